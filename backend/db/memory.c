@@ -22,247 +22,2836 @@
 #include <glib.h>
 #include <gmodule.h>
 
+#include <string.h>
+
 #include <julea.h>
+#include <julea-db.h>
+
+#include "jbson.c"
+
+/*
+ * Every schema is stored as a table with one column per field.
+ * Columns are arrays whose elements have the width of the field's type (strings and blobs are stored as pointers).
+ * Deleted rows are only marked as such, so row numbers stay valid for iterators and undo records.
+ * Each index declared in the schema's _index is maintained both as a hash index (for equality on all its fields)
+ * and as an ordered index on its first field (for ranges).
+ * Batches keep an undo log that is rolled back when an operation fails; changes are visible to other batches immediately.
+ */
+
+union JMemoryValue
+{
+	gint32 val_sint32;
+	guint32 val_uint32;
+	gfloat val_float32;
+	gint64 val_sint64;
+	guint64 val_uint64;
+	gdouble val_float64;
+	gchar* val_string;
+	GBytes* val_blob;
+};
+
+typedef union JMemoryValue JMemoryValue;
+
+struct JMemoryColumn
+{
+	gchar* name;
+	JDBType type;
+
+	GArray* values;
+	// Whether a row has a value, missing values behave like SQL's NULL
+	GArray* present;
+};
+
+typedef struct JMemoryColumn JMemoryColumn;
+
+struct JMemoryIndex
+{
+	GPtrArray* columns;
+
+	// Serialized key -> set of rows (stored as row + 1)
+	GHashTable* hash;
+	// Rows (stored as row + 1) ordered by the first column
+	GSequence* ordered;
+	// Row -> position in ordered, NULL if the row is not indexed
+	GPtrArray* positions;
+};
+
+typedef struct JMemoryIndex JMemoryIndex;
+
+struct JMemoryTable
+{
+	gint ref_count;
+
+	bson_t* schema;
+
+	GPtrArray* columns;
+	GHashTable* columns_by_name;
+	GPtrArray* indexes;
+
+	GArray* ids;
+	GArray* live;
+	guint32 next_id;
+};
+
+typedef struct JMemoryTable JMemoryTable;
+
+struct JMemoryCondition
+{
+	// Inner nodes
+	JDBSelectorMode mode;
+	GPtrArray* children;
+
+	// Leaves, column is NULL for _id
+	JMemoryColumn* column;
+	JDBType type;
+	JDBSelectorOperator op;
+	JMemoryValue value;
+};
+
+typedef struct JMemoryCondition JMemoryCondition;
+
+enum JMemoryUndoType
+{
+	J_MEMORY_UNDO_INSERT,
+	J_MEMORY_UNDO_DELETE,
+	J_MEMORY_UNDO_UPDATE
+};
+
+typedef enum JMemoryUndoType JMemoryUndoType;
+
+struct JMemoryUndo
+{
+	JMemoryUndoType type;
+	JMemoryTable* table;
+	guint row;
+
+	// Updates only
+	JMemoryColumn* column;
+	gboolean present;
+	JMemoryValue value;
+};
+
+typedef struct JMemoryUndo JMemoryUndo;
+
+struct JMemoryBatch
+{
+	gchar* namespace;
+	JSemantics* semantics;
+	GArray* undo;
+};
+
+typedef struct JMemoryBatch JMemoryBatch;
+
+struct JMemoryIterator
+{
+	JMemoryTable* table;
+	// Projected columns, NULL if all columns are returned
+	GPtrArray* columns;
+	GArray* rows;
+	// Precomputed entries of aggregations, rows is NULL in this case
+	GPtrArray* results;
+	guint position;
+};
+
+typedef struct JMemoryIterator JMemoryIterator;
+
+struct JMemoryFunction
+{
+	// Points into the aggregation's BSON document
+	gchar const* name;
+	JDBAggregateFunction function;
+	// NULL for counting all entries
+	JMemoryColumn* column;
+	JDBType type;
+};
+
+typedef struct JMemoryFunction JMemoryFunction;
+
+struct JMemoryGroup
+{
+	// First row of the group, which provides the group-by values
+	guint row;
+	// One accumulator and number of aggregated values per function
+	JMemoryValue* values;
+	guint64* counts;
+};
+
+typedef struct JMemoryGroup JMemoryGroup;
+
+struct JMemoryData
+{
+	// Namespace -> (name -> table)
+	GHashTable* namespaces;
+
+	GRWLock lock[1];
+};
+
+typedef struct JMemoryData JMemoryData;
+
+struct JMemoryProbe
+{
+	JMemoryColumn* column;
+	gconstpointer value;
+	guint row;
+};
+
+typedef struct JMemoryProbe JMemoryProbe;
+
+static gsize
+memory_type_width(JDBType type)
+{
+	switch (type)
+	{
+		case J_DB_TYPE_SINT32:
+		case J_DB_TYPE_UINT32:
+		case J_DB_TYPE_FLOAT32:
+			return 4;
+		case J_DB_TYPE_SINT64:
+		case J_DB_TYPE_UINT64:
+		case J_DB_TYPE_FLOAT64:
+			return 8;
+		case J_DB_TYPE_STRING:
+		case J_DB_TYPE_BLOB:
+			return sizeof(gpointer);
+		case J_DB_TYPE_ID:
+		default:
+			g_assert_not_reached();
+	}
+
+	return 0;
+}
+
+static gpointer
+memory_column_get(JMemoryColumn* column, guint row)
+{
+	return column->values->data + (gsize)row * memory_type_width(column->type);
+}
+
+static gboolean
+memory_column_present(JMemoryColumn* column, guint row)
+{
+	return g_array_index(column->present, guint8, row);
+}
+
+static void
+memory_value_clear(JDBType type, JMemoryValue* value)
+{
+	switch (type)
+	{
+		case J_DB_TYPE_STRING:
+			g_free(value->val_string);
+			value->val_string = NULL;
+			break;
+		case J_DB_TYPE_BLOB:
+			if (value->val_blob != NULL)
+			{
+				g_bytes_unref(value->val_blob);
+				value->val_blob = NULL;
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+static void
+memory_value_load(JDBType type, gconstpointer element, JMemoryValue* value)
+{
+	memset(value, 0, sizeof(*value));
+	memcpy(value, element, memory_type_width(type));
+}
+
+static void
+memory_value_store(JDBType type, gpointer element, JMemoryValue const* value)
+{
+	memcpy(element, value, memory_type_width(type));
+}
+
+static gboolean
+memory_value_from_bson(bson_iter_t* iter, JDBType type, JMemoryValue* value, gboolean* present, gboolean copy, GError** error)
+{
+	JDBTypeValue bson_value;
+
+	memset(value, 0, sizeof(*value));
+	*present = TRUE;
+
+	if (G_UNLIKELY(!j_bson_iter_value(iter, type, &bson_value, error)))
+	{
+		return FALSE;
+	}
+
+	switch (type)
+	{
+		case J_DB_TYPE_SINT32:
+			value->val_sint32 = bson_value.val_sint32;
+			break;
+		case J_DB_TYPE_UINT32:
+			value->val_uint32 = bson_value.val_uint32;
+			break;
+		case J_DB_TYPE_FLOAT32:
+			value->val_float32 = bson_value.val_float32;
+			break;
+		case J_DB_TYPE_SINT64:
+			value->val_sint64 = bson_value.val_sint64;
+			break;
+		case J_DB_TYPE_UINT64:
+			value->val_uint64 = bson_value.val_uint64;
+			break;
+		case J_DB_TYPE_FLOAT64:
+			value->val_float64 = bson_value.val_float64;
+			break;
+		case J_DB_TYPE_STRING:
+			// Selector values point into the selector, which outlives the condition
+			value->val_string = (copy) ? g_strdup(bson_value.val_string) : (gchar*)bson_value.val_string;
+			break;
+		case J_DB_TYPE_BLOB:
+			if (bson_value.val_blob == NULL)
+			{
+				*present = FALSE;
+			}
+			else if (copy)
+			{
+				value->val_blob = g_bytes_new(bson_value.val_blob, bson_value.val_blob_length);
+			}
+			else
+			{
+				value->val_blob = g_bytes_new_static(bson_value.val_blob, bson_value.val_blob_length);
+			}
+			break;
+		case J_DB_TYPE_ID:
+		default:
+			g_assert_not_reached();
+	}
+
+	return TRUE;
+}
+
+static gboolean
+memory_value_to_bson(bson_t* bson, gchar const* name, JDBType type, gconstpointer element, GError** error)
+{
+	JMemoryValue value;
+	JDBTypeValue bson_value;
+	gsize length;
+
+	memory_value_load(type, element, &value);
+
+	switch (type)
+	{
+		case J_DB_TYPE_SINT32:
+			bson_value.val_sint32 = value.val_sint32;
+			break;
+		case J_DB_TYPE_UINT32:
+			bson_value.val_uint32 = value.val_uint32;
+			break;
+		case J_DB_TYPE_FLOAT32:
+			bson_value.val_float32 = value.val_float32;
+			break;
+		case J_DB_TYPE_SINT64:
+			bson_value.val_sint64 = value.val_sint64;
+			break;
+		case J_DB_TYPE_UINT64:
+			bson_value.val_uint64 = value.val_uint64;
+			break;
+		case J_DB_TYPE_FLOAT64:
+			bson_value.val_float64 = value.val_float64;
+			break;
+		case J_DB_TYPE_STRING:
+			bson_value.val_string = value.val_string;
+			break;
+		case J_DB_TYPE_BLOB:
+			bson_value.val_blob = g_bytes_get_data(value.val_blob, &length);
+			bson_value.val_blob_length = length;
+			break;
+		case J_DB_TYPE_ID:
+		default:
+			g_assert_not_reached();
+	}
+
+	return j_bson_append_value(bson, name, type, &bson_value, error);
+}
+
+static gint
+memory_value_compare(JDBType type, gconstpointer a, gconstpointer b)
+{
+	JMemoryValue value_a;
+	JMemoryValue value_b;
+
+	memory_value_load(type, a, &value_a);
+	memory_value_load(type, b, &value_b);
+
+	switch (type)
+	{
+		case J_DB_TYPE_SINT32:
+			return (value_a.val_sint32 > value_b.val_sint32) - (value_a.val_sint32 < value_b.val_sint32);
+		case J_DB_TYPE_UINT32:
+			return (value_a.val_uint32 > value_b.val_uint32) - (value_a.val_uint32 < value_b.val_uint32);
+		case J_DB_TYPE_FLOAT32:
+			return (value_a.val_float32 > value_b.val_float32) - (value_a.val_float32 < value_b.val_float32);
+		case J_DB_TYPE_SINT64:
+			return (value_a.val_sint64 > value_b.val_sint64) - (value_a.val_sint64 < value_b.val_sint64);
+		case J_DB_TYPE_UINT64:
+			return (value_a.val_uint64 > value_b.val_uint64) - (value_a.val_uint64 < value_b.val_uint64);
+		case J_DB_TYPE_FLOAT64:
+			return (value_a.val_float64 > value_b.val_float64) - (value_a.val_float64 < value_b.val_float64);
+		case J_DB_TYPE_STRING:
+			return strcmp(value_a.val_string, value_b.val_string);
+		case J_DB_TYPE_BLOB:
+			return g_bytes_compare(value_a.val_blob, value_b.val_blob);
+		case J_DB_TYPE_ID:
+		default:
+			g_assert_not_reached();
+	}
+
+	return 0;
+}
+
+static void
+memory_key_append(GByteArray* key, JDBType type, gconstpointer element)
+{
+	JMemoryValue value;
+	gconstpointer data;
+	gsize length;
+	guint32 length32;
+
+	memory_value_load(type, element, &value);
+
+	switch (type)
+	{
+		case J_DB_TYPE_FLOAT32:
+			// 0.0 and -0.0 are equal but differ in their representation
+			if (value.val_float32 == 0.0f)
+			{
+				value.val_float32 = 0.0f;
+			}
+
+			g_byte_array_append(key, (guint8 const*)&value, 4);
+			break;
+		case J_DB_TYPE_FLOAT64:
+			if (value.val_float64 == 0.0)
+			{
+				value.val_float64 = 0.0;
+			}
+
+			g_byte_array_append(key, (guint8 const*)&value, 8);
+			break;
+		case J_DB_TYPE_STRING:
+			g_byte_array_append(key, (guint8 const*)value.val_string, strlen(value.val_string) + 1);
+			break;
+		case J_DB_TYPE_BLOB:
+			data = g_bytes_get_data(value.val_blob, &length);
+			length32 = length;
+			g_byte_array_append(key, (guint8 const*)&length32, sizeof(length32));
+			g_byte_array_append(key, data, length);
+			break;
+		default:
+			g_byte_array_append(key, (guint8 const*)&value, memory_type_width(type));
+			break;
+	}
+}
+
+static gint
+memory_index_compare(gconstpointer a, gconstpointer b, gpointer data)
+{
+	JMemoryProbe const* probe = data;
+	gconstpointer value_a;
+	gconstpointer value_b;
+	guint row_a;
+	guint row_b;
+	gint ret;
+
+	// Stored rows are offset by one, NULL stands for the probe
+	// Probes use 0 or G_MAXUINT as their row to sort before or after all rows with the same value
+	if (a == NULL)
+	{
+		value_a = probe->value;
+		row_a = probe->row;
+	}
+	else
+	{
+		row_a = GPOINTER_TO_UINT(a);
+		value_a = memory_column_get(probe->column, row_a - 1);
+	}
+
+	if (b == NULL)
+	{
+		value_b = probe->value;
+		row_b = probe->row;
+	}
+	else
+	{
+		row_b = GPOINTER_TO_UINT(b);
+		value_b = memory_column_get(probe->column, row_b - 1);
+	}
+
+	if ((ret = memory_value_compare(probe->column->type, value_a, value_b)) != 0)
+	{
+		return ret;
+	}
+
+	return (row_a > row_b) - (row_a < row_b);
+}
+
+static GBytes*
+memory_index_key(JMemoryIndex* index, guint row)
+{
+	GByteArray* key;
+
+	key = g_byte_array_new();
+
+	for (guint i = 0; i < index->columns->len; i++)
+	{
+		JMemoryColumn* column = g_ptr_array_index(index->columns, i);
+
+		memory_key_append(key, column->type, memory_column_get(column, row));
+	}
+
+	return g_byte_array_free_to_bytes(key);
+}
+
+static void
+memory_index_add(JMemoryIndex* index, guint row)
+{
+	JMemoryProbe probe;
+	GHashTable* rows;
+	GBytes* key;
+
+	// Rows with missing values never match a comparison and are therefore not indexed
+	for (guint i = 0; i < index->columns->len; i++)
+	{
+		if (!memory_column_present(g_ptr_array_index(index->columns, i), row))
+		{
+			return;
+		}
+	}
+
+	key = memory_index_key(index, row);
+
+	if ((rows = g_hash_table_lookup(index->hash, key)) == NULL)
+	{
+		rows = g_hash_table_new(NULL, NULL);
+		g_hash_table_insert(index->hash, g_bytes_ref(key), rows);
+	}
+
+	g_hash_table_add(rows, GUINT_TO_POINTER(row + 1));
+	g_bytes_unref(key);
+
+	probe.column = g_ptr_array_index(index->columns, 0);
+	probe.value = NULL;
+	probe.row = 0;
+
+	if (index->positions->len <= row)
+	{
+		g_ptr_array_set_size(index->positions, row + 1);
+	}
+
+	g_ptr_array_index(index->positions, row) = g_sequence_insert_sorted(index->ordered, GUINT_TO_POINTER(row + 1), memory_index_compare, &probe);
+}
+
+static void
+memory_index_remove(JMemoryIndex* index, guint row)
+{
+	GSequenceIter* position;
+	GHashTable* rows;
+	GBytes* key;
+
+	if (index->positions->len <= row || (position = g_ptr_array_index(index->positions, row)) == NULL)
+	{
+		return;
+	}
+
+	g_sequence_remove(position);
+	g_ptr_array_index(index->positions, row) = NULL;
+
+	key = memory_index_key(index, row);
+
+	if ((rows = g_hash_table_lookup(index->hash, key)) != NULL)
+	{
+		g_hash_table_remove(rows, GUINT_TO_POINTER(row + 1));
+
+		if (g_hash_table_size(rows) == 0)
+		{
+			g_hash_table_remove(index->hash, key);
+		}
+	}
+
+	g_bytes_unref(key);
+}
+
+static JMemoryIndex*
+memory_index_new(GPtrArray* columns)
+{
+	JMemoryIndex* index;
+
+	index = g_slice_new(JMemoryIndex);
+	index->columns = columns;
+	index->hash = g_hash_table_new_full(g_bytes_hash, g_bytes_equal, (GDestroyNotify)g_bytes_unref, (GDestroyNotify)g_hash_table_unref);
+	index->ordered = g_sequence_new(NULL);
+	index->positions = g_ptr_array_new();
+
+	return index;
+}
+
+static void
+memory_index_free(gpointer data)
+{
+	JMemoryIndex* index = data;
+
+	g_ptr_array_unref(index->columns);
+	g_hash_table_unref(index->hash);
+	g_sequence_free(index->ordered);
+	g_ptr_array_unref(index->positions);
+
+	g_slice_free(JMemoryIndex, index);
+}
+
+static void
+memory_column_free(gpointer data)
+{
+	JMemoryColumn* column = data;
+
+	g_free(column->name);
+	g_array_unref(column->values);
+	g_array_unref(column->present);
+
+	g_slice_free(JMemoryColumn, column);
+}
+
+static gboolean
+memory_table_row_live(JMemoryTable* table, guint row)
+{
+	return g_array_index(table->live, guint8, row);
+}
+
+static void
+memory_table_row_index(JMemoryTable* table, guint row)
+{
+	for (guint i = 0; i < table->indexes->len; i++)
+	{
+		memory_index_add(g_ptr_array_index(table->indexes, i), row);
+	}
+}
+
+static void
+memory_table_row_unindex(JMemoryTable* table, guint row)
+{
+	for (guint i = 0; i < table->indexes->len; i++)
+	{
+		memory_index_remove(g_ptr_array_index(table->indexes, i), row);
+	}
+}
+
+static void
+memory_table_row_clear(JMemoryTable* table, guint row)
+{
+	for (guint i = 0; i < table->columns->len; i++)
+	{
+		JMemoryColumn* column = g_ptr_array_index(table->columns, i);
+		JMemoryValue value;
+
+		if (memory_column_present(column, row))
+		{
+			memory_value_load(column->type, memory_column_get(column, row), &value);
+			memory_value_clear(column->type, &value);
+			memory_value_store(column->type, memory_column_get(column, row), &value);
+			g_array_index(column->present, guint8, row) = FALSE;
+		}
+	}
+}
+
+static JMemoryTable*
+memory_table_ref(JMemoryTable* table)
+{
+	// Queries take references while holding the reader lock
+	g_atomic_int_inc(&table->ref_count);
+
+	return table;
+}
+
+static void
+memory_table_unref(JMemoryTable* table)
+{
+	if (!g_atomic_int_dec_and_test(&table->ref_count))
+	{
+		return;
+	}
+
+	for (guint i = 0; i < table->live->len; i++)
+	{
+		memory_table_row_clear(table, i);
+	}
+
+	g_ptr_array_unref(table->indexes);
+	g_hash_table_unref(table->columns_by_name);
+	g_ptr_array_unref(table->columns);
+	g_array_unref(table->ids);
+	g_array_unref(table->live);
+	bson_destroy(table->schema);
+
+	g_slice_free(JMemoryTable, table);
+}
+
+static JMemoryTable*
+memory_table_new(bson_t const* schema, GError** error)
+{
+	JMemoryTable* table;
+	bson_iter_t iter;
+	bson_iter_t iter_index;
+	bson_iter_t iter_field;
+	gboolean has_next;
+	gboolean found_index = FALSE;
+
+	table = g_slice_new(JMemoryTable);
+	table->ref_count = 1;
+	table->schema = bson_copy(schema);
+	table->columns = g_ptr_array_new_with_free_func(memory_column_free);
+	table->columns_by_name = g_hash_table_new(g_str_hash, g_str_equal);
+	table->indexes = g_ptr_array_new_with_free_func(memory_index_free);
+	table->ids = g_array_new(FALSE, FALSE, sizeof(guint32));
+	table->live = g_array_new(FALSE, FALSE, sizeof(guint8));
+	table->next_id = 1;
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, schema, error)))
+	{
+		goto error;
+	}
+
+	while (TRUE)
+	{
+		JMemoryColumn* column;
+		JDBTypeValue value;
+		gchar const* key;
+
+		if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
+		{
+			goto error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY((key = j_bson_iter_key(&iter, error)) == NULL))
+		{
+			goto error;
+		}
+
+		if (g_strcmp0(key, "_index") == 0)
+		{
+			found_index = TRUE;
+			continue;
+		}
+
+		if (g_strcmp0(key, "_id") == 0)
+		{
+			continue;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT32, &value, error)))
+		{
+			goto error;
+		}
+
+		if (value.val_uint32 > J_DB_TYPE_ID)
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_DB_TYPE_INVALID, "db type invalid");
+			goto error;
+		}
+
+		column = g_slice_new(JMemoryColumn);
+		column->name = g_strdup(key);
+		// IDs are stored like the entries' own IDs
+		column->type = (value.val_uint32 == J_DB_TYPE_ID) ? J_DB_TYPE_UINT32 : value.val_uint32;
+		column->values = g_array_new(FALSE, TRUE, memory_type_width(column->type));
+		column->present = g_array_new(FALSE, TRUE, sizeof(guint8));
+
+		g_ptr_array_add(table->columns, column);
+		g_hash_table_insert(table->columns_by_name, column->name, column);
+	}
+
+	if (table->columns->len == 0)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_SCHEMA_EMPTY, "schema empty");
+		goto error;
+	}
+
+	if (found_index)
+	{
+		if (G_UNLIKELY(!j_bson_iter_init(&iter, schema, error)))
+		{
+			goto error;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_find(&iter, "_index", error)))
+		{
+			goto error;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_recurse_array(&iter, &iter_index, error)))
+		{
+			goto error;
+		}
+
+		while (TRUE)
+		{
+			g_autoptr(GPtrArray) columns = NULL;
+
+			if (G_UNLIKELY(!j_bson_iter_next(&iter_index, &has_next, error)))
+			{
+				goto error;
+			}
+
+			if (!has_next)
+			{
+				break;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_array(&iter_index, &iter_field, error)))
+			{
+				goto error;
+			}
+
+			columns = g_ptr_array_new();
+
+			while (TRUE)
+			{
+				JMemoryColumn* column;
+				JDBTypeValue value;
+
+				if (G_UNLIKELY(!j_bson_iter_next(&iter_field, &has_next, error)))
+				{
+					goto error;
+				}
+
+				if (!has_next)
+				{
+					break;
+				}
+
+				if (G_UNLIKELY(!j_bson_iter_value(&iter_field, J_DB_TYPE_STRING, &value, error)))
+				{
+					goto error;
+				}
+
+				if ((column = g_hash_table_lookup(table->columns_by_name, value.val_string)) == NULL)
+				{
+					g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+					goto error;
+				}
+
+				g_ptr_array_add(columns, column);
+			}
+
+			if (columns->len > 0)
+			{
+				g_ptr_array_add(table->indexes, memory_index_new(g_steal_pointer(&columns)));
+			}
+		}
+	}
+
+	return table;
+
+error:
+	memory_table_unref(table);
+
+	return NULL;
+}
+
+static JMemoryTable*
+memory_table_lookup(JMemoryData* bd, gchar const* namespace, gchar const* name, GError** error)
+{
+	GHashTable* tables;
+	JMemoryTable* table = NULL;
+
+	if ((tables = g_hash_table_lookup(bd->namespaces, namespace)) != NULL)
+	{
+		table = g_hash_table_lookup(tables, name);
+	}
+
+	if (table == NULL)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_SCHEMA_NOT_FOUND, "schema not found");
+	}
+
+	return table;
+}
+
+static void
+memory_condition_free(gpointer data)
+{
+	JMemoryCondition* condition = data;
+
+	if (condition->children != NULL)
+	{
+		g_ptr_array_unref(condition->children);
+	}
+	else if (condition->type == J_DB_TYPE_BLOB && condition->value.val_blob != NULL)
+	{
+		g_bytes_unref(condition->value.val_blob);
+	}
+
+	g_slice_free(JMemoryCondition, condition);
+}
+
+static JMemoryCondition*
+memory_condition_parse(JMemoryTable* table, bson_iter_t* iter, JDBSelectorMode mode, GError** error)
+{
+	JMemoryCondition* condition;
+	gboolean has_next;
+	gboolean equals;
+
+	condition = g_slice_new0(JMemoryCondition);
+	condition->mode = mode;
+	condition->children = g_ptr_array_new_with_free_func(memory_condition_free);
+
+	if (mode != J_DB_SELECTOR_MODE_AND && mode != J_DB_SELECTOR_MODE_OR)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_OPERATOR_INVALID, "operator invalid");
+		goto error;
+	}
+
+	while (TRUE)
+	{
+		JMemoryCondition* child;
+		bson_iter_t iter_child;
+		JDBTypeValue value;
+
+		if (G_UNLIKELY(!j_bson_iter_next(iter, &has_next, error)))
+		{
+			goto error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_key_equals(iter, "_mode", &equals, error)))
+		{
+			goto error;
+		}
+
+		if (equals)
+		{
+			continue;
+		}
+
+		// Prepared selectors identify their shape, which is only used to cache queries
+		if (G_UNLIKELY(!j_bson_iter_key_equals(iter, "_shape", &equals, error)))
+		{
+			goto error;
+		}
+
+		if (equals)
+		{
+			continue;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iter_child, error)))
+		{
+			goto error;
+		}
+
+		if (j_bson_iter_find(&iter_child, "_mode", NULL))
+		{
+			if (G_UNLIKELY(!j_bson_iter_value(&iter_child, J_DB_TYPE_UINT32, &value, error)))
+			{
+				goto error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iter_child, error)))
+			{
+				goto error;
+			}
+
+			if ((child = memory_condition_parse(table, &iter_child, value.val_uint32, error)) == NULL)
+			{
+				goto error;
+			}
+
+			g_ptr_array_add(condition->children, child);
+		}
+		else
+		{
+			gchar const* name;
+			gboolean present;
+
+			child = g_slice_new0(JMemoryCondition);
+			g_ptr_array_add(condition->children, child);
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iter_child, error)))
+			{
+				goto error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_find(&iter_child, "_name", error)))
+			{
+				goto error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_value(&iter_child, J_DB_TYPE_STRING, &value, error)))
+			{
+				goto error;
+			}
+
+			name = value.val_string;
+
+			if (g_strcmp0(name, "_id") == 0)
+			{
+				child->column = NULL;
+				child->type = J_DB_TYPE_UINT32;
+			}
+			else if ((child->column = g_hash_table_lookup(table->columns_by_name, name)) != NULL)
+			{
+				child->type = child->column->type;
+			}
+			else
+			{
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+				goto error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iter_child, error)))
+			{
+				goto error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_find(&iter_child, "_operator", error)))
+			{
+				goto error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_value(&iter_child, J_DB_TYPE_UINT32, &value, error)))
+			{
+				goto error;
+			}
+
+			child->op = value.val_uint32;
+
+			if (child->op > J_DB_SELECTOR_OPERATOR_NE)
+			{
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_COMPARATOR_INVALID, "comparator invalid");
+				goto error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iter_child, error)))
+			{
+				goto error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_find(&iter_child, "_value", error)))
+			{
+				goto error;
+			}
+
+			if (G_UNLIKELY(!memory_value_from_bson(&iter_child, child->type, &child->value, &present, FALSE, error)))
+			{
+				goto error;
+			}
+
+			// Comparisons with a missing value never match
+			if (!present)
+			{
+				child->op = J_DB_SELECTOR_OPERATOR_NE + 1;
+			}
+		}
+	}
+
+	if (condition->children->len == 0)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_SELECTOR_EMPTY, "selector empty");
+		goto error;
+	}
+
+	return condition;
+
+error:
+	memory_condition_free(condition);
+
+	return NULL;
+}
+
+static gboolean
+memory_condition_parse_selector(JMemoryTable* table, bson_t const* selector, JMemoryCondition** condition, GError** error)
+{
+	bson_iter_t iter;
+	JDBTypeValue value;
+
+	*condition = NULL;
+
+	// Selectors without conditions match all entries
+	if (selector == NULL || !j_bson_has_enough_keys(selector, 2, NULL))
+	{
+		return TRUE;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
+	{
+		return FALSE;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_find(&iter, "_mode", error)))
+	{
+		return FALSE;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT32, &value, error)))
+	{
+		return FALSE;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
+	{
+		return FALSE;
+	}
+
+	*condition = memory_condition_parse(table, &iter, value.val_uint32, error);
+
+	return (*condition != NULL);
+}
+
+/*
+ * Filters operate on chunks of rows and write one byte per row into mask.
+ * The loops only touch the column's plain array, which allows the compiler to vectorize them.
+ */
+#define J_MEMORY_CHUNK 1024
+
+#define J_MEMORY_FILTER(name, ctype) \
+	static void name(ctype const* restrict values, guint count, JDBSelectorOperator op, ctype value, guint8* restrict mask) \
+	{ \
+		switch (op) \
+		{ \
+			case J_DB_SELECTOR_OPERATOR_LT: \
+				for (guint i = 0; i < count; i++) \
+					mask[i] = (values[i] < value); \
+				break; \
+			case J_DB_SELECTOR_OPERATOR_LE: \
+				for (guint i = 0; i < count; i++) \
+					mask[i] = (values[i] <= value); \
+				break; \
+			case J_DB_SELECTOR_OPERATOR_GT: \
+				for (guint i = 0; i < count; i++) \
+					mask[i] = (values[i] > value); \
+				break; \
+			case J_DB_SELECTOR_OPERATOR_GE: \
+				for (guint i = 0; i < count; i++) \
+					mask[i] = (values[i] >= value); \
+				break; \
+			case J_DB_SELECTOR_OPERATOR_EQ: \
+				for (guint i = 0; i < count; i++) \
+					mask[i] = (values[i] == value); \
+				break; \
+			case J_DB_SELECTOR_OPERATOR_NE: \
+				for (guint i = 0; i < count; i++) \
+					mask[i] = (values[i] != value); \
+				break; \
+			default: \
+				memset(mask, 0, count); \
+				break; \
+		} \
+	}
+
+J_MEMORY_FILTER(memory_filter_sint32, gint32)
+J_MEMORY_FILTER(memory_filter_uint32, guint32)
+J_MEMORY_FILTER(memory_filter_float32, gfloat)
+J_MEMORY_FILTER(memory_filter_sint64, gint64)
+J_MEMORY_FILTER(memory_filter_uint64, guint64)
+J_MEMORY_FILTER(memory_filter_float64, gdouble)
+
+static void
+memory_filter_generic(JMemoryColumn* column, guint first, guint count, JDBSelectorOperator op, JMemoryValue const* value, guint8* mask)
+{
+	for (guint i = 0; i < count; i++)
+	{
+		gint cmp;
+
+		if (!memory_column_present(column, first + i))
+		{
+			mask[i] = FALSE;
+			continue;
+		}
+
+		cmp = memory_value_compare(column->type, memory_column_get(column, first + i), value);
+
+		switch (op)
+		{
+			case J_DB_SELECTOR_OPERATOR_LT:
+				mask[i] = (cmp < 0);
+				break;
+			case J_DB_SELECTOR_OPERATOR_LE:
+				mask[i] = (cmp <= 0);
+				break;
+			case J_DB_SELECTOR_OPERATOR_GT:
+				mask[i] = (cmp > 0);
+				break;
+			case J_DB_SELECTOR_OPERATOR_GE:
+				mask[i] = (cmp >= 0);
+				break;
+			case J_DB_SELECTOR_OPERATOR_EQ:
+				mask[i] = (cmp == 0);
+				break;
+			case J_DB_SELECTOR_OPERATOR_NE:
+				mask[i] = (cmp != 0);
+				break;
+			default:
+				mask[i] = FALSE;
+				break;
+		}
+	}
+}
+
+/*
+ * Evaluates condition for rows first to first + count - 1, count must not exceed J_MEMORY_CHUNK.
+ */
+static void
+memory_condition_filter(JMemoryCondition const* condition, JMemoryTable* table, guint first, guint count, guint8* mask)
+{
+	gconstpointer values;
+
+	if (condition->children != NULL)
+	{
+		guint8 child_mask[J_MEMORY_CHUNK];
+
+		memory_condition_filter(g_ptr_array_index(condition->children, 0), table, first, count, mask);
+
+		for (guint i = 1; i < condition->children->len; i++)
+		{
+			memory_condition_filter(g_ptr_array_index(condition->children, i), table, first, count, child_mask);
+
+			if (condition->mode == J_DB_SELECTOR_MODE_AND)
+			{
+				for (guint j = 0; j < count; j++)
+				{
+					mask[j] &= child_mask[j];
+				}
+			}
+			else
+			{
+				for (guint j = 0; j < count; j++)
+				{
+					mask[j] |= child_mask[j];
+				}
+			}
+		}
+
+		return;
+	}
+
+	if (condition->column == NULL)
+	{
+		memory_filter_uint32((guint32 const*)table->ids->data + first, count, condition->op, condition->value.val_uint32, mask);
+		return;
+	}
+
+	values = memory_column_get(condition->column, first);
+
+	switch (condition->type)
+	{
+		case J_DB_TYPE_SINT32:
+			memory_filter_sint32(values, count, condition->op, condition->value.val_sint32, mask);
+			break;
+		case J_DB_TYPE_UINT32:
+			memory_filter_uint32(values, count, condition->op, condition->value.val_uint32, mask);
+			break;
+		case J_DB_TYPE_FLOAT32:
+			memory_filter_float32(values, count, condition->op, condition->value.val_float32, mask);
+			break;
+		case J_DB_TYPE_SINT64:
+			memory_filter_sint64(values, count, condition->op, condition->value.val_sint64, mask);
+			break;
+		case J_DB_TYPE_UINT64:
+			memory_filter_uint64(values, count, condition->op, condition->value.val_uint64, mask);
+			break;
+		case J_DB_TYPE_FLOAT64:
+			memory_filter_float64(values, count, condition->op, condition->value.val_float64, mask);
+			break;
+		case J_DB_TYPE_STRING:
+		case J_DB_TYPE_BLOB:
+			memory_filter_generic(condition->column, first, count, condition->op, &condition->value, mask);
+			return;
+		case J_DB_TYPE_ID:
+		default:
+			g_assert_not_reached();
+	}
+
+	// Missing values never match
+	for (guint i = 0; i < count; i++)
+	{
+		mask[i] &= g_array_index(condition->column->present, guint8, first + i);
+	}
+}
+
+static void
+memory_select_range(JMemoryIndex* index, JMemoryCondition const* lower, JMemoryCondition const* upper, GArray* rows)
+{
+	JMemoryProbe probe;
+	GSequenceIter* begin;
+	GSequenceIter* end;
+
+	probe.column = g_ptr_array_index(index->columns, 0);
+
+	if (lower != NULL)
+	{
+		probe.value = &lower->value;
+		probe.row = (lower->op == J_DB_SELECTOR_OPERATOR_GT) ? G_MAXUINT : 0;
+		begin = g_sequence_search(index->ordered, NULL, memory_index_compare, &probe);
+	}
+	else
+	{
+		begin = g_sequence_get_begin_iter(index->ordered);
+	}
+
+	if (upper != NULL)
+	{
+		probe.value = &upper->value;
+		probe.row = (upper->op == J_DB_SELECTOR_OPERATOR_LT) ? 0 : G_MAXUINT;
+		end = g_sequence_search(index->ordered, NULL, memory_index_compare, &probe);
+	}
+	else
+	{
+		end = g_sequence_get_end_iter(index->ordered);
+	}
+
+	if (g_sequence_iter_compare(begin, end) >= 0)
+	{
+		return;
+	}
+
+	for (GSequenceIter* it = begin; it != end; it = g_sequence_iter_next(it))
+	{
+		guint row = GPOINTER_TO_UINT(g_sequence_get(it)) - 1;
+
+		g_array_append_val(rows, row);
+	}
+}
+
+static gint
+memory_row_compare(gconstpointer a, gconstpointer b)
+{
+	guint const* row_a = a;
+	guint const* row_b = b;
+
+	return (*row_a > *row_b) - (*row_a < *row_b);
+}
+
+/*
+ * Collects candidate rows using the schema's indexes.
+ * Only conjunctions can be narrowed down, returns FALSE if all rows have to be scanned.
+ */
+static gboolean
+memory_select_candidates(JMemoryTable* table, JMemoryCondition const* condition, GArray* rows)
+{
+	g_autoptr(GPtrArray) leaves = NULL;
+	JMemoryIndex* range_index = NULL;
+	JMemoryCondition const* range_lower = NULL;
+	JMemoryCondition const* range_upper = NULL;
+
+	if (condition == NULL || table->indexes->len == 0 || condition->mode != J_DB_SELECTOR_MODE_AND)
+	{
+		return FALSE;
+	}
+
+	leaves = g_ptr_array_new();
+
+	for (guint i = 0; i < condition->children->len; i++)
+	{
+		JMemoryCondition const* child = g_ptr_array_index(condition->children, i);
+
+		if (child->children == NULL && child->column != NULL && child->op <= J_DB_SELECTOR_OPERATOR_NE)
+		{
+			g_ptr_array_add(leaves, (gpointer)child);
+		}
+		else if (child->children != NULL && child->mode == J_DB_SELECTOR_MODE_AND && child->children->len == 1)
+		{
+			// Nested single conditions are common when building selectors programmatically
+			JMemoryCondition const* nested = g_ptr_array_index(child->children, 0);
+
+			if (nested->children == NULL && nested->column != NULL && nested->op <= J_DB_SELECTOR_OPERATOR_NE)
+			{
+				g_ptr_array_add(leaves, (gpointer)nested);
+			}
+		}
+	}
+
+	for (guint i = 0; i < table->indexes->len; i++)
+	{
+		JMemoryIndex* index = g_ptr_array_index(table->indexes, i);
+		JMemoryCondition const* lower = NULL;
+		JMemoryCondition const* upper = NULL;
+		g_autoptr(GByteArray) key = NULL;
+		gboolean complete = TRUE;
+
+		key = g_byte_array_new();
+
+		for (guint j = 0; j < index->columns->len && complete; j++)
+		{
+			JMemoryColumn* column = g_ptr_array_index(index->columns, j);
+			JMemoryCondition const* equal = NULL;
+
+			for (guint k = 0; k < leaves->len; k++)
+			{
+				JMemoryCondition const* leaf = g_ptr_array_index(leaves, k);
+
+				if (leaf->column == column && leaf->op == J_DB_SELECTOR_OPERATOR_EQ)
+				{
+					equal = leaf;
+					break;
+				}
+			}
+
+			if (equal != NULL)
+			{
+				memory_key_append(key, column->type, &equal->value);
+			}
+			else
+			{
+				complete = FALSE;
+			}
+		}
+
+		if (complete)
+		{
+			g_autoptr(GBytes) lookup = NULL;
+			GHashTable* matches;
+
+			lookup = g_byte_array_free_to_bytes(g_steal_pointer(&key));
+
+			if ((matches = g_hash_table_lookup(index->hash, lookup)) != NULL)
+			{
+				GHashTableIter iter;
+				gpointer row_key;
+
+				g_hash_table_iter_init(&iter, matches);
+
+				while (g_hash_table_iter_next(&iter, &row_key, NULL))
+				{
+					guint row = GPOINTER_TO_UINT(row_key) - 1;
+
+					g_array_append_val(rows, row);
+				}
+
+				g_array_sort(rows, memory_row_compare);
+			}
+
+			return TRUE;
+		}
+
+		if (range_index != NULL)
+		{
+			continue;
+		}
+
+		// Combine all bounds on the leading column, keeping the tightest ones
+		for (guint k = 0; k < leaves->len; k++)
+		{
+			JMemoryCondition const* leaf = g_ptr_array_index(leaves, k);
+			JMemoryColumn* column = g_ptr_array_index(index->columns, 0);
+			gint cmp;
+
+			if (leaf->column != column)
+			{
+				continue;
+			}
+
+			if (leaf->op == J_DB_SELECTOR_OPERATOR_GT || leaf->op == J_DB_SELECTOR_OPERATOR_GE || leaf->op == J_DB_SELECTOR_OPERATOR_EQ)
+			{
+				cmp = (lower == NULL) ? 1 : memory_value_compare(column->type, &leaf->value, &lower->value);
+
+				if (cmp > 0 || (cmp == 0 && leaf->op == J_DB_SELECTOR_OPERATOR_GT))
+				{
+					lower = leaf;
+				}
+			}
+
+			if (leaf->op == J_DB_SELECTOR_OPERATOR_LT || leaf->op == J_DB_SELECTOR_OPERATOR_LE || leaf->op == J_DB_SELECTOR_OPERATOR_EQ)
+			{
+				cmp = (upper == NULL) ? -1 : memory_value_compare(column->type, &leaf->value, &upper->value);
+
+				if (cmp < 0 || (cmp == 0 && leaf->op == J_DB_SELECTOR_OPERATOR_LT))
+				{
+					upper = leaf;
+				}
+			}
+		}
+
+		if (lower != NULL || upper != NULL)
+		{
+			range_index = index;
+			range_lower = lower;
+			range_upper = upper;
+		}
+	}
+
+	if (range_index == NULL)
+	{
+		return FALSE;
+	}
+
+	memory_select_range(range_index, range_lower, range_upper, rows);
+	g_array_sort(rows, memory_row_compare);
+
+	return TRUE;
+}
+
+/*
+ * Returns the live rows matching condition in insertion order.
+ */
+static GArray*
+memory_select(JMemoryTable* table, JMemoryCondition const* condition)
+{
+	GArray* candidates;
+	GArray* rows;
+	guint8 mask[J_MEMORY_CHUNK];
+
+	candidates = g_array_new(FALSE, FALSE, sizeof(guint));
+	rows = g_array_new(FALSE, FALSE, sizeof(guint));
+
+	if (memory_select_candidates(table, condition, candidates))
+	{
+		for (guint i = 0; i < candidates->len; i++)
+		{
+			guint row = g_array_index(candidates, guint, i);
+
+			if (!memory_table_row_live(table, row))
+			{
+				continue;
+			}
+
+			memory_condition_filter(condition, table, row, 1, mask);
+
+			if (mask[0])
+			{
+				g_array_append_val(rows, row);
+			}
+		}
+	}
+	else
+	{
+		for (guint first = 0; first < table->live->len; first += J_MEMORY_CHUNK)
+		{
+			guint count = MIN(J_MEMORY_CHUNK, table->live->len - first);
+			guint8 const* live = &g_array_index(table->live, guint8, first);
+
+			if (condition != NULL)
+			{
+				memory_condition_filter(condition, table, first, count, mask);
+			}
+			else
+			{
+				memset(mask, TRUE, count);
+			}
+
+			for (guint i = 0; i < count; i++)
+			{
+				if (mask[i] && live[i])
+				{
+					guint row = first + i;
+
+					g_array_append_val(rows, row);
+				}
+			}
+		}
+	}
+
+	g_array_unref(candidates);
+
+	return rows;
+}
+
+static void
+memory_batch_log(JMemoryBatch* batch, JMemoryUndoType type, JMemoryTable* table, guint row, JMemoryColumn* column)
+{
+	JMemoryUndo undo;
+
+	memset(&undo, 0, sizeof(undo));
+	undo.type = type;
+	undo.table = memory_table_ref(table);
+	undo.row = row;
+
+	if (type == J_MEMORY_UNDO_UPDATE)
+	{
+		undo.column = column;
+		undo.present = memory_column_present(column, row);
+		memory_value_load(column->type, memory_column_get(column, row), &undo.value);
+	}
+
+	g_array_append_val(batch->undo, undo);
+}
+
+static void
+memory_batch_commit(JMemoryBatch* batch)
+{
+	for (guint i = 0; i < batch->undo->len; i++)
+	{
+		JMemoryUndo* undo = &g_array_index(batch->undo, JMemoryUndo, i);
+
+		// Values of deleted rows and overwritten values are kept until here in case of a rollback
+		if (undo->type == J_MEMORY_UNDO_DELETE && !memory_table_row_live(undo->table, undo->row))
+		{
+			memory_table_row_clear(undo->table, undo->row);
+		}
+		else if (undo->type == J_MEMORY_UNDO_UPDATE && undo->present)
+		{
+			memory_value_clear(undo->column->type, &undo->value);
+		}
+
+		memory_table_unref(undo->table);
+	}
+
+	g_array_set_size(batch->undo, 0);
+}
+
+static void
+memory_batch_rollback(JMemoryBatch* batch)
+{
+	for (guint i = batch->undo->len; i > 0; i--)
+	{
+		JMemoryUndo* undo = &g_array_index(batch->undo, JMemoryUndo, i - 1);
+		JMemoryTable* table = undo->table;
+		JMemoryValue value;
+
+		switch (undo->type)
+		{
+			case J_MEMORY_UNDO_INSERT:
+				memory_table_row_unindex(table, undo->row);
+				memory_table_row_clear(table, undo->row);
+				g_array_index(table->live, guint8, undo->row) = FALSE;
+				break;
+			case J_MEMORY_UNDO_DELETE:
+				g_array_index(table->live, guint8, undo->row) = TRUE;
+				memory_table_row_index(table, undo->row);
+				break;
+			case J_MEMORY_UNDO_UPDATE:
+				memory_table_row_unindex(table, undo->row);
+
+				if (memory_column_present(undo->column, undo->row))
+				{
+					memory_value_load(undo->column->type, memory_column_get(undo->column, undo->row), &value);
+					memory_value_clear(undo->column->type, &value);
+				}
+
+				memory_value_store(undo->column->type, memory_column_get(undo->column, undo->row), &undo->value);
+				g_array_index(undo->column->present, guint8, undo->row) = undo->present;
+				memory_table_row_index(table, undo->row);
+				break;
+			default:
+				g_assert_not_reached();
+		}
+
+		memory_table_unref(table);
+	}
+
+	g_array_set_size(batch->undo, 0);
+}
+
+static void
+memory_value_copy(JDBType type, JMemoryValue const* value, JMemoryValue* copy)
+{
+	*copy = *value;
+
+	if (type == J_DB_TYPE_STRING)
+	{
+		copy->val_string = g_strdup(value->val_string);
+	}
+	else if (type == J_DB_TYPE_BLOB && value->val_blob != NULL)
+	{
+		copy->val_blob = g_bytes_ref(value->val_blob);
+	}
+}
+
+/*
+ * Parses metadata into one value per column, unset columns are left untouched.
+ */
+static gboolean
+memory_parse_values(JMemoryTable* table, bson_t const* metadata, JMemoryValue* values, guint8* set, guint8* present, GError** error)
+{
+	bson_iter_t iter;
+	gboolean has_next;
+	guint count = 0;
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, metadata, error)))
+	{
+		return FALSE;
+	}
+
+	while (TRUE)
+	{
+		JMemoryColumn* column;
+		gchar const* key;
+		gboolean value_present;
+		guint i;
+
+		if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
+		{
+			return FALSE;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY((key = j_bson_iter_key(&iter, error)) == NULL))
+		{
+			return FALSE;
+		}
+
+		if ((column = g_hash_table_lookup(table->columns_by_name, key)) == NULL)
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+			return FALSE;
+		}
+
+		for (i = 0; g_ptr_array_index(table->columns, i) != column; i++)
+		{
+		}
+
+		if (set[i])
+		{
+			memory_value_clear(column->type, &values[i]);
+		}
+
+		if (G_UNLIKELY(!memory_value_from_bson(&iter, column->type, &values[i], &value_present, TRUE, error)))
+		{
+			return FALSE;
+		}
+
+		set[i] = TRUE;
+		present[i] = value_present;
+		count++;
+	}
+
+	if (count == 0)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_NO_VARIABLE_SET, "no variable set");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void
+memory_values_free(JMemoryTable* table, JMemoryValue* values, guint8* set)
+{
+	for (guint i = 0; i < table->columns->len; i++)
+	{
+		if (set[i])
+		{
+			memory_value_clear(((JMemoryColumn*)g_ptr_array_index(table->columns, i))->type, &values[i]);
+		}
+	}
+
+	g_free(values);
+	g_free(set);
+}
+
+static gboolean
+backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* _batch, GError** error)
+{
+	JMemoryBatch* batch;
+
+	(void)backend_data;
+	(void)error;
+
+	batch = g_slice_new(JMemoryBatch);
+	batch->namespace = g_strdup(namespace);
+	batch->semantics = j_semantics_ref(semantics);
+	batch->undo = g_array_new(FALSE, FALSE, sizeof(JMemoryUndo));
+
+	*_batch = batch;
+
+	return TRUE;
+}
+
+static gboolean
+backend_batch_execute(gpointer backend_data, gpointer _batch, GError** error)
+{
+	JMemoryData* bd = backend_data;
+	JMemoryBatch* batch = _batch;
+
+	(void)error;
+
+	g_rw_lock_writer_lock(bd->lock);
+	memory_batch_commit(batch);
+	g_rw_lock_writer_unlock(bd->lock);
+
+	g_array_unref(batch->undo);
+	j_semantics_unref(batch->semantics);
+	g_free(batch->namespace);
+	g_slice_free(JMemoryBatch, batch);
+
+	return TRUE;
+}
+
+static gboolean
+backend_schema_create(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* schema, GError** error)
+{
+	JMemoryData* bd = backend_data;
+	JMemoryBatch* batch = _batch;
+	GHashTable* tables;
+	JMemoryTable* table;
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(schema != NULL, FALSE);
+
+	g_rw_lock_writer_lock(bd->lock);
+
+	if ((tables = g_hash_table_lookup(bd->namespaces, batch->namespace)) == NULL)
+	{
+		tables = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)memory_table_unref);
+		g_hash_table_insert(bd->namespaces, g_strdup(batch->namespace), tables);
+	}
+
+	if (g_hash_table_contains(tables, name))
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_FAILED, "schema already exists");
+		goto end;
+	}
+
+	if ((table = memory_table_new(schema, error)) == NULL)
+	{
+		goto end;
+	}
+
+	g_hash_table_insert(tables, g_strdup(name), table);
+	ret = TRUE;
+
+end:
+	g_rw_lock_writer_unlock(bd->lock);
+
+	return ret;
+}
+
+static gboolean
+backend_schema_get(gpointer backend_data, gpointer _batch, gchar const* name, bson_t* schema, GError** error)
+{
+	JMemoryData* bd = backend_data;
+	JMemoryBatch* batch = _batch;
+	JMemoryTable* table;
+	bson_iter_t iter;
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(name != NULL, FALSE);
+
+	g_rw_lock_reader_lock(bd->lock);
+
+	if ((table = memory_table_lookup(bd, batch->namespace, name, error)) == NULL)
+	{
+		goto end;
+	}
+
+	if (schema != NULL)
+	{
+		if (G_UNLIKELY(!j_bson_init(schema, error)))
+		{
+			goto end;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_init(&iter, table->schema, error)))
+		{
+			goto end;
+		}
+
+		while (bson_iter_next(&iter))
+		{
+			bson_append_iter(schema, NULL, 0, &iter);
+		}
+	}
+
+	ret = TRUE;
+
+end:
+	g_rw_lock_reader_unlock(bd->lock);
+
+	return ret;
+}
+
+static gboolean
+backend_schema_delete(gpointer backend_data, gpointer _batch, gchar const* name, GError** error)
+{
+	JMemoryData* bd = backend_data;
+	JMemoryBatch* batch = _batch;
+	GHashTable* tables;
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(name != NULL, FALSE);
+
+	g_rw_lock_writer_lock(bd->lock);
+
+	if (memory_table_lookup(bd, batch->namespace, name, error) == NULL)
+	{
+		goto end;
+	}
+
+	// Iterators and undo records keep their own references
+	tables = g_hash_table_lookup(bd->namespaces, batch->namespace);
+	g_hash_table_remove(tables, name);
+	ret = TRUE;
+
+end:
+	g_rw_lock_writer_unlock(bd->lock);
+
+	return ret;
+}
+
+static gboolean
+backend_insert(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* metadata, bson_t* id, GError** error)
+{
+	JMemoryData* bd = backend_data;
+	JMemoryBatch* batch = _batch;
+	JMemoryTable* table;
+	JMemoryValue* values = NULL;
+	guint8* set = NULL;
+	guint8* present;
+	JDBTypeValue value;
+	guint8 live = TRUE;
+	guint32 value_id;
+	guint row;
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(metadata != NULL, FALSE);
+	g_return_val_if_fail(id != NULL, FALSE);
+
+	g_rw_lock_writer_lock(bd->lock);
+
+	if ((table = memory_table_lookup(bd, batch->namespace, name, error)) == NULL)
+	{
+		goto end;
+	}
+
+	values = g_new0(JMemoryValue, table->columns->len);
+	set = g_new0(guint8, 2 * table->columns->len);
+	present = set + table->columns->len;
+
+	if (!memory_parse_values(table, metadata, values, set, present, error))
+	{
+		goto end;
+	}
 
-struct JMemoryData
-{
-	bson_t* schema_cache;
-	bson_t* entry_cache;
-	guint32 entry_counter;
+	row = table->live->len;
+	value_id = table->next_id++;
 
-	GMutex lock[1];
-};
+	for (guint i = 0; i < table->columns->len; i++)
+	{
+		JMemoryColumn* column = g_ptr_array_index(table->columns, i);
+
+		g_array_set_size(column->values, row + 1);
+		g_array_set_size(column->present, row + 1);
+
+		if (set[i] && present[i])
+		{
+			// Ownership of the value moves to the column
+			memory_value_store(column->type, memory_column_get(column, row), &values[i]);
+			g_array_index(column->present, guint8, row) = TRUE;
+			set[i] = FALSE;
+		}
+	}
 
-typedef struct JMemoryData JMemoryData;
+	g_array_append_val(table->ids, value_id);
+	g_array_append_val(table->live, live);
 
-static gboolean
-backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* batch, GError** error)
-{
-	(void)backend_data;
-	(void)semantics;
-	(void)namespace;
-	(void)batch;
-	(void)error;
+	memory_table_row_index(table, row);
+	memory_batch_log(batch, J_MEMORY_UNDO_INSERT, table, row, NULL);
 
-	// Return something != NULL
-	*batch = batch;
+	value.val_uint32 = value_id;
 
-	return TRUE;
-}
+	if (G_UNLIKELY(!j_bson_append_value(id, "_value", J_DB_TYPE_UINT32, &value, error)))
+	{
+		goto end;
+	}
 
-static gboolean
-backend_batch_execute(gpointer backend_data, gpointer batch, GError** error)
-{
-	(void)backend_data;
-	(void)batch;
-	(void)error;
+	value.val_uint32 = J_DB_TYPE_UINT32;
 
-	return TRUE;
+	if (G_UNLIKELY(!j_bson_append_value(id, "_value_type", J_DB_TYPE_UINT32, &value, error)))
+	{
+		goto end;
+	}
+
+	ret = TRUE;
+
+end:
+	if (values != NULL)
+	{
+		memory_values_free(table, values, set);
+	}
+
+	if (!ret)
+	{
+		memory_batch_rollback(batch);
+	}
+
+	g_rw_lock_writer_unlock(bd->lock);
+
+	return ret;
 }
 
 static gboolean
-backend_schema_create(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* schema, GError** error)
+backend_update(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* selector, bson_t const* metadata, GError** error)
 {
 	JMemoryData* bd = backend_data;
+	JMemoryBatch* batch = _batch;
+	JMemoryTable* table;
+	JMemoryCondition* condition = NULL;
+	JMemoryValue* values = NULL;
+	guint8* set = NULL;
+	guint8* present;
+	g_autoptr(GArray) rows = NULL;
+	gboolean ret = FALSE;
 
-	(void)batch;
-	(void)name;
-	(void)schema;
-	(void)error;
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(selector != NULL, FALSE);
+	g_return_val_if_fail(metadata != NULL, FALSE);
+
+	g_rw_lock_writer_lock(bd->lock);
+
+	if ((table = memory_table_lookup(bd, batch->namespace, name, error)) == NULL)
+	{
+		goto end;
+	}
 
-	g_mutex_lock(bd->lock);
+	values = g_new0(JMemoryValue, table->columns->len);
+	set = g_new0(guint8, 2 * table->columns->len);
+	present = set + table->columns->len;
 
-	if (bd->schema_cache != NULL)
+	if (!memory_parse_values(table, metadata, values, set, present, error))
 	{
-		bson_destroy(bd->schema_cache);
+		goto end;
 	}
 
-	bd->schema_cache = bson_copy(schema);
+	if (!memory_condition_parse_selector(table, selector, &condition, error))
+	{
+		goto end;
+	}
 
-	g_mutex_unlock(bd->lock);
+	rows = memory_select(table, condition);
 
-	return TRUE;
+	if (rows->len == 0)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+		goto end;
+	}
+
+	for (guint i = 0; i < rows->len; i++)
+	{
+		guint row = g_array_index(rows, guint, i);
+
+		memory_table_row_unindex(table, row);
+
+		for (guint j = 0; j < table->columns->len; j++)
+		{
+			JMemoryColumn* column = g_ptr_array_index(table->columns, j);
+			JMemoryValue copy;
+
+			if (!set[j])
+			{
+				continue;
+			}
+
+			// The old value is released when the batch is committed
+			memory_batch_log(batch, J_MEMORY_UNDO_UPDATE, table, row, column);
+
+			memset(&copy, 0, sizeof(copy));
+
+			if (present[j])
+			{
+				memory_value_copy(column->type, &values[j], &copy);
+			}
+
+			memory_value_store(column->type, memory_column_get(column, row), &copy);
+			g_array_index(column->present, guint8, row) = present[j];
+		}
+
+		memory_table_row_index(table, row);
+	}
+
+	ret = TRUE;
+
+end:
+	if (condition != NULL)
+	{
+		memory_condition_free(condition);
+	}
+
+	if (values != NULL)
+	{
+		memory_values_free(table, values, set);
+	}
+
+	if (!ret)
+	{
+		memory_batch_rollback(batch);
+	}
+
+	g_rw_lock_writer_unlock(bd->lock);
+
+	return ret;
 }
 
 static gboolean
-backend_schema_get(gpointer backend_data, gpointer batch, gchar const* name, bson_t* schema, GError** error)
+backend_delete(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* selector, GError** error)
 {
-	gboolean ret = FALSE;
 	JMemoryData* bd = backend_data;
+	JMemoryBatch* batch = _batch;
+	JMemoryTable* table;
+	JMemoryCondition* condition = NULL;
+	g_autoptr(GArray) rows = NULL;
+	gboolean ret = FALSE;
 
-	(void)batch;
-	(void)name;
-	(void)schema;
-	(void)error;
+	g_return_val_if_fail(name != NULL, FALSE);
 
-	g_mutex_lock(bd->lock);
+	g_rw_lock_writer_lock(bd->lock);
 
-	if (bd->schema_cache != NULL)
+	if ((table = memory_table_lookup(bd, batch->namespace, name, error)) == NULL)
 	{
-		// FIXME schema is uninitialized if backend is running on the server but initialized if running on the client
-		// bson_copy_to requires the destination to be uninitialized
-		//bson_destroy(schema);
-		bson_copy_to(bd->schema_cache, schema);
-		ret = TRUE;
+		goto end;
+	}
+
+	if (!memory_condition_parse_selector(table, selector, &condition, error))
+	{
+		goto end;
+	}
+
+	rows = memory_select(table, condition);
+
+	if (rows->len == 0)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+		goto end;
+	}
+
+	for (guint i = 0; i < rows->len; i++)
+	{
+		guint row = g_array_index(rows, guint, i);
+
+		// The row's values are released when the batch is committed
+		memory_table_row_unindex(table, row);
+		g_array_index(table->live, guint8, row) = FALSE;
+		memory_batch_log(batch, J_MEMORY_UNDO_DELETE, table, row, NULL);
 	}
 
-	g_mutex_unlock(bd->lock);
+	ret = TRUE;
+
+end:
+	if (condition != NULL)
+	{
+		memory_condition_free(condition);
+	}
+
+	if (!ret)
+	{
+		memory_batch_rollback(batch);
+	}
+
+	g_rw_lock_writer_unlock(bd->lock);
 
 	return ret;
 }
 
 static gboolean
-backend_schema_delete(gpointer backend_data, gpointer batch, gchar const* name, GError** error)
+memory_parse_fields(JMemoryTable* table, bson_t const* fields, GPtrArray** columns, GError** error)
 {
-	JMemoryData* bd = backend_data;
+	bson_iter_t iter;
+	gboolean has_next;
 
-	(void)batch;
-	(void)name;
-	(void)error;
+	*columns = NULL;
 
-	g_mutex_lock(bd->lock);
+	if (fields == NULL)
+	{
+		return TRUE;
+	}
 
-	if (bd->schema_cache != NULL)
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, fields, error)))
 	{
-		bson_destroy(bd->schema_cache);
-		bd->schema_cache = NULL;
+		return FALSE;
 	}
 
-	g_mutex_unlock(bd->lock);
+	*columns = g_ptr_array_new();
+
+	while (TRUE)
+	{
+		JMemoryColumn* column;
+		JDBTypeValue value;
+
+		if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
+		{
+			goto error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_STRING, &value, error)))
+		{
+			goto error;
+		}
+
+		if (g_strcmp0(value.val_string, "_id") == 0)
+		{
+			continue;
+		}
+
+		if ((column = g_hash_table_lookup(table->columns_by_name, value.val_string)) == NULL)
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+			goto error;
+		}
+
+		g_ptr_array_add(*columns, column);
+	}
 
 	return TRUE;
+
+error:
+	g_ptr_array_unref(*columns);
+	*columns = NULL;
+
+	return FALSE;
 }
 
 static gboolean
-backend_insert(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* metadata, bson_t* id, GError** error)
+backend_query_fields(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* selector, bson_t const* fields, gpointer* iterator, GError** error)
 {
 	JMemoryData* bd = backend_data;
+	JMemoryBatch* batch = _batch;
+	JMemoryTable* table;
+	JMemoryCondition* condition = NULL;
+	JMemoryIterator* memory_iterator;
+	GPtrArray* columns = NULL;
+	gboolean ret = FALSE;
 
-	(void)batch;
-	(void)name;
-	(void)metadata;
-	(void)id;
-	(void)error;
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(iterator != NULL, FALSE);
+
+	g_rw_lock_reader_lock(bd->lock);
+
+	if ((table = memory_table_lookup(bd, batch->namespace, name, error)) == NULL)
+	{
+		goto end;
+	}
 
-	g_mutex_lock(bd->lock);
+	if (!memory_condition_parse_selector(table, selector, &condition, error))
+	{
+		goto end;
+	}
 
-	if (bd->entry_cache != NULL)
+	if (!memory_parse_fields(table, fields, &columns, error))
 	{
-		bson_destroy(bd->entry_cache);
+		goto end;
 	}
 
-	bd->entry_cache = bson_copy(metadata);
-	bd->entry_counter++;
+	memory_iterator = g_slice_new(JMemoryIterator);
+	memory_iterator->table = memory_table_ref(table);
+	memory_iterator->columns = columns;
+	memory_iterator->rows = memory_select(table, condition);
+	memory_iterator->results = NULL;
+	memory_iterator->position = 0;
 
-	g_mutex_unlock(bd->lock);
+	*iterator = memory_iterator;
+	ret = TRUE;
 
-	return TRUE;
+end:
+	if (condition != NULL)
+	{
+		memory_condition_free(condition);
+	}
+
+	g_rw_lock_reader_unlock(bd->lock);
+
+	return ret;
 }
 
 static gboolean
-backend_update(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* selector, bson_t const* metadata, GError** error)
+backend_query(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* selector, gpointer* iterator, GError** error)
 {
-	(void)backend_data;
-	(void)batch;
-	(void)name;
-	(void)selector;
-	(void)metadata;
-	(void)error;
+	return backend_query_fields(backend_data, _batch, name, selector, NULL, iterator, error);
+}
 
-	return TRUE;
+static void
+memory_iterator_free(JMemoryIterator* memory_iterator)
+{
+	memory_table_unref(memory_iterator->table);
+
+	if (memory_iterator->columns != NULL)
+	{
+		g_ptr_array_unref(memory_iterator->columns);
+	}
+
+	if (memory_iterator->rows != NULL)
+	{
+		g_array_unref(memory_iterator->rows);
+	}
+
+	if (memory_iterator->results != NULL)
+	{
+		g_ptr_array_unref(memory_iterator->results);
+	}
+
+	g_slice_free(JMemoryIterator, memory_iterator);
 }
 
 static gboolean
-backend_delete(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* selector, GError** error)
+backend_iterate(gpointer backend_data, gpointer iterator, bson_t* metadata, GError** error)
 {
 	JMemoryData* bd = backend_data;
+	JMemoryIterator* memory_iterator = iterator;
+	JMemoryTable* table = memory_iterator->table;
+	GPtrArray* columns;
+	JDBTypeValue value;
+	gboolean ret = FALSE;
+	guint row;
 
-	(void)batch;
-	(void)name;
-	(void)selector;
-	(void)error;
+	g_return_val_if_fail(metadata != NULL, FALSE);
 
-	g_mutex_lock(bd->lock);
+	g_rw_lock_reader_lock(bd->lock);
 
-	if (bd->entry_cache != NULL)
+	if (memory_iterator->results != NULL)
 	{
-		bson_destroy(bd->entry_cache);
-		bd->entry_cache = NULL;
+		if (memory_iterator->position >= memory_iterator->results->len)
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+			memory_iterator_free(memory_iterator);
+
+			goto end;
+		}
+
+		bson_concat(metadata, g_ptr_array_index(memory_iterator->results, memory_iterator->position));
+		memory_iterator->position++;
+		ret = TRUE;
+
+		goto end;
 	}
 
-	bd->entry_counter--;
+	// Rows deleted since the query are skipped
+	while (memory_iterator->position < memory_iterator->rows->len && !memory_table_row_live(table, g_array_index(memory_iterator->rows, guint, memory_iterator->position)))
+	{
+		memory_iterator->position++;
+	}
 
-	g_mutex_unlock(bd->lock);
+	if (memory_iterator->position >= memory_iterator->rows->len)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+		memory_iterator_free(memory_iterator);
 
-	return TRUE;
+		goto end;
+	}
+
+	row = g_array_index(memory_iterator->rows, guint, memory_iterator->position);
+	memory_iterator->position++;
+
+	value.val_uint32 = g_array_index(table->ids, guint32, row);
+
+	if (G_UNLIKELY(!j_bson_append_value(metadata, "_id", J_DB_TYPE_UINT32, &value, error)))
+	{
+		goto end;
+	}
+
+	columns = (memory_iterator->columns != NULL) ? memory_iterator->columns : table->columns;
+
+	for (guint i = 0; i < columns->len; i++)
+	{
+		JMemoryColumn* column = g_ptr_array_index(columns, i);
+
+		if (!memory_column_present(column, row))
+		{
+			continue;
+		}
+
+		if (G_UNLIKELY(!memory_value_to_bson(metadata, column->name, column->type, memory_column_get(column, row), error)))
+		{
+			goto end;
+		}
+	}
+
+	ret = TRUE;
+
+end:
+	g_rw_lock_reader_unlock(bd->lock);
+
+	return ret;
 }
 
-static gboolean
-backend_query(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* selector, gpointer* iterator, GError** error)
+static void
+memory_function_accumulate(JMemoryFunction const* function, guint row, JMemoryValue* value, guint64* count)
 {
-	JMemoryData* bd = backend_data;
-	guint32* counter;
+	JMemoryValue element;
+	gdouble val_float64;
+	gint64 val_sint64;
+	guint64 val_uint64;
 
-	(void)batch;
-	(void)name;
-	(void)selector;
-	(void)error;
+	if (function->column == NULL)
+	{
+		(*count)++;
+		return;
+	}
 
-	counter = g_new(guint32, 1);
-	*iterator = counter;
+	if (!memory_column_present(function->column, row))
+	{
+		return;
+	}
 
-	g_mutex_lock(bd->lock);
+	memory_value_load(function->column->type, memory_column_get(function->column, row), &element);
 
-	if (bd->entry_cache == NULL)
+	switch (function->column->type)
 	{
-		*counter = 0;
+		case J_DB_TYPE_SINT32:
+			val_sint64 = element.val_sint32;
+			val_uint64 = element.val_sint32;
+			val_float64 = element.val_sint32;
+			break;
+		case J_DB_TYPE_UINT32:
+			val_sint64 = element.val_uint32;
+			val_uint64 = element.val_uint32;
+			val_float64 = element.val_uint32;
+			break;
+		case J_DB_TYPE_FLOAT32:
+			val_sint64 = element.val_float32;
+			val_uint64 = element.val_float32;
+			val_float64 = element.val_float32;
+			break;
+		case J_DB_TYPE_SINT64:
+			val_sint64 = element.val_sint64;
+			val_uint64 = element.val_sint64;
+			val_float64 = element.val_sint64;
+			break;
+		case J_DB_TYPE_UINT64:
+			val_sint64 = element.val_uint64;
+			val_uint64 = element.val_uint64;
+			val_float64 = element.val_uint64;
+			break;
+		case J_DB_TYPE_FLOAT64:
+			val_sint64 = element.val_float64;
+			val_uint64 = element.val_float64;
+			val_float64 = element.val_float64;
+			break;
+		default:
+			// Only counting supports other types
+			(*count)++;
+			return;
 	}
-	else if (selector != NULL)
+
+	switch (function->function)
 	{
-		*counter = 1;
+		case J_DB_AGGREGATE_FUNCTION_COUNT:
+			break;
+		case J_DB_AGGREGATE_FUNCTION_SUM:
+			if (function->type == J_DB_TYPE_SINT64)
+			{
+				value->val_sint64 += val_sint64;
+			}
+			else if (function->type == J_DB_TYPE_UINT64)
+			{
+				value->val_uint64 += val_uint64;
+			}
+			else
+			{
+				value->val_float64 += val_float64;
+			}
+			break;
+		case J_DB_AGGREGATE_FUNCTION_MIN:
+			if (*count == 0 || memory_value_compare(function->column->type, &element, value) < 0)
+			{
+				*value = element;
+			}
+			break;
+		case J_DB_AGGREGATE_FUNCTION_MAX:
+			if (*count == 0 || memory_value_compare(function->column->type, &element, value) > 0)
+			{
+				*value = element;
+			}
+			break;
+		case J_DB_AGGREGATE_FUNCTION_AVG:
+			value->val_float64 += val_float64;
+			break;
+		default:
+			g_assert_not_reached();
 	}
-	else
+
+	(*count)++;
+}
+
+static gint
+memory_group_compare(gconstpointer a, gconstpointer b, gpointer data)
+{
+	JMemoryGroup const* group_a = a;
+	JMemoryGroup const* group_b = b;
+	GPtrArray* columns = data;
+
+	// Groups are ordered by their group-by values, missing values come first like SQL's NULL
+	for (guint i = 0; i < columns->len; i++)
+	{
+		JMemoryColumn* column = g_ptr_array_index(columns, i);
+		gboolean present_a = memory_column_present(column, group_a->row);
+		gboolean present_b = memory_column_present(column, group_b->row);
+		gint cmp;
+
+		if (present_a != present_b)
+		{
+			return present_a - present_b;
+		}
+
+		if (present_a && (cmp = memory_value_compare(column->type, memory_column_get(column, group_a->row), memory_column_get(column, group_b->row))) != 0)
+		{
+			return cmp;
+		}
+	}
+
+	return 0;
+}
+
+static gboolean
+memory_parse_aggregate(JMemoryTable* table, bson_t const* aggregate, GPtrArray* columns, GArray* functions, GError** error)
+{
+	bson_iter_t iter;
+	bson_iter_t iter_array;
+	bson_iter_t iter_function;
+	gboolean has_next;
+	JDBTypeValue value;
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, aggregate, error) || !j_bson_iter_find(&iter, "_group", error) || !j_bson_iter_recurse_array(&iter, &iter_array, error)))
+	{
+		return FALSE;
+	}
+
+	while (TRUE)
+	{
+		JMemoryColumn* column;
+
+		if (G_UNLIKELY(!j_bson_iter_next(&iter_array, &has_next, error)))
+		{
+			return FALSE;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_value(&iter_array, J_DB_TYPE_STRING, &value, error)))
+		{
+			return FALSE;
+		}
+
+		if ((column = g_hash_table_lookup(table->columns_by_name, value.val_string)) == NULL)
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+			return FALSE;
+		}
+
+		g_ptr_array_add(columns, column);
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, aggregate, error) || !j_bson_iter_find(&iter, "_functions", error) || !j_bson_iter_recurse_array(&iter, &iter_array, error)))
 	{
-		*counter = bd->entry_counter;
+		return FALSE;
 	}
 
-	g_mutex_unlock(bd->lock);
+	while (TRUE)
+	{
+		JMemoryFunction function;
+
+		if (G_UNLIKELY(!j_bson_iter_next(&iter_array, &has_next, error)))
+		{
+			return FALSE;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter_array, &iter_function, error) || !j_bson_iter_find(&iter_function, "_name", error) || !j_bson_iter_value(&iter_function, J_DB_TYPE_STRING, &value, error)))
+		{
+			return FALSE;
+		}
+
+		function.name = value.val_string;
+
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter_array, &iter_function, error) || !j_bson_iter_find(&iter_function, "_function", error) || !j_bson_iter_value(&iter_function, J_DB_TYPE_UINT32, &value, error)))
+		{
+			return FALSE;
+		}
+
+		function.function = value.val_uint32;
+
+		if (G_UNLIKELY(function.function > J_DB_AGGREGATE_FUNCTION_AVG))
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_OPERATOR_INVALID, "operator invalid");
+			return FALSE;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter_array, &iter_function, error) || !j_bson_iter_find(&iter_function, "_type", error) || !j_bson_iter_value(&iter_function, J_DB_TYPE_UINT32, &value, error)))
+		{
+			return FALSE;
+		}
+
+		function.type = value.val_uint32;
+		function.column = NULL;
+
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter_array, &iter_function, error)))
+		{
+			return FALSE;
+		}
+
+		if (j_bson_iter_find(&iter_function, "_field", NULL))
+		{
+			if (G_UNLIKELY(!j_bson_iter_value(&iter_function, J_DB_TYPE_STRING, &value, error)))
+			{
+				return FALSE;
+			}
+
+			if ((function.column = g_hash_table_lookup(table->columns_by_name, value.val_string)) == NULL)
+			{
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+				return FALSE;
+			}
+		}
+
+		if (G_UNLIKELY(function.function != J_DB_AGGREGATE_FUNCTION_COUNT && function.column == NULL))
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+			return FALSE;
+		}
+
+		g_array_append_val(functions, function);
+	}
 
 	return TRUE;
 }
 
 static gboolean
-backend_iterate(gpointer backend_data, gpointer iterator, bson_t* metadata, GError** error)
+backend_aggregate(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* selector, bson_t const* aggregate, gpointer* iterator, GError** error)
 {
-	gboolean ret = TRUE;
-	guint32* counter = iterator;
 	JMemoryData* bd = backend_data;
+	JMemoryBatch* batch = _batch;
+	JMemoryTable* table;
+	JMemoryCondition* condition = NULL;
+	JMemoryIterator* memory_iterator;
+	g_autoptr(GPtrArray) columns = NULL;
+	g_autoptr(GArray) functions = NULL;
+	g_autoptr(GArray) groups = NULL;
+	g_autoptr(GHashTable) groups_by_key = NULL;
+	g_autoptr(GByteArray) key = NULL;
+	g_autoptr(GPtrArray) results = NULL;
+	GArray* rows = NULL;
+	gboolean ret = FALSE;
 
-	(void)iterator;
-	(void)metadata;
-	(void)error;
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(aggregate != NULL, FALSE);
+	g_return_val_if_fail(iterator != NULL, FALSE);
+
+	columns = g_ptr_array_new();
+	functions = g_array_new(FALSE, FALSE, sizeof(JMemoryFunction));
+	groups = g_array_new(FALSE, FALSE, sizeof(JMemoryGroup));
+	groups_by_key = g_hash_table_new_full(g_bytes_hash, g_bytes_equal, (GDestroyNotify)g_bytes_unref, NULL);
+	key = g_byte_array_new();
+	results = g_ptr_array_new_with_free_func((GDestroyNotify)bson_destroy);
 
-	g_mutex_lock(bd->lock);
+	g_rw_lock_reader_lock(bd->lock);
 
-	if (*counter <= 0 || bd->entry_cache == NULL)
+	if ((table = memory_table_lookup(bd, batch->namespace, name, error)) == NULL)
+	{
+		goto end;
+	}
+
+	if (!memory_condition_parse_selector(table, selector, &condition, error))
+	{
+		goto end;
+	}
+
+	if (!memory_parse_aggregate(table, aggregate, columns, functions, error))
 	{
-		g_free(counter);
-		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
-		ret = FALSE;
 		goto end;
 	}
 
-	(*counter)--;
-	// bson_copy_to requires the destination to be uninitialized
-	bson_destroy(metadata);
-	bson_copy_to(bd->entry_cache, metadata);
+	rows = memory_select(table, condition);
+
+	for (guint i = 0; i < rows->len; i++)
+	{
+		guint row = g_array_index(rows, guint, i);
+		JMemoryGroup* group;
+		GBytes* group_key;
+		gpointer index;
+
+		g_byte_array_set_size(key, 0);
+
+		for (guint j = 0; j < columns->len; j++)
+		{
+			JMemoryColumn* column = g_ptr_array_index(columns, j);
+			guint8 present = memory_column_present(column, row);
+
+			g_byte_array_append(key, &present, 1);
+
+			if (present)
+			{
+				memory_key_append(key, column->type, memory_column_get(column, row));
+			}
+		}
+
+		group_key = g_bytes_new(key->data, key->len);
+
+		if ((index = g_hash_table_lookup(groups_by_key, group_key)) == NULL)
+		{
+			JMemoryGroup new_group;
+
+			new_group.row = row;
+			new_group.values = g_new0(JMemoryValue, functions->len);
+			new_group.counts = g_new0(guint64, functions->len);
+			g_array_append_val(groups, new_group);
+
+			index = GUINT_TO_POINTER(groups->len);
+			g_hash_table_insert(groups_by_key, group_key, index);
+		}
+		else
+		{
+			g_bytes_unref(group_key);
+		}
+
+		group = &g_array_index(groups, JMemoryGroup, GPOINTER_TO_UINT(index) - 1);
+
+		for (guint j = 0; j < functions->len; j++)
+		{
+			memory_function_accumulate(&g_array_index(functions, JMemoryFunction, j), row, &group->values[j], &group->counts[j]);
+		}
+	}
+
+	// Without group-by fields, there always is exactly one result
+	if (columns->len == 0 && groups->len == 0)
+	{
+		JMemoryGroup new_group;
+
+		new_group.row = 0;
+		new_group.values = g_new0(JMemoryValue, functions->len);
+		new_group.counts = g_new0(guint64, functions->len);
+		g_array_append_val(groups, new_group);
+	}
+
+	g_array_sort_with_data(groups, memory_group_compare, columns);
+
+	for (guint i = 0; i < groups->len; i++)
+	{
+		JMemoryGroup* group = &g_array_index(groups, JMemoryGroup, i);
+		bson_t* result = bson_new();
+
+		g_ptr_array_add(results, result);
+
+		for (guint j = 0; j < columns->len; j++)
+		{
+			JMemoryColumn* column = g_ptr_array_index(columns, j);
+
+			if (memory_column_present(column, group->row)
+			    && G_UNLIKELY(!memory_value_to_bson(result, column->name, column->type, memory_column_get(column, group->row), error)))
+			{
+				goto end;
+			}
+		}
+
+		for (guint j = 0; j < functions->len; j++)
+		{
+			JMemoryFunction* function = &g_array_index(functions, JMemoryFunction, j);
+			JDBTypeValue value;
+
+			switch (function->function)
+			{
+				case J_DB_AGGREGATE_FUNCTION_COUNT:
+					value.val_uint64 = group->counts[j];
+					break;
+				case J_DB_AGGREGATE_FUNCTION_AVG:
+					if (group->counts[j] == 0)
+					{
+						continue;
+					}
+
+					value.val_float64 = group->values[j].val_float64 / group->counts[j];
+					break;
+				case J_DB_AGGREGATE_FUNCTION_MIN:
+				case J_DB_AGGREGATE_FUNCTION_MAX:
+					if (group->counts[j] == 0)
+					{
+						continue;
+					}
+					// fallthrough
+				case J_DB_AGGREGATE_FUNCTION_SUM:
+				default:
+					switch (function->type)
+					{
+						case J_DB_TYPE_SINT32:
+							value.val_sint32 = group->values[j].val_sint32;
+							break;
+						case J_DB_TYPE_UINT32:
+							value.val_uint32 = group->values[j].val_uint32;
+							break;
+						case J_DB_TYPE_FLOAT32:
+							value.val_float32 = group->values[j].val_float32;
+							break;
+						case J_DB_TYPE_SINT64:
+							value.val_sint64 = group->values[j].val_sint64;
+							break;
+						case J_DB_TYPE_UINT64:
+							value.val_uint64 = group->values[j].val_uint64;
+							break;
+						case J_DB_TYPE_FLOAT64:
+							value.val_float64 = group->values[j].val_float64;
+							break;
+						default:
+							g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_DB_TYPE_INVALID, "db type invalid");
+							goto end;
+					}
+					break;
+			}
+
+			if (G_UNLIKELY(!j_bson_append_value(result, function->name, function->type, &value, error)))
+			{
+				goto end;
+			}
+		}
+	}
+
+	memory_iterator = g_slice_new(JMemoryIterator);
+	memory_iterator->table = memory_table_ref(table);
+	memory_iterator->columns = NULL;
+	memory_iterator->rows = NULL;
+	memory_iterator->results = g_steal_pointer(&results);
+	memory_iterator->position = 0;
+
+	*iterator = memory_iterator;
+	ret = TRUE;
 
 end:
-	g_mutex_unlock(bd->lock);
+	for (guint i = 0; i < groups->len; i++)
+	{
+		g_free(g_array_index(groups, JMemoryGroup, i).values);
+		g_free(g_array_index(groups, JMemoryGroup, i).counts);
+	}
+
+	if (rows != NULL)
+	{
+		g_array_unref(rows);
+	}
+
+	if (condition != NULL)
+	{
+		memory_condition_free(condition);
+	}
+
+	g_rw_lock_reader_unlock(bd->lock);
 
 	return ret;
 }
 
+static void
+backend_iterator_free(gpointer backend_data, gpointer iterator)
+{
+	JMemoryData* bd = backend_data;
+
+	g_rw_lock_reader_lock(bd->lock);
+	memory_iterator_free(iterator);
+	g_rw_lock_reader_unlock(bd->lock);
+}
+
 static gboolean
 backend_init(gchar const* path, gpointer* backend_data)
 {
@@ -271,10 +2860,8 @@ backend_init(gchar const* path, gpointer* backend_data)
 	(void)path;
 
 	bd = g_slice_new(JMemoryData);
-	bd->schema_cache = NULL;
-	bd->entry_cache = NULL;
-	bd->entry_counter = 0;
-	g_mutex_init(bd->lock);
+	bd->namespaces = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_hash_table_unref);
+	g_rw_lock_init(bd->lock);
 
 	*backend_data = bd;
 
@@ -286,17 +2873,9 @@ backend_fini(gpointer backend_data)
 {
 	JMemoryData* bd = backend_data;
 
-	if (bd->schema_cache != NULL)
-	{
-		bson_destroy(bd->schema_cache);
-	}
-
-	if (bd->entry_cache != NULL)
-	{
-		bson_destroy(bd->entry_cache);
-	}
+	g_hash_table_unref(bd->namespaces);
 
-	g_mutex_clear(bd->lock);
+	g_rw_lock_clear(bd->lock);
 	g_slice_free(JMemoryData, bd);
 }
 
@@ -313,7 +2892,10 @@ static JBackend memory_backend = {
 		.backend_update = backend_update,
 		.backend_delete = backend_delete,
 		.backend_query = backend_query,
+		.backend_query_fields = backend_query_fields,
 		.backend_iterate = backend_iterate,
+		.backend_iterator_free = backend_iterator_free,
+		.backend_aggregate = backend_aggregate,
 		.backend_batch_start = backend_batch_start,
 		.backend_batch_execute = backend_batch_execute }
 };
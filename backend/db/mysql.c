@@ -32,19 +32,29 @@
 
 #define SQL_MODE_SINGLE_THREAD 0
 #define SQL_MODE_MULTI_THREAD 1
-#define SQL_MODE SQL_MODE_MULTI_THREAD
 
 #define SQL_AUTOINCREMENT_STRING " NOT NULL AUTO_INCREMENT "
 #define SQL_UINT64_TYPE " BIGINT UNSIGNED "
 #define SQL_LAST_INSERT_ID_STRING " SELECT LAST_INSERT_ID() "
 #define SQL_QUOTE "`"
 
+// InnoDB assigns consecutive ids to the rows of a multi-row insert, LAST_INSERT_ID() returns the first one
+#define SQL_INSERT_CONSECUTIVE_IDS
+
+// Prepared statements are limited to 65535 variables
+#define SQL_INSERT_MAX_VARIABLES 65535
+
 struct JMySQLData
 {
 	gchar* db_host;
 	gchar* db_database;
 	gchar* db_user;
 	gchar* db_password;
+
+	/**
+	 * The maximum number of connections, 0 uses one connection per thread.
+	 **/
+	guint max_connections;
 };
 
 typedef struct JMySQLData JMySQLData;
@@ -567,14 +577,63 @@ _error2:
 	return FALSE;
 }
 
+static gboolean
+j_sql_changes(MYSQL* backend_db, void* _stmt, guint64* changes, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	mysql_stmt_wrapper* wrapper = _stmt;
+
+	(void)error;
+
+	g_return_val_if_fail(backend_db != NULL, FALSE);
+	g_return_val_if_fail(_stmt != NULL, FALSE);
+
+	*changes = mysql_stmt_affected_rows(wrapper->stmt);
+
+	return TRUE;
+}
+
+static guint
+j_sql_mode(gpointer backend_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	(void)backend_data;
+
+	return SQL_MODE_MULTI_THREAD;
+}
+
+static gboolean
+j_sql_per_namespace(gpointer backend_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	(void)backend_data;
+
+	return FALSE;
+}
+
+static guint
+j_sql_max_connections(gpointer backend_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMySQLData* bd = backend_data;
+
+	return bd->max_connections;
+}
+
 static void*
-j_sql_open(gpointer backend_data)
+j_sql_open(gpointer backend_data, gchar const* namespace)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JMySQLData* bd = backend_data;
 	MYSQL* backend_db = NULL;
 
+	(void)namespace;
+
 	if (!(backend_db = mysql_init(NULL)))
 	{
 		goto _error;
@@ -587,7 +646,7 @@ j_sql_open(gpointer backend_data)
 				bd->db_database, //database name
 				3306, //port number
 				NULL, //unix socket
-				0 //client flags
+				CLIENT_FOUND_ROWS //client flags, count matched instead of changed rows
 				))
 	{
 		goto _error;
@@ -663,7 +722,12 @@ backend_init(gchar const* path, gpointer* backend_data)
 
 	split = g_strsplit(path, ":", 0);
 
-	if (g_strv_length(split) != 4)
+	if (g_strv_length(split) < 4 || g_strv_length(split) > 5)
+	{
+		return FALSE;
+	}
+
+	if (split[4] != NULL && !g_str_has_prefix(split[4], "connections="))
 	{
 		return FALSE;
 	}
@@ -673,6 +737,7 @@ backend_init(gchar const* path, gpointer* backend_data)
 	bd->db_database = g_strdup(split[1]);
 	bd->db_user = g_strdup(split[2]);
 	bd->db_password = g_strdup(split[3]);
+	bd->max_connections = (split[4] != NULL) ? g_ascii_strtoull(split[4] + strlen("connections="), NULL, 10) : 0;
 
 	g_return_val_if_fail(bd->db_host != NULL, FALSE);
 	g_return_val_if_fail(bd->db_database != NULL, FALSE);
@@ -712,12 +777,18 @@ static JBackend mysql_backend = {
 		.backend_schema_get = backend_schema_get,
 		.backend_schema_delete = backend_schema_delete,
 		.backend_insert = backend_insert,
+		.backend_insert_multi = backend_insert_multi,
 		.backend_update = backend_update,
 		.backend_delete = backend_delete,
 		.backend_query = backend_query,
+		.backend_query_fields = backend_query_fields,
 		.backend_iterate = backend_iterate,
+		.backend_iterator_free = backend_iterator_free,
+		.backend_aggregate = backend_aggregate,
+		.backend_advise_indexes = backend_advise_indexes,
 		.backend_batch_start = backend_batch_start,
 		.backend_batch_execute = backend_batch_execute,
+		.backend_batch_abort = backend_batch_abort,
 	},
 };
 
@@ -42,45 +42,57 @@ backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* s
 static gboolean
 backend_batch_execute(gpointer backend_data, gpointer batch, GError** error)
 {
-	(void)backend_data;
+	JBackendLatency* latency = backend_data;
+
 	(void)batch;
 	(void)error;
 
+	j_backend_latency_inject(latency, J_BACKEND_LATENCY_WRITE, 0);
+
 	return TRUE;
 }
 
 static gboolean
 backend_schema_create(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* schema, GError** error)
 {
-	(void)backend_data;
+	JBackendLatency* latency = backend_data;
+
 	(void)batch;
 	(void)name;
 	(void)schema;
 	(void)error;
 
+	j_backend_latency_inject(latency, J_BACKEND_LATENCY_METADATA, 0);
+
 	return TRUE;
 }
 
 static gboolean
 backend_schema_get(gpointer backend_data, gpointer batch, gchar const* name, bson_t* schema, GError** error)
 {
-	(void)backend_data;
+	JBackendLatency* latency = backend_data;
+
 	(void)batch;
 	(void)name;
 	(void)schema;
 	(void)error;
 
+	j_backend_latency_inject(latency, J_BACKEND_LATENCY_METADATA, 0);
+
 	return TRUE;
 }
 
 static gboolean
 backend_schema_delete(gpointer backend_data, gpointer batch, gchar const* name, GError** error)
 {
-	(void)backend_data;
+	JBackendLatency* latency = backend_data;
+
 	(void)batch;
 	(void)name;
 	(void)error;
 
+	j_backend_latency_inject(latency, J_BACKEND_LATENCY_METADATA, 0);
+
 	return TRUE;
 }
 
@@ -125,13 +137,16 @@ backend_delete(gpointer backend_data, gpointer batch, gchar const* name, bson_t
 static gboolean
 backend_query(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* selector, gpointer* iterator, GError** error)
 {
-	(void)backend_data;
+	JBackendLatency* latency = backend_data;
+
 	(void)batch;
 	(void)name;
 	(void)selector;
 	(void)iterator;
 	(void)error;
 
+	j_backend_latency_inject(latency, J_BACKEND_LATENCY_READ, 0);
+
 	return TRUE;
 }
 
@@ -149,8 +164,16 @@ backend_iterate(gpointer backend_data, gpointer iterator, bson_t* metadata, GErr
 static gboolean
 backend_init(gchar const* path, gpointer* backend_data)
 {
-	(void)path;
-	(void)backend_data;
+	JBackendLatency* latency;
+
+	// The path can be suffixed with a latency model (:read=100:write=~200)
+	if ((latency = j_backend_latency_new(path)) == NULL)
+	{
+		g_warning("Invalid latency model %s.", path);
+		return FALSE;
+	}
+
+	*backend_data = latency;
 
 	return TRUE;
 }
@@ -158,7 +181,9 @@ backend_init(gchar const* path, gpointer* backend_data)
 static void
 backend_fini(gpointer backend_data)
 {
-	(void)backend_data;
+	JBackendLatency* latency = backend_data;
+
+	j_backend_latency_free(latency);
 }
 
 static JBackend null_backend = {
@@ -26,7 +26,10 @@
 struct JThreadVariables
 {
 	gboolean initialized;
+	// The connection used by the current batch
 	void* sql_backend;
+	// namespace(char*) -> connection, only used if the backend stores each namespace separately
+	GHashTable* sql_backends;
 	GHashTable* namespaces;
 };
 
@@ -39,24 +42,57 @@ struct JSqlCacheNames
 
 typedef struct JSqlCacheNames JSqlCacheNames;
 
-struct JSqlCacheSQLQueries
+/*
+ * Schema types are shared by all threads, only prepared statements are kept per thread.
+ * Entries are immutable once published and are replaced instead of modified.
+ */
+struct JSqlCacheSchema
 {
+	gint ref_count;
 	GHashTable* types; // variablename(char*) -> variabletype(JDBType)
+};
+
+typedef struct JSqlCacheSchema JSqlCacheSchema;
+
+struct JSqlCacheSQLQueries
+{
+	// Shared schema types, NULL if not loaded yet
+	JSqlCacheSchema* schema;
+	// Value of schema_cache_version when schema was last validated
+	guint version;
 	GHashTable* queries; //sql(char*) -> (JSqlCacheSQLPrepared*)
+	GHashTable* shapes; //shape(char*) -> (JSqlCacheShape*)
 };
 
 typedef struct JSqlCacheSQLQueries JSqlCacheSQLQueries;
 
+/*
+ * The condition built for a prepared selector, see j_db_selector_prepare().
+ * Selectors of the same shape only differ in their values, so the condition can be reused.
+ */
+struct JSqlCacheShape
+{
+	gchar* sql;
+	// Types of the condition's variables
+	GArray* types;
+};
+
+typedef struct JSqlCacheShape JSqlCacheShape;
+
 struct JSqlCacheSQLPrepared
 {
 	GString* sql;
 	void* stmt;
 	guint variables_count;
 	GHashTable* variables_index;
+	// Types of the selected columns if they are not fields of the schema, for example, aggregates
+	GArray* variables_type;
 	gboolean initialized;
 	gchar* namespace;
 	gchar* name;
 	gpointer backend_data;
+	// The connection the statement was prepared on
+	void* sql_backend;
 };
 
 typedef struct JSqlCacheSQLPrepared JSqlCacheSQLPrepared;
@@ -84,405 +120,610 @@ typedef struct JSqlIterator JSqlIterator;
 static void thread_variables_fini(void* ptr);
 static GPrivate thread_variables_global = G_PRIVATE_INIT(thread_variables_fini);
 
-static void
-sql_generic_init(void)
+/*
+ * If the backend limits the number of connections, connections are not bound to threads.
+ * Instead, a batch takes a connection from the pool when it starts and returns it when it ends.
+ */
+static GQueue thread_variables_pool = G_QUEUE_INIT;
+static GMutex thread_variables_pool_mutex;
+static GCond thread_variables_pool_cond;
+// Number of pooled connections, including those currently used by batches
+static guint thread_variables_pool_count = 0;
+// The pooled connection used by the current thread's batch
+static GPrivate thread_variables_pooled;
+
+// namespace(char*) -> (name(char*) -> JSqlCacheSchema*)
+static GHashTable* schema_cache_shared = NULL;
+static GRWLock schema_cache_lock;
+// Incremented whenever a schema is deleted, threads revalidate their cached schemas if it changes
+static guint schema_cache_version = 0;
+
+/*
+ * Queries that have to compare at least this many times before an index is suggested for them.
+ */
+#define SQL_ADVISOR_MIN_QUERIES 16
+
+/*
+ * The index advisor records which fields selectors compare and how long the corresponding queries take.
+ * Candidates are shared by all threads.
+ */
+struct JSqlAdvisorCandidate
+{
+	// Fields compared for equality in sorted order, followed by at most one field compared using a range
+	GPtrArray* fields;
+	guint equal_count;
+	guint64 queries;
+	// Microseconds spent in the queries
+	guint64 time;
+};
+
+typedef struct JSqlAdvisorCandidate JSqlAdvisorCandidate;
+
+struct JSqlAdvisorSchema
+{
+	GHashTable* candidates; // fields(char*) -> (JSqlAdvisorCandidate*)
+	// The schema's known indexes, each one a GPtrArray of field names
+	GPtrArray* indexes;
+};
+
+typedef struct JSqlAdvisorSchema JSqlAdvisorSchema;
+
+// namespace/name(char*) -> JSqlAdvisorSchema*
+static GHashTable* advisor_schemas = NULL;
+static GMutex advisor_mutex;
+
+static JSqlCacheSchema*
+schema_cache_ref(JSqlCacheSchema* schema)
 {
 	J_TRACE_FUNCTION(NULL);
+
+	g_atomic_int_inc(&schema->ref_count);
+
+	return schema;
 }
 
 static void
-sql_generic_fini(void)
+schema_cache_unref(JSqlCacheSchema* schema)
 {
 	J_TRACE_FUNCTION(NULL);
+
+	if (schema && g_atomic_int_dec_and_test(&schema->ref_count))
+	{
+		g_hash_table_unref(schema->types);
+		g_free(schema);
+	}
 }
 
 static void
-thread_variables_fini(void* ptr)
+sql_generic_init(void)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JThreadVariables* thread_variables = ptr;
+	g_rw_lock_writer_lock(&schema_cache_lock);
 
-	if (thread_variables)
+	if (schema_cache_shared == NULL)
 	{
-		if (thread_variables->namespaces)
-		{
-			g_hash_table_destroy(thread_variables->namespaces);
-		}
-
-		j_sql_close(thread_variables->sql_backend);
-		g_free(thread_variables);
+		schema_cache_shared = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_hash_table_unref);
 	}
-}
 
-static void freeJSqlCacheNames(void* ptr);
+	g_rw_lock_writer_unlock(&schema_cache_lock);
+}
 
-static JThreadVariables*
-thread_variables_get(gpointer backend_data, GError** error)
+static void
+sql_generic_fini(void)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JThreadVariables* thread_variables = NULL;
+	JThreadVariables* thread_variables;
 
-	thread_variables = g_private_get(&thread_variables_global);
+	g_mutex_lock(&thread_variables_pool_mutex);
 
-	if (!thread_variables)
+	while ((thread_variables = g_queue_pop_head(&thread_variables_pool)) != NULL)
 	{
-		thread_variables = g_new0(JThreadVariables, 1);
-		thread_variables->initialized = FALSE;
+		thread_variables_fini(thread_variables);
+		thread_variables_pool_count--;
 	}
 
-	if (!thread_variables->initialized)
-	{
-		thread_variables->sql_backend = j_sql_open(backend_data);
+	g_mutex_unlock(&thread_variables_pool_mutex);
 
-		if (G_UNLIKELY(!j_sql_exec(thread_variables->sql_backend,
-					   "CREATE TABLE IF NOT EXISTS schema_structure ("
-					   "namespace VARCHAR(255),"
-					   "name VARCHAR(255),"
-					   "varname VARCHAR(255),"
-					   "vartype INTEGER"
-					   // FIXME figure out whether we should add an index instead
-					   //"PRIMARY KEY (namespace, name, varname)"
-					   ")",
-					   error)))
-		{
-			goto _error;
-		}
+	g_rw_lock_writer_lock(&schema_cache_lock);
 
-		thread_variables->namespaces = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, freeJSqlCacheNames);
-		thread_variables->initialized = TRUE;
-		g_private_replace(&thread_variables_global, thread_variables);
+	if (schema_cache_shared != NULL)
+	{
+		g_hash_table_unref(schema_cache_shared);
+		schema_cache_shared = NULL;
 	}
 
-	return thread_variables;
+	g_rw_lock_writer_unlock(&schema_cache_lock);
 
-_error:
-	return NULL;
+	g_mutex_lock(&advisor_mutex);
+
+	if (advisor_schemas != NULL)
+	{
+		g_hash_table_unref(advisor_schemas);
+		advisor_schemas = NULL;
+	}
+
+	g_mutex_unlock(&advisor_mutex);
 }
 
-static void
-freeJSqlIterator(gpointer ptr)
+static JSqlCacheSchema*
+schema_cache_lookup(gchar const* namespace, gchar const* name)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JSqlIterator* iter = ptr;
+	JSqlCacheSchema* schema = NULL;
+	GHashTable* names;
 
-	if (ptr)
+	g_rw_lock_reader_lock(&schema_cache_lock);
+
+	if (schema_cache_shared != NULL && (names = g_hash_table_lookup(schema_cache_shared, namespace)) != NULL)
 	{
-		g_free(iter->namespace);
-		g_free(iter->name);
-		g_array_free(iter->arr, TRUE);
-		g_free(iter);
+		if ((schema = g_hash_table_lookup(names, name)) != NULL)
+		{
+			schema_cache_ref(schema);
+		}
 	}
+
+	g_rw_lock_reader_unlock(&schema_cache_lock);
+
+	return schema;
 }
 
-static void
-freeJSqlCacheNames(void* ptr)
+/*
+ * Publishes a schema loaded at the given version.
+ * Returns the schema that should be used, which might have been published by another thread in the meantime.
+ */
+static JSqlCacheSchema*
+schema_cache_publish(gchar const* namespace, gchar const* name, JSqlCacheSchema* schema, guint version)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JSqlCacheNames* p = ptr;
+	JSqlCacheSchema* existing;
+	GHashTable* names;
 
-	if (ptr)
+	g_rw_lock_writer_lock(&schema_cache_lock);
+
+	// The schema might have been deleted while it was loaded, do not publish it in this case
+	if (schema_cache_shared == NULL || version != (guint)g_atomic_int_get(&schema_cache_version))
 	{
-		if (p->names)
-		{
-			g_hash_table_destroy(p->names);
-		}
+		goto end;
+	}
 
-		g_free(p);
+	if ((names = g_hash_table_lookup(schema_cache_shared, namespace)) == NULL)
+	{
+		names = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)schema_cache_unref);
+		g_hash_table_insert(schema_cache_shared, g_strdup(namespace), names);
+	}
+
+	if ((existing = g_hash_table_lookup(names, name)) != NULL)
+	{
+		schema_cache_unref(schema);
+		schema = schema_cache_ref(existing);
 	}
+	else
+	{
+		g_hash_table_insert(names, g_strdup(name), schema_cache_ref(schema));
+	}
+
+end:
+	g_rw_lock_writer_unlock(&schema_cache_lock);
+
+	return schema;
 }
 
 static void
-freeJSqlCacheSQLQueries(void* ptr)
+schema_cache_invalidate(gchar const* namespace, gchar const* name)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JSqlCacheSQLQueries* p = ptr;
+	GHashTable* names;
 
-	if (ptr)
+	g_rw_lock_writer_lock(&schema_cache_lock);
+
+	if (schema_cache_shared != NULL && (names = g_hash_table_lookup(schema_cache_shared, namespace)) != NULL)
 	{
-		if (p->queries)
-		{
-			g_hash_table_destroy(p->queries);
-		}
+		g_hash_table_remove(names, name);
+	}
 
-		if (p->types)
-		{
-			g_hash_table_destroy(p->types);
-		}
+	g_atomic_int_inc(&schema_cache_version);
 
-		g_free(p);
-	}
+	g_rw_lock_writer_unlock(&schema_cache_lock);
 }
 
 static void
-freeJSqlCacheSQLPrepared(void* ptr)
+advisor_candidate_free(gpointer data)
 {
-	J_TRACE_FUNCTION(NULL);
+	JSqlAdvisorCandidate* candidate = data;
 
-	JSqlCacheSQLPrepared* p = ptr;
-	JThreadVariables* thread_variables = NULL;
+	g_ptr_array_unref(candidate->fields);
+	g_free(candidate);
+}
 
-	if (G_UNLIKELY(!(thread_variables = thread_variables_get(p->backend_data, NULL))))
-		g_assert_not_reached();
+static void
+advisor_schema_free(gpointer data)
+{
+	JSqlAdvisorSchema* schema = data;
 
-	if (ptr)
+	g_hash_table_unref(schema->candidates);
+	g_ptr_array_unref(schema->indexes);
+	g_free(schema);
+}
+
+/*
+ * Returns the advisor's state for a schema, advisor_mutex has to be held.
+ */
+static JSqlAdvisorSchema*
+advisor_schema_get(gchar const* namespace, gchar const* name)
+{
+	g_autofree gchar* key = NULL;
+	JSqlAdvisorSchema* schema;
+
+	if (advisor_schemas == NULL)
 	{
-		if (p->initialized)
-		{
-			if (p->variables_index)
-			{
-				g_hash_table_destroy(p->variables_index);
-			}
+		advisor_schemas = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, advisor_schema_free);
+	}
 
-			if (p->sql)
-			{
-				g_string_free(p->sql, TRUE);
-			}
+	key = g_strdup_printf("%s/%s", namespace, name);
 
-			if (p->stmt)
-			{
-				j_sql_finalize(thread_variables->sql_backend, p->stmt, NULL);
-			}
-		}
+	if ((schema = g_hash_table_lookup(advisor_schemas, key)) == NULL)
+	{
+		schema = g_new(JSqlAdvisorSchema, 1);
+		schema->candidates = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, advisor_candidate_free);
+		schema->indexes = g_ptr_array_new_with_free_func((GDestroyNotify)g_ptr_array_unref);
 
-		g_free(p->namespace);
-		g_free(p->name);
-		g_free(p);
+		g_hash_table_insert(advisor_schemas, g_steal_pointer(&key), schema);
 	}
+
+	return schema;
 }
 
-static JSqlCacheSQLQueries*
-_getCachePrepared(gpointer backend_data, gchar const* namespace, gchar const* name, GError** error)
+static void
+advisor_forget(gchar const* namespace, gchar const* name)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JSqlCacheNames* cacheNames = NULL;
-	JSqlCacheSQLQueries* cacheQueries = NULL;
-	JThreadVariables* thread_variables = NULL;
+	g_autofree gchar* key = NULL;
 
-	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	key = g_strdup_printf("%s/%s", namespace, name);
+
+	g_mutex_lock(&advisor_mutex);
+
+	if (advisor_schemas != NULL)
 	{
-		goto _error;
+		g_hash_table_remove(advisor_schemas, key);
 	}
 
-	g_return_val_if_fail(thread_variables->namespaces != NULL, NULL);
+	g_mutex_unlock(&advisor_mutex);
+}
 
-	if (!(cacheNames = g_hash_table_lookup(thread_variables->namespaces, namespace)))
+/*
+ * Remembers an existing index, so that it is not suggested.
+ * Takes ownership of fields.
+ */
+static void
+advisor_add_index(gchar const* namespace, gchar const* name, GPtrArray* fields)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_mutex_lock(&advisor_mutex);
+	g_ptr_array_add(advisor_schema_get(namespace, name)->indexes, fields);
+	g_mutex_unlock(&advisor_mutex);
+}
+
+static gboolean
+advisor_covered(JSqlAdvisorSchema* schema, JSqlAdvisorCandidate* candidate)
+{
+	for (guint i = 0; i < schema->indexes->len; i++)
 	{
-		cacheNames = g_new0(JSqlCacheNames, 1);
-		cacheNames->names = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, freeJSqlCacheSQLQueries);
+		GPtrArray* index = g_ptr_array_index(schema->indexes, i);
+		gboolean covered = TRUE;
 
-		if (G_UNLIKELY(!g_hash_table_insert(thread_variables->namespaces, g_strdup(namespace), cacheNames)))
+		if (index->len < candidate->fields->len)
 		{
-			g_assert_not_reached();
+			continue;
 		}
-	}
 
-	if (!(cacheQueries = g_hash_table_lookup(cacheNames->names, name)))
-	{
-		cacheQueries = g_new0(JSqlCacheSQLQueries, 1);
-		cacheQueries->queries = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, freeJSqlCacheSQLPrepared);
-		cacheQueries->types = NULL;
+		// The equality fields have to be the index's first fields in any order, followed by the range field
+		for (guint j = 0; j < candidate->equal_count && covered; j++)
+		{
+			gboolean found = FALSE;
 
-		if (G_UNLIKELY(!g_hash_table_insert(cacheNames->names, g_strdup(name), cacheQueries)))
+			for (guint k = 0; k < candidate->equal_count && !found; k++)
+			{
+				found = (g_strcmp0(g_ptr_array_index(candidate->fields, j), g_ptr_array_index(index, k)) == 0);
+			}
+
+			covered = found;
+		}
+
+		if (covered && candidate->fields->len > candidate->equal_count)
 		{
-			g_assert_not_reached();
+			covered = (g_strcmp0(g_ptr_array_index(candidate->fields, candidate->equal_count), g_ptr_array_index(index, candidate->equal_count)) == 0);
 		}
-	}
 
-	return cacheQueries;
+		if (covered)
+		{
+			return TRUE;
+		}
+	}
 
-_error:
-	return NULL;
+	return FALSE;
 }
 
-static gboolean _backend_schema_get(gpointer backend_data, gpointer _batch, gchar const* name, bson_t* schema, GError** error);
-
-static GHashTable*
-getCacheSchema(gpointer backend_data, gpointer _batch, gchar const* name, GError** error)
+/*
+ * Collects the fields compared by the AND-connected parts of a selector.
+ * Fields compared within OR-connected parts can not use a single index and are ignored.
+ */
+static void
+advisor_collect(bson_iter_t* iter, GPtrArray* equal, GPtrArray* range)
 {
-	J_TRACE_FUNCTION(NULL);
-
-	JSqlBatch* batch = _batch;
-	gboolean schema_initialized = FALSE;
+	JDBTypeValue value;
+	bson_iter_t iter_mode;
+	bson_iter_t iter_child;
 	gboolean has_next;
 	gboolean equals;
-	bson_t schema;
-	JSqlCacheSQLQueries* cacheQueries = NULL;
-	bson_iter_t iter;
-	char const* string_tmp;
-	JDBTypeValue value;
 
-	if (!(cacheQueries = _getCachePrepared(backend_data, batch->namespace, name, error)))
+	iter_mode = *iter;
+
+	if (!j_bson_iter_find(&iter_mode, "_mode", NULL) || !j_bson_iter_value(&iter_mode, J_DB_TYPE_UINT32, &value, NULL) || value.val_uint32 != J_DB_SELECTOR_MODE_AND)
 	{
-		goto _error;
+		return;
 	}
 
-	if (cacheQueries->types == NULL)
+	while (j_bson_iter_next(iter, &has_next, NULL) && has_next)
 	{
-		cacheQueries->types = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+		gchar const* field;
 
-		if (!(schema_initialized = _backend_schema_get(backend_data, batch, name, &schema, error)))
+		if (!j_bson_iter_key_equals(iter, "_mode", &equals, NULL) || equals)
 		{
-			goto _error;
+			continue;
 		}
 
-		if (G_UNLIKELY(!j_bson_iter_init(&iter, &schema, error)))
+		if (!j_bson_iter_key_equals(iter, "_shape", &equals, NULL) || equals)
 		{
-			goto _error;
+			continue;
 		}
 
-		while (TRUE)
+		if (!j_bson_iter_recurse_document(iter, &iter_child, NULL))
 		{
-			if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
-			{
-				goto _error;
-			}
+			continue;
+		}
 
-			if (!has_next)
+		if (j_bson_iter_find(&iter_child, "_mode", NULL))
+		{
+			if (j_bson_iter_recurse_document(iter, &iter_child, NULL))
 			{
-				break;
+				advisor_collect(&iter_child, equal, range);
 			}
 
-			if (G_UNLIKELY(!j_bson_iter_key_equals(&iter, "_index", &equals, error)))
-			{
-				goto _error;
-			}
+			continue;
+		}
 
-			if (equals)
-			{
-				continue;
-			}
+		if (!j_bson_iter_recurse_document(iter, &iter_child, NULL) || !j_bson_iter_find(&iter_child, "_name", NULL) || !j_bson_iter_value(&iter_child, J_DB_TYPE_STRING, &value, NULL))
+		{
+			continue;
+		}
 
-			string_tmp = j_bson_iter_key(&iter, error);
+		field = value.val_string;
 
-			if (G_UNLIKELY(!string_tmp))
-			{
-				goto _error;
-			}
+		// _id is the primary key
+		if (g_strcmp0(field, "_id") == 0)
+		{
+			continue;
+		}
 
-			if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT32, &value, error)))
-			{
-				goto _error;
-			}
+		if (!j_bson_iter_recurse_document(iter, &iter_child, NULL) || !j_bson_iter_find(&iter_child, "_operator", NULL) || !j_bson_iter_value(&iter_child, J_DB_TYPE_UINT32, &value, NULL))
+		{
+			continue;
+		}
 
-			g_hash_table_insert(cacheQueries->types, g_strdup(string_tmp), GINT_TO_POINTER(value.val_uint32));
+		switch (value.val_uint32)
+		{
+			case J_DB_SELECTOR_OPERATOR_EQ:
+				if (!g_ptr_array_find_with_equal_func(equal, field, g_str_equal, NULL))
+				{
+					g_ptr_array_add(equal, (gpointer)field);
+				}
+				break;
+			case J_DB_SELECTOR_OPERATOR_LT:
+			case J_DB_SELECTOR_OPERATOR_LE:
+			case J_DB_SELECTOR_OPERATOR_GT:
+			case J_DB_SELECTOR_OPERATOR_GE:
+				g_ptr_array_add(range, (gpointer)field);
+				break;
+			case J_DB_SELECTOR_OPERATOR_NE:
+			default:
+				break;
 		}
 	}
+}
 
-	if (schema_initialized)
+static gint
+advisor_compare_fields(gconstpointer a, gconstpointer b)
+{
+	return g_strcmp0(*(gchar const* const*)a, *(gchar const* const*)b);
+}
+
+/*
+ * Records a query that used the given selector.
+ */
+static void
+advisor_record(gchar const* namespace, gchar const* name, bson_t const* selector, gint64 time)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GPtrArray) equal = NULL;
+	g_autoptr(GPtrArray) range = NULL;
+	g_autoptr(GString) key = NULL;
+	JSqlAdvisorSchema* schema;
+	JSqlAdvisorCandidate* candidate;
+	bson_iter_t iter;
+
+	if (selector == NULL || !j_bson_has_enough_keys(selector, 2, NULL) || !j_bson_iter_init(&iter, selector, NULL))
 	{
-		j_bson_destroy(&schema);
+		return;
 	}
 
-	return cacheQueries->types;
+	equal = g_ptr_array_new();
+	range = g_ptr_array_new();
 
-_error:
-	if (schema_initialized)
+	advisor_collect(&iter, equal, range);
+
+	// Fields compared for equality as well as using a range only benefit from the equality
+	for (guint i = 0; i < range->len;)
 	{
-		j_bson_destroy(&schema);
+		if (g_ptr_array_find_with_equal_func(equal, g_ptr_array_index(range, i), g_str_equal, NULL))
+		{
+			g_ptr_array_remove_index(range, i);
+		}
+		else
+		{
+			i++;
+		}
 	}
 
-	if (cacheQueries->types)
+	if (equal->len == 0 && range->len == 0)
 	{
-		g_hash_table_unref(cacheQueries->types);
-		cacheQueries->types = NULL;
+		return;
 	}
 
-	return NULL;
-}
-
-static JSqlCacheSQLPrepared*
-getCachePrepared(gpointer backend_data, gchar const* namespace, gchar const* name, gchar const* query, GError** error)
-{
-	J_TRACE_FUNCTION(NULL);
-
-	JSqlCacheSQLQueries* cacheQueries = NULL;
-	JSqlCacheSQLPrepared* cachePrepared = NULL;
-	JThreadVariables* thread_variables = NULL;
+	g_ptr_array_sort(equal, advisor_compare_fields);
+	key = g_string_new(NULL);
 
-	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	for (guint i = 0; i < equal->len; i++)
 	{
-		goto _error;
+		g_string_append_printf(key, "%s%s", (i > 0) ? "," : "", (gchar const*)g_ptr_array_index(equal, i));
 	}
 
-	if (!(cacheQueries = _getCachePrepared(backend_data, namespace, name, error)))
+	// Only the first range can be used together with the equality fields
+	if (range->len > 0)
 	{
-		goto _error;
+		g_string_append_printf(key, "|%s", (gchar const*)g_ptr_array_index(range, 0));
 	}
 
-	if (!(cachePrepared = g_hash_table_lookup(cacheQueries->queries, query)))
+	g_mutex_lock(&advisor_mutex);
+
+	schema = advisor_schema_get(namespace, name);
+
+	if ((candidate = g_hash_table_lookup(schema->candidates, key->str)) == NULL)
 	{
-		cachePrepared = g_new0(JSqlCacheSQLPrepared, 1);
-		cachePrepared->namespace = g_strdup(namespace);
-		cachePrepared->name = g_strdup(name);
-		cachePrepared->backend_data = backend_data;
+		candidate = g_new0(JSqlAdvisorCandidate, 1);
+		candidate->fields = g_ptr_array_new_with_free_func(g_free);
+		candidate->equal_count = equal->len;
 
-		if (G_UNLIKELY(!g_hash_table_insert(cacheQueries->queries, g_strdup(query), cachePrepared)))
+		for (guint i = 0; i < equal->len; i++)
 		{
-			g_assert_not_reached();
+			g_ptr_array_add(candidate->fields, g_strdup(g_ptr_array_index(equal, i)));
+		}
+
+		if (range->len > 0)
+		{
+			g_ptr_array_add(candidate->fields, g_strdup(g_ptr_array_index(range, 0)));
 		}
+
+		g_hash_table_insert(schema->candidates, g_strdup(key->str), candidate);
 	}
 
-	return cachePrepared;
+	candidate->queries++;
+	candidate->time += MAX(0, time);
 
-_error:
-	return NULL;
+	g_mutex_unlock(&advisor_mutex);
 }
 
 static void
-deleteCachePrepared(gpointer backend_data, gchar const* namespace, gchar const* name)
+thread_variables_fini(void* ptr)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JSqlCacheNames* cacheNames = NULL;
-	JThreadVariables* thread_variables = NULL;
+	JThreadVariables* thread_variables = ptr;
 
-	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, NULL))))
+	if (thread_variables)
 	{
-		goto _error;
+		// Prepared statements have to be finalized before their connections are closed
+		if (thread_variables->namespaces)
+		{
+			g_hash_table_destroy(thread_variables->namespaces);
+		}
+
+		if (thread_variables->sql_backends)
+		{
+			g_hash_table_destroy(thread_variables->sql_backends);
+		}
+		else
+		{
+			j_sql_close(thread_variables->sql_backend);
+		}
+
+		g_free(thread_variables);
 	}
+}
 
-	g_return_if_fail(thread_variables->namespaces != NULL);
+static void freeJSqlCacheNames(void* ptr);
 
-	if (G_UNLIKELY(!(cacheNames = g_hash_table_lookup(thread_variables->namespaces, namespace))))
+static void
+thread_variables_close(gpointer sql_backend)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	j_sql_close(sql_backend);
+}
+
+/*
+ * Opens a connection and makes sure the schema_structure table exists.
+ * namespace is NULL for the connection shared by all namespaces.
+ */
+static void*
+thread_variables_open(gpointer backend_data, gchar const* namespace, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	void* sql_backend;
+
+	if (G_UNLIKELY((sql_backend = j_sql_open(backend_data, namespace)) == NULL))
 	{
+		g_set_error_literal(error, J_BACKEND_SQL_ERROR, J_BACKEND_SQL_ERROR_FAILED, "sql open failed");
 		goto _error;
 	}
 
-	g_hash_table_remove(cacheNames->names, name);
+	if (G_UNLIKELY(!j_sql_exec(sql_backend,
+				   "CREATE TABLE IF NOT EXISTS schema_structure ("
+				   "namespace VARCHAR(255),"
+				   "name VARCHAR(255),"
+				   "varname VARCHAR(255),"
+				   "vartype INTEGER"
+				   // FIXME figure out whether we should add an index instead
+				   //"PRIMARY KEY (namespace, name, varname)"
+				   ")",
+				   error)))
+	{
+		j_sql_close(sql_backend);
+		goto _error;
+	}
 
-	return;
+	return sql_backend;
 
 _error:
-	return;
+	return NULL;
 }
 
 static gboolean
-_backend_batch_start(gpointer backend_data, JSqlBatch* batch, GError** error)
+thread_variables_init(JThreadVariables* thread_variables, gpointer backend_data, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JThreadVariables* thread_variables = NULL;
-
-	g_return_val_if_fail(!batch->open, FALSE);
-
-	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	if (j_sql_per_namespace(backend_data))
 	{
-		goto _error;
+		// Connections are opened by thread_variables_select when a namespace is used for the first time
+		thread_variables->sql_backends = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, thread_variables_close);
 	}
-
-	if (!j_sql_start_transaction(thread_variables->sql_backend, error))
+	else if (G_UNLIKELY((thread_variables->sql_backend = thread_variables_open(backend_data, NULL, error)) == NULL))
 	{
 		goto _error;
 	}
 
-	batch->open = TRUE;
-	batch->aborted = FALSE;
+	thread_variables->namespaces = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, freeJSqlCacheNames);
+	thread_variables->initialized = TRUE;
 
 	return TRUE;
 
@@ -490,54 +731,99 @@ _error:
 	return FALSE;
 }
 
-static gboolean
-_backend_batch_execute(gpointer backend_data, JSqlBatch* batch, GError** error)
+static JThreadVariables*
+thread_variables_get(gpointer backend_data, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JThreadVariables* thread_variables = NULL;
 
-	g_return_val_if_fail(batch->open || (!batch->open && batch->aborted), FALSE);
-
-	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	if (j_sql_max_connections(backend_data) > 0)
 	{
-		goto _error;
+		if (G_UNLIKELY((thread_variables = g_private_get(&thread_variables_pooled)) == NULL))
+		{
+			g_set_error_literal(error, J_BACKEND_SQL_ERROR, J_BACKEND_SQL_ERROR_FAILED, "sql connection used outside of a batch");
+		}
+
+		return thread_variables;
 	}
 
-	if (!j_sql_commit_transaction(thread_variables->sql_backend, error))
+	thread_variables = g_private_get(&thread_variables_global);
+
+	if (!thread_variables)
 	{
-		goto _error;
+		thread_variables = g_new0(JThreadVariables, 1);
+		thread_variables->initialized = FALSE;
 	}
 
-	batch->open = FALSE;
+	if (!thread_variables->initialized)
+	{
+		if (G_UNLIKELY(!thread_variables_init(thread_variables, backend_data, error)))
+		{
+			goto _error;
+		}
 
-	return TRUE;
+		g_private_replace(&thread_variables_global, thread_variables);
+	}
+
+	return thread_variables;
 
 _error:
-	return FALSE;
+	return NULL;
 }
 
+/*
+ * Binds a pooled connection to the current thread, waiting for one to become available if all are in use.
+ * Does nothing if the backend uses one connection per thread.
+ */
 static gboolean
-_backend_batch_abort(gpointer backend_data, JSqlBatch* batch, GError** error)
+thread_variables_acquire(gpointer backend_data, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JThreadVariables* thread_variables = NULL;
+	guint max_connections;
 
-	g_return_val_if_fail(batch->open, FALSE);
+	if ((max_connections = j_sql_max_connections(backend_data)) == 0)
+	{
+		return TRUE;
+	}
 
-	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	g_return_val_if_fail(g_private_get(&thread_variables_pooled) == NULL, FALSE);
+
+	g_mutex_lock(&thread_variables_pool_mutex);
+
+	while ((thread_variables = g_queue_pop_head(&thread_variables_pool)) == NULL && thread_variables_pool_count >= max_connections)
 	{
-		goto _error;
+		g_cond_wait(&thread_variables_pool_cond, &thread_variables_pool_mutex);
 	}
 
-	if (!j_sql_abort_transaction(thread_variables->sql_backend, error))
+	if (thread_variables == NULL)
 	{
-		goto _error;
+		// Reserve the slot before opening the connection without holding the lock
+		thread_variables_pool_count++;
 	}
 
-	batch->open = FALSE;
-	batch->aborted = TRUE;
+	g_mutex_unlock(&thread_variables_pool_mutex);
+
+	if (thread_variables == NULL)
+	{
+		thread_variables = g_new0(JThreadVariables, 1);
+
+		if (G_UNLIKELY(!thread_variables_init(thread_variables, backend_data, error)))
+		{
+			thread_variables_fini(thread_variables);
+
+			g_mutex_lock(&thread_variables_pool_mutex);
+			thread_variables_pool_count--;
+			g_cond_signal(&thread_variables_pool_cond);
+			g_mutex_unlock(&thread_variables_pool_mutex);
+
+			goto _error;
+		}
+	}
+
+	g_private_set(&thread_variables_pooled, thread_variables);
 
 	return TRUE;
 
@@ -545,255 +831,295 @@ _error:
 	return FALSE;
 }
 
-G_LOCK_DEFINE_STATIC(sql_backend_lock);
-
-static gboolean
-backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* _batch, GError** error)
+/*
+ * Returns the current thread's pooled connection.
+ */
+static void
+thread_variables_release(gpointer backend_data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JSqlBatch* batch;
-
-	g_return_val_if_fail(namespace != NULL, FALSE);
-	g_return_val_if_fail(semantics != NULL, FALSE);
-	g_return_val_if_fail(_batch != NULL, FALSE);
-
-	if (SQL_MODE == SQL_MODE_SINGLE_THREAD)
-		G_LOCK(sql_backend_lock);
-
-	batch = *_batch = g_new(JSqlBatch, 1);
-	batch->namespace = namespace;
-	batch->semantics = j_semantics_ref(semantics);
-	batch->open = FALSE;
+	JThreadVariables* thread_variables;
 
-	if (G_UNLIKELY(!_backend_batch_start(backend_data, batch, error)))
+	if (j_sql_max_connections(backend_data) == 0)
 	{
-		goto _error;
+		return;
 	}
 
-	return TRUE;
-
-_error:
-	j_semantics_unref(batch->semantics);
-	g_free(batch);
+	if ((thread_variables = g_private_get(&thread_variables_pooled)) == NULL)
+	{
+		return;
+	}
 
-	if (SQL_MODE == SQL_MODE_SINGLE_THREAD)
-		G_UNLOCK(sql_backend_lock);
+	g_private_set(&thread_variables_pooled, NULL);
 
-	return FALSE;
+	g_mutex_lock(&thread_variables_pool_mutex);
+	g_queue_push_head(&thread_variables_pool, thread_variables);
+	g_cond_signal(&thread_variables_pool_cond);
+	g_mutex_unlock(&thread_variables_pool_mutex);
 }
 
+/*
+ * Makes the namespace's connection the current one if the backend stores each namespace separately.
+ * All operations of a batch are performed by the thread that started it, so the connection stays valid until the batch ends.
+ */
 static gboolean
-backend_batch_execute(gpointer backend_data, gpointer _batch, GError** error)
+thread_variables_select(JThreadVariables* thread_variables, gpointer backend_data, gchar const* namespace, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JSqlBatch* batch = _batch;
-
-	g_return_val_if_fail(batch != NULL, FALSE);
+	void* sql_backend;
 
-	if (G_UNLIKELY(!_backend_batch_execute(backend_data, batch, error)))
+	if (thread_variables->sql_backends == NULL)
 	{
-		goto _error;
+		return TRUE;
 	}
 
-	j_semantics_unref(batch->semantics);
-	g_free(batch);
+	if ((sql_backend = g_hash_table_lookup(thread_variables->sql_backends, namespace)) == NULL)
+	{
+		if (G_UNLIKELY((sql_backend = thread_variables_open(backend_data, namespace, error)) == NULL))
+		{
+			goto _error;
+		}
 
-	if (SQL_MODE == SQL_MODE_SINGLE_THREAD)
-		G_UNLOCK(sql_backend_lock);
+		g_hash_table_insert(thread_variables->sql_backends, g_strdup(namespace), sql_backend);
+	}
+
+	thread_variables->sql_backend = sql_backend;
 
 	return TRUE;
 
 _error:
-	j_semantics_unref(batch->semantics);
-	g_free(batch);
-
-	if (SQL_MODE == SQL_MODE_SINGLE_THREAD)
-		G_UNLOCK(sql_backend_lock);
-
 	return FALSE;
 }
 
-static gboolean
-backend_schema_create(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* schema, GError** error)
+static void
+freeJSqlIterator(gpointer ptr)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JSqlCacheSQLPrepared* prepared = NULL;
-	JSqlBatch* batch = _batch;
-	bson_iter_t iter;
-	bson_iter_t iter_child;
-	bson_iter_t iter_child2;
-	JDBType type;
-	gboolean first;
-	guint i;
-	gboolean has_next;
-	gboolean equals;
-	guint counter = 0;
-	gboolean found_index = FALSE;
-	JDBTypeValue value;
-	const char* string_tmp;
-	GString* sql = g_string_new(NULL);
-	JThreadVariables* thread_variables = NULL;
-	g_autoptr(GArray) arr_types_in = NULL;
-
-	g_return_val_if_fail(name != NULL, FALSE);
-	g_return_val_if_fail(batch != NULL, FALSE);
-	g_return_val_if_fail(schema != NULL, FALSE);
-
-	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
+	JSqlIterator* iter = ptr;
 
-	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	if (ptr)
 	{
-		goto _error;
+		g_free(iter->namespace);
+		g_free(iter->name);
+		g_array_free(iter->arr, TRUE);
+		g_free(iter);
 	}
+}
 
-	prepared = getCachePrepared(backend_data, batch->namespace, name, "_schema_create", error);
+static void
+freeJSqlCacheNames(void* ptr)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	if (G_UNLIKELY(!prepared))
-	{
-		goto _error;
-	}
+	JSqlCacheNames* p = ptr;
 
-	if (!prepared->initialized)
+	if (ptr)
 	{
-		type = J_DB_TYPE_STRING;
-		g_array_append_val(arr_types_in, type);
-		g_array_append_val(arr_types_in, type);
-		g_array_append_val(arr_types_in, type);
-		type = J_DB_TYPE_UINT32;
-		g_array_append_val(arr_types_in, type);
-
-		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, "INSERT INTO schema_structure(namespace, name, varname, vartype) VALUES (?, ?, ?, ?)", &prepared->stmt, arr_types_in, NULL, error)))
+		if (p->names)
 		{
-			goto _error;
+			g_hash_table_destroy(p->names);
 		}
 
-		prepared->initialized = TRUE;
+		g_free(p);
 	}
+}
 
-	if (G_UNLIKELY(!_backend_batch_execute(backend_data, batch, error)))
-	{
-		//no ddl in transaction - most databases wont support that - continue without any open transaction
-		goto _error;
-	}
+static void
+freeJSqlCacheShape(void* ptr)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	g_string_append_printf(sql, "CREATE TABLE " SQL_QUOTE "%s_%s" SQL_QUOTE " ( _id INTEGER " SQL_AUTOINCREMENT_STRING " PRIMARY KEY", batch->namespace, name);
+	JSqlCacheShape* p = ptr;
 
-	if (G_UNLIKELY(!j_bson_iter_init(&iter, schema, error)))
+	if (ptr)
 	{
-		goto _error;
+		g_free(p->sql);
+		g_array_unref(p->types);
+		g_free(p);
 	}
+}
 
-	while (TRUE)
+static void
+freeJSqlCacheSQLQueries(void* ptr)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JSqlCacheSQLQueries* p = ptr;
+
+	if (ptr)
 	{
-		if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
+		if (p->queries)
 		{
-			goto _error;
+			g_hash_table_destroy(p->queries);
 		}
 
-		if (!has_next)
+		if (p->shapes)
 		{
-			break;
+			g_hash_table_destroy(p->shapes);
 		}
 
-		if (G_UNLIKELY(!j_bson_iter_key_equals(&iter, "_index", &equals, error)))
-		{
-			goto _error;
-		}
+		schema_cache_unref(p->schema);
 
-		if (equals)
-		{
-			found_index = TRUE;
-		}
-		else
+		g_free(p);
+	}
+}
+
+static void
+freeJSqlCacheSQLPrepared(void* ptr)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JSqlCacheSQLPrepared* p = ptr;
+
+	if (ptr)
+	{
+		if (p->initialized)
 		{
-			counter++;
-			g_string_append_printf(sql, ", " SQL_QUOTE "%s" SQL_QUOTE, j_bson_iter_key(&iter, error));
+			if (p->variables_index)
+			{
+				g_hash_table_destroy(p->variables_index);
+			}
 
-			if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT32, &value, error)))
+			if (p->variables_type)
 			{
-				goto _error;
+				g_array_unref(p->variables_type);
 			}
 
-			type = value.val_uint32;
+			if (p->sql)
+			{
+				g_string_free(p->sql, TRUE);
+			}
 
-			switch (type)
+			if (p->stmt)
 			{
-				case J_DB_TYPE_SINT32:
-					g_string_append(sql, " INTEGER");
-					break;
-				case J_DB_TYPE_ID:
-				case J_DB_TYPE_UINT32:
-					g_string_append(sql, " INTEGER");
-					break;
-				case J_DB_TYPE_FLOAT32:
-					g_string_append(sql, " REAL");
-					break;
-				case J_DB_TYPE_SINT64:
-					g_string_append(sql, " INTEGER");
-					break;
-				case J_DB_TYPE_UINT64:
-					g_string_append(sql, SQL_UINT64_TYPE);
-					break;
-				case J_DB_TYPE_FLOAT64:
-					g_string_append(sql, " REAL");
-					break;
-				case J_DB_TYPE_STRING:
-					g_string_append(sql, " VARCHAR(255)");
-					break;
-				case J_DB_TYPE_BLOB:
-					g_string_append(sql, " BLOB");
-					break;
-				default:
-					g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_DB_TYPE_INVALID, "db type invalid");
-					goto _error;
+				j_sql_finalize(p->sql_backend, p->stmt, NULL);
 			}
 		}
+
+		g_free(p->namespace);
+		g_free(p->name);
+		g_free(p);
 	}
+}
 
-	g_string_append(sql, " )");
+static JSqlCacheSQLQueries*
+_getCachePrepared(gpointer backend_data, gchar const* namespace, gchar const* name, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	if (G_UNLIKELY(!counter))
+	JSqlCacheNames* cacheNames = NULL;
+	JSqlCacheSQLQueries* cacheQueries = NULL;
+	JThreadVariables* thread_variables = NULL;
+
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
 	{
-		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_SCHEMA_EMPTY, "schema empty");
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_sql_exec(thread_variables->sql_backend, sql->str, error)))
+	g_return_val_if_fail(thread_variables->namespaces != NULL, NULL);
+
+	if (!(cacheNames = g_hash_table_lookup(thread_variables->namespaces, namespace)))
 	{
-		goto _error;
+		cacheNames = g_new0(JSqlCacheNames, 1);
+		cacheNames->names = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, freeJSqlCacheSQLQueries);
+
+		if (G_UNLIKELY(!g_hash_table_insert(thread_variables->namespaces, g_strdup(namespace), cacheNames)))
+		{
+			g_assert_not_reached();
+		}
 	}
 
-	if (sql)
+	if (!(cacheQueries = g_hash_table_lookup(cacheNames->names, name)))
 	{
-		g_string_free(sql, TRUE);
-		sql = NULL;
+		cacheQueries = g_new0(JSqlCacheSQLQueries, 1);
+		cacheQueries->queries = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, freeJSqlCacheSQLPrepared);
+		cacheQueries->shapes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, freeJSqlCacheShape);
+		cacheQueries->schema = NULL;
+		cacheQueries->version = 0;
+
+		if (G_UNLIKELY(!g_hash_table_insert(cacheNames->names, g_strdup(name), cacheQueries)))
+		{
+			g_assert_not_reached();
+		}
 	}
 
-	if (found_index)
+	return cacheQueries;
+
+_error:
+	return NULL;
+}
+
+static gboolean _backend_schema_get(gpointer backend_data, gpointer _batch, gchar const* name, bson_t* schema, GError** error);
+
+static GHashTable*
+getCacheSchema(gpointer backend_data, gpointer _batch, gchar const* name, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JSqlBatch* batch = _batch;
+	gboolean schema_initialized = FALSE;
+	gboolean has_next;
+	gboolean equals;
+	bson_t schema;
+	JSqlCacheSQLQueries* cacheQueries = NULL;
+	JSqlCacheSchema* shared = NULL;
+	bson_iter_t iter;
+	char const* string_tmp;
+	JDBTypeValue value;
+	guint version;
+
+	if (!(cacheQueries = _getCachePrepared(backend_data, batch->namespace, name, error)))
 	{
-		i = 0;
+		goto _error;
+	}
 
-		if (G_UNLIKELY(!j_bson_iter_init(&iter, schema, error)))
+	version = g_atomic_int_get(&schema_cache_version);
+
+	if (cacheQueries->schema != NULL && cacheQueries->version == version)
+	{
+		return cacheQueries->schema->types;
+	}
+
+	shared = schema_cache_lookup(batch->namespace, name);
+
+	if (shared != cacheQueries->schema)
+	{
+		// The schema has been deleted or replaced, the prepared statements might refer to the old table
+		if (cacheQueries->schema != NULL)
 		{
-			goto _error;
+			g_hash_table_remove_all(cacheQueries->queries);
+			g_hash_table_remove_all(cacheQueries->shapes);
+			schema_cache_unref(cacheQueries->schema);
 		}
 
-		if (G_UNLIKELY(!j_bson_iter_find(&iter, "_index", error)))
+		cacheQueries->schema = g_steal_pointer(&shared);
+	}
+
+	schema_cache_unref(shared);
+	shared = NULL;
+
+	if (cacheQueries->schema == NULL)
+	{
+		shared = g_new(JSqlCacheSchema, 1);
+		shared->ref_count = 1;
+		shared->types = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+		if (!(schema_initialized = _backend_schema_get(backend_data, batch, name, &schema, error)))
 		{
 			goto _error;
 		}
 
-		if (G_UNLIKELY(!j_bson_iter_recurse_array(&iter, &iter_child, error)))
+		if (G_UNLIKELY(!j_bson_iter_init(&iter, &schema, error)))
 		{
 			goto _error;
 		}
 
 		while (TRUE)
 		{
-			if (G_UNLIKELY(!j_bson_iter_next(&iter_child, &has_next, error)))
+			if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
 			{
 				goto _error;
 			}
@@ -803,305 +1129,255 @@ backend_schema_create(gpointer backend_data, gpointer _batch, gchar const* name,
 				break;
 			}
 
-			sql = g_string_new(NULL);
-			first = TRUE;
+			if (G_UNLIKELY(!j_bson_iter_key_equals(&iter, "_index", &equals, error)))
+			{
+				goto _error;
+			}
 
-			g_string_append_printf(sql, "CREATE INDEX " SQL_QUOTE "%s_%s_%d" SQL_QUOTE " ON " SQL_QUOTE "%s_%s" SQL_QUOTE " ( ", batch->namespace, name, i, batch->namespace, name);
+			if (equals)
+			{
+				continue;
+			}
 
-			if (G_UNLIKELY(!j_bson_iter_recurse_array(&iter_child, &iter_child2, error)))
+			string_tmp = j_bson_iter_key(&iter, error);
+
+			if (G_UNLIKELY(!string_tmp))
 			{
 				goto _error;
 			}
 
-			while (TRUE)
+			if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT32, &value, error)))
 			{
-				if (G_UNLIKELY(!j_bson_iter_next(&iter_child2, &has_next, error)))
-				{
-					goto _error;
-				}
+				goto _error;
+			}
 
-				if (!has_next)
-				{
-					break;
-				}
-
-				if (first)
-				{
-					first = FALSE;
-				}
-				else
-				{
-					g_string_append(sql, ", ");
-				}
-
-				if (G_UNLIKELY(!j_bson_iter_value(&iter_child2, J_DB_TYPE_STRING, &value, error)))
-				{
-					goto _error;
-				}
-
-				string_tmp = value.val_string;
-				g_string_append_printf(sql, SQL_QUOTE "%s" SQL_QUOTE, string_tmp);
-			}
-
-			g_string_append(sql, " )");
-
-			if (G_UNLIKELY(!j_sql_exec(thread_variables->sql_backend, sql->str, error)))
-			{
-				goto _error;
-			}
-
-			if (sql)
-			{
-				g_string_free(sql, TRUE);
-				sql = NULL;
-			}
-
-			i++;
+			g_hash_table_insert(shared->types, g_strdup(string_tmp), GINT_TO_POINTER(value.val_uint32));
 		}
+
+		cacheQueries->schema = schema_cache_publish(batch->namespace, name, g_steal_pointer(&shared), version);
 	}
 
-	value.val_string = batch->namespace;
+	cacheQueries->version = version;
 
-	if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 1, J_DB_TYPE_STRING, &value, error)))
+	if (schema_initialized)
 	{
-		goto _error;
+		j_bson_destroy(&schema);
 	}
 
-	value.val_string = name;
+	return cacheQueries->schema->types;
 
-	if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 2, J_DB_TYPE_STRING, &value, error)))
+_error:
+	if (schema_initialized)
 	{
-		goto _error;
+		j_bson_destroy(&schema);
 	}
 
-	value.val_string = "_id";
+	schema_cache_unref(shared);
 
-	if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 3, J_DB_TYPE_STRING, &value, error)))
-	{
-		goto _error;
-	}
+	return NULL;
+}
 
-	value.val_uint32 = J_DB_TYPE_UINT32;
+static GHashTable*
+getCacheShapes(gpointer backend_data, gpointer _batch, gchar const* name, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 4, J_DB_TYPE_UINT32, &value, error)))
+	JSqlBatch* batch = _batch;
+	JSqlCacheSQLQueries* cacheQueries = NULL;
+
+	if (!(cacheQueries = _getCachePrepared(backend_data, batch->namespace, name, error)))
 	{
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_sql_step_and_reset_check_done(thread_variables->sql_backend, prepared->stmt, error)))
+	return cacheQueries->shapes;
+
+_error:
+	return NULL;
+}
+
+static JSqlCacheSQLPrepared*
+getCachePrepared(gpointer backend_data, gchar const* namespace, gchar const* name, gchar const* query, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JSqlCacheSQLQueries* cacheQueries = NULL;
+	JSqlCacheSQLPrepared* cachePrepared = NULL;
+	JThreadVariables* thread_variables = NULL;
+
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
 	{
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_bson_iter_init(&iter, schema, error)))
+	if (!(cacheQueries = _getCachePrepared(backend_data, namespace, name, error)))
 	{
 		goto _error;
 	}
 
-	while (TRUE)
+	if (!(cachePrepared = g_hash_table_lookup(cacheQueries->queries, query)))
 	{
-		if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
-		{
-			goto _error;
-		}
+		cachePrepared = g_new0(JSqlCacheSQLPrepared, 1);
+		cachePrepared->namespace = g_strdup(namespace);
+		cachePrepared->name = g_strdup(name);
+		cachePrepared->backend_data = backend_data;
+		cachePrepared->sql_backend = thread_variables->sql_backend;
 
-		if (!has_next)
+		if (G_UNLIKELY(!g_hash_table_insert(cacheQueries->queries, g_strdup(query), cachePrepared)))
 		{
-			break;
+			g_assert_not_reached();
 		}
+	}
 
-		if (G_UNLIKELY(!j_bson_iter_key_equals(&iter, "_index", &equals, error)))
-		{
-			goto _error;
-		}
+	return cachePrepared;
 
-		if (!equals)
-		{
-			value.val_string = batch->namespace;
+_error:
+	return NULL;
+}
 
-			if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 1, J_DB_TYPE_STRING, &value, error)))
-			{
-				goto _error;
-			}
+static void
+deleteCachePrepared(gpointer backend_data, gchar const* namespace, gchar const* name)
+{
+	J_TRACE_FUNCTION(NULL);
 
-			value.val_string = name;
+	JSqlCacheNames* cacheNames = NULL;
+	JThreadVariables* thread_variables = NULL;
 
-			if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 2, J_DB_TYPE_STRING, &value, error)))
-			{
-				goto _error;
-			}
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, NULL))))
+	{
+		goto _error;
+	}
 
-			value.val_string = j_bson_iter_key(&iter, error);
+	g_return_if_fail(thread_variables->namespaces != NULL);
 
-			if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 3, J_DB_TYPE_STRING, &value, error)))
-			{
-				goto _error;
-			}
+	if (G_UNLIKELY(!(cacheNames = g_hash_table_lookup(thread_variables->namespaces, namespace))))
+	{
+		goto _error;
+	}
 
-			if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT32, &value, error)))
-			{
-				goto _error;
-			}
+	g_hash_table_remove(cacheNames->names, name);
 
-			if (value.val_uint32 == J_DB_TYPE_ID)
-			{
-				value.val_uint32 = J_DB_TYPE_UINT32;
-			}
+	return;
 
-			if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 4, J_DB_TYPE_UINT32, &value, error)))
-			{
-				goto _error;
-			}
+_error:
+	return;
+}
 
-			if (G_UNLIKELY(!j_sql_step_and_reset_check_done(thread_variables->sql_backend, prepared->stmt, error)))
-			{
-				goto _error;
-			}
-		}
-	}
+static gboolean
+_backend_batch_start(gpointer backend_data, JSqlBatch* batch, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	if (G_UNLIKELY(!_backend_batch_start(backend_data, batch, error)))
+	JThreadVariables* thread_variables = NULL;
+
+	g_return_val_if_fail(!batch->open, FALSE);
+
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
 	{
 		goto _error;
 	}
 
-	return TRUE;
-
-_error:
-	if (G_UNLIKELY(!_backend_batch_start(backend_data, batch, NULL)))
+	if (G_UNLIKELY(!thread_variables_select(thread_variables, backend_data, batch->namespace, error)))
 	{
-		goto _error2;
+		goto _error;
 	}
 
-	if (sql)
+	if (!j_sql_start_transaction(thread_variables->sql_backend, error))
 	{
-		g_string_free(sql, TRUE);
+		goto _error;
 	}
 
-	return FALSE;
+	batch->open = TRUE;
+	batch->aborted = FALSE;
 
-_error2:
+	return TRUE;
+
+_error:
 	return FALSE;
 }
 
 static gboolean
-_backend_schema_get(gpointer backend_data, gpointer _batch, gchar const* name, bson_t* schema, GError** error)
+_backend_batch_execute(gpointer backend_data, JSqlBatch* batch, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JDBTypeValue value1;
-	JDBTypeValue value2;
-	JSqlBatch* batch = _batch;
-	guint found = FALSE;
-	gboolean sql_found;
-	gboolean bson_initialized = FALSE;
-	JSqlCacheSQLPrepared* prepared = NULL;
 	JThreadVariables* thread_variables = NULL;
-	g_autoptr(GArray) arr_types_in = NULL;
-	g_autoptr(GArray) arr_types_out = NULL;
-	JDBType type;
-
-	g_return_val_if_fail(name != NULL, FALSE);
-	g_return_val_if_fail(batch != NULL, FALSE);
 
-	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
-	arr_types_out = g_array_new(FALSE, FALSE, sizeof(JDBType));
+	g_return_val_if_fail(batch->open || (!batch->open && batch->aborted), FALSE);
 
 	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
 	{
 		goto _error;
 	}
 
-	prepared = getCachePrepared(backend_data, batch->namespace, name, "_schema_get", error);
-
-	if (G_UNLIKELY(!prepared))
+	if (!j_sql_commit_transaction(thread_variables->sql_backend, error))
 	{
 		goto _error;
 	}
 
-	if (!prepared->initialized)
-	{
-		type = J_DB_TYPE_STRING;
-		g_array_append_val(arr_types_in, type);
-		g_array_append_val(arr_types_in, type);
-		g_array_append_val(arr_types_out, type);
-		type = J_DB_TYPE_UINT32;
-		g_array_append_val(arr_types_out, type);
+	batch->open = FALSE;
 
-		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, "SELECT varname, vartype FROM schema_structure WHERE namespace=? AND name=?", &prepared->stmt, arr_types_in, arr_types_out, error)))
-		{
-			goto _error;
-		}
+	return TRUE;
 
-		prepared->initialized = TRUE;
-	}
+_error:
+	return FALSE;
+}
 
-	value1.val_string = batch->namespace;
+static gboolean
+_backend_batch_abort(gpointer backend_data, JSqlBatch* batch, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 1, J_DB_TYPE_STRING, &value1, error)))
-	{
-		goto _error;
-	}
+	JThreadVariables* thread_variables = NULL;
 
-	value1.val_string = name;
+	g_return_val_if_fail(batch->open, FALSE);
 
-	if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 2, J_DB_TYPE_STRING, &value1, error)))
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
 	{
 		goto _error;
 	}
 
-	if (schema)
+	if (!j_sql_abort_transaction(thread_variables->sql_backend, error))
 	{
-		if (!j_bson_init(schema, error))
-		{
-			goto _error;
-		}
+		goto _error;
 	}
 
-	bson_initialized = TRUE;
+	batch->open = FALSE;
+	batch->aborted = TRUE;
 
-	while (TRUE)
-	{
-		if (G_UNLIKELY(!j_sql_step(thread_variables->sql_backend, prepared->stmt, &sql_found, error)))
-		{
-			goto _error;
-		}
+	return TRUE;
 
-		if (!sql_found)
-		{
-			break;
-		}
+_error:
+	return FALSE;
+}
 
-		found = TRUE;
+G_LOCK_DEFINE_STATIC(sql_backend_lock);
 
-		if (!schema)
-		{
-			break;
-		}
+static gboolean
+backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* _batch, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
 
-		if (G_UNLIKELY(!j_sql_column(thread_variables->sql_backend, prepared->stmt, 0, J_DB_TYPE_STRING, &value1, error)))
-		{
-			goto _error;
-		}
+	JSqlBatch* batch;
 
-		if (G_UNLIKELY(!j_sql_column(thread_variables->sql_backend, prepared->stmt, 1, J_DB_TYPE_UINT32, &value2, error)))
-		{
-			goto _error;
-		}
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+	g_return_val_if_fail(_batch != NULL, FALSE);
 
-		if (G_UNLIKELY(!j_bson_append_value(schema, value1.val_string, J_DB_TYPE_UINT32, &value2, error)))
-		{
-			goto _error;
-		}
-	}
+	if (j_sql_mode(backend_data) == SQL_MODE_SINGLE_THREAD)
+		G_LOCK(sql_backend_lock);
 
-	if (G_UNLIKELY(!found))
+	batch = *_batch = g_new(JSqlBatch, 1);
+	batch->namespace = namespace;
+	batch->semantics = j_semantics_ref(semantics);
+	batch->open = FALSE;
+
+	if (G_UNLIKELY(!thread_variables_acquire(backend_data, error)))
 	{
-		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_SCHEMA_NOT_FOUND, "schema not found");
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_sql_reset(thread_variables->sql_backend, prepared->stmt, error)))
+	if (G_UNLIKELY(!_backend_batch_start(backend_data, batch, error)))
 	{
 		goto _error;
 	}
@@ -1109,54 +1385,110 @@ _backend_schema_get(gpointer backend_data, gpointer _batch, gchar const* name, b
 	return TRUE;
 
 _error:
-	if (G_UNLIKELY(!j_sql_reset(thread_variables->sql_backend, prepared->stmt, NULL)))
-	{
-		goto _error2;
-	}
+	thread_variables_release(backend_data);
 
-	if (bson_initialized)
+	j_semantics_unref(batch->semantics);
+	g_free(batch);
+
+	if (j_sql_mode(backend_data) == SQL_MODE_SINGLE_THREAD)
+		G_UNLOCK(sql_backend_lock);
+
+	return FALSE;
+}
+
+static gboolean
+backend_batch_execute(gpointer backend_data, gpointer _batch, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JSqlBatch* batch = _batch;
+
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	if (G_UNLIKELY(!_backend_batch_execute(backend_data, batch, error)))
 	{
-		j_bson_destroy(schema);
+		goto _error;
 	}
 
-	return FALSE;
+	thread_variables_release(backend_data);
+
+	j_semantics_unref(batch->semantics);
+	g_free(batch);
+
+	if (j_sql_mode(backend_data) == SQL_MODE_SINGLE_THREAD)
+		G_UNLOCK(sql_backend_lock);
+
+	return TRUE;
+
+_error:
+	thread_variables_release(backend_data);
+
+	j_semantics_unref(batch->semantics);
+	g_free(batch);
+
+	if (j_sql_mode(backend_data) == SQL_MODE_SINGLE_THREAD)
+		G_UNLOCK(sql_backend_lock);
 
-_error2:
-	/*something failed very hard*/
 	return FALSE;
 }
 
 static gboolean
-backend_schema_get(gpointer backend_data, gpointer _batch, gchar const* name, bson_t* schema, GError** error)
+backend_batch_abort(gpointer backend_data, gpointer _batch, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gboolean ret;
+	gboolean ret = TRUE;
+	JSqlBatch* batch = _batch;
 
-	ret = _backend_schema_get(backend_data, _batch, name, schema, error);
+	g_return_val_if_fail(batch != NULL, FALSE);
 
-	if (!ret)
+	// A failed operation may already have rolled back the transaction.
+	if (batch->open && G_UNLIKELY(!_backend_batch_abort(backend_data, batch, error)))
 	{
-		_backend_batch_abort(backend_data, _batch, NULL);
+		ret = FALSE;
 	}
 
+	thread_variables_release(backend_data);
+
+	j_semantics_unref(batch->semantics);
+	g_free(batch);
+
+	if (j_sql_mode(backend_data) == SQL_MODE_SINGLE_THREAD)
+		G_UNLOCK(sql_backend_lock);
+
 	return ret;
 }
+
 static gboolean
-backend_schema_delete(gpointer backend_data, gpointer _batch, gchar const* name, GError** error)
+backend_schema_create(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* schema, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
+	JSqlCacheSQLPrepared* prepared = NULL;
+	JSqlBatch* batch = _batch;
+	bson_iter_t iter;
+	bson_iter_t iter_child;
+	bson_iter_t iter_child2;
 	JDBType type;
+	gboolean first;
+	guint i;
+	gboolean has_next;
+	gboolean equals;
+	guint counter = 0;
+	gboolean found_index = FALSE;
 	JDBTypeValue value;
-	JSqlBatch* batch = _batch;
+	const char* string_tmp;
 	GString* sql = g_string_new(NULL);
-	JSqlCacheSQLPrepared* prepared = NULL;
 	JThreadVariables* thread_variables = NULL;
 	g_autoptr(GArray) arr_types_in = NULL;
+	g_autoptr(GPtrArray) index_fields = NULL;
 
 	g_return_val_if_fail(name != NULL, FALSE);
 	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(schema != NULL, FALSE);
+
+	// A previous schema of the same name might have had different fields and indexes
+	advisor_forget(batch->namespace, name);
 
 	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
 
@@ -1165,7 +1497,7 @@ backend_schema_delete(gpointer backend_data, gpointer _batch, gchar const* name,
 		goto _error;
 	}
 
-	prepared = getCachePrepared(backend_data, batch->namespace, name, "_schema_delete", error);
+	prepared = getCachePrepared(backend_data, batch->namespace, name, "_schema_create", error);
 
 	if (G_UNLIKELY(!prepared))
 	{
@@ -1177,8 +1509,11 @@ backend_schema_delete(gpointer backend_data, gpointer _batch, gchar const* name,
 		type = J_DB_TYPE_STRING;
 		g_array_append_val(arr_types_in, type);
 		g_array_append_val(arr_types_in, type);
+		g_array_append_val(arr_types_in, type);
+		type = J_DB_TYPE_UINT32;
+		g_array_append_val(arr_types_in, type);
 
-		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, "DELETE FROM schema_structure WHERE namespace=? AND name=?", &prepared->stmt, arr_types_in, NULL, error)))
+		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, "INSERT INTO schema_structure(namespace, name, varname, vartype) VALUES (?, ?, ?, ?)", &prepared->stmt, arr_types_in, NULL, error)))
 		{
 			goto _error;
 		}
@@ -1192,174 +1527,1675 @@ backend_schema_delete(gpointer backend_data, gpointer _batch, gchar const* name,
 		goto _error;
 	}
 
-	g_string_append_printf(sql, "DROP TABLE IF EXISTS " SQL_QUOTE "%s_%s" SQL_QUOTE, batch->namespace, name);
-	value.val_string = batch->namespace;
+	g_string_append_printf(sql, "CREATE TABLE " SQL_QUOTE "%s_%s" SQL_QUOTE " ( _id INTEGER " SQL_AUTOINCREMENT_STRING " PRIMARY KEY", batch->namespace, name);
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, schema, error)))
+	{
+		goto _error;
+	}
+
+	while (TRUE)
+	{
+		if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
+		{
+			goto _error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_key_equals(&iter, "_index", &equals, error)))
+		{
+			goto _error;
+		}
+
+		if (equals)
+		{
+			found_index = TRUE;
+		}
+		else
+		{
+			counter++;
+			g_string_append_printf(sql, ", " SQL_QUOTE "%s" SQL_QUOTE, j_bson_iter_key(&iter, error));
+
+			if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT32, &value, error)))
+			{
+				goto _error;
+			}
+
+			type = value.val_uint32;
+
+			switch (type)
+			{
+				case J_DB_TYPE_SINT32:
+					g_string_append(sql, " INTEGER");
+					break;
+				case J_DB_TYPE_ID:
+				case J_DB_TYPE_UINT32:
+					g_string_append(sql, " INTEGER");
+					break;
+				case J_DB_TYPE_FLOAT32:
+					g_string_append(sql, " REAL");
+					break;
+				case J_DB_TYPE_SINT64:
+					g_string_append(sql, " INTEGER");
+					break;
+				case J_DB_TYPE_UINT64:
+					g_string_append(sql, SQL_UINT64_TYPE);
+					break;
+				case J_DB_TYPE_FLOAT64:
+					g_string_append(sql, " REAL");
+					break;
+				case J_DB_TYPE_STRING:
+					g_string_append(sql, " VARCHAR(255)");
+					break;
+				case J_DB_TYPE_BLOB:
+					g_string_append(sql, " BLOB");
+					break;
+				default:
+					g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_DB_TYPE_INVALID, "db type invalid");
+					goto _error;
+			}
+		}
+	}
+
+	g_string_append(sql, " )");
+
+	if (G_UNLIKELY(!counter))
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_SCHEMA_EMPTY, "schema empty");
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_sql_exec(thread_variables->sql_backend, sql->str, error)))
+	{
+		goto _error;
+	}
+
+	if (sql)
+	{
+		g_string_free(sql, TRUE);
+		sql = NULL;
+	}
+
+	if (found_index)
+	{
+		i = 0;
+
+		if (G_UNLIKELY(!j_bson_iter_init(&iter, schema, error)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_find(&iter, "_index", error)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_recurse_array(&iter, &iter_child, error)))
+		{
+			goto _error;
+		}
+
+		while (TRUE)
+		{
+			if (G_UNLIKELY(!j_bson_iter_next(&iter_child, &has_next, error)))
+			{
+				goto _error;
+			}
+
+			if (!has_next)
+			{
+				break;
+			}
+
+			sql = g_string_new(NULL);
+			first = TRUE;
+			index_fields = g_ptr_array_new_with_free_func(g_free);
+
+			g_string_append_printf(sql, "CREATE INDEX " SQL_QUOTE "%s_%s_%d" SQL_QUOTE " ON " SQL_QUOTE "%s_%s" SQL_QUOTE " ( ", batch->namespace, name, i, batch->namespace, name);
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_array(&iter_child, &iter_child2, error)))
+			{
+				goto _error;
+			}
+
+			while (TRUE)
+			{
+				if (G_UNLIKELY(!j_bson_iter_next(&iter_child2, &has_next, error)))
+				{
+					goto _error;
+				}
+
+				if (!has_next)
+				{
+					break;
+				}
+
+				if (first)
+				{
+					first = FALSE;
+				}
+				else
+				{
+					g_string_append(sql, ", ");
+				}
+
+				if (G_UNLIKELY(!j_bson_iter_value(&iter_child2, J_DB_TYPE_STRING, &value, error)))
+				{
+					goto _error;
+				}
+
+				string_tmp = value.val_string;
+				g_string_append_printf(sql, SQL_QUOTE "%s" SQL_QUOTE, string_tmp);
+				g_ptr_array_add(index_fields, g_strdup(string_tmp));
+			}
+
+			g_string_append(sql, " )");
+
+			if (G_UNLIKELY(!j_sql_exec(thread_variables->sql_backend, sql->str, error)))
+			{
+				goto _error;
+			}
+
+			advisor_add_index(batch->namespace, name, g_steal_pointer(&index_fields));
+
+			if (sql)
+			{
+				g_string_free(sql, TRUE);
+				sql = NULL;
+			}
+
+			i++;
+		}
+	}
+
+	value.val_string = batch->namespace;
+
+	if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 1, J_DB_TYPE_STRING, &value, error)))
+	{
+		goto _error;
+	}
+
+	value.val_string = name;
+
+	if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 2, J_DB_TYPE_STRING, &value, error)))
+	{
+		goto _error;
+	}
+
+	value.val_string = "_id";
+
+	if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 3, J_DB_TYPE_STRING, &value, error)))
+	{
+		goto _error;
+	}
+
+	value.val_uint32 = J_DB_TYPE_UINT32;
+
+	if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 4, J_DB_TYPE_UINT32, &value, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_sql_step_and_reset_check_done(thread_variables->sql_backend, prepared->stmt, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, schema, error)))
+	{
+		goto _error;
+	}
+
+	while (TRUE)
+	{
+		if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
+		{
+			goto _error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_key_equals(&iter, "_index", &equals, error)))
+		{
+			goto _error;
+		}
+
+		if (!equals)
+		{
+			value.val_string = batch->namespace;
+
+			if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 1, J_DB_TYPE_STRING, &value, error)))
+			{
+				goto _error;
+			}
+
+			value.val_string = name;
+
+			if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 2, J_DB_TYPE_STRING, &value, error)))
+			{
+				goto _error;
+			}
+
+			value.val_string = j_bson_iter_key(&iter, error);
+
+			if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 3, J_DB_TYPE_STRING, &value, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT32, &value, error)))
+			{
+				goto _error;
+			}
+
+			if (value.val_uint32 == J_DB_TYPE_ID)
+			{
+				value.val_uint32 = J_DB_TYPE_UINT32;
+			}
+
+			if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 4, J_DB_TYPE_UINT32, &value, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_sql_step_and_reset_check_done(thread_variables->sql_backend, prepared->stmt, error)))
+			{
+				goto _error;
+			}
+		}
+	}
+
+	if (G_UNLIKELY(!_backend_batch_start(backend_data, batch, error)))
+	{
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	if (G_UNLIKELY(!_backend_batch_start(backend_data, batch, NULL)))
+	{
+		goto _error2;
+	}
+
+	if (sql)
+	{
+		g_string_free(sql, TRUE);
+	}
+
+	return FALSE;
+
+_error2:
+	return FALSE;
+}
+
+static gboolean
+_backend_schema_get(gpointer backend_data, gpointer _batch, gchar const* name, bson_t* schema, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBTypeValue value1;
+	JDBTypeValue value2;
+	JSqlBatch* batch = _batch;
+	guint found = FALSE;
+	gboolean sql_found;
+	gboolean bson_initialized = FALSE;
+	JSqlCacheSQLPrepared* prepared = NULL;
+	JThreadVariables* thread_variables = NULL;
+	g_autoptr(GArray) arr_types_in = NULL;
+	g_autoptr(GArray) arr_types_out = NULL;
+	JDBType type;
+
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
+	arr_types_out = g_array_new(FALSE, FALSE, sizeof(JDBType));
+
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	{
+		goto _error;
+	}
+
+	prepared = getCachePrepared(backend_data, batch->namespace, name, "_schema_get", error);
+
+	if (G_UNLIKELY(!prepared))
+	{
+		goto _error;
+	}
+
+	if (!prepared->initialized)
+	{
+		type = J_DB_TYPE_STRING;
+		g_array_append_val(arr_types_in, type);
+		g_array_append_val(arr_types_in, type);
+		g_array_append_val(arr_types_out, type);
+		type = J_DB_TYPE_UINT32;
+		g_array_append_val(arr_types_out, type);
+
+		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, "SELECT varname, vartype FROM schema_structure WHERE namespace=? AND name=?", &prepared->stmt, arr_types_in, arr_types_out, error)))
+		{
+			goto _error;
+		}
+
+		prepared->initialized = TRUE;
+	}
+
+	value1.val_string = batch->namespace;
+
+	if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 1, J_DB_TYPE_STRING, &value1, error)))
+	{
+		goto _error;
+	}
+
+	value1.val_string = name;
+
+	if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 2, J_DB_TYPE_STRING, &value1, error)))
+	{
+		goto _error;
+	}
+
+	if (schema)
+	{
+		if (!j_bson_init(schema, error))
+		{
+			goto _error;
+		}
+	}
+
+	bson_initialized = TRUE;
+
+	while (TRUE)
+	{
+		if (G_UNLIKELY(!j_sql_step(thread_variables->sql_backend, prepared->stmt, &sql_found, error)))
+		{
+			goto _error;
+		}
+
+		if (!sql_found)
+		{
+			break;
+		}
+
+		found = TRUE;
+
+		if (!schema)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY(!j_sql_column(thread_variables->sql_backend, prepared->stmt, 0, J_DB_TYPE_STRING, &value1, error)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_sql_column(thread_variables->sql_backend, prepared->stmt, 1, J_DB_TYPE_UINT32, &value2, error)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_bson_append_value(schema, value1.val_string, J_DB_TYPE_UINT32, &value2, error)))
+		{
+			goto _error;
+		}
+	}
+
+	if (G_UNLIKELY(!found))
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_SCHEMA_NOT_FOUND, "schema not found");
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_sql_reset(thread_variables->sql_backend, prepared->stmt, error)))
+	{
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	if (G_UNLIKELY(!j_sql_reset(thread_variables->sql_backend, prepared->stmt, NULL)))
+	{
+		goto _error2;
+	}
+
+	if (bson_initialized)
+	{
+		j_bson_destroy(schema);
+	}
+
+	return FALSE;
+
+_error2:
+	/*something failed very hard*/
+	return FALSE;
+}
+
+static gboolean
+backend_schema_get(gpointer backend_data, gpointer _batch, gchar const* name, bson_t* schema, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	ret = _backend_schema_get(backend_data, _batch, name, schema, error);
+
+	if (!ret)
+	{
+		_backend_batch_abort(backend_data, _batch, NULL);
+	}
+
+	return ret;
+}
+static gboolean
+backend_schema_delete(gpointer backend_data, gpointer _batch, gchar const* name, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBType type;
+	JDBTypeValue value;
+	JSqlBatch* batch = _batch;
+	GString* sql = g_string_new(NULL);
+	JSqlCacheSQLPrepared* prepared = NULL;
+	JThreadVariables* thread_variables = NULL;
+	g_autoptr(GArray) arr_types_in = NULL;
+
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
+
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	{
+		goto _error;
+	}
+
+	prepared = getCachePrepared(backend_data, batch->namespace, name, "_schema_delete", error);
+
+	if (G_UNLIKELY(!prepared))
+	{
+		goto _error;
+	}
+
+	if (!prepared->initialized)
+	{
+		type = J_DB_TYPE_STRING;
+		g_array_append_val(arr_types_in, type);
+		g_array_append_val(arr_types_in, type);
+
+		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, "DELETE FROM schema_structure WHERE namespace=? AND name=?", &prepared->stmt, arr_types_in, NULL, error)))
+		{
+			goto _error;
+		}
+
+		prepared->initialized = TRUE;
+	}
+
+	if (G_UNLIKELY(!_backend_batch_execute(backend_data, batch, error)))
+	{
+		//no ddl in transaction - most databases wont support that - continue without any open transaction
+		goto _error;
+	}
+
+	g_string_append_printf(sql, "DROP TABLE IF EXISTS " SQL_QUOTE "%s_%s" SQL_QUOTE, batch->namespace, name);
+	value.val_string = batch->namespace;
+
+	if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 1, J_DB_TYPE_STRING, &value, error)))
+	{
+		goto _error;
+	}
+
+	value.val_string = name;
+
+	if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 2, J_DB_TYPE_STRING, &value, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_sql_step_and_reset_check_done(thread_variables->sql_backend, prepared->stmt, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_sql_exec(thread_variables->sql_backend, sql->str, error)))
+	{
+		goto _error;
+	}
+
+	if (sql)
+	{
+		g_string_free(sql, TRUE);
+		sql = NULL;
+	}
+
+	if (G_UNLIKELY(!_backend_batch_start(backend_data, batch, error)))
+	{
+		goto _error;
+	}
+
+	deleteCachePrepared(backend_data, batch->namespace, name);
+	schema_cache_invalidate(batch->namespace, name);
+	advisor_forget(batch->namespace, name);
+
+	return TRUE;
+
+_error:
+	if (sql)
+	{
+		g_string_free(sql, TRUE);
+	}
+
+	if (G_UNLIKELY(!_backend_batch_start(backend_data, batch, NULL)))
+	{
+		goto _error2;
+	}
+
+_error2:
+	return FALSE;
+}
+
+static gboolean
+bind_insert_values(JThreadVariables* thread_variables, JSqlCacheSQLPrepared* prepared, GHashTable* schema_cache, bson_t const* metadata, guint offset, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_iter_t iter;
+	JDBType type;
+	JDBTypeValue value;
+	const char* string_tmp;
+	gboolean has_next;
+	guint index;
+	guint count = 0;
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, metadata, error)))
+	{
+		goto _error;
+	}
+
+	while (TRUE)
+	{
+		if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
+		{
+			goto _error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		string_tmp = j_bson_iter_key(&iter, error);
+
+		if (G_UNLIKELY(!string_tmp))
+		{
+			goto _error;
+		}
+
+		type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
+		index = GPOINTER_TO_INT(g_hash_table_lookup(prepared->variables_index, string_tmp));
+
+		if (G_UNLIKELY(!index))
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+			goto _error;
+		}
+
+		count++;
+
+		if (G_UNLIKELY(!j_bson_iter_value(&iter, type, &value, error)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, offset + index, type, &value, error)))
+		{
+			goto _error;
+		}
+	}
+
+	if (G_UNLIKELY(!count))
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_NO_VARIABLE_SET, "no variable set");
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+static gboolean
+append_insert_id(bson_t* id, guint32 value_id, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBTypeValue value;
+
+	value.val_uint32 = value_id;
+
+	if (G_UNLIKELY(!j_bson_append_value(id, "_value", J_DB_TYPE_UINT32, &value, error)))
+	{
+		goto _error;
+	}
+
+	value.val_uint32 = J_DB_TYPE_UINT32;
+
+	if (G_UNLIKELY(!j_bson_append_value(id, "_value_type", J_DB_TYPE_UINT32, &value, error)))
+	{
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+static JSqlCacheSQLPrepared*
+getCachePreparedInsertID(gpointer backend_data, JSqlBatch* batch, gchar const* name, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JSqlCacheSQLPrepared* prepared = NULL;
+	JThreadVariables* thread_variables = NULL;
+	g_autoptr(GArray) arr_types_out = NULL;
+	JDBType type;
+
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	{
+		goto _error;
+	}
+
+	prepared = getCachePrepared(backend_data, batch->namespace, name, "_insert_id", error);
+
+	if (G_UNLIKELY(!prepared))
+	{
+		goto _error;
+	}
+
+	if (!prepared->initialized)
+	{
+		arr_types_out = g_array_new(FALSE, FALSE, sizeof(JDBType));
+		type = J_DB_TYPE_UINT32;
+		g_array_append_val(arr_types_out, type);
+
+		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, SQL_LAST_INSERT_ID_STRING, &prepared->stmt, NULL, arr_types_out, error)))
+		{
+			goto _error;
+		}
+
+		prepared->initialized = TRUE;
+	}
+
+	return prepared;
+
+_error:
+	return NULL;
+}
+
+static gboolean
+backend_insert(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* metadata, bson_t* id, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JSqlBatch* batch = _batch;
+	guint i;
+	gpointer type_tmp;
+	JDBType type;
+	GHashTableIter schema_iter;
+	GHashTable* schema_cache = NULL;
+	gboolean found;
+	JSqlCacheSQLPrepared* prepared = NULL;
+	JSqlCacheSQLPrepared* prepared_id = NULL;
+	JThreadVariables* thread_variables = NULL;
+	g_autoptr(GArray) arr_types_in = NULL;
+	JDBTypeValue value;
+
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(metadata != NULL, FALSE);
+
+	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
+
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_has_enough_keys(metadata, 1, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!(prepared_id = getCachePreparedInsertID(backend_data, batch, name, error))))
+	{
+		goto _error;
+	}
+
+	prepared = getCachePrepared(backend_data, batch->namespace, name, "_insert", error);
+
+	if (G_UNLIKELY(!prepared))
+	{
+		goto _error;
+	}
+
+	if (!(schema_cache = getCacheSchema(backend_data, batch, name, error)))
+	{
+		goto _error;
+	}
+
+	if (!prepared->initialized)
+	{
+		gchar* key;
+
+		prepared->sql = g_string_new(NULL);
+		prepared->variables_count = 0;
+		prepared->variables_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+		g_string_append_printf(prepared->sql, "INSERT INTO " SQL_QUOTE "%s_%s" SQL_QUOTE " (", batch->namespace, name);
+		g_hash_table_iter_init(&schema_iter, schema_cache);
+
+		while (g_hash_table_iter_next(&schema_iter, (gpointer*)&key, &type_tmp))
+		{
+			type = GPOINTER_TO_INT(type_tmp);
+
+			if (prepared->variables_count)
+			{
+				g_string_append(prepared->sql, ", ");
+			}
+
+			prepared->variables_count++;
+			g_string_append_printf(prepared->sql, SQL_QUOTE "%s" SQL_QUOTE, key);
+			g_array_append_val(arr_types_in, type);
+			g_hash_table_insert(prepared->variables_index, g_strdup(key), GINT_TO_POINTER(prepared->variables_count));
+		}
+
+		g_string_append(prepared->sql, ") VALUES (");
+
+		if (prepared->variables_count)
+		{
+			g_string_append_printf(prepared->sql, " ?");
+		}
+
+		for (i = 1; i < prepared->variables_count; i++)
+		{
+			g_string_append_printf(prepared->sql, ", ?");
+		}
+
+		g_string_append(prepared->sql, " )");
+
+		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, prepared->sql->str, &prepared->stmt, arr_types_in, NULL, error)))
+		{
+			goto _error;
+		}
+
+		prepared->initialized = TRUE;
+	}
+
+	for (i = 0; i < prepared->variables_count; i++)
+	{
+		if (G_UNLIKELY(!j_sql_bind_null(thread_variables->sql_backend, prepared->stmt, i + 1, error)))
+		{
+			goto _error;
+		}
+	}
+
+	if (G_UNLIKELY(!bind_insert_values(thread_variables, prepared, schema_cache, metadata, 0, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_sql_step_and_reset_check_done(thread_variables->sql_backend, prepared->stmt, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_sql_step(thread_variables->sql_backend, prepared_id->stmt, &found, error)))
+	{
+		goto _error;
+	}
+
+	if (!found)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_sql_column(thread_variables->sql_backend, prepared_id->stmt, 0, J_DB_TYPE_UINT32, &value, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_sql_reset(thread_variables->sql_backend, prepared_id->stmt, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!append_insert_id(id, value.val_uint32, error)))
+	{
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	if (G_UNLIKELY(!_backend_batch_abort(backend_data, batch, NULL)))
+	{
+		goto _error2;
+	}
+
+	return FALSE;
+
+_error2:
+	/*something failed very hard*/
+	return FALSE;
+}
+
+#if defined(SQL_INSERT_RETURNING_STRING) || defined(SQL_INSERT_CONSECUTIVE_IDS)
+static gint
+compare_insert_ids(gconstpointer a, gconstpointer b)
+{
+	guint32 const* id_a = a;
+	guint32 const* id_b = b;
+
+	return (*id_a > *id_b) - (*id_a < *id_b);
+}
+
+static JSqlCacheSQLPrepared*
+getCachePreparedInsertMulti(gpointer backend_data, JSqlBatch* batch, gchar const* name, GHashTable* schema_cache, guint rows, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JSqlCacheSQLPrepared* prepared = NULL;
+	JThreadVariables* thread_variables = NULL;
+	g_autoptr(GArray) arr_types_in = NULL;
+	g_autoptr(GArray) arr_types_out = NULL;
+	g_autofree gchar* cache_key = NULL;
+	GHashTableIter schema_iter;
+	gpointer type_tmp;
+	JDBType type;
+	gchar* key;
+	guint columns;
+
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	{
+		goto _error;
+	}
+
+	cache_key = g_strdup_printf("_insert_multi_%u", rows);
+	prepared = getCachePrepared(backend_data, batch->namespace, name, cache_key, error);
+
+	if (G_UNLIKELY(!prepared))
+	{
+		goto _error;
+	}
+
+	if (prepared->initialized)
+	{
+		return prepared;
+	}
+
+	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
+	arr_types_out = g_array_new(FALSE, FALSE, sizeof(JDBType));
+
+#ifdef SQL_INSERT_RETURNING_STRING
+	type = J_DB_TYPE_UINT32;
+	g_array_append_val(arr_types_out, type);
+#endif
+
+	prepared->sql = g_string_new(NULL);
+	prepared->variables_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	g_string_append_printf(prepared->sql, "INSERT INTO " SQL_QUOTE "%s_%s" SQL_QUOTE " (", batch->namespace, name);
+	g_hash_table_iter_init(&schema_iter, schema_cache);
+	columns = 0;
+
+	while (g_hash_table_iter_next(&schema_iter, (gpointer*)&key, &type_tmp))
+	{
+		type = GPOINTER_TO_INT(type_tmp);
+
+		if (columns)
+		{
+			g_string_append(prepared->sql, ", ");
+		}
+
+		columns++;
+		g_string_append_printf(prepared->sql, SQL_QUOTE "%s" SQL_QUOTE, key);
+		g_array_append_val(arr_types_in, type);
+		g_hash_table_insert(prepared->variables_index, g_strdup(key), GINT_TO_POINTER(columns));
+	}
+
+	g_string_append(prepared->sql, ") VALUES ");
+
+	for (guint i = 0; i < rows; i++)
+	{
+		g_string_append(prepared->sql, (i == 0) ? "(" : ", (");
+
+		for (guint j = 0; j < columns; j++)
+		{
+			g_string_append(prepared->sql, (j == 0) ? " ?" : ", ?");
+		}
+
+		g_string_append(prepared->sql, " )");
+
+		if (i > 0)
+		{
+			for (guint j = 0; j < columns; j++)
+			{
+				type = g_array_index(arr_types_in, JDBType, j);
+				g_array_append_val(arr_types_in, type);
+			}
+		}
+	}
+
+#ifdef SQL_INSERT_RETURNING_STRING
+	g_string_append(prepared->sql, SQL_INSERT_RETURNING_STRING);
+#endif
+	prepared->variables_count = rows * columns;
+
+	if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, prepared->sql->str, &prepared->stmt, arr_types_in, arr_types_out, error)))
+	{
+		goto _error;
+	}
+
+	prepared->initialized = TRUE;
+
+	return prepared;
+
+_error:
+	return NULL;
+}
+#endif
+
+static gboolean
+backend_insert_multi(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* const* metadata, guint count, bson_t* ids, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+#if defined(SQL_INSERT_RETURNING_STRING) || defined(SQL_INSERT_CONSECUTIVE_IDS)
+	JSqlBatch* batch = _batch;
+	JSqlCacheSQLPrepared* prepared = NULL;
+#ifndef SQL_INSERT_RETURNING_STRING
+	JSqlCacheSQLPrepared* prepared_id = NULL;
+#endif
+	JThreadVariables* thread_variables = NULL;
+	GHashTable* schema_cache = NULL;
+	g_autoptr(GArray) row_ids = NULL;
+	JDBTypeValue value;
+	gboolean found;
+	guint columns;
+	guint rows_max;
+	guint done = 0;
+
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(metadata != NULL, FALSE);
+	g_return_val_if_fail(ids != NULL, FALSE);
+
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	{
+		goto _error;
+	}
+
+	if (!(schema_cache = getCacheSchema(backend_data, batch, name, error)))
+	{
+		goto _error;
+	}
+
+	columns = MAX(g_hash_table_size(schema_cache), 1);
+	rows_max = MAX(SQL_INSERT_MAX_VARIABLES / columns, 1);
+	row_ids = g_array_new(FALSE, FALSE, sizeof(guint32));
+
+	while (done < count)
+	{
+		guint rows = 1;
+
+		// Power-of-two chunks keep the number of cached statements per schema small
+		while (rows * 2 <= MIN(count - done, rows_max))
+		{
+			rows *= 2;
+		}
+
+		if (G_UNLIKELY(!(prepared = getCachePreparedInsertMulti(backend_data, batch, name, schema_cache, rows, error))))
+		{
+			goto _error;
+		}
+
+		for (guint i = 0; i < prepared->variables_count; i++)
+		{
+			if (G_UNLIKELY(!j_sql_bind_null(thread_variables->sql_backend, prepared->stmt, i + 1, error)))
+			{
+				goto _error;
+			}
+		}
+
+		for (guint i = 0; i < rows; i++)
+		{
+			if (G_UNLIKELY(!j_bson_has_enough_keys(metadata[done + i], 1, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!bind_insert_values(thread_variables, prepared, schema_cache, metadata[done + i], i * columns, error)))
+			{
+				goto _error;
+			}
+		}
+
+		g_array_set_size(row_ids, 0);
+
+#ifdef SQL_INSERT_RETURNING_STRING
+		while (TRUE)
+		{
+			if (G_UNLIKELY(!j_sql_step(thread_variables->sql_backend, prepared->stmt, &found, error)))
+			{
+				goto _error;
+			}
+
+			if (!found)
+			{
+				break;
+			}
+
+			if (G_UNLIKELY(!j_sql_column(thread_variables->sql_backend, prepared->stmt, 0, J_DB_TYPE_UINT32, &value, error)))
+			{
+				goto _error;
+			}
+
+			g_array_append_val(row_ids, value.val_uint32);
+		}
+
+		if (G_UNLIKELY(!j_sql_reset(thread_variables->sql_backend, prepared->stmt, error)))
+		{
+			goto _error;
+		}
+
+		prepared = NULL;
+#else
+		if (G_UNLIKELY(!j_sql_step_and_reset_check_done(thread_variables->sql_backend, prepared->stmt, error)))
+		{
+			prepared = NULL;
+			goto _error;
+		}
+
+		prepared = NULL;
+
+		if (G_UNLIKELY(!(prepared_id = getCachePreparedInsertID(backend_data, batch, name, error))))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_sql_step(thread_variables->sql_backend, prepared_id->stmt, &found, error)))
+		{
+			j_sql_reset(thread_variables->sql_backend, prepared_id->stmt, NULL);
+			goto _error;
+		}
+
+		if (found && G_UNLIKELY(!j_sql_column(thread_variables->sql_backend, prepared_id->stmt, 0, J_DB_TYPE_UINT32, &value, error)))
+		{
+			j_sql_reset(thread_variables->sql_backend, prepared_id->stmt, NULL);
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_sql_reset(thread_variables->sql_backend, prepared_id->stmt, error)))
+		{
+			goto _error;
+		}
+
+		// The last insert id is the id of the first row, the ids of a multi-row insert are consecutive
+		for (guint i = 0; found && i < rows; i++)
+		{
+			guint32 row_id = value.val_uint32 + i;
+
+			g_array_append_val(row_ids, row_id);
+		}
+#endif
+
+		if (row_ids->len != rows)
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+			goto _error;
+		}
+
+		// The order of RETURNING rows is unspecified, but ids are assigned in ascending order of the rows
+		g_array_sort(row_ids, compare_insert_ids);
+
+		for (guint i = 0; i < rows; i++)
+		{
+			if (G_UNLIKELY(!append_insert_id(&ids[done + i], g_array_index(row_ids, guint32, i), error)))
+			{
+				goto _error;
+			}
+		}
+
+		done += rows;
+	}
+
+	return TRUE;
+
+_error:
+	if (prepared != NULL)
+	{
+		j_sql_reset(thread_variables->sql_backend, prepared->stmt, NULL);
+	}
+
+	if (G_UNLIKELY(!_backend_batch_abort(backend_data, batch, NULL)))
+	{
+		goto _error2;
+	}
+
+	return FALSE;
+
+_error2:
+	/*something failed very hard*/
+	return FALSE;
+#else
+	// Without RETURNING or consecutive ids, the ids of a multi-row insert cannot be determined reliably
+	for (guint i = 0; i < count; i++)
+	{
+		if (!backend_insert(backend_data, _batch, name, metadata[i], &ids[i], error))
+		{
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+#endif
+}
+
+static gboolean
+build_selector_query(gpointer backend_data, bson_iter_t* iter, GString* sql, JDBSelectorMode mode, guint* variables_count, GArray* arr_types_in, GHashTable* schema_cache, GHashTable* shapes, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBSelectorMode mode_child;
+	gboolean equals;
+	gboolean has_next;
+	JDBSelectorOperator op;
+	gboolean first = TRUE;
+	const char* string_tmp;
+	JDBTypeValue value;
+	bson_iter_t iterchild;
+	bson_iter_t iter_shape;
+	JThreadVariables* thread_variables = NULL;
+	JDBType type;
+	JSqlCacheShape* cache_shape = NULL;
+	gchar const* shape = NULL;
+	gsize sql_start = sql->len;
+	guint types_start = arr_types_in->len;
+
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	{
+		goto _error;
+	}
+
+	iter_shape = *iter;
+
+	if (shapes != NULL && j_bson_iter_find(&iter_shape, "_shape", NULL) && j_bson_iter_value(&iter_shape, J_DB_TYPE_STRING, &value, NULL))
+	{
+		shape = value.val_string;
+
+		if ((cache_shape = g_hash_table_lookup(shapes, shape)) != NULL)
+		{
+			g_string_append(sql, cache_shape->sql);
+			g_array_append_vals(arr_types_in, cache_shape->types->data, cache_shape->types->len);
+			*variables_count += cache_shape->types->len;
+
+			return TRUE;
+		}
+	}
+
+	g_string_append(sql, "( ");
+
+	while (TRUE)
+	{
+		if (G_UNLIKELY(!j_bson_iter_next(iter, &has_next, error)))
+		{
+			goto _error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_key_equals(iter, "_mode", &equals, error)))
+		{
+			goto _error;
+		}
+
+		if (equals)
+		{
+			continue;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_key_equals(iter, "_shape", &equals, error)))
+		{
+			goto _error;
+		}
+
+		if (equals)
+		{
+			continue;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
+		{
+			goto _error;
+		}
+
+		if (!first)
+		{
+			switch (mode)
+			{
+				case J_DB_SELECTOR_MODE_AND:
+					g_string_append(sql, " AND ");
+					break;
+				case J_DB_SELECTOR_MODE_OR:
+					g_string_append(sql, " OR ");
+					break;
+				default:
+					g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_OPERATOR_INVALID, "operator invalid");
+					goto _error;
+			}
+		}
+
+		first = FALSE;
+
+		if (j_bson_iter_find(&iterchild, "_mode", NULL))
+		{
+			if (G_UNLIKELY(!j_bson_iter_value(&iterchild, J_DB_TYPE_UINT32, &value, error)))
+			{
+				goto _error;
+			}
+
+			mode_child = value.val_uint32;
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!build_selector_query(backend_data, &iterchild, sql, mode_child, variables_count, arr_types_in, schema_cache, shapes, error)))
+			{
+				goto _error;
+			}
+		}
+		else
+		{
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_find(&iterchild, "_name", error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_value(&iterchild, J_DB_TYPE_STRING, &value, error)))
+			{
+				goto _error;
+			}
+
+			string_tmp = value.val_string;
+			g_string_append_printf(sql, SQL_QUOTE "%s" SQL_QUOTE " ", string_tmp);
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_find(&iterchild, "_value", error)))
+			{
+				goto _error;
+			}
+
+			type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
+			g_array_append_val(arr_types_in, type);
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_find(&iterchild, "_operator", error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_value(&iterchild, J_DB_TYPE_UINT32, &value, error)))
+			{
+				goto _error;
+			}
+
+			op = value.val_uint32;
+
+			switch (op)
+			{
+				case J_DB_SELECTOR_OPERATOR_LT:
+					g_string_append(sql, "<");
+					break;
+				case J_DB_SELECTOR_OPERATOR_LE:
+					g_string_append(sql, "<=");
+					break;
+				case J_DB_SELECTOR_OPERATOR_GT:
+					g_string_append(sql, ">");
+					break;
+				case J_DB_SELECTOR_OPERATOR_GE:
+					g_string_append(sql, ">=");
+					break;
+				case J_DB_SELECTOR_OPERATOR_EQ:
+					g_string_append(sql, "=");
+					break;
+				case J_DB_SELECTOR_OPERATOR_NE:
+					g_string_append(sql, "!=");
+					break;
+				default:
+					g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_COMPARATOR_INVALID, "comparator invalid");
+					goto _error;
+			}
+
+			(*variables_count)++;
+
+			g_string_append_printf(sql, " ?");
+		}
+	}
+
+	g_string_append(sql, " )");
+
+	if (first)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_SELECTOR_EMPTY, "selector empty");
+		goto _error;
+	}
+
+	if (shape != NULL)
+	{
+		cache_shape = g_new(JSqlCacheShape, 1);
+		cache_shape->sql = g_strndup(sql->str + sql_start, sql->len - sql_start);
+		cache_shape->types = g_array_new(FALSE, FALSE, sizeof(JDBType));
+		g_array_append_vals(cache_shape->types, arr_types_in->data + types_start * sizeof(JDBType), arr_types_in->len - types_start);
+
+		g_hash_table_insert(shapes, g_strdup(shape), cache_shape);
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+static gboolean
+bind_selector_query(gpointer backend_data, bson_iter_t* iter, JSqlCacheSQLPrepared* prepared, guint* variables_count, GHashTable* schema_cache, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_iter_t iterchild;
+	JDBTypeValue value;
+	JDBType type;
+	gboolean has_next;
+	gboolean equals;
+	JThreadVariables* thread_variables = NULL;
+	char const* string_tmp;
+
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	{
+		goto _error;
+	}
+
+	while (TRUE)
+	{
+		if (G_UNLIKELY(!j_bson_iter_next(iter, &has_next, error)))
+		{
+			goto _error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_key_equals(iter, "_mode", &equals, error)))
+		{
+			goto _error;
+		}
+
+		if (equals)
+		{
+			continue;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_key_equals(iter, "_shape", &equals, error)))
+		{
+			goto _error;
+		}
+
+		if (equals)
+		{
+			continue;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
+		{
+			goto _error;
+		}
+
+		if (j_bson_iter_find(&iterchild, "_mode", NULL))
+		{
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!bind_selector_query(backend_data, &iterchild, prepared, variables_count, schema_cache, error)))
+			{
+				goto _error;
+			}
+		}
+		else
+		{
+			(*variables_count)++;
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_find(&iterchild, "_name", error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_value(&iterchild, J_DB_TYPE_STRING, &value, error)))
+			{
+				goto _error;
+			}
+
+			string_tmp = value.val_string;
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_find(&iterchild, "_value", error)))
+			{
+				goto _error;
+			}
+
+			type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
+
+			if (G_UNLIKELY(!j_bson_iter_value(&iterchild, type, &value, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, *variables_count, type, &value, error)))
+			{
+				goto _error;
+			}
+		}
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+static gboolean
+build_selector_where(gpointer backend_data, bson_t const* selector, GString* sql, guint* variables_count, GArray* arr_types_in, GHashTable* schema_cache, GHashTable* shapes, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBSelectorMode mode_child;
+	JDBTypeValue value;
+	bson_iter_t iter;
 
-	if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 1, J_DB_TYPE_STRING, &value, error)))
+	if (selector == NULL || !j_bson_has_enough_keys(selector, 2, NULL))
 	{
-		goto _error;
+		return TRUE;
 	}
 
-	value.val_string = name;
+	g_string_append(sql, " WHERE ");
 
-	if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 2, J_DB_TYPE_STRING, &value, error)))
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
 	{
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_sql_step_and_reset_check_done(thread_variables->sql_backend, prepared->stmt, error)))
+	if (G_UNLIKELY(!j_bson_iter_find(&iter, "_mode", error)))
 	{
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_sql_exec(thread_variables->sql_backend, sql->str, error)))
+	if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT32, &value, error)))
 	{
 		goto _error;
 	}
 
-	if (sql)
+	mode_child = value.val_uint32;
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
 	{
-		g_string_free(sql, TRUE);
-		sql = NULL;
+		goto _error;
 	}
 
-	if (G_UNLIKELY(!_backend_batch_start(backend_data, batch, error)))
+	if (G_UNLIKELY(!build_selector_query(backend_data, &iter, sql, mode_child, variables_count, arr_types_in, schema_cache, shapes, error)))
 	{
 		goto _error;
 	}
 
-	deleteCachePrepared(backend_data, batch->namespace, name);
-
 	return TRUE;
 
 _error:
-	if (sql)
+	return FALSE;
+}
+
+static gboolean
+bind_selector_where(gpointer backend_data, bson_t const* selector, JSqlCacheSQLPrepared* prepared, guint* variables_count, GHashTable* schema_cache, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_iter_t iter;
+
+	if (selector == NULL || !j_bson_has_enough_keys(selector, 2, NULL))
 	{
-		g_string_free(sql, TRUE);
+		return TRUE;
 	}
 
-	if (G_UNLIKELY(!_backend_batch_start(backend_data, batch, NULL)))
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
 	{
-		goto _error2;
+		goto _error;
 	}
 
-_error2:
+	if (G_UNLIKELY(!bind_selector_query(backend_data, &iter, prepared, variables_count, schema_cache, error)))
+	{
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
 	return FALSE;
 }
 
 static gboolean
-backend_insert(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* metadata, bson_t* id, GError** error)
+_backend_query(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* selector, gpointer* iterator, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JSqlBatch* batch = _batch;
-	guint i;
-	bson_iter_t iter;
-	gpointer type_tmp;
-	JDBType type;
-	GHashTableIter schema_iter;
-	GHashTable* schema_cache = NULL;
-	const char* string_tmp;
-	gboolean found;
+	gboolean sql_found;
+	JDBTypeValue value;
+	guint count = 0;
+	guint variables_count;
 	JSqlCacheSQLPrepared* prepared = NULL;
-	JSqlCacheSQLPrepared* prepared_id = NULL;
+	GString* sql = g_string_new(NULL);
+	JSqlIterator* iteratorOut = NULL;
 	JThreadVariables* thread_variables = NULL;
 	g_autoptr(GArray) arr_types_in = NULL;
-	g_autoptr(GArray) id_arr_types_out = NULL;
-	gboolean has_next;
-	guint index;
-	guint count = 0;
-	JDBTypeValue value;
-
-	g_return_val_if_fail(name != NULL, FALSE);
-	g_return_val_if_fail(batch != NULL, FALSE);
-	g_return_val_if_fail(metadata != NULL, FALSE);
-
-	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
-	id_arr_types_out = g_array_new(FALSE, FALSE, sizeof(JDBType));
+	g_autoptr(GArray) arr_types_out = NULL;
+	JDBType type;
+	GHashTable* schema_cache = NULL;
+	GHashTable* shapes = NULL;
+	gint64 start = g_get_monotonic_time();
 
-	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	if (!(schema_cache = getCacheSchema(backend_data, batch, name, error)))
 	{
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_bson_has_enough_keys(metadata, 1, error)))
+	if (!(shapes = getCacheShapes(backend_data, batch, name, error)))
 	{
 		goto _error;
 	}
 
-	prepared_id = getCachePrepared(backend_data, batch->namespace, name, "_insert_id", error);
+	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
+	arr_types_out = g_array_new(FALSE, FALSE, sizeof(JDBType));
+	type = J_DB_TYPE_UINT32;
+	g_array_append_val(arr_types_out, type);
 
-	if (G_UNLIKELY(!prepared_id))
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
 	{
 		goto _error;
 	}
 
-	if (!prepared_id->initialized)
-	{
-		type = J_DB_TYPE_UINT32;
-		g_array_append_val(id_arr_types_out, type);
-
-		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, SQL_LAST_INSERT_ID_STRING, &prepared_id->stmt, NULL, id_arr_types_out, error)))
-		{
-			goto _error;
-		}
+	*iterator = NULL;
+	iteratorOut = g_new(JSqlIterator, 1);
+	iteratorOut->namespace = g_strdup(batch->namespace);
+	iteratorOut->name = g_strdup(name);
+	iteratorOut->index = 0;
+	iteratorOut->arr = g_array_new(FALSE, FALSE, sizeof(guint64));
 
-		prepared_id->initialized = TRUE;
-	}
+	g_string_append_printf(sql, "SELECT DISTINCT _id FROM " SQL_QUOTE "%s_%s" SQL_QUOTE, batch->namespace, name);
 
-	prepared = getCachePrepared(backend_data, batch->namespace, name, "_insert", error);
+	variables_count = 0;
 
-	if (G_UNLIKELY(!prepared))
+	if (G_UNLIKELY(!build_selector_where(backend_data, selector, sql, &variables_count, arr_types_in, schema_cache, shapes, error)))
 	{
 		goto _error;
 	}
 
-	if (!(schema_cache = getCacheSchema(backend_data, batch, name, error)))
+	prepared = getCachePrepared(backend_data, batch->namespace, name, sql->str, error);
+
+	if (G_UNLIKELY(!prepared))
 	{
 		goto _error;
 	}
 
 	if (!prepared->initialized)
 	{
-		gchar* key;
-
-		prepared->sql = g_string_new(NULL);
-		prepared->variables_count = 0;
-		prepared->variables_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
-		g_string_append_printf(prepared->sql, "INSERT INTO " SQL_QUOTE "%s_%s" SQL_QUOTE " (", batch->namespace, name);
-		g_hash_table_iter_init(&schema_iter, schema_cache);
-
-		while (g_hash_table_iter_next(&schema_iter, (gpointer*)&key, &type_tmp))
-		{
-			type = GPOINTER_TO_INT(type_tmp);
-
-			if (prepared->variables_count)
-			{
-				g_string_append(prepared->sql, ", ");
-			}
-
-			prepared->variables_count++;
-			g_string_append_printf(prepared->sql, SQL_QUOTE "%s" SQL_QUOTE, key);
-			g_array_append_val(arr_types_in, type);
-			g_hash_table_insert(prepared->variables_index, g_strdup(key), GINT_TO_POINTER(prepared->variables_count));
-		}
-
-		g_string_append(prepared->sql, ") VALUES (");
-
-		if (prepared->variables_count)
-		{
-			g_string_append_printf(prepared->sql, " ?");
-		}
-
-		for (i = 1; i < prepared->variables_count; i++)
-		{
-			g_string_append_printf(prepared->sql, ", ?");
-		}
-
-		g_string_append(prepared->sql, " )");
+		prepared->sql = g_string_new(sql->str);
+		prepared->variables_count = variables_count;
 
-		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, prepared->sql->str, &prepared->stmt, arr_types_in, NULL, error)))
+		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, prepared->sql->str, &prepared->stmt, arr_types_in, arr_types_out, error)))
 		{
 			goto _error;
 		}
@@ -1367,145 +3203,131 @@ backend_insert(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 		prepared->initialized = TRUE;
 	}
 
-	if (G_UNLIKELY(!j_bson_iter_init(&iter, metadata, error)))
-	{
-		goto _error;
-	}
+	variables_count = 0;
 
-	for (i = 0; i < prepared->variables_count; i++)
+	if (G_UNLIKELY(!bind_selector_where(backend_data, selector, prepared, &variables_count, schema_cache, error)))
 	{
-		if (G_UNLIKELY(!j_sql_bind_null(thread_variables->sql_backend, prepared->stmt, i + 1, error)))
-		{
-			goto _error;
-		}
+		goto _error;
 	}
 
 	while (TRUE)
 	{
-		if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
+		if (G_UNLIKELY(!j_sql_step(thread_variables->sql_backend, prepared->stmt, &sql_found, error)))
 		{
 			goto _error;
 		}
 
-		if (!has_next)
+		if (!sql_found)
 		{
 			break;
 		}
-
-		string_tmp = j_bson_iter_key(&iter, error);
-
-		if (G_UNLIKELY(!string_tmp))
-		{
-			goto _error;
-		}
-
-		type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
-		index = GPOINTER_TO_INT(g_hash_table_lookup(prepared->variables_index, string_tmp));
-
-		if (G_UNLIKELY(!index))
-		{
-			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
-			goto _error;
-		}
-
 		count++;
 
-		if (G_UNLIKELY(!j_bson_iter_value(&iter, type, &value, error)))
-		{
-			goto _error;
-		}
-
-		if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, index, type, &value, error)))
+		if (G_UNLIKELY(!j_sql_column(thread_variables->sql_backend, prepared->stmt, 0, J_DB_TYPE_UINT32, &value, error)))
 		{
 			goto _error;
 		}
-	}
-
-	if (G_UNLIKELY(!count))
-	{
-		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_NO_VARIABLE_SET, "no variable set");
-		goto _error;
-	}
 
-	if (G_UNLIKELY(!j_sql_step_and_reset_check_done(thread_variables->sql_backend, prepared->stmt, error)))
-	{
-		goto _error;
+		g_array_append_val(iteratorOut->arr, value.val_uint32);
 	}
 
-	if (G_UNLIKELY(!j_sql_step(thread_variables->sql_backend, prepared_id->stmt, &found, error)))
+	if (G_UNLIKELY(!j_sql_reset(thread_variables->sql_backend, prepared->stmt, error)))
 	{
 		goto _error;
 	}
 
-	if (!found)
+	if (!count)
 	{
 		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_sql_column(thread_variables->sql_backend, prepared_id->stmt, 0, J_DB_TYPE_UINT32, &value, error)))
-	{
-		goto _error;
-	}
-
-	if (G_UNLIKELY(!j_sql_reset(thread_variables->sql_backend, prepared_id->stmt, error)))
-	{
-		goto _error;
-	}
-
-	if (G_UNLIKELY(!j_bson_append_value(id, "_value", J_DB_TYPE_UINT32, &value, error)))
+	if (sql)
 	{
-		goto _error;
+		g_string_free(sql, TRUE);
+		sql = NULL;
 	}
 
-	value.val_uint32 = J_DB_TYPE_UINT32;
+	*iterator = iteratorOut;
 
-	if (G_UNLIKELY(!j_bson_append_value(id, "_value_type", J_DB_TYPE_UINT32, &value, error)))
-	{
-		goto _error;
-	}
+	advisor_record(batch->namespace, name, selector, g_get_monotonic_time() - start);
 
 	return TRUE;
 
 _error:
-	if (G_UNLIKELY(!_backend_batch_abort(backend_data, batch, NULL)))
+	if (sql)
 	{
-		goto _error2;
+		g_string_free(sql, TRUE);
 	}
 
-	return FALSE;
+	freeJSqlIterator(iteratorOut);
 
-_error2:
-	/*something failed very hard*/
 	return FALSE;
 }
-
 static gboolean
-build_selector_query(gpointer backend_data, bson_iter_t* iter, GString* sql, JDBSelectorMode mode, guint* variables_count, GArray* arr_types_in, GHashTable* schema_cache, GError** error)
+backend_update(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* selector, bson_t const* metadata, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JDBSelectorMode mode_child;
+	JSqlBatch* batch = _batch;
+	guint count;
 	gboolean equals;
-	gboolean has_next;
-	JDBSelectorOperator op;
-	gboolean first = TRUE;
-	const char* string_tmp;
+	JDBType type;
 	JDBTypeValue value;
-	bson_iter_t iterchild;
+	guint variables_count;
+	bson_iter_t iter;
+	guint index;
+	guint64 changes;
+	GHashTable* schema_cache = NULL;
+	GHashTable* shapes = NULL;
+	gint64 start = g_get_monotonic_time();
+	const char* string_tmp;
+	gboolean has_next;
+	GString* sql = g_string_new(NULL);
+	JSqlCacheSQLPrepared* prepared = NULL;
+	GHashTable* variables_index = NULL;
 	JThreadVariables* thread_variables = NULL;
-	JDBType type;
+	g_autoptr(GArray) arr_types_in = NULL;
+
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(metadata != NULL, FALSE);
+	g_return_val_if_fail(selector != NULL, FALSE);
+
+	if (!(schema_cache = getCacheSchema(backend_data, batch, name, error)))
+	{
+		goto _error;
+	}
+
+	if (!(shapes = getCacheShapes(backend_data, batch, name, error)))
+	{
+		goto _error;
+	}
+
+	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
 
 	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
 	{
 		goto _error;
 	}
 
-	g_string_append(sql, "( ");
+	if (G_UNLIKELY(!j_bson_has_enough_keys(selector, 2, error)))
+	{
+		goto _error;
+	}
+
+	variables_count = 0;
+	variables_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	g_string_append_printf(sql, "UPDATE " SQL_QUOTE "%s_%s" SQL_QUOTE " SET ", batch->namespace, name);
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, metadata, error)))
+	{
+		goto _error;
+	}
 
 	while (TRUE)
 	{
-		if (G_UNLIKELY(!j_bson_iter_next(iter, &has_next, error)))
+		if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
 		{
 			goto _error;
 		}
@@ -1515,7 +3337,7 @@ build_selector_query(gpointer backend_data, bson_iter_t* iter, GString* sql, JDB
 			break;
 		}
 
-		if (G_UNLIKELY(!j_bson_iter_key_equals(iter, "_mode", &equals, error)))
+		if (G_UNLIKELY(!j_bson_iter_key_equals(&iter, "_index", &equals, error)))
 		{
 			goto _error;
 		}
@@ -1525,164 +3347,64 @@ build_selector_query(gpointer backend_data, bson_iter_t* iter, GString* sql, JDB
 			continue;
 		}
 
-		if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
-		{
-			goto _error;
-		}
-
-		if (!first)
+		if (variables_count)
 		{
-			switch (mode)
-			{
-				case J_DB_SELECTOR_MODE_AND:
-					g_string_append(sql, " AND ");
-					break;
-				case J_DB_SELECTOR_MODE_OR:
-					g_string_append(sql, " OR ");
-					break;
-				default:
-					g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_OPERATOR_INVALID, "operator invalid");
-					goto _error;
-			}
+			g_string_append(sql, ", ");
 		}
 
-		first = FALSE;
+		variables_count++;
+		string_tmp = j_bson_iter_key(&iter, error);
 
-		if (j_bson_iter_find(&iterchild, "_mode", NULL))
+		if (G_UNLIKELY(!string_tmp))
 		{
-			if (G_UNLIKELY(!j_bson_iter_value(&iterchild, J_DB_TYPE_UINT32, &value, error)))
-			{
-				goto _error;
-			}
-
-			mode_child = value.val_uint32;
-
-			if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
-			{
-				goto _error;
-			}
-
-			if (G_UNLIKELY(!build_selector_query(backend_data, &iterchild, sql, mode_child, variables_count, arr_types_in, schema_cache, error)))
-			{
-				goto _error;
-			}
+			goto _error;
 		}
-		else
-		{
-			if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
-			{
-				goto _error;
-			}
-
-			if (G_UNLIKELY(!j_bson_iter_find(&iterchild, "_name", error)))
-			{
-				goto _error;
-			}
-
-			if (G_UNLIKELY(!j_bson_iter_value(&iterchild, J_DB_TYPE_STRING, &value, error)))
-			{
-				goto _error;
-			}
-
-			string_tmp = value.val_string;
-			g_string_append_printf(sql, SQL_QUOTE "%s" SQL_QUOTE " ", string_tmp);
-
-			if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
-			{
-				goto _error;
-			}
-
-			if (G_UNLIKELY(!j_bson_iter_find(&iterchild, "_value", error)))
-			{
-				goto _error;
-			}
 
-			type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
-			g_array_append_val(arr_types_in, type);
-
-			if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
-			{
-				goto _error;
-			}
-
-			if (G_UNLIKELY(!j_bson_iter_find(&iterchild, "_operator", error)))
-			{
-				goto _error;
-			}
-
-			if (G_UNLIKELY(!j_bson_iter_value(&iterchild, J_DB_TYPE_UINT32, &value, error)))
-			{
-				goto _error;
-			}
-
-			op = value.val_uint32;
-
-			switch (op)
-			{
-				case J_DB_SELECTOR_OPERATOR_LT:
-					g_string_append(sql, "<");
-					break;
-				case J_DB_SELECTOR_OPERATOR_LE:
-					g_string_append(sql, "<=");
-					break;
-				case J_DB_SELECTOR_OPERATOR_GT:
-					g_string_append(sql, ">");
-					break;
-				case J_DB_SELECTOR_OPERATOR_GE:
-					g_string_append(sql, ">=");
-					break;
-				case J_DB_SELECTOR_OPERATOR_EQ:
-					g_string_append(sql, "=");
-					break;
-				case J_DB_SELECTOR_OPERATOR_NE:
-					g_string_append(sql, "!=");
-					break;
-				default:
-					g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_COMPARATOR_INVALID, "comparator invalid");
-					goto _error;
-			}
+		type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
+		g_array_append_val(arr_types_in, type);
+		g_string_append_printf(sql, SQL_QUOTE "%s" SQL_QUOTE " = ?", string_tmp);
+		g_hash_table_insert(variables_index, g_strdup(string_tmp), GINT_TO_POINTER(variables_count));
+	}
 
-			(*variables_count)++;
+	// The selector's variables follow the SET variables, so the statement is cached per selector shape
+	count = variables_count;
 
-			g_string_append_printf(sql, " ?");
-		}
+	if (G_UNLIKELY(!build_selector_where(backend_data, selector, sql, &variables_count, arr_types_in, schema_cache, shapes, error)))
+	{
+		goto _error;
 	}
 
-	g_string_append(sql, " )");
+	prepared = getCachePrepared(backend_data, batch->namespace, name, sql->str, error);
 
-	if (first)
+	if (G_UNLIKELY(!prepared))
 	{
-		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_SELECTOR_EMPTY, "selector empty");
 		goto _error;
 	}
 
-	return TRUE;
-
-_error:
-	return FALSE;
-}
+	if (!prepared->initialized)
+	{
+		prepared->sql = sql;
+		sql = NULL;
+		prepared->variables_count = variables_count;
+		prepared->variables_index = variables_index;
+		variables_index = NULL;
 
-static gboolean
-bind_selector_query(gpointer backend_data, bson_iter_t* iter, JSqlCacheSQLPrepared* prepared, guint* variables_count, GHashTable* schema_cache, GError** error)
-{
-	J_TRACE_FUNCTION(NULL);
+		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, prepared->sql->str, &prepared->stmt, arr_types_in, NULL, error)))
+		{
+			goto _error;
+		}
 
-	bson_iter_t iterchild;
-	JDBTypeValue value;
-	JDBType type;
-	gboolean has_next;
-	gboolean equals;
-	JThreadVariables* thread_variables = NULL;
-	char const* string_tmp;
+		prepared->initialized = TRUE;
+	}
 
-	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, metadata, error)))
 	{
 		goto _error;
 	}
 
 	while (TRUE)
 	{
-		if (G_UNLIKELY(!j_bson_iter_next(iter, &has_next, error)))
+		if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
 		{
 			goto _error;
 		}
@@ -1692,160 +3414,131 @@ bind_selector_query(gpointer backend_data, bson_iter_t* iter, JSqlCacheSQLPrepar
 			break;
 		}
 
-		if (G_UNLIKELY(!j_bson_iter_key_equals(iter, "_mode", &equals, error)))
+		string_tmp = j_bson_iter_key(&iter, error);
+
+		if (G_UNLIKELY(!string_tmp))
 		{
 			goto _error;
 		}
 
-		if (equals)
+		type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
+		index = GPOINTER_TO_INT(g_hash_table_lookup(prepared->variables_index, string_tmp));
+
+		if (G_UNLIKELY(!index))
 		{
-			continue;
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+			goto _error;
 		}
 
-		if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
+		if (G_UNLIKELY(!j_bson_iter_value(&iter, type, &value, error)))
 		{
 			goto _error;
 		}
 
-		if (j_bson_iter_find(&iterchild, "_mode", NULL))
+		if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, index, type, &value, error)))
 		{
-			if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
-			{
-				goto _error;
-			}
-
-			if (G_UNLIKELY(!bind_selector_query(backend_data, &iterchild, prepared, variables_count, schema_cache, error)))
-			{
-				goto _error;
-			}
+			goto _error;
 		}
-		else
-		{
-			(*variables_count)++;
+	}
 
-			if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
-			{
-				goto _error;
-			}
+	if (G_UNLIKELY(!bind_selector_where(backend_data, selector, prepared, &count, schema_cache, error)))
+	{
+		goto _error;
+	}
 
-			if (G_UNLIKELY(!j_bson_iter_find(&iterchild, "_name", error)))
-			{
-				goto _error;
-			}
+	if (G_UNLIKELY(!j_sql_step_and_reset_check_done(thread_variables->sql_backend, prepared->stmt, error)))
+	{
+		goto _error;
+	}
 
-			if (G_UNLIKELY(!j_bson_iter_value(&iterchild, J_DB_TYPE_STRING, &value, error)))
-			{
-				goto _error;
-			}
+	if (G_UNLIKELY(!j_sql_changes(thread_variables->sql_backend, prepared->stmt, &changes, error)))
+	{
+		goto _error;
+	}
 
-			string_tmp = value.val_string;
+	if (!changes)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+		goto _error;
+	}
 
-			if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
-			{
-				goto _error;
-			}
+	if (sql)
+	{
+		g_string_free(sql, TRUE);
+		sql = NULL;
+	}
+
+	if (variables_index)
+		g_hash_table_destroy(variables_index);
 
-			if (G_UNLIKELY(!j_bson_iter_find(&iterchild, "_value", error)))
-			{
-				goto _error;
-			}
+	advisor_record(batch->namespace, name, selector, g_get_monotonic_time() - start);
 
-			type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
+	return TRUE;
 
-			if (G_UNLIKELY(!j_bson_iter_value(&iterchild, type, &value, error)))
-			{
-				goto _error;
-			}
+_error:
+	if (sql)
+	{
+		g_string_free(sql, TRUE);
+		sql = NULL;
+	}
 
-			if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, *variables_count, type, &value, error)))
-			{
-				goto _error;
-			}
-		}
+	if (variables_index)
+		g_hash_table_destroy(variables_index);
+
+	if (G_UNLIKELY(!_backend_batch_abort(backend_data, batch, NULL)))
+	{
+		goto _error2;
 	}
 
-	return TRUE;
+	return FALSE;
 
-_error:
+_error2:
+	/*something failed very hard*/
 	return FALSE;
 }
+
 static gboolean
-_backend_query(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* selector, gpointer* iterator, GError** error)
+backend_delete(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* selector, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JDBSelectorMode mode_child;
 	JSqlBatch* batch = _batch;
-	gboolean sql_found;
-	JDBTypeValue value;
-	guint count = 0;
-	bson_iter_t iter;
 	guint variables_count;
-	JSqlCacheSQLPrepared* prepared = NULL;
+	guint64 changes;
+	GHashTable* schema_cache = NULL;
+	GHashTable* shapes = NULL;
+	gint64 start = g_get_monotonic_time();
 	GString* sql = g_string_new(NULL);
-	JSqlIterator* iteratorOut = NULL;
+	JSqlCacheSQLPrepared* prepared = NULL;
 	JThreadVariables* thread_variables = NULL;
 	g_autoptr(GArray) arr_types_in = NULL;
-	g_autoptr(GArray) arr_types_out = NULL;
-	JDBType type;
-	GHashTable* schema_cache = NULL;
+
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
 
 	if (!(schema_cache = getCacheSchema(backend_data, batch, name, error)))
 	{
 		goto _error;
 	}
 
+	if (!(shapes = getCacheShapes(backend_data, batch, name, error)))
+	{
+		goto _error;
+	}
+
 	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
-	arr_types_out = g_array_new(FALSE, FALSE, sizeof(JDBType));
-	type = J_DB_TYPE_UINT32;
-	g_array_append_val(arr_types_out, type);
 
 	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
 	{
 		goto _error;
 	}
 
-	*iterator = NULL;
-	iteratorOut = g_new(JSqlIterator, 1);
-	iteratorOut->namespace = g_strdup(batch->namespace);
-	iteratorOut->name = g_strdup(name);
-	iteratorOut->index = 0;
-	iteratorOut->arr = g_array_new(FALSE, FALSE, sizeof(guint64));
-
-	g_string_append_printf(sql, "SELECT DISTINCT _id FROM " SQL_QUOTE "%s_%s" SQL_QUOTE, batch->namespace, name);
+	variables_count = 0;
+	g_string_append_printf(sql, "DELETE FROM " SQL_QUOTE "%s_%s" SQL_QUOTE, batch->namespace, name);
 
-	if (selector && j_bson_has_enough_keys(selector, 2, NULL))
+	if (G_UNLIKELY(!build_selector_where(backend_data, selector, sql, &variables_count, arr_types_in, schema_cache, shapes, error)))
 	{
-		g_string_append(sql, " WHERE ");
-
-		if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
-		{
-			goto _error;
-		}
-
-		if (G_UNLIKELY(!j_bson_iter_find(&iter, "_mode", error)))
-		{
-			goto _error;
-		}
-
-		if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT32, &value, error)))
-		{
-			goto _error;
-		}
-
-		mode_child = value.val_uint32;
-
-		if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
-		{
-			goto _error;
-		}
-
-		variables_count = 0;
-
-		if (G_UNLIKELY(!build_selector_query(backend_data, &iter, sql, mode_child, &variables_count, arr_types_in, schema_cache, error)))
-		{
-			goto _error;
-		}
+		goto _error;
 	}
 
 	prepared = getCachePrepared(backend_data, batch->namespace, name, sql->str, error);
@@ -1857,10 +3550,11 @@ _backend_query(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 
 	if (!prepared->initialized)
 	{
-		prepared->sql = g_string_new(sql->str);
+		prepared->sql = sql;
+		sql = NULL;
 		prepared->variables_count = variables_count;
 
-		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, prepared->sql->str, &prepared->stmt, arr_types_in, arr_types_out, error)))
+		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, prepared->sql->str, &prepared->stmt, arr_types_in, NULL, error)))
 		{
 			goto _error;
 		}
@@ -1868,48 +3562,24 @@ _backend_query(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 		prepared->initialized = TRUE;
 	}
 
-	if (selector && j_bson_has_enough_keys(selector, 2, NULL))
-	{
-		if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
-		{
-			goto _error;
-		}
-
-		variables_count = 0;
+	variables_count = 0;
 
-		if (G_UNLIKELY(!bind_selector_query(backend_data, &iter, prepared, &variables_count, schema_cache, error)))
-		{
-			goto _error;
-		}
+	if (G_UNLIKELY(!bind_selector_where(backend_data, selector, prepared, &variables_count, schema_cache, error)))
+	{
+		goto _error;
 	}
 
-	while (TRUE)
+	if (G_UNLIKELY(!j_sql_step_and_reset_check_done(thread_variables->sql_backend, prepared->stmt, error)))
 	{
-		if (G_UNLIKELY(!j_sql_step(thread_variables->sql_backend, prepared->stmt, &sql_found, error)))
-		{
-			goto _error;
-		}
-
-		if (!sql_found)
-		{
-			break;
-		}
-		count++;
-
-		if (G_UNLIKELY(!j_sql_column(thread_variables->sql_backend, prepared->stmt, 0, J_DB_TYPE_UINT32, &value, error)))
-		{
-			goto _error;
-		}
-
-		g_array_append_val(iteratorOut->arr, value.val_uint32);
+		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_sql_reset(thread_variables->sql_backend, prepared->stmt, error)))
+	if (G_UNLIKELY(!j_sql_changes(thread_variables->sql_backend, prepared->stmt, &changes, error)))
 	{
 		goto _error;
 	}
 
-	if (!count)
+	if (!changes)
 	{
 		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
 		goto _error;
@@ -1921,7 +3591,7 @@ _backend_query(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 		sql = NULL;
 	}
 
-	*iterator = iteratorOut;
+	advisor_record(batch->namespace, name, selector, g_get_monotonic_time() - start);
 
 	return TRUE;
 
@@ -1929,113 +3599,180 @@ _error:
 	if (sql)
 	{
 		g_string_free(sql, TRUE);
+		sql = NULL;
 	}
 
-	freeJSqlIterator(iteratorOut);
+	if (G_UNLIKELY(!_backend_batch_abort(backend_data, batch, NULL)))
+	{
+		goto _error2;
+	}
 
 	return FALSE;
+
+_error2:
+	/*something failed very hard*/
+	return FALSE;
 }
+
 static gboolean
-backend_update(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* selector, bson_t const* metadata, GError** error)
+backend_query_fields(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* selector, bson_t const* fields, gpointer* iterator, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JSqlBatch* batch = _batch;
-	guint count;
-	gboolean equals;
+	JDBSelectorMode mode_child;
+	GHashTableIter schema_iter;
+
+	GHashTable* schema_cache = NULL;
+	GHashTable* shapes = NULL;
+	gint64 start = g_get_monotonic_time();
 	JDBType type;
-	JDBTypeValue value;
-	JSqlIterator* iterator = NULL;
-	guint variables_count;
+	gpointer type_tmp;
+
+	JSqlBatch* batch = _batch;
 	bson_iter_t iter;
-	guint index;
-	guint j;
-	GHashTable* schema_cache = NULL;
-	const char* string_tmp;
-	gboolean has_next;
-	GString* sql = g_string_new(NULL);
+	guint variables_count;
+	guint variables_count2;
+	JDBTypeValue value;
+	char* string_tmp;
 	JSqlCacheSQLPrepared* prepared = NULL;
 	GHashTable* variables_index = NULL;
+	GString* sql = g_string_new(NULL);
 	JThreadVariables* thread_variables = NULL;
 	g_autoptr(GArray) arr_types_in = NULL;
+	g_autoptr(GArray) arr_types_out = NULL;
 
 	g_return_val_if_fail(name != NULL, FALSE);
 	g_return_val_if_fail(batch != NULL, FALSE);
-	g_return_val_if_fail(metadata != NULL, FALSE);
-	g_return_val_if_fail(selector != NULL, FALSE);
-
-	if (!(schema_cache = getCacheSchema(backend_data, batch, name, error)))
-	{
-		goto _error;
-	}
 
 	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
+	arr_types_out = g_array_new(FALSE, FALSE, sizeof(JDBType));
 
 	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
 	{
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_bson_has_enough_keys(selector, 2, error)))
+	variables_index = g_hash_table_new_full(g_direct_hash, NULL, NULL, g_free);
+	g_string_append(sql, "SELECT ");
+	variables_count = 0;
+
+	if (!(schema_cache = getCacheSchema(backend_data, batch, name, error)))
 	{
 		goto _error;
 	}
 
-	variables_count = 0;
-	variables_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
-	g_string_append_printf(sql, "UPDATE " SQL_QUOTE "%s_%s" SQL_QUOTE " SET ", batch->namespace, name);
-
-	if (G_UNLIKELY(!j_bson_iter_init(&iter, metadata, error)))
+	if (!(shapes = getCacheShapes(backend_data, batch, name, error)))
 	{
 		goto _error;
 	}
 
-	while (TRUE)
+	g_hash_table_iter_init(&schema_iter, schema_cache);
+
+	g_string_append(sql, "_id");
+	g_hash_table_insert(variables_index, GINT_TO_POINTER(variables_count), g_strdup("_id"));
+	type = J_DB_TYPE_UINT32;
+	g_array_append_val(arr_types_out, type);
+	variables_count++;
+
+	if (fields != NULL)
 	{
-		if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
+		gboolean has_next;
+
+		// Only select the projected fields
+		if (G_UNLIKELY(!j_bson_iter_init(&iter, fields, error)))
 		{
 			goto _error;
 		}
 
-		if (!has_next)
+		while (TRUE)
 		{
-			break;
+			if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
+			{
+				goto _error;
+			}
+
+			if (!has_next)
+			{
+				break;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_STRING, &value, error)))
+			{
+				goto _error;
+			}
+
+			if (strcmp(value.val_string, "_id") == 0)
+				continue;
+
+			if (!g_hash_table_lookup_extended(schema_cache, value.val_string, NULL, &type_tmp))
+			{
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+				goto _error;
+			}
+
+			type = GPOINTER_TO_INT(type_tmp);
+
+			g_string_append_printf(sql, ", " SQL_QUOTE "%s" SQL_QUOTE, value.val_string);
+			g_hash_table_insert(variables_index, GINT_TO_POINTER(variables_count), g_strdup(value.val_string));
+			g_array_append_val(arr_types_out, type);
+			variables_count++;
+		}
+	}
+	else
+	{
+		while (g_hash_table_iter_next(&schema_iter, (gpointer*)&string_tmp, &type_tmp))
+		{
+			type = GPOINTER_TO_INT(type_tmp);
+
+			if (strcmp(string_tmp, "_id") == 0)
+				continue;
+
+			g_string_append_printf(sql, ", " SQL_QUOTE "%s" SQL_QUOTE, string_tmp);
+			g_hash_table_insert(variables_index, GINT_TO_POINTER(variables_count), g_strdup(string_tmp));
+			g_array_append_val(arr_types_out, type);
+			variables_count++;
 		}
+	}
 
-		if (G_UNLIKELY(!j_bson_iter_key_equals(&iter, "_index", &equals, error)))
+	g_string_append_printf(sql, " FROM " SQL_QUOTE "%s_%s" SQL_QUOTE, batch->namespace, name);
+
+	if (selector && j_bson_has_enough_keys(selector, 2, NULL))
+	{
+		g_string_append(sql, " WHERE ");
+
+		if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
 		{
 			goto _error;
 		}
 
-		if (equals)
+		if (G_UNLIKELY(!j_bson_iter_find(&iter, "_mode", error)))
 		{
-			continue;
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT32, &value, error)))
+		{
+			goto _error;
 		}
 
-		if (variables_count)
+		mode_child = value.val_uint32;
+
+		if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
 		{
-			g_string_append(sql, ", ");
+			goto _error;
 		}
 
-		variables_count++;
-		string_tmp = j_bson_iter_key(&iter, error);
+		variables_count2 = 0;
 
-		if (G_UNLIKELY(!string_tmp))
+		if (G_UNLIKELY(!build_selector_query(backend_data, &iter, sql, mode_child, &variables_count2, arr_types_in, schema_cache, shapes, error)))
 		{
 			goto _error;
 		}
-
-		type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
-		g_array_append_val(arr_types_in, type);
-		g_string_append_printf(sql, SQL_QUOTE "%s" SQL_QUOTE " = ?", string_tmp);
-		g_hash_table_insert(variables_index, g_strdup(string_tmp), GINT_TO_POINTER(variables_count));
 	}
 
-	variables_count++;
-	type = J_DB_TYPE_UINT32;
-	g_array_append_val(arr_types_in, type);
-	g_string_append_printf(sql, " WHERE _id = ?");
-	g_hash_table_insert(variables_index, g_strdup("_id"), GINT_TO_POINTER(variables_count));
+	// Clients page through large results using the entries' IDs
+	g_string_append(sql, " ORDER BY _id");
+
 	prepared = getCachePrepared(backend_data, batch->namespace, name, sql->str, error);
 
 	if (G_UNLIKELY(!prepared))
@@ -2045,286 +3782,378 @@ backend_update(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 
 	if (!prepared->initialized)
 	{
-		prepared->sql = sql;
-		sql = NULL;
-		prepared->variables_count = variables_count;
+		prepared->sql = g_string_new(sql->str);
 		prepared->variables_index = variables_index;
-		variables_index = NULL;
+		prepared->variables_count = variables_count;
 
-		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, prepared->sql->str, &prepared->stmt, arr_types_in, NULL, error)))
+		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, prepared->sql->str, &prepared->stmt, arr_types_in, arr_types_out, error)))
 		{
 			goto _error;
 		}
-
 		prepared->initialized = TRUE;
 	}
-
-	if (G_UNLIKELY(!_backend_query(backend_data, batch, name, selector, (gpointer*)&iterator, error)))
+	else
 	{
-		goto _error;
+		g_hash_table_destroy(variables_index);
+		variables_index = NULL;
 	}
 
-	for (j = 0; j < iterator->arr->len; j++)
+	if (selector && j_bson_has_enough_keys(selector, 2, NULL))
 	{
-		count = 0;
-		index = GPOINTER_TO_INT(g_hash_table_lookup(prepared->variables_index, "_id"));
-
-		if (G_UNLIKELY(!index))
+		if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
 		{
-			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
 			goto _error;
 		}
 
-		value.val_uint32 = g_array_index(iterator->arr, guint64, j);
+		variables_count2 = 0;
 
-		if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, index, J_DB_TYPE_UINT32, &value, error)))
+		if (G_UNLIKELY(!bind_selector_query(backend_data, &iter, prepared, &variables_count2, schema_cache, error)))
 		{
 			goto _error;
 		}
+	}
 
-		if (G_UNLIKELY(!j_bson_iter_init(&iter, metadata, error)))
-		{
-			goto _error;
-		}
+	*iterator = prepared;
 
-		while (TRUE)
-		{
-			if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
-			{
-				goto _error;
-			}
+	if (sql)
+	{
+		g_string_free(sql, TRUE);
+		sql = NULL;
+	}
 
-			if (!has_next)
-			{
-				break;
-			}
+	advisor_record(batch->namespace, name, selector, g_get_monotonic_time() - start);
 
-			string_tmp = j_bson_iter_key(&iter, error);
+	return TRUE;
 
-			if (G_UNLIKELY(!string_tmp))
-			{
-				goto _error;
-			}
+_error:
+	if (sql)
+	{
+		g_string_free(sql, TRUE);
+		sql = NULL;
+	}
 
-			type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
-			index = GPOINTER_TO_INT(g_hash_table_lookup(prepared->variables_index, string_tmp));
+	if (variables_index)
+	{
+		g_hash_table_destroy(variables_index);
+	}
+
+	return FALSE;
+}
+
+static gboolean
+backend_query(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* selector, gpointer* iterator, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return backend_query_fields(backend_data, _batch, name, selector, NULL, iterator, error);
+}
+
+static gboolean
+backend_iterate(gpointer backend_data, gpointer _iterator, bson_t* metadata, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GHashTable* schema_cache = NULL;
+	const char* string_tmp;
+	guint i;
+	JSqlCacheSQLQueries* queries = NULL;
+	JDBTypeValue value;
+	JDBType type;
+	gboolean sql_found;
+	JSqlCacheSQLPrepared* prepared = _iterator;
+	gboolean found = FALSE;
+	JThreadVariables* thread_variables = NULL;
+
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	{
+		goto _error;
+	}
+
+	if (!(queries = _getCachePrepared(backend_data, prepared->namespace, prepared->name, error)))
+	{
+		goto _error;
+	}
+
+	// The schema has been loaded when the query was started
+	if (!queries->schema || !(schema_cache = queries->schema->types))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_sql_step(thread_variables->sql_backend, prepared->stmt, &sql_found, error)))
+	{
+		goto _error;
+	}
+
+	if (sql_found)
+	{
+		found = TRUE;
+
+		for (i = 0; i < prepared->variables_count; i++)
+		{
+			string_tmp = g_hash_table_lookup(prepared->variables_index, GINT_TO_POINTER(i));
 
-			if (G_UNLIKELY(!index))
+			if (prepared->variables_type != NULL)
 			{
-				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
-				goto _error;
+				type = g_array_index(prepared->variables_type, JDBType, i);
+			}
+			else
+			{
+				type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
 			}
 
-			count++;
-
-			if (G_UNLIKELY(!j_bson_iter_value(&iter, type, &value, error)))
+			if (G_UNLIKELY(!j_sql_column(thread_variables->sql_backend, prepared->stmt, i, type, &value, error)))
 			{
 				goto _error;
 			}
 
-			if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, index, type, &value, error)))
+			if (G_UNLIKELY(!j_bson_append_value(metadata, string_tmp, type, &value, error)))
 			{
 				goto _error;
 			}
 		}
-
-		if (G_UNLIKELY(!j_sql_step_and_reset_check_done(thread_variables->sql_backend, prepared->stmt, error)))
-		{
-			goto _error;
-		}
-
-		if (!count)
-		{
-			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
-			goto _error;
-		}
 	}
 
-	if (sql)
+	if (!found)
 	{
-		g_string_free(sql, TRUE);
-		sql = NULL;
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+		goto _error;
 	}
 
-	if (variables_index)
-		g_hash_table_destroy(variables_index);
-
-	freeJSqlIterator(iterator);
-
 	return TRUE;
 
 _error:
-	if (sql)
-	{
-		g_string_free(sql, TRUE);
-		sql = NULL;
-	}
-
-	if (variables_index)
-		g_hash_table_destroy(variables_index);
-
-	freeJSqlIterator(iterator);
-
-	if (G_UNLIKELY(!_backend_batch_abort(backend_data, batch, NULL)))
+	if (G_UNLIKELY(!j_sql_reset(thread_variables->sql_backend, prepared->stmt, NULL)))
 	{
-		goto _error2;
+		goto _error3;
 	}
 
 	return FALSE;
 
-_error2:
+_error3:
 	/*something failed very hard*/
 	return FALSE;
 }
 
 static gboolean
-backend_delete(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* selector, GError** error)
+backend_aggregate(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* selector, bson_t const* aggregate, gpointer* iterator, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
+	JDBSelectorMode mode_child;
+	GHashTable* schema_cache = NULL;
+	GHashTable* shapes = NULL;
 	JDBType type;
+	gpointer type_tmp;
+
 	JSqlBatch* batch = _batch;
-	JSqlIterator* iterator = NULL;
-	guint j;
+	bson_iter_t iter;
+	bson_iter_t iter_array;
+	bson_iter_t iter_function;
+	gboolean has_next;
+	guint variables_count;
+	guint variables_count2;
 	JDBTypeValue value;
 	JSqlCacheSQLPrepared* prepared = NULL;
+	GHashTable* variables_index = NULL;
+	GString* sql = g_string_new(NULL);
+	g_autoptr(GString) group = g_string_new(NULL);
 	JThreadVariables* thread_variables = NULL;
 	g_autoptr(GArray) arr_types_in = NULL;
+	GArray* arr_types_out = NULL;
 
 	g_return_val_if_fail(name != NULL, FALSE);
 	g_return_val_if_fail(batch != NULL, FALSE);
 
 	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
-	type = J_DB_TYPE_UINT32;
-	g_array_append_val(arr_types_in, type);
+	arr_types_out = g_array_new(FALSE, FALSE, sizeof(JDBType));
 
 	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
 	{
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!_backend_query(backend_data, batch, name, selector, (gpointer*)&iterator, error)))
+	if (!(schema_cache = getCacheSchema(backend_data, batch, name, error)))
 	{
 		goto _error;
 	}
 
-	prepared = getCachePrepared(backend_data, batch->namespace, name, "_delete", error);
+	if (!(shapes = getCacheShapes(backend_data, batch, name, error)))
+	{
+		goto _error;
+	}
 
-	if (G_UNLIKELY(!prepared))
+	variables_index = g_hash_table_new_full(g_direct_hash, NULL, NULL, g_free);
+	g_string_append(sql, "SELECT ");
+	variables_count = 0;
+
+	// Group-by fields come first, they are also used for GROUP BY and ORDER BY
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, aggregate, error)))
 	{
 		goto _error;
 	}
 
-	if (!prepared->initialized)
+	if (G_UNLIKELY(!j_bson_iter_find(&iter, "_group", error)))
 	{
-		prepared->sql = g_string_new(NULL);
-		prepared->variables_count = 1;
-		g_string_append_printf(prepared->sql, "DELETE FROM " SQL_QUOTE "%s_%s" SQL_QUOTE " WHERE _id = ?", batch->namespace, name);
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_recurse_array(&iter, &iter_array, error)))
+	{
+		goto _error;
+	}
+
+	while (TRUE)
+	{
+		if (G_UNLIKELY(!j_bson_iter_next(&iter_array, &has_next, error)))
+		{
+			goto _error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_value(&iter_array, J_DB_TYPE_STRING, &value, error)))
+		{
+			goto _error;
+		}
+
+		if (!g_hash_table_lookup_extended(schema_cache, value.val_string, NULL, &type_tmp))
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+			goto _error;
+		}
+
+		type = GPOINTER_TO_INT(type_tmp);
+
+		g_string_append_printf(sql, "%s" SQL_QUOTE "%s" SQL_QUOTE, (variables_count > 0) ? ", " : "", value.val_string);
+		g_string_append_printf(group, "%s" SQL_QUOTE "%s" SQL_QUOTE, (variables_count > 0) ? ", " : "", value.val_string);
+		g_hash_table_insert(variables_index, GINT_TO_POINTER(variables_count), g_strdup(value.val_string));
+		g_array_append_val(arr_types_out, type);
+		variables_count++;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, aggregate, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_find(&iter, "_functions", error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_recurse_array(&iter, &iter_array, error)))
+	{
+		goto _error;
+	}
+
+	while (TRUE)
+	{
+		gchar const* function_sql;
+		gchar const* result_name;
+		gchar const* field = NULL;
+
+		if (G_UNLIKELY(!j_bson_iter_next(&iter_array, &has_next, error)))
+		{
+			goto _error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter_array, &iter_function, error)))
+		{
+			goto _error;
+		}
 
-		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, prepared->sql->str, &prepared->stmt, arr_types_in, NULL, error)))
+		if (G_UNLIKELY(!j_bson_iter_find(&iter_function, "_name", error) || !j_bson_iter_value(&iter_function, J_DB_TYPE_STRING, &value, error)))
 		{
 			goto _error;
 		}
 
-		prepared->initialized = TRUE;
-	}
-
-	for (j = 0; j < iterator->arr->len; j++)
-	{
-		value.val_uint32 = g_array_index(iterator->arr, guint64, j);
+		result_name = value.val_string;
 
-		if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 1, J_DB_TYPE_UINT32, &value, error)))
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter_array, &iter_function, error)))
 		{
 			goto _error;
 		}
 
-		if (G_UNLIKELY(!j_sql_step_and_reset_check_done(thread_variables->sql_backend, prepared->stmt, error)))
+		if (G_UNLIKELY(!j_bson_iter_find(&iter_function, "_function", error) || !j_bson_iter_value(&iter_function, J_DB_TYPE_UINT32, &value, error)))
 		{
 			goto _error;
 		}
-	}
-
-	freeJSqlIterator(iterator);
-
-	return TRUE;
-
-_error:
-	freeJSqlIterator(iterator);
-
-	if (G_UNLIKELY(!_backend_batch_abort(backend_data, batch, NULL)))
-	{
-		goto _error2;
-	}
-
-	return FALSE;
-
-_error2:
-	/*something failed very hard*/
-	return FALSE;
-}
-
-static gboolean
-backend_query(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* selector, gpointer* iterator, GError** error)
-{
-	J_TRACE_FUNCTION(NULL);
-
-	JDBSelectorMode mode_child;
-	GHashTableIter schema_iter;
 
-	GHashTable* schema_cache = NULL;
-	JDBType type;
-	gpointer type_tmp;
-
-	JSqlBatch* batch = _batch;
-	bson_iter_t iter;
-	guint variables_count;
-	guint variables_count2;
-	JDBTypeValue value;
-	char* string_tmp;
-	JSqlCacheSQLPrepared* prepared = NULL;
-	GHashTable* variables_index = NULL;
-	GString* sql = g_string_new(NULL);
-	JThreadVariables* thread_variables = NULL;
-	g_autoptr(GArray) arr_types_in = NULL;
-	g_autoptr(GArray) arr_types_out = NULL;
-
-	g_return_val_if_fail(name != NULL, FALSE);
-	g_return_val_if_fail(batch != NULL, FALSE);
+		switch (value.val_uint32)
+		{
+			case J_DB_AGGREGATE_FUNCTION_COUNT:
+				function_sql = "COUNT";
+				break;
+			case J_DB_AGGREGATE_FUNCTION_SUM:
+				function_sql = "SUM";
+				break;
+			case J_DB_AGGREGATE_FUNCTION_MIN:
+				function_sql = "MIN";
+				break;
+			case J_DB_AGGREGATE_FUNCTION_MAX:
+				function_sql = "MAX";
+				break;
+			case J_DB_AGGREGATE_FUNCTION_AVG:
+				function_sql = "AVG";
+				break;
+			default:
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_OPERATOR_INVALID, "operator invalid");
+				goto _error;
+		}
 
-	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
-	arr_types_out = g_array_new(FALSE, FALSE, sizeof(JDBType));
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter_array, &iter_function, error)))
+		{
+			goto _error;
+		}
 
-	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
-	{
-		goto _error;
-	}
+		// COUNT does not require a field
+		if (j_bson_iter_find(&iter_function, "_field", NULL))
+		{
+			if (G_UNLIKELY(!j_bson_iter_value(&iter_function, J_DB_TYPE_STRING, &value, error)))
+			{
+				goto _error;
+			}
 
-	variables_index = g_hash_table_new_full(g_direct_hash, NULL, NULL, g_free);
-	g_string_append(sql, "SELECT ");
-	variables_count = 0;
+			field = value.val_string;
 
-	if (!(schema_cache = getCacheSchema(backend_data, batch, name, error)))
-	{
-		goto _error;
-	}
+			if (!g_hash_table_contains(schema_cache, field))
+			{
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+				goto _error;
+			}
+		}
 
-	g_hash_table_iter_init(&schema_iter, schema_cache);
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter_array, &iter_function, error)))
+		{
+			goto _error;
+		}
 
-	g_string_append(sql, "_id");
-	g_hash_table_insert(variables_index, GINT_TO_POINTER(variables_count), g_strdup("_id"));
-	type = J_DB_TYPE_UINT32;
-	g_array_append_val(arr_types_out, type);
-	variables_count++;
+		if (G_UNLIKELY(!j_bson_iter_find(&iter_function, "_type", error) || !j_bson_iter_value(&iter_function, J_DB_TYPE_UINT32, &value, error)))
+		{
+			goto _error;
+		}
 
-	while (g_hash_table_iter_next(&schema_iter, (gpointer*)&string_tmp, &type_tmp))
-	{
-		type = GPOINTER_TO_INT(type_tmp);
+		type = value.val_uint32;
 
-		if (strcmp(string_tmp, "_id") == 0)
-			continue;
+		if (field != NULL)
+		{
+			g_string_append_printf(sql, "%s%s(" SQL_QUOTE "%s" SQL_QUOTE ")", (variables_count > 0) ? ", " : "", function_sql, field);
+		}
+		else
+		{
+			g_string_append_printf(sql, "%s%s(*)", (variables_count > 0) ? ", " : "", function_sql);
+		}
 
-		g_string_append_printf(sql, ", " SQL_QUOTE "%s" SQL_QUOTE, string_tmp);
-		g_hash_table_insert(variables_index, GINT_TO_POINTER(variables_count), g_strdup(string_tmp));
+		g_hash_table_insert(variables_index, GINT_TO_POINTER(variables_count), g_strdup(result_name));
 		g_array_append_val(arr_types_out, type);
 		variables_count++;
 	}
@@ -2359,12 +4188,17 @@ backend_query(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 
 		variables_count2 = 0;
 
-		if (G_UNLIKELY(!build_selector_query(backend_data, &iter, sql, mode_child, &variables_count2, arr_types_in, schema_cache, error)))
+		if (G_UNLIKELY(!build_selector_query(backend_data, &iter, sql, mode_child, &variables_count2, arr_types_in, schema_cache, shapes, error)))
 		{
 			goto _error;
 		}
 	}
 
+	if (group->len > 0)
+	{
+		g_string_append_printf(sql, " GROUP BY %s ORDER BY %s", group->str, group->str);
+	}
+
 	prepared = getCachePrepared(backend_data, batch->namespace, name, sql->str, error);
 
 	if (G_UNLIKELY(!prepared))
@@ -2376,19 +4210,18 @@ backend_query(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 	{
 		prepared->sql = g_string_new(sql->str);
 		prepared->variables_index = variables_index;
+		prepared->variables_type = arr_types_out;
 		prepared->variables_count = variables_count;
+		variables_index = NULL;
+		arr_types_out = NULL;
 
-		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, prepared->sql->str, &prepared->stmt, arr_types_in, arr_types_out, error)))
+		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, prepared->sql->str, &prepared->stmt, arr_types_in, prepared->variables_type, error)))
 		{
 			goto _error;
 		}
+
 		prepared->initialized = TRUE;
 	}
-	else
-	{
-		g_hash_table_destroy(variables_index);
-		variables_index = NULL;
-	}
 
 	if (selector && j_bson_has_enough_keys(selector, 2, NULL))
 	{
@@ -2407,104 +4240,261 @@ backend_query(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 
 	*iterator = prepared;
 
-	if (sql)
+	g_string_free(sql, TRUE);
+
+	if (variables_index)
 	{
-		g_string_free(sql, TRUE);
-		sql = NULL;
+		g_hash_table_destroy(variables_index);
+	}
+
+	if (arr_types_out)
+	{
+		g_array_unref(arr_types_out);
 	}
 
 	return TRUE;
 
 _error:
-	if (sql)
-	{
-		g_string_free(sql, TRUE);
-		sql = NULL;
-	}
+	g_string_free(sql, TRUE);
 
 	if (variables_index)
 	{
 		g_hash_table_destroy(variables_index);
 	}
 
+	if (arr_types_out)
+	{
+		g_array_unref(arr_types_out);
+	}
+
 	return FALSE;
 }
 
+static gint
+advisor_compare_candidates(gconstpointer a, gconstpointer b)
+{
+	JSqlAdvisorCandidate const* candidate_a = *(JSqlAdvisorCandidate const* const*)a;
+	JSqlAdvisorCandidate const* candidate_b = *(JSqlAdvisorCandidate const* const*)b;
+
+	if (candidate_a->time != candidate_b->time)
+	{
+		return (candidate_a->time > candidate_b->time) ? -1 : 1;
+	}
+
+	return 0;
+}
+
 static gboolean
-backend_iterate(gpointer backend_data, gpointer _iterator, bson_t* metadata, GError** error)
+backend_advise_indexes(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* options, bson_t* advice, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	GHashTable* schema_cache = NULL;
-	const char* string_tmp;
-	guint i;
-	JSqlCacheSQLQueries* queries = NULL;
-	JDBTypeValue value;
-	JDBType type;
-	gboolean sql_found;
-	JSqlCacheSQLPrepared* prepared = _iterator;
-	gboolean found = FALSE;
+	JSqlBatch* batch = _batch;
 	JThreadVariables* thread_variables = NULL;
+	JSqlAdvisorSchema* schema;
+	JDBTypeValue value;
+	bson_iter_t iter;
+	gboolean create = FALSE;
+	g_autoptr(GPtrArray) candidates = NULL;
+	GHashTableIter candidates_iter;
+	gpointer candidate_value;
 
-	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	if (j_bson_iter_init(&iter, options, NULL) && j_bson_iter_find(&iter, "_create", NULL) && j_bson_iter_value(&iter, J_DB_TYPE_UINT32, &value, NULL))
 	{
-		goto _error;
+		create = value.val_uint32;
 	}
 
-	if (!(queries = _getCachePrepared(backend_data, prepared->namespace, prepared->name, error)))
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
 	{
 		goto _error;
 	}
 
-	if (!(schema_cache = queries->types))
+	candidates = g_ptr_array_new_with_free_func(advisor_candidate_free);
+
+	// Candidates are copied, so that the indexes can be created without holding the mutex
+	g_mutex_lock(&advisor_mutex);
+
+	schema = advisor_schema_get(batch->namespace, name);
+	g_hash_table_iter_init(&candidates_iter, schema->candidates);
+
+	while (g_hash_table_iter_next(&candidates_iter, NULL, &candidate_value))
 	{
-		goto _error;
+		JSqlAdvisorCandidate* candidate = candidate_value;
+		JSqlAdvisorCandidate* copy;
+
+		if (candidate->queries < SQL_ADVISOR_MIN_QUERIES || advisor_covered(schema, candidate))
+		{
+			continue;
+		}
+
+		copy = g_new(JSqlAdvisorCandidate, 1);
+		copy->fields = g_ptr_array_new_with_free_func(g_free);
+		copy->equal_count = candidate->equal_count;
+		copy->queries = candidate->queries;
+		copy->time = candidate->time;
+
+		for (guint i = 0; i < candidate->fields->len; i++)
+		{
+			g_ptr_array_add(copy->fields, g_strdup(g_ptr_array_index(candidate->fields, i)));
+		}
+
+		g_ptr_array_add(candidates, copy);
 	}
 
-	if (G_UNLIKELY(!j_sql_step(thread_variables->sql_backend, prepared->stmt, &sql_found, error)))
+	g_mutex_unlock(&advisor_mutex);
+
+	g_ptr_array_sort(candidates, advisor_compare_candidates);
+
+	if (create && candidates->len > 0)
 	{
-		goto _error;
+		if (G_UNLIKELY(!_backend_batch_execute(backend_data, batch, error)))
+		{
+			//no ddl in transaction - most databases wont support that - continue without any open transaction
+			goto _error;
+		}
 	}
 
-	if (sql_found)
+	for (guint i = 0; i < candidates->len; i++)
 	{
-		found = TRUE;
+		JSqlAdvisorCandidate* candidate = g_ptr_array_index(candidates, i);
+		g_autoptr(GString) sql = NULL;
+		bson_t document[1];
+		bson_t fields[1];
+		gboolean created = FALSE;
+		gchar key[16];
+		gchar const* key_tmp;
 
-		for (i = 0; i < prepared->variables_count; i++)
+		if (create)
 		{
-			string_tmp = g_hash_table_lookup(prepared->variables_index, GINT_TO_POINTER(i));
-			type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
+			g_autoptr(GString) index_name = NULL;
+			g_autoptr(GError) create_error = NULL;
+			GPtrArray* index_fields;
 
-			if (G_UNLIKELY(!j_sql_column(thread_variables->sql_backend, prepared->stmt, i, type, &value, error)))
+			index_name = g_string_new(NULL);
+			sql = g_string_new(NULL);
+
+			for (guint j = 0; j < candidate->fields->len; j++)
 			{
-				goto _error;
+				g_string_append_printf(index_name, "%s%s", (j > 0) ? "," : "", (gchar const*)g_ptr_array_index(candidate->fields, j));
 			}
 
-			if (G_UNLIKELY(!j_bson_append_value(metadata, string_tmp, type, &value, error)))
+			g_string_append_printf(sql, "CREATE INDEX " SQL_QUOTE "%s_%s_advised_%08x" SQL_QUOTE " ON " SQL_QUOTE "%s_%s" SQL_QUOTE " ( ", batch->namespace, name, g_str_hash(index_name->str), batch->namespace, name);
+
+			for (guint j = 0; j < candidate->fields->len; j++)
 			{
-				goto _error;
+				g_string_append_printf(sql, "%s" SQL_QUOTE "%s" SQL_QUOTE, (j > 0) ? ", " : "", (gchar const*)g_ptr_array_index(candidate->fields, j));
+			}
+
+			g_string_append(sql, " )");
+
+			// The index usually exists already if this fails, for example, because it has been created before the server was restarted
+			created = j_sql_exec(thread_variables->sql_backend, sql->str, &create_error);
+
+			index_fields = g_ptr_array_new_with_free_func(g_free);
+
+			for (guint j = 0; j < candidate->fields->len; j++)
+			{
+				g_ptr_array_add(index_fields, g_strdup(g_ptr_array_index(candidate->fields, j)));
+			}
+
+			advisor_add_index(batch->namespace, name, index_fields);
+		}
+
+		j_bson_array_generate_key(i, &key_tmp, key, sizeof(key), NULL);
+
+		if (G_UNLIKELY(!j_bson_append_document_begin(advice, key_tmp, document, error)))
+		{
+			goto _error_create;
+		}
+
+		if (G_UNLIKELY(!j_bson_append_array_begin(document, "_index", fields, error)))
+		{
+			goto _error_create;
+		}
+
+		for (guint j = 0; j < candidate->fields->len; j++)
+		{
+			gchar field_key[16];
+			gchar const* field_key_tmp;
+
+			j_bson_array_generate_key(j, &field_key_tmp, field_key, sizeof(field_key), NULL);
+			value.val_string = g_ptr_array_index(candidate->fields, j);
+
+			if (G_UNLIKELY(!j_bson_append_value(fields, field_key_tmp, J_DB_TYPE_STRING, &value, error)))
+			{
+				goto _error_create;
 			}
 		}
+
+		if (G_UNLIKELY(!j_bson_append_array_end(document, fields, error)))
+		{
+			goto _error_create;
+		}
+
+		value.val_uint64 = candidate->queries;
+
+		if (G_UNLIKELY(!j_bson_append_value(document, "_queries", J_DB_TYPE_UINT64, &value, error)))
+		{
+			goto _error_create;
+		}
+
+		value.val_uint64 = candidate->time;
+
+		if (G_UNLIKELY(!j_bson_append_value(document, "_time", J_DB_TYPE_UINT64, &value, error)))
+		{
+			goto _error_create;
+		}
+
+		value.val_uint32 = created;
+
+		if (G_UNLIKELY(!j_bson_append_value(document, "_created", J_DB_TYPE_UINT32, &value, error)))
+		{
+			goto _error_create;
+		}
+
+		if (G_UNLIKELY(!j_bson_append_document_end(advice, document, error)))
+		{
+			goto _error_create;
+		}
 	}
 
-	if (!found)
+	if (create && candidates->len > 0)
 	{
-		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
-		goto _error;
+		if (G_UNLIKELY(!_backend_batch_start(backend_data, batch, error)))
+		{
+			goto _error;
+		}
 	}
 
 	return TRUE;
 
-_error:
-	if (G_UNLIKELY(!j_sql_reset(thread_variables->sql_backend, prepared->stmt, NULL)))
+_error_create:
+	if (create && candidates->len > 0)
 	{
-		goto _error3;
+		_backend_batch_start(backend_data, batch, NULL);
 	}
 
+_error:
 	return FALSE;
+}
 
-_error3:
-	/*something failed very hard*/
-	return FALSE;
+static void
+backend_iterator_free(gpointer backend_data, gpointer _iterator)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JSqlCacheSQLPrepared* prepared = _iterator;
+	JThreadVariables* thread_variables = NULL;
+
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, NULL))))
+	{
+		return;
+	}
+
+	// The prepared statement is cached, resetting it makes it available for the next query
+	j_sql_reset(thread_variables->sql_backend, prepared->stmt, NULL);
 }
 #endif
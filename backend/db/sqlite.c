@@ -29,28 +29,68 @@
 #include "jbson.c"
 
 /*
- * sqlite supports multithread, but only for concurrent read. concurrent write requires manual retrys
- * to remove errors due to concurrent access.
- * if SQL_MODE is defined as SQL_MODE_SINGLE_THREAD, the sqlite-generic code uses a global lock to prevent concurrency errors.
- * otherwise there is no lock
+ * sqlite supports multithread, but the shared cache used for in-memory databases reports table lock errors
+ * instead of waiting for concurrent writers.
+ * if j_sql_mode returns SQL_MODE_SINGLE_THREAD, the sqlite-generic code uses a global lock to prevent concurrency errors.
+ * otherwise there is no lock and file databases rely on the busy timeout instead.
  */
 #define SQL_MODE_SINGLE_THREAD 0
 #define SQL_MODE_MULTI_THREAD 1
-#define SQL_MODE SQL_MODE_SINGLE_THREAD
+
+/**
+ * How long a connection waits for the write lock held by another thread's connection, in milliseconds.
+ **/
+#define J_SQLITE_BUSY_TIMEOUT 10000
 
 #define SQL_AUTOINCREMENT_STRING " "
 #define SQL_UINT64_TYPE " UNSIGNED BIGINT "
 #define SQL_LAST_INSERT_ID_STRING " SELECT last_insert_rowid() "
 #define SQL_QUOTE "\""
 
+// Multi-row inserts need RETURNING to determine the ids of the inserted rows
+#if SQLITE_VERSION_NUMBER >= 3035000
+#define SQL_INSERT_RETURNING_STRING " RETURNING _id "
+#endif
+
+// Older SQLite versions limit statements to 999 variables
+#define SQL_INSERT_MAX_VARIABLES 999
+
 struct JSQLiteData
 {
 	gchar* path;
 	sqlite3* db;
+
+	/**
+	 * Whether path is a directory containing one database file per namespace.
+	 **/
+	gboolean per_namespace;
+
+	/**
+	 * The journal mode (WAL by default).
+	 **/
+	gchar const* journal_mode;
+
+	/**
+	 * The synchronous level.
+	 **/
+	gchar const* synchronous;
+
+	/**
+	 * The mmap size in bytes, 0 disables memory mapping.
+	 **/
+	guint64 mmap_size;
+
+	/**
+	 * The page cache size in KiB, 0 keeps SQLite's default.
+	 **/
+	guint64 cache_size;
 };
 
 typedef struct JSQLiteData JSQLiteData;
 
+static gchar const* const sqlite_journal_modes[] = { "DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF", NULL };
+static gchar const* const sqlite_synchronous_levels[] = { "OFF", "NORMAL", "FULL", "EXTRA", NULL };
+
 static gboolean
 j_sql_finalize(sqlite3* backend_db, void* _stmt, GError** error)
 {
@@ -358,26 +398,151 @@ _error2:
 	return FALSE;
 }
 
+static gboolean
+j_sql_changes(sqlite3* backend_db, void* _stmt, guint64* changes, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	(void)_stmt;
+	(void)error;
+
+	*changes = sqlite3_changes(backend_db);
+
+	return TRUE;
+}
+
+/**
+ * Looks up a value in a NULL-terminated list of allowed values, ignoring case.
+ *
+ * \param values The allowed values.
+ * \param value  The value.
+ *
+ * \return The matching allowed value, or NULL.
+ **/
+static gchar const*
+j_sql_lookup_value(gchar const* const* values, gchar const* value)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	for (guint i = 0; values[i] != NULL; i++)
+	{
+		if (g_ascii_strcasecmp(values[i], value) == 0)
+		{
+			return values[i];
+		}
+	}
+
+	return NULL;
+}
+
+static guint
+j_sql_mode(gpointer backend_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JSQLiteData* bd = backend_data;
+
+	// Only the shared cache of the in-memory database needs to be protected by the global lock
+	return (bd->db != NULL) ? SQL_MODE_SINGLE_THREAD : SQL_MODE_MULTI_THREAD;
+}
+
+static gboolean
+j_sql_per_namespace(gpointer backend_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JSQLiteData* bd = backend_data;
+
+	return bd->per_namespace;
+}
+
+static guint
+j_sql_max_connections(gpointer backend_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	(void)backend_data;
+
+	return 0;
+}
+
 static void*
-j_sql_open(gpointer backend_data)
+j_sql_open(gpointer backend_data, gchar const* namespace)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JSQLiteData* bd = backend_data;
 
 	sqlite3* backend_db = NULL;
+	g_autofree gchar* path = NULL;
 	g_autofree gchar* dirname = NULL;
+	g_autofree gchar* sql = NULL;
 
 	g_return_val_if_fail(bd->path != NULL, FALSE);
 
 	if (g_strcmp0(bd->path, ":memory:") != 0)
 	{
-		dirname = g_path_get_dirname(bd->path);
+		if (bd->per_namespace)
+		{
+			g_autofree gchar* escaped = NULL;
+			g_autofree gchar* basename = NULL;
+
+			g_return_val_if_fail(namespace != NULL, NULL);
+
+			// Namespaces might contain slashes
+			escaped = g_uri_escape_string(namespace, NULL, FALSE);
+			basename = g_strconcat(escaped, ".db", NULL);
+			path = g_build_filename(bd->path, basename, NULL);
+		}
+		else
+		{
+			path = g_strdup(bd->path);
+		}
+
+		dirname = g_path_get_dirname(path);
 		g_mkdir_with_parents(dirname, 0700);
-		if (G_UNLIKELY(sqlite3_open(bd->path, &backend_db) != SQLITE_OK))
+
+		if (G_UNLIKELY(sqlite3_open(path, &backend_db) != SQLITE_OK))
+		{
+			goto _error;
+		}
+
+		sqlite3_busy_timeout(backend_db, J_SQLITE_BUSY_TIMEOUT);
+
+		sql = g_strdup_printf("PRAGMA journal_mode = %s", bd->journal_mode);
+
+		if (G_UNLIKELY(!j_sql_exec(backend_db, sql, NULL)))
 		{
 			goto _error;
 		}
+
+		g_free(sql);
+		sql = g_strdup_printf("PRAGMA synchronous = %s", bd->synchronous);
+
+		if (G_UNLIKELY(!j_sql_exec(backend_db, sql, NULL)))
+		{
+			goto _error;
+		}
+
+		g_free(sql);
+		sql = g_strdup_printf("PRAGMA mmap_size = %" G_GUINT64_FORMAT, bd->mmap_size);
+
+		if (G_UNLIKELY(!j_sql_exec(backend_db, sql, NULL)))
+		{
+			goto _error;
+		}
+
+		if (bd->cache_size > 0)
+		{
+			g_free(sql);
+			// Negative values specify the size in KiB instead of pages
+			sql = g_strdup_printf("PRAGMA cache_size = -%" G_GUINT64_FORMAT, bd->cache_size);
+
+			if (G_UNLIKELY(!j_sql_exec(backend_db, sql, NULL)))
+			{
+				goto _error;
+			}
+		}
 	}
 	else
 	{
@@ -388,6 +553,7 @@ j_sql_open(gpointer backend_data)
 			goto _error;
 		}
 	}
+
 	if (G_UNLIKELY(!j_sql_exec(backend_db, "PRAGMA foreign_keys = ON", NULL)))
 	{
 		goto _error;
@@ -414,7 +580,8 @@ j_sql_start_transaction(sqlite3* backend_db, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	return j_sql_exec(backend_db, "BEGIN TRANSACTION", error);
+	// Take the write lock up front, upgrading a read transaction does not wait for concurrent writers
+	return j_sql_exec(backend_db, "BEGIN IMMEDIATE TRANSACTION", error);
 }
 
 static gboolean
@@ -441,10 +608,72 @@ backend_init(gchar const* _path, gpointer* backend_data)
 	J_TRACE_FUNCTION(NULL);
 
 	JSQLiteData* bd;
+	g_auto(GStrv) split = NULL;
+
+	g_return_val_if_fail(_path != NULL, FALSE);
 
 	bd = g_slice_new(JSQLiteData);
-	bd->path = g_strdup(_path);
 	bd->db = NULL;
+	bd->per_namespace = FALSE;
+	bd->journal_mode = "WAL";
+	bd->synchronous = "FULL";
+	bd->mmap_size = 0;
+	bd->cache_size = 0;
+
+	if (g_strcmp0(_path, ":memory:") == 0)
+	{
+		bd->path = g_strdup(_path);
+	}
+	else
+	{
+		split = g_strsplit(_path, ":", 0);
+		bd->path = g_strdup(split[0]);
+
+		for (guint i = 1; split[i] != NULL; i++)
+		{
+			gchar const* value;
+
+			if (g_strcmp0(split[i], "per-namespace") == 0)
+			{
+				bd->per_namespace = TRUE;
+				continue;
+			}
+
+			if ((value = strchr(split[i], '=')) == NULL)
+			{
+				goto _error;
+			}
+
+			value++;
+
+			if (g_str_has_prefix(split[i], "journal-mode="))
+			{
+				if ((bd->journal_mode = j_sql_lookup_value(sqlite_journal_modes, value)) == NULL)
+				{
+					goto _error;
+				}
+			}
+			else if (g_str_has_prefix(split[i], "synchronous="))
+			{
+				if ((bd->synchronous = j_sql_lookup_value(sqlite_synchronous_levels, value)) == NULL)
+				{
+					goto _error;
+				}
+			}
+			else if (g_str_has_prefix(split[i], "mmap-size="))
+			{
+				bd->mmap_size = g_ascii_strtoull(value, NULL, 10) * 1024 * 1024;
+			}
+			else if (g_str_has_prefix(split[i], "cache-size="))
+			{
+				bd->cache_size = g_ascii_strtoull(value, NULL, 10) * 1024;
+			}
+			else
+			{
+				goto _error;
+			}
+		}
+	}
 
 	if (g_strcmp0(bd->path, ":memory:") == 0)
 	{
@@ -457,6 +686,12 @@ backend_init(gchar const* _path, gpointer* backend_data)
 	sql_generic_init();
 
 	return TRUE;
+
+_error:
+	g_free(bd->path);
+	g_slice_free(JSQLiteData, bd);
+
+	return FALSE;
 }
 
 static void
@@ -487,12 +722,18 @@ static JBackend sqlite_backend = {
 		.backend_schema_get = backend_schema_get,
 		.backend_schema_delete = backend_schema_delete,
 		.backend_insert = backend_insert,
+		.backend_insert_multi = backend_insert_multi,
 		.backend_update = backend_update,
 		.backend_delete = backend_delete,
 		.backend_query = backend_query,
+		.backend_query_fields = backend_query_fields,
 		.backend_iterate = backend_iterate,
+		.backend_iterator_free = backend_iterator_free,
+		.backend_aggregate = backend_aggregate,
+		.backend_advise_indexes = backend_advise_indexes,
 		.backend_batch_start = backend_batch_start,
 		.backend_batch_execute = backend_batch_execute,
+		.backend_batch_abort = backend_batch_abort,
 	},
 };
 
@@ -21,6 +21,8 @@
 #include <glib.h>
 #include <gmodule.h>
 
+#include <string.h>
+
 #include <leveldb/c.h>
 
 #include <julea.h>
@@ -41,15 +43,66 @@ struct JLevelDBData
 	leveldb_readoptions_t* read_options;
 	leveldb_writeoptions_t* write_options;
 	leveldb_writeoptions_t* write_options_sync;
+
+	/**
+	 * Serializes compare-and-swap and add, which are not isolated by write batches.
+	 **/
+	GMutex atomic_mutex;
 };
 
 typedef struct JLevelDBData JLevelDBData;
 
+/**
+ * The state used to take a key's pending changes out of a write batch.
+ **/
+struct JLevelDBPending
+{
+	gchar const* key;
+	gsize key_len;
+
+	/**
+	 * The write batch without the key's changes.
+	 **/
+	leveldb_writebatch_t* rest;
+
+	gboolean found;
+
+	/**
+	 * The key's last pending value, NULL if it has been deleted.
+	 **/
+	gchar* value;
+	gsize len;
+};
+
+typedef struct JLevelDBPending JLevelDBPending;
+
 struct JLevelDBIterator
 {
 	leveldb_iterator_t* iterator;
 	gboolean first;
 	gchar* prefix;
+
+	/**
+	 * The key to start at, NULL to start at the prefix.
+	 **/
+	gchar* seek;
+
+	/**
+	 * The key to stop before, NULL to stop at the end of the prefix.
+	 **/
+	gchar* end;
+
+	/**
+	 * Whether keys are returned in descending order, starting before end.
+	 **/
+	gboolean reverse;
+
+	/**
+	 * The maximum number of pairs, 0 for no limit.
+	 **/
+	guint32 limit;
+	guint32 count;
+
 	gsize namespace_len;
 };
 
@@ -103,6 +156,24 @@ backend_batch_execute(gpointer backend_data, gpointer backend_batch)
 	return (leveldb_error == NULL);
 }
 
+static gboolean
+backend_batch_abort(gpointer backend_data, gpointer backend_batch)
+{
+	JLevelDBBatch* batch = backend_batch;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+
+	// Nothing has been written yet, dropping the write batch discards all changes.
+	j_semantics_unref(batch->semantics);
+	g_free(batch->namespace);
+	leveldb_writebatch_destroy(batch->batch);
+	g_slice_free(JLevelDBBatch, batch);
+
+	return TRUE;
+}
+
 static gboolean
 backend_put(gpointer backend_data, gpointer backend_batch, gchar const* key, gconstpointer value, guint32 len)
 {
@@ -168,6 +239,342 @@ backend_get(gpointer backend_data, gpointer backend_batch, gchar const* key, gpo
 	return (result != NULL);
 }
 
+static void
+backend_pending_put(void* state, gchar const* key, gsize key_len, gchar const* value, gsize len)
+{
+	JLevelDBPending* pending = state;
+
+	if (key_len != pending->key_len || memcmp(key, pending->key, key_len) != 0)
+	{
+		leveldb_writebatch_put(pending->rest, key, key_len, value, len);
+		return;
+	}
+
+	g_free(pending->value);
+
+	pending->found = TRUE;
+#if GLIB_CHECK_VERSION(2, 68, 0)
+	pending->value = g_memdup2(value, len);
+#else
+	pending->value = g_memdup(value, len);
+#endif
+	pending->len = len;
+}
+
+static void
+backend_pending_delete(void* state, gchar const* key, gsize key_len)
+{
+	JLevelDBPending* pending = state;
+
+	if (key_len != pending->key_len || memcmp(key, pending->key, key_len) != 0)
+	{
+		leveldb_writebatch_delete(pending->rest, key, key_len);
+		return;
+	}
+
+	g_clear_pointer(&(pending->value), g_free);
+
+	pending->found = TRUE;
+	pending->len = 0;
+}
+
+/**
+ * Reads a key's current value for compare-and-swap and add, taking the batch's own changes into account.
+ * The key's pending changes are removed from the batch, the caller has to write the resulting value or restore them.
+ * Has to be called with the atomic mutex held.
+ *
+ * \private
+ *
+ * \param bd      The backend data.
+ * \param batch   A batch.
+ * \param key     A namespaced key.
+ * \param pending Returns whether the value comes from the batch.
+ * \param exists  Returns whether the key exists.
+ * \param value   Returns the value, to be freed with g_free().
+ * \param len     Returns the value's length.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+backend_get_current(JLevelDBData* bd, JLevelDBBatch* batch, gchar const* key, gboolean* pending, gboolean* exists, gpointer* value, gsize* len)
+{
+	g_autofree gchar* leveldb_error = NULL;
+	JLevelDBPending state;
+
+	state.key = key;
+	state.key_len = strlen(key) + 1;
+	state.rest = leveldb_writebatch_create();
+	state.found = FALSE;
+	state.value = NULL;
+	state.len = 0;
+
+	// Write batches can not be queried, so they are rebuilt without the key
+	leveldb_writebatch_iterate(batch->batch, &state, backend_pending_put, backend_pending_delete);
+
+	*pending = state.found;
+
+	if (state.found)
+	{
+		leveldb_writebatch_destroy(batch->batch);
+		batch->batch = state.rest;
+
+		*exists = (state.value != NULL);
+		*value = state.value;
+		*len = state.len;
+
+		return TRUE;
+	}
+
+	leveldb_writebatch_destroy(state.rest);
+
+	*value = leveldb_get(bd->db, bd->read_options, key, strlen(key) + 1, len, &leveldb_error);
+	*exists = (*value != NULL);
+
+	return (leveldb_error == NULL);
+}
+
+/**
+ * Adds a key's change taken out by backend_get_current() back to the batch.
+ *
+ * \private
+ *
+ * \param batch A batch.
+ * \param key   A namespaced key.
+ * \param value A value, NULL if the key has been deleted.
+ * \param len   The value's length.
+ **/
+static void
+backend_restore_pending(JLevelDBBatch* batch, gchar const* key, gconstpointer value, gsize len)
+{
+	if (value != NULL)
+	{
+		leveldb_writebatch_put(batch->batch, key, strlen(key) + 1, value, len);
+	}
+	else
+	{
+		leveldb_writebatch_delete(batch->batch, key, strlen(key) + 1);
+	}
+}
+
+/**
+ * Writes a value directly instead of adding it to the batch.
+ * Write batches are not visible to reads before they are executed, so compare-and-swap and add have to apply their changes immediately.
+ *
+ * \private
+ *
+ * \param bd    The backend data.
+ * \param batch A batch.
+ * \param key   A namespaced key.
+ * \param value A value.
+ * \param len   The value's length.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+backend_put_now(JLevelDBData* bd, JLevelDBBatch* batch, gchar const* key, gconstpointer value, gsize len)
+{
+	g_autofree gchar* leveldb_error = NULL;
+
+	leveldb_writeoptions_t* write_options = bd->write_options;
+
+	if (j_semantics_get(batch->semantics, J_SEMANTICS_SAFETY) == J_SEMANTICS_SAFETY_STORAGE)
+	{
+		write_options = bd->write_options_sync;
+	}
+
+	leveldb_put(bd->db, write_options, key, strlen(key) + 1, value, len, &leveldb_error);
+
+	return (leveldb_error == NULL);
+}
+
+static gboolean
+backend_compare_and_swap(gpointer backend_data, gpointer backend_batch, gchar const* key, gconstpointer expected, guint32 expected_len, gconstpointer value, guint32 len, gboolean* swapped)
+{
+	JLevelDBBatch* batch = backend_batch;
+	JLevelDBData* bd = backend_data;
+	g_autoptr(GMutexLocker) locker = NULL;
+	g_autofree gchar* nskey = NULL;
+	g_autofree gpointer current = NULL;
+	gsize current_len = 0;
+	gboolean pending;
+	gboolean exists;
+	gboolean match;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+	g_return_val_if_fail(swapped != NULL, FALSE);
+
+	*swapped = FALSE;
+
+	nskey = g_strdup_printf("%s:%s", batch->namespace, key);
+
+	locker = g_mutex_locker_new(&(bd->atomic_mutex));
+
+	if (!backend_get_current(bd, batch, nskey, &pending, &exists, &current, &current_len))
+	{
+		return FALSE;
+	}
+
+	if (expected == NULL)
+	{
+		match = !exists;
+	}
+	else
+	{
+		match = (exists && current_len == expected_len && memcmp(current, expected, expected_len) == 0);
+	}
+
+	if (!match)
+	{
+		if (pending)
+		{
+			backend_restore_pending(batch, nskey, current, current_len);
+		}
+
+		return TRUE;
+	}
+
+	*swapped = backend_put_now(bd, batch, nskey, value, len);
+
+	return *swapped;
+}
+
+static gboolean
+backend_add(gpointer backend_data, gpointer backend_batch, gchar const* key, gint64 delta, gint64* result)
+{
+	JLevelDBBatch* batch = backend_batch;
+	JLevelDBData* bd = backend_data;
+	g_autoptr(GMutexLocker) locker = NULL;
+	g_autofree gchar* nskey = NULL;
+	g_autofree gpointer current = NULL;
+	gsize current_len = 0;
+	gboolean pending;
+	gboolean exists;
+	gint64 sum = 0;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(result != NULL, FALSE);
+
+	nskey = g_strdup_printf("%s:%s", batch->namespace, key);
+
+	locker = g_mutex_locker_new(&(bd->atomic_mutex));
+
+	if (!backend_get_current(bd, batch, nskey, &pending, &exists, &current, &current_len))
+	{
+		return FALSE;
+	}
+
+	if (exists)
+	{
+		if (current_len != sizeof(sum))
+		{
+			if (pending)
+			{
+				backend_restore_pending(batch, nskey, current, current_len);
+			}
+
+			return FALSE;
+		}
+
+		memcpy(&sum, current, sizeof(sum));
+		sum = GINT64_FROM_LE(sum);
+	}
+
+	*result = sum + delta;
+	sum = GINT64_TO_LE(*result);
+
+	return backend_put_now(bd, batch, nskey, &sum, sizeof(sum));
+}
+
+/**
+ * Compares two namespaced keys like LevelDB's default bytewise comparator.
+ **/
+static gint
+backend_key_compare(gconstpointer a, gconstpointer b, gpointer data)
+{
+	gchar** nskeys = data;
+
+	// Keys are stored including their terminating null byte, which sorts before all other characters
+	return strcmp(nskeys[*(guint32 const*)a], nskeys[*(guint32 const*)b]);
+}
+
+/**
+ * Looks up multiple keys with a single iterator.
+ * The keys are visited in sorted order so that lookups sweep forward through the database,
+ * reusing blocks that have already been loaded.
+ **/
+static gboolean
+backend_get_multi(gpointer backend_data, gpointer backend_batch, gchar const** keys, guint32 count, gpointer* values, guint32* lens)
+{
+	JLevelDBBatch* batch = backend_batch;
+	JLevelDBData* bd = backend_data;
+	g_autofree gchar** nskeys = NULL;
+	g_autofree guint32* order = NULL;
+	leveldb_iterator_t* it;
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(keys != NULL, FALSE);
+	g_return_val_if_fail(values != NULL, FALSE);
+	g_return_val_if_fail(lens != NULL, FALSE);
+
+	nskeys = g_new(gchar*, count);
+	order = g_new(guint32, count);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		nskeys[i] = g_strdup_printf("%s:%s", batch->namespace, keys[i]);
+		order[i] = i;
+		values[i] = NULL;
+		lens[i] = 0;
+	}
+
+	g_qsort_with_data(order, count, sizeof(guint32), backend_key_compare, nskeys);
+
+	it = leveldb_create_iterator(bd->db, bd->read_options);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		guint32 index = order[i];
+		gchar const* nskey = nskeys[index];
+		gsize nskey_len = strlen(nskey) + 1;
+
+		leveldb_iter_seek(it, nskey, nskey_len);
+
+		if (leveldb_iter_valid(it))
+		{
+			gchar const* key_;
+			gsize key_len;
+
+			key_ = leveldb_iter_key(it, &key_len);
+
+			if (key_len == nskey_len && memcmp(key_, nskey, nskey_len) == 0)
+			{
+				gchar const* value;
+				gsize value_len;
+
+				value = leveldb_iter_value(it, &value_len);
+
+				// g_memdup2() returns NULL for empty values, which would mark the key as missing
+				values[index] = g_malloc(MAX(value_len, 1));
+				memcpy(values[index], value, value_len);
+				lens[index] = value_len;
+			}
+		}
+	}
+
+	leveldb_iter_destroy(it);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		g_free(nskeys[i]);
+	}
+
+	return ret;
+}
+
 static gboolean
 backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend_iterator)
 {
@@ -185,6 +592,11 @@ backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend
 		iterator = g_slice_new(JLevelDBIterator);
 		iterator->iterator = it;
 		iterator->first = TRUE;
+		iterator->seek = NULL;
+		iterator->end = NULL;
+		iterator->reverse = FALSE;
+		iterator->limit = 0;
+		iterator->count = 0;
 		iterator->prefix = g_strdup_printf("%s:", namespace);
 		iterator->namespace_len = strlen(namespace) + 1;
 
@@ -212,6 +624,11 @@ backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const
 		iterator = g_slice_new(JLevelDBIterator);
 		iterator->iterator = it;
 		iterator->first = TRUE;
+		iterator->seek = NULL;
+		iterator->end = NULL;
+		iterator->reverse = FALSE;
+		iterator->limit = 0;
+		iterator->count = 0;
 		iterator->prefix = g_strdup_printf("%s:%s", namespace, prefix);
 		iterator->namespace_len = strlen(namespace) + 1;
 
@@ -221,6 +638,75 @@ backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const
 	return (iterator != NULL);
 }
 
+static gboolean
+backend_get_range(gpointer backend_data, gchar const* namespace, gchar const* start, gchar const* end, gboolean reverse, guint32 limit, gpointer* backend_iterator)
+{
+	JLevelDBData* bd = backend_data;
+	JLevelDBIterator* iterator = NULL;
+	leveldb_iterator_t* it;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+
+	it = leveldb_create_iterator(bd->db, bd->read_options);
+
+	if (it != NULL)
+	{
+		iterator = g_slice_new(JLevelDBIterator);
+		iterator->iterator = it;
+		iterator->first = TRUE;
+		iterator->seek = (start != NULL) ? g_strdup_printf("%s:%s", namespace, start) : NULL;
+		iterator->end = (end != NULL) ? g_strdup_printf("%s:%s", namespace, end) : NULL;
+		iterator->reverse = reverse;
+		iterator->limit = limit;
+		iterator->count = 0;
+		iterator->prefix = g_strdup_printf("%s:", namespace);
+		iterator->namespace_len = strlen(namespace) + 1;
+
+		*backend_iterator = iterator;
+	}
+
+	return (iterator != NULL);
+}
+
+static void
+backend_iterator_free(gpointer backend_data, gpointer backend_iterator)
+{
+	JLevelDBIterator* iterator = backend_iterator;
+
+	(void)backend_data;
+
+	g_free(iterator->prefix);
+	g_free(iterator->seek);
+	g_free(iterator->end);
+	leveldb_iter_destroy(iterator->iterator);
+	g_slice_free(JLevelDBIterator, iterator);
+}
+
+static gboolean
+backend_seek(gpointer backend_data, gpointer backend_iterator, gchar const* key)
+{
+	JLevelDBIterator* iterator = backend_iterator;
+	g_autofree gchar* nskey = NULL;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(iterator->first, FALSE);
+
+	nskey = g_strdup_printf("%.*s%s", (gint)iterator->namespace_len, iterator->prefix, key);
+
+	// Keys before the prefix would end the iteration immediately
+	if (strcmp(nskey, iterator->prefix) > 0)
+	{
+		g_free(iterator->seek);
+		iterator->seek = g_steal_pointer(&nskey);
+	}
+
+	return TRUE;
+}
+
 static gboolean
 backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const** key, gconstpointer* value, guint32* len)
 {
@@ -232,11 +718,41 @@ backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const**
 	g_return_val_if_fail(value != NULL, FALSE);
 	g_return_val_if_fail(len != NULL, FALSE);
 
-	if (iterator->first)
+	if (iterator->limit > 0 && iterator->count == iterator->limit)
+	{
+		goto out;
+	}
+
+	if (iterator->first && iterator->reverse)
+	{
+		// Without an end key, the namespace's keys end before the separator's successor
+		g_autofree gchar* upper = (iterator->end != NULL) ? g_strdup(iterator->end) : g_strdup_printf("%.*s;", (gint)(iterator->namespace_len - 1), iterator->prefix);
+
+		// Start at the last key before the upper bound, or at the last key overall if there is none after it
+		leveldb_iter_seek(iterator->iterator, upper, strlen(upper));
+
+		if (leveldb_iter_valid(iterator->iterator))
+		{
+			leveldb_iter_prev(iterator->iterator);
+		}
+		else
+		{
+			leveldb_iter_seek_to_last(iterator->iterator);
+		}
+
+		iterator->first = FALSE;
+	}
+	else if (iterator->first)
 	{
-		leveldb_iter_seek(iterator->iterator, iterator->prefix, strlen(iterator->prefix));
+		gchar const* start = (iterator->seek != NULL) ? iterator->seek : iterator->prefix;
+
+		leveldb_iter_seek(iterator->iterator, start, strlen(start));
 		iterator->first = FALSE;
 	}
+	else if (iterator->reverse)
+	{
+		leveldb_iter_prev(iterator->iterator);
+	}
 	else
 	{
 		leveldb_iter_next(iterator->iterator);
@@ -254,6 +770,18 @@ backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const**
 			goto out;
 		}
 
+		if (iterator->reverse && iterator->seek != NULL && strcmp(key_, iterator->seek) < 0)
+		{
+			goto out;
+		}
+
+		if (!iterator->reverse && iterator->end != NULL && strcmp(key_, iterator->end) >= 0)
+		{
+			goto out;
+		}
+
+		iterator->count++;
+
 		*key = key_ + iterator->namespace_len;
 		*value = leveldb_iter_value(iterator->iterator, &tmp);
 		*len = tmp;
@@ -262,9 +790,7 @@ backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const**
 	}
 
 out:
-	g_free(iterator->prefix);
-	leveldb_iter_destroy(iterator->iterator);
-	g_slice_free(JLevelDBIterator, iterator);
+	backend_iterator_free(backend_data, iterator);
 
 	return FALSE;
 }
@@ -286,6 +812,7 @@ backend_init(gchar const* path, gpointer* backend_data)
 	bd->read_options = leveldb_readoptions_create();
 	bd->write_options = leveldb_writeoptions_create();
 	bd->write_options_sync = leveldb_writeoptions_create();
+	g_mutex_init(&(bd->atomic_mutex));
 	leveldb_writeoptions_set_sync(bd->write_options_sync, 1);
 
 	options = leveldb_options_create();
@@ -319,6 +846,7 @@ backend_fini(gpointer backend_data)
 	leveldb_readoptions_destroy(bd->read_options);
 	leveldb_writeoptions_destroy(bd->write_options);
 	leveldb_writeoptions_destroy(bd->write_options_sync);
+	g_mutex_clear(&(bd->atomic_mutex));
 
 	if (bd->db != NULL)
 	{
@@ -336,12 +864,19 @@ static JBackend leveldb_backend = {
 		.backend_fini = backend_fini,
 		.backend_batch_start = backend_batch_start,
 		.backend_batch_execute = backend_batch_execute,
+		.backend_batch_abort = backend_batch_abort,
 		.backend_put = backend_put,
 		.backend_delete = backend_delete,
 		.backend_get = backend_get,
+		.backend_get_multi = backend_get_multi,
+		.backend_compare_and_swap = backend_compare_and_swap,
+		.backend_add = backend_add,
 		.backend_get_all = backend_get_all,
 		.backend_get_by_prefix = backend_get_by_prefix,
-		.backend_iterate = backend_iterate }
+		.backend_get_range = backend_get_range,
+		.backend_iterate = backend_iterate,
+		.backend_seek = backend_seek,
+		.backend_iterator_free = backend_iterator_free }
 };
 
 G_MODULE_EXPORT
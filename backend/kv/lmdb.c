@@ -21,13 +21,31 @@
 #include <glib.h>
 #include <gmodule.h>
 
+#include <string.h>
+
 #include <lmdb.h>
 
 #include <julea.h>
 
 struct JLMDBBatch
 {
+	/**
+	 * The transaction, started on first use.
+	 */
 	MDB_txn* txn;
+	gboolean read_only;
+
+	/**
+	 * The values read while the transaction was read-only, NULL if nothing has been read.
+	 * Maps the namespaced keys to the values' hashes, NULL for missing keys.
+	 */
+	GHashTable* reads;
+
+	/**
+	 * Whether a value read by the batch has changed before it switched to a write transaction.
+	 */
+	gboolean conflict;
+
 	gchar* namespace;
 	JSemantics* semantics;
 };
@@ -38,42 +56,244 @@ struct JLMDBData
 {
 	MDB_env* env;
 	MDB_dbi dbi;
+
+	/**
+	 * Reset read-only transactions that can be renewed.
+	 * Contains MDB_txn elements.
+	 */
+	GAsyncQueue* readers;
 };
 
 typedef struct JLMDBData JLMDBData;
 
 struct JLMDBIterator
 {
+	JLMDBData* bd;
 	MDB_cursor* cursor;
 	MDB_txn* txn;
 	gboolean first;
 	gchar* prefix;
+
+	/**
+	 * The key to start at, NULL to start at the prefix.
+	 **/
+	gchar* seek;
+
+	/**
+	 * The key to stop before, NULL to stop at the end of the prefix.
+	 **/
+	gchar* end;
+
+	/**
+	 * Whether keys are returned in descending order, starting before end.
+	 **/
+	gboolean reverse;
+
+	/**
+	 * The maximum number of pairs, 0 for no limit.
+	 **/
+	guint32 limit;
+	guint32 count;
+
 	gsize namespace_len;
 };
 
 typedef struct JLMDBIterator JLMDBIterator;
 
+static MDB_txn*
+backend_reader_get(JLMDBData* bd)
+{
+	MDB_txn* txn;
+
+	// Renewing a reset transaction avoids allocating a new one and acquiring a reader slot.
+	while ((txn = g_async_queue_try_pop(bd->readers)) != NULL)
+	{
+		if (mdb_txn_renew(txn) == 0)
+		{
+			return txn;
+		}
+
+		mdb_txn_abort(txn);
+	}
+
+	if (mdb_txn_begin(bd->env, NULL, MDB_RDONLY, &txn) != 0)
+	{
+		return NULL;
+	}
+
+	return txn;
+}
+
+static void
+backend_reader_put(JLMDBData* bd, MDB_txn* txn)
+{
+	mdb_txn_reset(txn);
+	g_async_queue_push(bd->readers, txn);
+}
+
+static gpointer
+backend_batch_hash_value(MDB_val const* value)
+{
+	guint8* hash;
+
+	if (value == NULL)
+	{
+		return NULL;
+	}
+
+	hash = g_malloc(J_CHECKSUM_HASH_SIZE);
+	j_checksum_hash(value->mv_data, value->mv_size, hash);
+
+	return hash;
+}
+
+/**
+ * Remembers a value read within a read-only transaction, so it can be validated if the batch switches to a write transaction.
+ */
+static void
+backend_batch_record_read(JLMDBBatch* batch, MDB_val const* key, MDB_val const* value)
+{
+	if (!batch->read_only)
+	{
+		return;
+	}
+
+	if (batch->reads == NULL)
+	{
+		batch->reads = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+	}
+
+	// The first read determines the value the batch has seen
+	if (!g_hash_table_contains(batch->reads, key->mv_data))
+	{
+		g_hash_table_insert(batch->reads, g_strdup(key->mv_data), backend_batch_hash_value(value));
+	}
+}
+
+/**
+ * Checks whether the values read within the read-only transaction are still current.
+ *
+ * \return TRUE if none of them have changed, FALSE otherwise.
+ */
+static gboolean
+backend_batch_validate_reads(JLMDBData* bd, JLMDBBatch* batch, MDB_txn* txn)
+{
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+
+	if (batch->reads == NULL)
+	{
+		return TRUE;
+	}
+
+	g_hash_table_iter_init(&iter, batch->reads);
+
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		g_autofree gpointer hash = NULL;
+		MDB_val m_key;
+		MDB_val m_value;
+		gint ret;
+
+		m_key.mv_size = strlen(key) + 1;
+		m_key.mv_data = key;
+
+		ret = mdb_get(txn, bd->dbi, &m_key, &m_value);
+
+		if (ret != 0 && ret != MDB_NOTFOUND)
+		{
+			return FALSE;
+		}
+
+		hash = backend_batch_hash_value((ret == 0) ? &m_value : NULL);
+
+		if ((hash == NULL) != (value == NULL) || (hash != NULL && memcmp(hash, value, J_CHECKSUM_HASH_SIZE) != 0))
+		{
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+static MDB_txn*
+backend_batch_get_txn(JLMDBData* bd, JLMDBBatch* batch, gboolean write)
+{
+	gboolean upgrade = FALSE;
+
+	if (batch->conflict)
+	{
+		return NULL;
+	}
+
+	if (batch->txn != NULL && (!write || !batch->read_only))
+	{
+		return batch->txn;
+	}
+
+	if (batch->txn != NULL)
+	{
+		// The batch modifies data after all, switch to a write transaction.
+		backend_reader_put(bd, batch->txn);
+		batch->txn = NULL;
+		upgrade = TRUE;
+	}
+
+	if (write)
+	{
+		if (mdb_txn_begin(bd->env, NULL, 0, &(batch->txn)) != 0)
+		{
+			batch->txn = NULL;
+		}
+
+		batch->read_only = FALSE;
+
+		// Other batches might have changed the values read so far in between, which would break the batch's atomicity.
+		if (batch->txn != NULL && upgrade && !backend_batch_validate_reads(bd, batch, batch->txn))
+		{
+			mdb_txn_abort(batch->txn);
+			batch->txn = NULL;
+			batch->conflict = TRUE;
+		}
+
+		if (batch->reads != NULL)
+		{
+			g_hash_table_unref(batch->reads);
+			batch->reads = NULL;
+		}
+	}
+	else
+	{
+		batch->txn = backend_reader_get(bd);
+		batch->read_only = TRUE;
+	}
+
+	return batch->txn;
+}
+
 static gboolean
 backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* data)
 {
-	JLMDBData* bd = backend_data;
 	JLMDBBatch* batch = NULL;
-	MDB_txn* txn;
+
+	(void)backend_data;
 
 	g_return_val_if_fail(namespace != NULL, FALSE);
 	g_return_val_if_fail(data != NULL, FALSE);
 
-	if (mdb_txn_begin(bd->env, NULL, 0, &txn) == 0)
-	{
-		batch = g_slice_new(JLMDBBatch);
-		batch->txn = txn;
-		batch->namespace = g_strdup(namespace);
-		batch->semantics = j_semantics_ref(semantics);
-	}
+	// The transaction is only started by the first operation, as LMDB allows many readers but only a single writer.
+	batch = g_slice_new(JLMDBBatch);
+	batch->txn = NULL;
+	batch->read_only = TRUE;
+	batch->reads = NULL;
+	batch->conflict = FALSE;
+	batch->namespace = g_strdup(namespace);
+	batch->semantics = j_semantics_ref(semantics);
 
 	*data = batch;
 
-	return (batch != NULL);
+	return TRUE;
 }
 
 static gboolean
@@ -81,20 +301,35 @@ backend_batch_execute(gpointer backend_data, gpointer data)
 {
 	gboolean ret = FALSE;
 
+	JLMDBData* bd = backend_data;
 	JLMDBBatch* batch = data;
 
-	(void)backend_data;
-
 	g_return_val_if_fail(data != NULL, FALSE);
 
 	// FIXME do something with batch->semantics
 
-	if (mdb_txn_commit(batch->txn) == 0)
+	if (batch->conflict)
+	{
+		ret = FALSE;
+	}
+	else if (batch->txn == NULL)
+	{
+		ret = TRUE;
+	}
+	else if (batch->read_only)
+	{
+		backend_reader_put(bd, batch->txn);
+		ret = TRUE;
+	}
+	else if (mdb_txn_commit(batch->txn) == 0)
 	{
 		ret = TRUE;
 	}
 
-	// FIXME free txn
+	if (batch->reads != NULL)
+	{
+		g_hash_table_unref(batch->reads);
+	}
 
 	j_semantics_unref(batch->semantics);
 	g_free(batch->namespace);
@@ -103,11 +338,44 @@ backend_batch_execute(gpointer backend_data, gpointer data)
 	return ret;
 }
 
+static gboolean
+backend_batch_abort(gpointer backend_data, gpointer data)
+{
+	JLMDBData* bd = backend_data;
+	JLMDBBatch* batch = data;
+
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	if (batch->txn != NULL)
+	{
+		if (batch->read_only)
+		{
+			backend_reader_put(bd, batch->txn);
+		}
+		else
+		{
+			mdb_txn_abort(batch->txn);
+		}
+	}
+
+	if (batch->reads != NULL)
+	{
+		g_hash_table_unref(batch->reads);
+	}
+
+	j_semantics_unref(batch->semantics);
+	g_free(batch->namespace);
+	g_slice_free(JLMDBBatch, batch);
+
+	return TRUE;
+}
+
 static gboolean
 backend_put(gpointer backend_data, gpointer data, gchar const* key, gconstpointer value, guint32 len)
 {
 	JLMDBData* bd = backend_data;
 	JLMDBBatch* batch = data;
+	MDB_txn* txn;
 	MDB_val m_key;
 	MDB_val m_value;
 	g_autofree gchar* nskey = NULL;
@@ -123,7 +391,12 @@ backend_put(gpointer backend_data, gpointer data, gchar const* key, gconstpointe
 	m_value.mv_size = len;
 	m_value.mv_data = value;
 
-	return (mdb_put(batch->txn, bd->dbi, &m_key, &m_value, 0) == 0);
+	if ((txn = backend_batch_get_txn(bd, batch, TRUE)) == NULL)
+	{
+		return FALSE;
+	}
+
+	return (mdb_put(txn, bd->dbi, &m_key, &m_value, 0) == 0);
 }
 
 static gboolean
@@ -131,6 +404,7 @@ backend_delete(gpointer backend_data, gpointer data, gchar const* key)
 {
 	JLMDBData* bd = backend_data;
 	JLMDBBatch* batch = data;
+	MDB_txn* txn;
 	MDB_val m_key;
 	g_autofree gchar* nskey = NULL;
 
@@ -142,7 +416,12 @@ backend_delete(gpointer backend_data, gpointer data, gchar const* key)
 	m_key.mv_size = strlen(nskey) + 1;
 	m_key.mv_data = nskey;
 
-	return (mdb_del(batch->txn, bd->dbi, &m_key, NULL) == 0);
+	if ((txn = backend_batch_get_txn(bd, batch, TRUE)) == NULL)
+	{
+		return FALSE;
+	}
+
+	return (mdb_del(txn, bd->dbi, &m_key, NULL) == 0);
 }
 
 static gboolean
@@ -152,6 +431,7 @@ backend_get(gpointer backend_data, gpointer data, gchar const* key, gpointer* va
 
 	JLMDBData* bd = backend_data;
 	JLMDBBatch* batch = data;
+	MDB_txn* txn;
 	MDB_val m_key;
 	MDB_val m_value;
 	g_autofree gchar* nskey = NULL;
@@ -166,8 +446,19 @@ backend_get(gpointer backend_data, gpointer data, gchar const* key, gpointer* va
 	m_key.mv_size = strlen(nskey) + 1;
 	m_key.mv_data = nskey;
 
-	if (mdb_get(batch->txn, bd->dbi, &m_key, &m_value) == 0)
+	if ((txn = backend_batch_get_txn(bd, batch, FALSE)) == NULL)
+	{
+		return FALSE;
+	}
+
+	if (mdb_get(txn, bd->dbi, &m_key, &m_value) != 0)
+	{
+		backend_batch_record_read(batch, &m_key, NULL);
+	}
+	else
 	{
+		backend_batch_record_read(batch, &m_key, &m_value);
+
 		// FIXME check whether copies can be avoided
 #if GLIB_CHECK_VERSION(2, 68, 0)
 		*value = g_memdup2(m_value.mv_data, m_value.mv_size);
@@ -182,6 +473,174 @@ backend_get(gpointer backend_data, gpointer data, gchar const* key, gpointer* va
 	return ret;
 }
 
+static gboolean
+backend_get_multi(gpointer backend_data, gpointer data, gchar const** keys, guint32 count, gpointer* values, guint32* lens)
+{
+	JLMDBData* bd = backend_data;
+	JLMDBBatch* batch = data;
+	MDB_txn* txn;
+	g_autoptr(GString) nskey = NULL;
+
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(keys != NULL, FALSE);
+	g_return_val_if_fail(values != NULL, FALSE);
+	g_return_val_if_fail(lens != NULL, FALSE);
+
+	if ((txn = backend_batch_get_txn(bd, batch, FALSE)) == NULL)
+	{
+		return FALSE;
+	}
+
+	nskey = g_string_new(NULL);
+
+	// All keys are resolved within the batch's transaction, reusing the key buffer.
+	for (guint32 i = 0; i < count; i++)
+	{
+		MDB_val m_key;
+		MDB_val m_value;
+
+		values[i] = NULL;
+		lens[i] = 0;
+
+		g_string_printf(nskey, "%s:%s", batch->namespace, keys[i]);
+
+		m_key.mv_size = nskey->len + 1;
+		m_key.mv_data = nskey->str;
+
+		if (mdb_get(txn, bd->dbi, &m_key, &m_value) != 0)
+		{
+			backend_batch_record_read(batch, &m_key, NULL);
+		}
+		else
+		{
+			backend_batch_record_read(batch, &m_key, &m_value);
+
+			// g_memdup2() returns NULL for empty values, which would mark the key as missing
+			values[i] = g_malloc(MAX(m_value.mv_size, 1));
+			memcpy(values[i], m_value.mv_data, m_value.mv_size);
+			lens[i] = m_value.mv_size;
+		}
+	}
+
+	return TRUE;
+}
+
+static gboolean
+backend_compare_and_swap(gpointer backend_data, gpointer data, gchar const* key, gconstpointer expected, guint32 expected_len, gconstpointer value, guint32 len, gboolean* swapped)
+{
+	JLMDBData* bd = backend_data;
+	JLMDBBatch* batch = data;
+	MDB_txn* txn;
+	MDB_val m_key;
+	MDB_val m_value;
+	gboolean match;
+	gint ret;
+	g_autofree gchar* nskey = NULL;
+
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+	g_return_val_if_fail(swapped != NULL, FALSE);
+
+	*swapped = FALSE;
+
+	nskey = g_strdup_printf("%s:%s", batch->namespace, key);
+
+	m_key.mv_size = strlen(nskey) + 1;
+	m_key.mv_data = nskey;
+
+	// Reading within the write transaction makes the comparison and the update atomic, as there is only a single writer.
+	if ((txn = backend_batch_get_txn(bd, batch, TRUE)) == NULL)
+	{
+		return FALSE;
+	}
+
+	ret = mdb_get(txn, bd->dbi, &m_key, &m_value);
+
+	if (ret != 0 && ret != MDB_NOTFOUND)
+	{
+		return FALSE;
+	}
+
+	if (expected == NULL)
+	{
+		match = (ret == MDB_NOTFOUND);
+	}
+	else
+	{
+		match = (ret == 0 && m_value.mv_size == expected_len && memcmp(m_value.mv_data, expected, expected_len) == 0);
+	}
+
+	if (!match)
+	{
+		return TRUE;
+	}
+
+	m_value.mv_size = len;
+	m_value.mv_data = value;
+
+	if (mdb_put(txn, bd->dbi, &m_key, &m_value, 0) != 0)
+	{
+		return FALSE;
+	}
+
+	*swapped = TRUE;
+
+	return TRUE;
+}
+
+static gboolean
+backend_add(gpointer backend_data, gpointer data, gchar const* key, gint64 delta, gint64* result)
+{
+	JLMDBData* bd = backend_data;
+	JLMDBBatch* batch = data;
+	MDB_txn* txn;
+	MDB_val m_key;
+	MDB_val m_value;
+	gint64 sum = 0;
+	gint ret;
+	g_autofree gchar* nskey = NULL;
+
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(result != NULL, FALSE);
+
+	nskey = g_strdup_printf("%s:%s", batch->namespace, key);
+
+	m_key.mv_size = strlen(nskey) + 1;
+	m_key.mv_data = nskey;
+
+	if ((txn = backend_batch_get_txn(bd, batch, TRUE)) == NULL)
+	{
+		return FALSE;
+	}
+
+	ret = mdb_get(txn, bd->dbi, &m_key, &m_value);
+
+	if (ret == 0)
+	{
+		if (m_value.mv_size != sizeof(sum))
+		{
+			return FALSE;
+		}
+
+		memcpy(&sum, m_value.mv_data, sizeof(sum));
+		sum = GINT64_FROM_LE(sum);
+	}
+	else if (ret != MDB_NOTFOUND)
+	{
+		return FALSE;
+	}
+
+	*result = sum + delta;
+	sum = GINT64_TO_LE(*result);
+
+	m_value.mv_size = sizeof(sum);
+	m_value.mv_data = &sum;
+
+	return (mdb_put(txn, bd->dbi, &m_key, &m_value, 0) == 0);
+}
+
 static gboolean
 backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* data)
 {
@@ -194,14 +653,32 @@ backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* data)
 	iterator = g_slice_new(JLMDBIterator);
 	iterator->first = TRUE;
 	iterator->prefix = g_strdup_printf("%s:", namespace);
+	iterator->seek = NULL;
+	iterator->end = NULL;
+	iterator->reverse = FALSE;
+	iterator->limit = 0;
+	iterator->count = 0;
 	iterator->namespace_len = strlen(namespace) + 1;
 
-	mdb_txn_begin(bd->env, NULL, 0, &(iterator->txn));
-	mdb_cursor_open(iterator->txn, bd->dbi, &(iterator->cursor));
+	// Iterators only read, so they do not have to wait for the writer.
+	if ((iterator->txn = backend_reader_get(bd)) == NULL || mdb_cursor_open(iterator->txn, bd->dbi, &(iterator->cursor)) != 0)
+	{
+		if (iterator->txn != NULL)
+		{
+			backend_reader_put(bd, iterator->txn);
+		}
+
+		g_free(iterator->prefix);
+		g_slice_free(JLMDBIterator, iterator);
+
+		return FALSE;
+	}
+
+	iterator->bd = bd;
 
 	*data = iterator;
 
-	return (iterator != NULL);
+	return TRUE;
 }
 
 static gboolean
@@ -217,14 +694,113 @@ backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const
 	iterator = g_slice_new(JLMDBIterator);
 	iterator->first = TRUE;
 	iterator->prefix = g_strdup_printf("%s:%s", namespace, prefix);
+	iterator->seek = NULL;
+	iterator->end = NULL;
+	iterator->reverse = FALSE;
+	iterator->limit = 0;
+	iterator->count = 0;
 	iterator->namespace_len = strlen(namespace) + 1;
 
-	mdb_txn_begin(bd->env, NULL, 0, &(iterator->txn));
-	mdb_cursor_open(iterator->txn, bd->dbi, &(iterator->cursor));
+	// Iterators only read, so they do not have to wait for the writer.
+	if ((iterator->txn = backend_reader_get(bd)) == NULL || mdb_cursor_open(iterator->txn, bd->dbi, &(iterator->cursor)) != 0)
+	{
+		if (iterator->txn != NULL)
+		{
+			backend_reader_put(bd, iterator->txn);
+		}
+
+		g_free(iterator->prefix);
+		g_slice_free(JLMDBIterator, iterator);
+
+		return FALSE;
+	}
+
+	iterator->bd = bd;
 
 	*data = iterator;
 
-	return (iterator != NULL);
+	return TRUE;
+}
+
+static gboolean
+backend_get_range(gpointer backend_data, gchar const* namespace, gchar const* start, gchar const* end, gboolean reverse, guint32 limit, gpointer* data)
+{
+	JLMDBData* bd = backend_data;
+	JLMDBIterator* iterator = NULL;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	iterator = g_slice_new(JLMDBIterator);
+	iterator->first = TRUE;
+	iterator->prefix = g_strdup_printf("%s:", namespace);
+	iterator->seek = (start != NULL) ? g_strdup_printf("%s:%s", namespace, start) : NULL;
+	iterator->end = (end != NULL) ? g_strdup_printf("%s:%s", namespace, end) : NULL;
+	iterator->reverse = reverse;
+	iterator->limit = limit;
+	iterator->count = 0;
+	iterator->namespace_len = strlen(namespace) + 1;
+
+	if ((iterator->txn = backend_reader_get(bd)) == NULL || mdb_cursor_open(iterator->txn, bd->dbi, &(iterator->cursor)) != 0)
+	{
+		if (iterator->txn != NULL)
+		{
+			backend_reader_put(bd, iterator->txn);
+		}
+
+		g_free(iterator->prefix);
+		g_free(iterator->seek);
+		g_free(iterator->end);
+		g_slice_free(JLMDBIterator, iterator);
+
+		return FALSE;
+	}
+
+	iterator->bd = bd;
+
+	*data = iterator;
+
+	return TRUE;
+}
+
+static void
+backend_iterator_free(gpointer backend_data, gpointer data)
+{
+	JLMDBIterator* iterator = data;
+
+	(void)backend_data;
+
+	mdb_cursor_close(iterator->cursor);
+	backend_reader_put(iterator->bd, iterator->txn);
+
+	g_free(iterator->prefix);
+	g_free(iterator->seek);
+	g_free(iterator->end);
+	g_slice_free(JLMDBIterator, iterator);
+}
+
+static gboolean
+backend_seek(gpointer backend_data, gpointer data, gchar const* key)
+{
+	JLMDBIterator* iterator = data;
+	g_autofree gchar* nskey = NULL;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(iterator->first, FALSE);
+
+	nskey = g_strdup_printf("%.*s%s", (gint)iterator->namespace_len, iterator->prefix, key);
+
+	// Keys before the prefix would end the iteration immediately
+	if (strcmp(nskey, iterator->prefix) > 0)
+	{
+		g_free(iterator->seek);
+		iterator->seek = g_steal_pointer(&nskey);
+	}
+
+	return TRUE;
 }
 
 static gboolean
@@ -241,11 +817,38 @@ backend_iterate(gpointer backend_data, gpointer data, gchar const** key, gconstp
 	g_return_val_if_fail(value != NULL, FALSE);
 	g_return_val_if_fail(len != NULL, FALSE);
 
-	if (iterator->first)
+	if (iterator->limit > 0 && iterator->count == iterator->limit)
+	{
+		goto out;
+	}
+
+	if (iterator->reverse)
+	{
+		cursor_op = MDB_PREV;
+
+		if (iterator->first)
+		{
+			g_autofree gchar* upper = NULL;
+
+			// Without an end key, the namespace's keys end before the separator's successor
+			upper = (iterator->end != NULL) ? g_strdup(iterator->end) : g_strdup_printf("%.*s;", (gint)(iterator->namespace_len - 1), iterator->prefix);
+
+			m_key.mv_size = strlen(upper) + 1;
+			m_key.mv_data = upper;
+
+			// Start at the last key before the upper bound, or at the last key overall if there is none after it
+			cursor_op = (mdb_cursor_get(iterator->cursor, &m_key, &m_value, MDB_SET_RANGE) == 0) ? MDB_PREV : MDB_LAST;
+
+			iterator->first = FALSE;
+		}
+	}
+	else if (iterator->first)
 	{
+		gchar* start = (iterator->seek != NULL) ? iterator->seek : iterator->prefix;
+
 		// FIXME check +1
-		m_key.mv_size = strlen(iterator->prefix) + 1;
-		m_key.mv_data = iterator->prefix;
+		m_key.mv_size = strlen(start) + 1;
+		m_key.mv_data = start;
 
 		cursor_op = MDB_SET_RANGE;
 
@@ -260,6 +863,18 @@ backend_iterate(gpointer backend_data, gpointer data, gchar const** key, gconstp
 			goto out;
 		}
 
+		if (iterator->reverse && iterator->seek != NULL && strcmp(m_key.mv_data, iterator->seek) < 0)
+		{
+			goto out;
+		}
+
+		if (!iterator->reverse && iterator->end != NULL && strcmp(m_key.mv_data, iterator->end) >= 0)
+		{
+			goto out;
+		}
+
+		iterator->count++;
+
 		*key = (gchar const*)m_key.mv_data + iterator->namespace_len;
 		*value = m_value.mv_data;
 		*len = m_value.mv_size;
@@ -268,10 +883,7 @@ backend_iterate(gpointer backend_data, gpointer data, gchar const** key, gconstp
 	}
 
 out:
-	mdb_txn_commit(iterator->txn);
-
-	g_free(iterator->prefix);
-	g_slice_free(JLMDBIterator, iterator);
+	backend_iterator_free(backend_data, iterator);
 
 	return FALSE;
 }
@@ -287,6 +899,7 @@ backend_init(gchar const* path, gpointer* backend_data)
 	g_mkdir_with_parents(path, 0700);
 
 	bd = g_slice_new(JLMDBData);
+	bd->readers = g_async_queue_new();
 
 	if (mdb_env_create(&(bd->env)) == 0)
 	{
@@ -296,7 +909,8 @@ backend_init(gchar const* path, gpointer* backend_data)
 			goto error;
 		}
 
-		if (mdb_env_open(bd->env, path, 0, 0600) != 0)
+		// MDB_NOTLS decouples read-only transactions from threads, allowing them to be reused by any thread.
+		if (mdb_env_open(bd->env, path, MDB_NOTLS, 0600) != 0)
 		{
 			goto error;
 		}
@@ -323,6 +937,7 @@ backend_init(gchar const* path, gpointer* backend_data)
 
 error:
 	mdb_env_close(bd->env);
+	g_async_queue_unref(bd->readers);
 	g_slice_free(JLMDBData, bd);
 
 	return FALSE;
@@ -332,6 +947,14 @@ static void
 backend_fini(gpointer backend_data)
 {
 	JLMDBData* bd = backend_data;
+	MDB_txn* txn;
+
+	while ((txn = g_async_queue_try_pop(bd->readers)) != NULL)
+	{
+		mdb_txn_abort(txn);
+	}
+
+	g_async_queue_unref(bd->readers);
 
 	if (bd->env != NULL)
 	{
@@ -349,12 +972,19 @@ static JBackend lmdb_backend = {
 		.backend_fini = backend_fini,
 		.backend_batch_start = backend_batch_start,
 		.backend_batch_execute = backend_batch_execute,
+		.backend_batch_abort = backend_batch_abort,
 		.backend_put = backend_put,
 		.backend_delete = backend_delete,
 		.backend_get = backend_get,
+		.backend_get_multi = backend_get_multi,
+		.backend_compare_and_swap = backend_compare_and_swap,
+		.backend_add = backend_add,
 		.backend_get_all = backend_get_all,
 		.backend_get_by_prefix = backend_get_by_prefix,
-		.backend_iterate = backend_iterate }
+		.backend_get_range = backend_get_range,
+		.backend_iterate = backend_iterate,
+		.backend_seek = backend_seek,
+		.backend_iterator_free = backend_iterator_free }
 };
 
 G_MODULE_EXPORT
@@ -0,0 +1,909 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <gmodule.h>
+
+#include <string.h>
+
+#include <julea.h>
+
+/*
+ * Every namespace has a hash table for lookups and a sequence ordered by key for iteration.
+ * Entries are immutable and reference counted, so iterators can work on a snapshot without holding any locks.
+ * Batches collect their changes and apply them at once when they are executed.
+ */
+
+struct JMemoryEntry
+{
+	gint ref_count;
+
+	gchar* key;
+	GBytes* value;
+};
+
+typedef struct JMemoryEntry JMemoryEntry;
+
+struct JMemoryNamespace
+{
+	GRWLock lock[1];
+
+	// key(gchar*) -> GSequenceIter* pointing to a JMemoryEntry
+	GHashTable* entries;
+	GSequence* ordered;
+
+	/**
+	 * The size of all keys and values in bytes.
+	 **/
+	guint64 size;
+};
+
+typedef struct JMemoryNamespace JMemoryNamespace;
+
+struct JMemoryData
+{
+	GRWLock lock[1];
+
+	// namespace(gchar*) -> JMemoryNamespace*
+	GHashTable* namespaces;
+
+	/**
+	 * The maximum size of a namespace's keys and values in bytes, 0 for unlimited.
+	 **/
+	guint64 limit;
+};
+
+typedef struct JMemoryData JMemoryData;
+
+struct JMemoryBatch
+{
+	JMemoryNamespace* namespace;
+
+	// key(gchar*) -> JMemoryEntry*, entries without a value are deletions
+	GHashTable* changes;
+};
+
+typedef struct JMemoryBatch JMemoryBatch;
+
+struct JMemoryIterator
+{
+	GPtrArray* entries;
+	guint index;
+};
+
+typedef struct JMemoryIterator JMemoryIterator;
+
+static JMemoryEntry*
+memory_entry_new(gchar const* key, gconstpointer value, guint32 len)
+{
+	JMemoryEntry* entry;
+
+	entry = g_slice_new(JMemoryEntry);
+	entry->ref_count = 1;
+	entry->key = g_strdup(key);
+	entry->value = (value != NULL) ? g_bytes_new(value, len) : NULL;
+
+	return entry;
+}
+
+static JMemoryEntry*
+memory_entry_ref(JMemoryEntry* entry)
+{
+	g_atomic_int_inc(&(entry->ref_count));
+
+	return entry;
+}
+
+static void
+memory_entry_unref(JMemoryEntry* entry)
+{
+	if (g_atomic_int_dec_and_test(&(entry->ref_count)))
+	{
+		if (entry->value != NULL)
+		{
+			g_bytes_unref(entry->value);
+		}
+
+		g_free(entry->key);
+		g_slice_free(JMemoryEntry, entry);
+	}
+}
+
+static guint64
+memory_entry_size(JMemoryEntry const* entry)
+{
+	return strlen(entry->key) + g_bytes_get_size(entry->value);
+}
+
+static gint
+memory_entry_compare(gconstpointer a, gconstpointer b, gpointer data)
+{
+	JMemoryEntry const* entry_a = a;
+	JMemoryEntry const* entry_b = b;
+
+	(void)data;
+
+	// strcmp compares unsigned bytes, matching the order of the other backends
+	return strcmp(entry_a->key, entry_b->key);
+}
+
+static JMemoryNamespace*
+memory_namespace_new(void)
+{
+	JMemoryNamespace* namespace;
+
+	namespace = g_slice_new(JMemoryNamespace);
+	g_rw_lock_init(namespace->lock);
+	// Keys are owned by the entries
+	namespace->entries = g_hash_table_new(g_str_hash, g_str_equal);
+	namespace->ordered = g_sequence_new((GDestroyNotify)memory_entry_unref);
+	namespace->size = 0;
+
+	return namespace;
+}
+
+static void
+memory_namespace_free(JMemoryNamespace* namespace)
+{
+	g_hash_table_unref(namespace->entries);
+	g_sequence_free(namespace->ordered);
+	g_rw_lock_clear(namespace->lock);
+	g_slice_free(JMemoryNamespace, namespace);
+}
+
+/**
+ * Returns a namespace, creating it if necessary.
+ *
+ * \private
+ *
+ * \param bd     The backend data.
+ * \param name   The namespace's name.
+ * \param create Whether to create the namespace if it does not exist.
+ *
+ * \return The namespace, or NULL if it does not exist and create is FALSE.
+ **/
+static JMemoryNamespace*
+memory_namespace_get(JMemoryData* bd, gchar const* name, gboolean create)
+{
+	JMemoryNamespace* namespace;
+
+	g_rw_lock_reader_lock(bd->lock);
+	namespace = g_hash_table_lookup(bd->namespaces, name);
+	g_rw_lock_reader_unlock(bd->lock);
+
+	if (namespace != NULL || !create)
+	{
+		return namespace;
+	}
+
+	g_rw_lock_writer_lock(bd->lock);
+
+	// Another thread might have created the namespace in the meantime
+	if ((namespace = g_hash_table_lookup(bd->namespaces, name)) == NULL)
+	{
+		namespace = memory_namespace_new();
+		g_hash_table_insert(bd->namespaces, g_strdup(name), namespace);
+	}
+
+	g_rw_lock_writer_unlock(bd->lock);
+
+	return namespace;
+}
+
+/**
+ * Creates an iterator over a snapshot of a namespace's entries.
+ *
+ * \private
+ *
+ * \param bd        The backend data.
+ * \param name      The namespace's name.
+ * \param start     The first key, NULL to start at the beginning.
+ * \param end       The key to stop at (exclusive), NULL to continue until the end.
+ * \param prefix    The prefix all keys have to match, may be NULL.
+ * \param reverse   Whether to iterate in descending order.
+ * \param limit     The maximum number of entries, 0 for unlimited.
+ *
+ * \return A new iterator.
+ **/
+static JMemoryIterator*
+memory_iterator_new(JMemoryData* bd, gchar const* name, gchar const* start, gchar const* end, gchar const* prefix, gboolean reverse, guint32 limit)
+{
+	JMemoryIterator* iterator;
+	JMemoryNamespace* namespace;
+
+	iterator = g_slice_new(JMemoryIterator);
+	iterator->entries = g_ptr_array_new_with_free_func((GDestroyNotify)memory_entry_unref);
+	iterator->index = 0;
+
+	if ((namespace = memory_namespace_get(bd, name, FALSE)) == NULL)
+	{
+		return iterator;
+	}
+
+	if (prefix != NULL && (start == NULL || strcmp(prefix, start) > 0))
+	{
+		start = prefix;
+	}
+
+	g_rw_lock_reader_lock(namespace->lock);
+
+	{
+		GSequenceIter* it;
+
+		if (start != NULL)
+		{
+			JMemoryEntry lookup = { .key = (gchar*)start };
+
+			it = g_sequence_search(namespace->ordered, &lookup, memory_entry_compare, NULL);
+
+			// g_sequence_search returns the position after equal entries
+			while (!g_sequence_iter_is_begin(it))
+			{
+				GSequenceIter* prev = g_sequence_iter_prev(it);
+
+				if (strcmp(((JMemoryEntry*)g_sequence_get(prev))->key, start) < 0)
+				{
+					break;
+				}
+
+				it = prev;
+			}
+		}
+		else
+		{
+			it = g_sequence_get_begin_iter(namespace->ordered);
+		}
+
+		for (; !g_sequence_iter_is_end(it); it = g_sequence_iter_next(it))
+		{
+			JMemoryEntry* entry = g_sequence_get(it);
+
+			if (end != NULL && strcmp(entry->key, end) >= 0)
+			{
+				break;
+			}
+
+			if (prefix != NULL && !g_str_has_prefix(entry->key, prefix))
+			{
+				break;
+			}
+
+			g_ptr_array_add(iterator->entries, memory_entry_ref(entry));
+
+			// Descending iteration needs the last entries of the range
+			if (!reverse && limit > 0 && iterator->entries->len == limit)
+			{
+				break;
+			}
+		}
+	}
+
+	g_rw_lock_reader_unlock(namespace->lock);
+
+	if (reverse)
+	{
+		guint len = iterator->entries->len;
+
+		for (guint i = 0; i < len / 2; i++)
+		{
+			gpointer tmp = iterator->entries->pdata[i];
+
+			iterator->entries->pdata[i] = iterator->entries->pdata[len - i - 1];
+			iterator->entries->pdata[len - i - 1] = tmp;
+		}
+
+		if (limit > 0 && len > limit)
+		{
+			g_ptr_array_set_size(iterator->entries, limit);
+		}
+	}
+
+	return iterator;
+}
+
+static void
+memory_iterator_free(JMemoryIterator* iterator)
+{
+	g_ptr_array_unref(iterator->entries);
+	g_slice_free(JMemoryIterator, iterator);
+}
+
+static gboolean
+backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* backend_batch)
+{
+	JMemoryBatch* batch;
+	JMemoryData* bd = backend_data;
+
+	(void)semantics;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+
+	batch = g_slice_new(JMemoryBatch);
+	batch->namespace = memory_namespace_get(bd, namespace, TRUE);
+	batch->changes = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)memory_entry_unref);
+
+	*backend_batch = batch;
+
+	return TRUE;
+}
+
+static void
+memory_batch_free(JMemoryBatch* batch)
+{
+	g_hash_table_unref(batch->changes);
+	g_slice_free(JMemoryBatch, batch);
+}
+
+static gboolean
+backend_batch_execute(gpointer backend_data, gpointer backend_batch)
+{
+	JMemoryBatch* batch = backend_batch;
+	JMemoryData* bd = backend_data;
+	JMemoryNamespace* namespace;
+	GHashTableIter iter;
+	JMemoryEntry* entry;
+	gint64 delta = 0;
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+
+	namespace = batch->namespace;
+
+	if (g_hash_table_size(batch->changes) == 0)
+	{
+		goto end;
+	}
+
+	g_rw_lock_writer_lock(namespace->lock);
+
+	g_hash_table_iter_init(&iter, batch->changes);
+
+	while (g_hash_table_iter_next(&iter, NULL, (gpointer*)&entry))
+	{
+		GSequenceIter* it;
+
+		if (entry->value != NULL)
+		{
+			delta += memory_entry_size(entry);
+		}
+
+		if ((it = g_hash_table_lookup(namespace->entries, entry->key)) != NULL)
+		{
+			delta -= memory_entry_size(g_sequence_get(it));
+		}
+	}
+
+	// The batch is applied completely or not at all
+	if (bd->limit > 0 && delta > 0 && namespace->size + delta > bd->limit)
+	{
+		ret = FALSE;
+		goto unlock;
+	}
+
+	g_hash_table_iter_init(&iter, batch->changes);
+
+	while (g_hash_table_iter_next(&iter, NULL, (gpointer*)&entry))
+	{
+		GSequenceIter* it;
+
+		if ((it = g_hash_table_lookup(namespace->entries, entry->key)) != NULL)
+		{
+			g_hash_table_remove(namespace->entries, entry->key);
+			g_sequence_remove(it);
+		}
+
+		if (entry->value != NULL)
+		{
+			it = g_sequence_insert_sorted(namespace->ordered, memory_entry_ref(entry), memory_entry_compare, NULL);
+			g_hash_table_insert(namespace->entries, entry->key, it);
+		}
+	}
+
+	namespace->size += delta;
+
+unlock:
+	g_rw_lock_writer_unlock(namespace->lock);
+
+end:
+	memory_batch_free(batch);
+
+	return ret;
+}
+
+static gboolean
+backend_batch_abort(gpointer backend_data, gpointer backend_batch)
+{
+	JMemoryBatch* batch = backend_batch;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+
+	memory_batch_free(batch);
+
+	return TRUE;
+}
+
+static gboolean
+backend_put(gpointer backend_data, gpointer backend_batch, gchar const* key, gconstpointer value, guint32 len)
+{
+	JMemoryBatch* batch = backend_batch;
+	JMemoryData* bd = backend_data;
+	JMemoryEntry* entry;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+
+	entry = memory_entry_new(key, value, len);
+
+	// Fail early if the entry can never fit
+	if (bd->limit > 0 && memory_entry_size(entry) > bd->limit)
+	{
+		memory_entry_unref(entry);
+		return FALSE;
+	}
+
+	g_hash_table_replace(batch->changes, entry->key, entry);
+
+	return TRUE;
+}
+
+static gboolean
+backend_delete(gpointer backend_data, gpointer backend_batch, gchar const* key)
+{
+	JMemoryBatch* batch = backend_batch;
+	JMemoryEntry* entry;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+
+	entry = memory_entry_new(key, NULL, 0);
+	g_hash_table_replace(batch->changes, entry->key, entry);
+
+	return TRUE;
+}
+
+static gboolean
+backend_get(gpointer backend_data, gpointer backend_batch, gchar const* key, gpointer* value, guint32* len)
+{
+	JMemoryBatch* batch = backend_batch;
+	JMemoryNamespace* namespace;
+	JMemoryEntry* entry;
+	GBytes* bytes = NULL;
+	gconstpointer data;
+	gsize size;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+	g_return_val_if_fail(len != NULL, FALSE);
+
+	namespace = batch->namespace;
+
+	// The batch's own changes take precedence
+	if ((entry = g_hash_table_lookup(batch->changes, key)) != NULL)
+	{
+		if (entry->value != NULL)
+		{
+			bytes = g_bytes_ref(entry->value);
+		}
+	}
+	else
+	{
+		GSequenceIter* it;
+
+		g_rw_lock_reader_lock(namespace->lock);
+
+		if ((it = g_hash_table_lookup(namespace->entries, key)) != NULL)
+		{
+			bytes = g_bytes_ref(((JMemoryEntry*)g_sequence_get(it))->value);
+		}
+
+		g_rw_lock_reader_unlock(namespace->lock);
+	}
+
+	if (bytes == NULL)
+	{
+		return FALSE;
+	}
+
+	data = g_bytes_get_data(bytes, &size);
+#if GLIB_CHECK_VERSION(2, 68, 0)
+	*value = g_memdup2(data, size);
+#else
+	*value = g_memdup(data, size);
+#endif
+	*len = size;
+
+	g_bytes_unref(bytes);
+
+	return TRUE;
+}
+
+/**
+ * Returns a key's current value for compare-and-swap and add, taking the batch's own changes into account.
+ * Has to be called with the namespace's writer lock held, the value is only valid until it is released.
+ *
+ * \private
+ *
+ * \param batch A batch.
+ * \param key   A key.
+ *
+ * \return The value, NULL if the key does not exist.
+ **/
+static GBytes*
+memory_get_current(JMemoryBatch* batch, gchar const* key)
+{
+	JMemoryEntry* entry;
+	GSequenceIter* it;
+
+	if ((entry = g_hash_table_lookup(batch->changes, key)) != NULL)
+	{
+		return entry->value;
+	}
+
+	if ((it = g_hash_table_lookup(batch->namespace->entries, key)) != NULL)
+	{
+		return ((JMemoryEntry*)g_sequence_get(it))->value;
+	}
+
+	return NULL;
+}
+
+/**
+ * Applies a value directly instead of adding it to the batch.
+ * Other batches must not see a stale value between compare-and-swap or add and the batch's execution, so the change is applied immediately.
+ * The key's pending change, which the value has been derived from, is dropped from the batch.
+ * Has to be called with the namespace's writer lock held.
+ *
+ * \private
+ *
+ * \param bd    The backend data.
+ * \param batch A batch.
+ * \param key   A key.
+ * \param value A value.
+ * \param len   The value's length.
+ *
+ * \return TRUE on success, FALSE if the namespace's limit would be exceeded.
+ **/
+static gboolean
+memory_put_now(JMemoryData* bd, JMemoryBatch* batch, gchar const* key, gconstpointer value, guint32 len)
+{
+	JMemoryNamespace* namespace = batch->namespace;
+	JMemoryEntry* entry;
+	GSequenceIter* it;
+	gint64 delta;
+
+	entry = memory_entry_new(key, value, len);
+	delta = memory_entry_size(entry);
+
+	if ((it = g_hash_table_lookup(namespace->entries, key)) != NULL)
+	{
+		delta -= memory_entry_size(g_sequence_get(it));
+	}
+
+	if (bd->limit > 0 && delta > 0 && namespace->size + delta > bd->limit)
+	{
+		memory_entry_unref(entry);
+		return FALSE;
+	}
+
+	if (it != NULL)
+	{
+		g_hash_table_remove(namespace->entries, key);
+		g_sequence_remove(it);
+	}
+
+	it = g_sequence_insert_sorted(namespace->ordered, entry, memory_entry_compare, NULL);
+	g_hash_table_insert(namespace->entries, entry->key, it);
+	namespace->size += delta;
+
+	g_hash_table_remove(batch->changes, key);
+
+	return TRUE;
+}
+
+static gboolean
+backend_compare_and_swap(gpointer backend_data, gpointer backend_batch, gchar const* key, gconstpointer expected, guint32 expected_len, gconstpointer value, guint32 len, gboolean* swapped)
+{
+	JMemoryBatch* batch = backend_batch;
+	JMemoryData* bd = backend_data;
+	GBytes* current;
+	gboolean match;
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+	g_return_val_if_fail(swapped != NULL, FALSE);
+
+	*swapped = FALSE;
+
+	g_rw_lock_writer_lock(batch->namespace->lock);
+
+	current = memory_get_current(batch, key);
+
+	if (expected == NULL)
+	{
+		match = (current == NULL);
+	}
+	else
+	{
+		gconstpointer data;
+		gsize size;
+
+		match = FALSE;
+
+		if (current != NULL)
+		{
+			data = g_bytes_get_data(current, &size);
+			match = (size == expected_len && memcmp(data, expected, expected_len) == 0);
+		}
+	}
+
+	if (match)
+	{
+		ret = memory_put_now(bd, batch, key, value, len);
+		*swapped = ret;
+	}
+
+	g_rw_lock_writer_unlock(batch->namespace->lock);
+
+	return ret;
+}
+
+static gboolean
+backend_add(gpointer backend_data, gpointer backend_batch, gchar const* key, gint64 delta, gint64* result)
+{
+	JMemoryBatch* batch = backend_batch;
+	JMemoryData* bd = backend_data;
+	GBytes* current;
+	gint64 sum = 0;
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(result != NULL, FALSE);
+
+	g_rw_lock_writer_lock(batch->namespace->lock);
+
+	if ((current = memory_get_current(batch, key)) != NULL)
+	{
+		gconstpointer data;
+		gsize size;
+
+		data = g_bytes_get_data(current, &size);
+
+		if (size != sizeof(sum))
+		{
+			goto end;
+		}
+
+		memcpy(&sum, data, sizeof(sum));
+		sum = GINT64_FROM_LE(sum);
+	}
+
+	*result = sum + delta;
+	sum = GINT64_TO_LE(*result);
+
+	ret = memory_put_now(bd, batch, key, &sum, sizeof(sum));
+
+end:
+	g_rw_lock_writer_unlock(batch->namespace->lock);
+
+	return ret;
+}
+
+static gboolean
+backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend_iterator)
+{
+	JMemoryData* bd = backend_data;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+
+	*backend_iterator = memory_iterator_new(bd, namespace, NULL, NULL, NULL, FALSE, 0);
+
+	return TRUE;
+}
+
+static gboolean
+backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const* prefix, gpointer* backend_iterator)
+{
+	JMemoryData* bd = backend_data;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(prefix != NULL, FALSE);
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+
+	*backend_iterator = memory_iterator_new(bd, namespace, NULL, NULL, prefix, FALSE, 0);
+
+	return TRUE;
+}
+
+static gboolean
+backend_get_range(gpointer backend_data, gchar const* namespace, gchar const* start, gchar const* end, gboolean reverse, guint32 limit, gpointer* backend_iterator)
+{
+	JMemoryData* bd = backend_data;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+
+	*backend_iterator = memory_iterator_new(bd, namespace, start, end, NULL, reverse, limit);
+
+	return TRUE;
+}
+
+static gboolean
+backend_seek(gpointer backend_data, gpointer backend_iterator, gchar const* key)
+{
+	JMemoryIterator* iterator = backend_iterator;
+	guint low;
+	guint high;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(iterator->index == 0, FALSE);
+
+	low = 0;
+	high = iterator->entries->len;
+
+	// Find the first entry that is not smaller than key
+	while (low < high)
+	{
+		guint mid = low + (high - low) / 2;
+		JMemoryEntry* entry = g_ptr_array_index(iterator->entries, mid);
+
+		if (strcmp(entry->key, key) < 0)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+
+	iterator->index = low;
+
+	return TRUE;
+}
+
+static gboolean
+backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const** key, gconstpointer* value, guint32* len)
+{
+	JMemoryIterator* iterator = backend_iterator;
+	JMemoryEntry* entry;
+	gsize size;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+	g_return_val_if_fail(len != NULL, FALSE);
+
+	if (iterator->index >= iterator->entries->len)
+	{
+		memory_iterator_free(iterator);
+
+		return FALSE;
+	}
+
+	entry = g_ptr_array_index(iterator->entries, iterator->index);
+	iterator->index++;
+
+	*key = entry->key;
+	*value = g_bytes_get_data(entry->value, &size);
+	*len = size;
+
+	return TRUE;
+}
+
+static void
+backend_iterator_free(gpointer backend_data, gpointer backend_iterator)
+{
+	(void)backend_data;
+
+	g_return_if_fail(backend_iterator != NULL);
+
+	memory_iterator_free(backend_iterator);
+}
+
+static gboolean
+backend_init(gchar const* path, gpointer* backend_data)
+{
+	JMemoryData* bd;
+	g_auto(GStrv) split = NULL;
+
+	bd = g_slice_new(JMemoryData);
+	g_rw_lock_init(bd->lock);
+	bd->namespaces = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)memory_namespace_free);
+	bd->limit = 0;
+
+	// The path itself is ignored, it can only contain optional settings
+	split = g_strsplit((path != NULL) ? path : "", ":", 0);
+
+	for (guint i = 1; split[0] != NULL && split[i] != NULL; i++)
+	{
+		if (g_str_has_prefix(split[i], "limit="))
+		{
+			bd->limit = g_ascii_strtoull(split[i] + strlen("limit="), NULL, 10) * 1024 * 1024;
+		}
+		else
+		{
+			g_hash_table_unref(bd->namespaces);
+			g_rw_lock_clear(bd->lock);
+			g_slice_free(JMemoryData, bd);
+
+			return FALSE;
+		}
+	}
+
+	*backend_data = bd;
+
+	return TRUE;
+}
+
+static void
+backend_fini(gpointer backend_data)
+{
+	JMemoryData* bd = backend_data;
+
+	g_hash_table_unref(bd->namespaces);
+	g_rw_lock_clear(bd->lock);
+	g_slice_free(JMemoryData, bd);
+}
+
+static JBackend memory_backend = {
+	.type = J_BACKEND_TYPE_KV,
+	.component = J_BACKEND_COMPONENT_CLIENT | J_BACKEND_COMPONENT_SERVER,
+	.kv = {
+		.backend_init = backend_init,
+		.backend_fini = backend_fini,
+		.backend_batch_start = backend_batch_start,
+		.backend_batch_execute = backend_batch_execute,
+		.backend_batch_abort = backend_batch_abort,
+		.backend_put = backend_put,
+		.backend_delete = backend_delete,
+		.backend_get = backend_get,
+		.backend_compare_and_swap = backend_compare_and_swap,
+		.backend_add = backend_add,
+		.backend_get_all = backend_get_all,
+		.backend_get_by_prefix = backend_get_by_prefix,
+		.backend_get_range = backend_get_range,
+		.backend_iterate = backend_iterate,
+		.backend_seek = backend_seek,
+		.backend_iterator_free = backend_iterator_free }
+};
+
+G_MODULE_EXPORT
+JBackend*
+backend_info(void)
+{
+	return &memory_backend;
+}
@@ -27,7 +27,18 @@
 
 struct JMongoDBBatch
 {
+	mongoc_collection_t* collection;
+
+	/**
+	 * The pending writes, created on the first write and executed as a single round trip.
+	 **/
 	mongoc_bulk_operation_t* bulk_op;
+
+	/**
+	 * The bulk options containing the write concern and ordering.
+	 **/
+	bson_t opts[1];
+
 	gchar* namespace;
 };
 
@@ -39,30 +50,45 @@ struct JMongoDBData
 
 	gchar* host;
 	gchar* database;
+
+	/**
+	 * The namespaces whose index has already been created.
+	 **/
+	GHashTable* indexed;
+	GMutex indexed_mutex;
 };
 
 typedef struct JMongoDBData JMongoDBData;
 
-static gboolean
-backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* backend_batch)
+/**
+ * Creates the unique key index of a namespace's collection if it has not been created by this process yet.
+ *
+ * \private
+ *
+ * \param bd        The backend data.
+ * \param namespace A namespace.
+ **/
+static void
+backend_create_index(JMongoDBData* bd, gchar const* namespace)
 {
-	JMongoDBBatch* batch;
-	JMongoDBData* bd = backend_data;
 	bson_t command[1];
 	bson_t index[1];
 	bson_t indexes[1];
 	bson_t key[1];
-	bson_t opts[1];
 	bson_t reply[1];
-	mongoc_bulk_operation_t* bulk_op;
-	mongoc_collection_t* m_collection;
 	mongoc_database_t* m_database;
-	mongoc_write_concern_t* write_concern;
+	gboolean indexed;
 
 	gchar* index_name;
 
-	g_return_val_if_fail(namespace != NULL, FALSE);
-	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_mutex_lock(&(bd->indexed_mutex));
+	indexed = g_hash_table_contains(bd->indexed, namespace);
+	g_mutex_unlock(&(bd->indexed_mutex));
+
+	if (indexed)
+	{
+		return;
+	}
 
 	bson_init(key);
 	bson_append_int32(key, "key", -1, 1);
@@ -82,6 +108,99 @@ backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* s
 	bson_destroy(key);
 	bson_free(index_name);
 
+	m_database = mongoc_client_get_database(bd->connection, bd->database);
+
+	// createIndexes succeeds if the index already exists
+	if (mongoc_database_write_command_with_opts(m_database, command, NULL, reply, NULL))
+	{
+		g_mutex_lock(&(bd->indexed_mutex));
+		g_hash_table_add(bd->indexed, g_strdup(namespace));
+		g_mutex_unlock(&(bd->indexed_mutex));
+	}
+
+	mongoc_database_destroy(m_database);
+
+	bson_destroy(command);
+	bson_destroy(reply);
+}
+
+/**
+ * Executes a batch's pending writes.
+ *
+ * \private
+ *
+ * \param batch A batch.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+backend_batch_flush(JMongoDBBatch* batch)
+{
+	gboolean ret;
+
+	bson_t reply[1];
+
+	if (batch->bulk_op == NULL)
+	{
+		return TRUE;
+	}
+
+	ret = mongoc_bulk_operation_execute(batch->bulk_op, reply, NULL);
+
+	mongoc_bulk_operation_destroy(batch->bulk_op);
+	batch->bulk_op = NULL;
+
+	bson_destroy(reply);
+
+	return ret;
+}
+
+/**
+ * Returns a batch's bulk operation, creating it if necessary.
+ *
+ * \private
+ *
+ * \param batch A batch.
+ *
+ * \return The bulk operation.
+ **/
+static mongoc_bulk_operation_t*
+backend_batch_get_bulk(JMongoDBBatch* batch)
+{
+	if (batch->bulk_op == NULL)
+	{
+		batch->bulk_op = mongoc_collection_create_bulk_operation_with_opts(batch->collection, batch->opts);
+	}
+
+	return batch->bulk_op;
+}
+
+static void
+backend_batch_free(JMongoDBBatch* batch)
+{
+	if (batch->bulk_op != NULL)
+	{
+		mongoc_bulk_operation_destroy(batch->bulk_op);
+	}
+
+	mongoc_collection_destroy(batch->collection);
+	bson_destroy(batch->opts);
+	g_free(batch->namespace);
+	g_slice_free(JMongoDBBatch, batch);
+}
+
+static gboolean
+backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* backend_batch)
+{
+	JMongoDBBatch* batch;
+	JMongoDBData* bd = backend_data;
+	mongoc_write_concern_t* write_concern;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+
+	backend_create_index(bd, namespace);
+
 	write_concern = mongoc_write_concern_new();
 
 	if (j_semantics_get(semantics, J_SEMANTICS_SAFETY) != J_SEMANTICS_SAFETY_NONE)
@@ -98,30 +217,18 @@ backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* s
 		mongoc_write_concern_set_w(write_concern, MONGOC_WRITE_CONCERN_W_UNACKNOWLEDGED);
 	}
 
-	/* FIXME cache */
-	m_collection = mongoc_client_get_collection(bd->connection, bd->database, namespace);
-	m_database = mongoc_client_get_database(bd->connection, bd->database);
-
-	mongoc_database_write_command_with_opts(m_database, command, NULL, reply, NULL);
-
-	bson_init(opts);
-	mongoc_write_concern_append(write_concern, opts);
-
-	bulk_op = mongoc_collection_create_bulk_operation_with_opts(m_collection, opts);
+	batch = g_slice_new(JMongoDBBatch);
+	batch->collection = mongoc_client_get_collection(bd->connection, bd->database, namespace);
+	batch->bulk_op = NULL;
+	batch->namespace = g_strdup(namespace);
 
-	bson_free(opts);
+	bson_init(batch->opts);
+	mongoc_write_concern_append(write_concern, batch->opts);
+	// Unordered bulk writes let the server apply the operations in parallel
+	bson_append_bool(batch->opts, "ordered", -1, j_semantics_get(semantics, J_SEMANTICS_ORDERING) != J_SEMANTICS_ORDERING_RELAXED);
 
-	mongoc_collection_destroy(m_collection);
-	mongoc_database_destroy(m_database);
 	mongoc_write_concern_destroy(write_concern);
 
-	bson_destroy(command);
-	bson_destroy(reply);
-
-	batch = g_slice_new(JMongoDBBatch);
-	batch->bulk_op = bulk_op;
-	batch->namespace = g_strdup(namespace);
-
 	*backend_batch = batch;
 
 	return TRUE;
@@ -134,31 +241,31 @@ backend_batch_execute(gpointer backend_data, gpointer backend_batch)
 
 	JMongoDBBatch* batch = backend_batch;
 
-	bson_t reply[1];
-
 	(void)backend_data;
 
 	g_return_val_if_fail(backend_batch != NULL, FALSE);
 
-	ret = mongoc_bulk_operation_execute(batch->bulk_op, reply, NULL);
+	// Batches without writes do not need another round trip
+	ret = backend_batch_flush(batch);
 
-	/*
-	if (!ret)
-	{
-		bson_t error[1];
+	backend_batch_free(batch);
 
-		mongo_cmd_get_last_error(mongo_connection, store->name, error);
-		bson_print(error);
-		bson_destroy(error);
-	}
-	*/
+	return ret;
+}
 
-	mongoc_bulk_operation_destroy(batch->bulk_op);
-	bson_destroy(reply);
-	g_free(batch->namespace);
-	g_slice_free(JMongoDBBatch, batch);
+static gboolean
+backend_batch_abort(gpointer backend_data, gpointer backend_batch)
+{
+	JMongoDBBatch* batch = backend_batch;
 
-	return ret;
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+
+	// Writes are only sent when the batch is executed
+	backend_batch_free(batch);
+
+	return TRUE;
 }
 
 static gboolean
@@ -183,7 +290,7 @@ backend_put(gpointer backend_data, gpointer backend_batch, gchar const* key, gco
 
 	/* FIXME use insert when possible */
 	//mongoc_bulk_operation_insert(batch->bulk_op, document);
-	mongoc_bulk_operation_replace_one(batch->bulk_op, selector, document, TRUE);
+	mongoc_bulk_operation_replace_one(backend_batch_get_bulk(batch), selector, document, TRUE);
 
 	/*
 	if (!ret)
@@ -216,7 +323,8 @@ backend_delete(gpointer backend_data, gpointer backend_batch, gchar const* key)
 	bson_init(document);
 	bson_append_utf8(document, "key", -1, key, -1);
 
-	mongoc_bulk_operation_remove(batch->bulk_op, document);
+	// Keys are unique
+	mongoc_bulk_operation_remove_one(backend_batch_get_bulk(batch), document);
 
 	bson_destroy(document);
 
@@ -229,27 +337,32 @@ backend_get(gpointer backend_data, gpointer backend_batch, gchar const* key, gpo
 	gboolean ret = FALSE;
 
 	JMongoDBBatch* batch = backend_batch;
-	JMongoDBData* bd = backend_data;
 
 	bson_t document[1];
 	bson_t opts[1];
 	bson_t const* result;
-	mongoc_collection_t* m_collection;
 	mongoc_cursor_t* cursor;
 
+	(void)backend_data;
+
 	g_return_val_if_fail(backend_batch != NULL, FALSE);
 	g_return_val_if_fail(key != NULL, FALSE);
 	g_return_val_if_fail(value != NULL, FALSE);
 	g_return_val_if_fail(len != NULL, FALSE);
 
+	// Make the batch's previous writes visible
+	if (!backend_batch_flush(batch))
+	{
+		return FALSE;
+	}
+
 	bson_init(document);
 	bson_append_utf8(document, "key", -1, key, -1);
 
 	bson_init(opts);
 	bson_append_int32(opts, "limit", -1, 1);
 
-	m_collection = mongoc_client_get_collection(bd->connection, bd->database, batch->namespace);
-	cursor = mongoc_collection_find_with_opts(m_collection, document, opts, NULL);
+	cursor = mongoc_collection_find_with_opts(batch->collection, document, opts, NULL);
 
 	while (mongoc_cursor_next(cursor, &result))
 	{
@@ -277,7 +390,6 @@ backend_get(gpointer backend_data, gpointer backend_batch, gchar const* key, gpo
 	bson_destroy(document);
 
 	mongoc_cursor_destroy(cursor);
-	mongoc_collection_destroy(m_collection);
 
 	return ret;
 }
@@ -351,6 +463,66 @@ backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const
 	return ret;
 }
 
+static gboolean
+backend_get_range(gpointer backend_data, gchar const* namespace, gchar const* start, gchar const* end, gboolean reverse, guint32 limit, gpointer* backend_iterator)
+{
+	JMongoDBData* bd = backend_data;
+	gboolean ret = FALSE;
+
+	bson_t document[1];
+	bson_t opts[1];
+	bson_t range[1];
+	bson_t sort[1];
+	mongoc_collection_t* m_collection;
+	mongoc_cursor_t* cursor;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+
+	bson_init(document);
+	bson_append_document_begin(document, "key", -1, range);
+
+	if (start != NULL)
+	{
+		bson_append_utf8(range, "$gte", -1, start, -1);
+	}
+
+	if (end != NULL)
+	{
+		bson_append_utf8(range, "$lt", -1, end, -1);
+	}
+
+	// Strings compare by their UTF-8 bytes, matching the order of the other backends
+	bson_append_utf8(range, "$type", -1, "string", -1);
+	bson_append_document_end(document, range);
+
+	bson_init(opts);
+	bson_append_document_begin(opts, "sort", -1, sort);
+	bson_append_int32(sort, "key", -1, (reverse) ? -1 : 1);
+	bson_append_document_end(opts, sort);
+
+	if (limit > 0)
+	{
+		bson_append_int64(opts, "limit", -1, limit);
+	}
+
+	m_collection = mongoc_client_get_collection(bd->connection, bd->database, namespace);
+	cursor = mongoc_collection_find_with_opts(m_collection, document, opts, NULL);
+
+	if (cursor != NULL)
+	{
+		ret = TRUE;
+		*backend_iterator = cursor;
+	}
+
+	mongoc_collection_destroy(m_collection);
+
+	bson_destroy(opts);
+	bson_destroy(document);
+
+	return ret;
+}
+
 static gboolean
 backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const** key, gconstpointer* value, guint32* len)
 {
@@ -420,6 +592,8 @@ backend_init(gchar const* path, gpointer* backend_data)
 	bd = g_slice_new(JMongoDBData);
 	bd->host = g_strdup(split[0]);
 	bd->database = g_strdup(split[1]);
+	bd->indexed = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	g_mutex_init(&(bd->indexed_mutex));
 
 	g_return_val_if_fail(bd->host != NULL, FALSE);
 	g_return_val_if_fail(bd->database != NULL, FALSE);
@@ -458,6 +632,9 @@ backend_fini(gpointer backend_data)
 
 	mongoc_client_destroy(bd->connection);
 
+	g_hash_table_unref(bd->indexed);
+	g_mutex_clear(&(bd->indexed_mutex));
+
 	g_free(bd->database);
 	g_free(bd->host);
 
@@ -474,11 +651,13 @@ static JBackend mongodb_backend = {
 		.backend_fini = backend_fini,
 		.backend_batch_start = backend_batch_start,
 		.backend_batch_execute = backend_batch_execute,
+		.backend_batch_abort = backend_batch_abort,
 		.backend_put = backend_put,
 		.backend_delete = backend_delete,
 		.backend_get = backend_get,
 		.backend_get_all = backend_get_all,
 		.backend_get_by_prefix = backend_get_by_prefix,
+		.backend_get_range = backend_get_range,
 		.backend_iterate = backend_iterate }
 };
 
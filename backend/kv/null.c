@@ -41,10 +41,12 @@ backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* s
 static gboolean
 backend_batch_execute(gpointer backend_data, gpointer backend_batch)
 {
-	(void)backend_data;
+	JBackendLatency* latency = backend_data;
 
 	g_return_val_if_fail(backend_batch != NULL, FALSE);
 
+	j_backend_latency_inject(latency, J_BACKEND_LATENCY_WRITE, 0);
+
 	return TRUE;
 }
 
@@ -75,13 +77,15 @@ backend_delete(gpointer backend_data, gpointer backend_batch, gchar const* key)
 static gboolean
 backend_get(gpointer backend_data, gpointer backend_batch, gchar const* key, gpointer* value, guint32* len)
 {
-	(void)backend_data;
+	JBackendLatency* latency = backend_data;
 
 	g_return_val_if_fail(backend_batch != NULL, FALSE);
 	g_return_val_if_fail(key != NULL, FALSE);
 	g_return_val_if_fail(value != NULL, FALSE);
 	g_return_val_if_fail(len != NULL, FALSE);
 
+	j_backend_latency_inject(latency, J_BACKEND_LATENCY_READ, 0);
+
 	*value = NULL;
 	*len = 0;
 
@@ -91,11 +95,13 @@ backend_get(gpointer backend_data, gpointer backend_batch, gchar const* key, gpo
 static gboolean
 backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend_iterator)
 {
-	(void)backend_data;
+	JBackendLatency* latency = backend_data;
 
 	g_return_val_if_fail(namespace != NULL, FALSE);
 	g_return_val_if_fail(backend_iterator != NULL, FALSE);
 
+	j_backend_latency_inject(latency, J_BACKEND_LATENCY_READ, 0);
+
 	*backend_iterator = NULL;
 
 	return TRUE;
@@ -104,12 +110,34 @@ backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend
 static gboolean
 backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const* prefix, gpointer* backend_iterator)
 {
-	(void)backend_data;
+	JBackendLatency* latency = backend_data;
 
 	g_return_val_if_fail(namespace != NULL, FALSE);
 	g_return_val_if_fail(prefix != NULL, FALSE);
 	g_return_val_if_fail(backend_iterator != NULL, FALSE);
 
+	j_backend_latency_inject(latency, J_BACKEND_LATENCY_READ, 0);
+
+	*backend_iterator = NULL;
+
+	return TRUE;
+}
+
+static gboolean
+backend_get_range(gpointer backend_data, gchar const* namespace, gchar const* start, gchar const* end, gboolean reverse, guint32 limit, gpointer* backend_iterator)
+{
+	JBackendLatency* latency = backend_data;
+
+	(void)start;
+	(void)end;
+	(void)reverse;
+	(void)limit;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+
+	j_backend_latency_inject(latency, J_BACKEND_LATENCY_READ, 0);
+
 	*backend_iterator = NULL;
 
 	return TRUE;
@@ -134,8 +162,16 @@ backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const**
 static gboolean
 backend_init(gchar const* path, gpointer* backend_data)
 {
-	(void)path;
-	(void)backend_data;
+	JBackendLatency* latency;
+
+	// The path can be suffixed with a latency model (:read=100:write=~200)
+	if ((latency = j_backend_latency_new(path)) == NULL)
+	{
+		g_warning("Invalid latency model %s.", path);
+		return FALSE;
+	}
+
+	*backend_data = latency;
 
 	return TRUE;
 }
@@ -143,7 +179,9 @@ backend_init(gchar const* path, gpointer* backend_data)
 static void
 backend_fini(gpointer backend_data)
 {
-	(void)backend_data;
+	JBackendLatency* latency = backend_data;
+
+	j_backend_latency_free(latency);
 }
 
 static JBackend null_backend = {
@@ -159,6 +197,7 @@ static JBackend null_backend = {
 		.backend_get = backend_get,
 		.backend_get_all = backend_get_all,
 		.backend_get_by_prefix = backend_get_by_prefix,
+		.backend_get_range = backend_get_range,
 		.backend_iterate = backend_iterate }
 };
 
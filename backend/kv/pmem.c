@@ -0,0 +1,1402 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Required for MAP_SHARED_VALIDATE and MAP_SYNC
+#define _GNU_SOURCE
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <gmodule.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#endif
+
+#include <julea.h>
+
+/*
+ * The data is stored in a log in a memory-mapped file, ideally on a DAX file system backed by persistent memory.
+ * The file is split into two halves, only one of which is active at a time.
+ * Batches are appended to the active half as a sequence of records followed by a commit record and are made durable by flushing the CPU caches.
+ * When the active half is full, all live pairs are copied to the other half, which then becomes the active one.
+ * Every namespace has a hash table for lookups and a sequence ordered by key for iteration, both are rebuilt from the log on start.
+ */
+
+#define J_PMEM_MAGIC G_GUINT64_CONSTANT(0x31564b4d454d504a)
+
+/**
+ * The size of the header at the beginning of the file.
+ **/
+#define J_PMEM_HEADER_SIZE 4096
+
+/**
+ * The cache line size used for flushing.
+ **/
+#define J_PMEM_CACHE_LINE 64
+
+enum JPmemFlags
+{
+	J_PMEM_PUT = 1 << 0,
+	J_PMEM_DELETE = 1 << 1,
+	J_PMEM_COMMIT = 1 << 2
+};
+
+struct JPmemHeader
+{
+	guint64 magic;
+	guint64 size;
+
+	/**
+	 * The epoch of the active half, which is half epoch % 2.
+	 * It is increased with every compaction and written atomically.
+	 **/
+	guint64 epoch;
+};
+
+typedef struct JPmemHeader JPmemHeader;
+
+/**
+ * A record in the log, followed by the namespace, the key and the value and padded to eight bytes.
+ * A batch's records are only valid once its commit record follows them.
+ **/
+struct JPmemRecord
+{
+	/**
+	 * Covers the rest of the record, so torn records are detected.
+	 **/
+	guint32 crc;
+	guint32 flags;
+
+	/**
+	 * Records from a previous use of the half have a different epoch.
+	 **/
+	guint64 epoch;
+
+	/**
+	 * The batch's sequence number, which increases by one with every batch.
+	 * This keeps leftovers of batches that were interrupted by a crash from being committed later.
+	 **/
+	guint64 sequence;
+
+	guint32 namespace_length;
+	guint32 key_length;
+	guint32 value_length;
+	guint32 padding;
+};
+
+typedef struct JPmemRecord JPmemRecord;
+
+struct JPmemEntry
+{
+	gint ref_count;
+
+	gchar* key;
+
+	/**
+	 * The value's offset within the file.
+	 **/
+	guint64 offset;
+	guint32 length;
+};
+
+typedef struct JPmemEntry JPmemEntry;
+
+struct JPmemNamespace
+{
+	gchar* name;
+
+	GRWLock lock[1];
+
+	// key(gchar*) -> GSequenceIter* pointing to a JPmemEntry
+	GHashTable* entries;
+	GSequence* ordered;
+};
+
+typedef struct JPmemNamespace JPmemNamespace;
+
+struct JPmemData
+{
+	gint fd;
+	gchar* base;
+	guint64 size;
+	guint64 half_size;
+
+	/**
+	 * Whether the mapping is synchronous, so flushing the CPU caches makes data durable.
+	 **/
+	gboolean sync;
+
+	/**
+	 * Held as reader while accessing the log, compaction moves the values and needs it as writer.
+	 * Also protects the namespaces.
+	 **/
+	GRWLock lock[1];
+
+	// namespace(gchar*) -> JPmemNamespace*
+	GHashTable* namespaces;
+
+	/**
+	 * Serializes appends to the log.
+	 **/
+	GMutex log_mutex[1];
+
+	guint64 epoch;
+	guint64 tail;
+	guint64 sequence;
+};
+
+typedef struct JPmemData JPmemData;
+
+struct JPmemChange
+{
+	gchar* key;
+
+	// NULL for deletions
+	GBytes* value;
+};
+
+typedef struct JPmemChange JPmemChange;
+
+struct JPmemBatch
+{
+	JPmemNamespace* namespace;
+
+	// key(gchar*) -> JPmemChange*
+	GHashTable* changes;
+
+	/**
+	 * Whether the batch holds the locks needed to apply its changes.
+	 * They are taken by operations that have to read and modify atomically and held until the batch ends.
+	 **/
+	gboolean locked;
+};
+
+typedef struct JPmemBatch JPmemBatch;
+
+struct JPmemIterator
+{
+	// Copies, so the log can change while iterating
+	GPtrArray* keys;
+	GPtrArray* values;
+	guint index;
+};
+
+typedef struct JPmemIterator JPmemIterator;
+
+static guint64
+pmem_align(guint64 value)
+{
+	return (value + 7) & ~G_GUINT64_CONSTANT(7);
+}
+
+static guint64
+pmem_record_size(guint32 namespace_length, guint32 key_length, guint32 value_length)
+{
+	return pmem_align(sizeof(JPmemRecord) + namespace_length + key_length + value_length);
+}
+
+/**
+ * Makes a range of the mapping durable.
+ *
+ * \private
+ **/
+static void
+pmem_persist(JPmemData* bd, gconstpointer address, guint64 length)
+{
+	guintptr start = (guintptr)address;
+	guintptr end = start + length;
+
+	if (length == 0)
+	{
+		return;
+	}
+
+#if defined(__x86_64__) || defined(__i386__)
+	if (bd->sync)
+	{
+		for (guintptr line = start & ~(guintptr)(J_PMEM_CACHE_LINE - 1); line < end; line += J_PMEM_CACHE_LINE)
+		{
+			_mm_clflush((void const*)line);
+		}
+
+		_mm_sfence();
+
+		return;
+	}
+#endif
+
+	{
+		guintptr page_size = sysconf(_SC_PAGESIZE);
+		guintptr page = start & ~(page_size - 1);
+
+		msync((gpointer)page, end - page, MS_SYNC);
+	}
+}
+
+static gchar*
+pmem_half(JPmemData* bd, guint64 epoch)
+{
+	return bd->base + J_PMEM_HEADER_SIZE + (epoch % 2) * bd->half_size;
+}
+
+/**
+ * Computes a record's checksum.
+ *
+ * \private
+ **/
+static guint32
+pmem_record_crc(JPmemRecord const* record)
+{
+	return j_checksum_crc32c(0, (guint8 const*)record + sizeof(record->crc), sizeof(*record) - sizeof(record->crc) + record->namespace_length + record->key_length + record->value_length);
+}
+
+/**
+ * Writes a record to the log without making it durable.
+ *
+ * \private
+ *
+ * \return The offset of the record's value within the file.
+ **/
+static guint64
+pmem_record_write(JPmemData* bd, gchar* half, guint64 position, guint32 flags, guint64 epoch, guint64 sequence, gchar const* namespace, gchar const* key, gconstpointer value, guint32 value_length)
+{
+	JPmemRecord* record = (JPmemRecord*)(gpointer)(half + position);
+	gchar* payload = (gchar*)(record + 1);
+
+	record->flags = flags;
+	record->epoch = epoch;
+	record->sequence = sequence;
+	record->namespace_length = (namespace != NULL) ? strlen(namespace) : 0;
+	record->key_length = (key != NULL) ? strlen(key) : 0;
+	record->value_length = value_length;
+	record->padding = 0;
+
+	memcpy(payload, namespace, record->namespace_length);
+	memcpy(payload + record->namespace_length, key, record->key_length);
+	memcpy(payload + record->namespace_length + record->key_length, value, value_length);
+
+	record->crc = pmem_record_crc(record);
+
+	return (payload + record->namespace_length + record->key_length) - bd->base;
+}
+
+static JPmemEntry*
+pmem_entry_new(gchar const* key, guint64 offset, guint32 length)
+{
+	JPmemEntry* entry;
+
+	entry = g_slice_new(JPmemEntry);
+	entry->ref_count = 1;
+	entry->key = g_strdup(key);
+	entry->offset = offset;
+	entry->length = length;
+
+	return entry;
+}
+
+static void
+pmem_entry_unref(JPmemEntry* entry)
+{
+	if (g_atomic_int_dec_and_test(&(entry->ref_count)))
+	{
+		g_free(entry->key);
+		g_slice_free(JPmemEntry, entry);
+	}
+}
+
+static gint
+pmem_entry_compare(gconstpointer a, gconstpointer b, gpointer data)
+{
+	JPmemEntry const* entry_a = a;
+	JPmemEntry const* entry_b = b;
+
+	(void)data;
+
+	// strcmp compares unsigned bytes, matching the order of the other backends
+	return strcmp(entry_a->key, entry_b->key);
+}
+
+static JPmemNamespace*
+pmem_namespace_new(gchar const* name)
+{
+	JPmemNamespace* namespace;
+
+	namespace = g_slice_new(JPmemNamespace);
+	namespace->name = g_strdup(name);
+	g_rw_lock_init(namespace->lock);
+	// Keys are owned by the entries
+	namespace->entries = g_hash_table_new(g_str_hash, g_str_equal);
+	namespace->ordered = g_sequence_new((GDestroyNotify)pmem_entry_unref);
+
+	return namespace;
+}
+
+static void
+pmem_namespace_free(JPmemNamespace* namespace)
+{
+	g_hash_table_unref(namespace->entries);
+	g_sequence_free(namespace->ordered);
+	g_rw_lock_clear(namespace->lock);
+	g_free(namespace->name);
+	g_slice_free(JPmemNamespace, namespace);
+}
+
+/**
+ * Returns a namespace, creating it if necessary.
+ * Has to be called with the backend's lock held as reader, creating namespaces briefly takes the namespaces mutex.
+ *
+ * \private
+ **/
+static JPmemNamespace*
+pmem_namespace_get(JPmemData* bd, gchar const* name, gboolean create)
+{
+	static GMutex namespaces_mutex;
+
+	JPmemNamespace* namespace;
+
+	g_mutex_lock(&namespaces_mutex);
+
+	if ((namespace = g_hash_table_lookup(bd->namespaces, name)) == NULL && create)
+	{
+		namespace = pmem_namespace_new(name);
+		g_hash_table_insert(bd->namespaces, namespace->name, namespace);
+	}
+
+	g_mutex_unlock(&namespaces_mutex);
+
+	return namespace;
+}
+
+/**
+ * Replaces or removes a namespace's entry.
+ * Has to be called with the namespace's writer lock held.
+ *
+ * \private
+ **/
+static void
+pmem_namespace_apply(JPmemNamespace* namespace, gchar const* key, guint64 offset, guint32 length, gboolean put)
+{
+	GSequenceIter* it;
+
+	if ((it = g_hash_table_lookup(namespace->entries, key)) != NULL)
+	{
+		g_hash_table_remove(namespace->entries, key);
+		g_sequence_remove(it);
+	}
+
+	if (put)
+	{
+		JPmemEntry* entry;
+
+		entry = pmem_entry_new(key, offset, length);
+		it = g_sequence_insert_sorted(namespace->ordered, entry, pmem_entry_compare, NULL);
+		g_hash_table_insert(namespace->entries, entry->key, it);
+	}
+}
+
+/**
+ * Copies all live pairs to the inactive half and makes it the active one.
+ * Has to be called with the backend's lock held as writer.
+ *
+ * \private
+ *
+ * \return TRUE if all pairs fit, FALSE otherwise.
+ **/
+static gboolean
+pmem_compact(JPmemData* bd)
+{
+	JPmemHeader* header = (JPmemHeader*)(gpointer)bd->base;
+	g_autoptr(GPtrArray) entries = NULL;
+	g_autoptr(GArray) offsets = NULL;
+	GHashTableIter iter;
+	JPmemNamespace* namespace;
+	guint64 epoch = bd->epoch + 1;
+	gchar* half = pmem_half(bd, epoch);
+	guint64 position = 0;
+
+	entries = g_ptr_array_new();
+	offsets = g_array_new(FALSE, FALSE, sizeof(guint64));
+
+	// All pairs are written as a single batch
+	g_hash_table_iter_init(&iter, bd->namespaces);
+
+	while (g_hash_table_iter_next(&iter, NULL, (gpointer*)&namespace))
+	{
+		for (GSequenceIter* it = g_sequence_get_begin_iter(namespace->ordered); !g_sequence_iter_is_end(it); it = g_sequence_iter_next(it))
+		{
+			JPmemEntry* entry = g_sequence_get(it);
+			guint64 size;
+			guint64 offset;
+
+			size = pmem_record_size(strlen(namespace->name), strlen(entry->key), entry->length);
+
+			if (position + size + sizeof(JPmemRecord) > bd->half_size)
+			{
+				return FALSE;
+			}
+
+			offset = pmem_record_write(bd, half, position, J_PMEM_PUT, epoch, 1, namespace->name, entry->key, bd->base + entry->offset, entry->length);
+			position += size;
+
+			g_ptr_array_add(entries, entry);
+			g_array_append_val(offsets, offset);
+		}
+	}
+
+	pmem_persist(bd, half, position);
+	pmem_record_write(bd, half, position, J_PMEM_COMMIT, epoch, 1, NULL, NULL, NULL, 0);
+	pmem_persist(bd, half + position, sizeof(JPmemRecord));
+	position += sizeof(JPmemRecord);
+
+	// Aligned eight-byte stores are atomic, so switching the epoch makes the new half the active one at once
+	header->epoch = epoch;
+	pmem_persist(bd, &(header->epoch), sizeof(header->epoch));
+
+	for (guint i = 0; i < entries->len; i++)
+	{
+		((JPmemEntry*)g_ptr_array_index(entries, i))->offset = g_array_index(offsets, guint64, i);
+	}
+
+	bd->epoch = epoch;
+	bd->tail = position;
+	bd->sequence = 1;
+
+	return TRUE;
+}
+
+/**
+ * Makes sure that the active half has room for a batch, compacting the log if necessary.
+ * Must not be called with any locks held.
+ *
+ * \private
+ *
+ * \return TRUE if there is enough room, FALSE otherwise.
+ **/
+static gboolean
+pmem_reserve(JPmemData* bd, guint64 size)
+{
+	gboolean ret;
+
+	g_mutex_lock(bd->log_mutex);
+	ret = (bd->tail + size <= bd->half_size);
+	g_mutex_unlock(bd->log_mutex);
+
+	if (ret)
+	{
+		return TRUE;
+	}
+
+	g_rw_lock_writer_lock(bd->lock);
+
+	// Another thread might have compacted the log in the meantime
+	if (bd->tail + size > bd->half_size && !pmem_compact(bd))
+	{
+		g_warning("Persistent memory is full.");
+	}
+
+	ret = (bd->tail + size <= bd->half_size);
+
+	g_rw_lock_writer_unlock(bd->lock);
+
+	return ret;
+}
+
+/**
+ * Takes the locks needed to apply a batch's changes.
+ *
+ * \private
+ **/
+static void
+pmem_batch_lock(JPmemData* bd, JPmemBatch* batch)
+{
+	if (!batch->locked)
+	{
+		g_rw_lock_reader_lock(bd->lock);
+		g_rw_lock_writer_lock(batch->namespace->lock);
+		batch->locked = TRUE;
+	}
+}
+
+static void
+pmem_batch_unlock(JPmemData* bd, JPmemBatch* batch)
+{
+	if (batch->locked)
+	{
+		g_rw_lock_writer_unlock(batch->namespace->lock);
+		g_rw_lock_reader_unlock(bd->lock);
+		batch->locked = FALSE;
+	}
+}
+
+static void
+pmem_change_free(JPmemChange* change)
+{
+	if (change->value != NULL)
+	{
+		g_bytes_unref(change->value);
+	}
+
+	g_free(change->key);
+	g_slice_free(JPmemChange, change);
+}
+
+static void
+pmem_batch_change(JPmemBatch* batch, gchar const* key, gconstpointer value, guint32 len)
+{
+	JPmemChange* change;
+
+	change = g_slice_new(JPmemChange);
+	change->key = g_strdup(key);
+	change->value = (value != NULL) ? g_bytes_new(value, len) : NULL;
+
+	g_hash_table_replace(batch->changes, change->key, change);
+}
+
+static void
+pmem_batch_free(JPmemData* bd, JPmemBatch* batch)
+{
+	pmem_batch_unlock(bd, batch);
+	g_hash_table_unref(batch->changes);
+	g_slice_free(JPmemBatch, batch);
+}
+
+/**
+ * Returns a key's current value, taking the batch's own changes into account.
+ * Has to be called with the backend's lock held as reader and the namespace's lock held.
+ *
+ * \private
+ *
+ * \return A copy of the value, NULL if the key does not exist.
+ **/
+static GBytes*
+pmem_batch_lookup(JPmemData* bd, JPmemBatch* batch, gchar const* key)
+{
+	JPmemChange* change;
+	GSequenceIter* it;
+
+	if ((change = g_hash_table_lookup(batch->changes, key)) != NULL)
+	{
+		return (change->value != NULL) ? g_bytes_ref(change->value) : NULL;
+	}
+
+	if ((it = g_hash_table_lookup(batch->namespace->entries, key)) != NULL)
+	{
+		JPmemEntry const* entry = g_sequence_get(it);
+
+		return g_bytes_new(bd->base + entry->offset, entry->length);
+	}
+
+	return NULL;
+}
+
+/**
+ * Creates an iterator over a copy of a namespace's entries.
+ *
+ * \private
+ *
+ * \param bd        The backend data.
+ * \param name      The namespace's name.
+ * \param start     The first key, NULL to start at the beginning.
+ * \param end       The key to stop at (exclusive), NULL to continue until the end.
+ * \param prefix    The prefix all keys have to match, may be NULL.
+ * \param reverse   Whether to iterate in descending order.
+ * \param limit     The maximum number of entries, 0 for unlimited.
+ *
+ * \return A new iterator.
+ **/
+static JPmemIterator*
+pmem_iterator_new(JPmemData* bd, gchar const* name, gchar const* start, gchar const* end, gchar const* prefix, gboolean reverse, guint32 limit)
+{
+	JPmemIterator* iterator;
+	JPmemNamespace* namespace;
+
+	iterator = g_slice_new(JPmemIterator);
+	iterator->keys = g_ptr_array_new_with_free_func(g_free);
+	iterator->values = g_ptr_array_new_with_free_func((GDestroyNotify)g_bytes_unref);
+	iterator->index = 0;
+
+	if (prefix != NULL && (start == NULL || strcmp(prefix, start) > 0))
+	{
+		start = prefix;
+	}
+
+	g_rw_lock_reader_lock(bd->lock);
+
+	if ((namespace = pmem_namespace_get(bd, name, FALSE)) != NULL)
+	{
+		GSequenceIter* it;
+
+		g_rw_lock_reader_lock(namespace->lock);
+
+		if (start != NULL)
+		{
+			JPmemEntry lookup = { .key = (gchar*)(gintptr)start };
+
+			it = g_sequence_search(namespace->ordered, &lookup, pmem_entry_compare, NULL);
+
+			// g_sequence_search returns the position after equal entries
+			while (!g_sequence_iter_is_begin(it))
+			{
+				GSequenceIter* prev = g_sequence_iter_prev(it);
+
+				if (strcmp(((JPmemEntry*)g_sequence_get(prev))->key, start) < 0)
+				{
+					break;
+				}
+
+				it = prev;
+			}
+		}
+		else
+		{
+			it = g_sequence_get_begin_iter(namespace->ordered);
+		}
+
+		for (; !g_sequence_iter_is_end(it); it = g_sequence_iter_next(it))
+		{
+			JPmemEntry* entry = g_sequence_get(it);
+
+			if (end != NULL && strcmp(entry->key, end) >= 0)
+			{
+				break;
+			}
+
+			if (prefix != NULL && !g_str_has_prefix(entry->key, prefix))
+			{
+				break;
+			}
+
+			g_ptr_array_add(iterator->keys, g_strdup(entry->key));
+			g_ptr_array_add(iterator->values, g_bytes_new(bd->base + entry->offset, entry->length));
+
+			// Descending iteration needs the last entries of the range
+			if (!reverse && limit > 0 && iterator->keys->len == limit)
+			{
+				break;
+			}
+		}
+
+		g_rw_lock_reader_unlock(namespace->lock);
+	}
+
+	g_rw_lock_reader_unlock(bd->lock);
+
+	if (reverse)
+	{
+		guint len = iterator->keys->len;
+
+		for (guint i = 0; i < len / 2; i++)
+		{
+			gpointer tmp;
+
+			tmp = iterator->keys->pdata[i];
+			iterator->keys->pdata[i] = iterator->keys->pdata[len - i - 1];
+			iterator->keys->pdata[len - i - 1] = tmp;
+
+			tmp = iterator->values->pdata[i];
+			iterator->values->pdata[i] = iterator->values->pdata[len - i - 1];
+			iterator->values->pdata[len - i - 1] = tmp;
+		}
+
+		if (limit > 0 && len > limit)
+		{
+			g_ptr_array_set_size(iterator->keys, limit);
+			g_ptr_array_set_size(iterator->values, limit);
+		}
+	}
+
+	return iterator;
+}
+
+static void
+pmem_iterator_free(JPmemIterator* iterator)
+{
+	g_ptr_array_unref(iterator->keys);
+	g_ptr_array_unref(iterator->values);
+	g_slice_free(JPmemIterator, iterator);
+}
+
+static gboolean
+backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* backend_batch)
+{
+	JPmemBatch* batch;
+	JPmemData* bd = backend_data;
+
+	(void)semantics;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+
+	batch = g_slice_new(JPmemBatch);
+
+	// Compaction walks the namespaces
+	g_rw_lock_reader_lock(bd->lock);
+	batch->namespace = pmem_namespace_get(bd, namespace, TRUE);
+	g_rw_lock_reader_unlock(bd->lock);
+
+	batch->changes = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)pmem_change_free);
+	batch->locked = FALSE;
+
+	*backend_batch = batch;
+
+	return TRUE;
+}
+
+static gboolean
+backend_batch_execute(gpointer backend_data, gpointer backend_batch)
+{
+	JPmemBatch* batch = backend_batch;
+	JPmemData* bd = backend_data;
+	JPmemNamespace* namespace;
+	GHashTableIter iter;
+	JPmemChange* change;
+	g_autoptr(GArray) offsets = NULL;
+	gchar* half;
+	guint64 size = sizeof(JPmemRecord);
+	guint64 position;
+	guint64 sequence;
+	guint32 namespace_length;
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+
+	namespace = batch->namespace;
+	namespace_length = strlen(namespace->name);
+
+	if (g_hash_table_size(batch->changes) == 0)
+	{
+		goto end;
+	}
+
+	g_hash_table_iter_init(&iter, batch->changes);
+
+	while (g_hash_table_iter_next(&iter, NULL, (gpointer*)&change))
+	{
+		size += pmem_record_size(namespace_length, strlen(change->key), (change->value != NULL) ? g_bytes_get_size(change->value) : 0);
+	}
+
+	// Batches holding their locks cannot wait for a compaction, it is done beforehand by the operations taking the locks
+	if (!batch->locked && !pmem_reserve(bd, size))
+	{
+		ret = FALSE;
+		goto end;
+	}
+
+	pmem_batch_lock(bd, batch);
+
+	g_mutex_lock(bd->log_mutex);
+
+	if (bd->tail + size > bd->half_size)
+	{
+		g_mutex_unlock(bd->log_mutex);
+		ret = FALSE;
+		goto end;
+	}
+
+	half = pmem_half(bd, bd->epoch);
+	position = bd->tail;
+	sequence = bd->sequence + 1;
+	offsets = g_array_sized_new(FALSE, FALSE, sizeof(guint64), g_hash_table_size(batch->changes));
+
+	g_hash_table_iter_init(&iter, batch->changes);
+
+	while (g_hash_table_iter_next(&iter, NULL, (gpointer*)&change))
+	{
+		gconstpointer value = NULL;
+		gsize value_length = 0;
+		guint64 offset;
+
+		if (change->value != NULL)
+		{
+			value = g_bytes_get_data(change->value, &value_length);
+		}
+
+		offset = pmem_record_write(bd, half, position, (change->value != NULL) ? J_PMEM_PUT : J_PMEM_DELETE, bd->epoch, sequence, namespace->name, change->key, value, value_length);
+		position += pmem_record_size(namespace_length, strlen(change->key), value_length);
+
+		g_array_append_val(offsets, offset);
+	}
+
+	// The records have to be durable before the commit record
+	pmem_persist(bd, half + bd->tail, position - bd->tail);
+	pmem_record_write(bd, half, position, J_PMEM_COMMIT, bd->epoch, sequence, NULL, NULL, NULL, 0);
+	pmem_persist(bd, half + position, sizeof(JPmemRecord));
+
+	bd->tail = position + sizeof(JPmemRecord);
+	bd->sequence = sequence;
+
+	g_mutex_unlock(bd->log_mutex);
+
+	{
+		guint i = 0;
+
+		g_hash_table_iter_init(&iter, batch->changes);
+
+		while (g_hash_table_iter_next(&iter, NULL, (gpointer*)&change))
+		{
+			guint32 length = (change->value != NULL) ? g_bytes_get_size(change->value) : 0;
+
+			pmem_namespace_apply(namespace, change->key, g_array_index(offsets, guint64, i), length, change->value != NULL);
+			i++;
+		}
+	}
+
+end:
+	pmem_batch_free(bd, batch);
+
+	return ret;
+}
+
+static gboolean
+backend_batch_abort(gpointer backend_data, gpointer backend_batch)
+{
+	JPmemBatch* batch = backend_batch;
+	JPmemData* bd = backend_data;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+
+	pmem_batch_free(bd, batch);
+
+	return TRUE;
+}
+
+static gboolean
+backend_put(gpointer backend_data, gpointer backend_batch, gchar const* key, gconstpointer value, guint32 len)
+{
+	JPmemBatch* batch = backend_batch;
+	JPmemData* bd = backend_data;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+
+	// Fail early if the pair can never fit
+	if (pmem_record_size(strlen(batch->namespace->name), strlen(key), len) + sizeof(JPmemRecord) > bd->half_size)
+	{
+		return FALSE;
+	}
+
+	pmem_batch_change(batch, key, value, len);
+
+	return TRUE;
+}
+
+static gboolean
+backend_delete(gpointer backend_data, gpointer backend_batch, gchar const* key)
+{
+	JPmemBatch* batch = backend_batch;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+
+	pmem_batch_change(batch, key, NULL, 0);
+
+	return TRUE;
+}
+
+static gboolean
+backend_get(gpointer backend_data, gpointer backend_batch, gchar const* key, gpointer* value, guint32* len)
+{
+	JPmemBatch* batch = backend_batch;
+	JPmemData* bd = backend_data;
+	GBytes* bytes;
+	gconstpointer data;
+	gsize size;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+	g_return_val_if_fail(len != NULL, FALSE);
+
+	if (batch->locked)
+	{
+		bytes = pmem_batch_lookup(bd, batch, key);
+	}
+	else
+	{
+		g_rw_lock_reader_lock(bd->lock);
+		g_rw_lock_reader_lock(batch->namespace->lock);
+		bytes = pmem_batch_lookup(bd, batch, key);
+		g_rw_lock_reader_unlock(batch->namespace->lock);
+		g_rw_lock_reader_unlock(bd->lock);
+	}
+
+	if (bytes == NULL)
+	{
+		return FALSE;
+	}
+
+	data = g_bytes_get_data(bytes, &size);
+#if GLIB_CHECK_VERSION(2, 68, 0)
+	*value = g_memdup2(data, size);
+#else
+	*value = g_memdup(data, size);
+#endif
+	*len = size;
+
+	g_bytes_unref(bytes);
+
+	return TRUE;
+}
+
+static gboolean
+backend_compare_and_swap(gpointer backend_data, gpointer backend_batch, gchar const* key, gconstpointer expected, guint32 expected_len, gconstpointer value, guint32 len, gboolean* swapped)
+{
+	JPmemBatch* batch = backend_batch;
+	JPmemData* bd = backend_data;
+	g_autoptr(GBytes) current = NULL;
+	gboolean match;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+	g_return_val_if_fail(swapped != NULL, FALSE);
+
+	*swapped = FALSE;
+
+	// Holding the namespace until the batch ends makes the comparison and the update atomic
+	if (!batch->locked && !pmem_reserve(bd, bd->half_size / 4))
+	{
+		return FALSE;
+	}
+
+	pmem_batch_lock(bd, batch);
+
+	current = pmem_batch_lookup(bd, batch, key);
+
+	if (expected == NULL)
+	{
+		match = (current == NULL);
+	}
+	else
+	{
+		match = (current != NULL && g_bytes_get_size(current) == expected_len && memcmp(g_bytes_get_data(current, NULL), expected, expected_len) == 0);
+	}
+
+	if (match)
+	{
+		pmem_batch_change(batch, key, value, len);
+		*swapped = TRUE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+backend_add(gpointer backend_data, gpointer backend_batch, gchar const* key, gint64 delta, gint64* sum)
+{
+	JPmemBatch* batch = backend_batch;
+	JPmemData* bd = backend_data;
+	g_autoptr(GBytes) current = NULL;
+	gint64 value = 0;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+
+	if (!batch->locked && !pmem_reserve(bd, bd->half_size / 4))
+	{
+		return FALSE;
+	}
+
+	pmem_batch_lock(bd, batch);
+
+	current = pmem_batch_lookup(bd, batch, key);
+
+	if (current != NULL)
+	{
+		if (g_bytes_get_size(current) != sizeof(value))
+		{
+			return FALSE;
+		}
+
+		memcpy(&value, g_bytes_get_data(current, NULL), sizeof(value));
+		value = GINT64_FROM_LE(value);
+	}
+
+	value += delta;
+
+	if (sum != NULL)
+	{
+		*sum = value;
+	}
+
+	value = GINT64_TO_LE(value);
+	pmem_batch_change(batch, key, &value, sizeof(value));
+
+	return TRUE;
+}
+
+static gboolean
+backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend_iterator)
+{
+	JPmemData* bd = backend_data;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+
+	*backend_iterator = pmem_iterator_new(bd, namespace, NULL, NULL, NULL, FALSE, 0);
+
+	return TRUE;
+}
+
+static gboolean
+backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const* prefix, gpointer* backend_iterator)
+{
+	JPmemData* bd = backend_data;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(prefix != NULL, FALSE);
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+
+	*backend_iterator = pmem_iterator_new(bd, namespace, NULL, NULL, prefix, FALSE, 0);
+
+	return TRUE;
+}
+
+static gboolean
+backend_get_range(gpointer backend_data, gchar const* namespace, gchar const* start, gchar const* end, gboolean reverse, guint32 limit, gpointer* backend_iterator)
+{
+	JPmemData* bd = backend_data;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+
+	*backend_iterator = pmem_iterator_new(bd, namespace, start, end, NULL, reverse, limit);
+
+	return TRUE;
+}
+
+static gboolean
+backend_seek(gpointer backend_data, gpointer backend_iterator, gchar const* key)
+{
+	JPmemIterator* iterator = backend_iterator;
+	guint low;
+	guint high;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(iterator->index == 0, FALSE);
+
+	low = 0;
+	high = iterator->keys->len;
+
+	// Find the first entry that is not smaller than key
+	while (low < high)
+	{
+		guint mid = low + (high - low) / 2;
+
+		if (strcmp(g_ptr_array_index(iterator->keys, mid), key) < 0)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+
+	iterator->index = low;
+
+	return TRUE;
+}
+
+static gboolean
+backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const** key, gconstpointer* value, guint32* len)
+{
+	JPmemIterator* iterator = backend_iterator;
+	gsize size;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+	g_return_val_if_fail(len != NULL, FALSE);
+
+	if (iterator->index >= iterator->keys->len)
+	{
+		pmem_iterator_free(iterator);
+
+		return FALSE;
+	}
+
+	*key = g_ptr_array_index(iterator->keys, iterator->index);
+	*value = g_bytes_get_data(g_ptr_array_index(iterator->values, iterator->index), &size);
+	*len = size;
+
+	iterator->index++;
+
+	return TRUE;
+}
+
+static void
+backend_iterator_free(gpointer backend_data, gpointer backend_iterator)
+{
+	(void)backend_data;
+
+	g_return_if_fail(backend_iterator != NULL);
+
+	pmem_iterator_free(backend_iterator);
+}
+
+/**
+ * Rebuilds the namespaces from the active half of the log.
+ * Records following the last complete batch are ignored and overwritten later.
+ *
+ * \private
+ **/
+static void
+pmem_recover(JPmemData* bd)
+{
+	g_autoptr(GPtrArray) pending = NULL;
+	gchar* half = pmem_half(bd, bd->epoch);
+	guint64 position = 0;
+
+	pending = g_ptr_array_new();
+	bd->tail = 0;
+	bd->sequence = 0;
+
+	while (position + sizeof(JPmemRecord) <= bd->half_size)
+	{
+		JPmemRecord* record = (JPmemRecord*)(gpointer)(half + position);
+		guint64 size;
+
+		if (record->epoch != bd->epoch || record->sequence != bd->sequence + 1)
+		{
+			break;
+		}
+
+		size = pmem_record_size(record->namespace_length, record->key_length, record->value_length);
+
+		if (size > bd->half_size - position || record->crc != pmem_record_crc(record))
+		{
+			break;
+		}
+
+		position += size;
+
+		if (!(record->flags & J_PMEM_COMMIT))
+		{
+			g_ptr_array_add(pending, record);
+			continue;
+		}
+
+		for (guint i = 0; i < pending->len; i++)
+		{
+			JPmemRecord* put = g_ptr_array_index(pending, i);
+			gchar* payload = (gchar*)(put + 1);
+			g_autofree gchar* namespace = NULL;
+			g_autofree gchar* key = NULL;
+
+			namespace = g_strndup(payload, put->namespace_length);
+			key = g_strndup(payload + put->namespace_length, put->key_length);
+
+			pmem_namespace_apply(pmem_namespace_get(bd, namespace, TRUE), key, (payload + put->namespace_length + put->key_length) - bd->base, put->value_length, (put->flags & J_PMEM_PUT) != 0);
+		}
+
+		g_ptr_array_set_size(pending, 0);
+
+		bd->tail = position;
+		bd->sequence = record->sequence;
+	}
+}
+
+static gboolean
+backend_init(gchar const* path, gpointer* backend_data)
+{
+	JPmemData* bd;
+	JPmemHeader* header;
+	g_auto(GStrv) split = NULL;
+	g_autofree gchar* dirname = NULL;
+	struct stat buf;
+	guint64 size = 0;
+
+	g_return_val_if_fail(path != NULL, FALSE);
+
+	// The path can be suffixed with :size=MiB to set the size of new files
+	split = g_strsplit(path, ":", 0);
+
+	for (guint i = 1; split[0] != NULL && split[i] != NULL; i++)
+	{
+		if (g_str_has_prefix(split[i], "size="))
+		{
+			size = g_ascii_strtoull(split[i] + strlen("size="), NULL, 10) * 1024 * 1024;
+		}
+		else
+		{
+			return FALSE;
+		}
+	}
+
+	dirname = g_path_get_dirname(split[0]);
+	g_mkdir_with_parents(dirname, 0700);
+
+	bd = g_slice_new0(JPmemData);
+	g_rw_lock_init(bd->lock);
+	g_mutex_init(bd->log_mutex);
+	bd->namespaces = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)pmem_namespace_free);
+	bd->base = MAP_FAILED;
+
+	if ((bd->fd = open(split[0], O_RDWR | O_CREAT, 0600)) == -1 || fstat(bd->fd, &buf) != 0)
+	{
+		g_warning("Could not open %s: %s", split[0], g_strerror(errno));
+		goto error;
+	}
+
+	if (buf.st_size == 0)
+	{
+		// One gibibyte is enough for a lot of metadata
+		size = (size > 0) ? size : 1024 * 1024 * 1024;
+
+		if (posix_fallocate(bd->fd, 0, size) != 0)
+		{
+			goto error;
+		}
+	}
+	else
+	{
+		size = buf.st_size;
+	}
+
+	if (size < J_PMEM_HEADER_SIZE + 2 * 4096)
+	{
+		goto error;
+	}
+
+	bd->size = size;
+	bd->half_size = (size - J_PMEM_HEADER_SIZE) / 2 / 8 * 8;
+
+#ifdef MAP_SYNC
+	// Synchronous mappings are only supported on DAX file systems
+	bd->base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED_VALIDATE | MAP_SYNC, bd->fd, 0);
+	bd->sync = (bd->base != MAP_FAILED);
+#endif
+
+	if (bd->base == MAP_FAILED)
+	{
+		bd->base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, bd->fd, 0);
+	}
+
+	if (bd->base == MAP_FAILED)
+	{
+		g_warning("Could not map %s: %s", split[0], g_strerror(errno));
+		goto error;
+	}
+
+	if (!bd->sync)
+	{
+		g_debug("%s is not on a DAX file system, falling back to msync.", split[0]);
+	}
+
+	header = (JPmemHeader*)(gpointer)bd->base;
+
+	if (header->magic != J_PMEM_MAGIC)
+	{
+		// New files are zeroed, so both halves are empty
+		header->size = size;
+		header->epoch = 0;
+		pmem_persist(bd, header, sizeof(*header));
+
+		header->magic = J_PMEM_MAGIC;
+		pmem_persist(bd, header, sizeof(*header));
+	}
+	else if (header->size != size)
+	{
+		g_warning("%s has been resized.", split[0]);
+		goto error;
+	}
+
+	bd->epoch = header->epoch;
+	pmem_recover(bd);
+
+	*backend_data = bd;
+
+	return TRUE;
+
+error:
+	if (bd->base != MAP_FAILED)
+	{
+		munmap(bd->base, size);
+	}
+
+	if (bd->fd != -1)
+	{
+		close(bd->fd);
+	}
+
+	g_hash_table_unref(bd->namespaces);
+	g_mutex_clear(bd->log_mutex);
+	g_rw_lock_clear(bd->lock);
+	g_slice_free(JPmemData, bd);
+
+	return FALSE;
+}
+
+static void
+backend_fini(gpointer backend_data)
+{
+	JPmemData* bd = backend_data;
+
+	g_hash_table_unref(bd->namespaces);
+	munmap(bd->base, bd->size);
+	close(bd->fd);
+	g_mutex_clear(bd->log_mutex);
+	g_rw_lock_clear(bd->lock);
+	g_slice_free(JPmemData, bd);
+}
+
+static JBackend pmem_backend = {
+	.type = J_BACKEND_TYPE_KV,
+	.component = J_BACKEND_COMPONENT_SERVER,
+	.kv = {
+		.backend_init = backend_init,
+		.backend_fini = backend_fini,
+		.backend_batch_start = backend_batch_start,
+		.backend_batch_execute = backend_batch_execute,
+		.backend_batch_abort = backend_batch_abort,
+		.backend_put = backend_put,
+		.backend_delete = backend_delete,
+		.backend_get = backend_get,
+		.backend_compare_and_swap = backend_compare_and_swap,
+		.backend_add = backend_add,
+		.backend_get_all = backend_get_all,
+		.backend_get_by_prefix = backend_get_by_prefix,
+		.backend_get_range = backend_get_range,
+		.backend_iterate = backend_iterate,
+		.backend_seek = backend_seek,
+		.backend_iterator_free = backend_iterator_free }
+};
+
+G_MODULE_EXPORT
+JBackend*
+backend_info(void)
+{
+	return &pmem_backend;
+}
@@ -21,6 +21,8 @@
 #include <glib.h>
 #include <gmodule.h>
 
+#include <string.h>
+
 #include <rocksdb/c.h>
 
 #include <julea.h>
@@ -38,9 +40,20 @@ struct JRocksDBData
 {
 	rocksdb_t* db;
 
+	/**
+	 * The block cache shared by all tables.
+	 **/
+	rocksdb_cache_t* cache;
+
 	rocksdb_readoptions_t* read_options;
+	rocksdb_readoptions_t* read_options_iterator;
 	rocksdb_writeoptions_t* write_options;
 	rocksdb_writeoptions_t* write_options_sync;
+
+	/**
+	 * Serializes compare-and-swap and add, which are not isolated by write batches.
+	 **/
+	GMutex atomic_mutex;
 };
 
 typedef struct JRocksDBData JRocksDBData;
@@ -50,6 +63,28 @@ struct JRocksDBIterator
 	rocksdb_iterator_t* iterator;
 	gboolean first;
 	gchar* prefix;
+
+	/**
+	 * The key to start at, NULL to start at the prefix.
+	 **/
+	gchar* seek;
+
+	/**
+	 * The key to stop before, NULL to stop at the end of the prefix.
+	 **/
+	gchar* end;
+
+	/**
+	 * Whether keys are returned in descending order, starting before end.
+	 **/
+	gboolean reverse;
+
+	/**
+	 * The maximum number of pairs, 0 for no limit.
+	 **/
+	guint32 limit;
+	guint32 count;
+
 	gsize namespace_len;
 };
 
@@ -103,6 +138,24 @@ backend_batch_execute(gpointer backend_data, gpointer backend_batch)
 	return (rocksdb_error == NULL);
 }
 
+static gboolean
+backend_batch_abort(gpointer backend_data, gpointer backend_batch)
+{
+	JRocksDBBatch* batch = backend_batch;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+
+	// Nothing has been written yet, dropping the write batch discards all changes.
+	j_semantics_unref(batch->semantics);
+	g_free(batch->namespace);
+	rocksdb_writebatch_destroy(batch->batch);
+	g_slice_free(JRocksDBBatch, batch);
+
+	return TRUE;
+}
+
 static gboolean
 backend_put(gpointer backend_data, gpointer backend_batch, gchar const* key, gconstpointer value, guint32 len)
 {
@@ -168,6 +221,184 @@ backend_get(gpointer backend_data, gpointer backend_batch, gchar const* key, gpo
 	return (result != NULL);
 }
 
+static gboolean
+backend_get_multi(gpointer backend_data, gpointer backend_batch, gchar const** keys, guint32 count, gpointer* values, guint32* lens)
+{
+	JRocksDBBatch* batch = backend_batch;
+	JRocksDBData* bd = backend_data;
+	g_autofree gchar** nskeys = NULL;
+	g_autofree gsize* nskeys_len = NULL;
+	g_autofree gchar** results = NULL;
+	g_autofree gsize* results_len = NULL;
+	g_autofree gchar** errors = NULL;
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(keys != NULL, FALSE);
+	g_return_val_if_fail(values != NULL, FALSE);
+	g_return_val_if_fail(lens != NULL, FALSE);
+
+	nskeys = g_new(gchar*, count);
+	nskeys_len = g_new(gsize, count);
+	results = g_new0(gchar*, count);
+	results_len = g_new0(gsize, count);
+	errors = g_new0(gchar*, count);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		nskeys[i] = g_strdup_printf("%s:%s", batch->namespace, keys[i]);
+		nskeys_len[i] = strlen(nskeys[i]) + 1;
+	}
+
+	rocksdb_multi_get(bd->db, bd->read_options, count, (gchar const* const*)nskeys, nskeys_len, results, results_len, errors);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		values[i] = NULL;
+		lens[i] = 0;
+
+		if (errors[i] != NULL)
+		{
+			ret = FALSE;
+			rocksdb_free(errors[i]);
+		}
+		else if (results[i] != NULL)
+		{
+			// g_memdup2() returns NULL for empty values, which would mark the key as missing
+			values[i] = g_malloc(MAX(results_len[i], 1));
+			memcpy(values[i], results[i], results_len[i]);
+			lens[i] = results_len[i];
+		}
+
+		rocksdb_free(results[i]);
+		g_free(nskeys[i]);
+	}
+
+	return ret;
+}
+
+/**
+ * Writes a value directly instead of adding it to the batch.
+ * Write batches are not visible to reads before they are executed, so compare-and-swap and add have to apply their changes immediately.
+ *
+ * \private
+ *
+ * \param bd    The backend data.
+ * \param batch A batch.
+ * \param key   A namespaced key.
+ * \param value A value.
+ * \param len   The value's length.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+backend_put_now(JRocksDBData* bd, JRocksDBBatch* batch, gchar const* key, gconstpointer value, gsize len)
+{
+	g_autofree gchar* rocksdb_error = NULL;
+
+	rocksdb_writeoptions_t* write_options = bd->write_options;
+
+	if (j_semantics_get(batch->semantics, J_SEMANTICS_SAFETY) == J_SEMANTICS_SAFETY_STORAGE)
+	{
+		write_options = bd->write_options_sync;
+	}
+
+	rocksdb_put(bd->db, write_options, key, strlen(key) + 1, value, len, &rocksdb_error);
+
+	return (rocksdb_error == NULL);
+}
+
+static gboolean
+backend_compare_and_swap(gpointer backend_data, gpointer backend_batch, gchar const* key, gconstpointer expected, guint32 expected_len, gconstpointer value, guint32 len, gboolean* swapped)
+{
+	JRocksDBBatch* batch = backend_batch;
+	JRocksDBData* bd = backend_data;
+	g_autoptr(GMutexLocker) locker = NULL;
+	g_autofree gchar* nskey = NULL;
+	g_autofree gchar* rocksdb_error = NULL;
+	g_autofree gpointer result = NULL;
+	gsize result_len;
+	gboolean match;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+	g_return_val_if_fail(swapped != NULL, FALSE);
+
+	*swapped = FALSE;
+
+	nskey = g_strdup_printf("%s:%s", batch->namespace, key);
+
+	locker = g_mutex_locker_new(&(bd->atomic_mutex));
+	result = rocksdb_get(bd->db, bd->read_options, nskey, strlen(nskey) + 1, &result_len, &rocksdb_error);
+
+	if (rocksdb_error != NULL)
+	{
+		return FALSE;
+	}
+
+	if (expected == NULL)
+	{
+		match = (result == NULL);
+	}
+	else
+	{
+		match = (result != NULL && result_len == expected_len && memcmp(result, expected, expected_len) == 0);
+	}
+
+	if (!match)
+	{
+		return TRUE;
+	}
+
+	*swapped = backend_put_now(bd, batch, nskey, value, len);
+
+	return *swapped;
+}
+
+static gboolean
+backend_add(gpointer backend_data, gpointer backend_batch, gchar const* key, gint64 delta, gint64* result)
+{
+	JRocksDBBatch* batch = backend_batch;
+	JRocksDBData* bd = backend_data;
+	g_autoptr(GMutexLocker) locker = NULL;
+	g_autofree gchar* nskey = NULL;
+	g_autofree gchar* rocksdb_error = NULL;
+	g_autofree gpointer current = NULL;
+	gsize current_len;
+	gint64 sum = 0;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(result != NULL, FALSE);
+
+	nskey = g_strdup_printf("%s:%s", batch->namespace, key);
+
+	locker = g_mutex_locker_new(&(bd->atomic_mutex));
+	current = rocksdb_get(bd->db, bd->read_options, nskey, strlen(nskey) + 1, &current_len, &rocksdb_error);
+
+	if (rocksdb_error != NULL)
+	{
+		return FALSE;
+	}
+
+	if (current != NULL)
+	{
+		if (current_len != sizeof(sum))
+		{
+			return FALSE;
+		}
+
+		memcpy(&sum, current, sizeof(sum));
+		sum = GINT64_FROM_LE(sum);
+	}
+
+	*result = sum + delta;
+	sum = GINT64_TO_LE(*result);
+
+	return backend_put_now(bd, batch, nskey, &sum, sizeof(sum));
+}
+
 static gboolean
 backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend_iterator)
 {
@@ -178,13 +409,18 @@ backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend
 	g_return_val_if_fail(namespace != NULL, FALSE);
 	g_return_val_if_fail(backend_iterator != NULL, FALSE);
 
-	it = rocksdb_create_iterator(bd->db, bd->read_options);
+	it = rocksdb_create_iterator(bd->db, bd->read_options_iterator);
 
 	if (it != NULL)
 	{
 		iterator = g_slice_new(JRocksDBIterator);
 		iterator->iterator = it;
 		iterator->first = TRUE;
+		iterator->seek = NULL;
+		iterator->end = NULL;
+		iterator->reverse = FALSE;
+		iterator->limit = 0;
+		iterator->count = 0;
 		iterator->prefix = g_strdup_printf("%s:", namespace);
 		iterator->namespace_len = strlen(namespace) + 1;
 
@@ -205,13 +441,18 @@ backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const
 	g_return_val_if_fail(prefix != NULL, FALSE);
 	g_return_val_if_fail(backend_iterator != NULL, FALSE);
 
-	it = rocksdb_create_iterator(bd->db, bd->read_options);
+	it = rocksdb_create_iterator(bd->db, bd->read_options_iterator);
 
 	if (it != NULL)
 	{
 		iterator = g_slice_new(JRocksDBIterator);
 		iterator->iterator = it;
 		iterator->first = TRUE;
+		iterator->seek = NULL;
+		iterator->end = NULL;
+		iterator->reverse = FALSE;
+		iterator->limit = 0;
+		iterator->count = 0;
 		iterator->prefix = g_strdup_printf("%s:%s", namespace, prefix);
 		iterator->namespace_len = strlen(namespace) + 1;
 
@@ -221,6 +462,75 @@ backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const
 	return (iterator != NULL);
 }
 
+static gboolean
+backend_get_range(gpointer backend_data, gchar const* namespace, gchar const* start, gchar const* end, gboolean reverse, guint32 limit, gpointer* backend_iterator)
+{
+	JRocksDBData* bd = backend_data;
+	JRocksDBIterator* iterator = NULL;
+	rocksdb_iterator_t* it;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+
+	it = rocksdb_create_iterator(bd->db, bd->read_options_iterator);
+
+	if (it != NULL)
+	{
+		iterator = g_slice_new(JRocksDBIterator);
+		iterator->iterator = it;
+		iterator->first = TRUE;
+		iterator->seek = (start != NULL) ? g_strdup_printf("%s:%s", namespace, start) : NULL;
+		iterator->end = (end != NULL) ? g_strdup_printf("%s:%s", namespace, end) : NULL;
+		iterator->reverse = reverse;
+		iterator->limit = limit;
+		iterator->count = 0;
+		iterator->prefix = g_strdup_printf("%s:", namespace);
+		iterator->namespace_len = strlen(namespace) + 1;
+
+		*backend_iterator = iterator;
+	}
+
+	return (iterator != NULL);
+}
+
+static void
+backend_iterator_free(gpointer backend_data, gpointer backend_iterator)
+{
+	JRocksDBIterator* iterator = backend_iterator;
+
+	(void)backend_data;
+
+	g_free(iterator->prefix);
+	g_free(iterator->seek);
+	g_free(iterator->end);
+	rocksdb_iter_destroy(iterator->iterator);
+	g_slice_free(JRocksDBIterator, iterator);
+}
+
+static gboolean
+backend_seek(gpointer backend_data, gpointer backend_iterator, gchar const* key)
+{
+	JRocksDBIterator* iterator = backend_iterator;
+	g_autofree gchar* nskey = NULL;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(iterator->first, FALSE);
+
+	nskey = g_strdup_printf("%.*s%s", (gint)iterator->namespace_len, iterator->prefix, key);
+
+	// Keys before the prefix would end the iteration immediately
+	if (strcmp(nskey, iterator->prefix) > 0)
+	{
+		g_free(iterator->seek);
+		iterator->seek = g_steal_pointer(&nskey);
+	}
+
+	return TRUE;
+}
+
 static gboolean
 backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const** key, gconstpointer* value, guint32* len)
 {
@@ -233,10 +543,40 @@ backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const**
 	g_return_val_if_fail(value != NULL, FALSE);
 	g_return_val_if_fail(len != NULL, FALSE);
 
-	if (iterator->first)
+	if (iterator->limit > 0 && iterator->count == iterator->limit)
 	{
-		rocksdb_iter_seek(iterator->iterator, iterator->prefix, strlen(iterator->prefix));
+		goto out;
+	}
+
+	if (iterator->first && iterator->reverse)
+	{
+		// 0xff does not occur in UTF-8, so it sorts after all keys of the namespace
+		g_autofree gchar* upper = (iterator->end != NULL) ? g_strdup(iterator->end) : g_strdup_printf("%s\xff", iterator->prefix);
+
+		rocksdb_iter_seek_for_prev(iterator->iterator, upper, strlen(upper));
 		iterator->first = FALSE;
+
+		// The end key itself is excluded
+		if (rocksdb_iter_valid(iterator->iterator))
+		{
+			gsize tmp;
+
+			if (strcmp(rocksdb_iter_key(iterator->iterator, &tmp), upper) >= 0)
+			{
+				rocksdb_iter_prev(iterator->iterator);
+			}
+		}
+	}
+	else if (iterator->first)
+	{
+		gchar const* start = (iterator->seek != NULL) ? iterator->seek : iterator->prefix;
+
+		rocksdb_iter_seek(iterator->iterator, start, strlen(start));
+		iterator->first = FALSE;
+	}
+	else if (iterator->reverse)
+	{
+		rocksdb_iter_prev(iterator->iterator);
 	}
 	else
 	{
@@ -255,6 +595,18 @@ backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const**
 			goto out;
 		}
 
+		if (iterator->reverse && iterator->seek != NULL && strcmp(key_, iterator->seek) < 0)
+		{
+			goto out;
+		}
+
+		if (!iterator->reverse && iterator->end != NULL && strcmp(key_, iterator->end) >= 0)
+		{
+			goto out;
+		}
+
+		iterator->count++;
+
 		*key = key_ + iterator->namespace_len;
 		*value = rocksdb_iter_value(iterator->iterator, &tmp);
 		*len = tmp;
@@ -263,41 +615,128 @@ backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const**
 	}
 
 out:
-	g_free(iterator->prefix);
-	rocksdb_iter_destroy(iterator->iterator);
-	g_slice_free(JRocksDBIterator, iterator);
+	backend_iterator_free(backend_data, iterator);
 
 	return FALSE;
 }
 
+/**
+ * Extracts the namespace from a key of the form namespace:key.
+ * This allows bloom filters to skip SST files that do not contain a namespace
+ * and keeps iterators from walking other namespaces.
+ **/
+static gchar*
+backend_namespace_transform(gpointer state, gchar const* key, gsize length, gsize* prefix_length)
+{
+	gchar const* separator;
+
+	(void)state;
+
+	separator = memchr(key, ':', length);
+	*prefix_length = (separator != NULL) ? (gsize)(separator - key) + 1 : length;
+
+	return (gchar*)key;
+}
+
+static guchar
+backend_namespace_in_domain(gpointer state, gchar const* key, gsize length)
+{
+	(void)state;
+
+	return (memchr(key, ':', length) != NULL);
+}
+
+static guchar
+backend_namespace_in_range(gpointer state, gchar const* key, gsize length)
+{
+	(void)state;
+	(void)key;
+	(void)length;
+
+	return 0;
+}
+
+static gchar const*
+backend_namespace_name(gpointer state)
+{
+	(void)state;
+
+	return "julea.namespace";
+}
+
 static gboolean
 backend_init(gchar const* path, gpointer* backend_data)
 {
 	JRocksDBData* bd;
 	rocksdb_options_t* options;
+	rocksdb_block_based_table_options_t* table_options;
+	g_auto(GStrv) split = NULL;
 	g_autofree gchar* dirname = NULL;
 	gint const compressions[] = { rocksdb_lz4_compression, rocksdb_snappy_compression, rocksdb_no_compression };
+	guint64 block_cache_size = 64;
+	guint64 write_buffer_size = 64;
 
 	g_return_val_if_fail(path != NULL, FALSE);
 
-	dirname = g_path_get_dirname(path);
+	/* Path syntax: [path](:[option]=[value])*
+	   e.g.: /var/storage/rocksdb:block-cache=512:write-buffer=128
+	   Sizes are given in MiB. */
+	split = g_strsplit(path, ":", 0);
+
+	for (guint i = 1; split[i] != NULL; i++)
+	{
+		g_auto(GStrv) option = NULL;
+
+		option = g_strsplit(split[i], "=", 2);
+
+		if (option[0] == NULL || option[1] == NULL)
+		{
+			g_warning("Ignoring invalid RocksDB option %s.", split[i]);
+		}
+		else if (g_strcmp0(option[0], "block-cache") == 0)
+		{
+			block_cache_size = g_ascii_strtoull(option[1], NULL, 10);
+		}
+		else if (g_strcmp0(option[0], "write-buffer") == 0)
+		{
+			write_buffer_size = g_ascii_strtoull(option[1], NULL, 10);
+		}
+		else
+		{
+			g_warning("Ignoring unknown RocksDB option %s.", option[0]);
+		}
+	}
+
+	dirname = g_path_get_dirname(split[0]);
 	g_mkdir_with_parents(dirname, 0700);
 
 	bd = g_slice_new(JRocksDBData);
+	bd->cache = rocksdb_cache_create_lru(block_cache_size * 1024 * 1024);
 	bd->read_options = rocksdb_readoptions_create();
+	bd->read_options_iterator = rocksdb_readoptions_create();
 	bd->write_options = rocksdb_writeoptions_create();
 	bd->write_options_sync = rocksdb_writeoptions_create();
+	g_mutex_init(&(bd->atomic_mutex));
+	rocksdb_readoptions_set_prefix_same_as_start(bd->read_options_iterator, 1);
 	rocksdb_writeoptions_set_sync(bd->write_options_sync, 1);
 
+	table_options = rocksdb_block_based_options_create();
+	rocksdb_block_based_options_set_block_cache(table_options, bd->cache);
+	rocksdb_block_based_options_set_filter_policy(table_options, rocksdb_filterpolicy_create_bloom(10));
+
 	options = rocksdb_options_create();
 	rocksdb_options_set_create_if_missing(options, 1);
+	rocksdb_options_set_write_buffer_size(options, write_buffer_size * 1024 * 1024);
+	rocksdb_options_set_prefix_extractor(options, rocksdb_slicetransform_create(NULL, NULL, backend_namespace_transform, backend_namespace_in_domain, backend_namespace_in_range, backend_namespace_name));
+	rocksdb_options_set_memtable_prefix_bloom_size_ratio(options, 0.1);
+	rocksdb_options_set_block_based_table_factory(options, table_options);
 
 	for (guint i = 0; i < G_N_ELEMENTS(compressions); i++)
 	{
 		g_autofree gchar* error = NULL;
 
 		rocksdb_options_set_compression(options, compressions[i]);
-		bd->db = rocksdb_open(options, path, &error);
+		bd->db = rocksdb_open(options, split[0], &error);
 
 		if (bd->db != NULL)
 		{
@@ -306,6 +745,7 @@ backend_init(gchar const* path, gpointer* backend_data)
 	}
 
 	rocksdb_options_destroy(options);
+	rocksdb_block_based_options_destroy(table_options);
 
 	*backend_data = bd;
 
@@ -318,14 +758,18 @@ backend_fini(gpointer backend_data)
 	JRocksDBData* bd = backend_data;
 
 	rocksdb_readoptions_destroy(bd->read_options);
+	rocksdb_readoptions_destroy(bd->read_options_iterator);
 	rocksdb_writeoptions_destroy(bd->write_options);
 	rocksdb_writeoptions_destroy(bd->write_options_sync);
+	g_mutex_clear(&(bd->atomic_mutex));
 
 	if (bd->db != NULL)
 	{
 		rocksdb_close(bd->db);
 	}
 
+	rocksdb_cache_destroy(bd->cache);
+
 	g_slice_free(JRocksDBData, bd);
 }
 
@@ -337,12 +781,19 @@ static JBackend rocksdb_backend = {
 		.backend_fini = backend_fini,
 		.backend_batch_start = backend_batch_start,
 		.backend_batch_execute = backend_batch_execute,
+		.backend_batch_abort = backend_batch_abort,
 		.backend_put = backend_put,
 		.backend_delete = backend_delete,
 		.backend_get = backend_get,
+		.backend_get_multi = backend_get_multi,
+		.backend_compare_and_swap = backend_compare_and_swap,
+		.backend_add = backend_add,
 		.backend_get_all = backend_get_all,
 		.backend_get_by_prefix = backend_get_by_prefix,
-		.backend_iterate = backend_iterate }
+		.backend_get_range = backend_get_range,
+		.backend_iterate = backend_iterate,
+		.backend_seek = backend_seek,
+		.backend_iterator_free = backend_iterator_free }
 };
 
 G_MODULE_EXPORT
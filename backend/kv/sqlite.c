@@ -21,10 +21,17 @@
 #include <glib.h>
 #include <gmodule.h>
 
+#include <string.h>
+
 #include <sqlite3.h>
 
 #include <julea.h>
 
+/**
+ * How long a connection waits for the write lock held by another thread's connection, in milliseconds.
+ **/
+#define J_SQLITE_BUSY_TIMEOUT 10000
+
 struct JSQLiteBatch
 {
 	gchar* namespace;
@@ -35,21 +42,310 @@ typedef struct JSQLiteBatch JSQLiteBatch;
 
 struct JSQLiteData
 {
-	sqlite3* db;
+	gchar* path;
+
+	/**
+	 * The journal mode (WAL by default).
+	 **/
+	gchar const* journal_mode;
+
+	/**
+	 * The synchronous level used for batches that do not require storage safety.
+	 **/
+	gchar const* synchronous;
+
+	/**
+	 * The mmap size in bytes, 0 disables memory mapping.
+	 **/
+	guint64 mmap_size;
 };
 
 typedef struct JSQLiteData JSQLiteData;
 
+/**
+ * Per-thread connection with its cached prepared statements.
+ **/
+struct JSQLiteThread
+{
+	JSQLiteData* bd;
+	sqlite3* db;
+
+	/**
+	 * Whether the connection currently uses PRAGMA synchronous = FULL.
+	 **/
+	gboolean synchronous_full;
+
+	sqlite3_stmt* put;
+	sqlite3_stmt* delete;
+	sqlite3_stmt* get;
+
+	/**
+	 * Iterator statements are handed out to iterators and set to NULL while in use.
+	 **/
+	sqlite3_stmt* get_all;
+	sqlite3_stmt* get_by_prefix;
+	sqlite3_stmt* get_range;
+	sqlite3_stmt* get_range_reverse;
+};
+
+typedef struct JSQLiteThread JSQLiteThread;
+
+struct JSQLiteIterator
+{
+	sqlite3_stmt* stmt;
+
+	/**
+	 * The cache slot the statement is returned to, NULL if it is not cached.
+	 **/
+	sqlite3_stmt** slot;
+};
+
+typedef struct JSQLiteIterator JSQLiteIterator;
+
+static gchar const* const sqlite_journal_modes[] = { "DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF", NULL };
+static gchar const* const sqlite_synchronous_levels[] = { "OFF", "NORMAL", "FULL", "EXTRA", NULL };
+
+static gchar const sqlite_sql_put[] = "INSERT OR REPLACE INTO julea (namespace, key, value) VALUES (?, ?, ?);";
+static gchar const sqlite_sql_delete[] = "DELETE FROM julea WHERE namespace = ? AND key = ?;";
+static gchar const sqlite_sql_get[] = "SELECT value FROM julea WHERE namespace = ? AND key = ?;";
+static gchar const sqlite_sql_get_all[] = "SELECT key, value FROM julea WHERE namespace = ?;";
+static gchar const sqlite_sql_get_by_prefix[] = "SELECT key, value FROM julea WHERE namespace = ? AND key LIKE ? || '%';";
+// Open upper bounds are bound as an empty blob, which sorts after all text values. A negative limit disables it.
+static gchar const sqlite_sql_get_range[] = "SELECT key, value FROM julea WHERE namespace = ? AND key >= ? AND key < ? ORDER BY key ASC LIMIT ?;";
+static gchar const sqlite_sql_get_range_reverse[] = "SELECT key, value FROM julea WHERE namespace = ? AND key >= ? AND key < ? ORDER BY key DESC LIMIT ?;";
+
+static void backend_thread_fini(gpointer data);
+static GPrivate backend_thread_global = G_PRIVATE_INIT(backend_thread_fini);
+
+/**
+ * Finalizes a thread's statements and closes its connection.
+ *
+ * \private
+ *
+ * \param data A JSQLiteThread.
+ **/
+static void
+backend_thread_fini(gpointer data)
+{
+	JSQLiteThread* thread = data;
+
+	if (thread == NULL)
+	{
+		return;
+	}
+
+	// sqlite3_finalize() accepts NULL
+	sqlite3_finalize(thread->put);
+	sqlite3_finalize(thread->delete);
+	sqlite3_finalize(thread->get);
+	sqlite3_finalize(thread->get_all);
+	sqlite3_finalize(thread->get_by_prefix);
+	sqlite3_finalize(thread->get_range);
+	sqlite3_finalize(thread->get_range_reverse);
+
+	sqlite3_close(thread->db);
+
+	g_slice_free(JSQLiteThread, thread);
+}
+
+/**
+ * Looks up a value in a NULL-terminated list of allowed values, ignoring case.
+ *
+ * \private
+ *
+ * \param values The allowed values.
+ * \param value  The value.
+ *
+ * \return The matching allowed value, or NULL.
+ **/
+static gchar const*
+backend_lookup_value(gchar const* const* values, gchar const* value)
+{
+	for (guint i = 0; values[i] != NULL; i++)
+	{
+		if (g_ascii_strcasecmp(values[i], value) == 0)
+		{
+			return values[i];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Sets the synchronous level of a connection.
+ *
+ * \private
+ *
+ * \param db    A connection.
+ * \param level A level from sqlite_synchronous_levels.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+backend_set_synchronous(sqlite3* db, gchar const* level)
+{
+	g_autofree gchar* sql = NULL;
+
+	sql = g_strdup_printf("PRAGMA synchronous = %s;", level);
+
+	return (sqlite3_exec(db, sql, NULL, NULL, NULL) == SQLITE_OK);
+}
+
+/**
+ * Opens a connection and applies the configured pragmas.
+ *
+ * \private
+ *
+ * \param bd The backend data.
+ *
+ * \return A connection on success, NULL otherwise.
+ **/
+static sqlite3*
+backend_open(JSQLiteData* bd)
+{
+	sqlite3* db = NULL;
+	g_autofree gchar* journal_mode = NULL;
+	g_autofree gchar* mmap_size = NULL;
+
+	if (sqlite3_open(bd->path, &db) != SQLITE_OK)
+	{
+		goto error;
+	}
+
+	sqlite3_busy_timeout(db, J_SQLITE_BUSY_TIMEOUT);
+
+	journal_mode = g_strdup_printf("PRAGMA journal_mode = %s;", bd->journal_mode);
+	mmap_size = g_strdup_printf("PRAGMA mmap_size = %" G_GUINT64_FORMAT ";", bd->mmap_size);
+
+	if (sqlite3_exec(db, journal_mode, NULL, NULL, NULL) != SQLITE_OK)
+	{
+		goto error;
+	}
+
+	if (!backend_set_synchronous(db, bd->synchronous))
+	{
+		goto error;
+	}
+
+	if (sqlite3_exec(db, mmap_size, NULL, NULL, NULL) != SQLITE_OK)
+	{
+		goto error;
+	}
+
+	return db;
+
+error:
+	sqlite3_close(db);
+
+	return NULL;
+}
+
+/**
+ * Returns the calling thread's connection, opening it and preparing its statements if necessary.
+ *
+ * \private
+ *
+ * \param bd The backend data.
+ *
+ * \return The thread's state on success, NULL otherwise.
+ **/
+static JSQLiteThread*
+backend_thread_get(JSQLiteData* bd)
+{
+	JSQLiteThread* thread;
+
+	thread = g_private_get(&backend_thread_global);
+
+	if (thread != NULL && thread->bd == bd)
+	{
+		return thread;
+	}
+
+	thread = g_slice_new0(JSQLiteThread);
+	thread->bd = bd;
+
+	if ((thread->db = backend_open(bd)) == NULL)
+	{
+		goto error;
+	}
+
+	if (sqlite3_prepare_v2(thread->db, sqlite_sql_put, -1, &(thread->put), NULL) != SQLITE_OK
+	    || sqlite3_prepare_v2(thread->db, sqlite_sql_delete, -1, &(thread->delete), NULL) != SQLITE_OK
+	    || sqlite3_prepare_v2(thread->db, sqlite_sql_get, -1, &(thread->get), NULL) != SQLITE_OK
+	    || sqlite3_prepare_v2(thread->db, sqlite_sql_get_all, -1, &(thread->get_all), NULL) != SQLITE_OK
+	    || sqlite3_prepare_v2(thread->db, sqlite_sql_get_by_prefix, -1, &(thread->get_by_prefix), NULL) != SQLITE_OK
+	    || sqlite3_prepare_v2(thread->db, sqlite_sql_get_range, -1, &(thread->get_range), NULL) != SQLITE_OK
+	    || sqlite3_prepare_v2(thread->db, sqlite_sql_get_range_reverse, -1, &(thread->get_range_reverse), NULL) != SQLITE_OK)
+	{
+		goto error;
+	}
+
+	// Replaces (and closes) a connection left over from a previous backend instance
+	g_private_replace(&backend_thread_global, thread);
+
+	return thread;
+
+error:
+	backend_thread_fini(thread);
+
+	return NULL;
+}
+
+/**
+ * Returns a statement to its cache slot or finalizes it if the slot has been refilled.
+ *
+ * \private
+ *
+ * \param stmt A statement.
+ * \param slot The statement's cache slot, may be NULL.
+ **/
+static void
+backend_statement_release(sqlite3_stmt* stmt, sqlite3_stmt** slot)
+{
+	sqlite3_reset(stmt);
+	sqlite3_clear_bindings(stmt);
+
+	if (slot != NULL && *slot == NULL)
+	{
+		*slot = stmt;
+	}
+	else
+	{
+		sqlite3_finalize(stmt);
+	}
+}
+
 static gboolean
 backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* backend_batch)
 {
 	JSQLiteBatch* batch = NULL;
 	JSQLiteData* bd = backend_data;
+	JSQLiteThread* thread;
+	gboolean synchronous_full;
 
 	g_return_val_if_fail(namespace != NULL, FALSE);
 	g_return_val_if_fail(backend_batch != NULL, FALSE);
 
-	if (sqlite3_exec(bd->db, "BEGIN TRANSACTION;", NULL, NULL, NULL) == SQLITE_OK)
+	if ((thread = backend_thread_get(bd)) == NULL)
+	{
+		goto end;
+	}
+
+	// The synchronous level cannot be changed inside a transaction, so it has to be set here
+	synchronous_full = (j_semantics_get(semantics, J_SEMANTICS_SAFETY) == J_SEMANTICS_SAFETY_STORAGE);
+
+	if (synchronous_full != thread->synchronous_full)
+	{
+		if (!backend_set_synchronous(thread->db, (synchronous_full) ? "FULL" : bd->synchronous))
+		{
+			goto end;
+		}
+
+		thread->synchronous_full = synchronous_full;
+	}
+
+	if (sqlite3_exec(thread->db, "BEGIN TRANSACTION;", NULL, NULL, NULL) == SQLITE_OK)
 	{
 		batch = g_slice_new(JSQLiteBatch);
 
@@ -57,6 +353,7 @@ backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* s
 		batch->semantics = j_semantics_ref(semantics);
 	}
 
+end:
 	*backend_batch = batch;
 
 	return (batch != NULL);
@@ -69,14 +366,46 @@ backend_batch_execute(gpointer backend_data, gpointer backend_batch)
 
 	JSQLiteBatch* batch = backend_batch;
 	JSQLiteData* bd = backend_data;
+	JSQLiteThread* thread;
 
 	g_return_val_if_fail(backend_batch != NULL, FALSE);
 
-	// FIXME do something with batch->semantics
+	if ((thread = backend_thread_get(bd)) != NULL)
+	{
+		if (sqlite3_exec(thread->db, "COMMIT;", NULL, NULL, NULL) == SQLITE_OK)
+		{
+			ret = TRUE;
+		}
+		else
+		{
+			sqlite3_exec(thread->db, "ROLLBACK;", NULL, NULL, NULL);
+		}
+	}
+
+	j_semantics_unref(batch->semantics);
+	g_free(batch->namespace);
+	g_slice_free(JSQLiteBatch, batch);
 
-	if (sqlite3_exec(bd->db, "COMMIT;", NULL, NULL, NULL) == SQLITE_OK)
+	return ret;
+}
+
+static gboolean
+backend_batch_abort(gpointer backend_data, gpointer backend_batch)
+{
+	gboolean ret = FALSE;
+
+	JSQLiteBatch* batch = backend_batch;
+	JSQLiteData* bd = backend_data;
+	JSQLiteThread* thread;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+
+	if ((thread = backend_thread_get(bd)) != NULL)
 	{
-		ret = TRUE;
+		if (sqlite3_exec(thread->db, "ROLLBACK;", NULL, NULL, NULL) == SQLITE_OK)
+		{
+			ret = TRUE;
+		}
 	}
 
 	j_semantics_unref(batch->semantics);
@@ -91,22 +420,31 @@ backend_put(gpointer backend_data, gpointer backend_batch, gchar const* key, gco
 {
 	JSQLiteBatch* batch = backend_batch;
 	JSQLiteData* bd = backend_data;
+	JSQLiteThread* thread;
 	sqlite3_stmt* stmt;
+	gint ret;
 
 	g_return_val_if_fail(backend_batch != NULL, FALSE);
 	g_return_val_if_fail(key != NULL, FALSE);
 	g_return_val_if_fail(value != NULL, FALSE);
 
-	sqlite3_prepare_v2(bd->db, "INSERT OR REPLACE INTO julea (namespace, key, value) VALUES (?, ?, ?);", -1, &stmt, NULL);
-	sqlite3_bind_text(stmt, 1, batch->namespace, -1, NULL);
-	sqlite3_bind_text(stmt, 2, key, -1, NULL);
-	sqlite3_bind_blob(stmt, 3, value, len, NULL);
+	if ((thread = backend_thread_get(bd)) == NULL)
+	{
+		return FALSE;
+	}
 
-	sqlite3_step(stmt);
-	sqlite3_finalize(stmt);
+	stmt = thread->put;
 
-	// FIXME
-	return TRUE;
+	sqlite3_bind_text(stmt, 1, batch->namespace, -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 2, key, -1, SQLITE_STATIC);
+	sqlite3_bind_blob(stmt, 3, value, len, SQLITE_STATIC);
+
+	ret = sqlite3_step(stmt);
+
+	sqlite3_reset(stmt);
+	sqlite3_clear_bindings(stmt);
+
+	return (ret == SQLITE_DONE);
 }
 
 static gboolean
@@ -114,20 +452,29 @@ backend_delete(gpointer backend_data, gpointer backend_batch, gchar const* key)
 {
 	JSQLiteBatch* batch = backend_batch;
 	JSQLiteData* bd = backend_data;
+	JSQLiteThread* thread;
 	sqlite3_stmt* stmt;
+	gint ret;
 
 	g_return_val_if_fail(backend_batch != NULL, FALSE);
 	g_return_val_if_fail(key != NULL, FALSE);
 
-	sqlite3_prepare_v2(bd->db, "DELETE FROM julea WHERE namespace = ? AND key = ?;", -1, &stmt, NULL);
-	sqlite3_bind_text(stmt, 1, batch->namespace, -1, NULL);
-	sqlite3_bind_text(stmt, 2, key, -1, NULL);
+	if ((thread = backend_thread_get(bd)) == NULL)
+	{
+		return FALSE;
+	}
+
+	stmt = thread->delete;
 
-	sqlite3_step(stmt);
-	sqlite3_finalize(stmt);
+	sqlite3_bind_text(stmt, 1, batch->namespace, -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 2, key, -1, SQLITE_STATIC);
 
-	// FIXME
-	return TRUE;
+	ret = sqlite3_step(stmt);
+
+	sqlite3_reset(stmt);
+	sqlite3_clear_bindings(stmt);
+
+	return (ret == SQLITE_DONE);
 }
 
 static gboolean
@@ -135,6 +482,7 @@ backend_get(gpointer backend_data, gpointer backend_batch, gchar const* key, gpo
 {
 	JSQLiteBatch* batch = backend_batch;
 	JSQLiteData* bd = backend_data;
+	JSQLiteThread* thread;
 	sqlite3_stmt* stmt;
 	gint ret;
 	gconstpointer result = NULL;
@@ -145,9 +493,15 @@ backend_get(gpointer backend_data, gpointer backend_batch, gchar const* key, gpo
 	g_return_val_if_fail(value != NULL, FALSE);
 	g_return_val_if_fail(len != NULL, FALSE);
 
-	sqlite3_prepare_v2(bd->db, "SELECT value FROM julea WHERE namespace = ? AND key = ?;", -1, &stmt, NULL);
-	sqlite3_bind_text(stmt, 1, batch->namespace, -1, NULL);
-	sqlite3_bind_text(stmt, 2, key, -1, NULL);
+	if ((thread = backend_thread_get(bd)) == NULL)
+	{
+		return FALSE;
+	}
+
+	stmt = thread->get;
+
+	sqlite3_bind_text(stmt, 1, batch->namespace, -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 2, key, -1, SQLITE_STATIC);
 
 	ret = sqlite3_step(stmt);
 
@@ -165,72 +519,155 @@ backend_get(gpointer backend_data, gpointer backend_batch, gchar const* key, gpo
 		*len = result_len;
 	}
 
-	sqlite3_finalize(stmt);
+	sqlite3_reset(stmt);
+	sqlite3_clear_bindings(stmt);
 
 	return (result != NULL);
 }
 
+/**
+ * Creates an iterator, taking the cached statement if it is not used by another iterator.
+ *
+ * \private
+ *
+ * \param thread The thread's state.
+ * \param slot   The statement's cache slot.
+ * \param sql    The statement's SQL, used if the cached statement is in use.
+ *
+ * \return An iterator on success, NULL otherwise.
+ **/
+static JSQLiteIterator*
+backend_iterator_new(JSQLiteThread* thread, sqlite3_stmt** slot, gchar const* sql)
+{
+	JSQLiteIterator* iterator;
+	sqlite3_stmt* stmt = *slot;
+
+	if (stmt != NULL)
+	{
+		*slot = NULL;
+	}
+	else if (sqlite3_prepare_v2(thread->db, sql, -1, &stmt, NULL) != SQLITE_OK)
+	{
+		return NULL;
+	}
+
+	iterator = g_slice_new(JSQLiteIterator);
+	iterator->stmt = stmt;
+	iterator->slot = slot;
+
+	return iterator;
+}
+
 static gboolean
 backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend_iterator)
 {
 	JSQLiteData* bd = backend_data;
-	sqlite3_stmt* stmt = NULL;
+	JSQLiteThread* thread;
+	JSQLiteIterator* iterator = NULL;
 
 	g_return_val_if_fail(namespace != NULL, FALSE);
 	g_return_val_if_fail(backend_iterator != NULL, FALSE);
 
-	if (sqlite3_prepare_v2(bd->db, "SELECT key, value FROM julea WHERE namespace = ?;", -1, &stmt, NULL) == SQLITE_OK)
+	if ((thread = backend_thread_get(bd)) != NULL
+	    && (iterator = backend_iterator_new(thread, &(thread->get_all), sqlite_sql_get_all)) != NULL)
 	{
-		sqlite3_bind_text(stmt, 1, namespace, -1, NULL);
+		sqlite3_bind_text(iterator->stmt, 1, namespace, -1, SQLITE_STATIC);
 	}
 
-	*backend_iterator = stmt;
+	*backend_iterator = iterator;
 
-	return (stmt != NULL);
+	return (iterator != NULL);
 }
 
 static gboolean
 backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const* prefix, gpointer* backend_iterator)
 {
 	JSQLiteData* bd = backend_data;
-	sqlite3_stmt* stmt = NULL;
+	JSQLiteThread* thread;
+	JSQLiteIterator* iterator = NULL;
 
 	g_return_val_if_fail(namespace != NULL, FALSE);
 	g_return_val_if_fail(prefix != NULL, FALSE);
 	g_return_val_if_fail(backend_iterator != NULL, FALSE);
 
-	if (sqlite3_prepare_v2(bd->db, "SELECT key, value FROM julea WHERE namespace = ? AND key LIKE ? || '%';", -1, &stmt, NULL) == SQLITE_OK)
+	if ((thread = backend_thread_get(bd)) != NULL
+	    && (iterator = backend_iterator_new(thread, &(thread->get_by_prefix), sqlite_sql_get_by_prefix)) != NULL)
 	{
-		sqlite3_bind_text(stmt, 1, namespace, -1, NULL);
-		sqlite3_bind_text(stmt, 2, prefix, -1, NULL);
+		sqlite3_bind_text(iterator->stmt, 1, namespace, -1, SQLITE_STATIC);
+		sqlite3_bind_text(iterator->stmt, 2, prefix, -1, SQLITE_STATIC);
 	}
 
-	*backend_iterator = stmt;
+	*backend_iterator = iterator;
 
-	return (stmt != NULL);
+	return (iterator != NULL);
 }
 
 static gboolean
-backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const** key, gconstpointer* value, guint32* len)
+backend_get_range(gpointer backend_data, gchar const* namespace, gchar const* start, gchar const* end, gboolean reverse, guint32 limit, gpointer* backend_iterator)
+{
+	JSQLiteData* bd = backend_data;
+	JSQLiteThread* thread;
+	JSQLiteIterator* iterator = NULL;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+
+	if ((thread = backend_thread_get(bd)) != NULL
+	    && (iterator = (reverse) ? backend_iterator_new(thread, &(thread->get_range_reverse), sqlite_sql_get_range_reverse) : backend_iterator_new(thread, &(thread->get_range), sqlite_sql_get_range)) != NULL)
+	{
+		sqlite3_bind_text(iterator->stmt, 1, namespace, -1, SQLITE_STATIC);
+		sqlite3_bind_text(iterator->stmt, 2, (start != NULL) ? start : "", -1, SQLITE_STATIC);
+
+		if (end != NULL)
+		{
+			sqlite3_bind_text(iterator->stmt, 3, end, -1, SQLITE_STATIC);
+		}
+		else
+		{
+			sqlite3_bind_zeroblob(iterator->stmt, 3, 0);
+		}
+
+		sqlite3_bind_int64(iterator->stmt, 4, (limit > 0) ? (sqlite3_int64)limit : -1);
+	}
+
+	*backend_iterator = iterator;
+
+	return (iterator != NULL);
+}
+
+static void
+backend_iterator_free(gpointer backend_data, gpointer backend_iterator)
 {
-	sqlite3_stmt* stmt = backend_iterator;
+	JSQLiteIterator* iterator = backend_iterator;
 
 	(void)backend_data;
 
+	g_return_if_fail(backend_iterator != NULL);
+
+	backend_statement_release(iterator->stmt, iterator->slot);
+
+	g_slice_free(JSQLiteIterator, iterator);
+}
+
+static gboolean
+backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const** key, gconstpointer* value, guint32* len)
+{
+	JSQLiteIterator* iterator = backend_iterator;
+
 	g_return_val_if_fail(backend_iterator != NULL, FALSE);
 	g_return_val_if_fail(value != NULL, FALSE);
 	g_return_val_if_fail(len != NULL, FALSE);
 
-	if (sqlite3_step(stmt) == SQLITE_ROW)
+	if (sqlite3_step(iterator->stmt) == SQLITE_ROW)
 	{
-		*key = (gchar const*)sqlite3_column_text(stmt, 0);
-		*value = sqlite3_column_blob(stmt, 1);
-		*len = sqlite3_column_bytes(stmt, 1);
+		*key = (gchar const*)sqlite3_column_text(iterator->stmt, 0);
+		*value = sqlite3_column_blob(iterator->stmt, 1);
+		*len = sqlite3_column_bytes(iterator->stmt, 1);
 
 		return TRUE;
 	}
 
-	sqlite3_finalize(stmt);
+	backend_iterator_free(backend_data, iterator);
 
 	return FALSE;
 }
@@ -239,36 +676,83 @@ static gboolean
 backend_init(gchar const* path, gpointer* backend_data)
 {
 	JSQLiteData* bd;
+	sqlite3* db = NULL;
+	g_auto(GStrv) split = NULL;
 	g_autofree gchar* dirname = NULL;
 
 	g_return_val_if_fail(path != NULL, FALSE);
 
-	dirname = g_path_get_dirname(path);
-	g_mkdir_with_parents(dirname, 0700);
+	split = g_strsplit(path, ":", 0);
 
 	bd = g_slice_new(JSQLiteData);
+	bd->path = g_strdup(split[0]);
+	bd->journal_mode = "WAL";
+	bd->synchronous = "NORMAL";
+	bd->mmap_size = 0;
+
+	for (guint i = 1; split[i] != NULL; i++)
+	{
+		gchar const* value;
+
+		if ((value = strchr(split[i], '=')) == NULL)
+		{
+			goto error;
+		}
+
+		value++;
+
+		if (g_str_has_prefix(split[i], "journal-mode="))
+		{
+			if ((bd->journal_mode = backend_lookup_value(sqlite_journal_modes, value)) == NULL)
+			{
+				goto error;
+			}
+		}
+		else if (g_str_has_prefix(split[i], "synchronous="))
+		{
+			if ((bd->synchronous = backend_lookup_value(sqlite_synchronous_levels, value)) == NULL)
+			{
+				goto error;
+			}
+		}
+		else if (g_str_has_prefix(split[i], "mmap-size="))
+		{
+			bd->mmap_size = g_ascii_strtoull(value, NULL, 10) * 1024 * 1024;
+		}
+		else
+		{
+			goto error;
+		}
+	}
+
+	dirname = g_path_get_dirname(bd->path);
+	g_mkdir_with_parents(dirname, 0700);
 
-	if (sqlite3_open(path, &(bd->db)) != SQLITE_OK)
+	// The schema has to exist before the per-thread connections prepare their statements
+	if ((db = backend_open(bd)) == NULL)
 	{
 		goto error;
 	}
 
-	if (sqlite3_exec(bd->db, "CREATE TABLE IF NOT EXISTS julea (namespace TEXT NOT NULL, key TEXT NOT NULL, value BLOB NOT NULL);", NULL, NULL, NULL) != SQLITE_OK)
+	if (sqlite3_exec(db, "CREATE TABLE IF NOT EXISTS julea (namespace TEXT NOT NULL, key TEXT NOT NULL, value BLOB NOT NULL);", NULL, NULL, NULL) != SQLITE_OK)
 	{
 		goto error;
 	}
 
-	if (sqlite3_exec(bd->db, "CREATE UNIQUE INDEX IF NOT EXISTS julea_namespace_key ON julea (namespace, key);", NULL, NULL, NULL) != SQLITE_OK)
+	if (sqlite3_exec(db, "CREATE UNIQUE INDEX IF NOT EXISTS julea_namespace_key ON julea (namespace, key);", NULL, NULL, NULL) != SQLITE_OK)
 	{
 		goto error;
 	}
 
+	sqlite3_close(db);
+
 	*backend_data = bd;
 
-	return (bd->db != NULL);
+	return TRUE;
 
 error:
-	sqlite3_close(bd->db);
+	sqlite3_close(db);
+	g_free(bd->path);
 	g_slice_free(JSQLiteData, bd);
 
 	return FALSE;
@@ -278,12 +762,17 @@ static void
 backend_fini(gpointer backend_data)
 {
 	JSQLiteData* bd = backend_data;
+	JSQLiteThread* thread;
+
+	// Connections of other threads are closed when their threads exit
+	thread = g_private_get(&backend_thread_global);
 
-	if (bd->db != NULL)
+	if (thread != NULL && thread->bd == bd)
 	{
-		sqlite3_close(bd->db);
+		g_private_replace(&backend_thread_global, NULL);
 	}
 
+	g_free(bd->path);
 	g_slice_free(JSQLiteData, bd);
 }
 
@@ -295,12 +784,15 @@ static JBackend sqlite_backend = {
 		.backend_fini = backend_fini,
 		.backend_batch_start = backend_batch_start,
 		.backend_batch_execute = backend_batch_execute,
+		.backend_batch_abort = backend_batch_abort,
 		.backend_put = backend_put,
 		.backend_delete = backend_delete,
 		.backend_get = backend_get,
 		.backend_get_all = backend_get_all,
 		.backend_get_by_prefix = backend_get_by_prefix,
-		.backend_iterate = backend_iterate }
+		.backend_get_range = backend_get_range,
+		.backend_iterate = backend_iterate,
+		.backend_iterator_free = backend_iterator_free }
 };
 
 G_MODULE_EXPORT
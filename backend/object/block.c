@@ -0,0 +1,1638 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Required for O_DIRECT
+#define _GNU_SOURCE
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <gmodule.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <linux/fs.h>
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+#include <julea.h>
+
+/*
+ * Objects are stored directly on a block device (or a large file), bypassing the file system.
+ * The device starts with a superblock, followed by the object table, the chunk map and the data.
+ * Each object occupies one slot in the object table; its data is stored in fixed-size chunks.
+ * The chunk map records the object and position each chunk belongs to, chunks not referenced by a live object are free.
+ * All metadata is kept in memory and written back when objects are synced.
+ */
+
+#define J_BLOCK_MAGIC "JULEABLK"
+
+#define J_BLOCK_VERSION 1
+
+/**
+ * The alignment required for direct I/O and the unit metadata is written in.
+ **/
+#define J_BLOCK_SIZE 4096
+
+/**
+ * The default chunk size.
+ **/
+#define J_BLOCK_CHUNK_SIZE (128 * 1024)
+
+/**
+ * The size of an entry in the object table.
+ **/
+#define J_BLOCK_ENTRY_SIZE 512
+
+/**
+ * The maximum combined length of an object's namespace and name.
+ **/
+#define J_BLOCK_NAME_MAX (J_BLOCK_ENTRY_SIZE - 32)
+
+/**
+ * The number of submission queue entries per ring.
+ **/
+#define J_BLOCK_URING_ENTRIES 128
+
+struct JBlockSuperblock
+{
+	gchar magic[8];
+	guint32 version;
+	guint32 chunk_size;
+	guint64 entries;
+	guint64 chunks;
+	guint64 table_offset;
+	guint64 map_offset;
+	guint64 data_offset;
+};
+
+typedef struct JBlockSuperblock JBlockSuperblock;
+
+/**
+ * An object's slot in the object table, unused slots have an ID of 0.
+ **/
+struct JBlockEntry
+{
+	guint64 id;
+	guint64 size;
+	gint64 modification_time;
+	guint16 namespace_length;
+	guint16 name_length;
+	guint32 reserved;
+
+	/**
+	 * The namespace followed by the name, without terminators.
+	 **/
+	gchar names[J_BLOCK_NAME_MAX];
+};
+
+typedef struct JBlockEntry JBlockEntry;
+
+G_STATIC_ASSERT(sizeof(JBlockEntry) == J_BLOCK_ENTRY_SIZE);
+
+/**
+ * A chunk's owner, free chunks have an ID of 0.
+ **/
+struct JBlockMapEntry
+{
+	guint64 id;
+	guint64 index;
+};
+
+typedef struct JBlockMapEntry JBlockMapEntry;
+
+struct JBlockData
+{
+	gint fd;
+
+	/**
+	 * Whether the device is accessed with direct I/O.
+	 **/
+	gboolean direct;
+
+	/**
+	 * Whether completions are polled instead of waiting for interrupts.
+	 **/
+	gboolean poll;
+
+	JBlockSuperblock superblock;
+
+	GRWLock lock[1];
+
+	// namespace(gchar*) -> (name(gchar*) -> JBlockObject*)
+	GHashTable* namespaces;
+
+	/**
+	 * Protects the metadata below.
+	 **/
+	GMutex meta_mutex[1];
+
+	JBlockEntry* table;
+	JBlockMapEntry* map;
+
+	/**
+	 * One flag per metadata page that has to be written back.
+	 **/
+	guint8* table_dirty;
+	guint8* map_dirty;
+
+	/**
+	 * Free slots and chunks, used as stacks.
+	 **/
+	GArray* free_entries;
+	GArray* free_chunks;
+
+	guint64 next_id;
+
+	/**
+	 * A zeroed chunk used to clear newly allocated chunks.
+	 **/
+	gpointer zeros;
+};
+
+typedef struct JBlockData JBlockData;
+
+struct JBlockObject
+{
+	gint ref_count;
+
+	JBlockData* bd;
+	gchar* namespace;
+	gchar* name;
+	guint64 entry;
+	guint64 id;
+	gboolean deleted;
+
+	GRWLock lock[1];
+
+	// Chunk number plus one, 0 for chunks that have not been written
+	GArray* chunks;
+	guint64 size;
+	gint64 modification_time;
+};
+
+typedef struct JBlockObject JBlockObject;
+
+struct JBlockIterator
+{
+	GPtrArray* names;
+	guint index;
+};
+
+typedef struct JBlockIterator JBlockIterator;
+
+/**
+ * A contiguous part of an extent within a single chunk.
+ **/
+struct JBlockSegment
+{
+	gpointer buffer;
+	guint64 length;
+
+	/**
+	 * The offset on the device.
+	 **/
+	guint64 offset;
+
+	/**
+	 * The index of the extent the segment belongs to.
+	 **/
+	guint32 extent;
+};
+
+typedef struct JBlockSegment JBlockSegment;
+
+static guint64
+block_align_up(guint64 value, guint64 alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * Reads or writes a range of the device, retrying short transfers.
+ *
+ * \private
+ *
+ * \return TRUE if the whole range has been transferred, FALSE otherwise.
+ **/
+static gboolean
+block_device_io(JBlockData* bd, gpointer buffer, guint64 length, guint64 offset, gboolean write)
+{
+	guint64 nbytes_total = 0;
+
+	while (nbytes_total < length)
+	{
+		gssize nbytes;
+
+		if (write)
+		{
+			nbytes = pwrite(bd->fd, (gchar*)buffer + nbytes_total, length - nbytes_total, offset + nbytes_total);
+		}
+		else
+		{
+			nbytes = pread(bd->fd, (gchar*)buffer + nbytes_total, length - nbytes_total, offset + nbytes_total);
+		}
+
+		if (nbytes < 0 && errno == EINTR)
+		{
+			continue;
+		}
+
+		if (nbytes <= 0)
+		{
+			return FALSE;
+		}
+
+		nbytes_total += nbytes;
+	}
+
+	return TRUE;
+}
+
+#ifdef HAVE_LIBURING
+static gboolean block_uring_unavailable = FALSE;
+
+static void
+block_uring_free(gpointer data)
+{
+	struct io_uring* ring = data;
+
+	io_uring_queue_exit(ring);
+	g_slice_free(struct io_uring, ring);
+}
+
+// Polled rings can only be used with direct I/O, so both kinds are kept per thread
+static GPrivate block_uring = G_PRIVATE_INIT(block_uring_free);
+static GPrivate block_uring_poll = G_PRIVATE_INIT(block_uring_free);
+
+/**
+ * Returns the calling thread's ring.
+ * Each server thread submits its own requests and reaps their completions, so no separate completion threads are needed.
+ *
+ * \private
+ **/
+static struct io_uring*
+block_uring_get_thread(gboolean poll)
+{
+	GPrivate* key = (poll) ? &block_uring_poll : &block_uring;
+	struct io_uring* ring;
+
+	ring = g_private_get(key);
+
+	if (G_UNLIKELY(ring == NULL) && !g_atomic_int_get(&block_uring_unavailable))
+	{
+		ring = g_slice_new(struct io_uring);
+
+		if (io_uring_queue_init(J_BLOCK_URING_ENTRIES, ring, (poll) ? IORING_SETUP_IOPOLL : 0) < 0)
+		{
+			g_slice_free(struct io_uring, ring);
+
+			// Without polling support, fall back to interrupt-driven completions
+			if (poll)
+			{
+				return block_uring_get_thread(FALSE);
+			}
+
+			g_atomic_int_set(&block_uring_unavailable, TRUE);
+
+			return NULL;
+		}
+
+		g_private_replace(key, ring);
+	}
+
+	return ring;
+}
+#endif
+
+/**
+ * Transfers segments, submitting them as batches if possible.
+ * The segments have to be aligned if the device uses direct I/O.
+ *
+ * \private
+ *
+ * \param bd       The backend data.
+ * \param segments The segments.
+ * \param count    The number of segments.
+ * \param write    Whether to write the segments.
+ * \param failed   Set to TRUE for each extent that has not been transferred completely.
+ **/
+static void
+block_segments_io(JBlockData* bd, JBlockSegment const* segments, guint count, gboolean write, gboolean* failed)
+{
+	guint done = 0;
+
+#ifdef HAVE_LIBURING
+	struct io_uring* ring;
+
+	if (count > 1 && (ring = block_uring_get_thread(bd->poll)) != NULL)
+	{
+		while (done < count)
+		{
+			guint batch = MIN(count - done, J_BLOCK_URING_ENTRIES);
+			guint submitted = 0;
+
+			for (guint i = 0; i < batch; i++)
+			{
+				JBlockSegment const* segment = &(segments[done + i]);
+				struct io_uring_sqe* sqe;
+
+				if ((sqe = io_uring_get_sqe(ring)) == NULL)
+				{
+					break;
+				}
+
+				if (write)
+				{
+					io_uring_prep_write(sqe, bd->fd, segment->buffer, segment->length, segment->offset);
+				}
+				else
+				{
+					io_uring_prep_read(sqe, bd->fd, segment->buffer, segment->length, segment->offset);
+				}
+
+				io_uring_sqe_set_data(sqe, GUINT_TO_POINTER(done + i));
+				submitted++;
+			}
+
+			if (submitted == 0 || io_uring_submit_and_wait(ring, submitted) < 0)
+			{
+				break;
+			}
+
+			for (guint i = 0; i < submitted; i++)
+			{
+				struct io_uring_cqe* cqe;
+				guint index;
+
+				if (io_uring_wait_cqe(ring, &cqe) < 0)
+				{
+					// The remaining completions cannot be matched anymore
+					for (guint j = done; j < done + submitted; j++)
+					{
+						failed[segments[j].extent] = TRUE;
+					}
+
+					return;
+				}
+
+				index = GPOINTER_TO_UINT(io_uring_cqe_get_data(cqe));
+
+				// Short transfers are completed synchronously
+				if (cqe->res < 0 || (guint64)cqe->res != segments[index].length)
+				{
+					guint64 nbytes = (cqe->res > 0) ? (guint64)cqe->res : 0;
+
+					if (!block_device_io(bd, (gchar*)segments[index].buffer + nbytes, segments[index].length - nbytes, segments[index].offset + nbytes, write))
+					{
+						failed[segments[index].extent] = TRUE;
+					}
+				}
+
+				io_uring_cqe_seen(ring, cqe);
+			}
+
+			done += submitted;
+		}
+	}
+#endif
+
+	for (guint i = done; i < count; i++)
+	{
+		if (!block_device_io(bd, segments[i].buffer, segments[i].length, segments[i].offset, write))
+		{
+			failed[segments[i].extent] = TRUE;
+		}
+	}
+}
+
+/**
+ * Marks the metadata page containing a byte range as dirty.
+ * Has to be called with the metadata mutex held.
+ *
+ * \private
+ **/
+static void
+block_meta_dirty(guint8* dirty, guint64 offset)
+{
+	dirty[offset / J_BLOCK_SIZE] = 1;
+}
+
+/**
+ * Writes back all dirty metadata pages.
+ * Has to be called with the metadata mutex held.
+ *
+ * \private
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+block_meta_flush(JBlockData* bd)
+{
+	JBlockSuperblock const* sb = &(bd->superblock);
+	gpointer areas[2] = { bd->table, bd->map };
+	guint8* dirty[2] = { bd->table_dirty, bd->map_dirty };
+	guint64 offsets[2] = { sb->table_offset, sb->map_offset };
+	guint64 pages[2];
+	gboolean ret = TRUE;
+
+	pages[0] = (sb->map_offset - sb->table_offset) / J_BLOCK_SIZE;
+	pages[1] = (sb->data_offset - sb->map_offset) / J_BLOCK_SIZE;
+
+	for (guint a = 0; a < 2; a++)
+	{
+		guint64 page = 0;
+
+		while (page < pages[a])
+		{
+			guint64 end;
+
+			if (!dirty[a][page])
+			{
+				page++;
+				continue;
+			}
+
+			// Consecutive dirty pages are written at once
+			for (end = page; end < pages[a] && dirty[a][end]; end++)
+			{
+				dirty[a][end] = 0;
+			}
+
+			if (!block_device_io(bd, (gchar*)areas[a] + page * J_BLOCK_SIZE, (end - page) * J_BLOCK_SIZE, offsets[a] + page * J_BLOCK_SIZE, TRUE))
+			{
+				// Try again on the next sync
+				memset(dirty[a] + page, 1, end - page);
+				ret = FALSE;
+			}
+
+			page = end;
+		}
+	}
+
+	return ret;
+}
+
+/**
+ * Updates an object's entry in the object table.
+ *
+ * \private
+ **/
+static void
+block_object_update_entry(JBlockObject* object)
+{
+	JBlockData* bd = object->bd;
+	JBlockEntry* entry;
+
+	g_mutex_lock(bd->meta_mutex);
+
+	if (!object->deleted)
+	{
+		entry = &(bd->table[object->entry]);
+		entry->size = object->size;
+		entry->modification_time = object->modification_time;
+		block_meta_dirty(bd->table_dirty, object->entry * sizeof(JBlockEntry));
+	}
+
+	g_mutex_unlock(bd->meta_mutex);
+}
+
+static JBlockObject*
+block_object_new(JBlockData* bd, gchar const* namespace, gchar const* name, guint64 entry, guint64 id)
+{
+	JBlockObject* object;
+
+	object = g_slice_new(JBlockObject);
+	object->ref_count = 1;
+	object->bd = bd;
+	object->namespace = g_strdup(namespace);
+	object->name = g_strdup(name);
+	object->entry = entry;
+	object->id = id;
+	object->deleted = FALSE;
+	g_rw_lock_init(object->lock);
+	object->chunks = g_array_new(FALSE, TRUE, sizeof(guint64));
+	object->size = 0;
+	object->modification_time = g_get_real_time();
+
+	return object;
+}
+
+static JBlockObject*
+block_object_ref(JBlockObject* object)
+{
+	g_atomic_int_inc(&(object->ref_count));
+
+	return object;
+}
+
+static void
+block_object_unref(JBlockObject* object)
+{
+	if (g_atomic_int_dec_and_test(&(object->ref_count)))
+	{
+		JBlockData* bd = object->bd;
+
+		// The chunks of deleted objects are only released once nobody can read them anymore
+		if (object->deleted)
+		{
+			g_mutex_lock(bd->meta_mutex);
+
+			for (guint i = 0; i < object->chunks->len; i++)
+			{
+				guint64 chunk = g_array_index(object->chunks, guint64, i);
+
+				if (chunk > 0)
+				{
+					bd->map[chunk - 1].id = 0;
+					bd->map[chunk - 1].index = 0;
+					block_meta_dirty(bd->map_dirty, (chunk - 1) * sizeof(JBlockMapEntry));
+					g_array_append_val(bd->free_chunks, chunk);
+				}
+			}
+
+			g_mutex_unlock(bd->meta_mutex);
+		}
+
+		g_array_unref(object->chunks);
+		g_rw_lock_clear(object->lock);
+		g_free(object->namespace);
+		g_free(object->name);
+		g_slice_free(JBlockObject, object);
+	}
+}
+
+/**
+ * Makes sure the chunks covering a range exist.
+ * New chunks are zeroed unless they are overwritten completely.
+ * Has to be called with the object's writer lock held.
+ *
+ * \private
+ *
+ * \param object An object.
+ * \param length The range's length.
+ * \param offset The range's offset.
+ *
+ * \return The number of bytes from offset that are backed by chunks.
+ **/
+static guint64
+block_object_allocate(JBlockObject* object, guint64 length, guint64 offset)
+{
+	JBlockData* bd = object->bd;
+	guint64 chunk_size = bd->superblock.chunk_size;
+	guint64 first;
+	guint64 last;
+
+	if (length == 0)
+	{
+		return 0;
+	}
+
+	first = offset / chunk_size;
+	last = (offset + length - 1) / chunk_size;
+
+	if (object->chunks->len <= last)
+	{
+		g_array_set_size(object->chunks, last + 1);
+	}
+
+	for (guint64 i = first; i <= last; i++)
+	{
+		guint64 chunk = 0;
+		guint64 chunk_offset;
+
+		if (g_array_index(object->chunks, guint64, i) != 0)
+		{
+			continue;
+		}
+
+		g_mutex_lock(bd->meta_mutex);
+
+		if (bd->free_chunks->len > 0)
+		{
+			chunk = g_array_index(bd->free_chunks, guint64, bd->free_chunks->len - 1);
+			g_array_set_size(bd->free_chunks, bd->free_chunks->len - 1);
+
+			bd->map[chunk - 1].id = object->id;
+			bd->map[chunk - 1].index = i;
+			block_meta_dirty(bd->map_dirty, (chunk - 1) * sizeof(JBlockMapEntry));
+		}
+
+		g_mutex_unlock(bd->meta_mutex);
+
+		if (chunk == 0)
+		{
+			// Only the chunks before the missing one can be used
+			return (i == first) ? 0 : i * chunk_size - offset;
+		}
+
+		chunk_offset = bd->superblock.data_offset + (chunk - 1) * chunk_size;
+
+		// The chunk might contain data of a deleted object
+		if (offset > i * chunk_size || offset + length < (i + 1) * chunk_size)
+		{
+#ifdef FALLOC_FL_ZERO_RANGE
+			if (fallocate(bd->fd, FALLOC_FL_ZERO_RANGE | FALLOC_FL_KEEP_SIZE, chunk_offset, chunk_size) != 0)
+#endif
+			{
+				block_device_io(bd, bd->zeros, chunk_size, chunk_offset, TRUE);
+			}
+		}
+
+		g_array_index(object->chunks, guint64, i) = chunk;
+	}
+
+	return length;
+}
+
+/**
+ * Reads or writes extents of an object.
+ * Has to be called with the object's lock held, writes require the chunks to be allocated.
+ * Aligned parts are transferred in one batch, unaligned ones through bounce buffers.
+ *
+ * \private
+ *
+ * \param object  An object.
+ * \param extents The extents, their lengths have to be limited to the allocated or readable range.
+ * \param count   The number of extents.
+ * \param write   Whether to write to the object.
+ **/
+static void
+block_object_io(JBlockObject* object, JBackendObjectExtent* extents, guint32 count, gboolean write)
+{
+	JBlockData* bd = object->bd;
+	guint64 chunk_size = bd->superblock.chunk_size;
+	g_autoptr(GArray) segments = NULL;
+	g_autofree gboolean* failed = NULL;
+
+	segments = g_array_new(FALSE, FALSE, sizeof(JBlockSegment));
+	failed = g_new0(gboolean, count);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		guint64 position = 0;
+
+		while (position < extents[i].length)
+		{
+			guint64 index = (extents[i].offset + position) / chunk_size;
+			guint64 chunk_offset = (extents[i].offset + position) % chunk_size;
+			guint64 chunk_length = MIN(extents[i].length - position, chunk_size - chunk_offset);
+			guint64 chunk = (index < object->chunks->len) ? g_array_index(object->chunks, guint64, index) : 0;
+			gchar* buffer = (gchar*)extents[i].data + position;
+			JBlockSegment segment;
+
+			position += chunk_length;
+
+			if (chunk == 0)
+			{
+				// Holes read as zeros
+				memset(buffer, 0, chunk_length);
+				continue;
+			}
+
+			segment.buffer = buffer;
+			segment.length = chunk_length;
+			segment.offset = bd->superblock.data_offset + (chunk - 1) * chunk_size + chunk_offset;
+			segment.extent = i;
+
+			if (!bd->direct || ((guintptr)buffer % J_BLOCK_SIZE == 0 && chunk_offset % J_BLOCK_SIZE == 0 && chunk_length % J_BLOCK_SIZE == 0))
+			{
+				g_array_append_val(segments, segment);
+			}
+			else
+			{
+				guint64 start = chunk_offset / J_BLOCK_SIZE * J_BLOCK_SIZE;
+				guint64 end = block_align_up(chunk_offset + chunk_length, J_BLOCK_SIZE);
+				guint64 device_offset = segment.offset - (chunk_offset - start);
+				gchar* bounce;
+
+				// Unaligned writes have to read the surrounding blocks first
+				bounce = j_helper_alloc_aligned(J_BLOCK_SIZE, end - start);
+
+				if (block_device_io(bd, bounce, end - start, device_offset, FALSE))
+				{
+					if (write)
+					{
+						memcpy(bounce + (chunk_offset - start), buffer, chunk_length);
+						failed[i] = failed[i] || !block_device_io(bd, bounce, end - start, device_offset, TRUE);
+					}
+					else
+					{
+						memcpy(buffer, bounce + (chunk_offset - start), chunk_length);
+					}
+				}
+				else
+				{
+					failed[i] = TRUE;
+				}
+
+				free(bounce);
+			}
+		}
+	}
+
+	block_segments_io(bd, (JBlockSegment*)(gpointer)segments->data, segments->len, write, failed);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		extents[i].bytes = (failed[i]) ? 0 : extents[i].length;
+	}
+}
+
+static GHashTable*
+block_namespace_get(JBlockData* bd, gchar const* namespace, gboolean create)
+{
+	GHashTable* objects;
+
+	if ((objects = g_hash_table_lookup(bd->namespaces, namespace)) == NULL && create)
+	{
+		objects = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)block_object_unref);
+		g_hash_table_insert(bd->namespaces, g_strdup(namespace), objects);
+	}
+
+	return objects;
+}
+
+static gboolean
+backend_create(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
+{
+	JBlockData* bd = backend_data;
+	JBlockObject* object;
+	GHashTable* objects;
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(path != NULL, FALSE);
+	g_return_val_if_fail(backend_object != NULL, FALSE);
+
+	if (strlen(namespace) + strlen(path) > J_BLOCK_NAME_MAX)
+	{
+		return FALSE;
+	}
+
+	g_rw_lock_writer_lock(bd->lock);
+
+	objects = block_namespace_get(bd, namespace, TRUE);
+
+	// Creating an existing object opens it, like the posix backend
+	if ((object = g_hash_table_lookup(objects, path)) == NULL)
+	{
+		g_mutex_lock(bd->meta_mutex);
+
+		if (bd->free_entries->len > 0)
+		{
+			JBlockEntry* entry;
+			guint64 slot;
+
+			slot = g_array_index(bd->free_entries, guint64, bd->free_entries->len - 1);
+			g_array_set_size(bd->free_entries, bd->free_entries->len - 1);
+
+			object = block_object_new(bd, namespace, path, slot, bd->next_id++);
+
+			entry = &(bd->table[slot]);
+			memset(entry, 0, sizeof(*entry));
+			entry->id = object->id;
+			entry->modification_time = object->modification_time;
+			entry->namespace_length = strlen(namespace);
+			entry->name_length = strlen(path);
+			memcpy(entry->names, namespace, entry->namespace_length);
+			memcpy(entry->names + entry->namespace_length, path, entry->name_length);
+			block_meta_dirty(bd->table_dirty, slot * sizeof(JBlockEntry));
+		}
+
+		g_mutex_unlock(bd->meta_mutex);
+
+		if (object != NULL)
+		{
+			// The object's name is used as the key
+			g_hash_table_insert(objects, object->name, object);
+		}
+		else
+		{
+			ret = FALSE;
+		}
+	}
+
+	if (ret)
+	{
+		*backend_object = block_object_ref(object);
+	}
+
+	g_rw_lock_writer_unlock(bd->lock);
+
+	return ret;
+}
+
+static gboolean
+backend_open(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
+{
+	JBlockData* bd = backend_data;
+	JBlockObject* object = NULL;
+	GHashTable* objects;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(path != NULL, FALSE);
+	g_return_val_if_fail(backend_object != NULL, FALSE);
+
+	g_rw_lock_reader_lock(bd->lock);
+
+	if ((objects = block_namespace_get(bd, namespace, FALSE)) != NULL && (object = g_hash_table_lookup(objects, path)) != NULL)
+	{
+		*backend_object = block_object_ref(object);
+	}
+
+	g_rw_lock_reader_unlock(bd->lock);
+
+	return (object != NULL);
+}
+
+static gboolean
+backend_delete(gpointer backend_data, gpointer backend_object)
+{
+	JBlockData* bd = backend_data;
+	JBlockObject* object = backend_object;
+	GHashTable* objects;
+	gboolean ret = FALSE;
+
+	g_rw_lock_writer_lock(bd->lock);
+
+	// Only remove the object if it has not been replaced in the meantime
+	if ((objects = block_namespace_get(bd, object->namespace, FALSE)) != NULL && g_hash_table_lookup(objects, object->name) == object)
+	{
+		g_mutex_lock(bd->meta_mutex);
+
+		// The slot can be reused right away, the chunks are released with the last reference
+		object->deleted = TRUE;
+		memset(&(bd->table[object->entry]), 0, sizeof(JBlockEntry));
+		block_meta_dirty(bd->table_dirty, object->entry * sizeof(JBlockEntry));
+		g_array_append_val(bd->free_entries, object->entry);
+
+		g_mutex_unlock(bd->meta_mutex);
+
+		ret = g_hash_table_remove(objects, object->name);
+	}
+
+	g_rw_lock_writer_unlock(bd->lock);
+
+	block_object_unref(object);
+
+	return ret;
+}
+
+static gboolean
+backend_close(gpointer backend_data, gpointer backend_object)
+{
+	JBlockObject* object = backend_object;
+
+	(void)backend_data;
+
+	block_object_unref(object);
+
+	return TRUE;
+}
+
+static gboolean
+backend_status(gpointer backend_data, gpointer backend_object, gint64* modification_time, guint64* size)
+{
+	JBlockObject* object = backend_object;
+
+	(void)backend_data;
+
+	g_rw_lock_reader_lock(object->lock);
+
+	if (modification_time != NULL)
+	{
+		*modification_time = object->modification_time;
+	}
+
+	if (size != NULL)
+	{
+		*size = object->size;
+	}
+
+	g_rw_lock_reader_unlock(object->lock);
+
+	return TRUE;
+}
+
+static gboolean
+backend_sync(gpointer backend_data, gpointer backend_object)
+{
+	JBlockData* bd = backend_data;
+	gboolean ret;
+
+	(void)backend_object;
+
+	// Metadata is shared by all objects, so it is written back as a whole
+	g_mutex_lock(bd->meta_mutex);
+	ret = block_meta_flush(bd);
+	g_mutex_unlock(bd->meta_mutex);
+
+	// Flushes the device's volatile write cache
+	return (fdatasync(bd->fd) == 0) && ret;
+}
+
+static gboolean
+backend_syncv(gpointer backend_data, gpointer* backend_objects, guint32 count)
+{
+	(void)backend_objects;
+
+	if (count == 0)
+	{
+		return TRUE;
+	}
+
+	return backend_sync(backend_data, NULL);
+}
+
+static gboolean
+backend_readv(gpointer backend_data, gpointer backend_object, JBackendObjectExtent* extents, guint32 count)
+{
+	JBlockObject* object = backend_object;
+	g_autofree JBackendObjectExtent* readable = NULL;
+	gboolean ret = TRUE;
+
+	(void)backend_data;
+
+	readable = g_new(JBackendObjectExtent, count);
+
+	g_rw_lock_reader_lock(object->lock);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		readable[i] = extents[i];
+		readable[i].length = (extents[i].offset < object->size) ? MIN(extents[i].length, object->size - extents[i].offset) : 0;
+	}
+
+	block_object_io(object, readable, count, FALSE);
+
+	g_rw_lock_reader_unlock(object->lock);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		extents[i].bytes = readable[i].bytes;
+		ret = ret && (extents[i].bytes == extents[i].length);
+	}
+
+	return ret;
+}
+
+static gboolean
+backend_writev(gpointer backend_data, gpointer backend_object, JBackendObjectExtent* extents, guint32 count)
+{
+	JBlockObject* object = backend_object;
+	g_autofree JBackendObjectExtent* writable = NULL;
+	gboolean ret = TRUE;
+
+	(void)backend_data;
+
+	writable = g_new(JBackendObjectExtent, count);
+
+	g_rw_lock_writer_lock(object->lock);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		writable[i] = extents[i];
+		writable[i].length = block_object_allocate(object, extents[i].length, extents[i].offset);
+	}
+
+	block_object_io(object, writable, count, TRUE);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		extents[i].bytes = writable[i].bytes;
+		ret = ret && (extents[i].bytes == extents[i].length);
+
+		if (extents[i].bytes > 0)
+		{
+			object->size = MAX(object->size, extents[i].offset + extents[i].bytes);
+		}
+	}
+
+	object->modification_time = g_get_real_time();
+	block_object_update_entry(object);
+
+	g_rw_lock_writer_unlock(object->lock);
+
+	return ret;
+}
+
+static gboolean
+backend_read(gpointer backend_data, gpointer backend_object, gpointer buffer, guint64 length, guint64 offset, guint64* bytes_read)
+{
+	JBackendObjectExtent extent = { buffer, length, offset, 0 };
+	gboolean ret;
+
+	ret = backend_readv(backend_data, backend_object, &extent, 1);
+
+	if (bytes_read != NULL)
+	{
+		*bytes_read = extent.bytes;
+	}
+
+	return ret;
+}
+
+static gboolean
+backend_write(gpointer backend_data, gpointer backend_object, gconstpointer buffer, guint64 length, guint64 offset, guint64* bytes_written)
+{
+	JBackendObjectExtent extent = { (gpointer)(gintptr)buffer, length, offset, 0 };
+	gboolean ret;
+
+	ret = backend_writev(backend_data, backend_object, &extent, 1);
+
+	if (bytes_written != NULL)
+	{
+		*bytes_written = extent.bytes;
+	}
+
+	return ret;
+}
+
+static gboolean
+backend_discard(gpointer backend_data, gpointer backend_object, guint64 length, guint64 offset)
+{
+	JBlockData* bd = backend_data;
+	JBlockObject* object = backend_object;
+	guint64 chunk_size = bd->superblock.chunk_size;
+	gboolean ret = TRUE;
+
+	g_rw_lock_writer_lock(object->lock);
+
+	if (offset < object->size)
+	{
+		guint64 position = offset;
+		guint64 end;
+
+		end = MIN(offset + length, object->size);
+
+		while (position < end)
+		{
+			guint64 index = position / chunk_size;
+			guint64 chunk_offset = position % chunk_size;
+			guint64 chunk_length = MIN(end - position, chunk_size - chunk_offset);
+			guint64 chunk = (index < object->chunks->len) ? g_array_index(object->chunks, guint64, index) : 0;
+
+			if (chunk != 0)
+			{
+				if (chunk_length == chunk_size)
+				{
+					// Whole chunks are released and read as zeros afterwards
+					g_mutex_lock(bd->meta_mutex);
+					bd->map[chunk - 1].id = 0;
+					bd->map[chunk - 1].index = 0;
+					block_meta_dirty(bd->map_dirty, (chunk - 1) * sizeof(JBlockMapEntry));
+					g_array_append_val(bd->free_chunks, chunk);
+					g_mutex_unlock(bd->meta_mutex);
+
+					g_array_index(object->chunks, guint64, index) = 0;
+				}
+				else
+				{
+					JBackendObjectExtent extent = { bd->zeros, chunk_length, position, 0 };
+
+					block_object_io(object, &extent, 1, TRUE);
+					ret = ret && (extent.bytes == chunk_length);
+				}
+			}
+
+			position += chunk_length;
+		}
+
+		object->modification_time = g_get_real_time();
+		block_object_update_entry(object);
+	}
+
+	g_rw_lock_writer_unlock(object->lock);
+
+	return ret;
+}
+
+static gboolean
+backend_preallocate(gpointer backend_data, gpointer backend_object, guint64 size)
+{
+	JBlockObject* object = backend_object;
+	guint64 nbytes;
+
+	(void)backend_data;
+
+	g_rw_lock_writer_lock(object->lock);
+	// Keep the size so that the preallocated space is not visible to readers
+	nbytes = block_object_allocate(object, size, 0);
+	g_rw_lock_writer_unlock(object->lock);
+
+	return (nbytes == size);
+}
+
+static gboolean
+backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const* prefix, gpointer* backend_iterator)
+{
+	JBlockData* bd = backend_data;
+	JBlockIterator* iterator;
+	GHashTable* objects;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+
+	iterator = g_slice_new(JBlockIterator);
+	iterator->names = g_ptr_array_new_with_free_func(g_free);
+	iterator->index = 0;
+
+	g_rw_lock_reader_lock(bd->lock);
+
+	// Iterate over a snapshot of the names, so that the lock does not have to be held
+	if ((objects = block_namespace_get(bd, namespace, FALSE)) != NULL)
+	{
+		GHashTableIter iter;
+		gchar const* name;
+
+		g_hash_table_iter_init(&iter, objects);
+
+		while (g_hash_table_iter_next(&iter, (gpointer*)&name, NULL))
+		{
+			if (prefix == NULL || g_str_has_prefix(name, prefix))
+			{
+				g_ptr_array_add(iterator->names, g_strdup(name));
+			}
+		}
+	}
+
+	g_rw_lock_reader_unlock(bd->lock);
+
+	*backend_iterator = iterator;
+
+	return TRUE;
+}
+
+static gboolean
+backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend_iterator)
+{
+	return backend_get_by_prefix(backend_data, namespace, NULL, backend_iterator);
+}
+
+static gboolean
+backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const** name)
+{
+	JBlockIterator* iterator = backend_iterator;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+
+	if (iterator->index < iterator->names->len)
+	{
+		*name = g_ptr_array_index(iterator->names, iterator->index);
+		iterator->index++;
+
+		return TRUE;
+	}
+
+	g_ptr_array_unref(iterator->names);
+	g_slice_free(JBlockIterator, iterator);
+
+	return FALSE;
+}
+
+/**
+ * Computes the layout of a new store.
+ *
+ * \private
+ *
+ * \param sb         The superblock.
+ * \param size       The device's size.
+ * \param chunk_size The chunk size.
+ * \param entries    The number of objects, 0 to derive it from the size.
+ *
+ * \return TRUE if at least one chunk fits, FALSE otherwise.
+ **/
+static gboolean
+block_layout(JBlockSuperblock* sb, guint64 size, guint64 chunk_size, guint64 entries)
+{
+	guint64 chunks;
+
+	if (entries == 0)
+	{
+		// Assume that objects occupy eight chunks on average
+		entries = MAX(1024, size / chunk_size / 8);
+	}
+
+	memset(sb, 0, sizeof(*sb));
+	memcpy(sb->magic, J_BLOCK_MAGIC, sizeof(sb->magic));
+	sb->version = J_BLOCK_VERSION;
+	sb->chunk_size = chunk_size;
+	sb->entries = entries;
+	sb->table_offset = J_BLOCK_SIZE;
+	sb->map_offset = sb->table_offset + block_align_up(entries * sizeof(JBlockEntry), J_BLOCK_SIZE);
+
+	if (sb->map_offset >= size)
+	{
+		return FALSE;
+	}
+
+	chunks = (size - sb->map_offset) / (chunk_size + sizeof(JBlockMapEntry));
+
+	// The map's padding might not leave room for the last chunk
+	for (; chunks > 0; chunks--)
+	{
+		sb->chunks = chunks;
+		sb->data_offset = sb->map_offset + block_align_up(chunks * sizeof(JBlockMapEntry), J_BLOCK_SIZE);
+
+		if (sb->data_offset + chunks * chunk_size <= size)
+		{
+			break;
+		}
+	}
+
+	return (chunks > 0);
+}
+
+/**
+ * Writes a new, empty store.
+ *
+ * \private
+ **/
+static gboolean
+block_format(JBlockData* bd, guint64 size, guint64 chunk_size, guint64 entries)
+{
+	JBlockSuperblock* sb = &(bd->superblock);
+	gpointer page;
+	gboolean ret;
+
+	if (!block_layout(sb, size, chunk_size, entries))
+	{
+		return FALSE;
+	}
+
+	// Writing the zeroed metadata marks all objects and chunks as free
+	bd->table = j_helper_alloc_aligned(J_BLOCK_SIZE, sb->map_offset - sb->table_offset);
+	bd->map = j_helper_alloc_aligned(J_BLOCK_SIZE, sb->data_offset - sb->map_offset);
+	memset(bd->table, 0, sb->map_offset - sb->table_offset);
+	memset(bd->map, 0, sb->data_offset - sb->map_offset);
+
+	page = j_helper_alloc_aligned(J_BLOCK_SIZE, J_BLOCK_SIZE);
+	memset(page, 0, J_BLOCK_SIZE);
+	memcpy(page, sb, sizeof(*sb));
+
+	ret = block_device_io(bd, bd->table, sb->map_offset - sb->table_offset, sb->table_offset, TRUE)
+	      && block_device_io(bd, bd->map, sb->data_offset - sb->map_offset, sb->map_offset, TRUE)
+	      && fdatasync(bd->fd) == 0
+	      // The superblock is written last, so an interrupted format is not mistaken for a valid store
+	      && block_device_io(bd, page, J_BLOCK_SIZE, 0, TRUE)
+	      && fdatasync(bd->fd) == 0;
+
+	free(page);
+
+	return ret;
+}
+
+/**
+ * Reads an existing store's metadata and rebuilds the objects.
+ *
+ * \private
+ **/
+static gboolean
+block_load(JBlockData* bd)
+{
+	JBlockSuperblock* sb = &(bd->superblock);
+	g_autoptr(GHashTable) ids = NULL;
+
+	if (bd->table == NULL)
+	{
+		bd->table = j_helper_alloc_aligned(J_BLOCK_SIZE, sb->map_offset - sb->table_offset);
+		bd->map = j_helper_alloc_aligned(J_BLOCK_SIZE, sb->data_offset - sb->map_offset);
+
+		if (!block_device_io(bd, bd->table, sb->map_offset - sb->table_offset, sb->table_offset, FALSE)
+		    || !block_device_io(bd, bd->map, sb->data_offset - sb->map_offset, sb->map_offset, FALSE))
+		{
+			return FALSE;
+		}
+	}
+
+	bd->table_dirty = g_new0(guint8, (sb->map_offset - sb->table_offset) / J_BLOCK_SIZE);
+	bd->map_dirty = g_new0(guint8, (sb->data_offset - sb->map_offset) / J_BLOCK_SIZE);
+	bd->free_entries = g_array_new(FALSE, FALSE, sizeof(guint64));
+	bd->free_chunks = g_array_new(FALSE, FALSE, sizeof(guint64));
+	bd->next_id = 1;
+
+	ids = g_hash_table_new(g_int64_hash, g_int64_equal);
+
+	// Free slots and chunks are pushed in reverse, so that low ones are used first
+	for (guint64 i = sb->entries; i > 0; i--)
+	{
+		JBlockEntry* entry = &(bd->table[i - 1]);
+
+		if (entry->id == 0)
+		{
+			guint64 slot = i - 1;
+
+			g_array_append_val(bd->free_entries, slot);
+		}
+		else if (entry->namespace_length + entry->name_length <= J_BLOCK_NAME_MAX)
+		{
+			g_autofree gchar* namespace = NULL;
+			g_autofree gchar* name = NULL;
+			JBlockObject* object;
+
+			namespace = g_strndup(entry->names, entry->namespace_length);
+			name = g_strndup(entry->names + entry->namespace_length, entry->name_length);
+
+			object = block_object_new(bd, namespace, name, i - 1, entry->id);
+			object->size = entry->size;
+			object->modification_time = entry->modification_time;
+
+			g_hash_table_insert(block_namespace_get(bd, namespace, TRUE), object->name, object);
+			g_hash_table_insert(ids, &(object->id), object);
+
+			bd->next_id = MAX(bd->next_id, entry->id + 1);
+		}
+	}
+
+	for (guint64 i = sb->chunks; i > 0; i--)
+	{
+		JBlockMapEntry* map_entry = &(bd->map[i - 1]);
+		JBlockObject* object;
+		guint64 chunk = i;
+
+		// Chunks of objects that have been deleted before their chunks were written back are free, too
+		if (map_entry->id != 0 && (object = g_hash_table_lookup(ids, &(map_entry->id))) != NULL)
+		{
+			if (object->chunks->len <= map_entry->index)
+			{
+				g_array_set_size(object->chunks, map_entry->index + 1);
+			}
+
+			g_array_index(object->chunks, guint64, map_entry->index) = chunk;
+		}
+		else
+		{
+			if (map_entry->id != 0)
+			{
+				map_entry->id = 0;
+				map_entry->index = 0;
+				block_meta_dirty(bd->map_dirty, (i - 1) * sizeof(JBlockMapEntry));
+			}
+
+			g_array_append_val(bd->free_chunks, chunk);
+		}
+	}
+
+	return TRUE;
+}
+
+static void
+block_data_free(JBlockData* bd)
+{
+	if (bd->namespaces != NULL)
+	{
+		g_hash_table_unref(bd->namespaces);
+	}
+
+	if (bd->fd != -1)
+	{
+		close(bd->fd);
+	}
+
+	free(bd->table);
+	free(bd->map);
+	free(bd->zeros);
+	g_free(bd->table_dirty);
+	g_free(bd->map_dirty);
+
+	if (bd->free_entries != NULL)
+	{
+		g_array_unref(bd->free_entries);
+	}
+
+	if (bd->free_chunks != NULL)
+	{
+		g_array_unref(bd->free_chunks);
+	}
+
+	g_rw_lock_clear(bd->lock);
+	g_mutex_clear(bd->meta_mutex);
+	g_slice_free(JBlockData, bd);
+}
+
+static gboolean
+backend_init(gchar const* path, gpointer* backend_data)
+{
+	JBlockData* bd;
+	g_auto(GStrv) split = NULL;
+	gpointer page = NULL;
+	struct stat buf;
+	guint64 size = 0;
+	guint64 chunk_size = J_BLOCK_CHUNK_SIZE;
+	guint64 entries = 0;
+	gboolean format = FALSE;
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(path != NULL, FALSE);
+
+	bd = g_slice_new0(JBlockData);
+	bd->fd = -1;
+	g_rw_lock_init(bd->lock);
+	g_mutex_init(bd->meta_mutex);
+	bd->namespaces = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_hash_table_unref);
+
+	// The path can be suffixed with :format to create a new store, :size=MiB for files, :chunk-size=KiB and :objects=COUNT
+	split = g_strsplit(path, ":", 0);
+
+	for (guint i = 1; split[0] != NULL && split[i] != NULL; i++)
+	{
+		if (g_strcmp0(split[i], "format") == 0)
+		{
+			format = TRUE;
+		}
+		else if (g_str_has_prefix(split[i], "size="))
+		{
+			size = g_ascii_strtoull(split[i] + strlen("size="), NULL, 10) * 1024 * 1024;
+		}
+		else if (g_str_has_prefix(split[i], "chunk-size="))
+		{
+			chunk_size = g_ascii_strtoull(split[i] + strlen("chunk-size="), NULL, 10) * 1024;
+		}
+		else if (g_str_has_prefix(split[i], "objects="))
+		{
+			entries = g_ascii_strtoull(split[i] + strlen("objects="), NULL, 10);
+		}
+		else
+		{
+			goto end;
+		}
+	}
+
+	chunk_size = block_align_up(MAX(chunk_size, J_BLOCK_SIZE), J_BLOCK_SIZE);
+
+	bd->direct = TRUE;
+
+	if ((bd->fd = open(split[0], O_RDWR | O_CREAT | O_DIRECT, 0600)) == -1 && errno == EINVAL)
+	{
+		// Some file systems like tmpfs do not support direct I/O
+		bd->direct = FALSE;
+		bd->fd = open(split[0], O_RDWR | O_CREAT, 0600);
+	}
+
+	if (bd->fd == -1 || fstat(bd->fd, &buf) != 0)
+	{
+		g_warning("Could not open %s: %s", split[0], g_strerror(errno));
+		goto end;
+	}
+
+	if (S_ISBLK(buf.st_mode))
+	{
+		if (ioctl(bd->fd, BLKGETSIZE64, &size) != 0)
+		{
+			goto end;
+		}
+
+		// Polling only works for direct I/O on block devices
+		bd->poll = bd->direct;
+	}
+	else if ((guint64)buf.st_size < size)
+	{
+		if (ftruncate(bd->fd, size) != 0)
+		{
+			goto end;
+		}
+	}
+	else
+	{
+		size = buf.st_size;
+	}
+
+	page = j_helper_alloc_aligned(J_BLOCK_SIZE, J_BLOCK_SIZE);
+
+	if (!block_device_io(bd, page, J_BLOCK_SIZE, 0, FALSE))
+	{
+		// New files are still empty
+		memset(page, 0, J_BLOCK_SIZE);
+	}
+
+	memcpy(&(bd->superblock), page, sizeof(bd->superblock));
+
+	if (!format && memcmp(bd->superblock.magic, J_BLOCK_MAGIC, sizeof(bd->superblock.magic)) != 0)
+	{
+		gboolean empty = TRUE;
+
+		for (guint i = 0; i < J_BLOCK_SIZE && empty; i++)
+		{
+			empty = (((guint8*)page)[i] == 0);
+		}
+
+		// Devices are only formatted implicitly if they are unused, to avoid destroying other data
+		if (!empty)
+		{
+			g_warning("%s does not contain a JULEA object store, append :format to create one.", split[0]);
+			goto end;
+		}
+
+		format = TRUE;
+	}
+
+	if (format)
+	{
+		if (!block_format(bd, size, chunk_size, entries))
+		{
+			g_warning("Could not format %s.", split[0]);
+			goto end;
+		}
+	}
+	else if (bd->superblock.version != J_BLOCK_VERSION
+	         || bd->superblock.chunk_size % J_BLOCK_SIZE != 0
+	         || bd->superblock.data_offset + bd->superblock.chunks * bd->superblock.chunk_size > size)
+	{
+		g_warning("%s contains an incompatible JULEA object store.", split[0]);
+		goto end;
+	}
+
+	bd->zeros = j_helper_alloc_aligned(J_BLOCK_SIZE, bd->superblock.chunk_size);
+	memset(bd->zeros, 0, bd->superblock.chunk_size);
+
+	if (!block_load(bd))
+	{
+		goto end;
+	}
+
+	*backend_data = bd;
+	ret = TRUE;
+
+end:
+	free(page);
+
+	if (!ret)
+	{
+		block_data_free(bd);
+	}
+
+	return ret;
+}
+
+static void
+backend_fini(gpointer backend_data)
+{
+	JBlockData* bd = backend_data;
+
+	backend_sync(bd, NULL);
+
+	// Clear the namespaces before the metadata they refer to
+	g_hash_table_unref(bd->namespaces);
+	bd->namespaces = NULL;
+
+	block_data_free(bd);
+}
+
+static JBackend block_backend = {
+	.type = J_BACKEND_TYPE_OBJECT,
+	.component = J_BACKEND_COMPONENT_SERVER,
+	.object = {
+		.backend_init = backend_init,
+		.backend_fini = backend_fini,
+		.backend_create = backend_create,
+		.backend_delete = backend_delete,
+		.backend_open = backend_open,
+		.backend_close = backend_close,
+		.backend_status = backend_status,
+		.backend_sync = backend_sync,
+		.backend_syncv = backend_syncv,
+		.backend_read = backend_read,
+		.backend_write = backend_write,
+		.backend_readv = backend_readv,
+		.backend_writev = backend_writev,
+		.backend_discard = backend_discard,
+		.backend_preallocate = backend_preallocate,
+		.backend_get_all = backend_get_all,
+		.backend_get_by_prefix = backend_get_by_prefix,
+		.backend_iterate = backend_iterate }
+};
+
+G_MODULE_EXPORT
+JBackend*
+backend_info(void)
+{
+	return &block_backend;
+}
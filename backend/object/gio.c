@@ -16,6 +16,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define _GNU_SOURCE
+
 #include <julea-config.h>
 
 #include <glib.h>
@@ -23,11 +25,41 @@
 #include <gio/gio.h>
 #include <gmodule.h>
 
+#ifdef G_OS_UNIX
+#include <gio/gfiledescriptorbased.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#endif
+
 #include <julea.h>
 
+/**
+ * The maximum number of streams kept open per object.
+ * Vectored I/O uses up to this many streams to keep several requests in flight.
+ **/
+#define JD_BACKEND_STREAMS 4
+
+/**
+ * The maximum number of objects that are kept open while not in use.
+ **/
+#define JD_BACKEND_IDLE_OBJECTS 256
+
 struct JBackendData
 {
 	gchar* path;
+
+	GMutex mutex[1];
+
+	/**
+	 * Maps paths to JBackendObject elements, so that their streams can be reused.
+	 **/
+	GHashTable* objects;
+
+	/**
+	 * Objects that are not in use, most recently used first.
+	 **/
+	GQueue idle[1];
 };
 
 typedef struct JBackendData JBackendData;
@@ -43,17 +75,445 @@ typedef struct JBackendIterator JBackendIterator;
 
 struct JBackendObject
 {
+	JBackendData* bd;
+
 	gchar* path;
-	GFileIOStream* stream;
+	GFile* file;
+
+	/**
+	 * Streams that are not in use.
+	 * Streams have a position, so each one is used by one operation at a time.
+	 **/
+	GMutex mutex[1];
+	GQueue streams[1];
+
+	/**
+	 * Whether the object has been deleted or replaced and must not be cached anymore.
+	 **/
+	gboolean deleted;
+
+	/**
+	 * The object's link in the idle queue, NULL while the object is in use.
+	 **/
+	GList* idle_link;
+
+	/**
+	 * Protected by the backend's mutex.
+	 **/
+	guint ref_count;
 };
 
 typedef struct JBackendObject JBackendObject;
 
+/**
+ * A vectored read or write whose extents are distributed over multiple streams.
+ **/
+struct JBackendTransfer
+{
+	JBackendObject* bo;
+	JBackendObjectExtent* extents;
+	guint32 count;
+
+	/**
+	 * The next extent to start.
+	 **/
+	guint32 next;
+
+	/**
+	 * The number of lanes that still have requests in flight.
+	 **/
+	guint lanes;
+
+	gboolean write;
+	gboolean ret;
+};
+
+typedef struct JBackendTransfer JBackendTransfer;
+
+/**
+ * A stream working on the extents of a transfer, one at a time.
+ **/
+struct JBackendLane
+{
+	JBackendTransfer* transfer;
+	GFileIOStream* stream;
+	guint32 extent;
+	guint64 position;
+};
+
+typedef struct JBackendLane JBackendLane;
+
+static JBackendObject*
+backend_object_new(JBackendData* bd, gchar* path, GFile* file, GFileIOStream* stream)
+{
+	JBackendObject* bo;
+
+	bo = g_slice_new(JBackendObject);
+	bo->bd = bd;
+	bo->path = path;
+	bo->file = file;
+	g_mutex_init(bo->mutex);
+	g_queue_init(bo->streams);
+	g_queue_push_head(bo->streams, stream);
+	bo->deleted = FALSE;
+	bo->idle_link = NULL;
+	bo->ref_count = 1;
+
+	return bo;
+}
+
+static void
+backend_object_free(JBackendObject* bo)
+{
+	GFileIOStream* stream;
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_CLOSE);
+
+	while ((stream = g_queue_pop_head(bo->streams)) != NULL)
+	{
+		g_io_stream_close(G_IO_STREAM(stream), NULL, NULL);
+		g_object_unref(stream);
+	}
+
+	j_trace_file_end(bo->path, J_TRACE_FILE_CLOSE, 0, 0);
+
+	g_mutex_clear(bo->mutex);
+	g_object_unref(bo->file);
+	g_free(bo->path);
+	g_slice_free(JBackendObject, bo);
+}
+
+/**
+ * Returns a cached object and takes a reference.
+ *
+ * \private
+ *
+ * \param bd   The backend data.
+ * \param path The object's path.
+ *
+ * \return The object, NULL if it is not cached.
+ **/
+static JBackendObject*
+backend_object_lookup(JBackendData* bd, gchar const* path)
+{
+	JBackendObject* bo;
+
+	g_mutex_lock(bd->mutex);
+
+	if ((bo = g_hash_table_lookup(bd->objects, path)) != NULL)
+	{
+		if (bo->idle_link != NULL)
+		{
+			g_queue_delete_link(bd->idle, bo->idle_link);
+			bo->idle_link = NULL;
+		}
+
+		bo->ref_count++;
+	}
+
+	g_mutex_unlock(bd->mutex);
+
+	return bo;
+}
+
+/**
+ * Adds an object to the cache, replacing any object with the same path.
+ *
+ * \private
+ *
+ * \param bd The backend data.
+ * \param bo An object.
+ **/
+static void
+backend_object_insert(JBackendData* bd, JBackendObject* bo)
+{
+	JBackendObject* old;
+	JBackendObject* evict = NULL;
+
+	g_mutex_lock(bd->mutex);
+
+	if ((old = g_hash_table_lookup(bd->objects, bo->path)) != NULL)
+	{
+		old->deleted = TRUE;
+
+		if (old->idle_link != NULL)
+		{
+			g_queue_delete_link(bd->idle, old->idle_link);
+			old->idle_link = NULL;
+			evict = old;
+		}
+	}
+
+	g_hash_table_replace(bd->objects, bo->path, bo);
+
+	g_mutex_unlock(bd->mutex);
+
+	if (evict != NULL)
+	{
+		backend_object_free(evict);
+	}
+}
+
+static void
+backend_object_unref(JBackendObject* bo)
+{
+	JBackendData* bd = bo->bd;
+	JBackendObject* evict = NULL;
+
+	g_mutex_lock(bd->mutex);
+
+	if (--bo->ref_count == 0)
+	{
+		if (bo->deleted)
+		{
+			// Deleted objects have already been removed from the cache.
+			evict = bo;
+		}
+		else
+		{
+			g_queue_push_head(bd->idle, bo);
+			bo->idle_link = bd->idle->head;
+
+			if (bd->idle->length > JD_BACKEND_IDLE_OBJECTS)
+			{
+				evict = g_queue_pop_tail(bd->idle);
+				evict->idle_link = NULL;
+				g_hash_table_remove(bd->objects, evict->path);
+			}
+		}
+	}
+
+	g_mutex_unlock(bd->mutex);
+
+	if (evict != NULL)
+	{
+		backend_object_free(evict);
+	}
+}
+
+/**
+ * Returns an unused stream of an object, opening a new one if all are in use.
+ *
+ * \private
+ *
+ * \param bo An object.
+ *
+ * \return A stream, NULL on error.
+ **/
+static GFileIOStream*
+backend_stream_get(JBackendObject* bo)
+{
+	GFileIOStream* stream;
+
+	g_mutex_lock(bo->mutex);
+	stream = g_queue_pop_head(bo->streams);
+	g_mutex_unlock(bo->mutex);
+
+	if (stream == NULL)
+	{
+		j_trace_file_begin(bo->path, J_TRACE_FILE_OPEN);
+		stream = g_file_open_readwrite(bo->file, NULL, NULL);
+		j_trace_file_end(bo->path, J_TRACE_FILE_OPEN, 0, 0);
+	}
+
+	return stream;
+}
+
+static void
+backend_stream_put(JBackendObject* bo, GFileIOStream* stream)
+{
+	g_mutex_lock(bo->mutex);
+
+	if (bo->streams->length < JD_BACKEND_STREAMS)
+	{
+		g_queue_push_head(bo->streams, stream);
+		stream = NULL;
+	}
+
+	g_mutex_unlock(bo->mutex);
+
+	if (stream != NULL)
+	{
+		g_io_stream_close(G_IO_STREAM(stream), NULL, NULL);
+		g_object_unref(stream);
+	}
+}
+
+static void backend_lane_done(GObject*, GAsyncResult*, gpointer);
+
+/**
+ * Starts the next extent of a lane's transfer.
+ * Seeking is only necessary if the extent does not start where the lane's previous one ended.
+ *
+ * \private
+ *
+ * \param lane A lane.
+ **/
+static void
+backend_lane_next(JBackendLane* lane)
+{
+	JBackendTransfer* transfer = lane->transfer;
+
+	while (transfer->next < transfer->count)
+	{
+		JBackendObjectExtent* extent;
+
+		lane->extent = transfer->next++;
+		extent = &(transfer->extents[lane->extent]);
+
+		if (extent->offset != lane->position)
+		{
+			gboolean ret;
+
+			j_trace_file_begin(transfer->bo->path, J_TRACE_FILE_SEEK);
+			ret = g_seekable_seek(G_SEEKABLE(lane->stream), extent->offset, G_SEEK_SET, NULL, NULL);
+			j_trace_file_end(transfer->bo->path, J_TRACE_FILE_SEEK, 0, extent->offset);
+
+			if (!ret)
+			{
+				extent->bytes = 0;
+				transfer->ret = FALSE;
+				lane->position = G_MAXUINT64;
+				continue;
+			}
+		}
+
+		if (transfer->write)
+		{
+			g_output_stream_write_all_async(g_io_stream_get_output_stream(G_IO_STREAM(lane->stream)), extent->data, extent->length, G_PRIORITY_DEFAULT, NULL, backend_lane_done, lane);
+		}
+		else
+		{
+			g_input_stream_read_all_async(g_io_stream_get_input_stream(G_IO_STREAM(lane->stream)), extent->data, extent->length, G_PRIORITY_DEFAULT, NULL, backend_lane_done, lane);
+		}
+
+		return;
+	}
+
+	transfer->lanes--;
+}
+
+static void
+backend_lane_done(GObject* source, GAsyncResult* result, gpointer data)
+{
+	JBackendLane* lane = data;
+	JBackendTransfer* transfer = lane->transfer;
+	JBackendObjectExtent* extent = &(transfer->extents[lane->extent]);
+	gboolean ret;
+	gsize nbytes = 0;
+
+	if (transfer->write)
+	{
+		ret = g_output_stream_write_all_finish(G_OUTPUT_STREAM(source), result, &nbytes, NULL);
+	}
+	else
+	{
+		ret = g_input_stream_read_all_finish(G_INPUT_STREAM(source), result, &nbytes, NULL);
+	}
+
+	extent->bytes = nbytes;
+	transfer->ret = ret && transfer->ret;
+	// Short transfers leave the stream position unknown
+	lane->position = (nbytes == extent->length) ? extent->offset + nbytes : G_MAXUINT64;
+
+	backend_lane_next(lane);
+}
+
+/**
+ * Performs vectored I/O using GIO's asynchronous API.
+ * The extents are distributed over up to #JD_BACKEND_STREAMS streams, so that several requests are in flight at once.
+ * This hides the latency of remote GVfs mounts.
+ *
+ * \private
+ **/
+static gboolean
+backend_extents_io(JBackendObject* bo, JBackendObjectExtent* extents, guint32 count, gboolean write)
+{
+	JBackendTransfer transfer[1];
+	JBackendLane lanes[JD_BACKEND_STREAMS];
+	GMainContext* context;
+	guint lane_count;
+	guint64 bytes = 0;
+
+	transfer->bo = bo;
+	transfer->extents = extents;
+	transfer->count = count;
+	transfer->next = 0;
+	transfer->lanes = 0;
+	transfer->write = write;
+	transfer->ret = TRUE;
+
+	lane_count = MIN(count, JD_BACKEND_STREAMS);
+
+	// Overlapping writes have to be applied in order, which only a single stream guarantees.
+	for (guint32 i = 1; write && i < count; i++)
+	{
+		if (extents[i].offset < extents[i - 1].offset + extents[i - 1].length)
+		{
+			lane_count = 1;
+			break;
+		}
+	}
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		extents[i].bytes = 0;
+	}
+
+	// The callbacks are dispatched by this thread, independent of other threads' main contexts.
+	context = g_main_context_new();
+	g_main_context_push_thread_default(context);
+
+	j_trace_file_begin(bo->path, (write) ? J_TRACE_FILE_WRITE : J_TRACE_FILE_READ);
+
+	for (guint i = 0; i < lane_count; i++)
+	{
+		lanes[i].transfer = transfer;
+		lanes[i].position = G_MAXUINT64;
+
+		if ((lanes[i].stream = backend_stream_get(bo)) == NULL)
+		{
+			break;
+		}
+
+		transfer->lanes++;
+	}
+
+	lane_count = transfer->lanes;
+
+	for (guint i = 0; i < lane_count; i++)
+	{
+		backend_lane_next(&(lanes[i]));
+	}
+
+	while (transfer->lanes > 0)
+	{
+		g_main_context_iteration(context, TRUE);
+	}
+
+	for (guint i = 0; i < lane_count; i++)
+	{
+		backend_stream_put(bo, lanes[i].stream);
+	}
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		bytes += extents[i].bytes;
+	}
+
+	j_trace_file_end(bo->path, (write) ? J_TRACE_FILE_WRITE : J_TRACE_FILE_READ, bytes, (count > 0) ? extents[0].offset : 0);
+
+	g_main_context_pop_thread_default(context);
+	g_main_context_unref(context);
+
+	return (lane_count > 0 && transfer->ret);
+}
+
 static gboolean
 backend_create(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
 {
 	JBackendData* bd = backend_data;
-	JBackendObject* bo;
+	JBackendObject* bo = NULL;
 	GFile* file;
 	GFile* parent;
 	GFileIOStream* stream;
@@ -72,15 +532,20 @@ backend_create(gpointer backend_data, gchar const* namespace, gchar const* path,
 
 	j_trace_file_end(full_path, J_TRACE_FILE_CREATE, 0, 0);
 
-	bo = g_slice_new(JBackendObject);
-	bo->path = full_path;
-	bo->stream = stream;
+	if (stream != NULL)
+	{
+		bo = backend_object_new(bd, full_path, file, stream);
+		backend_object_insert(bd, bo);
+	}
+	else
+	{
+		g_object_unref(file);
+		g_free(full_path);
+	}
 
 	*backend_object = bo;
 
-	g_object_unref(file);
-
-	return (stream != NULL);
+	return (bo != NULL);
 }
 
 static gboolean
@@ -93,43 +558,60 @@ backend_open(gpointer backend_data, gchar const* namespace, gchar const* path, g
 	gchar* full_path;
 
 	full_path = g_build_filename(bd->path, namespace, path, NULL);
+
+	if ((bo = backend_object_lookup(bd, full_path)) != NULL)
+	{
+		g_free(full_path);
+		goto end;
+	}
+
 	file = g_file_new_for_path(full_path);
 
 	j_trace_file_begin(full_path, J_TRACE_FILE_OPEN);
 	stream = g_file_open_readwrite(file, NULL, NULL);
 	j_trace_file_end(full_path, J_TRACE_FILE_OPEN, 0, 0);
 
-	bo = g_slice_new(JBackendObject);
-	bo->path = full_path;
-	bo->stream = stream;
+	if (stream != NULL)
+	{
+		bo = backend_object_new(bd, full_path, file, stream);
+		backend_object_insert(bd, bo);
+	}
+	else
+	{
+		g_object_unref(file);
+		g_free(full_path);
+	}
 
+end:
 	*backend_object = bo;
 
-	g_object_unref(file);
-
-	return (stream != NULL);
+	return (bo != NULL);
 }
 
 static gboolean
 backend_delete(gpointer backend_data, gpointer backend_object)
 {
+	JBackendData* bd = backend_data;
 	JBackendObject* bo = backend_object;
 	gboolean ret;
-	GFile* file;
-
-	(void)backend_data;
-
-	file = g_file_new_for_path(bo->path);
 
 	j_trace_file_begin(bo->path, J_TRACE_FILE_DELETE);
-	ret = g_file_delete(file, NULL, NULL);
+	ret = g_file_delete(bo->file, NULL, NULL);
 	j_trace_file_end(bo->path, J_TRACE_FILE_DELETE, 0, 0);
 
-	g_object_unref(file);
+	// Make sure the streams are not reused for a new object with the same name.
+	g_mutex_lock(bd->mutex);
 
-	g_object_unref(bo->stream);
-	g_free(bo->path);
-	g_slice_free(JBackendObject, bo);
+	if (!bo->deleted && g_hash_table_lookup(bd->objects, bo->path) == bo)
+	{
+		g_hash_table_remove(bd->objects, bo->path);
+	}
+
+	bo->deleted = TRUE;
+
+	g_mutex_unlock(bd->mutex);
+
+	backend_object_unref(bo);
 
 	return ret;
 }
@@ -137,20 +619,11 @@ backend_delete(gpointer backend_data, gpointer backend_object)
 static gboolean
 backend_close(gpointer backend_data, gpointer backend_object)
 {
-	JBackendObject* bo = backend_object;
-	gboolean ret;
-
 	(void)backend_data;
 
-	j_trace_file_begin(bo->path, J_TRACE_FILE_CLOSE);
-	ret = g_io_stream_close(G_IO_STREAM(bo->stream), NULL, NULL);
-	j_trace_file_end(bo->path, J_TRACE_FILE_CLOSE, 0, 0);
-
-	g_object_unref(bo->stream);
-	g_free(bo->path);
-	g_slice_free(JBackendObject, bo);
+	backend_object_unref(backend_object);
 
-	return ret;
+	return TRUE;
 }
 
 static gboolean
@@ -163,16 +636,16 @@ backend_status(gpointer backend_data, gpointer backend_object, gint64* modificat
 
 	if (modification_time != NULL || size != NULL)
 	{
-		GFile* file;
 		GFileInfo* file_info;
 
-		file = g_file_new_for_path(bo->path);
-
 		j_trace_file_begin(bo->path, J_TRACE_FILE_STATUS);
-		file_info = g_file_query_info(file, G_FILE_ATTRIBUTE_STANDARD_SIZE "," G_FILE_ATTRIBUTE_TIME_MODIFIED "," G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC, G_FILE_QUERY_INFO_NONE, NULL, NULL);
+		file_info = g_file_query_info(bo->file, G_FILE_ATTRIBUTE_STANDARD_SIZE "," G_FILE_ATTRIBUTE_TIME_MODIFIED "," G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC, G_FILE_QUERY_INFO_NONE, NULL, NULL);
 		j_trace_file_end(bo->path, J_TRACE_FILE_STATUS, 0, 0);
 
-		ret = (file_info != NULL);
+		if (file_info == NULL)
+		{
+			return FALSE;
+		}
 
 		if (modification_time != NULL)
 		{
@@ -200,7 +673,6 @@ backend_status(gpointer backend_data, gpointer backend_object, gint64* modificat
 		}
 
 		g_object_unref(file_info);
-		g_object_unref(file);
 	}
 
 	return ret;
@@ -210,15 +682,22 @@ static gboolean
 backend_sync(gpointer backend_data, gpointer backend_object)
 {
 	JBackendObject* bo = backend_object;
-	gboolean ret;
-	GOutputStream* output;
+	gboolean ret = TRUE;
 
 	(void)backend_data;
 
-	output = g_io_stream_get_output_stream(G_IO_STREAM(bo->stream));
-
 	j_trace_file_begin(bo->path, J_TRACE_FILE_SYNC);
-	ret = g_output_stream_flush(output, NULL, NULL);
+
+	// Streams that are in use belong to operations that have not finished yet.
+	g_mutex_lock(bo->mutex);
+
+	for (GList* link = bo->streams->head; link != NULL; link = link->next)
+	{
+		ret = g_output_stream_flush(g_io_stream_get_output_stream(G_IO_STREAM(link->data)), NULL, NULL) && ret;
+	}
+
+	g_mutex_unlock(bo->mutex);
+
 	j_trace_file_end(bo->path, J_TRACE_FILE_SYNC, 0, 0);
 
 	return ret;
@@ -227,27 +706,20 @@ backend_sync(gpointer backend_data, gpointer backend_object)
 static gboolean
 backend_read(gpointer backend_data, gpointer backend_object, gpointer buffer, guint64 length, guint64 offset, guint64* bytes_read)
 {
-	JBackendObject* bo = backend_object;
+	JBackendObjectExtent extent[1];
 	gboolean ret;
 
-	GInputStream* input;
-	gsize nbytes;
-
 	(void)backend_data;
 
-	input = g_io_stream_get_input_stream(G_IO_STREAM(bo->stream));
+	extent->data = buffer;
+	extent->length = length;
+	extent->offset = offset;
 
-	j_trace_file_begin(bo->path, J_TRACE_FILE_SEEK);
-	g_seekable_seek(G_SEEKABLE(bo->stream), offset, G_SEEK_SET, NULL, NULL);
-	j_trace_file_end(bo->path, J_TRACE_FILE_SEEK, 0, offset);
-
-	j_trace_file_begin(bo->path, J_TRACE_FILE_READ);
-	ret = g_input_stream_read_all(input, buffer, length, &nbytes, NULL, NULL);
-	j_trace_file_end(bo->path, J_TRACE_FILE_READ, nbytes, offset);
+	ret = backend_extents_io(backend_object, extent, 1, FALSE);
 
 	if (bytes_read != NULL)
 	{
-		*bytes_read = nbytes;
+		*bytes_read = extent->bytes;
 	}
 
 	return ret;
@@ -256,28 +728,79 @@ backend_read(gpointer backend_data, gpointer backend_object, gpointer buffer, gu
 static gboolean
 backend_write(gpointer backend_data, gpointer backend_object, gconstpointer buffer, guint64 length, guint64 offset, guint64* bytes_written)
 {
-	JBackendObject* bo = backend_object;
+	JBackendObjectExtent extent[1];
 	gboolean ret;
 
-	GOutputStream* output;
-	gsize nbytes;
+	(void)backend_data;
+
+	extent->data = (gpointer)buffer;
+	extent->length = length;
+	extent->offset = offset;
+
+	ret = backend_extents_io(backend_object, extent, 1, TRUE);
+
+	if (bytes_written != NULL)
+	{
+		*bytes_written = extent->bytes;
+	}
+
+	return ret;
+}
 
+static gboolean
+backend_readv(gpointer backend_data, gpointer backend_object, JBackendObjectExtent* extents, guint32 count)
+{
 	(void)backend_data;
 
-	output = g_io_stream_get_output_stream(G_IO_STREAM(bo->stream));
+	return backend_extents_io(backend_object, extents, count, FALSE);
+}
 
-	j_trace_file_begin(bo->path, J_TRACE_FILE_SEEK);
-	g_seekable_seek(G_SEEKABLE(bo->stream), offset, G_SEEK_SET, NULL, NULL);
-	j_trace_file_end(bo->path, J_TRACE_FILE_SEEK, 0, offset);
+static gboolean
+backend_writev(gpointer backend_data, gpointer backend_object, JBackendObjectExtent* extents, guint32 count)
+{
+	(void)backend_data;
 
-	j_trace_file_begin(bo->path, J_TRACE_FILE_WRITE);
-	ret = g_output_stream_write_all(output, buffer, length, &nbytes, NULL, NULL);
-	j_trace_file_end(bo->path, J_TRACE_FILE_WRITE, nbytes, offset);
+	return backend_extents_io(backend_object, extents, count, TRUE);
+}
 
-	if (bytes_written != NULL)
+static gboolean
+backend_preallocate(gpointer backend_data, gpointer backend_object, guint64 size)
+{
+	JBackendObject* bo = backend_object;
+	gboolean ret = TRUE;
+
+	(void)backend_data;
+	(void)bo;
+	(void)size;
+
+#if defined(G_OS_UNIX) && defined(FALLOC_FL_KEEP_SIZE)
 	{
-		*bytes_written = nbytes;
+		GFileIOStream* stream;
+		GOutputStream* output;
+
+		if ((stream = backend_stream_get(bo)) == NULL)
+		{
+			return FALSE;
+		}
+
+		output = g_io_stream_get_output_stream(G_IO_STREAM(stream));
+
+		// GIO has no preallocation API, use the descriptor of local files directly
+		if (G_IS_FILE_DESCRIPTOR_BASED(output))
+		{
+			gint fd;
+
+			fd = g_file_descriptor_based_get_fd(G_FILE_DESCRIPTOR_BASED(output));
+
+			if (fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, size) != 0 && errno != EOPNOTSUPP)
+			{
+				ret = FALSE;
+			}
+		}
+
+		backend_stream_put(bo, stream);
 	}
+#endif
 
 	return ret;
 }
@@ -388,6 +911,9 @@ backend_init(gchar const* path, gpointer* backend_data)
 
 	bd = g_slice_new(JBackendData);
 	bd->path = g_strdup(path);
+	g_mutex_init(bd->mutex);
+	bd->objects = g_hash_table_new(g_str_hash, g_str_equal);
+	g_queue_init(bd->idle);
 
 	file = g_file_new_for_path(path);
 	g_file_make_directory_with_parents(file, NULL, NULL);
@@ -402,7 +928,17 @@ static void
 backend_fini(gpointer backend_data)
 {
 	JBackendData* bd = backend_data;
+	JBackendObject* bo;
+
+	// All objects have been closed at this point, so only idle ones are left.
+	while ((bo = g_queue_pop_head(bd->idle)) != NULL)
+	{
+		g_hash_table_remove(bd->objects, bo->path);
+		backend_object_free(bo);
+	}
 
+	g_hash_table_unref(bd->objects);
+	g_mutex_clear(bd->mutex);
 	g_free(bd->path);
 	g_slice_free(JBackendData, bd);
 }
@@ -421,6 +957,9 @@ static JBackend gio_backend = {
 		.backend_sync = backend_sync,
 		.backend_read = backend_read,
 		.backend_write = backend_write,
+		.backend_readv = backend_readv,
+		.backend_writev = backend_writev,
+		.backend_preallocate = backend_preallocate,
 		.backend_get_all = backend_get_all,
 		.backend_get_by_prefix = backend_get_by_prefix,
 		.backend_iterate = backend_iterate }
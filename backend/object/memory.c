@@ -0,0 +1,836 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <gmodule.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <julea.h>
+
+/*
+ * Objects are stored as arrays of fixed-size, page-aligned chunks.
+ * Chunks are allocated when they are first written to, missing chunks read as zeros.
+ * Handles reference their object, so deleted objects stay readable until all handles are closed.
+ */
+
+/**
+ * The default chunk size.
+ **/
+#define J_MEMORY_CHUNK_SIZE (1024 * 1024)
+
+/**
+ * The size of a transparent huge page.
+ **/
+#define J_MEMORY_HUGEPAGE_SIZE (2 * 1024 * 1024)
+
+struct JMemoryData
+{
+	GRWLock lock[1];
+
+	// namespace(gchar*) -> (name(gchar*) -> JMemoryObject*)
+	GHashTable* namespaces;
+
+	guint64 chunk_size;
+	gsize alignment;
+	gboolean hugepages;
+
+	/**
+	 * The maximum number of bytes allocated for chunks, 0 for unlimited.
+	 **/
+	guint64 capacity;
+
+	GMutex allocated_mutex[1];
+	guint64 allocated;
+};
+
+typedef struct JMemoryData JMemoryData;
+
+struct JMemoryObject
+{
+	gint ref_count;
+
+	JMemoryData* bd;
+	gchar* namespace;
+	gchar* name;
+
+	GRWLock lock[1];
+
+	// Chunk data, NULL for chunks that have not been written
+	GPtrArray* chunks;
+	guint64 size;
+	gint64 modification_time;
+};
+
+typedef struct JMemoryObject JMemoryObject;
+
+struct JMemoryIterator
+{
+	GPtrArray* names;
+	guint index;
+};
+
+typedef struct JMemoryIterator JMemoryIterator;
+
+/**
+ * Allocates a chunk if the capacity allows it.
+ *
+ * \private
+ *
+ * \param bd The backend data.
+ *
+ * \return A zeroed chunk, or NULL if the capacity is exhausted.
+ **/
+static gpointer
+memory_chunk_new(JMemoryData* bd)
+{
+	gpointer chunk;
+
+	g_mutex_lock(bd->allocated_mutex);
+
+	if (bd->capacity > 0 && bd->allocated + bd->chunk_size > bd->capacity)
+	{
+		g_mutex_unlock(bd->allocated_mutex);
+		return NULL;
+	}
+
+	bd->allocated += bd->chunk_size;
+
+	g_mutex_unlock(bd->allocated_mutex);
+
+	chunk = j_helper_alloc_aligned(bd->alignment, bd->chunk_size);
+
+#ifdef MADV_HUGEPAGE
+	if (bd->hugepages)
+	{
+		// This is only a hint, the kernel falls back to regular pages if no huge pages are available.
+		madvise(chunk, bd->chunk_size, MADV_HUGEPAGE);
+	}
+#endif
+
+	memset(chunk, 0, bd->chunk_size);
+
+	return chunk;
+}
+
+static void
+memory_chunk_free(JMemoryData* bd, gpointer chunk)
+{
+	if (chunk == NULL)
+	{
+		return;
+	}
+
+	free(chunk);
+
+	g_mutex_lock(bd->allocated_mutex);
+	bd->allocated -= bd->chunk_size;
+	g_mutex_unlock(bd->allocated_mutex);
+}
+
+static JMemoryObject*
+memory_object_ref(JMemoryObject* object)
+{
+	g_atomic_int_inc(&(object->ref_count));
+
+	return object;
+}
+
+static void
+memory_object_unref(JMemoryObject* object)
+{
+	if (g_atomic_int_dec_and_test(&(object->ref_count)))
+	{
+		for (guint i = 0; i < object->chunks->len; i++)
+		{
+			memory_chunk_free(object->bd, g_ptr_array_index(object->chunks, i));
+		}
+
+		g_ptr_array_unref(object->chunks);
+		g_rw_lock_clear(object->lock);
+		g_free(object->namespace);
+		g_free(object->name);
+		g_slice_free(JMemoryObject, object);
+	}
+}
+
+/**
+ * Makes sure the chunks covering a range exist.
+ * Has to be called with the object's writer lock held.
+ *
+ * \private
+ *
+ * \param object An object.
+ * \param length The range's length.
+ * \param offset The range's offset.
+ *
+ * \return The number of bytes from offset that are backed by chunks.
+ **/
+static guint64
+memory_object_allocate(JMemoryObject* object, guint64 length, guint64 offset)
+{
+	JMemoryData* bd = object->bd;
+	guint64 first;
+	guint64 last;
+
+	if (length == 0)
+	{
+		return 0;
+	}
+
+	first = offset / bd->chunk_size;
+	last = (offset + length - 1) / bd->chunk_size;
+
+	if (object->chunks->len <= last)
+	{
+		g_ptr_array_set_size(object->chunks, last + 1);
+	}
+
+	for (guint64 i = first; i <= last; i++)
+	{
+		if (g_ptr_array_index(object->chunks, i) == NULL)
+		{
+			gpointer chunk;
+
+			if ((chunk = memory_chunk_new(bd)) == NULL)
+			{
+				// Only the chunks before the missing one can be used
+				return (i == first) ? 0 : i * bd->chunk_size - offset;
+			}
+
+			object->chunks->pdata[i] = chunk;
+		}
+	}
+
+	return length;
+}
+
+/**
+ * Copies data from or to an object.
+ * Has to be called with the object's lock held, writes require the chunks to be allocated.
+ *
+ * \private
+ *
+ * \param object An object.
+ * \param buffer A buffer.
+ * \param length The number of bytes.
+ * \param offset The offset within the object.
+ * \param write  Whether to write to the object.
+ **/
+static void
+memory_object_copy(JMemoryObject* object, gpointer buffer, guint64 length, guint64 offset, gboolean write)
+{
+	JMemoryData* bd = object->bd;
+	guint64 position = 0;
+
+	while (position < length)
+	{
+		guint64 index = (offset + position) / bd->chunk_size;
+		guint64 chunk_offset = (offset + position) % bd->chunk_size;
+		guint64 chunk_length = MIN(length - position, bd->chunk_size - chunk_offset);
+		gchar* chunk = (index < object->chunks->len) ? g_ptr_array_index(object->chunks, index) : NULL;
+
+		if (write)
+		{
+			memcpy(chunk + chunk_offset, (gchar*)buffer + position, chunk_length);
+		}
+		else if (chunk != NULL)
+		{
+			memcpy((gchar*)buffer + position, chunk + chunk_offset, chunk_length);
+		}
+		else
+		{
+			memset((gchar*)buffer + position, 0, chunk_length);
+		}
+
+		position += chunk_length;
+	}
+}
+
+/**
+ * Reads from an object.
+ * Has to be called with the object's reader lock held.
+ *
+ * \private
+ *
+ * \return The number of bytes read, which is smaller than length when reading beyond the end.
+ **/
+static guint64
+memory_object_read(JMemoryObject* object, gpointer buffer, guint64 length, guint64 offset)
+{
+	if (offset >= object->size)
+	{
+		return 0;
+	}
+
+	length = MIN(length, object->size - offset);
+	memory_object_copy(object, buffer, length, offset, FALSE);
+
+	return length;
+}
+
+/**
+ * Writes to an object.
+ * Has to be called with the object's writer lock held.
+ *
+ * \private
+ *
+ * \return The number of bytes written, which is smaller than length if the capacity is exhausted.
+ **/
+static guint64
+memory_object_write(JMemoryObject* object, gconstpointer buffer, guint64 length, guint64 offset)
+{
+	length = memory_object_allocate(object, length, offset);
+	memory_object_copy(object, (gpointer)buffer, length, offset, TRUE);
+
+	if (length > 0)
+	{
+		object->size = MAX(object->size, offset + length);
+		object->modification_time = g_get_real_time();
+	}
+
+	return length;
+}
+
+static GHashTable*
+memory_namespace_get(JMemoryData* bd, gchar const* namespace, gboolean create)
+{
+	GHashTable* objects;
+
+	if ((objects = g_hash_table_lookup(bd->namespaces, namespace)) == NULL && create)
+	{
+		objects = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)memory_object_unref);
+		g_hash_table_insert(bd->namespaces, g_strdup(namespace), objects);
+	}
+
+	return objects;
+}
+
+static gboolean
+backend_create(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
+{
+	JMemoryData* bd = backend_data;
+	JMemoryObject* object;
+	GHashTable* objects;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(path != NULL, FALSE);
+	g_return_val_if_fail(backend_object != NULL, FALSE);
+
+	g_rw_lock_writer_lock(bd->lock);
+
+	objects = memory_namespace_get(bd, namespace, TRUE);
+
+	// Creating an existing object opens it, like the posix backend
+	if ((object = g_hash_table_lookup(objects, path)) == NULL)
+	{
+		object = g_slice_new(JMemoryObject);
+		object->ref_count = 1;
+		object->bd = bd;
+		object->namespace = g_strdup(namespace);
+		object->name = g_strdup(path);
+		g_rw_lock_init(object->lock);
+		object->chunks = g_ptr_array_new();
+		object->size = 0;
+		object->modification_time = g_get_real_time();
+
+		// The object's name is used as the key
+		g_hash_table_insert(objects, object->name, object);
+	}
+
+	*backend_object = memory_object_ref(object);
+
+	g_rw_lock_writer_unlock(bd->lock);
+
+	return TRUE;
+}
+
+static gboolean
+backend_open(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
+{
+	JMemoryData* bd = backend_data;
+	JMemoryObject* object = NULL;
+	GHashTable* objects;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(path != NULL, FALSE);
+	g_return_val_if_fail(backend_object != NULL, FALSE);
+
+	g_rw_lock_reader_lock(bd->lock);
+
+	if ((objects = memory_namespace_get(bd, namespace, FALSE)) != NULL && (object = g_hash_table_lookup(objects, path)) != NULL)
+	{
+		*backend_object = memory_object_ref(object);
+	}
+
+	g_rw_lock_reader_unlock(bd->lock);
+
+	return (object != NULL);
+}
+
+static gboolean
+backend_delete(gpointer backend_data, gpointer backend_object)
+{
+	JMemoryData* bd = backend_data;
+	JMemoryObject* object = backend_object;
+	GHashTable* objects;
+	gboolean ret = FALSE;
+
+	g_rw_lock_writer_lock(bd->lock);
+
+	// Only remove the object if it has not been replaced in the meantime
+	if ((objects = memory_namespace_get(bd, object->namespace, FALSE)) != NULL && g_hash_table_lookup(objects, object->name) == object)
+	{
+		ret = g_hash_table_remove(objects, object->name);
+	}
+
+	g_rw_lock_writer_unlock(bd->lock);
+
+	memory_object_unref(object);
+
+	return ret;
+}
+
+static gboolean
+backend_close(gpointer backend_data, gpointer backend_object)
+{
+	JMemoryObject* object = backend_object;
+
+	(void)backend_data;
+
+	memory_object_unref(object);
+
+	return TRUE;
+}
+
+static gboolean
+backend_status(gpointer backend_data, gpointer backend_object, gint64* modification_time, guint64* size)
+{
+	JMemoryObject* object = backend_object;
+
+	(void)backend_data;
+
+	g_rw_lock_reader_lock(object->lock);
+
+	if (modification_time != NULL)
+	{
+		*modification_time = object->modification_time;
+	}
+
+	if (size != NULL)
+	{
+		*size = object->size;
+	}
+
+	g_rw_lock_reader_unlock(object->lock);
+
+	return TRUE;
+}
+
+static gboolean
+backend_sync(gpointer backend_data, gpointer backend_object)
+{
+	(void)backend_data;
+	(void)backend_object;
+
+	// Nothing is persisted
+	return TRUE;
+}
+
+static gboolean
+backend_read(gpointer backend_data, gpointer backend_object, gpointer buffer, guint64 length, guint64 offset, guint64* bytes_read)
+{
+	JMemoryObject* object = backend_object;
+	guint64 nbytes;
+
+	(void)backend_data;
+
+	g_rw_lock_reader_lock(object->lock);
+	nbytes = memory_object_read(object, buffer, length, offset);
+	g_rw_lock_reader_unlock(object->lock);
+
+	if (bytes_read != NULL)
+	{
+		*bytes_read = nbytes;
+	}
+
+	return (nbytes == length);
+}
+
+static gboolean
+backend_write(gpointer backend_data, gpointer backend_object, gconstpointer buffer, guint64 length, guint64 offset, guint64* bytes_written)
+{
+	JMemoryObject* object = backend_object;
+	guint64 nbytes;
+
+	(void)backend_data;
+
+	g_rw_lock_writer_lock(object->lock);
+	nbytes = memory_object_write(object, buffer, length, offset);
+	g_rw_lock_writer_unlock(object->lock);
+
+	if (bytes_written != NULL)
+	{
+		*bytes_written = nbytes;
+	}
+
+	return (nbytes == length);
+}
+
+static gboolean
+backend_readv(gpointer backend_data, gpointer backend_object, JBackendObjectExtent* extents, guint32 count)
+{
+	JMemoryObject* object = backend_object;
+	gboolean ret = TRUE;
+
+	(void)backend_data;
+
+	g_rw_lock_reader_lock(object->lock);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		extents[i].bytes = memory_object_read(object, extents[i].data, extents[i].length, extents[i].offset);
+		ret = ret && (extents[i].bytes == extents[i].length);
+	}
+
+	g_rw_lock_reader_unlock(object->lock);
+
+	return ret;
+}
+
+static gboolean
+backend_writev(gpointer backend_data, gpointer backend_object, JBackendObjectExtent* extents, guint32 count)
+{
+	JMemoryObject* object = backend_object;
+	gboolean ret = TRUE;
+
+	(void)backend_data;
+
+	g_rw_lock_writer_lock(object->lock);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		extents[i].bytes = memory_object_write(object, extents[i].data, extents[i].length, extents[i].offset);
+		ret = ret && (extents[i].bytes == extents[i].length);
+	}
+
+	g_rw_lock_writer_unlock(object->lock);
+
+	return ret;
+}
+
+static gboolean
+backend_discard(gpointer backend_data, gpointer backend_object, guint64 length, guint64 offset)
+{
+	JMemoryData* bd = backend_data;
+	JMemoryObject* object = backend_object;
+
+	g_rw_lock_writer_lock(object->lock);
+
+	if (offset < object->size)
+	{
+		guint64 position = offset;
+		guint64 end;
+
+		end = MIN(offset + length, object->size);
+
+		while (position < end)
+		{
+			guint64 index = position / bd->chunk_size;
+			guint64 chunk_offset = position % bd->chunk_size;
+			guint64 chunk_length = MIN(end - position, bd->chunk_size - chunk_offset);
+			gchar* chunk = (index < object->chunks->len) ? g_ptr_array_index(object->chunks, index) : NULL;
+
+			if (chunk != NULL)
+			{
+				if (chunk_length == bd->chunk_size)
+				{
+					// Whole chunks are released and read as zeros afterwards
+					memory_chunk_free(bd, chunk);
+					object->chunks->pdata[index] = NULL;
+				}
+				else
+				{
+					memset(chunk + chunk_offset, 0, chunk_length);
+				}
+			}
+
+			position += chunk_length;
+		}
+
+		object->modification_time = g_get_real_time();
+	}
+
+	g_rw_lock_writer_unlock(object->lock);
+
+	return TRUE;
+}
+
+static gboolean
+backend_preallocate(gpointer backend_data, gpointer backend_object, guint64 size)
+{
+	JMemoryObject* object = backend_object;
+	guint64 nbytes;
+
+	(void)backend_data;
+
+	g_rw_lock_writer_lock(object->lock);
+	// Keep the size so that the preallocated space is not visible to readers
+	nbytes = memory_object_allocate(object, size, 0);
+	g_rw_lock_writer_unlock(object->lock);
+
+	return (nbytes == size);
+}
+
+static gboolean
+backend_clone(gpointer backend_data, gpointer backend_object, gpointer clone_object)
+{
+	JMemoryData* bd = backend_data;
+	JMemoryObject* object = backend_object;
+	JMemoryObject* clone = clone_object;
+	gboolean ret = TRUE;
+
+	if (object == clone)
+	{
+		return TRUE;
+	}
+
+	// Lock in a fixed order, so that concurrent clones in opposite directions do not deadlock
+	if (object < clone)
+	{
+		g_rw_lock_reader_lock(object->lock);
+		g_rw_lock_writer_lock(clone->lock);
+	}
+	else
+	{
+		g_rw_lock_writer_lock(clone->lock);
+		g_rw_lock_reader_lock(object->lock);
+	}
+
+	for (guint i = 0; i < clone->chunks->len; i++)
+	{
+		memory_chunk_free(bd, g_ptr_array_index(clone->chunks, i));
+	}
+
+	// Only written chunks are copied, so sparse objects stay sparse
+	g_ptr_array_set_size(clone->chunks, 0);
+	g_ptr_array_set_size(clone->chunks, object->chunks->len);
+
+	for (guint i = 0; i < object->chunks->len && ret; i++)
+	{
+		gpointer chunk = g_ptr_array_index(object->chunks, i);
+
+		if (chunk != NULL)
+		{
+			gpointer clone_chunk;
+
+			if ((clone_chunk = memory_chunk_new(bd)) == NULL)
+			{
+				ret = FALSE;
+				break;
+			}
+
+			memcpy(clone_chunk, chunk, bd->chunk_size);
+			clone->chunks->pdata[i] = clone_chunk;
+		}
+	}
+
+	clone->size = (ret) ? object->size : 0;
+	clone->modification_time = g_get_real_time();
+
+	g_rw_lock_reader_unlock(object->lock);
+	g_rw_lock_writer_unlock(clone->lock);
+
+	return ret;
+}
+
+static gboolean
+backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const* prefix, gpointer* backend_iterator)
+{
+	JMemoryData* bd = backend_data;
+	JMemoryIterator* iterator;
+	GHashTable* objects;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+
+	iterator = g_slice_new(JMemoryIterator);
+	iterator->names = g_ptr_array_new_with_free_func(g_free);
+	iterator->index = 0;
+
+	g_rw_lock_reader_lock(bd->lock);
+
+	// Iterate over a snapshot of the names, so that the lock does not have to be held
+	if ((objects = memory_namespace_get(bd, namespace, FALSE)) != NULL)
+	{
+		GHashTableIter iter;
+		gchar const* name;
+
+		g_hash_table_iter_init(&iter, objects);
+
+		while (g_hash_table_iter_next(&iter, (gpointer*)&name, NULL))
+		{
+			if (prefix == NULL || g_str_has_prefix(name, prefix))
+			{
+				g_ptr_array_add(iterator->names, g_strdup(name));
+			}
+		}
+	}
+
+	g_rw_lock_reader_unlock(bd->lock);
+
+	*backend_iterator = iterator;
+
+	return TRUE;
+}
+
+static gboolean
+backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend_iterator)
+{
+	return backend_get_by_prefix(backend_data, namespace, NULL, backend_iterator);
+}
+
+static gboolean
+backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const** name)
+{
+	JMemoryIterator* iterator = backend_iterator;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+
+	if (iterator->index < iterator->names->len)
+	{
+		*name = g_ptr_array_index(iterator->names, iterator->index);
+		iterator->index++;
+
+		return TRUE;
+	}
+
+	g_ptr_array_unref(iterator->names);
+	g_slice_free(JMemoryIterator, iterator);
+
+	return FALSE;
+}
+
+static gboolean
+backend_init(gchar const* path, gpointer* backend_data)
+{
+	JMemoryData* bd;
+	g_auto(GStrv) split = NULL;
+	glong page_size;
+
+	bd = g_slice_new(JMemoryData);
+	bd->chunk_size = J_MEMORY_CHUNK_SIZE;
+	bd->hugepages = FALSE;
+	bd->capacity = 0;
+	bd->allocated = 0;
+
+	// The path itself is ignored, it can only contain optional settings
+	split = g_strsplit((path != NULL) ? path : "", ":", 0);
+
+	for (guint i = 1; split[0] != NULL && split[i] != NULL; i++)
+	{
+		if (g_str_has_prefix(split[i], "capacity="))
+		{
+			bd->capacity = g_ascii_strtoull(split[i] + strlen("capacity="), NULL, 10) * 1024 * 1024;
+		}
+		else if (g_str_has_prefix(split[i], "chunk-size="))
+		{
+			bd->chunk_size = g_ascii_strtoull(split[i] + strlen("chunk-size="), NULL, 10) * 1024;
+		}
+		else if (g_strcmp0(split[i], "hugepages") == 0)
+		{
+			bd->hugepages = TRUE;
+		}
+		else
+		{
+			g_slice_free(JMemoryData, bd);
+
+			return FALSE;
+		}
+	}
+
+	page_size = sysconf(_SC_PAGESIZE);
+	bd->alignment = (page_size > 0) ? (gsize)page_size : 4096;
+
+	if (bd->hugepages)
+	{
+		bd->alignment = J_MEMORY_HUGEPAGE_SIZE;
+	}
+
+	// Chunks have to consist of whole pages, aligned_alloc requires the size to be a multiple of the alignment
+	bd->chunk_size = MAX(bd->chunk_size, bd->alignment);
+	bd->chunk_size = (bd->chunk_size + bd->alignment - 1) / bd->alignment * bd->alignment;
+
+	g_rw_lock_init(bd->lock);
+	bd->namespaces = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_hash_table_unref);
+	g_mutex_init(bd->allocated_mutex);
+
+	*backend_data = bd;
+
+	return TRUE;
+}
+
+static void
+backend_fini(gpointer backend_data)
+{
+	JMemoryData* bd = backend_data;
+
+	g_hash_table_unref(bd->namespaces);
+	g_rw_lock_clear(bd->lock);
+	g_mutex_clear(bd->allocated_mutex);
+	g_slice_free(JMemoryData, bd);
+}
+
+static JBackend memory_backend = {
+	.type = J_BACKEND_TYPE_OBJECT,
+	.component = J_BACKEND_COMPONENT_CLIENT | J_BACKEND_COMPONENT_SERVER,
+	.object = {
+		.backend_init = backend_init,
+		.backend_fini = backend_fini,
+		.backend_create = backend_create,
+		.backend_delete = backend_delete,
+		.backend_open = backend_open,
+		.backend_close = backend_close,
+		.backend_status = backend_status,
+		.backend_sync = backend_sync,
+		.backend_read = backend_read,
+		.backend_write = backend_write,
+		.backend_readv = backend_readv,
+		.backend_writev = backend_writev,
+		.backend_discard = backend_discard,
+		.backend_preallocate = backend_preallocate,
+		.backend_clone = backend_clone,
+		.backend_get_all = backend_get_all,
+		.backend_get_by_prefix = backend_get_by_prefix,
+		.backend_iterate = backend_iterate }
+};
+
+G_MODULE_EXPORT
+JBackend*
+backend_info(void)
+{
+	return &memory_backend;
+}
@@ -26,13 +26,13 @@
 static gboolean
 backend_create(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
 {
+	JBackendLatency* latency = backend_data;
 	gchar* full_path;
 
-	(void)backend_data;
-
 	full_path = g_build_filename(namespace, path, NULL);
 
 	j_trace_file_begin(full_path, J_TRACE_FILE_CREATE);
+	j_backend_latency_inject(latency, J_BACKEND_LATENCY_METADATA, 0);
 	j_trace_file_end(full_path, J_TRACE_FILE_CREATE, 0, 0);
 
 	*backend_object = full_path;
@@ -43,13 +43,13 @@ backend_create(gpointer backend_data, gchar const* namespace, gchar const* path,
 static gboolean
 backend_open(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
 {
+	JBackendLatency* latency = backend_data;
 	gchar* full_path;
 
-	(void)backend_data;
-
 	full_path = g_build_filename(namespace, path, NULL);
 
 	j_trace_file_begin(full_path, J_TRACE_FILE_OPEN);
+	j_backend_latency_inject(latency, J_BACKEND_LATENCY_METADATA, 0);
 	j_trace_file_end(full_path, J_TRACE_FILE_OPEN, 0, 0);
 
 	*backend_object = full_path;
@@ -60,11 +60,11 @@ backend_open(gpointer backend_data, gchar const* namespace, gchar const* path, g
 static gboolean
 backend_delete(gpointer backend_data, gpointer backend_object)
 {
+	JBackendLatency* latency = backend_data;
 	gchar* full_path = backend_object;
 
-	(void)backend_data;
-
 	j_trace_file_begin(full_path, J_TRACE_FILE_DELETE);
+	j_backend_latency_inject(latency, J_BACKEND_LATENCY_METADATA, 0);
 	j_trace_file_end(full_path, J_TRACE_FILE_DELETE, 0, 0);
 
 	g_free(full_path);
@@ -90,11 +90,11 @@ backend_close(gpointer backend_data, gpointer backend_object)
 static gboolean
 backend_status(gpointer backend_data, gpointer backend_object, gint64* modification_time, guint64* size)
 {
+	JBackendLatency* latency = backend_data;
 	gchar const* full_path = backend_object;
 
-	(void)backend_data;
-
 	j_trace_file_begin(full_path, J_TRACE_FILE_STATUS);
+	j_backend_latency_inject(latency, J_BACKEND_LATENCY_METADATA, 0);
 	j_trace_file_end(full_path, J_TRACE_FILE_STATUS, 0, 0);
 
 	if (modification_time != NULL)
@@ -113,11 +113,11 @@ backend_status(gpointer backend_data, gpointer backend_object, gint64* modificat
 static gboolean
 backend_sync(gpointer backend_data, gpointer backend_object)
 {
+	JBackendLatency* latency = backend_data;
 	gchar const* full_path = backend_object;
 
-	(void)backend_data;
-
 	j_trace_file_begin(full_path, J_TRACE_FILE_SYNC);
+	j_backend_latency_inject(latency, J_BACKEND_LATENCY_SYNC, 0);
 	j_trace_file_end(full_path, J_TRACE_FILE_SYNC, 0, 0);
 
 	return TRUE;
@@ -126,12 +126,13 @@ backend_sync(gpointer backend_data, gpointer backend_object)
 static gboolean
 backend_read(gpointer backend_data, gpointer backend_object, gpointer buffer, guint64 length, guint64 offset, guint64* bytes_read)
 {
+	JBackendLatency* latency = backend_data;
 	gchar const* full_path = backend_object;
 
-	(void)backend_data;
 	(void)buffer;
 
 	j_trace_file_begin(full_path, J_TRACE_FILE_READ);
+	j_backend_latency_inject(latency, J_BACKEND_LATENCY_READ, length);
 	j_trace_file_end(full_path, J_TRACE_FILE_READ, length, offset);
 
 	if (bytes_read != NULL)
@@ -145,12 +146,13 @@ backend_read(gpointer backend_data, gpointer backend_object, gpointer buffer, gu
 static gboolean
 backend_write(gpointer backend_data, gpointer backend_object, gconstpointer buffer, guint64 length, guint64 offset, guint64* bytes_written)
 {
+	JBackendLatency* latency = backend_data;
 	gchar const* full_path = backend_object;
 
-	(void)backend_data;
 	(void)buffer;
 
 	j_trace_file_begin(full_path, J_TRACE_FILE_WRITE);
+	j_backend_latency_inject(latency, J_BACKEND_LATENCY_WRITE, length);
 	j_trace_file_end(full_path, J_TRACE_FILE_WRITE, length, offset);
 
 	if (bytes_written != NULL)
@@ -164,11 +166,13 @@ backend_write(gpointer backend_data, gpointer backend_object, gconstpointer buff
 static gboolean
 backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend_iterator)
 {
-	(void)backend_data;
+	JBackendLatency* latency = backend_data;
 
 	g_return_val_if_fail(namespace != NULL, FALSE);
 	g_return_val_if_fail(backend_iterator != NULL, FALSE);
 
+	j_backend_latency_inject(latency, J_BACKEND_LATENCY_METADATA, 0);
+
 	*backend_iterator = NULL;
 
 	return TRUE;
@@ -177,12 +181,15 @@ backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend
 static gboolean
 backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const* prefix, gpointer* backend_iterator)
 {
-	(void)backend_data;
+	JBackendLatency* latency = backend_data;
+
 	(void)prefix;
 
 	g_return_val_if_fail(namespace != NULL, FALSE);
 	g_return_val_if_fail(backend_iterator != NULL, FALSE);
 
+	j_backend_latency_inject(latency, J_BACKEND_LATENCY_METADATA, 0);
+
 	*backend_iterator = NULL;
 
 	return TRUE;
@@ -202,8 +209,16 @@ backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const**
 static gboolean
 backend_init(gchar const* path, gpointer* backend_data)
 {
-	(void)backend_data;
-	(void)path;
+	JBackendLatency* latency;
+
+	// The path can be suffixed with a latency model (:read=100:write=~200:bandwidth=2048)
+	if ((latency = j_backend_latency_new(path)) == NULL)
+	{
+		g_warning("Invalid latency model %s.", path);
+		return FALSE;
+	}
+
+	*backend_data = latency;
 
 	return TRUE;
 }
@@ -211,7 +226,9 @@ backend_init(gchar const* path, gpointer* backend_data)
 static void
 backend_fini(gpointer backend_data)
 {
-	(void)backend_data;
+	JBackendLatency* latency = backend_data;
+
+	j_backend_latency_free(latency);
 }
 
 static JBackend null_backend = {
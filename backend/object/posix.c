@@ -16,22 +16,110 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+// Required for O_DIRECT
+#define _GNU_SOURCE
+
 #include <julea-config.h>
 
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <gmodule.h>
 
+#include <errno.h>
 #include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+#ifdef HAVE_FICLONE
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
 #include <julea.h>
 
+/**
+ * The alignment required for direct I/O.
+ **/
+#define JD_BACKEND_DIRECT_ALIGNMENT 4096
+
+/**
+ * The maximum size of bounce buffers used for unaligned direct I/O.
+ **/
+#define JD_BACKEND_DIRECT_BOUNCE_SIZE (4 * 1024 * 1024)
+
+/**
+ * The maximum number of adjacent extents merged into a single preadv or pwritev call.
+ **/
+#define JD_BACKEND_IOV_MAX 64
+
+/**
+ * The number of milliseconds between two rounds of the background flusher.
+ **/
+#define JD_BACKEND_FLUSH_INTERVAL 100
+
+/**
+ * The name of the per-namespace index file used with directory fan-out.
+ **/
+#define JD_BACKEND_INDEX_NAME ".index"
+
+/**
+ * The number of stale records after which an index file is compacted.
+ **/
+#define JD_BACKEND_INDEX_COMPACT_THRESHOLD 4096
+
+/**
+ * The sorted names of a namespace's objects, used with directory fan-out.
+ * Object creations and deletions are appended to an index file,
+ * so listing a namespace does not have to walk its directories.
+ **/
+struct JBackendIndex
+{
+	GMutex mutex[1];
+
+	gchar* path;
+	gint fd;
+
+	/**
+	 * The names in sorted order.
+	 **/
+	GSequence* names;
+
+	/**
+	 * Maps names to their position in names.
+	 **/
+	GHashTable* lookup;
+
+	/**
+	 * The number of records in the index file.
+	 **/
+	guint64 records;
+};
+
+typedef struct JBackendIndex JBackendIndex;
+
 struct JBackendData
 {
 	gchar* path;
+	gboolean direct;
+
+	/**
+	 * Whether objects are spread over two levels of 256 directories per namespace.
+	 **/
+	gboolean fanout;
+
+	GMutex indexes_mutex[1];
+
+	// namespace(gchar*) -> JBackendIndex*
+	GHashTable* indexes;
 	// FIXME check whether hash tables can stay global
 };
 
@@ -39,8 +127,22 @@ typedef struct JBackendData JBackendData;
 
 struct JBackendIterator
 {
+	JBackendData* bd;
 	JDirIterator* iterator;
 	gchar* prefix;
+
+	/**
+	 * The namespace's directory, -1 if it has not been opened yet.
+	 * Objects are queried relative to it, so that listing with status does not have to resolve full paths.
+	 **/
+	gint fd;
+	gchar* namespace;
+
+	/**
+	 * A snapshot of the index's names, NULL when iterating over a directory.
+	 **/
+	GPtrArray* names;
+	guint index;
 };
 
 typedef struct JBackendIterator JBackendIterator;
@@ -49,6 +151,40 @@ struct JBackendObject
 {
 	gchar* path;
 	gint fd;
+
+	/**
+	 * The object's namespace and name, used to update the index.
+	 **/
+	gchar* namespace;
+	gchar* name;
+
+	/**
+	 * A second descriptor opened with O_DIRECT, -1 if direct I/O is disabled.
+	 **/
+	gint direct_fd;
+
+	/**
+	 * Whether the object has been deleted and must not be cached anymore.
+	 **/
+	gboolean deleted;
+
+	/**
+	 * The object's link in its shard's idle queue, NULL while the object is in use.
+	 **/
+	GList* idle_link;
+
+	/**
+	 * The range that has been written but not written back yet.
+	 * Protected by the flusher's mutex.
+	 **/
+	guint64 dirty_start;
+	guint64 dirty_end;
+
+	/**
+	 * The object's link in the flusher's queue, NULL if it is not queued.
+	 **/
+	GList* dirty_link;
+
 	guint ref_count;
 };
 
@@ -56,352 +192,1779 @@ typedef struct JBackendObject JBackendObject;
 
 static guint jd_num_backends = 0;
 
-static GHashTable* jd_backend_file_cache = NULL;
+/**
+ * The number of shards the global file cache is split into.
+ **/
+#define JD_BACKEND_FILE_CACHE_SHARDS 64
+
+/**
+ * A shard of the global file cache.
+ * Objects that are not used anymore are kept open in the idle queue,
+ * which is bounded to avoid running out of file descriptors.
+ **/
+struct JBackendFileCacheShard
+{
+	GMutex mutex[1];
+	GHashTable* files;
+	GQueue idle[1];
+};
+
+typedef struct JBackendFileCacheShard JBackendFileCacheShard;
+
+static JBackendFileCacheShard jd_backend_file_cache[JD_BACKEND_FILE_CACHE_SHARDS];
+
+/**
+ * The maximum number of idle objects per shard.
+ **/
+static guint jd_backend_file_cache_idle_max = 0;
+
+/**
+ * Writes dirty data back in the background at a limited rate.
+ * This keeps data written without syncing from piling up in the page cache,
+ * which would otherwise be written back in large bursts and make later syncs slow.
+ **/
+static struct
+{
+	GThread* thread;
+
+	GMutex mutex[1];
+	GCond cond[1];
+	gboolean stop;
+
+	/**
+	 * Contains JBackendObject elements with dirty ranges, each holding a reference.
+	 **/
+	GQueue queue[1];
+
+	/**
+	 * The number of bytes written back per second, 0 if the flusher is disabled.
+	 **/
+	guint64 rate;
+} jd_backend_flusher;
+
+static JBackendFileCacheShard*
+jd_backend_file_cache_get_shard(gchar const* path)
+{
+	return &(jd_backend_file_cache[g_str_hash(path) % JD_BACKEND_FILE_CACHE_SHARDS]);
+}
+
+#ifdef HAVE_LIBURING
+/**
+ * The number of submission queue entries per ring.
+ **/
+#define JD_BACKEND_URING_ENTRIES 64
+
+/**
+ * I/O larger than this is split into multiple requests submitted at once.
+ **/
+#define JD_BACKEND_URING_CHUNK_SIZE (1024 * 1024)
 
-G_LOCK_DEFINE_STATIC(jd_backend_file_cache);
+static gboolean jd_backend_uring_unavailable = FALSE;
 
 static void
-jd_backend_files_free(gpointer data)
+jd_backend_uring_free(gpointer data)
+{
+	struct io_uring* ring = data;
+
+	io_uring_queue_exit(ring);
+	g_slice_free(struct io_uring, ring);
+}
+
+static GPrivate jd_backend_uring = G_PRIVATE_INIT(jd_backend_uring_free);
+
+static struct io_uring*
+jd_backend_uring_get_thread(void)
+{
+	struct io_uring* ring;
+
+	ring = g_private_get(&jd_backend_uring);
+
+	if (G_UNLIKELY(ring == NULL) && !g_atomic_int_get(&jd_backend_uring_unavailable))
+	{
+		ring = g_slice_new(struct io_uring);
+
+		if (io_uring_queue_init(JD_BACKEND_URING_ENTRIES, ring, 0) < 0)
+		{
+			// The kernel does not support io_uring, fall back to pread/pwrite.
+			g_slice_free(struct io_uring, ring);
+			g_atomic_int_set(&jd_backend_uring_unavailable, TRUE);
+
+			return NULL;
+		}
+
+		g_private_replace(&jd_backend_uring, ring);
+	}
+
+	return ring;
+}
+
+/**
+ * Reads or writes a buffer by splitting it into chunks that are submitted as one batch.
+ *
+ * \return The number of bytes transferred without gaps, starting at the beginning of the buffer.
+ *         The remainder (if any) has to be handled by the caller.
+ **/
+static guint64
+jd_backend_uring_io(gint fd, gpointer buffer, guint64 length, guint64 offset, gboolean write)
 {
-	GHashTable* files = data;
+	struct io_uring* ring;
+	guint64 nbytes_total = 0;
+
+	if (length <= JD_BACKEND_URING_CHUNK_SIZE || (ring = jd_backend_uring_get_thread()) == NULL)
+	{
+		return 0;
+	}
+
+	while (nbytes_total < length)
+	{
+		gint results[JD_BACKEND_URING_ENTRIES];
+		guint64 submitted = 0;
+		guint count = 0;
+		gboolean complete = TRUE;
+
+		for (count = 0; count < JD_BACKEND_URING_ENTRIES && nbytes_total + submitted < length; count++)
+		{
+			struct io_uring_sqe* sqe;
+			guint64 chunk;
+
+			chunk = MIN(length - nbytes_total - submitted, JD_BACKEND_URING_CHUNK_SIZE);
+			sqe = io_uring_get_sqe(ring);
+
+			if (write)
+			{
+				io_uring_prep_write(sqe, fd, (gchar*)buffer + nbytes_total + submitted, chunk, offset + nbytes_total + submitted);
+			}
+			else
+			{
+				io_uring_prep_read(sqe, fd, (gchar*)buffer + nbytes_total + submitted, chunk, offset + nbytes_total + submitted);
+			}
+
+			io_uring_sqe_set_data(sqe, GUINT_TO_POINTER(count));
+			submitted += chunk;
+		}
+
+		if (io_uring_submit_and_wait(ring, count) < 0)
+		{
+			break;
+		}
+
+		for (guint i = 0; i < count; i++)
+		{
+			struct io_uring_cqe* cqe;
+
+			if (io_uring_wait_cqe(ring, &cqe) < 0)
+			{
+				// Should not happen since all completions have been waited for above.
+				g_assert_not_reached();
+			}
+
+			results[GPOINTER_TO_UINT(io_uring_cqe_get_data(cqe))] = cqe->res;
+			io_uring_cqe_seen(ring, cqe);
+		}
+
+		for (guint i = 0; i < count; i++)
+		{
+			guint64 chunk;
+
+			chunk = MIN(length - nbytes_total, JD_BACKEND_URING_CHUNK_SIZE);
+
+			if (results[i] < 0 || (guint64)results[i] < chunk)
+			{
+				if (results[i] > 0)
+				{
+					nbytes_total += results[i];
+				}
+
+				complete = FALSE;
+				break;
+			}
+
+			nbytes_total += chunk;
+		}
 
-	g_hash_table_destroy(files);
+		if (!complete)
+		{
+			break;
+		}
+	}
+
+	return nbytes_total;
 }
+#endif
+
+static void
+backend_file_free(JBackendObject* bo)
+{
+	j_trace_file_begin(bo->path, J_TRACE_FILE_CLOSE);
+	close(bo->fd);
+
+	if (bo->direct_fd != -1)
+	{
+		close(bo->direct_fd);
+	}
 
-// FIXME not deleted?
-static GPrivate jd_backend_files = G_PRIVATE_INIT(jd_backend_files_free);
+	j_trace_file_end(bo->path, J_TRACE_FILE_CLOSE, 0, 0);
+
+	g_free(bo->path);
+	g_free(bo->namespace);
+	g_free(bo->name);
+	g_slice_free(JBackendObject, bo);
+}
 
 static void
 backend_file_unref(gpointer data)
 {
 	JBackendObject* bo = data;
+	JBackendObject* evict = NULL;
+	JBackendFileCacheShard* shard;
 
 	g_return_if_fail(bo != NULL);
 
-	G_LOCK(jd_backend_file_cache);
+	shard = jd_backend_file_cache_get_shard(bo->path);
+
+	g_mutex_lock(shard->mutex);
 
 	if (g_atomic_int_dec_and_test(&(bo->ref_count)))
 	{
-		g_hash_table_remove(jd_backend_file_cache, bo->path);
+		if (bo->deleted)
+		{
+			// Deleted objects have already been removed from the cache.
+			evict = bo;
+		}
+		else
+		{
+			g_queue_push_head(shard->idle, bo);
+			bo->idle_link = shard->idle->head;
+
+			if (shard->idle->length > jd_backend_file_cache_idle_max)
+			{
+				evict = g_queue_pop_tail(shard->idle);
+				evict->idle_link = NULL;
+				g_hash_table_remove(shard->files, evict->path);
+			}
+		}
+	}
+
+	g_mutex_unlock(shard->mutex);
+
+	if (evict != NULL)
+	{
+		backend_file_free(evict);
+	}
+}
+
+/**
+ * Records a range that has been written, so that the flusher writes it back.
+ * Ranges of an object are merged, which might cover data that is clean already; writing back clean pages is cheap, though.
+ **/
+static void
+jd_backend_flusher_mark(JBackendObject* bo, guint64 length, guint64 offset)
+{
+	// Direct I/O does not leave dirty data in the page cache
+	if (jd_backend_flusher.rate == 0 || bo->direct_fd != -1 || length == 0)
+	{
+		return;
+	}
+
+	g_mutex_lock(jd_backend_flusher.mutex);
+
+	if (bo->dirty_link == NULL)
+	{
+		bo->dirty_start = offset;
+		bo->dirty_end = offset + length;
+
+		g_atomic_int_inc(&(bo->ref_count));
+		g_queue_push_tail(jd_backend_flusher.queue, bo);
+		bo->dirty_link = jd_backend_flusher.queue->tail;
+	}
+	else if (bo->dirty_start == bo->dirty_end)
+	{
+		bo->dirty_start = offset;
+		bo->dirty_end = offset + length;
+	}
+	else
+	{
+		bo->dirty_start = MIN(bo->dirty_start, offset);
+		bo->dirty_end = MAX(bo->dirty_end, offset + length);
+	}
 
-		j_trace_file_begin(bo->path, J_TRACE_FILE_CLOSE);
-		close(bo->fd);
-		j_trace_file_end(bo->path, J_TRACE_FILE_CLOSE, 0, 0);
+	g_mutex_unlock(jd_backend_flusher.mutex);
+}
 
-		g_free(bo->path);
-		g_slice_free(JBackendObject, bo);
+/**
+ * Forgets an object's dirty range after it has been synced.
+ * The flusher drops the object the next time it encounters it.
+ **/
+static void
+jd_backend_flusher_clear(JBackendObject* bo)
+{
+	if (jd_backend_flusher.rate == 0)
+	{
+		return;
 	}
 
-	G_UNLOCK(jd_backend_file_cache);
+	g_mutex_lock(jd_backend_flusher.mutex);
+	bo->dirty_start = bo->dirty_end;
+	g_mutex_unlock(jd_backend_flusher.mutex);
 }
 
-static GHashTable*
-jd_backend_files_get_thread(void)
+static gpointer
+jd_backend_flusher_thread(gpointer data)
 {
-	GHashTable* files;
+	guint64 const budget = MAX(1, jd_backend_flusher.rate * JD_BACKEND_FLUSH_INTERVAL / 1000);
 
-	files = g_private_get(&jd_backend_files);
+	(void)data;
 
-	if (G_UNLIKELY(files == NULL))
+	g_mutex_lock(jd_backend_flusher.mutex);
+
+	while (!jd_backend_flusher.stop)
 	{
-		files = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, backend_file_unref);
-		g_private_replace(&jd_backend_files, files);
+		gint64 end_time;
+		guint64 remaining = budget;
+
+		// Objects are written back round-robin, each up to the remaining budget
+		while (remaining > 0 && !g_queue_is_empty(jd_backend_flusher.queue))
+		{
+			JBackendObject* bo;
+			guint64 length;
+			guint64 offset;
+
+			bo = g_queue_pop_head(jd_backend_flusher.queue);
+			bo->dirty_link = NULL;
+
+			offset = bo->dirty_start;
+			length = MIN(bo->dirty_end - bo->dirty_start, remaining);
+
+			if (length == 0 || bo->deleted)
+			{
+				g_mutex_unlock(jd_backend_flusher.mutex);
+				backend_file_unref(bo);
+				g_mutex_lock(jd_backend_flusher.mutex);
+
+				continue;
+			}
+
+			bo->dirty_start += length;
+			remaining -= length;
+
+			// The object stays queued while it has dirty data, so it keeps its reference
+			g_queue_push_tail(jd_backend_flusher.queue, bo);
+			bo->dirty_link = jd_backend_flusher.queue->tail;
+
+			g_mutex_unlock(jd_backend_flusher.mutex);
+
+#ifdef HAVE_SYNC_FILE_RANGE
+			// Only starts the write-back, which neither waits for the device nor flushes its cache
+			sync_file_range(bo->fd, offset, length, SYNC_FILE_RANGE_WRITE);
+#else
+			(void)offset;
+#endif
+
+			g_mutex_lock(jd_backend_flusher.mutex);
+		}
+
+		end_time = g_get_monotonic_time() + JD_BACKEND_FLUSH_INTERVAL * G_TIME_SPAN_MILLISECOND;
+
+		while (!jd_backend_flusher.stop && g_cond_wait_until(jd_backend_flusher.cond, jd_backend_flusher.mutex, end_time))
+		{
+		}
 	}
 
-	return files;
+	g_mutex_unlock(jd_backend_flusher.mutex);
+
+	return NULL;
 }
 
-static JBackendObject*
-backend_file_get(GHashTable* files, gchar const* key)
+static void
+jd_backend_flusher_start(guint64 rate)
+{
+	g_mutex_init(jd_backend_flusher.mutex);
+	g_cond_init(jd_backend_flusher.cond);
+	g_queue_init(jd_backend_flusher.queue);
+
+	jd_backend_flusher.stop = FALSE;
+	jd_backend_flusher.rate = rate;
+	jd_backend_flusher.thread = g_thread_new("julea-posix-flush", jd_backend_flusher_thread, NULL);
+}
+
+static void
+jd_backend_flusher_stop(void)
 {
 	JBackendObject* bo;
 
-	if ((bo = g_hash_table_lookup(files, key)) != NULL)
+	if (jd_backend_flusher.thread == NULL)
 	{
-		goto end;
+		return;
+	}
+
+	g_mutex_lock(jd_backend_flusher.mutex);
+	jd_backend_flusher.stop = TRUE;
+	g_cond_signal(jd_backend_flusher.cond);
+	g_mutex_unlock(jd_backend_flusher.mutex);
+
+	g_thread_join(jd_backend_flusher.thread);
+	jd_backend_flusher.thread = NULL;
+
+	// The remaining data is written back by the kernel as usual
+	while ((bo = g_queue_pop_head(jd_backend_flusher.queue)) != NULL)
+	{
+		bo->dirty_link = NULL;
+		backend_file_unref(bo);
 	}
 
-	G_LOCK(jd_backend_file_cache);
+	jd_backend_flusher.rate = 0;
+
+	g_cond_clear(jd_backend_flusher.cond);
+	g_mutex_clear(jd_backend_flusher.mutex);
+}
+
+/**
+ * Looks up an object and takes a reference on it.
+ * Each reference is owned by the caller of backend_open() or backend_create() and released by backend_close() or backend_delete(),
+ * so objects can be kept open across messages and closed from a different thread.
+ **/
+static JBackendObject*
+backend_file_get(gchar const* key)
+{
+	JBackendObject* bo;
+	JBackendFileCacheShard* shard;
+
+	shard = jd_backend_file_cache_get_shard(key);
+
+	g_mutex_lock(shard->mutex);
 
-	if ((bo = g_hash_table_lookup(jd_backend_file_cache, key)) != NULL)
+	if ((bo = g_hash_table_lookup(shard->files, key)) != NULL)
 	{
+		if (bo->idle_link != NULL)
+		{
+			g_queue_delete_link(shard->idle, bo->idle_link);
+			bo->idle_link = NULL;
+		}
+
 		g_atomic_int_inc(&(bo->ref_count));
-		g_hash_table_insert(files, bo->path, bo);
-		G_UNLOCK(jd_backend_file_cache);
+		g_mutex_unlock(shard->mutex);
 	}
 
 	/* Attention: The caller must call backend_file_add() if NULL is returned! */
 
-end:
 	return bo;
 }
 
 static void
-backend_file_add(GHashTable* files, JBackendObject* object)
+backend_file_add(gchar const* key, JBackendObject* object)
 {
+	JBackendFileCacheShard* shard;
+
+	shard = jd_backend_file_cache_get_shard(key);
+
 	if (object != NULL)
 	{
-		g_hash_table_insert(jd_backend_file_cache, object->path, object);
-		g_hash_table_insert(files, object->path, object);
+		g_hash_table_insert(shard->files, object->path, object);
 	}
 
-	G_UNLOCK(jd_backend_file_cache);
+	g_mutex_unlock(shard->mutex);
 }
 
-static gboolean
-backend_create(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
+/**
+ * Returns an object's path relative to its namespace's directory.
+ * With directory fan-out, objects are placed in one of 65,536 directories chosen by the hash of their name.
+ *
+ * \private
+ *
+ * \param bd   The backend data.
+ * \param path The object's name.
+ *
+ * \return The path, to be freed with g_free().
+ **/
+static gchar*
+backend_get_relative_path(JBackendData* bd, gchar const* path)
 {
-	JBackendData* bd = backend_data;
-	GHashTable* files = jd_backend_files_get_thread();
-
-	JBackendObject* bo = NULL;
-	g_autofree gchar* parent = NULL;
-	gchar* full_path;
-	gint fd;
+	gchar level1[3];
+	gchar level2[3];
+	guint32 hash = 2166136261u;
 
-	full_path = g_build_filename(bd->path, namespace, path, NULL);
+	if (!bd->fanout)
+	{
+		return g_strdup(path);
+	}
 
-	if ((bo = backend_file_get(files, full_path)) != NULL)
+	// FNV-1a, since the placement has to stay stable across GLib versions
+	for (gchar const* c = path; *c != '\0'; c++)
 	{
-		g_free(full_path);
+		hash ^= (guchar)*c;
+		hash *= 16777619u;
+	}
 
-		// FIXME
-		fd = bo->fd;
+	g_snprintf(level1, sizeof(level1), "%02x", hash & 0xff);
+	g_snprintf(level2, sizeof(level2), "%02x", (hash >> 8) & 0xff);
 
-		goto end;
+	return g_build_filename(level1, level2, path, NULL);
+}
+
+/**
+ * Returns an object's path.
+ *
+ * \private
+ *
+ * \param bd        The backend data.
+ * \param namespace The namespace.
+ * \param path      The object's name.
+ *
+ * \return The path, to be freed with g_free().
+ **/
+static gchar*
+backend_get_path(JBackendData* bd, gchar const* namespace, gchar const* path)
+{
+	g_autofree gchar* relative_path = NULL;
+
+	relative_path = backend_get_relative_path(bd, path);
+
+	return g_build_filename(bd->path, namespace, relative_path, NULL);
+}
+
+static gint
+backend_index_compare(gconstpointer a, gconstpointer b, gpointer data)
+{
+	(void)data;
+
+	return strcmp(a, b);
+}
+
+static void
+backend_index_insert(JBackendIndex* index, gchar const* name)
+{
+	GSequenceIter* it;
+	gchar* name_;
+
+	if (g_hash_table_contains(index->lookup, name))
+	{
+		return;
 	}
 
-	j_trace_file_begin(full_path, J_TRACE_FILE_CREATE);
+	name_ = g_strdup(name);
+	it = g_sequence_insert_sorted(index->names, name_, backend_index_compare, NULL);
+	g_hash_table_insert(index->lookup, name_, it);
+}
 
-	parent = g_path_get_dirname(full_path);
-	g_mkdir_with_parents(parent, 0700);
+static void
+backend_index_remove(JBackendIndex* index, gchar const* name)
+{
+	GSequenceIter* it;
 
-	fd = open(full_path, O_RDWR | O_CREAT, 0600);
+	if ((it = g_hash_table_lookup(index->lookup, name)) != NULL)
+	{
+		g_hash_table_remove(index->lookup, name);
+		g_sequence_remove(it);
+	}
+}
 
-	j_trace_file_end(full_path, J_TRACE_FILE_CREATE, 0, 0);
+/**
+ * Appends a record to an index file.
+ * Records consist of an operation (+ or -) followed by the null-terminated name.
+ * Has to be called with the index's mutex held.
+ *
+ * \private
+ **/
+static void
+backend_index_append(JBackendIndex* index, gchar op, gchar const* name)
+{
+	g_autofree gchar* record = NULL;
+	gsize length;
 
-	if (fd == -1)
+	length = strlen(name) + 2;
+	record = g_malloc(length);
+	record[0] = op;
+	memcpy(record + 1, name, length - 1);
+
+	if (write(index->fd, record, length) != (gssize)length)
 	{
-		backend_file_add(files, NULL);
-		goto end;
+		g_warning("Could not update index %s.", index->path);
 	}
 
-	bo = g_slice_new(JBackendObject);
-	bo->path = full_path;
-	bo->fd = fd;
-	bo->ref_count = 1;
+	index->records++;
+}
+
+/**
+ * Rewrites an index file to only contain the current names.
+ * Has to be called with the index's mutex held.
+ *
+ * \private
+ **/
+static void
+backend_index_compact(JBackendIndex* index)
+{
+	g_autofree gchar* tmp_path = NULL;
+	GSequenceIter* it;
+	gint fd;
 
-	backend_file_add(files, bo);
+	tmp_path = g_strconcat(index->path, ".tmp", NULL);
 
-end:
-	*backend_object = bo;
+	if ((fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0600)) == -1)
+	{
+		return;
+	}
+
+	close(index->fd);
+	index->fd = fd;
+	index->records = 0;
+
+	for (it = g_sequence_get_begin_iter(index->names); !g_sequence_iter_is_end(it); it = g_sequence_iter_next(it))
+	{
+		backend_index_append(index, '+', g_sequence_get(it));
+	}
+
+	fsync(index->fd);
+
+	if (g_rename(tmp_path, index->path) != 0)
+	{
+		g_warning("Could not compact index %s.", index->path);
+	}
+
+	close(index->fd);
+	index->fd = open(index->path, O_WRONLY | O_APPEND | O_CREAT, 0600);
+}
+
+/**
+ * Reads an index file.
+ * If it does not exist, it is rebuilt from the namespace's directories, so deleting it forces a rebuild.
+ *
+ * \private
+ **/
+static void
+backend_index_load(JBackendData* bd, JBackendIndex* index, gchar const* namespace)
+{
+	g_autofree gchar* contents = NULL;
+	gsize length;
+
+	if (g_file_get_contents(index->path, &contents, &length, NULL))
+	{
+		gsize position = 0;
+
+		while (position < length)
+		{
+			gchar const* name = contents + position + 1;
+			gsize name_length;
+
+			name_length = strnlen(name, length - position - 1);
+
+			// Ignore a truncated last record
+			if (position + 1 + name_length >= length)
+			{
+				break;
+			}
+
+			if (contents[position] == '+')
+			{
+				backend_index_insert(index, name);
+			}
+			else
+			{
+				backend_index_remove(index, name);
+			}
+
+			index->records++;
+			position += name_length + 2;
+		}
+	}
+	else
+	{
+		g_autofree gchar* namespace_path = NULL;
+		JDirIterator* it;
+
+		namespace_path = g_build_filename(bd->path, namespace, NULL);
+
+		if ((it = j_dir_iterator_new(namespace_path)) != NULL)
+		{
+			while (j_dir_iterator_next(it))
+			{
+				gchar const* name = j_dir_iterator_get(it);
+
+				// Only consider paths of the form xx/yy/name
+				if (strlen(name) > 6 && name[2] == '/' && name[5] == '/')
+				{
+					backend_index_insert(index, name + 6);
+				}
+			}
+
+			j_dir_iterator_free(it);
+		}
+
+		g_mkdir_with_parents(namespace_path, 0700);
+	}
+
+	index->fd = open(index->path, O_WRONLY | O_APPEND | O_CREAT, 0600);
+
+	if (index->records != g_sequence_get_length(index->names))
+	{
+		backend_index_compact(index);
+	}
+}
+
+/**
+ * Returns a namespace's index and locks it, loading it on first use.
+ *
+ * \private
+ **/
+static JBackendIndex*
+backend_index_get(JBackendData* bd, gchar const* namespace)
+{
+	JBackendIndex* index;
+
+	g_mutex_lock(bd->indexes_mutex);
+
+	if ((index = g_hash_table_lookup(bd->indexes, namespace)) == NULL)
+	{
+		index = g_slice_new(JBackendIndex);
+		g_mutex_init(index->mutex);
+		index->path = g_build_filename(bd->path, namespace, JD_BACKEND_INDEX_NAME, NULL);
+		index->fd = -1;
+		index->names = g_sequence_new(g_free);
+		index->lookup = g_hash_table_new(g_str_hash, g_str_equal);
+		index->records = 0;
+
+		backend_index_load(bd, index, namespace);
+
+		g_hash_table_insert(bd->indexes, g_strdup(namespace), index);
+	}
+
+	g_mutex_lock(index->mutex);
+	g_mutex_unlock(bd->indexes_mutex);
+
+	return index;
+}
+
+static void
+backend_index_free(gpointer data)
+{
+	JBackendIndex* index = data;
+
+	if (index->fd != -1)
+	{
+		close(index->fd);
+	}
+
+	g_hash_table_unref(index->lookup);
+	g_sequence_free(index->names);
+	g_free(index->path);
+	g_mutex_clear(index->mutex);
+	g_slice_free(JBackendIndex, index);
+}
+
+/**
+ * Records the creation or deletion of an object in its namespace's index.
+ *
+ * \private
+ **/
+static void
+backend_index_update(JBackendData* bd, gchar const* namespace, gchar const* name, gboolean created)
+{
+	JBackendIndex* index;
+
+	index = backend_index_get(bd, namespace);
+
+	if (created)
+	{
+		backend_index_insert(index, name);
+	}
+	else
+	{
+		backend_index_remove(index, name);
+	}
+
+	backend_index_append(index, (created) ? '+' : '-', name);
+
+	if (index->records > 2 * (guint64)g_sequence_get_length(index->names) + JD_BACKEND_INDEX_COMPACT_THRESHOLD)
+	{
+		backend_index_compact(index);
+	}
+
+	g_mutex_unlock(index->mutex);
+}
+
+static gboolean
+backend_create(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
+{
+	JBackendData* bd = backend_data;
+
+	JBackendObject* bo = NULL;
+	g_autofree gchar* parent = NULL;
+	gchar* full_path;
+	gint fd;
+
+	full_path = backend_get_path(bd, namespace, path);
+
+	if ((bo = backend_file_get(full_path)) != NULL)
+	{
+		g_free(full_path);
+
+		// FIXME
+		fd = bo->fd;
+
+		goto end;
+	}
+
+	j_trace_file_begin(full_path, J_TRACE_FILE_CREATE);
+
+	parent = g_path_get_dirname(full_path);
+	g_mkdir_with_parents(parent, 0700);
+
+	if (bd->fanout)
+	{
+		// Only new objects have to be added to the index
+		if ((fd = open(full_path, O_RDWR | O_CREAT | O_EXCL, 0600)) != -1)
+		{
+			backend_index_update(bd, namespace, path, TRUE);
+		}
+		else if (errno == EEXIST)
+		{
+			fd = open(full_path, O_RDWR);
+		}
+	}
+	else
+	{
+		fd = open(full_path, O_RDWR | O_CREAT, 0600);
+	}
+
+	j_trace_file_end(full_path, J_TRACE_FILE_CREATE, 0, 0);
+
+	if (fd == -1)
+	{
+		backend_file_add(full_path, NULL);
+		goto end;
+	}
+
+	bo = g_slice_new(JBackendObject);
+	bo->path = full_path;
+	bo->fd = fd;
+	bo->namespace = g_strdup(namespace);
+	bo->name = g_strdup(path);
+	bo->direct_fd = (bd->direct) ? open(full_path, O_RDWR | O_DIRECT) : -1;
+	bo->deleted = FALSE;
+	bo->idle_link = NULL;
+	bo->dirty_start = 0;
+	bo->dirty_end = 0;
+	bo->dirty_link = NULL;
+	bo->ref_count = 1;
+
+	backend_file_add(full_path, bo);
+
+end:
+	*backend_object = bo;
+
+	return (fd != -1);
+}
+
+static gboolean
+backend_open(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
+{
+	JBackendData* bd = backend_data;
+
+	JBackendObject* bo = NULL;
+	gchar* full_path;
+	gint fd;
+
+	full_path = backend_get_path(bd, namespace, path);
+
+	if ((bo = backend_file_get(full_path)) != NULL)
+	{
+		g_free(full_path);
+
+		// FIXME
+		fd = bo->fd;
+
+		goto end;
+	}
+
+	j_trace_file_begin(full_path, J_TRACE_FILE_OPEN);
+	fd = open(full_path, O_RDWR);
+	j_trace_file_end(full_path, J_TRACE_FILE_OPEN, 0, 0);
+
+	if (fd == -1)
+	{
+		backend_file_add(full_path, NULL);
+		goto end;
+	}
+
+	bo = g_slice_new(JBackendObject);
+	bo->path = full_path;
+	bo->fd = fd;
+	bo->namespace = g_strdup(namespace);
+	bo->name = g_strdup(path);
+	bo->direct_fd = (bd->direct) ? open(full_path, O_RDWR | O_DIRECT) : -1;
+	bo->deleted = FALSE;
+	bo->idle_link = NULL;
+	bo->dirty_start = 0;
+	bo->dirty_end = 0;
+	bo->dirty_link = NULL;
+	bo->ref_count = 1;
+
+	backend_file_add(full_path, bo);
+
+end:
+	*backend_object = bo;
+
+	return (fd != -1);
+}
+
+static gboolean
+backend_delete(gpointer backend_data, gpointer backend_object)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo = backend_object;
+	JBackendFileCacheShard* shard;
+	gboolean ret;
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_DELETE);
+	ret = (g_unlink(bo->path) == 0);
+	j_trace_file_end(bo->path, J_TRACE_FILE_DELETE, 0, 0);
+
+	if (ret && bd->fanout)
+	{
+		backend_index_update(bd, bo->namespace, bo->name, FALSE);
+	}
+
+	// Make sure the descriptor is not reused for a new object with the same name.
+	shard = jd_backend_file_cache_get_shard(bo->path);
+
+	g_mutex_lock(shard->mutex);
+
+	if (!bo->deleted && g_hash_table_lookup(shard->files, bo->path) == bo)
+	{
+		g_hash_table_remove(shard->files, bo->path);
+	}
+
+	bo->deleted = TRUE;
+
+	g_mutex_unlock(shard->mutex);
+
+	backend_file_unref(bo);
+
+	return ret;
+}
+
+static gboolean
+backend_close(gpointer backend_data, gpointer backend_object)
+{
+	JBackendObject* bo = backend_object;
+
+	(void)backend_data;
+
+	backend_file_unref(bo);
+
+	return TRUE;
+}
+
+/**
+ * Returns the modification time and size contained in a stat buffer.
+ *
+ * \private
+ *
+ * \param buf               A stat buffer.
+ * \param modification_time Returns the modification time, can be NULL.
+ * \param size              Returns the size, can be NULL.
+ **/
+static void
+backend_status_from_stat(struct stat const* buf, gint64* modification_time, guint64* size)
+{
+	if (modification_time != NULL)
+	{
+		*modification_time = buf->st_mtime * G_USEC_PER_SEC;
+
+#ifdef HAVE_STMTIM_TVNSEC
+		*modification_time += buf->st_mtim.tv_nsec / 1000;
+#endif
+	}
+
+	if (size != NULL)
+	{
+		*size = buf->st_size;
+	}
+}
+
+static gboolean
+backend_status(gpointer backend_data, gpointer backend_object, gint64* modification_time, guint64* size)
+{
+	JBackendObject* bo = backend_object;
+	gboolean ret = TRUE;
+	struct stat buf;
+
+	(void)backend_data;
+
+	if (modification_time != NULL || size != NULL)
+	{
+		j_trace_file_begin(bo->path, J_TRACE_FILE_STATUS);
+		ret = (fstat(bo->fd, &buf) == 0);
+		j_trace_file_end(bo->path, J_TRACE_FILE_STATUS, 0, 0);
+
+		if (ret)
+		{
+			backend_status_from_stat(&buf, modification_time, size);
+		}
+	}
+
+	return ret;
+}
+
+static gboolean
+backend_sync(gpointer backend_data, gpointer backend_object)
+{
+	JBackendObject* bo = backend_object;
+	gboolean ret;
+
+	(void)backend_data;
+
+	// Data written back by the flusher only has to be waited for
+	jd_backend_flusher_clear(bo);
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_SYNC);
+	ret = (fsync(bo->fd) == 0);
+	j_trace_file_end(bo->path, J_TRACE_FILE_SYNC, 0, 0);
+
+	return ret;
+}
+
+/**
+ * Syncs multiple objects.
+ * Objects are grouped by device and each group is synced with a single syncfs call,
+ * which is considerably cheaper than calling fsync for each object.
+ **/
+static gboolean
+backend_syncv(gpointer backend_data, gpointer* backend_objects, guint32 count)
+{
+	g_autoptr(GHashTable) devices = NULL;
+	GHashTableIter iter;
+	gpointer value;
+	gboolean ret = TRUE;
+
+	if (count == 1)
+	{
+		return backend_sync(backend_data, backend_objects[0]);
+	}
+
+	// Maps device numbers to one object residing on that device
+	devices = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, NULL);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		JBackendObject* bo = backend_objects[i];
+		struct stat buf;
+		gint64* device;
+
+		jd_backend_flusher_clear(bo);
+
+		if (fstat(bo->fd, &buf) != 0)
+		{
+			ret = backend_sync(backend_data, bo) && ret;
+			continue;
+		}
+
+		device = g_new(gint64, 1);
+		*device = buf.st_dev;
+
+		if (!g_hash_table_contains(devices, device))
+		{
+			g_hash_table_insert(devices, device, bo);
+		}
+		else
+		{
+			g_free(device);
+		}
+	}
+
+	g_hash_table_iter_init(&iter, devices);
+
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+	{
+		JBackendObject* bo = value;
+
+		j_trace_file_begin(bo->path, J_TRACE_FILE_SYNC);
+		ret = (syncfs(bo->fd) == 0) && ret;
+		j_trace_file_end(bo->path, J_TRACE_FILE_SYNC, 0, 0);
+	}
+
+	return ret;
+}
+
+static guint64
+jd_backend_read_all(gint fd, gpointer buffer, guint64 length, guint64 offset)
+{
+	gsize nbytes_total = 0;
+
+#ifdef HAVE_LIBURING
+	nbytes_total = jd_backend_uring_io(fd, buffer, length, offset, FALSE);
+#endif
+
+	while (nbytes_total < length)
+	{
+		gssize nbytes;
+
+		nbytes = pread(fd, (gchar*)buffer + nbytes_total, length - nbytes_total, offset + nbytes_total);
+
+		if (nbytes == 0)
+		{
+			break;
+		}
+		else if (nbytes < 0)
+		{
+			if (errno != EINTR)
+			{
+				break;
+			}
+		}
+
+		nbytes_total += nbytes;
+	}
+
+	return nbytes_total;
+}
+
+static guint64
+jd_backend_write_all(gint fd, gconstpointer buffer, guint64 length, guint64 offset)
+{
+	gsize nbytes_total = 0;
+
+#ifdef HAVE_LIBURING
+	nbytes_total = jd_backend_uring_io(fd, (gpointer)buffer, length, offset, TRUE);
+#endif
+
+	while (nbytes_total < length)
+	{
+		gssize nbytes;
+
+		nbytes = pwrite(fd, (gchar const*)buffer + nbytes_total, length - nbytes_total, offset + nbytes_total);
+
+		if (nbytes <= 0)
+		{
+			if (errno != EINTR)
+			{
+				break;
+			}
+		}
+
+		nbytes_total += nbytes;
+	}
+
+	return nbytes_total;
+}
+
+/**
+ * Performs I/O using O_DIRECT for the aligned part of the range.
+ * Unaligned heads and tails use buffered I/O, unaligned buffers are copied via a bounce buffer.
+ **/
+static guint64
+jd_backend_direct_io(JBackendObject* bo, gpointer buffer, guint64 length, guint64 offset, gboolean write)
+{
+	gchar* data = buffer;
+	gpointer bounce = NULL;
+	gboolean aligned;
+	guint64 nbytes_total = 0;
+	guint64 nbytes;
+	guint64 head;
+	guint64 body;
+	guint64 tail;
+
+	head = (JD_BACKEND_DIRECT_ALIGNMENT - (offset % JD_BACKEND_DIRECT_ALIGNMENT)) % JD_BACKEND_DIRECT_ALIGNMENT;
+	head = MIN(head, length);
+	body = (length - head) - ((length - head) % JD_BACKEND_DIRECT_ALIGNMENT);
+	tail = length - head - body;
+
+	if (head > 0)
+	{
+		nbytes = (write) ? jd_backend_write_all(bo->fd, data, head, offset) : jd_backend_read_all(bo->fd, data, head, offset);
+		nbytes_total += nbytes;
+
+		if (nbytes < head)
+		{
+			goto end;
+		}
+	}
+
+	aligned = ((guintptr)(data + head) % JD_BACKEND_DIRECT_ALIGNMENT == 0);
+
+	if (!aligned && body > 0)
+	{
+		bounce = j_helper_alloc_aligned(JD_BACKEND_DIRECT_ALIGNMENT, MIN(body, JD_BACKEND_DIRECT_BOUNCE_SIZE));
+	}
+
+	for (guint64 position = 0; position < body; position += JD_BACKEND_DIRECT_BOUNCE_SIZE)
+	{
+		gchar* chunk_data = data + head + position;
+		guint64 chunk_offset = offset + head + position;
+		guint64 chunk;
+
+		chunk = MIN(body - position, JD_BACKEND_DIRECT_BOUNCE_SIZE);
+
+		if (write)
+		{
+			if (!aligned)
+			{
+				memcpy(bounce, chunk_data, chunk);
+			}
+
+			nbytes = jd_backend_write_all(bo->direct_fd, (aligned) ? chunk_data : bounce, chunk, chunk_offset);
+		}
+		else
+		{
+			nbytes = jd_backend_read_all(bo->direct_fd, (aligned) ? chunk_data : bounce, chunk, chunk_offset);
+
+			if (!aligned)
+			{
+				memcpy(chunk_data, bounce, nbytes);
+			}
+		}
+
+		nbytes_total += nbytes;
+
+		if (nbytes < chunk)
+		{
+			goto end;
+		}
+	}
+
+	if (tail > 0)
+	{
+		nbytes = (write) ? jd_backend_write_all(bo->fd, data + head + body, tail, offset + head + body) : jd_backend_read_all(bo->fd, data + head + body, tail, offset + head + body);
+		nbytes_total += nbytes;
+	}
+
+end:
+	free(bounce);
+
+	return nbytes_total;
+}
+
+static gboolean
+backend_read(gpointer backend_data, gpointer backend_object, gpointer buffer, guint64 length, guint64 offset, guint64* bytes_read)
+{
+	JBackendObject* bo = backend_object;
+
+	gsize nbytes_total = 0;
+
+	(void)backend_data;
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_READ);
+
+	if (bo->direct_fd != -1)
+	{
+		nbytes_total = jd_backend_direct_io(bo, buffer, length, offset, FALSE);
+	}
+	else
+	{
+		nbytes_total = jd_backend_read_all(bo->fd, buffer, length, offset);
+	}
+
+	j_trace_file_end(bo->path, J_TRACE_FILE_READ, nbytes_total, offset);
+
+	if (bytes_read != NULL)
+	{
+		*bytes_read = nbytes_total;
+	}
+
+	return (nbytes_total == length);
+}
+
+static gboolean
+backend_write(gpointer backend_data, gpointer backend_object, gconstpointer buffer, guint64 length, guint64 offset, guint64* bytes_written)
+{
+	JBackendObject* bo = backend_object;
+
+	gsize nbytes_total = 0;
+
+	(void)backend_data;
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_WRITE);
+
+	if (bo->direct_fd != -1)
+	{
+		nbytes_total = jd_backend_direct_io(bo, (gpointer)buffer, length, offset, TRUE);
+	}
+	else
+	{
+		nbytes_total = jd_backend_write_all(bo->fd, buffer, length, offset);
+		jd_backend_flusher_mark(bo, nbytes_total, offset);
+	}
+
+	j_trace_file_end(bo->path, J_TRACE_FILE_WRITE, nbytes_total, offset);
+
+	if (bytes_written != NULL)
+	{
+		*bytes_written = nbytes_total;
+	}
+
+	return (nbytes_total == length);
+}
+
+/**
+ * Reads or writes adjacent extents using a single vector.
+ * The number of bytes transferred is distributed over the extents in order.
+ **/
+static guint64
+jd_backend_vector_io(gint fd, JBackendObjectExtent* extents, guint32 count, gboolean write)
+{
+	struct iovec iov[JD_BACKEND_IOV_MAX];
+	guint64 length = 0;
+	guint64 nbytes_total = 0;
+	guint64 remaining;
+	guint32 iov_start = 0;
+
+	g_return_val_if_fail(count <= JD_BACKEND_IOV_MAX, 0);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		iov[i].iov_base = extents[i].data;
+		iov[i].iov_len = extents[i].length;
+		length += extents[i].length;
+	}
+
+	while (nbytes_total < length)
+	{
+		gssize nbytes;
+
+		if (write)
+		{
+			nbytes = pwritev(fd, iov + iov_start, count - iov_start, extents[0].offset + nbytes_total);
+		}
+		else
+		{
+			nbytes = preadv(fd, iov + iov_start, count - iov_start, extents[0].offset + nbytes_total);
+		}
+
+		if (nbytes == 0)
+		{
+			break;
+		}
+		else if (nbytes < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			break;
+		}
+
+		nbytes_total += nbytes;
+
+		// Skip the vector entries that have been transferred completely
+		while (nbytes > 0 && iov_start < count)
+		{
+			if ((gsize)nbytes >= iov[iov_start].iov_len)
+			{
+				nbytes -= iov[iov_start].iov_len;
+				iov_start++;
+			}
+			else
+			{
+				iov[iov_start].iov_base = (gchar*)iov[iov_start].iov_base + nbytes;
+				iov[iov_start].iov_len -= nbytes;
+				nbytes = 0;
+			}
+		}
+	}
+
+	remaining = nbytes_total;
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		extents[i].bytes = MIN(remaining, extents[i].length);
+		remaining -= extents[i].bytes;
+	}
+
+	return nbytes_total;
+}
+
+/**
+ * Performs I/O for multiple extents.
+ * Runs of extents that are adjacent within the file are merged into single preadv or pwritev calls.
+ * Extents are processed in the given order, so overlapping writes keep their semantics.
+ **/
+static gboolean
+jd_backend_extents_io(JBackendObject* bo, JBackendObjectExtent* extents, guint32 count, gboolean write)
+{
+	JTraceFileOperation op = (write) ? J_TRACE_FILE_WRITE : J_TRACE_FILE_READ;
+	gboolean ret = TRUE;
+	guint64 nbytes_total = 0;
+
+	if (count == 0)
+	{
+		return TRUE;
+	}
+
+	j_trace_file_begin(bo->path, op);
+
+	for (guint32 i = 0; i < count;)
+	{
+		guint32 run = 1;
+
+		if (bo->direct_fd != -1)
+		{
+			extents[i].bytes = jd_backend_direct_io(bo, extents[i].data, extents[i].length, extents[i].offset, write);
+		}
+		else
+		{
+			while (i + run < count && run < JD_BACKEND_IOV_MAX && extents[i + run].offset == extents[i + run - 1].offset + extents[i + run - 1].length)
+			{
+				run++;
+			}
+
+			if (run == 1)
+			{
+				extents[i].bytes = (write) ? jd_backend_write_all(bo->fd, extents[i].data, extents[i].length, extents[i].offset) : jd_backend_read_all(bo->fd, extents[i].data, extents[i].length, extents[i].offset);
+			}
+			else
+			{
+				jd_backend_vector_io(bo->fd, extents + i, run, write);
+			}
+		}
+
+		for (guint32 j = i; j < i + run; j++)
+		{
+			nbytes_total += extents[j].bytes;
+			ret = (extents[j].bytes == extents[j].length) && ret;
+
+			if (write)
+			{
+				jd_backend_flusher_mark(bo, extents[j].bytes, extents[j].offset);
+			}
+		}
+
+		i += run;
+	}
+
+	j_trace_file_end(bo->path, op, nbytes_total, extents[0].offset);
+
+	return ret;
+}
+
+static gboolean
+backend_readv(gpointer backend_data, gpointer backend_object, JBackendObjectExtent* extents, guint32 count)
+{
+	(void)backend_data;
+
+	return jd_backend_extents_io(backend_object, extents, count, FALSE);
+}
+
+static gboolean
+backend_writev(gpointer backend_data, gpointer backend_object, JBackendObjectExtent* extents, guint32 count)
+{
+	(void)backend_data;
 
-	return (fd != -1);
+	return jd_backend_extents_io(backend_object, extents, count, TRUE);
 }
 
 static gboolean
-backend_open(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
+backend_discard(gpointer backend_data, gpointer backend_object, guint64 length, guint64 offset)
 {
-	JBackendData* bd = backend_data;
-	GHashTable* files = jd_backend_files_get_thread();
+	JBackendObject* bo = backend_object;
+	gboolean ret = FALSE;
 
-	JBackendObject* bo = NULL;
-	gchar* full_path;
-	gint fd;
+	(void)backend_data;
 
-	full_path = g_build_filename(bd->path, namespace, path, NULL);
+	j_trace_file_begin(bo->path, J_TRACE_FILE_DISCARD);
 
-	if ((bo = backend_file_get(files, full_path)) != NULL)
-	{
-		g_free(full_path);
+#ifdef FALLOC_FL_PUNCH_HOLE
+	ret = (fallocate(bo->fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, length) == 0);
+#endif
 
-		// FIXME
-		fd = bo->fd;
+	if (!ret)
+	{
+		struct stat buf;
 
-		goto end;
-	}
+		// The file system does not support punching holes, overwrite the range with zeros instead
+		if (fstat(bo->fd, &buf) == 0)
+		{
+			ret = TRUE;
 
-	j_trace_file_begin(full_path, J_TRACE_FILE_OPEN);
-	fd = open(full_path, O_RDWR);
-	j_trace_file_end(full_path, J_TRACE_FILE_OPEN, 0, 0);
+			if (offset < (guint64)buf.st_size)
+			{
+				g_autofree gpointer zeros = NULL;
+				guint64 zeros_size;
 
-	if (fd == -1)
-	{
-		backend_file_add(files, NULL);
-		goto end;
-	}
+				length = MIN(length, (guint64)buf.st_size - offset);
+				zeros_size = MIN(length, JD_BACKEND_DIRECT_BOUNCE_SIZE);
+				zeros = g_malloc0(zeros_size);
 
-	bo = g_slice_new(JBackendObject);
-	bo->path = full_path;
-	bo->fd = fd;
-	bo->ref_count = 1;
+				for (guint64 position = 0; position < length && ret; position += zeros_size)
+				{
+					guint64 chunk = MIN(length - position, zeros_size);
 
-	backend_file_add(files, bo);
+					ret = (jd_backend_write_all(bo->fd, zeros, chunk, offset + position) == chunk);
+				}
+			}
+		}
+	}
 
-end:
-	*backend_object = bo;
+	j_trace_file_end(bo->path, J_TRACE_FILE_DISCARD, length, offset);
 
-	return (fd != -1);
+	return ret;
 }
 
 static gboolean
-backend_delete(gpointer backend_data, gpointer backend_object)
+backend_preallocate(gpointer backend_data, gpointer backend_object, guint64 size)
 {
 	JBackendObject* bo = backend_object;
-	GHashTable* files = jd_backend_files_get_thread();
-	gboolean ret;
+	gboolean ret = TRUE;
 
 	(void)backend_data;
+	(void)bo;
+	(void)size;
 
-	j_trace_file_begin(bo->path, J_TRACE_FILE_DELETE);
-	ret = (g_unlink(bo->path) == 0);
-	j_trace_file_end(bo->path, J_TRACE_FILE_DELETE, 0, 0);
-
-	g_hash_table_remove(files, bo->path);
+#ifdef FALLOC_FL_KEEP_SIZE
+	// Keep the size so that the preallocated space is not visible to readers
+	if (fallocate(bo->fd, FALLOC_FL_KEEP_SIZE, 0, size) != 0 && errno != EOPNOTSUPP)
+	{
+		ret = FALSE;
+	}
+#endif
 
 	return ret;
 }
 
 static gboolean
-backend_close(gpointer backend_data, gpointer backend_object)
+backend_advise(gpointer backend_data, gpointer backend_object, JAdvice advice, guint64 length, guint64 offset)
 {
 	JBackendObject* bo = backend_object;
-	GHashTable* files = jd_backend_files_get_thread();
-	gboolean ret;
+	gboolean ret = TRUE;
 
 	(void)backend_data;
 
-	ret = g_hash_table_remove(files, bo->path);
+	// Direct I/O bypasses the page cache the advice is about
+	if (bo->direct_fd != -1)
+	{
+		return TRUE;
+	}
+
+#ifdef POSIX_FADV_NORMAL
+	{
+		gint fadvice = POSIX_FADV_NORMAL;
+
+		switch (advice)
+		{
+			case J_ADVICE_NORMAL:
+				fadvice = POSIX_FADV_NORMAL;
+				break;
+			case J_ADVICE_SEQUENTIAL:
+				fadvice = POSIX_FADV_SEQUENTIAL;
+				break;
+			case J_ADVICE_RANDOM:
+				fadvice = POSIX_FADV_RANDOM;
+				break;
+			case J_ADVICE_WILL_NEED:
+				// Starts reading the range into the page cache without waiting for it
+				fadvice = POSIX_FADV_WILLNEED;
+				break;
+			case J_ADVICE_NO_REUSE:
+				fadvice = POSIX_FADV_NOREUSE;
+				break;
+			default:
+				g_warn_if_reached();
+		}
+
+		// posix_fadvise() returns the error instead of setting errno
+		ret = (posix_fadvise(bo->fd, offset, length, fadvice) == 0);
+	}
+#else
+	(void)bo;
+	(void)advice;
+	(void)length;
+	(void)offset;
+#endif
 
 	return ret;
 }
 
 static gboolean
-backend_status(gpointer backend_data, gpointer backend_object, gint64* modification_time, guint64* size)
+backend_get_fd(gpointer backend_data, gpointer backend_object, gint* fd)
 {
 	JBackendObject* bo = backend_object;
-	gboolean ret = TRUE;
-	struct stat buf;
 
 	(void)backend_data;
 
-	if (modification_time != NULL || size != NULL)
+	// Sending from the page cache would bypass direct I/O
+	if (bo->direct_fd != -1)
 	{
-		j_trace_file_begin(bo->path, J_TRACE_FILE_STATUS);
-		ret = (fstat(bo->fd, &buf) == 0);
-		j_trace_file_end(bo->path, J_TRACE_FILE_STATUS, 0, 0);
+		return FALSE;
+	}
 
-		if (ret && modification_time != NULL)
-		{
-			*modification_time = buf.st_mtime * G_USEC_PER_SEC;
+	*fd = bo->fd;
 
-#ifdef HAVE_STMTIM_TVNSEC
-			*modification_time += buf.st_mtim.tv_nsec / 1000;
-#endif
-		}
+	return TRUE;
+}
 
-		if (ret && size != NULL)
-		{
-			*size = buf.st_size;
-		}
-	}
+static gboolean
+backend_written(gpointer backend_data, gpointer backend_object, guint64 length, guint64 offset)
+{
+	JBackendObject* bo = backend_object;
 
-	return ret;
+	(void)backend_data;
+
+	jd_backend_flusher_mark(bo, length, offset);
+
+	return TRUE;
 }
 
 static gboolean
-backend_sync(gpointer backend_data, gpointer backend_object)
+backend_clone(gpointer backend_data, gpointer backend_object, gpointer clone_object)
 {
 	JBackendObject* bo = backend_object;
-	gboolean ret;
+	JBackendObject* clone = clone_object;
+	gboolean ret = FALSE;
 
 	(void)backend_data;
-
-	j_trace_file_begin(bo->path, J_TRACE_FILE_SYNC);
-	ret = (fsync(bo->fd) == 0);
-	j_trace_file_end(bo->path, J_TRACE_FILE_SYNC, 0, 0);
+	(void)bo;
+	(void)clone;
+
+#ifdef HAVE_FICLONE
+	j_trace_file_begin(clone->path, J_TRACE_FILE_WRITE);
+	// Shares all extents if the file system supports reflinks (Btrfs, XFS, ...), fails with EOPNOTSUPP or EXDEV otherwise
+	ret = (ioctl(clone->fd, FICLONE, bo->fd) == 0);
+	j_trace_file_end(clone->path, J_TRACE_FILE_WRITE, 0, 0);
+#endif
 
 	return ret;
 }
 
 static gboolean
-backend_read(gpointer backend_data, gpointer backend_object, gpointer buffer, guint64 length, guint64 offset, guint64* bytes_read)
+backend_copy_range(gpointer backend_data, gpointer backend_object, gpointer target_object, guint64 length, guint64 offset, guint64 target_offset)
 {
 	JBackendObject* bo = backend_object;
-
-	gsize nbytes_total = 0;
+	JBackendObject* target = target_object;
+	gboolean ret = FALSE;
 
 	(void)backend_data;
+	(void)bo;
+	(void)target;
+	(void)length;
+	(void)offset;
+	(void)target_offset;
+
+#ifdef HAVE_COPY_FILE_RANGE
+	// Copying through the page cache would bypass direct I/O
+	if (bo->direct_fd != -1 || target->direct_fd != -1)
+	{
+		return FALSE;
+	}
 
-	j_trace_file_begin(bo->path, J_TRACE_FILE_READ);
+	j_trace_file_begin(target->path, J_TRACE_FILE_WRITE);
 
-	while (nbytes_total < length)
 	{
-		gssize nbytes;
-
-		nbytes = pread(bo->fd, (gchar*)buffer + nbytes_total, length - nbytes_total, offset + nbytes_total);
+		loff_t in_offset = offset;
+		loff_t out_offset = target_offset;
+		guint64 nbytes_total = 0;
 
-		if (nbytes == 0)
-		{
-			break;
-		}
-		else if (nbytes < 0)
+		// Shares extents if the file system supports reflinks (Btrfs, XFS, ...) and copies within the kernel otherwise
+		while (nbytes_total < length)
 		{
-			if (errno != EINTR)
+			gssize nbytes;
+
+			nbytes = copy_file_range(bo->fd, &in_offset, target->fd, &out_offset, length - nbytes_total, 0);
+
+			if (nbytes <= 0)
 			{
+				if (nbytes < 0 && errno == EINTR)
+				{
+					continue;
+				}
+
 				break;
 			}
+
+			nbytes_total += nbytes;
 		}
 
-		nbytes_total += nbytes;
+		ret = (nbytes_total == length);
+		jd_backend_flusher_mark(target, nbytes_total, target_offset);
 	}
 
-	j_trace_file_end(bo->path, J_TRACE_FILE_READ, nbytes_total, offset);
-
-	if (bytes_read != NULL)
-	{
-		*bytes_read = nbytes_total;
-	}
+	j_trace_file_end(target->path, J_TRACE_FILE_WRITE, length, target_offset);
+#endif
 
-	return (nbytes_total == length);
+	return ret;
 }
 
-static gboolean
-backend_write(gpointer backend_data, gpointer backend_object, gconstpointer buffer, guint64 length, guint64 offset, guint64* bytes_written)
+/**
+ * Creates an iterator over a snapshot of the names in a namespace's index.
+ *
+ * \private
+ *
+ * \param bd        The backend data.
+ * \param namespace The namespace.
+ * \param prefix    A prefix, NULL to return all names.
+ *
+ * \return A new iterator.
+ **/
+static JBackendIterator*
+backend_index_iterator_new(JBackendData* bd, gchar const* namespace, gchar const* prefix)
 {
-	JBackendObject* bo = backend_object;
-
-	gsize nbytes_total = 0;
-
-	(void)backend_data;
-
-	j_trace_file_begin(bo->path, J_TRACE_FILE_WRITE);
+	JBackendIterator* iterator;
+	JBackendIndex* index;
+	GSequenceIter* it;
+
+	iterator = g_slice_new(JBackendIterator);
+	iterator->bd = bd;
+	iterator->iterator = NULL;
+	iterator->prefix = NULL;
+	iterator->fd = -1;
+	iterator->namespace = g_strdup(namespace);
+	iterator->names = g_ptr_array_new_with_free_func(g_free);
+	iterator->index = 0;
+
+	index = backend_index_get(bd, namespace);
+
+	if (prefix != NULL)
+	{
+		// g_sequence_search returns the position after equal names
+		it = g_sequence_search(index->names, (gpointer)prefix, backend_index_compare, NULL);
 
-	while (nbytes_total < length)
+		if (!g_sequence_iter_is_begin(it) && strcmp(g_sequence_get(g_sequence_iter_prev(it)), prefix) == 0)
+		{
+			it = g_sequence_iter_prev(it);
+		}
+	}
+	else
 	{
-		gssize nbytes;
+		it = g_sequence_get_begin_iter(index->names);
+	}
 
-		nbytes = pwrite(bo->fd, (gchar const*)buffer + nbytes_total, length - nbytes_total, offset + nbytes_total);
+	// Names are sorted, so all names with the prefix are adjacent
+	for (; !g_sequence_iter_is_end(it); it = g_sequence_iter_next(it))
+	{
+		gchar const* name = g_sequence_get(it);
 
-		if (nbytes <= 0)
+		if (prefix != NULL && !g_str_has_prefix(name, prefix))
 		{
-			if (errno != EINTR)
-			{
-				break;
-			}
+			break;
 		}
 
-		nbytes_total += nbytes;
+		g_ptr_array_add(iterator->names, g_strdup(name));
 	}
 
-	j_trace_file_end(bo->path, J_TRACE_FILE_WRITE, nbytes_total, offset);
+	g_mutex_unlock(index->mutex);
 
-	if (bytes_written != NULL)
+	return iterator;
+}
+
+static void
+backend_iterator_free(JBackendIterator* iterator)
+{
+	if (iterator->fd != -1)
 	{
-		*bytes_written = nbytes_total;
+		close(iterator->fd);
 	}
 
-	return (nbytes_total == length);
+	if (iterator->names != NULL)
+	{
+		g_ptr_array_unref(iterator->names);
+	}
+
+	if (iterator->iterator != NULL)
+	{
+		j_dir_iterator_free(iterator->iterator);
+	}
+
+	g_free(iterator->namespace);
+	g_free(iterator->prefix);
+	g_slice_free(JBackendIterator, iterator);
 }
 
 static gboolean
@@ -415,14 +1978,26 @@ backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend
 	g_return_val_if_fail(namespace != NULL, FALSE);
 	g_return_val_if_fail(backend_iterator != NULL, FALSE);
 
+	if (bd->fanout)
+	{
+		*backend_iterator = backend_index_iterator_new(bd, namespace, NULL);
+
+		return TRUE;
+	}
+
 	full_path = g_build_filename(bd->path, namespace, NULL);
 	it = j_dir_iterator_new(full_path);
 
 	if (it != NULL)
 	{
 		iterator = g_slice_new(JBackendIterator);
+		iterator->bd = bd;
 		iterator->iterator = it;
 		iterator->prefix = NULL;
+		iterator->fd = -1;
+		iterator->namespace = g_strdup(namespace);
+		iterator->names = NULL;
+		iterator->index = 0;
 
 		*backend_iterator = iterator;
 	}
@@ -442,14 +2017,26 @@ backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const
 	g_return_val_if_fail(prefix != NULL, FALSE);
 	g_return_val_if_fail(backend_iterator != NULL, FALSE);
 
+	if (bd->fanout)
+	{
+		*backend_iterator = backend_index_iterator_new(bd, namespace, prefix);
+
+		return TRUE;
+	}
+
 	full_path = g_build_filename(bd->path, namespace, NULL);
 	it = j_dir_iterator_new(full_path);
 
 	if (it != NULL)
 	{
 		iterator = g_slice_new(JBackendIterator);
+		iterator->bd = bd;
 		iterator->iterator = it;
 		iterator->prefix = g_strdup(prefix);
+		iterator->fd = -1;
+		iterator->namespace = g_strdup(namespace);
+		iterator->names = NULL;
+		iterator->index = 0;
 
 		*backend_iterator = iterator;
 	}
@@ -467,6 +2054,21 @@ backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const**
 	g_return_val_if_fail(backend_iterator != NULL, FALSE);
 	g_return_val_if_fail(name != NULL, FALSE);
 
+	if (iterator->names != NULL)
+	{
+		if (iterator->index < iterator->names->len)
+		{
+			*name = g_ptr_array_index(iterator->names, iterator->index);
+			iterator->index++;
+
+			return TRUE;
+		}
+
+		backend_iterator_free(iterator);
+
+		return FALSE;
+	}
+
 	while (j_dir_iterator_next(iterator->iterator))
 	{
 		gchar const* name_;
@@ -483,9 +2085,53 @@ backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const**
 		return TRUE;
 	}
 
-	g_free(iterator->prefix);
-	j_dir_iterator_free(iterator->iterator);
-	g_slice_free(JBackendIterator, iterator);
+	backend_iterator_free(iterator);
+
+	return FALSE;
+}
+
+static gboolean
+backend_iterate_status(gpointer backend_data, gpointer backend_iterator, gchar const** name, gint64* modification_time, guint64* size)
+{
+	JBackendIterator* iterator = backend_iterator;
+
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+
+	if (iterator->fd == -1)
+	{
+		g_autofree gchar* full_path = NULL;
+
+		full_path = g_build_filename(iterator->bd->path, iterator->namespace, NULL);
+
+		if ((iterator->fd = open(full_path, O_RDONLY | O_DIRECTORY)) == -1)
+		{
+			// The iterator frees itself once it is exhausted
+			while (backend_iterate(backend_data, backend_iterator, name))
+			{
+			}
+
+			return FALSE;
+		}
+	}
+
+	// Objects are queried while walking the directory, so listing with status needs no additional open or close
+	while (backend_iterate(backend_data, backend_iterator, name))
+	{
+		g_autofree gchar* relative_path = NULL;
+		struct stat buf;
+
+		// Directory iterators already return paths relative to the namespace
+		relative_path = (iterator->names != NULL) ? backend_get_relative_path(iterator->bd, *name) : g_strdup(*name);
+
+		// Objects deleted in the meantime are skipped
+		if (fstatat(iterator->fd, relative_path, &buf, 0) == 0)
+		{
+			backend_status_from_stat(&buf, modification_time, size);
+
+			return TRUE;
+		}
+	}
 
 	return FALSE;
 }
@@ -495,12 +2141,80 @@ backend_init(gchar const* path, gpointer* backend_data)
 {
 	JBackendData* bd;
 
+	g_auto(GStrv) split = NULL;
+	guint64 flush_rate = 0;
+
 	bd = g_slice_new(JBackendData);
-	bd->path = g_strdup(path);
+	bd->direct = FALSE;
+	bd->fanout = FALSE;
+
+	// The path can be suffixed with :direct to enable direct I/O, :fanout to enable directory fan-out and :flush=RATE to write back dirty data at RATE MiB/s.
+	split = g_strsplit(path, ":", 0);
+	bd->path = g_strdup(split[0]);
+
+	for (guint i = 1; split[0] != NULL && split[i] != NULL; i++)
+	{
+		if (g_strcmp0(split[i], "direct") == 0)
+		{
+			bd->direct = TRUE;
+		}
+		else if (g_strcmp0(split[i], "fanout") == 0)
+		{
+			bd->fanout = TRUE;
+		}
+		else if (g_str_has_prefix(split[i], "flush=") && (flush_rate = g_ascii_strtoull(split[i] + strlen("flush="), NULL, 10)) > 0)
+		{
+			flush_rate *= 1024 * 1024;
+		}
+		else
+		{
+			g_free(bd->path);
+			g_slice_free(JBackendData, bd);
+
+			return FALSE;
+		}
+	}
+
+	g_mutex_init(bd->indexes_mutex);
+	bd->indexes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, backend_index_free);
+
+	if (g_atomic_int_get(&jd_num_backends) == 0)
+	{
+		struct rlimit limit;
+		guint64 max_files = 65536;
+
+		// Keep at most half of the available descriptors open for idle objects.
+		if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+		{
+			max_files = limit.rlim_cur / 2;
+		}
+
+		if (bd->direct)
+		{
+			max_files /= 2;
+		}
 
-	jd_backend_file_cache = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, NULL);
+		jd_backend_file_cache_idle_max = MAX(1, max_files / JD_BACKEND_FILE_CACHE_SHARDS);
 
-	g_mkdir_with_parents(path, 0700);
+		for (guint i = 0; i < JD_BACKEND_FILE_CACHE_SHARDS; i++)
+		{
+			g_mutex_init(jd_backend_file_cache[i].mutex);
+			jd_backend_file_cache[i].files = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, NULL);
+			g_queue_init(jd_backend_file_cache[i].idle);
+		}
+	}
+
+	// The flusher is shared by all instances, the first rate is used
+	if (flush_rate > 0 && jd_backend_flusher.thread == NULL)
+	{
+#ifdef HAVE_SYNC_FILE_RANGE
+		jd_backend_flusher_start(flush_rate);
+#else
+		g_warning("Background flushing is not supported on this platform.");
+#endif
+	}
+
+	g_mkdir_with_parents(bd->path, 0700);
 
 	g_atomic_int_inc(&jd_num_backends);
 
@@ -516,10 +2230,29 @@ backend_fini(gpointer backend_data)
 
 	if (g_atomic_int_dec_and_test(&jd_num_backends))
 	{
-		g_assert(g_hash_table_size(jd_backend_file_cache) == 0);
-		g_hash_table_destroy(jd_backend_file_cache);
+		// The flusher's references have to be dropped before the cache is emptied
+		jd_backend_flusher_stop();
+
+		for (guint i = 0; i < JD_BACKEND_FILE_CACHE_SHARDS; i++)
+		{
+			JBackendFileCacheShard* shard = &(jd_backend_file_cache[i]);
+			JBackendObject* bo;
+
+			while ((bo = g_queue_pop_head(shard->idle)) != NULL)
+			{
+				g_hash_table_remove(shard->files, bo->path);
+				backend_file_free(bo);
+			}
+
+			g_assert(g_hash_table_size(shard->files) == 0);
+			g_hash_table_destroy(shard->files);
+			g_mutex_clear(shard->mutex);
+		}
 	}
 
+	g_hash_table_unref(bd->indexes);
+	g_mutex_clear(bd->indexes_mutex);
+
 	g_free(bd->path);
 	g_slice_free(JBackendData, bd);
 }
@@ -536,11 +2269,22 @@ static JBackend posix_backend = {
 		.backend_close = backend_close,
 		.backend_status = backend_status,
 		.backend_sync = backend_sync,
+		.backend_syncv = backend_syncv,
 		.backend_read = backend_read,
 		.backend_write = backend_write,
+		.backend_readv = backend_readv,
+		.backend_writev = backend_writev,
+		.backend_discard = backend_discard,
+		.backend_preallocate = backend_preallocate,
+		.backend_get_fd = backend_get_fd,
+		.backend_written = backend_written,
+		.backend_clone = backend_clone,
+		.backend_copy_range = backend_copy_range,
+		.backend_advise = backend_advise,
 		.backend_get_all = backend_get_all,
 		.backend_get_by_prefix = backend_get_by_prefix,
-		.backend_iterate = backend_iterate }
+		.backend_iterate = backend_iterate,
+		.backend_iterate_status = backend_iterate_status }
 };
 
 G_MODULE_EXPORT
@@ -43,6 +43,16 @@ struct JBackendObject
 
 typedef struct JBackendObject JBackendObject;
 
+/**
+ * The amount of data read at once when prefetching.
+ **/
+#define J_BACKEND_RADOS_PREFETCH_CHUNK (4 * 1024 * 1024)
+
+/**
+ * The maximum amount of data prefetched by a single advice.
+ **/
+#define J_BACKEND_RADOS_PREFETCH_MAX (16 * J_BACKEND_RADOS_PREFETCH_CHUNK)
+
 static gboolean
 backend_create(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
 {
@@ -205,6 +215,221 @@ backend_write(gpointer backend_data, gpointer backend_object, gconstpointer buff
 	return TRUE;
 }
 
+/**
+ * Waits for asynchronous operations and releases their completions.
+ *
+ * \param completions The completions, NULL elements are skipped.
+ * \param extents     The extents belonging to the completions.
+ * \param count       The number of completions.
+ * \param write       Whether the operations are writes.
+ *
+ * \return TRUE if all operations succeeded, FALSE otherwise.
+ **/
+static gboolean
+backend_aio_wait(rados_completion_t* completions, JBackendObjectExtent* extents, guint32 count, gboolean write)
+{
+	gboolean ret = TRUE;
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		gint r;
+
+		if (completions[i] == NULL)
+		{
+			ret = FALSE;
+			continue;
+		}
+
+		rados_aio_wait_for_complete(completions[i]);
+		r = rados_aio_get_return_value(completions[i]);
+		rados_aio_release(completions[i]);
+
+		if (r < 0)
+		{
+			ret = FALSE;
+			continue;
+		}
+
+		// Reads return the number of bytes read, writes return 0 on success.
+		extents[i].bytes = (write) ? extents[i].length : (guint64)r;
+	}
+
+	return ret;
+}
+
+static void
+backend_prefetch_complete(rados_completion_t completion, gpointer data)
+{
+	(void)completion;
+
+	g_free(data);
+}
+
+static gboolean
+backend_advise(gpointer backend_data, gpointer backend_object, JAdvice advice, guint64 length, guint64 offset)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo = backend_object;
+
+	// Only prefetching has an equivalent, the OSDs manage their caches themselves
+	if (advice != J_ADVICE_WILL_NEED)
+	{
+		return TRUE;
+	}
+
+	if (length == 0)
+	{
+		guint64 size;
+		time_t modification_time;
+
+		if (rados_stat(bd->backend_io, bo->path, &size, &modification_time) != 0)
+		{
+			return FALSE;
+		}
+
+		length = (size > offset) ? size - offset : 0;
+	}
+
+	length = MIN(length, J_BACKEND_RADOS_PREFETCH_MAX);
+
+	// The reads are not waited for, their buffers are freed once they complete
+	for (guint64 position = 0; position < length; position += J_BACKEND_RADOS_PREFETCH_CHUNK)
+	{
+		rados_completion_t completion;
+		gpointer buffer;
+		guint64 chunk;
+
+		chunk = MIN(length - position, J_BACKEND_RADOS_PREFETCH_CHUNK);
+		buffer = g_malloc(chunk);
+
+		if (rados_aio_create_completion(buffer, backend_prefetch_complete, NULL, &completion) != 0)
+		{
+			g_free(buffer);
+			return FALSE;
+		}
+
+		if (rados_aio_read(bd->backend_io, bo->path, completion, buffer, chunk, offset + position) != 0)
+		{
+			rados_aio_release(completion);
+			g_free(buffer);
+			return FALSE;
+		}
+
+		// Completions are only freed once their operations have finished
+		rados_aio_release(completion);
+	}
+
+	return TRUE;
+}
+
+static gboolean
+backend_discard(gpointer backend_data, gpointer backend_object, guint64 length, guint64 offset)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo = backend_object;
+	rados_write_op_t write_op;
+	gint ret;
+
+	write_op = rados_create_write_op();
+	rados_write_op_zero(write_op, offset, length);
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_DISCARD);
+	ret = rados_write_op_operate(write_op, bd->backend_io, bo->path, NULL, 0);
+	j_trace_file_end(bo->path, J_TRACE_FILE_DISCARD, length, offset);
+
+	rados_release_write_op(write_op);
+
+	return (ret == 0);
+}
+
+static gboolean
+backend_readv(gpointer backend_data, gpointer backend_object, JBackendObjectExtent* extents, guint32 count)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo = backend_object;
+	g_autofree rados_completion_t* completions = NULL;
+	gboolean ret;
+	guint64 length = 0;
+
+	completions = g_new(rados_completion_t, count);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		length += extents[i].length;
+	}
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_READ);
+
+	// Issue all reads before waiting so that the OSDs can work on them concurrently.
+	for (guint32 i = 0; i < count; i++)
+	{
+		extents[i].bytes = 0;
+		completions[i] = NULL;
+
+		if (rados_aio_create_completion(NULL, NULL, NULL, &(completions[i])) != 0)
+		{
+			completions[i] = NULL;
+			continue;
+		}
+
+		if (rados_aio_read(bd->backend_io, bo->path, completions[i], extents[i].data, extents[i].length, extents[i].offset) != 0)
+		{
+			rados_aio_release(completions[i]);
+			completions[i] = NULL;
+		}
+	}
+
+	ret = backend_aio_wait(completions, extents, count, FALSE);
+
+	j_trace_file_end(bo->path, J_TRACE_FILE_READ, length, (count > 0) ? extents[0].offset : 0);
+
+	return ret;
+}
+
+static gboolean
+backend_writev(gpointer backend_data, gpointer backend_object, JBackendObjectExtent* extents, guint32 count)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo = backend_object;
+	g_autofree rados_completion_t* completions = NULL;
+	gboolean ret;
+	guint64 length = 0;
+
+	completions = g_new(rados_completion_t, count);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		length += extents[i].length;
+	}
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_WRITE);
+
+	// Issue all writes before waiting so that the OSDs can work on them concurrently.
+	for (guint32 i = 0; i < count; i++)
+	{
+		extents[i].bytes = 0;
+		completions[i] = NULL;
+
+		if (rados_aio_create_completion(NULL, NULL, NULL, &(completions[i])) != 0)
+		{
+			completions[i] = NULL;
+			continue;
+		}
+
+		if (rados_aio_write(bd->backend_io, bo->path, completions[i], extents[i].data, extents[i].length, extents[i].offset) != 0)
+		{
+			rados_aio_release(completions[i]);
+			completions[i] = NULL;
+		}
+	}
+
+	ret = backend_aio_wait(completions, extents, count, TRUE);
+
+	j_trace_file_end(bo->path, J_TRACE_FILE_WRITE, length, (count > 0) ? extents[0].offset : 0);
+
+	return ret;
+}
+
 // FIXME implement backend_get_all
 // FIXME implement backend_get_by_prefix
 // FIXME implement backend_iterate
@@ -288,7 +513,11 @@ static JBackend rados_backend = {
 		.backend_status = backend_status,
 		.backend_sync = backend_sync,
 		.backend_read = backend_read,
-		.backend_write = backend_write }
+		.backend_write = backend_write,
+		.backend_readv = backend_readv,
+		.backend_writev = backend_writev,
+		.backend_discard = backend_discard,
+		.backend_advise = backend_advise }
 };
 
 G_MODULE_EXPORT
@@ -0,0 +1,703 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2017-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <gmodule.h>
+
+#include <string.h>
+
+#include <bson.h>
+
+#include <julea.h>
+#include <julea-db.h>
+
+#include "benchmark.h"
+
+/**
+ * The number of operations per iteration.
+ **/
+#define BACKEND_OPERATIONS 1000
+
+/**
+ * A backend loaded into the benchmark's process, bypassing julea-server and the network.
+ **/
+struct BenchmarkBackend
+{
+	JBackendType type;
+	GModule* module;
+	JBackend* backend;
+};
+
+typedef struct BenchmarkBackend BenchmarkBackend;
+
+/**
+ * Loads and initializes the backend described by run->data.
+ * The description has the form TYPE:NAME[:COMPONENT[:PATH]], see --backend.
+ *
+ * \param run     A benchmark run.
+ * \param type    The backend's type.
+ * \param backend The backend to initialize.
+ **/
+static void
+backend_load(BenchmarkRun* run, JBackendType type, BenchmarkBackend* backend)
+{
+	g_auto(GStrv) parts = NULL;
+	g_autofree gchar* path = NULL;
+	gchar const* name;
+	gchar const* component = NULL;
+	gboolean ret = FALSE;
+
+	parts = g_strsplit(run->data, ":", 4);
+	g_assert_nonnull(parts[0]);
+	g_assert_nonnull(parts[1]);
+
+	name = parts[1];
+
+	if (parts[2] != NULL && parts[2][0] != '\0')
+	{
+		component = parts[2];
+	}
+
+	if (parts[2] != NULL && parts[3] != NULL)
+	{
+		path = g_strdup(parts[3]);
+	}
+	else
+	{
+		// Each rank gets its own storage, similar to the namespaces used by the client benchmarks.
+		path = g_build_filename(g_get_tmp_dir(), "julea-benchmark", j_benchmark_get_namespace(), parts[0], name, NULL);
+	}
+
+	backend->type = type;
+	backend->module = NULL;
+	backend->backend = NULL;
+
+	// Most backends are server backends, try those first if no component has been given.
+	if (component == NULL || g_strcmp0(component, "server") == 0)
+	{
+		j_backend_load_server(name, "server", type, &(backend->module), &(backend->backend));
+	}
+
+	if (backend->backend == NULL && (component == NULL || g_strcmp0(component, "client") == 0))
+	{
+		if (backend->module != NULL)
+		{
+			g_module_close(backend->module);
+		}
+
+		j_backend_load_client(name, "client", type, &(backend->module), &(backend->backend));
+	}
+
+	if (backend->backend == NULL)
+	{
+		g_error("Could not load %s backend %s.", parts[0], name);
+	}
+
+	switch (type)
+	{
+		case J_BACKEND_TYPE_OBJECT:
+			ret = j_backend_object_init(backend->backend, path);
+			break;
+		case J_BACKEND_TYPE_KV:
+			ret = j_backend_kv_init(backend->backend, path);
+			break;
+		case J_BACKEND_TYPE_DB:
+			ret = j_backend_db_init(backend->backend, path);
+			break;
+		default:
+			g_assert_not_reached();
+	}
+
+	if (!ret)
+	{
+		g_error("Could not initialize %s backend %s.", parts[0], name);
+	}
+}
+
+static void
+backend_unload(BenchmarkBackend* backend)
+{
+	switch (backend->type)
+	{
+		case J_BACKEND_TYPE_OBJECT:
+			j_backend_object_fini(backend->backend);
+			break;
+		case J_BACKEND_TYPE_KV:
+			j_backend_kv_fini(backend->backend);
+			break;
+		case J_BACKEND_TYPE_DB:
+			j_backend_db_fini(backend->backend);
+			break;
+		default:
+			g_assert_not_reached();
+	}
+
+	g_module_close(backend->module);
+}
+
+static void
+benchmark_backend_object_create(BenchmarkRun* run)
+{
+	BenchmarkBackend backend;
+	gpointer objects[BACKEND_OPERATIONS];
+	gboolean ret;
+
+	backend_load(run, J_BACKEND_TYPE_OBJECT, &backend);
+
+	while (j_benchmark_iterate(run))
+	{
+		j_benchmark_timer_start(run);
+
+		for (guint i = 0; i < BACKEND_OPERATIONS; i++)
+		{
+			g_autofree gchar* name = NULL;
+
+			name = g_strdup_printf("benchmark-%u", i);
+			ret = j_backend_object_create(backend.backend, j_benchmark_get_namespace(), name, &(objects[i]));
+			g_assert_true(ret);
+		}
+
+		j_benchmark_timer_stop(run);
+
+		for (guint i = 0; i < BACKEND_OPERATIONS; i++)
+		{
+			ret = j_backend_object_delete(backend.backend, objects[i]);
+			g_assert_true(ret);
+		}
+	}
+
+	backend_unload(&backend);
+
+	run->operations = BACKEND_OPERATIONS;
+}
+
+static void
+_benchmark_backend_object_read_write(BenchmarkRun* run, gboolean use_read)
+{
+	guint64 const block_size = j_benchmark_get_parameter(run, J_BENCHMARK_PARAMETER_BLOCK_SIZE, 4 * 1024);
+
+	BenchmarkBackend backend;
+	g_autofree gchar* buffer = NULL;
+	gpointer object;
+	gboolean ret;
+
+	backend_load(run, J_BACKEND_TYPE_OBJECT, &backend);
+
+	buffer = g_malloc0(block_size);
+
+	ret = j_backend_object_create(backend.backend, j_benchmark_get_namespace(), "benchmark", &object);
+	g_assert_true(ret);
+
+	if (use_read)
+	{
+		for (guint i = 0; i < BACKEND_OPERATIONS; i++)
+		{
+			guint64 bytes_written = 0;
+
+			ret = j_backend_object_write(backend.backend, object, buffer, block_size, i * block_size, &bytes_written);
+			g_assert_true(ret);
+			g_assert_cmpuint(bytes_written, ==, block_size);
+		}
+	}
+
+	while (j_benchmark_iterate(run))
+	{
+		j_benchmark_timer_start(run);
+
+		for (guint i = 0; i < BACKEND_OPERATIONS; i++)
+		{
+			guint64 bytes = 0;
+
+			if (use_read)
+			{
+				ret = j_backend_object_read(backend.backend, object, buffer, block_size, i * block_size, &bytes);
+			}
+			else
+			{
+				ret = j_backend_object_write(backend.backend, object, buffer, block_size, i * block_size, &bytes);
+			}
+
+			g_assert_true(ret);
+			g_assert_cmpuint(bytes, ==, block_size);
+		}
+
+		j_benchmark_timer_stop(run);
+	}
+
+	ret = j_backend_object_delete(backend.backend, object);
+	g_assert_true(ret);
+
+	backend_unload(&backend);
+
+	run->operations = BACKEND_OPERATIONS;
+	run->bytes = BACKEND_OPERATIONS * block_size;
+}
+
+static void
+benchmark_backend_object_read(BenchmarkRun* run)
+{
+	_benchmark_backend_object_read_write(run, TRUE);
+}
+
+static void
+benchmark_backend_object_write(BenchmarkRun* run)
+{
+	_benchmark_backend_object_read_write(run, FALSE);
+}
+
+static void
+benchmark_backend_object_status(BenchmarkRun* run)
+{
+	BenchmarkBackend backend;
+	gpointer object;
+	guint64 bytes_written = 0;
+	gboolean ret;
+
+	backend_load(run, J_BACKEND_TYPE_OBJECT, &backend);
+
+	ret = j_backend_object_create(backend.backend, j_benchmark_get_namespace(), "benchmark", &object);
+	g_assert_true(ret);
+	ret = j_backend_object_write(backend.backend, object, "benchmark", 9, 0, &bytes_written);
+	g_assert_true(ret);
+
+	while (j_benchmark_iterate(run))
+	{
+		j_benchmark_timer_start(run);
+
+		for (guint i = 0; i < BACKEND_OPERATIONS; i++)
+		{
+			gint64 modification_time;
+			guint64 size;
+
+			ret = j_backend_object_status(backend.backend, object, &modification_time, &size);
+			g_assert_true(ret);
+			g_assert_cmpuint(size, ==, 9);
+		}
+
+		j_benchmark_timer_stop(run);
+	}
+
+	ret = j_backend_object_delete(backend.backend, object);
+	g_assert_true(ret);
+
+	backend_unload(&backend);
+
+	run->operations = BACKEND_OPERATIONS;
+}
+
+/**
+ * Puts BACKEND_OPERATIONS values or deletes them again within a single batch.
+ **/
+static void
+backend_kv_put_all(BenchmarkRun* run, BenchmarkBackend* backend, gconstpointer value, guint32 value_size)
+{
+	gpointer batch;
+	gboolean ret;
+
+	ret = j_backend_kv_batch_start(backend->backend, j_benchmark_get_namespace(), run->semantics, &batch);
+	g_assert_true(ret);
+
+	for (guint i = 0; i < BACKEND_OPERATIONS; i++)
+	{
+		g_autofree gchar* key = NULL;
+
+		key = g_strdup_printf("benchmark-%u", i);
+
+		if (value != NULL)
+		{
+			ret = j_backend_kv_put(backend->backend, batch, key, value, value_size);
+		}
+		else
+		{
+			ret = j_backend_kv_delete(backend->backend, batch, key);
+		}
+
+		g_assert_true(ret);
+	}
+
+	ret = j_backend_kv_batch_execute(backend->backend, batch);
+	g_assert_true(ret);
+}
+
+static void
+benchmark_backend_kv_put(BenchmarkRun* run)
+{
+	guint32 const value_size = j_benchmark_get_parameter(run, J_BENCHMARK_PARAMETER_VALUE_SIZE, 6);
+
+	BenchmarkBackend backend;
+	g_autofree gchar* value = NULL;
+
+	backend_load(run, J_BACKEND_TYPE_KV, &backend);
+
+	value = g_malloc0(value_size);
+
+	while (j_benchmark_iterate(run))
+	{
+		j_benchmark_timer_start(run);
+		backend_kv_put_all(run, &backend, value, value_size);
+		j_benchmark_timer_stop(run);
+
+		backend_kv_put_all(run, &backend, NULL, 0);
+	}
+
+	backend_unload(&backend);
+
+	run->operations = BACKEND_OPERATIONS;
+	run->bytes = (guint64)BACKEND_OPERATIONS * value_size;
+}
+
+static void
+benchmark_backend_kv_get(BenchmarkRun* run)
+{
+	guint32 const value_size = j_benchmark_get_parameter(run, J_BENCHMARK_PARAMETER_VALUE_SIZE, 6);
+
+	BenchmarkBackend backend;
+	g_autofree gchar* value = NULL;
+	gboolean ret;
+
+	backend_load(run, J_BACKEND_TYPE_KV, &backend);
+
+	value = g_malloc0(value_size);
+	backend_kv_put_all(run, &backend, value, value_size);
+
+	while (j_benchmark_iterate(run))
+	{
+		gpointer batch;
+
+		j_benchmark_timer_start(run);
+
+		ret = j_backend_kv_batch_start(backend.backend, j_benchmark_get_namespace(), run->semantics, &batch);
+		g_assert_true(ret);
+
+		for (guint i = 0; i < BACKEND_OPERATIONS; i++)
+		{
+			g_autofree gchar* key = NULL;
+			g_autofree gpointer get_value = NULL;
+			guint32 get_value_len = 0;
+
+			key = g_strdup_printf("benchmark-%u", i);
+			ret = j_backend_kv_get(backend.backend, batch, key, &get_value, &get_value_len);
+			g_assert_true(ret);
+			g_assert_cmpuint(get_value_len, ==, value_size);
+		}
+
+		ret = j_backend_kv_batch_execute(backend.backend, batch);
+		g_assert_true(ret);
+
+		j_benchmark_timer_stop(run);
+	}
+
+	backend_kv_put_all(run, &backend, NULL, 0);
+	backend_unload(&backend);
+
+	run->operations = BACKEND_OPERATIONS;
+	run->bytes = (guint64)BACKEND_OPERATIONS * value_size;
+}
+
+static void
+benchmark_backend_kv_iterate(BenchmarkRun* run)
+{
+	guint32 const value_size = j_benchmark_get_parameter(run, J_BENCHMARK_PARAMETER_VALUE_SIZE, 6);
+
+	BenchmarkBackend backend;
+	g_autofree gchar* value = NULL;
+	gboolean ret;
+
+	backend_load(run, J_BACKEND_TYPE_KV, &backend);
+
+	value = g_malloc0(value_size);
+	backend_kv_put_all(run, &backend, value, value_size);
+
+	while (j_benchmark_iterate(run))
+	{
+		gpointer iterator;
+		gchar const* key;
+		gconstpointer iterate_value;
+		guint32 iterate_value_len;
+		guint count = 0;
+
+		j_benchmark_timer_start(run);
+
+		ret = j_backend_kv_get_all(backend.backend, j_benchmark_get_namespace(), &iterator);
+		g_assert_true(ret);
+
+		while (j_backend_kv_iterate(backend.backend, iterator, &key, &iterate_value, &iterate_value_len))
+		{
+			count++;
+		}
+
+		j_benchmark_timer_stop(run);
+
+		g_assert_cmpuint(count, ==, BACKEND_OPERATIONS);
+	}
+
+	backend_kv_put_all(run, &backend, NULL, 0);
+	backend_unload(&backend);
+
+	run->operations = BACKEND_OPERATIONS;
+	run->bytes = (guint64)BACKEND_OPERATIONS * value_size;
+}
+
+/**
+ * Creates the schema used by the DB benchmarks, consisting of an indexable key and a string value.
+ **/
+static void
+backend_db_schema_create(BenchmarkRun* run, BenchmarkBackend* backend)
+{
+	bson_t schema;
+	gpointer batch;
+	GError* error = NULL;
+	gboolean ret;
+
+	bson_init(&schema);
+	bson_append_int32(&schema, "key", -1, J_DB_TYPE_UINT64);
+	bson_append_int32(&schema, "value", -1, J_DB_TYPE_STRING);
+
+	ret = j_backend_db_batch_start(backend->backend, j_benchmark_get_namespace(), run->semantics, &batch, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = j_backend_db_schema_create(backend->backend, batch, "benchmark", &schema, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = j_backend_db_batch_execute(backend->backend, batch, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+
+	bson_destroy(&schema);
+}
+
+static void
+backend_db_schema_delete(BenchmarkRun* run, BenchmarkBackend* backend)
+{
+	gpointer batch;
+	GError* error = NULL;
+	gboolean ret;
+
+	ret = j_backend_db_batch_start(backend->backend, j_benchmark_get_namespace(), run->semantics, &batch, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = j_backend_db_schema_delete(backend->backend, batch, "benchmark", &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = j_backend_db_batch_execute(backend->backend, batch, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+}
+
+static void
+backend_db_insert_all(BenchmarkRun* run, BenchmarkBackend* backend)
+{
+	gpointer batch;
+	GError* error = NULL;
+	gboolean ret;
+
+	ret = j_backend_db_batch_start(backend->backend, j_benchmark_get_namespace(), run->semantics, &batch, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+
+	for (guint i = 0; i < BACKEND_OPERATIONS; i++)
+	{
+		bson_t metadata;
+		bson_t id;
+
+		bson_init(&metadata);
+		bson_init(&id);
+		bson_append_int64(&metadata, "key", -1, i);
+		bson_append_utf8(&metadata, "value", -1, "benchmark", -1);
+
+		ret = j_backend_db_insert(backend->backend, batch, "benchmark", &metadata, &id, &error);
+		g_assert_no_error(error);
+		g_assert_true(ret);
+
+		bson_destroy(&id);
+		bson_destroy(&metadata);
+	}
+
+	ret = j_backend_db_batch_execute(backend->backend, batch, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+}
+
+static void
+benchmark_backend_db_insert(BenchmarkRun* run)
+{
+	BenchmarkBackend backend;
+
+	backend_load(run, J_BACKEND_TYPE_DB, &backend);
+
+	while (j_benchmark_iterate(run))
+	{
+		backend_db_schema_create(run, &backend);
+
+		j_benchmark_timer_start(run);
+		backend_db_insert_all(run, &backend);
+		j_benchmark_timer_stop(run);
+
+		backend_db_schema_delete(run, &backend);
+	}
+
+	backend_unload(&backend);
+
+	run->operations = BACKEND_OPERATIONS;
+}
+
+static void
+benchmark_backend_db_query(BenchmarkRun* run)
+{
+	BenchmarkBackend backend;
+	GError* error = NULL;
+	gboolean ret;
+
+	backend_load(run, J_BACKEND_TYPE_DB, &backend);
+
+	backend_db_schema_create(run, &backend);
+	backend_db_insert_all(run, &backend);
+
+	while (j_benchmark_iterate(run))
+	{
+		gpointer batch;
+
+		j_benchmark_timer_start(run);
+
+		ret = j_backend_db_batch_start(backend.backend, j_benchmark_get_namespace(), run->semantics, &batch, &error);
+		g_assert_no_error(error);
+		g_assert_true(ret);
+
+		for (guint i = 0; i < BACKEND_OPERATIONS; i++)
+		{
+			bson_t selector;
+			bson_t condition;
+			bson_t entry;
+			gpointer iterator;
+			guint count = 0;
+
+			bson_init(&selector);
+			bson_append_int32(&selector, "_mode", -1, J_DB_SELECTOR_MODE_AND);
+			bson_append_document_begin(&selector, "0", -1, &condition);
+			bson_append_utf8(&condition, "_name", -1, "key", -1);
+			bson_append_int32(&condition, "_operator", -1, J_DB_SELECTOR_OPERATOR_EQ);
+			bson_append_int64(&condition, "_value", -1, i);
+			bson_append_document_end(&selector, &condition);
+
+			ret = j_backend_db_query(backend.backend, batch, "benchmark", &selector, &iterator, &error);
+			g_assert_no_error(error);
+			g_assert_true(ret);
+
+			bson_init(&entry);
+
+			while (j_backend_db_iterate(backend.backend, iterator, &entry, &error))
+			{
+				count++;
+
+				bson_destroy(&entry);
+				bson_init(&entry);
+			}
+
+			// Exhausted iterators report that there are no more elements.
+			g_assert_error(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS);
+			g_clear_error(&error);
+			g_assert_cmpuint(count, ==, 1);
+
+			bson_destroy(&entry);
+			bson_destroy(&selector);
+		}
+
+		ret = j_backend_db_batch_execute(backend.backend, batch, &error);
+		g_assert_no_error(error);
+		g_assert_true(ret);
+
+		j_benchmark_timer_stop(run);
+	}
+
+	backend_db_schema_delete(run, &backend);
+	backend_unload(&backend);
+
+	run->operations = BACKEND_OPERATIONS;
+}
+
+void
+benchmark_backend(void)
+{
+	gchar const* const* backends;
+
+	backends = j_benchmark_get_backends();
+
+	for (guint i = 0; backends != NULL && backends[i] != NULL; i++)
+	{
+		g_auto(GStrv) parts = NULL;
+		g_autofree gchar* prefix = NULL;
+		g_autofree gchar* name = NULL;
+		gconstpointer data = backends[i];
+
+		parts = g_strsplit(backends[i], ":", 3);
+
+		if (parts[0] == NULL || parts[1] == NULL || parts[1][0] == '\0')
+		{
+			g_printerr("Error: Backend %s has to be given as TYPE:NAME[:COMPONENT[:PATH]]\n", backends[i]);
+			continue;
+		}
+
+		prefix = g_strdup_printf("/backend/%s/%s", parts[0], parts[1]);
+
+		if (g_strcmp0(parts[0], "object") == 0)
+		{
+			name = g_strconcat(prefix, "/create", NULL);
+			j_benchmark_add_data(name, benchmark_backend_object_create, 0, data);
+			g_free(name);
+
+			name = g_strconcat(prefix, "/write", NULL);
+			j_benchmark_add_data(name, benchmark_backend_object_write, J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_BLOCK_SIZE), data);
+			g_free(name);
+
+			name = g_strconcat(prefix, "/read", NULL);
+			j_benchmark_add_data(name, benchmark_backend_object_read, J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_BLOCK_SIZE), data);
+			g_free(name);
+
+			name = g_strconcat(prefix, "/status", NULL);
+			j_benchmark_add_data(name, benchmark_backend_object_status, 0, data);
+		}
+		else if (g_strcmp0(parts[0], "kv") == 0)
+		{
+			name = g_strconcat(prefix, "/put", NULL);
+			j_benchmark_add_data(name, benchmark_backend_kv_put, J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_VALUE_SIZE), data);
+			g_free(name);
+
+			name = g_strconcat(prefix, "/get", NULL);
+			j_benchmark_add_data(name, benchmark_backend_kv_get, J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_VALUE_SIZE), data);
+			g_free(name);
+
+			name = g_strconcat(prefix, "/iterate", NULL);
+			j_benchmark_add_data(name, benchmark_backend_kv_iterate, J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_VALUE_SIZE), data);
+		}
+		else if (g_strcmp0(parts[0], "db") == 0)
+		{
+			name = g_strconcat(prefix, "/insert", NULL);
+			j_benchmark_add_data(name, benchmark_backend_db_insert, 0, data);
+			g_free(name);
+
+			name = g_strconcat(prefix, "/query", NULL);
+			j_benchmark_add_data(name, benchmark_backend_db_query, 0, data);
+		}
+		else
+		{
+			g_printerr("Error: Unknown backend type %s, has to be object, kv or db\n", parts[0]);
+		}
+	}
+}
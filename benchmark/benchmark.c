@@ -21,8 +21,18 @@
 #include <glib.h>
 
 #include <locale.h>
+#include <math.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include <sys/utsname.h>
+
+#ifdef HAVE_MPI
+#include <mpi.h>
+#endif
+
+#include <bson.h>
+
 #include <julea.h>
 
 #include "benchmark.h"
@@ -34,126 +44,1086 @@ static gboolean opt_machine_readable = FALSE;
 static gchar* opt_path = NULL;
 static gchar* opt_semantics = NULL;
 static gchar* opt_template = NULL;
+static gint opt_threads = 0;
+static gchar* opt_block_sizes = NULL;
+static gchar* opt_batch_sizes = NULL;
+static gchar* opt_value_sizes = NULL;
+static gchar* opt_stripe_sizes = NULL;
+static gchar* opt_distributions = NULL;
+static gchar* opt_workload = NULL;
+static gchar* opt_workload_trace = NULL;
+static gchar** opt_backends = NULL;
+static gchar* opt_json = NULL;
+
+/**
+ * The semantics to sweep, one per template given via --template.
+ **/
+static GPtrArray* j_benchmark_semantics = NULL;
+static gchar** j_benchmark_templates = NULL;
+
+/**
+ * The values to sweep per parameter, NULL if the benchmarks' defaults should be used.
+ **/
+static GArray* j_benchmark_sweeps[J_BENCHMARK_PARAMETERS] = { NULL };
+
+static gchar const* const j_benchmark_parameter_names[J_BENCHMARK_PARAMETERS] = {
+	"block-size",
+	"batch-size",
+	"value-size",
+	"stripe-size",
+	"distribution"
+};
+
+struct BenchmarkDistribution
+{
+	gchar const* name;
+	JDistributionType type;
+};
+
+typedef struct BenchmarkDistribution BenchmarkDistribution;
+
+static BenchmarkDistribution const j_benchmark_distributions[] = {
+	{ "round-robin", J_DISTRIBUTION_ROUND_ROBIN },
+	{ "single-server", J_DISTRIBUTION_SINGLE_SERVER },
+	{ "weighted", J_DISTRIBUTION_WEIGHTED },
+	{ "local", J_DISTRIBUTION_LOCAL },
+	{ "consistent", J_DISTRIBUTION_CONSISTENT },
+	{ "erasure", J_DISTRIBUTION_ERASURE },
+	{ "replicated", J_DISTRIBUTION_REPLICATED },
+	{ "adaptive", J_DISTRIBUTION_ADAPTIVE }
+};
+
+/**
+ * The benchmark that is currently running.
+ **/
+static BenchmarkRun* j_benchmark_current = NULL;
+
+static GList* j_benchmarks = NULL;
+static gsize j_benchmark_name_max = 0;
+
+/**
+ * The current process's rank and the number of ranks.
+ * There are multiple ranks if julea-benchmark has been started via MPI.
+ **/
+static gint j_benchmark_rank = 0;
+static gint j_benchmark_ranks = 1;
+
+static gchar* j_benchmark_namespace = NULL;
+
+/**
+ * The results written to the file given via --json, only used on the first rank.
+ **/
+static bson_t* j_benchmark_json_results = NULL;
+static guint32 j_benchmark_json_count = 0;
+
+/**
+ * The results of a benchmark run on a single rank.
+ **/
+struct BenchmarkResult
+{
+	gdouble elapsed;
+	gdouble operations;
+	gdouble bytes;
+	gdouble elapsed_total;
+	gdouble latency_max;
+};
+
+typedef struct BenchmarkResult BenchmarkResult;
+
+/**
+ * Values below 2^J_BENCHMARK_HISTOGRAM_PRECISION nanoseconds are recorded exactly.
+ * Larger values are recorded with J_BENCHMARK_HISTOGRAM_PRECISION significant bits, that is, a relative error below 1/64.
+ **/
+#define J_BENCHMARK_HISTOGRAM_PRECISION 7
+#define J_BENCHMARK_HISTOGRAM_SUB_BUCKETS (1 << (J_BENCHMARK_HISTOGRAM_PRECISION - 1))
+#define J_BENCHMARK_HISTOGRAM_BUCKETS ((1 << J_BENCHMARK_HISTOGRAM_PRECISION) + (64 - J_BENCHMARK_HISTOGRAM_PRECISION) * J_BENCHMARK_HISTOGRAM_SUB_BUCKETS)
+
+/**
+ * A log-linear latency histogram in the style of HdrHistogram.
+ * Recording a value is constant-time and the memory usage does not depend on the number of values.
+ **/
+struct BenchmarkHistogram
+{
+	guint64 counts[J_BENCHMARK_HISTOGRAM_BUCKETS];
+	guint64 count;
+
+	/**
+	 * The exact maximum in seconds.
+	 **/
+	gdouble max;
+
+	/**
+	 * The exact sum and sum of squares in seconds, used for the mean and standard deviation.
+	 **/
+	gdouble sum;
+	gdouble sum_squares;
+};
+
+typedef struct BenchmarkHistogram BenchmarkHistogram;
+
+JSemantics*
+j_benchmark_get_semantics(void)
+{
+	if (j_benchmark_current != NULL)
+	{
+		return j_semantics_ref(j_benchmark_current->semantics);
+	}
+
+	return j_semantics_ref(g_ptr_array_index(j_benchmark_semantics, 0));
+}
+
+gchar const*
+j_benchmark_get_namespace(void)
+{
+	return j_benchmark_namespace;
+}
+
+gint
+j_benchmark_get_duration(void)
+{
+	return opt_duration;
+}
+
+gchar const*
+j_benchmark_get_workload(void)
+{
+	return opt_workload;
+}
+
+gchar const*
+j_benchmark_get_workload_trace(void)
+{
+	return opt_workload_trace;
+}
+
+gchar const* const*
+j_benchmark_get_backends(void)
+{
+	return (gchar const* const*)opt_backends;
+}
+
+/**
+ * Returns the value of a swept parameter.
+ *
+ * \param run           A benchmark run.
+ * \param parameter     A parameter.
+ * \param default_value The value to use if the parameter is not swept.
+ *
+ * \return The parameter's value.
+ **/
+guint64
+j_benchmark_get_parameter(BenchmarkRun* run, BenchmarkParameter parameter, guint64 default_value)
+{
+	g_return_val_if_fail(run != NULL, default_value);
+	g_return_val_if_fail(parameter < J_BENCHMARK_PARAMETERS, default_value);
+
+	if (run->parameters_set & J_BENCHMARK_SWEEP(parameter))
+	{
+		return run->parameters[parameter];
+	}
+
+	return default_value;
+}
+
+/**
+ * Creates a distribution according to the distribution and stripe size parameters.
+ *
+ * \param run A benchmark run.
+ *
+ * \return A new distribution. Should be freed with j_distribution_unref().
+ **/
+JDistribution*
+j_benchmark_get_distribution(BenchmarkRun* run)
+{
+	JDistribution* distribution;
+	JDistributionType type;
+	guint64 stripe_size;
+
+	g_return_val_if_fail(run != NULL, NULL);
+
+	type = j_benchmark_get_parameter(run, J_BENCHMARK_PARAMETER_DISTRIBUTION, J_DISTRIBUTION_ROUND_ROBIN);
+	stripe_size = j_benchmark_get_parameter(run, J_BENCHMARK_PARAMETER_STRIPE_SIZE, 0);
+
+	distribution = j_distribution_new(type);
+
+	if (stripe_size > 0)
+	{
+		j_distribution_set_block_size(distribution, stripe_size);
+	}
+
+	// The weighted distribution does not use any server until weights have been set.
+	if (type == J_DISTRIBUTION_WEIGHTED)
+	{
+		guint32 server_count;
+
+		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
+
+		for (guint32 i = 0; i < server_count; i++)
+		{
+			j_distribution_set2(distribution, "weight", i, 1);
+		}
+	}
+
+	return distribution;
+}
+
+static gboolean
+j_benchmark_parse_size(gchar const* string, guint64* size)
+{
+	gchar* end = NULL;
+	guint64 value;
+
+	value = g_ascii_strtoull(string, &end, 10);
+
+	if (end == string)
+	{
+		return FALSE;
+	}
+
+	switch (g_ascii_toupper(*end))
+	{
+		case 'K':
+			value *= 1024;
+			end++;
+			break;
+		case 'M':
+			value *= 1024 * 1024;
+			end++;
+			break;
+		case 'G':
+			value *= 1024 * 1024 * 1024;
+			end++;
+			break;
+		default:
+			break;
+	}
+
+	if (*end != '\0' || value == 0)
+	{
+		return FALSE;
+	}
+
+	*size = value;
+
+	return TRUE;
+}
+
+/**
+ * Parses a list of sizes such as \"4K,64K-1M\".
+ * Ranges are swept in powers of two.
+ *
+ * \param string A list of sizes.
+ *
+ * \return The sizes, NULL on error.
+ **/
+GArray*
+j_benchmark_parse_sizes(gchar const* string)
+{
+	g_autoptr(GArray) sizes = NULL;
+	g_auto(GStrv) items = NULL;
+
+	sizes = g_array_new(FALSE, FALSE, sizeof(guint64));
+	items = g_strsplit(string, ",", 0);
+
+	for (guint i = 0; items[i] != NULL; i++)
+	{
+		g_auto(GStrv) range = NULL;
+		guint64 first;
+		guint64 last;
+
+		range = g_strsplit(items[i], "-", 2);
+
+		if (range[0] == NULL || !j_benchmark_parse_size(range[0], &first))
+		{
+			return NULL;
+		}
+
+		last = first;
+
+		if (range[1] != NULL && (!j_benchmark_parse_size(range[1], &last) || last < first))
+		{
+			return NULL;
+		}
+
+		for (guint64 size = first; size <= last; size *= 2)
+		{
+			g_array_append_val(sizes, size);
+
+			if (size > G_MAXUINT64 / 2)
+			{
+				break;
+			}
+		}
+	}
+
+	if (sizes->len == 0)
+	{
+		return NULL;
+	}
+
+	return g_steal_pointer(&sizes);
+}
+
+static GArray*
+j_benchmark_parse_distributions(gchar const* string)
+{
+	g_autoptr(GArray) distributions = NULL;
+	g_auto(GStrv) items = NULL;
+
+	distributions = g_array_new(FALSE, FALSE, sizeof(guint64));
+	items = g_strsplit(string, ",", 0);
+
+	for (guint i = 0; items[i] != NULL; i++)
+	{
+		gboolean found = FALSE;
+
+		for (guint j = 0; j < G_N_ELEMENTS(j_benchmark_distributions); j++)
+		{
+			if (g_strcmp0(items[i], j_benchmark_distributions[j].name) == 0)
+			{
+				guint64 type = j_benchmark_distributions[j].type;
+
+				g_array_append_val(distributions, type);
+				found = TRUE;
+				break;
+			}
+		}
+
+		if (!found)
+		{
+			return NULL;
+		}
+	}
+
+	if (distributions->len == 0)
+	{
+		return NULL;
+	}
+
+	return g_steal_pointer(&distributions);
+}
+
+/**
+ * Parses the values given for all parameters.
+ *
+ * \return TRUE on success, FALSE if a value is invalid.
+ **/
+static gboolean
+j_benchmark_parse_sweeps(void)
+{
+	gchar const* sizes[J_BENCHMARK_PARAMETERS] = { opt_block_sizes, opt_batch_sizes, opt_value_sizes, opt_stripe_sizes, NULL };
+
+	for (guint i = 0; i < J_BENCHMARK_PARAMETERS; i++)
+	{
+		if (i == J_BENCHMARK_PARAMETER_DISTRIBUTION)
+		{
+			if (opt_distributions != NULL && (j_benchmark_sweeps[i] = j_benchmark_parse_distributions(opt_distributions)) == NULL)
+			{
+				g_printerr("Error: Invalid distributions %s\n", opt_distributions);
+
+				return FALSE;
+			}
+		}
+		else if (sizes[i] != NULL && (j_benchmark_sweeps[i] = j_benchmark_parse_sizes(sizes[i])) == NULL)
+		{
+			g_printerr("Error: Invalid %ss %s\n", j_benchmark_parameter_names[i], sizes[i]);
+
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+static gchar const*
+j_benchmark_get_distribution_name(guint64 type)
+{
+	for (guint i = 0; i < G_N_ELEMENTS(j_benchmark_distributions); i++)
+	{
+		if (j_benchmark_distributions[i].type == type)
+		{
+			return j_benchmark_distributions[i].name;
+		}
+	}
+
+	return "unknown";
+}
+
+static void
+j_benchmark_barrier(void)
+{
+#ifdef HAVE_MPI
+	if (j_benchmark_ranks > 1)
+	{
+		MPI_Barrier(MPI_COMM_WORLD);
+	}
+#endif
+}
+
+/**
+ * Collects the results of all ranks on rank 0.
+ *
+ * \param result  The current rank's result.
+ * \param results The results of all ranks, only filled on rank 0.
+ **/
+static void
+j_benchmark_gather(BenchmarkResult const* result, BenchmarkResult* results)
+{
+#ifdef HAVE_MPI
+	if (j_benchmark_ranks > 1)
+	{
+		MPI_Gather(result, sizeof(BenchmarkResult) / sizeof(gdouble), MPI_DOUBLE, results, sizeof(BenchmarkResult) / sizeof(gdouble), MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+		return;
+	}
+#endif
+
+	results[0] = *result;
+}
+
+static gint
+j_benchmark_compare_double(void const* a, void const* b)
+{
+	gdouble const* x = a;
+	gdouble const* y = b;
+
+	return (*x > *y) - (*x < *y);
+}
+
+void
+j_benchmark_timer_start(BenchmarkRun* run)
+{
+	g_return_if_fail(run != NULL);
+
+	if (!run->timer_started)
+	{
+		g_timer_start(run->timer);
+		run->timer_started = TRUE;
+	}
+	else
+	{
+		g_timer_continue(run->timer);
+	}
+}
+
+void
+j_benchmark_timer_stop(BenchmarkRun* run)
+{
+	g_return_if_fail(run != NULL);
+
+	g_timer_stop(run->timer);
+}
+
+gboolean
+j_benchmark_iterate(BenchmarkRun* run)
+{
+	gdouble elapsed;
+
+	g_return_val_if_fail(run != NULL, FALSE);
+
+	// The timer only runs while it is started, so this is the measured part of the previous iteration.
+	if (run->iterations > 0)
+	{
+		elapsed = g_timer_elapsed(run->timer, NULL);
+		j_benchmark_add_latency(run, MAX(elapsed - run->iteration_elapsed, 0.0));
+		run->iteration_elapsed = elapsed;
+	}
+
+	if (run->iterations == 0 || run->iteration_elapsed < opt_duration)
+	{
+		run->iterations++;
+
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+static guint
+j_benchmark_histogram_index(guint64 value)
+{
+	guint shift;
+
+	if (value < (1 << J_BENCHMARK_HISTOGRAM_PRECISION))
+	{
+		return value;
+	}
+
+	// Keep the value's J_BENCHMARK_HISTOGRAM_PRECISION most significant bits.
+	shift = g_bit_storage(value) - J_BENCHMARK_HISTOGRAM_PRECISION;
+
+	return (1 << J_BENCHMARK_HISTOGRAM_PRECISION) + (shift - 1) * J_BENCHMARK_HISTOGRAM_SUB_BUCKETS + (value >> shift) - J_BENCHMARK_HISTOGRAM_SUB_BUCKETS;
+}
+
+/**
+ * Returns the highest value that is recorded in a bucket.
+ *
+ * \param index A bucket index.
+ *
+ * 
+eturn The bucket's highest value in nanoseconds.
+ **/
+static guint64
+j_benchmark_histogram_value(guint index)
+{
+	guint shift;
+	guint64 top;
+
+	if (index < (1 << J_BENCHMARK_HISTOGRAM_PRECISION))
+	{
+		return index;
+	}
+
+	index -= 1 << J_BENCHMARK_HISTOGRAM_PRECISION;
+	shift = index / J_BENCHMARK_HISTOGRAM_SUB_BUCKETS + 1;
+	top = index % J_BENCHMARK_HISTOGRAM_SUB_BUCKETS + J_BENCHMARK_HISTOGRAM_SUB_BUCKETS;
+
+	return ((top + 1) << shift) - 1;
+}
+
+/**
+ * Returns a latency percentile.
+ *
+ * \param histogram  A histogram.
+ * \param percentile A percentile between 0 and 100.
+ *
+ * 
+eturn The percentile in seconds.
+ **/
+static gdouble
+j_benchmark_histogram_percentile(BenchmarkHistogram const* histogram, gdouble percentile)
+{
+	guint64 rank;
+	guint64 count = 0;
+
+	if (histogram->count == 0)
+	{
+		return 0.0;
+	}
+
+	rank = MAX(1, (guint64)(percentile / 100.0 * histogram->count + 0.5));
+
+	for (guint i = 0; i < J_BENCHMARK_HISTOGRAM_BUCKETS; i++)
+	{
+		count += histogram->counts[i];
+
+		if (count >= rank)
+		{
+			// Buckets are approximate, so never report more than the actual maximum.
+			return MIN((gdouble)j_benchmark_histogram_value(i) / 1000000000.0, histogram->max);
+		}
+	}
+
+	return histogram->max;
+}
+
+/**
+ * Records a latency.
+ * This function is not thread-safe, multi-threaded benchmarks have to collect latencies themselves.
+ *
+ * \param run     A benchmark run.
+ * \param latency A latency in seconds.
+ **/
+void
+j_benchmark_add_latency(BenchmarkRun* run, gdouble latency)
+{
+	guint64 value;
+
+	g_return_if_fail(run != NULL);
+	g_return_if_fail(latency >= 0.0);
+
+	value = latency * 1000000000.0;
+
+	run->latencies->counts[j_benchmark_histogram_index(value)]++;
+	run->latencies->count++;
+	run->latencies->max = MAX(run->latencies->max, latency);
+	run->latencies->sum += latency;
+	run->latencies->sum_squares += latency * latency;
+}
+
+/**
+ * Combines the latency histograms of all ranks on rank 0.
+ *
+ * \param histogram A histogram, replaced by the combined histogram on rank 0.
+ **/
+static void
+j_benchmark_histogram_reduce(BenchmarkHistogram* histogram)
+{
+#ifdef HAVE_MPI
+	if (j_benchmark_ranks > 1)
+	{
+		g_autofree guint64* counts = NULL;
+		guint64 count = 0;
+		gdouble sums[2] = { 0.0, 0.0 };
+		gdouble sums_local[2];
+
+		counts = g_new(guint64, J_BENCHMARK_HISTOGRAM_BUCKETS);
+		sums_local[0] = histogram->sum;
+		sums_local[1] = histogram->sum_squares;
+
+		MPI_Reduce(histogram->counts, counts, J_BENCHMARK_HISTOGRAM_BUCKETS, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+		MPI_Reduce(&(histogram->count), &count, 1, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+		MPI_Reduce(sums_local, sums, 2, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+		if (j_benchmark_rank == 0)
+		{
+			memcpy(histogram->counts, counts, sizeof(histogram->counts));
+			histogram->count = count;
+			histogram->sum = sums[0];
+			histogram->sum_squares = sums[1];
+		}
+	}
+#else
+	(void)histogram;
+#endif
+}
+
+static void
+j_benchmark_run_free(gpointer data)
+{
+	BenchmarkRun* run = data;
+
+	g_return_if_fail(data != NULL);
+
+	g_ptr_array_unref(run->classes);
+	j_semantics_unref(run->semantics);
+	g_timer_destroy(run->timer);
+	g_free(run->latencies);
+	g_free(run->name);
+	g_free(run);
+}
+
+static BenchmarkRun*
+j_benchmark_run_new(gchar const* name, BenchmarkFunc benchmark_func, guint threads, JSemantics* semantics)
+{
+	BenchmarkRun* run;
+
+	run = g_new0(BenchmarkRun, 1);
+	run->name = g_strdup(name);
+	run->func = benchmark_func;
+	run->timer = g_timer_new();
+	run->timer_started = FALSE;
+	run->iterations = 0;
+	run->operations = 0;
+	run->bytes = 0;
+	run->threads = threads;
+	run->latencies = g_new0(BenchmarkHistogram, 1);
+	run->iteration_elapsed = 0.0;
+	run->parameters_set = 0;
+	run->semantics = j_semantics_ref(semantics);
+	run->classes = g_ptr_array_new_with_free_func(j_benchmark_run_free);
+	run->data = NULL;
+
+	return run;
+}
+
+/**
+ * Adds a single combination of a benchmark's parameters.
+ *
+ * \param name           A name.
+ * \param benchmark_func A benchmark function.
+ * \param threads        The number of threads.
+ * \param parameters     The parameters swept by the benchmark.
+ * \param index          The index into each parameter's values, the last one selects the semantics.
+ * \param classes        The names of the benchmark's classes, may be NULL.
+ * \param data           Data passed to the benchmark via run->data, may be NULL.
+ **/
+static void
+j_benchmark_add_one(gchar const* name, BenchmarkFunc benchmark_func, guint threads, guint parameters, guint const* index, gchar const* const* classes, gconstpointer data)
+{
+	g_autoptr(GString) run_name = NULL;
+	BenchmarkRun* run;
+	guint64 values[J_BENCHMARK_PARAMETERS] = { 0 };
+	guint values_set = 0;
+
+	run_name = g_string_new(name);
+
+	for (guint i = 0; i < J_BENCHMARK_PARAMETERS; i++)
+	{
+		if (!(parameters & J_BENCHMARK_SWEEP(i)) || j_benchmark_sweeps[i] == NULL)
+		{
+			continue;
+		}
+
+		values[i] = g_array_index(j_benchmark_sweeps[i], guint64, index[i]);
+		values_set |= J_BENCHMARK_SWEEP(i);
+
+		// Only parameters with multiple values are part of the name, the rest is the same for all results.
+		if (j_benchmark_sweeps[i]->len > 1)
+		{
+			if (i == J_BENCHMARK_PARAMETER_DISTRIBUTION)
+			{
+				g_string_append_printf(run_name, "/%s=%s", j_benchmark_parameter_names[i], j_benchmark_get_distribution_name(values[i]));
+			}
+			else
+			{
+				g_string_append_printf(run_name, "/%s=%" G_GUINT64_FORMAT, j_benchmark_parameter_names[i], values[i]);
+			}
+		}
+	}
+
+	if (j_benchmark_semantics->len > 1)
+	{
+		g_string_append_printf(run_name, "/template=%s", j_benchmark_templates[index[J_BENCHMARK_PARAMETERS]]);
+	}
+
+	if (opt_path != NULL)
+	{
+		g_autofree gchar* path_suite = NULL;
+
+		path_suite = g_strconcat(opt_path, "/", NULL);
+
+		if (g_strcmp0(run_name->str, opt_path) != 0 && !g_str_has_prefix(run_name->str, path_suite))
+		{
+			return;
+		}
+	}
+
+	j_benchmark_name_max = MAX(j_benchmark_name_max, run_name->len);
+
+	run = j_benchmark_run_new(run_name->str, benchmark_func, threads, g_ptr_array_index(j_benchmark_semantics, index[J_BENCHMARK_PARAMETERS]));
+	memcpy(run->parameters, values, sizeof(values));
+	run->parameters_set = values_set;
+	run->data = data;
+
+	for (guint i = 0; classes != NULL && classes[i] != NULL; i++)
+	{
+		BenchmarkRun* class;
+		g_autofree gchar* class_name = NULL;
+
+		class_name = g_strconcat(run->name, "/", classes[i], NULL);
+		j_benchmark_name_max = MAX(j_benchmark_name_max, strlen(class_name));
+
+		class = j_benchmark_run_new(class_name, NULL, threads, run->semantics);
+		g_ptr_array_add(run->classes, class);
+	}
+
+	j_benchmarks = g_list_prepend(j_benchmarks, run);
+}
+
+/**
+ * Adds one run per combination of the swept parameters' values and semantics.
+ **/
+static void
+j_benchmark_add_run(gchar const* name, BenchmarkFunc benchmark_func, guint threads, guint parameters, gchar const* const* classes, gconstpointer data)
+{
+	guint index[J_BENCHMARK_PARAMETERS + 1] = { 0 };
+	guint length[J_BENCHMARK_PARAMETERS + 1];
+	guint i;
+
+	for (i = 0; i < J_BENCHMARK_PARAMETERS; i++)
+	{
+		length[i] = ((parameters & J_BENCHMARK_SWEEP(i)) && j_benchmark_sweeps[i] != NULL) ? j_benchmark_sweeps[i]->len : 1;
+	}
+
+	length[J_BENCHMARK_PARAMETERS] = j_benchmark_semantics->len;
+
+	do
+	{
+		j_benchmark_add_one(name, benchmark_func, threads, parameters, index, classes, data);
+
+		// Advance to the next combination, the semantics change fastest.
+		for (i = J_BENCHMARK_PARAMETERS + 1; i > 0; i--)
+		{
+			index[i - 1]++;
+
+			if (index[i - 1] < length[i - 1])
+			{
+				break;
+			}
+
+			index[i - 1] = 0;
+		}
+	} while (i > 0);
+}
+
+void
+j_benchmark_add(gchar const* name, BenchmarkFunc benchmark_func)
+{
+	g_return_if_fail(name != NULL);
+	g_return_if_fail(benchmark_func != NULL);
+
+	j_benchmark_add_run(name, benchmark_func, 1, 0, NULL, NULL);
+}
+
+/**
+ * Adds a benchmark that is run once per combination of the values given for its parameters.
+ *
+ * \param name           A name.
+ * \param benchmark_func A benchmark function that uses j_benchmark_get_parameter().
+ * \param parameters     The J_BENCHMARK_SWEEP() bits of the parameters used by the benchmark.
+ **/
+void
+j_benchmark_add_sweep(gchar const* name, BenchmarkFunc benchmark_func, guint parameters)
+{
+	g_return_if_fail(name != NULL);
+	g_return_if_fail(benchmark_func != NULL);
+
+	j_benchmark_add_run(name, benchmark_func, 1, parameters, NULL, NULL);
+}
+
+/**
+ * Adds a sweep benchmark that is passed additional data via run->data.
+ *
+ * \param name           A name.
+ * \param benchmark_func A benchmark function.
+ * \param parameters     The J_BENCHMARK_SWEEP() bits of the parameters used by the benchmark.
+ * \param data           Data that has to stay valid until all benchmarks have run.
+ **/
+void
+j_benchmark_add_data(gchar const* name, BenchmarkFunc benchmark_func, guint parameters, gconstpointer data)
+{
+	g_return_if_fail(name != NULL);
+	g_return_if_fail(benchmark_func != NULL);
+
+	j_benchmark_add_run(name, benchmark_func, 1, parameters, NULL, data);
+}
+
+static void
+j_benchmark_add_threads(gchar const* name, BenchmarkFunc benchmark_func, gchar const* const* classes)
+{
+	for (guint threads = 1; threads <= (guint)opt_threads;)
+	{
+		g_autofree gchar* thread_name = NULL;
+
+		thread_name = g_strdup_printf("%s/%u", name, threads);
+
+		j_benchmark_add_run(thread_name, benchmark_func, threads, 0, classes, NULL);
 
-static JSemantics* j_benchmark_semantics = NULL;
+		if (threads == (guint)opt_threads)
+		{
+			break;
+		}
 
-static GList* j_benchmarks = NULL;
-static gsize j_benchmark_name_max = 0;
+		// Always include the maximum thread count, even if it is not a power of two.
+		threads = MIN(threads * 2, (guint)opt_threads);
+	}
+}
 
-JSemantics*
-j_benchmark_get_semantics(void)
+/**
+ * Adds a benchmark that is run with 1, 2, 4, ... threads up to the number given via --threads.
+ * The thread count is appended to the name.
+ *
+ * \param name           A name.
+ * \param benchmark_func A benchmark function that uses run->threads threads.
+ **/
+void
+j_benchmark_add_scaling(gchar const* name, BenchmarkFunc benchmark_func)
 {
-	return j_semantics_ref(j_benchmark_semantics);
+	g_return_if_fail(name != NULL);
+	g_return_if_fail(benchmark_func != NULL);
+
+	j_benchmark_add_threads(name, benchmark_func, NULL);
 }
 
+/**
+ * Adds a benchmark that additionally reports results per class.
+ * In contrast to j_benchmark_add_workload(), the benchmark is only run once with a single thread.
+ *
+ * \param name           A name.
+ * \param benchmark_func A benchmark function that fills in the classes' operations, bytes and latencies via run->classes.
+ * \param classes        A NULL-terminated array of class names.
+ **/
 void
-j_benchmark_timer_start(BenchmarkRun* run)
+j_benchmark_add_classes(gchar const* name, BenchmarkFunc benchmark_func, gchar const* const* classes)
 {
-	g_return_if_fail(run != NULL);
+	g_return_if_fail(name != NULL);
+	g_return_if_fail(benchmark_func != NULL);
+	g_return_if_fail(classes != NULL);
 
-	if (!run->timer_started)
-	{
-		g_timer_start(run->timer);
-		run->timer_started = TRUE;
-	}
-	else
-	{
-		g_timer_continue(run->timer);
-	}
+	j_benchmark_add_run(name, benchmark_func, 1, 0, classes, NULL);
 }
 
+/**
+ * Adds a scaling benchmark that additionally reports results per operation class.
+ * The benchmark function fills in the classes' operations, bytes and latencies via run->classes.
+ *
+ * \param name           A name.
+ * \param benchmark_func A benchmark function that uses run->threads threads.
+ * \param classes        A NULL-terminated array of class names.
+ **/
 void
-j_benchmark_timer_stop(BenchmarkRun* run)
+j_benchmark_add_workload(gchar const* name, BenchmarkFunc benchmark_func, gchar const* const* classes)
 {
-	g_return_if_fail(run != NULL);
+	g_return_if_fail(name != NULL);
+	g_return_if_fail(benchmark_func != NULL);
+	g_return_if_fail(classes != NULL);
 
-	g_timer_stop(run->timer);
+	j_benchmark_add_threads(name, benchmark_func, classes);
 }
 
-gboolean
-j_benchmark_iterate(BenchmarkRun* run)
+/**
+ * Appends a benchmark's combined results to the JSON results.
+ *
+ * \param run           A benchmark run with combined latencies.
+ * \param elapsed_time  The measured duration.
+ * \param elapsed_total The total duration.
+ * \param operations    The number of operations of all ranks.
+ * \param bytes         The number of bytes of all ranks.
+ **/
+static void
+j_benchmark_json_add(BenchmarkRun* run, gdouble elapsed_time, gdouble elapsed_total, gdouble operations, gdouble bytes)
 {
-	g_return_val_if_fail(run != NULL, FALSE);
+	BenchmarkHistogram const* latencies = run->latencies;
+	bson_t entry;
+	bson_t latency;
+	gchar buffer[16];
+	gchar const* key;
+	gdouble mean = 0.0;
+	gdouble stddev = 0.0;
+
+	if (j_benchmark_json_results == NULL)
+	{
+		return;
+	}
 
-	if (run->iterations == 0 || g_timer_elapsed(run->timer, NULL) < opt_duration)
+	if (latencies->count > 0)
 	{
-		run->iterations++;
+		mean = latencies->sum / latencies->count;
+	}
 
-		return TRUE;
+	if (latencies->count > 1)
+	{
+		gdouble variance;
+
+		variance = (latencies->sum_squares - latencies->sum * mean) / (latencies->count - 1);
+		stddev = sqrt(MAX(variance, 0.0));
 	}
 
-	return FALSE;
+	bson_uint32_to_string(j_benchmark_json_count, &key, buffer, sizeof(buffer));
+	j_benchmark_json_count++;
+
+	bson_append_document_begin(j_benchmark_json_results, key, -1, &entry);
+	bson_append_utf8(&entry, "name", -1, run->name, -1);
+	bson_append_int64(&entry, "iterations", -1, run->iterations);
+	bson_append_double(&entry, "elapsed", -1, elapsed_time);
+	bson_append_double(&entry, "elapsed_total", -1, elapsed_total);
+	bson_append_double(&entry, "operations", -1, operations);
+	bson_append_double(&entry, "bytes", -1, bytes);
+	bson_append_double(&entry, "operations_per_second", -1, (elapsed_time > 0.0) ? operations / elapsed_time : 0.0);
+	bson_append_double(&entry, "bytes_per_second", -1, (elapsed_time > 0.0) ? bytes / elapsed_time : 0.0);
+
+	bson_append_document_begin(&entry, "latency", -1, &latency);
+	bson_append_int64(&latency, "count", -1, latencies->count);
+	bson_append_double(&latency, "mean", -1, mean);
+	bson_append_double(&latency, "stddev", -1, stddev);
+	bson_append_double(&latency, "p50", -1, j_benchmark_histogram_percentile(latencies, 50.0));
+	bson_append_double(&latency, "p90", -1, j_benchmark_histogram_percentile(latencies, 90.0));
+	bson_append_double(&latency, "p99", -1, j_benchmark_histogram_percentile(latencies, 99.0));
+	bson_append_double(&latency, "p999", -1, j_benchmark_histogram_percentile(latencies, 99.9));
+	bson_append_double(&latency, "max", -1, latencies->max);
+	bson_append_document_end(&entry, &latency);
+
+	bson_append_document_end(j_benchmark_json_results, &entry);
 }
 
-void
-j_benchmark_add(gchar const* name, BenchmarkFunc benchmark_func)
+/**
+ * Writes the JSON results together with information about the build, the host and the options.
+ * The format is versioned, fields are only added within a version.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_benchmark_json_write(void)
 {
-	BenchmarkRun* run;
-
-	g_return_if_fail(name != NULL);
-	g_return_if_fail(benchmark_func != NULL);
-
-	if (opt_path != NULL)
+	g_autoptr(GDateTime) now = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar* timestamp = NULL;
+	bson_t root;
+	bson_t build;
+	bson_t host;
+	bson_t options;
+	struct utsname uts;
+	gchar* json;
+	gsize length;
+	gboolean ret;
+
+	now = g_date_time_new_now_utc();
+	timestamp = g_date_time_format(now, "%Y-%m-%dT%H:%M:%SZ");
+
+	bson_init(&root);
+	bson_append_int32(&root, "format", -1, 1);
+	bson_append_utf8(&root, "time", -1, timestamp, -1);
+
+	bson_append_document_begin(&root, "build", -1, &build);
+	bson_append_utf8(&build, "version", -1, JULEA_VERSION, -1);
+	bson_append_utf8(&build, "buildtype", -1, JULEA_BUILDTYPE, -1);
+	bson_append_utf8(&build, "compiler", -1, JULEA_COMPILER, -1);
+#ifdef JULEA_DEBUG
+	bson_append_bool(&build, "debug", -1, TRUE);
+#else
+	bson_append_bool(&build, "debug", -1, FALSE);
+#endif
+#ifdef HAVE_MPI
+	bson_append_bool(&build, "mpi", -1, TRUE);
+#else
+	bson_append_bool(&build, "mpi", -1, FALSE);
+#endif
+	bson_append_document_end(&root, &build);
+
+	bson_append_document_begin(&root, "host", -1, &host);
+	bson_append_utf8(&host, "name", -1, g_get_host_name(), -1);
+	bson_append_int32(&host, "processors", -1, g_get_num_processors());
+
+	if (uname(&uts) == 0)
 	{
-		g_autofree gchar* path_suite = NULL;
-
-		path_suite = g_strconcat(opt_path, "/", NULL);
-
-		if (g_strcmp0(name, opt_path) != 0 && !g_str_has_prefix(name, path_suite))
-		{
-			return;
-		}
+		bson_append_utf8(&host, "system", -1, uts.sysname, -1);
+		bson_append_utf8(&host, "release", -1, uts.release, -1);
+		bson_append_utf8(&host, "machine", -1, uts.machine, -1);
 	}
 
-	j_benchmark_name_max = MAX(j_benchmark_name_max, strlen(name));
+	bson_append_document_end(&root, &host);
 
-	run = g_new(BenchmarkRun, 1);
-	run->name = g_strdup(name);
-	run->func = benchmark_func;
-	run->timer = g_timer_new();
-	run->timer_started = FALSE;
-	run->iterations = 0;
-	run->operations = 0;
-	run->bytes = 0;
+	bson_append_document_begin(&root, "options", -1, &options);
+	bson_append_int32(&options, "duration", -1, opt_duration);
+	bson_append_int32(&options, "ranks", -1, j_benchmark_ranks);
+	bson_append_int32(&options, "threads", -1, opt_threads);
+	bson_append_utf8(&options, "semantics", -1, (opt_semantics != NULL) ? opt_semantics : "", -1);
+	bson_append_utf8(&options, "template", -1, (opt_template != NULL) ? opt_template : "", -1);
+	bson_append_document_end(&root, &options);
 
-	j_benchmarks = g_list_prepend(j_benchmarks, run);
-}
+	bson_append_array(&root, "results", -1, j_benchmark_json_results);
 
-static void
-j_benchmark_run_free(gpointer data)
-{
-	BenchmarkRun* run = data;
+	json = bson_as_relaxed_extended_json(&root, &length);
+	ret = g_file_set_contents(opt_json, json, length, &error);
 
-	g_return_if_fail(data != NULL);
+	bson_free(json);
+	bson_destroy(&root);
 
-	g_timer_destroy(run->timer);
-	g_free(run->name);
-	g_free(run);
+	if (!ret)
+	{
+		g_printerr("Error: %s\n", error->message);
+	}
+
+	return ret;
 }
 
+/**
+ * Prints a value of a benchmark's per-rank rates in human-readable form.
+ *
+ * \param rate  A rate.
+ * \param bytes Whether the rate is given in bytes per second.
+ **/
 static void
-j_benchmark_run_one(BenchmarkRun* run)
+j_benchmark_print_rate(gdouble rate, gboolean bytes)
 {
-	g_autoptr(GTimer) func_timer = NULL;
-	gdouble elapsed_time;
-	gdouble elapsed_total;
-
-	g_return_if_fail(run != NULL);
-
-	if (j_benchmark_name_max == 0)
+	if (bytes)
 	{
-		return;
-	}
+		g_autofree gchar* size = NULL;
 
-	if (opt_list)
+		size = g_format_size((guint64)rate);
+		g_print("%s/s", size);
+	}
+	else
 	{
-		g_print("%s\n", run->name);
-		return;
+		g_print("%.0f/s", rate);
 	}
+}
 
-	func_timer = g_timer_new();
-
-	if (!opt_machine_readable)
+static void
+j_benchmark_print_name(BenchmarkRun* run)
+{
+	if (j_benchmark_rank == 0 && !opt_machine_readable)
 	{
 		g_autofree gchar* left = NULL;
 		gsize pad;
@@ -168,71 +1138,259 @@ j_benchmark_run_one(BenchmarkRun* run)
 			g_print(" ");
 		}
 	}
-	else
+	else if (j_benchmark_rank == 0)
 	{
 		g_print("%s", run->name);
 	}
+}
 
-	g_timer_start(func_timer);
-	(*run->func)(run);
-	elapsed_total = g_timer_elapsed(func_timer, NULL);
+/**
+ * Combines the results of all ranks and prints them.
+ *
+ * \param run    A benchmark run that has finished.
+ * \param result The current rank's result.
+ **/
+static void
+j_benchmark_report(BenchmarkRun* run, BenchmarkResult const* result)
+{
+	g_autofree BenchmarkResult* results = NULL;
+	g_autofree gdouble* rates = NULL;
+	gdouble elapsed_time = 0.0;
+	gdouble elapsed_total = 0.0;
+	gdouble operations = 0.0;
+	gdouble bytes = 0.0;
+	gdouble rate_median = 0.0;
+	gdouble latency_p50;
+	gdouble latency_p90;
+	gdouble latency_p99;
+	gdouble latency_p999;
+	gdouble latency_max = 0.0;
+
+	results = g_new(BenchmarkResult, j_benchmark_ranks);
+	j_benchmark_gather(result, results);
+	j_benchmark_histogram_reduce(run->latencies);
+
+	if (j_benchmark_rank != 0)
+	{
+		return;
+	}
 
-	elapsed_time = g_timer_elapsed(run->timer, NULL);
+	// Ranks run concurrently, so the slowest one determines the aggregate throughput.
+	for (gint i = 0; i < j_benchmark_ranks; i++)
+	{
+		elapsed_time = MAX(elapsed_time, results[i].elapsed);
+		elapsed_total = MAX(elapsed_total, results[i].elapsed_total);
+		operations += results[i].operations;
+		bytes += results[i].bytes;
+		latency_max = MAX(latency_max, results[i].latency_max);
+	}
 
-	if (run->iterations > 1)
+	run->latencies->max = latency_max;
+
+	latency_p50 = j_benchmark_histogram_percentile(run->latencies, 50.0);
+	latency_p90 = j_benchmark_histogram_percentile(run->latencies, 90.0);
+	latency_p99 = j_benchmark_histogram_percentile(run->latencies, 99.0);
+	latency_p999 = j_benchmark_histogram_percentile(run->latencies, 99.9);
+
+	j_benchmark_json_add(run, elapsed_time, elapsed_total, operations, bytes);
+
+	if (j_benchmark_ranks > 1)
 	{
-		run->operations *= run->iterations;
-		run->bytes *= run->iterations;
+		rates = g_new(gdouble, j_benchmark_ranks);
+
+		for (gint i = 0; i < j_benchmark_ranks; i++)
+		{
+			gdouble amount;
+
+			// Compare operations if there are any, bytes otherwise.
+			amount = (operations > 0.0) ? results[i].operations : results[i].bytes;
+			rates[i] = (results[i].elapsed > 0.0) ? amount / results[i].elapsed : 0.0;
+		}
+
+		qsort(rates, j_benchmark_ranks, sizeof(gdouble), j_benchmark_compare_double);
+
+		rate_median = rates[j_benchmark_ranks / 2];
+
+		if (j_benchmark_ranks % 2 == 0)
+		{
+			rate_median = (rates[j_benchmark_ranks / 2 - 1] + rate_median) / 2.0;
+		}
 	}
 
 	if (!opt_machine_readable)
 	{
 		g_print("%.3f seconds", elapsed_time);
 
-		if (run->operations != 0)
+		if (operations > 0.0)
 		{
-			g_print(" (%.0f/s)", (gdouble)run->operations / elapsed_time);
+			g_print(" (%.0f/s)", operations / elapsed_time);
 		}
 
-		if (run->bytes != 0)
+		if (bytes > 0.0)
 		{
 			g_autofree gchar* size = NULL;
 
-			size = g_format_size((gdouble)run->bytes / elapsed_time);
+			size = g_format_size((guint64)(bytes / elapsed_time));
 			g_print(" (%s/s)", size);
 		}
 
-		g_print(" [%.3f seconds]\n", elapsed_total);
+		g_print(" [%.3f seconds]", elapsed_total);
+
+		if (rates != NULL && (operations > 0.0 || bytes > 0.0))
+		{
+			gboolean rate_bytes = !(operations > 0.0);
+
+			g_print(" {");
+			j_benchmark_print_rate(rates[0], rate_bytes);
+			g_print(" ");
+			j_benchmark_print_rate(rate_median, rate_bytes);
+			g_print(" ");
+			j_benchmark_print_rate(rates[j_benchmark_ranks - 1], rate_bytes);
+			g_print("}");
+		}
+
+		if (run->latencies->count > 0)
+		{
+			g_print(" <%.3f ms %.3f ms %.3f ms>", latency_p50 * 1000.0, latency_p99 * 1000.0, latency_max * 1000.0);
+		}
+
+		g_print("\n");
 	}
 	else
 	{
 		g_print("%s%f", opt_machine_separator, elapsed_time);
 
-		if (run->operations != 0)
+		if (operations > 0.0)
 		{
-			g_print("%s%f", opt_machine_separator, (gdouble)run->operations / elapsed_time);
+			g_print("%s%f", opt_machine_separator, operations / elapsed_time);
 		}
 		else
 		{
 			g_print("%s-", opt_machine_separator);
 		}
 
-		if (run->bytes != 0)
+		if (bytes > 0.0)
 		{
-			g_print("%s%f", opt_machine_separator, (gdouble)run->bytes / elapsed_time);
+			g_print("%s%f", opt_machine_separator, bytes / elapsed_time);
 		}
 		else
 		{
 			g_print("%s-", opt_machine_separator);
 		}
 
-		g_print("%s%f\n", opt_machine_separator, elapsed_total);
+		g_print("%s%f", opt_machine_separator, elapsed_total);
+
+		if (rates != NULL)
+		{
+			g_print("%s%d", opt_machine_separator, j_benchmark_ranks);
+
+			if (operations > 0.0 || bytes > 0.0)
+			{
+				g_print("%s%f%s%f%s%f", opt_machine_separator, rates[0], opt_machine_separator, rate_median, opt_machine_separator, rates[j_benchmark_ranks - 1]);
+			}
+			else
+			{
+				g_print("%s-%s-%s-", opt_machine_separator, opt_machine_separator, opt_machine_separator);
+			}
+		}
+
+		if (run->latencies->count > 0)
+		{
+			g_print("%s%f%s%f%s%f%s%f%s%f", opt_machine_separator, latency_p50, opt_machine_separator, latency_p90, opt_machine_separator, latency_p99, opt_machine_separator, latency_p999, opt_machine_separator, latency_max);
+		}
+		else
+		{
+			g_print("%s-%s-%s-%s-%s-", opt_machine_separator, opt_machine_separator, opt_machine_separator, opt_machine_separator, opt_machine_separator);
+		}
+
+		g_print("\n");
+	}
+}
+
+static void
+j_benchmark_run_one(BenchmarkRun* run)
+{
+	g_autoptr(GTimer) func_timer = NULL;
+	BenchmarkResult result;
+
+	g_return_if_fail(run != NULL);
+
+	if (j_benchmark_name_max == 0)
+	{
+		return;
+	}
+
+	if (opt_list)
+	{
+		if (j_benchmark_rank == 0)
+		{
+			g_print("%s\n", run->name);
+
+			for (guint i = 0; i < run->classes->len; i++)
+			{
+				g_print("%s\n", ((BenchmarkRun*)g_ptr_array_index(run->classes, i))->name);
+			}
+		}
+
+		return;
+	}
+
+	func_timer = g_timer_new();
+
+	j_benchmark_print_name(run);
+
+	// All ranks start at the same time, so the servers see their combined load.
+	j_benchmark_barrier();
+
+	j_benchmark_current = run;
+
+	g_timer_start(func_timer);
+	(*run->func)(run);
+	result.elapsed_total = g_timer_elapsed(func_timer, NULL);
+
+	result.elapsed = g_timer_elapsed(run->timer, NULL);
+
+	j_benchmark_current = NULL;
+
+	if (run->iterations > 1)
+	{
+		run->operations *= run->iterations;
+		run->bytes *= run->iterations;
+	}
+
+	result.operations = run->operations;
+	result.bytes = run->bytes;
+
+	// Benchmarks that neither iterate nor record latencies themselves consist of a single iteration.
+	if (run->latencies->count == 0 && run->timer_started)
+	{
+		j_benchmark_add_latency(run, result.elapsed);
 	}
 
+	result.latency_max = run->latencies->max;
+
 	if (run->iterations > 1000 * (guint)opt_duration)
 	{
 		g_warning("Benchmark %s performed %d iteration(s) in a duration of %d second(s), consider adjusting iteration workload.", run->name, run->iterations, opt_duration);
 	}
+
+	j_benchmark_report(run, &result);
+
+	// Classes share their parent's duration, they only differ in what has been counted.
+	for (guint i = 0; i < run->classes->len; i++)
+	{
+		BenchmarkRun* class = g_ptr_array_index(run->classes, i);
+		BenchmarkResult class_result;
+
+		class_result.elapsed = result.elapsed;
+		class_result.elapsed_total = result.elapsed_total;
+		class_result.operations = class->operations;
+		class_result.bytes = class->bytes;
+		class_result.latency_max = class->latencies->max;
+
+		j_benchmark_print_name(class);
+		j_benchmark_report(class, &class_result);
+	}
 }
 
 static void
@@ -245,14 +1403,23 @@ j_benchmark_run_all(void)
 		return;
 	}
 
-	if (!opt_machine_readable)
+	// Only the first rank reports results.
+	if (j_benchmark_rank == 0 && !opt_machine_readable)
 	{
+		g_autoptr(GString) right = NULL;
 		gchar const* left;
-		gchar const* right;
 		gsize pad;
 
 		left = "Name";
-		right = "Duration (Operations/s) (Throughput/s) [Total Duration]";
+		right = g_string_new("Duration (Operations/s) (Throughput/s) [Total Duration]");
+
+		if (j_benchmark_ranks > 1)
+		{
+			g_string_append(right, " {Minimum, Median and Maximum per Rank}");
+		}
+
+		g_string_append(right, " <Latency p50, p99 and Maximum>");
+
 		pad = j_benchmark_name_max + 2 - strlen(left);
 
 		g_print("Name");
@@ -262,18 +1429,27 @@ j_benchmark_run_all(void)
 			g_print(" ");
 		}
 
-		g_print("%s\n", right);
+		g_print("%s\n", right->str);
 
-		for (guint i = 0; i < j_benchmark_name_max + 2 + strlen(right); i++)
+		for (guint i = 0; i < j_benchmark_name_max + 2 + right->len; i++)
 		{
 			g_print("-");
 		}
 
 		g_print("\n");
 	}
-	else
+	else if (j_benchmark_rank == 0)
 	{
-		g_print("name%selapsed%soperations%sbytes%stotal_elapsed\n", opt_machine_separator, opt_machine_separator, opt_machine_separator, opt_machine_separator);
+		g_print("name%selapsed%soperations%sbytes%stotal_elapsed", opt_machine_separator, opt_machine_separator, opt_machine_separator, opt_machine_separator);
+
+		if (j_benchmark_ranks > 1)
+		{
+			g_print("%sranks%srank_min%srank_median%srank_max", opt_machine_separator, opt_machine_separator, opt_machine_separator, opt_machine_separator);
+		}
+
+		g_print("%slatency_p50%slatency_p90%slatency_p99%slatency_p999%slatency_max", opt_machine_separator, opt_machine_separator, opt_machine_separator, opt_machine_separator, opt_machine_separator);
+
+		g_print("\n");
 	}
 
 	j_benchmarks = g_list_reverse(j_benchmarks);
@@ -292,6 +1468,7 @@ main(int argc, char** argv)
 {
 	GError* error = NULL;
 	GOptionContext* context;
+	gint ret = 0;
 
 	GOptionEntry entries[] = {
 		{ "duration", 'd', 0, G_OPTION_ARG_INT, &opt_duration, "Approximate duration in seconds per benchmark", "1" },
@@ -300,7 +1477,17 @@ main(int argc, char** argv)
 		{ "machine-separator", 0, 0, G_OPTION_ARG_STRING, &opt_machine_separator, "Separator for machine-readable output", "\\t" },
 		{ "path", 'p', 0, G_OPTION_ARG_STRING, &opt_path, "Benchmark path to use", NULL },
 		{ "semantics", 's', 0, G_OPTION_ARG_STRING, &opt_semantics, "Semantics to use", NULL },
-		{ "template", 't', 0, G_OPTION_ARG_STRING, &opt_template, "Semantics template to use", NULL },
+		{ "template", 't', 0, G_OPTION_ARG_STRING, &opt_template, "Semantics templates to use, separated by commas", NULL },
+		{ "threads", 0, 0, G_OPTION_ARG_INT, &opt_threads, "Maximum number of threads for scaling benchmarks", "number of processors" },
+		{ "block-sizes", 0, 0, G_OPTION_ARG_STRING, &opt_block_sizes, "Block sizes to sweep", "4K,64K-1M" },
+		{ "batch-sizes", 0, 0, G_OPTION_ARG_STRING, &opt_batch_sizes, "Batch sizes to sweep", "1-1K" },
+		{ "value-sizes", 0, 0, G_OPTION_ARG_STRING, &opt_value_sizes, "KV value sizes to sweep", "8-4K" },
+		{ "stripe-sizes", 0, 0, G_OPTION_ARG_STRING, &opt_stripe_sizes, "Distribution stripe sizes to sweep", "64K-4M" },
+		{ "distributions", 0, 0, G_OPTION_ARG_STRING, &opt_distributions, "Distributions to sweep", "round-robin,single-server,weighted" },
+		{ "workload", 0, 0, G_OPTION_ARG_STRING, &opt_workload, "Mix of operation classes for workload benchmarks", "object-read=70:4K-1M,object-write=20:4K-1M,object-status=10" },
+		{ "workload-trace", 0, 0, G_OPTION_ARG_FILENAME, &opt_workload_trace, "Trace recorded with JULEA_TRACE=echo to replay", NULL },
+		{ "json", 0, 0, G_OPTION_ARG_FILENAME, &opt_json, "Write results including build and host information to a JSON file", NULL },
+		{ "backend", 0, 0, G_OPTION_ARG_STRING_ARRAY, &opt_backends, "Backend to benchmark in-process, can be given multiple times", "TYPE:NAME[:COMPONENT[:PATH]]" },
 		{ NULL, 0, 0, 0, NULL, NULL, NULL }
 	};
 
@@ -332,12 +1519,53 @@ main(int argc, char** argv)
 		return 1;
 	}
 
+	if (opt_threads < 0)
+	{
+		g_printerr("Error: Number of threads has to be greater than 0\n");
+
+		return 1;
+	}
+
+	if (opt_threads == 0)
+	{
+		opt_threads = g_get_num_processors();
+	}
+
+	if (!j_benchmark_parse_sweeps())
+	{
+		return 1;
+	}
+
 	if (opt_machine_separator == NULL)
 	{
 		opt_machine_separator = g_strdup("\t");
 	}
 
-	j_benchmark_semantics = j_semantics_new_from_string(opt_template, opt_semantics);
+#ifdef HAVE_MPI
+	MPI_Init(&argc, &argv);
+	MPI_Comm_rank(MPI_COMM_WORLD, &j_benchmark_rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &j_benchmark_ranks);
+#endif
+
+	// Ranks use separate namespaces to avoid interfering with each other.
+	j_benchmark_namespace = (j_benchmark_ranks > 1) ? g_strdup_printf("benchmark-%d", j_benchmark_rank) : g_strdup("benchmark");
+
+	j_benchmark_semantics = g_ptr_array_new_with_free_func((GDestroyNotify)j_semantics_unref);
+
+	if (opt_template != NULL)
+	{
+		j_benchmark_templates = g_strsplit(opt_template, ",", 0);
+
+		for (guint i = 0; j_benchmark_templates[i] != NULL; i++)
+		{
+			g_ptr_array_add(j_benchmark_semantics, j_semantics_new_from_string(j_benchmark_templates[i], opt_semantics));
+		}
+	}
+
+	if (j_benchmark_semantics->len == 0)
+	{
+		g_ptr_array_add(j_benchmark_semantics, j_semantics_new_from_string(NULL, opt_semantics));
+	}
 
 	// Core
 	benchmark_background_operation();
@@ -355,6 +1583,7 @@ main(int argc, char** argv)
 	// DB client
 	benchmark_db_entry();
 	benchmark_db_iterator();
+	benchmark_db_query();
 	benchmark_db_schema();
 
 	// Item client
@@ -365,14 +1594,62 @@ main(int argc, char** argv)
 	benchmark_hdf();
 	benchmark_hdf_dai();
 
+	// FUSE file system
+	benchmark_fuse();
+
+	// Multi-threaded clients
+	benchmark_scaling();
+	benchmark_workload();
+
+	// Backends
+	benchmark_backend();
+
+	if (opt_json != NULL && !opt_list && j_benchmark_rank == 0)
+	{
+		j_benchmark_json_results = bson_new();
+	}
+
 	j_benchmark_run_all();
 
-	j_semantics_unref(j_benchmark_semantics);
+	if (j_benchmark_json_results != NULL)
+	{
+		if (!j_benchmark_json_write())
+		{
+			ret = 1;
+		}
+
+		bson_destroy(j_benchmark_json_results);
+	}
+
+	g_ptr_array_unref(j_benchmark_semantics);
+	g_strfreev(j_benchmark_templates);
+
+	for (guint i = 0; i < J_BENCHMARK_PARAMETERS; i++)
+	{
+		if (j_benchmark_sweeps[i] != NULL)
+		{
+			g_array_unref(j_benchmark_sweeps[i]);
+		}
+	}
+
+#ifdef HAVE_MPI
+	MPI_Finalize();
+#endif
 
+	g_free(j_benchmark_namespace);
 	g_free(opt_machine_separator);
 	g_free(opt_path);
 	g_free(opt_semantics);
 	g_free(opt_template);
-
-	return 0;
+	g_free(opt_block_sizes);
+	g_free(opt_batch_sizes);
+	g_free(opt_value_sizes);
+	g_free(opt_stripe_sizes);
+	g_free(opt_distributions);
+	g_free(opt_workload);
+	g_free(opt_workload_trace);
+	g_strfreev(opt_backends);
+	g_free(opt_json);
+
+	return ret;
 }
@@ -21,6 +21,26 @@
 
 #include <glib.h>
 
+/**
+ * Parameters that can be swept via the command line.
+ **/
+enum BenchmarkParameter
+{
+	J_BENCHMARK_PARAMETER_BLOCK_SIZE,
+	J_BENCHMARK_PARAMETER_BATCH_SIZE,
+	J_BENCHMARK_PARAMETER_VALUE_SIZE,
+	J_BENCHMARK_PARAMETER_STRIPE_SIZE,
+	J_BENCHMARK_PARAMETER_DISTRIBUTION,
+	J_BENCHMARK_PARAMETERS
+};
+
+typedef enum BenchmarkParameter BenchmarkParameter;
+
+#define J_BENCHMARK_SWEEP(parameter) (1 << (parameter))
+
+struct BenchmarkHistogram;
+struct JSemantics;
+
 struct BenchmarkRun
 {
 	gchar* name;
@@ -30,27 +50,76 @@ struct BenchmarkRun
 	guint iterations;
 	guint64 operations;
 	guint64 bytes;
+
+	/**
+	 * The number of concurrent threads, only used by scaling benchmarks.
+	 **/
+	guint threads;
+
+	/**
+	 * Per-iteration latencies, see j_benchmark_add_latency().
+	 **/
+	struct BenchmarkHistogram* latencies;
+	gdouble iteration_elapsed;
+
+	/**
+	 * The values of swept parameters, only valid if the parameter's J_BENCHMARK_SWEEP() bit is set in parameters_set.
+	 **/
+	guint64 parameters[J_BENCHMARK_PARAMETERS];
+	guint parameters_set;
+
+	struct JSemantics* semantics;
+
+	/**
+	 * Per-class results of mixed workloads, see j_benchmark_add_workload().
+	 **/
+	GPtrArray* classes;
+
+	/**
+	 * Benchmark-specific data, see j_benchmark_add_data().
+	 **/
+	gconstpointer data;
 };
 
 typedef struct BenchmarkRun BenchmarkRun;
 
+#include <jdistribution.h>
 #include <jsemantics.h>
 
 typedef void (*BenchmarkFunc)(BenchmarkRun*);
 
 JSemantics* j_benchmark_get_semantics(void);
+gchar const* j_benchmark_get_namespace(void);
+gint j_benchmark_get_duration(void);
+gchar const* j_benchmark_get_workload(void);
+gchar const* j_benchmark_get_workload_trace(void);
+gchar const* const* j_benchmark_get_backends(void);
+
+GArray* j_benchmark_parse_sizes(gchar const*);
+
+guint64 j_benchmark_get_parameter(BenchmarkRun*, BenchmarkParameter, guint64);
+JDistribution* j_benchmark_get_distribution(BenchmarkRun*);
 
 void j_benchmark_timer_start(BenchmarkRun*);
 void j_benchmark_timer_stop(BenchmarkRun*);
 
 gboolean j_benchmark_iterate(BenchmarkRun*);
 
+void j_benchmark_add_latency(BenchmarkRun*, gdouble);
+
 void j_benchmark_add(gchar const*, BenchmarkFunc);
+void j_benchmark_add_scaling(gchar const*, BenchmarkFunc);
+void j_benchmark_add_sweep(gchar const*, BenchmarkFunc, guint);
+void j_benchmark_add_data(gchar const*, BenchmarkFunc, guint, gconstpointer);
+void j_benchmark_add_classes(gchar const*, BenchmarkFunc, gchar const* const*);
+void j_benchmark_add_workload(gchar const*, BenchmarkFunc, gchar const* const*);
 
 void benchmark_background_operation(void);
 void benchmark_cache(void);
 void benchmark_memory_chunk(void);
 void benchmark_message(void);
+void benchmark_scaling(void);
+void benchmark_workload(void);
 
 void benchmark_kv(void);
 
@@ -59,12 +128,17 @@ void benchmark_object(void);
 
 void benchmark_db_entry(void);
 void benchmark_db_iterator(void);
+void benchmark_db_query(void);
 void benchmark_db_schema(void);
 
 void benchmark_collection(void);
 void benchmark_item(void);
 
+void benchmark_fuse(void);
+
 void benchmark_hdf(void);
 void benchmark_hdf_dai(void);
 
+void benchmark_backend(void);
+
 #endif
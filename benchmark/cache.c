@@ -44,7 +44,7 @@ benchmark_cache_get_release(BenchmarkRun* run)
 			gpointer buf;
 
 			buf = j_cache_get(cache, 1);
-			j_cache_release(cache, buf);
+			j_cache_release(cache, buf, 1);
 		}
 	}
 
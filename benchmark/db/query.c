@@ -0,0 +1,507 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2017-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <julea.h>
+#include <julea-db.h>
+
+#include "benchmark.h"
+
+/**
+ * The number of rows used by the selector benchmarks.
+ * It is a multiple of QUERY_BUCKETS, so every bucket contains the same number of rows.
+ **/
+#define QUERY_ROWS (100 * 1024)
+
+/**
+ * The number of rows used by the large result set benchmark.
+ **/
+#define QUERY_ROWS_LARGE (1 << 20)
+
+/**
+ * The number of rows inserted per batch.
+ **/
+#define QUERY_INSERT_BATCH 10000
+
+/**
+ * The number of distinct buckets, each one contains 1% of the rows.
+ **/
+#define QUERY_BUCKETS 100
+
+/**
+ * The number of float columns in addition to key, bucket and name.
+ **/
+#define QUERY_VALUES 12
+
+/**
+ * The number of conditions combined by OR selectors.
+ **/
+#define QUERY_OR_TERMS 16
+
+/**
+ * Scatters the buckets across the keys, coprime to QUERY_BUCKETS.
+ **/
+#define QUERY_PRIME 11971
+
+enum QueryKind
+{
+	QUERY_KIND_OR,
+	QUERY_KIND_NESTED,
+	QUERY_KIND_SELECTIVITY,
+	QUERY_KIND_SCAN,
+	QUERY_KIND_PROJECTION,
+	QUERY_KIND_PROJECTION_ALL
+};
+
+typedef enum QueryKind QueryKind;
+
+static gchar const* const query_classes[] = { "first-row", NULL };
+
+static gchar const* query_projection[] = { "key", "name", NULL };
+
+static guint64
+query_get_bucket(guint64 key)
+{
+	return (key * QUERY_PRIME) % QUERY_BUCKETS;
+}
+
+static gchar*
+query_get_name(guint64 key)
+{
+	return g_strdup_printf("benchmark-%" G_GUINT64_FORMAT, key);
+}
+
+/**
+ * Creates a table with QUERY_VALUES + 3 columns and fills it with the given number of rows.
+ * key is unique, bucket is key-dependent but scattered and name is derived from key.
+ *
+ * \param namespace    A namespace.
+ * \param rows         The number of rows.
+ * \param delete_batch A batch that deletes the table.
+ *
+ * \return The table's schema.
+ **/
+static JDBSchema*
+query_prepare(gchar const* namespace, guint rows, JBatch* delete_batch)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autoptr(JDBSchema) schema = NULL;
+	gchar const* index[2] = { NULL, NULL };
+	gboolean ret;
+
+	semantics = j_benchmark_get_semantics();
+	batch = j_batch_new(semantics);
+
+	schema = j_db_schema_new(namespace, "table", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "key", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "bucket", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "name", J_DB_TYPE_STRING, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	for (guint i = 0; i < QUERY_VALUES; i++)
+	{
+		g_autofree gchar* field = NULL;
+
+		field = g_strdup_printf("value-%u", i);
+		ret = j_db_schema_add_field(schema, field, J_DB_TYPE_FLOAT64, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+	}
+
+	index[0] = "key";
+	ret = j_db_schema_add_index(schema, index, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	index[0] = "bucket";
+	ret = j_db_schema_add_index(schema, index, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+	ret = j_db_schema_delete(schema, delete_batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint64 i = 0; i < rows; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+		g_autofree gchar* name = NULL;
+		guint64 bucket;
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		name = query_get_name(i);
+		bucket = query_get_bucket(i);
+
+		ret = j_db_entry_set_field(entry, "key", &i, 0, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "bucket", &bucket, 0, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "name", name, 0, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		for (guint j = 0; j < QUERY_VALUES; j++)
+		{
+			g_autofree gchar* field = NULL;
+			gdouble value = i * (j + 1);
+
+			field = g_strdup_printf("value-%u", j);
+			ret = j_db_entry_set_field(entry, field, &value, 0, &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+		}
+
+		ret = j_db_entry_insert(entry, batch, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// Keep batches small enough to not build up huge messages.
+		if ((i + 1) % QUERY_INSERT_BATCH == 0 || i + 1 == rows)
+		{
+			ret = j_batch_execute(batch);
+			g_assert_true(ret);
+		}
+	}
+
+	return g_steal_pointer(&schema);
+}
+
+static void
+query_add_condition(JDBSelector* selector, gchar const* field, JDBSelectorOperator operator_, guint64 value)
+{
+	g_autoptr(GError) error = NULL;
+	gboolean ret;
+
+	ret = j_db_selector_add_field(selector, field, operator_, &value, 0, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+}
+
+static void
+query_add_selector(JDBSelector* selector, JDBSelector* sub_selector)
+{
+	g_autoptr(GError) error = NULL;
+	gboolean ret;
+
+	ret = j_db_selector_add_selector(selector, sub_selector, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+}
+
+/**
+ * Builds the selector of a query.
+ *
+ * \param schema    A schema.
+ * \param kind      The kind of query.
+ * \param query     The query's number, used to vary the selected rows.
+ * \param parameter The percentage of selected buckets for QUERY_KIND_SELECTIVITY.
+ * \param rows      Returns the number of rows the selector matches, 0 if it is not known exactly.
+ *
+ * \return The selector, NULL to select all rows.
+ **/
+static JDBSelector*
+query_get_selector(JDBSchema* schema, QueryKind kind, guint query, guint parameter, guint* rows)
+{
+	g_autoptr(GError) error = NULL;
+	JDBSelector* selector = NULL;
+
+	*rows = 0;
+
+	switch (kind)
+	{
+		case QUERY_KIND_OR:
+			// Point lookups of keys that are spread across the whole table.
+			selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_OR, &error);
+			g_assert_no_error(error);
+
+			for (guint i = 0; i < QUERY_OR_TERMS; i++)
+			{
+				query_add_condition(selector, "key", J_DB_SELECTOR_OPERATOR_EQ, (((guint64)query * QUERY_OR_TERMS + i) * QUERY_PRIME) % QUERY_ROWS);
+			}
+
+			*rows = QUERY_OR_TERMS;
+			break;
+		case QUERY_KIND_NESTED:
+		{
+			g_autoptr(JDBSelector) any = NULL;
+			g_autoptr(JDBSelector) low = NULL;
+			g_autoptr(JDBSelector) middle = NULL;
+			guint64 bucket = query % QUERY_BUCKETS;
+
+			// bucket = g AND (key < ROWS / 4 OR (key >= ROWS / 2 AND key < ROWS / 2 + ROWS / 8))
+			selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+			g_assert_no_error(error);
+			query_add_condition(selector, "bucket", J_DB_SELECTOR_OPERATOR_EQ, bucket);
+
+			low = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+			g_assert_no_error(error);
+			query_add_condition(low, "key", J_DB_SELECTOR_OPERATOR_LT, QUERY_ROWS / 4);
+
+			middle = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+			g_assert_no_error(error);
+			query_add_condition(middle, "key", J_DB_SELECTOR_OPERATOR_GE, QUERY_ROWS / 2);
+			query_add_condition(middle, "key", J_DB_SELECTOR_OPERATOR_LT, QUERY_ROWS / 2 + QUERY_ROWS / 8);
+
+			any = j_db_selector_new(schema, J_DB_SELECTOR_MODE_OR, &error);
+			g_assert_no_error(error);
+			query_add_selector(any, low);
+			query_add_selector(any, middle);
+
+			query_add_selector(selector, any);
+		}
+		break;
+		case QUERY_KIND_SELECTIVITY:
+		case QUERY_KIND_PROJECTION:
+		case QUERY_KIND_PROJECTION_ALL:
+		{
+			guint64 buckets = (kind == QUERY_KIND_SELECTIVITY) ? QUERY_BUCKETS * parameter / 100 : QUERY_BUCKETS / 10;
+			guint64 first = (query * buckets) % (QUERY_BUCKETS - buckets + 1);
+
+			selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+			g_assert_no_error(error);
+			query_add_condition(selector, "bucket", J_DB_SELECTOR_OPERATOR_GE, first);
+			query_add_condition(selector, "bucket", J_DB_SELECTOR_OPERATOR_LT, first + buckets);
+
+			*rows = QUERY_ROWS / QUERY_BUCKETS * buckets;
+		}
+		break;
+		case QUERY_KIND_SCAN:
+			*rows = QUERY_ROWS_LARGE;
+			break;
+		default:
+			g_assert_not_reached();
+	}
+
+	return selector;
+}
+
+/**
+ * Runs queries and reads the selected fields of all resulting rows.
+ * Reports rows per second for the run and the time until the first row is available for its first-row class.
+ *
+ * \param run       A benchmark run.
+ * \param namespace A namespace.
+ * \param kind      The kind of query.
+ * \param parameter A kind-specific parameter.
+ **/
+static void
+_benchmark_db_query(BenchmarkRun* run, gchar const* namespace, QueryKind kind, guint parameter)
+{
+	guint const table_rows = (kind == QUERY_KIND_SCAN) ? QUERY_ROWS_LARGE : QUERY_ROWS;
+	guint const queries = (kind == QUERY_KIND_OR || kind == QUERY_KIND_NESTED) ? 64 : 1;
+
+	g_autoptr(JBatch) delete_batch = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autoptr(JDBSchema) schema = NULL;
+	g_autoptr(GTimer) first_row_timer = NULL;
+	g_autoptr(GPtrArray) fields = NULL;
+	BenchmarkRun* first_row;
+	guint64 rows = 0;
+	gboolean ret;
+
+	semantics = j_benchmark_get_semantics();
+	delete_batch = j_batch_new(semantics);
+
+	schema = query_prepare(namespace, table_rows, delete_batch);
+
+	first_row = g_ptr_array_index(run->classes, 0);
+	first_row_timer = g_timer_new();
+
+	// Projections only read the fields they retrieved, all other queries read every field.
+	fields = g_ptr_array_new_with_free_func(g_free);
+
+	if (kind == QUERY_KIND_PROJECTION || kind == QUERY_KIND_SCAN)
+	{
+		for (guint i = 0; query_projection[i] != NULL; i++)
+		{
+			g_ptr_array_add(fields, g_strdup(query_projection[i]));
+		}
+	}
+	else
+	{
+		g_ptr_array_add(fields, g_strdup("key"));
+		g_ptr_array_add(fields, g_strdup("bucket"));
+		g_ptr_array_add(fields, g_strdup("name"));
+
+		for (guint i = 0; i < QUERY_VALUES; i++)
+		{
+			g_ptr_array_add(fields, g_strdup_printf("value-%u", i));
+		}
+	}
+
+	while (j_benchmark_iterate(run))
+	{
+		for (guint i = 0; i < queries; i++)
+		{
+			g_autoptr(GError) error = NULL;
+			g_autoptr(JDBIterator) iterator = NULL;
+			g_autoptr(JDBSelector) selector = NULL;
+			guint expected_rows;
+			guint count = 0;
+
+			selector = query_get_selector(schema, kind, run->iterations * queries + i, parameter, &expected_rows);
+
+			j_benchmark_timer_start(run);
+			g_timer_start(first_row_timer);
+
+			if (kind == QUERY_KIND_PROJECTION || kind == QUERY_KIND_SCAN)
+			{
+				iterator = j_db_iterator_new_for_fields(schema, selector, query_projection, &error);
+			}
+			else
+			{
+				iterator = j_db_iterator_new(schema, selector, &error);
+			}
+
+			g_assert_nonnull(iterator);
+			g_assert_no_error(error);
+
+			while (j_db_iterator_next(iterator, NULL))
+			{
+				if (count == 0)
+				{
+					j_benchmark_add_latency(first_row, g_timer_elapsed(first_row_timer, NULL));
+				}
+
+				for (guint j = 0; j < fields->len; j++)
+				{
+					g_autofree gpointer value = NULL;
+					JDBType type;
+					guint64 length;
+
+					ret = j_db_iterator_get_field(iterator, g_ptr_array_index(fields, j), &type, &value, &length, &error);
+					g_assert_true(ret);
+					g_assert_no_error(error);
+				}
+
+				count++;
+			}
+
+			j_benchmark_timer_stop(run);
+
+			if (expected_rows > 0)
+			{
+				g_assert_cmpuint(count, ==, expected_rows);
+			}
+			else
+			{
+				g_assert_cmpuint(count, >, 0);
+			}
+
+			rows += count;
+			first_row->operations++;
+		}
+	}
+
+	ret = j_batch_execute(delete_batch);
+	g_assert_true(ret);
+
+	// Result sizes can differ between queries, so the average number of rows per iteration is reported.
+	run->operations = rows / run->iterations;
+}
+
+static void
+benchmark_db_query_or(BenchmarkRun* run)
+{
+	_benchmark_db_query(run, "benchmark_query_or", QUERY_KIND_OR, 0);
+}
+
+static void
+benchmark_db_query_nested(BenchmarkRun* run)
+{
+	_benchmark_db_query(run, "benchmark_query_nested", QUERY_KIND_NESTED, 0);
+}
+
+static void
+benchmark_db_query_selectivity_1(BenchmarkRun* run)
+{
+	_benchmark_db_query(run, "benchmark_query_selectivity_1", QUERY_KIND_SELECTIVITY, 1);
+}
+
+static void
+benchmark_db_query_selectivity_10(BenchmarkRun* run)
+{
+	_benchmark_db_query(run, "benchmark_query_selectivity_10", QUERY_KIND_SELECTIVITY, 10);
+}
+
+static void
+benchmark_db_query_selectivity_100(BenchmarkRun* run)
+{
+	_benchmark_db_query(run, "benchmark_query_selectivity_100", QUERY_KIND_SELECTIVITY, 100);
+}
+
+static void
+benchmark_db_query_large(BenchmarkRun* run)
+{
+	_benchmark_db_query(run, "benchmark_query_large", QUERY_KIND_SCAN, 0);
+}
+
+static void
+benchmark_db_query_projection(BenchmarkRun* run)
+{
+	_benchmark_db_query(run, "benchmark_query_projection", QUERY_KIND_PROJECTION, 0);
+}
+
+static void
+benchmark_db_query_projection_all(BenchmarkRun* run)
+{
+	_benchmark_db_query(run, "benchmark_query_projection_all", QUERY_KIND_PROJECTION_ALL, 0);
+}
+
+void
+benchmark_db_query(void)
+{
+	j_benchmark_add_classes("/db/query/or", benchmark_db_query_or, query_classes);
+	j_benchmark_add_classes("/db/query/nested", benchmark_db_query_nested, query_classes);
+	j_benchmark_add_classes("/db/query/selectivity-1", benchmark_db_query_selectivity_1, query_classes);
+	j_benchmark_add_classes("/db/query/selectivity-10", benchmark_db_query_selectivity_10, query_classes);
+	j_benchmark_add_classes("/db/query/selectivity-100", benchmark_db_query_selectivity_100, query_classes);
+	j_benchmark_add_classes("/db/query/large", benchmark_db_query_large, query_classes);
+	j_benchmark_add_classes("/db/query/projection", benchmark_db_query_projection, query_classes);
+	j_benchmark_add_classes("/db/query/projection-all", benchmark_db_query_projection_all, query_classes);
+}
@@ -0,0 +1,760 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Benchmarks the FUSE file system by calling its callbacks directly.
+ * This measures everything julea-fuse does itself without requiring a mount or going through the kernel.
+ **/
+
+#include <julea-config.h>
+
+#ifdef HAVE_FUSE
+#include "julea-fuse.h"
+#endif
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <julea.h>
+
+#include "benchmark.h"
+
+#ifdef HAVE_FUSE
+
+/**
+ * The directory all benchmark files are created in.
+ **/
+#define FUSE_BENCHMARK_DIR "/benchmark-fuse"
+
+/**
+ * The size of a single read or write in the scaling benchmarks.
+ **/
+#define FUSE_SCALING_BLOCK_SIZE (4 * 1024)
+
+/**
+ * The number of blocks per file in the scaling benchmarks, reads and writes wrap around afterwards.
+ **/
+#define FUSE_SCALING_BLOCKS 256
+
+static void
+fuse_benchmark_init(void)
+{
+	struct fuse_conn_info conn;
+	gint ret;
+
+	memset(&conn, 0, sizeof(conn));
+	jfs_init(&conn);
+
+	ret = jfs_mkdir(FUSE_BENCHMARK_DIR, 0755);
+	g_assert_cmpint(ret, ==, 0);
+}
+
+static void
+fuse_benchmark_fini(void)
+{
+	gint ret;
+
+	ret = jfs_rmdir(FUSE_BENCHMARK_DIR);
+	g_assert_cmpint(ret, ==, 0);
+
+	jfs_destroy(NULL);
+}
+
+static gchar*
+fuse_benchmark_path(gchar const* name, guint i)
+{
+	return g_strdup_printf("%s/%s-%u", FUSE_BENCHMARK_DIR, name, i);
+}
+
+static void
+fuse_benchmark_create(gchar const* path)
+{
+	struct fuse_file_info fi;
+	gint ret;
+
+	memset(&fi, 0, sizeof(fi));
+
+	ret = jfs_create(path, 0644, &fi);
+	g_assert_cmpint(ret, ==, 0);
+	ret = jfs_release(path, &fi);
+	g_assert_cmpint(ret, ==, 0);
+}
+
+static void
+fuse_benchmark_unlink(gchar const* path)
+{
+	gint ret;
+
+	ret = jfs_unlink(path);
+	g_assert_cmpint(ret, ==, 0);
+}
+
+/**
+ * Returns the offsets of n blocks, either in ascending or in random order.
+ * Random orders are seeded identically for each run, so that results are comparable.
+ *
+ * \param n          The number of blocks.
+ * \param block_size The size of a block.
+ * \param shuffle    Whether to shuffle the offsets.
+ *
+ * \return The offsets, to be freed with g_free().
+ **/
+static guint64*
+fuse_benchmark_offsets(guint n, guint64 block_size, gboolean shuffle)
+{
+	g_autoptr(GRand) rng = NULL;
+	guint64* offsets;
+
+	offsets = g_new(guint64, n);
+	rng = g_rand_new_with_seed(42);
+
+	for (guint i = 0; i < n; i++)
+	{
+		offsets[i] = i * block_size;
+	}
+
+	for (guint i = n; shuffle && i > 1; i--)
+	{
+		guint j;
+		guint64 tmp;
+
+		j = g_rand_int_range(rng, 0, i);
+		tmp = offsets[i - 1];
+		offsets[i - 1] = offsets[j];
+		offsets[j] = tmp;
+	}
+
+	return offsets;
+}
+
+static void
+_benchmark_fuse_write(BenchmarkRun* run, gboolean use_random)
+{
+	guint const n = 1000;
+	guint64 const block_size = j_benchmark_get_parameter(run, J_BENCHMARK_PARAMETER_BLOCK_SIZE, 4 * 1024);
+
+	g_autofree gchar* path = NULL;
+	g_autofree gchar* dummy = NULL;
+	g_autofree guint64* offsets = NULL;
+	struct fuse_file_info fi;
+	gint ret;
+
+	fuse_benchmark_init();
+
+	path = fuse_benchmark_path("write", 0);
+	dummy = g_malloc0(block_size);
+	offsets = fuse_benchmark_offsets(n, block_size, use_random);
+
+	memset(&fi, 0, sizeof(fi));
+
+	ret = jfs_create(path, 0644, &fi);
+	g_assert_cmpint(ret, ==, 0);
+
+	j_benchmark_timer_start(run);
+
+	while (j_benchmark_iterate(run))
+	{
+		for (guint i = 0; i < n; i++)
+		{
+			ret = jfs_write(path, dummy, block_size, offsets[i], &fi);
+			g_assert_cmpint(ret, ==, block_size);
+		}
+
+		// Writes happen in the background, only flushing guarantees that they have finished
+		ret = jfs_flush(path, &fi);
+		g_assert_cmpint(ret, ==, 0);
+	}
+
+	j_benchmark_timer_stop(run);
+
+	ret = jfs_release(path, &fi);
+	g_assert_cmpint(ret, ==, 0);
+
+	fuse_benchmark_unlink(path);
+	fuse_benchmark_fini();
+
+	run->operations = n;
+	run->bytes = n * block_size;
+}
+
+static void
+benchmark_fuse_write(BenchmarkRun* run)
+{
+	_benchmark_fuse_write(run, FALSE);
+}
+
+static void
+benchmark_fuse_write_random(BenchmarkRun* run)
+{
+	_benchmark_fuse_write(run, TRUE);
+}
+
+static void
+_benchmark_fuse_read(BenchmarkRun* run, gboolean use_random)
+{
+	guint const n = 1000;
+	guint64 const block_size = j_benchmark_get_parameter(run, J_BENCHMARK_PARAMETER_BLOCK_SIZE, 4 * 1024);
+
+	g_autofree gchar* path = NULL;
+	g_autofree gchar* dummy = NULL;
+	g_autofree guint64* offsets = NULL;
+	struct fuse_file_info fi;
+	gint ret;
+
+	fuse_benchmark_init();
+
+	path = fuse_benchmark_path("read", 0);
+	dummy = g_malloc0(block_size);
+	offsets = fuse_benchmark_offsets(n, block_size, use_random);
+
+	memset(&fi, 0, sizeof(fi));
+
+	ret = jfs_create(path, 0644, &fi);
+	g_assert_cmpint(ret, ==, 0);
+
+	for (guint i = 0; i < n; i++)
+	{
+		ret = jfs_write(path, dummy, block_size, i * block_size, &fi);
+		g_assert_cmpint(ret, ==, block_size);
+	}
+
+	ret = jfs_release(path, &fi);
+	g_assert_cmpint(ret, ==, 0);
+
+	memset(&fi, 0, sizeof(fi));
+
+	ret = jfs_open(path, &fi);
+	g_assert_cmpint(ret, ==, 0);
+
+	j_benchmark_timer_start(run);
+
+	while (j_benchmark_iterate(run))
+	{
+		for (guint i = 0; i < n; i++)
+		{
+			ret = jfs_read(path, dummy, block_size, offsets[i], &fi);
+			g_assert_cmpint(ret, ==, block_size);
+		}
+	}
+
+	j_benchmark_timer_stop(run);
+
+	ret = jfs_release(path, &fi);
+	g_assert_cmpint(ret, ==, 0);
+
+	fuse_benchmark_unlink(path);
+	fuse_benchmark_fini();
+
+	run->operations = n;
+	run->bytes = n * block_size;
+}
+
+static void
+benchmark_fuse_read(BenchmarkRun* run)
+{
+	_benchmark_fuse_read(run, FALSE);
+}
+
+static void
+benchmark_fuse_read_random(BenchmarkRun* run)
+{
+	_benchmark_fuse_read(run, TRUE);
+}
+
+static void
+benchmark_fuse_create(BenchmarkRun* run)
+{
+	guint const n = 1000;
+
+	fuse_benchmark_init();
+
+	while (j_benchmark_iterate(run))
+	{
+		j_benchmark_timer_start(run);
+
+		for (guint i = 0; i < n; i++)
+		{
+			g_autofree gchar* path = NULL;
+
+			path = fuse_benchmark_path("create", i);
+			fuse_benchmark_create(path);
+		}
+
+		j_benchmark_timer_stop(run);
+
+		for (guint i = 0; i < n; i++)
+		{
+			g_autofree gchar* path = NULL;
+
+			path = fuse_benchmark_path("create", i);
+			fuse_benchmark_unlink(path);
+		}
+	}
+
+	fuse_benchmark_fini();
+
+	run->operations = n;
+}
+
+static void
+benchmark_fuse_stat(BenchmarkRun* run)
+{
+	guint const n = 1000;
+
+	fuse_benchmark_init();
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autofree gchar* path = NULL;
+
+		path = fuse_benchmark_path("stat", i);
+		fuse_benchmark_create(path);
+	}
+
+	j_benchmark_timer_start(run);
+
+	while (j_benchmark_iterate(run))
+	{
+		for (guint i = 0; i < n; i++)
+		{
+			g_autofree gchar* path = NULL;
+			struct stat stbuf;
+			gint ret;
+
+			path = fuse_benchmark_path("stat", i);
+			ret = jfs_getattr(path, &stbuf);
+			g_assert_cmpint(ret, ==, 0);
+		}
+	}
+
+	j_benchmark_timer_stop(run);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autofree gchar* path = NULL;
+
+		path = fuse_benchmark_path("stat", i);
+		fuse_benchmark_unlink(path);
+	}
+
+	fuse_benchmark_fini();
+
+	run->operations = n;
+}
+
+static int
+fuse_benchmark_filler(void* buf, char const* name, struct stat const* stbuf, off_t offset)
+{
+	guint* entries = buf;
+
+	(void)name;
+	(void)stbuf;
+	(void)offset;
+
+	(*entries)++;
+
+	return 0;
+}
+
+static void
+benchmark_fuse_readdir(BenchmarkRun* run)
+{
+	guint const n = 1000;
+
+	fuse_benchmark_init();
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autofree gchar* path = NULL;
+
+		path = fuse_benchmark_path("readdir", i);
+		fuse_benchmark_create(path);
+	}
+
+	j_benchmark_timer_start(run);
+
+	while (j_benchmark_iterate(run))
+	{
+		guint entries = 0;
+		gint ret;
+
+		ret = jfs_readdir(FUSE_BENCHMARK_DIR, &entries, fuse_benchmark_filler, 0, NULL);
+		g_assert_cmpint(ret, ==, 0);
+		g_assert_cmpuint(entries, ==, n);
+	}
+
+	j_benchmark_timer_stop(run);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autofree gchar* path = NULL;
+
+		path = fuse_benchmark_path("readdir", i);
+		fuse_benchmark_unlink(path);
+	}
+
+	fuse_benchmark_fini();
+
+	run->operations = n;
+}
+
+static void
+benchmark_fuse_unlink(BenchmarkRun* run)
+{
+	guint const n = 1000;
+
+	fuse_benchmark_init();
+
+	while (j_benchmark_iterate(run))
+	{
+		for (guint i = 0; i < n; i++)
+		{
+			g_autofree gchar* path = NULL;
+
+			path = fuse_benchmark_path("unlink", i);
+			fuse_benchmark_create(path);
+		}
+
+		j_benchmark_timer_start(run);
+
+		for (guint i = 0; i < n; i++)
+		{
+			g_autofree gchar* path = NULL;
+
+			path = fuse_benchmark_path("unlink", i);
+			fuse_benchmark_unlink(path);
+		}
+
+		j_benchmark_timer_stop(run);
+	}
+
+	fuse_benchmark_fini();
+
+	run->operations = n;
+}
+
+struct FuseScalingThread;
+
+typedef struct FuseScalingThread FuseScalingThread;
+
+/**
+ * An operation that is run concurrently by all threads.
+ * setup and teardown are optional and not part of the measurement.
+ **/
+struct FuseScalingOperation
+{
+	void (*setup)(FuseScalingThread*);
+	void (*run)(FuseScalingThread*);
+	void (*teardown)(FuseScalingThread*);
+
+	/**
+	 * The number of bytes transferred per operation.
+	 **/
+	guint64 bytes;
+};
+
+typedef struct FuseScalingOperation FuseScalingOperation;
+
+/**
+ * Synchronizes the start of all threads.
+ **/
+struct FuseScalingStart
+{
+	GMutex mutex;
+	GCond cond;
+	guint ready;
+	gboolean started;
+	gint64 end_time;
+};
+
+typedef struct FuseScalingStart FuseScalingStart;
+
+struct FuseScalingThread
+{
+	FuseScalingOperation const* operation;
+	FuseScalingStart* start;
+	guint id;
+
+	gchar* path;
+	struct fuse_file_info fi;
+	gchar* buffer;
+
+	guint64 operations;
+
+	/**
+	 * Durations of all operations in microseconds.
+	 **/
+	GArray* latencies;
+};
+
+static gpointer
+fuse_scaling_thread_func(gpointer data)
+{
+	FuseScalingThread* thread = data;
+
+	gint64 end_time;
+
+	if (thread->operation->setup != NULL)
+	{
+		thread->operation->setup(thread);
+	}
+
+	g_mutex_lock(&(thread->start->mutex));
+	thread->start->ready++;
+	g_cond_broadcast(&(thread->start->cond));
+
+	while (!thread->start->started)
+	{
+		g_cond_wait(&(thread->start->cond), &(thread->start->mutex));
+	}
+
+	end_time = thread->start->end_time;
+	g_mutex_unlock(&(thread->start->mutex));
+
+	while (g_get_monotonic_time() < end_time)
+	{
+		gint64 start_time;
+		gint64 latency;
+
+		start_time = g_get_monotonic_time();
+		thread->operation->run(thread);
+		latency = g_get_monotonic_time() - start_time;
+
+		g_array_append_val(thread->latencies, latency);
+		thread->operations++;
+	}
+
+	return NULL;
+}
+
+/**
+ * Runs an operation concurrently from run->threads threads, like FUSE's multi-threaded loop does.
+ *
+ * \param run       A benchmark run.
+ * \param operation An operation.
+ **/
+static void
+fuse_scaling_run(BenchmarkRun* run, FuseScalingOperation const* operation)
+{
+	g_autofree FuseScalingThread* threads = NULL;
+	g_autofree GThread** handles = NULL;
+	FuseScalingStart start;
+	guint64 operations = 0;
+
+	fuse_benchmark_init();
+
+	g_mutex_init(&(start.mutex));
+	g_cond_init(&(start.cond));
+	start.ready = 0;
+	start.started = FALSE;
+	start.end_time = 0;
+
+	threads = g_new0(FuseScalingThread, run->threads);
+	handles = g_new(GThread*, run->threads);
+
+	for (guint i = 0; i < run->threads; i++)
+	{
+		threads[i].operation = operation;
+		threads[i].start = &start;
+		threads[i].id = i;
+		threads[i].path = fuse_benchmark_path("scaling", i);
+		threads[i].latencies = g_array_new(FALSE, FALSE, sizeof(gint64));
+
+		handles[i] = g_thread_new("JBenchmarkFuse", fuse_scaling_thread_func, &(threads[i]));
+	}
+
+	// Start measuring only after all threads have finished their setup.
+	g_mutex_lock(&(start.mutex));
+
+	while (start.ready < run->threads)
+	{
+		g_cond_wait(&(start.cond), &(start.mutex));
+	}
+
+	j_benchmark_timer_start(run);
+
+	start.started = TRUE;
+	start.end_time = g_get_monotonic_time() + j_benchmark_get_duration() * G_USEC_PER_SEC;
+	g_cond_broadcast(&(start.cond));
+	g_mutex_unlock(&(start.mutex));
+
+	for (guint i = 0; i < run->threads; i++)
+	{
+		g_thread_join(handles[i]);
+	}
+
+	j_benchmark_timer_stop(run);
+
+	for (guint i = 0; i < run->threads; i++)
+	{
+		if (operation->teardown != NULL)
+		{
+			operation->teardown(&(threads[i]));
+		}
+
+		operations += threads[i].operations;
+
+		for (guint j = 0; j < threads[i].latencies->len; j++)
+		{
+			j_benchmark_add_latency(run, (gdouble)g_array_index(threads[i].latencies, gint64, j) / G_USEC_PER_SEC);
+		}
+
+		g_array_unref(threads[i].latencies);
+		g_free(threads[i].path);
+	}
+
+	g_cond_clear(&(start.cond));
+	g_mutex_clear(&(start.mutex));
+
+	fuse_benchmark_fini();
+
+	run->operations = operations;
+	run->bytes = operations * operation->bytes;
+}
+
+static void
+fuse_scaling_setup_write(FuseScalingThread* thread)
+{
+	gint ret;
+
+	thread->buffer = g_malloc0(FUSE_SCALING_BLOCK_SIZE);
+
+	ret = jfs_create(thread->path, 0644, &(thread->fi));
+	g_assert_cmpint(ret, ==, 0);
+}
+
+static void
+fuse_scaling_setup_read(FuseScalingThread* thread)
+{
+	gint ret;
+
+	fuse_scaling_setup_write(thread);
+
+	for (guint i = 0; i < FUSE_SCALING_BLOCKS; i++)
+	{
+		ret = jfs_write(thread->path, thread->buffer, FUSE_SCALING_BLOCK_SIZE, i * FUSE_SCALING_BLOCK_SIZE, &(thread->fi));
+		g_assert_cmpint(ret, ==, FUSE_SCALING_BLOCK_SIZE);
+	}
+
+	ret = jfs_flush(thread->path, &(thread->fi));
+	g_assert_cmpint(ret, ==, 0);
+}
+
+static void
+fuse_scaling_read(FuseScalingThread* thread)
+{
+	gint ret;
+
+	ret = jfs_read(thread->path, thread->buffer, FUSE_SCALING_BLOCK_SIZE, (thread->operations % FUSE_SCALING_BLOCKS) * FUSE_SCALING_BLOCK_SIZE, &(thread->fi));
+	g_assert_cmpint(ret, ==, FUSE_SCALING_BLOCK_SIZE);
+}
+
+static void
+fuse_scaling_write(FuseScalingThread* thread)
+{
+	gint ret;
+
+	// Writes are synchronous here, otherwise only the background writes' submission would be measured
+	ret = jfs_write(thread->path, thread->buffer, FUSE_SCALING_BLOCK_SIZE, (thread->operations % FUSE_SCALING_BLOCKS) * FUSE_SCALING_BLOCK_SIZE, &(thread->fi));
+	g_assert_cmpint(ret, ==, FUSE_SCALING_BLOCK_SIZE);
+	ret = jfs_flush(thread->path, &(thread->fi));
+	g_assert_cmpint(ret, ==, 0);
+}
+
+static void
+fuse_scaling_teardown(FuseScalingThread* thread)
+{
+	gint ret;
+
+	ret = jfs_release(thread->path, &(thread->fi));
+	g_assert_cmpint(ret, ==, 0);
+
+	fuse_benchmark_unlink(thread->path);
+	g_free(thread->buffer);
+}
+
+static void
+fuse_scaling_create(FuseScalingThread* thread)
+{
+	g_autofree gchar* path = NULL;
+	struct stat stbuf;
+	gint ret;
+
+	path = g_strdup_printf("%s-%" G_GUINT64_FORMAT, thread->path, thread->operations);
+	fuse_benchmark_create(path);
+
+	ret = jfs_getattr(path, &stbuf);
+	g_assert_cmpint(ret, ==, 0);
+}
+
+static void
+fuse_scaling_teardown_create(FuseScalingThread* thread)
+{
+	for (guint64 i = 0; i < thread->operations; i++)
+	{
+		g_autofree gchar* path = NULL;
+
+		path = g_strdup_printf("%s-%" G_GUINT64_FORMAT, thread->path, i);
+		fuse_benchmark_unlink(path);
+	}
+}
+
+static FuseScalingOperation const fuse_scaling_read_operation = { fuse_scaling_setup_read, fuse_scaling_read, fuse_scaling_teardown, FUSE_SCALING_BLOCK_SIZE };
+static FuseScalingOperation const fuse_scaling_write_operation = { fuse_scaling_setup_write, fuse_scaling_write, fuse_scaling_teardown, FUSE_SCALING_BLOCK_SIZE };
+static FuseScalingOperation const fuse_scaling_create_operation = { NULL, fuse_scaling_create, fuse_scaling_teardown_create, 0 };
+
+static void
+benchmark_fuse_scaling_read(BenchmarkRun* run)
+{
+	fuse_scaling_run(run, &fuse_scaling_read_operation);
+}
+
+static void
+benchmark_fuse_scaling_write(BenchmarkRun* run)
+{
+	fuse_scaling_run(run, &fuse_scaling_write_operation);
+}
+
+static void
+benchmark_fuse_scaling_create(BenchmarkRun* run)
+{
+	fuse_scaling_run(run, &fuse_scaling_create_operation);
+}
+
+#endif
+
+void
+benchmark_fuse(void)
+{
+#ifdef HAVE_FUSE
+	j_benchmark_add_sweep("/fuse/file/write", benchmark_fuse_write, J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_BLOCK_SIZE));
+	j_benchmark_add_sweep("/fuse/file/write-random", benchmark_fuse_write_random, J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_BLOCK_SIZE));
+	j_benchmark_add_sweep("/fuse/file/read", benchmark_fuse_read, J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_BLOCK_SIZE));
+	j_benchmark_add_sweep("/fuse/file/read-random", benchmark_fuse_read_random, J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_BLOCK_SIZE));
+	j_benchmark_add("/fuse/metadata/create", benchmark_fuse_create);
+	j_benchmark_add("/fuse/metadata/stat", benchmark_fuse_stat);
+	j_benchmark_add("/fuse/metadata/readdir", benchmark_fuse_readdir);
+	j_benchmark_add("/fuse/metadata/unlink", benchmark_fuse_unlink);
+	j_benchmark_add_scaling("/fuse/scaling/read", benchmark_fuse_scaling_read);
+	j_benchmark_add_scaling("/fuse/scaling/write", benchmark_fuse_scaling_write);
+	j_benchmark_add_scaling("/fuse/scaling/create", benchmark_fuse_scaling_create);
+#endif
+}
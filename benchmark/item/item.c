@@ -42,7 +42,7 @@ _benchmark_item_create(BenchmarkRun* run, gboolean use_batch)
 	delete_batch = j_batch_new(semantics);
 	batch = j_batch_new(semantics);
 
-	collection = j_collection_create("benchmark", batch);
+	collection = j_collection_create(j_benchmark_get_namespace(), batch);
 	ret = j_batch_execute(batch);
 	g_assert_true(ret);
 
@@ -113,7 +113,7 @@ _benchmark_item_delete(BenchmarkRun* run, gboolean use_batch)
 	get_batch = j_batch_new(semantics);
 	batch = j_batch_new(semantics);
 
-	collection = j_collection_create("benchmark", batch);
+	collection = j_collection_create(j_benchmark_get_namespace(), batch);
 	ret = j_batch_execute(batch);
 	g_assert_true(ret);
 
@@ -195,7 +195,7 @@ benchmark_item_delete_batch_without_get(BenchmarkRun* run)
 	delete_batch = j_batch_new(semantics);
 	batch = j_batch_new(semantics);
 
-	collection = j_collection_create("benchmark", batch);
+	collection = j_collection_create(j_benchmark_get_namespace(), batch);
 	ret = j_batch_execute(batch);
 	g_assert_true(ret);
 
@@ -248,7 +248,7 @@ _benchmark_item_get_status(BenchmarkRun* run, gboolean use_batch)
 	semantics = j_benchmark_get_semantics();
 	batch = j_batch_new(semantics);
 
-	collection = j_collection_create("benchmark", batch);
+	collection = j_collection_create(j_benchmark_get_namespace(), batch);
 	item = j_item_create(collection, "benchmark", NULL, batch);
 	j_item_write(item, dummy, 1, 0, &nb, batch);
 
@@ -317,7 +317,7 @@ _benchmark_item_read(BenchmarkRun* run, gboolean use_batch, guint block_size)
 	semantics = j_benchmark_get_semantics();
 	batch = j_batch_new(semantics);
 
-	collection = j_collection_create("benchmark", batch);
+	collection = j_collection_create(j_benchmark_get_namespace(), batch);
 	item = j_item_create(collection, "benchmark", NULL, batch);
 
 	for (guint i = 0; i < n; i++)
@@ -394,7 +394,7 @@ _benchmark_item_write(BenchmarkRun* run, gboolean use_batch, guint block_size)
 	semantics = j_benchmark_get_semantics();
 	batch = j_batch_new(semantics);
 
-	collection = j_collection_create("benchmark", batch);
+	collection = j_collection_create(j_benchmark_get_namespace(), batch);
 	item = j_item_create(collection, "benchmark", NULL, batch);
 	ret = j_batch_execute(batch);
 	g_assert_true(ret);
@@ -459,7 +459,7 @@ _benchmark_item_unordered_create_delete(BenchmarkRun* run, gboolean use_batch)
 	semantics = j_benchmark_get_semantics();
 	batch = j_batch_new(semantics);
 
-	collection = j_collection_create("benchmark", batch);
+	collection = j_collection_create(j_benchmark_get_namespace(), batch);
 	ret = j_batch_execute(batch);
 	g_assert_true(ret);
 
@@ -30,7 +30,8 @@
 static void
 _benchmark_kv_put(BenchmarkRun* run, gboolean use_batch)
 {
-	guint const n = 1000;
+	guint const n = (use_batch) ? j_benchmark_get_parameter(run, J_BENCHMARK_PARAMETER_BATCH_SIZE, 1000) : 1000;
+	guint32 const value_size = j_benchmark_get_parameter(run, J_BENCHMARK_PARAMETER_VALUE_SIZE, 6);
 
 	g_autoptr(JBatch) delete_batch = NULL;
 	g_autoptr(JBatch) batch = NULL;
@@ -51,8 +52,8 @@ _benchmark_kv_put(BenchmarkRun* run, gboolean use_batch)
 			g_autofree gchar* name = NULL;
 
 			name = g_strdup_printf("benchmark-%d", i);
-			object = j_kv_new("benchmark", name);
-			j_kv_put(object, g_strdup("empty"), 6, g_free, batch);
+			object = j_kv_new(j_benchmark_get_namespace(), name);
+			j_kv_put(object, g_malloc0(value_size), value_size, g_free, batch);
 
 			j_kv_delete(object, delete_batch);
 
@@ -76,6 +77,7 @@ _benchmark_kv_put(BenchmarkRun* run, gboolean use_batch)
 	}
 
 	run->operations = n;
+	run->bytes = (guint64)n * value_size;
 }
 
 static void
@@ -102,7 +104,8 @@ _benchmark_kv_get_callback(gpointer value, guint32 len, gpointer data)
 static void
 _benchmark_kv_get(BenchmarkRun* run, gboolean use_batch)
 {
-	guint const n = 1000;
+	guint const n = (use_batch) ? j_benchmark_get_parameter(run, J_BENCHMARK_PARAMETER_BATCH_SIZE, 1000) : 1000;
+	guint32 const value_size = j_benchmark_get_parameter(run, J_BENCHMARK_PARAMETER_VALUE_SIZE, 6);
 
 	g_autoptr(JBatch) delete_batch = NULL;
 	g_autoptr(JBatch) batch = NULL;
@@ -119,8 +122,8 @@ _benchmark_kv_get(BenchmarkRun* run, gboolean use_batch)
 		g_autofree gchar* name = NULL;
 
 		name = g_strdup_printf("benchmark-%d", i);
-		object = j_kv_new("benchmark", name);
-		j_kv_put(object, g_strdup(name), strlen(name), g_free, batch);
+		object = j_kv_new(j_benchmark_get_namespace(), name);
+		j_kv_put(object, g_malloc0(value_size), value_size, g_free, batch);
 
 		j_kv_delete(object, delete_batch);
 	}
@@ -138,7 +141,7 @@ _benchmark_kv_get(BenchmarkRun* run, gboolean use_batch)
 			g_autofree gchar* name = NULL;
 
 			name = g_strdup_printf("benchmark-%d", i);
-			object = j_kv_new("benchmark", name);
+			object = j_kv_new(j_benchmark_get_namespace(), name);
 			j_kv_get_callback(object, _benchmark_kv_get_callback, NULL, batch);
 
 			if (!use_batch)
@@ -161,6 +164,7 @@ _benchmark_kv_get(BenchmarkRun* run, gboolean use_batch)
 	g_assert_true(ret);
 
 	run->operations = n;
+	run->bytes = (guint64)n * value_size;
 }
 
 static void
@@ -195,7 +199,7 @@ _benchmark_kv_delete(BenchmarkRun* run, gboolean use_batch)
 			g_autofree gchar* name = NULL;
 
 			name = g_strdup_printf("benchmark-%d", i);
-			object = j_kv_new("benchmark", name);
+			object = j_kv_new(j_benchmark_get_namespace(), name);
 			j_kv_put(object, g_strdup("empty"), 6, g_free, batch);
 		}
 
@@ -210,7 +214,7 @@ _benchmark_kv_delete(BenchmarkRun* run, gboolean use_batch)
 			g_autofree gchar* name = NULL;
 
 			name = g_strdup_printf("benchmark-%d", i);
-			object = j_kv_new("benchmark", name);
+			object = j_kv_new(j_benchmark_get_namespace(), name);
 
 			j_kv_delete(object, batch);
 
@@ -267,7 +271,7 @@ _benchmark_kv_unordered_put_delete(BenchmarkRun* run, gboolean use_batch)
 			g_autofree gchar* name = NULL;
 
 			name = g_strdup_printf("benchmark-%d", i);
-			object = j_kv_new("benchmark", name);
+			object = j_kv_new(j_benchmark_get_namespace(), name);
 			j_kv_put(object, g_strdup("empty"), 6, g_free, batch);
 			j_kv_delete(object, batch);
 
@@ -305,10 +309,10 @@ benchmark_kv_unordered_put_delete_batch(BenchmarkRun* run)
 void
 benchmark_kv(void)
 {
-	j_benchmark_add("/kv/put", benchmark_kv_put);
-	j_benchmark_add("/kv/put-batch", benchmark_kv_put_batch);
-	j_benchmark_add("/kv/get", benchmark_kv_get);
-	j_benchmark_add("/kv/get-batch", benchmark_kv_get_batch);
+	j_benchmark_add_sweep("/kv/put", benchmark_kv_put, J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_VALUE_SIZE));
+	j_benchmark_add_sweep("/kv/put-batch", benchmark_kv_put_batch, J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_VALUE_SIZE) | J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_BATCH_SIZE));
+	j_benchmark_add_sweep("/kv/get", benchmark_kv_get, J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_VALUE_SIZE));
+	j_benchmark_add_sweep("/kv/get-batch", benchmark_kv_get_batch, J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_VALUE_SIZE) | J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_BATCH_SIZE));
 	j_benchmark_add("/kv/delete", benchmark_kv_delete);
 	j_benchmark_add("/kv/delete-batch", benchmark_kv_delete_batch);
 	j_benchmark_add("/kv/unordered-put-delete", benchmark_kv_unordered_put_delete);
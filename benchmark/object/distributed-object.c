@@ -38,7 +38,7 @@ _benchmark_distributed_object_create(BenchmarkRun* run, gboolean use_batch)
 	g_autoptr(JSemantics) semantics = NULL;
 	gboolean ret;
 
-	distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
+	distribution = j_benchmark_get_distribution(run);
 	semantics = j_benchmark_get_semantics();
 	delete_batch = j_batch_new(semantics);
 	batch = j_batch_new(semantics);
@@ -53,7 +53,7 @@ _benchmark_distributed_object_create(BenchmarkRun* run, gboolean use_batch)
 			g_autofree gchar* name = NULL;
 
 			name = g_strdup_printf("benchmark-%d", i);
-			object = j_distributed_object_new("benchmark", name, distribution);
+			object = j_distributed_object_new(j_benchmark_get_namespace(), name, distribution);
 			j_distributed_object_create(object, batch);
 
 			j_distributed_object_delete(object, delete_batch);
@@ -102,7 +102,7 @@ _benchmark_distributed_object_delete(BenchmarkRun* run, gboolean use_batch)
 	g_autoptr(JSemantics) semantics = NULL;
 	gboolean ret;
 
-	distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
+	distribution = j_benchmark_get_distribution(run);
 	semantics = j_benchmark_get_semantics();
 	batch = j_batch_new(semantics);
 
@@ -114,7 +114,7 @@ _benchmark_distributed_object_delete(BenchmarkRun* run, gboolean use_batch)
 			g_autofree gchar* name = NULL;
 
 			name = g_strdup_printf("benchmark-%d", i);
-			object = j_distributed_object_new("benchmark", name, distribution);
+			object = j_distributed_object_new(j_benchmark_get_namespace(), name, distribution);
 			j_distributed_object_create(object, batch);
 		}
 
@@ -129,7 +129,7 @@ _benchmark_distributed_object_delete(BenchmarkRun* run, gboolean use_batch)
 			g_autofree gchar* name = NULL;
 
 			name = g_strdup_printf("benchmark-%d", i);
-			object = j_distributed_object_new("benchmark", name, distribution);
+			object = j_distributed_object_new(j_benchmark_get_namespace(), name, distribution);
 
 			j_distributed_object_delete(object, batch);
 
@@ -180,11 +180,11 @@ _benchmark_distributed_object_status(BenchmarkRun* run, gboolean use_batch)
 
 	memset(dummy, 0, 1);
 
-	distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
+	distribution = j_benchmark_get_distribution(run);
 	semantics = j_benchmark_get_semantics();
 	batch = j_batch_new(semantics);
 
-	object = j_distributed_object_new("benchmark", "benchmark", distribution);
+	object = j_distributed_object_new(j_benchmark_get_namespace(), "benchmark", distribution);
 	j_distributed_object_create(object, batch);
 	j_distributed_object_write(object, dummy, 1, 0, &size, batch);
 
@@ -235,25 +235,26 @@ benchmark_distributed_object_status_batch(BenchmarkRun* run)
 }
 
 static void
-_benchmark_distributed_object_read(BenchmarkRun* run, gboolean use_batch, guint block_size)
+_benchmark_distributed_object_read(BenchmarkRun* run, gboolean use_batch)
 {
-	guint const n = (use_batch) ? 10000 : 1000;
+	guint const n = (use_batch) ? j_benchmark_get_parameter(run, J_BENCHMARK_PARAMETER_BATCH_SIZE, 10000) : 1000;
+	guint64 const block_size = j_benchmark_get_parameter(run, J_BENCHMARK_PARAMETER_BLOCK_SIZE, 4 * 1024);
 
 	g_autoptr(JDistributedObject) object = NULL;
 	g_autoptr(JBatch) batch = NULL;
 	g_autoptr(JDistribution) distribution = NULL;
 	g_autoptr(JSemantics) semantics = NULL;
-	gchar dummy[block_size];
+	g_autofree gchar* dummy = NULL;
 	guint64 nb = 0;
 	gboolean ret;
 
-	memset(dummy, 0, block_size);
+	dummy = g_malloc0(block_size);
 
-	distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
+	distribution = j_benchmark_get_distribution(run);
 	semantics = j_benchmark_get_semantics();
 	batch = j_batch_new(semantics);
 
-	object = j_distributed_object_new("benchmark", "benchmark", distribution);
+	object = j_distributed_object_new(j_benchmark_get_namespace(), "benchmark", distribution);
 	j_distributed_object_create(object, batch);
 
 	for (guint i = 0; i < n; i++)
@@ -302,35 +303,36 @@ _benchmark_distributed_object_read(BenchmarkRun* run, gboolean use_batch, guint
 static void
 benchmark_distributed_object_read(BenchmarkRun* run)
 {
-	_benchmark_distributed_object_read(run, FALSE, 4 * 1024);
+	_benchmark_distributed_object_read(run, FALSE);
 }
 
 static void
 benchmark_distributed_object_read_batch(BenchmarkRun* run)
 {
-	_benchmark_distributed_object_read(run, TRUE, 4 * 1024);
+	_benchmark_distributed_object_read(run, TRUE);
 }
 
 static void
-_benchmark_distributed_object_write(BenchmarkRun* run, gboolean use_batch, guint block_size)
+_benchmark_distributed_object_write(BenchmarkRun* run, gboolean use_batch)
 {
-	guint const n = (use_batch) ? 10000 : 1000;
+	guint const n = (use_batch) ? j_benchmark_get_parameter(run, J_BENCHMARK_PARAMETER_BATCH_SIZE, 10000) : 1000;
+	guint64 const block_size = j_benchmark_get_parameter(run, J_BENCHMARK_PARAMETER_BLOCK_SIZE, 4 * 1024);
 
 	g_autoptr(JDistributedObject) object = NULL;
 	g_autoptr(JBatch) batch = NULL;
 	g_autoptr(JDistribution) distribution = NULL;
 	g_autoptr(JSemantics) semantics = NULL;
-	gchar dummy[block_size];
+	g_autofree gchar* dummy = NULL;
 	guint64 nb = 0;
 	gboolean ret;
 
-	memset(dummy, 0, block_size);
+	dummy = g_malloc0(block_size);
 
-	distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
+	distribution = j_benchmark_get_distribution(run);
 	semantics = j_benchmark_get_semantics();
 	batch = j_batch_new(semantics);
 
-	object = j_distributed_object_new("benchmark", "benchmark", distribution);
+	object = j_distributed_object_new(j_benchmark_get_namespace(), "benchmark", distribution);
 	j_distributed_object_create(object, batch);
 	ret = j_batch_execute(batch);
 	g_assert_true(ret);
@@ -341,7 +343,7 @@ _benchmark_distributed_object_write(BenchmarkRun* run, gboolean use_batch, guint
 	{
 		for (guint i = 0; i < n; i++)
 		{
-			j_distributed_object_write(object, &dummy, block_size, i * block_size, &nb, batch);
+			j_distributed_object_write(object, dummy, block_size, i * block_size, &nb, batch);
 
 			if (!use_batch)
 			{
@@ -372,13 +374,13 @@ _benchmark_distributed_object_write(BenchmarkRun* run, gboolean use_batch, guint
 static void
 benchmark_distributed_object_write(BenchmarkRun* run)
 {
-	_benchmark_distributed_object_write(run, FALSE, 4 * 1024);
+	_benchmark_distributed_object_write(run, FALSE);
 }
 
 static void
 benchmark_distributed_object_write_batch(BenchmarkRun* run)
 {
-	_benchmark_distributed_object_write(run, TRUE, 4 * 1024);
+	_benchmark_distributed_object_write(run, TRUE);
 }
 
 static void
@@ -391,7 +393,7 @@ _benchmark_distributed_object_unordered_create_delete(BenchmarkRun* run, gboolea
 	g_autoptr(JSemantics) semantics = NULL;
 	gboolean ret;
 
-	distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
+	distribution = j_benchmark_get_distribution(run);
 	semantics = j_benchmark_get_semantics();
 	batch = j_batch_new(semantics);
 
@@ -405,7 +407,7 @@ _benchmark_distributed_object_unordered_create_delete(BenchmarkRun* run, gboolea
 			g_autofree gchar* name = NULL;
 
 			name = g_strdup_printf("benchmark-%d", i);
-			object = j_distributed_object_new("benchmark", name, distribution);
+			object = j_distributed_object_new(j_benchmark_get_namespace(), name, distribution);
 			j_distributed_object_create(object, batch);
 			j_distributed_object_delete(object, batch);
 
@@ -443,17 +445,19 @@ benchmark_distributed_object_unordered_create_delete_batch(BenchmarkRun* run)
 void
 benchmark_distributed_object(void)
 {
-	j_benchmark_add("/object/distributed-object/create", benchmark_distributed_object_create);
-	j_benchmark_add("/object/distributed-object/create-batch", benchmark_distributed_object_create_batch);
-	j_benchmark_add("/object/distributed-object/delete", benchmark_distributed_object_delete);
-	j_benchmark_add("/object/distributed-object/delete-batch", benchmark_distributed_object_delete_batch);
-	j_benchmark_add("/object/distributed-object/status", benchmark_distributed_object_status);
-	j_benchmark_add("/object/distributed-object/status-batch", benchmark_distributed_object_status_batch);
+	guint const sweep = J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_DISTRIBUTION) | J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_STRIPE_SIZE);
+
+	j_benchmark_add_sweep("/object/distributed-object/create", benchmark_distributed_object_create, sweep);
+	j_benchmark_add_sweep("/object/distributed-object/create-batch", benchmark_distributed_object_create_batch, sweep);
+	j_benchmark_add_sweep("/object/distributed-object/delete", benchmark_distributed_object_delete, sweep);
+	j_benchmark_add_sweep("/object/distributed-object/delete-batch", benchmark_distributed_object_delete_batch, sweep);
+	j_benchmark_add_sweep("/object/distributed-object/status", benchmark_distributed_object_status, sweep);
+	j_benchmark_add_sweep("/object/distributed-object/status-batch", benchmark_distributed_object_status_batch, sweep);
 	/* FIXME get */
-	j_benchmark_add("/object/distributed-object/read", benchmark_distributed_object_read);
-	j_benchmark_add("/object/distributed-object/read-batch", benchmark_distributed_object_read_batch);
-	j_benchmark_add("/object/distributed-object/write", benchmark_distributed_object_write);
-	j_benchmark_add("/object/distributed-object/write-batch", benchmark_distributed_object_write_batch);
-	j_benchmark_add("/object/distributed-object/unordered-create-delete", benchmark_distributed_object_unordered_create_delete);
-	j_benchmark_add("/object/distributed-object/unordered-create-delete-batch", benchmark_distributed_object_unordered_create_delete_batch);
+	j_benchmark_add_sweep("/object/distributed-object/read", benchmark_distributed_object_read, sweep | J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_BLOCK_SIZE));
+	j_benchmark_add_sweep("/object/distributed-object/read-batch", benchmark_distributed_object_read_batch, sweep | J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_BLOCK_SIZE) | J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_BATCH_SIZE));
+	j_benchmark_add_sweep("/object/distributed-object/write", benchmark_distributed_object_write, sweep | J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_BLOCK_SIZE));
+	j_benchmark_add_sweep("/object/distributed-object/write-batch", benchmark_distributed_object_write_batch, sweep | J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_BLOCK_SIZE) | J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_BATCH_SIZE));
+	j_benchmark_add_sweep("/object/distributed-object/unordered-create-delete", benchmark_distributed_object_unordered_create_delete, sweep);
+	j_benchmark_add_sweep("/object/distributed-object/unordered-create-delete-batch", benchmark_distributed_object_unordered_create_delete_batch, sweep);
 }
@@ -51,7 +51,7 @@ _benchmark_object_create(BenchmarkRun* run, gboolean use_batch)
 			g_autofree gchar* name = NULL;
 
 			name = g_strdup_printf("benchmark-%d", i);
-			object = j_object_new("benchmark", name);
+			object = j_object_new(j_benchmark_get_namespace(), name);
 			j_object_create(object, batch);
 
 			j_object_delete(object, delete_batch);
@@ -110,7 +110,7 @@ _benchmark_object_delete(BenchmarkRun* run, gboolean use_batch)
 			g_autofree gchar* name = NULL;
 
 			name = g_strdup_printf("benchmark-%d", i);
-			object = j_object_new("benchmark", name);
+			object = j_object_new(j_benchmark_get_namespace(), name);
 			j_object_create(object, batch);
 		}
 
@@ -125,7 +125,7 @@ _benchmark_object_delete(BenchmarkRun* run, gboolean use_batch)
 			g_autofree gchar* name = NULL;
 
 			name = g_strdup_printf("benchmark-%d", i);
-			object = j_object_new("benchmark", name);
+			object = j_object_new(j_benchmark_get_namespace(), name);
 
 			j_object_delete(object, batch);
 
@@ -178,7 +178,7 @@ _benchmark_object_status(BenchmarkRun* run, gboolean use_batch)
 	semantics = j_benchmark_get_semantics();
 	batch = j_batch_new(semantics);
 
-	object = j_object_new("benchmark", "benchmark");
+	object = j_object_new(j_benchmark_get_namespace(), "benchmark");
 	j_object_create(object, batch);
 	j_object_write(object, dummy, 1, 0, &size, batch);
 
@@ -229,23 +229,24 @@ benchmark_object_status_batch(BenchmarkRun* run)
 }
 
 static void
-_benchmark_object_read(BenchmarkRun* run, gboolean use_batch, guint block_size)
+_benchmark_object_read(BenchmarkRun* run, gboolean use_batch)
 {
-	guint const n = (use_batch) ? 10000 : 1000;
+	guint const n = (use_batch) ? j_benchmark_get_parameter(run, J_BENCHMARK_PARAMETER_BATCH_SIZE, 10000) : 1000;
+	guint64 const block_size = j_benchmark_get_parameter(run, J_BENCHMARK_PARAMETER_BLOCK_SIZE, 4 * 1024);
 
 	g_autoptr(JObject) object = NULL;
 	g_autoptr(JBatch) batch = NULL;
 	g_autoptr(JSemantics) semantics = NULL;
-	gchar dummy[block_size];
+	g_autofree gchar* dummy = NULL;
 	guint64 nb = 0;
 	gboolean ret;
 
-	memset(dummy, 0, block_size);
+	dummy = g_malloc0(block_size);
 
 	semantics = j_benchmark_get_semantics();
 	batch = j_batch_new(semantics);
 
-	object = j_object_new("benchmark", "benchmark");
+	object = j_object_new(j_benchmark_get_namespace(), "benchmark");
 	j_object_create(object, batch);
 
 	for (guint i = 0; i < n; i++)
@@ -294,33 +295,34 @@ _benchmark_object_read(BenchmarkRun* run, gboolean use_batch, guint block_size)
 static void
 benchmark_object_read(BenchmarkRun* run)
 {
-	_benchmark_object_read(run, FALSE, 4 * 1024);
+	_benchmark_object_read(run, FALSE);
 }
 
 static void
 benchmark_object_read_batch(BenchmarkRun* run)
 {
-	_benchmark_object_read(run, TRUE, 4 * 1024);
+	_benchmark_object_read(run, TRUE);
 }
 
 static void
-_benchmark_object_write(BenchmarkRun* run, gboolean use_batch, guint block_size)
+_benchmark_object_write(BenchmarkRun* run, gboolean use_batch)
 {
-	guint const n = (use_batch) ? 10000 : 1000;
+	guint const n = (use_batch) ? j_benchmark_get_parameter(run, J_BENCHMARK_PARAMETER_BATCH_SIZE, 10000) : 1000;
+	guint64 const block_size = j_benchmark_get_parameter(run, J_BENCHMARK_PARAMETER_BLOCK_SIZE, 4 * 1024);
 
 	g_autoptr(JObject) object = NULL;
 	g_autoptr(JBatch) batch = NULL;
 	g_autoptr(JSemantics) semantics = NULL;
-	gchar dummy[block_size];
+	g_autofree gchar* dummy = NULL;
 	guint64 nb = 0;
 	gboolean ret;
 
-	memset(dummy, 0, block_size);
+	dummy = g_malloc0(block_size);
 
 	semantics = j_benchmark_get_semantics();
 	batch = j_batch_new(semantics);
 
-	object = j_object_new("benchmark", "benchmark");
+	object = j_object_new(j_benchmark_get_namespace(), "benchmark");
 	j_object_create(object, batch);
 	ret = j_batch_execute(batch);
 	g_assert_true(ret);
@@ -331,7 +333,7 @@ _benchmark_object_write(BenchmarkRun* run, gboolean use_batch, guint block_size)
 	{
 		for (guint i = 0; i < n; i++)
 		{
-			j_object_write(object, &dummy, block_size, i * block_size, &nb, batch);
+			j_object_write(object, dummy, block_size, i * block_size, &nb, batch);
 
 			if (!use_batch)
 			{
@@ -362,13 +364,13 @@ _benchmark_object_write(BenchmarkRun* run, gboolean use_batch, guint block_size)
 static void
 benchmark_object_write(BenchmarkRun* run)
 {
-	_benchmark_object_write(run, FALSE, 4 * 1024);
+	_benchmark_object_write(run, FALSE);
 }
 
 static void
 benchmark_object_write_batch(BenchmarkRun* run)
 {
-	_benchmark_object_write(run, TRUE, 4 * 1024);
+	_benchmark_object_write(run, TRUE);
 }
 
 static void
@@ -393,7 +395,7 @@ _benchmark_object_unordered_create_delete(BenchmarkRun* run, gboolean use_batch)
 			g_autofree gchar* name = NULL;
 
 			name = g_strdup_printf("benchmark-%d", i);
-			object = j_object_new("benchmark", name);
+			object = j_object_new(j_benchmark_get_namespace(), name);
 			j_object_create(object, batch);
 			j_object_delete(object, batch);
 
@@ -438,10 +440,10 @@ benchmark_object(void)
 	j_benchmark_add("/object/object/status", benchmark_object_status);
 	j_benchmark_add("/object/object/status-batch", benchmark_object_status_batch);
 	/* FIXME get */
-	j_benchmark_add("/object/object/read", benchmark_object_read);
-	j_benchmark_add("/object/object/read-batch", benchmark_object_read_batch);
-	j_benchmark_add("/object/object/write", benchmark_object_write);
-	j_benchmark_add("/object/object/write-batch", benchmark_object_write_batch);
+	j_benchmark_add_sweep("/object/object/read", benchmark_object_read, J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_BLOCK_SIZE));
+	j_benchmark_add_sweep("/object/object/read-batch", benchmark_object_read_batch, J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_BLOCK_SIZE) | J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_BATCH_SIZE));
+	j_benchmark_add_sweep("/object/object/write", benchmark_object_write, J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_BLOCK_SIZE));
+	j_benchmark_add_sweep("/object/object/write-batch", benchmark_object_write_batch, J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_BLOCK_SIZE) | J_BENCHMARK_SWEEP(J_BENCHMARK_PARAMETER_BATCH_SIZE));
 	j_benchmark_add("/object/object/unordered-create-delete", benchmark_object_unordered_create_delete);
 	j_benchmark_add("/object/object/unordered-create-delete-batch", benchmark_object_unordered_create_delete_batch);
 }
@@ -0,0 +1,399 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2017-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <julea.h>
+#include <julea-kv.h>
+#include <julea-object.h>
+
+#include "benchmark.h"
+
+/**
+ * The size of a single read or write.
+ **/
+#define SCALING_BLOCK_SIZE (4 * 1024)
+
+/**
+ * The number of blocks per object, reads and writes wrap around afterwards.
+ **/
+#define SCALING_BLOCKS 256
+
+struct ScalingThread;
+
+typedef struct ScalingThread ScalingThread;
+
+/**
+ * An operation that is run concurrently by all threads.
+ * setup and teardown are optional and not part of the measurement.
+ **/
+struct ScalingOperation
+{
+	void (*setup)(ScalingThread*, JBatch*);
+	void (*run)(ScalingThread*, JBatch*);
+	void (*teardown)(ScalingThread*, JBatch*);
+
+	/**
+	 * The number of bytes transferred per operation.
+	 **/
+	guint64 bytes;
+};
+
+typedef struct ScalingOperation ScalingOperation;
+
+/**
+ * Synchronizes the start of all threads.
+ **/
+struct ScalingStart
+{
+	GMutex mutex;
+	GCond cond;
+	guint ready;
+	gboolean started;
+	gint64 end_time;
+};
+
+typedef struct ScalingStart ScalingStart;
+
+struct ScalingThread
+{
+	ScalingOperation const* operation;
+	ScalingStart* start;
+	guint id;
+
+	JObject* object;
+	JKV* kv;
+	gchar* buffer;
+
+	guint64 operations;
+
+	/**
+	 * Durations of all operations in microseconds.
+	 **/
+	GArray* latencies;
+};
+
+static gpointer
+scaling_thread_func(gpointer data)
+{
+	ScalingThread* thread = data;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	gint64 end_time;
+
+	semantics = j_benchmark_get_semantics();
+	batch = j_batch_new(semantics);
+
+	if (thread->operation->setup != NULL)
+	{
+		thread->operation->setup(thread, batch);
+	}
+
+	g_mutex_lock(&(thread->start->mutex));
+	thread->start->ready++;
+	g_cond_broadcast(&(thread->start->cond));
+
+	while (!thread->start->started)
+	{
+		g_cond_wait(&(thread->start->cond), &(thread->start->mutex));
+	}
+
+	end_time = thread->start->end_time;
+	g_mutex_unlock(&(thread->start->mutex));
+
+	while (g_get_monotonic_time() < end_time)
+	{
+		gint64 start_time;
+		gint64 latency;
+
+		start_time = g_get_monotonic_time();
+		thread->operation->run(thread, batch);
+		latency = g_get_monotonic_time() - start_time;
+
+		g_array_append_val(thread->latencies, latency);
+		thread->operations++;
+	}
+
+	return NULL;
+}
+
+/**
+ * Runs an operation concurrently from run->threads threads sharing the client's connections.
+ *
+ * \param run       A benchmark run.
+ * \param operation An operation.
+ **/
+static void
+scaling_run(BenchmarkRun* run, ScalingOperation const* operation)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autofree ScalingThread* threads = NULL;
+	g_autofree GThread** handles = NULL;
+	ScalingStart start;
+	guint64 operations = 0;
+
+	g_mutex_init(&(start.mutex));
+	g_cond_init(&(start.cond));
+	start.ready = 0;
+	start.started = FALSE;
+	start.end_time = 0;
+
+	threads = g_new0(ScalingThread, run->threads);
+	handles = g_new(GThread*, run->threads);
+
+	for (guint i = 0; i < run->threads; i++)
+	{
+		threads[i].operation = operation;
+		threads[i].start = &start;
+		threads[i].id = i;
+		threads[i].latencies = g_array_new(FALSE, FALSE, sizeof(gint64));
+
+		handles[i] = g_thread_new("JBenchmarkScaling", scaling_thread_func, &(threads[i]));
+	}
+
+	// Start measuring only after all threads have finished their setup.
+	g_mutex_lock(&(start.mutex));
+
+	while (start.ready < run->threads)
+	{
+		g_cond_wait(&(start.cond), &(start.mutex));
+	}
+
+	j_benchmark_timer_start(run);
+
+	start.started = TRUE;
+	start.end_time = g_get_monotonic_time() + j_benchmark_get_duration() * G_USEC_PER_SEC;
+	g_cond_broadcast(&(start.cond));
+	g_mutex_unlock(&(start.mutex));
+
+	for (guint i = 0; i < run->threads; i++)
+	{
+		g_thread_join(handles[i]);
+	}
+
+	j_benchmark_timer_stop(run);
+
+	semantics = j_benchmark_get_semantics();
+	batch = j_batch_new(semantics);
+
+	// Clean up outside of the measurement, the threads' objects can be used from any thread.
+	for (guint i = 0; i < run->threads; i++)
+	{
+		if (operation->teardown != NULL)
+		{
+			operation->teardown(&(threads[i]), batch);
+		}
+
+		operations += threads[i].operations;
+
+		for (guint j = 0; j < threads[i].latencies->len; j++)
+		{
+			j_benchmark_add_latency(run, (gdouble)g_array_index(threads[i].latencies, gint64, j) / G_USEC_PER_SEC);
+		}
+
+		g_array_unref(threads[i].latencies);
+	}
+
+	g_cond_clear(&(start.cond));
+	g_mutex_clear(&(start.mutex));
+
+	run->operations = operations;
+	run->bytes = operations * operation->bytes;
+}
+
+static void
+scaling_object_setup(ScalingThread* thread, JBatch* batch)
+{
+	g_autofree gchar* name = NULL;
+	gboolean ret;
+
+	name = g_strdup_printf("scaling-%u", thread->id);
+	thread->object = j_object_new(j_benchmark_get_namespace(), name);
+	thread->buffer = g_malloc0(SCALING_BLOCK_SIZE);
+
+	j_object_create(thread->object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+scaling_object_setup_read(ScalingThread* thread, JBatch* batch)
+{
+	guint64 bytes_written = 0;
+	gboolean ret;
+
+	scaling_object_setup(thread, batch);
+
+	for (guint i = 0; i < SCALING_BLOCKS; i++)
+	{
+		j_object_write(thread->object, thread->buffer, SCALING_BLOCK_SIZE, i * SCALING_BLOCK_SIZE, &bytes_written, batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(bytes_written, ==, SCALING_BLOCKS * SCALING_BLOCK_SIZE);
+}
+
+static void
+scaling_object_read(ScalingThread* thread, JBatch* batch)
+{
+	guint64 bytes_read = 0;
+	gboolean ret;
+
+	j_object_read(thread->object, thread->buffer, SCALING_BLOCK_SIZE, (thread->operations % SCALING_BLOCKS) * SCALING_BLOCK_SIZE, &bytes_read, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(bytes_read, ==, SCALING_BLOCK_SIZE);
+}
+
+static void
+scaling_object_write(ScalingThread* thread, JBatch* batch)
+{
+	guint64 bytes_written = 0;
+	gboolean ret;
+
+	j_object_write(thread->object, thread->buffer, SCALING_BLOCK_SIZE, (thread->operations % SCALING_BLOCKS) * SCALING_BLOCK_SIZE, &bytes_written, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(bytes_written, ==, SCALING_BLOCK_SIZE);
+}
+
+static void
+scaling_object_status(ScalingThread* thread, JBatch* batch)
+{
+	gint64 modification_time;
+	guint64 size;
+	gboolean ret;
+
+	j_object_status(thread->object, &modification_time, &size, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+scaling_object_teardown(ScalingThread* thread, JBatch* batch)
+{
+	gboolean ret;
+
+	j_object_delete(thread->object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_object_unref(thread->object);
+	g_free(thread->buffer);
+}
+
+static void
+scaling_kv_setup(ScalingThread* thread, JBatch* batch)
+{
+	g_autofree gchar* name = NULL;
+	gboolean ret;
+
+	name = g_strdup_printf("scaling-%u", thread->id);
+	thread->kv = j_kv_new(j_benchmark_get_namespace(), name);
+
+	j_kv_put(thread->kv, g_strdup(name), strlen(name) + 1, g_free, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+scaling_kv_put(ScalingThread* thread, JBatch* batch)
+{
+	gboolean ret;
+
+	j_kv_put(thread->kv, g_strdup("empty"), 6, g_free, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+scaling_kv_get(ScalingThread* thread, JBatch* batch)
+{
+	g_autofree gpointer value = NULL;
+	guint32 value_len = 0;
+	gboolean ret;
+
+	j_kv_get(thread->kv, &value, &value_len, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+scaling_kv_teardown(ScalingThread* thread, JBatch* batch)
+{
+	gboolean ret;
+
+	j_kv_delete(thread->kv, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_kv_unref(thread->kv);
+}
+
+static ScalingOperation const scaling_object_read_operation = { scaling_object_setup_read, scaling_object_read, scaling_object_teardown, SCALING_BLOCK_SIZE };
+static ScalingOperation const scaling_object_write_operation = { scaling_object_setup, scaling_object_write, scaling_object_teardown, SCALING_BLOCK_SIZE };
+static ScalingOperation const scaling_object_status_operation = { scaling_object_setup_read, scaling_object_status, scaling_object_teardown, 0 };
+static ScalingOperation const scaling_kv_put_operation = { scaling_kv_setup, scaling_kv_put, scaling_kv_teardown, 0 };
+static ScalingOperation const scaling_kv_get_operation = { scaling_kv_setup, scaling_kv_get, scaling_kv_teardown, 0 };
+
+static void
+benchmark_scaling_object_read(BenchmarkRun* run)
+{
+	scaling_run(run, &scaling_object_read_operation);
+}
+
+static void
+benchmark_scaling_object_write(BenchmarkRun* run)
+{
+	scaling_run(run, &scaling_object_write_operation);
+}
+
+static void
+benchmark_scaling_object_status(BenchmarkRun* run)
+{
+	scaling_run(run, &scaling_object_status_operation);
+}
+
+static void
+benchmark_scaling_kv_put(BenchmarkRun* run)
+{
+	scaling_run(run, &scaling_kv_put_operation);
+}
+
+static void
+benchmark_scaling_kv_get(BenchmarkRun* run)
+{
+	scaling_run(run, &scaling_kv_get_operation);
+}
+
+void
+benchmark_scaling(void)
+{
+	j_benchmark_add_scaling("/scaling/object/read", benchmark_scaling_object_read);
+	j_benchmark_add_scaling("/scaling/object/write", benchmark_scaling_object_write);
+	j_benchmark_add_scaling("/scaling/object/status", benchmark_scaling_object_status);
+	j_benchmark_add_scaling("/scaling/kv/put", benchmark_scaling_kv_put);
+	j_benchmark_add_scaling("/scaling/kv/get", benchmark_scaling_kv_get);
+}
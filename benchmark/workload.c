@@ -0,0 +1,859 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2017-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <math.h>
+#include <string.h>
+
+#include <julea.h>
+#include <julea-db.h>
+#include <julea-kv.h>
+#include <julea-object.h>
+
+#include "benchmark.h"
+
+/**
+ * The number of distinct offsets, keys and rows each thread uses per class.
+ **/
+#define WORKLOAD_SLOTS 16
+
+enum WorkloadClass
+{
+	WORKLOAD_OBJECT_READ,
+	WORKLOAD_OBJECT_WRITE,
+	WORKLOAD_OBJECT_STATUS,
+	WORKLOAD_KV_GET,
+	WORKLOAD_KV_PUT,
+	WORKLOAD_DB_INSERT,
+	WORKLOAD_DB_QUERY,
+	WORKLOAD_CLASSES
+};
+
+typedef enum WorkloadClass WorkloadClass;
+
+static gchar const* const workload_class_names[WORKLOAD_CLASSES] = {
+	"object-read",
+	"object-write",
+	"object-status",
+	"kv-get",
+	"kv-put",
+	"db-insert",
+	"db-query"
+};
+
+/**
+ * The size used for classes without explicit sizes, metadata classes ignore it.
+ **/
+static guint64 const workload_default_sizes[WORKLOAD_CLASSES] = {
+	4 * 1024,
+	4 * 1024,
+	0,
+	64,
+	64,
+	64,
+	0
+};
+
+struct WorkloadFunction
+{
+	gchar const* name;
+	WorkloadClass class;
+};
+
+typedef struct WorkloadFunction WorkloadFunction;
+
+/**
+ * Client functions recorded in echo traces and the classes they are replayed as.
+ **/
+static WorkloadFunction const workload_functions[] = {
+	{ "j_object_read", WORKLOAD_OBJECT_READ },
+	{ "j_object_write", WORKLOAD_OBJECT_WRITE },
+	{ "j_object_status", WORKLOAD_OBJECT_STATUS },
+	{ "j_distributed_object_read", WORKLOAD_OBJECT_READ },
+	{ "j_distributed_object_write", WORKLOAD_OBJECT_WRITE },
+	{ "j_distributed_object_status", WORKLOAD_OBJECT_STATUS },
+	{ "j_kv_get", WORKLOAD_KV_GET },
+	{ "j_kv_get_callback", WORKLOAD_KV_GET },
+	{ "j_kv_put", WORKLOAD_KV_PUT },
+	{ "j_db_entry_insert", WORKLOAD_DB_INSERT },
+	{ "j_db_iterator_new", WORKLOAD_DB_QUERY }
+};
+
+struct WorkloadTraceEntry
+{
+	WorkloadClass class;
+
+	/**
+	 * The time since the previous operation in microseconds.
+	 **/
+	gint64 delay;
+};
+
+typedef struct WorkloadTraceEntry WorkloadTraceEntry;
+
+/**
+ * A workload, either a synthetic mix or a trace.
+ **/
+struct Workload
+{
+	guint weights[WORKLOAD_CLASSES];
+	guint weight_sum;
+
+	/**
+	 * The sizes to choose from per class.
+	 **/
+	GArray* sizes[WORKLOAD_CLASSES];
+	guint64 size_max;
+
+	/**
+	 * The mean think time between two operations in microseconds.
+	 **/
+	gdouble think_time;
+
+	GArray* trace;
+	gint trace_next;
+
+	gboolean used[WORKLOAD_CLASSES];
+
+	/**
+	 * Maps run->classes to workload classes.
+	 **/
+	WorkloadClass classes[WORKLOAD_CLASSES];
+};
+
+typedef struct Workload Workload;
+
+static Workload workload;
+
+struct WorkloadStart
+{
+	GMutex mutex;
+	GCond cond;
+	guint ready;
+	gboolean started;
+	gint64 end_time;
+};
+
+typedef struct WorkloadStart WorkloadStart;
+
+struct WorkloadThread
+{
+	WorkloadStart* start;
+	guint id;
+	GRand* rand;
+
+	JObject* object;
+	JKV* kv[WORKLOAD_SLOTS];
+	JDBSchema* schema;
+	gchar* buffer;
+	guint64 db_next;
+
+	guint64 operations[WORKLOAD_CLASSES];
+	guint64 bytes[WORKLOAD_CLASSES];
+
+	/**
+	 * Durations of all operations in microseconds.
+	 **/
+	GArray* latencies[WORKLOAD_CLASSES];
+};
+
+typedef struct WorkloadThread WorkloadThread;
+
+/**
+ * Parses a mix such as "object-read=70:4K-1M,object-write=20:4K|64K,object-status=10,think=100".
+ * Sizes use the same syntax as the sweep options but are separated by | instead of commas.
+ *
+ * \param mix A mix.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+workload_parse_mix(gchar const* mix)
+{
+	g_auto(GStrv) items = NULL;
+
+	items = g_strsplit(mix, ",", 0);
+
+	for (guint i = 0; items[i] != NULL; i++)
+	{
+		g_auto(GStrv) item = NULL;
+		g_auto(GStrv) value = NULL;
+		gchar* end = NULL;
+		guint64 weight;
+		guint class;
+
+		item = g_strsplit(items[i], "=", 2);
+
+		if (item[0] == NULL || item[1] == NULL)
+		{
+			return FALSE;
+		}
+
+		if (g_strcmp0(item[0], "think") == 0)
+		{
+			workload.think_time = g_ascii_strtod(item[1], &end);
+
+			if (*end != '\0' || workload.think_time < 0.0)
+			{
+				return FALSE;
+			}
+
+			continue;
+		}
+
+		for (class = 0; class < WORKLOAD_CLASSES; class++)
+		{
+			if (g_strcmp0(item[0], workload_class_names[class]) == 0)
+			{
+				break;
+			}
+		}
+
+		if (class == WORKLOAD_CLASSES)
+		{
+			return FALSE;
+		}
+
+		value = g_strsplit(item[1], ":", 2);
+		weight = g_ascii_strtoull(value[0], &end, 10);
+
+		if (end == value[0] || *end != '\0' || weight > G_MAXUINT16)
+		{
+			return FALSE;
+		}
+
+		if (value[1] != NULL)
+		{
+			g_autofree gchar* sizes = NULL;
+
+			sizes = g_strdelimit(g_strdup(value[1]), "|", ',');
+
+			if (workload.sizes[class] != NULL)
+			{
+				g_array_unref(workload.sizes[class]);
+			}
+
+			if ((workload.sizes[class] = j_benchmark_parse_sizes(sizes)) == NULL)
+			{
+				return FALSE;
+			}
+		}
+
+		workload.weight_sum += weight - workload.weights[class];
+		workload.weights[class] = weight;
+		workload.used[class] = (weight > 0);
+	}
+
+	return (workload.weight_sum > 0);
+}
+
+/**
+ * Reads a trace recorded with JULEA_TRACE=echo.
+ * Echo traces do not contain sizes, so the mix's sizes are used.
+ *
+ * \param path A path.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+workload_parse_trace(gchar const* path)
+{
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar* contents = NULL;
+	g_auto(GStrv) lines = NULL;
+	gint64 previous = -1;
+
+	if (!g_file_get_contents(path, &contents, NULL, &error))
+	{
+		g_printerr("Error: Cannot read trace: %s\n", error->message);
+
+		return FALSE;
+	}
+
+	// Only the trace's operations are replayed, the mix's weights do not matter.
+	for (guint i = 0; i < WORKLOAD_CLASSES; i++)
+	{
+		workload.used[i] = FALSE;
+	}
+
+	workload.trace = g_array_new(FALSE, FALSE, sizeof(WorkloadTraceEntry));
+	lines = g_strsplit(contents, "\n", 0);
+
+	// Lines look like "[1612345678.123456] julea-benchmark main:     ENTER j_object_write".
+	for (guint i = 0; lines[i] != NULL; i++)
+	{
+		WorkloadTraceEntry entry;
+		gchar* line = lines[i];
+		gchar* end = NULL;
+		gchar* function;
+		gint64 timestamp;
+		gsize length;
+		guint j;
+
+		if (line[0] != '[')
+		{
+			continue;
+		}
+
+		timestamp = g_ascii_strtoll(line + 1, &end, 10) * G_USEC_PER_SEC;
+
+		if (*end != '.')
+		{
+			continue;
+		}
+
+		timestamp += g_ascii_strtoll(end + 1, &end, 10);
+
+		if ((function = strstr(end, ": ")) == NULL)
+		{
+			continue;
+		}
+
+		function = g_strchug(function + 2);
+
+		if (!g_str_has_prefix(function, "ENTER "))
+		{
+			continue;
+		}
+
+		function += strlen("ENTER ");
+		length = strcspn(function, " ");
+
+		for (j = 0; j < G_N_ELEMENTS(workload_functions); j++)
+		{
+			if (strlen(workload_functions[j].name) == length && strncmp(function, workload_functions[j].name, length) == 0)
+			{
+				break;
+			}
+		}
+
+		if (j == G_N_ELEMENTS(workload_functions))
+		{
+			continue;
+		}
+
+		entry.class = workload_functions[j].class;
+		entry.delay = (previous >= 0) ? MAX(timestamp - previous, 0) : 0;
+		previous = timestamp;
+
+		g_array_append_val(workload.trace, entry);
+		workload.used[entry.class] = TRUE;
+	}
+
+	if (workload.trace->len == 0)
+	{
+		g_printerr("Error: Trace %s does not contain any supported operations\n", path);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static guint64
+workload_get_size(WorkloadThread* thread, WorkloadClass class)
+{
+	GArray* sizes = workload.sizes[class];
+
+	if (sizes == NULL)
+	{
+		return workload_default_sizes[class];
+	}
+
+	return g_array_index(sizes, guint64, g_rand_int_range(thread->rand, 0, sizes->len));
+}
+
+static guint64
+workload_get_size_max(WorkloadClass class)
+{
+	GArray* sizes = workload.sizes[class];
+	guint64 size_max = 0;
+
+	if (sizes == NULL)
+	{
+		return workload_default_sizes[class];
+	}
+
+	for (guint i = 0; i < sizes->len; i++)
+	{
+		size_max = MAX(size_max, g_array_index(sizes, guint64, i));
+	}
+
+	return size_max;
+}
+
+static WorkloadClass
+workload_get_class(WorkloadThread* thread, gint64* delay)
+{
+	guint weight;
+
+	if (workload.trace != NULL)
+	{
+		WorkloadTraceEntry const* entry;
+		guint next;
+
+		next = (guint)g_atomic_int_add(&(workload.trace_next), 1) % workload.trace->len;
+		entry = &g_array_index(workload.trace, WorkloadTraceEntry, next);
+		*delay = entry->delay;
+
+		return entry->class;
+	}
+
+	// Think times are exponentially distributed, that is, operations arrive as a Poisson process.
+	*delay = (workload.think_time > 0.0) ? (gint64)(-workload.think_time * log(1.0 - g_rand_double(thread->rand))) : 0;
+
+	weight = g_rand_int_range(thread->rand, 0, workload.weight_sum);
+
+	for (guint i = 0; i < WORKLOAD_CLASSES; i++)
+	{
+		if (weight < workload.weights[i])
+		{
+			return i;
+		}
+
+		weight -= workload.weights[i];
+	}
+
+	g_assert_not_reached();
+
+	return WORKLOAD_OBJECT_STATUS;
+}
+
+static void
+workload_setup(WorkloadThread* thread, JBatch* batch)
+{
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar* name = NULL;
+	gboolean ret;
+
+	name = g_strdup_printf("workload-%u", thread->id);
+	thread->buffer = g_malloc0(workload.size_max);
+
+	if (workload.used[WORKLOAD_OBJECT_READ] || workload.used[WORKLOAD_OBJECT_WRITE] || workload.used[WORKLOAD_OBJECT_STATUS])
+	{
+		guint64 size;
+		guint64 bytes_written = 0;
+
+		thread->object = j_object_new(j_benchmark_get_namespace(), name);
+		j_object_create(thread->object, batch);
+
+		// Reads should not hit holes, so fill all slots.
+		if (workload.used[WORKLOAD_OBJECT_READ])
+		{
+			size = workload_get_size_max(WORKLOAD_OBJECT_READ);
+
+			for (guint i = 0; i < WORKLOAD_SLOTS; i++)
+			{
+				j_object_write(thread->object, thread->buffer, size, i * size, &bytes_written, batch);
+			}
+		}
+
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+	}
+
+	if (workload.used[WORKLOAD_KV_GET] || workload.used[WORKLOAD_KV_PUT])
+	{
+		guint64 size;
+
+		size = workload_get_size_max(WORKLOAD_KV_GET);
+
+		for (guint i = 0; i < WORKLOAD_SLOTS; i++)
+		{
+			g_autofree gchar* key = NULL;
+
+			key = g_strdup_printf("%s-%u", name, i);
+			thread->kv[i] = j_kv_new(j_benchmark_get_namespace(), key);
+
+			if (workload.used[WORKLOAD_KV_GET])
+			{
+				j_kv_put(thread->kv[i], g_malloc0(size), size, g_free, batch);
+			}
+		}
+
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+	}
+
+	if (workload.used[WORKLOAD_DB_INSERT] || workload.used[WORKLOAD_DB_QUERY])
+	{
+		thread->schema = j_db_schema_new(j_benchmark_get_namespace(), name, &error);
+		g_assert_nonnull(thread->schema);
+
+		ret = j_db_schema_add_field(thread->schema, "key", J_DB_TYPE_UINT64, &error);
+		g_assert_true(ret);
+		ret = j_db_schema_add_field(thread->schema, "value", J_DB_TYPE_BLOB, &error);
+		g_assert_true(ret);
+		ret = j_db_schema_create(thread->schema, batch, &error);
+		g_assert_true(ret);
+
+		// Queries look for the first slots, inserts append behind them.
+		for (thread->db_next = 0; thread->db_next < WORKLOAD_SLOTS; thread->db_next++)
+		{
+			g_autoptr(JDBEntry) entry = NULL;
+
+			entry = j_db_entry_new(thread->schema, &error);
+			ret = j_db_entry_set_field(entry, "key", &(thread->db_next), 0, &error);
+			g_assert_true(ret);
+			ret = j_db_entry_set_field(entry, "value", thread->buffer, workload_get_size_max(WORKLOAD_DB_INSERT), &error);
+			g_assert_true(ret);
+			ret = j_db_entry_insert(entry, batch, &error);
+			g_assert_true(ret);
+		}
+
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+	}
+}
+
+/**
+ * Runs a single operation.
+ *
+ * \param thread A thread.
+ * \param class  The operation's class.
+ * \param size   The operation's size.
+ * \param batch  A batch.
+ *
+ * \return The number of bytes transferred.
+ **/
+static guint64
+workload_run(WorkloadThread* thread, WorkloadClass class, guint64 size, JBatch* batch)
+{
+	g_autoptr(GError) error = NULL;
+	guint64 bytes = 0;
+	guint slot;
+	gboolean ret = TRUE;
+
+	slot = g_rand_int_range(thread->rand, 0, WORKLOAD_SLOTS);
+
+	switch (class)
+	{
+		case WORKLOAD_OBJECT_READ:
+			j_object_read(thread->object, thread->buffer, size, slot * workload_get_size_max(WORKLOAD_OBJECT_READ), &bytes, batch);
+			ret = j_batch_execute(batch);
+			break;
+		case WORKLOAD_OBJECT_WRITE:
+			j_object_write(thread->object, thread->buffer, size, slot * workload_get_size_max(WORKLOAD_OBJECT_WRITE), &bytes, batch);
+			ret = j_batch_execute(batch);
+			break;
+		case WORKLOAD_OBJECT_STATUS:
+		{
+			gint64 modification_time;
+			guint64 object_size;
+
+			j_object_status(thread->object, &modification_time, &object_size, batch);
+			ret = j_batch_execute(batch);
+		}
+		break;
+		case WORKLOAD_KV_GET:
+		{
+			g_autofree gpointer value = NULL;
+			guint32 value_len = 0;
+
+			j_kv_get(thread->kv[slot], &value, &value_len, batch);
+			ret = j_batch_execute(batch);
+			bytes = value_len;
+		}
+		break;
+		case WORKLOAD_KV_PUT:
+			j_kv_put(thread->kv[slot], g_malloc0(size), size, g_free, batch);
+			ret = j_batch_execute(batch);
+			bytes = size;
+			break;
+		case WORKLOAD_DB_INSERT:
+		{
+			g_autoptr(JDBEntry) entry = NULL;
+
+			entry = j_db_entry_new(thread->schema, &error);
+			j_db_entry_set_field(entry, "key", &(thread->db_next), 0, &error);
+			j_db_entry_set_field(entry, "value", thread->buffer, size, &error);
+			j_db_entry_insert(entry, batch, &error);
+			ret = j_batch_execute(batch);
+			bytes = size;
+			thread->db_next++;
+		}
+		break;
+		case WORKLOAD_DB_QUERY:
+		{
+			g_autoptr(JDBSelector) selector = NULL;
+			g_autoptr(JDBIterator) iterator = NULL;
+			guint64 key = slot;
+
+			selector = j_db_selector_new(thread->schema, J_DB_SELECTOR_MODE_AND, &error);
+			j_db_selector_add_field(selector, "key", J_DB_SELECTOR_OPERATOR_EQ, &key, 0, &error);
+			iterator = j_db_iterator_new(thread->schema, selector, &error);
+			ret = (iterator != NULL && j_db_iterator_next(iterator, &error));
+		}
+		break;
+		case WORKLOAD_CLASSES:
+		default:
+			g_assert_not_reached();
+	}
+
+	g_assert_true(ret);
+	g_assert_null(error);
+
+	return bytes;
+}
+
+static void
+workload_teardown(WorkloadThread* thread, JBatch* batch)
+{
+	g_autoptr(GError) error = NULL;
+	gboolean ret;
+
+	if (thread->object != NULL)
+	{
+		j_object_delete(thread->object, batch);
+	}
+
+	for (guint i = 0; i < WORKLOAD_SLOTS; i++)
+	{
+		if (thread->kv[i] != NULL)
+		{
+			j_kv_delete(thread->kv[i], batch);
+		}
+	}
+
+	if (thread->schema != NULL)
+	{
+		j_db_schema_delete(thread->schema, batch, &error);
+	}
+
+	// Keys that have never been put do not exist, so deleting them is allowed to fail.
+	ret = j_batch_execute(batch);
+	(void)ret;
+
+	if (thread->object != NULL)
+	{
+		j_object_unref(thread->object);
+	}
+
+	for (guint i = 0; i < WORKLOAD_SLOTS; i++)
+	{
+		if (thread->kv[i] != NULL)
+		{
+			j_kv_unref(thread->kv[i]);
+		}
+	}
+
+	if (thread->schema != NULL)
+	{
+		j_db_schema_unref(thread->schema);
+	}
+
+	g_rand_free(thread->rand);
+	g_free(thread->buffer);
+}
+
+static gpointer
+workload_thread_func(gpointer data)
+{
+	WorkloadThread* thread = data;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	gint64 end_time;
+
+	semantics = j_benchmark_get_semantics();
+	batch = j_batch_new(semantics);
+
+	workload_setup(thread, batch);
+
+	g_mutex_lock(&(thread->start->mutex));
+	thread->start->ready++;
+	g_cond_broadcast(&(thread->start->cond));
+
+	while (!thread->start->started)
+	{
+		g_cond_wait(&(thread->start->cond), &(thread->start->mutex));
+	}
+
+	end_time = thread->start->end_time;
+	g_mutex_unlock(&(thread->start->mutex));
+
+	while (g_get_monotonic_time() < end_time)
+	{
+		WorkloadClass class;
+		gint64 delay;
+		gint64 start_time;
+		gint64 latency;
+		guint64 size;
+
+		class = workload_get_class(thread, &delay);
+		size = workload_get_size(thread, class);
+
+		// Long gaps in traces must not delay the end of the benchmark.
+		delay = MIN(delay, end_time - g_get_monotonic_time());
+
+		if (delay > 0)
+		{
+			g_usleep(delay);
+		}
+
+		start_time = g_get_monotonic_time();
+		thread->bytes[class] += workload_run(thread, class, size, batch);
+		latency = g_get_monotonic_time() - start_time;
+
+		g_array_append_val(thread->latencies[class], latency);
+		thread->operations[class]++;
+	}
+
+	return NULL;
+}
+
+static void
+benchmark_workload_mixed(BenchmarkRun* run)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autofree WorkloadThread* threads = NULL;
+	g_autofree GThread** handles = NULL;
+	WorkloadStart start;
+
+	g_mutex_init(&(start.mutex));
+	g_cond_init(&(start.cond));
+	start.ready = 0;
+	start.started = FALSE;
+	start.end_time = 0;
+
+	workload.trace_next = 0;
+
+	threads = g_new0(WorkloadThread, run->threads);
+	handles = g_new(GThread*, run->threads);
+
+	for (guint i = 0; i < run->threads; i++)
+	{
+		threads[i].start = &start;
+		threads[i].id = i;
+		// Seed deterministically so that runs are repeatable.
+		threads[i].rand = g_rand_new_with_seed(i);
+
+		for (guint j = 0; j < WORKLOAD_CLASSES; j++)
+		{
+			threads[i].latencies[j] = g_array_new(FALSE, FALSE, sizeof(gint64));
+		}
+
+		handles[i] = g_thread_new("JBenchmarkWorkload", workload_thread_func, &(threads[i]));
+	}
+
+	g_mutex_lock(&(start.mutex));
+
+	while (start.ready < run->threads)
+	{
+		g_cond_wait(&(start.cond), &(start.mutex));
+	}
+
+	j_benchmark_timer_start(run);
+
+	start.started = TRUE;
+	start.end_time = g_get_monotonic_time() + j_benchmark_get_duration() * G_USEC_PER_SEC;
+	g_cond_broadcast(&(start.cond));
+	g_mutex_unlock(&(start.mutex));
+
+	for (guint i = 0; i < run->threads; i++)
+	{
+		g_thread_join(handles[i]);
+	}
+
+	j_benchmark_timer_stop(run);
+
+	semantics = j_benchmark_get_semantics();
+	batch = j_batch_new(semantics);
+
+	for (guint i = 0; i < run->threads; i++)
+	{
+		workload_teardown(&(threads[i]), batch);
+
+		for (guint j = 0; j < run->classes->len; j++)
+		{
+			BenchmarkRun* class_run = g_ptr_array_index(run->classes, j);
+			WorkloadClass class = workload.classes[j];
+			GArray* latencies = threads[i].latencies[class];
+
+			class_run->operations += threads[i].operations[class];
+			class_run->bytes += threads[i].bytes[class];
+
+			for (guint k = 0; k < latencies->len; k++)
+			{
+				gdouble latency = (gdouble)g_array_index(latencies, gint64, k) / G_USEC_PER_SEC;
+
+				j_benchmark_add_latency(class_run, latency);
+				j_benchmark_add_latency(run, latency);
+			}
+		}
+
+		for (guint j = 0; j < WORKLOAD_CLASSES; j++)
+		{
+			run->operations += threads[i].operations[j];
+			run->bytes += threads[i].bytes[j];
+			g_array_unref(threads[i].latencies[j]);
+		}
+	}
+
+	g_cond_clear(&(start.cond));
+	g_mutex_clear(&(start.mutex));
+}
+
+void
+benchmark_workload(void)
+{
+	gchar const* classes[WORKLOAD_CLASSES + 1];
+	gchar const* mix;
+	gchar const* trace;
+	guint n = 0;
+
+	mix = j_benchmark_get_workload();
+	trace = j_benchmark_get_workload_trace();
+
+	if (mix == NULL)
+	{
+		mix = "object-read=70:4K-1M,object-write=20:4K-1M,object-status=10";
+	}
+
+	if (!workload_parse_mix(mix))
+	{
+		g_printerr("Error: Invalid workload %s\n", mix);
+
+		return;
+	}
+
+	if (trace != NULL && !workload_parse_trace(trace))
+	{
+		return;
+	}
+
+	for (guint i = 0; i < WORKLOAD_CLASSES; i++)
+	{
+		if (workload.used[i])
+		{
+			classes[n] = workload_class_names[i];
+			workload.classes[n] = i;
+			n++;
+
+			workload.size_max = MAX(workload.size_max, workload_get_size_max(i));
+		}
+	}
+
+	classes[n] = NULL;
+
+	j_benchmark_add_workload((trace != NULL) ? "/workload/trace" : "/workload/mixed", benchmark_workload_mixed, classes);
+}
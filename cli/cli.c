@@ -36,6 +36,53 @@ j_cmd_arguments_length(gchar const** arguments)
 	return i;
 }
 
+/**
+ * Parses a size with an optional binary suffix, such as 4M.
+ *
+ * \param string A string.
+ * \param size   Returns the size.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+j_cmd_parse_size(gchar const* string, guint64* size)
+{
+	gchar* end = NULL;
+	guint64 value;
+
+	value = g_ascii_strtoull(string, &end, 10);
+
+	if (end == string)
+	{
+		return FALSE;
+	}
+
+	switch (g_ascii_toupper(*end))
+	{
+		case 'G':
+			value *= 1024;
+			// fall through
+		case 'M':
+			value *= 1024;
+			// fall through
+		case 'K':
+			value *= 1024;
+			end++;
+			break;
+		default:
+			break;
+	}
+
+	if (*end != '\0' || value == 0)
+	{
+		return FALSE;
+	}
+
+	*size = value;
+
+	return TRUE;
+}
+
 void
 j_cmd_usage(void)
 {
@@ -45,14 +92,16 @@ j_cmd_usage(void)
 	g_print("Commands:\n");
 	g_print("  create      uri\n");
 	g_print("  create-all  uri\n");
-	g_print("  copy        src-uri dst-uri\n");
+	g_print("  copy        [--recursive] [--block-size=size] [--queue-depth=n] [--jobs=n] src-uri dst-uri\n");
 	g_print("  delete      uri\n");
+	g_print("  export      [--block-size=size] [--jobs=n] [--progress] namespace-uri|collection-uri directory\n");
+	g_print("  import      [--block-size=size] [--jobs=n] [--batch-size=n] [--direct] [--progress] directory namespace-uri|collection-uri\n");
 	g_print("  list        uri\n");
-	g_print("  status      uri\n");
+	g_print("  status      [uri]\n");
 	g_print("\n");
 	g_print("URIs:\n");
 	g_print("  object://index/namespace[/name]\n");
-	g_print("  dobject://namespace/name\n");
+	g_print("  dobject://namespace[/name]\n");
 	g_print("  kv://index/namespace[/key]\n");
 	g_print("  julea://collection[/item]\n");
 	g_print("  file://path\n");
@@ -91,7 +140,7 @@ main(int argc, char** argv)
 	basename = g_path_get_basename(argv[0]);
 	g_set_prgname(basename);
 
-	if (argc <= 2)
+	if (argc < 2)
 	{
 		j_cmd_usage();
 		return 1;
@@ -124,6 +173,14 @@ main(int argc, char** argv)
 	{
 		success = j_cmd_delete(arguments);
 	}
+	else if (g_strcmp0(command, "export") == 0)
+	{
+		success = j_cmd_export(arguments);
+	}
+	else if (g_strcmp0(command, "import") == 0)
+	{
+		success = j_cmd_import(arguments);
+	}
 	else if (g_strcmp0(command, "list") == 0)
 	{
 		success = j_cmd_list(arguments);
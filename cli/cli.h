@@ -26,11 +26,14 @@
 void j_cmd_usage(void);
 
 guint j_cmd_arguments_length(gchar const**);
+gboolean j_cmd_parse_size(gchar const*, guint64*);
 
 gboolean j_cmd_error_last(JURI*);
 
 gboolean j_cmd_create(gchar const**, gboolean);
 gboolean j_cmd_copy(gchar const**);
 gboolean j_cmd_delete(gchar const**);
+gboolean j_cmd_export(gchar const**);
+gboolean j_cmd_import(gchar const**);
 gboolean j_cmd_list(gchar const**);
 gboolean j_cmd_status(gchar const**);
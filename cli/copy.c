@@ -22,32 +22,478 @@
 
 #include <gio/gio.h>
 
+#include <string.h>
+
+/**
+ * The default number of bytes copied per block.
+ **/
+#define J_CMD_COPY_BLOCK_SIZE (4 * 1024 * 1024)
+
+/**
+ * The default number of blocks in flight.
+ * Consecutive blocks usually reside on different servers, so they are transferred concurrently.
+ **/
+#define J_CMD_COPY_QUEUE_DEPTH 8
+
+/**
+ * The default number of items copied concurrently by recursive copies.
+ **/
+#define J_CMD_COPY_JOBS 4
+
+/**
+ * One end of a copy, exactly one of the members is set.
+ **/
+struct JCmdCopyEndpoint
+{
+	JObject* object;
+	JDistributedObject* distributed_object;
+	JItem* item;
+	GFileIOStream* stream;
+};
+
+typedef struct JCmdCopyEndpoint JCmdCopyEndpoint;
+
+/**
+ * A block of the copy pipeline.
+ **/
+struct JCmdCopySlot
+{
+	JBatch* batch;
+	gchar* buffer;
+	guint64 offset;
+	guint64 nbytes;
+	guint64 written;
+
+	/**
+	 * The result of the last operation, set by the asynchronous callback.
+	 **/
+	gboolean ret;
+};
+
+typedef struct JCmdCopySlot JCmdCopySlot;
+
+struct JCmdCopyOptions
+{
+	guint64 block_size;
+	guint queue_depth;
+	guint jobs;
+	gboolean recursive;
+};
+
+typedef struct JCmdCopyOptions JCmdCopyOptions;
+
+struct JCmdCopyJob
+{
+	JItem* source;
+	JCollection* destination;
+	JCmdCopyOptions const* options;
+	gint* failed;
+};
+
+typedef struct JCmdCopyJob JCmdCopyJob;
+
+static void
+j_cmd_copy_callback(JBatch* batch, gboolean ret, gpointer user_data)
+{
+	JCmdCopySlot* slot = user_data;
+
+	(void)batch;
+
+	slot->ret = ret;
+}
+
+static void
+j_cmd_copy_start_read(JCmdCopyEndpoint const* source, JCmdCopySlot* slot, guint64 offset, guint64 block_size)
+{
+	slot->offset = offset;
+	slot->nbytes = 0;
+	slot->ret = TRUE;
+
+	if (source->stream != NULL)
+	{
+		GInputStream* input;
+		gsize nbytes = 0;
+
+		// Streams are read in order, which the pipeline guarantees by starting reads in ascending order.
+		input = g_io_stream_get_input_stream(G_IO_STREAM(source->stream));
+		slot->ret = g_input_stream_read_all(input, slot->buffer, block_size, &nbytes, NULL, NULL);
+		slot->nbytes = nbytes;
+
+		return;
+	}
+
+	if (source->object != NULL)
+	{
+		j_object_read(source->object, slot->buffer, block_size, offset, &(slot->nbytes), slot->batch);
+	}
+	else if (source->distributed_object != NULL)
+	{
+		j_distributed_object_read(source->distributed_object, slot->buffer, block_size, offset, &(slot->nbytes), slot->batch);
+	}
+	else if (source->item != NULL)
+	{
+		j_item_read(source->item, slot->buffer, block_size, offset, &(slot->nbytes), slot->batch);
+	}
+
+	j_batch_execute_async(slot->batch, j_cmd_copy_callback, slot);
+}
+
+static void
+j_cmd_copy_start_write(JCmdCopyEndpoint const* destination, JCmdCopySlot* slot)
+{
+	slot->ret = TRUE;
+
+	if (slot->nbytes == 0)
+	{
+		return;
+	}
+
+	if (destination->stream != NULL)
+	{
+		GOutputStream* output;
+
+		output = g_io_stream_get_output_stream(G_IO_STREAM(destination->stream));
+		slot->ret = g_output_stream_write_all(output, slot->buffer, slot->nbytes, NULL, NULL, NULL);
+
+		return;
+	}
+
+	if (destination->object != NULL)
+	{
+		j_object_write(destination->object, slot->buffer, slot->nbytes, slot->offset, &(slot->written), slot->batch);
+	}
+	else if (destination->distributed_object != NULL)
+	{
+		j_distributed_object_write(destination->distributed_object, slot->buffer, slot->nbytes, slot->offset, &(slot->written), slot->batch);
+	}
+	else if (destination->item != NULL)
+	{
+		j_item_write(destination->item, slot->buffer, slot->nbytes, slot->offset, &(slot->written), slot->batch);
+	}
+
+	j_batch_execute_async(slot->batch, j_cmd_copy_callback, slot);
+}
+
+/**
+ * Copies all data from one endpoint to another.
+ * Up to queue_depth blocks are in flight at once, a block is written as soon as it has been read.
+ *
+ * \param source      The source.
+ * \param destination The destination.
+ * \param options     The copy options.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+/**
+ * Clones the source if both endpoints are objects of the same kind.
+ * The servers share the data between both objects if their backends support it, so nothing has to be transferred.
+ *
+ * \param source      The source.
+ * \param destination The destination.
+ * \param ret         Returns whether the clone succeeded.
+ *
+ * \return TRUE if the source has been cloned, FALSE if the data has to be copied.
+ **/
+static gboolean
+j_cmd_copy_clone(JCmdCopyEndpoint const* source, JCmdCopyEndpoint const* destination, gboolean* ret)
+{
+	g_autoptr(JBatch) batch = NULL;
+
+	if (source->object != NULL && destination->object != NULL)
+	{
+		batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+		j_object_clone(source->object, destination->object, batch);
+	}
+	else if (source->distributed_object != NULL && destination->distributed_object != NULL)
+	{
+		batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+		j_distributed_object_clone(source->distributed_object, destination->distributed_object, batch);
+	}
+	else
+	{
+		return FALSE;
+	}
+
+	*ret = j_batch_execute(batch);
+
+	return TRUE;
+}
+
+static gboolean
+j_cmd_copy_data(JCmdCopyEndpoint const* source, JCmdCopyEndpoint const* destination, JCmdCopyOptions const* options)
+{
+	gboolean ret = TRUE;
+	JCmdCopySlot* slots;
+	JCmdCopySlot* previous = NULL;
+	guint64 offset = 0;
+
+	if (j_cmd_copy_clone(source, destination, &ret))
+	{
+		return ret;
+	}
+
+	slots = g_new0(JCmdCopySlot, options->queue_depth);
+
+	for (guint i = 0; i < options->queue_depth; i++)
+	{
+		slots[i].batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+		slots[i].buffer = g_malloc(options->block_size);
+	}
+
+	for (guint i = 0; i < options->queue_depth; i++)
+	{
+		j_cmd_copy_start_read(source, &slots[i], offset, options->block_size);
+		offset += options->block_size;
+	}
+
+	// Blocks are completed in order, which keeps stream destinations sequential.
+	for (guint i = 0;; i = (i + 1) % options->queue_depth)
+	{
+		JCmdCopySlot* slot = &slots[i];
+		gboolean done;
+
+		j_batch_wait(slot->batch);
+
+		if (!slot->ret)
+		{
+			ret = FALSE;
+			break;
+		}
+
+		done = (slot->nbytes < options->block_size);
+		j_cmd_copy_start_write(destination, slot);
+
+		// The previous block's buffer can be reused once it has been written, while the others are still in flight.
+		if (previous != NULL)
+		{
+			j_batch_wait(previous->batch);
+
+			if (!previous->ret)
+			{
+				ret = FALSE;
+				break;
+			}
+
+			if (!done)
+			{
+				j_cmd_copy_start_read(source, previous, offset, options->block_size);
+				offset += options->block_size;
+			}
+		}
+
+		if (done)
+		{
+			j_batch_wait(slot->batch);
+			ret = slot->ret;
+			break;
+		}
+
+		previous = slot;
+	}
+
+	for (guint i = 0; i < options->queue_depth; i++)
+	{
+		// Reads beyond the end might still be in flight.
+		j_batch_wait(slots[i].batch);
+		j_batch_unref(slots[i].batch);
+		g_free(slots[i].buffer);
+	}
+
+	g_free(slots);
+
+	return ret;
+}
+
+static void
+j_cmd_copy_job(gpointer data, gpointer user_data)
+{
+	JCmdCopyJob* job = data;
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JItem) copy = NULL;
+
+	(void)user_data;
+
+	// Items are cloned, so only metadata has to be copied if the object backends can share data
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_item_get_status(job->source, batch);
+	j_batch_execute(batch);
+
+	copy = j_item_clone(job->source, job->destination, j_item_get_name(job->source), batch);
+
+	if (copy == NULL || !j_batch_execute(batch))
+	{
+		g_print("Error: Could not copy item “%s”.\n", j_item_get_name(job->source));
+		g_atomic_int_set(job->failed, 1);
+	}
+
+	j_item_unref(job->source);
+	j_collection_unref(job->destination);
+
+	g_slice_free(JCmdCopyJob, job);
+}
+
+/**
+ * Copies all items of a collection into another one, creating it if necessary.
+ *
+ * \param source      The source URI.
+ * \param destination The destination URI.
+ * \param options     The copy options.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_cmd_copy_collection(JURI* source, JURI* destination, JCmdCopyOptions const* options)
+{
+	g_autoptr(JItemIterator) iterator = NULL;
+	GThreadPool* pool;
+	GError* error = NULL;
+	gint failed = 0;
+
+	if (!j_uri_get(source, &error))
+	{
+		g_print("Error: %s\n", error->message);
+		g_error_free(error);
+		return FALSE;
+	}
+
+	if (!j_uri_get(destination, NULL) && !j_uri_create(destination, FALSE, &error))
+	{
+		g_print("Error: %s\n", error->message);
+		g_error_free(error);
+		return FALSE;
+	}
+
+	pool = g_thread_pool_new(j_cmd_copy_job, NULL, options->jobs, TRUE, NULL);
+	iterator = j_item_iterator_new(j_uri_get_collection(source));
+
+	while (j_item_iterator_next(iterator))
+	{
+		JCmdCopyJob* job;
+
+		job = g_slice_new(JCmdCopyJob);
+		job->source = j_item_iterator_get(iterator);
+		job->destination = j_collection_ref(j_uri_get_collection(destination));
+		job->options = options;
+		job->failed = &failed;
+
+		g_thread_pool_push(pool, job, NULL);
+	}
+
+	g_thread_pool_free(pool, FALSE, TRUE);
+
+	return (g_atomic_int_get(&failed) == 0);
+}
+
+/**
+ * Parses the copy options preceding the URIs.
+ *
+ * \param arguments The arguments.
+ * \param options   Returns the options.
+ *
+ * \return The remaining arguments, NULL on error.
+ **/
+static gchar const**
+j_cmd_copy_parse_options(gchar const** arguments, JCmdCopyOptions* options)
+{
+	options->block_size = J_CMD_COPY_BLOCK_SIZE;
+	options->queue_depth = J_CMD_COPY_QUEUE_DEPTH;
+	options->jobs = J_CMD_COPY_JOBS;
+	options->recursive = FALSE;
+
+	for (; *arguments != NULL && g_str_has_prefix(*arguments, "-"); arguments++)
+	{
+		gchar const* argument = *arguments;
+
+		if (g_strcmp0(argument, "--") == 0)
+		{
+			arguments++;
+			break;
+		}
+		else if (g_strcmp0(argument, "-r") == 0 || g_strcmp0(argument, "--recursive") == 0)
+		{
+			options->recursive = TRUE;
+		}
+		else if (g_str_has_prefix(argument, "--block-size="))
+		{
+			if (!j_cmd_parse_size(argument + strlen("--block-size="), &(options->block_size)))
+			{
+				return NULL;
+			}
+		}
+		else if (g_str_has_prefix(argument, "--queue-depth="))
+		{
+			options->queue_depth = g_ascii_strtoull(argument + strlen("--queue-depth="), NULL, 10);
+
+			if (options->queue_depth == 0)
+			{
+				return NULL;
+			}
+		}
+		else if (g_str_has_prefix(argument, "--jobs="))
+		{
+			options->jobs = g_ascii_strtoull(argument + strlen("--jobs="), NULL, 10);
+
+			if (options->jobs == 0)
+			{
+				return NULL;
+			}
+		}
+		else
+		{
+			return NULL;
+		}
+	}
+
+	return arguments;
+}
+
 gboolean
 j_cmd_copy(gchar const** arguments)
 {
 	gboolean ret = TRUE;
 	JObjectURI* ouri[2] = { NULL, NULL };
+	JObjectURI* duri[2] = { NULL, NULL };
 	JURI* uri[2] = { NULL, NULL };
+	JCmdCopyEndpoint endpoint[2] = { { NULL, NULL, NULL, NULL }, { NULL, NULL, NULL, NULL } };
+	JCmdCopyOptions options;
 	GError* error;
 	GFile* file;
-	GFileIOStream* stream[2] = { NULL, NULL };
-	g_autofree gchar* buffer = NULL;
-	guint64 offset;
+	gboolean cloned = FALSE;
 	guint i;
 
-	if (j_cmd_arguments_length(arguments) != 2)
+	arguments = j_cmd_copy_parse_options(arguments, &options);
+
+	if (arguments == NULL || j_cmd_arguments_length(arguments) != 2)
 	{
 		ret = FALSE;
 		j_cmd_usage();
 		goto end;
 	}
 
+	if (options.recursive)
+	{
+		uri[0] = j_uri_new(arguments[0]);
+		uri[1] = j_uri_new(arguments[1]);
+
+		if (uri[0] == NULL || uri[1] == NULL || j_uri_get_item_name(uri[0]) != NULL || j_uri_get_item_name(uri[1]) != NULL)
+		{
+			ret = FALSE;
+			j_cmd_usage();
+			goto end;
+		}
+
+		ret = j_cmd_copy_collection(uri[0], uri[1], &options);
+		goto end;
+	}
+
 	for (i = 0; i <= 1; i++)
 	{
 		g_autoptr(JBatch) batch = NULL;
 
 		if ((ouri[i] = j_object_uri_new(arguments[i], J_OBJECT_URI_SCHEME_OBJECT)) != NULL)
 		{
+			endpoint[i].object = j_object_uri_get_object(ouri[i]);
+
 			if (i == 0)
 			{
 				// FIXME check whether object exists
@@ -55,7 +501,23 @@ j_cmd_copy(gchar const** arguments)
 			else if (i == 1)
 			{
 				batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
-				j_object_create(j_object_uri_get_object(ouri[i]), batch);
+				j_object_create(endpoint[i].object, batch);
+
+				if (!j_batch_execute(batch))
+				{
+					ret = FALSE;
+					goto end;
+				}
+			}
+		}
+		else if ((duri[i] = j_object_uri_new(arguments[i], J_OBJECT_URI_SCHEME_DISTRIBUTED_OBJECT)) != NULL)
+		{
+			endpoint[i].distributed_object = j_object_uri_get_distributed_object(duri[i]);
+
+			if (i == 1)
+			{
+				batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+				j_distributed_object_create(endpoint[i].distributed_object, batch);
 
 				if (!j_batch_execute(batch))
 				{
@@ -114,7 +576,17 @@ j_cmd_copy(gchar const** arguments)
 				}
 
 				batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
-				item = j_item_create(j_uri_get_collection(uri[i]), j_uri_get_item_name(uri[i]), NULL, batch);
+
+				if (endpoint[0].item != NULL)
+				{
+					// Items are cloned, so that no data has to be copied
+					item = j_item_clone(endpoint[0].item, j_uri_get_collection(uri[i]), j_uri_get_item_name(uri[i]), batch);
+					cloned = TRUE;
+				}
+				else
+				{
+					item = j_item_create(j_uri_get_collection(uri[i]), j_uri_get_item_name(uri[i]), NULL, batch);
+				}
 
 				if (!j_batch_execute(batch))
 				{
@@ -124,6 +596,8 @@ j_cmd_copy(gchar const** arguments)
 
 				j_uri_get(uri[i], NULL);
 			}
+
+			endpoint[i].item = j_uri_get_item(uri[i]);
 		}
 		else
 		{
@@ -133,16 +607,16 @@ j_cmd_copy(gchar const** arguments)
 
 			if (i == 0)
 			{
-				stream[i] = g_file_open_readwrite(file, NULL, &error);
+				endpoint[i].stream = g_file_open_readwrite(file, NULL, &error);
 			}
 			else if (i == 1)
 			{
-				stream[i] = g_file_create_readwrite(file, G_FILE_CREATE_NONE, NULL, &error);
+				endpoint[i].stream = g_file_create_readwrite(file, G_FILE_CREATE_NONE, NULL, &error);
 			}
 
 			g_object_unref(file);
 
-			if (stream[i] == NULL)
+			if (endpoint[i].stream == NULL)
 			{
 				ret = FALSE;
 
@@ -157,102 +631,17 @@ j_cmd_copy(gchar const** arguments)
 		}
 	}
 
-	offset = 0;
-	buffer = g_new(gchar, 1024 * 1024);
-
-	while (TRUE)
+	if (!cloned)
 	{
-		g_autoptr(JBatch) batch = NULL;
-		guint64 bytes_read = 0;
-
-		batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
-
-		if (ouri[0] != NULL)
-		{
-			guint64 nbytes;
-
-			j_object_read(j_object_uri_get_object(ouri[0]), buffer, 1024 * 1024, offset, &nbytes, batch);
-
-			if (!j_batch_execute(batch))
-			{
-				ret = FALSE;
-				goto end;
-			}
-
-			bytes_read = nbytes;
-		}
-		else if (uri[0] != NULL)
-		{
-			guint64 nbytes;
-
-			j_item_read(j_uri_get_item(uri[0]), buffer, 1024 * 1024, offset, &nbytes, batch);
-
-			if (!j_batch_execute(batch))
-			{
-				ret = FALSE;
-				goto end;
-			}
-
-			bytes_read = nbytes;
-		}
-		else if (stream[0] != NULL)
-		{
-			GInputStream* input;
-			gsize nbytes;
-
-			input = g_io_stream_get_input_stream(G_IO_STREAM(stream[0]));
-
-			g_input_stream_read_all(input, buffer, 1024 * 1024, &nbytes, NULL, NULL);
-			bytes_read = nbytes;
-		}
-
-		if (ouri[1] != NULL)
-		{
-			guint64 dummy;
-
-			j_object_write(j_object_uri_get_object(ouri[1]), buffer, bytes_read, offset, &dummy, batch);
-
-			if (!j_batch_execute(batch))
-			{
-				ret = FALSE;
-				goto end;
-			}
-		}
-		else if (uri[1] != NULL)
-		{
-			guint64 dummy;
-
-			j_item_write(j_uri_get_item(uri[1]), buffer, bytes_read, offset, &dummy, batch);
-
-			if (!j_batch_execute(batch))
-			{
-				ret = FALSE;
-				goto end;
-			}
-		}
-		else if (stream[1] != NULL)
-		{
-			GOutputStream* output;
-
-			output = g_io_stream_get_output_stream(G_IO_STREAM(stream[1]));
-
-			g_output_stream_write_all(output, buffer, bytes_read, NULL, NULL, NULL);
-		}
-
-		offset += bytes_read;
-
-		if (bytes_read < 1024 * 1024)
-		{
-			break;
-		}
+		ret = j_cmd_copy_data(&endpoint[0], &endpoint[1], &options);
 	}
 
 end:
 	for (i = 0; i <= 1; i++)
 	{
-		if (stream[i] != NULL)
+		if (endpoint[i].stream != NULL)
 		{
-			g_object_unref(stream[i]);
+			g_object_unref(endpoint[i].stream);
 		}
 
 		if (ouri[i] != NULL)
@@ -260,6 +649,11 @@ end:
 			j_object_uri_free(ouri[i]);
 		}
 
+		if (duri[i] != NULL)
+		{
+			j_object_uri_free(duri[i]);
+		}
+
 		if (uri[i] != NULL)
 		{
 			j_uri_free(uri[i]);
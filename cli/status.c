@@ -20,6 +20,86 @@
 
 #include "cli.h"
 
+/**
+ * The number of pings sent to each server to measure its latency.
+ **/
+#define J_CMD_STATUS_PINGS 10
+
+/**
+ * Pings all servers and prints their client-side statistics.
+ **/
+static gboolean
+j_cmd_status_servers(void)
+{
+	JBackendType backends[] = { J_BACKEND_TYPE_OBJECT, J_BACKEND_TYPE_KV, J_BACKEND_TYPE_DB };
+	gchar const* names[] = { "object", "kv", "db" };
+	JConfiguration* configuration;
+	gboolean ret = TRUE;
+
+	configuration = j_configuration();
+
+	for (guint b = 0; b < G_N_ELEMENTS(backends); b++)
+	{
+		for (guint i = 0; i < j_configuration_get_server_count(configuration, backends[b]); i++)
+		{
+			JConnectionPoolServerStatistics statistics;
+			g_autofree gchar* bytes_string = NULL;
+			gpointer connection;
+
+			connection = j_connection_pool_pop(backends[b], i);
+
+			for (guint p = 0; p < J_CMD_STATUS_PINGS && connection != NULL; p++)
+			{
+				g_autoptr(JMessage) message = NULL;
+				g_autoptr(JMessage) reply = NULL;
+
+				message = j_message_new(J_MESSAGE_PING, 0);
+
+				if (!j_message_send(message, connection))
+				{
+					break;
+				}
+
+				reply = j_message_new_reply(message);
+
+				if (!j_message_receive(reply, connection))
+				{
+					break;
+				}
+			}
+
+			if (connection != NULL)
+			{
+				j_connection_pool_push(backends[b], i, connection);
+			}
+
+			if (!j_connection_pool_get_server_statistics(backends[b], i, &statistics))
+			{
+				continue;
+			}
+
+			bytes_string = g_format_size(statistics.bytes);
+
+			g_print("%-6s %u %s\n", names[b], i, j_configuration_get_server(configuration, backends[b], i));
+			g_print("  Replies:           %" G_GUINT64_FORMAT "\n", statistics.replies);
+			g_print("  Errors:            %" G_GUINT64_FORMAT "\n", statistics.errors);
+			g_print("  Transferred:       %s\n", bytes_string);
+
+			if (statistics.replies > 0)
+			{
+				g_print("  Latency:           %" G_GUINT64_FORMAT " µs (%.1f µs on average, %" G_GUINT64_FORMAT " µs maximum)\n", statistics.latency, (gdouble)statistics.latency_total / (gdouble)statistics.replies, statistics.latency_max);
+			}
+
+			if (statistics.errors > 0 || statistics.replies == 0)
+			{
+				ret = FALSE;
+			}
+		}
+	}
+
+	return ret;
+}
+
 gboolean
 j_cmd_status(gchar const** arguments)
 {
@@ -31,6 +111,12 @@ j_cmd_status(gchar const** arguments)
 	g_autoptr(JURI) uri = NULL;
 	GError* error = NULL;
 
+	if (j_cmd_arguments_length(arguments) == 0)
+	{
+		ret = j_cmd_status_servers();
+		goto end;
+	}
+
 	if (j_cmd_arguments_length(arguments) != 1)
 	{
 		ret = FALSE;
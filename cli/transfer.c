@@ -0,0 +1,1034 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Required for O_DIRECT
+#define _GNU_SOURCE
+
+#include <julea-config.h>
+
+#include "cli.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+/**
+ * The default number of bytes transferred per block.
+ **/
+#define J_CMD_TRANSFER_BLOCK_SIZE (4 * 1024 * 1024)
+
+/**
+ * The default number of files transferred concurrently.
+ **/
+#define J_CMD_TRANSFER_JOBS 8
+
+/**
+ * The default number of objects or items created per batch.
+ **/
+#define J_CMD_TRANSFER_BATCH_SIZE 256
+
+/**
+ * The alignment required for O_DIRECT.
+ **/
+#define J_CMD_TRANSFER_DIRECT_ALIGNMENT 4096
+
+struct JCmdTransferOptions
+{
+	guint64 block_size;
+	guint jobs;
+	guint batch_size;
+	gboolean direct;
+	gboolean progress;
+};
+
+typedef struct JCmdTransferOptions JCmdTransferOptions;
+
+/**
+ * The JULEA side of a transfer, exactly one of the URIs is set.
+ **/
+struct JCmdTransferTarget
+{
+	JObjectURI* object_uri;
+	JObjectURI* distributed_object_uri;
+	JURI* uri;
+};
+
+typedef struct JCmdTransferTarget JCmdTransferTarget;
+
+/**
+ * Shared state of a transfer.
+ **/
+struct JCmdTransfer
+{
+	JCmdTransferOptions options;
+	JCmdTransferTarget target;
+
+	/**
+	 * The local directory.
+	 **/
+	gchar* directory;
+
+	/**
+	 * Protects bytes.
+	 **/
+	GMutex mutex;
+	guint64 bytes;
+
+	gint files;
+	gint failed;
+	gint done;
+};
+
+typedef struct JCmdTransfer JCmdTransfer;
+
+/**
+ * A file to transfer, exactly one of object, distributed_object and item is set.
+ **/
+struct JCmdTransferFile
+{
+	JCmdTransfer* transfer;
+
+	/**
+	 * The path relative to the directory, also used as the name.
+	 **/
+	gchar* name;
+
+	JObject* object;
+	JDistributedObject* distributed_object;
+	JItem* item;
+};
+
+typedef struct JCmdTransferFile JCmdTransferFile;
+
+/**
+ * A block buffer with its own batch, so that reads and writes can overlap.
+ **/
+struct JCmdTransferSlot
+{
+	JBatch* batch;
+	gchar* buffer;
+	guint64 offset;
+	guint64 nbytes;
+	guint64 transferred;
+
+	/**
+	 * The result of the last operation, set by the asynchronous callback.
+	 **/
+	gboolean ret;
+};
+
+typedef struct JCmdTransferSlot JCmdTransferSlot;
+
+static void
+j_cmd_transfer_callback(JBatch* batch, gboolean ret, gpointer user_data)
+{
+	JCmdTransferSlot* slot = user_data;
+
+	(void)batch;
+
+	slot->ret = ret;
+}
+
+static void
+j_cmd_transfer_account(JCmdTransfer* transfer, guint64 bytes)
+{
+	g_mutex_lock(&(transfer->mutex));
+	transfer->bytes += bytes;
+	g_mutex_unlock(&(transfer->mutex));
+}
+
+static JCmdTransferFile*
+j_cmd_transfer_file_new(JCmdTransfer* transfer, gchar const* name)
+{
+	JCmdTransferFile* file;
+
+	file = g_slice_new0(JCmdTransferFile);
+	file->transfer = transfer;
+	file->name = g_strdup(name);
+
+	if (transfer->target.object_uri != NULL)
+	{
+		JObjectURI* uri = transfer->target.object_uri;
+
+		file->object = j_object_new_for_index(j_object_uri_get_index(uri), j_object_uri_get_namespace(uri), name);
+	}
+	else if (transfer->target.distributed_object_uri != NULL)
+	{
+		g_autoptr(JDistribution) distribution = NULL;
+
+		// Same distribution as used by JObjectURI
+		distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
+		j_distribution_set(distribution, "start-index", 0);
+
+		file->distributed_object = j_distributed_object_new(j_object_uri_get_namespace(transfer->target.distributed_object_uri), name, distribution);
+	}
+
+	return file;
+}
+
+static void
+j_cmd_transfer_file_free(JCmdTransferFile* file)
+{
+	if (file->object != NULL)
+	{
+		j_object_unref(file->object);
+	}
+
+	if (file->distributed_object != NULL)
+	{
+		j_distributed_object_unref(file->distributed_object);
+	}
+
+	if (file->item != NULL)
+	{
+		j_item_unref(file->item);
+	}
+
+	g_free(file->name);
+	g_slice_free(JCmdTransferFile, file);
+}
+
+static void
+j_cmd_transfer_file_read(JCmdTransferFile* file, JCmdTransferSlot* slot, guint64 length)
+{
+	slot->nbytes = 0;
+	slot->ret = TRUE;
+
+	if (file->object != NULL)
+	{
+		j_object_read(file->object, slot->buffer, length, slot->offset, &(slot->nbytes), slot->batch);
+	}
+	else if (file->distributed_object != NULL)
+	{
+		j_distributed_object_read(file->distributed_object, slot->buffer, length, slot->offset, &(slot->nbytes), slot->batch);
+	}
+	else if (file->item != NULL)
+	{
+		j_item_read(file->item, slot->buffer, length, slot->offset, &(slot->nbytes), slot->batch);
+	}
+
+	j_batch_execute_async(slot->batch, j_cmd_transfer_callback, slot);
+}
+
+static void
+j_cmd_transfer_file_write(JCmdTransferFile* file, JCmdTransferSlot* slot)
+{
+	slot->transferred = 0;
+	slot->ret = TRUE;
+
+	if (file->object != NULL)
+	{
+		j_object_write(file->object, slot->buffer, slot->nbytes, slot->offset, &(slot->transferred), slot->batch);
+	}
+	else if (file->distributed_object != NULL)
+	{
+		j_distributed_object_write(file->distributed_object, slot->buffer, slot->nbytes, slot->offset, &(slot->transferred), slot->batch);
+	}
+	else if (file->item != NULL)
+	{
+		j_item_write(file->item, slot->buffer, slot->nbytes, slot->offset, &(slot->transferred), slot->batch);
+	}
+
+	j_batch_execute_async(slot->batch, j_cmd_transfer_callback, slot);
+}
+
+static void
+j_cmd_transfer_file_create(JCmdTransferFile* file, JBatch* batch)
+{
+	JCmdTransferTarget* target = &(file->transfer->target);
+
+	if (file->object != NULL)
+	{
+		j_object_create(file->object, batch);
+	}
+	else if (file->distributed_object != NULL)
+	{
+		j_distributed_object_create(file->distributed_object, batch);
+	}
+	else if (target->uri != NULL)
+	{
+		file->item = j_item_create(j_uri_get_collection(target->uri), file->name, NULL, batch);
+	}
+}
+
+/**
+ * Reads from a file descriptor, restarting on short reads and interrupts.
+ * If O_DIRECT is rejected for the file, it is disabled and the read is retried.
+ **/
+static gssize
+j_cmd_transfer_pread(gint fd, gpointer buffer, gsize length, guint64 offset)
+{
+	gsize nbytes_total = 0;
+
+	while (nbytes_total < length)
+	{
+		gssize nbytes;
+
+		nbytes = pread(fd, (gchar*)buffer + nbytes_total, length - nbytes_total, offset + nbytes_total);
+
+		if (nbytes == 0)
+		{
+			break;
+		}
+		else if (nbytes < 0)
+		{
+#ifdef O_DIRECT
+			if (errno == EINVAL && (fcntl(fd, F_GETFL) & O_DIRECT))
+			{
+				fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+				continue;
+			}
+#endif
+
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			return -1;
+		}
+
+		nbytes_total += nbytes;
+	}
+
+	return nbytes_total;
+}
+
+static gboolean
+j_cmd_transfer_pwrite(gint fd, gconstpointer buffer, gsize length, guint64 offset)
+{
+	gsize nbytes_total = 0;
+
+	while (nbytes_total < length)
+	{
+		gssize nbytes;
+
+		nbytes = pwrite(fd, (gchar const*)buffer + nbytes_total, length - nbytes_total, offset + nbytes_total);
+
+		if (nbytes < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			return FALSE;
+		}
+
+		nbytes_total += nbytes;
+	}
+
+	return TRUE;
+}
+
+static void
+j_cmd_transfer_slots_init(JCmdTransferSlot* slots, guint64 block_size)
+{
+	for (guint i = 0; i < 2; i++)
+	{
+		slots[i].batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+		// Aligned buffers are required for O_DIRECT and do not hurt otherwise.
+		slots[i].buffer = j_helper_alloc_aligned(J_CMD_TRANSFER_DIRECT_ALIGNMENT, block_size);
+		slots[i].offset = 0;
+		slots[i].nbytes = 0;
+		slots[i].transferred = 0;
+		slots[i].ret = TRUE;
+	}
+}
+
+static void
+j_cmd_transfer_slots_fini(JCmdTransferSlot* slots)
+{
+	for (guint i = 0; i < 2; i++)
+	{
+		j_batch_wait(slots[i].batch);
+		j_batch_unref(slots[i].batch);
+		free(slots[i].buffer);
+	}
+}
+
+/**
+ * Imports a single file.
+ * The next block is read while the previous one is still being written.
+ **/
+static void
+j_cmd_transfer_import_job(gpointer data, gpointer user_data)
+{
+	JCmdTransferFile* file = data;
+	JCmdTransfer* transfer = file->transfer;
+	JCmdTransferSlot slots[2];
+	g_autofree gchar* path = NULL;
+	gboolean ret = TRUE;
+	guint64 offset = 0;
+	gint flags = O_RDONLY;
+	gint fd;
+
+	(void)user_data;
+
+	path = g_build_filename(transfer->directory, file->name, NULL);
+
+#ifdef O_DIRECT
+	if (transfer->options.direct)
+	{
+		flags |= O_DIRECT;
+	}
+#endif
+
+	fd = open(path, flags);
+
+#ifdef O_DIRECT
+	if (fd < 0 && errno == EINVAL && (flags & O_DIRECT))
+	{
+		// Some file systems do not support O_DIRECT.
+		fd = open(path, flags & ~O_DIRECT);
+	}
+#endif
+
+	if (fd < 0)
+	{
+		g_print("Error: Could not open “%s”: %s\n", path, g_strerror(errno));
+		g_atomic_int_set(&(transfer->failed), 1);
+		goto end;
+	}
+
+	j_cmd_transfer_slots_init(slots, transfer->options.block_size);
+
+	for (guint i = 0;; i = 1 - i)
+	{
+		JCmdTransferSlot* slot = &slots[i];
+		gssize nbytes;
+
+		// Wait for the write issued two blocks ago before reusing its buffer.
+		j_batch_wait(slot->batch);
+
+		if (!slot->ret || slot->transferred != slot->nbytes)
+		{
+			ret = FALSE;
+			break;
+		}
+
+		j_cmd_transfer_account(transfer, slot->nbytes);
+		slot->nbytes = 0;
+		slot->transferred = 0;
+
+		nbytes = j_cmd_transfer_pread(fd, slot->buffer, transfer->options.block_size, offset);
+
+		if (nbytes < 0)
+		{
+			ret = FALSE;
+			break;
+		}
+
+		if (nbytes > 0)
+		{
+			slot->offset = offset;
+			slot->nbytes = nbytes;
+			offset += nbytes;
+
+			j_cmd_transfer_file_write(file, slot);
+		}
+
+		if ((guint64)nbytes < transfer->options.block_size)
+		{
+			j_batch_wait(slot->batch);
+			j_batch_wait(slots[1 - i].batch);
+
+			ret = slots[0].ret && slots[1].ret && slots[0].transferred == slots[0].nbytes && slots[1].transferred == slots[1].nbytes;
+
+			if (ret)
+			{
+				j_cmd_transfer_account(transfer, slots[0].nbytes + slots[1].nbytes);
+			}
+
+			break;
+		}
+	}
+
+	j_cmd_transfer_slots_fini(slots);
+	close(fd);
+
+	if (!ret)
+	{
+		g_print("Error: Could not import “%s”.\n", path);
+		g_atomic_int_set(&(transfer->failed), 1);
+	}
+
+end:
+	g_atomic_int_inc(&(transfer->done));
+	j_cmd_transfer_file_free(file);
+}
+
+/**
+ * Exports a single object or item.
+ * The next block is read while the previous one is being written to the file.
+ **/
+static void
+j_cmd_transfer_export_job(gpointer data, gpointer user_data)
+{
+	JCmdTransferFile* file = data;
+	JCmdTransfer* transfer = file->transfer;
+	JCmdTransferSlot slots[2];
+	g_autofree gchar* path = NULL;
+	g_autofree gchar* parent = NULL;
+	gboolean ret = TRUE;
+	guint64 block_size = transfer->options.block_size;
+	gint fd;
+
+	(void)user_data;
+
+	path = g_build_filename(transfer->directory, file->name, NULL);
+	parent = g_path_get_dirname(path);
+
+	if (g_mkdir_with_parents(parent, 0755) != 0 || (fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+	{
+		g_print("Error: Could not create “%s”: %s\n", path, g_strerror(errno));
+		g_atomic_int_set(&(transfer->failed), 1);
+		goto end;
+	}
+
+	j_cmd_transfer_slots_init(slots, block_size);
+
+	slots[0].offset = 0;
+	j_cmd_transfer_file_read(file, &slots[0], block_size);
+
+	for (guint i = 0;; i = 1 - i)
+	{
+		JCmdTransferSlot* slot = &slots[i];
+		gboolean done;
+
+		j_batch_wait(slot->batch);
+
+		if (!slot->ret)
+		{
+			ret = FALSE;
+			break;
+		}
+
+		done = (slot->nbytes < block_size);
+
+		if (!done)
+		{
+			slots[1 - i].offset = slot->offset + block_size;
+			j_cmd_transfer_file_read(file, &slots[1 - i], block_size);
+		}
+
+		if (!j_cmd_transfer_pwrite(fd, slot->buffer, slot->nbytes, slot->offset))
+		{
+			ret = FALSE;
+			break;
+		}
+
+		j_cmd_transfer_account(transfer, slot->nbytes);
+
+		if (done)
+		{
+			break;
+		}
+	}
+
+	j_cmd_transfer_slots_fini(slots);
+
+	if (close(fd) != 0)
+	{
+		ret = FALSE;
+	}
+
+	if (!ret)
+	{
+		g_print("Error: Could not export “%s”.\n", file->name);
+		g_atomic_int_set(&(transfer->failed), 1);
+	}
+
+end:
+	g_atomic_int_inc(&(transfer->done));
+	j_cmd_transfer_file_free(file);
+}
+
+static void
+j_cmd_transfer_print_progress(JCmdTransfer* transfer, gdouble elapsed, gboolean final)
+{
+	g_autofree gchar* size = NULL;
+	g_autofree gchar* rate = NULL;
+	guint64 bytes;
+
+	g_mutex_lock(&(transfer->mutex));
+	bytes = transfer->bytes;
+	g_mutex_unlock(&(transfer->mutex));
+
+	size = g_format_size(bytes);
+	rate = g_format_size((elapsed > 0.0) ? bytes / elapsed : 0);
+
+	g_printerr("\r%d/%d files, %s, %s/s", g_atomic_int_get(&(transfer->done)), g_atomic_int_get(&(transfer->files)), size, rate);
+
+	if (final)
+	{
+		g_printerr("\n");
+	}
+}
+
+struct JCmdTransferReporter
+{
+	JCmdTransfer* transfer;
+	GTimer* timer;
+	GMutex mutex;
+	GCond cond;
+	gboolean stop;
+};
+
+typedef struct JCmdTransferReporter JCmdTransferReporter;
+
+static gpointer
+j_cmd_transfer_reporter(gpointer data)
+{
+	JCmdTransferReporter* reporter = data;
+
+	g_mutex_lock(&(reporter->mutex));
+
+	while (!reporter->stop)
+	{
+		gint64 end_time;
+
+		end_time = g_get_monotonic_time() + G_TIME_SPAN_SECOND;
+
+		if (!g_cond_wait_until(&(reporter->cond), &(reporter->mutex), end_time))
+		{
+			j_cmd_transfer_print_progress(reporter->transfer, g_timer_elapsed(reporter->timer, NULL), FALSE);
+		}
+	}
+
+	g_mutex_unlock(&(reporter->mutex));
+
+	return NULL;
+}
+
+/**
+ * Runs files through a thread pool, creating the files in batches first if requested.
+ *
+ * \param transfer The transfer.
+ * \param files    The files.
+ * \param create   Whether to create the objects or items.
+ * \param func     The job function.
+ **/
+static void
+j_cmd_transfer_run(JCmdTransfer* transfer, GPtrArray* files, gboolean create, GFunc func)
+{
+	JCmdTransferReporter reporter;
+	GThread* thread = NULL;
+	GThreadPool* pool;
+
+	reporter.transfer = transfer;
+	reporter.timer = g_timer_new();
+	reporter.stop = FALSE;
+	g_mutex_init(&(reporter.mutex));
+	g_cond_init(&(reporter.cond));
+
+	g_atomic_int_set(&(transfer->files), files->len);
+
+	if (transfer->options.progress)
+	{
+		thread = g_thread_new("julea-cli-progress", j_cmd_transfer_reporter, &reporter);
+	}
+
+	pool = g_thread_pool_new(func, NULL, transfer->options.jobs, TRUE, NULL);
+
+	for (guint i = 0; i < files->len; i += transfer->options.batch_size)
+	{
+		guint n = MIN(transfer->options.batch_size, files->len - i);
+
+		if (create)
+		{
+			g_autoptr(JBatch) batch = NULL;
+
+			// Creating many objects per batch saves one round trip per file.
+			batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+			for (guint j = i; j < i + n; j++)
+			{
+				j_cmd_transfer_file_create(g_ptr_array_index(files, j), batch);
+			}
+
+			if (!j_batch_execute(batch))
+			{
+				g_print("Error: Could not create objects for “%s” to “%s”.\n", ((JCmdTransferFile*)g_ptr_array_index(files, i))->name, ((JCmdTransferFile*)g_ptr_array_index(files, i + n - 1))->name);
+				g_atomic_int_set(&(transfer->failed), 1);
+
+				for (guint j = i; j < i + n; j++)
+				{
+					j_cmd_transfer_file_free(g_ptr_array_index(files, j));
+					g_atomic_int_inc(&(transfer->done));
+				}
+
+				continue;
+			}
+		}
+
+		for (guint j = i; j < i + n; j++)
+		{
+			g_thread_pool_push(pool, g_ptr_array_index(files, j), NULL);
+		}
+	}
+
+	g_thread_pool_free(pool, FALSE, TRUE);
+
+	if (thread != NULL)
+	{
+		g_mutex_lock(&(reporter.mutex));
+		reporter.stop = TRUE;
+		g_cond_signal(&(reporter.cond));
+		g_mutex_unlock(&(reporter.mutex));
+
+		g_thread_join(thread);
+
+		j_cmd_transfer_print_progress(transfer, g_timer_elapsed(reporter.timer, NULL), TRUE);
+	}
+
+	g_cond_clear(&(reporter.cond));
+	g_mutex_clear(&(reporter.mutex));
+	g_timer_destroy(reporter.timer);
+}
+
+/**
+ * Parses the transfer options preceding the arguments.
+ *
+ * \param arguments The arguments.
+ * \param options   Returns the options.
+ *
+ * \return The remaining arguments, NULL on error.
+ **/
+static gchar const**
+j_cmd_transfer_parse_options(gchar const** arguments, JCmdTransferOptions* options)
+{
+	options->block_size = J_CMD_TRANSFER_BLOCK_SIZE;
+	options->jobs = J_CMD_TRANSFER_JOBS;
+	options->batch_size = J_CMD_TRANSFER_BATCH_SIZE;
+	options->direct = FALSE;
+	options->progress = FALSE;
+
+	for (; *arguments != NULL && g_str_has_prefix(*arguments, "-"); arguments++)
+	{
+		gchar const* argument = *arguments;
+
+		if (g_strcmp0(argument, "--") == 0)
+		{
+			arguments++;
+			break;
+		}
+		else if (g_strcmp0(argument, "--direct") == 0)
+		{
+			options->direct = TRUE;
+		}
+		else if (g_strcmp0(argument, "--progress") == 0)
+		{
+			options->progress = TRUE;
+		}
+		else if (g_str_has_prefix(argument, "--block-size="))
+		{
+			if (!j_cmd_parse_size(argument + strlen("--block-size="), &(options->block_size)))
+			{
+				return NULL;
+			}
+		}
+		else if (g_str_has_prefix(argument, "--jobs="))
+		{
+			options->jobs = g_ascii_strtoull(argument + strlen("--jobs="), NULL, 10);
+
+			if (options->jobs == 0)
+			{
+				return NULL;
+			}
+		}
+		else if (g_str_has_prefix(argument, "--batch-size="))
+		{
+			options->batch_size = g_ascii_strtoull(argument + strlen("--batch-size="), NULL, 10);
+
+			if (options->batch_size == 0)
+			{
+				return NULL;
+			}
+		}
+		else
+		{
+			return NULL;
+		}
+	}
+
+	// O_DIRECT requires aligned offsets and lengths.
+	if (options->direct && options->block_size % J_CMD_TRANSFER_DIRECT_ALIGNMENT != 0)
+	{
+		options->block_size += J_CMD_TRANSFER_DIRECT_ALIGNMENT - (options->block_size % J_CMD_TRANSFER_DIRECT_ALIGNMENT);
+	}
+
+	return arguments;
+}
+
+/**
+ * Parses a namespace or collection URI.
+ *
+ * \param target   Returns the target.
+ * \param argument The URI.
+ * \param create   Whether to create the collection if it does not exist.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_cmd_transfer_target_init(JCmdTransferTarget* target, gchar const* argument, gboolean create)
+{
+	GError* error = NULL;
+
+	if ((target->object_uri = j_object_uri_new(argument, J_OBJECT_URI_SCHEME_NAMESPACE)) != NULL)
+	{
+		return TRUE;
+	}
+
+	if ((target->distributed_object_uri = j_object_uri_new(argument, J_OBJECT_URI_SCHEME_DISTRIBUTED_NAMESPACE)) != NULL)
+	{
+		return TRUE;
+	}
+
+	if ((target->uri = j_uri_new(argument)) == NULL || j_uri_get_collection_name(target->uri) == NULL || j_uri_get_item_name(target->uri) != NULL)
+	{
+		j_cmd_usage();
+		return FALSE;
+	}
+
+	if (j_uri_get(target->uri, &error))
+	{
+		return TRUE;
+	}
+
+	if (create && j_cmd_error_last(target->uri))
+	{
+		g_error_free(error);
+		error = NULL;
+
+		if (j_uri_create(target->uri, FALSE, &error))
+		{
+			return TRUE;
+		}
+	}
+
+	g_print("Error: %s\n", error->message);
+	g_error_free(error);
+
+	return FALSE;
+}
+
+static void
+j_cmd_transfer_target_fini(JCmdTransferTarget* target)
+{
+	if (target->object_uri != NULL)
+	{
+		j_object_uri_free(target->object_uri);
+	}
+
+	if (target->distributed_object_uri != NULL)
+	{
+		j_object_uri_free(target->distributed_object_uri);
+	}
+
+	if (target->uri != NULL)
+	{
+		j_uri_free(target->uri);
+	}
+}
+
+static JCmdTransfer*
+j_cmd_transfer_new(gchar const*** arguments)
+{
+	JCmdTransfer* transfer;
+
+	transfer = g_slice_new0(JCmdTransfer);
+	g_mutex_init(&(transfer->mutex));
+
+	*arguments = j_cmd_transfer_parse_options(*arguments, &(transfer->options));
+
+	return transfer;
+}
+
+static gboolean
+j_cmd_transfer_free(JCmdTransfer* transfer)
+{
+	gboolean ret;
+
+	ret = (g_atomic_int_get(&(transfer->failed)) == 0);
+
+	j_cmd_transfer_target_fini(&(transfer->target));
+	g_mutex_clear(&(transfer->mutex));
+	g_free(transfer->directory);
+	g_slice_free(JCmdTransfer, transfer);
+
+	return ret;
+}
+
+gboolean
+j_cmd_import(gchar const** arguments)
+{
+	JCmdTransfer* transfer;
+	g_autoptr(JDirIterator) iterator = NULL;
+	g_autoptr(GPtrArray) files = NULL;
+
+	transfer = j_cmd_transfer_new(&arguments);
+
+	if (arguments == NULL || j_cmd_arguments_length(arguments) != 2)
+	{
+		j_cmd_usage();
+		g_atomic_int_set(&(transfer->failed), 1);
+		goto end;
+	}
+
+	transfer->directory = g_strdup(arguments[0]);
+
+	if ((iterator = j_dir_iterator_new(transfer->directory)) == NULL)
+	{
+		g_print("Error: Could not open directory “%s”.\n", transfer->directory);
+		g_atomic_int_set(&(transfer->failed), 1);
+		goto end;
+	}
+
+	if (!j_cmd_transfer_target_init(&(transfer->target), arguments[1], TRUE))
+	{
+		g_atomic_int_set(&(transfer->failed), 1);
+		goto end;
+	}
+
+	files = g_ptr_array_new();
+
+	while (j_dir_iterator_next(iterator))
+	{
+		g_autofree gchar* path = NULL;
+		gchar const* name;
+		struct stat buf;
+
+		name = j_dir_iterator_get(iterator);
+		path = g_build_filename(transfer->directory, name, NULL);
+
+		if (lstat(path, &buf) != 0 || !S_ISREG(buf.st_mode))
+		{
+			continue;
+		}
+
+		g_ptr_array_add(files, j_cmd_transfer_file_new(transfer, name));
+	}
+
+	j_cmd_transfer_run(transfer, files, TRUE, j_cmd_transfer_import_job);
+
+end:
+	return j_cmd_transfer_free(transfer);
+}
+
+gboolean
+j_cmd_export(gchar const** arguments)
+{
+	JCmdTransfer* transfer;
+	g_autoptr(GPtrArray) files = NULL;
+
+	transfer = j_cmd_transfer_new(&arguments);
+
+	if (arguments == NULL || j_cmd_arguments_length(arguments) != 2)
+	{
+		j_cmd_usage();
+		g_atomic_int_set(&(transfer->failed), 1);
+		goto end;
+	}
+
+	if (!j_cmd_transfer_target_init(&(transfer->target), arguments[0], FALSE))
+	{
+		g_atomic_int_set(&(transfer->failed), 1);
+		goto end;
+	}
+
+	transfer->directory = g_strdup(arguments[1]);
+	files = g_ptr_array_new();
+
+	if (transfer->target.object_uri != NULL || transfer->target.distributed_object_uri != NULL)
+	{
+		g_autoptr(JObjectIterator) iterator = NULL;
+		g_autoptr(GHashTable) names = NULL;
+
+		if (transfer->target.object_uri != NULL)
+		{
+			iterator = j_object_iterator_new_for_index(j_object_uri_get_index(transfer->target.object_uri), j_object_uri_get_namespace(transfer->target.object_uri), NULL);
+		}
+		else
+		{
+			iterator = j_object_iterator_new(j_object_uri_get_namespace(transfer->target.distributed_object_uri), NULL);
+		}
+
+		// Distributed objects have a part on every server.
+		names = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+		while (j_object_iterator_next(iterator))
+		{
+			gchar const* name = j_object_iterator_get(iterator);
+
+			if (!g_hash_table_add(names, g_strdup(name)))
+			{
+				continue;
+			}
+
+			g_ptr_array_add(files, j_cmd_transfer_file_new(transfer, name));
+		}
+	}
+	else
+	{
+		g_autoptr(JItemIterator) iterator = NULL;
+
+		iterator = j_item_iterator_new(j_uri_get_collection(transfer->target.uri));
+
+		while (j_item_iterator_next(iterator))
+		{
+			JCmdTransferFile* file;
+			JItem* item;
+
+			item = j_item_iterator_get(iterator);
+
+			file = j_cmd_transfer_file_new(transfer, j_item_get_name(item));
+			file->item = item;
+
+			g_ptr_array_add(files, file);
+		}
+	}
+
+	for (guint i = 0; i < files->len; i++)
+	{
+		JCmdTransferFile* file = g_ptr_array_index(files, i);
+		g_auto(GStrv) components = NULL;
+
+		components = g_strsplit(file->name, "/", 0);
+
+		// Do not write outside of the target directory.
+		if (g_path_is_absolute(file->name) || g_strv_contains((gchar const* const*)components, ".."))
+		{
+			g_print("Error: Refusing to export “%s”.\n", file->name);
+			g_atomic_int_set(&(transfer->failed), 1);
+
+			j_cmd_transfer_file_free(file);
+			g_ptr_array_remove_index(files, i);
+			i--;
+		}
+	}
+
+	j_cmd_transfer_run(transfer, files, FALSE, j_cmd_transfer_export_job);
+
+end:
+	return j_cmd_transfer_free(transfer);
+}
@@ -0,0 +1,142 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include "julea-fuse.h"
+
+/**
+ * How long cached attributes are valid, in microseconds.
+ * This matches the kernel's attribute timeout for immediate consistency.
+ **/
+#define JFS_ATTR_CACHE_TIMEOUT (1 * G_USEC_PER_SEC)
+
+/**
+ * The number of entries after which expired entries are removed.
+ **/
+#define JFS_ATTR_CACHE_MAX 65536
+
+struct JFSAttrCacheEntry
+{
+	struct stat stbuf;
+	gint64 expires;
+};
+
+typedef struct JFSAttrCacheEntry JFSAttrCacheEntry;
+
+static GHashTable* jfs_attr_cache = NULL;
+static GMutex jfs_attr_cache_mutex;
+
+static void
+jfs_attr_cache_entry_free(gpointer data)
+{
+	g_slice_free(JFSAttrCacheEntry, data);
+}
+
+static gboolean
+jfs_attr_cache_entry_expired(gpointer key, gpointer value, gpointer data)
+{
+	JFSAttrCacheEntry* entry = value;
+	gint64 const* now = data;
+
+	(void)key;
+
+	return (entry->expires <= *now);
+}
+
+void
+jfs_attr_cache_init(void)
+{
+	jfs_attr_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, jfs_attr_cache_entry_free);
+}
+
+void
+jfs_attr_cache_fini(void)
+{
+	g_hash_table_unref(jfs_attr_cache);
+	jfs_attr_cache = NULL;
+}
+
+/**
+ * Caches a path's attributes for a short time.
+ **/
+void
+jfs_attr_cache_insert(char const* path, struct stat const* stbuf)
+{
+	JFSAttrCacheEntry* entry;
+	gint64 now;
+
+	now = g_get_monotonic_time();
+
+	entry = g_slice_new(JFSAttrCacheEntry);
+	entry->stbuf = *stbuf;
+	entry->expires = now + JFS_ATTR_CACHE_TIMEOUT;
+
+	g_mutex_lock(&jfs_attr_cache_mutex);
+
+	if (g_hash_table_size(jfs_attr_cache) >= JFS_ATTR_CACHE_MAX)
+	{
+		g_hash_table_foreach_remove(jfs_attr_cache, jfs_attr_cache_entry_expired, &now);
+	}
+
+	g_hash_table_insert(jfs_attr_cache, g_strdup(path), entry);
+
+	g_mutex_unlock(&jfs_attr_cache_mutex);
+}
+
+/**
+ * Looks up a path's cached attributes.
+ *
+ * \return TRUE if valid attributes have been found, FALSE otherwise.
+ **/
+gboolean
+jfs_attr_cache_lookup(char const* path, struct stat* stbuf)
+{
+	JFSAttrCacheEntry* entry;
+	gboolean ret = FALSE;
+
+	g_mutex_lock(&jfs_attr_cache_mutex);
+
+	if ((entry = g_hash_table_lookup(jfs_attr_cache, path)) != NULL)
+	{
+		if (entry->expires > g_get_monotonic_time())
+		{
+			*stbuf = entry->stbuf;
+			ret = TRUE;
+		}
+		else
+		{
+			g_hash_table_remove(jfs_attr_cache, path);
+		}
+	}
+
+	g_mutex_unlock(&jfs_attr_cache_mutex);
+
+	return ret;
+}
+
+/**
+ * Removes a path's cached attributes, to be called whenever they change.
+ **/
+void
+jfs_attr_cache_remove(char const* path)
+{
+	g_mutex_lock(&jfs_attr_cache_mutex);
+	g_hash_table_remove(jfs_attr_cache, path);
+	g_mutex_unlock(&jfs_attr_cache_mutex);
+}
@@ -21,6 +21,7 @@
 #include "julea-fuse.h"
 
 #include <errno.h>
+#include <stdint.h>
 
 int
 jfs_create(char const* path, mode_t mode, struct fuse_file_info* fi)
@@ -36,7 +37,6 @@ jfs_create(char const* path, mode_t mode, struct fuse_file_info* fi)
 	g_autofree gchar* basename = NULL;
 
 	(void)mode;
-	(void)fi;
 
 	basename = g_path_get_basename(path);
 	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_POSIX);
@@ -55,8 +55,12 @@ jfs_create(char const* path, mode_t mode, struct fuse_file_info* fi)
 	j_kv_put(kv, value, len, bson_free, batch);
 	j_object_create(object, batch);
 
+	jfs_attr_cache_remove(path);
+
 	if (j_batch_execute(batch))
 	{
+		fi->fh = (uintptr_t)jfs_file_new(path, 0);
+
 		ret = 0;
 	}
 
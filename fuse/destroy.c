@@ -24,4 +24,6 @@ void
 jfs_destroy(void* data)
 {
 	(void)data;
+
+	jfs_attr_cache_fini();
 }
@@ -0,0 +1,309 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include "julea-fuse.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * The maximum number of bytes of adjacent writes that are merged into a single object write.
+ **/
+#define JFS_WRITE_BUFFER_SIZE (4 * 1024 * 1024)
+
+JFSFile*
+jfs_file_new(char const* path, guint64 size)
+{
+	JFSFile* file;
+
+	file = g_slice_new(JFSFile);
+	file->path = g_strdup(path);
+	file->kv = j_kv_new("posix", path);
+	file->object = j_object_new("posix", path);
+	g_mutex_init(&file->mutex);
+	file->size = size;
+	file->size_dirty = FALSE;
+	file->write_buffer = NULL;
+	file->write_offset = 0;
+	file->write_length = 0;
+	file->write_batch = NULL;
+	file->write_batch_buffer = NULL;
+	file->write_batch_length = 0;
+	file->write_batch_bytes = 0;
+	file->write_failed = 0;
+
+	return file;
+}
+
+JFSFile*
+jfs_file_get(struct fuse_file_info* fi)
+{
+	return (JFSFile*)(uintptr_t)fi->fh;
+}
+
+static void
+jfs_file_write_callback(JBatch* batch, gboolean ret, gpointer data)
+{
+	JFSFile* file = data;
+
+	(void)batch;
+
+	if (!ret)
+	{
+		g_atomic_int_set(&file->write_failed, 1);
+	}
+}
+
+/**
+ * Waits for the write that is currently in flight.
+ * Has to be called with the file's mutex held.
+ **/
+static void
+jfs_file_wait(JFSFile* file)
+{
+	if (file->write_batch == NULL)
+	{
+		return;
+	}
+
+	j_batch_wait(file->write_batch);
+
+	if (file->write_batch_bytes != file->write_batch_length)
+	{
+		g_atomic_int_set(&file->write_failed, 1);
+	}
+
+	j_batch_unref(file->write_batch);
+	file->write_batch = NULL;
+
+	// Keep the buffer around for the next writes
+	if (file->write_buffer == NULL)
+	{
+		file->write_buffer = file->write_batch_buffer;
+	}
+	else
+	{
+		g_free(file->write_batch_buffer);
+	}
+
+	file->write_batch_buffer = NULL;
+}
+
+/**
+ * Starts writing the buffered data in the background.
+ * At most one write is in flight, so writes reach the object servers in order.
+ * Has to be called with the file's mutex held.
+ **/
+static void
+jfs_file_submit(JFSFile* file)
+{
+	if (file->write_length == 0)
+	{
+		return;
+	}
+
+	jfs_file_wait(file);
+
+	file->write_batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_POSIX);
+	file->write_batch_buffer = file->write_buffer;
+	file->write_batch_length = file->write_length;
+	file->write_batch_bytes = 0;
+
+	file->write_buffer = NULL;
+	file->write_length = 0;
+
+	j_object_write(file->object, file->write_batch_buffer, file->write_batch_length, file->write_offset, &file->write_batch_bytes, file->write_batch);
+	j_batch_execute_async(file->write_batch, jfs_file_write_callback, file);
+}
+
+/**
+ * Queues a write.
+ * Writes that directly follow the buffered ones are merged, so sequential writes result in few large object writes.
+ * Errors of earlier background writes are reported by the next call.
+ *
+ * \return TRUE on success, FALSE if an earlier write failed.
+ **/
+gboolean
+jfs_file_write(JFSFile* file, char const* buf, gsize size, guint64 offset)
+{
+	gboolean ret = TRUE;
+
+	g_mutex_lock(&file->mutex);
+
+	if (g_atomic_int_get(&file->write_failed))
+	{
+		g_atomic_int_set(&file->write_failed, 0);
+		ret = FALSE;
+	}
+	else
+	{
+		if (file->write_length > 0 && (offset != file->write_offset + file->write_length || file->write_length + size > JFS_WRITE_BUFFER_SIZE))
+		{
+			jfs_file_submit(file);
+		}
+
+		if (size > JFS_WRITE_BUFFER_SIZE)
+		{
+			g_autoptr(JBatch) batch = NULL;
+			guint64 bytes_written = 0;
+
+			// Writes that do not fit into the buffer are executed directly, after all earlier ones
+			jfs_file_wait(file);
+
+			batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_POSIX);
+			j_object_write(file->object, buf, size, offset, &bytes_written, batch);
+
+			ret = j_batch_execute(batch) && bytes_written == size;
+		}
+		else
+		{
+			if (file->write_buffer == NULL)
+			{
+				file->write_buffer = g_malloc(JFS_WRITE_BUFFER_SIZE);
+			}
+
+			if (file->write_length == 0)
+			{
+				file->write_offset = offset;
+			}
+
+			memcpy(file->write_buffer + file->write_length, buf, size);
+			file->write_length += size;
+		}
+
+		// The size is only stored when the file is flushed
+		if (file->size < offset + size)
+		{
+			file->size = offset + size;
+			file->size_dirty = TRUE;
+		}
+	}
+
+	g_mutex_unlock(&file->mutex);
+
+	return ret;
+}
+
+/**
+ * Writes all buffered data and waits for it to arrive.
+ *
+ * \return TRUE on success, FALSE if any write failed.
+ **/
+gboolean
+jfs_file_sync(JFSFile* file)
+{
+	gboolean ret;
+
+	g_mutex_lock(&file->mutex);
+
+	jfs_file_submit(file);
+	jfs_file_wait(file);
+
+	ret = !g_atomic_int_get(&file->write_failed);
+	g_atomic_int_set(&file->write_failed, 0);
+
+	g_mutex_unlock(&file->mutex);
+
+	return ret;
+}
+
+/**
+ * Writes all buffered data and stores the file's size if it has changed.
+ * The stored size is only increased, so a concurrently opened file that has grown further is not shrunk.
+ **/
+gboolean
+jfs_file_flush(JFSFile* file)
+{
+	gboolean ret;
+
+	g_autoptr(JBatch) batch = NULL;
+	gpointer value;
+	guint32 len;
+
+	ret = jfs_file_sync(file);
+
+	g_mutex_lock(&file->mutex);
+
+	if (file->size_dirty)
+	{
+		batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_POSIX);
+
+		j_kv_get(file->kv, &value, &len, batch);
+
+		if (j_batch_execute(batch))
+		{
+			bson_t metadata[1];
+			bson_iter_t iter;
+
+			bson_init_static(metadata, value, len);
+
+			if (bson_iter_init_find(&iter, metadata, "size") && bson_iter_type(&iter) == BSON_TYPE_INT64)
+			{
+				if ((guint64)bson_iter_int64(&iter) < file->size)
+				{
+					gpointer copy;
+
+					bson_iter_overwrite_int64(&iter, file->size);
+
+#if GLIB_CHECK_VERSION(2, 68, 0)
+					copy = g_memdup2(bson_get_data(metadata), metadata->len);
+#else
+					copy = g_memdup(bson_get_data(metadata), metadata->len);
+#endif
+
+					j_kv_put(file->kv, copy, metadata->len, g_free, batch);
+					jfs_attr_cache_remove(file->path);
+
+					ret = j_batch_execute(batch) && ret;
+				}
+			}
+
+			bson_destroy(metadata);
+			g_free(value);
+		}
+		else
+		{
+			ret = FALSE;
+		}
+
+		file->size_dirty = !ret;
+	}
+
+	g_mutex_unlock(&file->mutex);
+
+	return ret;
+}
+
+/**
+ * Frees the file's state, buffered data has to be flushed before.
+ **/
+void
+jfs_file_free(JFSFile* file)
+{
+	g_assert(file->write_length == 0);
+	g_assert(file->write_batch == NULL);
+
+	g_free(file->write_buffer);
+	g_free(file->path);
+	g_mutex_clear(&file->mutex);
+	j_object_unref(file->object);
+	j_kv_unref(file->kv);
+	g_slice_free(JFSFile, file);
+}
@@ -25,6 +25,71 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+/**
+ * Fills a stat structure from a file's or directory's metadata.
+ **/
+gboolean
+jfs_stat_from_metadata(gconstpointer value, guint32 len, struct stat* stbuf)
+{
+	bson_t file[1];
+	bson_iter_t iter;
+	gboolean is_file = TRUE;
+	gint64 size = 0;
+	gint64 time = 0;
+
+	if (!bson_init_static(file, value, len))
+	{
+		return FALSE;
+	}
+
+	bson_iter_init(&iter, file);
+
+	while (bson_iter_next(&iter))
+	{
+		gchar const* key;
+
+		key = bson_iter_key(&iter);
+
+		if (g_strcmp0(key, "file") == 0)
+		{
+			is_file = bson_iter_bool(&iter);
+		}
+		else if (g_strcmp0(key, "size") == 0)
+		{
+			size = bson_iter_int64(&iter);
+		}
+		else if (g_strcmp0(key, "time") == 0)
+		{
+			time = bson_iter_int64(&iter);
+		}
+	}
+
+	memset(stbuf, 0, sizeof(*stbuf));
+
+	if (is_file)
+	{
+		stbuf->st_mode = S_IFREG | S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+		stbuf->st_nlink = 1;
+		stbuf->st_uid = getuid();
+		stbuf->st_gid = getgid();
+		stbuf->st_size = size;
+		stbuf->st_atime = stbuf->st_ctime = stbuf->st_mtime = time / G_USEC_PER_SEC;
+	}
+	else
+	{
+		stbuf->st_mode = S_IFDIR | S_IRUSR | S_IWUSR | S_IXUSR | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH;
+		stbuf->st_nlink = 1;
+		stbuf->st_uid = getuid();
+		stbuf->st_gid = getgid();
+		stbuf->st_size = 0;
+		stbuf->st_atime = stbuf->st_ctime = stbuf->st_mtime = time / G_USEC_PER_SEC;
+	}
+
+	bson_destroy(file);
+
+	return TRUE;
+}
+
 int
 jfs_getattr(char const* path, struct stat* stbuf)
 {
@@ -47,6 +112,12 @@ jfs_getattr(char const* path, struct stat* stbuf)
 		return 0;
 	}
 
+	// Entries listed by readdir are usually looked up right afterwards
+	if (jfs_attr_cache_lookup(path, stbuf))
+	{
+		return 0;
+	}
+
 	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_POSIX);
 	kv = j_kv_new("posix", path);
 
@@ -54,59 +125,13 @@ jfs_getattr(char const* path, struct stat* stbuf)
 
 	if (j_batch_execute(batch))
 	{
-		bson_t file[1];
-		bson_iter_t iter;
-		gboolean is_file = TRUE;
-		gint64 size = 0;
-		gint64 time = 0;
-
-		bson_init_static(file, value, len);
-		bson_iter_init(&iter, file);
-
-		while (bson_iter_next(&iter))
-		{
-			gchar const* key;
-
-			key = bson_iter_key(&iter);
-
-			if (g_strcmp0(key, "file") == 0)
-			{
-				is_file = bson_iter_bool(&iter);
-			}
-			else if (g_strcmp0(key, "size") == 0)
-			{
-				size = bson_iter_int64(&iter);
-			}
-			else if (g_strcmp0(key, "time") == 0)
-			{
-				time = bson_iter_int64(&iter);
-			}
-		}
-
-		if (is_file)
-		{
-			stbuf->st_mode = S_IFREG | S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
-			stbuf->st_nlink = 1;
-			stbuf->st_uid = getuid();
-			stbuf->st_gid = getgid();
-			stbuf->st_size = size;
-			stbuf->st_atime = stbuf->st_ctime = stbuf->st_mtime = time / G_USEC_PER_SEC;
-
-			ret = 0;
-		}
-		else
+		if (jfs_stat_from_metadata(value, len, stbuf))
 		{
-			stbuf->st_mode = S_IFDIR | S_IRUSR | S_IWUSR | S_IXUSR | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH;
-			stbuf->st_nlink = 1;
-			stbuf->st_uid = getuid();
-			stbuf->st_gid = getgid();
-			stbuf->st_size = 0;
-			stbuf->st_atime = stbuf->st_ctime = stbuf->st_mtime = time / G_USEC_PER_SEC;
+			jfs_attr_cache_insert(path, stbuf);
 
 			ret = 0;
 		}
 
-		bson_destroy(file);
 		g_free(value);
 	}
 
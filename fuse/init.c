@@ -23,7 +23,14 @@
 void*
 jfs_init(struct fuse_conn_info* conn)
 {
+#ifdef FUSE_CAP_SPLICE_READ
+	// Let the kernel move data through pipes instead of copying it into the request buffers
+	conn->want |= conn->capable & (FUSE_CAP_SPLICE_READ | FUSE_CAP_SPLICE_WRITE | FUSE_CAP_SPLICE_MOVE);
+#else
 	(void)conn;
+#endif
+
+	jfs_attr_cache_init();
 
 	return NULL;
 }
@@ -30,27 +30,81 @@ struct fuse_operations jfs_vtable = {
 	.chown = jfs_chown,
 	.create = jfs_create,
 	.destroy = jfs_destroy,
+	.flush = jfs_flush,
 	.getattr = jfs_getattr,
 	.init = jfs_init,
 	.mkdir = jfs_mkdir,
+	.open = jfs_open,
 	.read = jfs_read,
 	.readdir = jfs_readdir,
+	.release = jfs_release,
 	.rmdir = jfs_rmdir,
 	.truncate = jfs_truncate,
 	.unlink = jfs_unlink,
 	.utimens = jfs_utimens,
 	.write = jfs_write,
+#if FUSE_VERSION >= 29
+	.read_buf = jfs_read_buf,
+	.write_buf = jfs_write_buf,
+#endif
 };
 
+/**
+ * The maximum size of a single read or write request, FUSE 2 does not support larger requests.
+ **/
+#define JFS_MAX_IO_SIZE (128 * 1024)
+
+/**
+ * Returns the mount options for the given semantics.
+ * The kernel caches attributes, entries and data for longer if the semantics' consistency is relaxed.
+ * Options given on the command line take precedence because they are parsed later.
+ **/
+static gchar*
+jfs_get_options(JSemantics* semantics)
+{
+	gchar const* cache_options;
+
+	switch (j_semantics_get(semantics, J_SEMANTICS_CONSISTENCY))
+	{
+		case J_SEMANTICS_CONSISTENCY_IMMEDIATE:
+			// Data is only cached as long as the file's size and modification time do not change
+			cache_options = "attr_timeout=1,entry_timeout=1,negative_timeout=0,auto_cache";
+			break;
+		case J_SEMANTICS_CONSISTENCY_EVENTUAL:
+			cache_options = "attr_timeout=10,entry_timeout=10,negative_timeout=1,kernel_cache";
+			break;
+		case J_SEMANTICS_CONSISTENCY_NONE:
+		default:
+			cache_options = "attr_timeout=60,entry_timeout=60,negative_timeout=10,kernel_cache";
+			break;
+	}
+
+	return g_strdup_printf("-o%s,big_writes,max_write=%d,max_read=%d,max_readahead=%d", cache_options, JFS_MAX_IO_SIZE, JFS_MAX_IO_SIZE, JFS_MAX_IO_SIZE);
+}
+
 int
 main(int argc, char** argv)
 {
+	struct fuse_args args = FUSE_ARGS_INIT(argc, argv);
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autofree gchar* options = NULL;
 	gint ret;
 
 	// Explicitly enable UTF-8 since functions such as g_format_size might return UTF-8 characters.
 	setlocale(LC_ALL, "C.UTF-8");
 
-	ret = fuse_main(argc, argv, &jfs_vtable, NULL);
+	// All operations use the POSIX semantics template
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_POSIX);
+	options = jfs_get_options(semantics);
+
+	if (fuse_opt_insert_arg(&args, 1, options) != 0)
+	{
+		return 1;
+	}
+
+	ret = fuse_main(args.argc, args.argv, &jfs_vtable, NULL);
+
+	fuse_opt_free_args(&args);
 
 	return ret;
 }
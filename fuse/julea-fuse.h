@@ -27,21 +27,89 @@
 
 #include <glib.h>
 
+/**
+ * The state of an open file.
+ * It is stored in fuse_file_info's fh, so that reads and writes do not have to look up the file again.
+ **/
+struct JFSFile
+{
+	gchar* path;
+	JKV* kv;
+	JObject* object;
+
+	/**
+	 * Protects all of the following members.
+	 * FUSE calls the callbacks from multiple threads, possibly for the same file.
+	 **/
+	GMutex mutex;
+
+	/**
+	 * The file's size, including writes whose size update has not been flushed yet.
+	 **/
+	guint64 size;
+	gboolean size_dirty;
+
+	/**
+	 * Adjacent writes that have not been submitted yet.
+	 **/
+	gchar* write_buffer;
+	guint64 write_offset;
+	gsize write_length;
+
+	/**
+	 * The write that is currently executed in the background.
+	 **/
+	JBatch* write_batch;
+	gchar* write_batch_buffer;
+	guint64 write_batch_length;
+	guint64 write_batch_bytes;
+
+	/**
+	 * Whether a background write has failed, set from the batch's callback.
+	 **/
+	gint write_failed;
+};
+
+typedef struct JFSFile JFSFile;
+
+JFSFile* jfs_file_new(char const*, guint64);
+JFSFile* jfs_file_get(struct fuse_file_info*);
+gboolean jfs_file_write(JFSFile*, char const*, gsize, guint64);
+gboolean jfs_file_sync(JFSFile*);
+gboolean jfs_file_flush(JFSFile*);
+void jfs_file_free(JFSFile*);
+
+void jfs_attr_cache_init(void);
+void jfs_attr_cache_fini(void);
+void jfs_attr_cache_insert(char const*, struct stat const*);
+gboolean jfs_attr_cache_lookup(char const*, struct stat*);
+void jfs_attr_cache_remove(char const*);
+
+gboolean jfs_stat_from_metadata(gconstpointer, guint32, struct stat*);
+
 int jfs_access(char const*, int);
 int jfs_chmod(char const*, mode_t);
 int jfs_chown(char const*, uid_t, gid_t);
 int jfs_create(char const*, mode_t, struct fuse_file_info*);
 void jfs_destroy(void*);
+int jfs_flush(char const*, struct fuse_file_info*);
 int jfs_getattr(char const*, struct stat*);
 void* jfs_init(struct fuse_conn_info*);
 int jfs_link(char const*, char const*);
 int jfs_mkdir(char const*, mode_t);
 int jfs_open(char const*, struct fuse_file_info*);
 int jfs_read(char const*, char*, size_t, off_t, struct fuse_file_info*);
+#if FUSE_VERSION >= 29
+int jfs_read_buf(char const*, struct fuse_bufvec**, size_t, off_t, struct fuse_file_info*);
+#endif
 int jfs_readdir(char const*, void*, fuse_fill_dir_t, off_t, struct fuse_file_info*);
+int jfs_release(char const*, struct fuse_file_info*);
 int jfs_rmdir(char const*);
 int jfs_statfs(char const*, struct statvfs*);
 int jfs_truncate(char const*, off_t);
 int jfs_unlink(char const*);
 int jfs_utimens(char const*, const struct timespec*);
 int jfs_write(char const*, char const*, size_t, off_t, struct fuse_file_info*);
+#if FUSE_VERSION >= 29
+int jfs_write_buf(char const*, struct fuse_bufvec*, off_t, struct fuse_file_info*);
+#endif
@@ -21,24 +21,30 @@
 #include "julea-fuse.h"
 
 #include <errno.h>
+#include <stdlib.h>
 
 int
 jfs_read(char const* path, char* buf, size_t size, off_t offset, struct fuse_file_info* fi)
 {
-	int ret = -ENOENT;
+	int ret = -EIO;
 
 	g_autoptr(JBatch) batch = NULL;
-	g_autoptr(JKV) kv = NULL;
-	g_autoptr(JObject) object = NULL;
+	JFSFile* file;
 	guint64 bytes_read;
 
-	(void)fi;
+	(void)path;
+
+	file = jfs_file_get(fi);
+
+	// Reads have to see the data of earlier writes
+	if (!jfs_file_sync(file))
+	{
+		return ret;
+	}
 
 	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_POSIX);
-	kv = j_kv_new("posix", path);
-	object = j_object_new("posix", path);
 
-	j_object_read(object, buf, size, offset, &bytes_read, batch);
+	j_object_read(file->object, buf, size, offset, &bytes_read, batch);
 
 	if (j_batch_execute(batch))
 	{
@@ -47,3 +53,32 @@ jfs_read(char const* path, char* buf, size_t size, off_t offset, struct fuse_fil
 
 	return ret;
 }
+
+#if FUSE_VERSION >= 29
+int
+jfs_read_buf(char const* path, struct fuse_bufvec** bufp, size_t size, off_t offset, struct fuse_file_info* fi)
+{
+	int ret;
+
+	struct fuse_bufvec* bufvec;
+	char* buf;
+
+	// FUSE frees the buffers using free()
+	buf = malloc(size);
+	ret = jfs_read(path, buf, size, offset, fi);
+
+	if (ret < 0)
+	{
+		free(buf);
+		return ret;
+	}
+
+	bufvec = malloc(sizeof(*bufvec));
+	*bufvec = (struct fuse_bufvec)FUSE_BUFVEC_INIT(ret);
+	bufvec->buf[0].mem = buf;
+
+	*bufp = bufvec;
+
+	return 0;
+}
+#endif
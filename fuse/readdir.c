@@ -47,24 +47,34 @@ jfs_readdir(char const* path, void* buf, fuse_fill_dir_t filler, off_t offset, s
 
 	while (j_kv_iterator_next(it))
 	{
+		gchar const* key;
 		gconstpointer value;
 		guint32 len;
 		bson_t tmp[1];
 		bson_iter_t iter;
+		struct stat stbuf;
+		struct stat* stbuf_ptr = NULL;
 
-		j_kv_iterator_get(it, &value, &len);
+		key = j_kv_iterator_get(it, &value, &len);
 		bson_init_static(tmp, value, len);
 
+		// The metadata already contains all attributes, cache them so that getattr does not have to fetch them again
+		if (jfs_stat_from_metadata(value, len, &stbuf))
+		{
+			jfs_attr_cache_insert(key, &stbuf);
+			stbuf_ptr = &stbuf;
+		}
+
 		if (bson_iter_init_find(&iter, tmp, "name") && bson_iter_type(&iter) == BSON_TYPE_UTF8)
 		{
 			gchar const* name;
 
 			name = bson_iter_utf8(&iter, NULL);
-			filler(buf, name, NULL, 0);
+			filler(buf, name, stbuf_ptr, 0);
 		}
 		else
 		{
-			filler(buf, "???", NULL, 0);
+			filler(buf, "???", stbuf_ptr, 0);
 		}
 	}
 
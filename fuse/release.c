@@ -0,0 +1,45 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include "julea-fuse.h"
+
+#include <errno.h>
+
+int
+jfs_release(char const* path, struct fuse_file_info* fi)
+{
+	int ret = 0;
+
+	JFSFile* file;
+
+	(void)path;
+
+	file = jfs_file_get(fi);
+
+	if (!jfs_file_flush(file))
+	{
+		ret = -EIO;
+	}
+
+	jfs_file_free(file);
+	fi->fh = 0;
+
+	return ret;
+}
@@ -35,6 +35,8 @@ jfs_unlink(char const* path)
 
 	j_kv_delete(kv, batch);
 
+	jfs_attr_cache_remove(path);
+
 	if (j_batch_execute(batch))
 	{
 		ret = 0;
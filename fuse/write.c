@@ -25,62 +25,50 @@
 int
 jfs_write(char const* path, char const* buf, size_t size, off_t offset, struct fuse_file_info* fi)
 {
-	int ret = -ENOENT;
+	int ret = -EIO;
 
-	g_autoptr(JBatch) batch = NULL;
-	g_autoptr(JKV) kv = NULL;
-	g_autoptr(JObject) object = NULL;
-	guint64 bytes_written;
-	gpointer value;
-	guint32 len;
+	JFSFile* file;
 
-	(void)fi;
+	(void)path;
 
-	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_POSIX);
-	kv = j_kv_new("posix", path);
-	object = j_object_new("posix", path);
+	file = jfs_file_get(fi);
 
-	j_kv_get(kv, &value, &len, batch);
-	j_object_write(object, buf, size, offset, &bytes_written, batch);
-
-	if (j_batch_execute(batch))
+	// The data is written in the background, errors are reported by later writes or when the file is flushed
+	if (jfs_file_write(file, buf, size, offset))
 	{
-		bson_t file[1];
-		bson_iter_t iter;
-		gint64 old_size = 0;
-
-		ret = bytes_written;
-
-		bson_init_static(file, value, len);
-
-		if (bson_iter_init_find(&iter, file, "size") && bson_iter_type(&iter) == BSON_TYPE_INT64)
-		{
-			old_size = bson_iter_int64(&iter);
+		ret = size;
+	}
 
-			if ((guint64)old_size < offset + size)
-			{
-				gpointer copy;
+	return ret;
+}
 
-				bson_iter_overwrite_int64(&iter, offset + size);
+#if FUSE_VERSION >= 29
+int
+jfs_write_buf(char const* path, struct fuse_bufvec* buf, off_t offset, struct fuse_file_info* fi)
+{
+	struct fuse_bufvec dst;
+	g_autofree char* mem = NULL;
+	size_t size;
+	ssize_t copied;
 
-#if GLIB_CHECK_VERSION(2, 68, 0)
-				copy = g_memdup2(bson_get_data(file), file->len);
-#else
-				copy = g_memdup(bson_get_data(file), file->len);
-#endif
+	size = fuse_buf_size(buf);
 
-				j_kv_put(kv, copy, file->len, g_free, batch);
+	// Memory buffers can be written directly
+	if (buf->count == 1 && buf->idx == 0 && buf->off == 0 && !(buf->buf[0].flags & FUSE_BUF_IS_FD))
+	{
+		return jfs_write(path, buf->buf[0].mem, size, offset, fi);
+	}
 
-				if (!j_batch_execute(batch))
-				{
-					ret = -EIO;
-				}
-			}
-		}
+	// Spliced data has to be moved out of the pipe before it can be sent to the object servers
+	mem = g_malloc(size);
+	dst = (struct fuse_bufvec)FUSE_BUFVEC_INIT(size);
+	dst.buf[0].mem = mem;
 
-		bson_destroy(file);
-		g_free(value);
+	if ((copied = fuse_buf_copy(&dst, buf, 0)) < 0)
+	{
+		return copied;
 	}
 
-	return ret;
+	return jfs_write(path, mem, copied, offset, fi);
 }
+#endif
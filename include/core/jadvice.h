@@ -0,0 +1,70 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#ifndef JULEA_ADVICE_H
+#define JULEA_ADVICE_H
+
+#if !defined(JULEA_H) && !defined(JULEA_COMPILATION)
+#error "Only <julea.h> can be included directly."
+#endif
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * Describes how a range of an object is going to be accessed.
+ * Advice is only a hint, backends that cannot make use of it ignore it.
+ **/
+enum JAdvice
+{
+	/**
+	 * No particular access pattern, which undoes previous advice.
+	 **/
+	J_ADVICE_NORMAL,
+
+	/**
+	 * The range is going to be read sequentially, so reading ahead pays off.
+	 **/
+	J_ADVICE_SEQUENTIAL,
+
+	/**
+	 * The range is going to be read randomly, so reading ahead wastes bandwidth.
+	 **/
+	J_ADVICE_RANDOM,
+
+	/**
+	 * The range is going to be read soon and should be fetched in the background.
+	 **/
+	J_ADVICE_WILL_NEED,
+
+	/**
+	 * The range is going to be read only once and does not have to be cached.
+	 **/
+	J_ADVICE_NO_REUSE
+};
+
+typedef enum JAdvice JAdvice;
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#ifndef JULEA_BACKEND_LATENCY_H
+#define JULEA_BACKEND_LATENCY_H
+
+#if !defined(JULEA_H) && !defined(JULEA_COMPILATION)
+#error "Only <julea.h> can be included directly."
+#endif
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * The operation types a latency model distinguishes.
+ **/
+enum JBackendLatencyOperation
+{
+	J_BACKEND_LATENCY_READ,
+	J_BACKEND_LATENCY_WRITE,
+	J_BACKEND_LATENCY_METADATA,
+	J_BACKEND_LATENCY_SYNC,
+	J_BACKEND_LATENCY_OPERATIONS
+};
+
+typedef enum JBackendLatencyOperation JBackendLatencyOperation;
+
+struct JBackendLatency;
+
+typedef struct JBackendLatency JBackendLatency;
+
+JBackendLatency* j_backend_latency_new(gchar const*);
+void j_backend_latency_free(JBackendLatency*);
+
+guint64 j_backend_latency_get(JBackendLatency*, JBackendLatencyOperation, guint64);
+void j_backend_latency_inject(JBackendLatency*, JBackendLatencyOperation, guint64);
+
+G_END_DECLS
+
+#endif
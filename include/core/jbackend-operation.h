@@ -38,6 +38,19 @@
 
 G_BEGIN_DECLS
 
+/**
+ * The maximum number of entries returned for one query message.
+ * Entries are returned in ascending order of their IDs, clients request further pages by restricting the selector to larger IDs.
+ *
+ * A page is not sent as one BSON document per entry but packed into a single document:
+ * - \c _names and \c _types list the columns and their BSON types once, the first column always is \c _id.
+ * - \c _count is the number of entries, \c _rows contains their fixed-width rows.
+ *   Each row starts with a bitmap marking the columns that are set, followed by the columns in order.
+ *   32-bit and 64-bit values are stored directly, strings and blobs as a 32-bit offset and length into \c _heap.
+ * - \c _heap contains the variable-length values, strings are stored including their terminator.
+ **/
+#define J_BACKEND_OPERATION_DB_QUERY_PAGE_SIZE 1000
+
 enum JBackendOperationParamType
 {
 	J_BACKEND_OPERATION_PARAM_TYPE_STR,
@@ -120,6 +133,8 @@ gboolean j_backend_operation_unwrap_db_insert(JBackend*, gpointer, JBackendOpera
 gboolean j_backend_operation_unwrap_db_update(JBackend*, gpointer, JBackendOperation*);
 gboolean j_backend_operation_unwrap_db_delete(JBackend*, gpointer, JBackendOperation*);
 gboolean j_backend_operation_unwrap_db_query(JBackend*, gpointer, JBackendOperation*);
+gboolean j_backend_operation_unwrap_db_aggregate(JBackend*, gpointer, JBackendOperation*);
+gboolean j_backend_operation_unwrap_db_advise_indexes(JBackend*, gpointer, JBackendOperation*);
 
 gboolean j_backend_operation_to_message(JMessage* message, JBackendOperationParam* data, guint len);
 gboolean j_backend_operation_from_message(JMessage* message, JBackendOperationParam* data, guint len);
@@ -241,6 +256,11 @@ static const JBackendOperation j_backend_operation_db_query = {
 			.type = J_BACKEND_OPERATION_PARAM_TYPE_BSON,
 			.bson_initialized = TRUE,
 		},
+		// Projected fields, empty if all fields are retrieved
+		{
+			.type = J_BACKEND_OPERATION_PARAM_TYPE_BSON,
+			.bson_initialized = TRUE,
+		},
 	},
 	.out_param = {
 		{
@@ -250,6 +270,54 @@ static const JBackendOperation j_backend_operation_db_query = {
 		{ .type = J_BACKEND_OPERATION_PARAM_TYPE_ERROR },
 	},
 	.backend_func = j_backend_operation_unwrap_db_query,
+	.in_param_count = 4,
+	.out_param_count = 2,
+};
+
+static const JBackendOperation j_backend_operation_db_aggregate = {
+	.in_param = {
+		{ .type = J_BACKEND_OPERATION_PARAM_TYPE_STR },
+		{ .type = J_BACKEND_OPERATION_PARAM_TYPE_STR },
+		{
+			.type = J_BACKEND_OPERATION_PARAM_TYPE_BSON,
+			.bson_initialized = TRUE,
+		},
+		// Group-by fields and aggregate functions
+		{
+			.type = J_BACKEND_OPERATION_PARAM_TYPE_BSON,
+			.bson_initialized = TRUE,
+		},
+	},
+	.out_param = {
+		{
+			.type = J_BACKEND_OPERATION_PARAM_TYPE_BSON,
+			.bson_initialized = TRUE,
+		},
+		{ .type = J_BACKEND_OPERATION_PARAM_TYPE_ERROR },
+	},
+	.backend_func = j_backend_operation_unwrap_db_aggregate,
+	.in_param_count = 4,
+	.out_param_count = 2,
+};
+
+static const JBackendOperation j_backend_operation_db_advise_indexes = {
+	.in_param = {
+		{ .type = J_BACKEND_OPERATION_PARAM_TYPE_STR },
+		{ .type = J_BACKEND_OPERATION_PARAM_TYPE_STR },
+		// Options
+		{
+			.type = J_BACKEND_OPERATION_PARAM_TYPE_BSON,
+			.bson_initialized = TRUE,
+		},
+	},
+	.out_param = {
+		{
+			.type = J_BACKEND_OPERATION_PARAM_TYPE_BSON,
+			.bson_initialized = TRUE,
+		},
+		{ .type = J_BACKEND_OPERATION_PARAM_TYPE_ERROR },
+	},
+	.backend_func = j_backend_operation_unwrap_db_advise_indexes,
 	.in_param_count = 3,
 	.out_param_count = 2,
 };
@@ -34,6 +34,7 @@
 
 #include <bson.h>
 
+#include <core/jadvice.h>
 #include <core/jsemantics.h>
 
 G_BEGIN_DECLS
@@ -121,6 +122,96 @@ enum JBackendComponent
 
 typedef enum JBackendComponent JBackendComponent;
 
+/**
+ * An extent of an object for vectored reads and writes.
+ */
+struct JBackendObjectExtent
+{
+	/**
+	 * The buffer to read into or write from.
+	 */
+	gpointer data;
+
+	guint64 length;
+	guint64 offset;
+
+	/**
+	 * The number of bytes read or written, set by the backend.
+	 */
+	guint64 bytes;
+};
+
+typedef struct JBackendObjectExtent JBackendObjectExtent;
+
+/**
+ * The backend calls statistics are kept for.
+ * Calls that exist for several backend types share a value.
+ */
+enum JBackendCall
+{
+	J_BACKEND_CALL_CREATE,
+	J_BACKEND_CALL_OPEN,
+	J_BACKEND_CALL_DELETE,
+	J_BACKEND_CALL_CLOSE,
+	J_BACKEND_CALL_STATUS,
+	J_BACKEND_CALL_SYNC,
+	J_BACKEND_CALL_SYNCV,
+	J_BACKEND_CALL_READ,
+	J_BACKEND_CALL_WRITE,
+	J_BACKEND_CALL_READV,
+	J_BACKEND_CALL_WRITEV,
+	J_BACKEND_CALL_DISCARD,
+	J_BACKEND_CALL_PREALLOCATE,
+	J_BACKEND_CALL_CLONE,
+	J_BACKEND_CALL_COPY_RANGE,
+	J_BACKEND_CALL_ADVISE,
+	J_BACKEND_CALL_GET_ALL,
+	J_BACKEND_CALL_GET_BY_PREFIX,
+	J_BACKEND_CALL_GET_RANGE,
+	J_BACKEND_CALL_ITERATE,
+	J_BACKEND_CALL_SEEK,
+	J_BACKEND_CALL_ITERATOR_FREE,
+	J_BACKEND_CALL_BATCH_START,
+	J_BACKEND_CALL_BATCH_EXECUTE,
+	J_BACKEND_CALL_BATCH_ABORT,
+	J_BACKEND_CALL_PUT,
+	J_BACKEND_CALL_GET,
+	J_BACKEND_CALL_GET_MULTI,
+	J_BACKEND_CALL_COMPARE_AND_SWAP,
+	J_BACKEND_CALL_ADD,
+	J_BACKEND_CALL_SCHEMA_CREATE,
+	J_BACKEND_CALL_SCHEMA_GET,
+	J_BACKEND_CALL_SCHEMA_DELETE,
+	J_BACKEND_CALL_INSERT,
+	J_BACKEND_CALL_INSERT_MULTI,
+	J_BACKEND_CALL_UPDATE,
+	J_BACKEND_CALL_QUERY,
+	J_BACKEND_CALL_QUERY_FIELDS,
+	J_BACKEND_CALL_AGGREGATE,
+	J_BACKEND_CALL_ADVISE_INDEXES
+};
+
+typedef enum JBackendCall JBackendCall;
+
+/**
+ * The number of backend calls statistics are kept for.
+ */
+#define J_BACKEND_CALLS (J_BACKEND_CALL_ADVISE_INDEXES + 1)
+
+enum JBackendStatisticsType
+{
+	J_BACKEND_STATISTICS_CALLS,
+	J_BACKEND_STATISTICS_BYTES,
+	/* Times are given in microseconds. */
+	J_BACKEND_STATISTICS_TIME
+};
+
+typedef enum JBackendStatisticsType JBackendStatisticsType;
+
+struct JBackendStatistics;
+
+typedef struct JBackendStatistics JBackendStatistics;
+
 struct JBackend
 {
 	JBackendType type;
@@ -128,6 +219,9 @@ struct JBackend
 
 	gpointer data;
 
+	// Per-call statistics, NULL unless enabled via j_backend_statistics_enable().
+	JBackendStatistics* statistics;
+
 	union
 	{
 		struct
@@ -143,13 +237,34 @@ struct JBackend
 
 			gboolean (*backend_status)(gpointer, gpointer, gint64*, guint64*);
 			gboolean (*backend_sync)(gpointer, gpointer);
+			// Optional, syncs multiple objects at once and falls back to backend_sync if NULL.
+			gboolean (*backend_syncv)(gpointer, gpointer*, guint32);
 
 			gboolean (*backend_read)(gpointer, gpointer, gpointer, guint64, guint64, guint64*);
 			gboolean (*backend_write)(gpointer, gpointer, gconstpointer, guint64, guint64, guint64*);
+			// Optional, handle multiple extents at once and fall back to backend_read and backend_write if NULL.
+			gboolean (*backend_readv)(gpointer, gpointer, JBackendObjectExtent*, guint32);
+			gboolean (*backend_writev)(gpointer, gpointer, JBackendObjectExtent*, guint32);
+			// Optional, deallocates a range so that it reads as zeros and falls back to writing zeros if NULL.
+			gboolean (*backend_discard)(gpointer, gpointer, guint64, guint64);
+			// Optional, reserves space for an object without changing its size.
+			gboolean (*backend_preallocate)(gpointer, gpointer, guint64);
+			// Optional, returns a descriptor of the object's data, so that the server can transfer it without copying.
+			gboolean (*backend_get_fd)(gpointer, gpointer, gint*);
+			// Optional, tells the backend that a range has been written through the descriptor returned by backend_get_fd.
+			gboolean (*backend_written)(gpointer, gpointer, guint64, guint64);
+			// Optional, replaces the second object's data with the first object's data, ideally sharing storage until either is modified.
+			gboolean (*backend_clone)(gpointer, gpointer, gpointer);
+			// Optional, copies a range of the first object to the second object, ideally sharing storage, and falls back to backend_read and backend_write if NULL.
+			gboolean (*backend_copy_range)(gpointer, gpointer, gpointer, guint64, guint64, guint64);
+			// Optional, tells the backend how a range of the object is going to be accessed, a length of 0 covers the rest of the object.
+			gboolean (*backend_advise)(gpointer, gpointer, JAdvice, guint64, guint64);
 
 			gboolean (*backend_get_all)(gpointer, gchar const*, gpointer*);
 			gboolean (*backend_get_by_prefix)(gpointer, gchar const*, gchar const*, gpointer*);
 			gboolean (*backend_iterate)(gpointer, gpointer, gchar const**);
+			// Optional, like backend_iterate but also returns the object's modification time and size, falls back to backend_iterate and backend_status if NULL.
+			gboolean (*backend_iterate_status)(gpointer, gpointer, gchar const**, gint64*, guint64*);
 		} object;
 
 		struct
@@ -159,14 +274,28 @@ struct JBackend
 
 			gboolean (*backend_batch_start)(gpointer, gchar const*, JSemantics*, gpointer*);
 			gboolean (*backend_batch_execute)(gpointer, gpointer);
+			// Optional, discards all changes of a batch and falls back to backend_batch_execute if NULL.
+			gboolean (*backend_batch_abort)(gpointer, gpointer);
 
 			gboolean (*backend_put)(gpointer, gpointer, gchar const*, gconstpointer, guint32);
 			gboolean (*backend_delete)(gpointer, gpointer, gchar const*);
 			gboolean (*backend_get)(gpointer, gpointer, gchar const*, gpointer*, guint32*);
+			// Optional, resolves multiple keys at once and falls back to backend_get if NULL.
+			gboolean (*backend_get_multi)(gpointer, gpointer, gchar const**, guint32, gpointer*, guint32*);
+			// Optional, replaces a value if it matches the expected one (NULL if the key must not exist) and falls back to backend_get and backend_put if NULL.
+			gboolean (*backend_compare_and_swap)(gpointer, gpointer, gchar const*, gconstpointer, guint32, gconstpointer, guint32, gboolean*);
+			// Optional, adds to a 64-bit little-endian counter (missing keys count as 0) and falls back to backend_get and backend_put if NULL.
+			gboolean (*backend_add)(gpointer, gpointer, gchar const*, gint64, gint64*);
 
 			gboolean (*backend_get_all)(gpointer, gchar const*, gpointer*);
 			gboolean (*backend_get_by_prefix)(gpointer, gchar const*, gchar const*, gpointer*);
+			// Optional, iterates over the keys in [start, end) in ascending or descending order, stopping after limit pairs (NULL bounds and a limit of 0 are unbounded).
+			gboolean (*backend_get_range)(gpointer, gchar const*, gchar const*, gchar const*, gboolean, guint32, gpointer*);
 			gboolean (*backend_iterate)(gpointer, gpointer, gchar const**, gconstpointer*, guint32*);
+			// Optional, lets an iterator start at the given key, which requires keys to be iterated in ascending order.
+			gboolean (*backend_seek)(gpointer, gpointer, gchar const*);
+			// Optional, frees an iterator that has not been exhausted and falls back to exhausting it if NULL.
+			void (*backend_iterator_free)(gpointer, gpointer);
 		} kv;
 
 		struct
@@ -176,6 +305,8 @@ struct JBackend
 
 			gboolean (*backend_batch_start)(gpointer, gchar const*, JSemantics*, gpointer*, GError**);
 			gboolean (*backend_batch_execute)(gpointer, gpointer, GError**);
+			// Optional, discards all changes of a batch and falls back to backend_batch_execute if NULL.
+			gboolean (*backend_batch_abort)(gpointer, gpointer, GError**);
 
 			/**
 			* Create a schema
@@ -251,6 +382,10 @@ struct JBackend
 			**/
 			gboolean (*backend_insert)(gpointer, gpointer, gchar const*, bson_t const*, bson_t*, GError**);
 
+			// Optional, inserts multiple entries into the same schema at once and falls back to backend_insert if NULL.
+			// ids points to count initialized BSON documents that receive the entries' ids; on failure, no entry has been inserted.
+			gboolean (*backend_insert_multi)(gpointer, gpointer, gchar const*, bson_t const* const*, guint, bson_t*, GError**);
+
 			/**
 			* Updates data
 			*
@@ -352,6 +487,10 @@ struct JBackend
 			**/
 			gboolean (*backend_query)(gpointer, gpointer, gchar const*, bson_t const*, gpointer*, GError**);
 
+			// Optional, like backend_query but backend_iterate only has to return _id and the fields listed in the given BSON array.
+			// Falls back to backend_query if NULL, which returns all fields.
+			gboolean (*backend_query_fields)(gpointer, gpointer, gchar const*, bson_t const*, bson_t const*, gpointer*, GError**);
+
 			/**
 			* Obtains metadata
 			*
@@ -373,6 +512,36 @@ struct JBackend
 			* \return TRUE on success, FALSE otherwise.
 			**/
 			gboolean (*backend_iterate)(gpointer, gpointer, bson_t*, GError**);
+
+			// Optional, frees an iterator that has not been exhausted and falls back to exhausting it if NULL.
+			void (*backend_iterator_free)(gpointer, gpointer);
+
+			// Optional, evaluates the aggregation described by the given BSON document over the selected entries.
+			// backend_iterate returns one entry per group, containing the group-by fields and the named results.
+			// Aggregations fail if NULL.
+			gboolean (*backend_aggregate)(gpointer, gpointer, gchar const*, bson_t const*, bson_t const*, gpointer*, GError**);
+
+			/**
+			* Optional, suggests indexes based on the selectors the backend has observed for a schema.
+			* Suggestions fail if NULL.
+			*
+			* \param[in]  name    Schema name (e.g., "files")
+			* \param[in]  options Points to an initialized BSON that may contain "_create" (int32) to create the suggested indexes
+			* \param[out] advice  Points to an initialized BSON that receives one document per suggested index
+			* \code
+			* {
+			*	"0": {
+			*		"_index": ["var_name1", "var_name2"],
+			*		"_queries": queries (int64),
+			*		"_time": time in microseconds (int64),
+			*		"_created": created (int32)
+			*	}
+			* }
+			* \endcode
+			*
+			* \return TRUE on success, FALSE otherwise.
+			**/
+			gboolean (*backend_advise_indexes)(gpointer, gpointer, gchar const*, bson_t const*, bson_t*, GError**);
 		} db;
 	};
 };
@@ -387,8 +556,19 @@ JBackend* backend_info(void);
 
 gboolean j_backend_load_client(gchar const*, gchar const*, JBackendType, GModule**, JBackend**);
 gboolean j_backend_load_server(gchar const*, gchar const*, JBackendType, GModule**, JBackend**);
+gboolean j_backend_load_local(gchar const*, JBackendType, GModule**, JBackend**);
+
+void j_backend_statistics_enable(gboolean);
+
+gchar const* j_backend_call_get_name(JBackendCall);
+
+JBackendStatistics* j_backend_get_statistics(JBackend*);
+gchar const* j_backend_statistics_get_name(JBackendStatistics*);
+guint64 j_backend_statistics_get(JBackendStatistics*, JBackendCall, JBackendStatisticsType);
+guint64 j_backend_statistics_get_latency(JBackendStatistics*, JBackendCall, guint);
 
 gboolean j_backend_object_init(JBackend*, gchar const*);
+gboolean j_backend_object_init_tiered(JBackend*, gchar const*, JBackend*, gchar const*, guint32);
 void j_backend_object_fini(JBackend*);
 
 gboolean j_backend_object_create(JBackend*, gchar const*, gchar const*, gpointer*);
@@ -399,44 +579,68 @@ gboolean j_backend_object_close(JBackend*, gpointer);
 
 gboolean j_backend_object_status(JBackend*, gpointer, gint64*, guint64*);
 gboolean j_backend_object_sync(JBackend*, gpointer);
+gboolean j_backend_object_syncv(JBackend*, gpointer*, guint32);
 
 gboolean j_backend_object_read(JBackend*, gpointer, gpointer, guint64, guint64, guint64*);
 gboolean j_backend_object_write(JBackend*, gpointer, gconstpointer, guint64, guint64, guint64*);
+gboolean j_backend_object_readv(JBackend*, gpointer, JBackendObjectExtent*, guint32);
+gboolean j_backend_object_writev(JBackend*, gpointer, JBackendObjectExtent*, guint32);
+gboolean j_backend_object_discard(JBackend*, gpointer, guint64, guint64);
+gboolean j_backend_object_preallocate(JBackend*, gpointer, guint64);
+gboolean j_backend_object_get_fd(JBackend*, gpointer, gint*);
+gboolean j_backend_object_written(JBackend*, gpointer, guint64, guint64);
+gboolean j_backend_object_clone(JBackend*, gpointer, gpointer);
+gboolean j_backend_object_copy_range(JBackend*, gpointer, gpointer, guint64, guint64, guint64);
+gboolean j_backend_object_advise(JBackend*, gpointer, JAdvice, guint64, guint64);
 
 gboolean j_backend_object_get_all(JBackend*, gchar const*, gpointer*);
 gboolean j_backend_object_get_by_prefix(JBackend*, gchar const*, gchar const*, gpointer*);
 gboolean j_backend_object_iterate(JBackend*, gpointer, gchar const**);
+gboolean j_backend_object_iterate_status(JBackend*, gchar const*, gpointer, gchar const**, gint64*, guint64*);
 
 gboolean j_backend_kv_init(JBackend*, gchar const*);
 void j_backend_kv_fini(JBackend*);
 
 gboolean j_backend_kv_batch_start(JBackend*, gchar const*, JSemantics*, gpointer*);
 gboolean j_backend_kv_batch_execute(JBackend*, gpointer);
+gboolean j_backend_kv_batch_abort(JBackend*, gpointer);
 
 gboolean j_backend_kv_put(JBackend*, gpointer, gchar const*, gconstpointer, guint32);
 gboolean j_backend_kv_delete(JBackend*, gpointer, gchar const*);
 gboolean j_backend_kv_get(JBackend*, gpointer, gchar const*, gpointer*, guint32*);
+gboolean j_backend_kv_get_multi(JBackend*, gpointer, gchar const**, guint32, gpointer*, guint32*);
+gboolean j_backend_kv_compare_and_swap(JBackend*, gpointer, gchar const*, gconstpointer, guint32, gconstpointer, guint32, gboolean*);
+gboolean j_backend_kv_add(JBackend*, gpointer, gchar const*, gint64, gint64*);
 
 gboolean j_backend_kv_get_all(JBackend*, gchar const*, gpointer*);
 gboolean j_backend_kv_get_by_prefix(JBackend*, gchar const*, gchar const*, gpointer*);
+gboolean j_backend_kv_get_range(JBackend*, gchar const*, gchar const*, gchar const*, gboolean, guint32, gpointer*);
 gboolean j_backend_kv_iterate(JBackend*, gpointer, gchar const**, gconstpointer*, guint32*);
+gboolean j_backend_kv_seek(JBackend*, gpointer, gchar const*);
+void j_backend_kv_iterator_free(JBackend*, gpointer);
 
 gboolean j_backend_db_init(JBackend*, gchar const*);
 void j_backend_db_fini(JBackend*);
 
 gboolean j_backend_db_batch_start(JBackend*, gchar const*, JSemantics*, gpointer*, GError**);
 gboolean j_backend_db_batch_execute(JBackend*, gpointer, GError**);
+gboolean j_backend_db_batch_abort(JBackend*, gpointer, GError**);
 
 gboolean j_backend_db_schema_create(JBackend*, gpointer, gchar const*, bson_t const*, GError**);
 gboolean j_backend_db_schema_get(JBackend*, gpointer, gchar const*, bson_t*, GError**);
 gboolean j_backend_db_schema_delete(JBackend*, gpointer, gchar const*, GError**);
 
 gboolean j_backend_db_insert(JBackend*, gpointer, gchar const*, bson_t const*, bson_t*, GError**);
+gboolean j_backend_db_insert_multi(JBackend*, gpointer, gchar const*, bson_t const* const*, guint, bson_t*, GError**);
 gboolean j_backend_db_update(JBackend*, gpointer, gchar const*, bson_t const*, bson_t const*, GError**);
 gboolean j_backend_db_delete(JBackend*, gpointer, gchar const*, bson_t const*, GError**);
 
 gboolean j_backend_db_query(JBackend*, gpointer, gchar const*, bson_t const*, gpointer*, GError**);
+gboolean j_backend_db_query_fields(JBackend*, gpointer, gchar const*, bson_t const*, bson_t const*, gpointer*, GError**);
 gboolean j_backend_db_iterate(JBackend*, gpointer, bson_t*, GError**);
+void j_backend_db_iterator_free(JBackend*, gpointer);
+gboolean j_backend_db_aggregate(JBackend*, gpointer, gchar const*, bson_t const*, bson_t const*, gpointer*, GError**);
+gboolean j_backend_db_advise_indexes(JBackend*, gpointer, gchar const*, bson_t const*, bson_t*, GError**);
 
 G_END_DECLS
 
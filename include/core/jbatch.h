@@ -37,15 +37,25 @@ typedef struct JBatch JBatch;
 
 typedef void (*JBatchAsyncCallback)(JBatch*, gboolean, gpointer);
 
+struct JBatchFuture;
+
+typedef struct JBatchFuture JBatchFuture;
+
+struct JBatchQueue;
+
+typedef struct JBatchQueue JBatchQueue;
+
 G_END_DECLS
 
 #include <core/joperation.h>
 #include <core/jsemantics.h>
+#include <core/jstatistics.h>
 
 G_BEGIN_DECLS
 
 JBatch* j_batch_new(JSemantics*);
 JBatch* j_batch_new_for_template(JSemanticsTemplate);
+JBatch* j_batch_new_auto(JSemantics*, guint, guint64, guint64);
 JBatch* j_batch_ref(JBatch*);
 void j_batch_unref(JBatch*);
 
@@ -58,8 +68,30 @@ void j_batch_add(JBatch*, JOperation*);
 gboolean j_batch_execute(JBatch*) G_GNUC_WARN_UNUSED_RESULT;
 
 void j_batch_execute_async(JBatch*, JBatchAsyncCallback, gpointer);
+JBatchFuture* j_batch_execute_future(JBatch*);
 void j_batch_wait(JBatch*);
 
+JBatchFuture* j_batch_future_ref(JBatchFuture*);
+void j_batch_future_unref(JBatchFuture*);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(JBatchFuture, j_batch_future_unref)
+
+gboolean j_batch_future_poll(JBatchFuture*, gboolean*);
+gboolean j_batch_future_wait(JBatchFuture*);
+
+JBatchQueue* j_batch_queue_new(void);
+JBatchQueue* j_batch_queue_ref(JBatchQueue*);
+void j_batch_queue_unref(JBatchQueue*);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(JBatchQueue, j_batch_queue_unref)
+
+void j_batch_queue_submit(JBatchQueue*, JBatch*, gpointer);
+gboolean j_batch_queue_poll(JBatchQueue*, JBatch**, gboolean*, gpointer*);
+guint j_batch_queue_wait(JBatchQueue*, guint);
+
+JStatistics* j_batch_get_statistics(JBatch*);
+JStatistics* j_batch_get_global_statistics(void);
+
 G_END_DECLS
 
 #endif
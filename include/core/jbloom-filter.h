@@ -0,0 +1,65 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#ifndef JULEA_BLOOM_FILTER_H
+#define JULEA_BLOOM_FILTER_H
+
+#if !defined(JULEA_H) && !defined(JULEA_COMPILATION)
+#error "Only <julea.h> can be included directly."
+#endif
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * The number of words in a block of a Bloom filter.
+ * Blocks are the unit in which filters are transferred incrementally.
+ **/
+#define J_BLOOM_FILTER_BLOCK_WORDS 64
+
+struct JBloomFilter;
+
+typedef struct JBloomFilter JBloomFilter;
+
+JBloomFilter* j_bloom_filter_new(guint64, guint);
+void j_bloom_filter_free(JBloomFilter*);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(JBloomFilter, j_bloom_filter_free)
+
+gboolean j_bloom_filter_add(JBloomFilter*, gchar const*);
+gboolean j_bloom_filter_contains(JBloomFilter const*, gchar const*);
+void j_bloom_filter_clear(JBloomFilter*);
+
+guint64 j_bloom_filter_get_bits(JBloomFilter const*);
+guint j_bloom_filter_get_hashes(JBloomFilter const*);
+guint64 j_bloom_filter_get_blocks(JBloomFilter const*);
+guint64 j_bloom_filter_get_version(JBloomFilter const*);
+
+guint64 j_bloom_filter_get_block_version(JBloomFilter const*, guint64);
+
+guint64 const* j_bloom_filter_get_block(JBloomFilter const*, guint64);
+void j_bloom_filter_set_block(JBloomFilter*, guint64, guint64 const*);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,48 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#ifndef JULEA_BUFFER_H
+#define JULEA_BUFFER_H
+
+#if !defined(JULEA_H) && !defined(JULEA_COMPILATION)
+#error "Only <julea.h> can be included directly."
+#endif
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * The alignment of all buffers, suitable for direct I/O.
+ **/
+#define J_BUFFER_ALIGNMENT 4096
+
+gpointer j_buffer_new(guint64, gboolean);
+void j_buffer_free(gpointer);
+
+gpointer j_buffer_ref(gconstpointer, guint64);
+
+guint64 j_buffer_get_size(gconstpointer);
+
+G_END_DECLS
+
+#endif
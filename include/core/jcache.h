@@ -39,7 +39,16 @@ JCache* j_cache_new(guint64);
 void j_cache_free(JCache*);
 
 gpointer j_cache_get(JCache*, guint64);
-void j_cache_release(JCache*, gpointer);
+
+/**
+ * \attention This is an API break: j_cache_release() used to take only the cache and the segment and allowed releasing segments in any order.
+ * Since JCache is a ring buffer, segments have to be released in the order they have been acquired and callers have to pass the segment's length.
+ * A wrapper with the old signature cannot provide the old semantics and is therefore not offered; callers have to be adapted.
+ **/
+void j_cache_release(JCache*, gpointer, guint64);
+
+guint64 j_cache_get_high_water_mark(JCache*);
+guint64 j_cache_get_used(JCache*);
 
 G_END_DECLS
 
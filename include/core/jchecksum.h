@@ -0,0 +1,51 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#ifndef JULEA_CHECKSUM_H
+#define JULEA_CHECKSUM_H
+
+#if !defined(JULEA_H) && !defined(JULEA_COMPILATION)
+#error "Only <julea.h> can be included directly."
+#endif
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * The size of a hash computed by j_checksum_hash().
+ **/
+#define J_CHECKSUM_HASH_SIZE 16
+
+/**
+ * The size of a digest computed by j_checksum_digest().
+ **/
+#define J_CHECKSUM_DIGEST_SIZE 32
+
+guint32 j_checksum_crc32c(guint32, gconstpointer, gsize);
+
+void j_checksum_hash(gconstpointer, gsize, guint8*);
+void j_checksum_digest(gconstpointer, gsize, guint8*);
+
+G_END_DECLS
+
+#endif
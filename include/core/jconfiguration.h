@@ -49,14 +49,47 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC(JConfiguration, j_configuration_unref)
 
 gchar const* j_configuration_get_server(JConfiguration*, JBackendType, guint32);
 guint32 j_configuration_get_server_count(JConfiguration*, JBackendType);
+guint32 j_configuration_get_replica_count(JConfiguration*, JBackendType);
+guint32 j_configuration_get_server_for_key(JConfiguration*, JBackendType, gchar const*);
+gchar const* j_configuration_get_server_locality(JConfiguration*, JBackendType, guint32);
+gchar const* j_configuration_get_server_address(JConfiguration*, gchar const*);
+guint32 j_configuration_get_local_server_count(JConfiguration*, JBackendType);
+guint32 j_configuration_get_local_server(JConfiguration*, JBackendType, guint32);
 
 gchar const* j_configuration_get_backend(JConfiguration*, JBackendType);
 gchar const* j_configuration_get_backend_component(JConfiguration*, JBackendType);
 gchar const* j_configuration_get_backend_path(JConfiguration*, JBackendType);
+gchar const* j_configuration_get_local_backend(JConfiguration*, JBackendType);
+gchar const* j_configuration_get_local_backend_path(JConfiguration*, JBackendType);
+gboolean j_configuration_is_local_namespace(JConfiguration*, JBackendType, gchar const*);
+gboolean j_configuration_get_object_lazy_create(JConfiguration*);
+gboolean j_configuration_get_object_checksums(JConfiguration*);
+gboolean j_configuration_get_object_dedup(JConfiguration*);
 
 guint64 j_configuration_get_max_operation_size(JConfiguration*);
+guint64 j_configuration_get_max_receive_size(JConfiguration*);
+gboolean j_configuration_get_receive_hugepages(JConfiguration*);
 guint32 j_configuration_get_max_connections(JConfiguration*);
+guint32 j_configuration_get_backend_max_connections(JConfiguration*, JBackendType);
+gboolean j_configuration_get_adaptive_connections(JConfiguration*);
+gboolean j_configuration_get_consistent_hashing(JConfiguration*);
 guint64 j_configuration_get_stripe_size(JConfiguration*);
+gchar const* j_configuration_get_compression(JConfiguration*);
+guint32 j_configuration_get_warm_up_connections(JConfiguration*);
+guint32 j_configuration_get_health_check_interval(JConfiguration*);
+guint32 j_configuration_get_retries(JConfiguration*);
+guint32 j_configuration_get_retry_delay(JConfiguration*);
+gboolean j_configuration_get_hedged_reads(JConfiguration*);
+gboolean j_configuration_get_compact_messages(JConfiguration*);
+guint64 j_configuration_get_block_cache_size(JConfiguration*);
+guint64 j_configuration_get_burst_buffer_size(JConfiguration*);
+guint64 j_configuration_get_burst_buffer_bandwidth(JConfiguration*);
+
+gchar const* j_configuration_get_object_cold_backend(JConfiguration*);
+gchar const* j_configuration_get_object_cold_path(JConfiguration*);
+guint32 j_configuration_get_object_cold_after(JConfiguration*);
+
+gchar const* j_configuration_get_object_wal_path(JConfiguration*);
 
 G_END_DECLS
 
@@ -31,11 +31,71 @@
 #include <gio/gio.h>
 
 #include <core/jbackend.h>
+#include <core/jmessage.h>
+#include <core/jstatistics.h>
 
 G_BEGIN_DECLS
 
+/**
+ * Client-side statistics about a server.
+ * Times are given in microseconds.
+ **/
+struct JConnectionPoolServerStatistics
+{
+	/**
+	 * The number of replies received from the server.
+	 **/
+	guint64 replies;
+
+	/**
+	 * The number of failed connection attempts, dropped connections and failed messages.
+	 **/
+	guint64 errors;
+
+	/**
+	 * The number of bytes sent to and received from the server.
+	 **/
+	guint64 bytes;
+
+	/**
+	 * The smoothed round-trip latency.
+	 **/
+	guint64 latency;
+
+	/**
+	 * The smoothed mean deviation of the round-trip latency.
+	 **/
+	guint64 latency_deviation;
+
+	/**
+	 * The sum of all round-trip latencies.
+	 **/
+	guint64 latency_total;
+
+	/**
+	 * The maximum round-trip latency.
+	 **/
+	guint64 latency_max;
+};
+
+typedef struct JConnectionPoolServerStatistics JConnectionPoolServerStatistics;
+
 gpointer j_connection_pool_pop(JBackendType, guint);
 void j_connection_pool_push(JBackendType, guint, gpointer);
+void j_connection_pool_discard(JBackendType, guint, gpointer);
+
+gboolean j_connection_pool_backoff(guint);
+gboolean j_connection_pool_retry(JBackendType, guint, JMessage*, JMessage*);
+gboolean j_connection_pool_exchange(JBackendType, guint, JMessage*, JMessage*);
+
+guint j_connection_pool_get_read_index(JBackendType, guint);
+
+guint j_connection_pool_get_load(JBackendType, guint);
+guint64 j_connection_pool_get_latency(JBackendType, guint);
+guint64 j_connection_pool_get_latency_p95(JBackendType, guint);
+gboolean j_connection_pool_get_server_statistics(JBackendType, guint, JConnectionPoolServerStatistics*);
+
+JStatistics* j_connection_pool_get_statistics(JBackendType);
 
 G_END_DECLS
 
@@ -37,7 +37,12 @@ enum JDistributionType
 {
 	J_DISTRIBUTION_ROUND_ROBIN,
 	J_DISTRIBUTION_SINGLE_SERVER,
-	J_DISTRIBUTION_WEIGHTED
+	J_DISTRIBUTION_WEIGHTED,
+	J_DISTRIBUTION_LOCAL,
+	J_DISTRIBUTION_CONSISTENT,
+	J_DISTRIBUTION_ERASURE,
+	J_DISTRIBUTION_REPLICATED,
+	J_DISTRIBUTION_ADAPTIVE
 };
 
 typedef enum JDistributionType JDistributionType;
@@ -67,8 +72,16 @@ void j_distribution_set_block_size(JDistribution*, guint64);
 void j_distribution_set(JDistribution*, gchar const*, guint64);
 void j_distribution_set2(JDistribution*, gchar const*, guint64, guint64);
 
+JDistributionType j_distribution_get_type(JDistribution*);
+gboolean j_distribution_get(JDistribution*, gchar const*, guint64*);
+
+void j_distribution_set_autotune(JDistribution*, gboolean);
+gboolean j_distribution_get_autotune(JDistribution*);
+gboolean j_distribution_tune(JDistribution*, guint64);
+
 void j_distribution_reset(JDistribution*, guint64, guint64);
 gboolean j_distribution_distribute(JDistribution*, guint*, guint64*, guint64*, guint64*);
+gboolean j_distribution_distribute_replica(JDistribution*, guint, guint*, guint64*);
 
 G_END_DECLS
 
@@ -29,32 +29,11 @@
 
 #include <glib.h>
 
-G_BEGIN_DECLS
-
-/**
- * A JList element.
- **/
-struct JListElement
-{
-	/**
-	 * Pointer to the next element.
-	 **/
-	struct JListElement* next;
-	/**
-	 * Pointer to data.
-	 **/
-	gpointer data;
-};
-
-typedef struct JListElement JListElement;
-
-G_END_DECLS
-
 #include <core/jlist.h>
 
 G_BEGIN_DECLS
 
-G_GNUC_INTERNAL JListElement* j_list_head(JList*);
+G_GNUC_INTERNAL gpointer* j_list_get_elements(JList*);
 
 G_END_DECLS
 
@@ -52,6 +52,7 @@ gpointer j_list_get_first(JList*);
 gpointer j_list_get_last(JList*);
 
 void j_list_delete_all(JList*);
+gboolean j_list_remove(JList*, gpointer);
 
 G_END_DECLS
 
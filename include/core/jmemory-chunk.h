@@ -36,10 +36,16 @@ struct JMemoryChunk;
 typedef struct JMemoryChunk JMemoryChunk;
 
 JMemoryChunk* j_memory_chunk_new(guint64);
+JMemoryChunk* j_memory_chunk_new_growable(guint64, guint64, gboolean);
 void j_memory_chunk_free(JMemoryChunk*);
 
 gpointer j_memory_chunk_get(JMemoryChunk*, guint64);
 void j_memory_chunk_reset(JMemoryChunk*);
+void j_memory_chunk_shrink(JMemoryChunk*);
+
+guint64 j_memory_chunk_get_size(JMemoryChunk*);
+
+guint64 j_memory_chunk_get_peak(JMemoryChunk*);
 
 G_END_DECLS
 
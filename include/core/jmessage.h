@@ -30,6 +30,8 @@
 #include <glib.h>
 #include <gio/gio.h>
 
+#include <core/jtrace.h>
+
 G_BEGIN_DECLS
 
 enum JMessageType
@@ -56,7 +58,26 @@ enum JMessageType
 	J_MESSAGE_DB_INSERT,
 	J_MESSAGE_DB_UPDATE,
 	J_MESSAGE_DB_DELETE,
-	J_MESSAGE_DB_QUERY
+	J_MESSAGE_DB_QUERY,
+	J_MESSAGE_DB_AGGREGATE,
+	J_MESSAGE_TRANSACTION_COMMIT,
+	J_MESSAGE_TRANSACTION_ABORT,
+	J_MESSAGE_KV_COMPARE_AND_SWAP,
+	J_MESSAGE_KV_ADD,
+	J_MESSAGE_KV_GET_RANGE,
+	J_MESSAGE_OBJECT_REDUCE,
+	J_MESSAGE_OBJECT_DELETE_PREFIX,
+	J_MESSAGE_KV_DELETE_PREFIX,
+	J_MESSAGE_DB_ADVISE_INDEXES,
+	J_MESSAGE_OBJECT_APPEND,
+	J_MESSAGE_OBJECT_CLONE,
+	J_MESSAGE_OBJECT_ADVISE,
+	J_MESSAGE_OBJECT_DEDUP,
+	J_MESSAGE_KV_BLOOM_FILTER,
+	J_MESSAGE_OBJECT_LIST,
+	J_MESSAGE_KV_REPLICATE,
+	J_MESSAGE_DB_REPLICATE,
+	J_MESSAGE_OBJECT_DISCARD
 };
 
 typedef enum JMessageType JMessageType;
@@ -65,6 +86,70 @@ struct JMessage;
 
 typedef struct JMessage JMessage;
 
+/**
+ * Set in a length appended to a message if the data does not follow inline
+ * but is sent after the message via j_message_add_send().
+ **/
+#define J_MESSAGE_LENGTH_DEFERRED (1U << 31)
+
+/**
+ * Set in a put's value length if the length is followed by the key's 8-byte TTL.
+ **/
+#define J_MESSAGE_LENGTH_EXPIRY (1U << 30)
+
+/**
+ * Set in an object read's or write's length if the extent is protected by a CRC32C checksum.
+ * Writes append the checksum to the offset, replies to reads contain it after the number of bytes read.
+ **/
+#define J_MESSAGE_LENGTH_CHECKSUM (G_GUINT64_CONSTANT(1) << 63)
+
+/**
+ * Set in an object write's length if the extent is a deduplication block whose content is not stored yet.
+ * The block's digest, see j_checksum_digest(), follows the offset and the checksum, if any.
+ **/
+#define J_MESSAGE_LENGTH_DEDUP (G_GUINT64_CONSTANT(1) << 62)
+
+/**
+ * The size of the blocks objects are deduplicated in.
+ * Only blocks that are aligned to it within an object's part on a server are deduplicated.
+ **/
+#define J_MESSAGE_DEDUP_BLOCK_SIZE (1024 * 1024)
+
+/**
+ * Used as an append's counter offset if the data follows and is appended to the end of the object.
+ * Other values denote the offset of an 8-byte counter within the object, which is advanced without appending any data.
+ **/
+#define J_MESSAGE_APPEND_END G_MAXUINT64
+
+/**
+ * The server-side timings of a request, echoed back in its reply.
+ * Times are given in microseconds.
+ **/
+struct JMessageTiming
+{
+	/**
+	 * The time the request waited for a server thread after it became readable.
+	 **/
+	guint32 queue_time;
+
+	/**
+	 * The time spent receiving the request.
+	 **/
+	guint32 receive_time;
+
+	/**
+	 * The time spent handling the request until its reply was ready to be sent.
+	 **/
+	guint32 service_time;
+
+	/**
+	 * Reserved for future use.
+	 **/
+	guint32 reserved;
+};
+
+typedef struct JMessageTiming JMessageTiming;
+
 G_END_DECLS
 
 #include <core/jsemantics.h>
@@ -79,7 +164,13 @@ void j_message_unref(JMessage*);
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(JMessage, j_message_unref)
 
 JMessageType j_message_get_type(JMessage const*);
+gchar const* j_message_type_get_name(JMessageType);
 guint32 j_message_get_count(JMessage const*);
+gboolean j_message_get_trace_context(JMessage const*, JTraceContext*);
+gboolean j_message_get_timing(JMessage const*, JMessageTiming*);
+void j_message_set_timing(JMessage*, JMessageTiming const*);
+gboolean j_message_get_lazy_create(JMessage const*);
+void j_message_set_lazy_create(JMessage*, gboolean);
 
 gboolean j_message_append_1(JMessage*, gconstpointer);
 gboolean j_message_append_4(JMessage*, gconstpointer);
@@ -95,11 +186,19 @@ gchar const* j_message_get_string(JMessage*);
 
 gboolean j_message_send(JMessage*, gpointer);
 gboolean j_message_receive(JMessage*, gpointer);
+gboolean j_message_receive_data(JMessage*, gpointer);
+gboolean j_message_receive_file(JMessage*, gpointer, gint, guint64, guint64, guint64*);
+
+gboolean j_message_compression_supported(gchar const*);
+gboolean j_message_set_compression(gpointer, gchar const*);
+void j_message_set_compact(gpointer, gboolean);
 
 gboolean j_message_read(JMessage*, GInputStream*);
 gboolean j_message_write(JMessage*, GOutputStream*);
 
 void j_message_add_send(JMessage*, gconstpointer, guint64);
+void j_message_add_send_file(JMessage*, gint, guint64, guint64);
+void j_message_add_receive(JMessage*, gpointer, guint64);
 void j_message_add_operation(JMessage*, gsize);
 
 void j_message_set_semantics(JMessage*, JSemantics*);
@@ -37,6 +37,23 @@ G_BEGIN_DECLS
 typedef gboolean (*JOperationExecFunc)(JList*, JSemantics*);
 typedef void (*JOperationFreeFunc)(gpointer);
 
+/**
+ * Prepares an operation for deferred execution by the operation cache.
+ *
+ * Returns the number of bytes the operation needs in the cache.
+ * If the buffer is not NULL, all data still owned by the caller has to be copied into it,
+ * so that the operation can be executed after the batch has returned.
+ **/
+typedef guint64 (*JOperationCacheFunc)(gpointer, gpointer);
+
+/**
+ * Returns an identifier for the state an operation replaces completely, or NULL.
+ *
+ * Queued operations with the same identifier are superseded by later ones and dropped by the operation cache.
+ * The identifier has to be freed with g_free().
+ **/
+typedef gchar* (*JOperationCoalesceFunc)(gpointer);
+
 /**
  * An operation.
  **/
@@ -47,11 +64,28 @@ struct JOperation
 
 	JOperationExecFunc exec_func;
 	JOperationFreeFunc free_func;
+
+	/**
+	 * Operations without a cache function can not be cached.
+	 **/
+	JOperationCacheFunc cache_func;
+
+	/**
+	 * Operations without a coalesce function are never dropped.
+	 **/
+	JOperationCoalesceFunc coalesce_func;
+
+	/**
+	 * The size of the data allocated together with the operation, 0 if the data is owned separately.
+	 * Free functions must not free such data themselves.
+	 **/
+	gsize data_size;
 };
 
 typedef struct JOperation JOperation;
 
 JOperation* j_operation_new(void);
+JOperation* j_operation_new_with_data(gsize);
 
 G_END_DECLS
 
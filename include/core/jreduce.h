@@ -0,0 +1,85 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#ifndef JULEA_REDUCE_H
+#define JULEA_REDUCE_H
+
+#if !defined(JULEA_H) && !defined(JULEA_COMPILATION)
+#error "Only <julea.h> can be included directly."
+#endif
+
+#include <glib.h>
+
+#include <core/jmessage.h>
+
+G_BEGIN_DECLS
+
+/**
+ * The type of the elements an object consists of.
+ **/
+enum JReduceType
+{
+	J_REDUCE_TYPE_INT32,
+	J_REDUCE_TYPE_INT64,
+	J_REDUCE_TYPE_UINT32,
+	J_REDUCE_TYPE_UINT64,
+	J_REDUCE_TYPE_FLOAT32,
+	J_REDUCE_TYPE_FLOAT64
+};
+
+typedef enum JReduceType JReduceType;
+
+struct JReduce;
+
+typedef struct JReduce JReduce;
+
+JReduce* j_reduce_new(JReduceType);
+JReduce* j_reduce_new_like(JReduce*);
+JReduce* j_reduce_ref(JReduce*);
+void j_reduce_unref(JReduce*);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(JReduce, j_reduce_unref)
+
+void j_reduce_set_filter(JReduce*, gdouble, gdouble);
+void j_reduce_set_histogram(JReduce*, gdouble, gdouble, guint32);
+
+JReduceType j_reduce_get_type(JReduce*);
+guint64 j_reduce_get_count(JReduce*);
+gdouble j_reduce_get_sum(JReduce*);
+gdouble j_reduce_get_min(JReduce*);
+gdouble j_reduce_get_max(JReduce*);
+guint64 const* j_reduce_get_histogram(JReduce*, guint32*);
+
+void j_reduce_process(JReduce*, gconstpointer, guint64);
+void j_reduce_merge(JReduce*, JReduce*);
+
+gsize j_reduce_get_spec_size(void);
+void j_reduce_append_spec(JReduce*, JMessage*);
+JReduce* j_reduce_new_from_message(JMessage*);
+
+gsize j_reduce_get_result_size(JReduce*);
+void j_reduce_append_result(JReduce*, JMessage*);
+void j_reduce_merge_from_message(JReduce*, JMessage*);
+
+G_END_DECLS
+
+#endif
@@ -29,6 +29,8 @@
 
 #include <glib.h>
 
+#include <core/jmessage.h>
+
 G_BEGIN_DECLS
 
 enum JStatisticsType
@@ -40,11 +42,57 @@ enum JStatisticsType
 	J_STATISTICS_BYTES_READ,
 	J_STATISTICS_BYTES_WRITTEN,
 	J_STATISTICS_BYTES_RECEIVED,
-	J_STATISTICS_BYTES_SENT
+	J_STATISTICS_BYTES_SENT,
+	J_STATISTICS_CONNECTIONS,
+	J_STATISTICS_CONNECTIONS_IDLE,
+	J_STATISTICS_CONNECTIONS_LIMIT,
+	J_STATISTICS_MESSAGES_SENT,
+	J_STATISTICS_MESSAGES_RECEIVED,
+	J_STATISTICS_BATCHES,
+	/* Times are given in microseconds. */
+	J_STATISTICS_BATCH_QUEUE_TIME,
+	J_STATISTICS_BATCH_EXECUTION_TIME,
+	J_STATISTICS_BATCH_NETWORK_TIME,
+	/* Only accounted if servers echo their timings, see JULEA_MESSAGE_TIMING. */
+	J_STATISTICS_BATCH_SERVER_QUEUE_TIME,
+	J_STATISTICS_BATCH_SERVER_TIME
 };
 
 typedef enum JStatisticsType JStatisticsType;
 
+/**
+ * Per-message-type statistics.
+ **/
+enum JStatisticsMessageType
+{
+	J_STATISTICS_MESSAGE_REQUESTS,
+	J_STATISTICS_MESSAGE_BYTES,
+	/* Times are given in microseconds. */
+	J_STATISTICS_MESSAGE_TIME,
+	/* From the connection becoming readable until a thread starts receiving. */
+	J_STATISTICS_MESSAGE_QUEUE_TIME,
+	/* From starting to receive until the full request is available. */
+	J_STATISTICS_MESSAGE_RECEIVE_TIME,
+	/* From dispatching the request until its reply is ready. */
+	J_STATISTICS_MESSAGE_SERVICE_TIME,
+	/* From the reply being ready until it has been sent. */
+	J_STATISTICS_MESSAGE_REPLY_TIME
+};
+
+typedef enum JStatisticsMessageType JStatisticsMessageType;
+
+/**
+ * The number of message types statistics are kept for.
+ **/
+#define J_STATISTICS_MESSAGE_TYPES (J_MESSAGE_OBJECT_DISCARD + 1)
+
+/**
+ * The number of buckets in a latency histogram.
+ * Bucket 0 counts durations of 0 microseconds, bucket i counts durations in [2^(i-1), 2^i) microseconds.
+ * The last bucket also counts all longer durations.
+ **/
+#define J_STATISTICS_LATENCY_BUCKETS 32
+
 struct JStatistics;
 
 typedef struct JStatistics JStatistics;
@@ -55,6 +103,14 @@ void j_statistics_free(JStatistics*);
 guint64 j_statistics_get(JStatistics*, JStatisticsType);
 void j_statistics_add(JStatistics*, JStatisticsType, guint64);
 
+guint64 j_statistics_get_message(JStatistics*, JMessageType, JStatisticsMessageType);
+void j_statistics_add_message(JStatistics*, JMessageType, JStatisticsMessageType, guint64);
+
+guint64 j_statistics_get_latency(JStatistics*, JMessageType, guint);
+void j_statistics_add_latency(JStatistics*, JMessageType, guint64);
+
+void j_statistics_merge(JStatistics*, JStatistics*);
+
 G_END_DECLS
 
 #endif
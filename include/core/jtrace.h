@@ -36,6 +36,7 @@ enum JTraceFileOperation
 	J_TRACE_FILE_CLOSE,
 	J_TRACE_FILE_CREATE,
 	J_TRACE_FILE_DELETE,
+	J_TRACE_FILE_DISCARD,
 	J_TRACE_FILE_OPEN,
 	J_TRACE_FILE_READ,
 	J_TRACE_FILE_SEEK,
@@ -50,6 +51,18 @@ struct JTrace;
 
 typedef struct JTrace JTrace;
 
+/**
+ * A trace context, identifying a span within a distributed trace.
+ * The layout matches the trace and span IDs used by OpenTelemetry.
+ **/
+struct JTraceContext
+{
+	guint8 trace_id[16];
+	guint8 span_id[8];
+};
+
+typedef struct JTraceContext JTraceContext;
+
 void j_trace_init(gchar const*);
 void j_trace_fini(void);
 
@@ -80,6 +93,12 @@ void j_trace_file_begin(gchar const*, JTraceFileOperation);
 void j_trace_file_end(gchar const*, JTraceFileOperation, guint64, guint64);
 
 void j_trace_counter(gchar const*, guint64);
+void j_trace_duration(gchar const*, guint64);
+
+void j_trace_summary_print(void);
+
+gboolean j_trace_context_get(JTraceContext*);
+void j_trace_context_set(JTraceContext const*);
 
 G_END_DECLS
 
@@ -0,0 +1,49 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#ifndef JULEA_TRANSACTION_H
+#define JULEA_TRANSACTION_H
+
+#if !defined(JULEA_H) && !defined(JULEA_COMPILATION)
+#error "Only <julea.h> can be included directly."
+#endif
+
+#include <glib.h>
+
+#include <core/jbackend.h>
+
+G_BEGIN_DECLS
+
+struct JTransaction;
+
+typedef struct JTransaction JTransaction;
+
+JTransaction* j_transaction_get_current(void);
+
+guint64 j_transaction_get_id(JTransaction*);
+
+void j_transaction_add_participant(JTransaction*, JBackendType, guint32);
+void j_transaction_vote(JTransaction*, gboolean);
+
+G_END_DECLS
+
+#endif
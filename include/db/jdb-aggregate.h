@@ -0,0 +1,186 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2019 Benjamin Warnke
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#ifndef JULEA_DB_AGGREGATE_H
+#define JULEA_DB_AGGREGATE_H
+
+#if !defined(JULEA_DB_H) && !defined(JULEA_DB_COMPILATION)
+#error "Only <julea-db.h> can be included directly."
+#endif
+
+#include <glib.h>
+
+#include <julea.h>
+
+G_BEGIN_DECLS
+
+enum JDBAggregateFunction
+{
+	// Number of entries, does not require a field
+	J_DB_AGGREGATE_FUNCTION_COUNT,
+	// Sum of a field, returned as J_DB_TYPE_SINT64, J_DB_TYPE_UINT64 or J_DB_TYPE_FLOAT64
+	J_DB_AGGREGATE_FUNCTION_SUM,
+	// Minimum of a field, returned using the field's type
+	J_DB_AGGREGATE_FUNCTION_MIN,
+	// Maximum of a field, returned using the field's type
+	J_DB_AGGREGATE_FUNCTION_MAX,
+	// Average of a field, returned as J_DB_TYPE_FLOAT64
+	J_DB_AGGREGATE_FUNCTION_AVG
+};
+
+typedef enum JDBAggregateFunction JDBAggregateFunction;
+
+struct JDBAggregate;
+
+typedef struct JDBAggregate JDBAggregate;
+
+G_END_DECLS
+
+#include <db/jdb-schema.h>
+#include <db/jdb-selector.h>
+#include <db/jdb-type.h>
+
+G_BEGIN_DECLS
+
+/**
+ * Allocates a new aggregation.
+ *
+ * Aggregations are evaluated by the backend, only the results are transferred.
+ * Without any group-by fields, the result consists of exactly one row.
+ *
+ * \param[in] schema The schema defines the structure of the aggregation
+ * \param[in] selector The selector defines which entries to aggregate, NULL aggregates all entries
+ * \pre schema != NULL
+ * \pre schema is initialized
+ *
+ * \return the new aggregation or NULL on failure
+ **/
+
+JDBAggregate* j_db_aggregate_new(JDBSchema* schema, JDBSelector* selector, GError** error);
+
+/**
+ * Increase the ref_count of the given aggregation.
+ *
+ * \param[in] aggregate the aggregation to increase the ref_count
+ * \pre aggregate != NULL
+ *
+ * \return the aggregation or NULL on failure
+ **/
+
+JDBAggregate* j_db_aggregate_ref(JDBAggregate* aggregate);
+
+/**
+ * Decrease the ref_count of the given aggregation - and automatically call free if ref_count is 0. This is a noop if aggregate == NULL.
+ *
+ * \param[in] aggregate the aggregation to decrease the ref_count
+ **/
+
+void j_db_aggregate_unref(JDBAggregate* aggregate);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(JDBAggregate, j_db_aggregate_unref)
+
+/**
+ * Add an aggregate function to the aggregation.
+ *
+ * \param[in] aggregate the aggregation to extend
+ * \param[in] name the name of the result, which is used to retrieve it using j_db_aggregate_get_field
+ * \param[in] function the aggregate function
+ * \param[in] field the field to aggregate, NULL for J_DB_AGGREGATE_FUNCTION_COUNT
+ * \pre aggregate != NULL
+ * \pre aggregate has not been executed
+ * \pre name != NULL
+ * \pre name is not used by another result or group-by field
+ * \pre field is a numeric field of the schema unless function is J_DB_AGGREGATE_FUNCTION_COUNT
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_aggregate_add(JDBAggregate* aggregate, gchar const* name, JDBAggregateFunction function, gchar const* field, GError** error);
+
+/**
+ * Group the aggregated entries by a field.
+ * Results are returned once per distinct combination of group-by fields, which can be retrieved using their names.
+ *
+ * \param[in] aggregate the aggregation to extend
+ * \param[in] field the field to group by
+ * \pre aggregate != NULL
+ * \pre aggregate has not been executed
+ * \pre field is a non-blob field of the schema
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_aggregate_group_by(JDBAggregate* aggregate, gchar const* field, GError** error);
+
+/**
+ * Execute the aggregation.
+ *
+ * \param[in] aggregate the aggregation to execute
+ * \param[in] batch the batch to append this operation to
+ * \pre aggregate != NULL
+ * \pre aggregate contains at least one aggregate function
+ * \pre batch != NULL
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_aggregate_execute(JDBAggregate* aggregate, JBatch* batch, GError** error);
+
+/**
+ * Move to the next result row after the aggregation has been executed.
+ *
+ * \param[inout] aggregate to update
+ * \pre aggregate != NULL
+ * \pre the batch containing the aggregation has been executed
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_aggregate_next(JDBAggregate* aggregate, GError** error);
+
+/**
+ * Get a result or group-by field from the current result row.
+ * Results are undefined if no entries have been aggregated, for example, MIN without any entries.
+ *
+ * \param[in] aggregate to query
+ * \param[in] name the name of the result or group-by field
+ * \param[out] type the type of the retrieved value
+ * \param[out] value the retieved value
+ * \param[out] length the length of the retrieved value
+ * \pre aggregate != NULL
+ * \pre j_db_aggregate_next returned TRUE
+ * \pre name != NULL
+ * \pre type != NULL
+ * \pre value != NULL
+ * \pre *value should not be initialized
+ * \pre length != NULL
+ * \post *value points to a new allocated memory region. The caller must free this later using g_free.
+ * \post *length contains the length of the allocated memory region
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_aggregate_get_field(JDBAggregate* aggregate, gchar const* name, JDBType* type, gpointer* value, guint64* length, GError** error);
+
+G_END_DECLS
+
+#endif
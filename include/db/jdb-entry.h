@@ -98,6 +98,22 @@ gboolean j_db_entry_get_id(JDBEntry* entry, gpointer* value, guint64* length, GE
 
 gboolean j_db_entry_set_field(JDBEntry* entry, gchar const* name, gconstpointer value, guint64 length, GError** error);
 
+/**
+ * Set all elements of an array field in the given entry
+ *
+ * \param[in] entry the entry to set a value
+ * \param[in] name the name of the array
+ * \param[in] values a C array of the element type defined in the schema
+ * \param[in] length the number of elements, must match the schema
+ * \pre entry != NULL
+ * \pre name != NULL
+ * \pre values != NULL
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_entry_set_array_field(JDBEntry* entry, gchar const* name, gconstpointer values, guint32 length, GError** error);
+
 /**
  * Save the entry in the backend.
  * All variables defined in the schema, which are not explicitily set, are initialized to NULL.
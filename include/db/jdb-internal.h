@@ -33,6 +33,7 @@
 
 #include <julea.h>
 
+#include <db/jdb-aggregate.h>
 #include <db/jdb-entry.h>
 #include <db/jdb-iterator.h>
 #include <db/jdb-schema.h>
@@ -52,17 +53,44 @@ struct JDBEntry
 
 struct JDBIterator
 {
-	bson_t bson;
-
 	JDBSchema* schema;
 	JDBSelector* selector;
+	// Projected fields, NULL if all fields are retrieved
+	bson_t* fields;
 
 	gpointer iterator;
 
 	gint ref_count;
 
 	gboolean valid;
-	gboolean bson_valid;
+	// Whether the iterator points to an entry
+	gboolean row_valid;
+};
+
+struct JDBAggregate
+{
+	JDBSchema* schema;
+	JDBSelector* selector;
+
+	// Combined into bson when the aggregation is executed
+	bson_t group;
+	bson_t functions;
+	guint group_count;
+	guint function_count;
+
+	// Group-by fields and aggregate functions
+	bson_t bson;
+	// Result and group-by field name -> JDBType
+	GHashTable* types;
+
+	gpointer page;
+	guint32 row;
+
+	gint ref_count;
+
+	gboolean executed;
+	gboolean initialized;
+	gboolean row_valid;
 };
 
 struct JDBSchemaIndex
@@ -86,6 +114,9 @@ struct JDBSchema
 	guint bson_index_count;
 	gint ref_count;
 
+	// The schema cache's generation when the schema was requested, see j_db_schema_cache_insert()
+	guint cache_generation;
+
 	gboolean bson_initialized;
 	gboolean bson_index_initialized;
 	gboolean server_side;
@@ -98,6 +129,18 @@ struct JDBSelector
 	JDBSelectorMode mode;
 	JDBSchema* schema;
 
+	/**
+	 * The parameters' values are replaced in place by j_db_selector_bind().
+	 * Contains JDBSelectorParameter elements.
+	 **/
+	GArray* parameters;
+
+	/**
+	 * Whether the selector's shape is fixed.
+	 * Prepared selectors carry a _shape key that allows backends to reuse the query built for the same shape.
+	 **/
+	gboolean prepared;
+
 	guint bson_count;
 	gint ref_count;
 };
@@ -123,17 +166,31 @@ union JDBTypeValue
 gboolean j_db_internal_schema_create(JDBSchema* j_db_schema, JBatch* batch, GError** error);
 gboolean j_db_internal_schema_get(JDBSchema* j_db_schema, JBatch* batch, GError** error);
 gboolean j_db_internal_schema_delete(JDBSchema* j_db_schema, JBatch* batch, GError** error);
+gboolean j_db_internal_schema_advise_indexes(JDBSchema* j_db_schema, gboolean create, GPtrArray* indexes, JBatch* batch, GError** error);
 gboolean j_db_internal_insert(JDBEntry* j_db_entry, JBatch* batch, GError** error);
 gboolean j_db_internal_update(JDBEntry* j_db_entry, JDBSelector* j_db_selector, JBatch* batch, GError** error);
 gboolean j_db_internal_delete(JDBEntry* j_db_entry, JDBSelector* j_db_selector, JBatch* batch, GError** error);
 gboolean j_db_internal_query(JDBSchema* j_db_schema, JDBSelector* j_db_selector, JDBIterator* j_db_iterator, JBatch* batch, GError** error);
 gboolean j_db_internal_iterate(JDBIterator* j_db_iterator, GError** error);
+gboolean j_db_internal_iterator_get_value(JDBIterator* j_db_iterator, gchar const* name, JDBType type, JDBTypeValue* value, GError** error);
+void j_db_internal_iterator_free(JDBIterator* j_db_iterator);
+gboolean j_db_internal_aggregate(JDBAggregate* j_db_aggregate, JBatch* batch, GError** error);
+gboolean j_db_internal_aggregate_next(JDBAggregate* j_db_aggregate, GError** error);
+gboolean j_db_internal_aggregate_get_value(JDBAggregate* j_db_aggregate, gchar const* name, JDBType type, JDBTypeValue* value, GError** error);
+void j_db_internal_aggregate_free(JDBAggregate* j_db_aggregate);
+void j_db_internal_value_copy(JDBType type, JDBTypeValue const* val, gpointer* value, guint64* length);
 
 // Client-side additional internal functions
 bson_t* j_db_selector_get_bson(JDBSelector* selector);
 
 G_GNUC_INTERNAL JBackend* j_db_get_backend(void);
 
+G_GNUC_INTERNAL gsize j_db_type_get_element_size(JDBType type);
+
+G_GNUC_INTERNAL gboolean j_db_schema_cache_lookup(JDBSchema* schema, JSemantics* semantics);
+G_GNUC_INTERNAL void j_db_schema_cache_insert(JDBSchema* schema);
+G_GNUC_INTERNAL void j_db_schema_cache_remove(JDBSchema* schema);
+
 G_END_DECLS
 
 #endif
@@ -57,6 +57,24 @@ G_BEGIN_DECLS
 
 JDBIterator* j_db_iterator_new(JDBSchema* schema, JDBSelector* selector, GError** error);
 
+/**
+ * Allocates a new iterator that only retrieves the given fields.
+ *
+ * Fields that are not part of the projection can not be read using j_db_iterator_get_field.
+ * The backend only has to read and transfer the requested fields, which is cheaper for wide schemas.
+ *
+ * \param[in] schema The schema defines the structure of the iterator
+ * \param[in] selector The selector defines which entrys to select
+ * \param[in] fields A NULL-terminated array of field names, NULL retrieves all fields
+ * \pre schema != NULL
+ * \pre schema is initialized
+ * \pre fields only contains fields of schema
+ *
+ * \return the new iterator or NULL on failure
+ **/
+
+JDBIterator* j_db_iterator_new_for_fields(JDBSchema* schema, JDBSelector* selector, gchar const** fields, GError** error);
+
 /**
  * Increase the ref_count of the given iterator.
  *
@@ -111,6 +129,26 @@ gboolean j_db_iterator_next(JDBIterator* iterator, GError** error);
 
 gboolean j_db_iterator_get_field(JDBIterator* iterator, gchar const* name, JDBType* type, gpointer* value, guint64* length, GError** error);
 
+/**
+ * Get all elements of an array field from the current entry of the iterator.
+ *
+ * \param[in] iterator to query
+ * \param[in] name the name of the array to retrieve
+ * \param[out] type the type of the array's elements
+ * \param[out] values the retrieved elements as a C array of the element type
+ * \param[out] length the number of elements
+ * \pre iterator != NULL
+ * \pre name != NULL
+ * \pre type != NULL
+ * \pre values != NULL
+ * \pre length != NULL
+ * \post *values points to a new allocated memory region. The caller must free this later using g_free.
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_iterator_get_array_field(JDBIterator* iterator, gchar const* name, JDBType* type, gpointer* values, guint32* length, GError** error);
+
 G_END_DECLS
 
 #endif
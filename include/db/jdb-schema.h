@@ -115,6 +115,56 @@ gboolean j_db_schema_add_field(JDBSchema* schema, gchar const* name, JDBType typ
 
 gboolean j_db_schema_get_field(JDBSchema* schema, gchar const* name, JDBType* type, GError** error);
 
+/**
+ * Add a fixed-length array field to the schema.
+ *
+ * Each element is stored as a separate field named name[i] (see j_db_array_element_name), so backends store arrays as native numeric columns.
+ * Individual elements can be used in selectors and indexes using their element names.
+ *
+ * \param[in] schema the schema to add a field to
+ * \param[in] name the name of the array to add
+ * \param[in] type the type of the elements, must be a numeric type
+ * \param[in] length the number of elements
+ *
+ * \pre schema != NULL
+ * \pre name != NULL
+ * \pre length > 0
+ * \pre schema does not contain a variable with the given name
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_schema_add_array_field(JDBSchema* schema, gchar const* name, JDBType type, guint32 length, GError** error);
+
+/**
+ * query an array field from the schema.
+ *
+ * \param[in] schema the schema to query
+ * \param[in] name the name of the array to query
+ * \param[out] type the type of the array's elements
+ * \param[out] length the number of elements
+ *
+ * \pre schema != NULL
+ * \pre name != NULL
+ * \pre type != NULL
+ * \pre length != NULL
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_schema_get_array_field(JDBSchema* schema, gchar const* name, JDBType* type, guint32* length, GError** error);
+
+/**
+ * Returns the field name of an array element.
+ *
+ * \param[in] name the name of the array
+ * \param[in] index the index of the element
+ *
+ * \return the field name, which must be freed by the caller using g_free
+ **/
+
+gchar* j_db_array_element_name(gchar const* name, guint32 index);
+
 /**
  * query all variables from the schema.
  *
@@ -197,6 +247,28 @@ gboolean j_db_schema_get(JDBSchema* schema, JBatch* batch, GError** error);
 
 gboolean j_db_schema_delete(JDBSchema* schema, JBatch* batch, GError** error);
 
+/**
+ * suggests indexes for a schema based on the selectors the backend has observed.
+ *
+ * Each suggestion is a NULL-terminated array of field names, as passed to j_db_schema_add_index.
+ * Suggestions are ordered by the time spent in the queries they would speed up.
+ * Only backends that record their queries support suggestions, currently the SQL backends.
+ *
+ * \param[in] schema the schema to get suggestions for
+ * \param[in] create whether the suggested indexes should be created right away
+ * \param[out] indexes receives the suggestions after the batch has been executed, should free its elements using g_strfreev
+ * \param[in] batch the batch to add this operation to
+ *
+ * \pre schema != NULL
+ * \pre schema exists in the backend
+ * \pre indexes != NULL
+ * \pre batch != NULL
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_schema_advise_indexes(JDBSchema* schema, gboolean create, GPtrArray* indexes, JBatch* batch, GError** error);
+
 /**
  * compares two schema with each other.
  *
@@ -138,6 +138,63 @@ gboolean j_db_selector_add_field(JDBSelector* selector, gchar const* name, JDBSe
 
 gboolean j_db_selector_add_selector(JDBSelector* selector, JDBSelector* sub_selector, GError** error);
 
+/**
+ * add a search field whose value is bound later to the selector.
+ *
+ * Parameters are numbered in the order they are added, starting at 0.
+ * The parameters of a sub_selector are appended to those of the selector when it is added.
+ *
+ * \param[in] selector to add a parameter to
+ * \param[in] name the name of the field to compare
+ * \param[in] operator the operator to use to compare the stored value with the bound value
+ *
+ * \pre selector != NULL
+ * \pre selector is not prepared
+ * \pre name != NULL
+ * \pre name must exist in the schema
+ * \pre selector including all previously added sub_selectors must not contain more than 500 search fields after applying this operation
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_selector_add_parameter(JDBSelector* selector, gchar const* name, JDBSelectorOperator operator_, GError** error);
+
+/**
+ * Fix the shape of the selector.
+ *
+ * Backends cache the query built for a prepared selector, so that running it again with different parameter values does not have to rebuild it.
+ * Afterwards, no fields or sub_selectors can be added to the selector.
+ *
+ * \param[in] selector to prepare
+ *
+ * \pre selector != NULL
+ * \pre selector is not prepared
+ * \pre selector must not be empty
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_selector_prepare(JDBSelector* selector, GError** error);
+
+/**
+ * bind a value to a parameter of the selector.
+ *
+ * \param[in] selector to bind a value in
+ * \param[in] index the number of the parameter
+ * \param[in] value the value to compare with
+ * \param[in] length the length of the value. Only used if value is binary
+ *
+ * \pre selector != NULL
+ * \pre selector is prepared
+ * \pre index is smaller than the number of parameters
+ * \pre operations using the selector have been executed
+ * \post the value may be freed or modified by the caller immediately after calling this function
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_selector_bind(JDBSelector* selector, guint32 index, gconstpointer value, guint64 length, GError** error);
+
 G_END_DECLS
 
 #endif
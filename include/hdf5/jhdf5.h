@@ -37,6 +37,31 @@ G_BEGIN_DECLS
 
 void j_hdf5_set_semantics(JSemantics*);
 
+/**
+ * Finds the datasets linked from a file or group whose values may lie within a range.
+ * Only supported by the julea-db connector, which maintains the datasets' minimum and maximum values.
+ *
+ * \param loc_id A file or group.
+ * \param min    The lower bound of the range.
+ * \param max    The upper bound of the range.
+ *
+ * \return A NULL-terminated array of dataset names to be freed with g_strfreev(), NULL if the search is not supported.
+ **/
+gchar** j_hdf5_db_find_datasets(hid_t loc_id, gdouble min, gdouble max);
+
+/**
+ * Finds the chunks of a chunked dataset whose values may lie within a range.
+ * Only supported by the julea-db connector.
+ *
+ * \param dataset_id A chunked dataset.
+ * \param min        The lower bound of the range.
+ * \param max        The upper bound of the range.
+ * \param offsets    Returns the chunks' offsets, rank entries per chunk, to be freed with g_free().
+ *
+ * \return The number of chunks found, -1 if the search is not supported.
+ **/
+gint64 j_hdf5_db_find_chunks(hid_t dataset_id, gdouble min, gdouble max, hsize_t** offsets);
+
 G_END_DECLS
 
 #endif
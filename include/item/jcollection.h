@@ -53,6 +53,7 @@ gchar const* j_collection_get_name(JCollection*);
 JCollection* j_collection_create(gchar const*, JBatch*);
 void j_collection_get(JCollection**, gchar const*, JBatch*);
 void j_collection_delete(JCollection*, JBatch*);
+void j_collection_delete_recursive(JCollection*, guint64*, JBatch*);
 
 G_END_DECLS
 
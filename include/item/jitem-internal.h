@@ -53,6 +53,8 @@ G_GNUC_INTERNAL gboolean j_item_get_exec(JList*, JSemantics*);
 G_GNUC_INTERNAL void j_item_set_modification_time(JItem*, gint64);
 G_GNUC_INTERNAL void j_item_set_size(JItem*, guint64);
 
+G_GNUC_INTERNAL void j_item_invalidate_collection(JCollection*);
+
 G_END_DECLS
 
 #endif
@@ -0,0 +1,78 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#ifndef JULEA_ITEM_ITEM_LIST_H
+#define JULEA_ITEM_ITEM_LIST_H
+
+#if !defined(JULEA_ITEM_H) && !defined(JULEA_ITEM_COMPILATION)
+#error "Only <julea-item.h> can be included directly."
+#endif
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * The fields filled in by a listing.
+ **/
+enum JItemListFields
+{
+	J_ITEM_LIST_NAME = 1 << 0,
+	J_ITEM_LIST_SIZE = 1 << 1,
+	J_ITEM_LIST_MODIFICATION_TIME = 1 << 2
+};
+
+typedef enum JItemListFields JItemListFields;
+
+/**
+ * An item returned by a listing.
+ * Fields that have not been requested are NULL or 0.
+ **/
+struct JItemListEntry
+{
+	gchar const* name;
+	guint64 size;
+	gint64 modification_time;
+};
+
+typedef struct JItemListEntry JItemListEntry;
+
+struct JItemList;
+
+typedef struct JItemList JItemList;
+
+G_END_DECLS
+
+#include <item/jcollection.h>
+
+G_BEGIN_DECLS
+
+JItemList* j_collection_list_items(JCollection*, JItemListFields);
+void j_item_list_free(JItemList*);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(JItemList, j_item_list_free)
+
+gboolean j_item_list_next_page(JItemList*, JItemListEntry const**, guint*);
+
+G_END_DECLS
+
+#endif
@@ -52,6 +52,7 @@ gchar const* j_item_get_name(JItem*);
 JCredentials* j_item_get_credentials(JItem*);
 
 JItem* j_item_create(JCollection*, gchar const*, JDistribution*, JBatch*);
+JItem* j_item_clone(JItem*, JCollection*, gchar const*, JBatch*);
 void j_item_delete(JItem*, JBatch*);
 void j_item_get(JCollection*, JItem**, gchar const*, JBatch*);
 
@@ -0,0 +1,52 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#ifndef JULEA_ITEM_METADATA_CACHE_INTERNAL_H
+#define JULEA_ITEM_METADATA_CACHE_INTERNAL_H
+
+#if !defined(JULEA_ITEM_H) && !defined(JULEA_ITEM_COMPILATION)
+#error "Only <julea-item.h> can be included directly."
+#endif
+
+#include <glib.h>
+
+#include <julea.h>
+
+G_BEGIN_DECLS
+
+struct JMetadataCache;
+
+typedef struct JMetadataCache JMetadataCache;
+
+typedef gpointer (*JMetadataCacheRefFunc)(gpointer);
+
+G_GNUC_INTERNAL JMetadataCache* j_metadata_cache_new(guint, JMetadataCacheRefFunc, GDestroyNotify);
+G_GNUC_INTERNAL void j_metadata_cache_free(JMetadataCache*);
+
+G_GNUC_INTERNAL gpointer j_metadata_cache_lookup(JMetadataCache*, gchar const*, JSemantics*);
+G_GNUC_INTERNAL void j_metadata_cache_insert(JMetadataCache*, gchar const*, gpointer);
+G_GNUC_INTERNAL void j_metadata_cache_remove(JMetadataCache*, gchar const*);
+G_GNUC_INTERNAL void j_metadata_cache_remove_prefix(JMetadataCache*, gchar const*);
+
+G_END_DECLS
+
+#endif
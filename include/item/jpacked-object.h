@@ -0,0 +1,57 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#ifndef JULEA_ITEM_PACKED_OBJECT_H
+#define JULEA_ITEM_PACKED_OBJECT_H
+
+#if !defined(JULEA_ITEM_H) && !defined(JULEA_ITEM_COMPILATION)
+#error "Only <julea-item.h> can be included directly."
+#endif
+
+#include <glib.h>
+
+#include <julea.h>
+
+G_BEGIN_DECLS
+
+struct JPackedObject;
+
+typedef struct JPackedObject JPackedObject;
+
+JPackedObject* j_packed_object_new(gchar const*, gchar const*);
+JPackedObject* j_packed_object_ref(JPackedObject*);
+void j_packed_object_unref(JPackedObject*);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(JPackedObject, j_packed_object_unref)
+
+gchar const* j_packed_object_get_name(JPackedObject*);
+
+void j_packed_object_write(JPackedObject*, gconstpointer, guint64, guint64*, JBatch*);
+void j_packed_object_read(JPackedObject*, gpointer, guint64, guint64, guint64*, JBatch*);
+void j_packed_object_status(JPackedObject*, guint64*, JBatch*);
+void j_packed_object_delete(JPackedObject*, JBatch*);
+
+void j_packed_object_compact(gchar const*, JBatch*);
+
+G_END_DECLS
+
+#endif
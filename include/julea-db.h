@@ -23,6 +23,7 @@
 #ifndef JULEA_DB_H
 #define JULEA_DB_H
 
+#include <db/jdb-aggregate.h>
 #include <db/jdb-entry.h>
 #include <db/jdb-error.h>
 #include <db/jdb-iterator.h>
@@ -27,6 +27,8 @@
 #include <item/jcollection-iterator.h>
 #include <item/jitem.h>
 #include <item/jitem-iterator.h>
+#include <item/jitem-list.h>
+#include <item/jpacked-object.h>
 #include <item/juri.h>
 
 #undef JULEA_ITEM_H
@@ -32,11 +32,16 @@
  * The name JULEA is a play on ROMIO.
  **/
 
+#include <core/jadvice.h>
 #include <core/jbackend.h>
+#include <core/jbackend-latency.h>
 #include <core/jbackend-operation.h>
 #include <core/jbackground-operation.h>
 #include <core/jbatch.h>
+#include <core/jbloom-filter.h>
+#include <core/jbuffer.h>
 #include <core/jcache.h>
+#include <core/jchecksum.h>
 #include <core/jconfiguration.h>
 #include <core/jconnection-pool.h>
 #include <core/jcredentials.h>
@@ -48,9 +53,12 @@
 #include <core/jmemory-chunk.h>
 #include <core/jmessage.h>
 #include <core/joperation.h>
+#include <core/jreduce.h>
 #include <core/jsemantics.h>
 #include <core/jstatistics.h>
 #include <core/jtrace.h>
+#include <core/jtransaction.h>
+#include <core/jtransport.h>
 
 #undef JULEA_H
 
@@ -46,13 +46,19 @@ typedef void (*JKVGetFunc)(gpointer, guint32, gpointer);
 
 JKV* j_kv_new(gchar const*, gchar const*);
 JKV* j_kv_new_for_index(guint32, gchar const*, gchar const*);
+JKV* j_kv_new_local(gchar const*, gchar const*);
 JKV* j_kv_ref(JKV*);
 void j_kv_unref(JKV*);
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(JKV, j_kv_unref)
 
 void j_kv_put(JKV*, gpointer, guint32, GDestroyNotify, JBatch*);
+void j_kv_put_expiring(JKV*, gpointer, guint32, GDestroyNotify, GTimeSpan, JBatch*);
 void j_kv_delete(JKV*, JBatch*);
+void j_kv_delete_prefix(gchar const*, gchar const*, guint64*, JBatch*);
+
+void j_kv_compare_and_swap(JKV*, gconstpointer, guint32, gpointer, guint32, GDestroyNotify, gboolean*, JBatch*);
+void j_kv_add(JKV*, gint64, gint64*, JBatch*);
 
 void j_kv_get(JKV*, gpointer*, guint32*, JBatch*);
 void j_kv_get_callback(JKV*, JKVGetFunc, gpointer, JBatch*);
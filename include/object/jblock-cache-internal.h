@@ -0,0 +1,78 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#ifndef JULEA_OBJECT_BLOCK_CACHE_INTERNAL_H
+#define JULEA_OBJECT_BLOCK_CACHE_INTERNAL_H
+
+#if !defined(JULEA_OBJECT_H) && !defined(JULEA_OBJECT_COMPILATION)
+#error "Only <julea-object.h> can be included directly."
+#endif
+
+#include <glib.h>
+
+#include <julea.h>
+
+G_BEGIN_DECLS
+
+/**
+ * The index used for distributed objects, whose blocks are not stored on a single server.
+ **/
+#define J_BLOCK_CACHE_DISTRIBUTED G_MAXUINT32
+
+struct JBlockCache;
+
+typedef struct JBlockCache JBlockCache;
+
+/**
+ * A read to be served by the block cache.
+ **/
+struct JBlockCacheRead
+{
+	gpointer data;
+	guint64 length;
+	guint64 offset;
+	guint64* bytes_read;
+};
+
+typedef struct JBlockCacheRead JBlockCacheRead;
+
+/**
+ * Executes reads that could not be served by the block cache.
+ *
+ * \param reads     The reads.
+ * \param count     The number of reads.
+ * \param user_data User data.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+typedef gboolean (*JBlockCacheFetchFunc)(JBlockCacheRead* reads, guint count, gpointer user_data);
+
+G_GNUC_INTERNAL JBlockCache* j_block_cache_get(JSemantics*);
+
+G_GNUC_INTERNAL gboolean j_block_cache_read(JBlockCache*, guint32, gchar const*, gchar const*, JBlockCacheRead*, guint, JBlockCacheFetchFunc, gpointer);
+G_GNUC_INTERNAL gboolean j_block_cache_prefetch(JBlockCache*, guint32, gchar const*, gchar const*, guint64, guint64, JBlockCacheFetchFunc, gpointer);
+G_GNUC_INTERNAL void j_block_cache_invalidate(JBlockCache*, guint32, gchar const*, gchar const*, guint64, guint64);
+G_GNUC_INTERNAL void j_block_cache_invalidate_prefix(JBlockCache*, gchar const*, gchar const*);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,74 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#ifndef JULEA_OBJECT_BURST_BUFFER_INTERNAL_H
+#define JULEA_OBJECT_BURST_BUFFER_INTERNAL_H
+
+#if !defined(JULEA_OBJECT_H) && !defined(JULEA_OBJECT_COMPILATION)
+#error "Only <julea-object.h> can be included directly."
+#endif
+
+#include <glib.h>
+
+#include <julea.h>
+
+G_BEGIN_DECLS
+
+struct JBurstBuffer;
+
+typedef struct JBurstBuffer JBurstBuffer;
+
+/**
+ * Writes staged data to the object servers.
+ * Must not use batches, since it is called while other batches might be waiting for the burst buffer.
+ *
+ * \param object The object.
+ * \param data   The data.
+ * \param length The number of bytes.
+ * \param offset The offset.
+ *
+ * \return TRUE if all data has been written, FALSE otherwise.
+ **/
+typedef gboolean (*JBurstBufferDrainFunc)(gpointer object, gconstpointer data, guint64 length, guint64 offset);
+
+/**
+ * Describes a type of objects that can be staged.
+ **/
+struct JBurstBufferType
+{
+	gpointer (*ref)(gpointer);
+	GDestroyNotify unref;
+	JBurstBufferDrainFunc drain;
+};
+
+typedef struct JBurstBufferType JBurstBufferType;
+
+G_GNUC_INTERNAL JBurstBuffer* j_burst_buffer_get(JSemantics*);
+
+G_GNUC_INTERNAL gboolean j_burst_buffer_write(JBurstBuffer*, gchar const*, JBurstBufferType const*, gpointer, gconstpointer, guint64, guint64);
+G_GNUC_INTERNAL gboolean j_burst_buffer_read(JBurstBuffer*, gchar const*, gpointer, guint64, guint64, guint64*);
+G_GNUC_INTERNAL gboolean j_burst_buffer_flush(JBurstBuffer*, gchar const*);
+G_GNUC_INTERNAL gboolean j_burst_buffer_flush_all(JBurstBuffer*);
+
+G_END_DECLS
+
+#endif
@@ -37,21 +37,52 @@ struct JDistributedObject;
 
 typedef struct JDistributedObject JDistributedObject;
 
+/**
+ * A region of an object used for list I/O.
+ **/
+struct JDistributedObjectExtent
+{
+	/**
+	 * The buffer to read into or write from.
+	 **/
+	gpointer data;
+
+	guint64 length;
+	guint64 offset;
+};
+
+typedef struct JDistributedObjectExtent JDistributedObjectExtent;
+
 JDistributedObject* j_distributed_object_new(gchar const*, gchar const*, JDistribution*);
 JDistributedObject* j_distributed_object_ref(JDistributedObject*);
 void j_distributed_object_unref(JDistributedObject*);
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(JDistributedObject, j_distributed_object_unref)
 
+void j_distributed_object_set_read_ahead(JDistributedObject*, guint32);
+
 void j_distributed_object_create(JDistributedObject*, JBatch*);
+void j_distributed_object_create_with_size(JDistributedObject*, guint64, JBatch*);
 void j_distributed_object_delete(JDistributedObject*, JBatch*);
+void j_distributed_object_delete_prefix(gchar const*, gchar const*, JBatch*);
 
 void j_distributed_object_read(JDistributedObject*, gpointer, guint64, guint64, guint64*, JBatch*);
 void j_distributed_object_write(JDistributedObject*, gconstpointer, guint64, guint64, guint64*, JBatch*);
+void j_distributed_object_append(JDistributedObject*, gconstpointer, guint64, guint64*, guint64*, JBatch*);
+
+void j_distributed_object_readv(JDistributedObject*, JDistributedObjectExtent const*, guint32, guint64*, JBatch*);
+void j_distributed_object_writev(JDistributedObject*, JDistributedObjectExtent const*, guint32, guint64*, JBatch*);
 
 void j_distributed_object_status(JDistributedObject*, gint64*, guint64*, JBatch*);
 void j_distributed_object_sync(JDistributedObject*, JBatch*);
 
+void j_distributed_object_advise(JDistributedObject*, JAdvice, guint64, guint64, JBatch*);
+void j_distributed_object_prefetch(JDistributedObject*, guint64, guint64, JBatch*);
+
+void j_distributed_object_clone(JDistributedObject*, JDistributedObject*, JBatch*);
+
+void j_distributed_object_reduce(JDistributedObject*, JReduce*, guint64, guint64, gboolean*, JBatch*);
+
 G_END_DECLS
 
 #endif
@@ -35,6 +35,8 @@ G_BEGIN_DECLS
 
 G_GNUC_INTERNAL JBackend* j_object_get_backend(void);
 
+G_GNUC_INTERNAL void j_object_reserve(JObject*, guint64, guint64, guint64*, guint64*, JBatch*);
+
 G_END_DECLS
 
 #endif
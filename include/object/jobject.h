@@ -45,14 +45,26 @@ void j_object_unref(JObject*);
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(JObject, j_object_unref)
 
 void j_object_create(JObject*, JBatch*);
+void j_object_create_with_size(JObject*, guint64, JBatch*);
 void j_object_delete(JObject*, JBatch*);
+void j_object_delete_prefix(gchar const*, gchar const*, guint64*, JBatch*);
 
 void j_object_read(JObject*, gpointer, guint64, guint64, guint64*, JBatch*);
 void j_object_write(JObject*, gconstpointer, guint64, guint64, guint64*, JBatch*);
+void j_object_append(JObject*, gconstpointer, guint64, guint64*, guint64*, JBatch*);
 
 void j_object_status(JObject*, gint64*, guint64*, JBatch*);
 void j_object_sync(JObject*, JBatch*);
 
+void j_object_discard(JObject*, guint64, guint64, JBatch*);
+
+void j_object_advise(JObject*, JAdvice, guint64, guint64, JBatch*);
+void j_object_prefetch(JObject*, guint64, guint64, JBatch*);
+
+void j_object_clone(JObject*, JObject*, JBatch*);
+
+void j_object_reduce(JObject*, JReduce*, guint64, guint64, gboolean*, JBatch*);
+
 G_END_DECLS
 
 #endif
@@ -0,0 +1,39 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#ifndef JULEA_OBJECT_REED_SOLOMON_INTERNAL_H
+#define JULEA_OBJECT_REED_SOLOMON_INTERNAL_H
+
+#if !defined(JULEA_OBJECT_H) && !defined(JULEA_OBJECT_COMPILATION)
+#error "Only <julea-object.h> can be included directly."
+#endif
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+G_GNUC_INTERNAL void j_reed_solomon_encode(guint, guint, guint8* const*, guint8* const*, gsize);
+G_GNUC_INTERNAL gboolean j_reed_solomon_reconstruct(guint, guint, guint8* const*, gboolean const*, gsize);
+
+G_END_DECLS
+
+#endif
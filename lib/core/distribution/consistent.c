@@ -0,0 +1,302 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <bson.h>
+
+#include <jconfiguration.h>
+#include <jhelper.h>
+#include <jtrace.h>
+
+#include "distribution.h"
+
+/**
+ * \defgroup JDistribution Distribution
+ *
+ * Data structures and functions for managing distributions.
+ *
+ * @{
+ **/
+
+/**
+ * A distribution that places blocks using consistent hashing.
+ * When servers are added, only the blocks that belong on the new servers change their location.
+ **/
+struct JDistributionConsistent
+{
+	/**
+	 * The server count.
+	 **/
+	guint server_count;
+
+	/**
+	 * The length.
+	 **/
+	guint64 length;
+
+	/**
+	 * The offset.
+	 **/
+	guint64 offset;
+
+	/**
+	 * The block size.
+	 */
+	guint64 block_size;
+
+	/**
+	 * The seed that is combined with the block number.
+	 **/
+	guint64 seed;
+};
+
+typedef struct JDistributionConsistent JDistributionConsistent;
+
+/**
+ * Mixes the seed and a block number into a well-distributed hash key.
+ *
+ * \private
+ *
+ * \param seed  A seed.
+ * \param block A block number.
+ *
+ * \return A hash key.
+ **/
+static guint64
+distribution_key(guint64 seed, guint64 block)
+{
+	guint64 key;
+
+	// splitmix64 finalizer, sequential block numbers would otherwise map to similar servers.
+	key = seed + (block * G_GUINT64_CONSTANT(0x9E3779B97F4A7C15));
+	key = (key ^ (key >> 30)) * G_GUINT64_CONSTANT(0xBF58476D1CE4E5B9);
+	key = (key ^ (key >> 27)) * G_GUINT64_CONSTANT(0x94D049BB133111EB);
+	key = key ^ (key >> 31);
+
+	return key;
+}
+
+/**
+ * Distributes data using jump consistent hashing.
+ *
+ * Blocks keep their offset on each server, that is, the objects on the servers may be sparse.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ * \param index        A server index.
+ * \param new_length   A new length.
+ * \param new_offset   A new offset.
+ *
+ * \return TRUE on success, FALSE if the distribution is finished.
+ **/
+static gboolean
+distribution_distribute(gpointer data, guint* index, guint64* new_length, guint64* new_offset, guint64* block_id)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionConsistent* distribution = data;
+
+	guint64 block;
+	guint64 displacement;
+
+	if (distribution->length == 0)
+	{
+		return FALSE;
+	}
+
+	block = distribution->offset / distribution->block_size;
+	displacement = distribution->offset % distribution->block_size;
+
+	*index = j_helper_jump_hash(distribution_key(distribution->seed, block), distribution->server_count);
+	*new_length = MIN(distribution->length, distribution->block_size - displacement);
+	*new_offset = distribution->offset;
+	*block_id = block;
+
+	distribution->length -= *new_length;
+	distribution->offset += *new_length;
+
+	return TRUE;
+}
+
+static gpointer
+distribution_new(guint server_count, guint64 stripe_size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionConsistent* distribution;
+
+	distribution = g_slice_new(JDistributionConsistent);
+	distribution->server_count = server_count;
+	distribution->length = 0;
+	distribution->offset = 0;
+	distribution->block_size = stripe_size;
+	distribution->seed = ((guint64)g_random_int() << 32) | g_random_int();
+
+	return distribution;
+}
+
+static void
+distribution_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionConsistent* distribution = data;
+
+	g_return_if_fail(distribution != NULL);
+
+	g_slice_free(JDistributionConsistent, distribution);
+}
+
+/**
+ * Sets the block size or the seed.
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ * \param key          A key.
+ * \param value        A value.
+ */
+static void
+distribution_set(gpointer data, gchar const* key, guint64 value)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionConsistent* distribution = data;
+
+	g_return_if_fail(distribution != NULL);
+
+	if (g_strcmp0(key, "block-size") == 0)
+	{
+		distribution->block_size = value;
+	}
+	else if (g_strcmp0(key, "seed") == 0)
+	{
+		distribution->seed = value;
+	}
+}
+
+static gboolean
+distribution_get(gpointer data, gchar const* key, guint64* value)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionConsistent* distribution = data;
+
+	g_return_val_if_fail(distribution != NULL, FALSE);
+
+	if (g_strcmp0(key, "block-size") == 0)
+	{
+		*value = distribution->block_size;
+	}
+	else
+	{
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void
+distribution_serialize(gpointer data, bson_t* b)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionConsistent* distribution = data;
+
+	g_return_if_fail(distribution != NULL);
+
+	bson_append_int64(b, "block_size", -1, distribution->block_size);
+	bson_append_int64(b, "seed", -1, (gint64)distribution->seed);
+}
+
+static void
+distribution_deserialize(gpointer data, bson_t const* b)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionConsistent* distribution = data;
+
+	bson_iter_t iterator;
+
+	g_return_if_fail(distribution != NULL);
+	g_return_if_fail(b != NULL);
+
+	bson_iter_init(&iterator, b);
+
+	while (bson_iter_next(&iterator))
+	{
+		gchar const* key;
+
+		key = bson_iter_key(&iterator);
+
+		if (g_strcmp0(key, "block_size") == 0)
+		{
+			distribution->block_size = bson_iter_int64(&iterator);
+		}
+		else if (g_strcmp0(key, "seed") == 0)
+		{
+			distribution->seed = (guint64)bson_iter_int64(&iterator);
+		}
+	}
+}
+
+static void
+distribution_reset(gpointer data, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionConsistent* distribution = data;
+
+	g_return_if_fail(distribution != NULL);
+
+	distribution->length = length;
+	distribution->offset = offset;
+}
+
+void
+j_distribution_consistent_get_vtable(JDistributionVTable* vtable)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	vtable->distribution_new = distribution_new;
+	vtable->distribution_free = distribution_free;
+	vtable->distribution_set = distribution_set;
+	vtable->distribution_set2 = NULL;
+	vtable->distribution_get = distribution_get;
+	vtable->distribution_serialize = distribution_serialize;
+	vtable->distribution_deserialize = distribution_deserialize;
+	vtable->distribution_reset = distribution_reset;
+	vtable->distribution_distribute = distribution_distribute;
+	vtable->distribution_distribute_replica = NULL;
+}
+
+/**
+ * @}
+ **/
@@ -40,12 +40,14 @@ struct JDistributionVTable
 
 	void (*distribution_set)(gpointer, gchar const*, guint64);
 	void (*distribution_set2)(gpointer, gchar const*, guint64, guint64);
+	gboolean (*distribution_get)(gpointer, gchar const*, guint64*);
 
 	void (*distribution_serialize)(gpointer, bson_t*);
 	void (*distribution_deserialize)(gpointer, bson_t const*);
 
 	void (*distribution_reset)(gpointer, guint64, guint64);
 	gboolean (*distribution_distribute)(gpointer, guint*, guint64*, guint64*, guint64*);
+	gboolean (*distribution_distribute_replica)(gpointer, guint, guint*, guint64*);
 };
 
 typedef struct JDistributionVTable JDistributionVTable;
@@ -53,5 +55,9 @@ typedef struct JDistributionVTable JDistributionVTable;
 void j_distribution_round_robin_get_vtable(JDistributionVTable*);
 void j_distribution_single_server_get_vtable(JDistributionVTable*);
 void j_distribution_weighted_get_vtable(JDistributionVTable*);
+void j_distribution_local_get_vtable(JDistributionVTable*);
+void j_distribution_consistent_get_vtable(JDistributionVTable*);
+void j_distribution_erasure_get_vtable(JDistributionVTable*);
+void j_distribution_replicated_get_vtable(JDistributionVTable*);
 
 #endif
@@ -0,0 +1,322 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <bson.h>
+
+#include <jconfiguration.h>
+#include <jhelper-internal.h>
+#include <jtrace.h>
+
+#include "distribution.h"
+
+/**
+ * \defgroup JDistribution Distribution
+ *
+ * Data structures and functions for managing distributions.
+ *
+ * @{
+ **/
+
+/**
+ * A distribution that stripes data across the servers in the client's locality domain.
+ **/
+struct JDistributionLocal
+{
+	/**
+	 * The server count.
+	 **/
+	guint server_count;
+
+	/**
+	 * The length.
+	 **/
+	guint64 length;
+
+	/**
+	 * The offset.
+	 **/
+	guint64 offset;
+
+	/**
+	 * The block size.
+	 */
+	guint64 block_size;
+
+	/**
+	 * The servers to distribute to.
+	 * Contains guint elements.
+	 **/
+	GArray* servers;
+
+	guint start_index;
+};
+
+typedef struct JDistributionLocal JDistributionLocal;
+
+/**
+ * Distributes data in a round robin fashion across the local servers.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ * \param index        A server index.
+ * \param new_length   A new length.
+ * \param new_offset   A new offset.
+ *
+ * \return TRUE on success, FALSE if the distribution is finished.
+ **/
+static gboolean
+distribution_distribute(gpointer data, guint* index, guint64* new_length, guint64* new_offset, guint64* block_id)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionLocal* distribution = data;
+
+	guint64 block;
+	guint64 displacement;
+	guint64 round;
+
+	if (distribution->length == 0 || distribution->servers->len == 0)
+	{
+		return FALSE;
+	}
+
+	block = distribution->offset / distribution->block_size;
+	round = block / distribution->servers->len;
+	displacement = distribution->offset % distribution->block_size;
+
+	*index = g_array_index(distribution->servers, guint, (distribution->start_index + block) % distribution->servers->len);
+	*new_length = MIN(distribution->length, distribution->block_size - displacement);
+	*new_offset = (round * distribution->block_size) + displacement;
+	*block_id = block;
+
+	distribution->length -= *new_length;
+	distribution->offset += *new_length;
+
+	return TRUE;
+}
+
+static gpointer
+distribution_new(guint server_count, guint64 stripe_size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionLocal* distribution;
+
+	distribution = g_slice_new(JDistributionLocal);
+	distribution->server_count = server_count;
+	distribution->length = 0;
+	distribution->offset = 0;
+	distribution->block_size = stripe_size;
+	distribution->servers = g_array_new(FALSE, FALSE, sizeof(guint));
+	distribution->start_index = 0;
+
+	return distribution;
+}
+
+static void
+distribution_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionLocal* distribution = data;
+
+	g_return_if_fail(distribution != NULL);
+
+	g_array_unref(distribution->servers);
+
+	g_slice_free(JDistributionLocal, distribution);
+}
+
+/**
+ * Sets the block size, adds a server or sets the start index within the servers.
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ * \param key          A key.
+ * \param value        A value.
+ */
+static void
+distribution_set(gpointer data, gchar const* key, guint64 value)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionLocal* distribution = data;
+
+	g_return_if_fail(distribution != NULL);
+
+	if (g_strcmp0(key, "block-size") == 0)
+	{
+		distribution->block_size = value;
+	}
+	else if (g_strcmp0(key, "server") == 0)
+	{
+		guint index = value;
+
+		g_return_if_fail(value < distribution->server_count);
+
+		g_array_append_val(distribution->servers, index);
+	}
+	else if (g_strcmp0(key, "start-index") == 0)
+	{
+		g_return_if_fail(value < distribution->servers->len);
+
+		distribution->start_index = value;
+	}
+}
+
+static gboolean
+distribution_get(gpointer data, gchar const* key, guint64* value)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionLocal* distribution = data;
+
+	g_return_val_if_fail(distribution != NULL, FALSE);
+
+	if (g_strcmp0(key, "block-size") == 0)
+	{
+		*value = distribution->block_size;
+	}
+	else
+	{
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void
+distribution_serialize(gpointer data, bson_t* b)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionLocal* distribution = data;
+
+	bson_t b_array[1];
+	gchar numstr[16];
+
+	g_return_if_fail(distribution != NULL);
+
+	bson_append_int64(b, "block_size", -1, distribution->block_size);
+	bson_append_int32(b, "start_index", -1, distribution->start_index);
+
+	// The servers have to be stored, as other clients might be located elsewhere.
+	bson_append_array_begin(b, "servers", -1, b_array);
+
+	for (guint i = 0; i < distribution->servers->len; i++)
+	{
+		j_helper_get_number_string(numstr, sizeof(numstr), i);
+		bson_append_int32(b_array, numstr, -1, g_array_index(distribution->servers, guint, i));
+	}
+
+	bson_append_array_end(b, b_array);
+}
+
+static void
+distribution_deserialize(gpointer data, bson_t const* b)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionLocal* distribution = data;
+
+	bson_iter_t iterator;
+
+	g_return_if_fail(distribution != NULL);
+	g_return_if_fail(b != NULL);
+
+	bson_iter_init(&iterator, b);
+
+	while (bson_iter_next(&iterator))
+	{
+		gchar const* key;
+
+		key = bson_iter_key(&iterator);
+
+		if (g_strcmp0(key, "block_size") == 0)
+		{
+			distribution->block_size = bson_iter_int64(&iterator);
+		}
+		else if (g_strcmp0(key, "start_index") == 0)
+		{
+			distribution->start_index = bson_iter_int32(&iterator);
+		}
+		else if (g_strcmp0(key, "servers") == 0)
+		{
+			bson_iter_t siterator;
+
+			bson_iter_recurse(&iterator, &siterator);
+
+			g_array_set_size(distribution->servers, 0);
+
+			while (bson_iter_next(&siterator))
+			{
+				guint index = bson_iter_int32(&siterator);
+
+				g_array_append_val(distribution->servers, index);
+			}
+		}
+	}
+}
+
+static void
+distribution_reset(gpointer data, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionLocal* distribution = data;
+
+	g_return_if_fail(distribution != NULL);
+
+	distribution->length = length;
+	distribution->offset = offset;
+}
+
+void
+j_distribution_local_get_vtable(JDistributionVTable* vtable)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	vtable->distribution_new = distribution_new;
+	vtable->distribution_free = distribution_free;
+	vtable->distribution_set = distribution_set;
+	vtable->distribution_set2 = NULL;
+	vtable->distribution_get = distribution_get;
+	vtable->distribution_serialize = distribution_serialize;
+	vtable->distribution_deserialize = distribution_deserialize;
+	vtable->distribution_reset = distribution_reset;
+	vtable->distribution_distribute = distribution_distribute;
+	vtable->distribution_distribute_replica = NULL;
+}
+
+/**
+ * @}
+ **/
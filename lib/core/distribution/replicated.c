@@ -0,0 +1,369 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <bson.h>
+
+#include <jconfiguration.h>
+#include <jtrace.h>
+
+#include "distribution.h"
+
+/**
+ * \defgroup JDistribution Distribution
+ *
+ * Data structures and functions for managing distributions.
+ *
+ * @{
+ **/
+
+/**
+ * The default number of copies of each block.
+ **/
+#define J_DISTRIBUTION_REPLICATED_DEFAULT_REPLICAS 3
+
+/**
+ * A distribution storing each block on several servers.
+ * Block b and its copies are stored on the servers (start_index + b + r) % server_count for r < replica_count.
+ * All copies are stored at the block's logical offset.
+ **/
+struct JDistributionReplicated
+{
+	/**
+	 * The server count.
+	 **/
+	guint server_count;
+
+	/**
+	 * The length.
+	 **/
+	guint64 length;
+
+	/**
+	 * The offset.
+	 **/
+	guint64 offset;
+
+	/**
+	 * The block size.
+	 */
+	guint64 block_size;
+
+	/**
+	 * The number of copies of each block.
+	 **/
+	guint replica_count;
+
+	guint start_index;
+
+	/**
+	 * The block and offset returned by the last call to distribution_distribute().
+	 **/
+	guint64 last_block;
+	guint64 last_offset;
+};
+
+typedef struct JDistributionReplicated JDistributionReplicated;
+
+/**
+ * Distributes data to the first copy of each block.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ * \param index        A server index.
+ * \param new_length   A new length.
+ * \param new_offset   A new offset.
+ *
+ * \return TRUE on success, FALSE if the distribution is finished.
+ **/
+static gboolean
+distribution_distribute(gpointer data, guint* index, guint64* new_length, guint64* new_offset, guint64* block_id)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionReplicated* distribution = data;
+
+	guint64 block;
+	guint64 displacement;
+
+	if (distribution->length == 0)
+	{
+		return FALSE;
+	}
+
+	block = distribution->offset / distribution->block_size;
+	displacement = distribution->offset % distribution->block_size;
+
+	*index = (distribution->start_index + block) % distribution->server_count;
+	*new_length = MIN(distribution->length, distribution->block_size - displacement);
+	*new_offset = distribution->offset;
+	*block_id = block;
+
+	distribution->last_block = block;
+	distribution->last_offset = distribution->offset;
+
+	distribution->length -= *new_length;
+	distribution->offset += *new_length;
+
+	return TRUE;
+}
+
+/**
+ * Returns a copy of the block returned by the last call to distribution_distribute().
+ *
+ * \private
+ *
+ * \param distribution A distribution.
+ * \param replica      A copy, 0 is the one returned by distribution_distribute().
+ * \param index        A server index.
+ * \param new_offset   A new offset.
+ *
+ * \return TRUE on success, FALSE if the copy does not exist.
+ **/
+static gboolean
+distribution_distribute_replica(gpointer data, guint replica, guint* index, guint64* new_offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionReplicated* distribution = data;
+
+	if (replica >= distribution->replica_count)
+	{
+		return FALSE;
+	}
+
+	*index = (distribution->start_index + distribution->last_block + replica) % distribution->server_count;
+	*new_offset = distribution->last_offset;
+
+	return TRUE;
+}
+
+static gpointer
+distribution_new(guint server_count, guint64 stripe_size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionReplicated* distribution;
+
+	distribution = g_slice_new(JDistributionReplicated);
+	distribution->server_count = server_count;
+	distribution->length = 0;
+	distribution->offset = 0;
+	distribution->block_size = stripe_size;
+	distribution->replica_count = MIN(J_DISTRIBUTION_REPLICATED_DEFAULT_REPLICAS, server_count);
+	distribution->last_block = 0;
+	distribution->last_offset = 0;
+
+	distribution->start_index = g_random_int_range(0, distribution->server_count);
+
+	return distribution;
+}
+
+static void
+distribution_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionReplicated* distribution = data;
+
+	g_return_if_fail(distribution != NULL);
+
+	g_slice_free(JDistributionReplicated, distribution);
+}
+
+/**
+ * Sets the block size, the number of copies or the start index.
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ * \param key          A key.
+ * \param value        A value.
+ */
+static void
+distribution_set(gpointer data, gchar const* key, guint64 value)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionReplicated* distribution = data;
+
+	g_return_if_fail(distribution != NULL);
+
+	if (g_strcmp0(key, "block-size") == 0)
+	{
+		distribution->block_size = value;
+	}
+	else if (g_strcmp0(key, "replicas") == 0)
+	{
+		g_return_if_fail(value > 0 && value <= distribution->server_count);
+
+		distribution->replica_count = value;
+	}
+	else if (g_strcmp0(key, "start-index") == 0)
+	{
+		g_return_if_fail(value < distribution->server_count);
+
+		distribution->start_index = value;
+	}
+}
+
+static gboolean
+distribution_get(gpointer data, gchar const* key, guint64* value)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionReplicated* distribution = data;
+
+	g_return_val_if_fail(distribution != NULL, FALSE);
+
+	if (g_strcmp0(key, "block-size") == 0)
+	{
+		*value = distribution->block_size;
+	}
+	else if (g_strcmp0(key, "replicas") == 0)
+	{
+		*value = distribution->replica_count;
+	}
+	else if (g_strcmp0(key, "start-index") == 0)
+	{
+		*value = distribution->start_index;
+	}
+	else
+	{
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Serializes distribution.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ * \param b            A BSON object.
+ **/
+static void
+distribution_serialize(gpointer data, bson_t* b)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionReplicated* distribution = data;
+
+	g_return_if_fail(distribution != NULL);
+
+	bson_append_int64(b, "block_size", -1, distribution->block_size);
+	bson_append_int32(b, "replica_count", -1, distribution->replica_count);
+	bson_append_int32(b, "start_index", -1, distribution->start_index);
+}
+
+/**
+ * Deserializes distribution.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ * \param b            A BSON object.
+ **/
+static void
+distribution_deserialize(gpointer data, bson_t const* b)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionReplicated* distribution = data;
+
+	bson_iter_t iterator;
+
+	g_return_if_fail(distribution != NULL);
+	g_return_if_fail(b != NULL);
+
+	bson_iter_init(&iterator, b);
+
+	while (bson_iter_next(&iterator))
+	{
+		gchar const* key;
+
+		key = bson_iter_key(&iterator);
+
+		if (g_strcmp0(key, "block_size") == 0)
+		{
+			distribution->block_size = bson_iter_int64(&iterator);
+		}
+		else if (g_strcmp0(key, "replica_count") == 0)
+		{
+			distribution->replica_count = CLAMP((guint)bson_iter_int32(&iterator), 1, distribution->server_count);
+		}
+		else if (g_strcmp0(key, "start_index") == 0)
+		{
+			distribution->start_index = bson_iter_int32(&iterator);
+		}
+	}
+}
+
+static void
+distribution_reset(gpointer data, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionReplicated* distribution = data;
+
+	g_return_if_fail(distribution != NULL);
+
+	distribution->length = length;
+	distribution->offset = offset;
+}
+
+void
+j_distribution_replicated_get_vtable(JDistributionVTable* vtable)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	vtable->distribution_new = distribution_new;
+	vtable->distribution_free = distribution_free;
+	vtable->distribution_set = distribution_set;
+	vtable->distribution_set2 = NULL;
+	vtable->distribution_get = distribution_get;
+	vtable->distribution_serialize = distribution_serialize;
+	vtable->distribution_deserialize = distribution_deserialize;
+	vtable->distribution_reset = distribution_reset;
+	vtable->distribution_distribute = distribution_distribute;
+	vtable->distribution_distribute_replica = distribution_distribute_replica;
+}
+
+/**
+ * @}
+ **/
@@ -64,6 +64,11 @@ struct JDistributionRoundRobin
 	 */
 	guint64 block_size;
 
+	/**
+	 * The number of servers the data is striped over.
+	 **/
+	guint stripe_count;
+
 	guint start_index;
 };
 
@@ -101,10 +106,10 @@ distribution_distribute(gpointer data, guint* index, guint64* new_length, guint6
 	}
 
 	block = distribution->offset / distribution->block_size;
-	round = block / distribution->server_count;
+	round = block / distribution->stripe_count;
 	displacement = distribution->offset % distribution->block_size;
 
-	*index = (distribution->start_index + block) % distribution->server_count;
+	*index = (distribution->start_index + (block % distribution->stripe_count)) % distribution->server_count;
 	*new_length = MIN(distribution->length, distribution->block_size - displacement);
 	*new_offset = (round * distribution->block_size) + displacement;
 	*block_id = block;
@@ -127,6 +132,7 @@ distribution_new(guint server_count, guint64 stripe_size)
 	distribution->length = 0;
 	distribution->offset = 0;
 	distribution->block_size = stripe_size;
+	distribution->stripe_count = server_count;
 
 	distribution->start_index = g_random_int_range(0, distribution->server_count);
 
@@ -176,6 +182,12 @@ distribution_set(gpointer data, gchar const* key, guint64 value)
 	{
 		distribution->block_size = value;
 	}
+	else if (g_strcmp0(key, "stripe-count") == 0)
+	{
+		g_return_if_fail(value > 0 && value <= distribution->server_count);
+
+		distribution->stripe_count = value;
+	}
 	else if (g_strcmp0(key, "start-index") == 0)
 	{
 		g_return_if_fail(value < distribution->server_count);
@@ -184,6 +196,27 @@ distribution_set(gpointer data, gchar const* key, guint64 value)
 	}
 }
 
+static gboolean
+distribution_get(gpointer data, gchar const* key, guint64* value)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionRoundRobin* distribution = data;
+
+	g_return_val_if_fail(distribution != NULL, FALSE);
+
+	if (g_strcmp0(key, "block-size") == 0)
+	{
+		*value = distribution->block_size;
+	}
+	else
+	{
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
 /**
  * Serializes distribution.
  *
@@ -206,6 +239,7 @@ distribution_serialize(gpointer data, bson_t* b)
 	g_return_if_fail(distribution != NULL);
 
 	bson_append_int64(b, "block_size", -1, distribution->block_size);
+	bson_append_int32(b, "stripe_count", -1, distribution->stripe_count);
 	bson_append_int32(b, "start_index", -1, distribution->start_index);
 }
 
@@ -244,6 +278,10 @@ distribution_deserialize(gpointer data, bson_t const* b)
 		{
 			distribution->block_size = bson_iter_int64(&iterator);
 		}
+		else if (g_strcmp0(key, "stripe_count") == 0)
+		{
+			distribution->stripe_count = CLAMP((guint)bson_iter_int32(&iterator), 1, distribution->server_count);
+		}
 		else if (g_strcmp0(key, "start_index") == 0)
 		{
 			distribution->start_index = bson_iter_int32(&iterator);
@@ -287,10 +325,12 @@ j_distribution_round_robin_get_vtable(JDistributionVTable* vtable)
 	vtable->distribution_free = distribution_free;
 	vtable->distribution_set = distribution_set;
 	vtable->distribution_set2 = NULL;
+	vtable->distribution_get = distribution_get;
 	vtable->distribution_serialize = distribution_serialize;
 	vtable->distribution_deserialize = distribution_deserialize;
 	vtable->distribution_reset = distribution_reset;
 	vtable->distribution_distribute = distribution_distribute;
+	vtable->distribution_distribute_replica = NULL;
 }
 
 /**
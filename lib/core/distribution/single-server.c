@@ -182,6 +182,27 @@ distribution_set(gpointer data, gchar const* key, guint64 value)
 	}
 }
 
+static gboolean
+distribution_get(gpointer data, gchar const* key, guint64* value)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionSingleServer* distribution = data;
+
+	g_return_val_if_fail(distribution != NULL, FALSE);
+
+	if (g_strcmp0(key, "block-size") == 0)
+	{
+		*value = distribution->block_size;
+	}
+	else
+	{
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
 /**
  * Serializes distribution.
  *
@@ -285,10 +306,12 @@ j_distribution_single_server_get_vtable(JDistributionVTable* vtable)
 	vtable->distribution_free = distribution_free;
 	vtable->distribution_set = distribution_set;
 	vtable->distribution_set2 = NULL;
+	vtable->distribution_get = distribution_get;
 	vtable->distribution_serialize = distribution_serialize;
 	vtable->distribution_deserialize = distribution_deserialize;
 	vtable->distribution_reset = distribution_reset;
 	vtable->distribution_distribute = distribution_distribute;
+	vtable->distribution_distribute_replica = NULL;
 }
 
 /**
@@ -40,6 +40,14 @@
  * @{
  **/
 
+struct JDistributionWeightedSlot
+{
+	guint32 index;
+	guint32 offset;
+};
+
+typedef struct JDistributionWeightedSlot JDistributionWeightedSlot;
+
 /**
  * A distribution.
  **/
@@ -67,10 +75,45 @@ struct JDistributionWeighted
 
 	guint* weights;
 	guint sum;
+
+	/**
+	 * Maps each block of a round to its server and its position within the server's blocks.
+	 * Contains sum entries, NULL if it has to be rebuilt.
+	 */
+	JDistributionWeightedSlot* slots;
 };
 
 typedef struct JDistributionWeighted JDistributionWeighted;
 
+/**
+ * Builds the lookup table used by distribution_distribute().
+ * Placing a block then only requires a single table access instead of walking all weights.
+ *
+ * \private
+ *
+ * \param distribution A distribution.
+ **/
+static void
+distribution_build_slots(JDistributionWeighted* distribution)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint slot = 0;
+
+	g_free(distribution->slots);
+	distribution->slots = g_new(JDistributionWeightedSlot, distribution->sum);
+
+	for (guint i = 0; i < distribution->server_count; i++)
+	{
+		for (guint j = 0; j < distribution->weights[i]; j++)
+		{
+			distribution->slots[slot].index = i;
+			distribution->slots[slot].offset = j;
+			slot++;
+		}
+	}
+}
+
 /**
  * Distributes data to a weighted list of servers.
  *
@@ -93,37 +136,30 @@ distribution_distribute(gpointer data, guint* index, guint64* new_length, guint6
 
 	JDistributionWeighted* distribution = data;
 
+	JDistributionWeightedSlot const* slot;
 	guint64 block;
 	guint64 displacement;
 	guint64 round;
-	guint block_offset;
 
 	if (distribution->length == 0)
 	{
 		return FALSE;
 	}
 
+	if (distribution->slots == NULL)
+	{
+		distribution_build_slots(distribution);
+	}
+
 	block = distribution->offset / distribution->block_size;
 	round = block / distribution->sum;
 	displacement = distribution->offset % distribution->block_size;
 
-	*index = 0;
-
-	block_offset = block % distribution->sum;
-
-	for (guint i = 0; i < distribution->server_count; i++)
-	{
-		if (block_offset < distribution->weights[i])
-		{
-			*index = i;
-			break;
-		}
-
-		block_offset -= distribution->weights[i];
-	}
+	slot = &(distribution->slots[block % distribution->sum]);
+	*index = slot->index;
 
 	*new_length = MIN(distribution->length, distribution->block_size - displacement);
-	*new_offset = (((round * distribution->weights[*index]) + block_offset) * distribution->block_size) + displacement;
+	*new_offset = (((round * distribution->weights[*index]) + slot->offset) * distribution->block_size) + displacement;
 	*block_id = block;
 
 	distribution->length -= *new_length;
@@ -147,6 +183,7 @@ distribution_new(guint server_count, guint64 stripe_size)
 
 	distribution->sum = 0;
 	distribution->weights = g_new(guint, distribution->server_count);
+	distribution->slots = NULL;
 
 	for (guint i = 0; i < distribution->server_count; i++)
 	{
@@ -175,6 +212,7 @@ distribution_free(gpointer data)
 	g_return_if_fail(distribution != NULL);
 
 	g_free(distribution->weights);
+	g_free(distribution->slots);
 
 	g_slice_free(JDistributionWeighted, distribution);
 }
@@ -220,7 +258,31 @@ distribution_set2(gpointer data, gchar const* key, guint64 value1, guint64 value
 
 		distribution->sum += value2 - distribution->weights[value1];
 		distribution->weights[value1] = value2;
+
+		// Rebuilt on first use, so that setting all weights does not rebuild the table for every server
+		g_clear_pointer(&(distribution->slots), g_free);
+	}
+}
+
+static gboolean
+distribution_get(gpointer data, gchar const* key, guint64* value)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionWeighted* distribution = data;
+
+	g_return_val_if_fail(distribution != NULL, FALSE);
+
+	if (g_strcmp0(key, "block-size") == 0)
+	{
+		*value = distribution->block_size;
+	}
+	else
+	{
+		return FALSE;
 	}
+
+	return TRUE;
 }
 
 /**
@@ -308,6 +370,8 @@ distribution_deserialize(gpointer data, bson_t const* b)
 				distribution->weights[i] = bson_iter_int32(&siterator);
 				distribution->sum += distribution->weights[i];
 			}
+
+			g_clear_pointer(&(distribution->slots), g_free);
 		}
 	}
 }
@@ -348,10 +412,12 @@ j_distribution_weighted_get_vtable(JDistributionVTable* vtable)
 	vtable->distribution_free = distribution_free;
 	vtable->distribution_set = distribution_set;
 	vtable->distribution_set2 = distribution_set2;
+	vtable->distribution_get = distribution_get;
 	vtable->distribution_serialize = distribution_serialize;
 	vtable->distribution_deserialize = distribution_deserialize;
 	vtable->distribution_reset = distribution_reset;
 	vtable->distribution_distribute = distribution_distribute;
+	vtable->distribution_distribute_replica = NULL;
 }
 
 /**
@@ -0,0 +1,417 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <math.h>
+
+#include <jbackend-latency.h>
+
+#include <jtrace.h>
+
+/**
+ * \defgroup JBackendLatency Backend Latency
+ *
+ * Latency models for simulating storage devices in the null backends.
+ *
+ * A model is described by colon-separated options, which allows using it as a backend path (`/ignored:read=100:write=~250:bandwidth=2048`):
+ * - `latency=D` sets the latency of all operation types that are not set explicitly.
+ * - `read=D`, `write=D`, `metadata=D` and `sync=D` set the latency of one operation type.
+ * - `bandwidth=B`, `read-bandwidth=B` and `write-bandwidth=B` limit the bandwidth of reads and writes to B MiB/s.
+ *
+ * Latencies are given in microseconds as a fixed value (`100`), a uniformly distributed range (`50-150`) or an exponentially distributed mean (`~100`).
+ * Latencies of concurrent operations overlap, while the bandwidth is shared by all of them like on a real device.
+ *
+ * @{
+ **/
+
+enum JBackendLatencyDistribution
+{
+	J_BACKEND_LATENCY_FIXED,
+	J_BACKEND_LATENCY_UNIFORM,
+	J_BACKEND_LATENCY_EXPONENTIAL
+};
+
+typedef enum JBackendLatencyDistribution JBackendLatencyDistribution;
+
+struct JBackendLatencyModel
+{
+	JBackendLatencyDistribution distribution;
+
+	/**
+	 * The fixed latency, the lower bound or the mean in microseconds.
+	 **/
+	gdouble first;
+
+	/**
+	 * The upper bound in microseconds.
+	 **/
+	gdouble second;
+};
+
+typedef struct JBackendLatencyModel JBackendLatencyModel;
+
+struct JBackendLatency
+{
+	JBackendLatencyModel models[J_BACKEND_LATENCY_OPERATIONS];
+
+	/**
+	 * The bandwidth of reads and writes in bytes per second, 0 means unlimited.
+	 **/
+	guint64 bandwidth[2];
+
+	/**
+	 * Whether any latency or bandwidth has been set.
+	 **/
+	gboolean enabled;
+
+	GMutex mutex[1];
+
+	/**
+	 * The monotonic times at which all previous reads and writes will have been transferred.
+	 **/
+	gint64 busy_until[2];
+};
+
+static GPrivate j_backend_latency_rand = G_PRIVATE_INIT((GDestroyNotify)g_rand_free);
+
+/**
+ * Returns the calling thread's random number generator.
+ * Using one generator per thread avoids serializing concurrent operations.
+ *
+ * \private
+ **/
+static GRand*
+j_backend_latency_get_rand(void)
+{
+	GRand* generator;
+
+	if ((generator = g_private_get(&j_backend_latency_rand)) == NULL)
+	{
+		generator = g_rand_new();
+		g_private_set(&j_backend_latency_rand, generator);
+	}
+
+	return generator;
+}
+
+/**
+ * Parses a latency.
+ *
+ * \private
+ *
+ * \param value A fixed latency (`100`), a range (`50-150`) or a mean (`~100`).
+ * \param model A model.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_backend_latency_parse(gchar const* value, JBackendLatencyModel* model)
+{
+	gchar* end;
+
+	model->distribution = J_BACKEND_LATENCY_FIXED;
+
+	if (value[0] == '~')
+	{
+		model->distribution = J_BACKEND_LATENCY_EXPONENTIAL;
+		value++;
+	}
+
+	model->first = g_ascii_strtod(value, &end);
+	model->second = model->first;
+
+	if (end == value || model->first < 0)
+	{
+		return FALSE;
+	}
+
+	if (model->distribution == J_BACKEND_LATENCY_FIXED && end[0] == '-')
+	{
+		value = end + 1;
+		model->distribution = J_BACKEND_LATENCY_UNIFORM;
+		model->second = g_ascii_strtod(value, &end);
+
+		if (end == value || model->second < model->first)
+		{
+			return FALSE;
+		}
+	}
+
+	return (end[0] == '\0');
+}
+
+/**
+ * Creates a new latency model.
+ *
+ * \code
+ * JBackendLatency* latency;
+ *
+ * latency = j_backend_latency_new("/ignored:latency=10:write=50-150:bandwidth=1024");
+ * \endcode
+ *
+ * \param spec The model's options, the part before the first colon is ignored. May be NULL.
+ *
+ * \return A new latency model that should be freed with j_backend_latency_free(), NULL if spec is invalid.
+ **/
+JBackendLatency*
+j_backend_latency_new(gchar const* spec)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	static gchar const* const operations[J_BACKEND_LATENCY_OPERATIONS] = { "read", "write", "metadata", "sync" };
+
+	JBackendLatency* latency;
+	g_auto(GStrv) split = NULL;
+	JBackendLatencyModel default_model = { J_BACKEND_LATENCY_FIXED, 0, 0 };
+	gboolean is_set[J_BACKEND_LATENCY_OPERATIONS] = { FALSE };
+	gboolean has_default = FALSE;
+
+	latency = g_slice_new0(JBackendLatency);
+	g_mutex_init(latency->mutex);
+
+	if (spec == NULL)
+	{
+		return latency;
+	}
+
+	split = g_strsplit(spec, ":", 0);
+
+	for (guint i = 1; split[0] != NULL && split[i] != NULL; i++)
+	{
+		g_auto(GStrv) option = NULL;
+		gboolean valid = FALSE;
+
+		option = g_strsplit(split[i], "=", 2);
+
+		if (option[0] == NULL || option[1] == NULL)
+		{
+			goto error;
+		}
+
+		if (g_strcmp0(option[0], "latency") == 0)
+		{
+			valid = j_backend_latency_parse(option[1], &default_model);
+			has_default = TRUE;
+		}
+		else if (g_str_has_suffix(option[0], "bandwidth"))
+		{
+			gchar* end;
+			guint64 bandwidth;
+
+			bandwidth = g_ascii_strtoull(option[1], &end, 10) * 1024 * 1024;
+			valid = (end != option[1] && end[0] == '\0');
+
+			if (g_strcmp0(option[0], "bandwidth") == 0)
+			{
+				latency->bandwidth[J_BACKEND_LATENCY_READ] = bandwidth;
+				latency->bandwidth[J_BACKEND_LATENCY_WRITE] = bandwidth;
+			}
+			else if (g_strcmp0(option[0], "read-bandwidth") == 0)
+			{
+				latency->bandwidth[J_BACKEND_LATENCY_READ] = bandwidth;
+			}
+			else if (g_strcmp0(option[0], "write-bandwidth") == 0)
+			{
+				latency->bandwidth[J_BACKEND_LATENCY_WRITE] = bandwidth;
+			}
+			else
+			{
+				valid = FALSE;
+			}
+		}
+		else
+		{
+			for (guint j = 0; j < J_BACKEND_LATENCY_OPERATIONS; j++)
+			{
+				if (g_strcmp0(option[0], operations[j]) == 0)
+				{
+					valid = j_backend_latency_parse(option[1], &(latency->models[j]));
+					is_set[j] = TRUE;
+					break;
+				}
+			}
+		}
+
+		if (!valid)
+		{
+			goto error;
+		}
+	}
+
+	if (has_default)
+	{
+		// Explicit latencies take precedence regardless of their position
+		for (guint i = 0; i < J_BACKEND_LATENCY_OPERATIONS; i++)
+		{
+			if (!is_set[i])
+			{
+				latency->models[i] = default_model;
+			}
+		}
+	}
+
+	for (guint i = 0; i < J_BACKEND_LATENCY_OPERATIONS; i++)
+	{
+		if (latency->models[i].second > 0)
+		{
+			latency->enabled = TRUE;
+		}
+	}
+
+	if (latency->bandwidth[J_BACKEND_LATENCY_READ] > 0 || latency->bandwidth[J_BACKEND_LATENCY_WRITE] > 0)
+	{
+		latency->enabled = TRUE;
+	}
+
+	return latency;
+
+error:
+	j_backend_latency_free(latency);
+
+	return NULL;
+}
+
+/**
+ * Frees the memory allocated by a latency model.
+ *
+ * \param latency A latency model.
+ **/
+void
+j_backend_latency_free(JBackendLatency* latency)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(latency != NULL);
+
+	g_mutex_clear(latency->mutex);
+	g_slice_free(JBackendLatency, latency);
+}
+
+/**
+ * Draws an operation's latency from its distribution.
+ *
+ * \private
+ **/
+static guint64
+j_backend_latency_sample(JBackendLatency* latency, JBackendLatencyOperation operation)
+{
+	JBackendLatencyModel const* model = &(latency->models[operation]);
+
+	switch (model->distribution)
+	{
+		case J_BACKEND_LATENCY_UNIFORM:
+			return g_rand_double_range(j_backend_latency_get_rand(), model->first, model->second);
+		case J_BACKEND_LATENCY_EXPONENTIAL:
+			// 1 - x is in (0, 1], which keeps log from returning infinity
+			return -model->first * log(1.0 - g_rand_double(j_backend_latency_get_rand()));
+		case J_BACKEND_LATENCY_FIXED:
+		default:
+			return model->first;
+	}
+}
+
+/**
+ * Returns the transfer time of a read or write.
+ *
+ * \private
+ **/
+static guint64
+j_backend_latency_transfer(JBackendLatency* latency, JBackendLatencyOperation operation, guint64 bytes)
+{
+	if ((operation != J_BACKEND_LATENCY_READ && operation != J_BACKEND_LATENCY_WRITE) || latency->bandwidth[operation] == 0)
+	{
+		return 0;
+	}
+
+	return (gdouble)bytes * G_USEC_PER_SEC / latency->bandwidth[operation];
+}
+
+/**
+ * Returns the time an operation would take if it did not have to share the bandwidth.
+ *
+ * \param latency   A latency model.
+ * \param operation The operation's type.
+ * \param bytes     The number of bytes read or written.
+ *
+ * \return The time in microseconds.
+ **/
+guint64
+j_backend_latency_get(JBackendLatency* latency, JBackendLatencyOperation operation, guint64 bytes)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(latency != NULL, 0);
+	g_return_val_if_fail(operation < J_BACKEND_LATENCY_OPERATIONS, 0);
+
+	return j_backend_latency_sample(latency, operation) + j_backend_latency_transfer(latency, operation, bytes);
+}
+
+/**
+ * Blocks for the time an operation would take on the modelled device.
+ *
+ * \param latency   A latency model.
+ * \param operation The operation's type.
+ * \param bytes     The number of bytes read or written.
+ **/
+void
+j_backend_latency_inject(JBackendLatency* latency, JBackendLatencyOperation operation, guint64 bytes)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gint64 now;
+	gint64 end;
+	guint64 transfer;
+
+	g_return_if_fail(latency != NULL);
+	g_return_if_fail(operation < J_BACKEND_LATENCY_OPERATIONS);
+
+	if (!latency->enabled)
+	{
+		return;
+	}
+
+	now = g_get_monotonic_time();
+	end = now;
+
+	if ((transfer = j_backend_latency_transfer(latency, operation, bytes)) > 0)
+	{
+		// Transfers are queued behind each other, so concurrent operations share the bandwidth
+		g_mutex_lock(latency->mutex);
+		latency->busy_until[operation] = MAX(latency->busy_until[operation], now) + transfer;
+		end = latency->busy_until[operation];
+		g_mutex_unlock(latency->mutex);
+	}
+
+	end += j_backend_latency_sample(latency, operation);
+
+	if (end > now)
+	{
+		g_usleep(end - now);
+	}
+}
+
+/**
+ * @}
+ **/
@@ -100,6 +100,210 @@ j_backend_operation_unwrap_db_delete(JBackend* backend, gpointer batch, JBackend
 	return j_backend_db_delete(backend, batch, data->in_param[1].ptr, data->in_param[2].ptr, data->out_param[0].ptr);
 }
 
+static guint32
+j_backend_operation_db_rows_width(bson_type_t type)
+{
+	switch (type)
+	{
+		case BSON_TYPE_INT32:
+			return 4;
+		case BSON_TYPE_INT64:
+		case BSON_TYPE_DOUBLE:
+			return 8;
+		case BSON_TYPE_UTF8:
+		case BSON_TYPE_BINARY:
+			// Offset and length within the heap
+			return 8;
+		case BSON_TYPE_NULL:
+			return 0;
+		default:
+			return G_MAXUINT32;
+	}
+}
+
+/**
+ * Packs the rows of a query page into the format described at J_BACKEND_OPERATION_DB_QUERY_PAGE_SIZE.
+ * Columns whose type differs between rows cannot be packed and result in an error.
+ *
+ * \param[out] bson The encoded page
+ * \param[in] rows The rows returned by the backend
+ * \param[in] with_id Whether the rows are entries with IDs
+ * \param[out] error A GError
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+static gboolean
+j_backend_operation_db_rows_encode(bson_t* bson, GPtrArray* rows, gboolean with_id, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GHashTable) column_index = NULL;
+	g_autoptr(GPtrArray) names = NULL;
+	g_autoptr(GArray) types = NULL;
+	g_autoptr(GArray) offsets = NULL;
+	g_autoptr(GByteArray) heap = NULL;
+	guint8* packed = NULL;
+	guint32 bitmap_size;
+	guint32 row_size;
+	char str_buf[16];
+	const char* key;
+	bson_t array[1];
+	bson_iter_t iter;
+	bson_type_t type_null = BSON_TYPE_NULL;
+	gboolean ret = FALSE;
+
+	column_index = g_hash_table_new(g_str_hash, g_str_equal);
+	names = g_ptr_array_new();
+	types = g_array_new(FALSE, FALSE, sizeof(bson_type_t));
+	offsets = g_array_new(FALSE, FALSE, sizeof(guint32));
+	heap = g_byte_array_new();
+
+	// The ID always is the first column, the client relies on it to fetch the following page
+	if (with_id)
+	{
+		g_hash_table_insert(column_index, (gpointer)"_id", GUINT_TO_POINTER(1));
+		g_ptr_array_add(names, (gpointer)"_id");
+		g_array_append_val(types, type_null);
+	}
+
+	// Determine the columns and their types, the keys point into the rows and stay valid until they are freed
+	for (guint i = 0; i < rows->len; i++)
+	{
+		if (!bson_iter_init(&iter, g_ptr_array_index(rows, i)))
+		{
+			g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_INIT, "bson iter init failed");
+			goto _error;
+		}
+
+		while (bson_iter_next(&iter))
+		{
+			gchar const* name = bson_iter_key(&iter);
+			bson_type_t type = bson_iter_type(&iter);
+			guint column;
+
+			if ((column = GPOINTER_TO_UINT(g_hash_table_lookup(column_index, name))) == 0)
+			{
+				g_ptr_array_add(names, (gpointer)name);
+				g_array_append_val(types, type_null);
+				column = names->len;
+				g_hash_table_insert(column_index, (gpointer)name, GUINT_TO_POINTER(column));
+			}
+
+			column--;
+
+			if (type == BSON_TYPE_NULL)
+			{
+				continue;
+			}
+
+			if (j_backend_operation_db_rows_width(type) == G_MAXUINT32
+			    || (g_array_index(types, bson_type_t, column) != BSON_TYPE_NULL && g_array_index(types, bson_type_t, column) != type))
+			{
+				g_set_error(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_DB_TYPE_INVALID, "field %s has an invalid type", name);
+				goto _error;
+			}
+
+			g_array_index(types, bson_type_t, column) = type;
+		}
+	}
+
+	bitmap_size = (names->len + 7) / 8;
+	row_size = bitmap_size;
+
+	for (guint i = 0; i < names->len; i++)
+	{
+		g_array_append_val(offsets, row_size);
+		row_size += j_backend_operation_db_rows_width(g_array_index(types, bson_type_t, i));
+	}
+
+	packed = g_malloc0((gsize)row_size * rows->len + 1);
+
+	for (guint i = 0; i < rows->len; i++)
+	{
+		guint8* row = packed + (gsize)row_size * i;
+
+		bson_iter_init(&iter, g_ptr_array_index(rows, i));
+
+		while (bson_iter_next(&iter))
+		{
+			guint column = GPOINTER_TO_UINT(g_hash_table_lookup(column_index, bson_iter_key(&iter))) - 1;
+			guint8* cell = row + g_array_index(offsets, guint32, column);
+			guint32 ref[2];
+			gint32 val_int32;
+			gint64 val_int64;
+			gdouble val_double;
+			gchar const* val_string;
+			guint8 const* val_binary;
+			guint32 length;
+
+			switch (bson_iter_type(&iter))
+			{
+				case BSON_TYPE_INT32:
+					val_int32 = bson_iter_int32(&iter);
+					memcpy(cell, &val_int32, sizeof(val_int32));
+					break;
+				case BSON_TYPE_INT64:
+					val_int64 = bson_iter_int64(&iter);
+					memcpy(cell, &val_int64, sizeof(val_int64));
+					break;
+				case BSON_TYPE_DOUBLE:
+					val_double = bson_iter_double(&iter);
+					memcpy(cell, &val_double, sizeof(val_double));
+					break;
+				case BSON_TYPE_UTF8:
+					val_string = bson_iter_utf8(&iter, &length);
+					ref[0] = heap->len;
+					ref[1] = length;
+					// Keep the terminator so strings can be returned without copying them
+					g_byte_array_append(heap, (guint8 const*)val_string, length + 1);
+					memcpy(cell, ref, sizeof(ref));
+					break;
+				case BSON_TYPE_BINARY:
+					bson_iter_binary(&iter, NULL, &length, &val_binary);
+					ref[0] = heap->len;
+					ref[1] = length;
+					g_byte_array_append(heap, val_binary, length);
+					memcpy(cell, ref, sizeof(ref));
+					break;
+				case BSON_TYPE_NULL:
+				default:
+					continue;
+			}
+
+			row[column / 8] |= 1 << (column % 8);
+		}
+	}
+
+	bson_append_array_begin(bson, "_names", -1, array);
+
+	for (guint i = 0; i < names->len; i++)
+	{
+		bson_uint32_to_string(i, &key, str_buf, sizeof(str_buf));
+		bson_append_utf8(array, key, -1, g_ptr_array_index(names, i), -1);
+	}
+
+	bson_append_array_end(bson, array);
+	bson_append_array_begin(bson, "_types", -1, array);
+
+	for (guint i = 0; i < types->len; i++)
+	{
+		bson_uint32_to_string(i, &key, str_buf, sizeof(str_buf));
+		bson_append_int32(array, key, -1, g_array_index(types, bson_type_t, i));
+	}
+
+	bson_append_array_end(bson, array);
+	bson_append_int32(bson, "_count", -1, rows->len);
+	bson_append_binary(bson, "_rows", -1, BSON_SUBTYPE_BINARY, packed, row_size * rows->len);
+	bson_append_binary(bson, "_heap", -1, BSON_SUBTYPE_BINARY, heap->data, heap->len);
+
+	ret = TRUE;
+
+_error:
+	g_free(packed);
+
+	return ret;
+}
+
 // FIXME clean up
 gboolean
 j_backend_operation_unwrap_db_query(JBackend* backend, gpointer batch, JBackendOperation* data)
@@ -110,41 +314,114 @@ j_backend_operation_unwrap_db_query(JBackend* backend, gpointer batch, JBackendO
 	gboolean ret;
 	gpointer iter;
 	guint i;
-	char str_buf[16];
-	const char* key;
 	bson_t* bson = data->out_param[0].ptr;
-	bson_t tmp[1];
+	bson_t* tmp;
+	g_autoptr(GPtrArray) rows = NULL;
 
 	bson_init(bson);
-	ret = j_backend_db_query(backend, batch, data->in_param[1].ptr, data->in_param[2].ptr, &iter, data->out_param[1].ptr);
+	ret = j_backend_db_query_fields(backend, batch, data->in_param[1].ptr, data->in_param[2].ptr, data->in_param[3].ptr, &iter, data->out_param[1].ptr);
 	if (!ret)
 	{
 		goto _error;
 	}
+	rows = g_ptr_array_new_with_free_func((GDestroyNotify)bson_destroy);
 	i = 0;
 	do
 	{
-		bson_uint32_to_string(i, &key, str_buf, sizeof(str_buf));
-		bson_init(tmp);
+		if (i == J_BACKEND_OPERATION_DB_QUERY_PAGE_SIZE)
+		{
+			// The page is full, the client will ask for the remaining entries
+			j_backend_db_iterator_free(backend, iter);
+			break;
+		}
+
+		tmp = bson_new();
 		ret = j_backend_db_iterate(backend, iter, tmp, data->out_param[1].ptr);
 		i++;
 		if (ret)
 		{
-			bson_append_document(bson, key, -1, tmp);
+			g_ptr_array_add(rows, tmp);
+		}
+		else
+		{
+			bson_destroy(tmp);
 		}
-		bson_destroy(tmp);
 	} while (ret); //TODO handle the no more elements error here
 	error = data->out_param[1].ptr;
-	if (error && (*error)->code == J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS)
+	if (error && *error && (*error)->code == J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS)
 	{
 		g_error_free(*error);
 		*error = NULL;
 	}
+	if (!j_backend_operation_db_rows_encode(bson, rows, TRUE, error))
+	{
+		goto _error;
+	}
 	return TRUE;
 _error:
 	return FALSE;
 }
 
+gboolean
+j_backend_operation_unwrap_db_aggregate(JBackend* backend, gpointer batch, JBackendOperation* data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GError** error = data->out_param[1].ptr;
+	gboolean ret;
+	gpointer iter;
+	bson_t* bson = data->out_param[0].ptr;
+	bson_t* tmp;
+	g_autoptr(GPtrArray) rows = NULL;
+
+	bson_init(bson);
+
+	if (!j_backend_db_aggregate(backend, batch, data->in_param[1].ptr, data->in_param[2].ptr, data->in_param[3].ptr, &iter, error))
+	{
+		return FALSE;
+	}
+
+	rows = g_ptr_array_new_with_free_func((GDestroyNotify)bson_destroy);
+
+	// Aggregations return one row per group, which are not paged
+	do
+	{
+		tmp = bson_new();
+		ret = j_backend_db_iterate(backend, iter, tmp, error);
+
+		if (ret)
+		{
+			g_ptr_array_add(rows, tmp);
+		}
+		else
+		{
+			bson_destroy(tmp);
+		}
+	} while (ret);
+
+	if (error && *error && (*error)->code == J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS)
+	{
+		g_error_free(*error);
+		*error = NULL;
+	}
+	else if (error && *error)
+	{
+		return FALSE;
+	}
+
+	return j_backend_operation_db_rows_encode(bson, rows, FALSE, error);
+}
+
+gboolean
+j_backend_operation_unwrap_db_advise_indexes(JBackend* backend, gpointer batch, JBackendOperation* data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_init(data->out_param[0].ptr);
+
+	return j_backend_db_advise_indexes(backend, batch, data->in_param[1].ptr, data->in_param[2].ptr, data->out_param[0].ptr, data->out_param[1].ptr);
+}
+
 gboolean
 j_backend_operation_to_message(JMessage* message, JBackendOperationParam* data, guint arrlen)
 {
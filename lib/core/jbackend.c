@@ -25,8 +25,12 @@
 #include <glib.h>
 #include <gmodule.h>
 
+#include <string.h>
+
 #include <jbackend.h>
 
+#include <jhelper.h>
+#include <jstatistics.h>
 #include <jtrace.h>
 
 /**
@@ -61,6 +65,148 @@ j_backend_sql_error_quark(void)
 	return g_quark_from_static_string("j-backend-sql-error-quark");
 }
 
+/**
+ * Statistics of a single backend call.
+ **/
+struct JBackendCallStatistics
+{
+	guint64 calls;
+	guint64 bytes;
+	guint64 time;
+
+	/**
+	 * The latency histogram, see #J_STATISTICS_LATENCY_BUCKETS.
+	 **/
+	guint64 latency[J_STATISTICS_LATENCY_BUCKETS];
+};
+
+typedef struct JBackendCallStatistics JBackendCallStatistics;
+
+struct JBackendStatistics
+{
+	/**
+	 * The backend's name, for example, "posix".
+	 **/
+	gchar* name;
+
+	JBackendCallStatistics calls[J_BACKEND_CALLS];
+};
+
+/**
+ * Measures a backend call and accounts it when going out of scope.
+ **/
+struct JBackendTimer
+{
+	JBackendStatistics* statistics;
+	JBackendCall call;
+	gint64 start_time;
+	guint64 bytes;
+};
+
+typedef struct JBackendTimer JBackendTimer;
+
+static void
+j_backend_timer_stop(JBackendTimer* timer)
+{
+	JBackendCallStatistics* call_statistics;
+	guint64 duration;
+
+	if (G_LIKELY(timer->statistics == NULL))
+	{
+		return;
+	}
+
+	call_statistics = &(timer->statistics->calls[timer->call]);
+	duration = MAX(g_get_monotonic_time() - timer->start_time, 0);
+
+	j_helper_atomic_add(&(call_statistics->calls), 1);
+	j_helper_atomic_add(&(call_statistics->bytes), timer->bytes);
+	j_helper_atomic_add(&(call_statistics->time), duration);
+	j_helper_atomic_add(&(call_statistics->latency[(duration == 0) ? 0 : MIN(g_bit_storage(duration), J_STATISTICS_LATENCY_BUCKETS - 1)]), 1);
+}
+
+G_DEFINE_AUTO_CLEANUP_CLEAR_FUNC(JBackendTimer, j_backend_timer_stop)
+
+/**
+ * Measures the backend call in the current scope.
+ * If statistics are disabled, this only costs checking the backend's statistics pointer.
+ * The number of bytes can be set via backend_timer.bytes.
+ **/
+#define J_BACKEND_STATISTICS(call) g_auto(JBackendTimer) backend_timer G_GNUC_UNUSED = { backend->statistics, call, (backend->statistics != NULL) ? g_get_monotonic_time() : 0, 0 }
+
+static gchar const* const j_backend_call_names[] = {
+	"create",
+	"open",
+	"delete",
+	"close",
+	"status",
+	"sync",
+	"syncv",
+	"read",
+	"write",
+	"readv",
+	"writev",
+	"discard",
+	"preallocate",
+	"clone",
+	"copy_range",
+	"advise",
+	"get_all",
+	"get_by_prefix",
+	"get_range",
+	"iterate",
+	"seek",
+	"iterator_free",
+	"batch_start",
+	"batch_execute",
+	"batch_abort",
+	"put",
+	"get",
+	"get_multi",
+	"compare_and_swap",
+	"add",
+	"schema_create",
+	"schema_get",
+	"schema_delete",
+	"insert",
+	"insert_multi",
+	"update",
+	"query",
+	"query_fields",
+	"aggregate",
+	"advise_indexes"
+};
+
+G_STATIC_ASSERT(G_N_ELEMENTS(j_backend_call_names) == J_BACKEND_CALLS);
+
+static gboolean j_backend_statistics_enabled = FALSE;
+
+static JBackendStatistics*
+j_backend_statistics_new(gchar const* name)
+{
+	JBackendStatistics* statistics;
+
+	statistics = g_new0(JBackendStatistics, 1);
+	statistics->name = g_strdup(name);
+
+	return statistics;
+}
+
+static void
+j_backend_statistics_free(JBackend* backend)
+{
+	JBackendStatistics* statistics;
+
+	statistics = backend->statistics;
+	backend->statistics = NULL;
+
+	if (statistics != NULL)
+	{
+		g_free(statistics->name);
+		g_free(statistics);
+	}
+}
+
 static GModule*
 j_backend_load(gchar const* name, JBackendComponent component, JBackendType type, JBackend** backend)
 {
@@ -206,6 +352,11 @@ j_backend_load(gchar const* name, JBackendComponent component, JBackendType type
 		}
 	}
 
+	if ((j_backend_statistics_enabled || g_getenv("JULEA_BACKEND_STATISTICS") != NULL) && tmp_backend->statistics == NULL)
+	{
+		tmp_backend->statistics = j_backend_statistics_new(name);
+	}
+
 	*backend = tmp_backend;
 
 	return module;
@@ -269,258 +420,2322 @@ j_backend_load_server(gchar const* name, gchar const* component, JBackendType ty
 	return FALSE;
 }
 
+/**
+ * Loads a backend into the client library for node-local namespaces.
+ * In contrast to j_backend_load_client(), server backends are accepted, too, since the data never leaves the node.
+ *
+ * \param name    The backend's name.
+ * \param type    The backend type.
+ * \param module  Returns the backend's module.
+ * \param backend Returns the backend.
+ *
+ * \return TRUE if the backend has been loaded, FALSE otherwise.
+ **/
 gboolean
-j_backend_object_init(JBackend* backend, gchar const* path)
+j_backend_load_local(gchar const* name, JBackendType type, GModule** module, JBackend** backend)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gboolean ret;
-
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(type == J_BACKEND_TYPE_OBJECT || type == J_BACKEND_TYPE_KV || type == J_BACKEND_TYPE_DB, FALSE);
+	g_return_val_if_fail(module != NULL, FALSE);
 	g_return_val_if_fail(backend != NULL, FALSE);
-	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
-	g_return_val_if_fail(path != NULL, FALSE);
 
-	{
-		J_TRACE("backend_init", "%s", path);
-		ret = backend->object.backend_init(path, &(backend->data));
-	}
+	*module = j_backend_load(name, J_BACKEND_COMPONENT_CLIENT | J_BACKEND_COMPONENT_SERVER, type, backend);
 
-	return ret;
+	return (*backend != NULL);
 }
 
+/**
+ * Enables or disables statistics for backends loaded afterwards.
+ * Statistics can also be enabled by setting the \c JULEA_BACKEND_STATISTICS environment variable.
+ *
+ * \param enabled Whether statistics should be kept.
+ **/
 void
-j_backend_object_fini(JBackend* backend)
+j_backend_statistics_enable(gboolean enabled)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	g_return_if_fail(backend != NULL);
-	g_return_if_fail(backend->type == J_BACKEND_TYPE_OBJECT);
-
-	{
-		J_TRACE("backend_fini", NULL);
-		backend->object.backend_fini(backend->data);
-	}
+	j_backend_statistics_enabled = enabled;
 }
 
-gboolean
-j_backend_object_create(JBackend* backend, gchar const* namespace, gchar const* path, gpointer* data)
+/**
+ * Returns the name of a backend call.
+ *
+ * \param call A backend call.
+ *
+ * \return The call's name, for example, "read".
+ **/
+gchar const*
+j_backend_call_get_name(JBackendCall call)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gboolean ret;
-
-	g_return_val_if_fail(backend != NULL, FALSE);
-	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
-	g_return_val_if_fail(namespace != NULL, FALSE);
-	g_return_val_if_fail(path != NULL, FALSE);
-	g_return_val_if_fail(data != NULL, FALSE);
-
-	{
-		J_TRACE("backend_create", "%s, %s, %p", namespace, path, (gpointer)data);
-		ret = backend->object.backend_create(backend->data, namespace, path, data);
-	}
+	g_return_val_if_fail((guint)call < J_BACKEND_CALLS, NULL);
 
-	return ret;
+	return j_backend_call_names[call];
 }
 
-gboolean
-j_backend_object_open(JBackend* backend, gchar const* namespace, gchar const* path, gpointer* data)
+/**
+ * Returns a backend's statistics.
+ *
+ * \param backend A backend.
+ *
+ * \return The statistics, NULL if statistics were not enabled when the backend was loaded.
+ **/
+JBackendStatistics*
+j_backend_get_statistics(JBackend* backend)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gboolean ret;
+	g_return_val_if_fail(backend != NULL, NULL);
 
-	g_return_val_if_fail(backend != NULL, FALSE);
-	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
-	g_return_val_if_fail(namespace != NULL, FALSE);
-	g_return_val_if_fail(path != NULL, FALSE);
-	g_return_val_if_fail(data != NULL, FALSE);
+	return backend->statistics;
+}
 
-	{
-		J_TRACE("backend_open", "%s, %s, %p", namespace, path, (gpointer)data);
-		ret = backend->object.backend_open(backend->data, namespace, path, data);
-	}
+/**
+ * Returns the name of the backend statistics belong to.
+ *
+ * \param statistics Backend statistics.
+ *
+ * \return The backend's name.
+ **/
+gchar const*
+j_backend_statistics_get_name(JBackendStatistics* statistics)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	return ret;
+	g_return_val_if_fail(statistics != NULL, NULL);
+
+	return statistics->name;
 }
 
-gboolean
-j_backend_object_delete(JBackend* backend, gpointer data)
+/**
+ * Returns a value of a backend call's statistics.
+ *
+ * \param statistics Backend statistics.
+ * \param call       A backend call.
+ * \param type       A statistics type.
+ *
+ * \return The value.
+ **/
+guint64
+j_backend_statistics_get(JBackendStatistics* statistics, JBackendCall call, JBackendStatisticsType type)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gboolean ret;
+	JBackendCallStatistics* call_statistics;
 
-	g_return_val_if_fail(backend != NULL, FALSE);
-	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
-	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(statistics != NULL, 0);
+	g_return_val_if_fail((guint)call < J_BACKEND_CALLS, 0);
 
+	call_statistics = &(statistics->calls[call]);
+
+	switch (type)
 	{
-		J_TRACE("backend_delete", "%p", data);
-		ret = backend->object.backend_delete(backend->data, data);
+		case J_BACKEND_STATISTICS_CALLS:
+			return call_statistics->calls;
+		case J_BACKEND_STATISTICS_BYTES:
+			return call_statistics->bytes;
+		case J_BACKEND_STATISTICS_TIME:
+			return call_statistics->time;
+		default:
+			g_warn_if_reached();
 	}
 
-	return ret;
+	return 0;
 }
 
-gboolean
-j_backend_object_get_all(JBackend* backend, gchar const* namespace, gpointer* iterator)
+/**
+ * Returns a bucket of a backend call's latency histogram.
+ *
+ * \param statistics Backend statistics.
+ * \param call       A backend call.
+ * \param bucket     A bucket, see #J_STATISTICS_LATENCY_BUCKETS.
+ *
+ * \return The number of calls accounted in the bucket.
+ **/
+guint64
+j_backend_statistics_get_latency(JBackendStatistics* statistics, JBackendCall call, guint bucket)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gboolean ret;
-
-	g_return_val_if_fail(backend != NULL, FALSE);
-	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
-	g_return_val_if_fail(namespace != NULL, FALSE);
-	g_return_val_if_fail(iterator != NULL, FALSE);
-
-	{
-		J_TRACE("backend_get_all", "%s, %p", namespace, (gpointer)iterator);
-		ret = backend->object.backend_get_all(backend->data, namespace, iterator);
-	}
+	g_return_val_if_fail(statistics != NULL, 0);
+	g_return_val_if_fail((guint)call < J_BACKEND_CALLS, 0);
+	g_return_val_if_fail(bucket < J_STATISTICS_LATENCY_BUCKETS, 0);
 
-	return ret;
+	return statistics->calls[call].latency[bucket];
 }
 
-gboolean
-j_backend_object_get_by_prefix(JBackend* backend, gchar const* namespace, gchar const* prefix, gpointer* iterator)
+/**
+ * Spreads objects over multiple instances of an object backend.
+ * Used if an object backend's path contains several paths separated by semicolons,
+ * for example, to make use of multiple local devices with a single server.
+ * The backend's functions are replaced by the ones below, which forward to the instance an object belongs to.
+ **/
+struct JBackendStripe
 {
-	J_TRACE_FUNCTION(NULL);
+	/**
+	 * The backend whose functions have been replaced.
+	 **/
+	JBackend* backend;
 
-	gboolean ret;
+	/**
+	 * The backend's original functions.
+	 **/
+	JBackend original;
 
-	g_return_val_if_fail(backend != NULL, FALSE);
-	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
-	g_return_val_if_fail(namespace != NULL, FALSE);
-	g_return_val_if_fail(prefix != NULL, FALSE);
-	g_return_val_if_fail(iterator != NULL, FALSE);
+	/**
+	 * The instances' data.
+	 **/
+	gpointer* instances;
 
-	{
-		J_TRACE("backend_get_by_prefix", "%s, %s, %p", namespace, prefix, (gpointer)iterator);
-		ret = backend->object.backend_get_by_prefix(backend->data, namespace, prefix, iterator);
-	}
+	guint count;
+};
 
-	return ret;
-}
-gboolean
-j_backend_object_iterate(JBackend* backend, gpointer iterator, gchar const** name)
+typedef struct JBackendStripe JBackendStripe;
+
+/**
+ * An object of a striped backend.
+ **/
+struct JBackendStripeObject
 {
-	J_TRACE_FUNCTION(NULL);
+	guint instance;
+	gpointer data;
+};
 
-	gboolean ret;
+typedef struct JBackendStripeObject JBackendStripeObject;
 
-	g_return_val_if_fail(backend != NULL, FALSE);
-	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
-	g_return_val_if_fail(iterator != NULL, FALSE);
-	g_return_val_if_fail(name != NULL, FALSE);
+/**
+ * An iterator over all instances of a striped backend.
+ **/
+struct JBackendStripeIterator
+{
+	gchar* namespace;
 
-	{
-		J_TRACE("backend_iterate", "%p, %p", iterator, (gpointer)name);
-		ret = backend->object.backend_iterate(backend->data, iterator, name);
-	}
+	/**
+	 * The prefix, NULL to iterate over all objects.
+	 **/
+	gchar* prefix;
 
-	return ret;
-}
+	/**
+	 * The next instance to iterate over.
+	 **/
+	guint instance;
 
-gboolean
-j_backend_object_close(JBackend* backend, gpointer data)
+	/**
+	 * The current instance's iterator, NULL if it has been exhausted.
+	 **/
+	gpointer iterator;
+};
+
+typedef struct JBackendStripeIterator JBackendStripeIterator;
+
+/**
+ * Returns the instance an object belongs to.
+ * Uses FNV-1a, since the placement has to stay the same across restarts.
+ **/
+static guint
+j_backend_stripe_instance(JBackendStripe* stripe, gchar const* namespace, gchar const* path)
 {
-	J_TRACE_FUNCTION(NULL);
+	guint32 hash = 2166136261U;
 
-	gboolean ret;
+	for (gchar const* c = namespace; *c != '\0'; c++)
+	{
+		hash = (hash ^ (guchar)*c) * 16777619U;
+	}
 
-	g_return_val_if_fail(backend != NULL, FALSE);
-	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
-	g_return_val_if_fail(data != NULL, FALSE);
+	hash = (hash ^ '/') * 16777619U;
 
+	for (gchar const* c = path; *c != '\0'; c++)
 	{
-		J_TRACE("backend_close", "%p", data);
-		ret = backend->object.backend_close(backend->data, data);
+		hash = (hash ^ (guchar)*c) * 16777619U;
 	}
 
-	return ret;
+	return hash % stripe->count;
 }
 
-gboolean
-j_backend_object_status(JBackend* backend, gpointer data, gint64* modification_time, guint64* size)
+static gboolean
+j_backend_stripe_open_or_create(JBackendStripe* stripe, gchar const* namespace, gchar const* path, gpointer* data, gboolean create)
 {
-	J_TRACE_FUNCTION(NULL);
-
+	JBackendStripeObject* object;
+	gpointer instance_data;
+	guint instance;
 	gboolean ret;
 
-	g_return_val_if_fail(backend != NULL, FALSE);
-	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
-	g_return_val_if_fail(data != NULL, FALSE);
-	g_return_val_if_fail(modification_time != NULL, FALSE);
-	g_return_val_if_fail(size != NULL, FALSE);
+	instance = j_backend_stripe_instance(stripe, namespace, path);
 
+	if (create)
 	{
-		J_TRACE("backend_status", "%p, %p, %p", data, (gpointer)modification_time, (gpointer)size);
-		ret = backend->object.backend_status(backend->data, data, modification_time, size);
+		ret = stripe->original.object.backend_create(stripe->instances[instance], namespace, path, &instance_data);
+	}
+	else
+	{
+		ret = stripe->original.object.backend_open(stripe->instances[instance], namespace, path, &instance_data);
+	}
+
+	if (ret)
+	{
+		object = g_slice_new(JBackendStripeObject);
+		object->instance = instance;
+		object->data = instance_data;
+
+		*data = object;
 	}
 
 	return ret;
 }
 
-gboolean
-j_backend_object_sync(JBackend* backend, gpointer data)
+static gboolean
+j_backend_stripe_create(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* data)
 {
-	J_TRACE_FUNCTION(NULL);
+	return j_backend_stripe_open_or_create(backend_data, namespace, path, data, TRUE);
+}
 
-	gboolean ret;
+static gboolean
+j_backend_stripe_open(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* data)
+{
+	return j_backend_stripe_open_or_create(backend_data, namespace, path, data, FALSE);
+}
 
-	g_return_val_if_fail(backend != NULL, FALSE);
-	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
-	g_return_val_if_fail(data != NULL, FALSE);
+static gboolean
+j_backend_stripe_delete(gpointer backend_data, gpointer data)
+{
+	JBackendStripe* stripe = backend_data;
+	JBackendStripeObject* object = data;
+	gboolean ret;
 
-	{
-		J_TRACE("backend_sync", "%p", data);
-		ret = backend->object.backend_sync(backend->data, data);
-	}
+	ret = stripe->original.object.backend_delete(stripe->instances[object->instance], object->data);
+	g_slice_free(JBackendStripeObject, object);
 
 	return ret;
 }
 
-gboolean
-j_backend_object_read(JBackend* backend, gpointer data, gpointer buffer, guint64 length, guint64 offset, guint64* bytes_read)
+static gboolean
+j_backend_stripe_close(gpointer backend_data, gpointer data)
 {
-	J_TRACE_FUNCTION(NULL);
-
+	JBackendStripe* stripe = backend_data;
+	JBackendStripeObject* object = data;
 	gboolean ret;
 
-	g_return_val_if_fail(backend != NULL, FALSE);
-	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
-	g_return_val_if_fail(data != NULL, FALSE);
-	g_return_val_if_fail(buffer != NULL, FALSE);
-	g_return_val_if_fail(bytes_read != NULL, FALSE);
-
-	{
-		J_TRACE("backend_read", "%p, %p, %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT ", %p", data, buffer, length, offset, (gpointer)bytes_read);
-		ret = backend->object.backend_read(backend->data, data, buffer, length, offset, bytes_read);
-	}
+	ret = stripe->original.object.backend_close(stripe->instances[object->instance], object->data);
+	g_slice_free(JBackendStripeObject, object);
 
 	return ret;
 }
 
-gboolean
-j_backend_object_write(JBackend* backend, gpointer data, gconstpointer buffer, guint64 length, guint64 offset, guint64* bytes_written)
+static gboolean
+j_backend_stripe_status(gpointer backend_data, gpointer data, gint64* modification_time, guint64* size)
 {
-	J_TRACE_FUNCTION(NULL);
+	JBackendStripe* stripe = backend_data;
+	JBackendStripeObject* object = data;
 
-	gboolean ret;
+	return stripe->original.object.backend_status(stripe->instances[object->instance], object->data, modification_time, size);
+}
 
-	g_return_val_if_fail(backend != NULL, FALSE);
-	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
-	g_return_val_if_fail(data != NULL, FALSE);
-	g_return_val_if_fail(buffer != NULL, FALSE);
+static gboolean
+j_backend_stripe_sync(gpointer backend_data, gpointer data)
+{
+	JBackendStripe* stripe = backend_data;
+	JBackendStripeObject* object = data;
+
+	return stripe->original.object.backend_sync(stripe->instances[object->instance], object->data);
+}
+
+static gboolean
+j_backend_stripe_syncv(gpointer backend_data, gpointer* data, guint32 count)
+{
+	JBackendStripe* stripe = backend_data;
+	g_autofree gpointer* objects = NULL;
+	gboolean ret = TRUE;
+
+	objects = g_new(gpointer, count);
+
+	// Each instance syncs its own objects, so devices are synced independently.
+	for (guint i = 0; i < stripe->count; i++)
+	{
+		guint32 n = 0;
+
+		for (guint32 j = 0; j < count; j++)
+		{
+			JBackendStripeObject* object = data[j];
+
+			if (object->instance == i)
+			{
+				objects[n] = object->data;
+				n++;
+			}
+		}
+
+		if (n > 0)
+		{
+			ret = stripe->original.object.backend_syncv(stripe->instances[i], objects, n) && ret;
+		}
+	}
+
+	return ret;
+}
+
+static gboolean
+j_backend_stripe_read(gpointer backend_data, gpointer data, gpointer buffer, guint64 length, guint64 offset, guint64* bytes_read)
+{
+	JBackendStripe* stripe = backend_data;
+	JBackendStripeObject* object = data;
+
+	return stripe->original.object.backend_read(stripe->instances[object->instance], object->data, buffer, length, offset, bytes_read);
+}
+
+static gboolean
+j_backend_stripe_write(gpointer backend_data, gpointer data, gconstpointer buffer, guint64 length, guint64 offset, guint64* bytes_written)
+{
+	JBackendStripe* stripe = backend_data;
+	JBackendStripeObject* object = data;
+
+	return stripe->original.object.backend_write(stripe->instances[object->instance], object->data, buffer, length, offset, bytes_written);
+}
+
+static gboolean
+j_backend_stripe_readv(gpointer backend_data, gpointer data, JBackendObjectExtent* extents, guint32 count)
+{
+	JBackendStripe* stripe = backend_data;
+	JBackendStripeObject* object = data;
+
+	return stripe->original.object.backend_readv(stripe->instances[object->instance], object->data, extents, count);
+}
+
+static gboolean
+j_backend_stripe_writev(gpointer backend_data, gpointer data, JBackendObjectExtent* extents, guint32 count)
+{
+	JBackendStripe* stripe = backend_data;
+	JBackendStripeObject* object = data;
+
+	return stripe->original.object.backend_writev(stripe->instances[object->instance], object->data, extents, count);
+}
+
+static gboolean
+j_backend_stripe_discard(gpointer backend_data, gpointer data, guint64 length, guint64 offset)
+{
+	JBackendStripe* stripe = backend_data;
+	JBackendStripeObject* object = data;
+
+	return stripe->original.object.backend_discard(stripe->instances[object->instance], object->data, length, offset);
+}
+
+static gboolean
+j_backend_stripe_preallocate(gpointer backend_data, gpointer data, guint64 size)
+{
+	JBackendStripe* stripe = backend_data;
+	JBackendStripeObject* object = data;
+
+	return stripe->original.object.backend_preallocate(stripe->instances[object->instance], object->data, size);
+}
+
+static gboolean
+j_backend_stripe_get_fd(gpointer backend_data, gpointer data, gint* fd)
+{
+	JBackendStripe* stripe = backend_data;
+	JBackendStripeObject* object = data;
+
+	return stripe->original.object.backend_get_fd(stripe->instances[object->instance], object->data, fd);
+}
+
+static gboolean
+j_backend_stripe_written(gpointer backend_data, gpointer data, guint64 length, guint64 offset)
+{
+	JBackendStripe* stripe = backend_data;
+	JBackendStripeObject* object = data;
+
+	return stripe->original.object.backend_written(stripe->instances[object->instance], object->data, length, offset);
+}
+
+static gboolean
+j_backend_stripe_clone(gpointer backend_data, gpointer data, gpointer clone_data)
+{
+	JBackendStripe* stripe = backend_data;
+	JBackendStripeObject* object = data;
+	JBackendStripeObject* clone = clone_data;
+
+	// Data can only be shared within an instance, the caller falls back to copying
+	if (object->instance != clone->instance)
+	{
+		return FALSE;
+	}
+
+	return stripe->original.object.backend_clone(stripe->instances[object->instance], object->data, clone->data);
+}
+
+static gboolean
+j_backend_stripe_copy_range(gpointer backend_data, gpointer data, gpointer target_data, guint64 length, guint64 offset, guint64 target_offset)
+{
+	JBackendStripe* stripe = backend_data;
+	JBackendStripeObject* object = data;
+	JBackendStripeObject* target = target_data;
+
+	// Data can only be shared within an instance, the caller falls back to copying
+	if (object->instance != target->instance)
+	{
+		return FALSE;
+	}
+
+	return stripe->original.object.backend_copy_range(stripe->instances[object->instance], object->data, target->data, length, offset, target_offset);
+}
+
+static gboolean
+j_backend_stripe_advise(gpointer backend_data, gpointer data, JAdvice advice, guint64 length, guint64 offset)
+{
+	JBackendStripe* stripe = backend_data;
+	JBackendStripeObject* object = data;
+
+	return stripe->original.object.backend_advise(stripe->instances[object->instance], object->data, advice, length, offset);
+}
+
+static gpointer
+j_backend_stripe_iterator_new(gchar const* namespace, gchar const* prefix)
+{
+	JBackendStripeIterator* iterator;
+
+	iterator = g_slice_new(JBackendStripeIterator);
+	iterator->namespace = g_strdup(namespace);
+	iterator->prefix = g_strdup(prefix);
+	iterator->instance = 0;
+	iterator->iterator = NULL;
+
+	return iterator;
+}
+
+static gboolean
+j_backend_stripe_get_all(gpointer backend_data, gchar const* namespace, gpointer* iterator)
+{
+	(void)backend_data;
+
+	*iterator = j_backend_stripe_iterator_new(namespace, NULL);
+
+	return TRUE;
+}
+
+static gboolean
+j_backend_stripe_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const* prefix, gpointer* iterator)
+{
+	(void)backend_data;
+
+	*iterator = j_backend_stripe_iterator_new(namespace, prefix);
+
+	return TRUE;
+}
+
+/**
+ * Returns the next name of a striped iterator.
+ *
+ * \private
+ *
+ * \param stripe            A striped backend.
+ * \param iterator          An iterator.
+ * \param name              Returns the name.
+ * \param status            Whether to return the modification time and size, too.
+ * \param modification_time Returns the modification time if status is TRUE.
+ * \param size              Returns the size if status is TRUE.
+ *
+ * \return TRUE if another name is available, FALSE otherwise.
+ **/
+static gboolean
+j_backend_stripe_next(JBackendStripe* stripe, JBackendStripeIterator* iterator, gchar const** name, gboolean status, gint64* modification_time, guint64* size)
+{
+	while (TRUE)
+	{
+		if (iterator->iterator == NULL)
+		{
+			gpointer instance_data;
+			gboolean ret;
+
+			if (iterator->instance >= stripe->count)
+			{
+				break;
+			}
+
+			instance_data = stripe->instances[iterator->instance];
+			iterator->instance++;
+
+			if (iterator->prefix == NULL)
+			{
+				ret = stripe->original.object.backend_get_all(instance_data, iterator->namespace, &(iterator->iterator));
+			}
+			else
+			{
+				ret = stripe->original.object.backend_get_by_prefix(instance_data, iterator->namespace, iterator->prefix, &(iterator->iterator));
+			}
+
+			// The namespace might not exist on every instance.
+			if (!ret)
+			{
+				iterator->iterator = NULL;
+				continue;
+			}
+		}
+
+		// Instances free their iterators once they are exhausted.
+		if (status)
+		{
+			if (stripe->original.object.backend_iterate_status(stripe->instances[iterator->instance - 1], iterator->iterator, name, modification_time, size))
+			{
+				return TRUE;
+			}
+		}
+		else if (stripe->original.object.backend_iterate(stripe->instances[iterator->instance - 1], iterator->iterator, name))
+		{
+			return TRUE;
+		}
+
+		iterator->iterator = NULL;
+	}
+
+	g_free(iterator->namespace);
+	g_free(iterator->prefix);
+	g_slice_free(JBackendStripeIterator, iterator);
+
+	return FALSE;
+}
+
+static gboolean
+j_backend_stripe_iterate(gpointer backend_data, gpointer data, gchar const** name)
+{
+	return j_backend_stripe_next(backend_data, data, name, FALSE, NULL, NULL);
+}
+
+static gboolean
+j_backend_stripe_iterate_status(gpointer backend_data, gpointer data, gchar const** name, gint64* modification_time, guint64* size)
+{
+	return j_backend_stripe_next(backend_data, data, name, TRUE, modification_time, size);
+}
+
+static void
+j_backend_stripe_fini(gpointer backend_data)
+{
+	JBackendStripe* stripe = backend_data;
+	JBackendStatistics* statistics;
+
+	for (guint i = 0; i < stripe->count; i++)
+	{
+		stripe->original.object.backend_fini(stripe->instances[i]);
+	}
+
+	// Restore the original functions, so that the backend can be initialized again.
+	statistics = stripe->backend->statistics;
+	*(stripe->backend) = stripe->original;
+	stripe->backend->statistics = statistics;
+
+	g_free(stripe->instances);
+	g_slice_free(JBackendStripe, stripe);
+}
+
+/**
+ * Initializes one instance of an object backend per path and replaces the backend's functions with forwarding ones.
+ *
+ * \private
+ *
+ * \param backend A backend.
+ * \param paths   The instances' paths.
+ *
+ * \return TRUE on success, FALSE if an instance could not be initialized.
+ **/
+static gboolean
+j_backend_stripe_init(JBackend* backend, gchar** paths)
+{
+	JBackendStripe* stripe;
+	guint count;
+
+	count = g_strv_length(paths);
+
+	stripe = g_slice_new(JBackendStripe);
+	stripe->backend = backend;
+	stripe->original = *backend;
+	stripe->instances = g_new0(gpointer, count);
+	stripe->count = 0;
+
+	for (guint i = 0; i < count; i++)
+	{
+		if (!backend->object.backend_init(paths[i], &(stripe->instances[i])))
+		{
+			for (guint j = 0; j < stripe->count; j++)
+			{
+				backend->object.backend_fini(stripe->instances[j]);
+			}
+
+			g_free(stripe->instances);
+			g_slice_free(JBackendStripe, stripe);
+
+			return FALSE;
+		}
+
+		stripe->count++;
+	}
+
+	backend->data = stripe;
+
+	backend->object.backend_fini = j_backend_stripe_fini;
+	backend->object.backend_create = j_backend_stripe_create;
+	backend->object.backend_open = j_backend_stripe_open;
+	backend->object.backend_delete = j_backend_stripe_delete;
+	backend->object.backend_close = j_backend_stripe_close;
+	backend->object.backend_status = j_backend_stripe_status;
+	backend->object.backend_sync = j_backend_stripe_sync;
+	backend->object.backend_read = j_backend_stripe_read;
+	backend->object.backend_write = j_backend_stripe_write;
+	backend->object.backend_get_all = j_backend_stripe_get_all;
+	backend->object.backend_get_by_prefix = j_backend_stripe_get_by_prefix;
+	backend->object.backend_iterate = j_backend_stripe_iterate;
+
+	// Optional functions stay NULL, so that the usual fallbacks apply.
+	backend->object.backend_syncv = (backend->object.backend_syncv != NULL) ? j_backend_stripe_syncv : NULL;
+	backend->object.backend_readv = (backend->object.backend_readv != NULL) ? j_backend_stripe_readv : NULL;
+	backend->object.backend_writev = (backend->object.backend_writev != NULL) ? j_backend_stripe_writev : NULL;
+	backend->object.backend_discard = (backend->object.backend_discard != NULL) ? j_backend_stripe_discard : NULL;
+	backend->object.backend_preallocate = (backend->object.backend_preallocate != NULL) ? j_backend_stripe_preallocate : NULL;
+	backend->object.backend_get_fd = (backend->object.backend_get_fd != NULL) ? j_backend_stripe_get_fd : NULL;
+	backend->object.backend_written = (backend->object.backend_written != NULL) ? j_backend_stripe_written : NULL;
+	backend->object.backend_clone = (backend->object.backend_clone != NULL) ? j_backend_stripe_clone : NULL;
+	backend->object.backend_copy_range = (backend->object.backend_copy_range != NULL) ? j_backend_stripe_copy_range : NULL;
+	backend->object.backend_advise = (backend->object.backend_advise != NULL) ? j_backend_stripe_advise : NULL;
+	backend->object.backend_iterate_status = (backend->object.backend_iterate_status != NULL) ? j_backend_stripe_iterate_status : NULL;
+
+	return TRUE;
+}
+
+/**
+ * Keeps objects on two object backends, a fast hot tier and a slow cold tier.
+ * New objects are created on the hot tier; a background thread moves objects that have not been used for a while to the cold tier and moves frequently used ones back.
+ * Objects are opened on whichever tier they are on, so moving them is transparent to the server.
+ * The backend's functions are replaced by the ones below, which forward to the tier an object is on.
+ **/
+struct JBackendTier
+{
+	/**
+	 * The backend whose functions have been replaced, it forms the hot tier.
+	 **/
+	JBackend* backend;
+
+	/**
+	 * The backend's original functions and data.
+	 **/
+	JBackend original;
+
+	/**
+	 * The cold tier's backend.
+	 **/
+	JBackend* cold;
+
+	/**
+	 * The time after which unused objects are moved to the cold tier, in microseconds.
+	 **/
+	gint64 cold_after;
+
+	GThread* thread;
+
+	GMutex mutex[1];
+	GCond cond[1];
+	gboolean stop;
+
+	/**
+	 * Maps namespace and path of all objects that are in use or on the hot tier to their JBackendTierEntry.
+	 * Objects on the cold tier are forgotten once they have not been used for a while.
+	 **/
+	GHashTable* entries;
+};
+
+typedef struct JBackendTier JBackendTier;
+
+enum JBackendTierLevel
+{
+	J_BACKEND_TIER_HOT,
+	J_BACKEND_TIER_COLD
+};
+
+typedef enum JBackendTierLevel JBackendTierLevel;
+
+/**
+ * The number of accesses within the cold_after period that move an object back to the hot tier.
+ **/
+#define J_BACKEND_TIER_PROMOTE 8
+
+/**
+ * The maximum number of objects moved before the tiers are examined again.
+ **/
+#define J_BACKEND_TIER_BATCH 16
+
+/**
+ * The amount of data copied at once when moving objects.
+ **/
+#define J_BACKEND_TIER_CHUNK (4 * 1024 * 1024)
+
+/**
+ * The access history of an object.
+ **/
+struct JBackendTierEntry
+{
+	gchar* key;
+	gchar* namespace;
+	gchar* path;
+
+	/**
+	 * The tier the object is on.
+	 * Unknown objects are looked for on the hot tier first.
+	 **/
+	JBackendTierLevel level;
+
+	/**
+	 * The number of open handles, objects are only moved while they are not open.
+	 **/
+	guint users;
+
+	/**
+	 * Whether the object is being moved, opening it waits until it has been moved.
+	 **/
+	gboolean migrating;
+
+	gint64 access_time;
+
+	/**
+	 * The start of the current period and the number of accesses within it.
+	 **/
+	gint64 period_start;
+	guint accesses;
+};
+
+typedef struct JBackendTierEntry JBackendTierEntry;
+
+/**
+ * An object of a tiered backend.
+ **/
+struct JBackendTierObject
+{
+	/**
+	 * Stays valid while the object is open.
+	 **/
+	JBackendTierEntry* entry;
+
+	JBackendTierLevel level;
+	gpointer data;
+};
+
+typedef struct JBackendTierObject JBackendTierObject;
+
+static void
+j_backend_tier_entry_free(JBackendTierEntry* entry)
+{
+	g_free(entry->key);
+	g_free(entry->namespace);
+	g_free(entry->path);
+
+	g_slice_free(JBackendTierEntry, entry);
+}
+
+static JBackend*
+j_backend_tier_get(JBackendTier* tier, JBackendTierLevel level)
+{
+	return (level == J_BACKEND_TIER_HOT) ? &(tier->original) : tier->cold;
+}
+
+/**
+ * Records an access to an object.
+ **/
+static void
+j_backend_tier_touch(JBackendTier* tier, JBackendTierEntry* entry)
+{
+	gint64 now;
+
+	now = g_get_monotonic_time();
+
+	g_mutex_lock(tier->mutex);
+
+	// Accesses are counted per period, so that objects have to be in use continuously to be moved back.
+	if (now - entry->period_start > tier->cold_after)
+	{
+		entry->period_start = now;
+		entry->accesses = 0;
+	}
+
+	entry->access_time = now;
+	entry->accesses++;
+
+	g_mutex_unlock(tier->mutex);
+}
+
+/**
+ * Releases an object's entry.
+ *
+ * \private
+ *
+ * \param tier   A tiered backend.
+ * \param entry  An entry.
+ * \param forget Whether to forget the object if it is not used anymore, for example, because it has been deleted.
+ **/
+static void
+j_backend_tier_release(JBackendTier* tier, JBackendTierEntry* entry, gboolean forget)
+{
+	g_mutex_lock(tier->mutex);
+
+	entry->users--;
+
+	if (forget && entry->users == 0)
+	{
+		g_hash_table_remove(tier->entries, entry->key);
+	}
+
+	g_mutex_unlock(tier->mutex);
+}
+
+static gboolean
+j_backend_tier_open_or_create(JBackendTier* tier, gchar const* namespace, gchar const* path, gpointer* data, gboolean create)
+{
+	JBackendTierEntry* entry;
+	JBackendTierObject* object;
+	JBackendTierLevel first;
+	JBackendTierLevel level = J_BACKEND_TIER_HOT;
+	g_autofree gchar* key = NULL;
+	gpointer tier_data = NULL;
+	gboolean ret = FALSE;
+
+	key = g_strconcat(namespace, "/", path, NULL);
+
+	g_mutex_lock(tier->mutex);
+
+	// Entries might be removed while waiting, so they have to be looked up again.
+	while ((entry = g_hash_table_lookup(tier->entries, key)) != NULL && entry->migrating)
+	{
+		g_cond_wait(tier->cond, tier->mutex);
+	}
+
+	if (entry == NULL)
+	{
+		entry = g_slice_new(JBackendTierEntry);
+		entry->key = g_strdup(key);
+		entry->namespace = g_strdup(namespace);
+		entry->path = g_strdup(path);
+		entry->level = J_BACKEND_TIER_HOT;
+		entry->users = 0;
+		entry->migrating = FALSE;
+		entry->access_time = g_get_monotonic_time();
+		entry->period_start = entry->access_time;
+		entry->accesses = 0;
+
+		g_hash_table_insert(tier->entries, entry->key, entry);
+	}
+
+	entry->users++;
+	first = entry->level;
+
+	g_mutex_unlock(tier->mutex);
+
+	// Existing objects stay on their tier, so creating an object looks for it first.
+	for (guint i = 0; i < 2 && !ret; i++)
+	{
+		JBackend* backend;
+
+		level = (i == 0) ? first : !first;
+		backend = j_backend_tier_get(tier, level);
+
+		ret = backend->object.backend_open(backend->data, namespace, path, &tier_data);
+	}
+
+	if (!ret && create)
+	{
+		level = J_BACKEND_TIER_HOT;
+		ret = tier->original.object.backend_create(tier->original.data, namespace, path, &tier_data);
+	}
+
+	if (!ret)
+	{
+		j_backend_tier_release(tier, entry, TRUE);
+
+		return FALSE;
+	}
+
+	g_mutex_lock(tier->mutex);
+	entry->level = level;
+	g_mutex_unlock(tier->mutex);
+
+	j_backend_tier_touch(tier, entry);
+
+	object = g_slice_new(JBackendTierObject);
+	object->entry = entry;
+	object->level = level;
+	object->data = tier_data;
+
+	*data = object;
+
+	return TRUE;
+}
+
+static gboolean
+j_backend_tier_create(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* data)
+{
+	return j_backend_tier_open_or_create(backend_data, namespace, path, data, TRUE);
+}
+
+static gboolean
+j_backend_tier_open(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* data)
+{
+	return j_backend_tier_open_or_create(backend_data, namespace, path, data, FALSE);
+}
+
+static gboolean
+j_backend_tier_delete(gpointer backend_data, gpointer data)
+{
+	JBackendTier* tier = backend_data;
+	JBackendTierObject* object = data;
+	JBackend* backend;
+	gboolean ret;
+
+	backend = j_backend_tier_get(tier, object->level);
+	ret = backend->object.backend_delete(backend->data, object->data);
+
+	j_backend_tier_release(tier, object->entry, TRUE);
+	g_slice_free(JBackendTierObject, object);
+
+	return ret;
+}
+
+static gboolean
+j_backend_tier_close(gpointer backend_data, gpointer data)
+{
+	JBackendTier* tier = backend_data;
+	JBackendTierObject* object = data;
+	JBackend* backend;
+	gboolean ret;
+
+	backend = j_backend_tier_get(tier, object->level);
+	ret = backend->object.backend_close(backend->data, object->data);
+
+	j_backend_tier_release(tier, object->entry, FALSE);
+	g_slice_free(JBackendTierObject, object);
+
+	return ret;
+}
+
+static gboolean
+j_backend_tier_status(gpointer backend_data, gpointer data, gint64* modification_time, guint64* size)
+{
+	JBackendTier* tier = backend_data;
+	JBackendTierObject* object = data;
+	JBackend* backend;
+
+	backend = j_backend_tier_get(tier, object->level);
+
+	return backend->object.backend_status(backend->data, object->data, modification_time, size);
+}
+
+static gboolean
+j_backend_tier_sync(gpointer backend_data, gpointer data)
+{
+	JBackendTier* tier = backend_data;
+	JBackendTierObject* object = data;
+	JBackend* backend;
+
+	backend = j_backend_tier_get(tier, object->level);
+
+	return backend->object.backend_sync(backend->data, object->data);
+}
+
+static gboolean
+j_backend_tier_read(gpointer backend_data, gpointer data, gpointer buffer, guint64 length, guint64 offset, guint64* bytes_read)
+{
+	JBackendTier* tier = backend_data;
+	JBackendTierObject* object = data;
+	JBackend* backend;
+
+	j_backend_tier_touch(tier, object->entry);
+	backend = j_backend_tier_get(tier, object->level);
+
+	return backend->object.backend_read(backend->data, object->data, buffer, length, offset, bytes_read);
+}
+
+static gboolean
+j_backend_tier_write(gpointer backend_data, gpointer data, gconstpointer buffer, guint64 length, guint64 offset, guint64* bytes_written)
+{
+	JBackendTier* tier = backend_data;
+	JBackendTierObject* object = data;
+	JBackend* backend;
+
+	j_backend_tier_touch(tier, object->entry);
+	backend = j_backend_tier_get(tier, object->level);
+
+	return backend->object.backend_write(backend->data, object->data, buffer, length, offset, bytes_written);
+}
+
+static gboolean
+j_backend_tier_readv(gpointer backend_data, gpointer data, JBackendObjectExtent* extents, guint32 count)
+{
+	JBackendTier* tier = backend_data;
+	JBackendTierObject* object = data;
+	JBackend* backend;
+
+	j_backend_tier_touch(tier, object->entry);
+	backend = j_backend_tier_get(tier, object->level);
+
+	return backend->object.backend_readv(backend->data, object->data, extents, count);
+}
+
+static gboolean
+j_backend_tier_writev(gpointer backend_data, gpointer data, JBackendObjectExtent* extents, guint32 count)
+{
+	JBackendTier* tier = backend_data;
+	JBackendTierObject* object = data;
+	JBackend* backend;
+
+	j_backend_tier_touch(tier, object->entry);
+	backend = j_backend_tier_get(tier, object->level);
+
+	return backend->object.backend_writev(backend->data, object->data, extents, count);
+}
+
+static gboolean
+j_backend_tier_discard(gpointer backend_data, gpointer data, guint64 length, guint64 offset)
+{
+	JBackendTier* tier = backend_data;
+	JBackendTierObject* object = data;
+	JBackend* backend;
+
+	backend = j_backend_tier_get(tier, object->level);
+
+	return backend->object.backend_discard(backend->data, object->data, length, offset);
+}
+
+static gboolean
+j_backend_tier_preallocate(gpointer backend_data, gpointer data, guint64 size)
+{
+	JBackendTier* tier = backend_data;
+	JBackendTierObject* object = data;
+	JBackend* backend;
+
+	backend = j_backend_tier_get(tier, object->level);
+
+	return backend->object.backend_preallocate(backend->data, object->data, size);
+}
+
+static gboolean
+j_backend_tier_get_fd(gpointer backend_data, gpointer data, gint* fd)
+{
+	JBackendTier* tier = backend_data;
+	JBackendTierObject* object = data;
+	JBackend* backend;
+
+	backend = j_backend_tier_get(tier, object->level);
+
+	return backend->object.backend_get_fd(backend->data, object->data, fd);
+}
+
+static gboolean
+j_backend_tier_written(gpointer backend_data, gpointer data, guint64 length, guint64 offset)
+{
+	JBackendTier* tier = backend_data;
+	JBackendTierObject* object = data;
+	JBackend* backend;
+
+	backend = j_backend_tier_get(tier, object->level);
+
+	// The tiers do not have to track writes both
+	if (backend->object.backend_written == NULL)
+	{
+		return TRUE;
+	}
+
+	return backend->object.backend_written(backend->data, object->data, length, offset);
+}
+
+static gboolean
+j_backend_tier_clone(gpointer backend_data, gpointer data, gpointer clone_data)
+{
+	JBackendTier* tier = backend_data;
+	JBackendTierObject* object = data;
+	JBackendTierObject* clone = clone_data;
+	JBackend* backend;
+
+	// Data can only be shared within a tier, the caller falls back to copying
+	if (object->level != clone->level)
+	{
+		return FALSE;
+	}
+
+	backend = j_backend_tier_get(tier, object->level);
+
+	return backend->object.backend_clone(backend->data, object->data, clone->data);
+}
+
+static gboolean
+j_backend_tier_copy_range(gpointer backend_data, gpointer data, gpointer target_data, guint64 length, guint64 offset, guint64 target_offset)
+{
+	JBackendTier* tier = backend_data;
+	JBackendTierObject* object = data;
+	JBackendTierObject* target = target_data;
+	JBackend* backend;
+
+	// Data can only be shared within a tier, the caller falls back to copying
+	if (object->level != target->level)
+	{
+		return FALSE;
+	}
+
+	backend = j_backend_tier_get(tier, object->level);
+
+	return backend->object.backend_copy_range(backend->data, object->data, target->data, length, offset, target_offset);
+}
+
+static gboolean
+j_backend_tier_advise(gpointer backend_data, gpointer data, JAdvice advice, guint64 length, guint64 offset)
+{
+	JBackendTier* tier = backend_data;
+	JBackendTierObject* object = data;
+	JBackend* backend;
+
+	backend = j_backend_tier_get(tier, object->level);
+
+	// The tiers do not have to support advice both
+	if (backend->object.backend_advise == NULL)
+	{
+		return TRUE;
+	}
+
+	return backend->object.backend_advise(backend->data, object->data, advice, length, offset);
+}
+
+static gpointer
+j_backend_tier_iterator_new(gchar const* namespace, gchar const* prefix)
+{
+	JBackendStripeIterator* iterator;
+
+	iterator = g_slice_new(JBackendStripeIterator);
+	iterator->namespace = g_strdup(namespace);
+	iterator->prefix = g_strdup(prefix);
+	iterator->instance = J_BACKEND_TIER_HOT;
+	iterator->iterator = NULL;
+
+	return iterator;
+}
+
+static gboolean
+j_backend_tier_get_all(gpointer backend_data, gchar const* namespace, gpointer* iterator)
+{
+	(void)backend_data;
+
+	*iterator = j_backend_tier_iterator_new(namespace, NULL);
+
+	return TRUE;
+}
+
+static gboolean
+j_backend_tier_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const* prefix, gpointer* iterator)
+{
+	(void)backend_data;
+
+	*iterator = j_backend_tier_iterator_new(namespace, prefix);
+
+	return TRUE;
+}
+
+static gboolean
+j_backend_tier_iterate(gpointer backend_data, gpointer data, gchar const** name)
+{
+	JBackendTier* tier = backend_data;
+	JBackendStripeIterator* iterator = data;
+
+	// Iterates over the hot tier first and the cold tier afterwards, like a striped backend with two instances.
+	while (TRUE)
+	{
+		JBackend* backend;
+
+		if (iterator->iterator == NULL)
+		{
+			gboolean ret;
+
+			if (iterator->instance > J_BACKEND_TIER_COLD)
+			{
+				break;
+			}
+
+			backend = j_backend_tier_get(tier, iterator->instance);
+			iterator->instance++;
+
+			if (iterator->prefix == NULL)
+			{
+				ret = backend->object.backend_get_all(backend->data, iterator->namespace, &(iterator->iterator));
+			}
+			else
+			{
+				ret = backend->object.backend_get_by_prefix(backend->data, iterator->namespace, iterator->prefix, &(iterator->iterator));
+			}
+
+			// The namespace might not exist on both tiers.
+			if (!ret)
+			{
+				iterator->iterator = NULL;
+				continue;
+			}
+		}
+
+		backend = j_backend_tier_get(tier, iterator->instance - 1);
+
+		if (backend->object.backend_iterate(backend->data, iterator->iterator, name))
+		{
+			return TRUE;
+		}
+
+		iterator->iterator = NULL;
+	}
+
+	g_free(iterator->namespace);
+	g_free(iterator->prefix);
+	g_slice_free(JBackendStripeIterator, iterator);
+
+	return FALSE;
+}
+
+/**
+ * Moves an object to another tier.
+ * The object is copied, synced and only deleted from its old tier afterwards, so it is not lost if the server crashes in between.
+ *
+ * \private
+ *
+ * \param tier  A tiered backend.
+ * \param entry The object's entry, which has to be marked as migrating.
+ * \param level The tier to move the object to.
+ * \param gone  Returns whether the object does not exist anymore.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_backend_tier_migrate(JBackendTier* tier, JBackendTierEntry* entry, JBackendTierLevel level, gboolean* gone)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBackend* source;
+	JBackend* destination;
+	gpointer source_object;
+	gpointer destination_object;
+	g_autofree gpointer buffer = NULL;
+	gint64 modification_time;
+	guint64 size;
+	guint64 offset = 0;
+	gboolean ret = TRUE;
+
+	source = j_backend_tier_get(tier, entry->level);
+	destination = j_backend_tier_get(tier, level);
+
+	*gone = FALSE;
+
+	if (!source->object.backend_open(source->data, entry->namespace, entry->path, &source_object))
+	{
+		*gone = TRUE;
+		return FALSE;
+	}
+
+	if (!source->object.backend_status(source->data, source_object, &modification_time, &size))
+	{
+		source->object.backend_close(source->data, source_object);
+		return FALSE;
+	}
+
+	// A copy left behind by a crash might be larger than the object.
+	if (destination->object.backend_open(destination->data, entry->namespace, entry->path, &destination_object))
+	{
+		destination->object.backend_delete(destination->data, destination_object);
+	}
+
+	if (!destination->object.backend_create(destination->data, entry->namespace, entry->path, &destination_object))
+	{
+		source->object.backend_close(source->data, source_object);
+		return FALSE;
+	}
+
+	buffer = g_malloc(J_BACKEND_TIER_CHUNK);
+
+	while (ret && offset < size)
+	{
+		guint64 length;
+		guint64 bytes_read = 0;
+		guint64 bytes_written = 0;
+
+		length = MIN(size - offset, J_BACKEND_TIER_CHUNK);
+
+		ret = source->object.backend_read(source->data, source_object, buffer, length, offset, &bytes_read)
+		      && bytes_read > 0
+		      && destination->object.backend_write(destination->data, destination_object, buffer, bytes_read, offset, &bytes_written)
+		      && bytes_written == bytes_read;
+
+		offset += bytes_read;
+	}
+
+	ret = ret && destination->object.backend_sync(destination->data, destination_object);
+
+	if (ret)
+	{
+		destination->object.backend_close(destination->data, destination_object);
+		source->object.backend_delete(source->data, source_object);
+	}
+	else
+	{
+		destination->object.backend_delete(destination->data, destination_object);
+		source->object.backend_close(source->data, source_object);
+	}
+
+	return ret;
+}
+
+static gpointer
+j_backend_tier_thread(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBackendTier* tier = data;
+	gint64 interval;
+
+	// Examine the tiers often enough to notice cold objects in time, but at most once per second.
+	interval = CLAMP(tier->cold_after / 10, G_TIME_SPAN_SECOND, G_TIME_SPAN_MINUTE);
+
+	g_mutex_lock(tier->mutex);
+
+	while (!tier->stop)
+	{
+		g_autoptr(GPtrArray) entries = NULL;
+		GHashTableIter iter;
+		gpointer value;
+		gint64 end_time;
+		gint64 now;
+
+		end_time = g_get_monotonic_time() + interval;
+
+		while (!tier->stop && g_cond_wait_until(tier->cond, tier->mutex, end_time))
+		{
+		}
+
+		if (tier->stop)
+		{
+			break;
+		}
+
+		entries = g_ptr_array_new();
+		now = g_get_monotonic_time();
+
+		g_hash_table_iter_init(&iter, tier->entries);
+
+		while (entries->len < J_BACKEND_TIER_BATCH && g_hash_table_iter_next(&iter, NULL, &value))
+		{
+			JBackendTierEntry* entry = value;
+
+			if (entry->users > 0)
+			{
+				continue;
+			}
+
+			if (entry->level == J_BACKEND_TIER_HOT && now - entry->access_time > tier->cold_after)
+			{
+				entry->migrating = TRUE;
+				g_ptr_array_add(entries, entry);
+			}
+			else if (entry->level == J_BACKEND_TIER_COLD && entry->accesses >= J_BACKEND_TIER_PROMOTE && now - entry->period_start <= tier->cold_after)
+			{
+				entry->migrating = TRUE;
+				g_ptr_array_add(entries, entry);
+			}
+			else if (entry->level == J_BACKEND_TIER_COLD && now - entry->access_time > tier->cold_after)
+			{
+				// Unused objects on the cold tier are found again when they are opened.
+				g_hash_table_iter_remove(&iter);
+			}
+		}
+
+		g_mutex_unlock(tier->mutex);
+
+		for (guint i = 0; i < entries->len; i++)
+		{
+			JBackendTierEntry* entry = g_ptr_array_index(entries, i);
+			JBackendTierLevel level;
+			gboolean gone;
+			gboolean ret;
+
+			level = !entry->level;
+			ret = j_backend_tier_migrate(tier, entry, level, &gone);
+
+			g_mutex_lock(tier->mutex);
+
+			now = g_get_monotonic_time();
+
+			if (ret)
+			{
+				entry->level = level;
+			}
+
+			// Failed moves are retried in the next period.
+			entry->access_time = now;
+			entry->period_start = now;
+			entry->accesses = 0;
+			entry->migrating = FALSE;
+
+			if (gone)
+			{
+				g_hash_table_remove(tier->entries, entry->key);
+			}
+
+			g_cond_broadcast(tier->cond);
+			g_mutex_unlock(tier->mutex);
+		}
+
+		g_mutex_lock(tier->mutex);
+	}
+
+	g_mutex_unlock(tier->mutex);
+
+	return NULL;
+}
+
+static void
+j_backend_tier_fini(gpointer backend_data)
+{
+	JBackendTier* tier = backend_data;
+	JBackendStatistics* statistics;
+
+	g_mutex_lock(tier->mutex);
+	tier->stop = TRUE;
+	g_cond_broadcast(tier->cond);
+	g_mutex_unlock(tier->mutex);
+
+	g_thread_join(tier->thread);
+
+	// Restore the original functions first, since a striped hot tier restores its own ones when finalized.
+	statistics = tier->backend->statistics;
+	*(tier->backend) = tier->original;
+	tier->backend->statistics = statistics;
+
+	tier->backend->object.backend_fini(tier->backend->data);
+	j_backend_object_fini(tier->cold);
+
+	g_hash_table_unref(tier->entries);
+	g_mutex_clear(tier->mutex);
+	g_cond_clear(tier->cond);
+
+	g_slice_free(JBackendTier, tier);
+}
+
+/**
+ * Replaces an initialized backend's functions with ones that move objects between it and a cold tier.
+ *
+ * \private
+ *
+ * \param backend    A backend.
+ * \param cold       The cold tier's initialized backend.
+ * \param cold_after The time in seconds after which unused objects are moved to the cold tier.
+ **/
+static void
+j_backend_tier_init(JBackend* backend, JBackend* cold, guint32 cold_after)
+{
+	JBackendTier* tier;
+
+	tier = g_slice_new(JBackendTier);
+	tier->backend = backend;
+	tier->original = *backend;
+	tier->cold = cold;
+	tier->cold_after = (gint64)cold_after * G_TIME_SPAN_SECOND;
+	tier->stop = FALSE;
+	tier->entries = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)j_backend_tier_entry_free);
+
+	g_mutex_init(tier->mutex);
+	g_cond_init(tier->cond);
+
+	backend->data = tier;
+
+	backend->object.backend_fini = j_backend_tier_fini;
+	backend->object.backend_create = j_backend_tier_create;
+	backend->object.backend_open = j_backend_tier_open;
+	backend->object.backend_delete = j_backend_tier_delete;
+	backend->object.backend_close = j_backend_tier_close;
+	backend->object.backend_status = j_backend_tier_status;
+	backend->object.backend_sync = j_backend_tier_sync;
+	backend->object.backend_read = j_backend_tier_read;
+	backend->object.backend_write = j_backend_tier_write;
+	backend->object.backend_get_all = j_backend_tier_get_all;
+	backend->object.backend_get_by_prefix = j_backend_tier_get_by_prefix;
+	backend->object.backend_iterate = j_backend_tier_iterate;
+
+	// Optional functions are only used if both tiers provide them, the usual fallbacks apply otherwise.
+	backend->object.backend_syncv = NULL;
+	backend->object.backend_readv = (backend->object.backend_readv != NULL && cold->object.backend_readv != NULL) ? j_backend_tier_readv : NULL;
+	backend->object.backend_writev = (backend->object.backend_writev != NULL && cold->object.backend_writev != NULL) ? j_backend_tier_writev : NULL;
+	backend->object.backend_discard = (backend->object.backend_discard != NULL && cold->object.backend_discard != NULL) ? j_backend_tier_discard : NULL;
+	backend->object.backend_preallocate = (backend->object.backend_preallocate != NULL && cold->object.backend_preallocate != NULL) ? j_backend_tier_preallocate : NULL;
+	backend->object.backend_get_fd = (backend->object.backend_get_fd != NULL && cold->object.backend_get_fd != NULL) ? j_backend_tier_get_fd : NULL;
+	backend->object.backend_written = (backend->object.backend_written != NULL || cold->object.backend_written != NULL) ? j_backend_tier_written : NULL;
+	backend->object.backend_clone = (backend->object.backend_clone != NULL && cold->object.backend_clone != NULL) ? j_backend_tier_clone : NULL;
+	backend->object.backend_copy_range = (backend->object.backend_copy_range != NULL && cold->object.backend_copy_range != NULL) ? j_backend_tier_copy_range : NULL;
+	backend->object.backend_advise = (backend->object.backend_advise != NULL || cold->object.backend_advise != NULL) ? j_backend_tier_advise : NULL;
+	backend->object.backend_iterate_status = NULL;
+
+	tier->thread = g_thread_new("julea-tier", j_backend_tier_thread, tier);
+}
+
+gboolean
+j_backend_object_init(JBackend* backend, gchar const* path)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_auto(GStrv) paths = NULL;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(path != NULL, FALSE);
+
+	// Several paths separated by semicolons stripe objects over multiple instances.
+	paths = g_strsplit(path, ";", 0);
+
+	{
+		J_TRACE("backend_init", "%s", path);
+
+		if (g_strv_length(paths) > 1)
+		{
+			ret = j_backend_stripe_init(backend, paths);
+		}
+		else
+		{
+			ret = backend->object.backend_init(path, &(backend->data));
+		}
+	}
+
+	return ret;
+}
+
+/**
+ * Initializes an object backend as the hot tier and another one as the cold tier.
+ * Objects that have not been used for a while are moved to the cold tier in the background and moved back once they are used frequently.
+ *
+ * \param backend      A backend.
+ * \param path         The backend's path.
+ * \param cold_backend The cold tier's backend.
+ * \param cold_path    The cold tier's path.
+ * \param cold_after   The time in seconds after which unused objects are moved to the cold tier.
+ *
+ * \return TRUE on success, FALSE if one of the backends could not be initialized.
+ **/
+gboolean
+j_backend_object_init_tiered(JBackend* backend, gchar const* path, JBackend* cold_backend, gchar const* cold_path, guint32 cold_after)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(cold_backend != NULL, FALSE);
+	g_return_val_if_fail(cold_backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(cold_after > 0, FALSE);
+
+	if (!j_backend_object_init(backend, path))
+	{
+		return FALSE;
+	}
+
+	if (!j_backend_object_init(cold_backend, cold_path))
+	{
+		backend->object.backend_fini(backend->data);
+
+		return FALSE;
+	}
+
+	j_backend_tier_init(backend, cold_backend, cold_after);
+
+	return TRUE;
+}
+
+void
+j_backend_object_fini(JBackend* backend)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(backend != NULL);
+	g_return_if_fail(backend->type == J_BACKEND_TYPE_OBJECT);
+
+	{
+		J_TRACE("backend_fini", NULL);
+		backend->object.backend_fini(backend->data);
+	}
+
+	j_backend_statistics_free(backend);
+}
+
+gboolean
+j_backend_object_create(JBackend* backend, gchar const* namespace, gchar const* path, gpointer* data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(path != NULL, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	{
+		J_TRACE("backend_create", "%s, %s, %p", namespace, path, (gpointer)data);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_CREATE);
+		ret = backend->object.backend_create(backend->data, namespace, path, data);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_open(JBackend* backend, gchar const* namespace, gchar const* path, gpointer* data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(path != NULL, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	{
+		J_TRACE("backend_open", "%s, %s, %p", namespace, path, (gpointer)data);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_OPEN);
+		ret = backend->object.backend_open(backend->data, namespace, path, data);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_delete(JBackend* backend, gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	{
+		J_TRACE("backend_delete", "%p", data);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_DELETE);
+		ret = backend->object.backend_delete(backend->data, data);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_get_all(JBackend* backend, gchar const* namespace, gpointer* iterator)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(iterator != NULL, FALSE);
+
+	{
+		J_TRACE("backend_get_all", "%s, %p", namespace, (gpointer)iterator);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_GET_ALL);
+		ret = backend->object.backend_get_all(backend->data, namespace, iterator);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_get_by_prefix(JBackend* backend, gchar const* namespace, gchar const* prefix, gpointer* iterator)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(prefix != NULL, FALSE);
+	g_return_val_if_fail(iterator != NULL, FALSE);
+
+	{
+		J_TRACE("backend_get_by_prefix", "%s, %s, %p", namespace, prefix, (gpointer)iterator);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_GET_BY_PREFIX);
+		ret = backend->object.backend_get_by_prefix(backend->data, namespace, prefix, iterator);
+	}
+
+	return ret;
+}
+gboolean
+j_backend_object_iterate(JBackend* backend, gpointer iterator, gchar const** name)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(iterator != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+
+	{
+		J_TRACE("backend_iterate", "%p, %p", iterator, (gpointer)name);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_ITERATE);
+		ret = backend->object.backend_iterate(backend->data, iterator, name);
+	}
+
+	return ret;
+}
+
+/**
+ * Returns the next name of an iterator together with the object's modification time and size.
+ * Backends that do not provide backend_iterate_status have every object opened and queried separately.
+ *
+ * \param backend           A backend.
+ * \param namespace         The namespace the iterator was created for.
+ * \param iterator          An iterator returned by j_backend_object_get_all() or j_backend_object_get_by_prefix().
+ * \param name              Returns the name.
+ * \param modification_time Returns the modification time.
+ * \param size              Returns the size.
+ *
+ * \return TRUE if another name is available, FALSE otherwise.
+ **/
+gboolean
+j_backend_object_iterate_status(JBackend* backend, gchar const* namespace, gpointer iterator, gchar const** name, gint64* modification_time, guint64* size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(iterator != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(modification_time != NULL, FALSE);
+	g_return_val_if_fail(size != NULL, FALSE);
+
+	if (backend->object.backend_iterate_status != NULL)
+	{
+		J_TRACE("backend_iterate_status", "%p, %p", iterator, (gpointer)name);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_ITERATE);
+		ret = backend->object.backend_iterate_status(backend->data, iterator, name, modification_time, size);
+	}
+	else
+	{
+		while ((ret = j_backend_object_iterate(backend, iterator, name)))
+		{
+			gpointer object;
+			gboolean status;
+
+			// Objects deleted in the meantime are skipped
+			if (!j_backend_object_open(backend, namespace, *name, &object))
+			{
+				continue;
+			}
+
+			status = j_backend_object_status(backend, object, modification_time, size);
+			j_backend_object_close(backend, object);
+
+			if (status)
+			{
+				break;
+			}
+		}
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_close(JBackend* backend, gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	{
+		J_TRACE("backend_close", "%p", data);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_CLOSE);
+		ret = backend->object.backend_close(backend->data, data);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_status(JBackend* backend, gpointer data, gint64* modification_time, guint64* size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(modification_time != NULL, FALSE);
+	g_return_val_if_fail(size != NULL, FALSE);
+
+	{
+		J_TRACE("backend_status", "%p, %p, %p", data, (gpointer)modification_time, (gpointer)size);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_STATUS);
+		ret = backend->object.backend_status(backend->data, data, modification_time, size);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_sync(JBackend* backend, gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	{
+		J_TRACE("backend_sync", "%p", data);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_SYNC);
+		ret = backend->object.backend_sync(backend->data, data);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_syncv(JBackend* backend, gpointer* data, guint32 count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	if (backend->object.backend_syncv != NULL)
+	{
+		J_TRACE("backend_syncv", "%p, %u", (gpointer)data, count);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_SYNCV);
+		ret = backend->object.backend_syncv(backend->data, data, count);
+	}
+	else
+	{
+		for (guint32 i = 0; i < count; i++)
+		{
+			J_TRACE("backend_sync", "%p", data[i]);
+			J_BACKEND_STATISTICS(J_BACKEND_CALL_SYNC);
+			ret = backend->object.backend_sync(backend->data, data[i]) && ret;
+		}
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_read(JBackend* backend, gpointer data, gpointer buffer, guint64 length, guint64 offset, guint64* bytes_read)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(buffer != NULL, FALSE);
+	g_return_val_if_fail(bytes_read != NULL, FALSE);
+
+	{
+		J_TRACE("backend_read", "%p, %p, %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT ", %p", data, buffer, length, offset, (gpointer)bytes_read);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_READ);
+		ret = backend->object.backend_read(backend->data, data, buffer, length, offset, bytes_read);
+		backend_timer.bytes = *bytes_read;
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_write(JBackend* backend, gpointer data, gconstpointer buffer, guint64 length, guint64 offset, guint64* bytes_written)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(buffer != NULL, FALSE);
 	g_return_val_if_fail(bytes_written != NULL, FALSE);
 
 	{
-		J_TRACE("backend_write", "%p, %p, %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT ", %p", data, buffer, length, offset, (gpointer)bytes_written);
-		ret = backend->object.backend_write(backend->data, data, buffer, length, offset, bytes_written);
+		J_TRACE("backend_write", "%p, %p, %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT ", %p", data, buffer, length, offset, (gpointer)bytes_written);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_WRITE);
+		ret = backend->object.backend_write(backend->data, data, buffer, length, offset, bytes_written);
+		backend_timer.bytes = *bytes_written;
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_readv(JBackend* backend, gpointer data, JBackendObjectExtent* extents, guint32 count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(extents != NULL, FALSE);
+
+	if (backend->object.backend_readv != NULL)
+	{
+		J_TRACE("backend_readv", "%p, %p, %u", data, (gpointer)extents, count);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_READV);
+
+		// Backends only have to report the bytes of extents they actually transferred
+		for (guint32 i = 0; i < count; i++)
+		{
+			extents[i].bytes = 0;
+		}
+
+		ret = backend->object.backend_readv(backend->data, data, extents, count);
+
+		for (guint32 i = 0; i < count; i++)
+		{
+			backend_timer.bytes += extents[i].bytes;
+		}
+	}
+	else
+	{
+		for (guint32 i = 0; i < count; i++)
+		{
+			J_TRACE("backend_read", "%p, %p, %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT ", %p", data, extents[i].data, extents[i].length, extents[i].offset, (gpointer)&(extents[i].bytes));
+			J_BACKEND_STATISTICS(J_BACKEND_CALL_READ);
+
+			extents[i].bytes = 0;
+			ret = backend->object.backend_read(backend->data, data, extents[i].data, extents[i].length, extents[i].offset, &(extents[i].bytes)) && ret;
+			backend_timer.bytes = extents[i].bytes;
+		}
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_writev(JBackend* backend, gpointer data, JBackendObjectExtent* extents, guint32 count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(extents != NULL, FALSE);
+
+	if (backend->object.backend_writev != NULL)
+	{
+		J_TRACE("backend_writev", "%p, %p, %u", data, (gpointer)extents, count);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_WRITEV);
+
+		// Backends only have to report the bytes of extents they actually transferred
+		for (guint32 i = 0; i < count; i++)
+		{
+			extents[i].bytes = 0;
+		}
+
+		ret = backend->object.backend_writev(backend->data, data, extents, count);
+
+		for (guint32 i = 0; i < count; i++)
+		{
+			backend_timer.bytes += extents[i].bytes;
+		}
+	}
+	else
+	{
+		for (guint32 i = 0; i < count; i++)
+		{
+			J_TRACE("backend_write", "%p, %p, %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT ", %p", data, extents[i].data, extents[i].length, extents[i].offset, (gpointer)&(extents[i].bytes));
+			J_BACKEND_STATISTICS(J_BACKEND_CALL_WRITE);
+
+			extents[i].bytes = 0;
+			ret = backend->object.backend_write(backend->data, data, extents[i].data, extents[i].length, extents[i].offset, &(extents[i].bytes)) && ret;
+			backend_timer.bytes = extents[i].bytes;
+		}
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_discard(JBackend* backend, gpointer data, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	if (backend->object.backend_discard != NULL)
+	{
+		J_TRACE("backend_discard", "%p, %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT, data, length, offset);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_DISCARD);
+		ret = backend->object.backend_discard(backend->data, data, length, offset);
+	}
+	else
+	{
+		guint64 size = 0;
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_DISCARD);
+
+		// Overwrite the range with zeros but do not extend the object
+		J_TRACE("backend_status", "%p, %p, %p", data, NULL, (gpointer)&size);
+		ret = backend->object.backend_status(backend->data, data, NULL, &size);
+
+		if (ret && offset < size)
+		{
+			g_autofree gpointer zeros = NULL;
+			guint64 zeros_size;
+
+			length = MIN(length, size - offset);
+			zeros_size = MIN(length, 1024 * 1024);
+			zeros = g_malloc0(zeros_size);
+
+			for (guint64 position = 0; position < length && ret; position += zeros_size)
+			{
+				guint64 chunk = MIN(length - position, zeros_size);
+				guint64 bytes_written = 0;
+
+				J_TRACE("backend_write", "%p, %p, %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT ", %p", data, zeros, chunk, offset + position, (gpointer)&bytes_written);
+				ret = backend->object.backend_write(backend->data, data, zeros, chunk, offset + position, &bytes_written);
+			}
+		}
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_advise(JBackend* backend, gpointer data, JAdvice advice, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	// Advice is only a hint
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	if (backend->object.backend_advise != NULL)
+	{
+		J_TRACE("backend_advise", "%p, %d, %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT, data, advice, length, offset);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_ADVISE);
+		ret = backend->object.backend_advise(backend->data, data, advice, length, offset);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_preallocate(JBackend* backend, gpointer data, guint64 size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	// Preallocation is only a hint
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	if (backend->object.backend_preallocate != NULL && size > 0)
+	{
+		J_TRACE("backend_preallocate", "%p, %" G_GUINT64_FORMAT, data, size);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_PREALLOCATE);
+		ret = backend->object.backend_preallocate(backend->data, data, size);
+	}
+
+	return ret;
+}
+
+/**
+ * Returns a file descriptor for an object's data.
+ * The descriptor can be used to read and write the data with sendfile() and splice() and stays valid until the object is closed.
+ * Writes through the descriptor bypass the backend and have to be reported with j_backend_object_written().
+ *
+ * \param backend A backend.
+ * \param data    An object.
+ * \param fd      Returns the descriptor.
+ *
+ * \return TRUE if the backend provides a descriptor, FALSE otherwise.
+ **/
+gboolean
+j_backend_object_get_fd(JBackend* backend, gpointer data, gint* fd)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(fd != NULL, FALSE);
+
+	if (backend->object.backend_get_fd == NULL)
+	{
+		return FALSE;
+	}
+
+	return backend->object.backend_get_fd(backend->data, data, fd);
+}
+
+/**
+ * Tells the backend that a range of an object has been written through the descriptor returned by j_backend_object_get_fd().
+ *
+ * \param backend A backend.
+ * \param data    An object.
+ * \param length  The range's length.
+ * \param offset  The range's offset.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+j_backend_object_written(JBackend* backend, gpointer data, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	if (backend->object.backend_written == NULL || length == 0)
+	{
+		return TRUE;
+	}
+
+	return backend->object.backend_written(backend->data, data, length, offset);
+}
+
+/**
+ * Replaces an object's data with a copy of another object's data.
+ * Backends that support it share the data between both objects until either is modified, so that cloning only costs metadata.
+ * Otherwise, the data is copied.
+ *
+ * \param backend    A backend.
+ * \param data       The object to clone.
+ * \param clone_data The clone, which should be empty.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+j_backend_object_clone(JBackend* backend, gpointer data, gpointer clone_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(clone_data != NULL, FALSE);
+
+	J_BACKEND_STATISTICS(J_BACKEND_CALL_CLONE);
+
+	if (backend->object.backend_clone != NULL)
+	{
+		J_TRACE("backend_clone", "%p, %p", data, clone_data);
+		ret = backend->object.backend_clone(backend->data, data, clone_data);
+	}
+
+	if (!ret)
+	{
+		g_autofree gpointer buffer = NULL;
+		guint64 buffer_size;
+		guint64 size = 0;
+
+		J_TRACE("backend_status", "%p, %p, %p", data, NULL, (gpointer)&size);
+		ret = backend->object.backend_status(backend->data, data, NULL, &size);
+
+		buffer_size = MIN(size, 4 * 1024 * 1024);
+		buffer = g_malloc(MAX(buffer_size, 1));
+
+		for (guint64 position = 0; position < size && ret; position += buffer_size)
+		{
+			guint64 chunk = MIN(size - position, buffer_size);
+			guint64 nbytes = 0;
+
+			J_TRACE("backend_read", "%p, %p, %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT ", %p", data, buffer, chunk, position, (gpointer)&nbytes);
+			ret = backend->object.backend_read(backend->data, data, buffer, chunk, position, &nbytes) && nbytes == chunk;
+
+			if (ret)
+			{
+				J_TRACE("backend_write", "%p, %p, %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT ", %p", clone_data, buffer, chunk, position, (gpointer)&nbytes);
+				ret = backend->object.backend_write(backend->data, clone_data, buffer, chunk, position, &nbytes) && nbytes == chunk;
+			}
+		}
+
+		backend_timer.bytes = size;
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_copy_range(JBackend* backend, gpointer data, gpointer target_data, guint64 length, guint64 offset, guint64 target_offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(target_data != NULL, FALSE);
+
+	J_BACKEND_STATISTICS(J_BACKEND_CALL_COPY_RANGE);
+
+	if (backend->object.backend_copy_range != NULL)
+	{
+		J_TRACE("backend_copy_range", "%p, %p, %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT, data, target_data, length, offset, target_offset);
+		ret = backend->object.backend_copy_range(backend->data, data, target_data, length, offset, target_offset);
+	}
+
+	if (!ret)
+	{
+		g_autofree gpointer buffer = NULL;
+		guint64 buffer_size;
+
+		buffer_size = MIN(length, 4 * 1024 * 1024);
+		buffer = g_malloc(MAX(buffer_size, 1));
+		ret = TRUE;
+
+		for (guint64 position = 0; position < length && ret; position += buffer_size)
+		{
+			guint64 chunk = MIN(length - position, buffer_size);
+			guint64 nbytes = 0;
+
+			J_TRACE("backend_read", "%p, %p, %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT ", %p", data, buffer, chunk, offset + position, (gpointer)&nbytes);
+			ret = backend->object.backend_read(backend->data, data, buffer, chunk, offset + position, &nbytes) && nbytes == chunk;
+
+			if (ret)
+			{
+				J_TRACE("backend_write", "%p, %p, %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT ", %p", target_data, buffer, chunk, target_offset + position, (gpointer)&nbytes);
+				ret = backend->object.backend_write(backend->data, target_data, buffer, chunk, target_offset + position, &nbytes) && nbytes == chunk;
+			}
+		}
 	}
 
+	backend_timer.bytes = length;
+
 	return ret;
 }
 
@@ -555,6 +2770,8 @@ j_backend_kv_fini(JBackend* backend)
 		J_TRACE("backend_fini", NULL);
 		backend->kv.backend_fini(backend->data);
 	}
+
+	j_backend_statistics_free(backend);
 }
 
 gboolean
@@ -566,39 +2783,198 @@ j_backend_kv_batch_start(JBackend* backend, gchar const* namespace, JSemantics*
 
 	g_return_val_if_fail(backend != NULL, FALSE);
 	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_KV, FALSE);
-	g_return_val_if_fail(namespace != NULL, FALSE);
-	g_return_val_if_fail(semantics != NULL, FALSE);
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	{
+		J_TRACE("backend_batch_start", "%s, %p, %p", namespace, (gpointer)semantics, (gpointer)batch);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_BATCH_START);
+		ret = backend->kv.backend_batch_start(backend->data, namespace, semantics, batch);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_kv_batch_execute(JBackend* backend, gpointer batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_KV, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	{
+		J_TRACE("backend_batch_execute", "%p", batch);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_BATCH_EXECUTE);
+		ret = backend->kv.backend_batch_execute(backend->data, batch);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_kv_batch_abort(JBackend* backend, gpointer batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_KV, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	if (backend->kv.backend_batch_abort != NULL)
+	{
+		J_TRACE("backend_batch_abort", "%p", batch);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_BATCH_ABORT);
+		ret = backend->kv.backend_batch_abort(backend->data, batch);
+	}
+	else
+	{
+		J_TRACE("backend_batch_execute", "%p", batch);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_BATCH_ABORT);
+		backend->kv.backend_batch_execute(backend->data, batch);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_kv_put(JBackend* backend, gpointer batch, gchar const* key, gconstpointer value, guint32 value_len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_KV, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+
+	{
+		J_TRACE("backend_put", "%p, %s, %p, %u", batch, key, (gconstpointer)value, value_len);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_PUT);
+		ret = backend->kv.backend_put(backend->data, batch, key, value, value_len);
+		backend_timer.bytes = value_len;
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_kv_delete(JBackend* backend, gpointer batch, gchar const* key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_KV, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+
+	{
+		J_TRACE("backend_delete", "%p, %s", batch, key);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_DELETE);
+		ret = backend->kv.backend_delete(backend->data, batch, key);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_kv_get(JBackend* backend, gpointer batch, gchar const* key, gpointer* value, guint32* value_len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_KV, FALSE);
 	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+	g_return_val_if_fail(value_len != NULL, FALSE);
 
 	{
-		J_TRACE("backend_batch_start", "%s, %p, %p", namespace, (gpointer)semantics, (gpointer)batch);
-		ret = backend->kv.backend_batch_start(backend->data, namespace, semantics, batch);
+		J_TRACE("backend_get", "%p, %s, %p, %p", batch, key, (gpointer)value, (gpointer)value_len);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_GET);
+		ret = backend->kv.backend_get(backend->data, batch, key, value, value_len);
+		backend_timer.bytes = (ret) ? *value_len : 0;
 	}
 
 	return ret;
 }
 
 gboolean
-j_backend_kv_batch_execute(JBackend* backend, gpointer batch)
+j_backend_kv_get_multi(JBackend* backend, gpointer batch, gchar const** keys, guint32 count, gpointer* values, guint32* values_len)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gboolean ret;
+	gboolean ret = TRUE;
 
 	g_return_val_if_fail(backend != NULL, FALSE);
 	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_KV, FALSE);
 	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(keys != NULL, FALSE);
+	g_return_val_if_fail(values != NULL, FALSE);
+	g_return_val_if_fail(values_len != NULL, FALSE);
 
+	if (backend->kv.backend_get_multi != NULL)
 	{
-		J_TRACE("backend_batch_execute", "%p", batch);
-		ret = backend->kv.backend_batch_execute(backend->data, batch);
+		J_TRACE("backend_get_multi", "%p, %u, %p, %p", batch, count, (gpointer)values, (gpointer)values_len);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_GET_MULTI);
+		ret = backend->kv.backend_get_multi(backend->data, batch, keys, count, values, values_len);
+
+		for (guint32 i = 0; i < count; i++)
+		{
+			backend_timer.bytes += values_len[i];
+		}
+	}
+	else
+	{
+		for (guint32 i = 0; i < count; i++)
+		{
+			J_TRACE("backend_get", "%p, %s, %p, %p", batch, keys[i], (gpointer)&values[i], (gpointer)&values_len[i]);
+			J_BACKEND_STATISTICS(J_BACKEND_CALL_GET);
+
+			if (!backend->kv.backend_get(backend->data, batch, keys[i], &values[i], &values_len[i]))
+			{
+				values[i] = NULL;
+				values_len[i] = 0;
+			}
+
+			backend_timer.bytes += values_len[i];
+		}
 	}
 
 	return ret;
 }
 
+/**
+ * Replaces a value if it matches the expected one.
+ *
+ * Backends without native support fall back to backend_get and backend_put within the batch,
+ * which is only atomic if the backend isolates concurrent batches from each other.
+ *
+ * \param backend      A backend.
+ * \param batch        A batch.
+ * \param key          A key.
+ * \param expected     The expected value, NULL if the key must not exist.
+ * \param expected_len The expected value's length.
+ * \param value        The new value.
+ * \param value_len    The new value's length.
+ * \param swapped      Returns whether the value has been replaced.
+ *
+ * \return FALSE if the backend failed, TRUE otherwise (even if the value has not been replaced).
+ **/
 gboolean
-j_backend_kv_put(JBackend* backend, gpointer batch, gchar const* key, gconstpointer value, guint32 value_len)
+j_backend_kv_compare_and_swap(JBackend* backend, gpointer batch, gchar const* key, gconstpointer expected, guint32 expected_len, gconstpointer value, guint32 value_len, gboolean* swapped)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -609,52 +2985,131 @@ j_backend_kv_put(JBackend* backend, gpointer batch, gchar const* key, gconstpoin
 	g_return_val_if_fail(batch != NULL, FALSE);
 	g_return_val_if_fail(key != NULL, FALSE);
 	g_return_val_if_fail(value != NULL, FALSE);
+	g_return_val_if_fail(swapped != NULL, FALSE);
 
+	*swapped = FALSE;
+
+	if (backend->kv.backend_compare_and_swap != NULL)
 	{
-		J_TRACE("backend_put", "%p, %s, %p, %u", batch, key, (gconstpointer)value, value_len);
-		ret = backend->kv.backend_put(backend->data, batch, key, value, value_len);
+		J_TRACE("backend_compare_and_swap", "%p, %s, %p, %u, %p, %u", batch, key, expected, expected_len, value, value_len);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_COMPARE_AND_SWAP);
+		ret = backend->kv.backend_compare_and_swap(backend->data, batch, key, expected, expected_len, value, value_len, swapped);
+		backend_timer.bytes = (*swapped) ? value_len : 0;
+	}
+	else
+	{
+		g_autofree gpointer current = NULL;
+		guint32 current_len = 0;
+		gboolean exists;
+		gboolean match;
+
+		{
+			J_TRACE("backend_get", "%p, %s, %p, %p", batch, key, (gpointer)&current, (gpointer)&current_len);
+			J_BACKEND_STATISTICS(J_BACKEND_CALL_GET);
+			exists = backend->kv.backend_get(backend->data, batch, key, &current, &current_len);
+			backend_timer.bytes = (exists) ? current_len : 0;
+		}
+
+		if (expected == NULL)
+		{
+			match = !exists;
+		}
+		else
+		{
+			match = exists && current_len == expected_len && memcmp(current, expected, expected_len) == 0;
+		}
+
+		ret = TRUE;
+
+		if (match)
+		{
+			J_TRACE("backend_put", "%p, %s, %p, %u", batch, key, value, value_len);
+			J_BACKEND_STATISTICS(J_BACKEND_CALL_PUT);
+			ret = backend->kv.backend_put(backend->data, batch, key, value, value_len);
+			backend_timer.bytes = value_len;
+			*swapped = ret;
+		}
 	}
 
 	return ret;
 }
 
+/**
+ * Adds to a counter stored as a 64-bit little-endian integer.
+ *
+ * Missing keys count as 0.
+ * Backends without native support fall back to backend_get and backend_put within the batch,
+ * which is only atomic if the backend isolates concurrent batches from each other.
+ *
+ * \param backend A backend.
+ * \param batch   A batch.
+ * \param key     A key.
+ * \param delta   The value to add.
+ * \param result  Returns the new value, may be NULL.
+ *
+ * \return FALSE if the backend failed or the existing value is not a counter, TRUE otherwise.
+ **/
 gboolean
-j_backend_kv_delete(JBackend* backend, gpointer batch, gchar const* key)
+j_backend_kv_add(JBackend* backend, gpointer batch, gchar const* key, gint64 delta, gint64* result)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	gboolean ret;
+	gint64 sum = 0;
 
 	g_return_val_if_fail(backend != NULL, FALSE);
 	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_KV, FALSE);
 	g_return_val_if_fail(batch != NULL, FALSE);
 	g_return_val_if_fail(key != NULL, FALSE);
 
+	if (backend->kv.backend_add != NULL)
 	{
-		J_TRACE("backend_delete", "%p, %s", batch, key);
-		ret = backend->kv.backend_delete(backend->data, batch, key);
+		J_TRACE("backend_add", "%p, %s, %" G_GINT64_FORMAT, batch, key, delta);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_ADD);
+		ret = backend->kv.backend_add(backend->data, batch, key, delta, &sum);
+		backend_timer.bytes = sizeof(sum);
 	}
+	else
+	{
+		g_autofree gpointer current = NULL;
+		guint32 current_len = 0;
+		gboolean exists;
 
-	return ret;
-}
+		{
+			J_TRACE("backend_get", "%p, %s, %p, %p", batch, key, (gpointer)&current, (gpointer)&current_len);
+			J_BACKEND_STATISTICS(J_BACKEND_CALL_GET);
+			exists = backend->kv.backend_get(backend->data, batch, key, &current, &current_len);
+			backend_timer.bytes = (exists) ? current_len : 0;
+		}
 
-gboolean
-j_backend_kv_get(JBackend* backend, gpointer batch, gchar const* key, gpointer* value, guint32* value_len)
-{
-	J_TRACE_FUNCTION(NULL);
+		if (exists && current_len != sizeof(sum))
+		{
+			return FALSE;
+		}
 
-	gboolean ret;
+		if (exists)
+		{
+			memcpy(&sum, current, sizeof(sum));
+			sum = GINT64_FROM_LE(sum);
+		}
 
-	g_return_val_if_fail(backend != NULL, FALSE);
-	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_KV, FALSE);
-	g_return_val_if_fail(batch != NULL, FALSE);
-	g_return_val_if_fail(key != NULL, FALSE);
-	g_return_val_if_fail(value != NULL, FALSE);
-	g_return_val_if_fail(value_len != NULL, FALSE);
+		sum += delta;
+
+		{
+			gint64 sum_le;
+
+			sum_le = GINT64_TO_LE(sum);
 
+			J_TRACE("backend_put", "%p, %s, %p, %u", batch, key, (gpointer)&sum_le, (guint32)sizeof(sum_le));
+			J_BACKEND_STATISTICS(J_BACKEND_CALL_PUT);
+			ret = backend->kv.backend_put(backend->data, batch, key, &sum_le, sizeof(sum_le));
+			backend_timer.bytes = sizeof(sum_le);
+		}
+	}
+
+	if (ret && result != NULL)
 	{
-		J_TRACE("backend_get", "%p, %s, %p, %p", batch, key, (gpointer)value, (gpointer)value_len);
-		ret = backend->kv.backend_get(backend->data, batch, key, value, value_len);
+		*result = sum;
 	}
 
 	return ret;
@@ -674,6 +3129,7 @@ j_backend_kv_get_all(JBackend* backend, gchar const* namespace, gpointer* iterat
 
 	{
 		J_TRACE("backend_get_all", "%s, %p", namespace, (gpointer)iterator);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_GET_ALL);
 		ret = backend->kv.backend_get_all(backend->data, namespace, iterator);
 	}
 
@@ -695,11 +3151,47 @@ j_backend_kv_get_by_prefix(JBackend* backend, gchar const* namespace, gchar cons
 
 	{
 		J_TRACE("backend_get_by_prefix", "%s, %s, %p", namespace, prefix, (gpointer)iterator);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_GET_BY_PREFIX);
 		ret = backend->kv.backend_get_by_prefix(backend->data, namespace, prefix, iterator);
 	}
 
 	return ret;
 }
+
+/**
+ * Iterates over a range of keys.
+ *
+ * \param backend   A backend.
+ * \param namespace A namespace.
+ * \param start     The first key (inclusive), NULL to start at the namespace's first key.
+ * \param end       The last key (exclusive), NULL to end at the namespace's last key.
+ * \param reverse   Whether to return keys in descending order.
+ * \param limit     The maximum number of pairs, 0 for no limit.
+ * \param iterator  Returns the iterator.
+ *
+ * \return TRUE on success, FALSE if the backend does not support ranges or failed.
+ **/
+gboolean
+j_backend_kv_get_range(JBackend* backend, gchar const* namespace, gchar const* start, gchar const* end, gboolean reverse, guint32 limit, gpointer* iterator)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_KV, FALSE);
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(iterator != NULL, FALSE);
+
+	if (backend->kv.backend_get_range != NULL)
+	{
+		J_TRACE("backend_get_range", "%s, %s, %s, %d, %u, %p", namespace, start, end, reverse, limit, (gpointer)iterator);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_GET_RANGE);
+		ret = backend->kv.backend_get_range(backend->data, namespace, start, end, reverse, limit, iterator);
+	}
+
+	return ret;
+}
 gboolean
 j_backend_kv_iterate(JBackend* backend, gpointer iterator, gchar const** key, gconstpointer* value, guint32* value_len)
 {
@@ -716,12 +3208,64 @@ j_backend_kv_iterate(JBackend* backend, gpointer iterator, gchar const** key, gc
 
 	{
 		J_TRACE("backend_iterate", "%p, %p, %p, %p", iterator, (gpointer)key, (gpointer)value, (gpointer)value_len);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_ITERATE);
 		ret = backend->kv.backend_iterate(backend->data, iterator, key, value, value_len);
+		backend_timer.bytes = (ret) ? *value_len : 0;
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_kv_seek(JBackend* backend, gpointer iterator, gchar const* key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_KV, FALSE);
+	g_return_val_if_fail(iterator != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+
+	if (backend->kv.backend_seek != NULL)
+	{
+		J_TRACE("backend_seek", "%p, %s", iterator, key);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_SEEK);
+		ret = backend->kv.backend_seek(backend->data, iterator, key);
 	}
 
 	return ret;
 }
 
+void
+j_backend_kv_iterator_free(JBackend* backend, gpointer iterator)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(backend != NULL);
+	g_return_if_fail(backend->type == J_BACKEND_TYPE_KV);
+	g_return_if_fail(iterator != NULL);
+
+	if (backend->kv.backend_iterator_free != NULL)
+	{
+		J_TRACE("backend_iterator_free", "%p", iterator);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_ITERATOR_FREE);
+		backend->kv.backend_iterator_free(backend->data, iterator);
+	}
+	else
+	{
+		gchar const* key;
+		gconstpointer value;
+		guint32 len;
+
+		// Iterators free themselves when they are exhausted
+		while (backend->kv.backend_iterate(backend->data, iterator, &key, &value, &len))
+		{
+		}
+	}
+}
+
 gboolean
 j_backend_db_init(JBackend* backend, gchar const* path)
 {
@@ -753,6 +3297,8 @@ j_backend_db_fini(JBackend* backend)
 		J_TRACE("backend_fini", NULL);
 		backend->db.backend_fini(backend->data);
 	}
+
+	j_backend_statistics_free(backend);
 }
 
 gboolean
@@ -771,6 +3317,7 @@ j_backend_db_batch_start(JBackend* backend, gchar const* namespace, JSemantics*
 
 	{
 		J_TRACE("backend_batch_start", "%s, %p, %p, %p", namespace, (gpointer)semantics, (gpointer)batch, (gpointer)error);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_BATCH_START);
 		ret = backend->db.backend_batch_start(backend->data, namespace, semantics, batch, error);
 	}
 
@@ -791,12 +3338,41 @@ j_backend_db_batch_execute(JBackend* backend, gpointer batch, GError** error)
 
 	{
 		J_TRACE("backend_batch_execute", "%p, %p", batch, (gpointer)error);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_BATCH_EXECUTE);
 		ret = backend->db.backend_batch_execute(backend->data, batch, error);
 	}
 
 	return ret;
 }
 
+gboolean
+j_backend_db_batch_abort(JBackend* backend, gpointer batch, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_DB, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (backend->db.backend_batch_abort != NULL)
+	{
+		J_TRACE("backend_batch_abort", "%p, %p", batch, (gpointer)error);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_BATCH_ABORT);
+		ret = backend->db.backend_batch_abort(backend->data, batch, error);
+	}
+	else
+	{
+		J_TRACE("backend_batch_execute", "%p, %p", batch, (gpointer)error);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_BATCH_ABORT);
+		backend->db.backend_batch_execute(backend->data, batch, error);
+	}
+
+	return ret;
+}
+
 gboolean
 j_backend_db_schema_create(JBackend* backend, gpointer batch, gchar const* name, bson_t const* schema, GError** error)
 {
@@ -813,6 +3389,7 @@ j_backend_db_schema_create(JBackend* backend, gpointer batch, gchar const* name,
 
 	{
 		J_TRACE("backend_schema_create", "%p, %s, %p, %p", batch, name, (gconstpointer)schema, (gpointer)error);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_SCHEMA_CREATE);
 		ret = backend->db.backend_schema_create(backend->data, batch, name, schema, error);
 	}
 
@@ -834,6 +3411,7 @@ j_backend_db_schema_get(JBackend* backend, gpointer batch, gchar const* name, bs
 
 	{
 		J_TRACE("backend_schema_get", "%p, %s, %p, %p", batch, name, (gpointer)schema, (gpointer)error);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_SCHEMA_GET);
 		ret = backend->db.backend_schema_get(backend->data, batch, name, schema, error);
 	}
 
@@ -855,6 +3433,7 @@ j_backend_db_schema_delete(JBackend* backend, gpointer batch, gchar const* name,
 
 	{
 		J_TRACE("backend_schema_delete", "%p, %s, %p", batch, name, (gpointer)error);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_SCHEMA_DELETE);
 		ret = backend->db.backend_schema_delete(backend->data, batch, name, error);
 	}
 
@@ -878,12 +3457,47 @@ j_backend_db_insert(JBackend* backend, gpointer batch, gchar const* name, bson_t
 
 	{
 		J_TRACE("backend_insert", "%p, %s, %p, %p, %p", batch, name, (gconstpointer)metadata, (gpointer)id, (gpointer)error);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_INSERT);
 		ret = backend->db.backend_insert(backend->data, batch, name, metadata, id, error);
 	}
 
 	return ret;
 }
 
+gboolean
+j_backend_db_insert_multi(JBackend* backend, gpointer batch, gchar const* name, bson_t const* const* metadata, guint count, bson_t* ids, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_DB, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(metadata != NULL, FALSE);
+	g_return_val_if_fail(ids != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (backend->db.backend_insert_multi != NULL)
+	{
+		J_TRACE("backend_insert_multi", "%p, %s, %p, %u, %p, %p", batch, name, (gconstpointer)metadata, count, (gpointer)ids, (gpointer)error);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_INSERT_MULTI);
+		ret = backend->db.backend_insert_multi(backend->data, batch, name, metadata, count, ids, error);
+	}
+	else
+	{
+		for (guint i = 0; i < count && ret; i++)
+		{
+			J_TRACE("backend_insert", "%p, %s, %p, %p, %p", batch, name, (gconstpointer)metadata[i], (gpointer)&ids[i], (gpointer)error);
+			J_BACKEND_STATISTICS(J_BACKEND_CALL_INSERT);
+			ret = backend->db.backend_insert(backend->data, batch, name, metadata[i], &ids[i], error);
+		}
+	}
+
+	return ret;
+}
+
 gboolean
 j_backend_db_update(JBackend* backend, gpointer batch, gchar const* name, bson_t const* selector, bson_t const* metadata, GError** error)
 {
@@ -901,6 +3515,7 @@ j_backend_db_update(JBackend* backend, gpointer batch, gchar const* name, bson_t
 
 	{
 		J_TRACE("backend_update", "%p, %s, %p, %p, %p", batch, name, (gconstpointer)selector, (gconstpointer)metadata, (gpointer)error);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_UPDATE);
 		ret = backend->db.backend_update(backend->data, batch, name, selector, metadata, error);
 	}
 
@@ -922,6 +3537,7 @@ j_backend_db_delete(JBackend* backend, gpointer batch, gchar const* name, bson_t
 
 	{
 		J_TRACE("backend_delete", "%p, %s, %p, %p", batch, name, (gconstpointer)selector, (gpointer)error);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_DELETE);
 		ret = backend->db.backend_delete(backend->data, batch, name, selector, error);
 	}
 
@@ -944,6 +3560,37 @@ j_backend_db_query(JBackend* backend, gpointer batch, gchar const* name, bson_t
 
 	{
 		J_TRACE("backend_query", "%p, %s, %p, %p, %p", batch, name, (gconstpointer)selector, (gpointer)iterator, (gpointer)error);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_QUERY);
+		ret = backend->db.backend_query(backend->data, batch, name, selector, iterator, error);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_db_query_fields(JBackend* backend, gpointer batch, gchar const* name, bson_t const* selector, bson_t const* fields, gpointer* iterator, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_DB, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(iterator != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (fields != NULL && backend->db.backend_query_fields != NULL)
+	{
+		J_TRACE("backend_query_fields", "%p, %s, %p, %p, %p, %p", batch, name, (gconstpointer)selector, (gconstpointer)fields, (gpointer)iterator, (gpointer)error);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_QUERY_FIELDS);
+		ret = backend->db.backend_query_fields(backend->data, batch, name, selector, fields, iterator, error);
+	}
+	else
+	{
+		J_TRACE("backend_query", "%p, %s, %p, %p, %p", batch, name, (gconstpointer)selector, (gpointer)iterator, (gpointer)error);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_QUERY);
 		ret = backend->db.backend_query(backend->data, batch, name, selector, iterator, error);
 	}
 
@@ -965,12 +3612,109 @@ j_backend_db_iterate(JBackend* backend, gpointer iterator, bson_t* metadata, GEr
 
 	{
 		J_TRACE("backend_iterate", "%p, %p, %p", iterator, (gpointer)metadata, (gpointer)error);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_ITERATE);
 		ret = backend->db.backend_iterate(backend->data, iterator, metadata, error);
 	}
 
 	return ret;
 }
 
+void
+j_backend_db_iterator_free(JBackend* backend, gpointer iterator)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(backend != NULL);
+	g_return_if_fail(backend->type == J_BACKEND_TYPE_DB);
+	g_return_if_fail(iterator != NULL);
+
+	if (backend->db.backend_iterator_free != NULL)
+	{
+		J_TRACE("backend_iterator_free", "%p", iterator);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_ITERATOR_FREE);
+		backend->db.backend_iterator_free(backend->data, iterator);
+	}
+	else
+	{
+		// Iterators free themselves when they are exhausted
+		while (TRUE)
+		{
+			g_autoptr(GError) error = NULL;
+			bson_t metadata[1];
+			gboolean ret;
+
+			bson_init(metadata);
+			ret = backend->db.backend_iterate(backend->data, iterator, metadata, &error);
+			bson_destroy(metadata);
+
+			if (!ret)
+			{
+				break;
+			}
+		}
+	}
+}
+
+gboolean
+j_backend_db_aggregate(JBackend* backend, gpointer batch, gchar const* name, bson_t const* selector, bson_t const* aggregate, gpointer* iterator, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_DB, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(aggregate != NULL, FALSE);
+	g_return_val_if_fail(iterator != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (backend->db.backend_aggregate == NULL)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_FAILED, "backend does not support aggregations");
+		return FALSE;
+	}
+
+	{
+		J_TRACE("backend_aggregate", "%p, %s, %p, %p, %p, %p", batch, name, (gconstpointer)selector, (gconstpointer)aggregate, (gpointer)iterator, (gpointer)error);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_AGGREGATE);
+		ret = backend->db.backend_aggregate(backend->data, batch, name, selector, aggregate, iterator, error);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_db_advise_indexes(JBackend* backend, gpointer batch, gchar const* name, bson_t const* options, bson_t* advice, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_DB, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(options != NULL, FALSE);
+	g_return_val_if_fail(advice != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (backend->db.backend_advise_indexes == NULL)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_FAILED, "backend does not support index advice");
+		return FALSE;
+	}
+
+	{
+		J_TRACE("backend_advise_indexes", "%p, %s, %p, %p, %p", batch, name, (gconstpointer)options, (gpointer)advice, (gpointer)error);
+		J_BACKEND_STATISTICS(J_BACKEND_CALL_ADVISE_INDEXES);
+		ret = backend->db.backend_advise_indexes(backend->data, batch, name, options, advice, error);
+	}
+
+	return ret;
+}
+
 /**
  * @}
  **/
@@ -20,16 +20,25 @@
  * \file
  **/
 
+// Required for pthread_setaffinity_np().
+#define _GNU_SOURCE
+
 #include <julea-config.h>
 
 #include <glib.h>
 
 #include <unistd.h>
 
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #include <jbackground-operation.h>
 #include <jbackground-operation-internal.h>
 
 #include <jhelper-internal.h>
+#include <jstatistics-internal.h>
 #include <jtrace.h>
 
 /**
@@ -58,58 +67,431 @@ struct JBackgroundOperation
 	gpointer result;
 
 	/**
-	 * Whether the background operation has finished.
+	 * Whether the background operation has finished, accessed atomically.
+	 **/
+	gint completed;
+
+	/**
+	 * The reference count.
+	 **/
+	gint ref_count;
+};
+
+/**
+ * The maximum number of persistent workers used by j_background_operation_execute_parallel().
+ **/
+#define J_BACKGROUND_OPERATION_MAX_WORKERS 256
+
+/**
+ * A set of tasks submitted together, the submitter waits for all of them at once.
+ **/
+struct JBackgroundOperationGroup
+{
+	/**
+	 * The number of unfinished tasks, protected by #mutex.
 	 **/
-	gboolean completed;
+	guint pending;
 
 	/**
-	 * The mutex for #completed.
+	 * The mutex for #cond.
 	 */
 	GMutex mutex[1];
 
 	/**
-	 * The condition for #completed.
+	 * The condition signaled when the last task has finished.
 	 */
 	GCond cond[1];
+};
+
+typedef struct JBackgroundOperationGroup JBackgroundOperationGroup;
 
+/**
+ * A task for a persistent worker.
+ **/
+struct JBackgroundOperationTask
+{
 	/**
-	 * The reference count.
+	 * The function to execute, NULL to stop the worker.
 	 **/
-	gint ref_count;
+	JBackgroundOperationFunc func;
+
+	/**
+	 * The data to give to #func, replaced by its return value.
+	 **/
+	gpointer* data;
+
+	JBackgroundOperationGroup* group;
+
+	/**
+	 * The submitter's statistics, so that the task is accounted to the same batch.
+	 **/
+	JStatistics* statistics;
+};
+
+typedef struct JBackgroundOperationTask JBackgroundOperationTask;
+
+/**
+ * A persistent worker thread with its own queue.
+ **/
+struct JBackgroundOperationWorker
+{
+	GThread* thread;
+
+	/**
+	 * Contains #JBackgroundOperationTask elements.
+	 **/
+	GAsyncQueue* queue;
+};
+
+typedef struct JBackgroundOperationWorker JBackgroundOperationWorker;
+
+/**
+ * The number of iterations j_background_operation_wait() spins before blocking.
+ **/
+#define J_BACKGROUND_OPERATION_SPIN_COUNT 1000
+
+/**
+ * A worker's deque of background operations.
+ * The owner pushes and pops at the tail, other workers steal from the head.
+ **/
+struct JBackgroundOperationDeque
+{
+	GQueue queue[1];
+	GMutex mutex[1];
+};
+
+typedef struct JBackgroundOperationDeque JBackgroundOperationDeque;
+
+/**
+ * A work-stealing pool executing background operations.
+ **/
+struct JBackgroundOperationPool
+{
+	guint count;
+
+	GThread** threads;
+
+	/**
+	 * One deque per thread.
+	 **/
+	JBackgroundOperationDeque* deques;
+
+	/**
+	 * The deque that the next operation submitted from outside the pool is pushed to.
+	 **/
+	guint next;
+
+	/**
+	 * The number of queued operations, accessed atomically.
+	 **/
+	gint queued;
+
+	/**
+	 * The number of threads waiting for operations, accessed atomically.
+	 **/
+	gint sleeping;
+
+	/**
+	 * Whether to pin the threads to CPUs.
+	 **/
+	gboolean pin;
+
+	/**
+	 * Whether the pool is shutting down, protected by #mutex.
+	 **/
+	gboolean stop;
+
+	GMutex mutex[1];
+	GCond cond[1];
 };
 
-static GThreadPool* j_thread_pool = NULL;
+typedef struct JBackgroundOperationPool JBackgroundOperationPool;
+
+static JBackgroundOperationPool* j_background_operation_pool = NULL;
+
+/**
+ * The index of the current thread's deque plus one, if it is a pool thread.
+ **/
+static GPrivate j_background_operation_pool_index;
+
+/**
+ * Used to wake up threads blocked in j_background_operation_wait().
+ * A single condition is sufficient because blocking is rare due to spinning.
+ **/
+static GMutex j_background_operation_wait_mutex;
+static GCond j_background_operation_wait_cond;
+static gint j_background_operation_waiters = 0;
+
+static JBackgroundOperationWorker* j_background_operation_workers[J_BACKGROUND_OPERATION_MAX_WORKERS];
+static guint j_background_operation_workers_len = 0;
+static GMutex j_background_operation_workers_mutex;
 
 /**
- * Executes background operations.
+ * Whether the current thread is a persistent worker.
+ **/
+static GPrivate j_background_operation_is_worker;
+
+static void
+j_background_operation_task_done(JBackgroundOperationGroup* group)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	// The group lives on the submitter's stack, so it must not be touched after unlocking.
+	g_mutex_lock(group->mutex);
+
+	group->pending--;
+
+	if (group->pending == 0)
+	{
+		g_cond_signal(group->cond);
+	}
+
+	g_mutex_unlock(group->mutex);
+}
+
+static gpointer
+j_background_operation_worker_thread(gpointer data)
+{
+	JBackgroundOperationWorker* worker = data;
+
+	g_private_set(&j_background_operation_is_worker, GINT_TO_POINTER(TRUE));
+
+	while (TRUE)
+	{
+		JBackgroundOperationTask* task;
+
+		task = g_async_queue_pop(worker->queue);
+
+		if (task->func == NULL)
+		{
+			g_slice_free(JBackgroundOperationTask, task);
+			break;
+		}
+
+		j_statistics_set_current(task->statistics);
+		*(task->data) = task->func(*(task->data));
+		j_statistics_set_current(NULL);
+
+		j_background_operation_task_done(task->group);
+	}
+
+	return NULL;
+}
+
+/**
+ * Returns the persistent worker for an index, starting it if necessary.
  *
  * \private
  *
- * \code
- * \endcode
+ * \param index An index, for example, a server index.
  *
- * \param data A background operations.
- * \param user_data User data.
+ * \return A worker.
  **/
-static void
-j_background_operation_thread(gpointer data, gpointer user_data)
+static JBackgroundOperationWorker*
+j_background_operation_get_worker(guint index)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JBackgroundOperation* background_operation = data;
+	JBackgroundOperationWorker* worker;
 
-	(void)user_data;
+	index %= J_BACKGROUND_OPERATION_MAX_WORKERS;
+
+	if (index < g_atomic_int_get(&j_background_operation_workers_len))
+	{
+		return j_background_operation_workers[index];
+	}
+
+	g_mutex_lock(&j_background_operation_workers_mutex);
+
+	while (j_background_operation_workers_len <= index)
+	{
+		g_autofree gchar* name = NULL;
+
+		name = g_strdup_printf("j-worker-%u", j_background_operation_workers_len);
+
+		worker = g_slice_new(JBackgroundOperationWorker);
+		worker->queue = g_async_queue_new();
+		worker->thread = g_thread_new(name, j_background_operation_worker_thread, worker);
+
+		j_background_operation_workers[j_background_operation_workers_len] = worker;
+		g_atomic_int_inc(&j_background_operation_workers_len);
+	}
+
+	g_mutex_unlock(&j_background_operation_workers_mutex);
+
+	return j_background_operation_workers[index];
+}
+
+/**
+ * Executes a background operation and signals its completion.
+ *
+ * \private
+ *
+ * \param background_operation A background operation.
+ **/
+static void
+j_background_operation_run(JBackgroundOperation* background_operation)
+{
+	J_TRACE_FUNCTION(NULL);
 
 	background_operation->result = (*(background_operation->func))(background_operation->data);
 
-	g_mutex_lock(background_operation->mutex);
-	background_operation->completed = TRUE;
-	g_cond_signal(background_operation->cond);
-	g_mutex_unlock(background_operation->mutex);
+	g_atomic_int_set(&(background_operation->completed), 1);
+
+	if (g_atomic_int_get(&j_background_operation_waiters) > 0)
+	{
+		g_mutex_lock(&j_background_operation_wait_mutex);
+		g_cond_broadcast(&j_background_operation_wait_cond);
+		g_mutex_unlock(&j_background_operation_wait_mutex);
+	}
 
 	j_background_operation_unref(background_operation);
 }
 
+/**
+ * Takes a background operation from a thread's own deque or steals one from another thread.
+ *
+ * \private
+ *
+ * \param pool  A pool.
+ * \param index The thread's index.
+ *
+ * \return A background operation, or NULL.
+ **/
+static JBackgroundOperation*
+j_background_operation_pool_take(JBackgroundOperationPool* pool, guint index)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBackgroundOperation* background_operation = NULL;
+
+	for (guint i = 0; i < pool->count && background_operation == NULL; i++)
+	{
+		JBackgroundOperationDeque* deque = &(pool->deques[(index + i) % pool->count]);
+
+		g_mutex_lock(deque->mutex);
+
+		if (i == 0)
+		{
+			// The most recent operation is the most likely one to have its data in the cache.
+			background_operation = g_queue_pop_tail(deque->queue);
+		}
+		else
+		{
+			background_operation = g_queue_pop_head(deque->queue);
+		}
+
+		g_mutex_unlock(deque->mutex);
+	}
+
+	if (background_operation != NULL)
+	{
+		g_atomic_int_dec_and_test(&(pool->queued));
+	}
+
+	return background_operation;
+}
+
+static gpointer
+j_background_operation_pool_thread(gpointer data)
+{
+	JBackgroundOperationPool* pool = j_background_operation_pool;
+	guint index = GPOINTER_TO_UINT(data);
+
+	g_private_set(&j_background_operation_pool_index, GUINT_TO_POINTER(index + 1));
+
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+	if (pool->pin)
+	{
+		cpu_set_t cpu_set;
+
+		CPU_ZERO(&cpu_set);
+		CPU_SET(index % g_get_num_processors(), &cpu_set);
+
+		if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0)
+		{
+			g_warning("Could not pin background thread %u.", index);
+		}
+	}
+#endif
+
+	while (TRUE)
+	{
+		JBackgroundOperation* background_operation;
+
+		if ((background_operation = j_background_operation_pool_take(pool, index)) != NULL)
+		{
+			j_background_operation_run(background_operation);
+			continue;
+		}
+
+		g_mutex_lock(pool->mutex);
+
+		g_atomic_int_inc(&(pool->sleeping));
+
+		while (g_atomic_int_get(&(pool->queued)) == 0 && !pool->stop)
+		{
+			g_cond_wait(pool->cond, pool->mutex);
+		}
+
+		g_atomic_int_dec_and_test(&(pool->sleeping));
+
+		if (pool->stop && g_atomic_int_get(&(pool->queued)) == 0)
+		{
+			g_mutex_unlock(pool->mutex);
+			break;
+		}
+
+		g_mutex_unlock(pool->mutex);
+	}
+
+	return NULL;
+}
+
+/**
+ * Submits a background operation to the pool.
+ * Pool threads push to their own deque, other threads distribute operations round-robin.
+ *
+ * \private
+ *
+ * \param background_operation A background operation.
+ **/
+static void
+j_background_operation_pool_push(JBackgroundOperation* background_operation)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBackgroundOperationPool* pool = j_background_operation_pool;
+	JBackgroundOperationDeque* deque;
+	guint index;
+
+	index = GPOINTER_TO_UINT(g_private_get(&j_background_operation_pool_index));
+
+	if (index > 0)
+	{
+		index--;
+	}
+	else
+	{
+		index = (guint)g_atomic_int_add((gint*)&(pool->next), 1) % pool->count;
+	}
+
+	deque = &(pool->deques[index]);
+
+	g_mutex_lock(deque->mutex);
+	g_queue_push_tail(deque->queue, background_operation);
+	g_mutex_unlock(deque->mutex);
+
+	g_atomic_int_inc(&(pool->queued));
+
+	if (g_atomic_int_get(&(pool->sleeping)) > 0)
+	{
+		g_mutex_lock(pool->mutex);
+		g_cond_signal(pool->cond);
+		g_mutex_unlock(pool->mutex);
+	}
+}
+
 /**
  * Initializes the background operation framework.
  *
@@ -122,17 +504,43 @@ j_background_operation_init(guint count)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	GThreadPool* thread_pool;
+	JBackgroundOperationPool* pool;
 
-	g_return_if_fail(j_thread_pool == NULL);
+	g_return_if_fail(j_background_operation_pool == NULL);
 
 	if (count == 0)
 	{
 		count = g_get_num_processors();
 	}
 
-	thread_pool = g_thread_pool_new(j_background_operation_thread, NULL, count, FALSE, NULL);
-	g_atomic_pointer_set(&j_thread_pool, thread_pool);
+	pool = g_slice_new(JBackgroundOperationPool);
+	pool->count = count;
+	pool->threads = g_new(GThread*, count);
+	pool->deques = g_new(JBackgroundOperationDeque, count);
+	pool->next = 0;
+	pool->queued = 0;
+	pool->sleeping = 0;
+	pool->pin = (g_strcmp0(g_getenv("JULEA_BACKGROUND_PIN"), "1") == 0);
+	pool->stop = FALSE;
+
+	g_mutex_init(pool->mutex);
+	g_cond_init(pool->cond);
+
+	for (guint i = 0; i < count; i++)
+	{
+		g_queue_init(pool->deques[i].queue);
+		g_mutex_init(pool->deques[i].mutex);
+	}
+
+	g_atomic_pointer_set(&j_background_operation_pool, pool);
+
+	for (guint i = 0; i < count; i++)
+	{
+		g_autofree gchar* name = NULL;
+
+		name = g_strdup_printf("j-background-%u", i);
+		pool->threads[i] = g_thread_new(name, j_background_operation_pool_thread, GUINT_TO_POINTER(i));
+	}
 }
 
 /**
@@ -147,14 +555,54 @@ j_background_operation_fini(void)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	GThreadPool* thread_pool;
+	JBackgroundOperationPool* pool;
+
+	g_return_if_fail(j_background_operation_pool != NULL);
 
-	g_return_if_fail(j_thread_pool != NULL);
+	pool = g_atomic_pointer_get(&j_background_operation_pool);
 
-	thread_pool = g_atomic_pointer_get(&j_thread_pool);
-	g_atomic_pointer_set(&j_thread_pool, NULL);
+	// The threads finish all queued operations before stopping.
+	g_mutex_lock(pool->mutex);
+	pool->stop = TRUE;
+	g_cond_broadcast(pool->cond);
+	g_mutex_unlock(pool->mutex);
 
-	g_thread_pool_free(thread_pool, FALSE, TRUE);
+	for (guint i = 0; i < pool->count; i++)
+	{
+		g_thread_join(pool->threads[i]);
+
+		g_queue_clear(pool->deques[i].queue);
+		g_mutex_clear(pool->deques[i].mutex);
+	}
+
+	g_atomic_pointer_set(&j_background_operation_pool, NULL);
+
+	g_cond_clear(pool->cond);
+	g_mutex_clear(pool->mutex);
+
+	g_free(pool->deques);
+	g_free(pool->threads);
+	g_slice_free(JBackgroundOperationPool, pool);
+
+	g_mutex_lock(&j_background_operation_workers_mutex);
+
+	for (guint i = 0; i < j_background_operation_workers_len; i++)
+	{
+		JBackgroundOperationWorker* worker = j_background_operation_workers[i];
+		JBackgroundOperationTask* task;
+
+		task = g_slice_new0(JBackgroundOperationTask);
+		g_async_queue_push(worker->queue, task);
+		g_thread_join(worker->thread);
+		g_async_queue_unref(worker->queue);
+
+		g_slice_free(JBackgroundOperationWorker, worker);
+		j_background_operation_workers[i] = NULL;
+	}
+
+	g_atomic_int_set(&j_background_operation_workers_len, 0);
+
+	g_mutex_unlock(&j_background_operation_workers_mutex);
 }
 
 guint
@@ -162,7 +610,7 @@ j_background_operation_get_num_threads(void)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	return g_thread_pool_get_max_threads(j_thread_pool);
+	return j_background_operation_pool->count;
 }
 
 /**
@@ -199,13 +647,10 @@ j_background_operation_new(JBackgroundOperationFunc func, gpointer data)
 	background_operation->func = func;
 	background_operation->data = data;
 	background_operation->result = NULL;
-	background_operation->completed = FALSE;
+	background_operation->completed = 0;
 	background_operation->ref_count = 2;
 
-	g_mutex_init(background_operation->mutex);
-	g_cond_init(background_operation->cond);
-
-	g_thread_pool_push(j_thread_pool, background_operation, NULL);
+	j_background_operation_pool_push(background_operation);
 
 	return background_operation;
 }
@@ -256,9 +701,6 @@ j_background_operation_unref(JBackgroundOperation* background_operation)
 
 	if (g_atomic_int_dec_and_test(&(background_operation->ref_count)))
 	{
-		g_cond_clear(background_operation->cond);
-		g_mutex_clear(background_operation->mutex);
-
 		g_slice_free(JBackgroundOperation, background_operation);
 	}
 }
@@ -283,18 +725,121 @@ j_background_operation_wait(JBackgroundOperation* background_operation)
 
 	g_return_val_if_fail(background_operation != NULL, NULL);
 
-	g_mutex_lock(background_operation->mutex);
+	for (guint i = 0; i < J_BACKGROUND_OPERATION_SPIN_COUNT; i++)
+	{
+		if (g_atomic_int_get(&(background_operation->completed)))
+		{
+			return background_operation->result;
+		}
+	}
+
+	g_mutex_lock(&j_background_operation_wait_mutex);
+	g_atomic_int_inc(&j_background_operation_waiters);
 
-	while (!background_operation->completed)
+	while (!g_atomic_int_get(&(background_operation->completed)))
 	{
-		g_cond_wait(background_operation->cond, background_operation->mutex);
+		g_cond_wait(&j_background_operation_wait_cond, &j_background_operation_wait_mutex);
 	}
 
-	g_mutex_unlock(background_operation->mutex);
+	g_atomic_int_dec_and_test(&j_background_operation_waiters);
+	g_mutex_unlock(&j_background_operation_wait_mutex);
 
 	return background_operation->result;
 }
 
+/**
+ * Executes a function for multiple data elements in parallel and waits for all of them.
+ *
+ * Element i is handed to persistent worker i, so that the same index (usually a server) is always handled by the same thread.
+ * Submitting a task only requires a queue push and the caller is woken up once when the last task has finished.
+ * The first element is executed by the calling thread itself.
+ *
+ * \param func   A function.
+ * \param data   An array of data elements, NULL elements are skipped. Each element is replaced by #func's return value.
+ * \param length The length of #data.
+ **/
+void
+j_background_operation_execute_parallel(JBackgroundOperationFunc func, gpointer* data, guint length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBackgroundOperationGroup group[1];
+	JBackgroundOperationTask* tasks;
+	gint first = -1;
+	guint count = 0;
+
+	g_return_if_fail(func != NULL);
+	g_return_if_fail(data != NULL);
+
+	for (guint i = 0; i < length; i++)
+	{
+		if (data[i] != NULL)
+		{
+			count++;
+		}
+	}
+
+	// Running tasks inline avoids deadlocks if a worker submits tasks itself.
+	if (count <= 1 || g_private_get(&j_background_operation_is_worker) != NULL)
+	{
+		for (guint i = 0; i < length; i++)
+		{
+			if (data[i] != NULL)
+			{
+				data[i] = func(data[i]);
+			}
+		}
+
+		return;
+	}
+
+	tasks = g_new(JBackgroundOperationTask, length);
+
+	g_mutex_init(group->mutex);
+	g_cond_init(group->cond);
+	// Includes the caller's own task.
+	group->pending = count;
+
+	for (guint i = 0; i < length; i++)
+	{
+		if (data[i] == NULL)
+		{
+			continue;
+		}
+
+		if (first < 0)
+		{
+			first = i;
+			continue;
+		}
+
+		tasks[i].func = func;
+		tasks[i].data = &(data[i]);
+		tasks[i].group = group;
+		tasks[i].statistics = j_statistics_get_current();
+
+		g_async_queue_push(j_background_operation_get_worker(i)->queue, &(tasks[i]));
+	}
+
+	data[first] = func(data[first]);
+
+	g_mutex_lock(group->mutex);
+
+	group->pending--;
+
+	while (group->pending > 0)
+	{
+		g_cond_wait(group->cond, group->mutex);
+	}
+
+	g_mutex_unlock(group->mutex);
+
+	g_cond_clear(group->cond);
+	g_mutex_clear(group->mutex);
+
+	g_free(tasks);
+}
+
 /**
  * @}
  **/
@@ -29,12 +29,17 @@
 
 #include <jbackground-operation.h>
 #include <jcache.h>
+#include <jhelper.h>
 #include <jlist.h>
 #include <jlist-iterator.h>
 #include <joperation-cache-internal.h>
 #include <joperation-internal.h>
 #include <jsemantics.h>
+#include <jstatistics.h>
+#include <jstatistics-internal.h>
 #include <jtrace.h>
+#include <jtransaction.h>
+#include <jtransaction-internal.h>
 
 /**
  * \defgroup JBatch Batch
@@ -42,6 +47,74 @@
  * @{
  **/
 
+/**
+ * A handle for the result of executing a batch.
+ **/
+struct JBatchFuture
+{
+	GMutex mutex[1];
+	GCond cond[1];
+
+	gboolean done;
+	gboolean ret;
+
+	/**
+	 * The reference count.
+	 **/
+	gint ref_count;
+};
+
+/**
+ * The state of a batch that executes its operations automatically.
+ **/
+struct JBatchAuto
+{
+	/**
+	 * The thread executing the accumulated operations.
+	 **/
+	GThread* thread;
+
+	/**
+	 * The thresholds that trigger an execution, 0 if disabled.
+	 * The delay is given in microseconds.
+	 **/
+	guint max_operations;
+	guint64 max_bytes;
+	guint64 max_delay;
+
+	/**
+	 * The number of accumulated operations, their size and the time the first one has been added.
+	 **/
+	guint operations;
+	guint64 bytes;
+	gint64 first_time;
+
+	/**
+	 * The future of the accumulated operations.
+	 **/
+	JBatchFuture* future;
+
+	/**
+	 * The future of the operations that have been executed last, NULL if there are none.
+	 **/
+	JBatchFuture* sealed;
+
+	gboolean flush;
+	gboolean stop;
+
+	/**
+	 * The mutex for the batch's list and all of the above.
+	 **/
+	GMutex mutex[1];
+
+	/**
+	 * The condition signaled when operations have been added or should be executed.
+	 **/
+	GCond cond[1];
+};
+
+typedef struct JBatchAuto JBatchAuto;
+
 /**
  * An operation.
  **/
@@ -57,11 +130,26 @@ struct JBatch
 	 **/
 	JSemantics* semantics;
 
+	/**
+	 * The statistics of all executions of this batch.
+	 **/
+	JStatistics* statistics;
+
+	/**
+	 * The time the batch has been queued for background execution, 0 if it is not queued.
+	 **/
+	gint64 queued_time;
+
 	/**
 	 * The background operation used for j_batch_execute_async().
 	 **/
 	JBackgroundOperation* background_operation;
 
+	/**
+	 * The state for automatic execution, NULL for regular batches.
+	 **/
+	JBatchAuto* auto_batch;
+
 	/**
 	 * The reference count.
 	 **/
@@ -77,252 +165,1421 @@ struct JBatchAsync
 
 typedef struct JBatchAsync JBatchAsync;
 
+/**
+ * A completion queue for batches.
+ **/
+struct JBatchQueue
+{
+	/**
+	 * The submitted batches that have not been started yet.
+	 * Contains #JBatchQueueEntry elements.
+	 **/
+	GQueue submitted[1];
+
+	/**
+	 * The executed batches that have not been retrieved yet.
+	 * Contains #JBatchQueueEntry elements.
+	 **/
+	GQueue completed[1];
+
+	/**
+	 * Whether a background operation is executing the submitted batches.
+	 **/
+	gboolean draining;
+
+	/**
+	 * The mutex for #submitted, #completed and #draining.
+	 **/
+	GMutex mutex[1];
+
+	/**
+	 * The condition signaled when batches have completed.
+	 **/
+	GCond cond[1];
+
+	/**
+	 * The reference count.
+	 **/
+	gint ref_count;
+};
+
+struct JBatchQueueEntry
+{
+	JBatch* batch;
+	gpointer user_data;
+	gboolean ret;
+};
+
+typedef struct JBatchQueueEntry JBatchQueueEntry;
+
+/**
+ * A group of operations that can be executed together.
+ **/
+struct JBatchGroup
+{
+	JOperationExecFunc exec_func;
+	JList* list;
+};
+
+typedef struct JBatchGroup JBatchGroup;
+
+/**
+ * A sequence of groups for the same key that has to be executed in order.
+ **/
+struct JBatchChain
+{
+	JBatch* batch;
+
+	/**
+	 * Contains #JBatchGroup elements.
+	 **/
+	GPtrArray* groups;
+
+	gboolean ret;
+};
+
+typedef struct JBatchChain JBatchChain;
+
+/**
+ * The statistics recorded for batches.
+ **/
+static JStatisticsType const j_batch_statistics_types[] = {
+	J_STATISTICS_BYTES_SENT,
+	J_STATISTICS_BYTES_RECEIVED,
+	J_STATISTICS_MESSAGES_SENT,
+	J_STATISTICS_MESSAGES_RECEIVED,
+	J_STATISTICS_BATCHES,
+	J_STATISTICS_BATCH_QUEUE_TIME,
+	J_STATISTICS_BATCH_EXECUTION_TIME,
+	J_STATISTICS_BATCH_NETWORK_TIME,
+	J_STATISTICS_BATCH_SERVER_QUEUE_TIME,
+	J_STATISTICS_BATCH_SERVER_TIME
+};
+
 static gpointer
 j_batch_background_operation(gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JBatchAsync* async = data;
-	gboolean ret;
+	JBatchAsync* async = data;
+	gboolean ret;
+
+	ret = j_batch_execute(async->batch);
+
+	if (async->callback != NULL)
+	{
+		(*async->callback)(async->batch, ret, async->user_data);
+	}
+
+	j_batch_unref(async->batch);
+
+	g_slice_free(JBatchAsync, async);
+
+	return NULL;
+}
+
+static JBatchFuture*
+j_batch_future_new(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBatchFuture* future;
+
+	future = g_slice_new(JBatchFuture);
+	future->done = FALSE;
+	future->ret = FALSE;
+	future->ref_count = 1;
+
+	g_mutex_init(future->mutex);
+	g_cond_init(future->cond);
+
+	return future;
+}
+
+static void
+j_batch_future_complete(JBatchFuture* future, gboolean ret)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_mutex_lock(future->mutex);
+	future->ret = ret;
+	future->done = TRUE;
+	g_cond_broadcast(future->cond);
+	g_mutex_unlock(future->mutex);
+}
+
+/**
+ * Executes the operations accumulated by an automatic batch.
+ * The operations are executed in the order they have been added, one execution at a time.
+ *
+ * \private
+ *
+ * \param data A batch.
+ *
+ * \return NULL.
+ **/
+static gpointer
+j_batch_auto_thread(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBatch* batch = data;
+	JBatchAuto* auto_batch = batch->auto_batch;
+
+	g_mutex_lock(auto_batch->mutex);
+
+	while (TRUE)
+	{
+		JBatch* sealed;
+		JBatchFuture* future;
+		gboolean ret;
+
+		while (!auto_batch->flush && !auto_batch->stop)
+		{
+			if (auto_batch->operations == 0 || auto_batch->max_delay == 0)
+			{
+				g_cond_wait(auto_batch->cond, auto_batch->mutex);
+			}
+			else if (!g_cond_wait_until(auto_batch->cond, auto_batch->mutex, auto_batch->first_time + (gint64)auto_batch->max_delay))
+			{
+				auto_batch->flush = TRUE;
+			}
+		}
+
+		auto_batch->flush = FALSE;
+
+		if (auto_batch->operations == 0)
+		{
+			if (auto_batch->stop)
+			{
+				break;
+			}
+
+			continue;
+		}
+
+		// New operations are accumulated while the current ones are executed
+		sealed = j_batch_new_from_batch(batch);
+		future = auto_batch->future;
+
+		if (auto_batch->sealed != NULL)
+		{
+			j_batch_future_unref(auto_batch->sealed);
+		}
+
+		auto_batch->sealed = j_batch_future_ref(future);
+		auto_batch->future = j_batch_future_new();
+		auto_batch->operations = 0;
+		auto_batch->bytes = 0;
+
+		g_mutex_unlock(auto_batch->mutex);
+
+		ret = j_batch_execute(sealed);
+
+		for (guint i = 0; i < G_N_ELEMENTS(j_batch_statistics_types); i++)
+		{
+			j_statistics_add(batch->statistics, j_batch_statistics_types[i], j_statistics_get(sealed->statistics, j_batch_statistics_types[i]));
+		}
+
+		j_batch_unref(sealed);
+
+		j_batch_future_complete(future, ret);
+		j_batch_future_unref(future);
+
+		g_mutex_lock(auto_batch->mutex);
+	}
+
+	g_mutex_unlock(auto_batch->mutex);
+
+	return NULL;
+}
+
+/**
+ * Adds an operation to an automatic batch.
+ * Triggers an execution if the number or size of the accumulated operations exceeds its threshold.
+ *
+ * \private
+ *
+ * \param batch     A batch.
+ * \param operation An operation.
+ **/
+static void
+j_batch_auto_add(JBatch* batch, JOperation* operation)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBatchAuto* auto_batch = batch->auto_batch;
+	guint64 size = 0;
+
+	// The size of the data the operation references, as far as it is known
+	if (operation->cache_func != NULL)
+	{
+		size = operation->cache_func(operation->data, NULL);
+	}
+
+	g_mutex_lock(auto_batch->mutex);
+
+	j_list_append(batch->list, operation);
+
+	if (auto_batch->operations == 0)
+	{
+		auto_batch->first_time = g_get_monotonic_time();
+		g_cond_signal(auto_batch->cond);
+	}
+
+	auto_batch->operations++;
+	auto_batch->bytes += size;
+
+	if ((auto_batch->max_operations > 0 && auto_batch->operations >= auto_batch->max_operations)
+	    || (auto_batch->max_bytes > 0 && auto_batch->bytes >= auto_batch->max_bytes))
+	{
+		auto_batch->flush = TRUE;
+		g_cond_signal(auto_batch->cond);
+	}
+
+	g_mutex_unlock(auto_batch->mutex);
+}
+
+/**
+ * Returns the future of the operations accumulated by an automatic batch and optionally triggers their execution.
+ * If no operations are accumulated, the future of the last execution is returned.
+ *
+ * \private
+ *
+ * \param batch A batch.
+ * \param flush Whether to execute the operations right away.
+ *
+ * \return A future, or NULL if no operations have been executed yet.
+ **/
+static JBatchFuture*
+j_batch_auto_get_future(JBatch* batch, gboolean flush)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBatchAuto* auto_batch = batch->auto_batch;
+	JBatchFuture* future = NULL;
+
+	g_mutex_lock(auto_batch->mutex);
+
+	if (auto_batch->operations > 0)
+	{
+		future = j_batch_future_ref(auto_batch->future);
+
+		if (flush)
+		{
+			auto_batch->flush = TRUE;
+			g_cond_signal(auto_batch->cond);
+		}
+	}
+	else if (auto_batch->sealed != NULL)
+	{
+		future = j_batch_future_ref(auto_batch->sealed);
+	}
+
+	g_mutex_unlock(auto_batch->mutex);
+
+	return future;
+}
+
+/**
+ * Stops an automatic batch's thread after executing all accumulated operations.
+ *
+ * \private
+ *
+ * \param batch A batch.
+ **/
+static void
+j_batch_auto_free(JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBatchAuto* auto_batch = batch->auto_batch;
+
+	g_mutex_lock(auto_batch->mutex);
+	auto_batch->stop = TRUE;
+	g_cond_signal(auto_batch->cond);
+	g_mutex_unlock(auto_batch->mutex);
+
+	g_thread_join(auto_batch->thread);
+
+	j_batch_future_unref(auto_batch->future);
+
+	if (auto_batch->sealed != NULL)
+	{
+		j_batch_future_unref(auto_batch->sealed);
+	}
+
+	g_cond_clear(auto_batch->cond);
+	g_mutex_clear(auto_batch->mutex);
+
+	g_slice_free(JBatchAuto, auto_batch);
+	batch->auto_batch = NULL;
+}
+
+/**
+ * Creates a new batch.
+ *
+ * \code
+ * \endcode
+ *
+ * \param semantics A semantics object.
+ *
+ * \return A new batch. Should be freed with j_batch_unref().
+ **/
+JBatch*
+j_batch_new(JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBatch* batch;
+
+	g_return_val_if_fail(semantics != NULL, NULL);
+
+	batch = g_slice_new(JBatch);
+	batch->list = j_list_new((JListFreeFunc)j_operation_free);
+	batch->semantics = j_semantics_ref(semantics);
+	batch->background_operation = NULL;
+	batch->auto_batch = NULL;
+	batch->statistics = j_statistics_new(FALSE);
+	batch->queued_time = 0;
+	batch->ref_count = 1;
+
+	return batch;
+}
+
+/**
+ * Creates a new batch that executes its operations automatically.
+ *
+ * Operations added to the batch, possibly by several threads, are accumulated and executed together by a background thread.
+ * An execution is triggered when the number of accumulated operations or the size of their data reaches its threshold,
+ * or when the first accumulated operation has waited for the given delay.
+ * j_batch_execute() only queues the operations, so buffers and results passed to the operations have to stay valid
+ * until the operations have been executed, which can be waited for using j_batch_execute_future() or j_batch_wait().
+ *
+ * The batch's atomicity must not be #J_SEMANTICS_ATOMICITY_BATCH, because operations of different callers are executed together.
+ *
+ * \code
+ * g_autoptr(JBatch) batch = NULL;
+ * g_autoptr(JBatchFuture) future = NULL;
+ *
+ * batch = j_batch_new_auto(semantics, 128, 1024 * 1024, 1000);
+ * j_kv_put(kv, value, length, g_free, batch);
+ * future = j_batch_execute_future(batch);
+ * j_batch_future_wait(future);
+ * \endcode
+ *
+ * \param semantics      A semantics object.
+ * \param max_operations The number of operations that triggers an execution, 0 to disable.
+ * \param max_bytes      The size of the operations' data that triggers an execution, 0 to disable.
+ * \param max_delay      The time in microseconds operations are delayed at most, 0 to disable.
+ *
+ * \return A new batch. Should be freed with j_batch_unref(), which executes the remaining operations.
+ **/
+JBatch*
+j_batch_new_auto(JSemantics* semantics, guint max_operations, guint64 max_bytes, guint64 max_delay)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBatch* batch;
+	JBatchAuto* auto_batch;
+
+	g_return_val_if_fail(semantics != NULL, NULL);
+	g_return_val_if_fail(j_semantics_get(semantics, J_SEMANTICS_ATOMICITY) != J_SEMANTICS_ATOMICITY_BATCH, NULL);
+
+	batch = j_batch_new(semantics);
+
+	auto_batch = g_slice_new(JBatchAuto);
+	auto_batch->max_operations = max_operations;
+	auto_batch->max_bytes = max_bytes;
+	auto_batch->max_delay = max_delay;
+	auto_batch->operations = 0;
+	auto_batch->bytes = 0;
+	auto_batch->first_time = 0;
+	auto_batch->future = j_batch_future_new();
+	auto_batch->sealed = NULL;
+	auto_batch->flush = FALSE;
+	auto_batch->stop = FALSE;
+
+	g_mutex_init(auto_batch->mutex);
+	g_cond_init(auto_batch->cond);
+
+	batch->auto_batch = auto_batch;
+	auto_batch->thread = g_thread_new("julea-auto-batch", j_batch_auto_thread, batch);
+
+	return batch;
+}
+
+/**
+ * Creates a new batch for a semantics template.
+ *
+ * \code
+ * JBatch* batch;
+ *
+ * batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+ * \endcode
+ *
+ * \param template A semantics template.
+ *
+ * \return A new batch. Should be freed with j_batch_unref().
+ **/
+JBatch*
+	j_batch_new_for_template(JSemanticsTemplate template)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBatch* batch;
+	g_autoptr(JSemantics) semantics = NULL;
+
+	semantics = j_semantics_new(template);
+	batch = j_batch_new(semantics);
+
+	return batch;
+}
+
+/**
+ * Increases the batch's reference count.
+ *
+ * \param list A batch.
+ *
+ * \return The batch.
+ **/
+JBatch*
+j_batch_ref(JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(batch != NULL, NULL);
+
+	g_atomic_int_inc(&(batch->ref_count));
+
+	return batch;
+}
+
+/**
+ * Decreases the batch's reference count.
+ * When the reference count reaches zero, frees the memory allocated for the batch.
+ *
+ * \code
+ * \endcode
+ *
+ * \param batch A batch.
+ **/
+void
+j_batch_unref(JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(batch != NULL);
+
+	if (g_atomic_int_dec_and_test(&(batch->ref_count)))
+	{
+		if (batch->auto_batch != NULL)
+		{
+			j_batch_auto_free(batch);
+		}
+
+		if (batch->background_operation != NULL)
+		{
+			j_background_operation_unref(batch->background_operation);
+		}
+
+		if (batch->semantics != NULL)
+		{
+			j_semantics_unref(batch->semantics);
+		}
+
+		j_list_unref(batch->list);
+		j_statistics_free(batch->statistics);
+
+		g_slice_free(JBatch, batch);
+	}
+}
+
+/**
+ * Executes the batch parts of a given batch type.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param type An operation type.
+ * \param list A list of batch parts.
+ **/
+static gboolean
+j_batch_execute_same(JBatch* batch, JOperationExecFunc exec_func, JList* list)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JOperation* operation;
+	gboolean ret = FALSE;
+
+	operation = j_list_get_first(list);
+
+	if (operation == NULL)
+	{
+		return FALSE;
+	}
+
+	if (exec_func != NULL)
+	{
+		ret = exec_func(list, batch->semantics);
+	}
+
+	j_list_delete_all(list);
+
+	return ret;
+}
+
+/**
+ * Executes a chain of groups sequentially.
+ *
+ * \private
+ *
+ * \param data A chain.
+ *
+ * \return The chain.
+ **/
+static gpointer
+j_batch_execute_chain(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBatchChain* chain = data;
+
+	for (guint i = 0; i < chain->groups->len; i++)
+	{
+		JBatchGroup* group = g_ptr_array_index(chain->groups, i);
+
+		chain->ret = j_batch_execute_same(chain->batch, group->exec_func, group->list) && chain->ret;
+	}
+
+	return chain;
+}
+
+static void
+j_batch_chain_free(gpointer data)
+{
+	JBatchChain* chain = data;
+
+	for (guint i = 0; i < chain->groups->len; i++)
+	{
+		JBatchGroup* group = g_ptr_array_index(chain->groups, i);
+
+		j_list_unref(group->list);
+		g_free(group);
+	}
+
+	g_ptr_array_unref(chain->groups);
+	g_free(chain);
+}
+
+/**
+ * Executes independent chains in parallel and waits for all of them.
+ *
+ * \private
+ *
+ * \param chains An array of chains, will be emptied.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_batch_execute_chains(GPtrArray* chains)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	if (chains->len == 0)
+	{
+		return TRUE;
+	}
+
+	j_helper_execute_parallel(j_batch_execute_chain, chains->pdata, chains->len);
+
+	for (guint i = 0; i < chains->len; i++)
+	{
+		JBatchChain* chain = g_ptr_array_index(chains, i);
+
+		ret = chain->ret && ret;
+	}
+
+	g_ptr_array_set_size(chains, 0);
+
+	return ret;
+}
+
+/**
+ * Executes the batch's operations in relaxed order.
+ *
+ * Operations are regrouped by their type and key to produce batches that are as large as possible.
+ * The key identifies the object an operation works on, so operations with different keys are considered independent.
+ * Dependencies between operations with the same key are honored by only appending an operation to the latest group of its key.
+ * For example, create, write and delete operations on the same object are never reordered.
+ *
+ * The groups of each key form a chain that is executed sequentially, while the chains of different keys are executed in parallel.
+ * Operations without a key act as barriers, that is, all previous operations are finished before they are executed on their own.
+ *
+ * \private
+ *
+ * \param batch A batch.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_batch_execute_relaxed(JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GHashTable) key_chain = NULL;
+	g_autoptr(GPtrArray) chains = NULL;
+	g_autoptr(JListIterator) iterator = NULL;
+	gboolean ret;
+
+	iterator = j_list_iterator_new(batch->list);
+	key_chain = g_hash_table_new(NULL, NULL);
+	chains = g_ptr_array_new_with_free_func(j_batch_chain_free);
+	ret = (j_list_length(batch->list) > 0);
+
+	while (j_list_iterator_next(iterator))
+	{
+		JOperation* operation = j_list_iterator_get(iterator);
+		JBatchChain* chain = NULL;
+		JBatchGroup* group = NULL;
+
+		if (operation->key == NULL)
+		{
+			/* Do not move operations across this one. */
+			ret = j_batch_execute_chains(chains) && ret;
+			g_hash_table_remove_all(key_chain);
+		}
+		else
+		{
+			chain = g_hash_table_lookup(key_chain, operation->key);
+		}
+
+		if (chain == NULL)
+		{
+			chain = g_new(JBatchChain, 1);
+			chain->batch = batch;
+			chain->groups = g_ptr_array_new();
+			chain->ret = TRUE;
+			g_ptr_array_add(chains, chain);
+
+			if (operation->key != NULL)
+			{
+				g_hash_table_insert(key_chain, (gpointer)operation->key, chain);
+			}
+		}
+
+		if (chain->groups->len > 0)
+		{
+			group = g_ptr_array_index(chain->groups, chain->groups->len - 1);
+		}
+
+		/* Operations with the same key have to keep their order, so we can only join the key's latest group. */
+		if (group == NULL || group->exec_func != operation->exec_func)
+		{
+			group = g_new(JBatchGroup, 1);
+			group->exec_func = operation->exec_func;
+			group->list = j_list_new(NULL);
+			g_ptr_array_add(chain->groups, group);
+		}
+
+		j_list_append(group->list, operation->data);
+
+		if (operation->key == NULL)
+		{
+			ret = j_batch_execute_chains(chains) && ret;
+		}
+	}
+
+	ret = j_batch_execute_chains(chains) && ret;
+
+	return ret;
+}
+
+/**
+ * Executes the batch.
+ * The operations of batches created with j_batch_new_auto() are only queued for execution.
+ *
+ * \code
+ * \endcode
+ *
+ * \param batch A batch.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+gboolean
+j_batch_execute(JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	if (batch->auto_batch != NULL)
+	{
+		return TRUE;
+	}
+
+	if (j_list_length(batch->list) == 0)
+	{
+		return FALSE;
+	}
+
+	if (j_semantics_get(batch->semantics, J_SEMANTICS_PERSISTENCY) == J_SEMANTICS_PERSISTENCY_EVENTUAL
+	    && j_operation_cache_add(batch))
+	{
+		return TRUE;
+	}
+
+	j_operation_cache_flush();
+
+	ret = j_batch_execute_internal(batch);
+	j_list_delete_all(batch->list);
+
+	return ret;
+}
+
+/**
+ * Executes the batch asynchronously.
+ *
+ * \code
+ * \endcode
+ *
+ * \param batch     A batch.
+ * \param callback  An async callback.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+void
+j_batch_execute_async(JBatch* batch, JBatchAsyncCallback callback, gpointer user_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBatchAsync* async;
+
+	g_return_if_fail(batch != NULL);
+	g_return_if_fail(batch->background_operation == NULL);
+	g_return_if_fail(batch->auto_batch == NULL);
+
+	async = g_slice_new(JBatchAsync);
+	async->batch = j_batch_ref(batch);
+	async->callback = callback;
+	async->user_data = user_data;
+
+	batch->queued_time = g_get_monotonic_time();
+	batch->background_operation = j_background_operation_new(j_batch_background_operation, async);
+}
+
+/**
+ * Executes the batch and returns a future for its result.
+ * For batches created with j_batch_new_auto(), the future covers the operations accumulated so far and completes once they have been executed.
+ * For other batches, the batch is executed right away.
+ *
+ * \code
+ * \endcode
+ *
+ * \param batch A batch.
+ *
+ * \return A future. Should be freed with j_batch_future_unref().
+ **/
+JBatchFuture*
+j_batch_execute_future(JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBatchFuture* future = NULL;
+
+	g_return_val_if_fail(batch != NULL, NULL);
+
+	if (batch->auto_batch != NULL)
+	{
+		future = j_batch_auto_get_future(batch, FALSE);
+	}
+
+	if (future == NULL)
+	{
+		future = j_batch_future_new();
+		j_batch_future_complete(future, (batch->auto_batch == NULL) ? j_batch_execute(batch) : FALSE);
+	}
+
+	return future;
+}
+
+/**
+ * Waits for the batch's asynchronous execution.
+ * For batches created with j_batch_new_auto(), executes the accumulated operations right away and waits for them.
+ *
+ * \code
+ * \endcode
+ *
+ * \param batch A batch.
+ **/
+void
+j_batch_wait(JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(batch != NULL);
+
+	if (batch->auto_batch != NULL)
+	{
+		g_autoptr(JBatchFuture) future = NULL;
+
+		if ((future = j_batch_auto_get_future(batch, TRUE)) != NULL)
+		{
+			j_batch_future_wait(future);
+		}
+	}
+
+	if (batch->background_operation != NULL)
+	{
+		j_background_operation_wait(batch->background_operation);
+		j_background_operation_unref(batch->background_operation);
+		batch->background_operation = NULL;
+	}
+}
+
+/**
+ * Increases the future's reference count.
+ *
+ * \param future A future.
+ *
+ * \return The future.
+ **/
+JBatchFuture*
+j_batch_future_ref(JBatchFuture* future)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(future != NULL, NULL);
+
+	g_atomic_int_inc(&(future->ref_count));
+
+	return future;
+}
+
+/**
+ * Decreases the future's reference count.
+ * When the reference count reaches zero, frees the memory allocated for the future.
+ *
+ * \param future A future.
+ **/
+void
+j_batch_future_unref(JBatchFuture* future)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(future != NULL);
+
+	if (g_atomic_int_dec_and_test(&(future->ref_count)))
+	{
+		g_cond_clear(future->cond);
+		g_mutex_clear(future->mutex);
+
+		g_slice_free(JBatchFuture, future);
+	}
+}
+
+/**
+ * Checks whether the operations of a future have been executed without blocking.
+ *
+ * \code
+ * \endcode
+ *
+ * \param future A future.
+ * \param ret    Returns the result, or NULL.
+ *
+ * \return TRUE if the operations have been executed, FALSE otherwise.
+ **/
+gboolean
+j_batch_future_poll(JBatchFuture* future, gboolean* ret)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean done;
+
+	g_return_val_if_fail(future != NULL, FALSE);
+
+	g_mutex_lock(future->mutex);
+
+	done = future->done;
+
+	if (done && ret != NULL)
+	{
+		*ret = future->ret;
+	}
+
+	g_mutex_unlock(future->mutex);
+
+	return done;
+}
+
+/**
+ * Waits until the operations of a future have been executed.
+ *
+ * \code
+ * \endcode
+ *
+ * \param future A future.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+gboolean
+j_batch_future_wait(JBatchFuture* future)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(future != NULL, FALSE);
+
+	g_mutex_lock(future->mutex);
+
+	while (!future->done)
+	{
+		g_cond_wait(future->cond, future->mutex);
+	}
+
+	ret = future->ret;
+
+	g_mutex_unlock(future->mutex);
+
+	return ret;
+}
+
+/**
+ * Returns the batch's statistics.
+ *
+ * The statistics accumulate over all executions of the batch and contain the number of executions,
+ * the time spent queued, executing and on the network as well as the number of messages and bytes sent and received.
+ *
+ * \code
+ * \endcode
+ *
+ * \param batch A batch.
+ *
+ * \return The statistics, owned by the batch.
+ **/
+JStatistics*
+j_batch_get_statistics(JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(batch != NULL, NULL);
+
+	return batch->statistics;
+}
+
+/**
+ * Returns the statistics of all batches executed by this process.
+ *
+ * \code
+ * \endcode
+ *
+ * \return The statistics, should not be freed.
+ **/
+JStatistics*
+j_batch_get_global_statistics(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	static JStatistics* statistics = NULL;
+
+	if (g_once_init_enter(&statistics))
+	{
+		g_once_init_leave(&statistics, j_statistics_new(FALSE));
+	}
+
+	return statistics;
+}
+
+/**
+ * Creates a new completion queue for batches.
+ *
+ * Batches submitted to the queue are executed in the background by a single background operation per queue.
+ * Batches that have been submitted in the meantime are combined into one merged execution if their semantics match,
+ * which allows many small batches to share messages instead of occupying one thread each.
+ *
+ * \code
+ * g_autoptr(JBatchQueue) queue = NULL;
+ *
+ * queue = j_batch_queue_new();
+ * j_batch_queue_submit(queue, batch, NULL);
+ * j_batch_queue_wait(queue, 1);
+ * \endcode
+ *
+ * \return A new completion queue. Should be freed with j_batch_queue_unref().
+ **/
+JBatchQueue*
+j_batch_queue_new(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBatchQueue* queue;
+
+	queue = g_slice_new(JBatchQueue);
+	g_queue_init(queue->submitted);
+	g_queue_init(queue->completed);
+	queue->draining = FALSE;
+	queue->ref_count = 1;
+
+	g_mutex_init(queue->mutex);
+	g_cond_init(queue->cond);
+
+	return queue;
+}
+
+/**
+ * Increases the completion queue's reference count.
+ *
+ * \param queue A completion queue.
+ *
+ * \return The completion queue.
+ **/
+JBatchQueue*
+j_batch_queue_ref(JBatchQueue* queue)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(queue != NULL, NULL);
 
-	ret = j_batch_execute(async->batch);
+	g_atomic_int_inc(&(queue->ref_count));
 
-	if (async->callback != NULL)
-	{
-		(*async->callback)(async->batch, ret, async->user_data);
-	}
+	return queue;
+}
 
-	j_batch_unref(async->batch);
+static void
+j_batch_queue_entry_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	g_slice_free(JBatchAsync, async);
+	JBatchQueueEntry* entry = data;
 
-	return NULL;
+	j_batch_unref(entry->batch);
+	g_slice_free(JBatchQueueEntry, entry);
 }
 
 /**
- * Creates a new batch.
- *
- * \code
- * \endcode
- *
- * \param semantics A semantics object.
+ * Decreases the completion queue's reference count.
+ * When the reference count reaches zero, frees the memory allocated for the completion queue.
+ * Completions that have not been retrieved are discarded.
  *
- * \return A new batch. Should be freed with j_batch_unref().
+ * \param queue A completion queue.
  **/
-JBatch*
-j_batch_new(JSemantics* semantics)
+void
+j_batch_queue_unref(JBatchQueue* queue)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JBatch* batch;
+	g_return_if_fail(queue != NULL);
 
-	g_return_val_if_fail(semantics != NULL, NULL);
+	if (g_atomic_int_dec_and_test(&(queue->ref_count)))
+	{
+		// The background operation holds a reference, so no batches can be left.
+		g_assert(g_queue_is_empty(queue->submitted));
 
-	batch = g_slice_new(JBatch);
-	batch->list = j_list_new((JListFreeFunc)j_operation_free);
-	batch->semantics = j_semantics_ref(semantics);
-	batch->background_operation = NULL;
-	batch->ref_count = 1;
+		g_queue_clear_full(queue->completed, j_batch_queue_entry_free);
 
-	return batch;
+		g_cond_clear(queue->cond);
+		g_mutex_clear(queue->mutex);
+
+		g_slice_free(JBatchQueue, queue);
+	}
 }
 
 /**
- * Creates a new batch for a semantics template.
- *
- * \code
- * JBatch* batch;
- *
- * batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
- * \endcode
- *
- * \param template A semantics template.
+ * Checks whether batches can be combined into one execution.
  *
- * \return A new batch. Should be freed with j_batch_unref().
+ * \private
  **/
-JBatch*
-	j_batch_new_for_template(JSemanticsTemplate template)
+static gboolean
+j_batch_queue_can_merge(JBatch* batch, JBatch* other)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JBatch* batch;
-	g_autoptr(JSemantics) semantics = NULL;
+	JSemanticsType const types[] = {
+		J_SEMANTICS_ATOMICITY,
+		J_SEMANTICS_CONCURRENCY,
+		J_SEMANTICS_CONSISTENCY,
+		J_SEMANTICS_ORDERING,
+		J_SEMANTICS_PERSISTENCY,
+		J_SEMANTICS_SAFETY,
+		J_SEMANTICS_SECURITY
+	};
+
+	// Merging would make batches atomic together and cached batches take over the operation list.
+	if (j_semantics_get(batch->semantics, J_SEMANTICS_ATOMICITY) == J_SEMANTICS_ATOMICITY_BATCH
+	    || j_semantics_get(batch->semantics, J_SEMANTICS_PERSISTENCY) == J_SEMANTICS_PERSISTENCY_EVENTUAL)
+	{
+		return FALSE;
+	}
 
-	semantics = j_semantics_new(template);
-	batch = j_batch_new(semantics);
+	for (guint i = 0; i < G_N_ELEMENTS(types); i++)
+	{
+		if (j_semantics_get(batch->semantics, types[i]) != j_semantics_get(other->semantics, types[i]))
+		{
+			return FALSE;
+		}
+	}
 
-	return batch;
+	return TRUE;
 }
 
 /**
- * Increases the batch's reference count.
+ * Executes a run of batches with matching semantics as one batch.
  *
- * \param list A batch.
+ * \private
  *
- * \return The batch.
+ * \param entries An array of #JBatchQueueEntry elements.
  **/
-JBatch*
-j_batch_ref(JBatch* batch)
+static void
+j_batch_queue_execute_merged(GPtrArray* entries)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	g_return_val_if_fail(batch != NULL, NULL);
+	JBatchQueueEntry* first;
+	JBatch* merged;
+	gint64 start_time;
+	gboolean ret;
 
-	g_atomic_int_inc(&(batch->ref_count));
+	first = g_ptr_array_index(entries, 0);
+	start_time = g_get_monotonic_time();
 
-	return batch;
+	if (entries->len == 1)
+	{
+		first->ret = j_batch_execute(first->batch);
+		return;
+	}
+
+	merged = j_batch_new(first->batch->semantics);
+
+	// The operations stay owned by their batches.
+	j_list_unref(merged->list);
+	merged->list = j_list_new(NULL);
+
+	for (guint i = 0; i < entries->len; i++)
+	{
+		JBatchQueueEntry* entry = g_ptr_array_index(entries, i);
+		g_autoptr(JListIterator) iterator = NULL;
+
+		iterator = j_list_iterator_new(entry->batch->list);
+
+		while (j_list_iterator_next(iterator))
+		{
+			j_list_append(merged->list, j_list_iterator_get(iterator));
+		}
+	}
+
+	ret = j_batch_execute(merged);
+	j_batch_unref(merged);
+
+	for (guint i = 0; i < entries->len; i++)
+	{
+		JBatchQueueEntry* entry = g_ptr_array_index(entries, i);
+
+		// Individual results are not known for merged batches.
+		entry->ret = ret;
+		j_list_delete_all(entry->batch->list);
+
+		j_statistics_add(entry->batch->statistics, J_STATISTICS_BATCHES, 1);
+		j_statistics_add(entry->batch->statistics, J_STATISTICS_BATCH_QUEUE_TIME, start_time - entry->batch->queued_time);
+		entry->batch->queued_time = 0;
+	}
 }
 
-/**
- * Decreases the batch's reference count.
- * When the reference count reaches zero, frees the memory allocated for the batch.
- *
- * \code
- * \endcode
- *
- * \param batch A batch.
- **/
-void
-j_batch_unref(JBatch* batch)
+static gpointer
+j_batch_queue_drain(gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	g_return_if_fail(batch != NULL);
+	JBatchQueue* queue = data;
 
-	if (g_atomic_int_dec_and_test(&(batch->ref_count)))
+	while (TRUE)
 	{
-		if (batch->background_operation != NULL)
+		g_autoptr(GPtrArray) run = NULL;
+		GQueue entries;
+
+		g_mutex_lock(queue->mutex);
+
+		if (g_queue_is_empty(queue->submitted))
 		{
-			j_background_operation_unref(batch->background_operation);
+			queue->draining = FALSE;
+			g_mutex_unlock(queue->mutex);
+			break;
 		}
 
-		if (batch->semantics != NULL)
+		// Take over all batches that have been submitted so far.
+		entries = *(queue->submitted);
+		g_queue_init(queue->submitted);
+
+		g_mutex_unlock(queue->mutex);
+
+		run = g_ptr_array_new();
+
+		for (GList* link = entries.head; link != NULL; link = link->next)
 		{
-			j_semantics_unref(batch->semantics);
+			JBatchQueueEntry* entry = link->data;
+
+			if (run->len > 0 && !j_batch_queue_can_merge(((JBatchQueueEntry*)g_ptr_array_index(run, 0))->batch, entry->batch))
+			{
+				j_batch_queue_execute_merged(run);
+				g_ptr_array_set_size(run, 0);
+			}
+
+			g_ptr_array_add(run, entry);
 		}
 
-		j_list_unref(batch->list);
+		j_batch_queue_execute_merged(run);
 
-		g_slice_free(JBatch, batch);
+		g_mutex_lock(queue->mutex);
+
+		for (GList* link = entries.head; link != NULL; link = link->next)
+		{
+			g_queue_push_tail(queue->completed, link->data);
+		}
+
+		g_cond_broadcast(queue->cond);
+		g_mutex_unlock(queue->mutex);
+
+		g_queue_clear(&entries);
 	}
+
+	j_batch_queue_unref(queue);
+
+	return NULL;
 }
 
 /**
- * Executes the batch parts of a given batch type.
- *
- * \private
+ * Submits a batch to a completion queue.
+ * The batch must not be modified until its completion has been retrieved.
  *
  * \code
  * \endcode
  *
- * \param type An operation type.
- * \param list A list of batch parts.
+ * \param queue     A completion queue.
+ * \param batch     A batch.
+ * \param user_data User data returned with the batch's completion.
  **/
-static gboolean
-j_batch_execute_same(JBatch* batch, JOperationExecFunc exec_func, JList* list)
+void
+j_batch_queue_submit(JBatchQueue* queue, JBatch* batch, gpointer user_data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JOperation* operation;
-	gboolean ret = FALSE;
+	JBatchQueueEntry* entry;
+	gboolean start;
 
-	operation = j_list_get_first(list);
+	g_return_if_fail(queue != NULL);
+	g_return_if_fail(batch != NULL);
 
-	if (operation == NULL)
-	{
-		return FALSE;
-	}
+	entry = g_slice_new(JBatchQueueEntry);
+	entry->batch = j_batch_ref(batch);
+	entry->user_data = user_data;
+	entry->ret = FALSE;
 
-	if (exec_func != NULL)
-	{
-		ret = exec_func(list, batch->semantics);
-	}
+	batch->queued_time = g_get_monotonic_time();
 
-	j_list_delete_all(list);
+	g_mutex_lock(queue->mutex);
 
-	return ret;
+	g_queue_push_tail(queue->submitted, entry);
+
+	start = !queue->draining;
+	queue->draining = TRUE;
+
+	g_mutex_unlock(queue->mutex);
+
+	if (start)
+	{
+		j_background_operation_unref(j_background_operation_new(j_batch_queue_drain, j_batch_queue_ref(queue)));
+	}
 }
 
 /**
- * Executes the batch.
+ * Retrieves a completed batch without blocking.
  *
  * \code
  * \endcode
  *
- * \param batch A batch.
+ * \param queue     A completion queue.
+ * \param batch     Returns the batch, the caller takes over the queue's reference. Should be freed with j_batch_unref().
+ * \param ret       Returns the batch's result, or NULL.
+ * \param user_data Returns the user data given to j_batch_queue_submit(), or NULL.
  *
- * \return TRUE on success, FALSE if an error occurred.
+ * \return TRUE if a completion has been retrieved, FALSE otherwise.
  **/
 gboolean
-j_batch_execute(JBatch* batch)
+j_batch_queue_poll(JBatchQueue* queue, JBatch** batch, gboolean* ret, gpointer* user_data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gboolean ret;
+	JBatchQueueEntry* entry;
 
+	g_return_val_if_fail(queue != NULL, FALSE);
 	g_return_val_if_fail(batch != NULL, FALSE);
 
-	if (j_list_length(batch->list) == 0)
+	g_mutex_lock(queue->mutex);
+	entry = g_queue_pop_head(queue->completed);
+	g_mutex_unlock(queue->mutex);
+
+	if (entry == NULL)
 	{
 		return FALSE;
 	}
 
-	if (j_semantics_get(batch->semantics, J_SEMANTICS_PERSISTENCY) == J_SEMANTICS_PERSISTENCY_EVENTUAL
-	    && j_operation_cache_add(batch))
+	*batch = entry->batch;
+
+	if (ret != NULL)
 	{
-		return TRUE;
+		*ret = entry->ret;
 	}
 
-	j_operation_cache_flush();
+	if (user_data != NULL)
+	{
+		*user_data = entry->user_data;
+	}
 
-	ret = j_batch_execute_internal(batch);
-	j_list_delete_all(batch->list);
+	g_slice_free(JBatchQueueEntry, entry);
 
-	return ret;
+	return TRUE;
 }
 
 /**
- * Executes the batch asynchronously.
+ * Waits until a number of completions can be retrieved.
+ * Returns early if fewer batches are outstanding.
  *
  * \code
  * \endcode
  *
- * \param batch     A batch.
- * \param callback  An async callback.
+ * \param queue A completion queue.
+ * \param count The number of completions to wait for.
  *
- * \return TRUE on success, FALSE if an error occurred.
+ * \return The number of completions that can be retrieved using j_batch_queue_poll().
  **/
-void
-j_batch_execute_async(JBatch* batch, JBatchAsyncCallback callback, gpointer user_data)
+guint
+j_batch_queue_wait(JBatchQueue* queue, guint count)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JBatchAsync* async;
+	guint ret;
 
-	g_return_if_fail(batch != NULL);
-	g_return_if_fail(batch->background_operation == NULL);
+	g_return_val_if_fail(queue != NULL, 0);
 
-	async = g_slice_new(JBatchAsync);
-	async->batch = j_batch_ref(batch);
-	async->callback = callback;
-	async->user_data = user_data;
+	g_mutex_lock(queue->mutex);
 
-	batch->background_operation = j_background_operation_new(j_batch_background_operation, async);
-}
+	// While draining, batches are neither submitted nor completed.
+	while (g_queue_get_length(queue->completed) < count && queue->draining)
+	{
+		g_cond_wait(queue->cond, queue->mutex);
+	}
 
-void
-j_batch_wait(JBatch* batch)
-{
-	J_TRACE_FUNCTION(NULL);
+	ret = g_queue_get_length(queue->completed);
 
-	g_return_if_fail(batch != NULL);
+	g_mutex_unlock(queue->mutex);
 
-	if (batch->background_operation != NULL)
-	{
-		j_background_operation_wait(batch->background_operation);
-		j_background_operation_unref(batch->background_operation);
-		batch->background_operation = NULL;
-	}
+	return ret;
 }
 
 /* Internal */
@@ -352,6 +1609,9 @@ j_batch_new_from_batch(JBatch* old_batch)
 	batch->list = old_batch->list;
 	batch->semantics = j_semantics_ref(old_batch->semantics);
 	batch->background_operation = NULL;
+	batch->auto_batch = NULL;
+	batch->statistics = j_statistics_new(FALSE);
+	batch->queued_time = 0;
 	batch->ref_count = 1;
 
 	old_batch->list = j_list_new((JListFreeFunc)j_operation_free);
@@ -422,23 +1682,27 @@ j_batch_add(JBatch* batch, JOperation* operation)
 	g_return_if_fail(batch != NULL);
 	g_return_if_fail(operation != NULL);
 
+	if (batch->auto_batch != NULL)
+	{
+		j_batch_auto_add(batch, operation);
+		return;
+	}
+
 	j_list_append(batch->list, operation);
 }
 
 /**
- * Executes the batch.
+ * Executes the batch's operations in order.
+ * Consecutive operations of the same type and key are combined.
  *
  * \private
  *
- * \code
- * \endcode
- *
  * \param batch A batch.
  *
  * \return TRUE on success, FALSE if an error occurred.
  **/
-gboolean
-j_batch_execute_internal(JBatch* batch)
+static gboolean
+j_batch_execute_ordered(JBatch* batch)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -453,16 +1717,6 @@ j_batch_execute_internal(JBatch* batch)
 	last_key = NULL;
 	last_exec_func = NULL;
 
-	if (j_semantics_get(batch->semantics, J_SEMANTICS_ORDERING) == J_SEMANTICS_ORDERING_RELAXED)
-	{
-		/* FIXME: perform some optimizations */
-		/**
-		 * It is important to consider dependencies:
-		 * - Operations have to be performed before their dependent ones.
-		 *   For example, a collection has to be created before items in it can be created.
-		 */
-	}
-
 	/**
 	 * Try to combine as many operations of the same type as possible.
 	 * These are temporarily stored in same_list.
@@ -487,6 +1741,83 @@ j_batch_execute_internal(JBatch* batch)
 	return ret;
 }
 
+/**
+ * Executes the batch.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param batch A batch.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+gboolean
+j_batch_execute_internal(JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JStatistics* previous;
+	guint64 before[G_N_ELEMENTS(j_batch_statistics_types)];
+	gint64 start_time;
+	gboolean ret;
+
+	for (guint i = 0; i < G_N_ELEMENTS(j_batch_statistics_types); i++)
+	{
+		before[i] = j_statistics_get(batch->statistics, j_batch_statistics_types[i]);
+	}
+
+	start_time = g_get_monotonic_time();
+
+	if (batch->queued_time > 0)
+	{
+		j_statistics_add(batch->statistics, J_STATISTICS_BATCH_QUEUE_TIME, start_time - batch->queued_time);
+		batch->queued_time = 0;
+	}
+
+	previous = j_statistics_set_current(batch->statistics);
+
+	if (j_semantics_get(batch->semantics, J_SEMANTICS_ATOMICITY) == J_SEMANTICS_ATOMICITY_BATCH)
+	{
+		JTransaction* transaction;
+		JTransaction* previous_transaction;
+
+		// The transaction is thread-local, so all operations have to be executed by this thread.
+		transaction = j_transaction_new();
+		previous_transaction = j_transaction_set_current(transaction);
+
+		ret = j_batch_execute_ordered(batch);
+
+		j_transaction_set_current(previous_transaction);
+		ret = j_transaction_finish(transaction, batch->semantics, ret);
+		j_transaction_free(transaction);
+	}
+	else if (j_semantics_get(batch->semantics, J_SEMANTICS_ORDERING) == J_SEMANTICS_ORDERING_RELAXED)
+	{
+		ret = j_batch_execute_relaxed(batch);
+	}
+	else
+	{
+		ret = j_batch_execute_ordered(batch);
+	}
+
+	j_statistics_set_current(previous);
+
+	j_statistics_add(batch->statistics, J_STATISTICS_BATCHES, 1);
+	j_statistics_add(batch->statistics, J_STATISTICS_BATCH_EXECUTION_TIME, g_get_monotonic_time() - start_time);
+
+	for (guint i = 0; i < G_N_ELEMENTS(j_batch_statistics_types); i++)
+	{
+		guint64 value;
+
+		value = j_statistics_get(batch->statistics, j_batch_statistics_types[i]);
+		j_statistics_add(j_batch_get_global_statistics(), j_batch_statistics_types[i], value - before[i]);
+	}
+
+	return ret;
+}
+
 /**
  * @}
  **/
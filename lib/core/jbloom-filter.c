@@ -0,0 +1,369 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <jbloom-filter.h>
+
+#include <jtrace.h>
+
+/**
+ * \defgroup JBloomFilter Bloom Filter
+ *
+ * Bloom filters answer whether a key might be contained in a set.
+ * They never report contained keys as absent but can report absent keys as contained.
+ *
+ * The filters are not thread-safe, concurrent modifications have to be synchronized by the caller.
+ *
+ * @{
+ **/
+
+/**
+ * A Bloom filter.
+ **/
+struct JBloomFilter
+{
+	/**
+	 * The bits, rounded up to whole blocks.
+	 **/
+	guint64* words;
+	guint64 bits;
+
+	/**
+	 * The number of bits set per key.
+	 **/
+	guint hashes;
+
+	/**
+	 * The number of modifications and, per block, the modification that changed it last.
+	 **/
+	guint64 version;
+	guint64* versions;
+};
+
+/**
+ * Hashes a key using 64-bit FNV-1a.
+ * The two halves of the hash are combined to derive the positions of all bits (double hashing).
+ *
+ * \private
+ **/
+static guint64
+j_bloom_filter_hash(gchar const* key)
+{
+	guint64 hash = G_GUINT64_CONSTANT(14695981039346656037);
+
+	for (gchar const* c = key; *c != '\0'; c++)
+	{
+		hash ^= (guchar)*c;
+		hash *= G_GUINT64_CONSTANT(1099511628211);
+	}
+
+	return hash;
+}
+
+/**
+ * Creates a new Bloom filter.
+ * With ten bits per expected key and seven hashes, about one percent of absent keys are reported as contained.
+ *
+ * \code
+ * g_autoptr(JBloomFilter) filter = NULL;
+ *
+ * filter = j_bloom_filter_new(1024 * 1024, 7);
+ * j_bloom_filter_add(filter, "key");
+ * \endcode
+ *
+ * \param bits   The number of bits, rounded up to whole blocks.
+ * \param hashes The number of bits set per key.
+ *
+ * \return A new Bloom filter. Should be freed with j_bloom_filter_free().
+ **/
+JBloomFilter*
+j_bloom_filter_new(guint64 bits, guint hashes)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBloomFilter* filter;
+	guint64 block_bits = J_BLOOM_FILTER_BLOCK_WORDS * 64;
+
+	g_return_val_if_fail(bits > 0, NULL);
+	g_return_val_if_fail(hashes > 0, NULL);
+
+	filter = g_slice_new(JBloomFilter);
+	filter->bits = (bits + block_bits - 1) / block_bits * block_bits;
+	filter->hashes = hashes;
+	filter->words = g_new0(guint64, filter->bits / 64);
+	filter->version = 0;
+	filter->versions = g_new0(guint64, filter->bits / block_bits);
+
+	return filter;
+}
+
+/**
+ * Frees the memory allocated for the Bloom filter.
+ *
+ * \param filter A Bloom filter.
+ **/
+void
+j_bloom_filter_free(JBloomFilter* filter)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(filter != NULL);
+
+	g_free(filter->words);
+	g_free(filter->versions);
+
+	g_slice_free(JBloomFilter, filter);
+}
+
+/**
+ * Adds a key to the Bloom filter.
+ *
+ * \code
+ * \endcode
+ *
+ * \param filter A Bloom filter.
+ * \param key    A key.
+ *
+ * \return TRUE if the filter has been modified, FALSE if the key's bits were set already.
+ **/
+gboolean
+j_bloom_filter_add(JBloomFilter* filter, gchar const* key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 hash;
+	guint64 hash1;
+	guint64 hash2;
+	guint64 version;
+
+	g_return_val_if_fail(filter != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+
+	hash = j_bloom_filter_hash(key);
+	hash1 = hash & 0xffffffff;
+	hash2 = (hash >> 32) | 1;
+	version = filter->version + 1;
+
+	for (guint i = 0; i < filter->hashes; i++)
+	{
+		guint64 bit;
+		guint64 mask;
+
+		bit = (hash1 + i * hash2) % filter->bits;
+		mask = G_GUINT64_CONSTANT(1) << (bit % 64);
+
+		if ((filter->words[bit / 64] & mask) == 0)
+		{
+			filter->words[bit / 64] |= mask;
+			filter->versions[bit / 64 / J_BLOOM_FILTER_BLOCK_WORDS] = version;
+			filter->version = version;
+		}
+	}
+
+	return (filter->version == version);
+}
+
+/**
+ * Checks whether a key might be contained in the Bloom filter.
+ *
+ * \code
+ * \endcode
+ *
+ * \param filter A Bloom filter.
+ * \param key    A key.
+ *
+ * \return FALSE if the key is definitely absent, TRUE if it might be contained.
+ **/
+gboolean
+j_bloom_filter_contains(JBloomFilter const* filter, gchar const* key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 hash;
+	guint64 hash1;
+	guint64 hash2;
+
+	g_return_val_if_fail(filter != NULL, TRUE);
+	g_return_val_if_fail(key != NULL, TRUE);
+
+	hash = j_bloom_filter_hash(key);
+	hash1 = hash & 0xffffffff;
+	hash2 = (hash >> 32) | 1;
+
+	for (guint i = 0; i < filter->hashes; i++)
+	{
+		guint64 bit;
+
+		bit = (hash1 + i * hash2) % filter->bits;
+
+		if ((filter->words[bit / 64] & (G_GUINT64_CONSTANT(1) << (bit % 64))) == 0)
+		{
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Removes all keys from the Bloom filter.
+ *
+ * \param filter A Bloom filter.
+ **/
+void
+j_bloom_filter_clear(JBloomFilter* filter)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(filter != NULL);
+
+	memset(filter->words, 0, filter->bits / 8);
+
+	// Cleared blocks count as modified, so that copies are updated
+	filter->version++;
+
+	for (guint64 i = 0; i < j_bloom_filter_get_blocks(filter); i++)
+	{
+		filter->versions[i] = filter->version;
+	}
+}
+
+/**
+ * Returns the Bloom filter's number of bits.
+ *
+ * \param filter A Bloom filter.
+ *
+ * \return The number of bits.
+ **/
+guint64
+j_bloom_filter_get_bits(JBloomFilter const* filter)
+{
+	g_return_val_if_fail(filter != NULL, 0);
+
+	return filter->bits;
+}
+
+/**
+ * Returns the Bloom filter's number of bits set per key.
+ *
+ * \param filter A Bloom filter.
+ *
+ * \return The number of hashes.
+ **/
+guint
+j_bloom_filter_get_hashes(JBloomFilter const* filter)
+{
+	g_return_val_if_fail(filter != NULL, 0);
+
+	return filter->hashes;
+}
+
+/**
+ * Returns the Bloom filter's number of blocks.
+ *
+ * \param filter A Bloom filter.
+ *
+ * \return The number of blocks of #J_BLOOM_FILTER_BLOCK_WORDS words.
+ **/
+guint64
+j_bloom_filter_get_blocks(JBloomFilter const* filter)
+{
+	g_return_val_if_fail(filter != NULL, 0);
+
+	return filter->bits / 64 / J_BLOOM_FILTER_BLOCK_WORDS;
+}
+
+/**
+ * Returns the Bloom filter's version, which is increased by every modification.
+ *
+ * \param filter A Bloom filter.
+ *
+ * \return The version.
+ **/
+guint64
+j_bloom_filter_get_version(JBloomFilter const* filter)
+{
+	g_return_val_if_fail(filter != NULL, 0);
+
+	return filter->version;
+}
+
+/**
+ * Returns the version of the modification that changed a block of the Bloom filter last.
+ * Copies of the filter can be brought up to date by transferring the blocks with a version higher than the copy's.
+ *
+ * \param filter A Bloom filter.
+ * \param block  A block.
+ *
+ * \return The block's version, 0 if it has never been modified.
+ **/
+guint64
+j_bloom_filter_get_block_version(JBloomFilter const* filter, guint64 block)
+{
+	g_return_val_if_fail(filter != NULL, 0);
+	g_return_val_if_fail(block < j_bloom_filter_get_blocks(filter), 0);
+
+	return filter->versions[block];
+}
+
+/**
+ * Returns a block of the Bloom filter, for example, to send it to another process.
+ *
+ * \param filter A Bloom filter.
+ * \param block  A block.
+ *
+ * \return The block's #J_BLOOM_FILTER_BLOCK_WORDS words, owned by the filter.
+ **/
+guint64 const*
+j_bloom_filter_get_block(JBloomFilter const* filter, guint64 block)
+{
+	g_return_val_if_fail(filter != NULL, NULL);
+	g_return_val_if_fail(block < j_bloom_filter_get_blocks(filter), NULL);
+
+	return filter->words + block * J_BLOOM_FILTER_BLOCK_WORDS;
+}
+
+/**
+ * Replaces a block of the Bloom filter.
+ *
+ * \param filter A Bloom filter.
+ * \param block  A block.
+ * \param words  The block's #J_BLOOM_FILTER_BLOCK_WORDS words.
+ **/
+void
+j_bloom_filter_set_block(JBloomFilter* filter, guint64 block, guint64 const* words)
+{
+	g_return_if_fail(filter != NULL);
+	g_return_if_fail(block < j_bloom_filter_get_blocks(filter));
+	g_return_if_fail(words != NULL);
+
+	memcpy(filter->words + block * J_BLOOM_FILTER_BLOCK_WORDS, words, J_BLOOM_FILTER_BLOCK_WORDS * sizeof(guint64));
+}
+
+/**
+ * @}
+ **/
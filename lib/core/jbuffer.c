@@ -0,0 +1,348 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#include <jbuffer.h>
+
+#include <jhelper.h>
+#include <jtrace.h>
+
+/**
+ * \defgroup JBuffer Buffer
+ *
+ * Buffers are aligned memory regions taken from a pool.
+ * Operations recognize data that lies within a buffer and reference the buffer instead of copying the data,
+ * for example, when a batch is executed asynchronously or its operations are cached.
+ * Data written from a buffer must therefore not be modified until the write has completed; freeing the buffer is always safe.
+ *
+ * @{
+ **/
+
+/**
+ * The size of a transparent huge page.
+ **/
+#define J_BUFFER_HUGEPAGE_SIZE (2 * 1024 * 1024)
+
+/**
+ * The maximum number of bytes kept in the pool of unused buffers.
+ **/
+#define J_BUFFER_POOL_LIMIT (256 * 1024 * 1024)
+
+/**
+ * The number of size classes, one per power of two.
+ **/
+#define J_BUFFER_CLASSES 64
+
+/**
+ * A buffer.
+ **/
+struct JBuffer
+{
+	/**
+	 * The data, aligned to at least #J_BUFFER_ALIGNMENT bytes.
+	 **/
+	gchar* data;
+
+	/**
+	 * The size, rounded up to the buffer's size class.
+	 **/
+	guint64 size;
+
+	/**
+	 * Whether the data is backed by huge pages.
+	 **/
+	gboolean hugepages;
+
+	gint ref_count;
+};
+
+typedef struct JBuffer JBuffer;
+
+/**
+ * Contains all buffers in use, sorted by address.
+ * Protected by j_buffer_mutex, like the pool.
+ **/
+static GTree* j_buffer_registry = NULL;
+
+/**
+ * Unused buffers per huge page setting and size class.
+ **/
+static GQueue j_buffer_pool[2][J_BUFFER_CLASSES];
+static guint64 j_buffer_pool_size = 0;
+
+static GMutex j_buffer_mutex;
+
+static gint
+j_buffer_compare(gconstpointer a, gconstpointer b)
+{
+	JBuffer const* buffer_a = a;
+	JBuffer const* buffer_b = b;
+
+	if (buffer_a->data < buffer_b->data)
+	{
+		return -1;
+	}
+	else if (buffer_a->data > buffer_b->data)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Checks whether a buffer contains an address.
+ *
+ * \private
+ **/
+static gint
+j_buffer_search(gconstpointer key, gconstpointer data)
+{
+	JBuffer const* buffer = key;
+	gchar const* address = data;
+
+	if (address < buffer->data)
+	{
+		return -1;
+	}
+	else if (address >= buffer->data + buffer->size)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+static void
+j_buffer_free_data(JBuffer* buffer)
+{
+	// j_helper_alloc_aligned() uses aligned_alloc().
+	free(buffer->data);
+	g_slice_free(JBuffer, buffer);
+}
+
+/**
+ * Allocates a new buffer from the pool.
+ * The buffer's contents are undefined.
+ * Buffers of at least 2 MiB can be backed by transparent huge pages, which reduces TLB misses for large transfers.
+ *
+ * \code
+ * gpointer buffer;
+ *
+ * buffer = j_buffer_new(1024 * 1024, FALSE);
+ * j_object_write(object, buffer, 1024 * 1024, 0, &bytes_written, batch);
+ * j_batch_execute(batch);
+ * j_buffer_free(buffer);
+ * \endcode
+ *
+ * \param size      The size.
+ * \param hugepages Whether the buffer should be backed by huge pages.
+ *
+ * \return The buffer's data, aligned to at least #J_BUFFER_ALIGNMENT bytes. Should be freed with j_buffer_free().
+ **/
+gpointer
+j_buffer_new(guint64 size, gboolean hugepages)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBuffer* buffer;
+	guint64 class_size;
+	guint size_class;
+
+	g_return_val_if_fail(size > 0, NULL);
+
+	// Huge pages only pay off for large buffers, smaller ones would waste most of a page.
+	hugepages = (hugepages && size >= J_BUFFER_HUGEPAGE_SIZE);
+
+	class_size = MAX(size, J_BUFFER_ALIGNMENT);
+	size_class = g_bit_storage(class_size - 1);
+	class_size = G_GUINT64_CONSTANT(1) << size_class;
+
+	g_mutex_lock(&j_buffer_mutex);
+
+	if (j_buffer_registry == NULL)
+	{
+		j_buffer_registry = g_tree_new(j_buffer_compare);
+	}
+
+	if ((buffer = g_queue_pop_head(&(j_buffer_pool[hugepages][size_class]))) != NULL)
+	{
+		j_buffer_pool_size -= buffer->size;
+	}
+
+	g_mutex_unlock(&j_buffer_mutex);
+
+	if (buffer == NULL)
+	{
+		buffer = g_slice_new(JBuffer);
+		buffer->size = class_size;
+		buffer->hugepages = hugepages;
+		buffer->data = j_helper_alloc_aligned((hugepages) ? J_BUFFER_HUGEPAGE_SIZE : J_BUFFER_ALIGNMENT, class_size);
+
+#ifdef MADV_HUGEPAGE
+		if (hugepages)
+		{
+			// This is only a hint, the kernel falls back to regular pages if no huge pages are available.
+			madvise(buffer->data, class_size, MADV_HUGEPAGE);
+		}
+#endif
+	}
+
+	buffer->ref_count = 1;
+
+	g_mutex_lock(&j_buffer_mutex);
+	g_tree_insert(j_buffer_registry, buffer, buffer);
+	g_mutex_unlock(&j_buffer_mutex);
+
+	return buffer->data;
+}
+
+/**
+ * Releases a reference to a buffer.
+ * Buffers are returned to the pool when their last reference has been released,
+ * so a buffer can be freed while operations using it are still pending.
+ *
+ * \param data A buffer's data, as returned by j_buffer_new() or j_buffer_ref().
+ **/
+void
+j_buffer_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBuffer* buffer;
+	JBuffer* evict = NULL;
+
+	g_return_if_fail(data != NULL);
+
+	g_mutex_lock(&j_buffer_mutex);
+
+	buffer = (j_buffer_registry != NULL) ? g_tree_search(j_buffer_registry, j_buffer_search, data) : NULL;
+
+	if (buffer == NULL || buffer->data != data)
+	{
+		g_mutex_unlock(&j_buffer_mutex);
+		g_return_if_reached();
+	}
+
+	if (--buffer->ref_count == 0)
+	{
+		g_tree_remove(j_buffer_registry, buffer);
+
+		if (j_buffer_pool_size + buffer->size <= J_BUFFER_POOL_LIMIT)
+		{
+			g_queue_push_head(&(j_buffer_pool[buffer->hugepages][g_bit_storage(buffer->size - 1)]), buffer);
+			j_buffer_pool_size += buffer->size;
+		}
+		else
+		{
+			evict = buffer;
+		}
+	}
+
+	g_mutex_unlock(&j_buffer_mutex);
+
+	if (evict != NULL)
+	{
+		j_buffer_free_data(evict);
+	}
+}
+
+/**
+ * Takes a reference to the buffer containing a memory region.
+ * This allows operations to use the data without copying it, even after the caller has freed the buffer.
+ *
+ * \param data   The start of the region.
+ * \param length The region's length.
+ *
+ * \return The buffer's data if the region lies completely within a buffer, NULL otherwise.
+ *         The reference should be released with j_buffer_free().
+ **/
+gpointer
+j_buffer_ref(gconstpointer data, guint64 length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBuffer* buffer = NULL;
+
+	if (data == NULL)
+	{
+		return NULL;
+	}
+
+	g_mutex_lock(&j_buffer_mutex);
+
+	if (j_buffer_registry != NULL && (buffer = g_tree_search(j_buffer_registry, j_buffer_search, data)) != NULL)
+	{
+		if ((gchar const*)data + length <= buffer->data + buffer->size)
+		{
+			buffer->ref_count++;
+		}
+		else
+		{
+			buffer = NULL;
+		}
+	}
+
+	g_mutex_unlock(&j_buffer_mutex);
+
+	return (buffer != NULL) ? buffer->data : NULL;
+}
+
+/**
+ * Returns a buffer's size.
+ * The size might be larger than requested, because buffers are allocated in powers of two.
+ *
+ * \param data A buffer's data.
+ *
+ * \return The size, 0 if the data does not belong to a buffer.
+ **/
+guint64
+j_buffer_get_size(gconstpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBuffer* buffer = NULL;
+	guint64 size = 0;
+
+	g_return_val_if_fail(data != NULL, 0);
+
+	g_mutex_lock(&j_buffer_mutex);
+
+	if (j_buffer_registry != NULL && (buffer = g_tree_search(j_buffer_registry, j_buffer_search, data)) != NULL && buffer->data == data)
+	{
+		size = buffer->size;
+	}
+
+	g_mutex_unlock(&j_buffer_mutex);
+
+	return size;
+}
+
+/**
+ * @}
+ **/
@@ -24,6 +24,7 @@
 
 #include <glib.h>
 
+#include <stdatomic.h>
 #include <string.h>
 
 #include <jcache.h>
@@ -37,6 +38,10 @@
 
 /**
  * A cache.
+ *
+ * The cache is a fixed region that is used as a ring buffer.
+ * Segments are handed out by atomically bumping #head and are reclaimed by advancing #tail when they are released.
+ * #head and #tail are positions that only grow, their difference is the amount of used space.
  */
 struct JCache
 {
@@ -45,11 +50,25 @@ struct JCache
 	*/
 	guint64 size;
 
-	GHashTable* buffers;
+	/**
+	 * The region segments are allocated from.
+	 */
+	gchar* region;
 
-	guint64 used;
+	/**
+	 * The end of the last allocated segment.
+	 */
+	_Atomic guint64 head;
 
-	GMutex mutex[1];
+	/**
+	 * The start of the first segment that has not been released yet.
+	 */
+	_Atomic guint64 tail;
+
+	/**
+	 * The maximum amount of space that has been used at once.
+	 */
+	_Atomic guint64 high_water_mark;
 };
 
 /**
@@ -76,10 +95,11 @@ j_cache_new(guint64 size)
 
 	cache = g_slice_new(JCache);
 	cache->size = size;
-	cache->buffers = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, NULL);
-	cache->used = 0;
+	cache->region = g_malloc(size);
 
-	g_mutex_init(cache->mutex);
+	atomic_init(&(cache->head), 0);
+	atomic_init(&(cache->tail), 0);
+	atomic_init(&(cache->high_water_mark), 0);
 
 	return cache;
 }
@@ -102,28 +122,17 @@ j_cache_free(JCache* cache)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	GHashTableIter iter[1];
-	gpointer key;
-	gpointer value;
-
 	g_return_if_fail(cache != NULL);
 
-	g_hash_table_iter_init(iter, cache->buffers);
-
-	while (g_hash_table_iter_next(iter, &key, &value))
-	{
-		g_free(key);
-	}
-
-	g_hash_table_unref(cache->buffers);
-
-	g_mutex_clear(cache->mutex);
+	g_free(cache->region);
 
 	g_slice_free(JCache, cache);
 }
 
 /**
  * Gets a new segment from the cache.
+ * Segments are contiguous, a segment that does not fit at the end of the region starts at its beginning.
+ * This function can be called from multiple threads concurrently.
  *
  * \code
  * JCache* cache;
@@ -143,52 +152,143 @@ j_cache_get(JCache* cache, guint64 length)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gpointer ret = NULL;
+	guint64 head;
+	guint64 tail;
+	guint64 start;
+	guint64 end;
+	guint64 used;
+	guint64 high_water_mark;
 
 	g_return_val_if_fail(cache != NULL, NULL);
+	g_return_val_if_fail(length > 0, NULL);
 
-	g_mutex_lock(cache->mutex);
-
-	if (cache->used + length > cache->size)
+	if (length > cache->size)
 	{
-		goto end;
+		return NULL;
 	}
 
-	ret = g_malloc(length);
-	cache->used += length;
+	head = atomic_load(&(cache->head));
 
-	g_hash_table_insert(cache->buffers, ret, GSIZE_TO_POINTER(length));
+	do
+	{
+		guint64 offset;
 
-end:
-	g_mutex_unlock(cache->mutex);
+		offset = head % cache->size;
+		start = head;
 
-	return ret;
+		// Skip the rest of the region if the segment does not fit.
+		if (offset + length > cache->size)
+		{
+			start += cache->size - offset;
+		}
+
+		end = start + length;
+		tail = atomic_load(&(cache->tail));
+		used = end - tail;
+
+		// The segment must not overlap unreleased segments, an empty cache can always be used.
+		if (used > cache->size && tail != head)
+		{
+			return NULL;
+		}
+
+		used = MIN(used, cache->size);
+	} while (!atomic_compare_exchange_weak(&(cache->head), &head, end));
+
+	high_water_mark = atomic_load(&(cache->high_water_mark));
+
+	while (used > high_water_mark && !atomic_compare_exchange_weak(&(cache->high_water_mark), &high_water_mark, used))
+	{
+	}
+
+	return cache->region + (start % cache->size);
 }
 
+/**
+ * Releases a segment.
+ * Segments have to be released in the order they have been acquired.
+ * Releasing a segment out of order is a programming error and is ignored with a critical warning.
+ *
+ * \attention Before JCache became a ring buffer, this function did not take the segment's length and segments could be released in any order.
+ *
+ * \code
+ * JCache* cache;
+ * gpointer data;
+ *
+ * data = j_cache_get(cache, 1024);
+ * ...
+ * j_cache_release(cache, data, 1024);
+ * \endcode
+ *
+ * \param cache  A cache.
+ * \param data   A segment returned by j_cache_get().
+ * \param length The segment's length.
+ **/
 void
-j_cache_release(JCache* cache, gpointer data)
+j_cache_release(JCache* cache, gpointer data, guint64 length)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gpointer size;
+	guint64 offset;
+	guint64 tail;
 
 	g_return_if_fail(cache != NULL);
 	g_return_if_fail(data != NULL);
+	g_return_if_fail((gchar*)data >= cache->region && (gchar*)data < cache->region + cache->size);
 
-	g_mutex_lock(cache->mutex);
+	offset = (gchar*)data - cache->region;
+	tail = atomic_load(&(cache->tail));
 
-	if ((size = g_hash_table_lookup(cache->buffers, data)) == NULL)
+	// The segment has been placed at the region's beginning, reclaim the skipped space.
+	if (tail % cache->size != offset)
 	{
-		g_warn_if_reached();
-		return;
+		tail += cache->size - (tail % cache->size);
 	}
 
-	g_hash_table_remove(cache->buffers, data);
+	g_return_if_fail(tail % cache->size == offset);
+	g_return_if_fail(tail + length <= atomic_load(&(cache->head)));
+
+	atomic_store(&(cache->tail), tail + length);
+}
+
+/**
+ * Returns the maximum amount of space that has been in use at once.
+ *
+ * \code
+ * \endcode
+ *
+ * \param cache A cache.
+ *
+ * \return The high-water mark in bytes.
+ **/
+guint64
+j_cache_get_high_water_mark(JCache* cache)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(cache != NULL, 0);
+
+	return atomic_load(&(cache->high_water_mark));
+}
+
+/**
+ * Returns the amount of space currently in use.
+ *
+ * \code
+ * \endcode
+ *
+ * \param cache A cache.
+ *
+ * \return The used space in bytes.
+ **/
+guint64
+j_cache_get_used(JCache* cache)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	cache->used -= GPOINTER_TO_SIZE(size);
-	g_free(data);
+	g_return_val_if_fail(cache != NULL, 0);
 
-	g_mutex_unlock(cache->mutex);
+	return atomic_load(&(cache->head)) - atomic_load(&(cache->tail));
 }
 
 /**
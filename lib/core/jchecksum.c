@@ -0,0 +1,425 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+
+#define J_CHECKSUM_SSE42
+#elif defined(__GNUC__) && defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+
+#define J_CHECKSUM_ARMV8
+#endif
+
+#include <jchecksum.h>
+
+#include <jtrace.h>
+
+/**
+ * \defgroup JChecksum Checksums
+ *
+ * Checksums for detecting corrupted data.
+ *
+ * @{
+ **/
+
+/**
+ * The reflected Castagnoli polynomial.
+ **/
+#define J_CHECKSUM_CRC32C_POLYNOMIAL 0x82f63b78
+
+/**
+ * The primes used by j_checksum_hash().
+ **/
+#define J_CHECKSUM_PRIME_1 G_GUINT64_CONSTANT(0x9e3779b185ebca87)
+#define J_CHECKSUM_PRIME_2 G_GUINT64_CONSTANT(0xc2b2ae3d27d4eb4f)
+#define J_CHECKSUM_PRIME_3 G_GUINT64_CONSTANT(0x165667b19e3779f9)
+#define J_CHECKSUM_PRIME_4 G_GUINT64_CONSTANT(0x85ebca77c2b2ae63)
+#define J_CHECKSUM_PRIME_5 G_GUINT64_CONSTANT(0x27d4eb2f165667c5)
+
+/**
+ * The number of independent lanes processed by j_checksum_hash().
+ **/
+#define J_CHECKSUM_HASH_LANES 4
+
+static struct
+{
+	/**
+	 * Tables for processing eight bytes at a time in software.
+	 **/
+	guint32 crc32c[8][256];
+
+	/**
+	 * Whether the CPU supports SSE4.2.
+	 **/
+	gboolean sse42;
+} j_checksum_tables;
+
+static void
+j_checksum_init(void)
+{
+	static gsize initialized = 0;
+
+	if (g_once_init_enter(&initialized))
+	{
+		for (guint i = 0; i < 256; i++)
+		{
+			guint32 crc = i;
+
+			for (guint j = 0; j < 8; j++)
+			{
+				crc = (crc >> 1) ^ ((crc & 1) ? J_CHECKSUM_CRC32C_POLYNOMIAL : 0);
+			}
+
+			j_checksum_tables.crc32c[0][i] = crc;
+		}
+
+		for (guint i = 0; i < 256; i++)
+		{
+			for (guint j = 1; j < 8; j++)
+			{
+				guint32 crc = j_checksum_tables.crc32c[j - 1][i];
+
+				j_checksum_tables.crc32c[j][i] = (crc >> 8) ^ j_checksum_tables.crc32c[0][crc & 0xff];
+			}
+		}
+
+#ifdef J_CHECKSUM_SSE42
+		j_checksum_tables.sse42 = __builtin_cpu_supports("sse4.2");
+#else
+		j_checksum_tables.sse42 = FALSE;
+#endif
+
+		g_once_init_leave(&initialized, 1);
+	}
+}
+
+static guint32
+j_checksum_crc32c_software(guint32 crc, guint8 const* data, gsize length)
+{
+	// Process single bytes until the data is aligned
+	while (length > 0 && ((guintptr)data % sizeof(guint64)) != 0)
+	{
+		crc = (crc >> 8) ^ j_checksum_tables.crc32c[0][(crc ^ *data) & 0xff];
+		data++;
+		length--;
+	}
+
+	while (length >= sizeof(guint64))
+	{
+		guint64 value;
+
+		value = GUINT64_FROM_LE(*(guint64 const*)(gconstpointer)data) ^ crc;
+
+		crc = j_checksum_tables.crc32c[7][value & 0xff]
+		      ^ j_checksum_tables.crc32c[6][(value >> 8) & 0xff]
+		      ^ j_checksum_tables.crc32c[5][(value >> 16) & 0xff]
+		      ^ j_checksum_tables.crc32c[4][(value >> 24) & 0xff]
+		      ^ j_checksum_tables.crc32c[3][(value >> 32) & 0xff]
+		      ^ j_checksum_tables.crc32c[2][(value >> 40) & 0xff]
+		      ^ j_checksum_tables.crc32c[1][(value >> 48) & 0xff]
+		      ^ j_checksum_tables.crc32c[0][value >> 56];
+
+		data += sizeof(guint64);
+		length -= sizeof(guint64);
+	}
+
+	while (length > 0)
+	{
+		crc = (crc >> 8) ^ j_checksum_tables.crc32c[0][(crc ^ *data) & 0xff];
+		data++;
+		length--;
+	}
+
+	return crc;
+}
+
+#ifdef J_CHECKSUM_SSE42
+__attribute__((target("sse4.2"))) static guint32
+j_checksum_crc32c_sse42(guint32 crc, guint8 const* data, gsize length)
+{
+	guint64 crc64;
+
+	while (length > 0 && ((guintptr)data % sizeof(guint64)) != 0)
+	{
+		crc = _mm_crc32_u8(crc, *data);
+		data++;
+		length--;
+	}
+
+	crc64 = crc;
+
+	while (length >= sizeof(guint64))
+	{
+		crc64 = _mm_crc32_u64(crc64, *(guint64 const*)(gconstpointer)data);
+		data += sizeof(guint64);
+		length -= sizeof(guint64);
+	}
+
+	crc = crc64;
+
+	while (length > 0)
+	{
+		crc = _mm_crc32_u8(crc, *data);
+		data++;
+		length--;
+	}
+
+	return crc;
+}
+#endif
+
+#ifdef J_CHECKSUM_ARMV8
+static guint32
+j_checksum_crc32c_armv8(guint32 crc, guint8 const* data, gsize length)
+{
+	while (length > 0 && ((guintptr)data % sizeof(guint64)) != 0)
+	{
+		crc = __crc32cb(crc, *data);
+		data++;
+		length--;
+	}
+
+	while (length >= sizeof(guint64))
+	{
+		crc = __crc32cd(crc, *(guint64 const*)(gconstpointer)data);
+		data += sizeof(guint64);
+		length -= sizeof(guint64);
+	}
+
+	while (length > 0)
+	{
+		crc = __crc32cb(crc, *data);
+		data++;
+		length--;
+	}
+
+	return crc;
+}
+#endif
+
+static inline guint64
+j_checksum_rotate(guint64 value, guint bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+static inline guint64
+j_checksum_read_8(guint8 const* data)
+{
+	guint64 value;
+
+	memcpy(&value, data, sizeof(value));
+
+	return GUINT64_FROM_LE(value);
+}
+
+static inline guint64
+j_checksum_hash_round(guint64 lane, guint64 value)
+{
+	lane += value * J_CHECKSUM_PRIME_2;
+	lane = j_checksum_rotate(lane, 31);
+
+	return lane * J_CHECKSUM_PRIME_1;
+}
+
+static inline guint64
+j_checksum_hash_merge(guint64 hash, guint64 lane)
+{
+	hash ^= j_checksum_hash_round(0, lane);
+
+	return hash * J_CHECKSUM_PRIME_1 + J_CHECKSUM_PRIME_4;
+}
+
+static inline guint64
+j_checksum_hash_avalanche(guint64 hash)
+{
+	hash ^= hash >> 33;
+	hash *= J_CHECKSUM_PRIME_2;
+	hash ^= hash >> 29;
+	hash *= J_CHECKSUM_PRIME_3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
+
+/**
+ * Computes the CRC32C (Castagnoli) checksum of data.
+ * The CRC32C instructions of SSE4.2 or ARMv8 are used if they are available.
+ *
+ * Checksums of consecutive pieces can be computed by passing the previous checksum.
+ *
+ * \code
+ * guint32 crc;
+ *
+ * crc = j_checksum_crc32c(0, data, length);
+ * crc = j_checksum_crc32c(crc, more_data, more_length);
+ * \endcode
+ *
+ * \param crc    The checksum of the preceding data or 0.
+ * \param data   The data.
+ * \param length The data's length.
+ *
+ * \return The checksum.
+ **/
+guint32
+j_checksum_crc32c(guint32 crc, gconstpointer data, gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(data != NULL || length == 0, crc);
+
+	j_checksum_init();
+
+	crc = ~crc;
+
+#if defined(J_CHECKSUM_SSE42)
+	if (j_checksum_tables.sse42)
+	{
+		return ~j_checksum_crc32c_sse42(crc, data, length);
+	}
+#elif defined(J_CHECKSUM_ARMV8)
+	return ~j_checksum_crc32c_armv8(crc, data, length);
+#endif
+
+	return ~j_checksum_crc32c_software(crc, data, length);
+}
+
+/**
+ * Computes a 128 bit hash of data that identifies it by its content.
+ * Four independent 64 bit lanes are processed in parallel, which keeps the CPU's pipelines busy and allows compilers to vectorize the main loop.
+ * The hash is not cryptographic, it only makes accidental collisions practically impossible.
+ * Use j_checksum_digest() if data is identified by its hash alone.
+ *
+ * \param data   The data.
+ * \param length The data's length.
+ * \param hash   A buffer of #J_CHECKSUM_HASH_SIZE bytes to store the hash in.
+ **/
+void
+j_checksum_hash(gconstpointer data, gsize length, guint8* hash)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 lanes[J_CHECKSUM_HASH_LANES] = {
+		J_CHECKSUM_PRIME_1 + J_CHECKSUM_PRIME_2,
+		J_CHECKSUM_PRIME_2,
+		0,
+		0 - J_CHECKSUM_PRIME_1
+	};
+	guint8 const* position = data;
+	gsize remaining = length;
+	guint64 low;
+	guint64 high;
+
+	g_return_if_fail(data != NULL || length == 0);
+	g_return_if_fail(hash != NULL);
+
+	while (remaining >= J_CHECKSUM_HASH_LANES * sizeof(guint64))
+	{
+		for (guint i = 0; i < J_CHECKSUM_HASH_LANES; i++)
+		{
+			lanes[i] = j_checksum_hash_round(lanes[i], j_checksum_read_8(position + i * sizeof(guint64)));
+		}
+
+		position += J_CHECKSUM_HASH_LANES * sizeof(guint64);
+		remaining -= J_CHECKSUM_HASH_LANES * sizeof(guint64);
+	}
+
+	// Both halves are derived from all lanes, but combine them differently
+	low = j_checksum_rotate(lanes[0], 1) + j_checksum_rotate(lanes[1], 7) + j_checksum_rotate(lanes[2], 12) + j_checksum_rotate(lanes[3], 18);
+	high = (j_checksum_rotate(lanes[0], 18) + j_checksum_rotate(lanes[1], 12) + j_checksum_rotate(lanes[2], 7) + j_checksum_rotate(lanes[3], 1)) ^ J_CHECKSUM_PRIME_5;
+
+	for (guint i = 0; i < J_CHECKSUM_HASH_LANES; i++)
+	{
+		low = j_checksum_hash_merge(low, lanes[i]);
+		high = j_checksum_hash_merge(high, lanes[J_CHECKSUM_HASH_LANES - 1 - i]);
+	}
+
+	low += length;
+	high += length * J_CHECKSUM_PRIME_5;
+
+	while (remaining >= sizeof(guint64))
+	{
+		guint64 value;
+
+		value = j_checksum_hash_round(0, j_checksum_read_8(position));
+		low = j_checksum_rotate(low ^ value, 27) * J_CHECKSUM_PRIME_1 + J_CHECKSUM_PRIME_4;
+		high = j_checksum_rotate(high ^ value, 31) * J_CHECKSUM_PRIME_2 + J_CHECKSUM_PRIME_3;
+
+		position += sizeof(guint64);
+		remaining -= sizeof(guint64);
+	}
+
+	while (remaining > 0)
+	{
+		low = j_checksum_rotate(low ^ (*position * J_CHECKSUM_PRIME_5), 11) * J_CHECKSUM_PRIME_1;
+		high = j_checksum_rotate(high ^ (*position * J_CHECKSUM_PRIME_3), 13) * J_CHECKSUM_PRIME_4;
+
+		position++;
+		remaining--;
+	}
+
+	low = j_checksum_hash_avalanche(low);
+	high = j_checksum_hash_avalanche(high ^ j_checksum_rotate(low, 32));
+
+	low = GUINT64_TO_LE(low);
+	high = GUINT64_TO_LE(high);
+
+	memcpy(hash, &low, sizeof(low));
+	memcpy(hash + sizeof(low), &high, sizeof(high));
+}
+
+/**
+ * Computes the SHA-256 digest of data.
+ * Unlike j_checksum_hash(), the digest is cryptographic, so it is safe to identify data by it even if some clients are not trusted.
+ *
+ * \param data   The data.
+ * \param length The data's length.
+ * \param digest A buffer of #J_CHECKSUM_DIGEST_SIZE bytes to store the digest in.
+ **/
+void
+j_checksum_digest(gconstpointer data, gsize length, guint8* digest)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GChecksum) checksum = NULL;
+	gsize digest_length = J_CHECKSUM_DIGEST_SIZE;
+
+	g_return_if_fail(data != NULL || length == 0);
+	g_return_if_fail(digest != NULL);
+
+	checksum = g_checksum_new(G_CHECKSUM_SHA256);
+	g_checksum_update(checksum, data, length);
+	g_checksum_get_digest(checksum, digest, &digest_length);
+
+	g_assert(digest_length == J_CHECKSUM_DIGEST_SIZE);
+}
+
+/**
+ * @}
+ **/
@@ -30,6 +30,7 @@
 #include <jconfiguration-internal.h>
 
 #include <jbackend.h>
+#include <jhelper.h>
 #include <jtrace.h>
 
 /**
@@ -74,8 +75,42 @@ struct JConfiguration
 		 * The number of db servers.
 		 */
 		guint32 db_len;
+
+		/**
+		 * The servers' locality labels, such as "pod1/rack2".
+		 * NULL if no labels are configured.
+		 */
+		gchar** object_locality;
+		gchar** kv_locality;
+		gchar** db_locality;
+
+		/**
+		 * The indices of the servers closest to the client.
+		 * Contain guint32 elements.
+		 */
+		GArray* object_local;
+		GArray* kv_local;
+		GArray* db_local;
+
+		/**
+		 * The kv and db replicas, NULL if none are configured.
+		 * Replica r replicates primary r modulo the number of servers.
+		 */
+		gchar** kv_replicas;
+		gchar** db_replicas;
+
+		/**
+		 * The number of kv and db replicas.
+		 */
+		guint32 kv_replicas_len;
+		guint32 db_replicas_len;
 	} servers;
 
+	/**
+	 * The client's locality label.
+	 */
+	gchar* locality;
+
 	/**
 	 * The object configuration.
 	 */
@@ -95,6 +130,61 @@ struct JConfiguration
 		 * The path.
 		 */
 		gchar* path;
+
+		/**
+		 * Whether servers create their parts of distributed objects on the first write.
+		 */
+		gboolean lazy_create;
+
+		/**
+		 * Whether object data is protected by CRC32C checksums.
+		 */
+		gboolean checksums;
+
+		/**
+		 * Whether identical blocks of distributed objects are deduplicated.
+		 */
+		gboolean dedup;
+
+		/**
+		 * The backend used for the node-local burst buffer, NULL if none.
+		 */
+		gchar* local_backend;
+
+		/**
+		 * The path of the node-local backend.
+		 */
+		gchar* local_path;
+
+		/**
+		 * The capacity of the burst buffer in bytes.
+		 */
+		guint64 burst_buffer_size;
+
+		/**
+		 * The bandwidth in bytes per second used for draining the burst buffer, 0 for no limit.
+		 */
+		guint64 burst_buffer_bandwidth;
+
+		/**
+		 * The backend used as the servers' cold tier, NULL if none.
+		 */
+		gchar* cold_backend;
+
+		/**
+		 * The path of the cold tier's backend.
+		 */
+		gchar* cold_path;
+
+		/**
+		 * The number of seconds after which unused objects are moved to the cold tier.
+		 */
+		guint32 cold_after;
+
+		/**
+		 * The directory of the servers' write-ahead log, NULL if none.
+		 */
+		gchar* wal_path;
 	} object;
 
 	/**
@@ -116,6 +206,21 @@ struct JConfiguration
 		 * The path.
 		 */
 		gchar* path;
+
+		/**
+		 * The backend used for node-local namespaces, NULL if none.
+		 */
+		gchar* local_backend;
+
+		/**
+		 * The path of the node-local backend.
+		 */
+		gchar* local_path;
+
+		/**
+		 * Patterns of the namespaces handled by the node-local backend.
+		 */
+		gchar** local_namespaces;
 	} kv;
 
 	/**
@@ -143,6 +248,78 @@ struct JConfiguration
 	guint32 max_connections;
 	guint64 stripe_size;
 
+	/**
+	 * The maximum amount of memory a server connection uses for receiving a message.
+	 */
+	guint64 max_receive_size;
+
+	/**
+	 * Whether servers should back receive buffers with huge pages.
+	 */
+	gboolean receive_hugepages;
+
+	/**
+	 * The maximum number of connections per backend type, 0 to use #max_connections.
+	 */
+	guint32 max_connections_object;
+	guint32 max_connections_kv;
+	guint32 max_connections_db;
+
+	/**
+	 * Whether connection limits should adapt to the servers' service times.
+	 */
+	gboolean adaptive_connections;
+
+	/**
+	 * Whether key-value pairs should be placed using consistent hashing.
+	 */
+	gboolean consistent_hashing;
+
+	/**
+	 * The message compression codec requested by clients.
+	 */
+	gchar* compression;
+
+	/**
+	 * The number of connections per server to establish at startup.
+	 */
+	guint32 warm_up_connections;
+
+	/**
+	 * The interval in seconds for checking idle connections, 0 to disable.
+	 */
+	guint32 health_check_interval;
+
+	/**
+	 * The number of times idempotent requests are retried after a network error.
+	 */
+	guint32 retries;
+
+	/**
+	 * The delay before the first retry in milliseconds, doubled for every further one.
+	 */
+	guint32 retry_delay;
+
+	/**
+	 * Whether reads of replicated blocks are sent to a second copy if the first one is slow.
+	 */
+	gboolean hedged_reads;
+
+	/**
+	 * Whether object reads and writes are sent using the compact encoding.
+	 */
+	gboolean compact_messages;
+
+	/**
+	 * The size of the client-side block cache in bytes, 0 to disable.
+	 */
+	guint64 block_cache_size;
+
+	/**
+	 * Pre-resolved server addresses, mapping host names to IP addresses.
+	 */
+	GHashTable* addresses;
+
 	/**
 	 * The reference count.
 	 */
@@ -192,9 +369,94 @@ j_configuration(void)
 	return g_atomic_pointer_get(&j_config);
 }
 
+/**
+ * Loads configuration data passed via the environment.
+ * The data can be given as is or base64-encoded with a "base64:" prefix.
+ *
+ * \private
+ **/
+static gboolean
+j_configuration_load_data(GKeyFile* key_file, gchar const* data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	if (g_str_has_prefix(data, "base64:"))
+	{
+		g_autofree guchar* decoded = NULL;
+		gsize decoded_len;
+
+		decoded = g_base64_decode(data + strlen("base64:"), &decoded_len);
+		ret = g_key_file_load_from_data(key_file, (gchar const*)decoded, decoded_len, G_KEY_FILE_NONE, NULL);
+	}
+	else
+	{
+		ret = g_key_file_load_from_data(key_file, data, -1, G_KEY_FILE_NONE, NULL);
+	}
+
+	return ret;
+}
+
+/**
+ * Returns the path of the node-local cached copy of a configuration.
+ *
+ * \private
+ *
+ * \param name The configuration's name or absolute path.
+ *
+ * \return The path if JULEA_CONFIG_CACHE is set, NULL otherwise. Should be freed with g_free().
+ **/
+static gchar*
+j_configuration_cache_path(gchar const* name)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* checksum = NULL;
+	g_autofree gchar* file_name = NULL;
+	gchar const* cache_dir;
+
+	if ((cache_dir = g_getenv("JULEA_CONFIG_CACHE")) == NULL)
+	{
+		return NULL;
+	}
+
+	// Names can be absolute paths, use a checksum to get a flat file name.
+	checksum = g_compute_checksum_for_string(G_CHECKSUM_SHA1, name, -1);
+	file_name = g_strdup_printf("julea-config-%s", checksum);
+
+	return g_build_filename(cache_dir, file_name, NULL);
+}
+
+/**
+ * Stores a node-local copy of a configuration.
+ * The file is replaced atomically, so that concurrently starting processes never see partial data.
+ *
+ * \private
+ **/
+static void
+j_configuration_cache_store(GKeyFile* key_file, gchar const* cache_path)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* data = NULL;
+	gsize data_len;
+
+	data = g_key_file_to_data(key_file, &data_len, NULL);
+
+	if (!g_file_set_contents(cache_path, data, data_len, NULL))
+	{
+		g_debug("Can not write configuration cache %s.", cache_path);
+	}
+}
+
 /**
  * Creates a new configuration.
  *
+ * The configuration is taken from the JULEA_CONFIG_DATA environment variable if it is set.
+ * Otherwise, it is loaded from the file given by JULEA_CONFIG or found in the configuration directories.
+ * If JULEA_CONFIG_CACHE is set to a node-local directory, a copy is kept there and used by later processes instead of the original file.
+ *
  * \code
  * \endcode
  *
@@ -208,37 +470,61 @@ j_configuration_new(void)
 	JConfiguration* configuration = NULL;
 	GKeyFile* key_file;
 	gchar* config_name = NULL;
+	gchar* cache_path = NULL;
+	gchar const* env_data;
 	gchar const* env_path;
 	gchar* path = NULL;
 	gchar const* const* dirs;
 
 	key_file = g_key_file_new();
 
-	if ((env_path = g_getenv("JULEA_CONFIG")) != NULL)
+	// Avoids touching the (possibly shared) file system at all.
+	if ((env_data = g_getenv("JULEA_CONFIG_DATA")) != NULL)
 	{
-		if (g_path_is_absolute(env_path))
+		if (j_configuration_load_data(key_file, env_data))
 		{
-			if (g_key_file_load_from_file(key_file, env_path, G_KEY_FILE_NONE, NULL))
-			{
-				configuration = j_configuration_new_for_data(key_file);
-			}
-			else
-			{
-				g_critical("Can not open configuration file %s.", env_path);
-			}
-
-			/* If we do not find the configuration file, stop searching. */
-			goto out;
+			configuration = j_configuration_new_for_data(key_file);
 		}
 		else
 		{
-			config_name = g_path_get_basename(env_path);
+			g_critical("Can not parse configuration data from JULEA_CONFIG_DATA.");
 		}
+
+		goto out;
+	}
+
+	env_path = g_getenv("JULEA_CONFIG");
+
+	if (env_path != NULL && g_path_is_absolute(env_path))
+	{
+		cache_path = j_configuration_cache_path(env_path);
+	}
+	else
+	{
+		config_name = (env_path != NULL) ? g_path_get_basename(env_path) : g_strdup("julea");
+		cache_path = j_configuration_cache_path(config_name);
+	}
+
+	if (cache_path != NULL && g_key_file_load_from_file(key_file, cache_path, G_KEY_FILE_NONE, NULL))
+	{
+		configuration = j_configuration_new_for_data(key_file);
+
+		goto out;
 	}
 
 	if (config_name == NULL)
 	{
-		config_name = g_strdup("julea");
+		if (g_key_file_load_from_file(key_file, env_path, G_KEY_FILE_NONE, NULL))
+		{
+			configuration = j_configuration_new_for_data(key_file);
+		}
+		else
+		{
+			g_critical("Can not open configuration file %s.", env_path);
+		}
+
+		/* If we do not find the configuration file, stop searching. */
+		goto store;
 	}
 
 	path = g_build_filename(g_get_user_config_dir(), "julea", config_name, NULL);
@@ -247,7 +533,7 @@ j_configuration_new(void)
 	{
 		configuration = j_configuration_new_for_data(key_file);
 
-		goto out;
+		goto store;
 	}
 
 	g_free(path);
@@ -262,7 +548,7 @@ j_configuration_new(void)
 		{
 			configuration = j_configuration_new_for_data(key_file);
 
-			goto out;
+			goto store;
 		}
 
 		g_free(path);
@@ -270,15 +556,103 @@ j_configuration_new(void)
 
 	path = NULL;
 
+store:
+	if (configuration != NULL && cache_path != NULL)
+	{
+		j_configuration_cache_store(key_file, cache_path);
+	}
+
 out:
 	g_key_file_free(key_file);
 
+	g_free(cache_path);
 	g_free(path);
 	g_free(config_name);
 
 	return configuration;
 }
 
+/**
+ * Returns the number of leading components two locality labels have in common.
+ *
+ * \private
+ **/
+static guint
+j_configuration_locality_match(gchar const* a, gchar const* b)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_auto(GStrv) a_parts = NULL;
+	g_auto(GStrv) b_parts = NULL;
+	guint i;
+
+	a_parts = g_strsplit(a, "/", 0);
+	b_parts = g_strsplit(b, "/", 0);
+
+	for (i = 0; a_parts[i] != NULL && b_parts[i] != NULL; i++)
+	{
+		if (g_strcmp0(a_parts[i], b_parts[i]) != 0)
+		{
+			break;
+		}
+	}
+
+	return i;
+}
+
+/**
+ * Determines the servers closest to the client.
+ *
+ * \private
+ *
+ * \param locality The client's locality label.
+ * \param labels   The servers' locality labels.
+ * \param len      The number of servers.
+ *
+ * \return The indices of the servers sharing the longest locality prefix with the client, all servers if none match.
+ **/
+static GArray*
+j_configuration_find_local_servers(gchar const* locality, gchar** labels, guint32 len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GArray* local;
+	guint best = 0;
+
+	local = g_array_new(FALSE, FALSE, sizeof(guint32));
+
+	if (locality != NULL && labels != NULL)
+	{
+		for (guint32 i = 0; i < len && labels[i] != NULL; i++)
+		{
+			guint match;
+
+			match = j_configuration_locality_match(locality, labels[i]);
+
+			if (match > best)
+			{
+				best = match;
+				g_array_set_size(local, 0);
+			}
+
+			if (match == best && best > 0)
+			{
+				g_array_append_val(local, i);
+			}
+		}
+	}
+
+	if (local->len == 0)
+	{
+		for (guint32 i = 0; i < len; i++)
+		{
+			g_array_append_val(local, i);
+		}
+	}
+
+	return local;
+}
+
 /**
  * Creates a new configuration for the given configuration data.
  *
@@ -301,30 +675,106 @@ j_configuration_new_for_data(GKeyFile* key_file)
 	gchar* object_backend;
 	gchar* object_component;
 	gchar* object_path;
+	gboolean object_lazy_create;
+	gboolean object_checksums;
+	gboolean object_dedup;
+	gchar* object_local_backend;
+	gchar* object_local_path;
+	guint64 object_burst_buffer_size;
+	guint64 object_burst_buffer_bandwidth;
+	gchar* object_cold_backend;
+	gchar* object_cold_path;
+	guint32 object_cold_after;
+	gchar* object_wal_path;
 	gchar* kv_backend;
 	gchar* kv_component;
 	gchar* kv_path;
+	gchar* kv_local_backend;
+	gchar* kv_local_path;
+	gchar** kv_local_namespaces;
 	gchar* db_backend;
 	gchar* db_component;
 	gchar* db_path;
 	guint64 max_operation_size;
+	guint64 max_receive_size;
+	gboolean receive_hugepages;
 	guint32 max_connections;
 	guint64 stripe_size;
+	gchar* compression;
+	guint32 warm_up_connections;
+	guint32 health_check_interval;
+	guint32 retries;
+	guint32 retry_delay;
+	gboolean hedged_reads;
+	gboolean compact_messages;
+	guint64 block_cache_size;
+	guint32 max_connections_object;
+	guint32 max_connections_kv;
+	guint32 max_connections_db;
+	gboolean adaptive_connections;
+	gboolean consistent_hashing;
+	gchar** servers_object_locality;
+	gchar** servers_kv_locality;
+	gchar** servers_db_locality;
+	gchar** servers_kv_replicas;
+	gchar** servers_db_replicas;
+	gchar* locality;
+	g_auto(GStrv) address_hosts = NULL;
 
 	g_return_val_if_fail(key_file != NULL, FALSE);
 
 	max_operation_size = g_key_file_get_uint64(key_file, "core", "max-operation-size", NULL);
+	max_receive_size = g_key_file_get_uint64(key_file, "core", "max-receive-size", NULL);
+	receive_hugepages = g_key_file_get_boolean(key_file, "core", "receive-hugepages", NULL);
 	max_connections = g_key_file_get_integer(key_file, "clients", "max-connections", NULL);
 	stripe_size = g_key_file_get_uint64(key_file, "clients", "stripe-size", NULL);
+	compression = g_key_file_get_string(key_file, "clients", "compression", NULL);
+	warm_up_connections = g_key_file_get_integer(key_file, "clients", "warm-up-connections", NULL);
+	health_check_interval = g_key_file_get_integer(key_file, "clients", "health-check-interval", NULL);
+	retries = g_key_file_get_integer(key_file, "clients", "retries", NULL);
+	retry_delay = g_key_file_get_integer(key_file, "clients", "retry-delay", NULL);
+	hedged_reads = g_key_file_get_boolean(key_file, "clients", "hedged-reads", NULL);
+	compact_messages = g_key_file_get_boolean(key_file, "clients", "compact-messages", NULL);
+	block_cache_size = g_key_file_get_uint64(key_file, "clients", "block-cache-size", NULL);
+	max_connections_object = g_key_file_get_integer(key_file, "clients", "max-connections-object", NULL);
+	max_connections_kv = g_key_file_get_integer(key_file, "clients", "max-connections-kv", NULL);
+	max_connections_db = g_key_file_get_integer(key_file, "clients", "max-connections-db", NULL);
+	adaptive_connections = g_key_file_get_boolean(key_file, "clients", "adaptive-connections", NULL);
+	consistent_hashing = g_key_file_get_boolean(key_file, "clients", "consistent-hashing", NULL);
 	servers_object = g_key_file_get_string_list(key_file, "servers", "object", NULL, NULL);
 	servers_kv = g_key_file_get_string_list(key_file, "servers", "kv", NULL, NULL);
 	servers_db = g_key_file_get_string_list(key_file, "servers", "db", NULL, NULL);
+	servers_object_locality = g_key_file_get_string_list(key_file, "servers", "object-locality", NULL, NULL);
+	servers_kv_locality = g_key_file_get_string_list(key_file, "servers", "kv-locality", NULL, NULL);
+	servers_db_locality = g_key_file_get_string_list(key_file, "servers", "db-locality", NULL, NULL);
+	servers_kv_replicas = g_key_file_get_string_list(key_file, "servers", "kv-replicas", NULL, NULL);
+	servers_db_replicas = g_key_file_get_string_list(key_file, "servers", "db-replicas", NULL, NULL);
+	locality = g_strdup(g_getenv("JULEA_LOCALITY"));
+
+	if (locality == NULL)
+	{
+		locality = g_key_file_get_string(key_file, "clients", "locality", NULL);
+	}
 	object_backend = g_key_file_get_string(key_file, "object", "backend", NULL);
 	object_component = g_key_file_get_string(key_file, "object", "component", NULL);
 	object_path = g_key_file_get_string(key_file, "object", "path", NULL);
+	object_lazy_create = g_key_file_get_boolean(key_file, "object", "lazy-create", NULL);
+	object_checksums = g_key_file_get_boolean(key_file, "object", "checksums", NULL);
+	object_dedup = g_key_file_get_boolean(key_file, "object", "dedup", NULL);
+	object_local_backend = g_key_file_get_string(key_file, "object", "local-backend", NULL);
+	object_local_path = g_key_file_get_string(key_file, "object", "local-path", NULL);
+	object_burst_buffer_size = g_key_file_get_uint64(key_file, "object", "burst-buffer-size", NULL);
+	object_burst_buffer_bandwidth = g_key_file_get_uint64(key_file, "object", "burst-buffer-bandwidth", NULL);
+	object_cold_backend = g_key_file_get_string(key_file, "object", "cold-backend", NULL);
+	object_cold_path = g_key_file_get_string(key_file, "object", "cold-path", NULL);
+	object_cold_after = g_key_file_get_integer(key_file, "object", "cold-after", NULL);
+	object_wal_path = g_key_file_get_string(key_file, "object", "wal-path", NULL);
 	kv_backend = g_key_file_get_string(key_file, "kv", "backend", NULL);
 	kv_component = g_key_file_get_string(key_file, "kv", "component", NULL);
 	kv_path = g_key_file_get_string(key_file, "kv", "path", NULL);
+	kv_local_backend = g_key_file_get_string(key_file, "kv", "local-backend", NULL);
+	kv_local_path = g_key_file_get_string(key_file, "kv", "local-path", NULL);
+	kv_local_namespaces = g_key_file_get_string_list(key_file, "kv", "local-namespaces", NULL, NULL);
 	db_backend = g_key_file_get_string(key_file, "db", "backend", NULL);
 	db_component = g_key_file_get_string(key_file, "db", "component", NULL);
 	db_path = g_key_file_get_string(key_file, "db", "path", NULL);
@@ -348,12 +798,27 @@ j_configuration_new_for_data(GKeyFile* key_file)
 		g_free(kv_backend);
 		g_free(kv_component);
 		g_free(kv_path);
+		g_free(kv_local_backend);
+		g_free(kv_local_path);
+		g_strfreev(kv_local_namespaces);
 		g_free(object_backend);
 		g_free(object_component);
 		g_free(object_path);
+		g_free(object_local_backend);
+		g_free(object_local_path);
+		g_free(object_cold_backend);
+		g_free(object_cold_path);
+		g_free(object_wal_path);
 		g_strfreev(servers_object);
 		g_strfreev(servers_kv);
 		g_strfreev(servers_db);
+		g_strfreev(servers_object_locality);
+		g_strfreev(servers_kv_locality);
+		g_strfreev(servers_db_locality);
+		g_strfreev(servers_kv_replicas);
+		g_strfreev(servers_db_replicas);
+		g_free(compression);
+		g_free(locality);
 
 		return NULL;
 	}
@@ -365,35 +830,110 @@ j_configuration_new_for_data(GKeyFile* key_file)
 	configuration->servers.object_len = g_strv_length(servers_object);
 	configuration->servers.kv_len = g_strv_length(servers_kv);
 	configuration->servers.db_len = g_strv_length(servers_db);
+	configuration->servers.object_locality = servers_object_locality;
+	configuration->servers.kv_locality = servers_kv_locality;
+	configuration->servers.db_locality = servers_db_locality;
+	configuration->servers.object_local = j_configuration_find_local_servers(locality, servers_object_locality, configuration->servers.object_len);
+	configuration->servers.kv_local = j_configuration_find_local_servers(locality, servers_kv_locality, configuration->servers.kv_len);
+	configuration->servers.db_local = j_configuration_find_local_servers(locality, servers_db_locality, configuration->servers.db_len);
+	configuration->servers.kv_replicas = servers_kv_replicas;
+	configuration->servers.db_replicas = servers_db_replicas;
+	configuration->servers.kv_replicas_len = (servers_kv_replicas != NULL) ? g_strv_length(servers_kv_replicas) : 0;
+	configuration->servers.db_replicas_len = (servers_db_replicas != NULL) ? g_strv_length(servers_db_replicas) : 0;
+	configuration->locality = locality;
 	configuration->object.backend = object_backend;
 	configuration->object.component = object_component;
 	configuration->object.path = object_path;
+	configuration->object.lazy_create = object_lazy_create;
+	configuration->object.checksums = object_checksums;
+	configuration->object.dedup = object_dedup;
+	configuration->object.local_backend = object_local_backend;
+	configuration->object.local_path = object_local_path;
+	configuration->object.burst_buffer_size = object_burst_buffer_size;
+	configuration->object.burst_buffer_bandwidth = object_burst_buffer_bandwidth;
+	configuration->object.cold_backend = object_cold_backend;
+	configuration->object.cold_path = object_cold_path;
+	configuration->object.cold_after = object_cold_after;
+	configuration->object.wal_path = object_wal_path;
 	configuration->kv.backend = kv_backend;
 	configuration->kv.component = kv_component;
 	configuration->kv.path = kv_path;
+	configuration->kv.local_backend = kv_local_backend;
+	configuration->kv.local_path = kv_local_path;
+	configuration->kv.local_namespaces = kv_local_namespaces;
 	configuration->db.backend = db_backend;
 	configuration->db.component = db_component;
 	configuration->db.path = db_path;
 	configuration->max_operation_size = max_operation_size;
+	configuration->max_receive_size = max_receive_size;
+	configuration->receive_hugepages = receive_hugepages;
 	configuration->max_connections = max_connections;
 	configuration->stripe_size = stripe_size;
+	configuration->compression = compression;
+	configuration->warm_up_connections = warm_up_connections;
+	configuration->health_check_interval = health_check_interval;
+	configuration->retries = retries;
+	configuration->retry_delay = retry_delay;
+	configuration->hedged_reads = hedged_reads;
+	configuration->compact_messages = compact_messages;
+	configuration->block_cache_size = block_cache_size;
+	configuration->max_connections_object = max_connections_object;
+	configuration->max_connections_kv = max_connections_kv;
+	configuration->max_connections_db = max_connections_db;
+	configuration->adaptive_connections = adaptive_connections;
+	configuration->consistent_hashing = consistent_hashing;
+	configuration->addresses = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
 	configuration->ref_count = 1;
 
+	address_hosts = g_key_file_get_keys(key_file, "addresses", NULL, NULL);
+
+	for (guint i = 0; address_hosts != NULL && address_hosts[i] != NULL; i++)
+	{
+		gchar* address;
+
+		if ((address = g_key_file_get_string(key_file, "addresses", address_hosts[i], NULL)) != NULL)
+		{
+			g_hash_table_insert(configuration->addresses, g_strdup(address_hosts[i]), address);
+		}
+	}
+
 	if (configuration->max_operation_size == 0)
 	{
 		configuration->max_operation_size = 8 * 1024 * 1024;
 	}
 
+	if (configuration->max_receive_size == 0)
+	{
+		configuration->max_receive_size = 8 * configuration->max_operation_size;
+	}
+
+	configuration->max_receive_size = MAX(configuration->max_receive_size, configuration->max_operation_size);
+
 	if (configuration->max_connections == 0)
 	{
 		configuration->max_connections = g_get_num_processors();
 	}
 
+	if (configuration->retry_delay == 0)
+	{
+		configuration->retry_delay = 10;
+	}
+
 	if (configuration->stripe_size == 0)
 	{
 		configuration->stripe_size = 4 * 1024 * 1024;
 	}
 
+	if (configuration->object.burst_buffer_size == 0)
+	{
+		configuration->object.burst_buffer_size = G_GUINT64_CONSTANT(1024) * 1024 * 1024;
+	}
+
+	if (configuration->object.cold_after == 0)
+	{
+		configuration->object.cold_after = 60 * 60;
+	}
+
 	return configuration;
 }
 
@@ -444,22 +984,64 @@ j_configuration_unref(JConfiguration* configuration)
 		g_free(configuration->db.component);
 		g_free(configuration->db.path);
 
+		g_free(configuration->compression);
+
 		g_free(configuration->kv.backend);
 		g_free(configuration->kv.component);
 		g_free(configuration->kv.path);
+		g_free(configuration->kv.local_backend);
+		g_free(configuration->kv.local_path);
+		g_strfreev(configuration->kv.local_namespaces);
 
 		g_free(configuration->object.backend);
 		g_free(configuration->object.component);
 		g_free(configuration->object.path);
+		g_free(configuration->object.local_backend);
+		g_free(configuration->object.local_path);
+		g_free(configuration->object.cold_backend);
+		g_free(configuration->object.cold_path);
+		g_free(configuration->object.wal_path);
 
 		g_strfreev(configuration->servers.object);
 		g_strfreev(configuration->servers.kv);
 		g_strfreev(configuration->servers.db);
+		g_strfreev(configuration->servers.object_locality);
+		g_strfreev(configuration->servers.kv_locality);
+		g_strfreev(configuration->servers.db_locality);
+		g_array_unref(configuration->servers.object_local);
+		g_array_unref(configuration->servers.kv_local);
+		g_array_unref(configuration->servers.db_local);
+		g_strfreev(configuration->servers.kv_replicas);
+		g_strfreev(configuration->servers.db_replicas);
+
+		g_free(configuration->locality);
+
+		g_hash_table_unref(configuration->addresses);
 
 		g_slice_free(JConfiguration, configuration);
 	}
 }
 
+/**
+ * Returns the pre-resolved address of a server host.
+ * Addresses are stored in the configuration's addresses section, so that clients do not have to look up host names.
+ *
+ * \param configuration The configuration.
+ * \param host          A host name, without port.
+ *
+ * \return The IP address, NULL if it has not been resolved in advance.
+ **/
+gchar const*
+j_configuration_get_server_address(JConfiguration* configuration, gchar const* host)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, NULL);
+	g_return_val_if_fail(host != NULL, NULL);
+
+	return g_hash_table_lookup(configuration->addresses, host);
+}
+
 gchar const*
 j_configuration_get_server(JConfiguration* configuration, JBackendType backend, guint32 index)
 {
@@ -473,10 +1055,22 @@ j_configuration_get_server(JConfiguration* configuration, JBackendType backend,
 			g_return_val_if_fail(index < configuration->servers.object_len, NULL);
 			return configuration->servers.object[index];
 		case J_BACKEND_TYPE_KV:
-			g_return_val_if_fail(index < configuration->servers.kv_len, NULL);
-			return configuration->servers.kv[index];
+			g_return_val_if_fail(index < configuration->servers.kv_len + configuration->servers.kv_replicas_len, NULL);
+
+			if (index >= configuration->servers.kv_len)
+			{
+				return configuration->servers.kv_replicas[index - configuration->servers.kv_len];
+			}
+
+			return configuration->servers.kv[index];
 		case J_BACKEND_TYPE_DB:
-			g_return_val_if_fail(index < configuration->servers.db_len, NULL);
+			g_return_val_if_fail(index < configuration->servers.db_len + configuration->servers.db_replicas_len, NULL);
+
+			if (index >= configuration->servers.db_len)
+			{
+				return configuration->servers.db_replicas[index - configuration->servers.db_len];
+			}
+
 			return configuration->servers.db[index];
 		default:
 			g_assert_not_reached();
@@ -485,6 +1079,113 @@ j_configuration_get_server(JConfiguration* configuration, JBackendType backend,
 	return NULL;
 }
 
+/**
+ * Returns a server's locality label.
+ *
+ * \param configuration The configuration.
+ * \param backend       The backend type.
+ * \param index         The server index.
+ *
+ * \return The label or NULL if none is configured.
+ **/
+gchar const*
+j_configuration_get_server_locality(JConfiguration* configuration, JBackendType backend, guint32 index)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gchar** labels = NULL;
+
+	g_return_val_if_fail(configuration != NULL, NULL);
+	g_return_val_if_fail(index < j_configuration_get_server_count(configuration, backend), NULL);
+
+	switch (backend)
+	{
+		case J_BACKEND_TYPE_OBJECT:
+			labels = configuration->servers.object_locality;
+			break;
+		case J_BACKEND_TYPE_KV:
+			labels = configuration->servers.kv_locality;
+			break;
+		case J_BACKEND_TYPE_DB:
+			labels = configuration->servers.db_locality;
+			break;
+		default:
+			g_assert_not_reached();
+	}
+
+	if (labels == NULL || index >= g_strv_length(labels))
+	{
+		return NULL;
+	}
+
+	return labels[index];
+}
+
+static GArray*
+j_configuration_get_local_servers(JConfiguration* configuration, JBackendType backend)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	switch (backend)
+	{
+		case J_BACKEND_TYPE_OBJECT:
+			return configuration->servers.object_local;
+		case J_BACKEND_TYPE_KV:
+			return configuration->servers.kv_local;
+		case J_BACKEND_TYPE_DB:
+			return configuration->servers.db_local;
+		default:
+			g_assert_not_reached();
+	}
+
+	return NULL;
+}
+
+/**
+ * Returns the number of servers in the client's locality domain.
+ * These are the servers whose labels share the longest prefix with the client's label.
+ * If no labels match, all servers are considered local.
+ *
+ * \param configuration The configuration.
+ * \param backend       The backend type.
+ *
+ * \return The number of local servers.
+ **/
+guint32
+j_configuration_get_local_server_count(JConfiguration* configuration, JBackendType backend)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return j_configuration_get_local_servers(configuration, backend)->len;
+}
+
+/**
+ * Returns the index of a server in the client's locality domain.
+ *
+ * \param configuration The configuration.
+ * \param backend       The backend type.
+ * \param index         The index within the local servers.
+ *
+ * \return The server index.
+ **/
+guint32
+j_configuration_get_local_server(JConfiguration* configuration, JBackendType backend, guint32 index)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GArray* local;
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	local = j_configuration_get_local_servers(configuration, backend);
+
+	g_return_val_if_fail(index < local->len, 0);
+
+	return g_array_index(local, guint32, index);
+}
+
 guint32
 j_configuration_get_server_count(JConfiguration* configuration, JBackendType backend)
 {
@@ -507,6 +1208,72 @@ j_configuration_get_server_count(JConfiguration* configuration, JBackendType bac
 	return 0;
 }
 
+/**
+ * Returns the number of replicas.
+ * Replicas follow the servers, that is, replica r has the server index j_configuration_get_server_count() + r.
+ * It receives all changes of the server with index r modulo j_configuration_get_server_count().
+ *
+ * \param configuration The configuration.
+ * \param backend       The backend type.
+ *
+ * \return The number of replicas, 0 if the backend type cannot be replicated.
+ **/
+guint32
+j_configuration_get_replica_count(JConfiguration* configuration, JBackendType backend)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	switch (backend)
+	{
+		case J_BACKEND_TYPE_OBJECT:
+			return 0;
+		case J_BACKEND_TYPE_KV:
+			return configuration->servers.kv_replicas_len;
+		case J_BACKEND_TYPE_DB:
+			return configuration->servers.db_replicas_len;
+		default:
+			g_assert_not_reached();
+	}
+
+	return 0;
+}
+
+/**
+ * Returns the server responsible for a key.
+ *
+ * Depending on clients.consistent-hashing, the key's hash is either mapped using jump consistent hashing or modulo the server count.
+ *
+ * \param configuration A configuration.
+ * \param backend       The backend type.
+ * \param key           A key, for example, an object name.
+ *
+ * \return A server index.
+ **/
+guint32
+j_configuration_get_server_for_key(JConfiguration* configuration, JBackendType backend, gchar const* key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint32 server_count;
+	guint32 hash;
+
+	g_return_val_if_fail(configuration != NULL, 0);
+	g_return_val_if_fail(key != NULL, 0);
+
+	server_count = j_configuration_get_server_count(configuration, backend);
+	hash = j_helper_hash(key);
+
+	if (configuration->consistent_hashing)
+	{
+		// Adding a server only moves the keys that belong on the new server.
+		return j_helper_jump_hash(hash, server_count);
+	}
+
+	return hash % server_count;
+}
+
 gchar const*
 j_configuration_get_backend(JConfiguration* configuration, JBackendType backend)
 {
@@ -573,6 +1340,114 @@ j_configuration_get_backend_path(JConfiguration* configuration, JBackendType bac
 	return NULL;
 }
 
+/**
+ * Returns the backend used for node-local namespaces.
+ * Operations on these namespaces are executed by the client library itself, without contacting a server.
+ * For objects, the node-local backend is used as a burst buffer instead.
+ *
+ * \param configuration The configuration.
+ * \param backend       The backend type.
+ *
+ * \return The backend's name, NULL if no node-local backend is configured.
+ **/
+gchar const*
+j_configuration_get_local_backend(JConfiguration* configuration, JBackendType backend)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, NULL);
+
+	switch (backend)
+	{
+		case J_BACKEND_TYPE_OBJECT:
+			return configuration->object.local_backend;
+		case J_BACKEND_TYPE_DB:
+			return NULL;
+		case J_BACKEND_TYPE_KV:
+			return configuration->kv.local_backend;
+		default:
+			g_assert_not_reached();
+	}
+
+	return NULL;
+}
+
+/**
+ * Returns the path of the backend used for node-local namespaces.
+ *
+ * \param configuration The configuration.
+ * \param backend       The backend type.
+ *
+ * \return The path, NULL if no node-local backend is configured.
+ **/
+gchar const*
+j_configuration_get_local_backend_path(JConfiguration* configuration, JBackendType backend)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, NULL);
+
+	switch (backend)
+	{
+		case J_BACKEND_TYPE_OBJECT:
+			return configuration->object.local_path;
+		case J_BACKEND_TYPE_DB:
+			return NULL;
+		case J_BACKEND_TYPE_KV:
+			return configuration->kv.local_path;
+		default:
+			g_assert_not_reached();
+	}
+
+	return NULL;
+}
+
+/**
+ * Checks whether a namespace is node-local.
+ * Namespaces are matched against the configured patterns, which can contain the wildcards \c * and \c ?.
+ *
+ * \param configuration The configuration.
+ * \param backend       The backend type.
+ * \param namespace     A namespace.
+ *
+ * \return TRUE if the namespace is handled by the node-local backend, FALSE otherwise.
+ **/
+gboolean
+j_configuration_is_local_namespace(JConfiguration* configuration, JBackendType backend, gchar const* namespace)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gchar** patterns = NULL;
+
+	g_return_val_if_fail(configuration != NULL, FALSE);
+	g_return_val_if_fail(namespace != NULL, FALSE);
+
+	switch (backend)
+	{
+		case J_BACKEND_TYPE_OBJECT:
+		case J_BACKEND_TYPE_DB:
+			break;
+		case J_BACKEND_TYPE_KV:
+			if (configuration->kv.local_backend != NULL)
+			{
+				patterns = configuration->kv.local_namespaces;
+			}
+			break;
+		default:
+			g_assert_not_reached();
+	}
+
+	for (guint i = 0; patterns != NULL && patterns[i] != NULL; i++)
+	{
+		if (g_pattern_match_simple(patterns[i], namespace))
+		{
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
 guint64
 j_configuration_get_max_operation_size(JConfiguration* configuration)
 {
@@ -583,6 +1458,33 @@ j_configuration_get_max_operation_size(JConfiguration* configuration)
 	return configuration->max_operation_size;
 }
 
+/**
+ * Returns the maximum amount of memory a server connection uses for receiving a message.
+ *
+ * \param configuration The configuration.
+ *
+ * \return The size in bytes, at least the maximum operation size.
+ **/
+guint64
+j_configuration_get_max_receive_size(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->max_receive_size;
+}
+
+gboolean
+j_configuration_get_receive_hugepages(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, FALSE);
+
+	return configuration->receive_hugepages;
+}
+
 guint32
 j_configuration_get_max_connections(JConfiguration* configuration)
 {
@@ -593,6 +1495,123 @@ j_configuration_get_max_connections(JConfiguration* configuration)
 	return configuration->max_connections;
 }
 
+/**
+ * Returns the maximum number of connections per server for a backend type.
+ *
+ * \param configuration The configuration.
+ * \param backend       The backend type.
+ *
+ * \return The backend type's limit if configured, the global limit otherwise.
+ **/
+guint32
+j_configuration_get_backend_max_connections(JConfiguration* configuration, JBackendType backend)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint32 max_connections = 0;
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	switch (backend)
+	{
+		case J_BACKEND_TYPE_OBJECT:
+			max_connections = configuration->max_connections_object;
+			break;
+		case J_BACKEND_TYPE_KV:
+			max_connections = configuration->max_connections_kv;
+			break;
+		case J_BACKEND_TYPE_DB:
+			max_connections = configuration->max_connections_db;
+			break;
+		default:
+			g_assert_not_reached();
+	}
+
+	if (max_connections == 0)
+	{
+		max_connections = configuration->max_connections;
+	}
+
+	return max_connections;
+}
+
+gboolean
+j_configuration_get_adaptive_connections(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, FALSE);
+
+	return configuration->adaptive_connections;
+}
+
+/**
+ * Returns whether distributed objects are created lazily.
+ * If so, creating a distributed object only creates its first part and each other server creates its part on the first write to it.
+ * Objects that are not distributed are always created explicitly.
+ *
+ * \param configuration The configuration.
+ *
+ * \return TRUE if objects are created lazily, FALSE otherwise.
+ **/
+gboolean
+j_configuration_get_object_lazy_create(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, FALSE);
+
+	return configuration->object.lazy_create;
+}
+
+/**
+ * Returns whether object data is protected by checksums.
+ * If so, clients send a CRC32C checksum with each written extent and verify the checksums of read extents,
+ * while servers verify written data and store checksums alongside it.
+ *
+ * \param configuration The configuration.
+ *
+ * \return TRUE if checksums are used, FALSE otherwise.
+ **/
+gboolean
+j_configuration_get_object_checksums(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, FALSE);
+
+	return configuration->object.checksums;
+}
+
+/**
+ * Returns whether identical blocks of distributed objects are deduplicated.
+ * If so, clients only send blocks whose content is not yet stored on the servers,
+ * while servers keep one reference-counted copy of each block.
+ *
+ * \param configuration The configuration.
+ *
+ * \return TRUE if blocks are deduplicated, FALSE otherwise.
+ **/
+gboolean
+j_configuration_get_object_dedup(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, FALSE);
+
+	return configuration->object.dedup;
+}
+
+gboolean
+j_configuration_get_consistent_hashing(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, FALSE);
+
+	return configuration->consistent_hashing;
+}
+
 guint64
 j_configuration_get_stripe_size(JConfiguration* configuration)
 {
@@ -603,6 +1622,195 @@ j_configuration_get_stripe_size(JConfiguration* configuration)
 	return configuration->stripe_size;
 }
 
+/**
+ * Returns the message compression codec clients should request.
+ *
+ * \param configuration The configuration.
+ *
+ * \return The codec name or NULL if compression is disabled.
+ **/
+gchar const*
+j_configuration_get_compression(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, NULL);
+
+	return configuration->compression;
+}
+
+guint32
+j_configuration_get_warm_up_connections(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->warm_up_connections;
+}
+
+guint32
+j_configuration_get_health_check_interval(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->health_check_interval;
+}
+
+guint32
+j_configuration_get_retries(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->retries;
+}
+
+guint32
+j_configuration_get_retry_delay(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->retry_delay;
+}
+
+gboolean
+j_configuration_get_hedged_reads(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, FALSE);
+
+	return configuration->hedged_reads;
+}
+
+gboolean
+j_configuration_get_compact_messages(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, FALSE);
+
+	return configuration->compact_messages;
+}
+
+guint64
+j_configuration_get_block_cache_size(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->block_cache_size;
+}
+
+/**
+ * Returns the capacity of the node-local burst buffer.
+ *
+ * \param configuration The configuration.
+ *
+ * \return The capacity in bytes.
+ **/
+guint64
+j_configuration_get_burst_buffer_size(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->object.burst_buffer_size;
+}
+
+/**
+ * Returns the bandwidth used for draining the node-local burst buffer to the object servers.
+ *
+ * \param configuration The configuration.
+ *
+ * \return The bandwidth in bytes per second, 0 for no limit.
+ **/
+guint64
+j_configuration_get_burst_buffer_bandwidth(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->object.burst_buffer_bandwidth;
+}
+
+/**
+ * Returns the backend the object servers use as their cold tier.
+ *
+ * \param configuration The configuration.
+ *
+ * \return The backend's name, NULL if objects are not tiered.
+ **/
+gchar const*
+j_configuration_get_object_cold_backend(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, NULL);
+
+	return configuration->object.cold_backend;
+}
+
+/**
+ * Returns the path of the object servers' cold tier.
+ *
+ * \param configuration The configuration.
+ *
+ * \return The path, NULL if objects are not tiered.
+ **/
+gchar const*
+j_configuration_get_object_cold_path(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, NULL);
+
+	return configuration->object.cold_path;
+}
+
+/**
+ * Returns the time after which unused objects are moved to the cold tier.
+ *
+ * \param configuration The configuration.
+ *
+ * \return The time in seconds.
+ **/
+guint32
+j_configuration_get_object_cold_after(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->object.cold_after;
+}
+
+/**
+ * Returns the directory of the object servers' write-ahead log.
+ *
+ * \param configuration The configuration.
+ *
+ * \return The path, NULL if writes are not logged.
+ **/
+gchar const*
+j_configuration_get_object_wal_path(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, NULL);
+
+	return configuration->object.wal_path;
+}
+
 /**
  * @}
  **/
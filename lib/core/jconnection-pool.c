@@ -26,14 +26,20 @@
 #include <glib-object.h>
 #include <gio/gio.h>
 
+#include <string.h>
+
 #include <jconnection-pool.h>
 #include <jconnection-pool-internal.h>
 
 #include <jbackend.h>
+#include <jconfiguration.h>
 #include <jhelper.h>
 #include <jhelper-internal.h>
 #include <jmessage.h>
+#include <jmessage-internal.h>
+#include <jstatistics.h>
 #include <jtrace.h>
+#include <jtransport.h>
 
 /**
  * \defgroup JConnectionPool Connection Pool
@@ -43,14 +49,67 @@
  * @{
  **/
 
+/**
+ * The maximum delay before a server's connections are warmed up, in microseconds.
+ * Spreads out the connection attempts of many clients starting at once.
+ **/
+#define J_CONNECTION_POOL_WARM_UP_JITTER G_USEC_PER_SEC
+
+/**
+ * The maximum number of threads used for warming up connections.
+ **/
+#define J_CONNECTION_POOL_WARM_UP_THREADS 16
+
 struct JConnectionPoolQueue
 {
 	GAsyncQueue* queue;
 	guint count;
+
+	/**
+	 * The current connection limit.
+	 * Only differs from #max_count if the limit is adaptive.
+	 **/
+	guint limit;
+
+	/**
+	 * The maximum connection limit.
+	 **/
+	guint max_count;
+
+	/**
+	 * Protects #service_time, #service_time_baseline and #statistics.
+	 **/
+	GMutex mutex[1];
+
+	/**
+	 * The smoothed time connections are in use, in microseconds.
+	 **/
+	gint64 service_time;
+
+	/**
+	 * The service time when #limit was last changed.
+	 **/
+	gint64 service_time_baseline;
+
+	/**
+	 * The client-side statistics about the server.
+	 **/
+	JConnectionPoolServerStatistics statistics;
 };
 
 typedef struct JConnectionPoolQueue JConnectionPoolQueue;
 
+/**
+ * A server whose connections should be warmed up.
+ **/
+struct JConnectionPoolWarmUp
+{
+	JBackendType backend;
+	guint index;
+};
+
+typedef struct JConnectionPoolWarmUp JConnectionPoolWarmUp;
+
 /**
  * A connection.
  **/
@@ -63,263 +122,1269 @@ struct JConnectionPool
 	guint object_len;
 	guint kv_len;
 	guint db_len;
-	guint max_count;
+
+	/**
+	 * Spreads reads across a server and its replicas, see j_connection_pool_get_read_index().
+	 **/
+	gint read_counter;
+
+	/**
+	 * Whether the limits of exclusive connections adapt to the servers' service times.
+	 **/
+	gboolean adaptive;
+
+	/**
+	 * The threads establishing connections at startup, NULL if warm-up is disabled.
+	 **/
+	GThreadPool* warm_up;
+
+	/**
+	 * The thread checking idle connections, NULL if health checks are disabled.
+	 **/
+	GThread* health_check;
+	guint health_check_interval;
+	gboolean health_check_stop;
+	GMutex health_check_mutex[1];
+	GCond health_check_cond[1];
 };
 
 typedef struct JConnectionPool JConnectionPool;
 
 static JConnectionPool* j_connection_pool = NULL;
 
-void
-j_connection_pool_init(JConfiguration* configuration)
+G_DEFINE_QUARK(j-connection-pool-pop-time, j_connection_pool_pop_time)
+G_DEFINE_QUARK(j-connection-pool-queue, j_connection_pool_queue)
+
+static void
+j_connection_pool_queue_init(JConnectionPoolQueue* pool_queue, guint max_count, gboolean adaptive)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JConnectionPool* pool;
+	pool_queue->queue = g_async_queue_new();
+	pool_queue->count = 0;
+	pool_queue->max_count = max_count;
+	// Adaptive limits start low and grow on demand.
+	pool_queue->limit = (adaptive) ? MAX(1, max_count / 4) : max_count;
+	pool_queue->service_time = 0;
+	pool_queue->service_time_baseline = 0;
+	memset(&(pool_queue->statistics), 0, sizeof(pool_queue->statistics));
 
-	g_return_if_fail(j_connection_pool == NULL);
+	g_mutex_init(pool_queue->mutex);
+}
 
-	pool = g_slice_new(JConnectionPool);
-	pool->configuration = j_configuration_ref(configuration);
-	pool->object_len = j_configuration_get_server_count(configuration, J_BACKEND_TYPE_OBJECT);
-	pool->object_queues = g_new(JConnectionPoolQueue, pool->object_len);
-	pool->kv_len = j_configuration_get_server_count(configuration, J_BACKEND_TYPE_KV);
-	pool->kv_queues = g_new(JConnectionPoolQueue, pool->kv_len);
-	pool->db_len = j_configuration_get_server_count(configuration, J_BACKEND_TYPE_DB);
-	pool->db_queues = g_new(JConnectionPoolQueue, pool->db_len);
-	pool->max_count = j_configuration_get_max_connections(configuration);
+static void
+j_connection_pool_close(GAsyncQueue* queue)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	for (guint i = 0; i < pool->object_len; i++)
-	{
-		pool->object_queues[i].queue = g_async_queue_new();
-		pool->object_queues[i].count = 0;
-	}
+	GSocketConnection* connection;
 
-	for (guint i = 0; i < pool->kv_len; i++)
+	while ((connection = g_async_queue_try_pop(queue)) != NULL)
 	{
-		pool->kv_queues[i].queue = g_async_queue_new();
-		pool->kv_queues[i].count = 0;
+		j_message_multiplex_stop(connection);
+		g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+		g_object_unref(connection);
 	}
 
-	for (guint i = 0; i < pool->db_len; i++)
+	g_async_queue_unref(queue);
+}
+
+static void
+j_connection_pool_queue_fini(JConnectionPoolQueue* pool_queue)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	j_connection_pool_close(pool_queue->queue);
+	g_mutex_clear(pool_queue->mutex);
+}
+
+static GSocketConnection* j_connection_pool_connect(JConnectionPoolQueue*, gchar const*);
+
+/**
+ * Accounts an error for a server.
+ *
+ * \private
+ **/
+static void
+j_connection_pool_add_error(JConnectionPoolQueue* pool_queue)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_mutex_lock(pool_queue->mutex);
+	pool_queue->statistics.errors++;
+	g_mutex_unlock(pool_queue->mutex);
+}
+
+/**
+ * Returns the queue and server for a backend type and index.
+ *
+ * \private
+ **/
+static JConnectionPoolQueue*
+j_connection_pool_get_queue(JConnectionPool* pool, JBackendType backend, guint index, gchar const** server)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	*server = j_configuration_get_server(pool->configuration, backend, index);
+
+	switch (backend)
 	{
-		pool->db_queues[i].queue = g_async_queue_new();
-		pool->db_queues[i].count = 0;
+		case J_BACKEND_TYPE_OBJECT:
+			return &(pool->object_queues[index]);
+		case J_BACKEND_TYPE_KV:
+			return &(pool->kv_queues[index]);
+		case J_BACKEND_TYPE_DB:
+			return &(pool->db_queues[index]);
+		default:
+			g_assert_not_reached();
 	}
 
-	g_atomic_pointer_set(&j_connection_pool, pool);
+	return NULL;
 }
 
-void
-j_connection_pool_fini(void)
+/**
+ * Establishes the configured number of connections to a server.
+ * Runs in the warm-up thread pool, so multiple servers are connected to in parallel.
+ *
+ * \private
+ **/
+static void
+j_connection_pool_warm_up(gpointer data, gpointer user_data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JConnectionPool* pool;
+	JConnectionPoolWarmUp* warm_up = data;
+	JConnectionPool* pool = user_data;
 
-	g_return_if_fail(j_connection_pool != NULL);
+	JConnectionPoolQueue* pool_queue;
+	gchar const* server;
+	guint count;
 
-	pool = g_atomic_pointer_get(&j_connection_pool);
-	g_atomic_pointer_set(&j_connection_pool, NULL);
+	pool_queue = j_connection_pool_get_queue(pool, warm_up->backend, warm_up->index, &server);
+	count = MIN(j_configuration_get_warm_up_connections(pool->configuration), g_atomic_int_get(&(pool_queue->limit)));
 
-	for (guint i = 0; i < pool->object_len; i++)
+	g_usleep(g_random_int_range(0, J_CONNECTION_POOL_WARM_UP_JITTER));
+
+	for (guint i = 0; i < count; i++)
 	{
 		GSocketConnection* connection;
 
-		while ((connection = g_async_queue_try_pop(pool->object_queues[i].queue)) != NULL)
+		// Connections may have been established on demand in the meantime.
+		if ((guint)g_atomic_int_add(&(pool_queue->count), 1) >= (guint)g_atomic_int_get(&(pool_queue->limit)))
 		{
-			g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
-			g_object_unref(connection);
+			g_atomic_int_add(&(pool_queue->count), -1);
+			break;
 		}
 
-		g_async_queue_unref(pool->object_queues[i].queue);
-	}
+		connection = j_connection_pool_connect(pool_queue, server);
 
-	for (guint i = 0; i < pool->kv_len; i++)
-	{
-		GSocketConnection* connection;
+		if (connection == NULL)
+		{
+			g_atomic_int_add(&(pool_queue->count), -1);
+			break;
+		}
 
-		while ((connection = g_async_queue_try_pop(pool->kv_queues[i].queue)) != NULL)
+		if (warm_up->backend != J_BACKEND_TYPE_OBJECT)
 		{
-			g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
-			g_object_unref(connection);
+			j_message_multiplex_start(connection);
 		}
 
-		g_async_queue_unref(pool->kv_queues[i].queue);
+		g_async_queue_push(pool_queue->queue, connection);
 	}
 
-	for (guint i = 0; i < pool->db_len; i++)
-	{
-		GSocketConnection* connection;
+	g_slice_free(JConnectionPoolWarmUp, warm_up);
+}
 
-		while ((connection = g_async_queue_try_pop(pool->db_queues[i].queue)) != NULL)
-		{
-			g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
-			g_object_unref(connection);
-		}
+/**
+ * Checks whether an idle connection is still alive.
+ *
+ * Idle exclusive connections must not have pending input, as servers never
+ * send unsolicited messages; readable data only occurs if the server has
+ * closed the connection. Shared connections are checked by their multiplexer.
+ *
+ * \private
+ **/
+static gboolean
+j_connection_pool_is_alive(GSocketConnection* connection, gboolean shared)
+{
+	J_TRACE_FUNCTION(NULL);
 
-		g_async_queue_unref(pool->db_queues[i].queue);
-	}
+	GSocket* socket_;
 
-	j_configuration_unref(pool->configuration);
+	if (shared)
+	{
+		return !j_message_multiplex_failed(connection);
+	}
 
-	g_free(pool->object_queues);
-	g_free(pool->kv_queues);
-	g_free(pool->db_queues);
+	socket_ = g_socket_connection_get_socket(connection);
 
-	g_slice_free(JConnectionPool, pool);
+	return (g_socket_is_connected(socket_) && g_socket_condition_check(socket_, G_IO_IN | G_IO_ERR | G_IO_HUP) == 0);
 }
 
-static GSocketConnection*
-j_connection_pool_pop_internal(GAsyncQueue* queue, guint* count, gchar const* server)
+/**
+ * Drops dead connections from a queue.
+ * The connections are reestablished on demand.
+ *
+ * \private
+ **/
+static void
+j_connection_pool_check(JConnectionPoolQueue* pool_queue, gboolean shared)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	GSocketConnection* connection;
-
-	g_return_val_if_fail(queue != NULL, NULL);
-	g_return_val_if_fail(count != NULL, NULL);
+	gint length;
 
-	connection = g_async_queue_try_pop(queue);
+	length = g_async_queue_length(pool_queue->queue);
 
-	if (connection != NULL)
+	for (gint i = 0; i < length; i++)
 	{
-		return connection;
-	}
+		GSocketConnection* connection;
 
-	if ((guint)g_atomic_int_get(count) < j_connection_pool->max_count)
-	{
-		if ((guint)g_atomic_int_add(count, 1) < j_connection_pool->max_count)
+		connection = g_async_queue_try_pop(pool_queue->queue);
+
+		if (connection == NULL)
 		{
-			GError* error = NULL;
-			g_autoptr(GSocketClient) client = NULL;
+			break;
+		}
 
-			g_autoptr(JMessage) message = NULL;
-			g_autoptr(JMessage) reply = NULL;
+		if (j_connection_pool_is_alive(connection, shared))
+		{
+			g_async_queue_push(pool_queue->queue, connection);
+			continue;
+		}
 
-			guint op_count;
+		g_debug("Dropping dead connection.");
+		j_connection_pool_add_error(pool_queue);
 
-			client = g_socket_client_new();
-			connection = g_socket_client_connect_to_host(client, server, 4711, NULL, &error);
+		// Shared connections might still be referenced by other requests and are closed when they are finalized.
+		if (!shared)
+		{
+			g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+		}
 
-			if (error != NULL)
-			{
-				g_critical("%s", error->message);
-				g_error_free(error);
-			}
+		g_object_unref(connection);
+		g_atomic_int_add(&(pool_queue->count), -1);
+	}
+}
 
-			if (connection == NULL)
-			{
-				g_critical("Can not connect to %s [%d].", server, g_atomic_int_get(count));
-			}
+static gpointer
+j_connection_pool_health_check(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
 
-			j_helper_set_nodelay(connection, TRUE);
+	JConnectionPool* pool = data;
 
-			message = j_message_new(J_MESSAGE_PING, 0);
-			j_message_send(message, connection);
+	while (TRUE)
+	{
+		gboolean stop;
+		gint64 end_time;
 
-			reply = j_message_new_reply(message);
-			j_message_receive(reply, connection);
+		end_time = g_get_monotonic_time() + pool->health_check_interval * G_TIME_SPAN_SECOND;
 
-			op_count = j_message_get_count(reply);
+		g_mutex_lock(pool->health_check_mutex);
 
-			for (guint i = 0; i < op_count; i++)
-			{
-				gchar const* backend;
-
-				backend = j_message_get_string(reply);
-
-				if (g_strcmp0(backend, "object") == 0)
-				{
-					//g_print("Server has object backend.\n");
-				}
-				else if (g_strcmp0(backend, "kv") == 0)
-				{
-					//g_print("Server has kv backend.\n");
-				}
-				else if (g_strcmp0(backend, "db") == 0)
-				{
-					//g_print("Server has db backend.\n");
-				}
-			}
+		while (!pool->health_check_stop && g_cond_wait_until(pool->health_check_cond, pool->health_check_mutex, end_time))
+		{
 		}
-		else
+
+		stop = pool->health_check_stop;
+
+		g_mutex_unlock(pool->health_check_mutex);
+
+		if (stop)
 		{
-			g_atomic_int_add(count, -1);
+			break;
 		}
-	}
 
-	if (connection != NULL)
-	{
-		return connection;
-	}
+		for (guint i = 0; i < pool->object_len; i++)
+		{
+			j_connection_pool_check(&(pool->object_queues[i]), FALSE);
+		}
 
-	connection = g_async_queue_pop(queue);
+		for (guint i = 0; i < pool->kv_len; i++)
+		{
+			j_connection_pool_check(&(pool->kv_queues[i]), TRUE);
+		}
 
-	return connection;
+		for (guint i = 0; i < pool->db_len; i++)
+		{
+			j_connection_pool_check(&(pool->db_queues[i]), TRUE);
+		}
+	}
+
+	return NULL;
 }
 
+/**
+ * Starts warming up connections to all servers.
+ *
+ * \private
+ **/
 static void
-j_connection_pool_push_internal(GAsyncQueue* queue, GSocketConnection* connection)
+j_connection_pool_start_warm_up(JConnectionPool* pool)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	g_return_if_fail(queue != NULL);
-	g_return_if_fail(connection != NULL);
+	JBackendType backends[] = { J_BACKEND_TYPE_OBJECT, J_BACKEND_TYPE_KV, J_BACKEND_TYPE_DB };
+	guint lens[] = { pool->object_len, pool->kv_len, pool->db_len };
+
+	pool->warm_up = g_thread_pool_new(j_connection_pool_warm_up, pool, J_CONNECTION_POOL_WARM_UP_THREADS, FALSE, NULL);
 
-	g_async_queue_push(queue, connection);
+	for (guint i = 0; i < G_N_ELEMENTS(backends); i++)
+	{
+		for (guint j = 0; j < lens[i]; j++)
+		{
+			JConnectionPoolWarmUp* warm_up;
+
+			warm_up = g_slice_new(JConnectionPoolWarmUp);
+			warm_up->backend = backends[i];
+			warm_up->index = j;
+
+			g_thread_pool_push(pool->warm_up, warm_up, NULL);
+		}
+	}
 }
 
-gpointer
-j_connection_pool_pop(JBackendType backend, guint index)
+void
+j_connection_pool_init(JConfiguration* configuration)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	g_return_val_if_fail(j_connection_pool != NULL, NULL);
+	JConnectionPool* pool;
 
-	switch (backend)
+	g_return_if_fail(j_connection_pool == NULL);
+
+	pool = g_slice_new(JConnectionPool);
+	pool->configuration = j_configuration_ref(configuration);
+	pool->object_len = j_configuration_get_server_count(configuration, J_BACKEND_TYPE_OBJECT);
+	pool->object_queues = g_new(JConnectionPoolQueue, pool->object_len);
+	// Replicas are addressed by the server indices following the primaries'.
+	pool->kv_len = j_configuration_get_server_count(configuration, J_BACKEND_TYPE_KV) + j_configuration_get_replica_count(configuration, J_BACKEND_TYPE_KV);
+	pool->kv_queues = g_new(JConnectionPoolQueue, pool->kv_len);
+	pool->db_len = j_configuration_get_server_count(configuration, J_BACKEND_TYPE_DB) + j_configuration_get_replica_count(configuration, J_BACKEND_TYPE_DB);
+	pool->db_queues = g_new(JConnectionPoolQueue, pool->db_len);
+	pool->read_counter = 0;
+	pool->adaptive = j_configuration_get_adaptive_connections(configuration);
+	pool->warm_up = NULL;
+	pool->health_check = NULL;
+	pool->health_check_interval = j_configuration_get_health_check_interval(configuration);
+	pool->health_check_stop = FALSE;
+
+	g_mutex_init(pool->health_check_mutex);
+	g_cond_init(pool->health_check_cond);
+
+	for (guint i = 0; i < pool->object_len; i++)
 	{
-		case J_BACKEND_TYPE_OBJECT:
-			g_return_val_if_fail(index < j_connection_pool->object_len, NULL);
-			return j_connection_pool_pop_internal(j_connection_pool->object_queues[index].queue, &(j_connection_pool->object_queues[index].count), j_configuration_get_server(j_connection_pool->configuration, J_BACKEND_TYPE_OBJECT, index));
-		case J_BACKEND_TYPE_KV:
-			g_return_val_if_fail(index < j_connection_pool->kv_len, NULL);
-			return j_connection_pool_pop_internal(j_connection_pool->kv_queues[index].queue, &(j_connection_pool->kv_queues[index].count), j_configuration_get_server(j_connection_pool->configuration, J_BACKEND_TYPE_KV, index));
-		case J_BACKEND_TYPE_DB:
-			g_return_val_if_fail(index < j_connection_pool->db_len, NULL);
-			return j_connection_pool_pop_internal(j_connection_pool->db_queues[index].queue, &(j_connection_pool->db_queues[index].count), j_configuration_get_server(j_connection_pool->configuration, J_BACKEND_TYPE_DB, index));
-		default:
-			g_assert_not_reached();
+		j_connection_pool_queue_init(&(pool->object_queues[i]), j_configuration_get_backend_max_connections(configuration, J_BACKEND_TYPE_OBJECT), pool->adaptive);
 	}
 
-	return NULL;
+	// Shared connections are multiplexed, so their limits are not adaptive.
+	for (guint i = 0; i < pool->kv_len; i++)
+	{
+		j_connection_pool_queue_init(&(pool->kv_queues[i]), j_configuration_get_backend_max_connections(configuration, J_BACKEND_TYPE_KV), FALSE);
+	}
+
+	for (guint i = 0; i < pool->db_len; i++)
+	{
+		j_connection_pool_queue_init(&(pool->db_queues[i]), j_configuration_get_backend_max_connections(configuration, J_BACKEND_TYPE_DB), FALSE);
+	}
+
+	g_atomic_pointer_set(&j_connection_pool, pool);
+
+	if (j_configuration_get_warm_up_connections(configuration) > 0)
+	{
+		j_connection_pool_start_warm_up(pool);
+	}
+
+	if (pool->health_check_interval > 0)
+	{
+		pool->health_check = g_thread_new("JConnectionPoolHealthCheck", j_connection_pool_health_check, pool);
+	}
 }
 
 void
-j_connection_pool_push(JBackendType backend, guint index, gpointer connection)
+j_connection_pool_fini(void)
 {
 	J_TRACE_FUNCTION(NULL);
 
+	JConnectionPool* pool;
+
 	g_return_if_fail(j_connection_pool != NULL);
-	g_return_if_fail(connection != NULL);
 
-	switch (backend)
+	pool = g_atomic_pointer_get(&j_connection_pool);
+
+	if (pool->warm_up != NULL)
 	{
-		case J_BACKEND_TYPE_OBJECT:
-			g_return_if_fail(index < j_connection_pool->object_len);
-			j_connection_pool_push_internal(j_connection_pool->object_queues[index].queue, connection);
-			break;
-		case J_BACKEND_TYPE_KV:
-			g_return_if_fail(index < j_connection_pool->kv_len);
-			j_connection_pool_push_internal(j_connection_pool->kv_queues[index].queue, connection);
-			break;
-		case J_BACKEND_TYPE_DB:
-			g_return_if_fail(index < j_connection_pool->db_len);
-			j_connection_pool_push_internal(j_connection_pool->db_queues[index].queue, connection);
-			break;
-		default:
-			g_assert_not_reached();
+		g_thread_pool_free(pool->warm_up, FALSE, TRUE);
+	}
+
+	if (pool->health_check != NULL)
+	{
+		g_mutex_lock(pool->health_check_mutex);
+		pool->health_check_stop = TRUE;
+		g_cond_signal(pool->health_check_cond);
+		g_mutex_unlock(pool->health_check_mutex);
+
+		g_thread_join(pool->health_check);
+	}
+
+	g_mutex_clear(pool->health_check_mutex);
+	g_cond_clear(pool->health_check_cond);
+
+	g_atomic_pointer_set(&j_connection_pool, NULL);
+
+	for (guint i = 0; i < pool->object_len; i++)
+	{
+		j_connection_pool_queue_fini(&(pool->object_queues[i]));
 	}
+
+	for (guint i = 0; i < pool->kv_len; i++)
+	{
+		j_connection_pool_queue_fini(&(pool->kv_queues[i]));
+	}
+
+	for (guint i = 0; i < pool->db_len; i++)
+	{
+		j_connection_pool_queue_fini(&(pool->db_queues[i]));
+	}
+
+	j_configuration_unref(pool->configuration);
+
+	g_free(pool->object_queues);
+	g_free(pool->kv_queues);
+	g_free(pool->db_queues);
+
+	g_slice_free(JConnectionPool, pool);
+}
+
+static GSocketConnection*
+j_connection_pool_connect(JConnectionPoolQueue* pool_queue, gchar const* server)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GSocketConnection* connection;
+	GError* error = NULL;
+
+	g_autoptr(JMessage) message = NULL;
+	g_autoptr(JMessage) reply = NULL;
+
+	gchar const* compression;
+	guint op_count;
+
+	connection = j_transport_connect(server, &error);
+
+	if (error != NULL)
+	{
+		g_warning("%s", error->message);
+		g_error_free(error);
+	}
+
+	if (connection == NULL)
+	{
+		g_warning("Can not connect to %s [%d].", server, g_atomic_int_get(&(pool_queue->count)));
+		j_connection_pool_add_error(pool_queue);
+		return NULL;
+	}
+
+	// Allows j_connection_pool_account() to find the server's statistics.
+	g_object_set_qdata(G_OBJECT(connection), j_connection_pool_queue_quark(), pool_queue);
+
+	message = j_message_new(J_MESSAGE_PING, 0);
+	compression = j_configuration_get_compression(j_connection_pool->configuration);
+
+	if (compression != NULL && j_message_compression_supported(compression))
+	{
+		g_autofree gchar* request = NULL;
+
+		// The server enables compression if it supports the codec, too.
+		request = g_strdup_printf("compression:%s", compression);
+		j_message_add_operation(message, strlen(request) + 1);
+		j_message_append_string(message, request);
+	}
+
+	// The server confirms that it understands the compact encoding, older servers ignore the request.
+	if (j_configuration_get_compact_messages(j_connection_pool->configuration))
+	{
+		j_message_add_operation(message, strlen("compact") + 1);
+		j_message_append_string(message, "compact");
+	}
+
+	reply = j_message_new_reply(message);
+
+	if (!j_message_send(message, connection) || !j_message_receive(reply, connection))
+	{
+		g_warning("Can not establish connection to %s.", server);
+		j_connection_pool_add_error(pool_queue);
+		g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+		g_object_unref(connection);
+		return NULL;
+	}
+
+	op_count = j_message_get_count(reply);
+
+	for (guint i = 0; i < op_count; i++)
+	{
+		gchar const* backend;
+
+		backend = j_message_get_string(reply);
+
+		if (g_strcmp0(backend, "object") == 0)
+		{
+			//g_print("Server has object backend.\n");
+		}
+		else if (g_strcmp0(backend, "kv") == 0)
+		{
+			//g_print("Server has kv backend.\n");
+		}
+		else if (g_strcmp0(backend, "db") == 0)
+		{
+			//g_print("Server has db backend.\n");
+		}
+		else if (g_str_has_prefix(backend, "compression:"))
+		{
+			j_message_set_compression(connection, backend + strlen("compression:"));
+		}
+		else if (g_strcmp0(backend, "compact") == 0)
+		{
+			j_message_set_compact(connection, TRUE);
+		}
+	}
+
+	return connection;
+}
+
+/**
+ * Raises an adaptive connection limit if the service time has stayed flat.
+ * Called when a request would otherwise have to wait for a connection.
+ *
+ * \private
+ **/
+static void
+j_connection_pool_grow(JConnectionPoolQueue* pool_queue)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_mutex_lock(pool_queue->mutex);
+
+	if (pool_queue->limit < pool_queue->max_count
+	    && (guint)g_atomic_int_get(&(pool_queue->count)) >= pool_queue->limit
+	    && (pool_queue->service_time_baseline == 0 || pool_queue->service_time <= pool_queue->service_time_baseline * 5 / 4))
+	{
+		pool_queue->service_time_baseline = pool_queue->service_time;
+		g_atomic_int_inc(&(pool_queue->limit));
+	}
+
+	g_mutex_unlock(pool_queue->mutex);
+}
+
+/**
+ * Records a connection's service time and lowers an adaptive connection limit if it has risen.
+ *
+ * \private
+ *
+ * \return TRUE if the connection should be closed, FALSE otherwise.
+ **/
+static gboolean
+j_connection_pool_shrink(JConnectionPoolQueue* pool_queue, GSocketConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	gint64* pop_time;
+	gint64 service_time;
+
+	pop_time = g_object_get_qdata(G_OBJECT(connection), j_connection_pool_pop_time_quark());
+
+	if (pop_time == NULL)
+	{
+		return FALSE;
+	}
+
+	service_time = g_get_monotonic_time() - *pop_time;
+
+	g_mutex_lock(pool_queue->mutex);
+
+	pool_queue->service_time = (pool_queue->service_time == 0) ? service_time : (pool_queue->service_time * 7 + service_time) / 8;
+
+	// More connections only add load if the server's service time rises.
+	if (pool_queue->limit > 1
+	    && pool_queue->service_time_baseline > 0
+	    && pool_queue->service_time > pool_queue->service_time_baseline * 3 / 2)
+	{
+		pool_queue->service_time_baseline = pool_queue->service_time;
+		g_atomic_int_add(&(pool_queue->limit), -1);
+	}
+
+	if ((guint)g_atomic_int_get(&(pool_queue->count)) > pool_queue->limit)
+	{
+		g_atomic_int_add(&(pool_queue->count), -1);
+		ret = TRUE;
+	}
+
+	g_mutex_unlock(pool_queue->mutex);
+
+	return ret;
+}
+
+static GSocketConnection*
+j_connection_pool_pop_internal(JConnectionPoolQueue* pool_queue, gchar const* server)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GSocketConnection* connection;
+	guint limit;
+
+	g_return_val_if_fail(pool_queue != NULL, NULL);
+
+	connection = g_async_queue_try_pop(pool_queue->queue);
+
+	if (connection != NULL)
+	{
+		goto end;
+	}
+
+	if (j_connection_pool->adaptive)
+	{
+		j_connection_pool_grow(pool_queue);
+	}
+
+	limit = g_atomic_int_get(&(pool_queue->limit));
+
+	if ((guint)g_atomic_int_get(&(pool_queue->count)) < limit)
+	{
+		if ((guint)g_atomic_int_add(&(pool_queue->count), 1) < limit)
+		{
+			if ((connection = j_connection_pool_connect(pool_queue, server)) == NULL)
+			{
+				// Waiting for a connection to be returned would block forever if the server is unreachable
+				g_atomic_int_add(&(pool_queue->count), -1);
+				return NULL;
+			}
+		}
+		else
+		{
+			g_atomic_int_add(&(pool_queue->count), -1);
+		}
+	}
+
+	if (connection == NULL)
+	{
+		connection = g_async_queue_pop(pool_queue->queue);
+	}
+
+end:
+	if (j_connection_pool->adaptive && connection != NULL)
+	{
+		gint64* pop_time;
+
+		pop_time = g_object_get_qdata(G_OBJECT(connection), j_connection_pool_pop_time_quark());
+
+		if (pop_time == NULL)
+		{
+			pop_time = g_new(gint64, 1);
+			g_object_set_qdata_full(G_OBJECT(connection), j_connection_pool_pop_time_quark(), pop_time, g_free);
+		}
+
+		*pop_time = g_get_monotonic_time();
+	}
+
+	return connection;
+}
+
+/**
+ * Returns a shared connection.
+ *
+ * Shared connections stay in the queue while they are in use, so that
+ * multiple requests can be in flight on the same connection at once.
+ * Replies are matched to their requests by j_message_receive().
+ * Up to the queue's limit of connections are established, which are then
+ * handed out in round-robin fashion.
+ *
+ * \private
+ **/
+static GSocketConnection*
+j_connection_pool_pop_shared_internal(JConnectionPoolQueue* pool_queue, gchar const* server)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GSocketConnection* connection = NULL;
+
+	g_return_val_if_fail(pool_queue != NULL, NULL);
+
+	if ((guint)g_atomic_int_get(&(pool_queue->count)) < pool_queue->limit)
+	{
+		if ((guint)g_atomic_int_add(&(pool_queue->count), 1) < pool_queue->limit)
+		{
+			if ((connection = j_connection_pool_connect(pool_queue, server)) == NULL)
+			{
+				g_atomic_int_add(&(pool_queue->count), -1);
+				return NULL;
+			}
+		}
+		else
+		{
+			g_atomic_int_add(&(pool_queue->count), -1);
+		}
+	}
+
+	if (connection != NULL)
+	{
+		j_message_multiplex_start(connection);
+	}
+	else
+	{
+		connection = g_async_queue_pop(pool_queue->queue);
+	}
+
+	g_async_queue_push(pool_queue->queue, g_object_ref(connection));
+
+	return connection;
+}
+
+static void
+j_connection_pool_push_internal(JConnectionPoolQueue* pool_queue, GSocketConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(pool_queue != NULL);
+	g_return_if_fail(connection != NULL);
+
+	if (j_connection_pool->adaptive && j_connection_pool_shrink(pool_queue, connection))
+	{
+		g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+		g_object_unref(connection);
+		return;
+	}
+
+	g_async_queue_push(pool_queue->queue, connection);
+}
+
+gpointer
+j_connection_pool_pop(JBackendType backend, guint index)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(j_connection_pool != NULL, NULL);
+
+	switch (backend)
+	{
+		case J_BACKEND_TYPE_OBJECT:
+			g_return_val_if_fail(index < j_connection_pool->object_len, NULL);
+			return j_connection_pool_pop_internal(&(j_connection_pool->object_queues[index]), j_configuration_get_server(j_connection_pool->configuration, J_BACKEND_TYPE_OBJECT, index));
+		case J_BACKEND_TYPE_KV:
+			g_return_val_if_fail(index < j_connection_pool->kv_len, NULL);
+			return j_connection_pool_pop_shared_internal(&(j_connection_pool->kv_queues[index]), j_configuration_get_server(j_connection_pool->configuration, J_BACKEND_TYPE_KV, index));
+		case J_BACKEND_TYPE_DB:
+			g_return_val_if_fail(index < j_connection_pool->db_len, NULL);
+			return j_connection_pool_pop_shared_internal(&(j_connection_pool->db_queues[index]), j_configuration_get_server(j_connection_pool->configuration, J_BACKEND_TYPE_DB, index));
+		default:
+			g_assert_not_reached();
+	}
+
+	return NULL;
+}
+
+void
+j_connection_pool_push(JBackendType backend, guint index, gpointer connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(j_connection_pool != NULL);
+	g_return_if_fail(connection != NULL);
+
+	switch (backend)
+	{
+		case J_BACKEND_TYPE_OBJECT:
+			g_return_if_fail(index < j_connection_pool->object_len);
+			j_connection_pool_push_internal(&(j_connection_pool->object_queues[index]), connection);
+			break;
+		case J_BACKEND_TYPE_KV:
+			g_return_if_fail(index < j_connection_pool->kv_len);
+			// Shared connections are still part of the queue.
+			g_object_unref(connection);
+			break;
+		case J_BACKEND_TYPE_DB:
+			g_return_if_fail(index < j_connection_pool->db_len);
+			g_object_unref(connection);
+			break;
+		default:
+			g_assert_not_reached();
+	}
+}
+
+/**
+ * Drops a connection that failed instead of returning it to the pool.
+ * The connection is reestablished on demand.
+ *
+ * \code
+ * \endcode
+ *
+ * \param backend    A backend type.
+ * \param index      A server index.
+ * \param connection A connection returned by j_connection_pool_pop().
+ **/
+void
+j_connection_pool_discard(JBackendType backend, guint index, gpointer connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConnectionPoolQueue* pool_queue;
+	gchar const* server;
+
+	g_return_if_fail(j_connection_pool != NULL);
+	g_return_if_fail(connection != NULL);
+	g_return_if_fail(index < j_configuration_get_server_count(j_connection_pool->configuration, backend) + j_configuration_get_replica_count(j_connection_pool->configuration, backend));
+
+	pool_queue = j_connection_pool_get_queue(j_connection_pool, backend, index, &server);
+
+	g_debug("Dropping failed connection to %s.", server);
+
+	if (backend == J_BACKEND_TYPE_OBJECT)
+	{
+		g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+		g_atomic_int_add(&(pool_queue->count), -1);
+	}
+	else if (g_async_queue_remove(pool_queue->queue, connection))
+	{
+		// Shared connections might still be referenced by other requests and are closed when they are finalized.
+		g_object_unref(connection);
+		g_atomic_int_add(&(pool_queue->count), -1);
+	}
+
+	g_object_unref(connection);
+}
+
+/**
+ * Waits before retrying an idempotent request that failed because of a network error.
+ * The delay starts at the configured retry delay and doubles with every attempt.
+ *
+ * \code
+ * for (guint attempt = 0; attempt == 0 || j_connection_pool_backoff(attempt); attempt++)
+ * {
+ *   if (request_succeeded())
+ *   {
+ *     break;
+ *   }
+ * }
+ * \endcode
+ *
+ * \param attempt The number of failed attempts so far.
+ *
+ * \return TRUE if the request should be retried, FALSE if all retries have been used.
+ **/
+gboolean
+j_connection_pool_backoff(guint attempt)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 delay;
+
+	g_return_val_if_fail(j_connection_pool != NULL, FALSE);
+	g_return_val_if_fail(attempt > 0, FALSE);
+
+	if (attempt > j_configuration_get_retries(j_connection_pool->configuration))
+	{
+		return FALSE;
+	}
+
+	delay = (guint64)j_configuration_get_retry_delay(j_connection_pool->configuration) * G_TIME_SPAN_MILLISECOND;
+	delay <<= MIN(attempt - 1, 10);
+
+	// Jitter keeps clients that failed at the same time from retrying in lockstep
+	delay += g_random_double_range(0, delay / 2.0);
+
+	g_usleep(delay);
+
+	return TRUE;
+}
+
+/**
+ * Sends a request on a connection from the pool and receives its reply.
+ * Failed connections are discarded.
+ *
+ * \private
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_connection_pool_attempt(JBackendType backend, guint index, JMessage* message, JMessage* reply)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gpointer connection;
+
+	if ((connection = j_connection_pool_pop(backend, index)) == NULL)
+	{
+		return FALSE;
+	}
+
+	if (j_message_send(message, connection) && j_message_receive(reply, connection))
+	{
+		j_connection_pool_push(backend, index, connection);
+		return TRUE;
+	}
+
+	j_connection_pool_discard(backend, index, connection);
+
+	return FALSE;
+}
+
+/**
+ * Retries an idempotent request whose first attempt failed because of a network error.
+ * Each retry uses a new connection and waits as described for j_connection_pool_backoff().
+ * Only requests that can safely be executed more than once may be retried, since the server might have executed the failed attempt.
+ *
+ * \code
+ * \endcode
+ *
+ * \param backend A backend type.
+ * \param index   A server index.
+ * \param message A message.
+ * \param reply   The reply, created with j_message_new_reply().
+ *
+ * \return TRUE if a retry succeeded, FALSE if all retries failed.
+ **/
+gboolean
+j_connection_pool_retry(JBackendType backend, guint index, JMessage* message, JMessage* reply)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(message != NULL, FALSE);
+	g_return_val_if_fail(reply != NULL, FALSE);
+
+	for (guint attempt = 1; j_connection_pool_backoff(attempt); attempt++)
+	{
+		if (j_connection_pool_attempt(backend, index, message, reply))
+		{
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/**
+ * Sends an idempotent request and receives its reply.
+ * Failed attempts are retried with j_connection_pool_retry().
+ *
+ * \code
+ * \endcode
+ *
+ * \param backend A backend type.
+ * \param index   A server index.
+ * \param message A message.
+ * \param reply   The reply, created with j_message_new_reply().
+ *
+ * \return TRUE on success, FALSE if all attempts failed.
+ **/
+gboolean
+j_connection_pool_exchange(JBackendType backend, guint index, JMessage* message, JMessage* reply)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(message != NULL, FALSE);
+	g_return_val_if_fail(reply != NULL, FALSE);
+
+	return j_connection_pool_attempt(backend, index, message, reply) || j_connection_pool_retry(backend, index, message, reply);
+}
+
+/**
+ * Chooses the server to send a read to, either the server itself or one of its replicas.
+ * The choices are made in round-robin fashion.
+ * Since replicas receive changes asynchronously, this must only be used for reads that do not have to see the latest changes.
+ *
+ * \code
+ * \endcode
+ *
+ * \param backend A backend type.
+ * \param index   A server index.
+ *
+ * \return The index of the server or one of its replicas.
+ **/
+guint
+j_connection_pool_get_read_index(JBackendType backend, guint index)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint servers;
+	guint replicas;
+	guint choice;
+
+	if (j_connection_pool == NULL)
+	{
+		return index;
+	}
+
+	servers = j_configuration_get_server_count(j_connection_pool->configuration, backend);
+	replicas = j_configuration_get_replica_count(j_connection_pool->configuration, backend);
+
+	// Replica r belongs to the server with index r modulo servers.
+	if (index >= servers || index >= replicas)
+	{
+		return index;
+	}
+
+	choice = (guint)g_atomic_int_add(&(j_connection_pool->read_counter), 1) % ((replicas - index - 1) / servers + 2);
+
+	if (choice == 0)
+	{
+		return index;
+	}
+
+	return servers + index + (choice - 1) * servers;
+}
+
+/**
+ * Returns the number of connections to a server that are currently in use.
+ *
+ * \code
+ * \endcode
+ *
+ * \param backend A backend type.
+ * \param index   A server index.
+ *
+ * \return The number of connections in use, 0 if the pool has not been initialized.
+ **/
+guint
+j_connection_pool_get_load(JBackendType backend, guint index)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConnectionPoolQueue* pool_queue;
+	gchar const* server;
+	gint count;
+	gint idle;
+
+	if (j_connection_pool == NULL || index >= j_configuration_get_server_count(j_connection_pool->configuration, backend) + j_configuration_get_replica_count(j_connection_pool->configuration, backend))
+	{
+		return 0;
+	}
+
+	pool_queue = j_connection_pool_get_queue(j_connection_pool, backend, index, &server);
+
+	if (pool_queue == NULL)
+	{
+		return 0;
+	}
+
+	count = g_atomic_int_get(&(pool_queue->count));
+	idle = g_async_queue_length(pool_queue->queue);
+
+	return (count > idle) ? (guint)(count - idle) : 0;
+}
+
+/**
+ * Returns statistics about the connections to all servers of a backend type.
+ *
+ * \code
+ * \endcode
+ *
+ * \param backend A backend type.
+ *
+ * \return The number of established and idle connections as well as the current limit.
+ *         Should be freed with j_statistics_free().
+ **/
+JStatistics*
+j_connection_pool_get_statistics(JBackendType backend)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JStatistics* statistics;
+	JConnectionPoolQueue* queues = NULL;
+	guint len = 0;
+
+	g_return_val_if_fail(j_connection_pool != NULL, NULL);
+
+	switch (backend)
+	{
+		case J_BACKEND_TYPE_OBJECT:
+			queues = j_connection_pool->object_queues;
+			len = j_connection_pool->object_len;
+			break;
+		case J_BACKEND_TYPE_KV:
+			queues = j_connection_pool->kv_queues;
+			len = j_connection_pool->kv_len;
+			break;
+		case J_BACKEND_TYPE_DB:
+			queues = j_connection_pool->db_queues;
+			len = j_connection_pool->db_len;
+			break;
+		default:
+			g_assert_not_reached();
+	}
+
+	statistics = j_statistics_new(FALSE);
+
+	for (guint i = 0; i < len; i++)
+	{
+		gint idle;
+
+		idle = g_async_queue_length(queues[i].queue);
+
+		j_statistics_add(statistics, J_STATISTICS_CONNECTIONS, g_atomic_int_get(&(queues[i].count)));
+		j_statistics_add(statistics, J_STATISTICS_CONNECTIONS_IDLE, MAX(idle, 0));
+		j_statistics_add(statistics, J_STATISTICS_CONNECTIONS_LIMIT, g_atomic_int_get(&(queues[i].limit)));
+	}
+
+	return statistics;
+}
+
+/**
+ * Returns the smoothed round-trip latency of a server.
+ * Can be used to avoid slow servers, for example, when choosing between replicas.
+ *
+ * \code
+ * \endcode
+ *
+ * \param backend A backend type.
+ * \param index   A server index.
+ *
+ * \return The latency in microseconds, 0 if no reply has been received from the server yet.
+ **/
+guint64
+j_connection_pool_get_latency(JBackendType backend, guint index)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConnectionPoolServerStatistics statistics;
+
+	if (!j_connection_pool_get_server_statistics(backend, index, &statistics))
+	{
+		return 0;
+	}
+
+	return statistics.latency;
+}
+
+/**
+ * Returns an estimate of the 95th percentile of a server's round-trip latency.
+ * The estimate is derived from the smoothed latency and its mean deviation, so it adapts to changing conditions.
+ * Can be used to decide when a request is late, for example, to send a hedged request to another replica.
+ *
+ * \code
+ * \endcode
+ *
+ * \param backend A backend type.
+ * \param index   A server index.
+ *
+ * \return The latency in microseconds, 0 if no reply has been received from the server yet.
+ **/
+guint64
+j_connection_pool_get_latency_p95(JBackendType backend, guint index)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConnectionPoolServerStatistics statistics;
+
+	if (!j_connection_pool_get_server_statistics(backend, index, &statistics))
+	{
+		return 0;
+	}
+
+	// The mean deviation is about 0.8 standard deviations, which puts the 95th percentile about two of them above the mean
+	return statistics.latency + 2 * statistics.latency_deviation;
+}
+
+/**
+ * Returns client-side statistics about a server.
+ * Only the messages exchanged by the current process are accounted.
+ *
+ * \code
+ * JConnectionPoolServerStatistics statistics;
+ *
+ * if (j_connection_pool_get_server_statistics(J_BACKEND_TYPE_OBJECT, 0, &statistics))
+ * {
+ *   g_print("%" G_GUINT64_FORMAT " µs\n", statistics.latency);
+ * }
+ * \endcode
+ *
+ * \param backend    A backend type.
+ * \param index      A server index.
+ * \param statistics Returns the statistics.
+ *
+ * \return TRUE on success, FALSE if the pool has not been initialized or the server does not exist.
+ **/
+gboolean
+j_connection_pool_get_server_statistics(JBackendType backend, guint index, JConnectionPoolServerStatistics* statistics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConnectionPoolQueue* pool_queue;
+	gchar const* server;
+
+	g_return_val_if_fail(statistics != NULL, FALSE);
+
+	if (j_connection_pool == NULL || index >= j_configuration_get_server_count(j_connection_pool->configuration, backend) + j_configuration_get_replica_count(j_connection_pool->configuration, backend))
+	{
+		return FALSE;
+	}
+
+	pool_queue = j_connection_pool_get_queue(j_connection_pool, backend, index, &server);
+
+	g_mutex_lock(pool_queue->mutex);
+	*statistics = pool_queue->statistics;
+	g_mutex_unlock(pool_queue->mutex);
+
+	return TRUE;
+}
+
+/**
+ * Accounts a message exchanged with a server.
+ * Connections that have not been established by the pool, for example, on the server, are ignored.
+ *
+ * \private
+ *
+ * \param connection A connection.
+ * \param success    Whether the message was sent or received successfully.
+ * \param bytes      The number of bytes sent or received.
+ * \param latency    The round-trip latency in microseconds if a reply was received, -1 otherwise.
+ **/
+void
+j_connection_pool_account(gpointer connection, gboolean success, guint64 bytes, gint64 latency)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConnectionPoolQueue* pool_queue;
+	JConnectionPoolServerStatistics* statistics;
+
+	if ((pool_queue = g_object_get_qdata(G_OBJECT(connection), j_connection_pool_queue_quark())) == NULL)
+	{
+		return;
+	}
+
+	statistics = &(pool_queue->statistics);
+
+	g_mutex_lock(pool_queue->mutex);
+
+	statistics->bytes += bytes;
+
+	if (!success)
+	{
+		statistics->errors++;
+	}
+	else if (latency >= 0)
+	{
+		statistics->replies++;
+		if (statistics->latency == 0)
+		{
+			statistics->latency = latency;
+			statistics->latency_deviation = latency / 2;
+		}
+		else
+		{
+			guint64 deviation;
+
+			deviation = ((guint64)latency > statistics->latency) ? latency - statistics->latency : statistics->latency - latency;
+			statistics->latency_deviation = (statistics->latency_deviation * 3 + deviation) / 4;
+			statistics->latency = (statistics->latency * 7 + latency) / 8;
+		}
+
+		statistics->latency_total += latency;
+		statistics->latency_max = MAX(statistics->latency_max, (guint64)latency);
+	}
+
+	g_mutex_unlock(pool_queue->mutex);
 }
 
 /**
@@ -31,6 +31,9 @@
 
 #include <jbackend.h>
 #include <jconfiguration.h>
+#include <jconnection-pool.h>
+#include <jmessage.h>
+#include <jstatistics.h>
 #include <jtrace.h>
 
 #include "distribution/distribution.h"
@@ -43,6 +46,53 @@
  * @{
  **/
 
+/**
+ * The largest block size chosen by j_distribution_tune().
+ **/
+#define J_DISTRIBUTION_TUNE_MAX_BLOCK_SIZE (16 * 1024 * 1024)
+
+/**
+ * The number of blocks per server j_distribution_tune() aims for before increasing the block size.
+ **/
+#define J_DISTRIBUTION_TUNE_BLOCKS_PER_SERVER 64
+
+/**
+ * The interval in which #J_DISTRIBUTION_ADAPTIVE refreshes its weights.
+ **/
+#define J_DISTRIBUTION_ADAPTIVE_INTERVAL (60 * G_TIME_SPAN_SECOND)
+
+/**
+ * The state shared by all adaptive distributions.
+ **/
+struct JDistributionAdaptive
+{
+	GMutex mutex[1];
+
+	/**
+	 * The time of the last refresh.
+	 **/
+	gint64 time;
+
+	/**
+	 * The number of servers.
+	 **/
+	guint server_count;
+
+	/**
+	 * The servers' current weights.
+	 **/
+	guint* weights;
+
+	/**
+	 * The bytes read and written by each server at the time of the last refresh.
+	 **/
+	guint64* bytes;
+};
+
+typedef struct JDistributionAdaptive JDistributionAdaptive;
+
+static JDistributionAdaptive j_distribution_adaptive;
+
 /**
  * A distribution.
  **/
@@ -58,13 +108,213 @@ struct JDistribution
 	 */
 	gpointer distribution;
 
+	/**
+	 * The configured server count and stripe size.
+	 **/
+	guint server_count;
+	guint64 stripe_size;
+
+	/**
+	 * Whether the layout is chosen by j_distribution_tune().
+	 **/
+	gboolean autotune;
+
 	/**
 	 * The reference count.
 	 **/
 	guint ref_count;
 };
 
-static JDistributionVTable j_distribution_vtables[3];
+static JDistributionVTable j_distribution_vtables[8];
+
+/**
+ * Fetches an object server's traffic and storage space.
+ *
+ * \private
+ *
+ * \param index       The server's index.
+ * \param bytes       Returns the number of bytes read and written.
+ * \param space_free  Returns the free space.
+ * \param space_total Returns the total space, 0 if unknown.
+ **/
+static void
+j_distribution_adaptive_fetch(guint index, guint64* bytes, guint64* space_free, guint64* space_total)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JMessage) message = NULL;
+	g_autoptr(JMessage) reply = NULL;
+	gpointer connection;
+	gchar get_all;
+
+	get_all = 1;
+
+	message = j_message_new(J_MESSAGE_STATISTICS, sizeof(gchar));
+	j_message_add_operation(message, 0);
+	j_message_append_1(message, &get_all);
+
+	connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, index);
+
+	j_message_send(message, connection);
+
+	reply = j_message_new_reply(message);
+	j_message_receive(reply, connection);
+
+	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, index, connection);
+
+	// Files created, deleted and stated, syncs
+	for (guint i = 0; i < 4; i++)
+	{
+		j_message_get_8(reply);
+	}
+
+	*bytes = j_message_get_8(reply);
+	*bytes += j_message_get_8(reply);
+
+	// Bytes received and sent, connections, per-message statistics and phases
+	for (guint i = 0; i < 3 + 7 * J_STATISTICS_MESSAGE_TYPES; i++)
+	{
+		j_message_get_8(reply);
+	}
+
+	*space_free = j_message_get_8(reply);
+	*space_total = j_message_get_8(reply);
+}
+
+/**
+ * Recomputes the adaptive weights.
+ * Each server's weight is proportional to its free space,
+ * reduced for servers that have handled more traffic than average since the last refresh.
+ * Has to be called with the mutex held.
+ *
+ * \private
+ *
+ * \param server_count The number of servers.
+ **/
+static void
+j_distribution_adaptive_refresh(guint server_count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree guint64* bytes = NULL;
+	g_autofree gdouble* bandwidth = NULL;
+	g_autofree gdouble* score = NULL;
+	gdouble bandwidth_mean = 0.0;
+	gdouble score_max = 0.0;
+	gdouble elapsed;
+	gint64 now;
+	gboolean space_known = FALSE;
+	gboolean bandwidth_known;
+
+	now = g_get_monotonic_time();
+	elapsed = (gdouble)(now - j_distribution_adaptive.time) / G_TIME_SPAN_SECOND;
+	bandwidth_known = (j_distribution_adaptive.server_count == server_count && j_distribution_adaptive.time > 0 && elapsed > 0.0);
+
+	bytes = g_new(guint64, server_count);
+	bandwidth = g_new0(gdouble, server_count);
+	score = g_new(gdouble, server_count);
+
+	for (guint i = 0; i < server_count; i++)
+	{
+		guint64 space_free;
+		guint64 space_total;
+
+		j_distribution_adaptive_fetch(i, &bytes[i], &space_free, &space_total);
+
+		if (bandwidth_known && bytes[i] >= j_distribution_adaptive.bytes[i])
+		{
+			bandwidth[i] = (gdouble)(bytes[i] - j_distribution_adaptive.bytes[i]) / elapsed;
+		}
+
+		bandwidth_mean += bandwidth[i] / server_count;
+		// Servers that cannot report their space are treated as empty
+		score[i] = (space_total > 0) ? (gdouble)space_free : -1.0;
+		space_known = space_known || (space_total > 0);
+	}
+
+	for (guint i = 0; i < server_count; i++)
+	{
+		if (!space_known || score[i] < 0.0)
+		{
+			score[i] = 1.0;
+		}
+
+		if (bandwidth_mean > 0.0)
+		{
+			score[i] /= 1.0 + (bandwidth[i] / bandwidth_mean);
+		}
+
+		score_max = MAX(score_max, score[i]);
+	}
+
+	g_free(j_distribution_adaptive.weights);
+	g_free(j_distribution_adaptive.bytes);
+
+	j_distribution_adaptive.weights = g_new(guint, server_count);
+	j_distribution_adaptive.bytes = g_steal_pointer(&bytes);
+	j_distribution_adaptive.server_count = server_count;
+	j_distribution_adaptive.time = now;
+
+	for (guint i = 0; i < server_count; i++)
+	{
+		// Weights are limited to 255 by the weighted distribution; full servers get no new blocks
+		j_distribution_adaptive.weights[i] = (score_max > 0.0) ? (guint)(score[i] / score_max * 255.0 + 0.5) : 1;
+	}
+
+	if (score_max == 0.0)
+	{
+		// All servers are full, fall back to equal weights
+		for (guint i = 0; i < server_count; i++)
+		{
+			j_distribution_adaptive.weights[i] = 1;
+		}
+	}
+}
+
+/**
+ * Sets a distribution's weights according to the servers' free space and recent throughput.
+ * The weights are shared by all adaptive distributions and refreshed every #J_DISTRIBUTION_ADAPTIVE_INTERVAL.
+ *
+ * \private
+ *
+ * \param distribution  A distribution.
+ * \param configuration The configuration.
+ **/
+static void
+j_distribution_adaptive_set_weights(JDistribution* distribution, JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	// Only the servers of the global configuration can be queried
+	if (configuration != j_configuration())
+	{
+		for (guint i = 0; i < distribution->server_count; i++)
+		{
+			j_distribution_vtables[distribution->type].distribution_set2(distribution->distribution, "weight", i, 1);
+		}
+
+		return;
+	}
+
+	g_mutex_lock(j_distribution_adaptive.mutex);
+
+	if (j_distribution_adaptive.server_count != distribution->server_count
+	    || g_get_monotonic_time() - j_distribution_adaptive.time >= J_DISTRIBUTION_ADAPTIVE_INTERVAL)
+	{
+		j_distribution_adaptive_refresh(distribution->server_count);
+	}
+
+	for (guint i = 0; i < distribution->server_count; i++)
+	{
+		// Weights start at 0, so full servers can be skipped
+		if (j_distribution_adaptive.weights[i] > 0)
+		{
+			j_distribution_vtables[distribution->type].distribution_set2(distribution->distribution, "weight", i, j_distribution_adaptive.weights[i]);
+		}
+	}
+
+	g_mutex_unlock(j_distribution_adaptive.mutex);
+}
 
 static JDistribution*
 j_distribution_new_common(JDistributionType type, JConfiguration* configuration)
@@ -81,8 +331,29 @@ j_distribution_new_common(JDistributionType type, JConfiguration* configuration)
 	distribution = g_slice_new(JDistribution);
 	distribution->type = type;
 	distribution->distribution = j_distribution_vtables[type].distribution_new(server_count, stripe_size);
+	distribution->server_count = server_count;
+	distribution->stripe_size = stripe_size;
+	distribution->autotune = FALSE;
 	distribution->ref_count = 1;
 
+	if (type == J_DISTRIBUTION_LOCAL)
+	{
+		guint32 local_count;
+
+		local_count = j_configuration_get_local_server_count(configuration, J_BACKEND_TYPE_OBJECT);
+
+		for (guint32 i = 0; i < local_count; i++)
+		{
+			j_distribution_vtables[type].distribution_set(distribution->distribution, "server", j_configuration_get_local_server(configuration, J_BACKEND_TYPE_OBJECT, i));
+		}
+
+		j_distribution_vtables[type].distribution_set(distribution->distribution, "start-index", g_random_int_range(0, local_count));
+	}
+	else if (type == J_DISTRIBUTION_ADAPTIVE)
+	{
+		j_distribution_adaptive_set_weights(distribution, configuration);
+	}
+
 	return distribution;
 }
 
@@ -201,6 +472,152 @@ j_distribution_set(JDistribution* distribution, gchar const* key, guint64 value)
 	}
 }
 
+/**
+ * Lets the distribution choose its block size and stripe count depending on the object's size.
+ * The layout is chosen by j_distribution_tune(),
+ * which is called with the size hint of j_distributed_object_create_with_size() or the extent of the first write.
+ * Only round robin distributions support this.
+ *
+ * \code
+ * JDistribution* d;
+ *
+ * d = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
+ * j_distribution_set_autotune(d, TRUE);
+ * \endcode
+ *
+ * \param distribution A distribution.
+ * \param autotune     Whether to choose the layout automatically.
+ **/
+void
+j_distribution_set_autotune(JDistribution* distribution, gboolean autotune)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(distribution != NULL);
+
+	distribution->autotune = (autotune && distribution->type == J_DISTRIBUTION_ROUND_ROBIN);
+}
+
+/**
+ * Chooses the layout for an object of the given size if the distribution is in autotune mode.
+ * Objects not larger than one stripe are stored on a single server.
+ * Larger ones are striped over as many servers as they have stripes.
+ * If each server would store many blocks, the block size is doubled up to 16 MiB.
+ * Afterwards, the layout is fixed.
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ * \param size         The object's expected size.
+ *
+ * \return TRUE if the layout has been chosen, FALSE if the distribution is not in autotune mode.
+ **/
+gboolean
+j_distribution_tune(JDistribution* distribution, guint64 size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 block_size;
+	guint64 stripe_count;
+
+	g_return_val_if_fail(distribution != NULL, FALSE);
+
+	if (!distribution->autotune)
+	{
+		return FALSE;
+	}
+
+	block_size = distribution->stripe_size;
+	stripe_count = (size + block_size - 1) / block_size;
+	stripe_count = CLAMP(stripe_count, 1, distribution->server_count);
+
+	while (block_size < J_DISTRIBUTION_TUNE_MAX_BLOCK_SIZE && size / (block_size * stripe_count) > J_DISTRIBUTION_TUNE_BLOCKS_PER_SERVER)
+	{
+		block_size *= 2;
+	}
+
+	j_distribution_vtables[distribution->type].distribution_set(distribution->distribution, "block-size", block_size);
+	j_distribution_vtables[distribution->type].distribution_set(distribution->distribution, "stripe-count", stripe_count);
+
+	distribution->autotune = FALSE;
+
+	return TRUE;
+}
+
+/**
+ * Returns whether the distribution is waiting for j_distribution_tune().
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ *
+ * \return TRUE if in autotune mode, FALSE otherwise.
+ **/
+gboolean
+j_distribution_get_autotune(JDistribution* distribution)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(distribution != NULL, FALSE);
+
+	return distribution->autotune;
+}
+
+/**
+ * Returns a distribution's type.
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ *
+ * \return The type.
+ **/
+JDistributionType
+j_distribution_get_type(JDistribution* distribution)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(distribution != NULL, J_DISTRIBUTION_ROUND_ROBIN);
+
+	return distribution->type;
+}
+
+/**
+ * Gets a distribution's parameter.
+ * All distributions report their "block-size", further parameters are only supported by distributions whose layout has to be known outside of j_distribution_distribute(), such as #J_DISTRIBUTION_ERASURE.
+ *
+ * \code
+ * guint64 parity;
+ *
+ * j_distribution_get(d, "parity", &parity);
+ * \endcode
+ *
+ * \param distribution A distribution.
+ * \param key          A key.
+ * \param value        Returns the value.
+ *
+ * \return TRUE if the parameter exists, FALSE otherwise.
+ **/
+gboolean
+j_distribution_get(JDistribution* distribution, gchar const* key, guint64* value)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(distribution != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+
+	if (j_distribution_vtables[distribution->type].distribution_get != NULL)
+	{
+		return j_distribution_vtables[distribution->type].distribution_get(distribution->distribution, key, value);
+	}
+
+	return FALSE;
+}
+
 void
 j_distribution_set2(JDistribution* distribution, gchar const* key, guint64 value1, guint64 value2)
 {
@@ -243,6 +660,12 @@ j_distribution_init(void)
 	j_distribution_round_robin_get_vtable(&(j_distribution_vtables[J_DISTRIBUTION_ROUND_ROBIN]));
 	j_distribution_single_server_get_vtable(&(j_distribution_vtables[J_DISTRIBUTION_SINGLE_SERVER]));
 	j_distribution_weighted_get_vtable(&(j_distribution_vtables[J_DISTRIBUTION_WEIGHTED]));
+	j_distribution_local_get_vtable(&(j_distribution_vtables[J_DISTRIBUTION_LOCAL]));
+	j_distribution_consistent_get_vtable(&(j_distribution_vtables[J_DISTRIBUTION_CONSISTENT]));
+	j_distribution_erasure_get_vtable(&(j_distribution_vtables[J_DISTRIBUTION_ERASURE]));
+	j_distribution_replicated_get_vtable(&(j_distribution_vtables[J_DISTRIBUTION_REPLICATED]));
+	// The adaptive distribution only differs from the weighted one in how its weights are chosen
+	j_distribution_weighted_get_vtable(&(j_distribution_vtables[J_DISTRIBUTION_ADAPTIVE]));
 
 	j_distribution_check_vtables();
 }
@@ -360,7 +783,19 @@ j_distribution_deserialize(JDistribution* distribution, bson_t const* b)
 
 		if (g_strcmp0(key, "type") == 0)
 		{
-			distribution->type = bson_iter_int32(&iterator);
+			JDistributionType type;
+
+			type = bson_iter_int32(&iterator);
+
+			// The actual distribution has to match the type, as the types use different data.
+			if (type != distribution->type)
+			{
+				JConfiguration* configuration = j_configuration();
+
+				j_distribution_vtables[distribution->type].distribution_free(distribution->distribution);
+				distribution->type = type;
+				distribution->distribution = j_distribution_vtables[type].distribution_new(j_configuration_get_server_count(configuration, J_BACKEND_TYPE_OBJECT), j_configuration_get_stripe_size(configuration));
+			}
 		}
 	}
 
@@ -417,6 +852,44 @@ j_distribution_distribute(JDistribution* distribution, guint* index, guint64* ne
 	return j_distribution_vtables[distribution->type].distribution_distribute(distribution->distribution, index, new_length, new_offset, block_id);
 }
 
+/**
+ * Returns a further copy of the block returned by the last call to j_distribution_distribute().
+ * Only distributions storing blocks more than once, such as #J_DISTRIBUTION_REPLICATED, have copies besides the first one.
+ *
+ * \code
+ * while (j_distribution_distribute(d, &index, &new_length, &new_offset, &block_id))
+ * {
+ *   for (guint r = 1; j_distribution_distribute_replica(d, r, &index, &new_offset); r++)
+ *   {
+ *     ...
+ *   }
+ * }
+ * \endcode
+ *
+ * \param distribution A distribution.
+ * \param replica      A copy, 0 is the one returned by j_distribution_distribute().
+ * \param index        A server index.
+ * \param new_offset   A new offset.
+ *
+ * \return TRUE on success, FALSE if the copy does not exist.
+ **/
+gboolean
+j_distribution_distribute_replica(JDistribution* distribution, guint replica, guint* index, guint64* new_offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(distribution != NULL, FALSE);
+	g_return_val_if_fail(index != NULL, FALSE);
+	g_return_val_if_fail(new_offset != NULL, FALSE);
+
+	if (j_distribution_vtables[distribution->type].distribution_distribute_replica == NULL)
+	{
+		return FALSE;
+	}
+
+	return j_distribution_vtables[distribution->type].distribution_distribute_replica(distribution->distribution, replica, index, new_offset);
+}
+
 /**
  * @}
  **/
@@ -39,6 +39,7 @@
 #include <jhelper-internal.h>
 
 #include <jbackground-operation.h>
+#include <jbackground-operation-internal.h>
 #include <jsemantics.h>
 #include <jtrace.h>
 
@@ -63,6 +64,13 @@ j_helper_set_nodelay(GSocketConnection* connection, gboolean enable)
 	g_return_if_fail(connection != NULL);
 
 	socket_ = g_socket_connection_get_socket(connection);
+
+	// Only TCP connections (see JTransport) support these options.
+	if (g_socket_get_family(socket_) == G_SOCKET_FAMILY_UNIX)
+	{
+		return;
+	}
+
 	fd = g_socket_get_fd(socket_);
 
 	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(gint));
@@ -81,6 +89,13 @@ j_helper_set_cork(GSocketConnection* connection, gboolean enable)
 	g_return_if_fail(connection != NULL);
 
 	socket_ = g_socket_connection_get_socket(connection);
+
+	// Only TCP connections (see JTransport) support these options.
+	if (g_socket_get_family(socket_) == G_SOCKET_FAMILY_UNIX)
+	{
+		return;
+	}
+
 	fd = g_socket_get_fd(socket_);
 
 	setsockopt(fd, IPPROTO_TCP, TCP_CORK, &flag, sizeof(gint));
@@ -123,48 +138,7 @@ j_helper_execute_parallel(JBackgroundOperationFunc func, gpointer* data, guint l
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JBackgroundOperation** operations;
-	guint data_count = 0;
-
-	operations = g_new(JBackgroundOperation*, length);
-
-	for (guint i = 0; i < length; i++)
-	{
-		operations[i] = NULL;
-
-		if (data[i] != NULL)
-		{
-			data_count++;
-		}
-	}
-
-	for (guint i = 0; i < length; i++)
-	{
-		if (data[i] == NULL)
-		{
-			continue;
-		}
-
-		if (data_count > 1)
-		{
-			operations[i] = j_background_operation_new(func, data[i]);
-		}
-		else
-		{
-			data[i] = func(data[i]);
-		}
-	}
-
-	for (guint i = 0; i < length; i++)
-	{
-		if (operations[i] != NULL)
-		{
-			data[i] = j_background_operation_wait(operations[i]);
-			j_background_operation_unref(operations[i]);
-		}
-	}
-
-	g_free(operations);
+	j_background_operation_execute_parallel(func, data, length);
 
 	return TRUE;
 }
@@ -209,6 +183,40 @@ j_helper_hash(gchar const* str)
 	return hash;
 }
 
+/**
+ * Maps a key to one of a number of buckets using jump consistent hashing.
+ * When the number of buckets grows from n to n + 1, only 1/(n + 1) of the keys move to the new bucket.
+ *
+ * See Lamping and Veach, "A Fast, Minimal Memory, Consistent Hash Algorithm".
+ *
+ * \param key     A key.
+ * \param buckets The number of buckets.
+ *
+ * \return The bucket in the range [0, buckets).
+ **/
+guint32
+j_helper_jump_hash(guint64 key, guint32 buckets)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gint64 b;
+	gint64 j;
+
+	g_return_val_if_fail(buckets > 0, 0);
+
+	b = -1;
+	j = 0;
+
+	while (j < buckets)
+	{
+		b = j;
+		key = key * G_GUINT64_CONSTANT(2862933555777941757) + 1;
+		j = (b + 1) * ((gdouble)(G_GINT64_CONSTANT(1) << 31) / (gdouble)((key >> 33) + 1));
+	}
+
+	return b;
+}
+
 gpointer
 j_helper_alloc_aligned(gsize align, gsize len)
 {
@@ -45,13 +45,9 @@ struct JListIterator
 	 **/
 	JList* list;
 	/**
-	 * The current list element.
+	 * The index of the current list element, G_MAXUINT before the first call to j_list_iterator_next().
 	 **/
-	JListElement* current;
-	/**
-	 * Whether the current element is the first one.
-	 **/
-	gboolean first;
+	guint index;
 };
 
 /**
@@ -75,8 +71,7 @@ j_list_iterator_new(JList* list)
 
 	iterator = g_slice_new(JListIterator);
 	iterator->list = j_list_ref(list);
-	iterator->current = j_list_head(iterator->list);
-	iterator->first = TRUE;
+	iterator->index = G_MAXUINT;
 
 	return iterator;
 }
@@ -118,16 +113,10 @@ j_list_iterator_next(JListIterator* iterator)
 
 	g_return_val_if_fail(iterator != NULL, FALSE);
 
-	if (G_UNLIKELY(iterator->first))
-	{
-		iterator->first = FALSE;
-	}
-	else
-	{
-		iterator->current = iterator->current->next;
-	}
+	// Wraps around to 0 for the first element.
+	iterator->index++;
 
-	return (iterator->current != NULL);
+	return (iterator->index < j_list_length(iterator->list));
 }
 
 /**
@@ -146,9 +135,10 @@ j_list_iterator_get(JListIterator* iterator)
 	J_TRACE_FUNCTION(NULL);
 
 	g_return_val_if_fail(iterator != NULL, NULL);
-	g_return_val_if_fail(iterator->current != NULL, NULL);
+	g_return_val_if_fail(iterator->index < j_list_length(iterator->list), NULL);
 
-	return iterator->current->data;
+	// The elements are looked up every time, since the list might have grown in the meantime.
+	return j_list_get_elements(iterator->list)[iterator->index];
 }
 
 /**
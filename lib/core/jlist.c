@@ -24,6 +24,8 @@
 
 #include <glib.h>
 
+#include <string.h>
+
 #include <jlist.h>
 #include <jlist-internal.h>
 
@@ -35,25 +37,32 @@
  **/
 
 /**
- * A linked list which allows fast prepend and append operations.
+ * An array-backed list which allows fast prepend and append operations.
+ * The elements are stored contiguously, with free space at both ends.
  * Also allows querying the length of the list without iterating over it.
  **/
 struct JList
 {
 	/**
-	 * The first element.
+	 * The elements, NULL if no array has been allocated yet.
 	 **/
-	JListElement* head;
+	gpointer* elements;
+
 	/**
-	 * The last element.
+	 * The index of the first element within #elements.
 	 **/
-	JListElement* tail;
+	guint start;
 
 	/**
 	 * The length.
 	 **/
 	guint length;
 
+	/**
+	 * The number of elements #elements can hold.
+	 **/
+	guint capacity;
+
 	/**
 	 * The function used to free the list elements.
 	 **/
@@ -65,6 +74,199 @@ struct JList
 	gint ref_count;
 };
 
+/**
+ * The capacity of newly allocated arrays.
+ **/
+#define J_LIST_INITIAL_CAPACITY 16
+
+/**
+ * The largest capacity kept when a list is emptied.
+ **/
+#define J_LIST_MAX_KEPT_CAPACITY 4096
+
+/**
+ * The maximum number of free arrays kept per thread.
+ **/
+#define J_LIST_POOL_DEPTH 256
+
+/**
+ * A thread-local pool of arrays with the initial capacity.
+ **/
+struct JListPool
+{
+	/**
+	 * The free arrays.
+	 **/
+	gpointer* arrays[J_LIST_POOL_DEPTH];
+
+	/**
+	 * The number of free arrays.
+	 **/
+	guint arrays_len;
+};
+
+typedef struct JListPool JListPool;
+
+static void j_list_pool_free(gpointer);
+
+static GPrivate j_list_pool = G_PRIVATE_INIT(j_list_pool_free);
+
+static void
+j_list_pool_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JListPool* pool = data;
+
+	for (guint i = 0; i < pool->arrays_len; i++)
+	{
+		g_free(pool->arrays[i]);
+	}
+
+	g_slice_free(JListPool, pool);
+}
+
+/**
+ * Returns the current thread's pool.
+ *
+ * \private
+ *
+ * \return The pool.
+ **/
+static JListPool*
+j_list_pool_get(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JListPool* pool;
+
+	pool = g_private_get(&j_list_pool);
+
+	if (G_UNLIKELY(pool == NULL))
+	{
+		pool = g_slice_new0(JListPool);
+		g_private_set(&j_list_pool, pool);
+	}
+
+	return pool;
+}
+
+static gpointer*
+j_list_array_alloc(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JListPool* pool;
+
+	pool = j_list_pool_get();
+
+	if (pool->arrays_len > 0)
+	{
+		pool->arrays_len--;
+
+		return pool->arrays[pool->arrays_len];
+	}
+
+	return g_new(gpointer, J_LIST_INITIAL_CAPACITY);
+}
+
+/**
+ * Releases a list's array, arrays with the initial capacity are returned to the pool.
+ *
+ * \private
+ *
+ * \param list A list.
+ **/
+static void
+j_list_array_dealloc(JList* list)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JListPool* pool;
+
+	if (list->elements == NULL)
+	{
+		return;
+	}
+
+	pool = j_list_pool_get();
+
+	if (list->capacity == J_LIST_INITIAL_CAPACITY && pool->arrays_len < J_LIST_POOL_DEPTH)
+	{
+		pool->arrays[pool->arrays_len] = list->elements;
+		pool->arrays_len++;
+	}
+	else
+	{
+		g_free(list->elements);
+	}
+
+	list->elements = NULL;
+	list->start = 0;
+	list->capacity = 0;
+}
+
+/**
+ * Makes room for another element.
+ * The capacity is doubled, so that appends and prepends take amortized constant time.
+ *
+ * \private
+ *
+ * \param list    A list.
+ * \param prepend Whether the room is needed in front of the first element.
+ **/
+static void
+j_list_reserve(JList* list, gboolean prepend)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gpointer* elements;
+	guint capacity;
+	guint start;
+
+	if (list->elements == NULL)
+	{
+		list->elements = j_list_array_alloc();
+		list->capacity = J_LIST_INITIAL_CAPACITY;
+		// Lists are mostly appended to, leave some room for prepends nonetheless.
+		list->start = (prepend) ? list->capacity / 2 : 0;
+
+		return;
+	}
+
+	if ((prepend && list->start > 0) || (!prepend && list->start + list->length < list->capacity))
+	{
+		return;
+	}
+
+	capacity = list->capacity;
+
+	// Only grow if the list is at least half full, otherwise recentering is enough.
+	if (list->length >= capacity / 2)
+	{
+		capacity *= 2;
+	}
+
+	start = (prepend) ? capacity - list->length - (capacity - list->length) / 2 : (capacity - list->length) / 4;
+
+	if (capacity == list->capacity)
+	{
+		memmove(list->elements + start, list->elements + list->start, list->length * sizeof(gpointer));
+	}
+	else
+	{
+		elements = g_new(gpointer, capacity);
+		memcpy(elements + start, list->elements + list->start, list->length * sizeof(gpointer));
+
+		j_list_array_dealloc(list);
+
+		list->elements = elements;
+		list->capacity = capacity;
+	}
+
+	list->start = start;
+}
+
 /**
  * Creates a new list.
  *
@@ -82,10 +284,12 @@ j_list_new(JListFreeFunc free_func)
 
 	JList* list;
 
+	// The array is allocated on the first insertion, since many lists stay empty.
 	list = g_slice_new(JList);
-	list->head = NULL;
-	list->tail = NULL;
+	list->elements = NULL;
+	list->start = 0;
 	list->length = 0;
+	list->capacity = 0;
 	list->free_func = free_func;
 	list->ref_count = 1;
 
@@ -130,6 +334,7 @@ j_list_unref(JList* list)
 	if (g_atomic_int_dec_and_test(&(list->ref_count)))
 	{
 		j_list_delete_all(list);
+		j_list_array_dealloc(list);
 
 		g_slice_free(JList, list);
 	}
@@ -169,28 +374,13 @@ j_list_append(JList* list, gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JListElement* element;
-
 	g_return_if_fail(list != NULL);
 	g_return_if_fail(data != NULL);
 
-	element = g_slice_new(JListElement);
-	element->next = NULL;
-	element->data = data;
+	j_list_reserve(list, FALSE);
 
+	list->elements[list->start + list->length] = data;
 	list->length++;
-
-	if (list->tail != NULL)
-	{
-		list->tail->next = element;
-	}
-
-	list->tail = element;
-
-	if (list->head == NULL)
-	{
-		list->head = list->tail;
-	}
 }
 
 /**
@@ -207,22 +397,14 @@ j_list_prepend(JList* list, gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JListElement* element;
-
 	g_return_if_fail(list != NULL);
 	g_return_if_fail(data != NULL);
 
-	element = g_slice_new(JListElement);
-	element->next = list->head;
-	element->data = data;
+	j_list_reserve(list, TRUE);
 
+	list->start--;
+	list->elements[list->start] = data;
 	list->length++;
-	list->head = element;
-
-	if (list->tail == NULL)
-	{
-		list->tail = list->head;
-	}
 }
 
 /**
@@ -241,9 +423,9 @@ j_list_get_first(JList* list)
 
 	g_return_val_if_fail(list != NULL, NULL);
 
-	if (list->head != NULL && list->tail != NULL)
+	if (list->length > 0)
 	{
-		data = list->head->data;
+		data = list->elements[list->start];
 	}
 
 	return data;
@@ -265,9 +447,9 @@ j_list_get_last(JList* list)
 
 	g_return_val_if_fail(list != NULL, NULL);
 
-	if (list->head != NULL && list->tail != NULL)
+	if (list->length > 0)
 	{
-		data = list->tail->data;
+		data = list->elements[list->start + list->length - 1];
 	}
 
 	return data;
@@ -275,6 +457,7 @@ j_list_get_last(JList* list)
 
 /**
  * Deletes all list elements.
+ * The array is kept for reuse unless it has grown large.
  *
  * \param list A list.
  **/
@@ -283,35 +466,84 @@ j_list_delete_all(JList* list)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JListElement* element;
-
 	g_return_if_fail(list != NULL);
 
-	element = list->head;
+	if (list->free_func != NULL)
+	{
+		for (guint i = list->start; i < list->start + list->length; i++)
+		{
+			list->free_func(list->elements[i]);
+		}
+	}
+
+	list->length = 0;
+	list->start = 0;
 
-	while (element != NULL)
+	if (list->capacity > J_LIST_MAX_KEPT_CAPACITY)
 	{
-		JListElement* next;
+		j_list_array_dealloc(list);
+	}
+}
+
+/**
+ * Removes an element from a list.
+ * The element's data is freed using the list's free function.
+ *
+ * \code
+ * \endcode
+ *
+ * \param list A list.
+ * \param data A list element.
+ *
+ * \return TRUE if the element was found, FALSE otherwise.
+ **/
+gboolean
+j_list_remove(JList* list, gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
 
-		if (list->free_func != NULL)
+	guint i;
+
+	g_return_val_if_fail(list != NULL, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	for (i = list->start; i < list->start + list->length; i++)
+	{
+		if (list->elements[i] == data)
 		{
-			list->free_func(element->data);
+			break;
 		}
+	}
+
+	if (i == list->start + list->length)
+	{
+		return FALSE;
+	}
+
+	if (i == list->start)
+	{
+		list->start++;
+	}
+	else
+	{
+		memmove(list->elements + i, list->elements + i + 1, (list->start + list->length - i - 1) * sizeof(gpointer));
+	}
+
+	list->length--;
 
-		next = element->next;
-		g_slice_free(JListElement, element);
-		element = next;
+	if (list->free_func != NULL)
+	{
+		list->free_func(data);
 	}
 
-	list->head = NULL;
-	list->tail = NULL;
-	list->length = 0;
+	return TRUE;
 }
 
 /* Internal */
 
 /**
- * Returns the list's first element.
+ * Returns the list's elements.
+ * The array is only valid until the list is modified.
  *
  * \private
  *
@@ -320,16 +552,16 @@ j_list_delete_all(JList* list)
  *
  * \param list A JList.
  *
- * \return A JListElement.
+ * \return The elements, j_list_length() of them.
  **/
-JListElement*
-j_list_head(JList* list)
+gpointer*
+j_list_get_elements(JList* list)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	g_return_val_if_fail(list != NULL, NULL);
 
-	return list->head;
+	return (list->elements != NULL) ? list->elements + list->start : NULL;
 }
 
 /**
@@ -20,14 +20,21 @@
  * \file
  **/
 
+// Required for getcpu().
+#define _GNU_SOURCE
+
 #include <julea-config.h>
 
 #include <glib.h>
 
+#include <sched.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 
 #include <jmemory-chunk.h>
 
+#include <jhelper.h>
 #include <jtrace.h>
 
 /**
@@ -35,27 +42,274 @@
  * @{
  **/
 
+/**
+ * The size of a transparent huge page.
+ */
+#define J_MEMORY_CHUNK_HUGEPAGE_SIZE (2 * 1024 * 1024)
+
+/**
+ * The maximum number of unused segments kept per segment size.
+ */
+#define J_MEMORY_CHUNK_POOL_SEGMENTS 64
+
+/**
+ * A segment of a chained cache.
+ */
+struct JMemoryChunkSegment
+{
+	/**
+	* The data.
+	*/
+	gchar* data;
+
+	/**
+	* The size.
+	*/
+	guint64 size;
+
+	/**
+	* Whether the data is backed by huge pages.
+	*/
+	gboolean hugepages;
+
+	/**
+	* The NUMA node the segment was last used on, -1 if unknown.
+	*/
+	gint node;
+};
+
+typedef struct JMemoryChunkSegment JMemoryChunkSegment;
+
 /**
  * A cache.
  */
 struct JMemoryChunk
 {
 	/**
-	* The size.
+	* The size of the first and all regular segments.
 	*/
 	guint64 size;
 
 	/**
-	* The data.
+	* The maximum size of all segments, equal to #size if the cache cannot grow.
 	*/
-	gchar* data;
+	guint64 limit;
+
+	/**
+	* Whether segments should be backed by huge pages.
+	*/
+	gboolean hugepages;
 
 	/**
-	* The current position within #data.
+	* The segments.
+	*/
+	GArray* segments;
+
+	/**
+	* The total size of all segments.
+	*/
+	guint64 allocated;
+
+	/**
+	* The index of the segment #current points into.
+	*/
+	guint segment;
+
+	/**
+	* The current position within the current segment.
 	*/
 	gchar* current;
+
+	/**
+	* The end of the current segment.
+	*/
+	gchar* end;
+
+	/**
+	* The amount of memory handed out since the last reset.
+	*/
+	guint64 used;
+
+	/**
+	* The largest amount of memory used at once.
+	*/
+	guint64 peak;
 };
 
+/**
+ * Unused regular segments shared by all caches, keyed by segment size.
+ * Protected by j_memory_chunk_pool_mutex.
+ */
+static GHashTable* j_memory_chunk_pool = NULL;
+static GMutex j_memory_chunk_pool_mutex;
+
+/**
+ * Returns the NUMA node of the CPU the calling thread runs on.
+ *
+ * \return The node, -1 if it is unknown.
+ */
+static gint
+j_memory_chunk_current_node(void)
+{
+#ifdef HAVE_GETCPU
+	guint cpu;
+	guint node;
+
+	if (getcpu(&cpu, &node) == 0)
+	{
+		return node;
+	}
+#endif
+
+	return -1;
+}
+
+static JMemoryChunkSegment
+j_memory_chunk_segment_new(guint64 size, gboolean hugepages)
+{
+	JMemoryChunkSegment segment;
+
+	segment.size = size;
+	segment.hugepages = FALSE;
+	segment.node = -1;
+
+#ifdef MADV_HUGEPAGE
+	// Huge pages only pay off for large segments, smaller ones would waste most of a page.
+	if (hugepages && size >= J_MEMORY_CHUNK_HUGEPAGE_SIZE)
+	{
+		guint64 aligned_size;
+
+		aligned_size = (size + J_MEMORY_CHUNK_HUGEPAGE_SIZE - 1) / J_MEMORY_CHUNK_HUGEPAGE_SIZE * J_MEMORY_CHUNK_HUGEPAGE_SIZE;
+		segment.data = j_helper_alloc_aligned(J_MEMORY_CHUNK_HUGEPAGE_SIZE, aligned_size);
+		segment.hugepages = TRUE;
+
+		// This is only a hint, the kernel falls back to regular pages if no huge pages are available.
+		madvise(segment.data, aligned_size, MADV_HUGEPAGE);
+
+		return segment;
+	}
+#else
+	(void)hugepages;
+#endif
+
+	segment.data = g_malloc(size);
+
+	return segment;
+}
+
+static void
+j_memory_chunk_segment_free(JMemoryChunkSegment* segment)
+{
+	if (segment->hugepages)
+	{
+		free(segment->data);
+	}
+	else
+	{
+		g_free(segment->data);
+	}
+}
+
+/**
+ * Gets a segment from the pool or allocates a new one.
+ */
+static JMemoryChunkSegment
+j_memory_chunk_segment_acquire(guint64 size, gboolean hugepages)
+{
+	JMemoryChunkSegment segment;
+	gboolean found = FALSE;
+	gint node;
+
+	node = j_memory_chunk_current_node();
+
+	g_mutex_lock(&j_memory_chunk_pool_mutex);
+
+	if (j_memory_chunk_pool != NULL)
+	{
+		GArray* segments;
+
+		segments = g_hash_table_lookup(j_memory_chunk_pool, &size);
+
+		for (guint i = 0; segments != NULL && i < segments->len; i++)
+		{
+			JMemoryChunkSegment const* pooled = &g_array_index(segments, JMemoryChunkSegment, i);
+
+			// Segments used on another NUMA node would make every access remote, a new one is first touched locally.
+			if (pooled->hugepages == hugepages && (pooled->node == node || pooled->node == -1 || node == -1))
+			{
+				segment = g_array_index(segments, JMemoryChunkSegment, i);
+				g_array_remove_index_fast(segments, i);
+				found = TRUE;
+				break;
+			}
+		}
+	}
+
+	g_mutex_unlock(&j_memory_chunk_pool_mutex);
+
+	if (!found)
+	{
+		segment = j_memory_chunk_segment_new(size, hugepages);
+	}
+
+	return segment;
+}
+
+/**
+ * Returns a regular segment to the pool, frees other segments.
+ */
+static void
+j_memory_chunk_segment_release(JMemoryChunk* cache, JMemoryChunkSegment* segment)
+{
+	gboolean pooled = FALSE;
+
+	if (segment->size == cache->size)
+	{
+		GArray* segments;
+
+		// The pages have most likely been placed on the node of the thread that used them.
+		segment->node = j_memory_chunk_current_node();
+
+		g_mutex_lock(&j_memory_chunk_pool_mutex);
+
+		if (j_memory_chunk_pool == NULL)
+		{
+			j_memory_chunk_pool = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, (GDestroyNotify)g_array_unref);
+		}
+
+		if ((segments = g_hash_table_lookup(j_memory_chunk_pool, &(segment->size))) == NULL)
+		{
+			segments = g_array_new(FALSE, FALSE, sizeof(JMemoryChunkSegment));
+			g_hash_table_insert(j_memory_chunk_pool, g_memdup2(&(segment->size), sizeof(guint64)), segments);
+		}
+
+		if (segments->len < J_MEMORY_CHUNK_POOL_SEGMENTS)
+		{
+			g_array_append_val(segments, *segment);
+			pooled = TRUE;
+		}
+
+		g_mutex_unlock(&j_memory_chunk_pool_mutex);
+	}
+
+	if (!pooled)
+	{
+		j_memory_chunk_segment_free(segment);
+	}
+}
+
+static void
+j_memory_chunk_use_segment(JMemoryChunk* cache, guint index)
+{
+	JMemoryChunkSegment* segment;
+
+	segment = &g_array_index(cache->segments, JMemoryChunkSegment, index);
+
+	cache->segment = index;
+	cache->current = segment->data;
+	cache->end = segment->data + segment->size;
+}
+
 /**
  * Creates a new cache.
  *
@@ -74,14 +328,52 @@ j_memory_chunk_new(guint64 size)
 {
 	J_TRACE_FUNCTION(NULL);
 
+	g_return_val_if_fail(size > 0, NULL);
+
+	return j_memory_chunk_new_growable(size, size, FALSE);
+}
+
+/**
+ * Creates a new cache that grows on demand.
+ * Additional segments are chained to the first one when it is full, up to a total size of limit.
+ * Regular segments are taken from and returned to a pool shared by all caches.
+ *
+ * \code
+ * JMemoryChunk* cache;
+ *
+ * cache = j_memory_chunk_new_growable(1024, 8 * 1024, FALSE);
+ * \endcode
+ *
+ * \param size      The size of the first and all regular segments.
+ * \param limit     The maximum size of all segments.
+ * \param hugepages Whether large segments should be backed by huge pages.
+ *
+ * \return A new cache. Should be freed with j_memory_chunk_free().
+ **/
+JMemoryChunk*
+j_memory_chunk_new_growable(guint64 size, guint64 limit, gboolean hugepages)
+{
+	J_TRACE_FUNCTION(NULL);
+
 	JMemoryChunk* cache;
+	JMemoryChunkSegment segment;
 
 	g_return_val_if_fail(size > 0, NULL);
+	g_return_val_if_fail(limit >= size, NULL);
 
 	cache = g_slice_new(JMemoryChunk);
 	cache->size = size;
-	cache->data = g_malloc(cache->size);
-	cache->current = cache->data;
+	cache->limit = limit;
+	cache->hugepages = hugepages;
+	cache->segments = g_array_new(FALSE, FALSE, sizeof(JMemoryChunkSegment));
+	cache->allocated = size;
+	cache->used = 0;
+	cache->peak = 0;
+
+	segment = j_memory_chunk_segment_acquire(size, hugepages);
+	g_array_append_val(cache->segments, segment);
+
+	j_memory_chunk_use_segment(cache, 0);
 
 	return cache;
 }
@@ -106,16 +398,19 @@ j_memory_chunk_free(JMemoryChunk* cache)
 
 	g_return_if_fail(cache != NULL);
 
-	if (cache->data != NULL)
+	for (guint i = 0; i < cache->segments->len; i++)
 	{
-		g_free(cache->data);
+		j_memory_chunk_segment_release(cache, &g_array_index(cache->segments, JMemoryChunkSegment, i));
 	}
 
+	g_array_unref(cache->segments);
+
 	g_slice_free(JMemoryChunk, cache);
 }
 
 /**
  * Gets a new segment from the cache.
+ * If the current segment is full, the next segment that is large enough is used, growing the cache if necessary.
  *
  * \code
  * JMemoryChunk* cache;
@@ -139,13 +434,47 @@ j_memory_chunk_get(JMemoryChunk* cache, guint64 length)
 
 	g_return_val_if_fail(cache != NULL, NULL);
 
-	if (cache->current + length > cache->data + cache->size)
+	if (length > (guint64)(cache->end - cache->current))
 	{
-		return NULL;
+		guint index;
+
+		// The rest of the current segment is skipped until the next reset.
+		for (index = cache->segment + 1; index < cache->segments->len; index++)
+		{
+			if (g_array_index(cache->segments, JMemoryChunkSegment, index).size >= length)
+			{
+				break;
+			}
+		}
+
+		if (index == cache->segments->len)
+		{
+			JMemoryChunkSegment segment;
+			guint64 size;
+
+			size = MAX(cache->size, length);
+
+			if (cache->allocated + size > cache->limit)
+			{
+				return NULL;
+			}
+
+			segment = (size == cache->size) ? j_memory_chunk_segment_acquire(size, cache->hugepages) : j_memory_chunk_segment_new(size, cache->hugepages);
+			g_array_append_val(cache->segments, segment);
+			cache->allocated += size;
+		}
+
+		j_memory_chunk_use_segment(cache, index);
 	}
 
 	ret = cache->current;
 	cache->current += length;
+	cache->used += length;
+
+	if (cache->used > cache->peak)
+	{
+		cache->peak = cache->used;
+	}
 
 	return ret;
 }
@@ -157,7 +486,93 @@ j_memory_chunk_reset(JMemoryChunk* cache)
 
 	g_return_if_fail(cache != NULL);
 
-	cache->current = cache->data;
+	j_memory_chunk_use_segment(cache, 0);
+	cache->used = 0;
+}
+
+/**
+ * Releases all segments but the first one.
+ * Should be called when the cache is idle, the segments are returned to the shared pool.
+ * Also resets the cache.
+ *
+ * \code
+ * JMemoryChunk* cache;
+ *
+ * ...
+ *
+ * j_memory_chunk_shrink(cache);
+ * \endcode
+ *
+ * \param cache A cache.
+ **/
+void
+j_memory_chunk_shrink(JMemoryChunk* cache)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(cache != NULL);
+
+	for (guint i = 1; i < cache->segments->len; i++)
+	{
+		j_memory_chunk_segment_release(cache, &g_array_index(cache->segments, JMemoryChunkSegment, i));
+	}
+
+	g_array_set_size(cache->segments, 1);
+	cache->allocated = cache->size;
+
+	j_memory_chunk_reset(cache);
+}
+
+/**
+ * Returns the total size of the cache's segments.
+ *
+ * \code
+ * JMemoryChunk* cache;
+ * guint64 size;
+ *
+ * ...
+ *
+ * size = j_memory_chunk_get_size(cache);
+ * \endcode
+ *
+ * \param cache A cache.
+ *
+ * \return The size in bytes.
+ **/
+guint64
+j_memory_chunk_get_size(JMemoryChunk* cache)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(cache != NULL, 0);
+
+	return cache->allocated;
+}
+
+/**
+ * Returns the largest amount of memory that has been used at once.
+ *
+ * \code
+ * JMemoryChunk* cache;
+ * guint64 peak;
+ *
+ * ...
+ *
+ * peak = j_memory_chunk_get_peak(cache);
+ * \endcode
+ *
+ * \param cache A cache.
+ *
+ * \return The peak usage in bytes.
+ **/
+guint64
+j_memory_chunk_get_peak(JMemoryChunk* cache)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(cache != NULL, 0);
+
+	return cache->peak;
 }
 
 /**
@@ -20,20 +20,43 @@
  * \file
  **/
 
+// Required for splice() and pipe2().
+#define _GNU_SOURCE
+
 #include <julea-config.h>
 
 #include <glib.h>
 #include <gio/gio.h>
 
+#include <errno.h>
+#include <fcntl.h>
 #include <math.h>
 #include <string.h>
+#include <unistd.h>
+
+#ifdef HAVE_SENDFILE
+#include <sys/sendfile.h>
+#endif
+
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
 
 #include <jmessage.h>
+#include <jmessage-internal.h>
 
+#include <jconnection-pool-internal.h>
 #include <jhelper-internal.h>
 #include <jlist.h>
+#include <jchecksum.h>
 #include <jlist-iterator.h>
 #include <jsemantics.h>
+#include <jstatistics.h>
+#include <jstatistics-internal.h>
 #include <jtrace.h>
 
 /**
@@ -68,6 +91,111 @@ enum JMessageSemantics
 
 typedef enum JMessageSemantics JMessageSemantics;
 
+/**
+ * The maximum number of vectors passed to a single gather write.
+ * Matches the common IOV_MAX limit.
+ **/
+#define J_MESSAGE_MAX_VECTORS 1024
+
+/**
+ * The minimum number of bytes for a message to be compressed.
+ * Smaller messages are dominated by latency and are sent as they are.
+ **/
+#define J_MESSAGE_COMPRESSION_THRESHOLD 4096
+
+/**
+ * The zstd compression level.
+ * Favors speed, as the network should remain the bottleneck.
+ **/
+#define J_MESSAGE_COMPRESSION_ZSTD_LEVEL 1
+
+/**
+ * The smallest buffer size class as a power of two (256 bytes).
+ **/
+#define J_MESSAGE_POOL_MIN_SHIFT 8
+
+/**
+ * The number of buffer size classes (256 bytes to 64 KiB).
+ * Larger buffers are not pooled.
+ **/
+#define J_MESSAGE_POOL_CLASSES 9
+
+/**
+ * The maximum number of buffers per size class and of messages kept per thread.
+ **/
+#define J_MESSAGE_POOL_DEPTH 32
+
+/**
+ * The number of bytes reserved per operation when creating a reply.
+ **/
+#define J_MESSAGE_REPLY_OPERATION_SIZE 16
+
+/**
+ * The buffer size used to copy file data that cannot be sent with sendfile().
+ **/
+#define J_MESSAGE_FILE_BUFFER_SIZE (64 * 1024)
+
+enum JMessageCompression
+{
+	J_MESSAGE_COMPRESSION_NONE,
+	J_MESSAGE_COMPRESSION_LZ4,
+	J_MESSAGE_COMPRESSION_ZSTD
+};
+
+typedef enum JMessageCompression JMessageCompression;
+
+/**
+ * Set in a header's compression field if a JTraceContext follows the header.
+ * Requests only carry a trace context if OTLP tracing is enabled, so the protocol is unchanged otherwise.
+ **/
+#define J_MESSAGE_TRACE_CONTEXT (1U << 31)
+
+/**
+ * Set in a request's compression field to ask the server to echo its timings.
+ * Requests only ask for timings if JULEA_MESSAGE_TIMING is set.
+ **/
+#define J_MESSAGE_TIMING_REQUEST (1U << 30)
+
+/**
+ * Set in a header's compression field if a JMessageTiming follows the header (and the trace context, if any).
+ **/
+#define J_MESSAGE_TIMING (1U << 29)
+
+/**
+ * Set in a header's compression field if the payload uses the compact encoding, see j_message_compact_encode().
+ **/
+#define J_MESSAGE_COMPACT (1U << 28)
+
+/**
+ * Set in a request's compression field if the server may create missing objects, see j_message_set_lazy_create().
+ **/
+#define J_MESSAGE_LAZY_CREATE (1U << 27)
+
+/**
+ * The flags that may be set in a header's compression field in addition to the codec.
+ **/
+#define J_MESSAGE_FLAGS (J_MESSAGE_TRACE_CONTEXT | J_MESSAGE_TIMING_REQUEST | J_MESSAGE_TIMING | J_MESSAGE_COMPACT | J_MESSAGE_LAZY_CREATE)
+
+/**
+ * The maximum length of a varint.
+ **/
+#define J_MESSAGE_VARINT_MAX 10
+
+/**
+ * The state of the compact encoding for one direction of a connection.
+ * Both ends remember the names of the last compactly encoded message, so that repeated names do not have to be sent again.
+ **/
+struct JMessageCompact
+{
+	/**
+	 * The last namespace and name, both including their terminating null bytes.
+	 **/
+	gchar* names;
+	gsize names_length;
+};
+
+typedef struct JMessageCompact JMessageCompact;
+
 /**
  * Additional message data.
  **/
@@ -82,10 +210,94 @@ struct JMessageData
 	 * The data length.
 	 **/
 	guint64 length;
+
+	/**
+	 * A file descriptor to send the data from, or -1 if the data is in memory.
+	 **/
+	gint fd;
+
+	/**
+	 * The data's offset within the file.
+	 **/
+	guint64 offset;
 };
 
 typedef struct JMessageData JMessageData;
 
+/**
+ * Calls X for each message type and its name.
+ **/
+#define J_MESSAGE_TYPES(X) \
+	X(J_MESSAGE_NONE, "none") \
+	X(J_MESSAGE_PING, "ping") \
+	X(J_MESSAGE_STATISTICS, "statistics") \
+	X(J_MESSAGE_OBJECT_CREATE, "object_create") \
+	X(J_MESSAGE_OBJECT_DELETE, "object_delete") \
+	X(J_MESSAGE_OBJECT_GET_ALL, "object_get_all") \
+	X(J_MESSAGE_OBJECT_GET_BY_PREFIX, "object_get_by_prefix") \
+	X(J_MESSAGE_OBJECT_READ, "object_read") \
+	X(J_MESSAGE_OBJECT_STATUS, "object_status") \
+	X(J_MESSAGE_OBJECT_SYNC, "object_sync") \
+	X(J_MESSAGE_OBJECT_WRITE, "object_write") \
+	X(J_MESSAGE_KV_PUT, "kv_put") \
+	X(J_MESSAGE_KV_DELETE, "kv_delete") \
+	X(J_MESSAGE_KV_GET, "kv_get") \
+	X(J_MESSAGE_KV_GET_ALL, "kv_get_all") \
+	X(J_MESSAGE_KV_GET_BY_PREFIX, "kv_get_by_prefix") \
+	X(J_MESSAGE_DB_SCHEMA_CREATE, "db_schema_create") \
+	X(J_MESSAGE_DB_SCHEMA_GET, "db_schema_get") \
+	X(J_MESSAGE_DB_SCHEMA_DELETE, "db_schema_delete") \
+	X(J_MESSAGE_DB_INSERT, "db_insert") \
+	X(J_MESSAGE_DB_UPDATE, "db_update") \
+	X(J_MESSAGE_DB_DELETE, "db_delete") \
+	X(J_MESSAGE_DB_QUERY, "db_query") \
+	X(J_MESSAGE_DB_AGGREGATE, "db_aggregate") \
+	X(J_MESSAGE_TRANSACTION_COMMIT, "transaction_commit") \
+	X(J_MESSAGE_TRANSACTION_ABORT, "transaction_abort") \
+	X(J_MESSAGE_KV_COMPARE_AND_SWAP, "kv_compare_and_swap") \
+	X(J_MESSAGE_KV_ADD, "kv_add") \
+	X(J_MESSAGE_KV_GET_RANGE, "kv_get_range") \
+	X(J_MESSAGE_OBJECT_REDUCE, "object_reduce") \
+	X(J_MESSAGE_OBJECT_DELETE_PREFIX, "object_delete_prefix") \
+	X(J_MESSAGE_KV_DELETE_PREFIX, "kv_delete_prefix") \
+	X(J_MESSAGE_DB_ADVISE_INDEXES, "db_advise_indexes") \
+	X(J_MESSAGE_OBJECT_APPEND, "object_append") \
+	X(J_MESSAGE_OBJECT_CLONE, "object_clone") \
+	X(J_MESSAGE_OBJECT_ADVISE, "object_advise") \
+	X(J_MESSAGE_OBJECT_DEDUP, "object_dedup") \
+	X(J_MESSAGE_KV_BLOOM_FILTER, "kv_bloom_filter") \
+	X(J_MESSAGE_OBJECT_LIST, "object_list") \
+	X(J_MESSAGE_KV_REPLICATE, "kv_replicate") \
+	X(J_MESSAGE_DB_REPLICATE, "db_replicate") \
+	X(J_MESSAGE_OBJECT_DISCARD, "object_discard")
+
+#define J_MESSAGE_TYPE_NAME(type, name) [type] = name,
+
+static gchar const* const j_message_type_names[] = {
+	J_MESSAGE_TYPES(J_MESSAGE_TYPE_NAME)
+};
+
+#undef J_MESSAGE_TYPE_NAME
+
+/**
+ * Names used to trace the latency of a message type on the client and server.
+ **/
+struct JMessageTraceName
+{
+	gchar const* client;
+	gchar const* server;
+};
+
+typedef struct JMessageTraceName JMessageTraceName;
+
+#define J_MESSAGE_TRACE_NAME(type, name) [type] = { "message/client/" name, "message/server/" name },
+
+static JMessageTraceName const j_message_trace_names[] = {
+	J_MESSAGE_TYPES(J_MESSAGE_TRACE_NAME)
+};
+
+#undef J_MESSAGE_TRACE_NAME
+
 /**
  * A message header.
  **/
@@ -116,12 +328,31 @@ struct JMessageHeader
 	 * The operation count.
 	 **/
 	guint32 op_count;
+
+	/**
+	 * The compression codec, see #JMessageCompression.
+	 * The flags in #J_MESSAGE_FLAGS may be set in addition.
+	 **/
+	guint32 compression;
+
+	/**
+	 * The length of the compressed payload following the header.
+	 * Only set if #compression is not J_MESSAGE_COMPRESSION_NONE.
+	 **/
+	guint32 compressed_length;
+
+	/**
+	 * The length of the additional data contained in the compressed payload.
+	 **/
+	guint32 data_length;
 };
 #pragma pack()
 
 typedef struct JMessageHeader JMessageHeader;
 
-G_STATIC_ASSERT(sizeof(JMessageHeader) == 5 * sizeof(guint32));
+G_STATIC_ASSERT(sizeof(JMessageHeader) == 8 * sizeof(guint32));
+G_STATIC_ASSERT(sizeof(JTraceContext) == 24);
+G_STATIC_ASSERT(sizeof(JMessageTiming) == 4 * sizeof(guint32));
 
 /**
  * A message.
@@ -154,12 +385,55 @@ struct JMessage
 	 **/
 	JList* send_list;
 
+	/**
+	 * The list of destination buffers to fill in j_message_receive_data().
+	 * Contains JMessageData elements.
+	 **/
+	JList* receive_list;
+
+	/**
+	 * The additional data that was contained in a compressed payload.
+	 * Points behind the message's data, NULL if there is none.
+	 **/
+	gchar const* inline_data;
+
+	/**
+	 * The remaining length of #inline_data.
+	 **/
+	gsize inline_length;
+
 	/**
 	 * The original message.
 	 * Set if the message is a reply, NULL otherwise.
 	 **/
 	JMessage* original_message;
 
+	/**
+	 * When a request was sent (client) or received (server).
+	 * Used to trace the latency per message type.
+	 **/
+	gint64 trace_time;
+
+	/**
+	 * The trace context received with a request.
+	 * Only valid if #has_trace_context is set.
+	 **/
+	JTraceContext trace_context;
+	gboolean has_trace_context;
+
+	/**
+	 * The server-side timings.
+	 * For requests, #has_timing is set if the client asked for them to be echoed.
+	 * For replies, #timing is only valid if #has_timing is set.
+	 **/
+	JMessageTiming timing;
+	gboolean has_timing;
+
+	/**
+	 * Whether the server may create missing objects, see j_message_set_lazy_create().
+	 **/
+	gboolean lazy_create;
+
 	/**
 	 * The reference count.
 	 **/
@@ -167,60 +441,96 @@ struct JMessage
 };
 
 /**
- * Returns a message's length.
- *
- * \private
- *
- * \code
- * \endcode
- *
- * \param message A message.
- *
- * \return The message's length.
+ * A demultiplexer for a connection shared by multiple requests.
  **/
-static gsize
-j_message_length(JMessage const* message)
+struct JMessageMultiplexer
 {
-	J_TRACE_FUNCTION(NULL);
+	/**
+	 * The connection's input stream.
+	 **/
+	GInputStream* stream;
 
-	guint32 length;
+	/**
+	 * The connection's socket.
+	 **/
+	GSocket* socket;
 
-	length = message->header.length;
+	/**
+	 * The thread reading replies.
+	 **/
+	GThread* thread;
 
-	return GUINT32_FROM_LE(length);
-}
+	/**
+	 * Serializes senders.
+	 **/
+	GMutex send_mutex[1];
+
+	/**
+	 * Protects #replies and #failed.
+	 **/
+	GMutex mutex[1];
+
+	/**
+	 * The queues of received replies, indexed by message ID.
+	 * Contain JMessage elements.
+	 **/
+	GHashTable* replies;
+
+	/**
+	 * Whether the connection has failed.
+	 **/
+	gboolean failed;
+};
+
+typedef struct JMessageMultiplexer JMessageMultiplexer;
+
+/**
+ * Marks the end of a failed connection in a reply queue.
+ **/
+static gint j_message_multiplexer_failed = 0;
+
+/**
+ * The ID of the next message.
+ * IDs are unique within a process, which allows multiplexed connections to match replies to their requests.
+ **/
+static gint j_message_next_id = 0;
+
+G_DEFINE_QUARK(j-message-multiplexer, j_message_multiplexer)
+G_DEFINE_QUARK(j-message-compression, j_message_compression)
+G_DEFINE_QUARK(j-message-compact, j_message_compact)
+G_DEFINE_QUARK(j-message-compact-receive, j_message_compact_receive)
 
 static void
-j_message_data_free(gpointer data)
+j_message_compact_free(gpointer data)
 {
-	J_TRACE_FUNCTION(NULL);
+	JMessageCompact* compact = data;
 
-	g_slice_free(JMessageData, data);
+	g_free(compact->names);
+	g_slice_free(JMessageCompact, compact);
 }
 
 /**
- * Checks whether it is possible to append data to a message.
+ * Returns whether requests should ask servers to echo their timings.
  *
  * \private
  *
- * \code
- * \endcode
- *
- * \param message A message.
- * \param length  A length.
- *
- * \return TRUE if it is possible, FALSE otherwise.
+ * \return TRUE if JULEA_MESSAGE_TIMING is set, FALSE otherwise.
  **/
 static gboolean
-j_message_can_append(JMessage const* message, gsize length)
+j_message_timing_enabled(void)
 {
-	J_TRACE_FUNCTION(NULL);
+	static gsize enabled = 0;
 
-	return (message->current + length <= message->data + message->size);
+	if (g_once_init_enter(&enabled))
+	{
+		g_once_init_leave(&enabled, (g_strcmp0(g_getenv("JULEA_MESSAGE_TIMING"), "1") == 0) ? 2 : 1);
+	}
+
+	return (enabled == 2);
 }
 
 /**
- * Checks whether it is possible to get data from a message.
+ * Returns a message's length.
  *
  * \private
  *
@@ -228,110 +538,436 @@ j_message_can_append(JMessage const* message, gsize length)
  * \endcode
  *
  * \param message A message.
- * \param length  A length.
  *
- * \return TRUE if it is possible, FALSE otherwise.
+ * \return The message's length.
  **/
-static gboolean
-j_message_can_get(JMessage const* message, gsize length)
+static gsize
+j_message_length(JMessage const* message)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	return (message->current + length <= message->data + j_message_length(message));
+	guint32 length;
+
+	length = message->header.length;
+
+	return GUINT32_FROM_LE(length);
 }
 
 static void
-j_message_extend(JMessage* message, gsize length)
+j_message_data_free(gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gsize factor = 1;
-	gsize current_length;
-	gsize position;
-	guint32 count;
+	g_slice_free(JMessageData, data);
+}
 
-	if (length == 0)
-	{
-		return;
-	}
+/**
+ * A thread-local pool of messages and message buffers.
+ **/
+struct JMessagePool
+{
+	/**
+	 * The free buffers, indexed by size class.
+	 **/
+	gchar* buffers[J_MESSAGE_POOL_CLASSES][J_MESSAGE_POOL_DEPTH];
 
-	current_length = j_message_length(message);
+	/**
+	 * The number of free buffers per size class.
+	 **/
+	guint buffers_len[J_MESSAGE_POOL_CLASSES];
 
-	if (current_length + length <= message->size)
-	{
-		return;
-	}
+	/**
+	 * The free messages.
+	 * Their lists are kept to avoid recreating them.
+	 **/
+	JMessage* messages[J_MESSAGE_POOL_DEPTH];
 
-	count = j_message_get_count(message);
+	/**
+	 * The number of free messages.
+	 **/
+	guint messages_len;
+};
 
-	if (count > 10)
-	{
-		factor = pow(10, floor(log10(count)));
-	}
+typedef struct JMessagePool JMessagePool;
 
-	message->size += length * factor;
+static void j_message_pool_free(gpointer);
 
-	position = message->current - message->data;
-	message->data = g_realloc(message->data, message->size);
-	message->current = message->data + position;
-}
+static GPrivate j_message_pool = G_PRIVATE_INIT(j_message_pool_free);
 
 static void
-j_message_ensure_size(JMessage* message, gsize length)
+j_message_pool_free(gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gsize position;
+	JMessagePool* pool = data;
 
-	if (length <= message->size)
+	for (guint i = 0; i < J_MESSAGE_POOL_CLASSES; i++)
 	{
-		return;
+		for (guint j = 0; j < pool->buffers_len[i]; j++)
+		{
+			g_free(pool->buffers[i][j]);
+		}
 	}
 
-	message->size = length;
+	for (guint i = 0; i < pool->messages_len; i++)
+	{
+		j_list_unref(pool->messages[i]->send_list);
+		j_list_unref(pool->messages[i]->receive_list);
+		g_slice_free(JMessage, pool->messages[i]);
+	}
 
-	position = message->current - message->data;
-	message->data = g_realloc(message->data, message->size);
-	message->current = message->data + position;
+	g_slice_free(JMessagePool, pool);
 }
 
 /**
- * Creates a new message.
- *
- * \code
- * \endcode
+ * Returns the current thread's pool.
  *
- * \param op_type An operation type.
- * \param length  A length.
+ * \private
  *
- * \return A new message. Should be freed with j_message_unref().
+ * \return The pool.
  **/
-JMessage*
-j_message_new(JMessageType op_type, gsize length)
+static JMessagePool*
+j_message_pool_get(void)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JMessage* message;
-	guint32 rand;
+	JMessagePool* pool;
 
-	//g_return_val_if_fail(op_type != J_MESSAGE_NONE, NULL);
+	pool = g_private_get(&j_message_pool);
 
-	length = MAX(256, length);
-	rand = g_random_int();
+	if (G_UNLIKELY(pool == NULL))
+	{
+		pool = g_slice_new0(JMessagePool);
+		g_private_set(&j_message_pool, pool);
+	}
 
-	message = g_slice_new(JMessage);
-	message->size = length;
-	message->data = g_malloc(message->size);
-	message->current = message->data;
-	message->send_list = j_list_new(j_message_data_free);
-	message->original_message = NULL;
-	message->ref_count = 1;
+	return pool;
+}
+
+/**
+ * Returns the size class for a buffer size.
+ *
+ * \private
+ *
+ * \param size A size. Rounded up to the size class's size.
+ *
+ * \return The size class, J_MESSAGE_POOL_CLASSES if the size is too large to be pooled.
+ **/
+static guint
+j_message_pool_class(gsize* size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	for (guint i = 0; i < J_MESSAGE_POOL_CLASSES; i++)
+	{
+		gsize class_size = (gsize)1 << (J_MESSAGE_POOL_MIN_SHIFT + i);
+
+		if (*size <= class_size)
+		{
+			*size = class_size;
+			return i;
+		}
+	}
+
+	return J_MESSAGE_POOL_CLASSES;
+}
+
+/**
+ * Allocates a message buffer, reusing a pooled one if possible.
+ *
+ * \private
+ *
+ * \param size A size. Returns the actual size of the buffer.
+ *
+ * \return A buffer, to be freed with j_message_buffer_free().
+ **/
+static gchar*
+j_message_buffer_alloc(gsize* size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessagePool* pool;
+	guint size_class;
+
+	size_class = j_message_pool_class(size);
+
+	if (size_class < J_MESSAGE_POOL_CLASSES)
+	{
+		pool = j_message_pool_get();
+
+		if (pool->buffers_len[size_class] > 0)
+		{
+			pool->buffers_len[size_class]--;
+			return pool->buffers[size_class][pool->buffers_len[size_class]];
+		}
+	}
+
+	return g_malloc(*size);
+}
+
+/**
+ * Returns a message buffer to the current thread's pool.
+ *
+ * \private
+ *
+ * \param data A buffer allocated with j_message_buffer_alloc().
+ * \param size The buffer's size.
+ **/
+static void
+j_message_buffer_free(gchar* data, gsize size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessagePool* pool;
+	gsize class_size = size;
+	guint size_class;
+
+	size_class = j_message_pool_class(&class_size);
+
+	// Only buffers of exactly a class's size can be reused.
+	if (size_class < J_MESSAGE_POOL_CLASSES && class_size == size)
+	{
+		pool = j_message_pool_get();
+
+		if (pool->buffers_len[size_class] < J_MESSAGE_POOL_DEPTH)
+		{
+			pool->buffers[size_class][pool->buffers_len[size_class]] = data;
+			pool->buffers_len[size_class]++;
+			return;
+		}
+	}
+
+	g_free(data);
+}
+
+/**
+ * Replaces a message's buffer with a larger one, keeping its contents.
+ *
+ * \private
+ *
+ * \param message A message.
+ * \param size    The new minimum size.
+ **/
+static void
+j_message_buffer_grow(JMessage* message, gsize size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gchar* data;
+	gsize position;
+
+	position = message->current - message->data;
+
+	data = j_message_buffer_alloc(&size);
+	memcpy(data, message->data, message->size);
+	j_message_buffer_free(message->data, message->size);
+
+	message->data = data;
+	message->size = size;
+	message->current = message->data + position;
+}
+
+/**
+ * Allocates a message, reusing a pooled one if possible.
+ *
+ * \private
+ *
+ * \param length The minimum size of the message's buffer.
+ *
+ * \return A message with empty lists and an allocated buffer.
+ **/
+static JMessage*
+j_message_alloc(gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessagePool* pool;
+	JMessage* message;
+
+	pool = j_message_pool_get();
+
+	if (pool->messages_len > 0)
+	{
+		pool->messages_len--;
+		message = pool->messages[pool->messages_len];
+	}
+	else
+	{
+		message = g_slice_new(JMessage);
+		message->send_list = j_list_new(j_message_data_free);
+		message->receive_list = j_list_new(j_message_data_free);
+	}
+
+	message->size = length;
+	message->data = j_message_buffer_alloc(&(message->size));
+	message->current = message->data;
+	message->inline_data = NULL;
+	message->inline_length = 0;
+	message->original_message = NULL;
+	message->trace_time = 0;
+	message->has_trace_context = FALSE;
+	message->has_timing = FALSE;
+	message->lazy_create = FALSE;
+	message->ref_count = 1;
+
+	return message;
+}
+
+/**
+ * Frees a message, returning it and its buffer to the current thread's pool.
+ *
+ * \private
+ *
+ * \param message A message.
+ **/
+static void
+j_message_free(JMessage* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessagePool* pool;
+
+	j_message_buffer_free(message->data, message->size);
+
+	pool = j_message_pool_get();
+
+	if (pool->messages_len < J_MESSAGE_POOL_DEPTH)
+	{
+		j_list_delete_all(message->send_list);
+		j_list_delete_all(message->receive_list);
+
+		pool->messages[pool->messages_len] = message;
+		pool->messages_len++;
+
+		return;
+	}
+
+	j_list_unref(message->send_list);
+	j_list_unref(message->receive_list);
+
+	g_slice_free(JMessage, message);
+}
+
+/**
+ * Checks whether it is possible to append data to a message.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ * \param length  A length.
+ *
+ * \return TRUE if it is possible, FALSE otherwise.
+ **/
+static gboolean
+j_message_can_append(JMessage const* message, gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return (message->current + length <= message->data + message->size);
+}
+
+/**
+ * Checks whether it is possible to get data from a message.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ * \param length  A length.
+ *
+ * \return TRUE if it is possible, FALSE otherwise.
+ **/
+static gboolean
+j_message_can_get(JMessage const* message, gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return (message->current + length <= message->data + j_message_length(message));
+}
+
+static void
+j_message_extend(JMessage* message, gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gsize factor = 1;
+	gsize current_length;
+	guint32 count;
+
+	if (length == 0)
+	{
+		return;
+	}
+
+	current_length = j_message_length(message);
+
+	if (current_length + length <= message->size)
+	{
+		return;
+	}
+
+	count = j_message_get_count(message);
+
+	if (count > 10)
+	{
+		factor = pow(10, floor(log10(count)));
+	}
+
+	j_message_buffer_grow(message, message->size + length * factor);
+}
+
+static void
+j_message_ensure_size(JMessage* message, gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (length <= message->size)
+	{
+		return;
+	}
+
+	j_message_buffer_grow(message, length);
+}
+
+/**
+ * Creates a new message.
+ *
+ * \code
+ * \endcode
+ *
+ * \param op_type An operation type.
+ * \param length  A length.
+ *
+ * \return A new message. Should be freed with j_message_unref().
+ **/
+JMessage*
+j_message_new(JMessageType op_type, gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessage* message;
+	guint32 id;
+
+	//g_return_val_if_fail(op_type != J_MESSAGE_NONE, NULL);
+
+	length = MAX(256, length);
+	id = (guint32)g_atomic_int_add(&j_message_next_id, 1);
+
+	message = j_message_alloc(length);
 
 	message->header.length = GUINT32_TO_LE(0);
-	message->header.id = GUINT32_TO_LE(rand);
+	message->header.id = GUINT32_TO_LE(id);
 	message->header.semantics = GUINT32_TO_LE(0);
 	message->header.op_type = GUINT32_TO_LE(op_type);
 	message->header.op_count = GUINT32_TO_LE(0);
+	message->header.compression = GUINT32_TO_LE(J_MESSAGE_COMPRESSION_NONE);
+	message->header.compressed_length = GUINT32_TO_LE(0);
+	message->header.data_length = GUINT32_TO_LE(0);
 
 	return message;
 }
@@ -355,19 +991,18 @@ j_message_new_reply(JMessage* message)
 
 	g_return_val_if_fail(message != NULL, NULL);
 
-	reply = g_slice_new(JMessage);
-	reply->size = 256;
-	reply->data = g_malloc(reply->size);
-	reply->current = reply->data;
-	reply->send_list = j_list_new(j_message_data_free);
+	// Presize the reply based on the request's operation count to avoid growing it later.
+	reply = j_message_alloc(MAX(256, j_message_get_count(message) * J_MESSAGE_REPLY_OPERATION_SIZE));
 	reply->original_message = j_message_ref(message);
-	reply->ref_count = 1;
 
 	reply->header.length = GUINT32_TO_LE(0);
 	reply->header.id = message->header.id;
 	reply->header.semantics = GUINT32_TO_LE(0);
 	reply->header.op_type = message->header.op_type;
 	reply->header.op_count = GUINT32_TO_LE(0);
+	reply->header.compression = GUINT32_TO_LE(J_MESSAGE_COMPRESSION_NONE);
+	reply->header.compressed_length = GUINT32_TO_LE(0);
+	reply->header.data_length = GUINT32_TO_LE(0);
 
 	return reply;
 }
@@ -420,14 +1055,7 @@ j_message_unref(JMessage* message)
 			j_message_unref(message->original_message);
 		}
 
-		if (message->send_list != NULL)
-		{
-			j_list_unref(message->send_list);
-		}
-
-		g_free(message->data);
-
-		g_slice_free(JMessage, message);
+		j_message_free(message);
 	}
 }
 
@@ -456,6 +1084,29 @@ j_message_get_type(JMessage const* message)
 	return op_type;
 }
 
+/**
+ * Returns the name of a message type.
+ *
+ * \code
+ * \endcode
+ *
+ * \param type A message type.
+ *
+ * \return The name, NULL for unknown message types.
+ **/
+gchar const*
+j_message_type_get_name(JMessageType type)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if ((guint)type >= G_N_ELEMENTS(j_message_type_names))
+	{
+		return NULL;
+	}
+
+	return j_message_type_names[type];
+}
+
 /**
  * Returns a message's count.
  *
@@ -482,23 +1133,160 @@ j_message_get_count(JMessage const* message)
 }
 
 /**
- * Appends 1 byte to a message.
+ * Returns the trace context a request was sent with.
+ * Servers use it to continue the client's trace, see j_trace_context_set().
  *
  * \code
  * \endcode
  *
  * \param message A message.
- * \param data    Data to append.
+ * \param context A trace context.
  *
- * \return TRUE on success, FALSE if an error occurred.
+ * \return TRUE if the message carried a trace context, FALSE otherwise.
  **/
 gboolean
-j_message_append_1(JMessage* message, gconstpointer data)
+j_message_get_trace_context(JMessage const* message, JTraceContext* context)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	guint32 new_length;
-
+	g_return_val_if_fail(message != NULL, FALSE);
+	g_return_val_if_fail(context != NULL, FALSE);
+
+	if (!message->has_trace_context)
+	{
+		return FALSE;
+	}
+
+	*context = message->trace_context;
+
+	return TRUE;
+}
+
+/**
+ * Returns the server-side timings echoed back in a reply.
+ * Servers only echo timings if the client has JULEA_MESSAGE_TIMING set.
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A reply.
+ * \param timing  A timing.
+ *
+ * \return TRUE if the reply carried timings, FALSE otherwise.
+ **/
+gboolean
+j_message_get_timing(JMessage const* message, JMessageTiming* timing)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(message != NULL, FALSE);
+	g_return_val_if_fail(timing != NULL, FALSE);
+
+	if (message->original_message == NULL || !message->has_timing)
+	{
+		return FALSE;
+	}
+
+	timing->queue_time = GUINT32_FROM_LE(message->timing.queue_time);
+	timing->receive_time = GUINT32_FROM_LE(message->timing.receive_time);
+	timing->service_time = GUINT32_FROM_LE(message->timing.service_time);
+	timing->reserved = 0;
+
+	return TRUE;
+}
+
+/**
+ * Returns whether the server may create the objects a request refers to if they do not exist.
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ *
+ * \return TRUE if missing objects may be created, FALSE otherwise.
+ **/
+gboolean
+j_message_get_lazy_create(JMessage const* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(message != NULL, FALSE);
+
+	return message->lazy_create;
+}
+
+/**
+ * Allows the server to create the objects a request refers to if they do not exist.
+ * This is used for the parts of distributed objects, which are only created by their first write.
+ * Deletions of such missing objects succeed, since they might never have been written.
+ * The server has to be configured to create objects lazily, see j_configuration_get_object_lazy_create().
+ *
+ * \code
+ * \endcode
+ *
+ * \param message     A request.
+ * \param lazy_create Whether missing objects may be created.
+ **/
+void
+j_message_set_lazy_create(JMessage* message, gboolean lazy_create)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(message != NULL);
+	g_return_if_fail(message->original_message == NULL);
+
+	message->lazy_create = lazy_create;
+}
+
+/**
+ * Sets the server-side timings to echo back in a reply.
+ * The timings are only sent if the request asked for them.
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A reply.
+ * \param timing  A timing.
+ **/
+void
+j_message_set_timing(JMessage* message, JMessageTiming const* timing)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(message != NULL);
+	g_return_if_fail(message->original_message != NULL);
+	g_return_if_fail(timing != NULL);
+
+	if (!message->original_message->has_timing)
+	{
+		return;
+	}
+
+	message->timing.queue_time = GUINT32_TO_LE(timing->queue_time);
+	message->timing.receive_time = GUINT32_TO_LE(timing->receive_time);
+	message->timing.service_time = GUINT32_TO_LE(timing->service_time);
+	message->timing.reserved = 0;
+	message->has_timing = TRUE;
+}
+
+/**
+ * Appends 1 byte to a message.
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ * \param data    Data to append.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+gboolean
+j_message_append_1(JMessage* message, gconstpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint32 new_length;
+
 	g_return_val_if_fail(message != NULL, FALSE);
 	g_return_val_if_fail(data != NULL, FALSE);
 	g_return_val_if_fail(j_message_can_append(message, 1), FALSE);
@@ -739,63 +1527,1815 @@ j_message_get_n(JMessage* message, gsize length)
 
 	gpointer ret;
 
-	g_return_val_if_fail(message != NULL, NULL);
-	g_return_val_if_fail(j_message_can_get(message, length), NULL);
+	g_return_val_if_fail(message != NULL, NULL);
+	g_return_val_if_fail(j_message_can_get(message, length), NULL);
+
+	ret = message->current;
+	message->current += length;
+
+	return ret;
+}
+
+/**
+ * Gets a string from a message.
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ *
+ * \return A string.
+ **/
+gchar const*
+j_message_get_string(JMessage* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gchar const* ret;
+
+	g_return_val_if_fail(message != NULL, NULL);
+
+	ret = message->current;
+	message->current += strlen(ret) + 1;
+
+	return ret;
+}
+
+/**
+ * Maps a codec name to a compression codec.
+ *
+ * \private
+ *
+ * \param codec A codec name.
+ *
+ * \return The codec, J_MESSAGE_COMPRESSION_NONE if it is unknown or unsupported.
+ **/
+static JMessageCompression
+j_message_compression_from_string(gchar const* codec)
+{
+	J_TRACE_FUNCTION(NULL);
+
+#ifdef HAVE_LZ4
+	if (g_strcmp0(codec, "lz4") == 0)
+	{
+		return J_MESSAGE_COMPRESSION_LZ4;
+	}
+#endif
+
+#ifdef HAVE_ZSTD
+	if (g_strcmp0(codec, "zstd") == 0)
+	{
+		return J_MESSAGE_COMPRESSION_ZSTD;
+	}
+#endif
+
+	return J_MESSAGE_COMPRESSION_NONE;
+}
+
+/**
+ * Copies a message's additional data into a buffer.
+ * Data backed by a file is read from it, missing data is filled with zeros to keep the message intact.
+ *
+ * \private
+ *
+ * \param message_data Additional data.
+ * \param buffer       A buffer of at least the data's length.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_message_data_copy(JMessageData const* message_data, gchar* buffer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 done = 0;
+
+	if (message_data->fd == -1)
+	{
+		memcpy(buffer, message_data->data, message_data->length);
+		return TRUE;
+	}
+
+	while (done < message_data->length)
+	{
+		gssize bytes_read;
+
+		bytes_read = pread(message_data->fd, buffer + done, message_data->length - done, message_data->offset + done);
+
+		if (bytes_read < 0 && errno == EINTR)
+		{
+			continue;
+		}
+
+		if (bytes_read < 0)
+		{
+			g_critical("%s", g_strerror(errno));
+			return FALSE;
+		}
+
+		if (bytes_read == 0)
+		{
+			memset(buffer + done, 0, message_data->length - done);
+			break;
+		}
+
+		done += bytes_read;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Writes a buffer to a file at an offset.
+ *
+ * \private
+ *
+ * \param fd     A file descriptor.
+ * \param data   A buffer.
+ * \param length The buffer's length.
+ * \param offset An offset within the file.
+ *
+ * \return The number of bytes written, less than length if an error occurred.
+ **/
+static gsize
+j_message_write_all(gint fd, gconstpointer data, gsize length, guint64 offset)
+{
+	gsize done = 0;
+
+	while (done < length)
+	{
+		gssize bytes_written;
+
+		bytes_written = pwrite(fd, (gchar const*)data + done, length - done, offset + done);
+
+		if (bytes_written < 0 && errno == EINTR)
+		{
+			continue;
+		}
+
+		if (bytes_written <= 0)
+		{
+			break;
+		}
+
+		done += bytes_written;
+	}
+
+	return done;
+}
+
+/**
+ * Sends data from a file to a socket.
+ * Uses sendfile() if available, so the data does not have to be copied to user space.
+ *
+ * \private
+ *
+ * \param socket_ A socket.
+ * \param fd      A file descriptor.
+ * \param offset  An offset within the file.
+ * \param length  A length.
+ * \param error   A GError.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_message_send_file(GSocket* socket_, gint fd, guint64 offset, guint64 length, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* buffer = NULL;
+
+#ifdef HAVE_SENDFILE
+	gint socket_fd;
+	off_t position;
+
+	socket_fd = g_socket_get_fd(socket_);
+	position = offset;
+
+	while (length > 0)
+	{
+		gssize bytes_sent;
+
+		// sendfile() transfers at most 0x7ffff000 bytes at once.
+		bytes_sent = sendfile(socket_fd, fd, &position, MIN(length, 0x7ffff000));
+
+		if (bytes_sent < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			// GSocket's descriptors are always non-blocking.
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+			{
+				if (!g_socket_condition_wait(socket_, G_IO_OUT, NULL, error))
+				{
+					return FALSE;
+				}
+
+				continue;
+			}
+
+			g_set_error_literal(error, G_IO_ERROR, g_io_error_from_errno(errno), g_strerror(errno));
+			return FALSE;
+		}
+
+		// The file is shorter than expected, the rest is padded below.
+		if (bytes_sent == 0)
+		{
+			break;
+		}
+
+		length -= bytes_sent;
+	}
+
+	offset = position;
+#endif
+
+	if (length > 0)
+	{
+		buffer = g_malloc(J_MESSAGE_FILE_BUFFER_SIZE);
+	}
+
+	while (length > 0)
+	{
+		JMessageData message_data;
+		gsize bytes_sent = 0;
+
+		message_data.data = NULL;
+		message_data.length = MIN(length, J_MESSAGE_FILE_BUFFER_SIZE);
+		message_data.fd = fd;
+		message_data.offset = offset;
+
+		if (!j_message_data_copy(&message_data, buffer))
+		{
+			g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Reading file data failed");
+			return FALSE;
+		}
+
+		while (bytes_sent < message_data.length)
+		{
+			gssize ret;
+
+			ret = g_socket_send(socket_, buffer + bytes_sent, message_data.length - bytes_sent, NULL, error);
+
+			if (ret < 0)
+			{
+				return FALSE;
+			}
+
+			bytes_sent += ret;
+		}
+
+		offset += message_data.length;
+		length -= message_data.length;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Compresses a message's data including its additional data.
+ *
+ * \private
+ *
+ * \param message           A message.
+ * \param compression       A compression codec.
+ * \param compressed_length Returns the compressed length.
+ * \param data_length       Returns the length of the included additional data.
+ *
+ * \return The compressed payload or NULL if compression is not worthwhile.
+ **/
+static gchar*
+j_message_compress(JMessage* message, JMessageCompression compression, gsize* compressed_length, gsize* data_length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JListIterator) iterator = NULL;
+	g_autofree gchar* raw = NULL;
+	gchar* compressed = NULL;
+	gchar const* source;
+	gsize length;
+	gsize total;
+
+	length = j_message_length(message);
+	*data_length = 0;
+
+	if (message->send_list != NULL)
+	{
+		iterator = j_list_iterator_new(message->send_list);
+
+		while (j_list_iterator_next(iterator))
+		{
+			JMessageData* message_data = j_list_iterator_get(iterator);
+
+			*data_length += message_data->length;
+		}
+	}
+
+	total = length + *data_length;
+
+	if (total < J_MESSAGE_COMPRESSION_THRESHOLD || total > G_MAXUINT32)
+	{
+		return NULL;
+	}
+
+	source = message->data;
+
+	if (*data_length > 0)
+	{
+		gchar* position;
+
+		raw = g_malloc(total);
+		memcpy(raw, message->data, length);
+		position = raw + length;
+
+		j_list_iterator_free(iterator);
+		iterator = j_list_iterator_new(message->send_list);
+
+		while (j_list_iterator_next(iterator))
+		{
+			JMessageData* message_data = j_list_iterator_get(iterator);
+
+			if (!j_message_data_copy(message_data, position))
+			{
+				return NULL;
+			}
+
+			position += message_data->length;
+		}
+
+		source = raw;
+	}
+
+	*compressed_length = 0;
+
+	switch (compression)
+	{
+#ifdef HAVE_LZ4
+		case J_MESSAGE_COMPRESSION_LZ4:
+			if (total <= LZ4_MAX_INPUT_SIZE)
+			{
+				gint bound;
+				gint ret;
+
+				bound = LZ4_compressBound(total);
+				compressed = g_malloc(bound);
+				ret = LZ4_compress_default(source, compressed, total, bound);
+
+				if (ret > 0)
+				{
+					*compressed_length = ret;
+				}
+			}
+			break;
+#endif
+#ifdef HAVE_ZSTD
+		case J_MESSAGE_COMPRESSION_ZSTD:
+		{
+			gsize bound;
+			gsize ret;
+
+			bound = ZSTD_compressBound(total);
+			compressed = g_malloc(bound);
+			ret = ZSTD_compress(compressed, bound, source, total, J_MESSAGE_COMPRESSION_ZSTD_LEVEL);
+
+			if (!ZSTD_isError(ret))
+			{
+				*compressed_length = ret;
+			}
+		}
+		break;
+#endif
+		case J_MESSAGE_COMPRESSION_NONE:
+		default:
+			break;
+	}
+
+	// Incompressible data is sent as it is.
+	if (*compressed_length == 0 || *compressed_length >= total)
+	{
+		g_free(compressed);
+		compressed = NULL;
+	}
+
+	return compressed;
+}
+
+/**
+ * Decompresses a payload.
+ *
+ * \private
+ *
+ * \param compression       A compression codec.
+ * \param compressed        The compressed payload.
+ * \param compressed_length The compressed length.
+ * \param data              A buffer for the decompressed data.
+ * \param length            The decompressed length.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_message_decompress(JMessageCompression compression, gchar const* compressed, gsize compressed_length, gchar* data, gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	(void)compressed;
+	(void)compressed_length;
+	(void)data;
+	(void)length;
+
+	switch (compression)
+	{
+#ifdef HAVE_LZ4
+		case J_MESSAGE_COMPRESSION_LZ4:
+			ret = (LZ4_decompress_safe(compressed, data, compressed_length, length) == (gint)length);
+			break;
+#endif
+#ifdef HAVE_ZSTD
+		case J_MESSAGE_COMPRESSION_ZSTD:
+			ret = (ZSTD_decompress(data, length, compressed, compressed_length) == length);
+			break;
+#endif
+		case J_MESSAGE_COMPRESSION_NONE:
+		default:
+			g_warning("Received message with unsupported compression %d.", compression);
+			break;
+	}
+
+	return ret;
+}
+
+/**
+ * Appends a varint.
+ *
+ * \private
+ *
+ * \param position A buffer with room for at least #J_MESSAGE_VARINT_MAX bytes.
+ * \param value    A value.
+ *
+ * \return The number of bytes written.
+ **/
+static guint
+j_message_varint_put(gchar* position, guint64 value)
+{
+	guint length = 0;
+
+	while (value >= 0x80)
+	{
+		position[length++] = (gchar)((value & 0x7f) | 0x80);
+		value >>= 7;
+	}
+
+	position[length++] = (gchar)value;
+
+	return length;
+}
+
+/**
+ * Reads a varint.
+ *
+ * \private
+ *
+ * \param position The current position, advanced past the varint.
+ * \param end      The end of the buffer.
+ * \param value    Returns the value.
+ *
+ * \return TRUE on success, FALSE if the varint is truncated or too long.
+ **/
+static gboolean
+j_message_varint_get(gchar const** position, gchar const* end, guint64* value)
+{
+	guint64 result = 0;
+
+	for (guint shift = 0; shift < 64 && *position < end; shift += 7)
+	{
+		guchar byte = (guchar)(**position);
+
+		(*position)++;
+		result |= (guint64)(byte & 0x7f) << shift;
+
+		if ((byte & 0x80) == 0)
+		{
+			*value = result;
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/**
+ * Returns the length of the fields following an operation's offset.
+ *
+ * \private
+ *
+ * \param type   The message type.
+ * \param length The operation's length including its flags.
+ *
+ * \return The length.
+ **/
+static gsize
+j_message_compact_extra_length(JMessageType type, guint64 length)
+{
+	gsize extra_length = 0;
+
+	// Only writes carry the checksum and hash, reads merely ask for the checksum
+	if (type == J_MESSAGE_OBJECT_WRITE)
+	{
+		extra_length += ((length & J_MESSAGE_LENGTH_CHECKSUM) != 0) ? sizeof(guint32) : 0;
+		extra_length += ((length & J_MESSAGE_LENGTH_DEDUP) != 0) ? J_CHECKSUM_DIGEST_SIZE : 0;
+	}
+
+	return extra_length;
+}
+
+/**
+ * Encodes an object read or write request compactly.
+ *
+ * The namespace and name are replaced by a single byte if they match the previous compactly encoded message on the connection.
+ * Each operation's length and offset are encoded as varints, with the length's flags moved to its lowest bits
+ * and the offset relative to the end of the previous operation, so that sequential accesses need a single byte.
+ * Fields following the offset are copied as they are.
+ *
+ * \private
+ *
+ * \param message A message.
+ * \param compact The connection's compact encoding state.
+ * \param length  Returns the encoded length.
+ *
+ * \return The encoded payload or NULL if the message can not be or is not worth encoding.
+ **/
+static gchar*
+j_message_compact_encode(JMessage* message, JMessageCompact* compact, gsize* length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* encoded = NULL;
+	JMessageType type;
+	gchar const* data;
+	gchar const* end;
+	gchar const* current;
+	gchar const* separator;
+	gchar* position;
+	gsize names_length;
+	gboolean same_names;
+	guint32 op_count;
+	guint64 expected = 0;
+
+	type = j_message_get_type(message);
+
+	if (message->original_message != NULL || (type != J_MESSAGE_OBJECT_READ && type != J_MESSAGE_OBJECT_WRITE))
+	{
+		return NULL;
+	}
+
+	data = message->data;
+	end = data + j_message_length(message);
+
+	// The namespace and name are the first two strings
+	if ((separator = memchr(data, '\0', end - data)) == NULL || (separator = memchr(separator + 1, '\0', end - separator - 1)) == NULL)
+	{
+		return NULL;
+	}
+
+	names_length = separator + 1 - data;
+	same_names = (compact->names != NULL && compact->names_length == names_length && memcmp(compact->names, data, names_length) == 0);
+	op_count = j_message_get_count(message);
+
+	encoded = g_malloc(1 + names_length + (gsize)op_count * (2 * J_MESSAGE_VARINT_MAX + sizeof(guint32) + J_CHECKSUM_DIGEST_SIZE));
+	position = encoded;
+
+	*position++ = (same_names) ? 1 : 0;
+
+	if (!same_names)
+	{
+		memcpy(position, data, names_length);
+		position += names_length;
+	}
+
+	current = data + names_length;
+
+	for (guint32 i = 0; i < op_count; i++)
+	{
+		guint64 op_length;
+		guint64 op_offset;
+		guint64 flags;
+		guint64 delta;
+		gsize extra_length;
+
+		if (end - current < (gssize)(2 * sizeof(guint64)))
+		{
+			return NULL;
+		}
+
+		memcpy(&op_length, current, sizeof(guint64));
+		memcpy(&op_offset, current + sizeof(guint64), sizeof(guint64));
+		current += 2 * sizeof(guint64);
+
+		op_length = GUINT64_FROM_LE(op_length);
+		op_offset = GUINT64_FROM_LE(op_offset);
+
+		extra_length = j_message_compact_extra_length(type, op_length);
+		flags = ((op_length & J_MESSAGE_LENGTH_CHECKSUM) ? 1 : 0) | ((op_length & J_MESSAGE_LENGTH_DEDUP) ? 2 : 0);
+		op_length &= ~(J_MESSAGE_LENGTH_CHECKSUM | J_MESSAGE_LENGTH_DEDUP);
+
+		// Zigzag encoding keeps small negative deltas short
+		delta = op_offset - expected;
+		delta = (delta << 1) ^ (((gint64)delta < 0) ? G_MAXUINT64 : 0);
+
+		position += j_message_varint_put(position, (op_length << 2) | flags);
+		position += j_message_varint_put(position, delta);
+
+		expected = op_offset + op_length;
+
+		if ((gsize)(end - current) < extra_length)
+		{
+			return NULL;
+		}
+
+		memcpy(position, current, extra_length);
+		position += extra_length;
+		current += extra_length;
+	}
+
+	*length = position - encoded;
+
+	// Unknown trailing data can not be encoded
+	if (current != end || *length >= j_message_length(message))
+	{
+		return NULL;
+	}
+
+	if (!same_names)
+	{
+		g_free(compact->names);
+		compact->names = g_malloc(names_length);
+		compact->names_length = names_length;
+		memcpy(compact->names, data, names_length);
+	}
+
+	return g_steal_pointer(&encoded);
+}
+
+/**
+ * Decodes a payload encoded with j_message_compact_encode() into a message's data.
+ * The message's header has to be set already.
+ *
+ * \private
+ *
+ * \param message        A message.
+ * \param compact        The connection's compact encoding state.
+ * \param encoded        The encoded payload.
+ * \param encoded_length The encoded length.
+ *
+ * \return TRUE on success, FALSE if the payload is invalid.
+ **/
+static gboolean
+j_message_compact_decode(JMessage* message, JMessageCompact* compact, gchar const* encoded, gsize encoded_length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessageType type;
+	gchar const* current = encoded;
+	gchar const* end = encoded + encoded_length;
+	gchar* position;
+	guint32 op_count;
+	guint64 expected = 0;
+
+	type = j_message_get_type(message);
+	op_count = j_message_get_count(message);
+
+	if (encoded_length == 0)
+	{
+		return FALSE;
+	}
+
+	if (*current++ == 0)
+	{
+		gchar const* separator;
+
+		if ((separator = memchr(current, '\0', end - current)) == NULL || (separator = memchr(separator + 1, '\0', end - separator - 1)) == NULL)
+		{
+			return FALSE;
+		}
+
+		g_free(compact->names);
+		compact->names_length = separator + 1 - current;
+		compact->names = g_malloc(compact->names_length);
+		memcpy(compact->names, current, compact->names_length);
+		current += compact->names_length;
+	}
+	else if (compact->names == NULL)
+	{
+		return FALSE;
+	}
+
+	j_message_ensure_size(message, compact->names_length + (gsize)op_count * (2 * sizeof(guint64) + sizeof(guint32) + J_CHECKSUM_DIGEST_SIZE));
+
+	position = message->data;
+	memcpy(position, compact->names, compact->names_length);
+	position += compact->names_length;
+
+	for (guint32 i = 0; i < op_count; i++)
+	{
+		guint64 op_length;
+		guint64 op_offset;
+		guint64 delta;
+		gsize extra_length;
+
+		if (!j_message_varint_get(&current, end, &op_length) || !j_message_varint_get(&current, end, &delta))
+		{
+			return FALSE;
+		}
+
+		op_offset = expected + ((delta >> 1) ^ ((delta & 1) ? G_MAXUINT64 : 0));
+		expected = op_offset + (op_length >> 2);
+
+		op_length = (op_length >> 2) | ((op_length & 1) ? J_MESSAGE_LENGTH_CHECKSUM : 0) | ((op_length & 2) ? J_MESSAGE_LENGTH_DEDUP : 0);
+		extra_length = j_message_compact_extra_length(type, op_length);
+
+		if ((gsize)(end - current) < extra_length)
+		{
+			return FALSE;
+		}
+
+		op_length = GUINT64_TO_LE(op_length);
+		op_offset = GUINT64_TO_LE(op_offset);
+
+		memcpy(position, &op_length, sizeof(guint64));
+		memcpy(position + sizeof(guint64), &op_offset, sizeof(guint64));
+		position += 2 * sizeof(guint64);
+
+		memcpy(position, current, extra_length);
+		position += extra_length;
+		current += extra_length;
+	}
+
+	if (current != end)
+	{
+		return FALSE;
+	}
+
+	message->header.length = GUINT32_TO_LE(position - message->data);
+
+	return TRUE;
+}
+
+/**
+ * Writes a message to a socket using a single gather write.
+ *
+ * The header, the message's data and all additional data added via
+ * j_message_add_send() are collected into one vector and sent with as few
+ * system calls as possible. Partial writes are handled by advancing through
+ * the vector.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ * \param socket_ A socket.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_message_write_vectored(JMessage* message, GSocket* socket_, JMessageCompression compression, JMessageCompact* compact, gsize* length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	g_autoptr(JListIterator) iterator = NULL;
+	g_autofree GOutputVector* vectors = NULL;
+	g_autofree JMessageData const** files = NULL;
+	g_autofree gchar* compressed = NULL;
+	g_autofree gchar* encoded = NULL;
+	JMessageHeader header;
+	JTraceContext trace_context;
+	GError* error = NULL;
+	gsize compressed_length = 0;
+	gsize data_length = 0;
+	gsize encoded_length = 0;
+	guint32 trace_flag = 0;
+	guint32 timing_flag = 0;
+	guint32 lazy_flag;
+	guint count;
+	guint i;
+
+	header = message->header;
+	header.compression = GUINT32_TO_LE(J_MESSAGE_COMPRESSION_NONE);
+	header.compressed_length = GUINT32_TO_LE(0);
+	header.data_length = GUINT32_TO_LE(0);
+
+	if (compression != J_MESSAGE_COMPRESSION_NONE)
+	{
+		compressed = j_message_compress(message, compression, &compressed_length, &data_length);
+	}
+
+	// Compressed messages are large enough for their operations not to matter
+	if (compressed == NULL && compact != NULL)
+	{
+		encoded = j_message_compact_encode(message, compact, &encoded_length);
+	}
+
+	// Replies do not need a trace context, the client already knows its trace.
+	if (message->original_message == NULL && j_trace_context_get(&trace_context))
+	{
+		trace_flag = J_MESSAGE_TRACE_CONTEXT;
+	}
+
+	// Requests only ask for timings, replies carry them.
+	if (message->original_message == NULL)
+	{
+		timing_flag = (j_message_timing_enabled()) ? J_MESSAGE_TIMING_REQUEST : 0;
+	}
+	else if (message->has_timing)
+	{
+		timing_flag = J_MESSAGE_TIMING;
+	}
+
+	lazy_flag = (message->lazy_create) ? J_MESSAGE_LAZY_CREATE : 0;
+
+	count = 2 + ((trace_flag != 0) ? 1 : 0) + ((timing_flag == J_MESSAGE_TIMING) ? 1 : 0);
+
+	if (compressed == NULL && message->send_list != NULL)
+	{
+		count += j_list_length(message->send_list);
+	}
+
+	vectors = g_new(GOutputVector, count);
+	// Additional data backed by a file is not part of the gather writes.
+	files = g_new0(JMessageData const*, count);
+
+	i = 0;
+
+	vectors[i].buffer = &header;
+	vectors[i].size = sizeof(JMessageHeader);
+	i++;
+
+	header.compression = GUINT32_TO_LE(J_MESSAGE_COMPRESSION_NONE | trace_flag | timing_flag | lazy_flag);
+
+	if (trace_flag != 0)
+	{
+		vectors[i].buffer = &trace_context;
+		vectors[i].size = sizeof(JTraceContext);
+		i++;
+	}
+
+	if (timing_flag == J_MESSAGE_TIMING)
+	{
+		vectors[i].buffer = &(message->timing);
+		vectors[i].size = sizeof(JMessageTiming);
+		i++;
+	}
+
+	vectors[i].buffer = message->data;
+	vectors[i].size = j_message_length(message);
+	i++;
+
+	if (compressed != NULL)
+	{
+		// The compressed payload replaces the message's data and its additional data.
+		header.compression = GUINT32_TO_LE(compression | trace_flag | timing_flag | lazy_flag);
+		header.compressed_length = GUINT32_TO_LE(compressed_length);
+		header.data_length = GUINT32_TO_LE(data_length);
+
+		vectors[i - 1].buffer = compressed;
+		vectors[i - 1].size = compressed_length;
+	}
+	else if (encoded != NULL)
+	{
+		header.length = GUINT32_TO_LE(encoded_length);
+		header.compression = GUINT32_TO_LE(J_MESSAGE_COMPRESSION_NONE | trace_flag | timing_flag | lazy_flag | J_MESSAGE_COMPACT);
+
+		vectors[i - 1].buffer = encoded;
+		vectors[i - 1].size = encoded_length;
+	}
+
+	if (compressed == NULL && message->send_list != NULL)
+	{
+		iterator = j_list_iterator_new(message->send_list);
+
+		while (j_list_iterator_next(iterator))
+		{
+			JMessageData* message_data = j_list_iterator_get(iterator);
+
+			vectors[i].buffer = message_data->data;
+			vectors[i].size = message_data->length;
+
+			if (message_data->fd != -1)
+			{
+				files[i] = message_data;
+			}
+
+			i++;
+		}
+	}
+
+	*length = 0;
+
+	for (i = 0; i < count; i++)
+	{
+		*length += vectors[i].size;
+	}
+
+	i = 0;
+
+	while (i < count)
+	{
+		gssize bytes_written;
+		guint n;
+
+		if (files[i] != NULL)
+		{
+			if (!j_message_send_file(socket_, files[i]->fd, files[i]->offset, files[i]->length, &error))
+			{
+				goto end;
+			}
+
+			i++;
+			continue;
+		}
+
+		// The kernel refuses to take more than IOV_MAX vectors at once.
+		for (n = i; n < count && n - i < J_MESSAGE_MAX_VECTORS && files[n] == NULL; n++)
+		{
+		}
+
+		bytes_written = g_socket_send_message(socket_, NULL, vectors + i, n - i, NULL, 0, 0, NULL, &error);
+
+		if (bytes_written < 0)
+		{
+			goto end;
+		}
+
+		while (i < n && (gsize)bytes_written >= vectors[i].size)
+		{
+			bytes_written -= vectors[i].size;
+			i++;
+		}
+
+		if (i < n && bytes_written > 0)
+		{
+			vectors[i].buffer = (gchar const*)vectors[i].buffer + bytes_written;
+			vectors[i].size -= bytes_written;
+		}
+	}
+
+	ret = TRUE;
+
+end:
+	if (error != NULL)
+	{
+		g_critical("%s", error->message);
+		g_error_free(error);
+	}
+
+	return ret;
+}
+
+/**
+ * Returns the reply queue for a message ID, creating it if necessary.
+ * The multiplexer's mutex has to be held.
+ *
+ * \private
+ **/
+static GAsyncQueue*
+j_message_multiplexer_get_queue(JMessageMultiplexer* multiplexer, guint32 id)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GAsyncQueue* queue;
+
+	queue = g_hash_table_lookup(multiplexer->replies, GUINT_TO_POINTER(id));
+
+	if (queue == NULL)
+	{
+		queue = g_async_queue_new();
+		g_hash_table_insert(multiplexer->replies, GUINT_TO_POINTER(id), queue);
+	}
+
+	return queue;
+}
+
+static gpointer
+j_message_multiplexer_thread(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessageMultiplexer* multiplexer = data;
+
+	GHashTableIter iter;
+	gpointer value;
+
+	while (TRUE)
+	{
+		JMessage* reply;
+		GAsyncQueue* queue;
+
+		reply = j_message_new(J_MESSAGE_NONE, 0);
+
+		if (!j_message_read(reply, multiplexer->stream))
+		{
+			j_message_unref(reply);
+			break;
+		}
+
+		g_mutex_lock(multiplexer->mutex);
+		queue = j_message_multiplexer_get_queue(multiplexer, reply->header.id);
+		g_async_queue_push(queue, reply);
+		g_mutex_unlock(multiplexer->mutex);
+	}
+
+	// Wake up all waiters, they will notice the failure.
+	g_mutex_lock(multiplexer->mutex);
+
+	multiplexer->failed = TRUE;
+
+	g_hash_table_iter_init(&iter, multiplexer->replies);
+
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+	{
+		g_async_queue_push(value, &j_message_multiplexer_failed);
+	}
+
+	g_mutex_unlock(multiplexer->mutex);
+
+	return NULL;
+}
+
+static void
+j_message_multiplexer_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessageMultiplexer* multiplexer = data;
+
+	GHashTableIter iter;
+	gpointer value;
+
+	// Wakes up the thread blocked in j_message_read().
+	g_socket_shutdown(multiplexer->socket, TRUE, FALSE, NULL);
+	g_thread_join(multiplexer->thread);
+
+	g_hash_table_iter_init(&iter, multiplexer->replies);
+
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+	{
+		gpointer reply;
+
+		while ((reply = g_async_queue_try_pop(value)) != NULL)
+		{
+			if (reply != &j_message_multiplexer_failed)
+			{
+				j_message_unref(reply);
+			}
+		}
+	}
+
+	g_hash_table_unref(multiplexer->replies);
+
+	g_mutex_clear(multiplexer->mutex);
+	g_mutex_clear(multiplexer->send_mutex);
+
+	g_object_unref(multiplexer->socket);
+	g_object_unref(multiplexer->stream);
+
+	g_slice_free(JMessageMultiplexer, multiplexer);
+}
+
+/**
+ * Waits for a reply on a multiplexed connection.
+ *
+ * \private
+ *
+ * \param multiplexer A multiplexer.
+ * \param id          A message ID.
+ *
+ * \return A reply, NULL if the connection has failed.
+ **/
+static JMessage*
+j_message_multiplexer_pop(JMessageMultiplexer* multiplexer, guint32 id)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GAsyncQueue* queue;
+	gpointer reply;
+
+	g_mutex_lock(multiplexer->mutex);
+
+	if (multiplexer->failed)
+	{
+		g_mutex_unlock(multiplexer->mutex);
+		return NULL;
+	}
+
+	queue = g_async_queue_ref(j_message_multiplexer_get_queue(multiplexer, id));
+
+	g_mutex_unlock(multiplexer->mutex);
+
+	reply = g_async_queue_pop(queue);
+
+	g_mutex_lock(multiplexer->mutex);
+
+	// Further replies for this ID will recreate the queue.
+	if (g_async_queue_length(queue) == 0 && reply != &j_message_multiplexer_failed)
+	{
+		g_hash_table_remove(multiplexer->replies, GUINT_TO_POINTER(id));
+	}
+
+	g_mutex_unlock(multiplexer->mutex);
+
+	g_async_queue_unref(queue);
+
+	if (reply == &j_message_multiplexer_failed)
+	{
+		return NULL;
+	}
+
+	return reply;
+}
+
+/**
+ * Allows a connection to be shared by multiple concurrent requests.
+ *
+ * A thread reads all replies from the connection and hands them to the
+ * threads waiting in j_message_receive() based on the message ID.
+ * Senders are serialized so that messages are not interleaved.
+ * Replies must not carry additional data (see j_message_receive_data()).
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param connection A connection.
+ **/
+void
+j_message_multiplex_start(gpointer connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessageMultiplexer* multiplexer;
+
+	g_return_if_fail(connection != NULL);
+	g_return_if_fail(g_object_get_qdata(connection, j_message_multiplexer_quark()) == NULL);
+
+	multiplexer = g_slice_new(JMessageMultiplexer);
+	multiplexer->stream = g_object_ref(g_io_stream_get_input_stream(G_IO_STREAM(connection)));
+	multiplexer->socket = g_object_ref(g_socket_connection_get_socket(connection));
+	multiplexer->replies = g_hash_table_new_full(NULL, NULL, NULL, (GDestroyNotify)g_async_queue_unref);
+	multiplexer->failed = FALSE;
+
+	g_mutex_init(multiplexer->send_mutex);
+	g_mutex_init(multiplexer->mutex);
+
+	multiplexer->thread = g_thread_new("JMessageMultiplexer", j_message_multiplexer_thread, multiplexer);
+
+	g_object_set_qdata_full(connection, j_message_multiplexer_quark(), multiplexer, j_message_multiplexer_free);
+}
+
+/**
+ * Stops sharing a connection.
+ * Has to be called before the connection is closed.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param connection A connection.
+ **/
+void
+j_message_multiplex_stop(gpointer connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(connection != NULL);
+
+	g_object_set_qdata(connection, j_message_multiplexer_quark(), NULL);
+}
+
+/**
+ * Checks whether a shared connection has failed.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param connection A connection.
+ *
+ * \return TRUE if the connection has failed, FALSE otherwise.
+ **/
+gboolean
+j_message_multiplex_failed(gpointer connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessageMultiplexer* multiplexer;
+	gboolean ret;
+
+	g_return_val_if_fail(connection != NULL, TRUE);
+
+	multiplexer = g_object_get_qdata(connection, j_message_multiplexer_quark());
+
+	if (multiplexer == NULL)
+	{
+		return FALSE;
+	}
+
+	g_mutex_lock(multiplexer->mutex);
+	ret = multiplexer->failed;
+	g_mutex_unlock(multiplexer->mutex);
+
+	return ret;
+}
+
+/**
+ * Checks whether a compression codec is supported.
+ *
+ * \code
+ * \endcode
+ *
+ * \param codec A codec name, such as "lz4" or "zstd".
+ *
+ * \return TRUE if the codec is supported, FALSE otherwise.
+ **/
+gboolean
+j_message_compression_supported(gchar const* codec)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(codec != NULL, FALSE);
+
+	return (j_message_compression_from_string(codec) != J_MESSAGE_COMPRESSION_NONE);
+}
+
+/**
+ * Enables compression for all messages sent via a connection.
+ * Both ends have to agree on the codec, which is negotiated via J_MESSAGE_PING.
+ * Messages smaller than J_MESSAGE_COMPRESSION_THRESHOLD are not compressed.
+ *
+ * \code
+ * \endcode
+ *
+ * \param connection A connection.
+ * \param codec      A codec name or NULL to disable compression.
+ *
+ * \return TRUE on success, FALSE if the codec is not supported.
+ **/
+gboolean
+j_message_set_compression(gpointer connection, gchar const* codec)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessageCompression compression = J_MESSAGE_COMPRESSION_NONE;
+
+	g_return_val_if_fail(connection != NULL, FALSE);
+
+	if (codec != NULL)
+	{
+		compression = j_message_compression_from_string(codec);
+
+		if (compression == J_MESSAGE_COMPRESSION_NONE)
+		{
+			return FALSE;
+		}
+	}
+
+	g_object_set_qdata(connection, j_message_compression_quark(), GUINT_TO_POINTER(compression));
+
+	return TRUE;
+}
+
+/**
+ * Enables the compact encoding for object read and write requests sent via a connection.
+ * Servers always accept compactly encoded requests, clients only enable the encoding if the server has confirmed this via J_MESSAGE_PING.
+ * Compressed messages are never encoded compactly.
+ *
+ * \code
+ * \endcode
+ *
+ * \param connection A connection.
+ * \param enable     Whether to enable the compact encoding.
+ **/
+void
+j_message_set_compact(gpointer connection, gboolean enable)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(connection != NULL);
+
+	if (enable)
+	{
+		g_object_set_qdata_full(connection, j_message_compact_quark(), g_slice_new0(JMessageCompact), j_message_compact_free);
+	}
+	else
+	{
+		g_object_set_qdata(connection, j_message_compact_quark(), NULL);
+	}
+}
+
+/**
+ * Reads a message from the network.
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ * \parem stream  A network stream.
+ *
+ * \private
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_message_receive_message(JMessage* message, gpointer connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessageMultiplexer* multiplexer;
+	GInputStream* stream;
+
+	g_return_val_if_fail(message != NULL, FALSE);
+	g_return_val_if_fail(connection != NULL, FALSE);
+
+	multiplexer = g_object_get_qdata(connection, j_message_multiplexer_quark());
+
+	if (multiplexer != NULL)
+	{
+		JMessage* reply;
+		gchar const* inline_data;
+		gchar* data;
+		gsize inline_length;
+		gsize size;
+
+		g_return_val_if_fail(message->original_message != NULL, FALSE);
+
+		reply = j_message_multiplexer_pop(multiplexer, message->header.id);
+
+		if (reply == NULL)
+		{
+			return FALSE;
+		}
+
+		// Take over the reply's data to avoid copying it.
+		data = message->data;
+		size = message->size;
+		inline_data = message->inline_data;
+		inline_length = message->inline_length;
+
+		message->header = reply->header;
+		message->data = reply->data;
+		message->size = reply->size;
+		message->current = message->data;
+		message->inline_data = reply->inline_data;
+		message->inline_length = reply->inline_length;
+		message->timing = reply->timing;
+		message->has_timing = reply->has_timing;
+
+		reply->data = data;
+		reply->size = size;
+		reply->inline_data = inline_data;
+		reply->inline_length = inline_length;
+
+		j_message_unref(reply);
+
+		return TRUE;
+	}
+
+	stream = g_io_stream_get_input_stream(G_IO_STREAM(connection));
+	return j_message_read(message, stream);
+}
+
+/**
+ * Traces the latency of a message.
+ *
+ * \private
+ *
+ * \param reply    A reply.
+ * \param client   TRUE if the reply was received by a client, FALSE if it was sent by a server.
+ * \param duration The time since the request was sent or received (in microseconds).
+ **/
+static void
+j_message_trace(JMessage const* reply, gboolean client, gint64 duration)
+{
+	JMessageType type;
+
+	type = j_message_get_type(reply);
+
+	if (G_UNLIKELY((guint)type >= G_N_ELEMENTS(j_message_trace_names)))
+	{
+		return;
+	}
+
+	j_trace_duration((client) ? j_message_trace_names[type].client : j_message_trace_names[type].server, MAX(duration, 0));
+}
+
+/**
+ * Receives a message from the network.
+ *
+ * \code
+ * \endcode
+ *
+ * \param message    A message.
+ * \param connection A connection.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+gboolean
+j_message_receive(JMessage* message, gpointer connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+	gint64 start_time;
+	gint64 end_time;
+
+	start_time = g_get_monotonic_time();
+	ret = j_message_receive_message(message, connection);
+
+	if (ret)
+	{
+		j_statistics_add_current(J_STATISTICS_MESSAGES_RECEIVED, 1);
+		j_statistics_add_current(J_STATISTICS_BYTES_RECEIVED, sizeof(JMessageHeader) + j_message_length(message));
+	}
+
+	end_time = g_get_monotonic_time();
+	j_statistics_add_current(J_STATISTICS_BATCH_NETWORK_TIME, end_time - start_time);
+
+	if (message->original_message != NULL)
+	{
+		j_connection_pool_account(connection, ret, (ret) ? sizeof(JMessageHeader) + j_message_length(message) : 0, (ret) ? end_time - message->original_message->trace_time : -1);
+	}
+
+	if (ret)
+	{
+		if (message->original_message == NULL)
+		{
+			// A request arrived at the server, its latency is traced when the reply is sent.
+			message->trace_time = end_time;
+		}
+		else
+		{
+			JMessageTiming timing;
+
+			j_message_trace(message, TRUE, end_time - message->original_message->trace_time);
+
+			if (j_message_get_timing(message, &timing))
+			{
+				j_statistics_add_current(J_STATISTICS_BATCH_SERVER_QUEUE_TIME, timing.queue_time);
+				j_statistics_add_current(J_STATISTICS_BATCH_SERVER_TIME, (guint64)timing.receive_time + timing.service_time);
+			}
+		}
+	}
+
+	return ret;
+}
+
+/**
+ * Reads the bulk data following a message from the network.
+ *
+ * The data is read directly into the buffers registered via
+ * j_message_add_receive(), using a single scatter read where possible.
+ * The list of registered buffers is cleared afterwards, so that the same
+ * message can be used to receive multiple times.
+ *
+ * \code
+ * \endcode
+ *
+ * \param message    A message.
+ * \param connection A connection.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+gboolean
+j_message_receive_data(JMessage* message, gpointer connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	g_autoptr(JListIterator) iterator = NULL;
+	g_autofree GInputVector* vectors = NULL;
+	GError* error = NULL;
+	GSocket* socket_;
+	gint64 start_time;
+	gsize length = 0;
+	guint count;
+	guint i;
+
+	g_return_val_if_fail(message != NULL, FALSE);
+	g_return_val_if_fail(connection != NULL, FALSE);
+	g_return_val_if_fail(g_object_get_qdata(connection, j_message_multiplexer_quark()) == NULL, FALSE);
+
+	count = j_list_length(message->receive_list);
+
+	if (count == 0)
+	{
+		return TRUE;
+	}
+
+	if (message->inline_data != NULL)
+	{
+		// The data has been part of the compressed payload.
+		iterator = j_list_iterator_new(message->receive_list);
+
+		while (j_list_iterator_next(iterator))
+		{
+			JMessageData* message_data = j_list_iterator_get(iterator);
+
+			if (message_data->length > message->inline_length)
+			{
+				goto end;
+			}
+
+			memcpy((gpointer)message_data->data, message->inline_data, message_data->length);
+			message->inline_data += message_data->length;
+			message->inline_length -= message_data->length;
+		}
+
+		ret = TRUE;
+		goto end;
+	}
+
+	vectors = g_new(GInputVector, count);
+
+	i = 0;
+	iterator = j_list_iterator_new(message->receive_list);
+
+	while (j_list_iterator_next(iterator))
+	{
+		JMessageData* message_data = j_list_iterator_get(iterator);
+
+		vectors[i].buffer = (gpointer)message_data->data;
+		vectors[i].size = message_data->length;
+		length += message_data->length;
+		i++;
+	}
+
+	socket_ = g_socket_connection_get_socket(connection);
+	start_time = g_get_monotonic_time();
+
+	i = 0;
+
+	while (i < count)
+	{
+		gssize bytes_read;
+
+		bytes_read = g_socket_receive_message(socket_, NULL, vectors + i, MIN(count - i, J_MESSAGE_MAX_VECTORS), NULL, NULL, NULL, NULL, &error);
+
+		if (bytes_read <= 0)
+		{
+			goto end;
+		}
 
-	ret = message->current;
-	message->current += length;
+		while (i < count && (gsize)bytes_read >= vectors[i].size)
+		{
+			bytes_read -= vectors[i].size;
+			i++;
+		}
 
-	return ret;
-}
+		if (i < count && bytes_read > 0)
+		{
+			vectors[i].buffer = (gchar*)vectors[i].buffer + bytes_read;
+			vectors[i].size -= bytes_read;
+		}
+	}
 
-/**
- * Gets a string from a message.
- *
- * \code
- * \endcode
- *
- * \param message A message.
- *
- * \return A string.
- **/
-gchar const*
-j_message_get_string(JMessage* message)
-{
-	J_TRACE_FUNCTION(NULL);
+	j_statistics_add_current(J_STATISTICS_BYTES_RECEIVED, length);
+	j_statistics_add_current(J_STATISTICS_BATCH_NETWORK_TIME, g_get_monotonic_time() - start_time);
 
-	gchar const* ret;
+	ret = TRUE;
 
-	g_return_val_if_fail(message != NULL, NULL);
+end:
+	j_connection_pool_account(connection, ret, (ret) ? length : 0, -1);
+	j_list_delete_all(message->receive_list);
 
-	ret = message->current;
-	message->current += strlen(ret) + 1;
+	if (error != NULL)
+	{
+		g_critical("%s", error->message);
+		g_error_free(error);
+	}
 
 	return ret;
 }
 
 /**
- * Reads a message from the network.
+ * Receives data following a message directly into a file.
+ * Uses splice() if available, so the data does not have to be copied to user space.
+ * All data is consumed from the connection even if writing to the file fails.
  *
  * \code
  * \endcode
  *
- * \param message A message.
- * \parem stream  A network stream.
+ * \param message       A message.
+ * \param connection    A connection.
+ * \param fd            A file descriptor.
+ * \param offset        An offset within the file.
+ * \param length        The data length.
+ * \param bytes_written Returns the number of bytes written to the file.
  *
- * \return TRUE on success, FALSE if an error occurred.
+ * \return TRUE on success, FALSE if the data could not be received.
  **/
 gboolean
-j_message_receive(JMessage* message, gpointer connection)
+j_message_receive_file(JMessage* message, gpointer connection, gint fd, guint64 offset, guint64 length, guint64* bytes_written)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	GInputStream* stream;
+	gboolean ret = FALSE;
+
+	g_autofree gchar* buffer = NULL;
+	GError* error = NULL;
+	GSocket* socket_;
+	gint64 start_time;
+	guint64 received = 0;
+	gboolean failed = FALSE;
 
 	g_return_val_if_fail(message != NULL, FALSE);
 	g_return_val_if_fail(connection != NULL, FALSE);
+	g_return_val_if_fail(fd >= 0, FALSE);
+	g_return_val_if_fail(bytes_written != NULL, FALSE);
+	g_return_val_if_fail(g_object_get_qdata(connection, j_message_multiplexer_quark()) == NULL, FALSE);
 
-	stream = g_io_stream_get_input_stream(G_IO_STREAM(connection));
-	return j_message_read(message, stream);
+	*bytes_written = 0;
+
+	if (message->inline_data != NULL)
+	{
+		// The data has been part of the compressed payload.
+		if (length > message->inline_length)
+		{
+			goto end;
+		}
+
+		*bytes_written = j_message_write_all(fd, message->inline_data, length, offset);
+		message->inline_data += length;
+		message->inline_length -= length;
+
+		ret = TRUE;
+		goto end;
+	}
+
+	socket_ = g_socket_connection_get_socket(connection);
+	start_time = g_get_monotonic_time();
+
+#ifdef HAVE_SPLICE
+	{
+		gint pipe_fds[2];
+
+		if (pipe2(pipe_fds, O_CLOEXEC) == 0)
+		{
+			gint socket_fd;
+
+			socket_fd = g_socket_get_fd(socket_);
+
+			while (received < length && !failed)
+			{
+				gssize bytes_spliced;
+
+				// GSocket's descriptors are always non-blocking.
+				bytes_spliced = splice(socket_fd, NULL, pipe_fds[1], NULL, MIN(length - received, J_MESSAGE_FILE_BUFFER_SIZE), SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+				if (bytes_spliced < 0)
+				{
+					if (errno == EINTR)
+					{
+						continue;
+					}
+
+					if (errno == EAGAIN || errno == EWOULDBLOCK)
+					{
+						if (!g_socket_condition_wait(socket_, G_IO_IN, NULL, &error))
+						{
+							break;
+						}
+
+						continue;
+					}
+
+					// The socket does not support splicing, receive the remaining data below
+					break;
+				}
+
+				if (bytes_spliced == 0)
+				{
+					g_set_error_literal(&error, G_IO_ERROR, G_IO_ERROR_CONNECTION_CLOSED, "Connection closed");
+					break;
+				}
+
+				received += bytes_spliced;
+
+				while (bytes_spliced > 0)
+				{
+					loff_t position = offset + *bytes_written;
+					gssize bytes_moved;
+
+					bytes_moved = splice(pipe_fds[0], NULL, fd, &position, bytes_spliced, SPLICE_F_MOVE);
+
+					if (bytes_moved < 0 && errno == EINTR)
+					{
+						continue;
+					}
+
+					if (bytes_moved <= 0)
+					{
+						gchar discard[4096];
+
+						// Drain the pipe, the data still has to be consumed
+						failed = TRUE;
+
+						while (bytes_spliced > 0)
+						{
+							gssize bytes_read;
+
+							bytes_read = read(pipe_fds[0], discard, MIN((gsize)bytes_spliced, sizeof(discard)));
+
+							if (bytes_read <= 0)
+							{
+								break;
+							}
+
+							bytes_spliced -= bytes_read;
+						}
+
+						break;
+					}
+
+					*bytes_written += bytes_moved;
+					bytes_spliced -= bytes_moved;
+				}
+			}
+
+			close(pipe_fds[0]);
+			close(pipe_fds[1]);
+
+			if (error != NULL)
+			{
+				goto end;
+			}
+		}
+	}
+#endif
+
+	if (received < length)
+	{
+		buffer = g_malloc(MIN(length - received, J_MESSAGE_FILE_BUFFER_SIZE));
+	}
+
+	while (received < length)
+	{
+		gsize chunk;
+		gsize done = 0;
+
+		chunk = MIN(length - received, J_MESSAGE_FILE_BUFFER_SIZE);
+
+		while (done < chunk)
+		{
+			gssize bytes_read;
+
+			bytes_read = g_socket_receive(socket_, buffer + done, chunk - done, NULL, &error);
+
+			if (bytes_read <= 0)
+			{
+				goto end;
+			}
+
+			done += bytes_read;
+		}
+
+		if (!failed)
+		{
+			gsize bytes;
+
+			bytes = j_message_write_all(fd, buffer, chunk, offset + *bytes_written);
+			failed = (bytes < chunk);
+			*bytes_written += bytes;
+		}
+
+		received += chunk;
+	}
+
+	j_statistics_add_current(J_STATISTICS_BYTES_RECEIVED, length);
+	j_statistics_add_current(J_STATISTICS_BATCH_NETWORK_TIME, g_get_monotonic_time() - start_time);
+
+	ret = TRUE;
+
+end:
+	j_connection_pool_account(connection, ret, (ret) ? length : 0, -1);
+
+	if (error != NULL)
+	{
+		g_critical("%s", error->message);
+		g_error_free(error);
+	}
+
+	return ret;
 }
 
 /**
@@ -816,18 +3356,56 @@ j_message_send(JMessage* message, gpointer connection)
 
 	gboolean ret;
 
-	GOutputStream* stream;
+	JMessageMultiplexer* multiplexer;
+	JMessageCompression compression;
+	JMessageCompact* compact;
+	GSocket* socket_;
+	gint64 start_time;
+	gint64 end_time;
+	gsize length = 0;
 
 	g_return_val_if_fail(message != NULL, FALSE);
 	g_return_val_if_fail(connection != NULL, FALSE);
 
+	start_time = g_get_monotonic_time();
+	multiplexer = g_object_get_qdata(connection, j_message_multiplexer_quark());
+	compression = GPOINTER_TO_UINT(g_object_get_qdata(connection, j_message_compression_quark()));
+	compact = g_object_get_qdata(connection, j_message_compact_quark());
+
+	if (multiplexer != NULL)
+	{
+		g_mutex_lock(multiplexer->send_mutex);
+	}
+
 	j_helper_set_cork(connection, TRUE);
 
-	stream = g_io_stream_get_output_stream(G_IO_STREAM(connection));
-	ret = j_message_write(message, stream);
+	socket_ = g_socket_connection_get_socket(connection);
+	ret = j_message_write_vectored(message, socket_, compression, compact, &length);
 
 	j_helper_set_cork(connection, FALSE);
 
+	if (multiplexer != NULL)
+	{
+		g_mutex_unlock(multiplexer->send_mutex);
+	}
+
+	end_time = g_get_monotonic_time();
+
+	j_statistics_add_current(J_STATISTICS_MESSAGES_SENT, 1);
+	j_statistics_add_current(J_STATISTICS_BYTES_SENT, length);
+	j_statistics_add_current(J_STATISTICS_BATCH_NETWORK_TIME, end_time - start_time);
+	j_connection_pool_account(connection, ret, length, -1);
+
+	if (message->original_message == NULL)
+	{
+		// The client's latency includes the time spent sending the request.
+		message->trace_time = start_time;
+	}
+	else
+	{
+		j_message_trace(message, FALSE, end_time - message->original_message->trace_time);
+	}
+
 	return ret;
 }
 
@@ -849,22 +3427,124 @@ j_message_read(JMessage* message, GInputStream* stream)
 
 	gboolean ret = FALSE;
 
+	g_autofree gchar* compressed = NULL;
 	GError* error = NULL;
+	JMessageCompression compression;
+	guint32 header_compression;
+	gboolean compact;
 	gsize bytes_read;
 
 	g_return_val_if_fail(message != NULL, FALSE);
 	g_return_val_if_fail(stream != NULL, FALSE);
 
+	message->inline_data = NULL;
+	message->inline_length = 0;
+	message->has_trace_context = FALSE;
+	message->has_timing = FALSE;
+	message->lazy_create = FALSE;
+
 	if (!g_input_stream_read_all(stream, &(message->header), sizeof(JMessageHeader), &bytes_read, NULL, &error) || bytes_read != sizeof(JMessageHeader))
 	{
 		goto end;
 	}
 
-	j_message_ensure_size(message, j_message_length(message));
+	header_compression = GUINT32_FROM_LE(message->header.compression);
 
-	if (!g_input_stream_read_all(stream, message->data, j_message_length(message), &bytes_read, NULL, &error) || bytes_read != j_message_length(message))
+	if (header_compression & J_MESSAGE_TRACE_CONTEXT)
 	{
-		goto end;
+		if (!g_input_stream_read_all(stream, &(message->trace_context), sizeof(JTraceContext), &bytes_read, NULL, &error) || bytes_read != sizeof(JTraceContext))
+		{
+			goto end;
+		}
+
+		message->has_trace_context = TRUE;
+	}
+
+	if (header_compression & J_MESSAGE_TIMING)
+	{
+		if (!g_input_stream_read_all(stream, &(message->timing), sizeof(JMessageTiming), &bytes_read, NULL, &error) || bytes_read != sizeof(JMessageTiming))
+		{
+			goto end;
+		}
+
+		message->has_timing = TRUE;
+	}
+
+	if (header_compression & J_MESSAGE_TIMING_REQUEST)
+	{
+		message->has_timing = TRUE;
+	}
+
+	compact = ((header_compression & J_MESSAGE_COMPACT) != 0);
+	message->lazy_create = ((header_compression & J_MESSAGE_LAZY_CREATE) != 0);
+
+	header_compression &= ~J_MESSAGE_FLAGS;
+	message->header.compression = GUINT32_TO_LE(header_compression);
+
+	compression = header_compression;
+
+	if (compact)
+	{
+		JMessageCompact* state;
+		gsize encoded_length;
+
+		// The state is kept with the stream, since that is all both ends have in common
+		if ((state = g_object_get_qdata(G_OBJECT(stream), j_message_compact_receive_quark())) == NULL)
+		{
+			state = g_slice_new0(JMessageCompact);
+			g_object_set_qdata_full(G_OBJECT(stream), j_message_compact_receive_quark(), state, j_message_compact_free);
+		}
+
+		encoded_length = j_message_length(message);
+		compressed = g_malloc(encoded_length);
+
+		if (!g_input_stream_read_all(stream, compressed, encoded_length, &bytes_read, NULL, &error) || bytes_read != encoded_length)
+		{
+			goto end;
+		}
+
+		if (!j_message_compact_decode(message, state, compressed, encoded_length))
+		{
+			g_warning("Received invalid compactly encoded message.");
+			goto end;
+		}
+	}
+	else if (compression != J_MESSAGE_COMPRESSION_NONE)
+	{
+		gsize compressed_length;
+		gsize data_length;
+
+		compressed_length = GUINT32_FROM_LE(message->header.compressed_length);
+		data_length = GUINT32_FROM_LE(message->header.data_length);
+
+		compressed = g_malloc(compressed_length);
+
+		if (!g_input_stream_read_all(stream, compressed, compressed_length, &bytes_read, NULL, &error) || bytes_read != compressed_length)
+		{
+			goto end;
+		}
+
+		j_message_ensure_size(message, j_message_length(message) + data_length);
+
+		if (!j_message_decompress(compression, compressed, compressed_length, message->data, j_message_length(message) + data_length))
+		{
+			goto end;
+		}
+
+		if (data_length > 0)
+		{
+			message->inline_data = message->data + j_message_length(message);
+			message->inline_length = data_length;
+		}
+	}
+	else
+	{
+		j_message_ensure_size(message, j_message_length(message));
+
+		if (!g_input_stream_read_all(stream, message->data, j_message_length(message), &bytes_read, NULL, &error) || bytes_read != j_message_length(message))
+		{
+			goto end;
+		}
 	}
 
 	message->current = message->data;
@@ -905,13 +3585,43 @@ j_message_write(JMessage* message, GOutputStream* stream)
 	gboolean ret = FALSE;
 
 	g_autoptr(JListIterator) iterator = NULL;
+	JMessageHeader header;
+	JTraceContext trace_context;
 	GError* error = NULL;
+	gboolean has_trace_context;
+	guint32 timing_flag = 0;
 	gsize bytes_written;
 
 	g_return_val_if_fail(message != NULL, FALSE);
 	g_return_val_if_fail(stream != NULL, FALSE);
 
-	if (!g_output_stream_write_all(stream, &(message->header), sizeof(JMessageHeader), &bytes_written, NULL, &error) || bytes_written != sizeof(JMessageHeader))
+	has_trace_context = (message->original_message == NULL && j_trace_context_get(&trace_context));
+
+	if (message->original_message == NULL)
+	{
+		timing_flag = (j_message_timing_enabled()) ? J_MESSAGE_TIMING_REQUEST : 0;
+	}
+	else if (message->has_timing)
+	{
+		timing_flag = J_MESSAGE_TIMING;
+	}
+
+	header = message->header;
+	header.compression = GUINT32_TO_LE(J_MESSAGE_COMPRESSION_NONE | ((has_trace_context) ? J_MESSAGE_TRACE_CONTEXT : 0) | timing_flag | ((message->lazy_create) ? J_MESSAGE_LAZY_CREATE : 0));
+	header.compressed_length = GUINT32_TO_LE(0);
+	header.data_length = GUINT32_TO_LE(0);
+
+	if (!g_output_stream_write_all(stream, &header, sizeof(JMessageHeader), &bytes_written, NULL, &error) || bytes_written != sizeof(JMessageHeader))
+	{
+		goto end;
+	}
+
+	if (has_trace_context && (!g_output_stream_write_all(stream, &trace_context, sizeof(JTraceContext), &bytes_written, NULL, &error) || bytes_written != sizeof(JTraceContext)))
+	{
+		goto end;
+	}
+
+	if (timing_flag == J_MESSAGE_TIMING && (!g_output_stream_write_all(stream, &(message->timing), sizeof(JMessageTiming), &bytes_written, NULL, &error) || bytes_written != sizeof(JMessageTiming)))
 	{
 		goto end;
 	}
@@ -928,8 +3638,22 @@ j_message_write(JMessage* message, GOutputStream* stream)
 		while (j_list_iterator_next(iterator))
 		{
 			JMessageData* message_data = j_list_iterator_get(iterator);
+			g_autofree gchar* file_data = NULL;
+			gconstpointer data = message_data->data;
+
+			if (message_data->fd != -1)
+			{
+				file_data = g_malloc(message_data->length);
+
+				if (!j_message_data_copy(message_data, file_data))
+				{
+					goto end;
+				}
+
+				data = file_data;
+			}
 
-			if (!g_output_stream_write_all(stream, message_data->data, message_data->length, &bytes_written, NULL, &error))
+			if (!g_output_stream_write_all(stream, data, message_data->length, &bytes_written, NULL, &error))
 			{
 				goto end;
 			}
@@ -974,10 +3698,77 @@ j_message_add_send(JMessage* message, gconstpointer data, guint64 length)
 	message_data = g_slice_new(JMessageData);
 	message_data->data = data;
 	message_data->length = length;
+	message_data->fd = -1;
+	message_data->offset = 0;
+
+	j_list_append(message->send_list, message_data);
+}
+
+/**
+ * Adds new data to send to a message, taking it from a file.
+ * The data is sent with sendfile() if possible, so it does not have to be read into memory first.
+ * The file descriptor has to stay valid until the message has been sent.
+ * If the file is shorter than expected, the missing data is sent as zeros.
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ * \param fd      A file descriptor.
+ * \param offset  An offset within the file.
+ * \param length  A length.
+ **/
+void
+j_message_add_send_file(JMessage* message, gint fd, guint64 offset, guint64 length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessageData* message_data;
+
+	g_return_if_fail(message != NULL);
+	g_return_if_fail(fd >= 0);
+	g_return_if_fail(length > 0);
+
+	message_data = g_slice_new(JMessageData);
+	message_data->data = NULL;
+	message_data->length = length;
+	message_data->fd = fd;
+	message_data->offset = offset;
 
 	j_list_append(message->send_list, message_data);
 }
 
+/**
+ * Adds a destination buffer for data to receive after a message.
+ * The buffers are filled in order by j_message_receive_data().
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ * \param data    A buffer.
+ * \param length  A length.
+ **/
+void
+j_message_add_receive(JMessage* message, gpointer data, guint64 length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessageData* message_data;
+
+	g_return_if_fail(message != NULL);
+	g_return_if_fail(data != NULL);
+	g_return_if_fail(length > 0);
+
+	message_data = g_slice_new(JMessageData);
+	message_data->data = data;
+	message_data->length = length;
+	message_data->fd = -1;
+	message_data->offset = 0;
+
+	j_list_append(message->receive_list, message_data);
+}
+
 /**
  * Adds a new operation to a message.
  *
@@ -64,17 +64,27 @@ struct JOperationCache
 	GThread* thread;
 
 	/**
-	 * Whether #thread is currently working.
+	 * The number of batches that have been queued but not executed yet.
 	 */
-	gboolean working;
+	guint pending;
 
 	/**
-	 * The mutex for #working.
+	 * Keeps batches in the same order as their cache segments, which have to be released in order.
+	 */
+	GMutex order[1];
+
+	/**
+	 * Maps coalescing identifiers to the latest queued #JCachedOperation, protected by #mutex.
+	 */
+	GHashTable* queued;
+
+	/**
+	 * The mutex for #pending and #queued.
 	 */
 	GMutex mutex[1];
 
 	/**
-	 * The condition for #working.
+	 * The condition for #pending.
 	 */
 	GCond cond[1];
 };
@@ -84,11 +94,32 @@ typedef struct JOperationCache JOperationCache;
 struct JCachedBatch
 {
 	JBatch* batch;
+
+	/**
+	 * The batch's segment of the cache and its length.
+	 */
 	gpointer data;
+	guint64 data_length;
+
+	/**
+	 * The coalescing identifiers of the batch's operations.
+	 */
+	GPtrArray* identifiers;
 };
 
 typedef struct JCachedBatch JCachedBatch;
 
+/**
+ * A queued operation that can still be superseded.
+ */
+struct JCachedOperation
+{
+	JOperation* operation;
+	JCachedBatch* cached_batch;
+};
+
+typedef struct JCachedOperation JCachedOperation;
+
 static JOperationCache* j_operation_cache = NULL;
 
 static gpointer
@@ -107,19 +138,43 @@ j_operation_cache_thread(gpointer data)
 			return NULL;
 		}
 
+		g_mutex_lock(cache->mutex);
+
+		/* The batch's operations can not be superseded anymore once it is executed. */
+		for (guint i = 0; i < cached_batch->identifiers->len; i++)
+		{
+			gchar const* identifier = g_ptr_array_index(cached_batch->identifiers, i);
+			JCachedOperation* cached_operation;
+
+			cached_operation = g_hash_table_lookup(cache->queued, identifier);
+
+			if (cached_operation != NULL && cached_operation->cached_batch == cached_batch)
+			{
+				g_hash_table_remove(cache->queued, identifier);
+			}
+		}
+
+		g_mutex_unlock(cache->mutex);
+
 		j_batch_execute_internal(cached_batch->batch);
 
 		j_batch_unref(cached_batch->batch);
-		j_cache_release(j_operation_cache->cache, cached_batch->data);
+		g_ptr_array_unref(cached_batch->identifiers);
+
+		if (cached_batch->data != NULL)
+		{
+			j_cache_release(cache->cache, cached_batch->data, cached_batch->data_length);
+		}
+
 		g_slice_free(JCachedBatch, cached_batch);
 
 		g_mutex_lock(cache->mutex);
 
-		cache->working = (g_async_queue_length(cache->queue) > 0);
+		cache->pending--;
 
-		if (!cache->working)
+		if (cache->pending == 0)
 		{
-			g_cond_signal(cache->cond);
+			g_cond_broadcast(cache->cond);
 		}
 
 		g_mutex_unlock(cache->mutex);
@@ -128,76 +183,21 @@ j_operation_cache_thread(gpointer data)
 	return NULL;
 }
 
-static gboolean
-j_operation_cache_test(JOperation* operation)
-{
-	J_TRACE_FUNCTION(NULL);
-
-	gboolean ret = FALSE;
-
-	(void)operation;
-
-	/* FIXME
-	switch (operation->type)
-	{
-		case J_OPERATION_COLLECTION_CREATE:
-		case J_OPERATION_COLLECTION_DELETE:
-		case J_OPERATION_ITEM_CREATE:
-		case J_OPERATION_ITEM_DELETE:
-		case J_OPERATION_ITEM_WRITE:
-			ret = TRUE;
-			break;
-
-		case J_OPERATION_COLLECTION_GET:
-		case J_OPERATION_ITEM_GET:
-		case J_OPERATION_ITEM_GET_STATUS:
-		case J_OPERATION_ITEM_READ:
-			ret = FALSE;
-			break;
-
-		case J_OPERATION_NONE:
-		default:
-			g_warn_if_reached();
-	}
-	*/
-
-	return ret;
-}
-
+/**
+ * Returns the space an operation requires in the cache.
+ *
+ * The space is rounded up to keep the data of the following operation aligned.
+ **/
 static guint64
 j_operation_cache_get_required_size(JOperation* operation)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	guint64 ret = 0;
-
-	(void)operation;
+	guint64 size;
 
-	/* FIXME
-	switch (operation->type)
-	{
-		case J_OPERATION_ITEM_WRITE:
-			ret = operation->item_write.length;
-			break;
-
-		case J_OPERATION_COLLECTION_CREATE:
-		case J_OPERATION_COLLECTION_DELETE:
-		case J_OPERATION_ITEM_CREATE:
-		case J_OPERATION_ITEM_DELETE:
-		case J_OPERATION_COLLECTION_GET:
-		case J_OPERATION_ITEM_GET:
-		case J_OPERATION_ITEM_GET_STATUS:
-		case J_OPERATION_ITEM_READ:
-			ret = 0;
-			break;
-
-		case J_OPERATION_NONE:
-		default:
-			g_warn_if_reached();
-	}
-	*/
+	size = operation->cache_func(operation->data, NULL);
 
-	return ret;
+	return (size + 7) & ~((guint64)7);
 }
 
 void
@@ -213,8 +213,10 @@ j_operation_cache_init(void)
 	cache->cache = j_cache_new(50 * 1024 * 1024);
 	cache->queue = g_async_queue_new_full(NULL);
 	cache->thread = g_thread_new("JOperationCache", j_operation_cache_thread, cache);
-	cache->working = FALSE;
+	cache->pending = 0;
+	cache->queued = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
 
+	g_mutex_init(cache->order);
 	g_mutex_init(cache->mutex);
 	g_cond_init(cache->cond);
 
@@ -240,10 +242,12 @@ j_operation_cache_fini(void)
 	g_thread_join(cache->thread);
 
 	g_async_queue_unref(cache->queue);
+	g_hash_table_unref(cache->queued);
 	j_cache_free(cache->cache);
 
 	g_cond_clear(cache->cond);
 	g_mutex_clear(cache->mutex);
+	g_mutex_clear(cache->order);
 
 	g_slice_free(JOperationCache, cache);
 }
@@ -257,7 +261,7 @@ j_operation_cache_flush(void)
 
 	g_mutex_lock(j_operation_cache->mutex);
 
-	while (j_operation_cache->working)
+	while (j_operation_cache->pending > 0)
 	{
 		g_cond_wait(j_operation_cache->cond, j_operation_cache->mutex);
 	}
@@ -267,18 +271,27 @@ j_operation_cache_flush(void)
 	return ret;
 }
 
+/**
+ * Adds a batch to the operation cache.
+ *
+ * The data of all operations is copied into the cache and the batch is executed in the background.
+ * If the cache is full, this blocks until the queued batches have been executed.
+ *
+ * \param batch A batch.
+ *
+ * \return TRUE if the batch has been cached, FALSE if it has to be executed directly.
+ **/
 gboolean
 j_operation_cache_add(JBatch* batch)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gboolean ret = TRUE;
+	g_autoptr(JListIterator) iterator = NULL;
+	g_autoptr(GPtrArray) superseded = NULL;
 	JCachedBatch* cached_batch;
 	JList* operations;
-	JListIterator* iterator;
-	gboolean can_cache = TRUE;
 	gchar* data;
-	gpointer buffer;
+	gpointer buffer = NULL;
 	guint64 required_size = 0;
 
 	operations = j_batch_get_operations(batch);
@@ -288,28 +301,28 @@ j_operation_cache_add(JBatch* batch)
 	{
 		JOperation* operation = j_list_iterator_get(iterator);
 
-		can_cache = j_operation_cache_test(operation) && can_cache;
-
-		if (!can_cache)
+		if (operation->cache_func == NULL)
 		{
-			ret = FALSE;
-			break;
+			return FALSE;
 		}
 
 		required_size += j_operation_cache_get_required_size(operation);
 	}
 
-	j_list_iterator_free(iterator);
+	g_clear_pointer(&iterator, j_list_iterator_free);
 
-	// FIXME never cleared
-	if ((buffer = j_cache_get(j_operation_cache->cache, required_size)) == NULL)
-	{
-		ret = FALSE;
-	}
+	g_mutex_lock(j_operation_cache->order);
 
-	if (!ret)
+	if (required_size > 0 && (buffer = j_cache_get(j_operation_cache->cache, required_size)) == NULL)
 	{
-		return FALSE;
+		/* Apply backpressure by waiting for the queued batches to release their space. */
+		j_operation_cache_flush();
+
+		if ((buffer = j_cache_get(j_operation_cache->cache, required_size)) == NULL)
+		{
+			g_mutex_unlock(j_operation_cache->order);
+			return FALSE;
+		}
 	}
 
 	data = buffer;
@@ -317,39 +330,87 @@ j_operation_cache_add(JBatch* batch)
 
 	while (j_list_iterator_next(iterator))
 	{
-		/* FIXME
 		JOperation* operation = j_list_iterator_get(iterator);
+		guint64 size;
+
+		size = j_operation_cache_get_required_size(operation);
 
-		if (operation->type == J_OPERATION_ITEM_WRITE)
+		if (size > 0)
 		{
-			memcpy(data, operation->item_write.data, operation->item_write.length);
+			operation->cache_func(operation->data, data);
+			data += size;
+		}
+	}
+
+	g_clear_pointer(&iterator, j_list_iterator_free);
+
+	cached_batch = g_slice_new(JCachedBatch);
+	cached_batch->batch = j_batch_new_from_batch(batch);
+	cached_batch->data = buffer;
+	cached_batch->data_length = required_size;
+	cached_batch->identifiers = g_ptr_array_new_with_free_func(g_free);
+
+	iterator = j_list_iterator_new(j_batch_get_operations(cached_batch->batch));
+
+	g_mutex_lock(j_operation_cache->mutex);
 
-			operation->item_write.data = data;
-			*(operation->item_write.bytes_written) += operation->item_write.length;
-			operation->item_write.bytes_written = NULL;
+	/* Drop queued operations that are superseded by the new ones, only the last state has to be sent. */
+	while (j_list_iterator_next(iterator))
+	{
+		JOperation* operation = j_list_iterator_get(iterator);
+		JCachedOperation* cached_operation;
+		gchar* identifier;
 
-			data += operation->item_write.length;
+		if (operation->coalesce_func == NULL || (identifier = operation->coalesce_func(operation->data)) == NULL)
+		{
+			continue;
 		}
-		*/
-		(void)data;
-	}
 
-	j_list_iterator_free(iterator);
+		if ((cached_operation = g_hash_table_lookup(j_operation_cache->queued, identifier)) != NULL)
+		{
+			if (cached_operation->cached_batch == cached_batch)
+			{
+				// Removing from the list that is being iterated would shift the following operations.
+				if (superseded == NULL)
+				{
+					superseded = g_ptr_array_new();
+				}
+
+				g_ptr_array_add(superseded, cached_operation->operation);
+			}
+			else
+			{
+				j_list_remove(j_batch_get_operations(cached_operation->cached_batch->batch), cached_operation->operation);
+			}
+		}
+		else
+		{
+			cached_operation = g_new(JCachedOperation, 1);
+			g_hash_table_insert(j_operation_cache->queued, g_strdup(identifier), cached_operation);
+		}
+
+		cached_operation->operation = operation;
+		cached_operation->cached_batch = cached_batch;
+
+		g_ptr_array_add(cached_batch->identifiers, identifier);
+	}
 
-	if (!ret)
+	for (guint i = 0; superseded != NULL && i < superseded->len; i++)
 	{
-		return FALSE;
+		j_list_remove(j_batch_get_operations(cached_batch->batch), g_ptr_array_index(superseded, i));
 	}
 
-	g_mutex_lock(j_operation_cache->mutex);
-	j_operation_cache->working = TRUE;
-	g_mutex_unlock(j_operation_cache->mutex);
+	j_operation_cache->pending++;
 
-	cached_batch = g_slice_new(JCachedBatch);
-	cached_batch->batch = j_batch_new_from_batch(batch);
-	cached_batch->data = buffer;
+	g_mutex_unlock(j_operation_cache->mutex);
 
 	g_async_queue_push(j_operation_cache->queue, cached_batch);
 
-	return ret;
+	g_mutex_unlock(j_operation_cache->order);
+
+	return TRUE;
 }
+
+/**
+ * @}
+ **/
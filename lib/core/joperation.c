@@ -34,6 +34,239 @@
  * @{
  **/
 
+/**
+ * The maximum size of data allocated together with a pooled operation.
+ * Operations with larger data are allocated individually.
+ **/
+#define J_OPERATION_POOL_DATA_SIZE 64
+
+/**
+ * The maximum number of free operations kept per thread and size class.
+ **/
+#define J_OPERATION_POOL_DEPTH 4096
+
+/**
+ * The operation size classes, without and with data.
+ **/
+#define J_OPERATION_POOL_CLASSES 2
+
+/**
+ * A free operation in a pool.
+ * It reuses the operation's memory.
+ **/
+struct JOperationPoolEntry
+{
+	struct JOperationPoolEntry* next;
+};
+
+typedef struct JOperationPoolEntry JOperationPoolEntry;
+
+/**
+ * An operation with data allocated together with it.
+ **/
+struct JOperationWithData
+{
+	JOperation operation;
+
+	/**
+	 * The data, aligned suitably for the structures used by the modules.
+	 **/
+	gdouble data[];
+};
+
+typedef struct JOperationWithData JOperationWithData;
+
+/**
+ * A thread-local pool of operations.
+ * Operations are usually freed together when their batch has been executed, so they can be reused by the next batch without touching the allocator.
+ **/
+struct JOperationPool
+{
+	/**
+	 * The free operations, indexed by size class.
+	 **/
+	JOperationPoolEntry* entries[J_OPERATION_POOL_CLASSES];
+
+	/**
+	 * The number of free operations per size class.
+	 **/
+	guint entries_len[J_OPERATION_POOL_CLASSES];
+};
+
+typedef struct JOperationPool JOperationPool;
+
+static void j_operation_pool_free(gpointer);
+
+static GPrivate j_operation_pool = G_PRIVATE_INIT(j_operation_pool_free);
+
+static void
+j_operation_pool_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JOperationPool* pool = data;
+
+	for (guint i = 0; i < J_OPERATION_POOL_CLASSES; i++)
+	{
+		JOperationPoolEntry* entry = pool->entries[i];
+
+		while (entry != NULL)
+		{
+			JOperationPoolEntry* next = entry->next;
+
+			g_free(entry);
+			entry = next;
+		}
+	}
+
+	g_slice_free(JOperationPool, pool);
+}
+
+/**
+ * Returns the current thread's pool.
+ *
+ * \private
+ *
+ * \return The pool.
+ **/
+static JOperationPool*
+j_operation_pool_get(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JOperationPool* pool;
+
+	pool = g_private_get(&j_operation_pool);
+
+	if (G_UNLIKELY(pool == NULL))
+	{
+		pool = g_slice_new0(JOperationPool);
+		g_private_set(&j_operation_pool, pool);
+	}
+
+	return pool;
+}
+
+/**
+ * Returns the size class for an operation's data size.
+ *
+ * \private
+ *
+ * \param data_size A data size.
+ *
+ * \return The size class, J_OPERATION_POOL_CLASSES if the operation is too large to be pooled.
+ **/
+static guint
+j_operation_pool_class(gsize data_size)
+{
+	if (data_size == 0)
+	{
+		return 0;
+	}
+	else if (data_size <= J_OPERATION_POOL_DATA_SIZE)
+	{
+		return 1;
+	}
+
+	return J_OPERATION_POOL_CLASSES;
+}
+
+/**
+ * Returns the allocation size for an operation.
+ *
+ * \private
+ *
+ * \param data_size A data size.
+ *
+ * \return The size including the operation itself.
+ **/
+static gsize
+j_operation_pool_size(gsize data_size)
+{
+	gsize const header_size = sizeof(JOperationWithData);
+
+	switch (j_operation_pool_class(data_size))
+	{
+		case 0:
+			return sizeof(JOperation);
+		case 1:
+			return header_size + J_OPERATION_POOL_DATA_SIZE;
+		default:
+			return header_size + data_size;
+	}
+}
+
+static JOperation*
+j_operation_alloc(gsize data_size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JOperationPool* pool;
+	guint class;
+
+	class = j_operation_pool_class(data_size);
+
+	if (class < J_OPERATION_POOL_CLASSES)
+	{
+		pool = j_operation_pool_get();
+
+		if (pool->entries[class] != NULL)
+		{
+			JOperationPoolEntry* entry = pool->entries[class];
+
+			pool->entries[class] = entry->next;
+			pool->entries_len[class]--;
+
+			return (JOperation*)entry;
+		}
+	}
+
+	return g_malloc(j_operation_pool_size(data_size));
+}
+
+static void
+j_operation_dealloc(JOperation* operation)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JOperationPool* pool;
+	guint class;
+
+	class = j_operation_pool_class(operation->data_size);
+
+	if (class < J_OPERATION_POOL_CLASSES)
+	{
+		pool = j_operation_pool_get();
+
+		if (pool->entries_len[class] < J_OPERATION_POOL_DEPTH)
+		{
+			JOperationPoolEntry* entry = (JOperationPoolEntry*)operation;
+
+			entry->next = pool->entries[class];
+			pool->entries[class] = entry;
+			pool->entries_len[class]++;
+
+			return;
+		}
+	}
+
+	g_free(operation);
+}
+
+static JOperation*
+j_operation_init(JOperation* operation, gsize data_size)
+{
+	operation->key = NULL;
+	operation->data = NULL;
+	operation->exec_func = NULL;
+	operation->free_func = NULL;
+	operation->cache_func = NULL;
+	operation->coalesce_func = NULL;
+	operation->data_size = data_size;
+
+	return operation;
+}
+
 /**
  * Creates a new operation.
  *
@@ -47,15 +280,38 @@ j_operation_new(void)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JOperation* operation;
+	return j_operation_init(j_operation_alloc(0), 0);
+}
 
-	operation = g_slice_new(JOperation);
-	operation->key = NULL;
-	operation->data = NULL;
-	operation->exec_func = NULL;
-	operation->free_func = NULL;
+/**
+ * Creates a new operation with data allocated together with it.
+ * The data is uninitialized and freed together with the operation.
+ *
+ * \code
+ * JKVOperation* kop;
+ * JOperation* operation;
+ *
+ * operation = j_operation_new_with_data(sizeof(JKVOperation));
+ * kop = operation->data;
+ * \endcode
+ *
+ * \param data_size The size of the data.
+ *
+ * \return A new operation. Should be freed with j_operation_free().
+ **/
+JOperation*
+j_operation_new_with_data(gsize data_size)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	return operation;
+	JOperationWithData* operation;
+
+	g_return_val_if_fail(data_size > 0, NULL);
+
+	operation = (JOperationWithData*)j_operation_init(j_operation_alloc(data_size), data_size);
+	operation->operation.data = operation->data;
+
+	return &(operation->operation);
 }
 
 /**
@@ -79,7 +335,7 @@ j_operation_free(JOperation* operation)
 		operation->free_func(operation->data);
 	}
 
-	g_slice_free(JOperation, operation);
+	j_operation_dealloc(operation);
 }
 
 /**
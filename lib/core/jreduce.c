@@ -0,0 +1,665 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <math.h>
+#include <string.h>
+
+#include <jreduce.h>
+
+#include <jmessage.h>
+#include <jtrace.h>
+
+/**
+ * \defgroup JReduce Reduce
+ *
+ * Reductions compute statistics over an object's elements where the data is stored.
+ * Only the results are sent to the client, see j_object_reduce().
+ *
+ * @{
+ **/
+
+/**
+ * A reduction and its results.
+ **/
+struct JReduce
+{
+	JReduceType type;
+
+	/**
+	 * Only elements within [filter_min, filter_max] are reduced.
+	 **/
+	gboolean filter;
+	gdouble filter_min;
+	gdouble filter_max;
+
+	/**
+	 * The histogram covers [histogram_min, histogram_max] with histogram_bins bins of equal width.
+	 **/
+	gdouble histogram_min;
+	gdouble histogram_max;
+	guint32 histogram_bins;
+
+	/**
+	 * The results.
+	 **/
+	guint64 count;
+	gdouble sum;
+	gdouble min;
+	gdouble max;
+	guint64* histogram;
+
+	gint ref_count;
+};
+
+/**
+ * Returns the size of an element.
+ *
+ * \private
+ **/
+static gsize
+j_reduce_type_size(JReduceType type)
+{
+	switch (type)
+	{
+		case J_REDUCE_TYPE_INT32:
+		case J_REDUCE_TYPE_UINT32:
+		case J_REDUCE_TYPE_FLOAT32:
+			return 4;
+		case J_REDUCE_TYPE_INT64:
+		case J_REDUCE_TYPE_UINT64:
+		case J_REDUCE_TYPE_FLOAT64:
+			return 8;
+		default:
+			g_assert_not_reached();
+	}
+
+	return 0;
+}
+
+/**
+ * Reads an element and converts it to a double.
+ *
+ * \private
+ **/
+static gdouble
+j_reduce_type_get(JReduceType type, gchar const* data)
+{
+	// The data might not be aligned.
+	switch (type)
+	{
+		case J_REDUCE_TYPE_INT32:
+		{
+			gint32 value;
+
+			memcpy(&value, data, sizeof(value));
+			return value;
+		}
+		case J_REDUCE_TYPE_INT64:
+		{
+			gint64 value;
+
+			memcpy(&value, data, sizeof(value));
+			return value;
+		}
+		case J_REDUCE_TYPE_UINT32:
+		{
+			guint32 value;
+
+			memcpy(&value, data, sizeof(value));
+			return value;
+		}
+		case J_REDUCE_TYPE_UINT64:
+		{
+			guint64 value;
+
+			memcpy(&value, data, sizeof(value));
+			return value;
+		}
+		case J_REDUCE_TYPE_FLOAT32:
+		{
+			gfloat value;
+
+			memcpy(&value, data, sizeof(value));
+			return value;
+		}
+		case J_REDUCE_TYPE_FLOAT64:
+		{
+			gdouble value;
+
+			memcpy(&value, data, sizeof(value));
+			return value;
+		}
+		default:
+			g_assert_not_reached();
+	}
+
+	return 0.0;
+}
+
+static void
+j_reduce_append_double(JMessage* message, gdouble value)
+{
+	j_message_append_8(message, &value);
+}
+
+static gdouble
+j_reduce_get_double(JMessage* message)
+{
+	gint64 bits;
+	gdouble value;
+
+	bits = j_message_get_8(message);
+	memcpy(&value, &bits, sizeof(value));
+
+	return value;
+}
+
+/**
+ * Creates a new reduction.
+ * Without further settings, it computes the number of elements as well as their sum, minimum and maximum.
+ *
+ * \code
+ * g_autoptr(JReduce) reduce = NULL;
+ *
+ * reduce = j_reduce_new(J_REDUCE_TYPE_FLOAT64);
+ * j_reduce_set_histogram(reduce, 0.0, 100.0, 10);
+ * \endcode
+ *
+ * \param type The type of the elements.
+ *
+ * \return A new reduction. Should be freed with j_reduce_unref().
+ **/
+JReduce*
+j_reduce_new(JReduceType type)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JReduce* reduce;
+
+	reduce = g_slice_new(JReduce);
+	reduce->type = type;
+	reduce->filter = FALSE;
+	reduce->filter_min = -INFINITY;
+	reduce->filter_max = INFINITY;
+	reduce->histogram_min = 0.0;
+	reduce->histogram_max = 0.0;
+	reduce->histogram_bins = 0;
+	reduce->count = 0;
+	reduce->sum = 0.0;
+	reduce->min = INFINITY;
+	reduce->max = -INFINITY;
+	reduce->histogram = NULL;
+	reduce->ref_count = 1;
+
+	return reduce;
+}
+
+/**
+ * Creates a new reduction with the same settings as another one but without results.
+ * Can be used to reduce parts of an object independently before merging them.
+ *
+ * \param reduce A reduction.
+ *
+ * \return A new reduction. Should be freed with j_reduce_unref().
+ **/
+JReduce*
+j_reduce_new_like(JReduce* reduce)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JReduce* new_reduce;
+
+	g_return_val_if_fail(reduce != NULL, NULL);
+
+	new_reduce = j_reduce_new(reduce->type);
+	new_reduce->filter = reduce->filter;
+	new_reduce->filter_min = reduce->filter_min;
+	new_reduce->filter_max = reduce->filter_max;
+
+	if (reduce->histogram_bins > 0)
+	{
+		j_reduce_set_histogram(new_reduce, reduce->histogram_min, reduce->histogram_max, reduce->histogram_bins);
+	}
+
+	return new_reduce;
+}
+
+JReduce*
+j_reduce_ref(JReduce* reduce)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(reduce != NULL, NULL);
+
+	g_atomic_int_inc(&(reduce->ref_count));
+
+	return reduce;
+}
+
+void
+j_reduce_unref(JReduce* reduce)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(reduce != NULL);
+
+	if (g_atomic_int_dec_and_test(&(reduce->ref_count)))
+	{
+		g_free(reduce->histogram);
+
+		g_slice_free(JReduce, reduce);
+	}
+}
+
+/**
+ * Restricts the reduction to elements within a range.
+ * All results only take matching elements into account, so the count is the number of matching elements.
+ *
+ * \param reduce A reduction.
+ * \param min    The smallest matching value.
+ * \param max    The largest matching value.
+ **/
+void
+j_reduce_set_filter(JReduce* reduce, gdouble min, gdouble max)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(reduce != NULL);
+	g_return_if_fail(min <= max);
+
+	reduce->filter = TRUE;
+	reduce->filter_min = min;
+	reduce->filter_max = max;
+}
+
+/**
+ * Additionally computes a histogram.
+ * Elements outside the range are not counted in the histogram.
+ *
+ * \param reduce A reduction.
+ * \param min    The lower bound of the first bin.
+ * \param max    The upper bound of the last bin, which includes it.
+ * \param bins   The number of bins.
+ **/
+void
+j_reduce_set_histogram(JReduce* reduce, gdouble min, gdouble max, guint32 bins)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(reduce != NULL);
+	g_return_if_fail(min < max);
+	g_return_if_fail(bins > 0);
+
+	reduce->histogram_min = min;
+	reduce->histogram_max = max;
+	reduce->histogram_bins = bins;
+
+	g_free(reduce->histogram);
+	reduce->histogram = g_new0(guint64, bins);
+}
+
+JReduceType
+j_reduce_get_type(JReduce* reduce)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(reduce != NULL, J_REDUCE_TYPE_INT32);
+
+	return reduce->type;
+}
+
+/**
+ * Returns the number of reduced elements.
+ *
+ * \param reduce A reduction.
+ *
+ * \return The number of elements.
+ **/
+guint64
+j_reduce_get_count(JReduce* reduce)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(reduce != NULL, 0);
+
+	return reduce->count;
+}
+
+/**
+ * Returns the sum of the reduced elements.
+ * The sum is computed using doubles, so large integer sums might be rounded.
+ *
+ * \param reduce A reduction.
+ *
+ * \return The sum.
+ **/
+gdouble
+j_reduce_get_sum(JReduce* reduce)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(reduce != NULL, 0.0);
+
+	return reduce->sum;
+}
+
+/**
+ * Returns the smallest reduced element.
+ *
+ * \param reduce A reduction.
+ *
+ * \return The minimum, infinity if no element has been reduced.
+ **/
+gdouble
+j_reduce_get_min(JReduce* reduce)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(reduce != NULL, 0.0);
+
+	return reduce->min;
+}
+
+/**
+ * Returns the largest reduced element.
+ *
+ * \param reduce A reduction.
+ *
+ * \return The maximum, negative infinity if no element has been reduced.
+ **/
+gdouble
+j_reduce_get_max(JReduce* reduce)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(reduce != NULL, 0.0);
+
+	return reduce->max;
+}
+
+/**
+ * Returns the histogram.
+ *
+ * \param reduce A reduction.
+ * \param bins   Returns the number of bins.
+ *
+ * \return The number of elements per bin, NULL if no histogram has been set.
+ **/
+guint64 const*
+j_reduce_get_histogram(JReduce* reduce, guint32* bins)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(reduce != NULL, NULL);
+	g_return_val_if_fail(bins != NULL, NULL);
+
+	*bins = reduce->histogram_bins;
+
+	return reduce->histogram;
+}
+
+/**
+ * Reduces a buffer of elements, updating the results.
+ * A trailing partial element is ignored.
+ *
+ * \param reduce A reduction.
+ * \param data   The elements.
+ * \param length The buffer's length in bytes.
+ **/
+void
+j_reduce_process(JReduce* reduce, gconstpointer data, guint64 length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gchar const* element = data;
+	gsize element_size;
+	gdouble bin_width = 0.0;
+
+	g_return_if_fail(reduce != NULL);
+	g_return_if_fail(data != NULL || length == 0);
+
+	element_size = j_reduce_type_size(reduce->type);
+
+	if (reduce->histogram != NULL)
+	{
+		bin_width = (reduce->histogram_max - reduce->histogram_min) / reduce->histogram_bins;
+	}
+
+	for (guint64 i = 0; i < length / element_size; i++, element += element_size)
+	{
+		gdouble value;
+
+		value = j_reduce_type_get(reduce->type, element);
+
+		if (reduce->filter && (value < reduce->filter_min || value > reduce->filter_max))
+		{
+			continue;
+		}
+
+		reduce->count++;
+		reduce->sum += value;
+		reduce->min = MIN(reduce->min, value);
+		reduce->max = MAX(reduce->max, value);
+
+		if (reduce->histogram != NULL && value >= reduce->histogram_min && value <= reduce->histogram_max)
+		{
+			guint32 bin;
+
+			bin = MIN((value - reduce->histogram_min) / bin_width, reduce->histogram_bins - 1);
+			reduce->histogram[bin]++;
+		}
+	}
+}
+
+/**
+ * Merges the results of another reduction, for example, one computed over another part of an object.
+ * Both reductions have to use the same settings.
+ *
+ * \param reduce A reduction.
+ * \param other  Another reduction.
+ **/
+void
+j_reduce_merge(JReduce* reduce, JReduce* other)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(reduce != NULL);
+	g_return_if_fail(other != NULL);
+	g_return_if_fail(reduce->histogram_bins == other->histogram_bins);
+
+	reduce->count += other->count;
+	reduce->sum += other->sum;
+	reduce->min = MIN(reduce->min, other->min);
+	reduce->max = MAX(reduce->max, other->max);
+
+	for (guint32 i = 0; i < reduce->histogram_bins; i++)
+	{
+		reduce->histogram[i] += other->histogram[i];
+	}
+}
+
+/**
+ * Returns the size of a reduction's settings in a message.
+ *
+ * \return The size.
+ **/
+gsize
+j_reduce_get_spec_size(void)
+{
+	return 4 + 4 + 8 + 8 + 4 + 8 + 8;
+}
+
+/**
+ * Appends a reduction's settings to a message.
+ *
+ * \param reduce  A reduction.
+ * \param message A message.
+ **/
+void
+j_reduce_append_spec(JReduce* reduce, JMessage* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint32 type;
+	guint32 filter;
+
+	g_return_if_fail(reduce != NULL);
+	g_return_if_fail(message != NULL);
+
+	type = reduce->type;
+	filter = reduce->filter;
+
+	j_message_append_4(message, &type);
+	j_message_append_4(message, &filter);
+	j_reduce_append_double(message, reduce->filter_min);
+	j_reduce_append_double(message, reduce->filter_max);
+	j_message_append_4(message, &(reduce->histogram_bins));
+	j_reduce_append_double(message, reduce->histogram_min);
+	j_reduce_append_double(message, reduce->histogram_max);
+}
+
+/**
+ * Creates a new reduction from settings appended with j_reduce_append_spec().
+ *
+ * \param message A message.
+ *
+ * \return A new reduction without results, NULL if the settings are invalid. Should be freed with j_reduce_unref().
+ **/
+JReduce*
+j_reduce_new_from_message(JMessage* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JReduce* reduce;
+	guint32 type;
+	guint32 filter;
+	gdouble filter_min;
+	gdouble filter_max;
+	guint32 bins;
+	gdouble histogram_min;
+	gdouble histogram_max;
+
+	g_return_val_if_fail(message != NULL, NULL);
+
+	type = j_message_get_4(message);
+	filter = j_message_get_4(message);
+	filter_min = j_reduce_get_double(message);
+	filter_max = j_reduce_get_double(message);
+	bins = j_message_get_4(message);
+	histogram_min = j_reduce_get_double(message);
+	histogram_max = j_reduce_get_double(message);
+
+	if (type > J_REDUCE_TYPE_FLOAT64 || (bins > 0 && !(histogram_min < histogram_max)))
+	{
+		return NULL;
+	}
+
+	reduce = j_reduce_new(type);
+
+	if (filter)
+	{
+		reduce->filter = TRUE;
+		reduce->filter_min = filter_min;
+		reduce->filter_max = filter_max;
+	}
+
+	if (bins > 0)
+	{
+		j_reduce_set_histogram(reduce, histogram_min, histogram_max, bins);
+	}
+
+	return reduce;
+}
+
+/**
+ * Returns the size of a reduction's results in a message.
+ *
+ * \param reduce A reduction.
+ *
+ * \return The size.
+ **/
+gsize
+j_reduce_get_result_size(JReduce* reduce)
+{
+	g_return_val_if_fail(reduce != NULL, 0);
+
+	return 8 + 8 + 8 + 8 + reduce->histogram_bins * 8;
+}
+
+/**
+ * Appends a reduction's results to a message.
+ *
+ * \param reduce  A reduction.
+ * \param message A message.
+ **/
+void
+j_reduce_append_result(JReduce* reduce, JMessage* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(reduce != NULL);
+	g_return_if_fail(message != NULL);
+
+	j_message_append_8(message, &(reduce->count));
+	j_reduce_append_double(message, reduce->sum);
+	j_reduce_append_double(message, reduce->min);
+	j_reduce_append_double(message, reduce->max);
+
+	for (guint32 i = 0; i < reduce->histogram_bins; i++)
+	{
+		j_message_append_8(message, &(reduce->histogram[i]));
+	}
+}
+
+/**
+ * Merges results appended with j_reduce_append_result() into a reduction.
+ * The results have to be computed with the reduction's settings.
+ *
+ * \param reduce  A reduction.
+ * \param message A message.
+ **/
+void
+j_reduce_merge_from_message(JReduce* reduce, JMessage* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(reduce != NULL);
+	g_return_if_fail(message != NULL);
+
+	reduce->count += j_message_get_8(message);
+	reduce->sum += j_reduce_get_double(message);
+	reduce->min = MIN(reduce->min, j_reduce_get_double(message));
+	reduce->max = MAX(reduce->max, j_reduce_get_double(message));
+
+	for (guint32 i = 0; i < reduce->histogram_bins; i++)
+	{
+		reduce->histogram[i] += j_message_get_8(message);
+	}
+}
+
+/**
+ * @}
+ **/
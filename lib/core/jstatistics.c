@@ -25,6 +25,9 @@
 #include <glib.h>
 
 #include <jstatistics.h>
+#include <jstatistics-internal.h>
+
+#include <jhelper.h>
 #include <jtrace.h>
 
 /**
@@ -33,6 +36,59 @@
  * @{
  **/
 
+/**
+ * The assumed size of a cache line.
+ **/
+#define J_STATISTICS_CACHE_LINE_SIZE 64
+
+/**
+ * The statistics of a message type.
+ **/
+struct JStatisticsMessage
+{
+	/**
+	 * The number of handled requests.
+	 **/
+	guint64 requests;
+
+	/**
+	 * The number of bytes read or written while handling requests.
+	 **/
+	guint64 bytes;
+
+	/**
+	 * The time spent handling requests.
+	 **/
+	guint64 time;
+
+	/**
+	 * The time requests waited for a server thread.
+	 **/
+	guint64 queue_time;
+
+	/**
+	 * The time spent receiving requests.
+	 **/
+	guint64 receive_time;
+
+	/**
+	 * The time spent servicing requests until their replies were ready.
+	 **/
+	guint64 service_time;
+
+	/**
+	 * The time spent sending replies.
+	 **/
+	guint64 reply_time;
+
+	/**
+	 * The latency histogram, see #J_STATISTICS_LATENCY_BUCKETS.
+	 **/
+	guint64 latency[J_STATISTICS_LATENCY_BUCKETS];
+};
+
+typedef struct JStatisticsMessage JStatisticsMessage;
+
 /**
  * A statistics.
  **/
@@ -82,8 +138,80 @@ struct JStatistics
 	 * The number of sent bytes.
 	 **/
 	guint64 bytes_sent;
+
+	/**
+	 * The number of established connections.
+	 **/
+	guint64 connections;
+
+	/**
+	 * The number of idle connections.
+	 **/
+	guint64 connections_idle;
+
+	/**
+	 * The current connection limit.
+	 **/
+	guint64 connections_limit;
+
+	/**
+	 * The number of sent messages.
+	 **/
+	guint64 messages_sent;
+
+	/**
+	 * The number of received messages.
+	 **/
+	guint64 messages_received;
+
+	/**
+	 * The number of executed batches.
+	 **/
+	guint64 batches;
+
+	/**
+	 * The time batches have been waiting to be executed.
+	 **/
+	guint64 batch_queue_time;
+
+	/**
+	 * The time batches have been executing.
+	 **/
+	guint64 batch_execution_time;
+
+	/**
+	 * The time batches have spent sending and receiving messages.
+	 **/
+	guint64 batch_network_time;
+
+	/**
+	 * The time batches' requests waited for a server thread, as reported by the servers.
+	 **/
+	guint64 batch_server_queue_time;
+
+	/**
+	 * The time servers spent receiving and servicing batches' requests, as reported by the servers.
+	 **/
+	guint64 batch_server_time;
+
+	/**
+	 * The per-message-type statistics.
+	 * Allocated on first use, since most statistics never account messages.
+	 **/
+	JStatisticsMessage* messages;
+
+	/**
+	 * Keeps the counters of different statistics on separate cache lines.
+	 * Statistics are often updated by different threads, for example, on the server.
+	 **/
+	gchar padding[J_STATISTICS_CACHE_LINE_SIZE];
 };
 
+/**
+ * The statistics that operations currently executed by this thread are accounted to.
+ **/
+static GPrivate j_statistics_current;
+
 static gchar const*
 j_statistics_get_type_name(JStatisticsType type)
 {
@@ -107,6 +235,28 @@ j_statistics_get_type_name(JStatisticsType type)
 			return "bytes_received";
 		case J_STATISTICS_BYTES_SENT:
 			return "bytes_sent";
+		case J_STATISTICS_CONNECTIONS:
+			return "connections";
+		case J_STATISTICS_CONNECTIONS_IDLE:
+			return "connections_idle";
+		case J_STATISTICS_CONNECTIONS_LIMIT:
+			return "connections_limit";
+		case J_STATISTICS_MESSAGES_SENT:
+			return "messages_sent";
+		case J_STATISTICS_MESSAGES_RECEIVED:
+			return "messages_received";
+		case J_STATISTICS_BATCHES:
+			return "batches";
+		case J_STATISTICS_BATCH_QUEUE_TIME:
+			return "batch_queue_time";
+		case J_STATISTICS_BATCH_EXECUTION_TIME:
+			return "batch_execution_time";
+		case J_STATISTICS_BATCH_NETWORK_TIME:
+			return "batch_network_time";
+		case J_STATISTICS_BATCH_SERVER_QUEUE_TIME:
+			return "batch_server_queue_time";
+		case J_STATISTICS_BATCH_SERVER_TIME:
+			return "batch_server_time";
 		default:
 			g_warn_if_reached();
 			return NULL;
@@ -143,6 +293,18 @@ j_statistics_new(gboolean trace)
 	statistics->bytes_written = 0;
 	statistics->bytes_received = 0;
 	statistics->bytes_sent = 0;
+	statistics->connections = 0;
+	statistics->connections_idle = 0;
+	statistics->connections_limit = 0;
+	statistics->messages_sent = 0;
+	statistics->messages_received = 0;
+	statistics->batches = 0;
+	statistics->batch_queue_time = 0;
+	statistics->batch_execution_time = 0;
+	statistics->batch_network_time = 0;
+	statistics->batch_server_queue_time = 0;
+	statistics->batch_server_time = 0;
+	statistics->messages = NULL;
 
 	return statistics;
 }
@@ -164,6 +326,7 @@ j_statistics_free(JStatistics* statistics)
 
 	g_return_if_fail(statistics != NULL);
 
+	g_free(statistics->messages);
 	g_slice_free(JStatistics, statistics);
 }
 
@@ -202,6 +365,39 @@ j_statistics_get(JStatistics* statistics, JStatisticsType type)
 		case J_STATISTICS_BYTES_SENT:
 			value = statistics->bytes_sent;
 			break;
+		case J_STATISTICS_CONNECTIONS:
+			value = statistics->connections;
+			break;
+		case J_STATISTICS_CONNECTIONS_IDLE:
+			value = statistics->connections_idle;
+			break;
+		case J_STATISTICS_CONNECTIONS_LIMIT:
+			value = statistics->connections_limit;
+			break;
+		case J_STATISTICS_MESSAGES_SENT:
+			value = statistics->messages_sent;
+			break;
+		case J_STATISTICS_MESSAGES_RECEIVED:
+			value = statistics->messages_received;
+			break;
+		case J_STATISTICS_BATCHES:
+			value = statistics->batches;
+			break;
+		case J_STATISTICS_BATCH_QUEUE_TIME:
+			value = statistics->batch_queue_time;
+			break;
+		case J_STATISTICS_BATCH_EXECUTION_TIME:
+			value = statistics->batch_execution_time;
+			break;
+		case J_STATISTICS_BATCH_NETWORK_TIME:
+			value = statistics->batch_network_time;
+			break;
+		case J_STATISTICS_BATCH_SERVER_QUEUE_TIME:
+			value = statistics->batch_server_queue_time;
+			break;
+		case J_STATISTICS_BATCH_SERVER_TIME:
+			value = statistics->batch_server_time;
+			break;
 		default:
 			g_warn_if_reached();
 			break;
@@ -220,28 +416,61 @@ j_statistics_add(JStatistics* statistics, JStatisticsType type, guint64 value)
 	switch (type)
 	{
 		case J_STATISTICS_FILES_CREATED:
-			statistics->files_created += value;
+			j_helper_atomic_add(&(statistics->files_created), value);
 			break;
 		case J_STATISTICS_FILES_DELETED:
-			statistics->files_deleted += value;
+			j_helper_atomic_add(&(statistics->files_deleted), value);
 			break;
 		case J_STATISTICS_FILES_STATED:
-			statistics->files_stated += value;
+			j_helper_atomic_add(&(statistics->files_stated), value);
 			break;
 		case J_STATISTICS_SYNC:
-			statistics->sync_count += value;
+			j_helper_atomic_add(&(statistics->sync_count), value);
 			break;
 		case J_STATISTICS_BYTES_READ:
-			statistics->bytes_read += value;
+			j_helper_atomic_add(&(statistics->bytes_read), value);
 			break;
 		case J_STATISTICS_BYTES_WRITTEN:
-			statistics->bytes_written += value;
+			j_helper_atomic_add(&(statistics->bytes_written), value);
 			break;
 		case J_STATISTICS_BYTES_RECEIVED:
-			statistics->bytes_received += value;
+			j_helper_atomic_add(&(statistics->bytes_received), value);
 			break;
 		case J_STATISTICS_BYTES_SENT:
-			statistics->bytes_sent += value;
+			j_helper_atomic_add(&(statistics->bytes_sent), value);
+			break;
+		case J_STATISTICS_CONNECTIONS:
+			j_helper_atomic_add(&(statistics->connections), value);
+			break;
+		case J_STATISTICS_CONNECTIONS_IDLE:
+			j_helper_atomic_add(&(statistics->connections_idle), value);
+			break;
+		case J_STATISTICS_CONNECTIONS_LIMIT:
+			j_helper_atomic_add(&(statistics->connections_limit), value);
+			break;
+		case J_STATISTICS_MESSAGES_SENT:
+			j_helper_atomic_add(&(statistics->messages_sent), value);
+			break;
+		case J_STATISTICS_MESSAGES_RECEIVED:
+			j_helper_atomic_add(&(statistics->messages_received), value);
+			break;
+		case J_STATISTICS_BATCHES:
+			j_helper_atomic_add(&(statistics->batches), value);
+			break;
+		case J_STATISTICS_BATCH_QUEUE_TIME:
+			j_helper_atomic_add(&(statistics->batch_queue_time), value);
+			break;
+		case J_STATISTICS_BATCH_EXECUTION_TIME:
+			j_helper_atomic_add(&(statistics->batch_execution_time), value);
+			break;
+		case J_STATISTICS_BATCH_NETWORK_TIME:
+			j_helper_atomic_add(&(statistics->batch_network_time), value);
+			break;
+		case J_STATISTICS_BATCH_SERVER_QUEUE_TIME:
+			j_helper_atomic_add(&(statistics->batch_server_queue_time), value);
+			break;
+		case J_STATISTICS_BATCH_SERVER_TIME:
+			j_helper_atomic_add(&(statistics->batch_server_time), value);
 			break;
 		default:
 			g_warn_if_reached();
@@ -254,6 +483,324 @@ j_statistics_add(JStatistics* statistics, JStatisticsType type, guint64 value)
 	}
 }
 
+/**
+ * Returns the per-message-type statistics, allocating them if necessary.
+ *
+ * \private
+ *
+ * \param statistics A statistics.
+ *
+ * \return The per-message-type statistics.
+ **/
+static JStatisticsMessage*
+j_statistics_get_messages(JStatistics* statistics)
+{
+	JStatisticsMessage* messages;
+
+	if (G_LIKELY((messages = g_atomic_pointer_get(&(statistics->messages))) != NULL))
+	{
+		return messages;
+	}
+
+	// Allocate an additional element, so no other allocation shares the last cache line.
+	messages = g_new0(JStatisticsMessage, J_STATISTICS_MESSAGE_TYPES + 1);
+
+	if (!g_atomic_pointer_compare_and_exchange(&(statistics->messages), NULL, messages))
+	{
+		// Another thread was faster.
+		g_free(messages);
+		messages = g_atomic_pointer_get(&(statistics->messages));
+	}
+
+	return messages;
+}
+
+/**
+ * Returns a per-message-type statistic.
+ *
+ * \code
+ * \endcode
+ *
+ * \param statistics   A statistics.
+ * \param message_type A message type.
+ * \param type         A per-message-type statistics type.
+ *
+ * \return The value.
+ **/
+guint64
+j_statistics_get_message(JStatistics* statistics, JMessageType message_type, JStatisticsMessageType type)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JStatisticsMessage* messages;
+	guint64 value = 0;
+
+	g_return_val_if_fail(statistics != NULL, 0);
+	g_return_val_if_fail((guint)message_type < J_STATISTICS_MESSAGE_TYPES, 0);
+
+	if ((messages = g_atomic_pointer_get(&(statistics->messages))) == NULL)
+	{
+		return 0;
+	}
+
+	switch (type)
+	{
+		case J_STATISTICS_MESSAGE_REQUESTS:
+			value = messages[message_type].requests;
+			break;
+		case J_STATISTICS_MESSAGE_BYTES:
+			value = messages[message_type].bytes;
+			break;
+		case J_STATISTICS_MESSAGE_TIME:
+			value = messages[message_type].time;
+			break;
+		case J_STATISTICS_MESSAGE_QUEUE_TIME:
+			value = messages[message_type].queue_time;
+			break;
+		case J_STATISTICS_MESSAGE_RECEIVE_TIME:
+			value = messages[message_type].receive_time;
+			break;
+		case J_STATISTICS_MESSAGE_SERVICE_TIME:
+			value = messages[message_type].service_time;
+			break;
+		case J_STATISTICS_MESSAGE_REPLY_TIME:
+			value = messages[message_type].reply_time;
+			break;
+		default:
+			g_warn_if_reached();
+			break;
+	}
+
+	return value;
+}
+
+/**
+ * Adds a value to a per-message-type statistic.
+ *
+ * \code
+ * \endcode
+ *
+ * \param statistics   A statistics.
+ * \param message_type A message type.
+ * \param type         A per-message-type statistics type.
+ * \param value        A value.
+ **/
+void
+j_statistics_add_message(JStatistics* statistics, JMessageType message_type, JStatisticsMessageType type, guint64 value)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JStatisticsMessage* messages;
+
+	g_return_if_fail(statistics != NULL);
+	g_return_if_fail((guint)message_type < J_STATISTICS_MESSAGE_TYPES);
+
+	messages = j_statistics_get_messages(statistics);
+
+	switch (type)
+	{
+		case J_STATISTICS_MESSAGE_REQUESTS:
+			j_helper_atomic_add(&(messages[message_type].requests), value);
+			break;
+		case J_STATISTICS_MESSAGE_BYTES:
+			j_helper_atomic_add(&(messages[message_type].bytes), value);
+			break;
+		case J_STATISTICS_MESSAGE_TIME:
+			j_helper_atomic_add(&(messages[message_type].time), value);
+			break;
+		case J_STATISTICS_MESSAGE_QUEUE_TIME:
+			j_helper_atomic_add(&(messages[message_type].queue_time), value);
+			break;
+		case J_STATISTICS_MESSAGE_RECEIVE_TIME:
+			j_helper_atomic_add(&(messages[message_type].receive_time), value);
+			break;
+		case J_STATISTICS_MESSAGE_SERVICE_TIME:
+			j_helper_atomic_add(&(messages[message_type].service_time), value);
+			break;
+		case J_STATISTICS_MESSAGE_REPLY_TIME:
+			j_helper_atomic_add(&(messages[message_type].reply_time), value);
+			break;
+		default:
+			g_warn_if_reached();
+			break;
+	}
+}
+
+/**
+ * Returns a bucket of a message type's latency histogram.
+ *
+ * \code
+ * \endcode
+ *
+ * \param statistics   A statistics.
+ * \param message_type A message type.
+ * \param bucket       A bucket, see #J_STATISTICS_LATENCY_BUCKETS.
+ *
+ * \return The number of requests accounted in the bucket.
+ **/
+guint64
+j_statistics_get_latency(JStatistics* statistics, JMessageType message_type, guint bucket)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JStatisticsMessage* messages;
+
+	g_return_val_if_fail(statistics != NULL, 0);
+	g_return_val_if_fail((guint)message_type < J_STATISTICS_MESSAGE_TYPES, 0);
+	g_return_val_if_fail(bucket < J_STATISTICS_LATENCY_BUCKETS, 0);
+
+	if ((messages = g_atomic_pointer_get(&(statistics->messages))) == NULL)
+	{
+		return 0;
+	}
+
+	return messages[message_type].latency[bucket];
+}
+
+/**
+ * Accounts a duration in a message type's latency histogram.
+ *
+ * \code
+ * \endcode
+ *
+ * \param statistics   A statistics.
+ * \param message_type A message type.
+ * \param duration     A duration in microseconds.
+ **/
+void
+j_statistics_add_latency(JStatistics* statistics, JMessageType message_type, guint64 duration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JStatisticsMessage* messages;
+	guint bucket;
+
+	g_return_if_fail(statistics != NULL);
+	g_return_if_fail((guint)message_type < J_STATISTICS_MESSAGE_TYPES);
+
+	messages = j_statistics_get_messages(statistics);
+	/* g_bit_storage() returns 1 for 0. */
+	bucket = (duration == 0) ? 0 : MIN(g_bit_storage(duration), J_STATISTICS_LATENCY_BUCKETS - 1);
+
+	j_helper_atomic_add(&(messages[message_type].latency[bucket]), 1);
+}
+
+/**
+ * Adds all values of a statistics to another one.
+ *
+ * \code
+ * \endcode
+ *
+ * \param statistics A statistics.
+ * \param other      The statistics to add.
+ **/
+void
+j_statistics_merge(JStatistics* statistics, JStatistics* other)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JStatisticsMessage* other_messages;
+
+	g_return_if_fail(statistics != NULL);
+	g_return_if_fail(other != NULL);
+
+	for (guint i = J_STATISTICS_FILES_CREATED; i <= J_STATISTICS_BATCH_SERVER_TIME; i++)
+	{
+		guint64 value;
+
+		if ((value = j_statistics_get(other, i)) > 0)
+		{
+			j_statistics_add(statistics, i, value);
+		}
+	}
+
+	if ((other_messages = g_atomic_pointer_get(&(other->messages))) != NULL)
+	{
+		JStatisticsMessage* messages;
+
+		messages = j_statistics_get_messages(statistics);
+
+		for (guint i = 0; i < J_STATISTICS_MESSAGE_TYPES; i++)
+		{
+			if (other_messages[i].requests == 0)
+			{
+				continue;
+			}
+
+			j_helper_atomic_add(&(messages[i].requests), other_messages[i].requests);
+			j_helper_atomic_add(&(messages[i].bytes), other_messages[i].bytes);
+			j_helper_atomic_add(&(messages[i].time), other_messages[i].time);
+			j_helper_atomic_add(&(messages[i].queue_time), other_messages[i].queue_time);
+			j_helper_atomic_add(&(messages[i].receive_time), other_messages[i].receive_time);
+			j_helper_atomic_add(&(messages[i].service_time), other_messages[i].service_time);
+			j_helper_atomic_add(&(messages[i].reply_time), other_messages[i].reply_time);
+
+			for (guint j = 0; j < J_STATISTICS_LATENCY_BUCKETS; j++)
+			{
+				j_helper_atomic_add(&(messages[i].latency[j]), other_messages[i].latency[j]);
+			}
+		}
+	}
+}
+
+/**
+ * Sets the statistics that operations executed by the current thread are accounted to.
+ *
+ * \private
+ *
+ * \param statistics A statistics, or NULL.
+ *
+ * \return The previous statistics, or NULL.
+ **/
+JStatistics*
+j_statistics_set_current(JStatistics* statistics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JStatistics* previous;
+
+	previous = g_private_get(&j_statistics_current);
+	g_private_set(&j_statistics_current, statistics);
+
+	return previous;
+}
+
+/**
+ * Returns the statistics that operations executed by the current thread are accounted to.
+ *
+ * \private
+ *
+ * \return A statistics, or NULL.
+ **/
+JStatistics*
+j_statistics_get_current(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return g_private_get(&j_statistics_current);
+}
+
+/**
+ * Adds a value to the current thread's statistics, if any.
+ *
+ * \private
+ *
+ * \param type  A statistics type.
+ * \param value A value.
+ **/
+void
+j_statistics_add_current(JStatisticsType type, guint64 value)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JStatistics* statistics;
+
+	if ((statistics = g_private_get(&j_statistics_current)) != NULL)
+	{
+		j_statistics_add(statistics, type, value);
+	}
+}
+
 /**
  * @}
  **/
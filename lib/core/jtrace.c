@@ -24,6 +24,12 @@
 
 #include <glib.h>
 #include <glib/gprintf.h>
+#include <gio/gio.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 #ifdef HAVE_OTF
 #include <otf.h>
@@ -35,7 +41,7 @@
  * \defgroup JTrace Trace
  *
  * The JTrace framework offers abstracted trace capabilities.
- * It can use normal terminal output and OTF.
+ * It can use normal terminal output, OTF, a compact binary format and OTLP collectors.
  *
  * @{
  **/
@@ -48,11 +54,89 @@ enum JTraceFlags
 	J_TRACE_OFF = 0,
 	J_TRACE_ECHO = 1 << 0,
 	J_TRACE_OTF = 1 << 1,
-	J_TRACE_SUMMARY = 1 << 2
+	J_TRACE_SUMMARY = 1 << 2,
+	J_TRACE_BINARY = 1 << 3,
+	J_TRACE_OTLP = 1 << 4
 };
 
 typedef enum JTraceFlags JTraceFlags;
 
+/**
+ * Number of preallocated trace frames per thread.
+ * Deeper call stacks fall back to allocating frames.
+ **/
+#define J_TRACE_FRAMES 64
+
+/**
+ * Number of records per ring buffer, must be a power of two.
+ **/
+#define J_TRACE_BINARY_RING_SIZE (1 << 16)
+
+/**
+ * Interval in which the binary trace is written to disk (in microseconds).
+ **/
+#define J_TRACE_BINARY_FLUSH_INTERVAL (100 * G_TIME_SPAN_MILLISECOND)
+
+/**
+ * Marks a record as leaving a function.
+ **/
+#define J_TRACE_BINARY_LEAVE (1U << 31)
+
+/**
+ * Marks a record as defining a function name.
+ **/
+#define J_TRACE_BINARY_DEFINE (1U << 30)
+
+/**
+ * A binary trace record.
+ *
+ * Enter and leave records contain the function ID (with J_TRACE_BINARY_LEAVE set for leave records),
+ * the thread ID and a monotonic timestamp in nanoseconds.
+ * Definition records have J_TRACE_BINARY_DEFINE set, store the name length in thread_id
+ * and are followed by the name, padded to a multiple of the record size.
+ **/
+struct JTraceRecord
+{
+	guint64 timestamp;
+	guint32 thread_id;
+	guint32 function_id;
+};
+
+typedef struct JTraceRecord JTraceRecord;
+
+/**
+ * A single-producer single-consumer ring buffer.
+ * It is filled by its owning thread and drained by the flush thread.
+ **/
+struct JTraceRing
+{
+	JTraceRecord* records;
+
+	/**
+	 * Next record to write, only modified by the owning thread.
+	 **/
+	gsize head;
+
+	/**
+	 * Next record to read, only modified by the flush thread.
+	 **/
+	gsize tail;
+
+	/**
+	 * Number of records dropped because the ring buffer was full.
+	 **/
+	gint dropped;
+
+	/**
+	 * Whether the owning thread has exited.
+	 **/
+	gint finished;
+
+	gint ref_count;
+};
+
+typedef struct JTraceRing JTraceRing;
+
 struct JTraceStack
 {
 	gchar* name;
@@ -61,13 +145,85 @@ struct JTraceStack
 
 typedef struct JTraceStack JTraceStack;
 
-struct JTraceTime
+/**
+ * Interval in which spans are exported to the OTLP collector (in microseconds).
+ **/
+#define J_TRACE_OTLP_EXPORT_INTERVAL (1 * G_TIME_SPAN_SECOND)
+
+/**
+ * Maximum number of spans per export request.
+ **/
+#define J_TRACE_OTLP_BATCH_SIZE 512
+
+/**
+ * Maximum number of queued spans, further spans are dropped.
+ **/
+#define J_TRACE_OTLP_QUEUE_SIZE (1 << 16)
+
+/**
+ * Port of the OTLP/HTTP collector unless the endpoint specifies one.
+ **/
+#define J_TRACE_OTLP_DEFAULT_PORT 4318
+
+/**
+ * A finished span waiting to be exported.
+ **/
+struct JTraceSpan
+{
+	gchar* name;
+	JTraceContext context;
+	guint8 parent_span_id[8];
+	gboolean remote_parent;
+	guint64 start_time;
+	guint64 end_time;
+	guint32 thread_id;
+};
+
+typedef struct JTraceSpan JTraceSpan;
+
+/**
+ * Number of linear sub-buckets per power of two in a latency histogram.
+ * This bounds the relative error of reported percentiles to 1/16.
+ **/
+#define J_TRACE_HISTOGRAM_SUB_BUCKETS 16
+
+/**
+ * Largest power of two distinguished by a latency histogram (in microseconds).
+ * Longer durations are accounted in the last bucket.
+ **/
+#define J_TRACE_HISTOGRAM_MAX_EXPONENT 40
+
+#define J_TRACE_HISTOGRAM_BUCKETS (J_TRACE_HISTOGRAM_SUB_BUCKETS * (J_TRACE_HISTOGRAM_MAX_EXPONENT - 2))
+
+/**
+ * Accumulated durations of a call stack or message type.
+ * Durations are stored in log-linear buckets, similar to HDR histograms.
+ **/
+struct JTraceSummary
 {
-	gdouble time;
-	guint count;
+	guint64 count;
+	guint64 total;
+	guint64 min;
+	guint64 max;
+	guint64 histogram[J_TRACE_HISTOGRAM_BUCKETS];
 };
 
-typedef struct JTraceTime JTraceTime;
+typedef struct JTraceSummary JTraceSummary;
+
+struct JTrace
+{
+	gchar* name;
+	guint64 enter_time;
+	guint32 function_id;
+	gboolean allocated;
+
+	/**
+	 * The span's context and its parent span, used for OTLP traces.
+	 **/
+	JTraceContext context;
+	guint8 parent_span_id[8];
+	gboolean remote_parent;
+};
 
 /**
  * A trace thread.
@@ -80,6 +236,11 @@ struct JTraceThread
 	 **/
 	gchar* thread_name;
 
+	/**
+	 * Thread ID used in binary traces.
+	 **/
+	guint32 thread_id;
+
 	/**
 	 * Function depth within the current thread.
 	 **/
@@ -87,6 +248,38 @@ struct JTraceThread
 
 	GArray* stack;
 
+	/**
+	 * Function name to function ID, 0 if the function is not traced.
+	 * This avoids matching the function patterns and taking locks on every call.
+	 **/
+	GHashTable* functions;
+
+	/**
+	 * Preallocated frames returned by j_trace_enter().
+	 **/
+	JTrace frames[J_TRACE_FRAMES];
+
+	/**
+	 * Ring buffer for binary traces.
+	 **/
+	JTraceRing* ring;
+
+	/**
+	 * Current trace and span, used for OTLP traces.
+	 * #context_remote is set if the current span belongs to another process.
+	 **/
+	JTraceContext context;
+	gboolean context_valid;
+	gboolean context_remote;
+
+	/**
+	 * Call stack or message name to JTraceSummary.
+	 * Only the owning thread modifies the summaries.
+	 * Insertions are protected by #summary_mutex, so other threads can merge the table.
+	 **/
+	GHashTable* summary_table;
+	GMutex summary_mutex;
+
 #ifdef HAVE_OTF
 	/**
 	 * OTF-specific structure.
@@ -103,42 +296,983 @@ struct JTraceThread
 
 typedef struct JTraceThread JTraceThread;
 
-struct JTrace
-{
-	gchar* name;
-	guint64 enter_time;
-};
-
 static JTraceFlags j_trace_flags = J_TRACE_OFF;
 
 static gchar* j_trace_name = NULL;
 static gint j_trace_thread_id = 1;
 
-static GPatternSpec** j_trace_function_patterns = NULL;
+static GPatternSpec** j_trace_function_patterns = NULL;
+
+#ifdef HAVE_OTF
+static OTF_FileManager* otf_manager = NULL;
+static OTF_Writer* otf_writer = NULL;
+
+static guint32 otf_process_id = 1;
+static guint32 otf_function_id = 1;
+static guint32 otf_file_id = 1;
+static guint32 otf_counter_id = 1;
+
+static GHashTable* otf_function_table = NULL;
+static GHashTable* otf_file_table = NULL;
+static GHashTable* otf_counter_table = NULL;
+
+G_LOCK_DEFINE_STATIC(j_trace_otf);
+#endif
+
+static void j_trace_thread_default_free(gpointer);
+
+static GPrivate j_trace_thread_default = G_PRIVATE_INIT(j_trace_thread_default_free);
+
+/**
+ * Summaries of exited threads and all threads that have a summary table.
+ * Protected by j_trace_summary.
+ **/
+static GHashTable* j_trace_summary_table = NULL;
+static GPtrArray* j_trace_summary_threads = NULL;
+
+G_LOCK_DEFINE_STATIC(j_trace_echo);
+G_LOCK_DEFINE_STATIC(j_trace_summary);
+
+static FILE* j_trace_binary_file = NULL;
+static GThread* j_trace_binary_thread = NULL;
+static gboolean j_trace_binary_stop = FALSE;
+
+static GMutex j_trace_binary_mutex;
+static GCond j_trace_binary_cond;
+
+/**
+ * Registered ring buffers, function IDs and names.
+ * Protected by j_trace_binary.
+ **/
+static GPtrArray* j_trace_binary_rings = NULL;
+static GHashTable* j_trace_binary_function_table = NULL;
+static GPtrArray* j_trace_binary_function_names = NULL;
+
+/**
+ * Number of function names already written, only used by the flush thread.
+ **/
+static guint j_trace_binary_function_names_written = 0;
+
+/**
+ * Number of records dropped by threads that have exited, only used by the flush thread.
+ **/
+static guint64 j_trace_binary_dropped = 0;
+
+G_LOCK_DEFINE_STATIC(j_trace_binary);
+
+static gchar* j_trace_otlp_endpoint = NULL;
+static GThread* j_trace_otlp_thread = NULL;
+static gboolean j_trace_otlp_stop = FALSE;
+
+static GMutex j_trace_otlp_mutex;
+static GCond j_trace_otlp_cond;
+
+/**
+ * Finished spans, protected by j_trace_otlp.
+ **/
+static GPtrArray* j_trace_otlp_spans = NULL;
+static guint64 j_trace_otlp_dropped = 0;
+
+G_LOCK_DEFINE_STATIC(j_trace_otlp);
+
+static void
+j_trace_span_free(gpointer data)
+{
+	JTraceSpan* span = data;
+
+	g_free(span->name);
+	g_slice_free(JTraceSpan, span);
+}
+
+static gboolean
+j_trace_otlp_id_is_zero(guint8 const* id, gsize length)
+{
+	for (gsize i = 0; i < length; i++)
+	{
+		if (id[i] != 0)
+		{
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Returns a monotonic timestamp in nanoseconds.
+ *
+ * \private
+ *
+ * \return A timestamp.
+ **/
+static inline guint64
+j_trace_binary_time(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (guint64)ts.tv_sec * G_GUINT64_CONSTANT(1000000000) + (guint64)ts.tv_nsec;
+}
+
+static JTraceRing*
+j_trace_ring_new(void)
+{
+	JTraceRing* ring;
+
+	ring = g_slice_new(JTraceRing);
+	ring->records = g_new(JTraceRecord, J_TRACE_BINARY_RING_SIZE);
+	ring->head = 0;
+	ring->tail = 0;
+	ring->dropped = 0;
+	ring->finished = 0;
+	ring->ref_count = 1;
+
+	return ring;
+}
+
+static JTraceRing*
+j_trace_ring_ref(JTraceRing* ring)
+{
+	g_atomic_int_inc(&ring->ref_count);
+
+	return ring;
+}
+
+static void
+j_trace_ring_unref(gpointer data)
+{
+	JTraceRing* ring = data;
+
+	if (g_atomic_int_dec_and_test(&ring->ref_count))
+	{
+		g_free(ring->records);
+		g_slice_free(JTraceRing, ring);
+	}
+}
+
+/**
+ * Appends a record to a ring buffer.
+ * This does not take any locks and drops the record if the ring buffer is full.
+ *
+ * \private
+ *
+ * \param trace_thread A trace thread.
+ * \param function_id  A function ID.
+ **/
+static inline void
+j_trace_ring_push(JTraceThread* trace_thread, guint32 function_id)
+{
+	JTraceRing* ring = trace_thread->ring;
+	JTraceRecord* record;
+	gsize head;
+	gsize tail;
+
+	head = ring->head;
+	tail = g_atomic_pointer_get(&ring->tail);
+
+	if (G_UNLIKELY(head - tail >= J_TRACE_BINARY_RING_SIZE))
+	{
+		g_atomic_int_inc(&ring->dropped);
+		return;
+	}
+
+	record = &ring->records[head & (J_TRACE_BINARY_RING_SIZE - 1)];
+	record->timestamp = j_trace_binary_time();
+	record->thread_id = trace_thread->thread_id;
+	record->function_id = function_id;
+
+	/* Publish the record to the flush thread. */
+	g_atomic_pointer_set(&ring->head, head + 1);
+}
+
+/**
+ * Writes all new function names and records to the binary trace.
+ * Must only be called by the flush thread.
+ *
+ * \private
+ **/
+static void
+j_trace_binary_flush(void)
+{
+	g_autoptr(GPtrArray) rings = NULL;
+	g_autofree gsize* heads = NULL;
+	g_autofree gboolean* finished = NULL;
+
+	G_LOCK(j_trace_binary);
+
+	rings = g_ptr_array_new_full(j_trace_binary_rings->len, j_trace_ring_unref);
+
+	for (guint i = 0; i < j_trace_binary_rings->len; i++)
+	{
+		g_ptr_array_add(rings, j_trace_ring_ref(g_ptr_array_index(j_trace_binary_rings, i)));
+	}
+
+	G_UNLOCK(j_trace_binary);
+
+	heads = g_new(gsize, rings->len);
+	finished = g_new(gboolean, rings->len);
+
+	/*
+	 * Take the heads before writing the function names.
+	 * Functions are registered before their first record is published, so all records up to the heads can be resolved.
+	 * Check whether the thread has finished first, so we do not miss its last records.
+	 */
+	for (guint i = 0; i < rings->len; i++)
+	{
+		JTraceRing* ring = g_ptr_array_index(rings, i);
+
+		finished[i] = g_atomic_int_get(&ring->finished);
+		heads[i] = g_atomic_pointer_get(&ring->head);
+	}
+
+	G_LOCK(j_trace_binary);
+
+	for (; j_trace_binary_function_names_written < j_trace_binary_function_names->len; j_trace_binary_function_names_written++)
+	{
+		static gchar const padding[sizeof(JTraceRecord)] = { 0 };
+
+		gchar const* name = g_ptr_array_index(j_trace_binary_function_names, j_trace_binary_function_names_written);
+		JTraceRecord record;
+		gsize length;
+
+		length = strlen(name);
+
+		record.timestamp = 0;
+		record.thread_id = (guint32)length;
+		record.function_id = (j_trace_binary_function_names_written + 1) | J_TRACE_BINARY_DEFINE;
+
+		fwrite(&record, sizeof(record), 1, j_trace_binary_file);
+		fwrite(name, 1, length, j_trace_binary_file);
+		fwrite(padding, 1, (sizeof(JTraceRecord) - (length % sizeof(JTraceRecord))) % sizeof(JTraceRecord), j_trace_binary_file);
+	}
+
+	G_UNLOCK(j_trace_binary);
+
+	for (guint i = 0; i < rings->len; i++)
+	{
+		JTraceRing* ring = g_ptr_array_index(rings, i);
+		gsize tail;
+
+		tail = ring->tail;
+
+		while (tail < heads[i])
+		{
+			gsize index;
+			gsize count;
+
+			index = tail & (J_TRACE_BINARY_RING_SIZE - 1);
+			count = MIN(heads[i] - tail, J_TRACE_BINARY_RING_SIZE - index);
+
+			fwrite(&ring->records[index], sizeof(JTraceRecord), count, j_trace_binary_file);
+			tail += count;
+		}
+
+		/* Hand the drained records back to the owning thread. */
+		g_atomic_pointer_set(&ring->tail, tail);
+
+		if (finished[i])
+		{
+			j_trace_binary_dropped += g_atomic_int_get(&ring->dropped);
+
+			G_LOCK(j_trace_binary);
+			g_ptr_array_remove_fast(j_trace_binary_rings, ring);
+			G_UNLOCK(j_trace_binary);
+		}
+	}
+
+	fflush(j_trace_binary_file);
+}
+
+static gpointer
+j_trace_binary_thread_func(gpointer data)
+{
+	(void)data;
+
+	g_mutex_lock(&j_trace_binary_mutex);
+
+	while (!j_trace_binary_stop)
+	{
+		g_cond_wait_until(&j_trace_binary_cond, &j_trace_binary_mutex, g_get_monotonic_time() + J_TRACE_BINARY_FLUSH_INTERVAL);
+
+		g_mutex_unlock(&j_trace_binary_mutex);
+		j_trace_binary_flush();
+		g_mutex_lock(&j_trace_binary_mutex);
+	}
+
+	g_mutex_unlock(&j_trace_binary_mutex);
+
+	return NULL;
+}
+
+/**
+ * Opens the binary trace and starts the flush thread.
+ *
+ * \private
+ *
+ * \param name A trace name.
+ **/
+static void
+j_trace_binary_init(gchar const* name)
+{
+	gchar const* trace_path;
+	g_autofree gchar* file_name = NULL;
+	g_autofree gchar* path = NULL;
+	/* Magic, monotonic and real time at the start, to correlate timestamps. */
+	gchar const magic[8] = { 'J', 'T', 'R', 'A', 'C', 'E', '\0', '\1' };
+	guint64 start_time[2];
+
+	if ((trace_path = g_getenv("JULEA_TRACE_PATH")) == NULL)
+	{
+		trace_path = ".";
+	}
+
+	file_name = g_strdup_printf("%s-%d.jtrace", name, (gint)getpid());
+	path = g_build_filename(trace_path, file_name, NULL);
+
+	if ((j_trace_binary_file = fopen(path, "wb")) == NULL)
+	{
+		g_warning("Cannot open binary trace %s, disabling binary tracing.", path);
+		j_trace_flags &= ~J_TRACE_BINARY;
+		return;
+	}
+
+	start_time[0] = j_trace_binary_time();
+	start_time[1] = g_get_real_time();
+
+	fwrite(magic, 1, sizeof(magic), j_trace_binary_file);
+	fwrite(start_time, sizeof(guint64), G_N_ELEMENTS(start_time), j_trace_binary_file);
+
+	j_trace_binary_rings = g_ptr_array_new_with_free_func(j_trace_ring_unref);
+	j_trace_binary_function_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	j_trace_binary_function_names = g_ptr_array_new();
+	j_trace_binary_function_names_written = 0;
+	j_trace_binary_dropped = 0;
+	j_trace_binary_stop = FALSE;
+
+	j_trace_binary_thread = g_thread_new("JTraceBinary", j_trace_binary_thread_func, NULL);
+}
+
+/**
+ * Stops the flush thread and closes the binary trace.
+ *
+ * \private
+ **/
+static void
+j_trace_binary_fini(void)
+{
+	guint64 dropped;
+
+	g_mutex_lock(&j_trace_binary_mutex);
+	j_trace_binary_stop = TRUE;
+	g_cond_signal(&j_trace_binary_cond);
+	g_mutex_unlock(&j_trace_binary_mutex);
+
+	g_thread_join(j_trace_binary_thread);
+	j_trace_binary_thread = NULL;
+
+	j_trace_binary_flush();
+
+	dropped = j_trace_binary_dropped;
+
+	for (guint i = 0; i < j_trace_binary_rings->len; i++)
+	{
+		JTraceRing* ring = g_ptr_array_index(j_trace_binary_rings, i);
+
+		dropped += g_atomic_int_get(&ring->dropped);
+	}
+
+	if (dropped > 0)
+	{
+		g_warning("Binary trace dropped %" G_GUINT64_FORMAT " records.", dropped);
+	}
+
+	fclose(j_trace_binary_file);
+	j_trace_binary_file = NULL;
+
+	/* Threads that are still running keep their own references. */
+	g_ptr_array_unref(j_trace_binary_rings);
+	j_trace_binary_rings = NULL;
+
+	g_hash_table_unref(j_trace_binary_function_table);
+	j_trace_binary_function_table = NULL;
+
+	/* The names are owned by the function table. */
+	g_ptr_array_unref(j_trace_binary_function_names);
+	j_trace_binary_function_names = NULL;
+}
+
+/**
+ * Generates a random trace or span ID.
+ *
+ * \private
+ *
+ * \param id     A buffer for the ID.
+ * \param length The ID's length, a multiple of four.
+ **/
+static void
+j_trace_otlp_random_id(guint8* id, gsize length)
+{
+	do
+	{
+		for (gsize i = 0; i < length; i += sizeof(guint32))
+		{
+			guint32 value;
+
+			value = g_random_int();
+			memcpy(id + i, &value, sizeof(guint32));
+		}
+	}
+	/* All-zero IDs are invalid. */
+	while (j_trace_otlp_id_is_zero(id, length));
+}
+
+static void
+j_trace_otlp_append_hex(GString* json, guint8 const* id, gsize length)
+{
+	for (gsize i = 0; i < length; i++)
+	{
+		g_string_append_printf(json, "%02x", id[i]);
+	}
+}
+
+static void
+j_trace_otlp_append_string(GString* json, gchar const* string)
+{
+	g_string_append_c(json, '"');
+
+	for (gchar const* c = string; *c != '\0'; c++)
+	{
+		if (*c == '"' || *c == '\\')
+		{
+			g_string_append_c(json, '\\');
+			g_string_append_c(json, *c);
+		}
+		else if ((guchar)*c < 0x20)
+		{
+			g_string_append_printf(json, "\\u%04x", (guint)(guchar)*c);
+		}
+		else
+		{
+			g_string_append_c(json, *c);
+		}
+	}
+
+	g_string_append_c(json, '"');
+}
+
+/**
+ * Encodes spans as an OTLP/HTTP JSON request.
+ *
+ * \private
+ *
+ * \param spans Spans.
+ *
+ * \return The request body. Should be freed with g_string_free().
+ **/
+static GString*
+j_trace_otlp_encode(GPtrArray* spans)
+{
+	GString* json;
+
+	json = g_string_new("{\"resourceSpans\":[{\"resource\":{\"attributes\":[");
+	g_string_append(json, "{\"key\":\"service.name\",\"value\":{\"stringValue\":");
+	j_trace_otlp_append_string(json, j_trace_name);
+	g_string_append_printf(json, "}},{\"key\":\"process.pid\",\"value\":{\"intValue\":\"%d\"}}", (gint)getpid());
+	g_string_append(json, "]},\"scopeSpans\":[{\"scope\":{\"name\":\"julea\"},\"spans\":[");
+
+	for (guint i = 0; i < spans->len; i++)
+	{
+		JTraceSpan const* span = g_ptr_array_index(spans, i);
+
+		if (i > 0)
+		{
+			g_string_append_c(json, ',');
+		}
+
+		g_string_append(json, "{\"traceId\":\"");
+		j_trace_otlp_append_hex(json, span->context.trace_id, sizeof(span->context.trace_id));
+		g_string_append(json, "\",\"spanId\":\"");
+		j_trace_otlp_append_hex(json, span->context.span_id, sizeof(span->context.span_id));
+		g_string_append_c(json, '"');
+
+		if (!j_trace_otlp_id_is_zero(span->parent_span_id, sizeof(span->parent_span_id)))
+		{
+			g_string_append(json, ",\"parentSpanId\":\"");
+			j_trace_otlp_append_hex(json, span->parent_span_id, sizeof(span->parent_span_id));
+			g_string_append_c(json, '"');
+		}
+
+		g_string_append(json, ",\"name\":");
+		j_trace_otlp_append_string(json, span->name);
+		/* 1 is an internal span, 2 a server span handling a remote request. */
+		g_string_append_printf(json, ",\"kind\":%d", (span->remote_parent) ? 2 : 1);
+		g_string_append_printf(json, ",\"startTimeUnixNano\":\"%" G_GUINT64_FORMAT "\",\"endTimeUnixNano\":\"%" G_GUINT64_FORMAT "\"", span->start_time * 1000, span->end_time * 1000);
+		g_string_append_printf(json, ",\"attributes\":[{\"key\":\"thread.id\",\"value\":{\"intValue\":\"%u\"}}]}", span->thread_id);
+	}
+
+	g_string_append(json, "]}]}]}");
+
+	return json;
+}
+
+/**
+ * Sends spans to the OTLP collector.
+ *
+ * \private
+ *
+ * \param spans Spans.
+ *
+ * \return TRUE if the collector accepted the spans, FALSE otherwise.
+ **/
+static gboolean
+j_trace_otlp_export(GPtrArray* spans)
+{
+	gboolean ret = FALSE;
+
+	g_autoptr(GSocketClient) client = NULL;
+	g_autoptr(GSocketConnection) connection = NULL;
+	g_autofree gchar* header = NULL;
+	GInputStream* input;
+	GOutputStream* output;
+	GError* error = NULL;
+	GString* body;
+	gchar response[64];
+	gsize response_length = 0;
+
+	body = j_trace_otlp_encode(spans);
+	client = g_socket_client_new();
+
+	if ((connection = g_socket_client_connect_to_host(client, j_trace_otlp_endpoint, J_TRACE_OTLP_DEFAULT_PORT, NULL, &error)) == NULL)
+	{
+		goto end;
+	}
+
+	input = g_io_stream_get_input_stream(G_IO_STREAM(connection));
+	output = g_io_stream_get_output_stream(G_IO_STREAM(connection));
+
+	header = g_strdup_printf("POST /v1/traces HTTP/1.1\r\nHost: %s\r\nContent-Type: application/json\r\nContent-Length: %" G_GSIZE_FORMAT "\r\nConnection: close\r\n\r\n", j_trace_otlp_endpoint, body->len);
+
+	if (!g_output_stream_write_all(output, header, strlen(header), NULL, NULL, &error) || !g_output_stream_write_all(output, body->str, body->len, NULL, NULL, &error))
+	{
+		goto end;
+	}
+
+	/* Only the status line matters, for example "HTTP/1.1 200 OK". */
+	if (!g_input_stream_read_all(input, response, sizeof(response) - 1, &response_length, NULL, &error))
+	{
+		goto end;
+	}
+
+	response[response_length] = '\0';
+	ret = (response_length >= 12 && g_str_has_prefix(response, "HTTP/") && strchr(response, ' ') != NULL && strchr(response, ' ')[1] == '2');
+
+	if (!ret)
+	{
+		g_warning("OTLP collector %s rejected %u spans.", j_trace_otlp_endpoint, spans->len);
+	}
+
+end:
+	if (error != NULL)
+	{
+		g_warning("Cannot export spans to OTLP collector %s: %s", j_trace_otlp_endpoint, error->message);
+		g_error_free(error);
+	}
+
+	if (connection != NULL)
+	{
+		g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+	}
+
+	g_string_free(body, TRUE);
+
+	return ret;
+}
+
+/**
+ * Exports all queued spans in batches.
+ * Spans that could not be exported are dropped.
+ *
+ * \private
+ **/
+static void
+j_trace_otlp_flush(void)
+{
+	GPtrArray* spans;
+
+	G_LOCK(j_trace_otlp);
+	spans = j_trace_otlp_spans;
+	j_trace_otlp_spans = g_ptr_array_new_with_free_func(j_trace_span_free);
+	G_UNLOCK(j_trace_otlp);
+
+	for (guint i = 0; i < spans->len; i += J_TRACE_OTLP_BATCH_SIZE)
+	{
+		g_autoptr(GPtrArray) batch = NULL;
+		guint length;
+
+		length = MIN(spans->len - i, J_TRACE_OTLP_BATCH_SIZE);
+		batch = g_ptr_array_sized_new(length);
+
+		for (guint j = 0; j < length; j++)
+		{
+			g_ptr_array_add(batch, g_ptr_array_index(spans, i + j));
+		}
+
+		if (!j_trace_otlp_export(batch))
+		{
+			G_LOCK(j_trace_otlp);
+			j_trace_otlp_dropped += spans->len - i;
+			G_UNLOCK(j_trace_otlp);
+			break;
+		}
+	}
+
+	g_ptr_array_unref(spans);
+}
+
+static gpointer
+j_trace_otlp_thread_func(gpointer data)
+{
+	(void)data;
+
+	g_mutex_lock(&j_trace_otlp_mutex);
+
+	while (!j_trace_otlp_stop)
+	{
+		g_cond_wait_until(&j_trace_otlp_cond, &j_trace_otlp_mutex, g_get_monotonic_time() + J_TRACE_OTLP_EXPORT_INTERVAL);
+
+		g_mutex_unlock(&j_trace_otlp_mutex);
+		j_trace_otlp_flush();
+		g_mutex_lock(&j_trace_otlp_mutex);
+	}
+
+	g_mutex_unlock(&j_trace_otlp_mutex);
+
+	return NULL;
+}
+
+/**
+ * Starts the thread exporting spans to the OTLP collector.
+ * The collector is set via \c JULEA_TRACE_OTLP_ENDPOINT and defaults to localhost:4318.
+ *
+ * \private
+ **/
+static void
+j_trace_otlp_init(void)
+{
+	gchar const* endpoint;
+
+	if ((endpoint = g_getenv("JULEA_TRACE_OTLP_ENDPOINT")) == NULL)
+	{
+		endpoint = "localhost";
+	}
+
+	/* Only plain HTTP is supported, so accept the URL form used by other OTLP exporters. */
+	if (g_str_has_prefix(endpoint, "http://"))
+	{
+		endpoint += strlen("http://");
+	}
+
+	j_trace_otlp_endpoint = g_strndup(endpoint, strcspn(endpoint, "/"));
+	j_trace_otlp_spans = g_ptr_array_new_with_free_func(j_trace_span_free);
+	j_trace_otlp_dropped = 0;
+	j_trace_otlp_stop = FALSE;
+
+	j_trace_otlp_thread = g_thread_new("JTraceOTLP", j_trace_otlp_thread_func, NULL);
+}
+
+/**
+ * Stops the export thread after exporting the remaining spans.
+ *
+ * \private
+ **/
+static void
+j_trace_otlp_fini(void)
+{
+	g_mutex_lock(&j_trace_otlp_mutex);
+	j_trace_otlp_stop = TRUE;
+	g_cond_signal(&j_trace_otlp_cond);
+	g_mutex_unlock(&j_trace_otlp_mutex);
+
+	g_thread_join(j_trace_otlp_thread);
+	j_trace_otlp_thread = NULL;
+
+	j_trace_otlp_flush();
+
+	if (j_trace_otlp_dropped > 0)
+	{
+		g_warning("OTLP trace dropped %" G_GUINT64_FORMAT " spans.", j_trace_otlp_dropped);
+	}
+
+	g_ptr_array_unref(j_trace_otlp_spans);
+	j_trace_otlp_spans = NULL;
+
+	g_free(j_trace_otlp_endpoint);
+	j_trace_otlp_endpoint = NULL;
+}
+
+/**
+ * Starts a span in the current thread's trace context.
+ * A new trace is started if the thread is not part of one.
+ *
+ * \private
+ *
+ * \param trace_thread A trace thread.
+ * \param trace        A trace.
+ **/
+static void
+j_trace_otlp_enter(JTraceThread* trace_thread, JTrace* trace)
+{
+	if (!trace_thread->context_valid)
+	{
+		j_trace_otlp_random_id(trace_thread->context.trace_id, sizeof(trace_thread->context.trace_id));
+		memset(trace_thread->context.span_id, 0, sizeof(trace_thread->context.span_id));
+		trace_thread->context_valid = TRUE;
+	}
+
+	memcpy(trace->context.trace_id, trace_thread->context.trace_id, sizeof(trace->context.trace_id));
+	memcpy(trace->parent_span_id, trace_thread->context.span_id, sizeof(trace->parent_span_id));
+	j_trace_otlp_random_id(trace->context.span_id, sizeof(trace->context.span_id));
+	trace->remote_parent = trace_thread->context_remote;
+
+	memcpy(trace_thread->context.span_id, trace->context.span_id, sizeof(trace_thread->context.span_id));
+	trace_thread->context_remote = FALSE;
+}
+
+/**
+ * Ends a span and queues it for export.
+ * Afterwards, the span's parent is the current span again.
+ *
+ * \private
+ *
+ * \param trace_thread A trace thread.
+ * \param trace        A trace.
+ * \param timestamp    The end time.
+ **/
+static void
+j_trace_otlp_leave(JTraceThread* trace_thread, JTrace* trace, guint64 timestamp)
+{
+	JTraceSpan* span;
+
+	span = g_slice_new(JTraceSpan);
+	span->name = trace->name;
+	span->context = trace->context;
+	memcpy(span->parent_span_id, trace->parent_span_id, sizeof(span->parent_span_id));
+	span->remote_parent = trace->remote_parent;
+	span->start_time = trace->enter_time;
+	span->end_time = timestamp;
+	span->thread_id = trace_thread->thread_id;
+
+	/* The span owns the name now. */
+	trace->name = NULL;
+
+	G_LOCK(j_trace_otlp);
+
+	if (j_trace_otlp_spans->len < J_TRACE_OTLP_QUEUE_SIZE)
+	{
+		g_ptr_array_add(j_trace_otlp_spans, span);
+		span = NULL;
+	}
+	else
+	{
+		j_trace_otlp_dropped++;
+	}
+
+	G_UNLOCK(j_trace_otlp);
+
+	if (span != NULL)
+	{
+		j_trace_span_free(span);
+	}
+
+	memcpy(trace_thread->context.trace_id, trace->context.trace_id, sizeof(trace_thread->context.trace_id));
+	memcpy(trace_thread->context.span_id, trace->parent_span_id, sizeof(trace_thread->context.span_id));
+	trace_thread->context_remote = trace->remote_parent;
+	/* Leaving a root span ends the trace. */
+	trace_thread->context_valid = !j_trace_otlp_id_is_zero(trace->parent_span_id, sizeof(trace->parent_span_id));
+}
+
+/**
+ * Returns the histogram bucket of a duration.
+ *
+ * \private
+ *
+ * \param duration A duration.
+ *
+ * \return A bucket index.
+ **/
+static guint
+j_trace_histogram_bucket(guint64 duration)
+{
+	guint exponent;
+
+	if (duration < J_TRACE_HISTOGRAM_SUB_BUCKETS)
+	{
+		return duration;
+	}
+
+	/* J_TRACE_HISTOGRAM_SUB_BUCKETS is 2^4. */
+	exponent = g_bit_storage(duration) - 1;
+
+	if (exponent > J_TRACE_HISTOGRAM_MAX_EXPONENT)
+	{
+		return J_TRACE_HISTOGRAM_BUCKETS - 1;
+	}
+
+	return J_TRACE_HISTOGRAM_SUB_BUCKETS * (exponent - 3) + ((duration >> (exponent - 4)) & (J_TRACE_HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+/**
+ * Returns the largest duration accounted in a histogram bucket.
+ *
+ * \private
+ *
+ * \param bucket A bucket index.
+ *
+ * \return A duration.
+ **/
+static guint64
+j_trace_histogram_bucket_max(guint bucket)
+{
+	guint exponent;
+	guint64 sub_bucket;
+
+	if (bucket < J_TRACE_HISTOGRAM_SUB_BUCKETS)
+	{
+		return bucket;
+	}
+
+	exponent = (bucket / J_TRACE_HISTOGRAM_SUB_BUCKETS) + 3;
+	sub_bucket = J_TRACE_HISTOGRAM_SUB_BUCKETS + (bucket % J_TRACE_HISTOGRAM_SUB_BUCKETS);
+
+	return ((sub_bucket + 1) << (exponent - 4)) - 1;
+}
+
+static JTraceSummary*
+j_trace_summary_new(void)
+{
+	JTraceSummary* summary;
+
+	summary = g_new0(JTraceSummary, 1);
+	summary->min = G_MAXUINT64;
+
+	return summary;
+}
+
+/**
+ * Accounts a duration in a summary.
+ *
+ * \private
+ *
+ * \param summary  A summary.
+ * \param duration A duration in microseconds.
+ **/
+static void
+j_trace_summary_record(JTraceSummary* summary, guint64 duration)
+{
+	summary->count++;
+	summary->total += duration;
+	summary->min = MIN(summary->min, duration);
+	summary->max = MAX(summary->max, duration);
+	summary->histogram[j_trace_histogram_bucket(duration)]++;
+}
+
+/**
+ * Merges a table of summaries into another one.
+ *
+ * \private
+ *
+ * \param table A table to merge into.
+ * \param other A table to merge.
+ **/
+static void
+j_trace_summary_merge(GHashTable* table, GHashTable* other)
+{
+	GHashTableIter iter;
+	gchar const* name;
+	JTraceSummary const* other_summary;
+
+	g_hash_table_iter_init(&iter, other);
+
+	while (g_hash_table_iter_next(&iter, (gpointer*)&name, (gpointer*)&other_summary))
+	{
+		JTraceSummary* summary;
+
+		if ((summary = g_hash_table_lookup(table, name)) == NULL)
+		{
+			summary = j_trace_summary_new();
+			g_hash_table_insert(table, g_strdup(name), summary);
+		}
+
+		summary->count += other_summary->count;
+		summary->total += other_summary->total;
+		summary->min = MIN(summary->min, other_summary->min);
+		summary->max = MAX(summary->max, other_summary->max);
+
+		for (guint i = 0; i < J_TRACE_HISTOGRAM_BUCKETS; i++)
+		{
+			summary->histogram[i] += other_summary->histogram[i];
+		}
+	}
+}
+
+/**
+ * Returns a percentile of a summary's durations.
+ *
+ * \private
+ *
+ * \param summary    A summary.
+ * \param percentile A percentile between 0 and 1.
+ *
+ * \return The duration in microseconds.
+ **/
+static guint64
+j_trace_summary_percentile(JTraceSummary const* summary, gdouble percentile)
+{
+	guint64 rank;
+	guint64 count = 0;
+
+	rank = MAX(1, (guint64)(percentile * (gdouble)summary->count + 0.5));
 
-#ifdef HAVE_OTF
-static OTF_FileManager* otf_manager = NULL;
-static OTF_Writer* otf_writer = NULL;
+	for (guint i = 0; i < J_TRACE_HISTOGRAM_BUCKETS; i++)
+	{
+		count += summary->histogram[i];
 
-static guint32 otf_process_id = 1;
-static guint32 otf_function_id = 1;
-static guint32 otf_file_id = 1;
-static guint32 otf_counter_id = 1;
+		if (count >= rank)
+		{
+			return MIN(j_trace_histogram_bucket_max(i), summary->max);
+		}
+	}
 
-static GHashTable* otf_function_table = NULL;
-static GHashTable* otf_file_table = NULL;
-static GHashTable* otf_counter_table = NULL;
+	return summary->max;
+}
 
-G_LOCK_DEFINE_STATIC(j_trace_otf);
-#endif
+/**
+ * Accounts a duration in the current thread's summary table.
+ * This does not take any locks unless the name is accounted for the first time.
+ *
+ * \private
+ *
+ * \param trace_thread A trace thread.
+ * \param name         A call stack or message name.
+ * \param duration     A duration in microseconds.
+ **/
+static void
+j_trace_summary_add(JTraceThread* trace_thread, gchar const* name, guint64 duration)
+{
+	JTraceSummary* summary;
 
-static void j_trace_thread_default_free(gpointer);
+	if (G_UNLIKELY((summary = g_hash_table_lookup(trace_thread->summary_table, name)) == NULL))
+	{
+		summary = j_trace_summary_new();
 
-static GPrivate j_trace_thread_default = G_PRIVATE_INIT(j_trace_thread_default_free);
-static GHashTable* j_trace_summary_table = NULL;
+		g_mutex_lock(&(trace_thread->summary_mutex));
+		g_hash_table_insert(trace_thread->summary_table, g_strdup(name), summary);
+		g_mutex_unlock(&(trace_thread->summary_mutex));
+	}
 
-G_LOCK_DEFINE_STATIC(j_trace_echo);
-G_LOCK_DEFINE_STATIC(j_trace_summary);
+	j_trace_summary_record(summary, duration);
+}
 
 /**
  * Creates a new trace thread.
@@ -163,10 +1297,15 @@ j_trace_thread_new(GThread* thread)
 	trace_thread = g_slice_new(JTraceThread);
 	trace_thread->function_depth = 0;
 	trace_thread->stack = g_array_new(FALSE, FALSE, sizeof(JTraceStack));
+	trace_thread->functions = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	trace_thread->ring = NULL;
+	trace_thread->context_valid = FALSE;
+	trace_thread->context_remote = FALSE;
 
 	if (thread == NULL)
 	{
 		trace_thread->thread_name = g_strdup("Main process");
+		trace_thread->thread_id = 0;
 	}
 	else
 	{
@@ -175,6 +1314,28 @@ j_trace_thread_new(GThread* thread)
 		/* FIXME use name? */
 		thread_id = g_atomic_int_add(&j_trace_thread_id, 1);
 		trace_thread->thread_name = g_strdup_printf("Thread %d", thread_id);
+		trace_thread->thread_id = thread_id;
+	}
+
+	trace_thread->summary_table = NULL;
+
+	if (j_trace_flags & J_TRACE_SUMMARY)
+	{
+		trace_thread->summary_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+		g_mutex_init(&(trace_thread->summary_mutex));
+
+		G_LOCK(j_trace_summary);
+		g_ptr_array_add(j_trace_summary_threads, trace_thread);
+		G_UNLOCK(j_trace_summary);
+	}
+
+	if (j_trace_flags & J_TRACE_BINARY)
+	{
+		trace_thread->ring = j_trace_ring_new();
+
+		G_LOCK(j_trace_binary);
+		g_ptr_array_add(j_trace_binary_rings, j_trace_ring_ref(trace_thread->ring));
+		G_UNLOCK(j_trace_binary);
 	}
 
 #ifdef HAVE_OTF
@@ -216,8 +1377,27 @@ j_trace_thread_free(JTraceThread* trace_thread)
 	}
 #endif
 
+	if (trace_thread->summary_table != NULL)
+	{
+		G_LOCK(j_trace_summary);
+		g_ptr_array_remove_fast(j_trace_summary_threads, trace_thread);
+		j_trace_summary_merge(j_trace_summary_table, trace_thread->summary_table);
+		G_UNLOCK(j_trace_summary);
+
+		g_hash_table_unref(trace_thread->summary_table);
+		g_mutex_clear(&(trace_thread->summary_mutex));
+	}
+
+	if (trace_thread->ring != NULL)
+	{
+		/* The flush thread drains the remaining records and drops its reference afterwards. */
+		g_atomic_int_set(&trace_thread->ring->finished, 1);
+		j_trace_ring_unref(trace_thread->ring);
+	}
+
 	g_free(trace_thread->thread_name);
 	g_array_free(trace_thread->stack, TRUE);
+	g_hash_table_unref(trace_thread->functions);
 	g_slice_free(JTraceThread, trace_thread);
 }
 
@@ -297,6 +1477,8 @@ j_trace_file_operation_name(JTraceFileOperation op)
 			return "create";
 		case J_TRACE_FILE_DELETE:
 			return "delete";
+		case J_TRACE_FILE_DISCARD:
+			return "discard";
 		case J_TRACE_FILE_OPEN:
 			return "open";
 		case J_TRACE_FILE_READ:
@@ -345,11 +1527,65 @@ j_trace_function_check(gchar const* name)
 	return TRUE;
 }
 
+/**
+ * Returns the ID of a function.
+ * The result is cached per thread, so only the first call of a function takes a lock.
+ *
+ * \private
+ *
+ * \param trace_thread A trace thread.
+ * \param name         A function name.
+ *
+ * \return The function ID, 0 if the function should not be traced.
+ **/
+static guint32
+j_trace_function_get_id(JTraceThread* trace_thread, gchar const* name)
+{
+	gpointer value;
+	guint32 function_id = 0;
+
+	if (G_LIKELY(g_hash_table_lookup_extended(trace_thread->functions, name, NULL, &value)))
+	{
+		return GPOINTER_TO_UINT(value);
+	}
+
+	if (j_trace_function_check(name))
+	{
+		function_id = 1;
+
+		if (j_trace_flags & J_TRACE_BINARY)
+		{
+			G_LOCK(j_trace_binary);
+
+			if ((value = g_hash_table_lookup(j_trace_binary_function_table, name)) == NULL)
+			{
+				gchar* function_name;
+
+				function_name = g_strdup(name);
+				g_ptr_array_add(j_trace_binary_function_names, function_name);
+				function_id = j_trace_binary_function_names->len;
+
+				g_hash_table_insert(j_trace_binary_function_table, function_name, GUINT_TO_POINTER(function_id));
+			}
+			else
+			{
+				function_id = GPOINTER_TO_UINT(value);
+			}
+
+			G_UNLOCK(j_trace_binary);
+		}
+	}
+
+	g_hash_table_insert(trace_thread->functions, g_strdup(name), GUINT_TO_POINTER(function_id));
+
+	return function_id;
+}
+
 /**
  * Initializes the trace framework.
  * Tracing is disabled by default.
  * Set the \c J_TRACE environment variable to enable it.
- * Valid values are \e echo and \e otf.
+ * Valid values are \e echo, \e otf, \e summary, \e binary and \e otlp.
  * Multiple values can be combined with commas.
  *
  * \code
@@ -391,6 +1627,14 @@ j_trace_init(gchar const* name)
 		{
 			j_trace_flags |= J_TRACE_SUMMARY;
 		}
+		else if (g_strcmp0(trace_parts[i], "binary") == 0)
+		{
+			j_trace_flags |= J_TRACE_BINARY;
+		}
+		else if (g_strcmp0(trace_parts[i], "otlp") == 0)
+		{
+			j_trace_flags |= J_TRACE_OTLP;
+		}
 	}
 
 	if (j_trace_flags == J_TRACE_OFF)
@@ -437,10 +1681,21 @@ j_trace_init(gchar const* name)
 	if (j_trace_flags & J_TRACE_SUMMARY)
 	{
 		j_trace_summary_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+		j_trace_summary_threads = g_ptr_array_new();
+	}
+
+	if (j_trace_flags & J_TRACE_BINARY)
+	{
+		j_trace_binary_init(name);
 	}
 
 	g_free(j_trace_name);
 	j_trace_name = g_strdup(name);
+
+	if (j_trace_flags & J_TRACE_OTLP)
+	{
+		j_trace_otlp_init();
+	}
 }
 
 /**
@@ -480,20 +1735,28 @@ j_trace_fini(void)
 
 	if (j_trace_flags & J_TRACE_SUMMARY)
 	{
-		GHashTableIter iter;
-		gchar* key;
-		JTraceTime* value;
+		j_trace_summary_print();
 
-		g_hash_table_iter_init(&iter, j_trace_summary_table);
+		G_LOCK(j_trace_summary);
 
-		g_printerr("# stack duration[s] count\n");
+		g_hash_table_unref(j_trace_summary_table);
+		j_trace_summary_table = NULL;
 
-		while (g_hash_table_iter_next(&iter, (gpointer*)&key, (gpointer*)&value))
-		{
-			g_printerr("%s %f %d\n", key, value->time, value->count);
-		}
+		/* Threads that are still running keep their own tables. */
+		g_ptr_array_unref(j_trace_summary_threads);
+		j_trace_summary_threads = NULL;
 
-		g_hash_table_unref(j_trace_summary_table);
+		G_UNLOCK(j_trace_summary);
+	}
+
+	if (j_trace_flags & J_TRACE_BINARY)
+	{
+		j_trace_binary_fini();
+	}
+
+	if (j_trace_flags & J_TRACE_OTLP)
+	{
+		j_trace_otlp_fini();
 	}
 
 	j_trace_flags = J_TRACE_OFF;
@@ -526,6 +1789,7 @@ j_trace_enter(gchar const* name, gchar const* format, ...)
 	JTraceThread* trace_thread;
 	JTrace* trace;
 	guint64 timestamp;
+	guint32 function_id;
 	va_list args;
 
 	if (j_trace_flags == J_TRACE_OFF)
@@ -537,18 +1801,49 @@ j_trace_enter(gchar const* name, gchar const* format, ...)
 
 	trace_thread = j_trace_thread_get_default();
 
-	if (!j_trace_function_check(name))
+	if ((function_id = j_trace_function_get_id(trace_thread, name)) == 0)
 	{
 		/* FIXME also blacklist nested functions */
 		return NULL;
 	}
 
+	if (G_LIKELY(trace_thread->function_depth < J_TRACE_FRAMES))
+	{
+		trace = &(trace_thread->frames[trace_thread->function_depth]);
+		trace->allocated = FALSE;
+	}
+	else
+	{
+		trace = g_slice_new(JTrace);
+		trace->allocated = TRUE;
+	}
+
+	trace->name = NULL;
+	trace->enter_time = 0;
+	trace->function_id = function_id;
+
+	if (j_trace_flags & J_TRACE_BINARY)
+	{
+		j_trace_ring_push(trace_thread, function_id);
+
+		if (j_trace_flags == J_TRACE_BINARY)
+		{
+			trace_thread->function_depth++;
+
+			return trace;
+		}
+	}
+
 	timestamp = g_get_real_time();
 
-	trace = g_slice_new(JTrace);
 	trace->name = g_strdup(name);
 	trace->enter_time = timestamp;
 
+	if (j_trace_flags & J_TRACE_OTLP)
+	{
+		j_trace_otlp_enter(trace_thread, trace);
+	}
+
 	va_start(args, format);
 
 	if (j_trace_flags & J_TRACE_ECHO)
@@ -650,11 +1945,6 @@ j_trace_leave(JTrace* trace)
 
 	trace_thread = j_trace_thread_get_default();
 
-	if (!j_trace_function_check(trace->name))
-	{
-		goto end;
-	}
-
 	/* FIXME */
 	if (trace_thread->function_depth == 0)
 	{
@@ -662,6 +1952,17 @@ j_trace_leave(JTrace* trace)
 	}
 
 	trace_thread->function_depth--;
+
+	if (j_trace_flags & J_TRACE_BINARY)
+	{
+		j_trace_ring_push(trace_thread, trace->function_id | J_TRACE_BINARY_LEAVE);
+
+		if (j_trace_flags == J_TRACE_BINARY)
+		{
+			goto end;
+		}
+	}
+
 	timestamp = g_get_real_time();
 
 	if (j_trace_flags & J_TRACE_ECHO)
@@ -697,42 +1998,29 @@ j_trace_leave(JTrace* trace)
 
 	if (j_trace_flags & J_TRACE_SUMMARY)
 	{
-		JTraceTime* combined_duration;
 		JTraceStack* top_stack;
-		guint64 duration;
 
 		g_assert(trace_thread->stack->len > 0);
 
 		top_stack = &g_array_index(trace_thread->stack, JTraceStack, trace_thread->stack->len - 1);
-		duration = timestamp - top_stack->enter_time;
-
-		G_LOCK(j_trace_summary);
-
-		combined_duration = g_hash_table_lookup(j_trace_summary_table, top_stack->name);
-
-		if (combined_duration == NULL)
-		{
-			combined_duration = g_new(JTraceTime, 1);
-			combined_duration->time = ((gdouble)duration) / ((gdouble)G_USEC_PER_SEC);
-			combined_duration->count = 1;
-
-			g_hash_table_insert(j_trace_summary_table, g_strdup(top_stack->name), combined_duration);
-		}
-		else
-		{
-			combined_duration->time += ((gdouble)duration) / ((gdouble)G_USEC_PER_SEC);
-			combined_duration->count++;
-		}
-
-		G_UNLOCK(j_trace_summary);
+		j_trace_summary_add(trace_thread, top_stack->name, timestamp - top_stack->enter_time);
 
 		g_free(top_stack->name);
 		g_array_set_size(trace_thread->stack, trace_thread->stack->len - 1);
 	}
 
+	if (j_trace_flags & J_TRACE_OTLP)
+	{
+		j_trace_otlp_leave(trace_thread, trace, timestamp);
+	}
+
 end:
 	g_free(trace->name);
-	g_slice_free(JTrace, trace);
+
+	if (trace->allocated)
+	{
+		g_slice_free(JTrace, trace);
+	}
 }
 
 /**
@@ -855,6 +2143,9 @@ j_trace_file_end(gchar const* path, JTraceFileOperation op, guint64 length, guin
 			case J_TRACE_FILE_DELETE:
 				otf_op = OTF_FILEOP_UNLINK;
 				break;
+			case J_TRACE_FILE_DISCARD:
+				otf_op = OTF_FILEOP_OTHER;
+				break;
 			case J_TRACE_FILE_OPEN:
 				otf_op = OTF_FILEOP_OPEN;
 				break;
@@ -952,6 +2243,162 @@ j_trace_counter(gchar const* name, guint64 counter_value)
 #endif
 }
 
+/**
+ * Traces a duration.
+ * Durations are accumulated in the summary under the given name, for example, per message type.
+ *
+ * \code
+ * \endcode
+ *
+ * \param name     A name.
+ * \param duration A duration in microseconds.
+ **/
+void
+j_trace_duration(gchar const* name, guint64 duration)
+{
+	JTraceThread* trace_thread;
+
+	if (!(j_trace_flags & J_TRACE_SUMMARY))
+	{
+		return;
+	}
+
+	g_return_if_fail(name != NULL);
+
+	trace_thread = j_trace_thread_get_default();
+	j_trace_summary_add(trace_thread, name, duration);
+}
+
+/**
+ * Prints the summary of all threads to stderr.
+ * This is done automatically by j_trace_fini() but can also be used to inspect running processes.
+ * The summaries of running threads are merged without stopping them, so the output is a close approximation.
+ *
+ * \code
+ * j_trace_summary_print();
+ * \endcode
+ **/
+void
+j_trace_summary_print(void)
+{
+	g_autoptr(GHashTable) table = NULL;
+	g_autoptr(GList) names = NULL;
+
+	if (!(j_trace_flags & J_TRACE_SUMMARY))
+	{
+		return;
+	}
+
+	table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+
+	G_LOCK(j_trace_summary);
+
+	j_trace_summary_merge(table, j_trace_summary_table);
+
+	for (guint i = 0; i < j_trace_summary_threads->len; i++)
+	{
+		JTraceThread* trace_thread = g_ptr_array_index(j_trace_summary_threads, i);
+
+		g_mutex_lock(&(trace_thread->summary_mutex));
+		j_trace_summary_merge(table, trace_thread->summary_table);
+		g_mutex_unlock(&(trace_thread->summary_mutex));
+	}
+
+	G_UNLOCK(j_trace_summary);
+
+	names = g_list_sort(g_hash_table_get_keys(table), (GCompareFunc)g_strcmp0);
+
+	g_printerr("# stack duration[s] count min[s] p50[s] p99[s] p999[s] max[s]\n");
+
+	for (GList* l = names; l != NULL; l = l->next)
+	{
+		gchar const* name = l->data;
+		JTraceSummary const* summary;
+
+		summary = g_hash_table_lookup(table, name);
+
+		g_printerr("%s %f %" G_GUINT64_FORMAT " %f %f %f %f %f\n", name, (gdouble)summary->total / (gdouble)G_USEC_PER_SEC, summary->count, (gdouble)summary->min / (gdouble)G_USEC_PER_SEC, (gdouble)j_trace_summary_percentile(summary, 0.5) / (gdouble)G_USEC_PER_SEC, (gdouble)j_trace_summary_percentile(summary, 0.99) / (gdouble)G_USEC_PER_SEC, (gdouble)j_trace_summary_percentile(summary, 0.999) / (gdouble)G_USEC_PER_SEC, (gdouble)summary->max / (gdouble)G_USEC_PER_SEC);
+	}
+}
+
+/**
+ * Returns the current thread's trace context.
+ * It can be sent to another process to continue the trace there, see j_trace_context_set().
+ *
+ * \code
+ * JTraceContext context;
+ *
+ * if (j_trace_context_get(&context))
+ * {
+ *   ...
+ * }
+ * \endcode
+ *
+ * \param context A trace context.
+ *
+ * \return TRUE if the thread is part of a trace, FALSE otherwise.
+ **/
+gboolean
+j_trace_context_get(JTraceContext* context)
+{
+	JTraceThread* trace_thread;
+
+	g_return_val_if_fail(context != NULL, FALSE);
+
+	if (!(j_trace_flags & J_TRACE_OTLP))
+	{
+		return FALSE;
+	}
+
+	trace_thread = j_trace_thread_get_default();
+
+	if (!trace_thread->context_valid || j_trace_otlp_id_is_zero(trace_thread->context.span_id, sizeof(trace_thread->context.span_id)))
+	{
+		return FALSE;
+	}
+
+	*context = trace_thread->context;
+
+	return TRUE;
+}
+
+/**
+ * Sets the current thread's trace context.
+ * Spans entered afterwards become children of the context's span, which usually belongs to another process.
+ *
+ * \code
+ * j_trace_context_set(&context);
+ * ...
+ * j_trace_context_set(NULL);
+ * \endcode
+ *
+ * \param context A trace context, NULL to leave the trace.
+ **/
+void
+j_trace_context_set(JTraceContext const* context)
+{
+	JTraceThread* trace_thread;
+
+	if (!(j_trace_flags & J_TRACE_OTLP))
+	{
+		return;
+	}
+
+	trace_thread = j_trace_thread_get_default();
+
+	if (context != NULL)
+	{
+		trace_thread->context = *context;
+		trace_thread->context_valid = TRUE;
+		trace_thread->context_remote = TRUE;
+	}
+	else
+	{
+		trace_thread->context_valid = FALSE;
+		trace_thread->context_remote = FALSE;
+	}
+}
+
 /**
  * @}
  **/
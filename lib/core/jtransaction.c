@@ -0,0 +1,304 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <jtransaction.h>
+#include <jtransaction-internal.h>
+
+#include <jconnection-pool.h>
+#include <jmessage.h>
+#include <jsemantics.h>
+#include <jtrace.h>
+
+/**
+ * \defgroup JTransaction Transaction
+ *
+ * Transactions make batches with J_SEMANTICS_ATOMICITY_BATCH atomic across servers.
+ *
+ * This is a lightweight two-phase commit with the client as its coordinator:
+ * Modules stage a batch's modifications on the servers using the transaction's ID, the servers' replies act as their votes.
+ * When the batch has been executed, all participants are told to either commit or abort their staged operations.
+ * The coordinator does not log its decision, a client failing between both phases leaves the staged operations to expire on the servers.
+ *
+ * @{
+ **/
+
+/**
+ * A server taking part in a transaction.
+ **/
+struct JTransactionParticipant
+{
+	JBackendType type;
+	guint32 index;
+};
+
+typedef struct JTransactionParticipant JTransactionParticipant;
+
+/**
+ * A transaction.
+ **/
+struct JTransaction
+{
+	/**
+	 * The ID, unique across clients.
+	 **/
+	guint64 id;
+
+	/**
+	 * The participating servers.
+	 **/
+	GArray* participants;
+
+	/**
+	 * Whether all participants have agreed so far.
+	 **/
+	gboolean commit;
+};
+
+static GPrivate j_transaction_current;
+
+/**
+ * Creates a new transaction.
+ *
+ * \private
+ *
+ * \return A new transaction. Should be freed with j_transaction_free().
+ **/
+JTransaction*
+j_transaction_new(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JTransaction* transaction;
+
+	transaction = g_slice_new(JTransaction);
+
+	// 0 marks messages that do not belong to a transaction.
+	do
+	{
+		transaction->id = ((guint64)g_random_int() << 32) | g_random_int();
+	} while (transaction->id == 0);
+
+	transaction->participants = g_array_new(FALSE, FALSE, sizeof(JTransactionParticipant));
+	transaction->commit = TRUE;
+
+	return transaction;
+}
+
+/**
+ * Frees the memory allocated for a transaction.
+ *
+ * \private
+ *
+ * \param transaction A transaction.
+ **/
+void
+j_transaction_free(JTransaction* transaction)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(transaction != NULL);
+
+	g_array_unref(transaction->participants);
+
+	g_slice_free(JTransaction, transaction);
+}
+
+/**
+ * Sets the transaction that operations executed by the current thread belong to.
+ *
+ * \private
+ *
+ * \param transaction A transaction, or NULL.
+ *
+ * \return The previous transaction, or NULL.
+ **/
+JTransaction*
+j_transaction_set_current(JTransaction* transaction)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JTransaction* previous;
+
+	previous = g_private_get(&j_transaction_current);
+	g_private_set(&j_transaction_current, transaction);
+
+	return previous;
+}
+
+/**
+ * Returns the transaction that operations executed by the current thread belong to.
+ *
+ * \code
+ * \endcode
+ *
+ * \return A transaction, or NULL if the current batch is not atomic.
+ **/
+JTransaction*
+j_transaction_get_current(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return g_private_get(&j_transaction_current);
+}
+
+/**
+ * Returns a transaction's ID.
+ *
+ * \code
+ * \endcode
+ *
+ * \param transaction A transaction, or NULL.
+ *
+ * \return The ID, 0 if transaction is NULL.
+ **/
+guint64
+j_transaction_get_id(JTransaction* transaction)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (transaction == NULL)
+	{
+		return 0;
+	}
+
+	return transaction->id;
+}
+
+/**
+ * Registers a server that has staged operations for a transaction.
+ *
+ * \code
+ * \endcode
+ *
+ * \param transaction A transaction.
+ * \param type        A backend type.
+ * \param index       A server index.
+ **/
+void
+j_transaction_add_participant(JTransaction* transaction, JBackendType type, guint32 index)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JTransactionParticipant participant;
+
+	g_return_if_fail(transaction != NULL);
+
+	for (guint i = 0; i < transaction->participants->len; i++)
+	{
+		JTransactionParticipant* existing = &g_array_index(transaction->participants, JTransactionParticipant, i);
+
+		if (existing->type == type && existing->index == index)
+		{
+			return;
+		}
+	}
+
+	participant.type = type;
+	participant.index = index;
+
+	g_array_append_val(transaction->participants, participant);
+}
+
+/**
+ * Records whether a participant is able to commit a transaction.
+ * A single negative vote aborts the whole transaction.
+ *
+ * \code
+ * \endcode
+ *
+ * \param transaction A transaction.
+ * \param commit      Whether the participant is able to commit.
+ **/
+void
+j_transaction_vote(JTransaction* transaction, gboolean commit)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(transaction != NULL);
+
+	if (!commit)
+	{
+		transaction->commit = FALSE;
+	}
+}
+
+/**
+ * Commits or aborts a transaction on all participants.
+ *
+ * \private
+ *
+ * \param transaction A transaction.
+ * \param semantics   The batch's semantics.
+ * \param ret         Whether the batch's operations have succeeded.
+ *
+ * \return TRUE if the transaction has been committed, FALSE otherwise.
+ **/
+gboolean
+j_transaction_finish(JTransaction* transaction, JSemantics* semantics, gboolean ret)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessageType type;
+	gboolean commit;
+
+	g_return_val_if_fail(transaction != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	commit = (ret && transaction->commit);
+	type = (commit) ? J_MESSAGE_TRANSACTION_COMMIT : J_MESSAGE_TRANSACTION_ABORT;
+
+	for (guint i = 0; i < transaction->participants->len; i++)
+	{
+		JTransactionParticipant* participant = &g_array_index(transaction->participants, JTransactionParticipant, i);
+		g_autoptr(JMessage) message = NULL;
+		g_autoptr(JMessage) reply = NULL;
+		gpointer connection;
+
+		message = j_message_new(type, 8);
+		j_message_set_semantics(message, semantics);
+		j_message_add_operation(message, 8);
+		j_message_append_8(message, &(transaction->id));
+
+		connection = j_connection_pool_pop(participant->type, participant->index);
+		j_message_send(message, connection);
+
+		// Always wait for the outcome, a later batch might depend on it.
+		reply = j_message_new_reply(message);
+
+		if (!j_message_receive(reply, connection) || j_message_get_count(reply) == 0 || j_message_get_4(reply) == 0)
+		{
+			commit = FALSE;
+		}
+
+		j_connection_pool_push(participant->type, participant->index, connection);
+	}
+
+	return commit;
+}
+
+/**
+ * @}
+ **/
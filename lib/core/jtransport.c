@@ -0,0 +1,452 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <gio/gunixsocketaddress.h>
+
+#include <sys/socket.h>
+
+#include <jtransport.h>
+
+#include <jconfiguration.h>
+#include <jhelper.h>
+#include <jtrace.h>
+
+/**
+ * \defgroup JTransport Transport
+ *
+ * Transports establish the connections used by clients and servers.
+ * Once a connection has been established, messages are exchanged using
+ * j_message_send() and j_message_receive() independent of the transport.
+ *
+ * Transports only cover connection setup, all of them have to provide a
+ * GSocketConnection. Message-level transports that move payloads without
+ * a socket, such as RDMA via libfabric or UCX, are not supported.
+ *
+ * @{
+ **/
+
+/**
+ * A transport.
+ **/
+struct JTransport
+{
+	/**
+	 * The transport's name.
+	 **/
+	gchar const* name;
+
+	/**
+	 * Checks whether the transport can be used to reach a server.
+	 **/
+	gboolean (*usable)(gchar const*);
+
+	/**
+	 * Connects to a server.
+	 **/
+	GSocketConnection* (*connect)(gchar const*, GError**);
+
+	/**
+	 * Listens for incoming connections.
+	 **/
+	gboolean (*listen)(GSocketListener*, gchar const*, guint16, GError**);
+
+	/**
+	 * Whether several listeners can listen on the same port, the kernel distributes connections among them.
+	 **/
+	gboolean shared;
+};
+
+typedef struct JTransport JTransport;
+
+static gboolean
+j_transport_tcp_usable(gchar const* server)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	(void)server;
+
+	return TRUE;
+}
+
+static GSocketConnection*
+j_transport_tcp_connect(gchar const* server, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GSocketClient) client = NULL;
+	g_autoptr(GSocketConnectable) address = NULL;
+	GSocketConnection* connection;
+	JConfiguration* configuration;
+
+	client = g_socket_client_new();
+	configuration = j_configuration();
+
+	// Use a pre-resolved address if available, this avoids a DNS lookup per connection.
+	if (configuration != NULL && (address = g_network_address_parse(server, 4711, NULL)) != NULL)
+	{
+		gchar const* resolved;
+
+		resolved = j_configuration_get_server_address(configuration, g_network_address_get_hostname(G_NETWORK_ADDRESS(address)));
+
+		if (resolved != NULL)
+		{
+			g_autoptr(GInetAddress) inet_address = NULL;
+
+			if ((inet_address = g_inet_address_new_from_string(resolved)) != NULL)
+			{
+				g_autoptr(GSocketAddress) socket_address = NULL;
+
+				socket_address = g_inet_socket_address_new(inet_address, g_network_address_get_port(G_NETWORK_ADDRESS(address)));
+				connection = g_socket_client_connect(client, G_SOCKET_CONNECTABLE(socket_address), NULL, error);
+
+				goto end;
+			}
+		}
+	}
+
+	connection = g_socket_client_connect_to_host(client, server, 4711, NULL, error);
+
+end:
+	if (connection != NULL)
+	{
+		j_helper_set_nodelay(connection, TRUE);
+	}
+
+	return connection;
+}
+
+static gboolean
+j_transport_tcp_listen(GSocketListener* listener, gchar const* host, guint16 port, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+#ifdef SO_REUSEPORT
+	g_autoptr(GSocket) socket_ = NULL;
+	g_autoptr(GInetAddress) inet_address = NULL;
+	g_autoptr(GSocketAddress) address = NULL;
+	GSocketFamily family = G_SOCKET_FAMILY_IPV6;
+	gint backlog;
+
+	(void)host;
+
+	// IPv6 sockets also accept IPv4 connections, IPv4 is only used if IPv6 is not available.
+	if ((socket_ = g_socket_new(family, G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_DEFAULT, NULL)) == NULL)
+	{
+		family = G_SOCKET_FAMILY_IPV4;
+
+		if ((socket_ = g_socket_new(family, G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_DEFAULT, error)) == NULL)
+		{
+			return FALSE;
+		}
+	}
+
+	// Allows listeners on several threads to share the port.
+	// A second server is still refused since the Unix transport cannot be shared.
+	if (!g_socket_set_option(socket_, SOL_SOCKET, SO_REUSEPORT, 1, error))
+	{
+		return FALSE;
+	}
+
+	inet_address = g_inet_address_new_any(family);
+	address = g_inet_socket_address_new(inet_address, port);
+
+	g_object_get(listener, "listen-backlog", &backlog, NULL);
+	g_socket_set_listen_backlog(socket_, backlog);
+
+	if (!g_socket_bind(socket_, address, TRUE, error) || !g_socket_listen(socket_, error))
+	{
+		return FALSE;
+	}
+
+	if (!g_socket_listener_add_socket(listener, socket_, NULL, error))
+	{
+		return FALSE;
+	}
+
+	// Sockets added directly do not emit the event, unlike the ones created by the listener.
+	g_signal_emit_by_name(listener, "event", G_SOCKET_LISTENER_LISTENED, socket_);
+
+	return TRUE;
+#else
+	(void)host;
+
+	return g_socket_listener_add_inet_port(listener, port, NULL, error);
+#endif
+}
+
+/**
+ * Returns the abstract socket address used by the Unix transport.
+ *
+ * \private
+ *
+ * \param port A port.
+ *
+ * \return A new socket address. Should be freed with g_object_unref().
+ **/
+static GSocketAddress*
+j_transport_unix_address(guint16 port)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* name = NULL;
+
+	name = g_strdup_printf("julea-server-%u", port);
+
+	return g_unix_socket_address_new_with_type(name, -1, G_UNIX_SOCKET_ADDRESS_ABSTRACT);
+}
+
+/**
+ * Checks whether a server is running on the local node.
+ * In this case, the Unix transport can be used to bypass the TCP stack.
+ *
+ * \private
+ **/
+static gboolean
+j_transport_unix_usable(gchar const* server)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GSocketConnectable) address = NULL;
+	gchar const* hostname;
+
+	address = g_network_address_parse(server, 4711, NULL);
+
+	if (address == NULL)
+	{
+		return FALSE;
+	}
+
+	hostname = g_network_address_get_hostname(G_NETWORK_ADDRESS(address));
+
+	return (g_strcmp0(hostname, g_get_host_name()) == 0
+		|| g_strcmp0(hostname, "localhost") == 0
+		|| g_strcmp0(hostname, "127.0.0.1") == 0
+		|| g_strcmp0(hostname, "::1") == 0);
+}
+
+static GSocketConnection*
+j_transport_unix_connect(gchar const* server, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GSocketClient) client = NULL;
+	g_autoptr(GSocketConnectable) address = NULL;
+	g_autoptr(GSocketAddress) unix_address = NULL;
+
+	address = g_network_address_parse(server, 4711, error);
+
+	if (address == NULL)
+	{
+		return NULL;
+	}
+
+	unix_address = j_transport_unix_address(g_network_address_get_port(G_NETWORK_ADDRESS(address)));
+
+	client = g_socket_client_new();
+	g_socket_client_set_family(client, G_SOCKET_FAMILY_UNIX);
+
+	return g_socket_client_connect(client, G_SOCKET_CONNECTABLE(unix_address), NULL, error);
+}
+
+static gboolean
+j_transport_unix_listen(GSocketListener* listener, gchar const* host, guint16 port, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GSocketAddress) address = NULL;
+
+	(void)host;
+
+	address = j_transport_unix_address(port);
+
+	return g_socket_listener_add_address(listener, address, G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_DEFAULT, NULL, NULL, error);
+}
+
+/**
+ * The available transports, in order of preference.
+ * The Unix transport is only usable for local servers, so all other
+ * connections fall through to TCP.
+ **/
+static JTransport const j_transports[] = {
+	{
+		.name = "unix",
+		.usable = j_transport_unix_usable,
+		.connect = j_transport_unix_connect,
+		.listen = j_transport_unix_listen,
+		.shared = FALSE,
+	},
+	{
+		.name = "tcp",
+		.usable = j_transport_tcp_usable,
+		.connect = j_transport_tcp_connect,
+		.listen = j_transport_tcp_listen,
+#ifdef SO_REUSEPORT
+		.shared = TRUE,
+#else
+		.shared = FALSE,
+#endif
+	},
+};
+
+/**
+ * Connects to a server using the most preferable usable transport.
+ * Local servers are reached via the Unix transport, all others via TCP.
+ *
+ * \code
+ * GSocketConnection* connection;
+ *
+ * connection = j_transport_connect("localhost:4711", NULL);
+ * \endcode
+ *
+ * \param server A server, optionally including a port.
+ * \param error  A return location for a GError, or NULL.
+ *
+ * \return A connection on success, NULL if an error occurred.
+ **/
+gpointer
+j_transport_connect(gchar const* server, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GError* local_error = NULL;
+
+	g_return_val_if_fail(server != NULL, NULL);
+
+	for (guint i = 0; i < G_N_ELEMENTS(j_transports); i++)
+	{
+		JTransport const* transport = &(j_transports[i]);
+		GSocketConnection* connection;
+
+		if (!transport->usable(server))
+		{
+			continue;
+		}
+
+		g_clear_error(&local_error);
+		connection = transport->connect(server, &local_error);
+
+		if (connection != NULL)
+		{
+			g_debug("Connected to %s using transport %s.", server, transport->name);
+			return connection;
+		}
+	}
+
+	if (local_error != NULL)
+	{
+		g_propagate_error(error, local_error);
+	}
+	else
+	{
+		g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "No transport can connect to %s", server);
+	}
+
+	return NULL;
+}
+
+/**
+ * Makes a listener accept connections on all available transports.
+ *
+ * \code
+ * \endcode
+ *
+ * \param listener A GSocketListener.
+ * \param host     The host name the server is running on.
+ * \param port     A port.
+ * \param error    A return location for a GError, or NULL.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+gboolean
+j_transport_listen(gpointer listener, gchar const* host, guint16 port, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(listener != NULL, FALSE);
+	g_return_val_if_fail(host != NULL, FALSE);
+
+	for (guint i = 0; i < G_N_ELEMENTS(j_transports); i++)
+	{
+		if (!j_transports[i].listen(G_SOCKET_LISTENER(listener), host, port, error))
+		{
+			// Drop the transports set up so far, allowing callers to retry.
+			g_socket_listener_close(G_SOCKET_LISTENER(listener));
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Makes an additional listener accept connections on the transports that can be shared.
+ * The listener has to be set up after a listener using j_transport_listen() on the same port.
+ * Connections are distributed among all listeners by the kernel.
+ *
+ * \param listener A GSocketListener.
+ * \param host     The host name the server is running on.
+ * \param port     A port.
+ * \param error    A return location for a GError, or NULL.
+ *
+ * \return TRUE on success, FALSE if an error occurred or no transport can be shared.
+ **/
+gboolean
+j_transport_listen_shared(gpointer listener, gchar const* host, guint16 port, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean listening = FALSE;
+
+	g_return_val_if_fail(listener != NULL, FALSE);
+	g_return_val_if_fail(host != NULL, FALSE);
+
+	for (guint i = 0; i < G_N_ELEMENTS(j_transports); i++)
+	{
+		if (!j_transports[i].shared)
+		{
+			continue;
+		}
+
+		if (!j_transports[i].listen(G_SOCKET_LISTENER(listener), host, port, error))
+		{
+			g_socket_listener_close(G_SOCKET_LISTENER(listener));
+			return FALSE;
+		}
+
+		listening = TRUE;
+	}
+
+	if (!listening)
+	{
+		g_set_error(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "No transport can be shared");
+	}
+
+	return listening;
+}
+
+/**
+ * @}
+ **/
@@ -0,0 +1,357 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2019 Benjamin Warnke
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <bson.h>
+
+#include <julea.h>
+#include <db/jdb-internal.h>
+#include <julea-db.h>
+#include "../../backend/db/jbson.c"
+
+JDBAggregate*
+j_db_aggregate_new(JDBSchema* schema, JDBSelector* selector, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBAggregate* aggregate;
+
+	g_return_val_if_fail(schema != NULL, NULL);
+	g_return_val_if_fail((selector == NULL) || (selector->schema == schema), NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+	aggregate = g_slice_new(JDBAggregate);
+	aggregate->schema = j_db_schema_ref(schema);
+	aggregate->selector = (selector != NULL) ? j_db_selector_ref(selector) : NULL;
+	bson_init(&aggregate->group);
+	bson_init(&aggregate->functions);
+	bson_init(&aggregate->bson);
+	aggregate->group_count = 0;
+	aggregate->function_count = 0;
+	aggregate->types = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	aggregate->page = NULL;
+	aggregate->row = 0;
+	aggregate->ref_count = 1;
+	aggregate->executed = FALSE;
+	aggregate->initialized = FALSE;
+	aggregate->row_valid = FALSE;
+
+	return aggregate;
+}
+
+JDBAggregate*
+j_db_aggregate_ref(JDBAggregate* aggregate)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(aggregate != NULL, NULL);
+
+	g_atomic_int_inc(&aggregate->ref_count);
+
+	return aggregate;
+}
+
+void
+j_db_aggregate_unref(JDBAggregate* aggregate)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (aggregate && g_atomic_int_dec_and_test(&aggregate->ref_count))
+	{
+		j_db_internal_aggregate_free(aggregate);
+
+		j_db_schema_unref(aggregate->schema);
+
+		if (aggregate->selector)
+		{
+			j_db_selector_unref(aggregate->selector);
+		}
+
+		bson_destroy(&aggregate->group);
+		bson_destroy(&aggregate->functions);
+		bson_destroy(&aggregate->bson);
+		g_hash_table_unref(aggregate->types);
+
+		g_slice_free(JDBAggregate, aggregate);
+	}
+}
+
+gboolean
+j_db_aggregate_add(JDBAggregate* aggregate, gchar const* name, JDBAggregateFunction function, gchar const* field, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBType field_type = J_DB_TYPE_UINT32;
+	JDBType type;
+	JDBTypeValue val;
+	bson_t bson;
+	char buf[16];
+	const char* key;
+
+	g_return_val_if_fail(aggregate != NULL, FALSE);
+	g_return_val_if_fail(!aggregate->executed, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(field != NULL || function == J_DB_AGGREGATE_FUNCTION_COUNT, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (G_UNLIKELY(g_hash_table_contains(aggregate->types, name)))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_VARIABLE_ALREADY_SET, "variable value must not be set more than once");
+		goto _error;
+	}
+
+	if (field != NULL && G_UNLIKELY(!j_db_schema_get_field(aggregate->schema, field, &field_type, error)))
+	{
+		goto _error;
+	}
+
+	if (function != J_DB_AGGREGATE_FUNCTION_COUNT && G_UNLIKELY(field_type == J_DB_TYPE_STRING || field_type == J_DB_TYPE_BLOB))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_TYPE_INVALID, "aggregate functions require numeric fields");
+		goto _error;
+	}
+
+	switch (function)
+	{
+		case J_DB_AGGREGATE_FUNCTION_COUNT:
+			type = J_DB_TYPE_UINT64;
+			break;
+		case J_DB_AGGREGATE_FUNCTION_SUM:
+			switch (field_type)
+			{
+				case J_DB_TYPE_SINT32:
+				case J_DB_TYPE_SINT64:
+					type = J_DB_TYPE_SINT64;
+					break;
+				case J_DB_TYPE_UINT32:
+				case J_DB_TYPE_UINT64:
+					type = J_DB_TYPE_UINT64;
+					break;
+				default:
+					type = J_DB_TYPE_FLOAT64;
+					break;
+			}
+			break;
+		case J_DB_AGGREGATE_FUNCTION_MIN:
+		case J_DB_AGGREGATE_FUNCTION_MAX:
+			type = field_type;
+			break;
+		case J_DB_AGGREGATE_FUNCTION_AVG:
+			type = J_DB_TYPE_FLOAT64;
+			break;
+		default:
+			g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_OPERATOR_INVALID, "aggregate function invalid");
+			goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_array_generate_key(aggregate->function_count, &key, buf, sizeof(buf), error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_append_document_begin(&aggregate->functions, key, &bson, error)))
+	{
+		goto _error;
+	}
+
+	val.val_string = name;
+
+	if (G_UNLIKELY(!j_bson_append_value(&bson, "_name", J_DB_TYPE_STRING, &val, error)))
+	{
+		goto _error;
+	}
+
+	val.val_uint32 = function;
+
+	if (G_UNLIKELY(!j_bson_append_value(&bson, "_function", J_DB_TYPE_UINT32, &val, error)))
+	{
+		goto _error;
+	}
+
+	if (field != NULL)
+	{
+		val.val_string = field;
+
+		if (G_UNLIKELY(!j_bson_append_value(&bson, "_field", J_DB_TYPE_STRING, &val, error)))
+		{
+			goto _error;
+		}
+	}
+
+	val.val_uint32 = type;
+
+	if (G_UNLIKELY(!j_bson_append_value(&bson, "_type", J_DB_TYPE_UINT32, &val, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_append_document_end(&aggregate->functions, &bson, error)))
+	{
+		goto _error;
+	}
+
+	g_hash_table_insert(aggregate->types, g_strdup(name), GINT_TO_POINTER(type));
+	aggregate->function_count++;
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+gboolean
+j_db_aggregate_group_by(JDBAggregate* aggregate, gchar const* field, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBType type;
+	JDBTypeValue val;
+	char buf[16];
+	const char* key;
+
+	g_return_val_if_fail(aggregate != NULL, FALSE);
+	g_return_val_if_fail(!aggregate->executed, FALSE);
+	g_return_val_if_fail(field != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (G_UNLIKELY(g_hash_table_contains(aggregate->types, field)))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_VARIABLE_ALREADY_SET, "variable value must not be set more than once");
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_db_schema_get_field(aggregate->schema, field, &type, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(type == J_DB_TYPE_BLOB))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_TYPE_INVALID, "blobs can not be grouped by");
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_array_generate_key(aggregate->group_count, &key, buf, sizeof(buf), error)))
+	{
+		goto _error;
+	}
+
+	val.val_string = field;
+
+	if (G_UNLIKELY(!j_bson_append_value(&aggregate->group, key, J_DB_TYPE_STRING, &val, error)))
+	{
+		goto _error;
+	}
+
+	g_hash_table_insert(aggregate->types, g_strdup(field), GINT_TO_POINTER(type));
+	aggregate->group_count++;
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+gboolean
+j_db_aggregate_execute(JDBAggregate* aggregate, JBatch* batch, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(aggregate != NULL, FALSE);
+	g_return_val_if_fail(!aggregate->executed, FALSE);
+	g_return_val_if_fail(aggregate->function_count > 0, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (G_UNLIKELY(!j_bson_append_array(&aggregate->bson, "_group", &aggregate->group, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_append_array(&aggregate->bson, "_functions", &aggregate->functions, error)))
+	{
+		goto _error;
+	}
+
+	aggregate->executed = TRUE;
+
+	return j_db_internal_aggregate(aggregate, batch, error);
+
+_error:
+	return FALSE;
+}
+
+gboolean
+j_db_aggregate_next(JDBAggregate* aggregate, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(aggregate != NULL, FALSE);
+	g_return_val_if_fail(aggregate->executed, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	aggregate->row_valid = j_db_internal_aggregate_next(aggregate, error);
+
+	return aggregate->row_valid;
+}
+
+gboolean
+j_db_aggregate_get_field(JDBAggregate* aggregate, gchar const* name, JDBType* type, gpointer* value, guint64* length, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBTypeValue val;
+	gpointer type_tmp;
+
+	g_return_val_if_fail(aggregate != NULL, FALSE);
+	g_return_val_if_fail(aggregate->row_valid, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(type != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+	g_return_val_if_fail(length != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (G_UNLIKELY(!g_hash_table_lookup_extended(aggregate->types, name, NULL, &type_tmp)))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+		goto _error;
+	}
+
+	*type = GPOINTER_TO_INT(type_tmp);
+
+	if (G_UNLIKELY(!j_db_internal_aggregate_get_value(aggregate, name, *type, &val, error)))
+	{
+		goto _error;
+	}
+
+	j_db_internal_value_copy(*type, &val, value, length);
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
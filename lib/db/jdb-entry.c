@@ -171,6 +171,49 @@ _error:
 	return FALSE;
 }
 
+gboolean
+j_db_entry_set_array_field(JDBEntry* entry, gchar const* name, gconstpointer values, guint32 length, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBType type;
+	gsize size;
+	guint32 schema_length;
+
+	g_return_val_if_fail(entry != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(values != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (G_UNLIKELY(!j_db_schema_get_array_field(entry->schema, name, &type, &schema_length, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(length != schema_length || (size = j_db_type_get_element_size(type)) == 0))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_TYPE_INVALID, "type invalid");
+		goto _error;
+	}
+
+	for (guint32 i = 0; i < length; i++)
+	{
+		g_autofree gchar* element = NULL;
+
+		element = j_db_array_element_name(name, i);
+
+		if (G_UNLIKELY(!j_db_entry_set_field(entry, element, (gchar const*)values + i * size, size, error)))
+		{
+			goto _error;
+		}
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
 gboolean
 j_db_entry_insert(JDBEntry* entry, JBatch* batch, GError** error)
 {
@@ -34,11 +34,41 @@
 #include <julea.h>
 #include "../../backend/db/jbson.c"
 
-struct JDBIteratorHelper
+struct JDBIteratorPage
 {
 	bson_t bson;
-	bson_iter_t iter;
+
+	// Restricts the query to entries following the previous page, NULL for the first page
+	bson_t* selector;
+
+	// Only set for pages that are fetched in the background
+	JBatch* batch;
+	GError* error;
+	gboolean ret;
+
+	// Decoded header of the packed rows, see J_BACKEND_OPERATION_DB_QUERY_PAGE_SIZE
+	// Maps column names to their index + 1, the names point into bson
+	GHashTable* columns;
+	bson_type_t* types;
+	guint32* offsets;
+	guint32 count;
+	guint32 row_size;
+	guint8 const* rows;
+	guint8 const* heap;
+	guint32 heap_length;
+};
+
+typedef struct JDBIteratorPage JDBIteratorPage;
+
+struct JDBIteratorHelper
+{
+	JDBIteratorPage* page;
+	// Index of the current row, only valid if initialized is set
+	guint32 row;
 	gboolean initialized;
+
+	// The next page is fetched while the current one is being processed
+	JDBIteratorPage* next;
 };
 
 typedef struct JDBIteratorHelper JDBIteratorHelper;
@@ -51,6 +81,28 @@ j_db_error_quark(void)
 	return g_quark_from_static_string("j-db-error-quark");
 }
 
+/**
+ * Returns the DB server responsible for a schema.
+ * Schemas are placed by hashing their namespace and name, so that all DB servers are used.
+ *
+ * \private
+ *
+ * \param data A backend operation, its first parameters have to be the namespace and name.
+ *
+ * \return A server index.
+ **/
+static guint32
+j_backend_db_get_server(JBackendOperation const* data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* key = NULL;
+
+	key = g_strdup_printf("%s/%s", (gchar const*)data->in_param[0].ptr_const, (gchar const*)data->in_param[1].ptr_const);
+
+	return j_configuration_get_server_for_key(j_configuration(), J_BACKEND_TYPE_DB, key);
+}
+
 static gboolean
 j_backend_db_func_exec(JList* operations, JSemantics* semantics, JMessageType type)
 {
@@ -58,18 +110,19 @@ j_backend_db_func_exec(JList* operations, JSemantics* semantics, JMessageType ty
 
 	JBackendOperation* data = NULL;
 	gboolean ret = TRUE;
-	GSocketConnection* db_connection;
 	g_autoptr(JListIterator) iter_send = NULL;
-	g_autoptr(JListIterator) iter_recieve = NULL;
-	g_autoptr(JMessage) message = NULL;
-	g_autoptr(JMessage) reply = NULL;
+	g_autofree JMessage** messages = NULL;
+	g_autofree JList** server_operations = NULL;
 	JBackend* db_backend = j_db_get_backend();
 	gpointer batch = NULL;
 	GError* error = NULL;
+	guint32 server_count = 0;
 
 	if (db_backend == NULL)
 	{
-		message = j_message_new(type, 0);
+		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_DB);
+		messages = g_new0(JMessage*, server_count);
+		server_operations = g_new0(JList*, server_count);
 	}
 
 	iter_send = j_list_iterator_new(operations);
@@ -80,7 +133,18 @@ j_backend_db_func_exec(JList* operations, JSemantics* semantics, JMessageType ty
 
 		if (db_backend == NULL)
 		{
-			ret = j_backend_operation_to_message(message, data->in_param, data->in_param_count) && ret;
+			guint32 index;
+
+			index = j_backend_db_get_server(data);
+
+			if (messages[index] == NULL)
+			{
+				messages[index] = j_message_new(type, 0);
+				server_operations[index] = j_list_new(NULL);
+			}
+
+			ret = j_backend_operation_to_message(messages[index], data->in_param, data->in_param_count) && ret;
+			j_list_append(server_operations[index], data);
 		}
 		else
 		{
@@ -102,19 +166,87 @@ j_backend_db_func_exec(JList* operations, JSemantics* semantics, JMessageType ty
 
 	if (db_backend == NULL)
 	{
-		db_connection = j_connection_pool_pop(J_BACKEND_TYPE_DB, 0);
-		j_message_send(message, db_connection);
-		reply = j_message_new_reply(message);
-		j_message_receive(reply, db_connection);
-		iter_recieve = j_list_iterator_new(operations);
+		g_autofree GSocketConnection** db_connections = NULL;
+		g_autofree gboolean* sent = NULL;
+		g_autofree guint32* read_servers = NULL;
+		gboolean idempotent;
+		gboolean replicated;
+
+		// Only requests without side effects can be repeated safely
+		idempotent = (type == J_MESSAGE_DB_SCHEMA_GET || type == J_MESSAGE_DB_QUERY || type == J_MESSAGE_DB_AGGREGATE);
+
+		// Replicas might lag behind, so only reads that do not have to see the latest changes may use them.
+		replicated = idempotent && (j_semantics_get(semantics, J_SEMANTICS_CONSISTENCY) == J_SEMANTICS_CONSISTENCY_EVENTUAL || j_semantics_get(semantics, J_SEMANTICS_CONSISTENCY) == J_SEMANTICS_CONSISTENCY_NONE);
 
-		while (j_list_iterator_next(iter_recieve))
+		db_connections = g_new0(GSocketConnection*, server_count);
+		sent = g_new0(gboolean, server_count);
+		read_servers = g_new0(guint32, server_count);
+
+		// Messages for different servers are sent before any reply is received, so the servers work in parallel.
+		for (guint32 i = 0; i < server_count; i++)
 		{
-			data = j_list_iterator_get(iter_recieve);
-			ret = j_backend_operation_from_message(reply, data->out_param, data->out_param_count) && ret;
+			if (messages[i] == NULL)
+			{
+				continue;
+			}
+
+			read_servers[i] = (replicated) ? j_connection_pool_get_read_index(J_BACKEND_TYPE_DB, i) : i;
+			db_connections[i] = j_connection_pool_pop(J_BACKEND_TYPE_DB, read_servers[i]);
+			sent[i] = (db_connections[i] != NULL && j_message_send(messages[i], db_connections[i]));
 		}
 
-		j_connection_pool_push(J_BACKEND_TYPE_DB, 0, db_connection);
+		for (guint32 i = 0; i < server_count; i++)
+		{
+			g_autoptr(JListIterator) iter_recieve = NULL;
+			g_autoptr(JMessage) reply = NULL;
+			gboolean received;
+
+			if (messages[i] == NULL)
+			{
+				continue;
+			}
+
+			reply = j_message_new_reply(messages[i]);
+			received = sent[i] && j_message_receive(reply, db_connections[i]);
+
+			if (received)
+			{
+				j_connection_pool_push(J_BACKEND_TYPE_DB, read_servers[i], db_connections[i]);
+			}
+			else
+			{
+				if (db_connections[i] != NULL)
+				{
+					j_connection_pool_discard(J_BACKEND_TYPE_DB, read_servers[i], db_connections[i]);
+				}
+
+				received = idempotent && j_connection_pool_retry(J_BACKEND_TYPE_DB, read_servers[i], messages[i], reply);
+
+				// Fall back to the server if its replica is unreachable.
+				if (!received && read_servers[i] != i)
+				{
+					received = j_connection_pool_exchange(J_BACKEND_TYPE_DB, i, messages[i], reply);
+				}
+			}
+
+			if (received)
+			{
+				iter_recieve = j_list_iterator_new(server_operations[i]);
+
+				while (j_list_iterator_next(iter_recieve))
+				{
+					data = j_list_iterator_get(iter_recieve);
+					ret = j_backend_operation_from_message(reply, data->out_param, data->out_param_count) && ret;
+				}
+			}
+			else
+			{
+				ret = FALSE;
+			}
+
+			j_message_unref(messages[i]);
+			j_list_unref(server_operations[i]);
+		}
 	}
 	else
 	{
@@ -155,12 +287,47 @@ j_backend_db_func_free(gpointer _data)
 	}
 }
 
+/**
+ * Adds the schemas of successful operations to the schema cache.
+ * The schema is the first value unreferenced by each operation.
+ *
+ * \private
+ *
+ * \param operations The operations.
+ **/
+static void
+j_db_schema_cache_insert_all(JList* operations)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JListIterator) iter = NULL;
+
+	iter = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(iter))
+	{
+		JBackendOperation* data = j_list_iterator_get(iter);
+
+		j_db_schema_cache_insert(data->unref_values[0]);
+	}
+}
+
 static gboolean
 j_db_schema_create_exec(JList* operations, JSemantics* semantics)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	return j_backend_db_func_exec(operations, semantics, J_MESSAGE_DB_SCHEMA_CREATE);
+	gboolean ret;
+
+	ret = j_backend_db_func_exec(operations, semantics, J_MESSAGE_DB_SCHEMA_CREATE);
+
+	// Errors are not reported per operation, so nothing is cached if one of them failed
+	if (ret)
+	{
+		j_db_schema_cache_insert_all(operations);
+	}
+
+	return ret;
 }
 
 gboolean
@@ -200,7 +367,27 @@ j_db_schema_get_exec(JList* operations, JSemantics* semantics)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	return j_backend_db_func_exec(operations, semantics, J_MESSAGE_DB_SCHEMA_GET);
+	gboolean ret;
+
+	ret = j_backend_db_func_exec(operations, semantics, J_MESSAGE_DB_SCHEMA_GET);
+
+	if (ret)
+	{
+		j_db_schema_cache_insert_all(operations);
+	}
+
+	return ret;
+}
+
+static gboolean
+j_db_schema_get_cached_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	(void)operations;
+	(void)semantics;
+
+	return TRUE;
 }
 
 gboolean
@@ -230,6 +417,12 @@ j_db_internal_schema_get(JDBSchema* j_db_schema, JBatch* batch, GError** error)
 	op->exec_func = j_db_schema_get_exec;
 	op->free_func = j_backend_db_func_free;
 
+	// A cached schema has already been copied, the operation only keeps the batch's result intact
+	if (j_db_schema_cache_lookup(j_db_schema, j_batch_get_semantics(batch)))
+	{
+		op->exec_func = j_db_schema_get_cached_exec;
+	}
+
 	j_batch_add(batch, op);
 
 	return TRUE;
@@ -240,7 +433,22 @@ j_db_schema_delete_exec(JList* operations, JSemantics* semantics)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	return j_backend_db_func_exec(operations, semantics, J_MESSAGE_DB_SCHEMA_DELETE);
+	g_autoptr(JListIterator) iter = NULL;
+	gboolean ret;
+
+	ret = j_backend_db_func_exec(operations, semantics, J_MESSAGE_DB_SCHEMA_DELETE);
+
+	// Schemas fetched while the deletion was in progress are dropped again
+	iter = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(iter))
+	{
+		JBackendOperation* data = j_list_iterator_get(iter);
+
+		j_db_schema_cache_remove(data->unref_values[0]);
+	}
+
+	return ret;
 }
 
 gboolean
@@ -408,103 +616,947 @@ j_db_query_exec(JList* operations, JSemantics* semantics)
 	return j_backend_db_func_exec(operations, semantics, J_MESSAGE_DB_QUERY);
 }
 
-gboolean
-j_db_internal_query(JDBSchema* j_db_schema, JDBSelector* j_db_selector, JDBIterator* j_db_iterator, JBatch* batch, GError** error)
+static JDBIteratorPage*
+j_db_iterator_page_new(void)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JDBIteratorHelper* helper;
-	JOperation* op;
-	JBackendOperation* data;
+	JDBIteratorPage* page;
+
+	page = g_slice_new(JDBIteratorPage);
+	memset(&page->bson, 0, sizeof(bson_t));
+	page->selector = NULL;
+	page->batch = NULL;
+	page->error = NULL;
+	page->ret = FALSE;
+	page->columns = NULL;
+	page->types = NULL;
+	page->offsets = NULL;
+	page->count = 0;
+	page->row_size = 0;
+	page->rows = NULL;
+	page->heap = NULL;
+	page->heap_length = 0;
+
+	return page;
+}
 
-	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+static void
+j_db_iterator_page_free(JDBIteratorPage* page)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	helper = j_helper_alloc_aligned(128, sizeof(JDBIteratorHelper));
-	helper->initialized = FALSE;
-	memset(&helper->bson, 0, sizeof(bson_t));
-	j_db_iterator->iterator = helper;
+	bson_t zerobson;
 
-	data = g_slice_new(JBackendOperation);
-	memcpy(data, &j_backend_operation_db_query, sizeof(JBackendOperation));
-	data->in_param[0].ptr_const = j_db_schema->namespace;
-	data->in_param[1].ptr_const = j_db_schema->name;
-	data->in_param[2].ptr_const = j_db_selector_get_bson(j_db_selector);
-	data->out_param[0].ptr_const = &helper->bson;
-	data->out_param[1].ptr_const = error;
+	memset(&zerobson, 0, sizeof(bson_t));
 
-	data->unref_func_count = 3;
-	data->unref_funcs[0] = (GDestroyNotify)j_db_schema_unref;
-	data->unref_funcs[1] = (GDestroyNotify)j_db_selector_unref;
-	data->unref_funcs[2] = (GDestroyNotify)j_db_iterator_unref;
-	data->unref_values[0] = j_db_schema_ref(j_db_schema);
-	data->unref_values[1] = j_db_selector_ref(j_db_selector);
-	data->unref_values[2] = j_db_iterator_ref(j_db_iterator);
+	if (page->batch != NULL)
+	{
+		j_batch_wait(page->batch);
+		j_batch_unref(page->batch);
+	}
 
-	op = j_operation_new();
-	op->key = j_db_schema->namespace;
-	op->data = data;
-	op->exec_func = j_db_query_exec;
-	op->free_func = j_backend_db_func_free;
+	if (memcmp(&page->bson, &zerobson, sizeof(bson_t)))
+	{
+		j_bson_destroy(&page->bson);
+	}
 
-	j_batch_add(batch, op);
+	if (page->selector != NULL)
+	{
+		j_bson_destroy(page->selector);
+	}
 
-	return TRUE;
+	g_clear_error(&page->error);
+
+	if (page->columns != NULL)
+	{
+		g_hash_table_unref(page->columns);
+	}
+
+	g_free(page->types);
+	g_free(page->offsets);
+
+	g_slice_free(JDBIteratorPage, page);
 }
 
-gboolean
-j_db_internal_iterate(JDBIterator* j_db_iterator, GError** error)
+/**
+ * Decodes the header of a page of packed rows.
+ *
+ * \private
+ *
+ * \param[in] page The page
+ * \param[out] error A GError
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+static gboolean
+j_db_iterator_page_decode(JDBIteratorPage* page, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JDBIteratorHelper* helper = j_db_iterator->iterator;
-	gboolean has_next;
-	bson_t zerobson;
+	bson_iter_t iter;
+	bson_iter_t iter_child;
+	guint32 column_count = 0;
+	guint32 types_count = 0;
+	guint32 rows_length;
+	guint32 offset;
+
+	// The backend did not return anything, for example, because the query failed
+	if (!bson_iter_init_find(&iter, &page->bson, "_count"))
+	{
+		return TRUE;
+	}
 
-	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+	if (G_UNLIKELY(!BSON_ITER_HOLDS_INT32(&iter)))
+	{
+		goto _invalid;
+	}
 
-	memset(&zerobson, 0, sizeof(bson_t));
+	page->count = bson_iter_int32(&iter);
+	page->columns = g_hash_table_new(g_str_hash, g_str_equal);
+
+	if (G_UNLIKELY(!bson_iter_init_find(&iter, &page->bson, "_names") || !bson_iter_recurse(&iter, &iter_child)))
+	{
+		goto _invalid;
+	}
 
-	if (!helper->initialized)
+	while (bson_iter_next(&iter_child))
 	{
-		if (G_UNLIKELY(!memcmp(&helper->bson, &zerobson, sizeof(bson_t))))
+		if (G_UNLIKELY(!BSON_ITER_HOLDS_UTF8(&iter_child)))
 		{
-			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_INVALID, "iterator invalid");
-			goto error2;
+			goto _invalid;
+		}
+
+		column_count++;
+		g_hash_table_insert(page->columns, (gpointer)bson_iter_utf8(&iter_child, NULL), GUINT_TO_POINTER(column_count));
+	}
+
+	page->types = g_new(bson_type_t, column_count);
+	page->offsets = g_new(guint32, column_count);
+	page->row_size = (column_count + 7) / 8;
+
+	if (G_UNLIKELY(!bson_iter_init_find(&iter, &page->bson, "_types") || !bson_iter_recurse(&iter, &iter_child)))
+	{
+		goto _invalid;
+	}
+
+	while (bson_iter_next(&iter_child))
+	{
+		if (G_UNLIKELY(types_count == column_count || !BSON_ITER_HOLDS_INT32(&iter_child)))
+		{
+			goto _invalid;
 		}
 
-		if (G_UNLIKELY(!j_bson_iter_init(&helper->iter, &helper->bson, error)))
+		page->types[types_count] = bson_iter_int32(&iter_child);
+		page->offsets[types_count] = page->row_size;
+
+		switch (page->types[types_count])
 		{
-			goto _error;
+			case BSON_TYPE_INT32:
+				page->row_size += 4;
+				break;
+			case BSON_TYPE_INT64:
+			case BSON_TYPE_DOUBLE:
+			case BSON_TYPE_UTF8:
+			case BSON_TYPE_BINARY:
+				page->row_size += 8;
+				break;
+			case BSON_TYPE_NULL:
+				break;
+			default:
+				goto _invalid;
+		}
+
+		types_count++;
+	}
+
+	if (G_UNLIKELY(types_count != column_count))
+	{
+		goto _invalid;
+	}
+
+	if (G_UNLIKELY(!bson_iter_init_find(&iter, &page->bson, "_rows") || !BSON_ITER_HOLDS_BINARY(&iter)))
+	{
+		goto _invalid;
+	}
+
+	bson_iter_binary(&iter, NULL, &rows_length, &page->rows);
+
+	if (G_UNLIKELY((guint64)page->row_size * page->count != rows_length))
+	{
+		goto _invalid;
+	}
+
+	if (G_UNLIKELY(!bson_iter_init_find(&iter, &page->bson, "_heap") || !BSON_ITER_HOLDS_BINARY(&iter)))
+	{
+		goto _invalid;
+	}
+
+	bson_iter_binary(&iter, NULL, &page->heap_length, &page->heap);
+
+	// Make sure that the heap references of all rows are valid, so they do not have to be checked while iterating
+	for (guint32 i = 0; i < column_count; i++)
+	{
+		if (page->types[i] != BSON_TYPE_UTF8 && page->types[i] != BSON_TYPE_BINARY)
+		{
+			continue;
+		}
+
+		offset = page->offsets[i];
+
+		for (guint32 j = 0; j < page->count; j++)
+		{
+			guint8 const* row = page->rows + (gsize)page->row_size * j;
+			guint32 ref[2];
+
+			if (!(row[i / 8] & (1 << (i % 8))))
+			{
+				continue;
+			}
+
+			memcpy(ref, row + offset, sizeof(ref));
+
+			if (G_UNLIKELY((guint64)ref[0] + ref[1] + (page->types[i] == BSON_TYPE_UTF8) > page->heap_length))
+			{
+				goto _invalid;
+			}
 		}
+	}
+
+	return TRUE;
+
+_invalid:
+	page->count = 0;
+	g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_INVALID, "iterator invalid");
+
+	return FALSE;
+}
+
+/**
+ * Returns the value of a field of a packed row.
+ * Values are only decoded when they are requested, strings and blobs point into the page.
+ *
+ * \private
+ *
+ * \param[in] page The page
+ * \param[in] row The index of the row
+ * \param[in] name The name of the field
+ * \param[in] type The type of the field
+ * \param[out] value The value
+ * \param[out] error A GError
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+static gboolean
+j_db_iterator_page_get_value(JDBIteratorPage* page, guint32 row, gchar const* name, JDBType type, JDBTypeValue* value, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_type_t expected;
+	guint8 const* data;
+	guint32 column;
+	guint32 ref[2];
+	gint32 val_int32;
+	gint64 val_int64;
+	gdouble val_double;
+
+	memset(value, 0, sizeof(*value));
 
-		helper->initialized = TRUE;
+	switch (type)
+	{
+		case J_DB_TYPE_SINT32:
+		case J_DB_TYPE_UINT32:
+			expected = BSON_TYPE_INT32;
+			break;
+		case J_DB_TYPE_SINT64:
+		case J_DB_TYPE_UINT64:
+			expected = BSON_TYPE_INT64;
+			break;
+		case J_DB_TYPE_FLOAT32:
+		case J_DB_TYPE_FLOAT64:
+			expected = BSON_TYPE_DOUBLE;
+			break;
+		case J_DB_TYPE_STRING:
+			expected = BSON_TYPE_UTF8;
+			break;
+		case J_DB_TYPE_BLOB:
+			expected = BSON_TYPE_BINARY;
+			break;
+		case J_DB_TYPE_ID:
+		default:
+			g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_INVALID_TYPE, "bson iter invalid type");
+			goto _error;
 	}
 
-	if (G_UNLIKELY(!j_bson_iter_next(&helper->iter, &has_next, error)))
+	if (G_UNLIKELY(row >= page->count || (column = GPOINTER_TO_UINT(g_hash_table_lookup(page->columns, name))) == 0))
 	{
+		g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_KEY_NOT_FOUND, "bson iter can not find key");
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!has_next))
+	column--;
+	data = page->rows + (gsize)page->row_size * row;
+
+	if (!(data[column / 8] & (1 << (column % 8))))
 	{
-		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+		// Unset blobs are returned as NULL, all other types have to be set
+		if (type == J_DB_TYPE_BLOB)
+		{
+			return TRUE;
+		}
+
+		g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_KEY_NOT_FOUND, "bson iter can not find key");
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_bson_iter_copy_document(&helper->iter, &j_db_iterator->bson, error)))
+	if (G_UNLIKELY(page->types[column] != expected))
 	{
+		g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_INVALID_TYPE, "bson iter invalid type");
 		goto _error;
 	}
 
+	data += page->offsets[column];
+
+	switch (type)
+	{
+		case J_DB_TYPE_SINT32:
+			memcpy(&val_int32, data, sizeof(val_int32));
+			value->val_sint32 = val_int32;
+			break;
+		case J_DB_TYPE_UINT32:
+			memcpy(&val_int32, data, sizeof(val_int32));
+			value->val_uint32 = val_int32;
+			break;
+		case J_DB_TYPE_SINT64:
+			memcpy(&val_int64, data, sizeof(val_int64));
+			value->val_sint64 = val_int64;
+			break;
+		case J_DB_TYPE_UINT64:
+			memcpy(&val_int64, data, sizeof(val_int64));
+			value->val_uint64 = val_int64;
+			break;
+		case J_DB_TYPE_FLOAT32:
+			memcpy(&val_double, data, sizeof(val_double));
+			value->val_float32 = val_double;
+			break;
+		case J_DB_TYPE_FLOAT64:
+			memcpy(&val_double, data, sizeof(val_double));
+			value->val_float64 = val_double;
+			break;
+		case J_DB_TYPE_STRING:
+			memcpy(ref, data, sizeof(ref));
+			value->val_string = (gchar const*)page->heap + ref[0];
+			break;
+		case J_DB_TYPE_BLOB:
+			memcpy(ref, data, sizeof(ref));
+			value->val_blob = (gchar const*)page->heap + ref[0];
+			value->val_blob_length = ref[1];
+			break;
+		case J_DB_TYPE_ID:
+		default:
+			g_assert_not_reached();
+	}
+
 	return TRUE;
 
 _error:
-	j_bson_destroy(&helper->bson);
+	return FALSE;
+}
 
-error2:
-	g_free(helper);
+static void
+j_db_iterator_page_done(JBatch* batch, gboolean ret, gpointer user_data)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	return FALSE;
+	JDBIteratorPage* page = user_data;
+
+	(void)batch;
+
+	page->ret = ret;
+}
+
+static void
+j_db_internal_query_add(JDBSchema* j_db_schema, bson_t const* selector, JDBIterator* j_db_iterator, JDBIteratorPage* page, JBatch* batch, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JOperation* op;
+	JBackendOperation* data;
+
+	data = g_slice_new(JBackendOperation);
+	memcpy(data, &j_backend_operation_db_query, sizeof(JBackendOperation));
+	data->in_param[0].ptr_const = j_db_schema->namespace;
+	data->in_param[1].ptr_const = j_db_schema->name;
+	data->in_param[2].ptr_const = selector;
+	data->in_param[3].ptr_const = j_db_iterator->fields;
+	data->out_param[0].ptr_const = &page->bson;
+	data->out_param[1].ptr_const = error;
+
+	// The iterator waits for background pages before it is freed, so they do not have to reference it
+	data->unref_func_count = 1;
+	data->unref_funcs[0] = (GDestroyNotify)j_db_schema_unref;
+	data->unref_values[0] = j_db_schema_ref(j_db_schema);
+
+	op = j_operation_new();
+	op->key = j_db_schema->namespace;
+	op->data = data;
+	op->exec_func = j_db_query_exec;
+	op->free_func = j_backend_db_func_free;
+
+	j_batch_add(batch, op);
+}
+
+/**
+ * Starts fetching the page following the current one if the current page is full.
+ *
+ * \private
+ *
+ * \param[in] j_db_iterator The iterator
+ **/
+static void
+j_db_internal_query_prefetch(JDBIterator* j_db_iterator)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBIteratorHelper* helper = j_db_iterator->iterator;
+	JDBIteratorPage* page;
+	bson_t const* selector;
+	bson_t condition[1];
+	JDBTypeValue value;
+	guint32 last_id;
+
+	if (helper->page->count < J_BACKEND_OPERATION_DB_QUERY_PAGE_SIZE)
+	{
+		return;
+	}
+
+	// Entries are returned in ascending order of their IDs, continue after the last one
+	if (!j_db_iterator_page_get_value(helper->page, helper->page->count - 1, "_id", J_DB_TYPE_UINT32, &value, NULL))
+	{
+		return;
+	}
+
+	last_id = value.val_uint32;
+
+	page = j_db_iterator_page_new();
+	page->selector = bson_new();
+
+	value.val_uint32 = J_DB_SELECTOR_MODE_AND;
+	j_bson_append_value(page->selector, "_mode", J_DB_TYPE_UINT32, &value, NULL);
+
+	j_bson_append_document_begin(page->selector, "0", condition, NULL);
+	value.val_string = "_id";
+	j_bson_append_value(condition, "_name", J_DB_TYPE_STRING, &value, NULL);
+	value.val_uint32 = J_DB_SELECTOR_OPERATOR_GT;
+	j_bson_append_value(condition, "_operator", J_DB_TYPE_UINT32, &value, NULL);
+	value.val_uint32 = last_id;
+	j_bson_append_value(condition, "_value", J_DB_TYPE_UINT32, &value, NULL);
+	j_bson_append_document_end(page->selector, condition, NULL);
+
+	if ((selector = j_db_selector_get_bson(j_db_iterator->selector)) != NULL)
+	{
+		j_bson_append_document(page->selector, "1", (bson_t*)selector, NULL);
+	}
+
+	page->batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_db_internal_query_add(j_db_iterator->schema, page->selector, j_db_iterator, page, page->batch, &page->error);
+	j_batch_execute_async(page->batch, j_db_iterator_page_done, page);
+
+	helper->next = page;
+}
+
+gboolean
+j_db_internal_query(JDBSchema* j_db_schema, JDBSelector* j_db_selector, JDBIterator* j_db_iterator, JBatch* batch, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBIteratorHelper* helper;
+
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	helper = j_helper_alloc_aligned(128, sizeof(JDBIteratorHelper));
+	helper->page = j_db_iterator_page_new();
+	helper->initialized = FALSE;
+	helper->next = NULL;
+	j_db_iterator->iterator = helper;
+
+	j_db_internal_query_add(j_db_schema, j_db_selector_get_bson(j_db_selector), j_db_iterator, helper->page, batch, error);
+
+	return TRUE;
+}
+
+gboolean
+j_db_internal_iterate(JDBIterator* j_db_iterator, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBIteratorHelper* helper = j_db_iterator->iterator;
+	bson_t zerobson;
+
+	g_return_val_if_fail(helper != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	memset(&zerobson, 0, sizeof(bson_t));
+
+	while (TRUE)
+	{
+		if (!helper->initialized)
+		{
+			if (G_UNLIKELY(!memcmp(&helper->page->bson, &zerobson, sizeof(bson_t))))
+			{
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_INVALID, "iterator invalid");
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_db_iterator_page_decode(helper->page, error)))
+			{
+				goto _error;
+			}
+
+			helper->row = 0;
+			helper->initialized = TRUE;
+			j_db_internal_query_prefetch(j_db_iterator);
+		}
+		else
+		{
+			helper->row++;
+		}
+
+		if (helper->row < helper->page->count)
+		{
+			break;
+		}
+
+		if (helper->next == NULL)
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+			goto _error;
+		}
+
+		j_batch_wait(helper->next->batch);
+
+		if (G_UNLIKELY(!helper->next->ret))
+		{
+			if (helper->next->error != NULL)
+			{
+				g_propagate_error(error, g_steal_pointer(&helper->next->error));
+			}
+			else
+			{
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_INVALID, "iterator invalid");
+			}
+
+			goto _error;
+		}
+
+		j_db_iterator_page_free(helper->page);
+		helper->page = helper->next;
+		helper->next = NULL;
+		helper->initialized = FALSE;
+	}
+
+	return TRUE;
+
+_error:
+	j_db_internal_iterator_free(j_db_iterator);
+
+	return FALSE;
+}
+
+gboolean
+j_db_internal_iterator_get_value(JDBIterator* j_db_iterator, gchar const* name, JDBType type, JDBTypeValue* value, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBIteratorHelper* helper = j_db_iterator->iterator;
+
+	g_return_val_if_fail(helper != NULL, FALSE);
+	g_return_val_if_fail(helper->initialized, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	return j_db_iterator_page_get_value(helper->page, helper->row, name, type, value, error);
+}
+
+void
+j_db_internal_iterator_free(JDBIterator* j_db_iterator)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBIteratorHelper* helper = j_db_iterator->iterator;
+
+	if (helper == NULL)
+	{
+		return;
+	}
+
+	if (helper->next != NULL)
+	{
+		j_db_iterator_page_free(helper->next);
+	}
+
+	j_db_iterator_page_free(helper->page);
+	g_free(helper);
+
+	j_db_iterator->iterator = NULL;
+}
+
+/**
+ * The state of an index advice operation.
+ **/
+struct JDBIndexAdvice
+{
+	bson_t options;
+	bson_t advice;
+
+	/**
+	 * Receives the suggested indexes as GStrv elements.
+	 **/
+	GPtrArray* indexes;
+};
+
+typedef struct JDBIndexAdvice JDBIndexAdvice;
+
+static void
+j_db_index_advice_free(JDBIndexAdvice* advice)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_destroy(&advice->options);
+
+	// The reply has only been received if the operation has been executed
+	if (advice->advice.len > 0)
+	{
+		bson_destroy(&advice->advice);
+	}
+
+	g_ptr_array_unref(advice->indexes);
+	g_free(advice);
+}
+
+static gboolean
+j_db_index_advice_decode(JDBIndexAdvice* advice, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_iter_t iter;
+	bson_iter_t iter_child;
+	bson_iter_t iter_fields;
+	gboolean has_next;
+	JDBTypeValue value;
+
+	if (advice->advice.len == 0)
+	{
+		return TRUE;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, &advice->advice, error)))
+	{
+		goto _error;
+	}
+
+	while (TRUE)
+	{
+		g_autoptr(GPtrArray) fields = NULL;
+
+		if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
+		{
+			goto _error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter, &iter_child, error)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_find(&iter_child, "_index", error)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_recurse_array(&iter_child, &iter_fields, error)))
+		{
+			goto _error;
+		}
+
+		fields = g_ptr_array_new_with_free_func(g_free);
+
+		while (TRUE)
+		{
+			if (G_UNLIKELY(!j_bson_iter_next(&iter_fields, &has_next, error)))
+			{
+				goto _error;
+			}
+
+			if (!has_next)
+			{
+				break;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_value(&iter_fields, J_DB_TYPE_STRING, &value, error)))
+			{
+				goto _error;
+			}
+
+			g_ptr_array_add(fields, g_strdup(value.val_string));
+		}
+
+		g_ptr_array_add(fields, NULL);
+		g_ptr_array_add(advice->indexes, g_ptr_array_free(g_steal_pointer(&fields), FALSE));
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+static gboolean
+j_db_schema_advise_indexes_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JListIterator) iter = NULL;
+	gboolean ret;
+
+	ret = j_backend_db_func_exec(operations, semantics, J_MESSAGE_DB_ADVISE_INDEXES);
+
+	iter = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(iter))
+	{
+		JBackendOperation* data = j_list_iterator_get(iter);
+
+		ret = j_db_index_advice_decode(data->unref_values[1], NULL) && ret;
+	}
+
+	return ret;
+}
+
+gboolean
+j_db_internal_schema_advise_indexes(JDBSchema* j_db_schema, gboolean create, GPtrArray* indexes, JBatch* batch, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JOperation* op;
+	JBackendOperation* data;
+	JDBIndexAdvice* advice;
+	JDBTypeValue value;
+
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	advice = g_new0(JDBIndexAdvice, 1);
+	advice->indexes = g_ptr_array_ref(indexes);
+	bson_init(&advice->options);
+
+	value.val_uint32 = create;
+
+	if (G_UNLIKELY(!j_bson_append_value(&advice->options, "_create", J_DB_TYPE_UINT32, &value, error)))
+	{
+		j_db_index_advice_free(advice);
+		return FALSE;
+	}
+
+	data = g_slice_new(JBackendOperation);
+	memcpy(data, &j_backend_operation_db_advise_indexes, sizeof(JBackendOperation));
+	data->in_param[0].ptr_const = j_db_schema->namespace;
+	data->in_param[1].ptr_const = j_db_schema->name;
+	data->in_param[2].ptr_const = &advice->options;
+	data->out_param[0].ptr_const = &advice->advice;
+	data->out_param[1].ptr_const = error;
+
+	data->unref_func_count = 2;
+	data->unref_funcs[0] = (GDestroyNotify)j_db_schema_unref;
+	data->unref_values[0] = j_db_schema_ref(j_db_schema);
+	data->unref_funcs[1] = (GDestroyNotify)j_db_index_advice_free;
+	data->unref_values[1] = advice;
+
+	op = j_operation_new();
+	op->key = j_db_schema->namespace;
+	op->data = data;
+	op->exec_func = j_db_schema_advise_indexes_exec;
+	op->free_func = j_backend_db_func_free;
+
+	j_batch_add(batch, op);
+
+	return TRUE;
+}
+
+static gboolean
+j_db_aggregate_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return j_backend_db_func_exec(operations, semantics, J_MESSAGE_DB_AGGREGATE);
+}
+
+gboolean
+j_db_internal_aggregate(JDBAggregate* j_db_aggregate, JBatch* batch, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JOperation* op;
+	JBackendOperation* data;
+	JDBIteratorPage* page;
+
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	page = j_db_iterator_page_new();
+	j_db_aggregate->page = page;
+
+	data = g_slice_new(JBackendOperation);
+	memcpy(data, &j_backend_operation_db_aggregate, sizeof(JBackendOperation));
+	data->in_param[0].ptr_const = j_db_aggregate->schema->namespace;
+	data->in_param[1].ptr_const = j_db_aggregate->schema->name;
+	data->in_param[2].ptr_const = j_db_selector_get_bson(j_db_aggregate->selector);
+	data->in_param[3].ptr_const = &j_db_aggregate->bson;
+	data->out_param[0].ptr_const = &page->bson;
+	data->out_param[1].ptr_const = error;
+
+	data->unref_func_count = 1;
+	data->unref_funcs[0] = (GDestroyNotify)j_db_aggregate_unref;
+	data->unref_values[0] = j_db_aggregate_ref(j_db_aggregate);
+
+	op = j_operation_new();
+	op->key = j_db_aggregate->schema->namespace;
+	op->data = data;
+	op->exec_func = j_db_aggregate_exec;
+	op->free_func = j_backend_db_func_free;
+
+	j_batch_add(batch, op);
+
+	return TRUE;
+}
+
+gboolean
+j_db_internal_aggregate_next(JDBAggregate* j_db_aggregate, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBIteratorPage* page = j_db_aggregate->page;
+	bson_t zerobson;
+
+	g_return_val_if_fail(page != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	memset(&zerobson, 0, sizeof(bson_t));
+
+	if (!j_db_aggregate->initialized)
+	{
+		if (G_UNLIKELY(!memcmp(&page->bson, &zerobson, sizeof(bson_t))))
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_INVALID, "iterator invalid");
+			return FALSE;
+		}
+
+		if (G_UNLIKELY(!j_db_iterator_page_decode(page, error)))
+		{
+			return FALSE;
+		}
+
+		j_db_aggregate->row = 0;
+		j_db_aggregate->initialized = TRUE;
+	}
+	else if (j_db_aggregate->row < page->count)
+	{
+		j_db_aggregate->row++;
+	}
+
+	if (j_db_aggregate->row >= page->count)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+gboolean
+j_db_internal_aggregate_get_value(JDBAggregate* j_db_aggregate, gchar const* name, JDBType type, JDBTypeValue* value, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(j_db_aggregate->page != NULL, FALSE);
+	g_return_val_if_fail(j_db_aggregate->initialized, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	return j_db_iterator_page_get_value(j_db_aggregate->page, j_db_aggregate->row, name, type, value, error);
+}
+
+void
+j_db_internal_aggregate_free(JDBAggregate* j_db_aggregate)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (j_db_aggregate->page != NULL)
+	{
+		j_db_iterator_page_free(j_db_aggregate->page);
+		j_db_aggregate->page = NULL;
+	}
+}
+
+void
+j_db_internal_value_copy(JDBType type, JDBTypeValue const* val, gpointer* value, guint64* length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	switch (type)
+	{
+		case J_DB_TYPE_SINT32:
+			*value = g_new(gint32, 1);
+			*((gint32*)*value) = val->val_sint32;
+			*length = sizeof(gint32);
+			break;
+		case J_DB_TYPE_UINT32:
+			*value = g_new(guint32, 1);
+			*((guint32*)*value) = val->val_uint32;
+			*length = sizeof(guint32);
+			break;
+		case J_DB_TYPE_FLOAT32:
+			*value = g_new(gfloat, 1);
+			*((gfloat*)*value) = val->val_float32;
+			*length = sizeof(gfloat);
+			break;
+		case J_DB_TYPE_SINT64:
+			*value = g_new(gint64, 1);
+			*((gint64*)*value) = val->val_sint64;
+			*length = sizeof(gint64);
+			break;
+		case J_DB_TYPE_UINT64:
+			*value = g_new(guint64, 1);
+			*((guint64*)*value) = val->val_uint64;
+			*length = sizeof(guint64);
+			break;
+		case J_DB_TYPE_FLOAT64:
+			*value = g_new(gdouble, 1);
+			*((gdouble*)*value) = val->val_float64;
+			*length = sizeof(gdouble);
+			break;
+		case J_DB_TYPE_STRING:
+			*value = g_strdup(val->val_string);
+			*length = strlen(val->val_string);
+			break;
+		case J_DB_TYPE_BLOB:
+			if (val->val_blob && val->val_blob_length)
+			{
+				*value = g_new(gchar, val->val_blob_length);
+				memcpy(*value, val->val_blob, val->val_blob_length);
+				*length = val->val_blob_length;
+			}
+			else
+			{
+				*value = NULL;
+				*length = 0;
+			}
+			break;
+		case J_DB_TYPE_ID:
+		default:
+			g_assert_not_reached();
+	}
 }
 
 bson_t*
@@ -38,6 +38,14 @@ j_db_iterator_new(JDBSchema* schema, JDBSelector* selector, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
+	return j_db_iterator_new_for_fields(schema, selector, NULL, error);
+}
+
+JDBIterator*
+j_db_iterator_new_for_fields(JDBSchema* schema, JDBSelector* selector, gchar const** fields, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
 	guint ret;
 	guint ret2 = FALSE;
 	JBatch* batch;
@@ -48,6 +56,7 @@ j_db_iterator_new(JDBSchema* schema, JDBSelector* selector, GError** error)
 	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
 
 	iterator = j_helper_alloc_aligned(128, sizeof(JDBIterator));
+	iterator->fields = NULL;
 	iterator->schema = j_db_schema_ref(schema);
 
 	if (G_UNLIKELY(!iterator->schema))
@@ -72,7 +81,50 @@ j_db_iterator_new(JDBSchema* schema, JDBSelector* selector, GError** error)
 	iterator->iterator = NULL;
 	iterator->ref_count = 1;
 	iterator->valid = FALSE;
-	iterator->bson_valid = FALSE;
+	iterator->row_valid = FALSE;
+
+	if (fields != NULL)
+	{
+		g_autoptr(GHashTable) seen = NULL;
+		guint32 count = 0;
+
+		seen = g_hash_table_new(g_str_hash, g_str_equal);
+		iterator->fields = bson_new();
+
+		for (gchar const** field = fields; *field != NULL; field++)
+		{
+			JDBTypeValue value;
+			JDBType type;
+			char buf[16];
+			const char* key;
+
+			// _id is always retrieved
+			if (g_strcmp0(*field, "_id") == 0 || !g_hash_table_add(seen, (gpointer)*field))
+			{
+				continue;
+			}
+
+			if (G_UNLIKELY(!j_db_schema_get_field(schema, *field, &type, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_array_generate_key(count, &key, buf, sizeof(buf), error)))
+			{
+				goto _error;
+			}
+
+			value.val_string = *field;
+
+			if (G_UNLIKELY(!j_bson_append_value(iterator->fields, key, J_DB_TYPE_STRING, &value, error)))
+			{
+				goto _error;
+			}
+
+			count++;
+		}
+	}
+
 	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
 	ret2 = j_db_internal_query(schema, selector, iterator, batch, error);
 	ret = ret2 && j_batch_execute(batch);
@@ -88,14 +140,6 @@ j_db_iterator_new(JDBSchema* schema, JDBSelector* selector, GError** error)
 	return iterator;
 
 _error:
-	if (ret2)
-	{
-		while (j_db_internal_iterate(iterator, NULL))
-		{
-			/*do nothing*/
-		}
-	}
-
 	j_db_iterator_unref(iterator);
 
 	return NULL;
@@ -122,10 +166,8 @@ j_db_iterator_unref(JDBIterator* iterator)
 
 	if (g_atomic_int_dec_and_test(&iterator->ref_count))
 	{
-		while (iterator->valid)
-		{
-			j_db_iterator_next(iterator, NULL);
-		}
+		// Pages that have not been processed yet are discarded without fetching the remaining ones
+		j_db_internal_iterator_free(iterator);
 
 		j_db_schema_unref(iterator->schema);
 
@@ -134,9 +176,9 @@ j_db_iterator_unref(JDBIterator* iterator)
 			j_db_selector_unref(iterator->selector);
 		}
 
-		if (iterator->bson_valid)
+		if (iterator->fields)
 		{
-			j_bson_destroy(&iterator->bson);
+			bson_destroy(iterator->fields);
 		}
 
 		g_free(iterator);
@@ -152,23 +194,18 @@ j_db_iterator_next(JDBIterator* iterator, GError** error)
 	g_return_val_if_fail(iterator->valid, FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-	if (iterator->bson_valid)
-	{
-		j_bson_destroy(&iterator->bson);
-	}
-
 	if (G_UNLIKELY(!j_db_internal_iterate(iterator, error)))
 	{
 		goto _error;
 	}
 
-	iterator->bson_valid = TRUE;
+	iterator->row_valid = TRUE;
 
 	return TRUE;
 
 _error:
 	iterator->valid = FALSE;
-	iterator->bson_valid = FALSE;
+	iterator->row_valid = FALSE;
 
 	return FALSE;
 }
@@ -179,10 +216,9 @@ j_db_iterator_get_field(JDBIterator* iterator, gchar const* name, JDBType* type,
 	J_TRACE_FUNCTION(NULL);
 
 	JDBTypeValue val;
-	bson_iter_t iter;
 
 	g_return_val_if_fail(iterator != NULL, FALSE);
-	g_return_val_if_fail(iterator->bson_valid, FALSE);
+	g_return_val_if_fail(iterator->row_valid, FALSE);
 	g_return_val_if_fail(name != NULL, FALSE);
 	g_return_val_if_fail(type != NULL, FALSE);
 	g_return_val_if_fail(value != NULL, FALSE);
@@ -194,75 +230,86 @@ j_db_iterator_get_field(JDBIterator* iterator, gchar const* name, JDBType* type,
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_bson_iter_init(&iter, &iterator->bson, error)))
+	if (G_UNLIKELY(!j_db_internal_iterator_get_value(iterator, name, *type, &val, error)))
 	{
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_bson_iter_find(&iter, name, error)))
-	{
-		goto _error;
-	}
+	j_db_internal_value_copy(*type, &val, value, length);
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+gboolean
+j_db_iterator_get_array_field(JDBIterator* iterator, gchar const* name, JDBType* type, gpointer* values, guint32* length, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* array = NULL;
+	JDBTypeValue val;
+	gsize size;
+
+	g_return_val_if_fail(iterator != NULL, FALSE);
+	g_return_val_if_fail(iterator->row_valid, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(type != NULL, FALSE);
+	g_return_val_if_fail(values != NULL, FALSE);
+	g_return_val_if_fail(length != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-	if (G_UNLIKELY(!j_bson_iter_value(&iter, *type, &val, error)))
+	if (G_UNLIKELY(!j_db_schema_get_array_field(iterator->schema, name, type, length, error)))
 	{
 		goto _error;
 	}
 
-	switch (*type)
+	size = j_db_type_get_element_size(*type);
+	array = g_malloc(*length * size);
+
+	for (guint32 i = 0; i < *length; i++)
 	{
-		case J_DB_TYPE_SINT32:
-			*value = g_new(gint32, 1);
-			*((gint32*)*value) = val.val_sint32;
-			*length = sizeof(gint32);
-			break;
-		case J_DB_TYPE_UINT32:
-			*value = g_new(guint32, 1);
-			*((guint32*)*value) = val.val_uint32;
-			*length = sizeof(guint32);
-			break;
-		case J_DB_TYPE_FLOAT32:
-			*value = g_new(gfloat, 1);
-			*((gfloat*)*value) = val.val_float32;
-			*length = sizeof(gfloat);
-			break;
-		case J_DB_TYPE_SINT64:
-			*value = g_new(gint64, 1);
-			*((gint64*)*value) = val.val_sint64;
-			*length = sizeof(gint64);
-			break;
-		case J_DB_TYPE_UINT64:
-			*value = g_new(guint64, 1);
-			*((guint64*)*value) = val.val_uint64;
-			*length = sizeof(guint64);
-			break;
-		case J_DB_TYPE_FLOAT64:
-			*value = g_new(gdouble, 1);
-			*((gdouble*)*value) = val.val_float64;
-			*length = sizeof(gdouble);
-			break;
-		case J_DB_TYPE_STRING:
-			*value = g_strdup(val.val_string);
-			*length = strlen(val.val_string);
-			break;
-		case J_DB_TYPE_BLOB:
-			if (val.val_blob && val.val_blob_length)
-			{
-				*value = g_new(gchar, val.val_blob_length);
-				memcpy(*value, val.val_blob, val.val_blob_length);
-				*length = val.val_blob_length;
-			}
-			else
-			{
-				*value = NULL;
-				*length = 0;
-			}
-			break;
-		case J_DB_TYPE_ID:
-		default:
-			g_assert_not_reached();
+		g_autofree gchar* element = NULL;
+		gpointer data = array + i * size;
+
+		element = j_db_array_element_name(name, i);
+
+		if (G_UNLIKELY(!j_db_internal_iterator_get_value(iterator, element, *type, &val, error)))
+		{
+			goto _error;
+		}
+
+		switch (*type)
+		{
+			case J_DB_TYPE_SINT32:
+				memcpy(data, &val.val_sint32, size);
+				break;
+			case J_DB_TYPE_UINT32:
+				memcpy(data, &val.val_uint32, size);
+				break;
+			case J_DB_TYPE_FLOAT32:
+				memcpy(data, &val.val_float32, size);
+				break;
+			case J_DB_TYPE_SINT64:
+				memcpy(data, &val.val_sint64, size);
+				break;
+			case J_DB_TYPE_UINT64:
+				memcpy(data, &val.val_uint64, size);
+				break;
+			case J_DB_TYPE_FLOAT64:
+				memcpy(data, &val.val_float64, size);
+				break;
+			case J_DB_TYPE_STRING:
+			case J_DB_TYPE_BLOB:
+			case J_DB_TYPE_ID:
+			default:
+				g_assert_not_reached();
+		}
 	}
 
+	*values = g_steal_pointer(&array);
+
 	return TRUE;
 
 _error:
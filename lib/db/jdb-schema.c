@@ -33,6 +33,197 @@
 #include <julea-db.h>
 #include "../../backend/db/jbson.c"
 
+/**
+ * Caches the fields of schemas that have been created or fetched by this process.
+ * Schemas cannot be modified after their creation, so only deletions have to be considered.
+ **/
+/**
+ * The time in seconds a cached schema may be used with J_SEMANTICS_CONSISTENCY_EVENTUAL.
+ **/
+#define J_DB_SCHEMA_CACHE_TTL 10
+
+/**
+ * A cached schema.
+ **/
+struct JDBSchemaCacheEntry
+{
+	/**
+	 * A copy of the schema's BSON.
+	 **/
+	bson_t* bson;
+
+	/**
+	 * The monotonic time the entry has been inserted at.
+	 **/
+	gint64 time;
+};
+
+typedef struct JDBSchemaCacheEntry JDBSchemaCacheEntry;
+
+static struct
+{
+	GMutex mutex[1];
+
+	/**
+	 * Maps namespace/name keys to #JDBSchemaCacheEntry.
+	 * Protected by mutex.
+	 **/
+	GHashTable* entries;
+
+	/**
+	 * Incremented by every deletion, so that schemas requested before it are not cached.
+	 * Protected by mutex.
+	 **/
+	guint generation;
+} j_db_schema_cache;
+
+static gchar*
+j_db_schema_cache_key(JDBSchema* schema)
+{
+	return g_strdup_printf("%s/%s", schema->namespace, schema->name);
+}
+
+static void
+j_db_schema_cache_entry_free(gpointer data)
+{
+	JDBSchemaCacheEntry* entry = data;
+
+	bson_destroy(entry->bson);
+	g_slice_free(JDBSchemaCacheEntry, entry);
+}
+
+/**
+ * Remembers the cache's current generation for a schema that is about to be created or fetched.
+ * The mutex has to be held.
+ *
+ * \private
+ **/
+static void
+j_db_schema_cache_begin(JDBSchema* schema)
+{
+	if (j_db_schema_cache.entries == NULL)
+	{
+		j_db_schema_cache.entries = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, j_db_schema_cache_entry_free);
+	}
+
+	schema->cache_generation = j_db_schema_cache.generation;
+}
+
+/**
+ * Copies a cached schema's fields into a schema.
+ * If the schema is not cached, its request is remembered for j_db_schema_cache_insert().
+ * With J_SEMANTICS_CONSISTENCY_IMMEDIATE, the cache is bypassed.
+ * With J_SEMANTICS_CONSISTENCY_EVENTUAL, entries expire after J_DB_SCHEMA_CACHE_TTL seconds.
+ *
+ * \private
+ *
+ * \param schema    A schema.
+ * \param semantics The semantics of the lookup.
+ *
+ * \return TRUE if the schema was cached, FALSE otherwise.
+ **/
+gboolean
+j_db_schema_cache_lookup(JDBSchema* schema, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* key = NULL;
+	JDBSchemaCacheEntry* entry;
+	JSemanticsConsistency consistency;
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	key = j_db_schema_cache_key(schema);
+	consistency = j_semantics_get(semantics, J_SEMANTICS_CONSISTENCY);
+
+	g_mutex_lock(j_db_schema_cache.mutex);
+
+	j_db_schema_cache_begin(schema);
+
+	if (consistency != J_SEMANTICS_CONSISTENCY_IMMEDIATE && (entry = g_hash_table_lookup(j_db_schema_cache.entries, key)) != NULL)
+	{
+		if (consistency == J_SEMANTICS_CONSISTENCY_EVENTUAL && g_get_monotonic_time() - entry->time > J_DB_SCHEMA_CACHE_TTL * G_USEC_PER_SEC)
+		{
+			g_hash_table_remove(j_db_schema_cache.entries, key);
+		}
+		else
+		{
+			bson_destroy(&schema->bson);
+			bson_copy_to(entry->bson, &schema->bson);
+			ret = TRUE;
+		}
+	}
+
+	g_mutex_unlock(j_db_schema_cache.mutex);
+
+	return ret;
+}
+
+/**
+ * Caches a schema after it has been created or fetched.
+ * Nothing is cached if the schema has been deleted in the meantime.
+ *
+ * \private
+ *
+ * \param schema A schema.
+ **/
+void
+j_db_schema_cache_insert(JDBSchema* schema)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBSchemaCacheEntry* entry;
+	guint32 count = 0;
+
+	// Fetching a schema that does not exist returns an empty document
+	if (!j_bson_count_keys(&schema->bson, &count, NULL) || count == 0)
+	{
+		return;
+	}
+
+	g_mutex_lock(j_db_schema_cache.mutex);
+
+	if (j_db_schema_cache.entries != NULL && schema->cache_generation == j_db_schema_cache.generation)
+	{
+		entry = g_slice_new(JDBSchemaCacheEntry);
+		entry->bson = bson_copy(&schema->bson);
+		entry->time = g_get_monotonic_time();
+
+		g_hash_table_insert(j_db_schema_cache.entries, j_db_schema_cache_key(schema), entry);
+	}
+
+	g_mutex_unlock(j_db_schema_cache.mutex);
+}
+
+/**
+ * Removes a schema from the cache.
+ *
+ * \private
+ *
+ * \param schema A schema.
+ **/
+void
+j_db_schema_cache_remove(JDBSchema* schema)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* key = NULL;
+
+	key = j_db_schema_cache_key(schema);
+
+	g_mutex_lock(j_db_schema_cache.mutex);
+
+	j_db_schema_cache.generation++;
+
+	if (j_db_schema_cache.entries != NULL)
+	{
+		g_hash_table_remove(j_db_schema_cache.entries, key);
+	}
+
+	g_mutex_unlock(j_db_schema_cache.mutex);
+}
+
 JDBSchema*
 j_db_schema_new(gchar const* namespace, gchar const* name, GError** error)
 {
@@ -54,6 +245,7 @@ j_db_schema_new(gchar const* namespace, gchar const* name, GError** error)
 	schema->bson_initialized = FALSE;
 	schema->bson_index_initialized = FALSE;
 	schema->ref_count = 1;
+	schema->cache_generation = 0;
 	schema->server_side = FALSE;
 	// FIXME since schema->bson is used as the out_param in j_db_internal_schema_get, the schema passed to the backend's schema_get is initialized if and only if the backend runs on the client
 	bson_init(&schema->bson);
@@ -196,6 +388,125 @@ _error:
 	return FALSE;
 }
 
+/**
+ * Returns the size of an array element.
+ *
+ * \private
+ *
+ * \param type The element type.
+ *
+ * \return The size in bytes, 0 if the type can not be used for arrays.
+ **/
+gsize
+j_db_type_get_element_size(JDBType type)
+{
+	switch (type)
+	{
+		case J_DB_TYPE_SINT32:
+		case J_DB_TYPE_UINT32:
+		case J_DB_TYPE_FLOAT32:
+			return 4;
+		case J_DB_TYPE_SINT64:
+		case J_DB_TYPE_UINT64:
+		case J_DB_TYPE_FLOAT64:
+			return 8;
+		case J_DB_TYPE_STRING:
+		case J_DB_TYPE_BLOB:
+		case J_DB_TYPE_ID:
+		default:
+			return 0;
+	}
+}
+
+gchar*
+j_db_array_element_name(gchar const* name, guint32 index)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(name != NULL, NULL);
+
+	return g_strdup_printf("%s[%u]", name, index);
+}
+
+gboolean
+j_db_schema_add_array_field(JDBSchema* schema, gchar const* name, JDBType type, guint32 length, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(schema != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(length > 0, FALSE);
+	g_return_val_if_fail(!schema->server_side, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (G_UNLIKELY(j_db_type_get_element_size(type) == 0))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_TYPE_INVALID, "type invalid");
+		goto _error;
+	}
+
+	for (guint32 i = 0; i < length; i++)
+	{
+		g_autofree gchar* element = NULL;
+
+		element = j_db_array_element_name(name, i);
+
+		if (G_UNLIKELY(!j_db_schema_add_field(schema, element, type, error)))
+		{
+			goto _error;
+		}
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+gboolean
+j_db_schema_get_array_field(JDBSchema* schema, gchar const* name, JDBType* type, guint32* length, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* element = NULL;
+	JDBType element_type;
+
+	g_return_val_if_fail(schema != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(type != NULL, FALSE);
+	g_return_val_if_fail(length != NULL, FALSE);
+	g_return_val_if_fail(schema->bson_initialized, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	element = j_db_array_element_name(name, 0);
+
+	if (G_UNLIKELY(!j_db_schema_get_field(schema, element, type, error)))
+	{
+		goto _error;
+	}
+
+	*length = 1;
+
+	// The elements are consecutive, the first missing one ends the array
+	while (TRUE)
+	{
+		g_free(element);
+		element = j_db_array_element_name(name, *length);
+
+		if (!j_db_schema_get_field(schema, element, &element_type, NULL) || element_type != *type)
+		{
+			break;
+		}
+
+		(*length)++;
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
 guint32
 j_db_schema_get_all_fields(JDBSchema* schema, gchar*** names, JDBType** types, GError** error)
 {
@@ -420,6 +731,10 @@ j_db_schema_create(JDBSchema* schema, JBatch* batch, GError** error)
 
 	schema->server_side = TRUE;
 
+	g_mutex_lock(j_db_schema_cache.mutex);
+	j_db_schema_cache_begin(schema);
+	g_mutex_unlock(j_db_schema_cache.mutex);
+
 	if (G_UNLIKELY(!j_db_internal_schema_create(schema, batch, error)))
 	{
 		goto _error;
@@ -456,6 +771,27 @@ _error:
 	return FALSE;
 }
 
+gboolean
+j_db_schema_advise_indexes(JDBSchema* schema, gboolean create, GPtrArray* indexes, JBatch* batch, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(schema != NULL, FALSE);
+	g_return_val_if_fail(indexes != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (G_UNLIKELY(!j_db_internal_schema_advise_indexes(schema, create, indexes, batch, error)))
+	{
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
 gboolean
 j_db_schema_delete(JDBSchema* schema, JBatch* batch, GError** error)
 {
@@ -465,6 +801,8 @@ j_db_schema_delete(JDBSchema* schema, JBatch* batch, GError** error)
 	g_return_val_if_fail(batch != NULL, FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
+	j_db_schema_cache_remove(schema);
+
 	if (G_UNLIKELY(!j_db_internal_schema_delete(schema, batch, error)))
 	{
 		goto _error;
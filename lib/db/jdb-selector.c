@@ -33,6 +33,206 @@
 #include <julea-db.h>
 #include "../../backend/db/jbson.c"
 
+/**
+ * A value that is bound after the selector has been built.
+ **/
+struct JDBSelectorParameter
+{
+	/**
+	 * The dotted path of the value within the selector's BSON.
+	 **/
+	gchar* path;
+
+	JDBType type;
+};
+
+typedef struct JDBSelectorParameter JDBSelectorParameter;
+
+static void
+j_db_selector_parameter_clear(gpointer data)
+{
+	JDBSelectorParameter* parameter = data;
+
+	g_free(parameter->path);
+}
+
+static void
+j_db_selector_value_set(JDBType type, gconstpointer value, guint64 length, JDBTypeValue* val)
+{
+	switch (type)
+	{
+		case J_DB_TYPE_SINT32:
+			val->val_sint32 = *(gint32 const*)value;
+			break;
+		case J_DB_TYPE_UINT32:
+			val->val_uint32 = *(guint32 const*)value;
+			break;
+		case J_DB_TYPE_FLOAT32:
+			val->val_float32 = *(gfloat const*)value;
+			break;
+		case J_DB_TYPE_SINT64:
+			val->val_sint64 = *(gint64 const*)value;
+			break;
+		case J_DB_TYPE_UINT64:
+			val->val_sint64 = *(gint64 const*)value;
+			break;
+		case J_DB_TYPE_FLOAT64:
+			val->val_float64 = *(gdouble const*)value;
+			break;
+		case J_DB_TYPE_STRING:
+			val->val_string = value;
+			break;
+		case J_DB_TYPE_BLOB:
+			val->val_blob = value;
+			val->val_blob_length = length;
+			break;
+		case J_DB_TYPE_ID:
+		default:
+			g_assert_not_reached();
+	}
+}
+
+static gboolean
+j_db_selector_append_field(JDBSelector* selector, gchar const* name, JDBSelectorOperator operator_, JDBType type, JDBTypeValue* value, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	char buf[20];
+	bson_t bson;
+	JDBTypeValue val;
+
+	snprintf(buf, sizeof(buf), "%d", selector->bson_count);
+
+	if (G_UNLIKELY(!j_bson_append_document_begin(&selector->bson, buf, &bson, error)))
+	{
+		goto _error;
+	}
+
+	val.val_string = name;
+
+	if (G_UNLIKELY(!j_bson_append_value(&bson, "_name", J_DB_TYPE_STRING, &val, error)))
+	{
+		goto _error;
+	}
+
+	val.val_uint32 = operator_;
+
+	if (G_UNLIKELY(!j_bson_append_value(&bson, "_operator", J_DB_TYPE_UINT32, &val, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_append_value(&bson, "_value", type, value, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_append_document_end(&selector->bson, &bson, error)))
+	{
+		goto _error;
+	}
+
+	selector->bson_count++;
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+/**
+ * Copies a BSON document, replacing the value at the given path.
+ * Used for values whose size can change, which can not be overwritten in place.
+ *
+ * \private
+ **/
+static gboolean
+j_db_selector_replace_value(bson_t const* bson, bson_t* copy, gchar const* path, JDBType type, JDBTypeValue* value, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_iter_t iter;
+	gchar const* dot;
+	gsize key_length;
+	gboolean has_next;
+
+	dot = strchr(path, '.');
+	key_length = (dot != NULL) ? (gsize)(dot - path) : strlen(path);
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, bson, error)))
+	{
+		goto _error;
+	}
+
+	while (TRUE)
+	{
+		gchar const* key;
+
+		if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
+		{
+			goto _error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		key = bson_iter_key(&iter);
+
+		if (strlen(key) != key_length || strncmp(key, path, key_length) != 0)
+		{
+			if (G_UNLIKELY(!bson_append_iter(copy, NULL, 0, &iter)))
+			{
+				g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_BSON_APPEND_FAILED, "bson append failed");
+				goto _error;
+			}
+		}
+		else if (dot == NULL)
+		{
+			if (G_UNLIKELY(!j_bson_append_value(copy, key, type, value, error)))
+			{
+				goto _error;
+			}
+		}
+		else
+		{
+			bson_t child[1];
+			bson_t child_copy[1];
+			guint8 const* data;
+			guint32 length;
+
+			bson_iter_document(&iter, &length, &data);
+
+			if (G_UNLIKELY(!bson_init_static(child, data, length)))
+			{
+				g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_FAILED, "bson init failed");
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_append_document_begin(copy, key, child_copy, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_db_selector_replace_value(child, child_copy, dot + 1, type, value, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_append_document_end(copy, child_copy, error)))
+			{
+				goto _error;
+			}
+		}
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
 JDBSelector*
 j_db_selector_new(JDBSchema* schema, JDBSelectorMode mode, GError** error)
 {
@@ -48,8 +248,12 @@ j_db_selector_new(JDBSchema* schema, JDBSelectorMode mode, GError** error)
 	selector->mode = mode;
 	selector->bson_count = 0;
 	bson_init(&selector->bson);
+	selector->parameters = g_array_new(FALSE, FALSE, sizeof(JDBSelectorParameter));
+	selector->prepared = FALSE;
 	selector->schema = j_db_schema_ref(schema);
 
+	g_array_set_clear_func(selector->parameters, j_db_selector_parameter_clear);
+
 	if (G_UNLIKELY(!selector->schema))
 	{
 		goto _error;
@@ -92,6 +296,7 @@ j_db_selector_unref(JDBSelector* selector)
 	{
 		j_db_schema_unref(selector->schema);
 		bson_destroy(&selector->bson);
+		g_array_unref(selector->parameters);
 		g_free(selector);
 	}
 }
@@ -101,12 +306,11 @@ j_db_selector_add_field(JDBSelector* selector, gchar const* name, JDBSelectorOpe
 {
 	J_TRACE_FUNCTION(NULL);
 
-	char buf[20];
-	bson_t bson;
 	JDBType type;
 	JDBTypeValue val;
 
 	g_return_val_if_fail(selector != NULL, FALSE);
+	g_return_val_if_fail(!selector->prepared, FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
 	if (G_UNLIKELY(selector->bson_count + 1 > 500))
@@ -120,70 +324,55 @@ j_db_selector_add_field(JDBSelector* selector, gchar const* name, JDBSelectorOpe
 		goto _error;
 	}
 
-	snprintf(buf, sizeof(buf), "%d", selector->bson_count);
+	j_db_selector_value_set(type, value, length, &val);
 
-	if (G_UNLIKELY(!j_bson_append_document_begin(&selector->bson, buf, &bson, error)))
-	{
-		goto _error;
-	}
+	return j_db_selector_append_field(selector, name, operator_, type, &val, error);
 
-	val.val_string = name;
+_error:
+	return FALSE;
+}
 
-	if (G_UNLIKELY(!j_bson_append_value(&bson, "_name", J_DB_TYPE_STRING, &val, error)))
-	{
-		goto _error;
-	}
+gboolean
+j_db_selector_add_parameter(JDBSelector* selector, gchar const* name, JDBSelectorOperator operator_, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	val.val_uint32 = operator_;
+	JDBSelectorParameter parameter;
+	JDBTypeValue val;
 
-	if (G_UNLIKELY(!j_bson_append_value(&bson, "_operator", J_DB_TYPE_UINT32, &val, error)))
+	g_return_val_if_fail(selector != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(!selector->prepared, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (G_UNLIKELY(selector->bson_count + 1 > 500))
 	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_SELECTOR_TOO_COMPLEX, "selector too complex");
 		goto _error;
 	}
 
-	switch (type)
+	if (G_UNLIKELY(!j_db_schema_get_field(selector->schema, name, &parameter.type, error)))
 	{
-		case J_DB_TYPE_SINT32:
-			val.val_sint32 = *(gint32 const*)value;
-			break;
-		case J_DB_TYPE_UINT32:
-			val.val_uint32 = *(guint32 const*)value;
-			break;
-		case J_DB_TYPE_FLOAT32:
-			val.val_float32 = *(gfloat const*)value;
-			break;
-		case J_DB_TYPE_SINT64:
-			val.val_sint64 = *(gint64 const*)value;
-			break;
-		case J_DB_TYPE_UINT64:
-			val.val_sint64 = *(gint64 const*)value;
-			break;
-		case J_DB_TYPE_FLOAT64:
-			val.val_float64 = *(gdouble const*)value;
-			break;
-		case J_DB_TYPE_STRING:
-			val.val_string = value;
-			break;
-		case J_DB_TYPE_BLOB:
-			val.val_blob = value;
-			val.val_blob_length = length;
-			break;
-		case J_DB_TYPE_ID:
-		default:
-			g_assert_not_reached();
+		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_bson_append_value(&bson, "_value", type, &val, error)))
+	// The placeholder has the parameter's type, so that numeric values can be overwritten in place
+	memset(&val, 0, sizeof(val));
+
+	if (parameter.type == J_DB_TYPE_STRING)
 	{
-		goto _error;
+		val.val_string = "";
 	}
 
-	if (G_UNLIKELY(!j_bson_append_document_end(&selector->bson, &bson, error)))
+	parameter.path = g_strdup_printf("%u._value", selector->bson_count);
+
+	if (G_UNLIKELY(!j_db_selector_append_field(selector, name, operator_, parameter.type, &val, error)))
 	{
+		g_free(parameter.path);
 		goto _error;
 	}
 
-	selector->bson_count++;
+	g_array_append_val(selector->parameters, parameter);
 
 	return TRUE;
 
@@ -202,6 +391,7 @@ j_db_selector_add_selector(JDBSelector* selector, JDBSelector* sub_selector, GEr
 	g_return_val_if_fail(sub_selector != NULL, FALSE);
 	g_return_val_if_fail(selector != sub_selector, FALSE);
 	g_return_val_if_fail(selector->schema == sub_selector->schema, FALSE);
+	g_return_val_if_fail(!selector->prepared, FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
 	if (G_UNLIKELY(!sub_selector->bson_count))
@@ -223,6 +413,17 @@ j_db_selector_add_selector(JDBSelector* selector, JDBSelector* sub_selector, GEr
 		goto _error;
 	}
 
+	for (guint i = 0; i < sub_selector->parameters->len; i++)
+	{
+		JDBSelectorParameter const* sub_parameter = &g_array_index(sub_selector->parameters, JDBSelectorParameter, i);
+		JDBSelectorParameter parameter;
+
+		parameter.path = g_strdup_printf("%s.%s", buf, sub_parameter->path);
+		parameter.type = sub_parameter->type;
+
+		g_array_append_val(selector->parameters, parameter);
+	}
+
 	selector->bson_count += sub_selector->bson_count;
 
 	return TRUE;
@@ -230,3 +431,120 @@ j_db_selector_add_selector(JDBSelector* selector, JDBSelector* sub_selector, GEr
 _error:
 	return FALSE;
 }
+
+gboolean
+j_db_selector_prepare(JDBSelector* selector, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* shape = NULL;
+	JDBTypeValue val;
+
+	g_return_val_if_fail(selector != NULL, FALSE);
+	g_return_val_if_fail(!selector->prepared, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (G_UNLIKELY(!selector->bson_count))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_SELECTOR_EMPTY, "selector must not be emoty");
+		goto _error;
+	}
+
+	// No values have been bound yet, so selectors of the same shape have the same BSON
+	shape = g_compute_checksum_for_data(G_CHECKSUM_SHA1, bson_get_data(&selector->bson), selector->bson.len);
+	val.val_string = shape;
+
+	if (G_UNLIKELY(!j_bson_append_value(&selector->bson, "_shape", J_DB_TYPE_STRING, &val, error)))
+	{
+		goto _error;
+	}
+
+	selector->prepared = TRUE;
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+gboolean
+j_db_selector_bind(JDBSelector* selector, guint32 index, gconstpointer value, guint64 length, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBSelectorParameter const* parameter;
+	JDBTypeValue val;
+	bson_iter_t iter;
+	bson_iter_t iter_value;
+	bson_t copy[1];
+
+	g_return_val_if_fail(selector != NULL, FALSE);
+	g_return_val_if_fail(selector->prepared, FALSE);
+	g_return_val_if_fail(index < selector->parameters->len, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	parameter = &g_array_index(selector->parameters, JDBSelectorParameter, index);
+
+	j_db_selector_value_set(parameter->type, value, length, &val);
+
+	if (parameter->type == J_DB_TYPE_STRING || parameter->type == J_DB_TYPE_BLOB)
+	{
+		bson_init(copy);
+
+		if (G_UNLIKELY(!j_db_selector_replace_value(&selector->bson, copy, parameter->path, parameter->type, &val, error)))
+		{
+			bson_destroy(copy);
+			goto _error;
+		}
+
+		bson_reinit(&selector->bson);
+		bson_concat(&selector->bson, copy);
+		bson_destroy(copy);
+
+		return TRUE;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, &selector->bson, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!bson_iter_find_descendant(&iter, parameter->path, &iter_value)))
+	{
+		g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_KEY_NOT_FOUND, "bson iter can not find key");
+		goto _error;
+	}
+
+	// Fixed-size values are overwritten in place
+	switch (parameter->type)
+	{
+		case J_DB_TYPE_SINT32:
+			bson_iter_overwrite_int32(&iter_value, val.val_sint32);
+			break;
+		case J_DB_TYPE_UINT32:
+			bson_iter_overwrite_int32(&iter_value, val.val_uint32);
+			break;
+		case J_DB_TYPE_SINT64:
+			bson_iter_overwrite_int64(&iter_value, val.val_sint64);
+			break;
+		case J_DB_TYPE_UINT64:
+			bson_iter_overwrite_int64(&iter_value, val.val_uint64);
+			break;
+		case J_DB_TYPE_FLOAT32:
+			bson_iter_overwrite_double(&iter_value, val.val_float32);
+			break;
+		case J_DB_TYPE_FLOAT64:
+			bson_iter_overwrite_double(&iter_value, val.val_float64);
+			break;
+		case J_DB_TYPE_STRING:
+		case J_DB_TYPE_BLOB:
+		case J_DB_TYPE_ID:
+		default:
+			g_assert_not_reached();
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
@@ -40,23 +40,20 @@ static JBackend* j_db_backend = NULL;
 static GModule* j_db_module = NULL;
 
 // FIXME copy and use GLib's G_DEFINE_CONSTRUCTOR/DESTRUCTOR
-static void __attribute__((constructor)) j_db_init(void);
 static void __attribute__((destructor)) j_db_fini(void);
 
 /**
  * Initializes the db client.
+ * Called on first use by j_db_get_backend(), so that processes not using the db client do not load its backend.
  */
-static void
-j_db_init(void)
+static gpointer
+j_db_init(gpointer data)
 {
 	gchar const* db_backend;
 	gchar const* db_component;
 	gchar const* db_path;
 
-	if (j_db_backend != NULL && j_db_module != NULL)
-	{
-		return;
-	}
+	(void)data;
 
 	db_backend = j_configuration_get_backend(j_configuration(), J_BACKEND_TYPE_DB);
 	db_component = j_configuration_get_backend_component(j_configuration(), J_BACKEND_TYPE_DB);
@@ -69,6 +66,8 @@ j_db_init(void)
 			g_critical("Could not initialize db backend %s.\n", db_backend);
 		}
 	}
+
+	return NULL;
 }
 
 /**
@@ -103,6 +102,10 @@ j_db_fini(void)
 JBackend*
 j_db_get_backend(void)
 {
+	static GOnce once = G_ONCE_INIT;
+
+	g_once(&once, j_db_init, NULL);
+
 	return j_db_backend;
 }
 
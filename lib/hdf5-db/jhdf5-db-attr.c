@@ -44,6 +44,11 @@
 
 static JDBSchema* julea_db_schema_attr = NULL;
 
+/**
+ * The fields of an attribute row that are needed to open the attribute.
+ **/
+static gchar const* const julea_db_attr_fields[] = { "space", "datatype", NULL };
+
 static herr_t
 H5VL_julea_db_attr_term(void)
 {
@@ -375,10 +380,10 @@ H5VL_julea_db_attr_open(void* obj, const H5VL_loc_params_t* loc_params, const ch
 	g_autoptr(JDBSelector) selector = NULL;
 	g_autofree void* space_id_buf = NULL;
 	g_autofree void* datatype_id_buf = NULL;
+	g_autoptr(GHashTable) row = NULL;
 	JHDF5Object_t* object = NULL;
 	JHDF5Object_t* parent = obj;
 	JHDF5Object_t* file;
-	JDBType type;
 	guint64 space_id_buf_len;
 	guint64 datatype_id_buf_len;
 
@@ -437,48 +442,56 @@ H5VL_julea_db_attr_open(void* obj, const H5VL_loc_params_t* loc_params, const ch
 		j_goto_error();
 	}
 
-	if (!(selector = j_db_selector_new(julea_db_schema_attr, J_DB_SELECTOR_MODE_AND, &error)))
+	if ((row = H5VL_julea_db_prefetch_get_attr(file, object->backend_id, object->backend_id_len)) != NULL)
 	{
-		j_goto_error();
+		g_hash_table_ref(row);
 	}
-
-	if (!j_db_selector_add_field(selector, "_id", J_DB_SELECTOR_OPERATOR_EQ, object->backend_id, object->backend_id_len, &error))
+	else
 	{
-		j_goto_error();
-	}
+		if (!(selector = j_db_selector_new(julea_db_schema_attr, J_DB_SELECTOR_MODE_AND, &error)))
+		{
+			j_goto_error();
+		}
 
-	if (!(iterator = j_db_iterator_new(julea_db_schema_attr, selector, &error)))
-	{
-		j_goto_error();
-	}
+		if (!j_db_selector_add_field(selector, "_id", J_DB_SELECTOR_OPERATOR_EQ, object->backend_id, object->backend_id_len, &error))
+		{
+			j_goto_error();
+		}
 
-	if (!j_db_iterator_next(iterator, &error))
-	{
-		j_goto_error();
+		if (!(iterator = j_db_iterator_new(julea_db_schema_attr, selector, &error)))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_iterator_next(iterator, &error))
+		{
+			j_goto_error();
+		}
+
+		row = H5VL_julea_db_row_new(iterator, julea_db_attr_fields);
+		g_assert(!j_db_iterator_next(iterator, NULL));
 	}
 
-	if (!j_db_iterator_get_field(iterator, "space", &type, &space_id_buf, &space_id_buf_len, &error))
+	if (!H5VL_julea_db_row_get_field(row, "space", &space_id_buf, &space_id_buf_len))
 	{
 		j_goto_error();
 	}
 
-	if (!(object->attr.space = H5VL_julea_db_space_decode(space_id_buf, space_id_buf_len)))
+	if (!(object->attr.space = H5VL_julea_db_prefetch_get_space(file, space_id_buf, space_id_buf_len)))
 	{
 		j_goto_error();
 	}
 
-	if (!j_db_iterator_get_field(iterator, "datatype", &type, &datatype_id_buf, &datatype_id_buf_len, &error))
+	if (!H5VL_julea_db_row_get_field(row, "datatype", &datatype_id_buf, &datatype_id_buf_len))
 	{
 		j_goto_error();
 	}
 
-	if (!(object->attr.datatype = H5VL_julea_db_datatype_decode(datatype_id_buf, datatype_id_buf_len)))
+	if (!(object->attr.datatype = H5VL_julea_db_prefetch_get_datatype(file, datatype_id_buf, datatype_id_buf_len)))
 	{
 		j_goto_error();
 	}
 
-	g_assert(!j_db_iterator_next(iterator, NULL));
-
 	j_hdf5_log(file->file.name, "a", 'O', NULL, object, parent);
 	return object;
 
@@ -500,11 +513,12 @@ H5VL_julea_db_attr_read(void* obj, hid_t mem_type_id, void* buf, hid_t dxpl_id,
 	g_autoptr(JDBSelector) selector = NULL;
 	guint64 bytes_read;
 	gsize data_size;
+	gsize mem_size;
+	guint64 data_count;
 	g_autofree gpointer tmp = NULL;
 	JHDF5Object_t* object = obj;
 	JDBType type;
 
-	(void)mem_type_id;
 	(void)dxpl_id;
 	(void)req;
 
@@ -512,8 +526,9 @@ H5VL_julea_db_attr_read(void* obj, hid_t mem_type_id, void* buf, hid_t dxpl_id,
 	g_return_val_if_fail(object->type == J_HDF5_OBJECT_TYPE_ATTR, 1);
 
 	bytes_read = 0;
-	data_size = object->dataset.datatype->datatype.type_total_size;
-	data_size *= object->attr.space->space.dim_total_count;
+	data_count = object->attr.space->space.dim_total_count;
+	data_size = object->attr.datatype->datatype.type_total_size * data_count;
+	mem_size = H5Tget_size(mem_type_id) * data_count;
 
 	if (!(selector = j_db_selector_new(julea_db_schema_attr, J_DB_SELECTOR_MODE_AND, &error)))
 	{
@@ -543,7 +558,18 @@ H5VL_julea_db_attr_read(void* obj, hid_t mem_type_id, void* buf, hid_t dxpl_id,
 	g_assert(!j_db_iterator_next(iterator, NULL));
 	g_assert_cmpuint(data_size, ==, bytes_read);
 
-	memcpy(buf, tmp, bytes_read);
+	// The data is converted in place, so the buffer has to be able to hold both representations
+	if (mem_size > data_size)
+	{
+		tmp = g_realloc(tmp, mem_size);
+	}
+
+	if (!H5VL_julea_db_datatype_convert(object->attr.datatype->datatype.hdf5_id, mem_type_id, tmp, data_count))
+	{
+		j_goto_error();
+	}
+
+	memcpy(buf, tmp, mem_size);
 
 	j_hdf5_log(object->attr.file->file.name, "a", 'R', NULL, object, NULL);
 	return 0;
@@ -561,19 +587,36 @@ H5VL_julea_db_attr_write(void* obj, hid_t mem_type_id, const void* buf, hid_t dx
 	g_autoptr(JBatch) batch = NULL;
 	g_autoptr(JDBEntry) entry = NULL;
 	g_autoptr(JDBSelector) selector = NULL;
+	g_autofree gchar* converted = NULL;
 	gsize data_size;
+	gsize mem_size;
+	guint64 data_count;
 	JHDF5Object_t* object = obj;
+	JHDF5Request_t* request = NULL;
 
-	(void)mem_type_id;
 	(void)dxpl_id;
-	(void)req;
 
 	g_return_val_if_fail(buf != NULL, 1);
 	g_return_val_if_fail(object->type == J_HDF5_OBJECT_TYPE_ATTR, 1);
 
 	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
-	data_size = object->dataset.datatype->datatype.type_total_size;
-	data_size *= object->attr.space->space.dim_total_count;
+	data_count = object->attr.space->space.dim_total_count;
+	data_size = object->attr.datatype->datatype.type_total_size * data_count;
+	mem_size = H5Tget_size(mem_type_id) * data_count;
+
+	if (H5Tequal(mem_type_id, object->attr.datatype->datatype.hdf5_id) <= 0)
+	{
+		// The data is converted in place, so the buffer has to be able to hold both representations
+		converted = g_malloc(MAX(data_size, mem_size));
+		memcpy(converted, buf, mem_size);
+
+		if (!H5VL_julea_db_datatype_convert(mem_type_id, object->attr.datatype->datatype.hdf5_id, converted, data_count))
+		{
+			j_goto_error();
+		}
+
+		buf = converted;
+	}
 
 	if (!(selector = j_db_selector_new(julea_db_schema_attr, J_DB_SELECTOR_MODE_AND, &error)))
 	{
@@ -610,12 +653,15 @@ H5VL_julea_db_attr_write(void* obj, hid_t mem_type_id, const void* buf, hid_t dx
 		j_goto_error();
 	}
 
-	if (!j_db_entry_update(entry, selector, batch, &error))
+	// The entry holds a copy of the data, so the update can complete in the background
+	request = H5VL_julea_db_request_new(req, object);
+
+	if (!j_db_entry_update(entry, selector, batch, H5VL_julea_db_request_get_error(request, &error)))
 	{
 		j_goto_error();
 	}
 
-	if (!j_batch_execute(batch))
+	if (!H5VL_julea_db_request_execute(g_steal_pointer(&request), batch, NULL, NULL, NULL, req))
 	{
 		j_goto_error();
 	}
@@ -624,6 +670,11 @@ H5VL_julea_db_attr_write(void* obj, hid_t mem_type_id, const void* buf, hid_t dx
 	return 0;
 
 _error:
+	if (request != NULL)
+	{
+		H5VL_julea_db_request_free(request);
+	}
+
 	return 1;
 }
 
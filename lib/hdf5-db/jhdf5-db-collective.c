@@ -0,0 +1,519 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2019 Benjamin Warnke
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Collective writes for files opened using the MPI-IO file driver.
+ *
+ * All ranks exchange their selections and a subset of aggregator ranks issues large writes.
+ * The written range is split into stripe-aligned file domains, one per aggregator,
+ * so that each aggregator talks to as few object servers as possible.
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <hdf5.h>
+#include <H5PLextern.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <julea.h>
+#include <julea-object.h>
+
+#include "jhdf5-db.h"
+
+/**
+ * A contiguous range of bytes within a dataset's object.
+ **/
+struct JHDF5Extent
+{
+	guint64 offset;
+	guint64 length;
+	gchar const* data;
+};
+
+typedef struct JHDF5Extent JHDF5Extent;
+
+#ifdef H5_HAVE_PARALLEL
+
+static gint
+H5VL_julea_db_extent_compare(gconstpointer a, gconstpointer b)
+{
+	JHDF5Extent const* extent_a = a;
+	JHDF5Extent const* extent_b = b;
+
+	if (extent_a->offset != extent_b->offset)
+	{
+		return (extent_a->offset < extent_b->offset) ? -1 : 1;
+	}
+
+	// Overlapping data of later ranks wins
+	if (extent_a->data != extent_b->data)
+	{
+		return (extent_a->data < extent_b->data) ? -1 : 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Returns the number of aggregators to use.
+ * The number defaults to the number of object servers and can be overridden by setting JULEA_HDF5_DB_AGGREGATORS.
+ *
+ * \param size    The number of ranks.
+ * \param stripes The number of stripes in the written range.
+ **/
+static guint
+H5VL_julea_db_collective_get_aggregators(gint size, guint64 stripes)
+{
+	gchar const* env;
+	guint64 aggregators;
+
+	if ((env = g_getenv("JULEA_HDF5_DB_AGGREGATORS")) != NULL)
+	{
+		aggregators = g_ascii_strtoull(env, NULL, 10);
+	}
+	else
+	{
+		aggregators = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
+	}
+
+	aggregators = CLAMP(aggregators, 1, (guint64)size);
+	aggregators = MIN(aggregators, stripes);
+
+	return aggregators;
+}
+
+/**
+ * Combines the statistics of all ranks.
+ **/
+static void
+H5VL_julea_db_collective_statistics(MPI_Comm comm, JHDF5Statistics* statistics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	MPI_Allreduce(MPI_IN_PLACE, &statistics->min_value_i, 1, MPI_INT64_T, MPI_MIN, comm);
+	MPI_Allreduce(MPI_IN_PLACE, &statistics->max_value_i, 1, MPI_INT64_T, MPI_MAX, comm);
+	MPI_Allreduce(MPI_IN_PLACE, &statistics->min_value_f, 1, MPI_DOUBLE, MPI_MIN, comm);
+	MPI_Allreduce(MPI_IN_PLACE, &statistics->max_value_f, 1, MPI_DOUBLE, MPI_MAX, comm);
+}
+
+/**
+ * Merges the extents received by an aggregator and writes them.
+ * Extents that touch or overlap are combined, so each contiguous range is written using a single operation.
+ *
+ * \param object  The object.
+ * \param extents The received extents.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+H5VL_julea_db_collective_flush(JDistributedObject* object, GArray* extents)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(GPtrArray) buffers = NULL;
+	guint64 bytes_written;
+	guint i;
+
+	if (extents->len == 0)
+	{
+		return TRUE;
+	}
+
+	g_array_sort(extents, H5VL_julea_db_extent_compare);
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffers = g_ptr_array_new_with_free_func(g_free);
+	bytes_written = 0;
+
+	for (i = 0; i < extents->len;)
+	{
+		JHDF5Extent* first = &g_array_index(extents, JHDF5Extent, i);
+		gchar* run;
+		guint64 run_end;
+		guint j;
+
+		run_end = first->offset + first->length;
+
+		for (j = i + 1; j < extents->len; j++)
+		{
+			JHDF5Extent* extent = &g_array_index(extents, JHDF5Extent, j);
+
+			if (extent->offset > run_end)
+			{
+				break;
+			}
+
+			run_end = MAX(run_end, extent->offset + extent->length);
+		}
+
+		run = g_malloc(run_end - first->offset);
+		g_ptr_array_add(buffers, run);
+
+		for (; i < j; i++)
+		{
+			JHDF5Extent* extent = &g_array_index(extents, JHDF5Extent, i);
+
+			memcpy(run + (extent->offset - first->offset), extent->data, extent->length);
+		}
+
+		j_distributed_object_write(object, run, run_end - first->offset, first->offset, &bytes_written, batch);
+	}
+
+	return j_batch_execute(batch);
+}
+
+/**
+ * Writes extents collectively.
+ *
+ * All ranks of \p comm have to call this function.
+ * Ranks that do not write anything pass an empty array.
+ * The written range is only known after exchanging the extents' bounds,
+ * so the decision whether to aggregate is made collectively, too.
+ *
+ * \param comm    The communicator.
+ * \param object  The object.
+ * \param extents The extents to write, sorted by their offset.
+ * \param handled Returns whether the extents have been written.
+ *                If FALSE, the write could not be aggregated and the caller has to write the extents itself.
+ *
+ * \return TRUE on success, FALSE if an error occurred on any rank.
+ **/
+static gboolean
+H5VL_julea_db_collective_write_extents(MPI_Comm comm, JDistributedObject* object, GArray* extents, gboolean* handled)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GArray) slices = NULL;
+	g_autoptr(GArray) received = NULL;
+	g_autofree guint64* aggregator_bytes = NULL;
+	g_autofree guint64* aggregator_totals = NULL;
+	g_autofree int* send_info = NULL;
+	g_autofree int* recv_info = NULL;
+	g_autofree int* counts = NULL;
+	g_autofree guint64* send_descriptors = NULL;
+	g_autofree guint64* recv_descriptors = NULL;
+	g_autofree gchar* send_data = NULL;
+	g_autofree gchar* recv_data = NULL;
+	guint64 local[3];
+	guint64 global[3];
+	guint64 start;
+	guint64 end;
+	guint64 stripe_size;
+	guint64 domain_size;
+	guint64 recv_descriptor_count;
+	guint64 recv_bytes;
+	guint aggregators;
+	gint size;
+	gint rank;
+	int success;
+
+	*handled = FALSE;
+
+	MPI_Comm_size(comm, &size);
+	MPI_Comm_rank(comm, &rank);
+
+	// The lowest offset is inverted, so all bounds can be reduced using a single operation
+	local[0] = 0;
+	local[1] = 0;
+	local[2] = 0;
+
+	for (guint i = 0; i < extents->len; i++)
+	{
+		JHDF5Extent* extent = &g_array_index(extents, JHDF5Extent, i);
+
+		local[0] = MAX(local[0], G_MAXUINT64 - extent->offset);
+		local[1] = MAX(local[1], extent->offset + extent->length);
+		local[2] += extent->length;
+	}
+
+	MPI_Allreduce(local, global, 3, MPI_UINT64_T, MPI_MAX, comm);
+
+	start = G_MAXUINT64 - global[0];
+	end = global[1];
+
+	if (end <= start)
+	{
+		// No rank writes anything
+		*handled = TRUE;
+		return TRUE;
+	}
+
+	// MPI counts and displacements are limited to int
+	if (global[2] > G_MAXINT)
+	{
+		return TRUE;
+	}
+
+	stripe_size = j_configuration_get_stripe_size(j_configuration());
+	start -= start % stripe_size;
+
+	aggregators = H5VL_julea_db_collective_get_aggregators(size, (end - start + stripe_size - 1) / stripe_size);
+	domain_size = (end - start + aggregators - 1) / aggregators;
+	domain_size = (domain_size + stripe_size - 1) / stripe_size * stripe_size;
+
+	// Split the extents at the domain boundaries
+	slices = g_array_new(FALSE, FALSE, sizeof(JHDF5Extent));
+	aggregator_bytes = g_new0(guint64, aggregators);
+	aggregator_totals = g_new0(guint64, aggregators);
+	send_info = g_new0(int, 2 * size);
+	recv_info = g_new0(int, 2 * size);
+
+	for (guint i = 0; i < extents->len; i++)
+	{
+		JHDF5Extent extent = g_array_index(extents, JHDF5Extent, i);
+
+		while (extent.length > 0)
+		{
+			JHDF5Extent slice;
+			guint aggregator;
+			gint aggregator_rank;
+
+			aggregator = (extent.offset - start) / domain_size;
+			aggregator_rank = (gint)((guint64)aggregator * size / aggregators);
+
+			slice.offset = extent.offset;
+			slice.length = MIN(extent.length, start + (aggregator + 1) * domain_size - extent.offset);
+			slice.data = extent.data;
+			g_array_append_val(slices, slice);
+
+			aggregator_bytes[aggregator] += slice.length;
+			send_info[2 * aggregator_rank] += 2;
+			send_info[2 * aggregator_rank + 1] += slice.length;
+
+			extent.offset += slice.length;
+			extent.length -= slice.length;
+			extent.data += slice.length;
+		}
+	}
+
+	MPI_Allreduce(aggregator_bytes, aggregator_totals, aggregators, MPI_UINT64_T, MPI_SUM, comm);
+
+	for (guint i = 0; i < aggregators; i++)
+	{
+		// Overlapping selections might make an aggregator receive more than its domain
+		if (aggregator_totals[i] > G_MAXINT)
+		{
+			return TRUE;
+		}
+	}
+
+	MPI_Alltoall(send_info, 2, MPI_INT, recv_info, 2, MPI_INT, comm);
+
+	// Pack the descriptors and data, slices are ordered by aggregator and thus by destination rank
+	send_descriptors = g_new(guint64, 2 * slices->len + 1);
+	send_data = g_malloc(local[2] + 1);
+
+	for (guint i = 0, position = 0; i < slices->len; i++)
+	{
+		JHDF5Extent* slice = &g_array_index(slices, JHDF5Extent, i);
+
+		send_descriptors[2 * i] = slice->offset;
+		send_descriptors[2 * i + 1] = slice->length;
+		memcpy(send_data + position, slice->data, slice->length);
+		position += slice->length;
+	}
+
+	// Counts and displacements for descriptors and data, in that order
+	counts = g_new(int, 8 * size);
+	recv_descriptor_count = 0;
+	recv_bytes = 0;
+
+	for (gint i = 0, send_descriptor_count = 0, send_bytes = 0; i < size; i++)
+	{
+		counts[i] = send_info[2 * i];
+		counts[size + i] = send_descriptor_count;
+		counts[2 * size + i] = recv_info[2 * i];
+		counts[3 * size + i] = recv_descriptor_count;
+		counts[4 * size + i] = send_info[2 * i + 1];
+		counts[5 * size + i] = send_bytes;
+		counts[6 * size + i] = recv_info[2 * i + 1];
+		counts[7 * size + i] = recv_bytes;
+
+		send_descriptor_count += send_info[2 * i];
+		send_bytes += send_info[2 * i + 1];
+		recv_descriptor_count += recv_info[2 * i];
+		recv_bytes += recv_info[2 * i + 1];
+	}
+
+	recv_descriptors = g_new(guint64, recv_descriptor_count + 1);
+	recv_data = g_malloc(recv_bytes + 1);
+
+	MPI_Alltoallv(send_descriptors, counts, counts + size, MPI_UINT64_T, recv_descriptors, counts + 2 * size, counts + 3 * size, MPI_UINT64_T, comm);
+	MPI_Alltoallv(send_data, counts + 4 * size, counts + 5 * size, MPI_BYTE, recv_data, counts + 6 * size, counts + 7 * size, MPI_BYTE, comm);
+
+	// Descriptors and data are received in rank order, so the data of an extent follows the data of the previous one
+	received = g_array_sized_new(FALSE, FALSE, sizeof(JHDF5Extent), recv_descriptor_count / 2);
+
+	for (guint64 i = 0, position = 0; i < recv_descriptor_count; i += 2)
+	{
+		JHDF5Extent extent;
+
+		extent.offset = recv_descriptors[i];
+		extent.length = recv_descriptors[i + 1];
+		extent.data = recv_data + position;
+		g_array_append_val(received, extent);
+
+		position += extent.length;
+	}
+
+	success = H5VL_julea_db_collective_flush(object, received);
+	MPI_Allreduce(MPI_IN_PLACE, &success, 1, MPI_INT, MPI_LAND, comm);
+
+	*handled = TRUE;
+
+	return success;
+}
+
+#endif
+
+/**
+ * Looks up the MPI communicator of a file opened using the MPI-IO file driver.
+ *
+ * \param file    The file.
+ * \param fapl_id The file access property list.
+ **/
+static void
+H5VL_julea_db_collective_file_init(JHDF5Object_t* file, hid_t fapl_id)
+{
+	J_TRACE_FUNCTION(NULL);
+
+#ifdef H5_HAVE_PARALLEL
+	MPI_Comm comm;
+	MPI_Info info;
+
+	file->file.comm = NULL;
+
+	if (H5Pget_driver(fapl_id) != H5FD_MPIO)
+	{
+		return;
+	}
+
+	// Returns duplicates of the communicator and info object
+	if (H5Pget_fapl_mpio(fapl_id, &comm, &info) < 0)
+	{
+		return;
+	}
+
+	if (info != MPI_INFO_NULL)
+	{
+		MPI_Info_free(&info);
+	}
+
+	file->file.comm = g_new(MPI_Comm, 1);
+	*(file->file.comm) = comm;
+#else
+	(void)file;
+	(void)fapl_id;
+#endif
+}
+
+static void
+H5VL_julea_db_collective_file_fini(JHDF5Object_t* file)
+{
+	J_TRACE_FUNCTION(NULL);
+
+#ifdef H5_HAVE_PARALLEL
+	if (file->file.comm != NULL)
+	{
+		MPI_Comm_free(file->file.comm);
+		g_free(file->file.comm);
+		file->file.comm = NULL;
+	}
+#else
+	(void)file;
+#endif
+}
+
+/**
+ * Returns whether a dataset should be written collectively.
+ * This is the case for contiguous datasets of files opened using the MPI-IO file driver if collective transfers are requested.
+ * The result only depends on collectively set properties, so all ranks arrive at the same decision.
+ *
+ * \param object        The dataset.
+ * \param xfer_plist_id The data transfer property list.
+ **/
+static gboolean
+H5VL_julea_db_collective_enabled(JHDF5Object_t* object, hid_t xfer_plist_id)
+{
+	J_TRACE_FUNCTION(NULL);
+
+#ifdef H5_HAVE_PARALLEL
+	H5FD_mpio_xfer_t mode;
+
+	g_return_val_if_fail(object->type == J_HDF5_OBJECT_TYPE_DATASET, FALSE);
+
+	if (object->dataset.file->file.comm == NULL || object->dataset.chunks.rank > 0)
+	{
+		return FALSE;
+	}
+
+	if (H5Pget_dxpl_mpio(xfer_plist_id, &mode) < 0)
+	{
+		return FALSE;
+	}
+
+	return (mode == H5FD_MPIO_COLLECTIVE);
+#else
+	(void)object;
+	(void)xfer_plist_id;
+
+	return FALSE;
+#endif
+}
+
+/**
+ * Writes a dataset's extents collectively.
+ * The dataset's statistics are combined across all ranks.
+ *
+ * \param object  The dataset.
+ * \param extents The extents to write, sorted by their offset.
+ * \param handled Returns whether the extents have been written.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+H5VL_julea_db_collective_write(JHDF5Object_t* object, GArray* extents, gboolean* handled)
+{
+	J_TRACE_FUNCTION(NULL);
+
+#ifdef H5_HAVE_PARALLEL
+	MPI_Comm comm;
+
+	g_return_val_if_fail(object->type == J_HDF5_OBJECT_TYPE_DATASET, FALSE);
+
+	comm = *(object->dataset.file->file.comm);
+
+	H5VL_julea_db_collective_statistics(comm, &object->dataset.statistics);
+
+	return H5VL_julea_db_collective_write_extents(comm, object->dataset.object, extents, handled);
+#else
+	(void)object;
+	(void)extents;
+
+	*handled = FALSE;
+
+	return TRUE;
+#endif
+}
@@ -43,6 +43,149 @@
 #include "jhdf5-db.h"
 
 static JDBSchema* julea_db_schema_dataset = NULL;
+static JDBSchema* julea_db_schema_chunk = NULL;
+
+/**
+ * The fields of a dataset row that are needed to open the dataset.
+ **/
+static gchar const* const julea_db_dataset_fields[] = { "min_value_i", "max_value_i", "min_value_f", "max_value_f", "space", "datatype", "layout", "chunk_dims", "filters", NULL };
+
+/**
+ * Creates or loads the chunk index schema.
+ * The chunk index records which chunks of a chunked dataset have been allocated, how large their stored, possibly filtered, data is and which values they contain.
+ **/
+static gboolean
+H5VL_julea_db_dataset_chunk_schema_init(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(GError) error = NULL;
+
+	if (!(batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT)))
+	{
+		j_goto_error();
+	}
+
+	if (!(julea_db_schema_chunk = j_db_schema_new(JULEA_HDF5_DB_NAMESPACE, "chunk", NULL)))
+	{
+		j_goto_error();
+	}
+
+	if (!(j_db_schema_get(julea_db_schema_chunk, batch, &error) && j_batch_execute(batch)))
+	{
+		if (error == NULL || error->code != J_BACKEND_DB_ERROR_SCHEMA_NOT_FOUND)
+		{
+			g_assert_not_reached();
+			j_goto_error();
+		}
+
+		g_error_free(error);
+		error = NULL;
+
+		j_db_schema_unref(julea_db_schema_chunk);
+
+		if (!(julea_db_schema_chunk = j_db_schema_new(JULEA_HDF5_DB_NAMESPACE, "chunk", NULL)))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_schema_add_field(julea_db_schema_chunk, "file", J_DB_TYPE_ID, &error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_schema_add_field(julea_db_schema_chunk, "dataset", J_DB_TYPE_ID, &error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_schema_add_field(julea_db_schema_chunk, "chunk_index", J_DB_TYPE_UINT64, &error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_schema_add_field(julea_db_schema_chunk, "chunk_size", J_DB_TYPE_UINT64, &error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_schema_add_field(julea_db_schema_chunk, "min_value_f", J_DB_TYPE_FLOAT64, &error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_schema_add_field(julea_db_schema_chunk, "max_value_f", J_DB_TYPE_FLOAT64, &error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_schema_add_field(julea_db_schema_chunk, "min_value_i", J_DB_TYPE_SINT64, &error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_schema_add_field(julea_db_schema_chunk, "max_value_i", J_DB_TYPE_SINT64, &error))
+		{
+			j_goto_error();
+		}
+
+		{
+			const gchar* index_file[] = {
+				"file",
+				NULL,
+			};
+			const gchar* index_dataset[] = {
+				"dataset",
+				NULL,
+			};
+
+			if (!j_db_schema_add_index(julea_db_schema_chunk, index_file, &error))
+			{
+				j_goto_error();
+			}
+
+			if (!j_db_schema_add_index(julea_db_schema_chunk, index_dataset, &error))
+			{
+				j_goto_error();
+			}
+		}
+
+		if (!j_db_schema_create(julea_db_schema_chunk, batch, &error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_batch_execute(batch))
+		{
+			j_goto_error();
+		}
+
+		j_db_schema_unref(julea_db_schema_chunk);
+
+		if (!(julea_db_schema_chunk = j_db_schema_new(JULEA_HDF5_DB_NAMESPACE, "chunk", NULL)))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_schema_get(julea_db_schema_chunk, batch, &error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_batch_execute(batch))
+		{
+			j_goto_error();
+		}
+	}
+
+	return TRUE;
+
+_error:
+	H5VL_julea_db_error_handler(error);
+
+	return FALSE;
+}
 
 static herr_t
 H5VL_julea_db_dataset_term(void)
@@ -55,6 +198,12 @@ H5VL_julea_db_dataset_term(void)
 		julea_db_schema_dataset = NULL;
 	}
 
+	if (julea_db_schema_chunk != NULL)
+	{
+		j_db_schema_unref(julea_db_schema_chunk);
+		julea_db_schema_chunk = NULL;
+	}
+
 	return 0;
 }
 
@@ -68,6 +217,11 @@ H5VL_julea_db_dataset_init(hid_t vipl_id)
 
 	(void)vipl_id;
 
+	if (!H5VL_julea_db_dataset_chunk_schema_init())
+	{
+		j_goto_error();
+	}
+
 	if (!(batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT)))
 	{
 		j_goto_error();
@@ -132,6 +286,21 @@ H5VL_julea_db_dataset_init(hid_t vipl_id)
 					j_goto_error();
 				}
 
+				if (!j_db_schema_add_field(julea_db_schema_dataset, "layout", J_DB_TYPE_UINT32, &error))
+				{
+					j_goto_error();
+				}
+
+				if (!j_db_schema_add_field(julea_db_schema_dataset, "chunk_dims", J_DB_TYPE_BLOB, &error))
+				{
+					j_goto_error();
+				}
+
+				if (!j_db_schema_add_field(julea_db_schema_dataset, "filters", J_DB_TYPE_BLOB, &error))
+				{
+					j_goto_error();
+				}
+
 				{
 					const gchar* index[] = {
 						"file",
@@ -201,9 +370,11 @@ H5VL_julea_db_dataset_truncate_file(void* obj)
 	J_TRACE_FUNCTION(NULL);
 
 	g_autoptr(JDBSelector) selector = NULL;
+	g_autoptr(JDBSelector) chunk_selector = NULL;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(JBatch) batch = NULL;
 	g_autoptr(JDBEntry) entry = NULL;
+	g_autoptr(JDBEntry) chunk_entry = NULL;
 	JHDF5Object_t* file = obj;
 
 	g_return_val_if_fail(file != NULL, 1);
@@ -240,193 +411,469 @@ H5VL_julea_db_dataset_truncate_file(void* obj)
 		{
 			j_goto_error();
 		}
-	}
-
-	return 0;
-
-_error:
-	H5VL_julea_db_error_handler(error);
-
-	return 1;
-}
-
-static void*
-H5VL_julea_db_dataset_create(void* obj, const H5VL_loc_params_t* loc_params, const char* name, hid_t lcpl_id, hid_t type_id, hid_t space_id, hid_t dcpl_id, hid_t dapl_id, hid_t dxpl_id, void** req)
-{
-	J_TRACE_FUNCTION(NULL);
-
-	g_autoptr(GError) error = NULL;
-	g_autoptr(JBatch) batch = NULL;
-	g_autoptr(JDBEntry) entry = NULL;
-	g_autofree char* hex_buf = NULL;
-	JHDF5Object_t* object = NULL;
-	JHDF5Object_t* parent = obj;
-	JHDF5Object_t* file;
-
-	(void)loc_params;
-	(void)lcpl_id;
-	(void)dcpl_id;
-	(void)dapl_id;
-	(void)dxpl_id;
-	(void)req;
-
-	g_return_val_if_fail(name != NULL, NULL);
-	g_return_val_if_fail(parent != NULL, NULL);
 
-	switch (parent->type)
-	{
-		case J_HDF5_OBJECT_TYPE_FILE:
-			file = parent;
-			break;
-		case J_HDF5_OBJECT_TYPE_DATASET:
-			file = parent->dataset.file;
-			break;
-		case J_HDF5_OBJECT_TYPE_ATTR:
-			file = parent->attr.file;
-			break;
-		case J_HDF5_OBJECT_TYPE_GROUP:
-			file = parent->group.file;
-			break;
-		case J_HDF5_OBJECT_TYPE_DATATYPE:
-		case J_HDF5_OBJECT_TYPE_SPACE:
-		case _J_HDF5_OBJECT_TYPE_COUNT:
-		default:
-			g_assert_not_reached();
-			j_goto_error();
+		g_clear_error(&error);
 	}
 
-	if (!(batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT)))
+	if (!(chunk_selector = j_db_selector_new(julea_db_schema_chunk, J_DB_SELECTOR_MODE_AND, &error)))
 	{
 		j_goto_error();
 	}
 
-	if (!(object = H5VL_julea_db_object_new(J_HDF5_OBJECT_TYPE_DATASET)))
+	if (!j_db_selector_add_field(chunk_selector, "file", J_DB_SELECTOR_OPERATOR_EQ, file->backend_id, file->backend_id_len, &error))
 	{
 		j_goto_error();
 	}
 
-	object->dataset.statistics.min_value_i = 0;
-	object->dataset.statistics.max_value_i = 0;
-	object->dataset.statistics.min_value_f = 0;
-	object->dataset.statistics.max_value_f = 0;
-
-	if (!(object->dataset.name = g_strdup(name)))
+	if (!(chunk_entry = j_db_entry_new(julea_db_schema_chunk, &error)))
 	{
 		j_goto_error();
 	}
 
-	if (!(object->dataset.file = H5VL_julea_db_object_ref(file)))
+	if (!j_db_entry_delete(chunk_entry, chunk_selector, batch, &error))
 	{
 		j_goto_error();
 	}
 
-	if (!(object->dataset.datatype = H5VL_julea_db_datatype_encode(&type_id)))
+	if (!j_batch_execute(batch))
 	{
-		j_goto_error();
+		if (!error || error->code != J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS)
+		{
+			j_goto_error();
+		}
 	}
 
-	if (!(object->dataset.space = H5VL_julea_db_space_encode(&space_id)))
-	{
-		j_goto_error();
-	}
+	return 0;
 
-	if (!(entry = j_db_entry_new(julea_db_schema_dataset, &error)))
-	{
-		j_goto_error();
-	}
+_error:
+	H5VL_julea_db_error_handler(error);
 
-	if (!j_db_entry_set_field(entry, "file", file->backend_id, file->backend_id_len, &error))
-	{
-		j_goto_error();
-	}
+	return 1;
+}
 
-	if (!j_db_entry_set_field(entry, "datatype", object->dataset.datatype->backend_id, object->dataset.datatype->backend_id_len, &error))
-	{
-		j_goto_error();
-	}
+/**
+ * Resets statistics, so that they do not match any value.
+ **/
+static void
+H5VL_julea_db_statistics_init(JHDF5Statistics* statistics)
+{
+	statistics->min_value_i = G_MAXINT64;
+	statistics->max_value_i = G_MININT64;
+	statistics->min_value_f = G_MAXDOUBLE;
+	statistics->max_value_f = -G_MAXDOUBLE;
+}
 
-	if (!j_db_entry_set_field(entry, "space", object->dataset.space->backend_id, object->dataset.space->backend_id_len, &error))
-	{
-		j_goto_error();
+/**
+ * Defines a min/max kernel for a native type.
+ * The loop only uses conditional moves on local variables, so compilers can vectorize it.
+ **/
+#define H5VL_julea_db_statistics_kernel(_type, _target_type, _target_extension) \
+	static void \
+	H5VL_julea_db_statistics_update_##_type(JHDF5Statistics* statistics, gconstpointer data, gsize n) \
+	{ \
+		_type const* values = data; \
+		_type min_value; \
+		_type max_value; \
+\
+		if (n == 0) \
+		{ \
+			return; \
+		} \
+\
+		min_value = values[0]; \
+		max_value = values[0]; \
+\
+		for (gsize i = 1; i < n; i++) \
+		{ \
+			min_value = (values[i] < min_value) ? values[i] : min_value; \
+			max_value = (values[i] > max_value) ? values[i] : max_value; \
+		} \
+\
+		statistics->min_value##_target_extension = MIN(statistics->min_value##_target_extension, (_target_type)min_value); \
+		statistics->max_value##_target_extension = MAX(statistics->max_value##_target_extension, (_target_type)max_value); \
 	}
 
-	if (!j_db_entry_insert(entry, batch, &error))
-	{
-		j_goto_error();
-	}
+H5VL_julea_db_statistics_kernel(gfloat, gdouble, _f)
+H5VL_julea_db_statistics_kernel(gdouble, gdouble, _f)
+H5VL_julea_db_statistics_kernel(gint8, gint64, _i)
+H5VL_julea_db_statistics_kernel(gint16, gint64, _i)
+H5VL_julea_db_statistics_kernel(gint32, gint64, _i)
+H5VL_julea_db_statistics_kernel(gint64, gint64, _i)
+H5VL_julea_db_statistics_kernel(guint8, gint64, _i)
+H5VL_julea_db_statistics_kernel(guint16, gint64, _i)
+H5VL_julea_db_statistics_kernel(guint32, gint64, _i)
 
-	if (!j_batch_execute(batch))
-	{
-		j_goto_error();
-	}
+static void
+H5VL_julea_db_statistics_update_guint64(JHDF5Statistics* statistics, gconstpointer data, gsize n)
+{
+	guint64 const* values = data;
+	guint64 min_value;
+	guint64 max_value;
 
-	if (!j_db_entry_get_id(entry, &object->backend_id, &object->backend_id_len, &error))
+	if (n == 0)
 	{
-		j_goto_error();
+		return;
 	}
 
-	if (!(object->dataset.distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN)))
-	{
-		j_goto_error();
-	}
+	min_value = values[0];
+	max_value = values[0];
 
-	if (!(hex_buf = H5VL_julea_db_buf_to_hex("dataset", object->backend_id, object->backend_id_len)))
+	for (gsize i = 1; i < n; i++)
 	{
-		j_goto_error();
+		min_value = (values[i] < min_value) ? values[i] : min_value;
+		max_value = (values[i] > max_value) ? values[i] : max_value;
 	}
 
-	if (!(object->dataset.object = j_distributed_object_new(JULEA_HDF5_DB_NAMESPACE, hex_buf, object->dataset.distribution)))
-	{
-		j_goto_error();
-	}
+	// Values that do not fit into the signed statistics are clamped, which keeps the bounds conservative
+	statistics->min_value_i = MIN(statistics->min_value_i, (gint64)MIN(min_value, (guint64)G_MAXINT64));
+	statistics->max_value_i = MAX(statistics->max_value_i, (gint64)MIN(max_value, (guint64)G_MAXINT64));
+}
+
+/**
+ * Updates statistics with the given values.
+ * Only native floating point and integer types are supported, other types are ignored.
+ *
+ * \param statistics The statistics.
+ * \param buf        The values.
+ * \param bytes      The length of the values in bytes.
+ * \param type_id    The values' datatype.
+ **/
+static void
+H5VL_julea_db_statistics_update(JHDF5Statistics* statistics, gconstpointer buf, gsize bytes, hid_t type_id)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	j_distributed_object_create(object->dataset.object, batch);
+	gsize element_size = H5Tget_size(type_id);
+	gsize n;
 
+	if (element_size == 0)
 	{
-		if (!j_batch_execute(batch))
-		{
-			j_goto_error();
-		}
+		return;
 	}
 
-	if (!H5VL_julea_db_link_create_helper(parent, object, name))
+	n = bytes / element_size;
+
+	switch (H5Tget_class(type_id))
 	{
-		j_goto_error();
+		case H5T_FLOAT:
+			if (element_size == sizeof(gfloat))
+			{
+				H5VL_julea_db_statistics_update_gfloat(statistics, buf, n);
+			}
+			else if (element_size == sizeof(gdouble))
+			{
+				H5VL_julea_db_statistics_update_gdouble(statistics, buf, n);
+			}
+			break;
+		case H5T_INTEGER:
+			if (H5Tget_sign(type_id) == H5T_SGN_NONE)
+			{
+				switch (element_size)
+				{
+					case 1:
+						H5VL_julea_db_statistics_update_guint8(statistics, buf, n);
+						break;
+					case 2:
+						H5VL_julea_db_statistics_update_guint16(statistics, buf, n);
+						break;
+					case 4:
+						H5VL_julea_db_statistics_update_guint32(statistics, buf, n);
+						break;
+					case 8:
+						H5VL_julea_db_statistics_update_guint64(statistics, buf, n);
+						break;
+					default:
+						break;
+				}
+			}
+			else
+			{
+				switch (element_size)
+				{
+					case 1:
+						H5VL_julea_db_statistics_update_gint8(statistics, buf, n);
+						break;
+					case 2:
+						H5VL_julea_db_statistics_update_gint16(statistics, buf, n);
+						break;
+					case 4:
+						H5VL_julea_db_statistics_update_gint32(statistics, buf, n);
+						break;
+					case 8:
+						H5VL_julea_db_statistics_update_gint64(statistics, buf, n);
+						break;
+					default:
+						break;
+				}
+			}
+			break;
+		case H5T_NO_CLASS:
+		case H5T_TIME:
+		case H5T_STRING:
+		case H5T_BITFIELD:
+		case H5T_OPAQUE:
+		case H5T_COMPOUND:
+		case H5T_REFERENCE:
+		case H5T_ENUM:
+		case H5T_VLEN:
+		case H5T_ARRAY:
+		case H5T_NCLASSES:
+		default:
+			break;
+	}
+}
+
+/**
+ * Sets the statistics fields of a dataset or chunk entry.
+ **/
+static gboolean
+H5VL_julea_db_statistics_set_fields(JDBEntry* entry, JHDF5Statistics const* statistics, GError** error)
+{
+	if (!j_db_entry_set_field(entry, "min_value_i", &statistics->min_value_i, sizeof(statistics->min_value_i), error))
+	{
+		return FALSE;
 	}
 
-	j_hdf5_log(file->file.name, "a", 'C', NULL, object, parent);
-	return object;
+	if (!j_db_entry_set_field(entry, "max_value_i", &statistics->max_value_i, sizeof(statistics->max_value_i), error))
+	{
+		return FALSE;
+	}
 
-_error:
-	H5VL_julea_db_error_handler(error);
-	H5VL_julea_db_object_unref(object);
+	if (!j_db_entry_set_field(entry, "min_value_f", &statistics->min_value_f, sizeof(statistics->min_value_f), error))
+	{
+		return FALSE;
+	}
 
-	return NULL;
+	if (!j_db_entry_set_field(entry, "max_value_f", &statistics->max_value_f, sizeof(statistics->max_value_f), error))
+	{
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Creates a selector matching dataset or chunk entries whose statistics overlap with a range.
+ * Floating point and integer statistics are checked, so the selector works regardless of the datatype.
+ *
+ * \param schema The dataset or chunk schema.
+ * \param min    The range's lower bound.
+ * \param max    The range's upper bound.
+ * \param error  A GError.
+ *
+ * \return The selector, NULL if an error occurred.
+ **/
+static JDBSelector*
+H5VL_julea_db_statistics_get_selector(JDBSchema* schema, gdouble min, gdouble max, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JDBSelector) selector = NULL;
+	g_autoptr(JDBSelector) selector_f = NULL;
+	g_autoptr(JDBSelector) selector_i = NULL;
+	gint64 min_i;
+	gint64 max_i;
+
+	// Round the bounds inwards, so that only integers within the range match
+	if (min <= (gdouble)G_MININT64)
+	{
+		min_i = G_MININT64;
+	}
+	else if (min >= (gdouble)G_MAXINT64)
+	{
+		min_i = G_MAXINT64;
+	}
+	else
+	{
+		min_i = (gint64)min;
+		min_i += ((gdouble)min_i < min) ? 1 : 0;
+	}
+
+	if (max <= (gdouble)G_MININT64)
+	{
+		max_i = G_MININT64;
+	}
+	else if (max >= (gdouble)G_MAXINT64)
+	{
+		max_i = G_MAXINT64;
+	}
+	else
+	{
+		max_i = (gint64)max;
+		max_i -= ((gdouble)max_i > max) ? 1 : 0;
+	}
+
+	if (!(selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_OR, error)))
+	{
+		return NULL;
+	}
+
+	if (!(selector_f = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, error)))
+	{
+		return NULL;
+	}
+
+	if (!j_db_selector_add_field(selector_f, "max_value_f", J_DB_SELECTOR_OPERATOR_GE, &min, sizeof(min), error))
+	{
+		return NULL;
+	}
+
+	if (!j_db_selector_add_field(selector_f, "min_value_f", J_DB_SELECTOR_OPERATOR_LE, &max, sizeof(max), error))
+	{
+		return NULL;
+	}
+
+	if (!(selector_i = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, error)))
+	{
+		return NULL;
+	}
+
+	if (!j_db_selector_add_field(selector_i, "max_value_i", J_DB_SELECTOR_OPERATOR_GE, &min_i, sizeof(min_i), error))
+	{
+		return NULL;
+	}
+
+	if (!j_db_selector_add_field(selector_i, "min_value_i", J_DB_SELECTOR_OPERATOR_LE, &max_i, sizeof(max_i), error))
+	{
+		return NULL;
+	}
+
+	if (!j_db_selector_add_selector(selector, selector_f, error))
+	{
+		return NULL;
+	}
+
+	if (!j_db_selector_add_selector(selector, selector_i, error))
+	{
+		return NULL;
+	}
+
+	return g_steal_pointer(&selector);
+}
+
+/**
+ * Sets up the chunked layout of a dataset.
+ *
+ * \param object     The dataset.
+ * \param rank       The number of dimensions.
+ * \param chunk_dims The chunk's extent in each dimension.
+ * \param prefix     The name prefix of the chunk objects.
+ * \param filters    The filter pipeline, NULL for unfiltered chunks. The dataset takes ownership.
+ **/
+static void
+H5VL_julea_db_dataset_chunks_init(JHDF5Object_t* object, guint rank, guint64 const* chunk_dims, gchar const* prefix, GArray* filters)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree hsize_t* dims = NULL;
+
+	dims = g_new(hsize_t, rank);
+	H5Sget_simple_extent_dims(object->dataset.space->space.hdf5_id, dims, NULL);
+
+	object->dataset.chunks.rank = rank;
+	object->dataset.chunks.dims = g_new(guint64, rank);
+	object->dataset.chunks.grid = g_new(guint64, rank);
+	object->dataset.chunks.prefix = g_strdup(prefix);
+	object->dataset.chunks.objects = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, (GDestroyNotify)j_distributed_object_unref);
+	object->dataset.chunks.allocated = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, g_free);
+	object->dataset.chunks.filters = filters;
+
+	for (guint i = 0; i < rank; i++)
+	{
+		object->dataset.chunks.dims[i] = chunk_dims[i];
+		object->dataset.chunks.grid[i] = (dims[i] + chunk_dims[i] - 1) / chunk_dims[i];
+	}
+}
+
+/**
+ * Loads the indices, sizes and statistics of a dataset's allocated chunks from the chunk index.
+ **/
+static void
+H5VL_julea_db_dataset_chunks_load(JHDF5Object_t* object)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JDBIterator) iterator = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	gchar const* fields[] = { "chunk_index", "chunk_size", "min_value_i", "max_value_i", "min_value_f", "max_value_f", NULL };
+
+	if (!(selector = j_db_selector_new(julea_db_schema_chunk, J_DB_SELECTOR_MODE_AND, NULL)))
+	{
+		return;
+	}
+
+	if (!j_db_selector_add_field(selector, "dataset", J_DB_SELECTOR_OPERATOR_EQ, object->backend_id, object->backend_id_len, NULL))
+	{
+		return;
+	}
+
+	// The query fails if no chunks have been allocated yet
+	if (!(iterator = j_db_iterator_new_for_fields(julea_db_schema_chunk, selector, fields, NULL)))
+	{
+		return;
+	}
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		JHDF5ChunkInfo* info;
+		JDBType type;
+		guint64* index = NULL;
+		guint64* size = NULL;
+		gint64* min_i = NULL;
+		gint64* max_i = NULL;
+		gdouble* min_f = NULL;
+		gdouble* max_f = NULL;
+		guint64 len;
+
+		if (j_db_iterator_get_field(iterator, "chunk_index", &type, (gpointer*)&index, &len, NULL)
+		    && j_db_iterator_get_field(iterator, "chunk_size", &type, (gpointer*)&size, &len, NULL)
+		    && j_db_iterator_get_field(iterator, "min_value_i", &type, (gpointer*)&min_i, &len, NULL)
+		    && j_db_iterator_get_field(iterator, "max_value_i", &type, (gpointer*)&max_i, &len, NULL)
+		    && j_db_iterator_get_field(iterator, "min_value_f", &type, (gpointer*)&min_f, &len, NULL)
+		    && j_db_iterator_get_field(iterator, "max_value_f", &type, (gpointer*)&max_f, &len, NULL))
+		{
+			info = g_new(JHDF5ChunkInfo, 1);
+			info->size = *size;
+			info->statistics.min_value_i = *min_i;
+			info->statistics.max_value_i = *max_i;
+			info->statistics.min_value_f = *min_f;
+			info->statistics.max_value_f = *max_f;
+
+			g_hash_table_insert(object->dataset.chunks.allocated, g_steal_pointer(&index), info);
+		}
+
+		g_free(index);
+		g_free(size);
+		g_free(min_i);
+		g_free(max_i);
+		g_free(min_f);
+		g_free(max_f);
+	}
 }
 
 static void*
-H5VL_julea_db_dataset_open(void* obj, const H5VL_loc_params_t* loc_params, const char* name, hid_t dapl_id, hid_t dxpl_id, void** req)
+H5VL_julea_db_dataset_create(void* obj, const H5VL_loc_params_t* loc_params, const char* name, hid_t lcpl_id, hid_t type_id, hid_t space_id, hid_t dcpl_id, hid_t dapl_id, hid_t dxpl_id, void** req)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	g_autoptr(GError) error = NULL;
 	g_autoptr(JBatch) batch = NULL;
-	g_autoptr(JDBIterator) iterator = NULL;
-	g_autoptr(JDBSelector) selector = NULL;
+	g_autoptr(JDBEntry) entry = NULL;
 	g_autofree char* hex_buf = NULL;
-	g_autofree void* space_id_buf = NULL;
-	g_autofree void* datatype_id_buf = NULL;
+	g_autofree guint64* chunk_dims = NULL;
+	g_autofree JHDF5Filter* filters_buf = NULL;
+	g_autoptr(GArray) filters = NULL;
 	JHDF5Object_t* object = NULL;
 	JHDF5Object_t* parent = obj;
 	JHDF5Object_t* file;
-	JDBType type;
-	guint64 len;
-	guint64 space_id_buf_len;
-	guint64 datatype_id_buf_len;
-	guint64* tmp_ptr_i;
-	gdouble* tmp_ptr_f;
+	guint32 layout = H5D_CONTIGUOUS;
+	guint64 filters_buf_len;
+	gboolean filters_unsupported;
+	guint64 chunk_dims_none = 0;
+	gint chunk_rank = 0;
 
 	(void)loc_params;
+	(void)lcpl_id;
 	(void)dapl_id;
 	(void)dxpl_id;
 	(void)req;
@@ -466,6 +913,8 @@ H5VL_julea_db_dataset_open(void* obj, const H5VL_loc_params_t* loc_params, const
 		j_goto_error();
 	}
 
+	H5VL_julea_db_statistics_init(&object->dataset.statistics);
+
 	if (!(object->dataset.name = g_strdup(name)))
 	{
 		j_goto_error();
@@ -476,84 +925,116 @@ H5VL_julea_db_dataset_open(void* obj, const H5VL_loc_params_t* loc_params, const
 		j_goto_error();
 	}
 
-	if (!H5VL_julea_db_link_get_helper(parent, object, name))
+	if (!(object->dataset.datatype = H5VL_julea_db_datatype_encode(&type_id)))
 	{
 		j_goto_error();
 	}
 
-	if (!(selector = j_db_selector_new(julea_db_schema_dataset, J_DB_SELECTOR_MODE_AND, &error)))
+	if (!(object->dataset.space = H5VL_julea_db_space_encode(&space_id)))
 	{
 		j_goto_error();
 	}
 
-	if (!j_db_selector_add_field(selector, "_id", J_DB_SELECTOR_OPERATOR_EQ, object->backend_id, object->backend_id_len, &error))
+	if (H5Pget_layout(dcpl_id) == H5D_CHUNKED)
 	{
-		j_goto_error();
+		g_autofree hsize_t* dims = NULL;
+
+		if ((chunk_rank = H5Sget_simple_extent_ndims(space_id)) <= 0)
+		{
+			j_goto_error();
+		}
+
+		dims = g_new(hsize_t, chunk_rank);
+		chunk_dims = g_new(guint64, chunk_rank);
+
+		if (H5Pget_chunk(dcpl_id, chunk_rank, dims) != chunk_rank)
+		{
+			j_goto_error();
+		}
+
+		for (gint i = 0; i < chunk_rank; i++)
+		{
+			chunk_dims[i] = dims[i];
+		}
+
+		layout = H5D_CHUNKED;
+
+		// HDF5 only allows filters for chunked datasets
+		filters = H5VL_julea_db_filter_get_pipeline(dcpl_id, &filters_unsupported);
+
+		if (filters_unsupported)
+		{
+			j_goto_error();
+		}
 	}
 
-	if (!(iterator = j_db_iterator_new(julea_db_schema_dataset, selector, &error)))
+	filters_buf = H5VL_julea_db_filter_serialize(filters, &filters_buf_len);
+
+	if (!(entry = j_db_entry_new(julea_db_schema_dataset, &error)))
 	{
 		j_goto_error();
 	}
 
-	if (!j_db_iterator_next(iterator, &error))
+	if (!j_db_entry_set_field(entry, "layout", &layout, sizeof(layout), &error))
 	{
 		j_goto_error();
 	}
 
-	if (!j_db_iterator_get_field(iterator, "min_value_i", &type, (gpointer*)&tmp_ptr_i, &len, &error))
+	if (chunk_rank > 0)
 	{
-		j_goto_error();
+		if (!j_db_entry_set_field(entry, "chunk_dims", chunk_dims, chunk_rank * sizeof(guint64), &error))
+		{
+			j_goto_error();
+		}
+	}
+	else
+	{
+		// Contiguous datasets do not have chunks
+		if (!j_db_entry_set_field(entry, "chunk_dims", &chunk_dims_none, sizeof(chunk_dims_none), &error))
+		{
+			j_goto_error();
+		}
 	}
 
-	object->dataset.statistics.min_value_i = *tmp_ptr_i;
-	g_free(tmp_ptr_i);
-
-	if (!j_db_iterator_get_field(iterator, "max_value_i", &type, (gpointer*)&tmp_ptr_i, &len, &error))
+	if (!j_db_entry_set_field(entry, "filters", filters_buf, filters_buf_len, &error))
 	{
 		j_goto_error();
 	}
 
-	object->dataset.statistics.max_value_i = *tmp_ptr_i;
-	g_free(tmp_ptr_i);
-
-	if (!j_db_iterator_get_field(iterator, "min_value_f", &type, (gpointer*)&tmp_ptr_f, &len, &error))
+	if (!H5VL_julea_db_statistics_set_fields(entry, &object->dataset.statistics, &error))
 	{
 		j_goto_error();
 	}
 
-	object->dataset.statistics.min_value_f = *tmp_ptr_f;
-	g_free(tmp_ptr_f);
-
-	if (!j_db_iterator_get_field(iterator, "max_value_f", &type, (gpointer*)&tmp_ptr_f, &len, &error))
+	if (!j_db_entry_set_field(entry, "file", file->backend_id, file->backend_id_len, &error))
 	{
 		j_goto_error();
 	}
 
-	object->dataset.statistics.max_value_f = *tmp_ptr_f;
-	g_free(tmp_ptr_f);
-
-	if (!j_db_iterator_get_field(iterator, "space", &type, &space_id_buf, &space_id_buf_len, &error))
+	if (!j_db_entry_set_field(entry, "datatype", object->dataset.datatype->backend_id, object->dataset.datatype->backend_id_len, &error))
 	{
 		j_goto_error();
 	}
 
-	if (!(object->dataset.space = H5VL_julea_db_space_decode(space_id_buf, space_id_buf_len)))
+	if (!j_db_entry_set_field(entry, "space", object->dataset.space->backend_id, object->dataset.space->backend_id_len, &error))
 	{
 		j_goto_error();
 	}
 
-	if (!j_db_iterator_get_field(iterator, "datatype", &type, &datatype_id_buf, &datatype_id_buf_len, &error))
+	if (!j_db_entry_insert(entry, batch, &error))
 	{
 		j_goto_error();
 	}
 
-	if (!(object->dataset.datatype = H5VL_julea_db_datatype_decode(datatype_id_buf, datatype_id_buf_len)))
+	if (!j_batch_execute(batch))
 	{
 		j_goto_error();
 	}
 
-	g_assert(!j_db_iterator_next(iterator, NULL));
+	if (!j_db_entry_get_id(entry, &object->backend_id, &object->backend_id_len, &error))
+	{
+		j_goto_error();
+	}
 
 	if (!(object->dataset.distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN)))
 	{
@@ -570,7 +1051,27 @@ H5VL_julea_db_dataset_open(void* obj, const H5VL_loc_params_t* loc_params, const
 		j_goto_error();
 	}
 
-	j_hdf5_log(file->file.name, "a", 'O', NULL, object, NULL);
+	if (chunk_rank > 0)
+	{
+		// Chunk objects are created when they are written for the first time
+		H5VL_julea_db_dataset_chunks_init(object, chunk_rank, chunk_dims, hex_buf, g_steal_pointer(&filters));
+	}
+	else
+	{
+		j_distributed_object_create(object->dataset.object, batch);
+
+		if (!j_batch_execute(batch))
+		{
+			j_goto_error();
+		}
+	}
+
+	if (!H5VL_julea_db_link_create_helper(parent, object, name))
+	{
+		j_goto_error();
+	}
+
+	j_hdf5_log(file->file.name, "a", 'C', NULL, object, parent);
 	return object;
 
 _error:
@@ -580,321 +1081,1282 @@ _error:
 	return NULL;
 }
 
-struct JHDF5IndexRange
+static void*
+H5VL_julea_db_dataset_open(void* obj, const H5VL_loc_params_t* loc_params, const char* name, hid_t dapl_id, hid_t dxpl_id, void** req)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDBIterator) iterator = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	g_autofree char* hex_buf = NULL;
+	g_autofree void* space_id_buf = NULL;
+	g_autofree void* datatype_id_buf = NULL;
+	g_autofree guint32* layout = NULL;
+	g_autofree guint64* chunk_dims = NULL;
+	g_autofree JHDF5Filter* filters_buf = NULL;
+	g_autoptr(GHashTable) row = NULL;
+	JHDF5Object_t* object = NULL;
+	JHDF5Object_t* parent = obj;
+	JHDF5Object_t* file;
+	guint64 len;
+	guint64 space_id_buf_len;
+	guint64 datatype_id_buf_len;
+	guint64 chunk_dims_len;
+	guint64 filters_buf_len;
+	guint64* tmp_ptr_i;
+	gdouble* tmp_ptr_f;
+
+	(void)loc_params;
+	(void)dapl_id;
+	(void)dxpl_id;
+	(void)req;
+
+	g_return_val_if_fail(name != NULL, NULL);
+	g_return_val_if_fail(parent != NULL, NULL);
+
+	switch (parent->type)
+	{
+		case J_HDF5_OBJECT_TYPE_FILE:
+			file = parent;
+			break;
+		case J_HDF5_OBJECT_TYPE_DATASET:
+			file = parent->dataset.file;
+			break;
+		case J_HDF5_OBJECT_TYPE_ATTR:
+			file = parent->attr.file;
+			break;
+		case J_HDF5_OBJECT_TYPE_GROUP:
+			file = parent->group.file;
+			break;
+		case J_HDF5_OBJECT_TYPE_DATATYPE:
+		case J_HDF5_OBJECT_TYPE_SPACE:
+		case _J_HDF5_OBJECT_TYPE_COUNT:
+		default:
+			g_assert_not_reached();
+			j_goto_error();
+	}
+
+	if (!(batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT)))
+	{
+		j_goto_error();
+	}
+
+	if (!(object = H5VL_julea_db_object_new(J_HDF5_OBJECT_TYPE_DATASET)))
+	{
+		j_goto_error();
+	}
+
+	if (!(object->dataset.name = g_strdup(name)))
+	{
+		j_goto_error();
+	}
+
+	if (!(object->dataset.file = H5VL_julea_db_object_ref(file)))
+	{
+		j_goto_error();
+	}
+
+	if (!H5VL_julea_db_link_get_helper(parent, object, name))
+	{
+		j_goto_error();
+	}
+
+	if ((row = H5VL_julea_db_prefetch_get_dataset(file, object->backend_id, object->backend_id_len)) != NULL)
+	{
+		g_hash_table_ref(row);
+	}
+	else
+	{
+		if (!(selector = j_db_selector_new(julea_db_schema_dataset, J_DB_SELECTOR_MODE_AND, &error)))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_selector_add_field(selector, "_id", J_DB_SELECTOR_OPERATOR_EQ, object->backend_id, object->backend_id_len, &error))
+		{
+			j_goto_error();
+		}
+
+		if (!(iterator = j_db_iterator_new(julea_db_schema_dataset, selector, &error)))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_iterator_next(iterator, &error))
+		{
+			j_goto_error();
+		}
+
+		row = H5VL_julea_db_row_new(iterator, julea_db_dataset_fields);
+		g_assert(!j_db_iterator_next(iterator, NULL));
+	}
+
+	if (!H5VL_julea_db_row_get_field(row, "min_value_i", (gpointer*)&tmp_ptr_i, &len))
+	{
+		j_goto_error();
+	}
+
+	object->dataset.statistics.min_value_i = *tmp_ptr_i;
+	g_free(tmp_ptr_i);
+
+	if (!H5VL_julea_db_row_get_field(row, "max_value_i", (gpointer*)&tmp_ptr_i, &len))
+	{
+		j_goto_error();
+	}
+
+	object->dataset.statistics.max_value_i = *tmp_ptr_i;
+	g_free(tmp_ptr_i);
+
+	if (!H5VL_julea_db_row_get_field(row, "min_value_f", (gpointer*)&tmp_ptr_f, &len))
+	{
+		j_goto_error();
+	}
+
+	object->dataset.statistics.min_value_f = *tmp_ptr_f;
+	g_free(tmp_ptr_f);
+
+	if (!H5VL_julea_db_row_get_field(row, "max_value_f", (gpointer*)&tmp_ptr_f, &len))
+	{
+		j_goto_error();
+	}
+
+	object->dataset.statistics.max_value_f = *tmp_ptr_f;
+	g_free(tmp_ptr_f);
+
+	if (!H5VL_julea_db_row_get_field(row, "space", &space_id_buf, &space_id_buf_len))
+	{
+		j_goto_error();
+	}
+
+	if (!(object->dataset.space = H5VL_julea_db_prefetch_get_space(file, space_id_buf, space_id_buf_len)))
+	{
+		j_goto_error();
+	}
+
+	if (!H5VL_julea_db_row_get_field(row, "datatype", &datatype_id_buf, &datatype_id_buf_len))
+	{
+		j_goto_error();
+	}
+
+	if (!(object->dataset.datatype = H5VL_julea_db_prefetch_get_datatype(file, datatype_id_buf, datatype_id_buf_len)))
+	{
+		j_goto_error();
+	}
+
+	if (!H5VL_julea_db_row_get_field(row, "layout", (gpointer*)&layout, &len))
+	{
+		j_goto_error();
+	}
+
+	if (!H5VL_julea_db_row_get_field(row, "chunk_dims", (gpointer*)&chunk_dims, &chunk_dims_len))
+	{
+		j_goto_error();
+	}
+
+	if (!H5VL_julea_db_row_get_field(row, "filters", (gpointer*)&filters_buf, &filters_buf_len))
+	{
+		j_goto_error();
+	}
+
+	if (!(object->dataset.distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN)))
+	{
+		j_goto_error();
+	}
+
+	if (!(hex_buf = H5VL_julea_db_buf_to_hex("dataset", object->backend_id, object->backend_id_len)))
+	{
+		j_goto_error();
+	}
+
+	if (!(object->dataset.object = j_distributed_object_new(JULEA_HDF5_DB_NAMESPACE, hex_buf, object->dataset.distribution)))
+	{
+		j_goto_error();
+	}
+
+	if (*layout == H5D_CHUNKED)
+	{
+		H5VL_julea_db_dataset_chunks_init(object, chunk_dims_len / sizeof(guint64), chunk_dims, hex_buf, H5VL_julea_db_filter_deserialize(filters_buf, filters_buf_len));
+		H5VL_julea_db_dataset_chunks_load(object);
+	}
+
+	j_hdf5_log(file->file.name, "a", 'O', NULL, object, NULL);
+	return object;
+
+_error:
+	H5VL_julea_db_error_handler(error);
+	H5VL_julea_db_object_unref(object);
+
+	return NULL;
+}
+
+/**
+ * A part of a selection that is contiguous in memory and in the file.
+ * All values are given in elements.
+ **/
+struct JHDF5Piece
+{
+	guint64 mem_start;
+	guint64 file_start;
+	guint64 staging_start;
+	guint64 count;
+};
+
+typedef struct JHDF5Piece JHDF5Piece;
+
+/**
+ * The maximum number of sequences fetched from a selection iterator at once.
+ **/
+#define J_HDF5_DB_SEQUENCES_MAX 1024
+
+static gint
+H5VL_julea_db_piece_compare(gconstpointer a, gconstpointer b)
+{
+	JHDF5Piece const* piece_a = a;
+	JHDF5Piece const* piece_b = b;
+
+	if (piece_a->file_start != piece_b->file_start)
+	{
+		return (piece_a->file_start < piece_b->file_start) ? -1 : 1;
+	}
+
+	if (piece_a->mem_start != piece_b->mem_start)
+	{
+		return (piece_a->mem_start < piece_b->mem_start) ? -1 : 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Fetches the next sequence of a selection iterator.
+ * Offsets and lengths are given in elements because the iterator is created with an element size of 1.
+ *
+ * \return TRUE if a sequence is available, FALSE if the selection is exhausted or an error occurred.
+ **/
+static gboolean
+H5VL_julea_db_space_next_sequence(hid_t iter_id, hsize_t* offsets, size_t* lengths, size_t* count, size_t* index)
+{
+	size_t nelements;
+
+	if (*index < *count)
+	{
+		return TRUE;
+	}
+
+	*index = 0;
+
+	if (H5Ssel_iter_get_seq_list(iter_id, J_HDF5_DB_SEQUENCES_MAX, SIZE_MAX, count, &nelements, offsets, lengths) < 0)
+	{
+		*count = 0;
+	}
+
+	return (*count > 0);
+}
+
+/**
+ * Converts a pair of memory and file selections into pieces.
+ *
+ * Both selections are traversed in selection order, so the n-th selected memory element is paired with the n-th selected file element.
+ * Neighbouring elements (for example, consecutive points or hyperslab rows) are merged into a single piece.
+ * The pieces are sorted by their file offset afterwards, and each piece is assigned a position within a packed staging buffer.
+ * Consecutive pieces that are contiguous in the file are therefore also contiguous in the staging buffer and can be transferred using a single operation.
+ *
+ * \param mem_space_id    The memory dataspace, H5S_ALL to use the stored dataspace.
+ * \param file_space_id   The file dataspace, H5S_ALL for the whole dataset.
+ * \param stored_space_id The dataset's dataspace.
+ * \param data_count      Returns the number of selected elements.
+ *
+ * \return The pieces, NULL if the selections could not be converted. Should be freed with g_array_unref().
+ **/
+static GArray*
+H5VL_julea_db_space_hdf5_to_pieces(hid_t mem_space_id, hid_t file_space_id, hid_t stored_space_id, guint64* data_count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree hsize_t* file_offsets = NULL;
+	g_autofree hsize_t* mem_offsets = NULL;
+	g_autofree size_t* file_lengths = NULL;
+	g_autofree size_t* mem_lengths = NULL;
+	GArray* pieces = NULL;
+	hid_t file_iter_id = H5I_INVALID_HID;
+	hid_t mem_iter_id = H5I_INVALID_HID;
+	hssize_t npoints;
+	guint64 staging_start;
+	size_t file_count = 0;
+	size_t file_index = 0;
+	size_t file_used = 0;
+	size_t mem_count = 0;
+	size_t mem_index = 0;
+	size_t mem_used = 0;
+	gboolean file_done = TRUE;
+	gboolean mem_done = TRUE;
+	guint i;
+
+	pieces = g_array_new(FALSE, FALSE, sizeof(JHDF5Piece));
+	*data_count = 0;
+
+	if (mem_space_id == H5S_ALL && file_space_id == H5S_ALL)
+	{
+		JHDF5Piece piece;
+
+		if ((npoints = H5Sget_simple_extent_npoints(stored_space_id)) < 0)
+		{
+			j_goto_error();
+		}
+
+		piece.mem_start = 0;
+		piece.file_start = 0;
+		piece.staging_start = 0;
+		piece.count = npoints;
+
+		if (piece.count > 0)
+		{
+			g_array_append_val(pieces, piece);
+		}
+
+		*data_count = piece.count;
+
+		return pieces;
+	}
+
+	if (file_space_id == H5S_ALL)
+	{
+		file_space_id = stored_space_id;
+	}
+
+	if (mem_space_id == H5S_ALL)
+	{
+		mem_space_id = file_space_id;
+	}
+
+	if ((npoints = H5Sget_select_npoints(file_space_id)) < 0 || npoints != H5Sget_select_npoints(mem_space_id))
+	{
+		j_goto_error();
+	}
+
+	file_offsets = g_new(hsize_t, J_HDF5_DB_SEQUENCES_MAX);
+	file_lengths = g_new(size_t, J_HDF5_DB_SEQUENCES_MAX);
+	mem_offsets = g_new(hsize_t, J_HDF5_DB_SEQUENCES_MAX);
+	mem_lengths = g_new(size_t, J_HDF5_DB_SEQUENCES_MAX);
+
+	if ((file_iter_id = H5Ssel_iter_create(file_space_id, 1, 0)) < 0)
+	{
+		j_goto_error();
+	}
+
+	if ((mem_iter_id = H5Ssel_iter_create(mem_space_id, 1, 0)) < 0)
+	{
+		j_goto_error();
+	}
+
+	while (TRUE)
+	{
+		JHDF5Piece piece;
+
+		file_done = !H5VL_julea_db_space_next_sequence(file_iter_id, file_offsets, file_lengths, &file_count, &file_index);
+		mem_done = !H5VL_julea_db_space_next_sequence(mem_iter_id, mem_offsets, mem_lengths, &mem_count, &mem_index);
+
+		if (file_done || mem_done)
+		{
+			break;
+		}
+
+		piece.mem_start = mem_offsets[mem_index] + mem_used;
+		piece.file_start = file_offsets[file_index] + file_used;
+		piece.staging_start = 0;
+		piece.count = MIN(file_lengths[file_index] - file_used, mem_lengths[mem_index] - mem_used);
+
+		if (pieces->len > 0)
+		{
+			JHDF5Piece* last = &g_array_index(pieces, JHDF5Piece, pieces->len - 1);
+
+			if (last->mem_start + last->count == piece.mem_start && last->file_start + last->count == piece.file_start)
+			{
+				last->count += piece.count;
+			}
+			else
+			{
+				g_array_append_val(pieces, piece);
+			}
+		}
+		else
+		{
+			g_array_append_val(pieces, piece);
+		}
+
+		file_used += piece.count;
+		mem_used += piece.count;
+
+		if (file_used == file_lengths[file_index])
+		{
+			file_index++;
+			file_used = 0;
+		}
+
+		if (mem_used == mem_lengths[mem_index])
+		{
+			mem_index++;
+			mem_used = 0;
+		}
+	}
+
+	if (file_done != mem_done)
+	{
+		j_goto_error();
+	}
+
+	g_array_sort(pieces, H5VL_julea_db_piece_compare);
+
+	staging_start = 0;
+
+	for (i = 0; i < pieces->len; i++)
+	{
+		JHDF5Piece* piece = &g_array_index(pieces, JHDF5Piece, i);
+
+		piece->staging_start = staging_start;
+		staging_start += piece->count;
+	}
+
+	*data_count = staging_start;
+
+	H5Ssel_iter_close(file_iter_id);
+	H5Ssel_iter_close(mem_iter_id);
+
+	return pieces;
+
+_error:
+	if (file_iter_id >= 0)
+	{
+		H5Ssel_iter_close(file_iter_id);
+	}
+
+	if (mem_iter_id >= 0)
+	{
+		H5Ssel_iter_close(mem_iter_id);
+	}
+
+	g_array_unref(pieces);
+
+	return NULL;
+}
+
+/**
+ * Returns the number of pieces starting at \p index that are contiguous in the file.
+ **/
+static guint
+H5VL_julea_db_pieces_get_run(GArray* pieces, guint index, guint64* count)
+{
+	JHDF5Piece* first = &g_array_index(pieces, JHDF5Piece, index);
+	guint i;
+
+	*count = first->count;
+
+	for (i = index + 1; i < pieces->len; i++)
+	{
+		JHDF5Piece* piece = &g_array_index(pieces, JHDF5Piece, i);
+
+		if (first->file_start + *count != piece->file_start)
+		{
+			break;
+		}
+
+		*count += piece->count;
+	}
+
+	return i - index;
+}
+
+/**
+ * A part of a selection that is contiguous within a chunk and within the staging buffer.
+ * All values are given in elements.
+ **/
+struct JHDF5ChunkSegment
+{
+	guint64 chunk;
+	guint64 chunk_start;
+	guint64 staging_start;
+	guint64 count;
+};
+
+typedef struct JHDF5ChunkSegment JHDF5ChunkSegment;
+
+static gint
+H5VL_julea_db_chunk_segment_compare(gconstpointer a, gconstpointer b)
+{
+	JHDF5ChunkSegment const* segment_a = a;
+	JHDF5ChunkSegment const* segment_b = b;
+
+	if (segment_a->chunk != segment_b->chunk)
+	{
+		return (segment_a->chunk < segment_b->chunk) ? -1 : 1;
+	}
+
+	if (segment_a->chunk_start != segment_b->chunk_start)
+	{
+		return (segment_a->chunk_start < segment_b->chunk_start) ? -1 : 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Splits pieces at chunk boundaries.
+ * The resulting segments are sorted by chunk, so all operations on a chunk are issued together.
+ *
+ * \param object The dataset.
+ * \param pieces The pieces, as returned by H5VL_julea_db_space_hdf5_to_pieces().
+ *
+ * \return The segments. Should be freed with g_array_unref().
+ **/
+static GArray*
+H5VL_julea_db_dataset_chunks_get_segments(JHDF5Object_t* object, GArray* pieces)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree hsize_t* dims = NULL;
+	g_autofree guint64* coordinates = NULL;
+	GArray* segments;
+	guint64 const* chunk_dims = object->dataset.chunks.dims;
+	guint64 const* grid = object->dataset.chunks.grid;
+	guint rank = object->dataset.chunks.rank;
+	guint last = rank - 1;
+	guint i;
+
+	dims = g_new(hsize_t, rank);
+	coordinates = g_new(guint64, rank);
+	H5Sget_simple_extent_dims(object->dataset.space->space.hdf5_id, dims, NULL);
+
+	segments = g_array_new(FALSE, FALSE, sizeof(JHDF5ChunkSegment));
+
+	for (i = 0; i < pieces->len; i++)
+	{
+		JHDF5Piece* piece = &g_array_index(pieces, JHDF5Piece, i);
+		guint64 position = piece->file_start;
+		guint64 staging = piece->staging_start;
+		guint64 remaining = piece->count;
+
+		while (remaining > 0)
+		{
+			JHDF5ChunkSegment segment;
+			guint64 tmp = position;
+
+			for (guint d = rank; d > 0; d--)
+			{
+				coordinates[d - 1] = tmp % dims[d - 1];
+				tmp /= dims[d - 1];
+			}
+
+			// A segment ends at the chunk's or the dataset's edge in the fastest-varying dimension
+			segment.count = MIN(remaining, chunk_dims[last] - (coordinates[last] % chunk_dims[last]));
+			segment.count = MIN(segment.count, dims[last] - coordinates[last]);
+			segment.chunk = 0;
+			segment.chunk_start = 0;
+			segment.staging_start = staging;
+
+			for (guint d = 0; d < rank; d++)
+			{
+				segment.chunk = segment.chunk * grid[d] + coordinates[d] / chunk_dims[d];
+				segment.chunk_start = segment.chunk_start * chunk_dims[d] + coordinates[d] % chunk_dims[d];
+			}
+
+			g_array_append_val(segments, segment);
+
+			position += segment.count;
+			staging += segment.count;
+			remaining -= segment.count;
+		}
+	}
+
+	g_array_sort(segments, H5VL_julea_db_chunk_segment_compare);
+
+	// Merge segments that are contiguous within their chunk and within the staging buffer
+	if (segments->len > 1)
+	{
+		guint merged = 0;
+
+		for (i = 1; i < segments->len; i++)
+		{
+			JHDF5ChunkSegment* previous = &g_array_index(segments, JHDF5ChunkSegment, merged);
+			JHDF5ChunkSegment* segment = &g_array_index(segments, JHDF5ChunkSegment, i);
+
+			if (previous->chunk == segment->chunk && previous->chunk_start + previous->count == segment->chunk_start && previous->staging_start + previous->count == segment->staging_start)
+			{
+				previous->count += segment->count;
+			}
+			else
+			{
+				merged++;
+				g_array_index(segments, JHDF5ChunkSegment, merged) = *segment;
+			}
+		}
+
+		g_array_set_size(segments, merged + 1);
+	}
+
+	return segments;
+}
+
+/**
+ * Returns the object storing a chunk.
+ * Chunks are spread across the object servers by their index, so touched chunks can be accessed in parallel.
+ **/
+static JDistributedObject*
+H5VL_julea_db_dataset_chunks_get_object(JHDF5Object_t* object, guint64 chunk)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObject* chunk_object;
+
+	if ((chunk_object = g_hash_table_lookup(object->dataset.chunks.objects, &chunk)) == NULL)
+	{
+		g_autoptr(JDistribution) distribution = NULL;
+		g_autofree gchar* name = NULL;
+		guint64* key;
+		guint32 server_count;
+
+		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
+
+		distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
+		j_distribution_set(distribution, "start-index", chunk % server_count);
+
+		name = g_strdup_printf("%s-%" G_GUINT64_FORMAT, object->dataset.chunks.prefix, chunk);
+		chunk_object = j_distributed_object_new(JULEA_HDF5_DB_NAMESPACE, name, distribution);
+
+		key = g_new(guint64, 1);
+		*key = chunk;
+		g_hash_table_insert(object->dataset.chunks.objects, key, chunk_object);
+	}
+
+	return chunk_object;
+}
+
+/**
+ * Creates a batch for data operations on a dataset.
+ * Chunks are independent objects, so operations on chunked datasets are allowed to be executed in parallel.
+ **/
+static JBatch*
+H5VL_julea_db_dataset_batch_new(JHDF5Object_t* object)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JSemantics) semantics = NULL;
+
+	if (object->dataset.chunks.rank == 0)
+	{
+		return j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	}
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(semantics, J_SEMANTICS_ORDERING, J_SEMANTICS_ORDERING_RELAXED);
+
+	return j_batch_new(semantics);
+}
+
+/**
+ * Queues the chunk index update for a written chunk.
+ * Chunks that are written for the first time are added to the chunk index, their objects have to be created by the caller.
+ * The cached chunk index is only updated by H5VL_julea_db_dataset_chunks_commit() once the batch has succeeded.
+ *
+ * \param object     The dataset.
+ * \param chunk      The chunk's index.
+ * \param size       The chunk's stored size.
+ * \param statistics The chunk's statistics.
+ * \param updates    Receives the #JHDF5ChunkUpdate for the chunk.
+ * \param batch      A batch.
+ * \param error      A GError.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+H5VL_julea_db_dataset_chunks_record(JHDF5Object_t* object, guint64 chunk, guint64 size, JHDF5Statistics const* statistics, GArray* updates, JBatch* batch, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JDBEntry) entry = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	JHDF5ChunkInfo* info;
+	JHDF5ChunkUpdate update;
+
+	info = g_hash_table_lookup(object->dataset.chunks.allocated, &chunk);
+
+	if (info != NULL && info->size == size && memcmp(&info->statistics, statistics, sizeof(*statistics)) == 0)
+	{
+		return TRUE;
+	}
+
+	if (!(entry = j_db_entry_new(julea_db_schema_chunk, error)))
+	{
+		return FALSE;
+	}
+
+	if (!j_db_entry_set_field(entry, "chunk_size", &size, sizeof(size), error))
+	{
+		return FALSE;
+	}
+
+	if (!H5VL_julea_db_statistics_set_fields(entry, statistics, error))
+	{
+		return FALSE;
+	}
+
+	if (info != NULL)
+	{
+		if (!(selector = j_db_selector_new(julea_db_schema_chunk, J_DB_SELECTOR_MODE_AND, error)))
+		{
+			return FALSE;
+		}
+
+		if (!j_db_selector_add_field(selector, "dataset", J_DB_SELECTOR_OPERATOR_EQ, object->backend_id, object->backend_id_len, error))
+		{
+			return FALSE;
+		}
+
+		if (!j_db_selector_add_field(selector, "chunk_index", J_DB_SELECTOR_OPERATOR_EQ, &chunk, sizeof(chunk), error))
+		{
+			return FALSE;
+		}
+
+		if (!j_db_entry_update(entry, selector, batch, error))
+		{
+			return FALSE;
+		}
+	}
+	else
+	{
+		if (!j_db_entry_set_field(entry, "file", object->dataset.file->backend_id, object->dataset.file->backend_id_len, error))
+		{
+			return FALSE;
+		}
+
+		if (!j_db_entry_set_field(entry, "dataset", object->backend_id, object->backend_id_len, error))
+		{
+			return FALSE;
+		}
+
+		if (!j_db_entry_set_field(entry, "chunk_index", &chunk, sizeof(chunk), error))
+		{
+			return FALSE;
+		}
+
+		if (!j_db_entry_insert(entry, batch, error))
+		{
+			return FALSE;
+		}
+	}
+
+	update.chunk = chunk;
+	update.info.size = size;
+	update.info.statistics = *statistics;
+	g_array_append_val(updates, update);
+
+	return TRUE;
+}
+
+/**
+ * Applies chunk index updates to the cached chunk index.
+ *
+ * \param object  The dataset.
+ * \param chunks  The #JHDF5ChunkUpdate entries, as collected by H5VL_julea_db_dataset_chunks_record().
+ **/
+static void
+H5VL_julea_db_dataset_chunks_commit(JHDF5Object_t* object, GArray* chunks)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	for (guint i = 0; i < chunks->len; i++)
+	{
+		JHDF5ChunkUpdate* update = &g_array_index(chunks, JHDF5ChunkUpdate, i);
+		JHDF5ChunkInfo* info;
+
+		if ((info = g_hash_table_lookup(object->dataset.chunks.allocated, &update->chunk)) == NULL)
+		{
+			guint64* key;
+
+			key = g_new(guint64, 1);
+			*key = update->chunk;
+			info = g_new(JHDF5ChunkInfo, 1);
+			g_hash_table_insert(object->dataset.chunks.allocated, key, info);
+		}
+
+		*info = update->info;
+	}
+}
+
+/**
+ * Returns the statistics a chunk's new values are merged into.
+ **/
+static void
+H5VL_julea_db_dataset_chunks_get_statistics(JHDF5Object_t* object, guint64 chunk, JHDF5Statistics* statistics)
+{
+	JHDF5ChunkInfo* info;
+
+	if ((info = g_hash_table_lookup(object->dataset.chunks.allocated, &chunk)) != NULL)
+	{
+		*statistics = info->statistics;
+	}
+	else
+	{
+		H5VL_julea_db_statistics_init(statistics);
+	}
+}
+
+/**
+ * Returns the size of a chunk in bytes.
+ **/
+static guint64
+H5VL_julea_db_dataset_chunks_get_size(JHDF5Object_t* object, gsize data_size)
+{
+	guint64 size = data_size;
+
+	for (guint i = 0; i < object->dataset.chunks.rank; i++)
+	{
+		size *= object->dataset.chunks.dims[i];
+	}
+
+	return size;
+}
+
+/**
+ * Queues the writes of a chunked dataset.
+ * The chunks' statistics are extended with the written values.
+ *
+ * \param object        The dataset.
+ * \param pieces        The pieces, as returned by H5VL_julea_db_space_hdf5_to_pieces().
+ * \param buf           The packed staging buffer.
+ * \param data_size     The element size.
+ * \param bytes_written Returns the number of bytes written.
+ * \param updates       Receives the chunk index updates to apply once the batch has succeeded.
+ * \param batch         A batch.
+ * \param error         A GError, it has to outlive the batch.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+H5VL_julea_db_dataset_chunks_write(JHDF5Object_t* object, GArray* pieces, const char* buf, gsize data_size, guint64* bytes_written, GArray* updates, JBatch* batch, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GArray) segments = NULL;
+	JHDF5Statistics statistics;
+	hid_t type_id = object->dataset.datatype->datatype.hdf5_id;
+	guint64 chunk_size;
+
+	segments = H5VL_julea_db_dataset_chunks_get_segments(object, pieces);
+	chunk_size = H5VL_julea_db_dataset_chunks_get_size(object, data_size);
+
+	for (guint i = 0; i < segments->len; i++)
+	{
+		JHDF5ChunkSegment* segment = &g_array_index(segments, JHDF5ChunkSegment, i);
+		JDistributedObject* chunk_object;
+
+		chunk_object = H5VL_julea_db_dataset_chunks_get_object(object, segment->chunk);
+
+		if (i == 0 || g_array_index(segments, JHDF5ChunkSegment, i - 1).chunk != segment->chunk)
+		{
+			if (!g_hash_table_contains(object->dataset.chunks.allocated, &segment->chunk))
+			{
+				j_distributed_object_create(chunk_object, batch);
+			}
+
+			H5VL_julea_db_dataset_chunks_get_statistics(object, segment->chunk, &statistics);
+		}
+
+		H5VL_julea_db_statistics_update(&statistics, buf + segment->staging_start * data_size, segment->count * data_size, type_id);
+
+		j_distributed_object_write(chunk_object, buf + segment->staging_start * data_size, segment->count * data_size, segment->chunk_start * data_size, bytes_written, batch);
+
+		// Segments are sorted by chunk, so the chunk is complete once the next segment belongs to another one
+		if (i + 1 == segments->len || g_array_index(segments, JHDF5ChunkSegment, i + 1).chunk != segment->chunk)
+		{
+			if (!H5VL_julea_db_dataset_chunks_record(object, segment->chunk, chunk_size, &statistics, updates, batch, error))
+			{
+				return FALSE;
+			}
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Queues the reads of a chunked dataset.
+ * Chunks that have not been allocated are skipped, so the corresponding parts of the staging buffer have to be zeroed.
+ *
+ * \param object     The dataset.
+ * \param pieces     The pieces, as returned by H5VL_julea_db_space_hdf5_to_pieces().
+ * \param buf        The packed staging buffer.
+ * \param data_size  The element size.
+ * \param bytes_read Returns the number of bytes read.
+ * \param batch      A batch.
+ *
+ * \return TRUE if reads have been queued, FALSE if none of the chunks have been allocated.
+ **/
+static gboolean
+H5VL_julea_db_dataset_chunks_read(JHDF5Object_t* object, GArray* pieces, char* buf, gsize data_size, guint64* bytes_read, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GArray) segments = NULL;
+	gboolean queued = FALSE;
+
+	segments = H5VL_julea_db_dataset_chunks_get_segments(object, pieces);
+
+	for (guint i = 0; i < segments->len; i++)
+	{
+		JHDF5ChunkSegment* segment = &g_array_index(segments, JHDF5ChunkSegment, i);
+		JDistributedObject* chunk_object;
+
+		if (!g_hash_table_contains(object->dataset.chunks.allocated, &segment->chunk))
+		{
+			continue;
+		}
+
+		chunk_object = H5VL_julea_db_dataset_chunks_get_object(object, segment->chunk);
+		j_distributed_object_read(chunk_object, buf + segment->staging_start * data_size, segment->count * data_size, segment->chunk_start * data_size, bytes_read, batch);
+		queued = TRUE;
+	}
+
+	return queued;
+}
+
+/**
+ * A whole chunk of a filtered dataset.
+ **/
+struct JHDF5ChunkBuffer
+{
+	JHDF5Object_t* object;
+	guint64 chunk;
+
+	/**
+	 * The unfiltered chunk.
+	 **/
+	gchar* data;
+	gsize length;
+	guint element_size;
+
+	/**
+	 * The filtered chunk, as stored in the chunk's object.
+	 **/
+	gchar* compressed;
+	gsize compressed_length;
+
+	/**
+	 * Whether the stored chunk has to be read before it can be modified.
+	 **/
+	gboolean fetch;
+
+	JHDF5Statistics statistics;
+
+	gboolean ret;
+};
+
+typedef struct JHDF5ChunkBuffer JHDF5ChunkBuffer;
+
+static void
+H5VL_julea_db_chunk_buffer_free(gpointer data)
+{
+	JHDF5ChunkBuffer* buffer = data;
+
+	g_free(buffer->data);
+	g_free(buffer->compressed);
+	g_free(buffer);
+}
+
+static gpointer
+H5VL_julea_db_chunk_buffer_compress(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JHDF5ChunkBuffer* buffer = data;
+
+	g_free(buffer->compressed);
+	buffer->compressed = H5VL_julea_db_filter_apply(buffer->object->dataset.chunks.filters, buffer->element_size, buffer->data, buffer->length, &buffer->compressed_length);
+	buffer->ret = (buffer->compressed != NULL);
+
+	return NULL;
+}
+
+static gpointer
+H5VL_julea_db_chunk_buffer_decompress(gpointer data)
 {
-	guint64 start;
-	guint64 stop;
-};
+	J_TRACE_FUNCTION(NULL);
 
-typedef struct JHDF5IndexRange JHDF5IndexRange;
+	JHDF5ChunkBuffer* buffer = data;
 
-static GArray*
-H5VL_julea_db_space_hdf5_to_range(hid_t mem_space_id, hid_t stored_space_id)
+	buffer->ret = H5VL_julea_db_filter_revert(buffer->object->dataset.chunks.filters, buffer->element_size, buffer->compressed, buffer->compressed_length, buffer->data, buffer->length);
+
+	return NULL;
+}
+
+/**
+ * Creates one buffer per chunk touched by the segments.
+ * Buffers of allocated chunks get room for their stored, filtered data.
+ *
+ * \param segments A sorted array of segments, as returned by H5VL_julea_db_dataset_chunks_get_segments().
+ * \param full     Whether buffers of chunks that are covered completely by the segments should not be fetched.
+ *
+ * \return An array of #JHDF5ChunkBuffer elements.
+ **/
+static GPtrArray*
+H5VL_julea_db_dataset_chunks_get_buffers(JHDF5Object_t* object, GArray* segments, gsize data_size, gboolean full)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	g_autofree hsize_t* stored_dims = NULL;
-	JHDF5IndexRange range;
-	JHDF5IndexRange range_tmp;
-	GArray* range_arr = NULL;
-	gboolean range_valid = FALSE;
-	gint stored_ndims;
-	guint i;
-	H5S_sel_type sel_type;
-	stored_ndims = H5Sget_simple_extent_ndims(stored_space_id);
-	stored_dims = g_new(hsize_t, stored_ndims);
-	H5Sget_simple_extent_dims(stored_space_id, stored_dims, NULL);
-	range_arr = g_array_new(FALSE, FALSE, sizeof(JHDF5IndexRange));
-	// FIXME G_DEBUG_HERE();
+	GPtrArray* buffers;
+	JHDF5ChunkBuffer* buffer = NULL;
+	guint64 chunk_size;
+	guint64 covered = 0;
 
-	if (mem_space_id == H5S_ALL)
-	{
-		sel_type = H5S_SEL_ALL;
-	}
-	else
-	{
-		sel_type = H5Sget_select_type(mem_space_id);
-	}
+	buffers = g_ptr_array_new_with_free_func(H5VL_julea_db_chunk_buffer_free);
+	chunk_size = H5VL_julea_db_dataset_chunks_get_size(object, data_size);
 
-	switch (sel_type)
+	for (guint i = 0; i < segments->len; i++)
 	{
-		case H5S_SEL_POINTS:
-		{
-			hssize_t npoints = 0;
-			hssize_t point_current = 0;
-			hssize_t point_current_index = 0;
-			g_autofree hsize_t* point_current_arr = NULL;
-			guint skipsize;
+		JHDF5ChunkSegment* segment = &g_array_index(segments, JHDF5ChunkSegment, i);
 
-			point_current_arr = g_new(hsize_t, stored_ndims);
+		if (buffer == NULL || buffer->chunk != segment->chunk)
+		{
+			JHDF5ChunkInfo* info;
 
-			if ((npoints = H5Sget_select_elem_npoints(mem_space_id)) <= 0)
+			if (buffer != NULL && full && covered == chunk_size)
 			{
-				j_goto_error();
+				buffer->fetch = FALSE;
 			}
 
-		_start:
-			while (point_current_index < npoints)
+			info = g_hash_table_lookup(object->dataset.chunks.allocated, &segment->chunk);
+
+			buffer = g_new0(JHDF5ChunkBuffer, 1);
+			buffer->object = object;
+			buffer->chunk = segment->chunk;
+			buffer->data = g_malloc0(chunk_size);
+			buffer->length = chunk_size;
+			buffer->element_size = data_size;
+			buffer->fetch = (info != NULL);
+
+			if (buffer->fetch)
 			{
-				if (H5Sget_select_elem_pointlist(mem_space_id, point_current_index, 1, point_current_arr) < 0)
-				{
-					j_goto_error();
-				}
+				buffer->compressed_length = info->size;
+				buffer->compressed = g_malloc(buffer->compressed_length);
+			}
 
-				point_current = point_current_arr[stored_ndims - 1];
-				skipsize = stored_dims[stored_ndims - 1];
+			H5VL_julea_db_dataset_chunks_get_statistics(object, segment->chunk, &buffer->statistics);
 
-				for (i = 2; i <= (guint)stored_ndims; i++)
-				{
-					point_current += point_current_arr[stored_ndims - i] * skipsize;
-					skipsize *= stored_dims[stored_ndims - i];
-				}
+			g_ptr_array_add(buffers, buffer);
+			covered = 0;
+		}
 
-				if (range_valid)
-				{
-					if ((guint64)point_current == range.stop + 1)
-					{
-						range.stop++;
-					}
-					else
-					{
-						g_array_append_val(range_arr, range);
-						range.start = point_current;
-						range.stop = point_current;
-					}
-				}
-				else
-				{
-					range.start = point_current;
-					range.stop = point_current;
-					range_valid = TRUE;
+		// Segments are sorted and merged, so a chunk is covered completely if they are consecutive
+		if (covered == segment->chunk_start * data_size)
+		{
+			covered += segment->count * data_size;
+		}
+	}
 
-					goto _start;
-				}
+	if (buffer != NULL && full && covered == chunk_size)
+	{
+		buffer->fetch = FALSE;
+	}
 
-				point_current_index++;
-			}
+	return buffers;
+}
 
-			if (range_valid)
-			{
-				g_array_append_val(range_arr, range);
-			}
-		}
-		break;
-		case H5S_SEL_HYPERSLABS:
+/**
+ * Reads and unfilters the stored chunks of the given buffers.
+ * The chunks are read in parallel and decompressed using multiple threads.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+H5VL_julea_db_dataset_chunks_fetch(JHDF5Object_t* object, GPtrArray* buffers)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(GPtrArray) fetched = NULL;
+	guint64 bytes_read = 0;
+
+	batch = H5VL_julea_db_dataset_batch_new(object);
+	fetched = g_ptr_array_new();
+
+	for (guint i = 0; i < buffers->len; i++)
+	{
+		JHDF5ChunkBuffer* buffer = g_ptr_array_index(buffers, i);
+
+		if (buffer->fetch)
 		{
-			g_autofree hsize_t* hyperspab_counters = NULL;
-			g_autofree hsize_t* hyperspab_coordinates = NULL;
-			g_autofree hsize_t* hyperspab_skip_size = NULL;
-			hssize_t hyperslab_count;
-			hssize_t hyperslab_index;
-			gint current_counter;
-			gboolean found;
-			gboolean first;
+			j_distributed_object_read(H5VL_julea_db_dataset_chunks_get_object(object, buffer->chunk), buffer->compressed, buffer->compressed_length, 0, &bytes_read, batch);
+			g_ptr_array_add(fetched, buffer);
+		}
+	}
 
-			if ((hyperslab_count = H5Sget_select_hyper_nblocks(mem_space_id)) < 0)
-			{
-				j_goto_error();
-			}
+	if (fetched->len == 0)
+	{
+		return TRUE;
+	}
 
-			hyperspab_coordinates = g_new(hsize_t, stored_ndims * 2);
-			hyperspab_counters = g_new(hsize_t, stored_ndims);
-			hyperspab_skip_size = g_new(hsize_t, stored_ndims);
-			hyperspab_skip_size[stored_ndims - 1] = 1;
+	if (!j_batch_execute(batch))
+	{
+		return FALSE;
+	}
 
-			for (i = stored_ndims - 1; i > 0; i--)
-			{
-				hyperspab_skip_size[i - 1] = hyperspab_skip_size[i] * stored_dims[i];
-			}
+	j_helper_execute_parallel(H5VL_julea_db_chunk_buffer_decompress, fetched->pdata, fetched->len);
 
-			//iterate over all hyperslabs
-			for (hyperslab_index = 0; hyperslab_index < hyperslab_count; hyperslab_index++)
-			{
-				if (H5Sget_select_hyper_blocklist(mem_space_id, hyperslab_index, 1, hyperspab_coordinates) < 0)
-				{
-					j_goto_error();
-				}
+	for (guint i = 0; i < fetched->len; i++)
+	{
+		JHDF5ChunkBuffer* buffer = g_ptr_array_index(fetched, i);
 
-				for (i = 0; i < (guint)stored_ndims; i++)
-				{
-					hyperspab_counters[i] = hyperspab_coordinates[i];
-				}
+		if (!buffer->ret)
+		{
+			return FALSE;
+		}
+	}
 
-				current_counter = stored_ndims - 1;
-				first = TRUE;
-				//within a hyperslab - iterate over the dimensions
+	return TRUE;
+}
 
-				do
-				{
-					//update current counter
-					found = FALSE;
+/**
+ * Writes the selected parts of a filtered, chunked dataset.
+ * Touched chunks are read and unfiltered unless they are overwritten completely, modified, filtered again and written as a whole.
+ * The filter pipeline is applied to multiple chunks in parallel.
+ *
+ * \param object    The dataset.
+ * \param pieces    The pieces, as returned by H5VL_julea_db_space_hdf5_to_pieces().
+ * \param buf       The packed staging buffer.
+ * \param data_size The element size.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+H5VL_julea_db_dataset_chunks_write_filtered(JHDF5Object_t* object, GArray* pieces, const char* buf, gsize data_size)
+{
+	J_TRACE_FUNCTION(NULL);
 
-					while (current_counter >= 0)
-					{
-						if ((hyperspab_counters[current_counter] < hyperspab_coordinates[stored_ndims + current_counter]) || first)
-						{
-							found = TRUE;
-							first = FALSE;
+	g_autoptr(GArray) segments = NULL;
+	g_autoptr(GPtrArray) buffers = NULL;
+	g_autoptr(GArray) updates = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = NULL;
+	guint64 bytes_written = 0;
+	guint buffer_index = 0;
+
+	segments = H5VL_julea_db_dataset_chunks_get_segments(object, pieces);
+	buffers = H5VL_julea_db_dataset_chunks_get_buffers(object, segments, data_size, TRUE);
 
-							break;
-						}
+	if (!H5VL_julea_db_dataset_chunks_fetch(object, buffers))
+	{
+		j_goto_error();
+	}
 
-						for (i = 0; i < (guint)stored_ndims; i++)
-						{
-							//reset counters
-							hyperspab_counters[current_counter] = hyperspab_coordinates[i];
-						}
+	for (guint i = 0; i < segments->len; i++)
+	{
+		JHDF5ChunkSegment* segment = &g_array_index(segments, JHDF5ChunkSegment, i);
+		JHDF5ChunkBuffer* buffer = g_ptr_array_index(buffers, buffer_index);
 
-						current_counter--;
-					}
+		if (buffer->chunk != segment->chunk)
+		{
+			buffer_index++;
+			buffer = g_ptr_array_index(buffers, buffer_index);
+		}
 
-					if (!found)
-					{
-						break;
-					}
+		memcpy(buffer->data + segment->chunk_start * data_size, buf + segment->staging_start * data_size, segment->count * data_size);
+		H5VL_julea_db_statistics_update(&buffer->statistics, buf + segment->staging_start * data_size, segment->count * data_size, object->dataset.datatype->datatype.hdf5_id);
+	}
 
-					//calculate output range
-					range_tmp.start = 0;
+	j_helper_execute_parallel(H5VL_julea_db_chunk_buffer_compress, buffers->pdata, buffers->len);
 
-					for (i = 0; i < (guint)stored_ndims; i++)
-					{
-						range_tmp.start += hyperspab_counters[i] * hyperspab_skip_size[i];
-					}
+	batch = H5VL_julea_db_dataset_batch_new(object);
+	updates = g_array_new(FALSE, FALSE, sizeof(JHDF5ChunkUpdate));
 
-					range_tmp.stop = range_tmp.start + hyperspab_coordinates[stored_ndims * 2 - 1] - hyperspab_coordinates[stored_ndims - 1];
+	for (guint i = 0; i < buffers->len; i++)
+	{
+		JHDF5ChunkBuffer* buffer = g_ptr_array_index(buffers, i);
+		JDistributedObject* chunk_object;
 
-					if (!range_valid)
-					{
-						range.start = range_tmp.start;
-						range.stop = range_tmp.stop;
-						range_valid = TRUE;
-					}
-					else
-					{
-						if (range.stop + 1 == range_tmp.start)
-						{ //merge consecutive ranges
-							range.stop = range_tmp.stop;
-						}
-						else
-						{ //append range if the next has a gap
-							g_array_append_val(range_arr, range);
-							range.start = range_tmp.start;
-							range.stop = range_tmp.stop;
-						}
-					}
+		if (!buffer->ret)
+		{
+			j_goto_error();
+		}
 
-					hyperspab_counters[current_counter]++;
-				} while (1);
-			}
+		chunk_object = H5VL_julea_db_dataset_chunks_get_object(object, buffer->chunk);
 
-			if (range_valid)
-			{
-				g_array_append_val(range_arr, range);
-			}
+		if (!g_hash_table_contains(object->dataset.chunks.allocated, &buffer->chunk))
+		{
+			j_distributed_object_create(chunk_object, batch);
 		}
-		break;
-		case H5S_SEL_ALL:
+
+		if (!H5VL_julea_db_dataset_chunks_record(object, buffer->chunk, buffer->compressed_length, &buffer->statistics, updates, batch, &error))
 		{
-			range.start = 0;
-			range.stop = 1;
+			j_goto_error();
+		}
 
-			for (i = 0; i < (guint)stored_ndims; i++)
-			{
-				range.stop *= stored_dims[i];
-			}
+		// Stale data behind the new end of the chunk is ignored thanks to the recorded size
+		j_distributed_object_write(chunk_object, buffer->compressed, buffer->compressed_length, 0, &bytes_written, batch);
+	}
 
-			g_array_append_val(range_arr, range);
-		}
-		break;
-		case H5S_SEL_N:
-		case H5S_SEL_ERROR:
-		case H5S_SEL_NONE:
-		default:
-			g_critical("%s NOT implemented !!", G_STRLOC);
-			g_assert_not_reached();
+	if (!j_batch_execute(batch))
+	{
+		j_goto_error();
 	}
 
-	//TODO for speedup: sort the array of ranges and merge if possible
-	return range_arr;
+	H5VL_julea_db_dataset_chunks_commit(object, updates);
+
+	return TRUE;
 
 _error:
-	g_array_free(range_arr, TRUE);
+	H5VL_julea_db_error_handler(error);
 
-	return NULL;
+	return FALSE;
 }
 
-#define calculate_statistics_helper(_buf, _target_extension) \
-	do \
-	{ \
-		for (i = 0; i < n; i++) \
-		{ \
-			if (_buf < object->dataset.statistics.min_value##_target_extension) \
-				object->dataset.statistics.min_value##_target_extension = _buf; \
-			if (_buf > object->dataset.statistics.max_value##_target_extension) \
-				object->dataset.statistics.max_value##_target_extension = _buf; \
-		} \
-	} while (0)
-
-static void
-calculate_statistics(JHDF5Object_t* object, const void* buf, gsize bytes, hid_t memory_type)
+/**
+ * Reads the selected parts of a filtered, chunked dataset.
+ * Touched chunks are read as a whole, unfiltered in parallel and copied into the staging buffer.
+ * Unallocated chunks are skipped, so the corresponding parts of the staging buffer have to be zeroed.
+ *
+ * \param object    The dataset.
+ * \param pieces    The pieces, as returned by H5VL_julea_db_space_hdf5_to_pieces().
+ * \param buf       The packed staging buffer.
+ * \param data_size The element size.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+H5VL_julea_db_dataset_chunks_read_filtered(JHDF5Object_t* object, GArray* pieces, char* buf, gsize data_size)
 {
-	guint i;
-	guint n;
-	guint element_size = H5Tget_size(memory_type);
-	n = bytes / element_size;
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GArray) segments = NULL;
+	g_autoptr(GPtrArray) buffers = NULL;
+	guint buffer_index = 0;
+
+	segments = H5VL_julea_db_dataset_chunks_get_segments(object, pieces);
+	buffers = H5VL_julea_db_dataset_chunks_get_buffers(object, segments, data_size, FALSE);
 
-	if (H5Tget_class(memory_type) == H5T_FLOAT)
+	if (!H5VL_julea_db_dataset_chunks_fetch(object, buffers))
 	{
-		if (element_size == 4)
-		{
-			calculate_statistics_helper(((gdouble)((const gfloat*)buf)[i]), _f);
-		}
-		else if (element_size == 8)
-		{
-			calculate_statistics_helper(((const gdouble*)buf)[i], _f);
-		}
+		return FALSE;
 	}
-	else if (H5Tget_class(memory_type) == H5T_INTEGER)
+
+	for (guint i = 0; i < segments->len; i++)
 	{
-		if (H5Tget_sign(memory_type) == H5T_SGN_NONE)
+		JHDF5ChunkSegment* segment = &g_array_index(segments, JHDF5ChunkSegment, i);
+		JHDF5ChunkBuffer* buffer = g_ptr_array_index(buffers, buffer_index);
+
+		if (buffer->chunk != segment->chunk)
 		{
-			if (element_size == 1)
-			{
-				calculate_statistics_helper(((gint8)((const guint8*)buf)[i]), _i);
-			}
-			else if (element_size == 2)
-			{
-				calculate_statistics_helper(((gint16)((const guint16*)buf)[i]), _i);
-			}
-			else if (element_size == 4)
-			{
-				calculate_statistics_helper(((gint32)((const guint32*)buf)[i]), _i);
-			}
-			else if (element_size == 8)
-			{
-				calculate_statistics_helper(((gint64)((const guint64*)buf)[i]), _i);
-			}
+			buffer_index++;
+			buffer = g_ptr_array_index(buffers, buffer_index);
 		}
-		else
+
+		if (buffer->fetch)
 		{
-			if (element_size == 1)
-			{
-				calculate_statistics_helper(((const gint8*)buf)[i], _i);
-			}
-			else if (element_size == 2)
-			{
-				calculate_statistics_helper(((const gint16*)buf)[i], _i);
-			}
-			else if (element_size == 4)
-			{
-				calculate_statistics_helper(((const gint32*)buf)[i], _i);
-			}
-			else if (element_size == 8)
-			{
-				calculate_statistics_helper(((const gint64*)buf)[i], _i);
-			}
+			memcpy(buf + segment->staging_start * data_size, buffer->data + segment->chunk_start * data_size, segment->count * data_size);
 		}
 	}
+
+	return TRUE;
 }
 
 static herr_t
@@ -902,98 +2364,156 @@ H5VL_julea_db_dataset_write(void* obj, hid_t mem_type_id, hid_t mem_space_id, hi
 {
 	J_TRACE_FUNCTION(NULL);
 
-	g_autofree void* local_buf_org = NULL;
+	g_autofree char* staging_buf = NULL;
 	g_autoptr(JBatch) batch = NULL;
-	g_autoptr(GArray) mem_space_arr = NULL;
-	g_autoptr(GArray) file_space_arr = NULL;
-	const void* local_buf;
+	g_autoptr(GArray) pieces = NULL;
+	g_autoptr(GError) error = NULL;
+	const char* local_buf;
 	guint64 bytes_written;
 	gsize data_size;
-	gsize data_count;
+	gsize mem_size;
+	guint64 data_count;
 	JHDF5Object_t* object = obj;
-	guint mem_space_idx;
-	guint file_space_idx;
-	JHDF5IndexRange* mem_space_range = NULL;
-	JHDF5IndexRange* file_space_range = NULL;
-	guint64 current_count1;
-	guint64 current_count2;
+	JHDF5Request_t* request = NULL;
+	gboolean collective;
 	guint i;
 
-	(void)xfer_plist_id;
-	(void)req;
-
 	g_return_val_if_fail(buf != NULL, 1);
 	g_return_val_if_fail(object->type == J_HDF5_OBJECT_TYPE_DATASET, 1);
 
 	data_size = object->dataset.datatype->datatype.type_total_size;
+	mem_size = H5Tget_size(mem_type_id);
+	collective = H5VL_julea_db_collective_enabled(object, xfer_plist_id);
 
-	if (!(batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT)))
+	if (!(batch = H5VL_julea_db_dataset_batch_new(object)))
 	{
 		j_goto_error();
 	}
 
-	if (!(mem_space_arr = H5VL_julea_db_space_hdf5_to_range(mem_space_id, object->dataset.space->space.hdf5_id)))
+	if (!(pieces = H5VL_julea_db_space_hdf5_to_pieces(mem_space_id, file_space_id, object->dataset.space->space.hdf5_id, &data_count)))
 	{
 		j_goto_error();
 	}
 
-	if (!(file_space_arr = H5VL_julea_db_space_hdf5_to_range(file_space_id, object->dataset.space->space.hdf5_id)))
+	// Ranks without a selection still have to take part in collective writes
+	if (data_count == 0 && !collective)
 	{
-		j_goto_error();
+		return 0;
 	}
 
-	data_count = 0;
+	// The staging buffer is converted in place, so it has to be able to hold both representations
+	staging_buf = g_new(char, MAX(data_size, mem_size) * data_count);
+
+	// Gather the selected elements into a packed buffer sorted by file offset
+	for (i = 0; i < pieces->len; i++)
+	{
+		JHDF5Piece* piece = &g_array_index(pieces, JHDF5Piece, i);
+
+		memcpy(staging_buf + piece->staging_start * mem_size, (const char*)buf + piece->mem_start * mem_size, piece->count * mem_size);
+	}
 
-	for (i = 0; i < mem_space_arr->len; i++)
+	if (!H5VL_julea_db_datatype_convert(mem_type_id, object->dataset.datatype->datatype.hdf5_id, staging_buf, data_count))
 	{
-		mem_space_range = &g_array_index(mem_space_arr, JHDF5IndexRange, i);
-		data_count += mem_space_range->stop - mem_space_range->start;
+		j_goto_error();
 	}
 
-	local_buf_org = g_new(char, data_size* data_count);
+	local_buf = staging_buf;
+	H5VL_julea_db_statistics_update(&object->dataset.statistics, local_buf, data_size * data_count, object->dataset.datatype->datatype.hdf5_id);
 
-	local_buf = H5VL_julea_db_datatype_convert_type(mem_type_id, object->dataset.datatype->datatype.hdf5_id, buf, local_buf_org, data_count);
-	mem_space_idx = 0;
-	file_space_idx = 0;
+	bytes_written = 0;
 
-	while ((mem_space_idx < mem_space_arr->len) && (file_space_idx < file_space_arr->len))
+	if (collective)
 	{
-		if (mem_space_range == NULL)
+		g_autoptr(GArray) extents = NULL;
+		gboolean handled;
+
+		extents = g_array_sized_new(FALSE, FALSE, sizeof(JHDF5Extent), pieces->len);
+
+		for (i = 0; i < pieces->len;)
 		{
-			mem_space_range = &g_array_index(mem_space_arr, JHDF5IndexRange, mem_space_idx++);
+			JHDF5Piece* piece = &g_array_index(pieces, JHDF5Piece, i);
+			JHDF5Extent extent;
+			guint64 count;
+
+			i += H5VL_julea_db_pieces_get_run(pieces, i, &count);
+
+			extent.offset = piece->file_start * data_size;
+			extent.length = count * data_size;
+			extent.data = local_buf + piece->staging_start * data_size;
+			g_array_append_val(extents, extent);
 		}
 
-		if (file_space_range == NULL)
+		if (!H5VL_julea_db_collective_write(object, extents, &handled))
 		{
-			file_space_range = &g_array_index(file_space_arr, JHDF5IndexRange, file_space_idx++);
+			j_goto_error();
 		}
 
-		current_count1 = mem_space_range->stop - mem_space_range->start;
-		current_count2 = file_space_range->stop - file_space_range->start;
-		current_count1 = current_count1 < current_count2 ? current_count1 : current_count2;
-		calculate_statistics(object, ((const char*)local_buf) + mem_space_range->start * data_size, data_size * current_count1, mem_type_id);
-		j_distributed_object_write(object->dataset.object, ((const char*)local_buf) + mem_space_range->start * data_size, data_size * current_count1, file_space_range->start * data_size, &bytes_written, batch);
-
-		if (mem_space_range->start + current_count1 == mem_space_range->stop)
+		if (handled || data_count == 0)
 		{
-			mem_space_range = NULL;
+			j_hdf5_log(object->dataset.file->file.name, "a", 'W', NULL, object, NULL);
+			return 0;
 		}
 
-		if (file_space_range->start + current_count1 == file_space_range->stop)
+		// The write could not be aggregated, fall back to independent writes
+	}
+
+	if (object->dataset.chunks.filters != NULL)
+	{
+		// Filtered chunks are executed on their own because they have to be modified as a whole
+		if (!H5VL_julea_db_dataset_chunks_write_filtered(object, pieces, local_buf, data_size))
 		{
-			file_space_range = NULL;
+			j_goto_error();
 		}
 	}
-
-	if (!j_batch_execute(batch))
+	else
 	{
-		j_goto_error();
+		g_autoptr(GArray) updates = NULL;
+		guint64* bytes;
+		GError** batch_error;
+
+		// The staging buffer is handed to the request, so the writes can complete in the background
+		request = H5VL_julea_db_request_new(req, object);
+		bytes = H5VL_julea_db_request_get_bytes(request, &bytes_written);
+		batch_error = H5VL_julea_db_request_get_error(request, &error);
+
+		if (object->dataset.chunks.rank > 0)
+		{
+			updates = g_array_new(FALSE, FALSE, sizeof(JHDF5ChunkUpdate));
+
+			if (!H5VL_julea_db_dataset_chunks_write(object, pieces, local_buf, data_size, bytes, updates, batch, batch_error))
+			{
+				j_goto_error();
+			}
+		}
+		else
+		{
+			for (i = 0; i < pieces->len;)
+			{
+				JHDF5Piece* piece = &g_array_index(pieces, JHDF5Piece, i);
+				guint64 count;
+
+				i += H5VL_julea_db_pieces_get_run(pieces, i, &count);
+				j_distributed_object_write(object->dataset.object, local_buf + piece->staging_start * data_size, data_size * count, piece->file_start * data_size, bytes, batch);
+			}
+		}
+
+		if (!H5VL_julea_db_request_execute(g_steal_pointer(&request), batch, g_steal_pointer(&staging_buf), object, updates, req))
+		{
+			j_goto_error();
+		}
 	}
 
 	j_hdf5_log(object->dataset.file->file.name, "a", 'W', NULL, object, NULL);
 	return 0;
 
 _error:
+	H5VL_julea_db_error_handler(error);
+
+	if (request != NULL)
+	{
+		H5VL_julea_db_request_free(request);
+	}
+
 	return 1;
 }
 
@@ -1002,21 +2522,15 @@ H5VL_julea_db_dataset_read(void* obj, hid_t mem_type_id, hid_t mem_space_id, hid
 {
 	J_TRACE_FUNCTION(NULL);
 
-	g_autofree void* local_buf_org = NULL;
+	g_autofree char* staging_buf = NULL;
 	g_autoptr(JBatch) batch = NULL;
-	g_autoptr(GArray) mem_space_arr = NULL;
-	g_autoptr(GArray) file_space_arr = NULL;
-	const void* local_buf;
+	g_autoptr(GArray) pieces = NULL;
 	guint64 bytes_read;
 	gsize data_size;
-	gsize data_count;
+	gsize mem_size;
+	guint64 data_count;
 	JHDF5Object_t* object = obj;
-	guint mem_space_idx;
-	guint file_space_idx;
-	JHDF5IndexRange* mem_space_range = NULL;
-	JHDF5IndexRange* file_space_range = NULL;
-	guint64 current_count1;
-	guint64 current_count2;
+	gboolean queued;
 	guint i;
 
 	(void)xfer_plist_id;
@@ -1026,73 +2540,72 @@ H5VL_julea_db_dataset_read(void* obj, hid_t mem_type_id, hid_t mem_space_id, hid
 	g_return_val_if_fail(object->type == J_HDF5_OBJECT_TYPE_DATASET, 1);
 
 	data_size = object->dataset.datatype->datatype.type_total_size;
+	mem_size = H5Tget_size(mem_type_id);
 
-	if (!(batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT)))
-	{
-		j_goto_error();
-	}
-
-	if (!(mem_space_arr = H5VL_julea_db_space_hdf5_to_range(mem_space_id, object->dataset.space->space.hdf5_id)))
+	if (!(batch = H5VL_julea_db_dataset_batch_new(object)))
 	{
 		j_goto_error();
 	}
 
-	if (!(file_space_arr = H5VL_julea_db_space_hdf5_to_range(file_space_id, object->dataset.space->space.hdf5_id)))
+	if (!(pieces = H5VL_julea_db_space_hdf5_to_pieces(mem_space_id, file_space_id, object->dataset.space->space.hdf5_id, &data_count)))
 	{
 		j_goto_error();
 	}
 
-	data_count = 0;
-
-	for (i = 0; i < mem_space_arr->len; i++)
+	if (data_count == 0)
 	{
-		mem_space_range = &g_array_index(mem_space_arr, JHDF5IndexRange, i);
-		data_count += mem_space_range->stop - mem_space_range->start;
+		return 0;
 	}
 
-	local_buf_org = g_new(char, data_size* data_count);
+	// Unallocated chunks are not read and have to appear as zeroes
+	// The staging buffer is converted in place, so it has to be able to hold both representations
+	staging_buf = g_new0(char, MAX(data_size, mem_size) * data_count);
 
-	mem_space_idx = 0;
-	file_space_idx = 0;
+	bytes_read = 0;
+	queued = TRUE;
 
-	while ((mem_space_idx < mem_space_arr->len) && (file_space_idx < file_space_arr->len))
+	if (object->dataset.chunks.filters != NULL)
 	{
-		if (mem_space_range == NULL)
-		{
-			mem_space_range = &g_array_index(mem_space_arr, JHDF5IndexRange, mem_space_idx++);
-		}
-
-		if (file_space_range == NULL)
+		if (!H5VL_julea_db_dataset_chunks_read_filtered(object, pieces, staging_buf, data_size))
 		{
-			file_space_range = &g_array_index(file_space_arr, JHDF5IndexRange, file_space_idx++);
+			j_goto_error();
 		}
 
-		current_count1 = mem_space_range->stop - mem_space_range->start;
-		current_count2 = file_space_range->stop - file_space_range->start;
-		current_count1 = current_count1 < current_count2 ? current_count1 : current_count2;
-		j_distributed_object_read(object->dataset.object, ((char*)buf) + mem_space_range->start * data_size, data_size * current_count1, file_space_range->start * data_size, &bytes_read, batch);
-
-		if (mem_space_range->start + current_count1 == mem_space_range->stop)
+		queued = FALSE;
+	}
+	else if (object->dataset.chunks.rank > 0)
+	{
+		queued = H5VL_julea_db_dataset_chunks_read(object, pieces, staging_buf, data_size, &bytes_read, batch);
+	}
+	else
+	{
+		for (i = 0; i < pieces->len;)
 		{
-			mem_space_range = NULL;
-		}
+			JHDF5Piece* piece = &g_array_index(pieces, JHDF5Piece, i);
+			guint64 count;
 
-		if (file_space_range->start + current_count1 == file_space_range->stop)
-		{
-			file_space_range = NULL;
+			i += H5VL_julea_db_pieces_get_run(pieces, i, &count);
+			j_distributed_object_read(object->dataset.object, staging_buf + piece->staging_start * data_size, data_size * count, piece->file_start * data_size, &bytes_read, batch);
 		}
 	}
 
-	if (!j_batch_execute(batch))
+	// Reads of unallocated chunks only leave nothing to execute
+	if (queued && !j_batch_execute(batch))
 	{
 		j_goto_error();
 	}
 
-	local_buf = H5VL_julea_db_datatype_convert_type(mem_type_id, object->dataset.datatype->datatype.hdf5_id, buf, local_buf_org, data_count);
+	if (!H5VL_julea_db_datatype_convert(object->dataset.datatype->datatype.hdf5_id, mem_type_id, staging_buf, data_count))
+	{
+		j_goto_error();
+	}
 
-	if (local_buf != buf)
+	// Scatter the packed elements into the selected parts of the user buffer
+	for (i = 0; i < pieces->len; i++)
 	{
-		memcpy(buf, local_buf, data_size * data_count);
+		JHDF5Piece* piece = &g_array_index(pieces, JHDF5Piece, i);
+
+		memcpy((char*)buf + piece->mem_start * mem_size, staging_buf + piece->staging_start * mem_size, piece->count * mem_size);
 	}
 
 	j_hdf5_log(object->dataset.file->file.name, "a", 'R', NULL, object, NULL);
@@ -1206,22 +2719,7 @@ H5VL_julea_db_dataset_close(void* obj, hid_t dxpl_id, void** req)
 		j_goto_error();
 	}
 
-	if (!j_db_entry_set_field(entry, "min_value_i", &object->dataset.statistics.min_value_i, sizeof(object->dataset.statistics.min_value_i), &error))
-	{
-		j_goto_error();
-	}
-
-	if (!j_db_entry_set_field(entry, "max_value_i", &object->dataset.statistics.max_value_i, sizeof(object->dataset.statistics.max_value_i), &error))
-	{
-		j_goto_error();
-	}
-
-	if (!j_db_entry_set_field(entry, "min_value_f", &object->dataset.statistics.min_value_f, sizeof(object->dataset.statistics.min_value_f), &error))
-	{
-		j_goto_error();
-	}
-
-	if (!j_db_entry_set_field(entry, "max_value_f", &object->dataset.statistics.max_value_f, sizeof(object->dataset.statistics.max_value_f), &error))
+	if (!H5VL_julea_db_statistics_set_fields(entry, &object->dataset.statistics, &error))
 	{
 		j_goto_error();
 	}
@@ -44,24 +44,286 @@
 
 static JDBSchema* julea_db_schema_datatype_header = NULL;
 
-static const void*
-H5VL_julea_db_datatype_convert_type_change(hid_t type_id_from, hid_t type_id_to, const char* from_buf, char* target_buf, guint count)
+/**
+ * The native numeric types with conversion fast paths.
+ **/
+enum JHDF5NumericType
 {
-	J_TRACE_FUNCTION(NULL);
+	J_HDF5_NUMERIC_INT8,
+	J_HDF5_NUMERIC_INT16,
+	J_HDF5_NUMERIC_INT32,
+	J_HDF5_NUMERIC_INT64,
+	J_HDF5_NUMERIC_UINT8,
+	J_HDF5_NUMERIC_UINT16,
+	J_HDF5_NUMERIC_UINT32,
+	J_HDF5_NUMERIC_UINT64,
+	J_HDF5_NUMERIC_FLOAT,
+	J_HDF5_NUMERIC_DOUBLE,
+	_J_HDF5_NUMERIC_COUNT
+};
+
+typedef enum JHDF5NumericType JHDF5NumericType;
 
-	(void)from_buf;
-	(void)count;
+/**
+ * The number of values converted at once.
+ **/
+#define J_HDF5_DB_CONVERT_BLOCK 256
+
+/**
+ * Holds a block of values of any numeric type, so values can be accessed using their actual type.
+ **/
+union JHDF5ConvertBlock
+{
+	gint8 i8[J_HDF5_DB_CONVERT_BLOCK];
+	gint16 i16[J_HDF5_DB_CONVERT_BLOCK];
+	gint32 i32[J_HDF5_DB_CONVERT_BLOCK];
+	gint64 i64[J_HDF5_DB_CONVERT_BLOCK];
+	gfloat f32[J_HDF5_DB_CONVERT_BLOCK];
+	gdouble f64[J_HDF5_DB_CONVERT_BLOCK];
+};
 
-	g_assert(H5Tget_class(type_id_from) == H5Tget_class(type_id_to));
-	g_assert(H5Tget_size(type_id_from) == H5Tget_size(type_id_to));
+typedef union JHDF5ConvertBlock JHDF5ConvertBlock;
 
-	// FIXME doesn't do anything?
+typedef void (*JHDF5ConvertFunc)(JHDF5ConvertBlock const*, JHDF5ConvertBlock*, gsize);
 
-	switch (H5Tget_class(type_id_from))
+/**
+ * Defines a conversion kernel for a pair of native types.
+ * Integers are clamped to the target type's range like HDF5's own conversions do.
+ * The loop works on separate blocks, so compilers can vectorize it.
+ *
+ * \param _expr The converted value, computed from the source value v.
+ **/
+#define H5VL_julea_db_convert_kernel(_from, _to, _expr) \
+	static void \
+	H5VL_julea_db_convert_##_from##_##_to(JHDF5ConvertBlock const* in, JHDF5ConvertBlock* out, gsize n) \
+	{ \
+		_from const* values = (_from const*)(gconstpointer)in; \
+		_to* results = (_to*)(gpointer)out; \
+\
+		for (gsize i = 0; i < n; i++) \
+		{ \
+			_from v = values[i]; \
+\
+			results[i] = (_to)(_expr); \
+		} \
+	}
+
+H5VL_julea_db_convert_kernel(gint8, gint16, v)
+H5VL_julea_db_convert_kernel(gint8, gint32, v)
+H5VL_julea_db_convert_kernel(gint8, gint64, v)
+H5VL_julea_db_convert_kernel(gint8, guint8, MAX(v, 0))
+H5VL_julea_db_convert_kernel(gint8, guint16, MAX(v, 0))
+H5VL_julea_db_convert_kernel(gint8, guint32, MAX(v, 0))
+H5VL_julea_db_convert_kernel(gint8, guint64, MAX(v, 0))
+H5VL_julea_db_convert_kernel(gint16, gint8, CLAMP(v, (gint16)G_MININT8, (gint16)G_MAXINT8))
+H5VL_julea_db_convert_kernel(gint16, gint32, v)
+H5VL_julea_db_convert_kernel(gint16, gint64, v)
+H5VL_julea_db_convert_kernel(gint16, guint8, CLAMP(v, 0, (gint16)G_MAXUINT8))
+H5VL_julea_db_convert_kernel(gint16, guint16, MAX(v, 0))
+H5VL_julea_db_convert_kernel(gint16, guint32, MAX(v, 0))
+H5VL_julea_db_convert_kernel(gint16, guint64, MAX(v, 0))
+H5VL_julea_db_convert_kernel(gint32, gint8, CLAMP(v, (gint32)G_MININT8, (gint32)G_MAXINT8))
+H5VL_julea_db_convert_kernel(gint32, gint16, CLAMP(v, (gint32)G_MININT16, (gint32)G_MAXINT16))
+H5VL_julea_db_convert_kernel(gint32, gint64, v)
+H5VL_julea_db_convert_kernel(gint32, guint8, CLAMP(v, 0, (gint32)G_MAXUINT8))
+H5VL_julea_db_convert_kernel(gint32, guint16, CLAMP(v, 0, (gint32)G_MAXUINT16))
+H5VL_julea_db_convert_kernel(gint32, guint32, MAX(v, 0))
+H5VL_julea_db_convert_kernel(gint32, guint64, MAX(v, 0))
+H5VL_julea_db_convert_kernel(gint64, gint8, CLAMP(v, (gint64)G_MININT8, (gint64)G_MAXINT8))
+H5VL_julea_db_convert_kernel(gint64, gint16, CLAMP(v, (gint64)G_MININT16, (gint64)G_MAXINT16))
+H5VL_julea_db_convert_kernel(gint64, gint32, CLAMP(v, (gint64)G_MININT32, (gint64)G_MAXINT32))
+H5VL_julea_db_convert_kernel(gint64, guint8, CLAMP(v, 0, (gint64)G_MAXUINT8))
+H5VL_julea_db_convert_kernel(gint64, guint16, CLAMP(v, 0, (gint64)G_MAXUINT16))
+H5VL_julea_db_convert_kernel(gint64, guint32, CLAMP(v, 0, (gint64)G_MAXUINT32))
+H5VL_julea_db_convert_kernel(gint64, guint64, MAX(v, 0))
+H5VL_julea_db_convert_kernel(guint8, gint8, MIN(v, (guint8)G_MAXINT8))
+H5VL_julea_db_convert_kernel(guint8, gint16, v)
+H5VL_julea_db_convert_kernel(guint8, gint32, v)
+H5VL_julea_db_convert_kernel(guint8, gint64, v)
+H5VL_julea_db_convert_kernel(guint8, guint16, v)
+H5VL_julea_db_convert_kernel(guint8, guint32, v)
+H5VL_julea_db_convert_kernel(guint8, guint64, v)
+H5VL_julea_db_convert_kernel(guint16, gint8, MIN(v, (guint16)G_MAXINT8))
+H5VL_julea_db_convert_kernel(guint16, gint16, MIN(v, (guint16)G_MAXINT16))
+H5VL_julea_db_convert_kernel(guint16, gint32, v)
+H5VL_julea_db_convert_kernel(guint16, gint64, v)
+H5VL_julea_db_convert_kernel(guint16, guint8, MIN(v, (guint16)G_MAXUINT8))
+H5VL_julea_db_convert_kernel(guint16, guint32, v)
+H5VL_julea_db_convert_kernel(guint16, guint64, v)
+H5VL_julea_db_convert_kernel(guint32, gint8, MIN(v, (guint32)G_MAXINT8))
+H5VL_julea_db_convert_kernel(guint32, gint16, MIN(v, (guint32)G_MAXINT16))
+H5VL_julea_db_convert_kernel(guint32, gint32, MIN(v, (guint32)G_MAXINT32))
+H5VL_julea_db_convert_kernel(guint32, gint64, v)
+H5VL_julea_db_convert_kernel(guint32, guint8, MIN(v, (guint32)G_MAXUINT8))
+H5VL_julea_db_convert_kernel(guint32, guint16, MIN(v, (guint32)G_MAXUINT16))
+H5VL_julea_db_convert_kernel(guint32, guint64, v)
+H5VL_julea_db_convert_kernel(guint64, gint8, MIN(v, (guint64)G_MAXINT8))
+H5VL_julea_db_convert_kernel(guint64, gint16, MIN(v, (guint64)G_MAXINT16))
+H5VL_julea_db_convert_kernel(guint64, gint32, MIN(v, (guint64)G_MAXINT32))
+H5VL_julea_db_convert_kernel(guint64, gint64, MIN(v, (guint64)G_MAXINT64))
+H5VL_julea_db_convert_kernel(guint64, guint8, MIN(v, (guint64)G_MAXUINT8))
+H5VL_julea_db_convert_kernel(guint64, guint16, MIN(v, (guint64)G_MAXUINT16))
+H5VL_julea_db_convert_kernel(guint64, guint32, MIN(v, (guint64)G_MAXUINT32))
+H5VL_julea_db_convert_kernel(gint8, gfloat, v)
+H5VL_julea_db_convert_kernel(gint8, gdouble, v)
+H5VL_julea_db_convert_kernel(gint16, gfloat, v)
+H5VL_julea_db_convert_kernel(gint16, gdouble, v)
+H5VL_julea_db_convert_kernel(gint32, gfloat, v)
+H5VL_julea_db_convert_kernel(gint32, gdouble, v)
+H5VL_julea_db_convert_kernel(gint64, gfloat, v)
+H5VL_julea_db_convert_kernel(gint64, gdouble, v)
+H5VL_julea_db_convert_kernel(guint8, gfloat, v)
+H5VL_julea_db_convert_kernel(guint8, gdouble, v)
+H5VL_julea_db_convert_kernel(guint16, gfloat, v)
+H5VL_julea_db_convert_kernel(guint16, gdouble, v)
+H5VL_julea_db_convert_kernel(guint32, gfloat, v)
+H5VL_julea_db_convert_kernel(guint32, gdouble, v)
+H5VL_julea_db_convert_kernel(guint64, gfloat, v)
+H5VL_julea_db_convert_kernel(guint64, gdouble, v)
+H5VL_julea_db_convert_kernel(gfloat, gdouble, v)
+H5VL_julea_db_convert_kernel(gdouble, gfloat, v)
+
+static JHDF5ConvertFunc const julea_db_convert_kernels[_J_HDF5_NUMERIC_COUNT][_J_HDF5_NUMERIC_COUNT] = {
+	[J_HDF5_NUMERIC_INT8][J_HDF5_NUMERIC_INT16] = H5VL_julea_db_convert_gint8_gint16,
+	[J_HDF5_NUMERIC_INT8][J_HDF5_NUMERIC_INT32] = H5VL_julea_db_convert_gint8_gint32,
+	[J_HDF5_NUMERIC_INT8][J_HDF5_NUMERIC_INT64] = H5VL_julea_db_convert_gint8_gint64,
+	[J_HDF5_NUMERIC_INT8][J_HDF5_NUMERIC_UINT8] = H5VL_julea_db_convert_gint8_guint8,
+	[J_HDF5_NUMERIC_INT8][J_HDF5_NUMERIC_UINT16] = H5VL_julea_db_convert_gint8_guint16,
+	[J_HDF5_NUMERIC_INT8][J_HDF5_NUMERIC_UINT32] = H5VL_julea_db_convert_gint8_guint32,
+	[J_HDF5_NUMERIC_INT8][J_HDF5_NUMERIC_UINT64] = H5VL_julea_db_convert_gint8_guint64,
+	[J_HDF5_NUMERIC_INT16][J_HDF5_NUMERIC_INT8] = H5VL_julea_db_convert_gint16_gint8,
+	[J_HDF5_NUMERIC_INT16][J_HDF5_NUMERIC_INT32] = H5VL_julea_db_convert_gint16_gint32,
+	[J_HDF5_NUMERIC_INT16][J_HDF5_NUMERIC_INT64] = H5VL_julea_db_convert_gint16_gint64,
+	[J_HDF5_NUMERIC_INT16][J_HDF5_NUMERIC_UINT8] = H5VL_julea_db_convert_gint16_guint8,
+	[J_HDF5_NUMERIC_INT16][J_HDF5_NUMERIC_UINT16] = H5VL_julea_db_convert_gint16_guint16,
+	[J_HDF5_NUMERIC_INT16][J_HDF5_NUMERIC_UINT32] = H5VL_julea_db_convert_gint16_guint32,
+	[J_HDF5_NUMERIC_INT16][J_HDF5_NUMERIC_UINT64] = H5VL_julea_db_convert_gint16_guint64,
+	[J_HDF5_NUMERIC_INT32][J_HDF5_NUMERIC_INT8] = H5VL_julea_db_convert_gint32_gint8,
+	[J_HDF5_NUMERIC_INT32][J_HDF5_NUMERIC_INT16] = H5VL_julea_db_convert_gint32_gint16,
+	[J_HDF5_NUMERIC_INT32][J_HDF5_NUMERIC_INT64] = H5VL_julea_db_convert_gint32_gint64,
+	[J_HDF5_NUMERIC_INT32][J_HDF5_NUMERIC_UINT8] = H5VL_julea_db_convert_gint32_guint8,
+	[J_HDF5_NUMERIC_INT32][J_HDF5_NUMERIC_UINT16] = H5VL_julea_db_convert_gint32_guint16,
+	[J_HDF5_NUMERIC_INT32][J_HDF5_NUMERIC_UINT32] = H5VL_julea_db_convert_gint32_guint32,
+	[J_HDF5_NUMERIC_INT32][J_HDF5_NUMERIC_UINT64] = H5VL_julea_db_convert_gint32_guint64,
+	[J_HDF5_NUMERIC_INT64][J_HDF5_NUMERIC_INT8] = H5VL_julea_db_convert_gint64_gint8,
+	[J_HDF5_NUMERIC_INT64][J_HDF5_NUMERIC_INT16] = H5VL_julea_db_convert_gint64_gint16,
+	[J_HDF5_NUMERIC_INT64][J_HDF5_NUMERIC_INT32] = H5VL_julea_db_convert_gint64_gint32,
+	[J_HDF5_NUMERIC_INT64][J_HDF5_NUMERIC_UINT8] = H5VL_julea_db_convert_gint64_guint8,
+	[J_HDF5_NUMERIC_INT64][J_HDF5_NUMERIC_UINT16] = H5VL_julea_db_convert_gint64_guint16,
+	[J_HDF5_NUMERIC_INT64][J_HDF5_NUMERIC_UINT32] = H5VL_julea_db_convert_gint64_guint32,
+	[J_HDF5_NUMERIC_INT64][J_HDF5_NUMERIC_UINT64] = H5VL_julea_db_convert_gint64_guint64,
+	[J_HDF5_NUMERIC_UINT8][J_HDF5_NUMERIC_INT8] = H5VL_julea_db_convert_guint8_gint8,
+	[J_HDF5_NUMERIC_UINT8][J_HDF5_NUMERIC_INT16] = H5VL_julea_db_convert_guint8_gint16,
+	[J_HDF5_NUMERIC_UINT8][J_HDF5_NUMERIC_INT32] = H5VL_julea_db_convert_guint8_gint32,
+	[J_HDF5_NUMERIC_UINT8][J_HDF5_NUMERIC_INT64] = H5VL_julea_db_convert_guint8_gint64,
+	[J_HDF5_NUMERIC_UINT8][J_HDF5_NUMERIC_UINT16] = H5VL_julea_db_convert_guint8_guint16,
+	[J_HDF5_NUMERIC_UINT8][J_HDF5_NUMERIC_UINT32] = H5VL_julea_db_convert_guint8_guint32,
+	[J_HDF5_NUMERIC_UINT8][J_HDF5_NUMERIC_UINT64] = H5VL_julea_db_convert_guint8_guint64,
+	[J_HDF5_NUMERIC_UINT16][J_HDF5_NUMERIC_INT8] = H5VL_julea_db_convert_guint16_gint8,
+	[J_HDF5_NUMERIC_UINT16][J_HDF5_NUMERIC_INT16] = H5VL_julea_db_convert_guint16_gint16,
+	[J_HDF5_NUMERIC_UINT16][J_HDF5_NUMERIC_INT32] = H5VL_julea_db_convert_guint16_gint32,
+	[J_HDF5_NUMERIC_UINT16][J_HDF5_NUMERIC_INT64] = H5VL_julea_db_convert_guint16_gint64,
+	[J_HDF5_NUMERIC_UINT16][J_HDF5_NUMERIC_UINT8] = H5VL_julea_db_convert_guint16_guint8,
+	[J_HDF5_NUMERIC_UINT16][J_HDF5_NUMERIC_UINT32] = H5VL_julea_db_convert_guint16_guint32,
+	[J_HDF5_NUMERIC_UINT16][J_HDF5_NUMERIC_UINT64] = H5VL_julea_db_convert_guint16_guint64,
+	[J_HDF5_NUMERIC_UINT32][J_HDF5_NUMERIC_INT8] = H5VL_julea_db_convert_guint32_gint8,
+	[J_HDF5_NUMERIC_UINT32][J_HDF5_NUMERIC_INT16] = H5VL_julea_db_convert_guint32_gint16,
+	[J_HDF5_NUMERIC_UINT32][J_HDF5_NUMERIC_INT32] = H5VL_julea_db_convert_guint32_gint32,
+	[J_HDF5_NUMERIC_UINT32][J_HDF5_NUMERIC_INT64] = H5VL_julea_db_convert_guint32_gint64,
+	[J_HDF5_NUMERIC_UINT32][J_HDF5_NUMERIC_UINT8] = H5VL_julea_db_convert_guint32_guint8,
+	[J_HDF5_NUMERIC_UINT32][J_HDF5_NUMERIC_UINT16] = H5VL_julea_db_convert_guint32_guint16,
+	[J_HDF5_NUMERIC_UINT32][J_HDF5_NUMERIC_UINT64] = H5VL_julea_db_convert_guint32_guint64,
+	[J_HDF5_NUMERIC_UINT64][J_HDF5_NUMERIC_INT8] = H5VL_julea_db_convert_guint64_gint8,
+	[J_HDF5_NUMERIC_UINT64][J_HDF5_NUMERIC_INT16] = H5VL_julea_db_convert_guint64_gint16,
+	[J_HDF5_NUMERIC_UINT64][J_HDF5_NUMERIC_INT32] = H5VL_julea_db_convert_guint64_gint32,
+	[J_HDF5_NUMERIC_UINT64][J_HDF5_NUMERIC_INT64] = H5VL_julea_db_convert_guint64_gint64,
+	[J_HDF5_NUMERIC_UINT64][J_HDF5_NUMERIC_UINT8] = H5VL_julea_db_convert_guint64_guint8,
+	[J_HDF5_NUMERIC_UINT64][J_HDF5_NUMERIC_UINT16] = H5VL_julea_db_convert_guint64_guint16,
+	[J_HDF5_NUMERIC_UINT64][J_HDF5_NUMERIC_UINT32] = H5VL_julea_db_convert_guint64_guint32,
+	[J_HDF5_NUMERIC_INT8][J_HDF5_NUMERIC_FLOAT] = H5VL_julea_db_convert_gint8_gfloat,
+	[J_HDF5_NUMERIC_INT8][J_HDF5_NUMERIC_DOUBLE] = H5VL_julea_db_convert_gint8_gdouble,
+	[J_HDF5_NUMERIC_INT16][J_HDF5_NUMERIC_FLOAT] = H5VL_julea_db_convert_gint16_gfloat,
+	[J_HDF5_NUMERIC_INT16][J_HDF5_NUMERIC_DOUBLE] = H5VL_julea_db_convert_gint16_gdouble,
+	[J_HDF5_NUMERIC_INT32][J_HDF5_NUMERIC_FLOAT] = H5VL_julea_db_convert_gint32_gfloat,
+	[J_HDF5_NUMERIC_INT32][J_HDF5_NUMERIC_DOUBLE] = H5VL_julea_db_convert_gint32_gdouble,
+	[J_HDF5_NUMERIC_INT64][J_HDF5_NUMERIC_FLOAT] = H5VL_julea_db_convert_gint64_gfloat,
+	[J_HDF5_NUMERIC_INT64][J_HDF5_NUMERIC_DOUBLE] = H5VL_julea_db_convert_gint64_gdouble,
+	[J_HDF5_NUMERIC_UINT8][J_HDF5_NUMERIC_FLOAT] = H5VL_julea_db_convert_guint8_gfloat,
+	[J_HDF5_NUMERIC_UINT8][J_HDF5_NUMERIC_DOUBLE] = H5VL_julea_db_convert_guint8_gdouble,
+	[J_HDF5_NUMERIC_UINT16][J_HDF5_NUMERIC_FLOAT] = H5VL_julea_db_convert_guint16_gfloat,
+	[J_HDF5_NUMERIC_UINT16][J_HDF5_NUMERIC_DOUBLE] = H5VL_julea_db_convert_guint16_gdouble,
+	[J_HDF5_NUMERIC_UINT32][J_HDF5_NUMERIC_FLOAT] = H5VL_julea_db_convert_guint32_gfloat,
+	[J_HDF5_NUMERIC_UINT32][J_HDF5_NUMERIC_DOUBLE] = H5VL_julea_db_convert_guint32_gdouble,
+	[J_HDF5_NUMERIC_UINT64][J_HDF5_NUMERIC_FLOAT] = H5VL_julea_db_convert_guint64_gfloat,
+	[J_HDF5_NUMERIC_UINT64][J_HDF5_NUMERIC_DOUBLE] = H5VL_julea_db_convert_guint64_gdouble,
+	[J_HDF5_NUMERIC_FLOAT][J_HDF5_NUMERIC_DOUBLE] = H5VL_julea_db_convert_gfloat_gdouble,
+	[J_HDF5_NUMERIC_DOUBLE][J_HDF5_NUMERIC_FLOAT] = H5VL_julea_db_convert_gdouble_gfloat,
+};
+
+/**
+ * Classifies a datatype as one of the numeric types with conversion fast paths.
+ *
+ * \param type_id The datatype.
+ * \param numeric Returns the numeric type.
+ * \param swap    Returns whether the values' byte order differs from the native one.
+ *
+ * \return TRUE if the datatype is supported, FALSE otherwise.
+ **/
+static gboolean
+H5VL_julea_db_datatype_get_numeric(hid_t type_id, JHDF5NumericType* numeric, gboolean* swap)
+{
+	H5T_order_t native_order;
+	size_t size;
+
+	native_order = (G_BYTE_ORDER == G_LITTLE_ENDIAN) ? H5T_ORDER_LE : H5T_ORDER_BE;
+	size = H5Tget_size(type_id);
+
+	switch (H5Tget_class(type_id))
 	{
-		case H5T_FLOAT: // no conversion
-			break;
-		case H5T_INTEGER: // no conversion
+		case H5T_INTEGER:
+		{
+			gboolean is_signed;
+
+			// Integers with padding bits are left to HDF5
+			if (H5Tget_precision(type_id) != size * 8 || H5Tget_offset(type_id) != 0)
+			{
+				return FALSE;
+			}
+
+			is_signed = (H5Tget_sign(type_id) == H5T_SGN_2);
+
+			switch (size)
+			{
+				case 1:
+					*numeric = (is_signed) ? J_HDF5_NUMERIC_INT8 : J_HDF5_NUMERIC_UINT8;
+					break;
+				case 2:
+					*numeric = (is_signed) ? J_HDF5_NUMERIC_INT16 : J_HDF5_NUMERIC_UINT16;
+					break;
+				case 4:
+					*numeric = (is_signed) ? J_HDF5_NUMERIC_INT32 : J_HDF5_NUMERIC_UINT32;
+					break;
+				case 8:
+					*numeric = (is_signed) ? J_HDF5_NUMERIC_INT64 : J_HDF5_NUMERIC_UINT64;
+					break;
+				default:
+					return FALSE;
+			}
+		}
+		break;
+		case H5T_FLOAT:
+			if (H5Tequal(type_id, H5T_IEEE_F32LE) > 0 || H5Tequal(type_id, H5T_IEEE_F32BE) > 0)
+			{
+				*numeric = J_HDF5_NUMERIC_FLOAT;
+			}
+			else if (H5Tequal(type_id, H5T_IEEE_F64LE) > 0 || H5Tequal(type_id, H5T_IEEE_F64BE) > 0)
+			{
+				*numeric = J_HDF5_NUMERIC_DOUBLE;
+			}
+			else
+			{
+				return FALSE;
+			}
 			break;
 		case H5T_STRING:
 		case H5T_BITFIELD:
@@ -75,24 +337,140 @@ H5VL_julea_db_datatype_convert_type_change(hid_t type_id_from, hid_t type_id_to,
 		case H5T_TIME:
 		case H5T_NCLASSES:
 		default:
-			g_critical("%s NOT implemented !!", G_STRLOC);
-			g_assert_not_reached();
+			return FALSE;
 	}
 
-	return target_buf;
+	*swap = (size > 1 && H5Tget_order(type_id) != native_order);
+
+	return TRUE;
+}
+
+/**
+ * Reverses the byte order of values in place.
+ **/
+static void
+H5VL_julea_db_datatype_swap(gchar* buf, gsize count, gsize size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	for (gsize i = 0; i < count; i++)
+	{
+		gchar* value = buf + i * size;
+
+		if (size == 2)
+		{
+			guint16 v;
+
+			memcpy(&v, value, sizeof(v));
+			v = GUINT16_SWAP_LE_BE(v);
+			memcpy(value, &v, sizeof(v));
+		}
+		else if (size == 4)
+		{
+			guint32 v;
+
+			memcpy(&v, value, sizeof(v));
+			v = GUINT32_SWAP_LE_BE(v);
+			memcpy(value, &v, sizeof(v));
+		}
+		else if (size == 8)
+		{
+			guint64 v;
+
+			memcpy(&v, value, sizeof(v));
+			v = GUINT64_SWAP_LE_BE(v);
+			memcpy(value, &v, sizeof(v));
+		}
+	}
+}
+
+/**
+ * Converts values in place using a conversion kernel.
+ * Values are converted block by block. Widening conversions start at the end of the buffer, so no unconverted values are overwritten.
+ **/
+static void
+H5VL_julea_db_datatype_convert_blocks(gchar* buf, gsize count, gsize from_size, gsize to_size, JHDF5ConvertFunc func)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JHDF5ConvertBlock in;
+	JHDF5ConvertBlock out;
+	gsize blocks;
+
+	blocks = (count + J_HDF5_DB_CONVERT_BLOCK - 1) / J_HDF5_DB_CONVERT_BLOCK;
+
+	for (gsize i = 0; i < blocks; i++)
+	{
+		gsize block;
+		gsize start;
+		gsize n;
+
+		block = (to_size > from_size) ? blocks - 1 - i : i;
+		start = block * J_HDF5_DB_CONVERT_BLOCK;
+		n = MIN(J_HDF5_DB_CONVERT_BLOCK, count - start);
+
+		memcpy(&in, buf + start * from_size, n * from_size);
+		func(&in, &out, n);
+		memcpy(buf + start * to_size, &out, n * to_size);
+	}
 }
 
-static const void*
-H5VL_julea_db_datatype_convert_type(hid_t type_id_from, hid_t type_id_to, const char* from_buf, char* tmp_buf, guint count)
+/**
+ * Converts values between datatypes in place.
+ * Conversions between native integer and floating point types, including different byte orders, are handled by the connector's own kernels.
+ * All other conversions are left to H5Tconvert().
+ *
+ * \param type_id_from The source datatype.
+ * \param type_id_to   The target datatype.
+ * \param buf          The values, large enough to hold \p count values of the larger datatype.
+ * \param count        The number of values.
+ *
+ * \return TRUE on success, FALSE if the values could not be converted.
+ **/
+static gboolean
+H5VL_julea_db_datatype_convert(hid_t type_id_from, hid_t type_id_to, void* buf, gsize count)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	if (H5Tequal(type_id_from, type_id_to))
+	JHDF5NumericType numeric_from;
+	JHDF5NumericType numeric_to;
+	gboolean swap_from;
+	gboolean swap_to;
+
+	if (count == 0 || H5Tequal(type_id_from, type_id_to) > 0)
 	{
-		return from_buf;
+		return TRUE;
 	}
 
-	return H5VL_julea_db_datatype_convert_type_change(type_id_from, type_id_to, from_buf, tmp_buf, count);
+	if (H5VL_julea_db_datatype_get_numeric(type_id_from, &numeric_from, &swap_from)
+	    && H5VL_julea_db_datatype_get_numeric(type_id_to, &numeric_to, &swap_to)
+	    && (numeric_from == numeric_to || julea_db_convert_kernels[numeric_from][numeric_to] != NULL))
+	{
+		gsize from_size;
+		gsize to_size;
+
+		from_size = H5Tget_size(type_id_from);
+		to_size = H5Tget_size(type_id_to);
+
+		if (swap_from)
+		{
+			H5VL_julea_db_datatype_swap(buf, count, from_size);
+		}
+
+		if (numeric_from != numeric_to)
+		{
+			H5VL_julea_db_datatype_convert_blocks(buf, count, from_size, to_size, julea_db_convert_kernels[numeric_from][numeric_to]);
+		}
+
+		if (swap_to)
+		{
+			H5VL_julea_db_datatype_swap(buf, count, to_size);
+		}
+
+		return TRUE;
+	}
+
+	return (H5Tconvert(type_id_from, type_id_to, count, buf, NULL, H5P_DEFAULT) >= 0);
 }
 
 static herr_t
@@ -240,15 +618,16 @@ _error:
 	return 1;
 }
 
+/**
+ * Creates a datatype from the current row of a datatype header iterator.
+ **/
 static JHDF5Object_t*
-H5VL_julea_db_datatype_decode(void* backend_id, guint64 backend_id_len)
+H5VL_julea_db_datatype_new_from_iterator(void const* backend_id, guint64 backend_id_len, JDBIterator* iterator)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	g_autofree guint32* tmp_uint32 = NULL;
-	g_autoptr(JDBIterator) iterator = NULL;
 	g_autoptr(GError) error = NULL;
-	g_autoptr(JDBSelector) selector = NULL;
 	JHDF5Object_t* object = NULL;
 	JDBType type;
 	guint64 length;
@@ -266,48 +645,65 @@ H5VL_julea_db_datatype_decode(void* backend_id, guint64 backend_id_len)
 	memcpy(object->backend_id, backend_id, backend_id_len);
 	object->backend_id_len = backend_id_len;
 
-	if (!(selector = j_db_selector_new(julea_db_schema_datatype_header, J_DB_SELECTOR_MODE_AND, &error)))
+	if (!j_db_iterator_get_field(iterator, "type_cache", &type, &object->datatype.data, &object->datatype.data_size, &error))
 	{
 		j_goto_error();
 	}
 
-	if (!j_db_selector_add_field(selector, "_id", J_DB_SELECTOR_OPERATOR_EQ, object->backend_id, object->backend_id_len, &error))
+	if (!j_db_iterator_get_field(iterator, "type_size", &type, (gpointer*)&tmp_uint32, &length, &error))
 	{
 		j_goto_error();
 	}
 
-	if (!(iterator = j_db_iterator_new(julea_db_schema_datatype_header, selector, &error)))
+	object->datatype.type_total_size = *tmp_uint32;
+
+	if (!(object->datatype.hdf5_id = H5Tdecode(object->datatype.data)))
 	{
 		j_goto_error();
 	}
 
-	if (!j_db_iterator_next(iterator, NULL))
+	return object;
+
+_error:
+	H5VL_julea_db_error_handler(error);
+	H5VL_julea_db_object_unref(object);
+
+	return NULL;
+}
+
+static JHDF5Object_t*
+H5VL_julea_db_datatype_decode(void* backend_id, guint64 backend_id_len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JDBIterator) iterator = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+
+	if (!(selector = j_db_selector_new(julea_db_schema_datatype_header, J_DB_SELECTOR_MODE_AND, &error)))
 	{
 		j_goto_error();
 	}
 
-	if (!j_db_iterator_get_field(iterator, "type_cache", &type, &object->datatype.data, &object->datatype.data_size, &error))
+	if (!j_db_selector_add_field(selector, "_id", J_DB_SELECTOR_OPERATOR_EQ, backend_id, backend_id_len, &error))
 	{
 		j_goto_error();
 	}
 
-	if (!j_db_iterator_get_field(iterator, "type_size", &type, (gpointer*)&tmp_uint32, &length, &error))
+	if (!(iterator = j_db_iterator_new(julea_db_schema_datatype_header, selector, &error)))
 	{
 		j_goto_error();
 	}
 
-	object->datatype.type_total_size = *tmp_uint32;
-
-	if (!(object->datatype.hdf5_id = H5Tdecode(object->datatype.data)))
+	if (!j_db_iterator_next(iterator, NULL))
 	{
 		j_goto_error();
 	}
 
-	return object;
+	return H5VL_julea_db_datatype_new_from_iterator(backend_id, backend_id_len, iterator);
 
 _error:
 	H5VL_julea_db_error_handler(error);
-	H5VL_julea_db_object_unref(object);
 
 	return NULL;
 }
@@ -163,7 +163,6 @@ H5VL_julea_db_file_create(const char* name, unsigned flags, hid_t fcpl_id, hid_t
 	gboolean exist;
 
 	(void)fcpl_id;
-	(void)fapl_id;
 	(void)dxpl_id;
 	(void)req;
 
@@ -281,6 +280,8 @@ H5VL_julea_db_file_create(const char* name, unsigned flags, hid_t fcpl_id, hid_t
 		}
 	}
 
+	H5VL_julea_db_collective_file_init(object, fapl_id);
+
 	j_hdf5_log(object->file.name, "w", 'C', exist ? "truncated" : NULL, object, NULL);
 	return object;
 
@@ -291,6 +292,257 @@ _error:
 	return NULL;
 }
 
+/**
+ * Fetches the space or datatype headers with the given IDs.
+ * The IDs are combined into OR selectors of at most #J_HDF5_DB_PREFETCH_IDS_MAX entries each.
+ *
+ * \param schema      The header schema.
+ * \param ids         The set of header IDs, as #GBytes.
+ * \param table       The table the decoded headers are inserted into.
+ * \param new_object  The function creating a header object from an iterator.
+ **/
+static gboolean
+H5VL_julea_db_file_prefetch_headers(JDBSchema* schema, GHashTable* id_set, GHashTable* table, JHDF5Object_t* (*new_object)(void const*, guint64, JDBIterator*))
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) ids = NULL;
+	GHashTableIter iter;
+	gpointer key;
+
+	ids = g_ptr_array_new();
+	g_hash_table_iter_init(&iter, id_set);
+
+	while (g_hash_table_iter_next(&iter, &key, NULL))
+	{
+		g_ptr_array_add(ids, key);
+	}
+
+	for (guint i = 0; i < ids->len; i += J_HDF5_DB_PREFETCH_IDS_MAX)
+	{
+		g_autoptr(JDBIterator) iterator = NULL;
+		g_autoptr(JDBSelector) selector = NULL;
+
+		if (!(selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_OR, &error)))
+		{
+			j_goto_error();
+		}
+
+		for (guint j = i; j < ids->len && j < i + J_HDF5_DB_PREFETCH_IDS_MAX; j++)
+		{
+			gconstpointer id;
+			gsize id_len;
+
+			id = g_bytes_get_data(g_ptr_array_index(ids, j), &id_len);
+
+			if (!j_db_selector_add_field(selector, "_id", J_DB_SELECTOR_OPERATOR_EQ, id, id_len, &error))
+			{
+				j_goto_error();
+			}
+		}
+
+		if (!(iterator = j_db_iterator_new(schema, selector, &error)))
+		{
+			j_goto_error();
+		}
+
+		while (j_db_iterator_next(iterator, NULL))
+		{
+			g_autofree void* id = NULL;
+			JHDF5Object_t* object;
+			JDBType type;
+			guint64 id_len;
+
+			if (!j_db_iterator_get_field(iterator, "_id", &type, &id, &id_len, &error))
+			{
+				j_goto_error();
+			}
+
+			if (!(object = new_object(id, id_len, iterator)))
+			{
+				j_goto_error();
+			}
+
+			g_hash_table_insert(table, g_bytes_new(id, id_len), object);
+		}
+	}
+
+	return TRUE;
+
+_error:
+	H5VL_julea_db_error_handler(error);
+
+	return FALSE;
+}
+
+/**
+ * Remembers the space and datatype IDs referenced by a row.
+ **/
+static void
+H5VL_julea_db_file_prefetch_collect(GHashTable* row, GHashTable* spaces, GHashTable* datatypes)
+{
+	GBytes* id;
+
+	if ((id = g_hash_table_lookup(row, "space")) != NULL)
+	{
+		g_hash_table_add(spaces, g_bytes_ref(id));
+	}
+
+	if ((id = g_hash_table_lookup(row, "datatype")) != NULL)
+	{
+		g_hash_table_add(datatypes, g_bytes_ref(id));
+	}
+}
+
+/**
+ * Fetches all rows of the given schema belonging to a file.
+ *
+ * \param file   The file.
+ * \param schema The schema.
+ * \param fields The fields to keep, or NULL for link rows.
+ * \param table  The table the rows are inserted into.
+ **/
+static gboolean
+H5VL_julea_db_file_prefetch_rows(JHDF5Object_t* file, JDBSchema* schema, gchar const* const* fields, GHashTable* table)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JDBIterator) iterator = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+
+	if (!(selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error)))
+	{
+		j_goto_error();
+	}
+
+	if (!j_db_selector_add_field(selector, "file", J_DB_SELECTOR_OPERATOR_EQ, file->backend_id, file->backend_id_len, &error))
+	{
+		j_goto_error();
+	}
+
+	if (!(iterator = j_db_iterator_new(schema, selector, &error)))
+	{
+		j_goto_error();
+	}
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		JDBType type;
+
+		if (fields == NULL)
+		{
+			g_autofree void* parent = NULL;
+			g_autofree guint32* parent_type = NULL;
+			g_autofree gchar* name = NULL;
+			void* child = NULL;
+			guint64 parent_len;
+			guint64 child_len;
+			guint64 length;
+
+			if (!j_db_iterator_get_field(iterator, "parent", &type, &parent, &parent_len, &error)
+			    || !j_db_iterator_get_field(iterator, "parent_type", &type, (gpointer*)&parent_type, &length, &error)
+			    || !j_db_iterator_get_field(iterator, "name", &type, (gpointer*)&name, &length, &error)
+			    || !j_db_iterator_get_field(iterator, "child", &type, &child, &child_len, &error))
+			{
+				j_goto_error();
+			}
+
+			g_hash_table_insert(table, H5VL_julea_db_prefetch_link_key(parent, parent_len, *parent_type, name), g_bytes_new_take(child, child_len));
+		}
+		else
+		{
+			void* id = NULL;
+			guint64 id_len;
+
+			if (!j_db_iterator_get_field(iterator, "_id", &type, &id, &id_len, &error))
+			{
+				j_goto_error();
+			}
+
+			g_hash_table_insert(table, g_bytes_new_take(id, id_len), H5VL_julea_db_row_new(iterator, fields));
+		}
+	}
+
+	return TRUE;
+
+_error:
+	H5VL_julea_db_error_handler(error);
+
+	return FALSE;
+}
+
+/**
+ * Prefetches the metadata of a file's objects.
+ * Links, dataset and attribute rows as well as the referenced spaces and datatypes are fetched using a few bulk queries,
+ * so that subsequent opens do not have to query the DB backend object by object.
+ * Chunk indices are still loaded when a dataset is opened.
+ *
+ * \param file The file.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+H5VL_julea_db_file_prefetch(JHDF5Object_t* file)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GHashTable) spaces = NULL;
+	g_autoptr(GHashTable) datatypes = NULL;
+	JHDF5Prefetch* prefetch;
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+
+	g_return_val_if_fail(file != NULL, FALSE);
+	g_return_val_if_fail(file->type == J_HDF5_OBJECT_TYPE_FILE, FALSE);
+
+	prefetch = H5VL_julea_db_prefetch_new();
+	spaces = g_hash_table_new_full(g_bytes_hash, g_bytes_equal, (GDestroyNotify)g_bytes_unref, NULL);
+	datatypes = g_hash_table_new_full(g_bytes_hash, g_bytes_equal, (GDestroyNotify)g_bytes_unref, NULL);
+
+	if (!H5VL_julea_db_file_prefetch_rows(file, julea_db_schema_link, NULL, prefetch->links)
+	    || !H5VL_julea_db_file_prefetch_rows(file, julea_db_schema_dataset, julea_db_dataset_fields, prefetch->datasets)
+	    || !H5VL_julea_db_file_prefetch_rows(file, julea_db_schema_attr, julea_db_attr_fields, prefetch->attrs))
+	{
+		j_goto_error();
+	}
+
+	g_hash_table_iter_init(&iter, prefetch->datasets);
+
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		H5VL_julea_db_file_prefetch_collect(value, spaces, datatypes);
+	}
+
+	g_hash_table_iter_init(&iter, prefetch->attrs);
+
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		H5VL_julea_db_file_prefetch_collect(value, spaces, datatypes);
+	}
+
+	if (!H5VL_julea_db_file_prefetch_headers(julea_db_schema_space_header, spaces, prefetch->spaces, H5VL_julea_db_space_new_from_iterator))
+	{
+		j_goto_error();
+	}
+
+	if (!H5VL_julea_db_file_prefetch_headers(julea_db_schema_datatype_header, datatypes, prefetch->datatypes, H5VL_julea_db_datatype_new_from_iterator))
+	{
+		j_goto_error();
+	}
+
+	file->file.prefetch = prefetch;
+
+	return TRUE;
+
+_error:
+	H5VL_julea_db_prefetch_free(prefetch);
+
+	return FALSE;
+}
+
 static void*
 H5VL_julea_db_file_open(const char* name, unsigned flags, hid_t fapl_id, hid_t dxpl_id, void** req)
 {
@@ -303,8 +555,6 @@ H5VL_julea_db_file_open(const char* name, unsigned flags, hid_t fapl_id, hid_t d
 	JHDF5Object_t* object = NULL;
 	JDBType type;
 
-	(void)flags;
-	(void)fapl_id;
 	(void)dxpl_id;
 	(void)req;
 
@@ -352,6 +602,14 @@ H5VL_julea_db_file_open(const char* name, unsigned flags, hid_t fapl_id, hid_t d
 
 	g_assert(!j_db_iterator_next(iterator, NULL));
 
+	if (!(flags & H5F_ACC_RDWR) && H5VL_julea_db_prefetch_enabled())
+	{
+		// Prefetching is only an optimization, fall back to querying objects individually if it fails.
+		H5VL_julea_db_file_prefetch(object);
+	}
+
+	H5VL_julea_db_collective_file_init(object, fapl_id);
+
         j_hdf5_log(object->file.name, "a", 'O', NULL, object, NULL);
 	return object;
 
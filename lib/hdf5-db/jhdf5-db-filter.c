@@ -0,0 +1,473 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2019 Benjamin Warnke
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <hdf5.h>
+#include <H5PLextern.h>
+
+#include <string.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <julea.h>
+
+#include "jhdf5-db.h"
+
+/**
+ * The registered HDF5 filter identifiers of the LZ4 and zstd plugins.
+ **/
+#define J_HDF5_DB_FILTER_LZ4 32004
+#define J_HDF5_DB_FILTER_ZSTD 32015
+
+/**
+ * The compressed stages of a pipeline are prefixed with the length of their input.
+ **/
+#define J_HDF5_DB_FILTER_HEADER_SIZE sizeof(guint64)
+
+/**
+ * Checks whether a filter can be applied by the client.
+ **/
+static gboolean
+H5VL_julea_db_filter_supported(guint32 id)
+{
+	switch (id)
+	{
+		case H5Z_FILTER_SHUFFLE:
+#ifdef HAVE_ZLIB
+		case H5Z_FILTER_DEFLATE:
+#endif
+#ifdef HAVE_LZ4
+		case J_HDF5_DB_FILTER_LZ4:
+#endif
+#ifdef HAVE_ZSTD
+		case J_HDF5_DB_FILTER_ZSTD:
+#endif
+			return TRUE;
+		default:
+			return FALSE;
+	}
+}
+
+/**
+ * Extracts the filter pipeline of a dataset creation property list.
+ * Optional filters that are not supported are skipped.
+ *
+ * \param dcpl_id     A dataset creation property list.
+ * \param unsupported Returns whether the property list contains an unsupported mandatory filter.
+ *
+ * \return The pipeline, NULL if the property list does not contain any supported filters or contains an unsupported mandatory filter.
+ *         Should be freed with g_array_unref().
+ **/
+static GArray*
+H5VL_julea_db_filter_get_pipeline(hid_t dcpl_id, gboolean* unsupported)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GArray* pipeline;
+	gint nfilters;
+
+	*unsupported = FALSE;
+
+	if ((nfilters = H5Pget_nfilters(dcpl_id)) <= 0)
+	{
+		return NULL;
+	}
+
+	pipeline = g_array_new(FALSE, FALSE, sizeof(JHDF5Filter));
+
+	for (gint i = 0; i < nfilters; i++)
+	{
+		JHDF5Filter filter;
+		H5Z_filter_t id;
+		guint flags;
+		guint values[1] = { 0 };
+		gsize nvalues = G_N_ELEMENTS(values);
+
+		if ((id = H5Pget_filter2(dcpl_id, i, &flags, &nvalues, values, 0, NULL, NULL)) < 0)
+		{
+			*unsupported = TRUE;
+			break;
+		}
+
+		if (!H5VL_julea_db_filter_supported(id))
+		{
+			if (flags & H5Z_FLAG_OPTIONAL)
+			{
+				continue;
+			}
+
+			g_debug("Mandatory filter %d is not supported.", id);
+			*unsupported = TRUE;
+			break;
+		}
+
+		filter.id = id;
+		filter.level = (nvalues > 0) ? values[0] : 0;
+		g_array_append_val(pipeline, filter);
+	}
+
+	if (*unsupported || pipeline->len == 0)
+	{
+		g_array_unref(pipeline);
+		pipeline = NULL;
+	}
+
+	return pipeline;
+}
+
+/**
+ * Serializes a pipeline for the dataset schema.
+ * Datasets without filters store a single H5Z_FILTER_NONE entry.
+ **/
+static JHDF5Filter*
+H5VL_julea_db_filter_serialize(GArray const* pipeline, guint64* length)
+{
+	JHDF5Filter* data;
+
+	if (pipeline == NULL)
+	{
+		data = g_new0(JHDF5Filter, 1);
+		data->id = H5Z_FILTER_NONE;
+		*length = sizeof(JHDF5Filter);
+	}
+	else
+	{
+		*length = pipeline->len * sizeof(JHDF5Filter);
+		data = g_malloc(*length);
+		memcpy(data, pipeline->data, *length);
+	}
+
+	return data;
+}
+
+/**
+ * Deserializes a pipeline stored by H5VL_julea_db_filter_serialize().
+ *
+ * \return The pipeline, NULL if there are no filters.
+ **/
+static GArray*
+H5VL_julea_db_filter_deserialize(JHDF5Filter const* data, guint64 length)
+{
+	GArray* pipeline = NULL;
+
+	for (guint64 i = 0; i < length / sizeof(JHDF5Filter); i++)
+	{
+		if (data[i].id == H5Z_FILTER_NONE)
+		{
+			continue;
+		}
+
+		if (pipeline == NULL)
+		{
+			pipeline = g_array_new(FALSE, FALSE, sizeof(JHDF5Filter));
+		}
+
+		g_array_append_val(pipeline, data[i]);
+	}
+
+	return pipeline;
+}
+
+static void
+H5VL_julea_db_filter_shuffle(gchar const* data, gchar* target, gsize length, guint element_size, gboolean reverse)
+{
+	gsize count = length / element_size;
+
+	for (gsize i = 0; i < count; i++)
+	{
+		for (guint j = 0; j < element_size; j++)
+		{
+			if (reverse)
+			{
+				target[i * element_size + j] = data[j * count + i];
+			}
+			else
+			{
+				target[j * count + i] = data[i * element_size + j];
+			}
+		}
+	}
+
+	// Trailing bytes that do not form a complete element are copied as they are
+	memcpy(target + count * element_size, data + count * element_size, length - count * element_size);
+}
+
+/**
+ * Compresses a buffer using a single filter.
+ *
+ * \return The length of the compressed data, 0 if an error occurred.
+ **/
+static gsize
+H5VL_julea_db_filter_compress(JHDF5Filter const* filter, gchar const* data, gsize length, gchar** target)
+{
+	gsize ret = 0;
+
+	(void)data;
+
+	switch (filter->id)
+	{
+#ifdef HAVE_ZLIB
+		case H5Z_FILTER_DEFLATE:
+		{
+			uLong bound;
+			uLongf target_length;
+
+			bound = compressBound(length);
+			*target = g_malloc(J_HDF5_DB_FILTER_HEADER_SIZE + bound);
+			target_length = bound;
+
+			if (compress2((Bytef*)*target + J_HDF5_DB_FILTER_HEADER_SIZE, &target_length, (Bytef const*)data, length, (filter->level > 0) ? (gint)filter->level : Z_DEFAULT_COMPRESSION) == Z_OK)
+			{
+				ret = target_length;
+			}
+		}
+		break;
+#endif
+#ifdef HAVE_LZ4
+		case J_HDF5_DB_FILTER_LZ4:
+			if (length <= LZ4_MAX_INPUT_SIZE)
+			{
+				gint bound;
+				gint lz4_ret;
+
+				bound = LZ4_compressBound(length);
+				*target = g_malloc(J_HDF5_DB_FILTER_HEADER_SIZE + bound);
+				lz4_ret = LZ4_compress_default(data, *target + J_HDF5_DB_FILTER_HEADER_SIZE, length, bound);
+
+				if (lz4_ret > 0)
+				{
+					ret = lz4_ret;
+				}
+			}
+			break;
+#endif
+#ifdef HAVE_ZSTD
+		case J_HDF5_DB_FILTER_ZSTD:
+		{
+			gsize bound;
+			gsize zstd_ret;
+
+			bound = ZSTD_compressBound(length);
+			*target = g_malloc(J_HDF5_DB_FILTER_HEADER_SIZE + bound);
+			zstd_ret = ZSTD_compress(*target + J_HDF5_DB_FILTER_HEADER_SIZE, bound, data, length, (filter->level > 0) ? (gint)filter->level : ZSTD_CLEVEL_DEFAULT);
+
+			if (!ZSTD_isError(zstd_ret))
+			{
+				ret = zstd_ret;
+			}
+		}
+		break;
+#endif
+		default:
+			break;
+	}
+
+	if (ret == 0)
+	{
+		g_free(*target);
+		*target = NULL;
+
+		return 0;
+	}
+
+	*((guint64*)*target) = GUINT64_TO_LE(length);
+
+	return J_HDF5_DB_FILTER_HEADER_SIZE + ret;
+}
+
+/**
+ * Decompresses a buffer using a single filter.
+ *
+ * \return The length of the decompressed data, 0 if an error occurred.
+ **/
+static gsize
+H5VL_julea_db_filter_decompress(JHDF5Filter const* filter, gchar const* data, gsize length, gchar** target)
+{
+	gboolean ret = FALSE;
+	guint64 header;
+	gsize target_length;
+
+	if (length < J_HDF5_DB_FILTER_HEADER_SIZE)
+	{
+		return 0;
+	}
+
+	memcpy(&header, data, sizeof(header));
+	target_length = GUINT64_FROM_LE(header);
+
+	data += J_HDF5_DB_FILTER_HEADER_SIZE;
+	length -= J_HDF5_DB_FILTER_HEADER_SIZE;
+
+	*target = g_malloc(target_length);
+
+	switch (filter->id)
+	{
+#ifdef HAVE_ZLIB
+		case H5Z_FILTER_DEFLATE:
+		{
+			uLongf zlib_length = target_length;
+
+			ret = (uncompress((Bytef*)*target, &zlib_length, (Bytef const*)data, length) == Z_OK && zlib_length == target_length);
+		}
+		break;
+#endif
+#ifdef HAVE_LZ4
+		case J_HDF5_DB_FILTER_LZ4:
+			ret = (LZ4_decompress_safe(data, *target, length, target_length) == (gint)target_length);
+			break;
+#endif
+#ifdef HAVE_ZSTD
+		case J_HDF5_DB_FILTER_ZSTD:
+			ret = (ZSTD_decompress(*target, target_length, data, length) == target_length);
+			break;
+#endif
+		default:
+			break;
+	}
+
+	if (!ret)
+	{
+		g_free(*target);
+		*target = NULL;
+
+		return 0;
+	}
+
+	return target_length;
+}
+
+/**
+ * Applies a filter pipeline to a chunk.
+ *
+ * \param pipeline          The pipeline.
+ * \param element_size      The size of the chunk's elements.
+ * \param data              The chunk.
+ * \param length            The chunk's length.
+ * \param compressed_length Returns the length of the filtered chunk.
+ *
+ * \return The filtered chunk, NULL if an error occurred. Should be freed with g_free().
+ **/
+static gchar*
+H5VL_julea_db_filter_apply(GArray const* pipeline, guint element_size, gchar const* data, gsize length, gsize* compressed_length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gchar* current;
+
+	current = g_malloc(length);
+	memcpy(current, data, length);
+
+	for (guint i = 0; i < pipeline->len; i++)
+	{
+		JHDF5Filter const* filter = &g_array_index(pipeline, JHDF5Filter, i);
+		gchar* next = NULL;
+
+		if (filter->id == H5Z_FILTER_SHUFFLE)
+		{
+			next = g_malloc(length);
+			H5VL_julea_db_filter_shuffle(current, next, length, element_size, FALSE);
+		}
+		else if ((length = H5VL_julea_db_filter_compress(filter, current, length, &next)) == 0)
+		{
+			g_free(current);
+
+			return NULL;
+		}
+
+		g_free(current);
+		current = next;
+	}
+
+	*compressed_length = length;
+
+	return current;
+}
+
+/**
+ * Reverts a filter pipeline applied by H5VL_julea_db_filter_apply().
+ *
+ * \param pipeline          The pipeline.
+ * \param element_size      The size of the chunk's elements.
+ * \param compressed        The filtered chunk.
+ * \param compressed_length The filtered chunk's length.
+ * \param data              A buffer for the chunk.
+ * \param length            The chunk's length.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+H5VL_julea_db_filter_revert(GArray const* pipeline, guint element_size, gchar const* compressed, gsize compressed_length, gchar* data, gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gchar* current;
+	gsize current_length = compressed_length;
+
+	current = g_malloc(compressed_length);
+	memcpy(current, compressed, compressed_length);
+
+	for (guint i = pipeline->len; i > 0; i--)
+	{
+		JHDF5Filter const* filter = &g_array_index(pipeline, JHDF5Filter, i - 1);
+		gchar* next = NULL;
+
+		if (filter->id == H5Z_FILTER_SHUFFLE)
+		{
+			next = g_malloc(current_length);
+			H5VL_julea_db_filter_shuffle(current, next, current_length, element_size, TRUE);
+		}
+		else if ((current_length = H5VL_julea_db_filter_decompress(filter, current, current_length, &next)) == 0)
+		{
+			g_free(current);
+
+			return FALSE;
+		}
+
+		g_free(current);
+		current = next;
+	}
+
+	if (current_length != length)
+	{
+		g_free(current);
+
+		return FALSE;
+	}
+
+	memcpy(data, current, length);
+	g_free(current);
+
+	return TRUE;
+}
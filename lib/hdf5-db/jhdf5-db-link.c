@@ -268,6 +268,7 @@ H5VL_julea_db_link_get_helper(JHDF5Object_t* parent, JHDF5Object_t* child, const
 	g_autoptr(JDBIterator) iterator = NULL;
 	g_autoptr(JDBSelector) selector = NULL;
 	JHDF5Object_t* file;
+	GBytes* prefetched;
 	JDBType type;
 
 	g_return_val_if_fail(name != NULL, FALSE);
@@ -316,6 +317,19 @@ H5VL_julea_db_link_get_helper(JHDF5Object_t* parent, JHDF5Object_t* child, const
 			j_goto_error();
 	}
 
+	if ((prefetched = H5VL_julea_db_prefetch_get_link(file, parent, name)) != NULL)
+	{
+		gconstpointer id;
+		gsize id_len;
+
+		id = g_bytes_get_data(prefetched, &id_len);
+		child->backend_id = g_malloc(id_len);
+		memcpy(child->backend_id, id, id_len);
+		child->backend_id_len = id_len;
+
+		return TRUE;
+	}
+
 	if (!(selector = j_db_selector_new(julea_db_schema_link, J_DB_SELECTOR_MODE_AND, &error)))
 	{
 		j_goto_error();
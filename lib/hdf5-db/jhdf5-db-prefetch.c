@@ -0,0 +1,256 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2019 Benjamin Warnke
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <hdf5.h>
+#include <H5PLextern.h>
+
+#include <string.h>
+
+#include <julea.h>
+#include <julea-db.h>
+
+#include "jhdf5-db.h"
+
+/**
+ * The maximum number of IDs combined into one selector when prefetching spaces and datatypes.
+ **/
+#define J_HDF5_DB_PREFETCH_IDS_MAX 64
+
+/**
+ * A DB row maps field names to #GBytes holding the field values.
+ **/
+
+/**
+ * Copies the given fields of the iterator's current row.
+ * Fields that cannot be read are left out.
+ *
+ * \param iterator An iterator.
+ * \param fields   The NULL-terminated field names.
+ *
+ * \return A new row, to be freed with g_hash_table_unref().
+ **/
+static GHashTable*
+H5VL_julea_db_row_new(JDBIterator* iterator, gchar const* const* fields)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GHashTable* row;
+
+	row = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_bytes_unref);
+
+	for (guint i = 0; fields[i] != NULL; i++)
+	{
+		JDBType type;
+		gpointer value = NULL;
+		guint64 length;
+
+		if (j_db_iterator_get_field(iterator, fields[i], &type, &value, &length, NULL))
+		{
+			g_hash_table_insert(row, g_strdup(fields[i]), g_bytes_new_take(value, length));
+		}
+	}
+
+	return row;
+}
+
+/**
+ * Returns a copy of a row's field, like j_db_iterator_get_field().
+ *
+ * \return TRUE if the field exists, FALSE otherwise.
+ **/
+static gboolean
+H5VL_julea_db_row_get_field(GHashTable* row, gchar const* name, gpointer* value, guint64* length)
+{
+	GBytes* bytes;
+	gconstpointer data;
+	gsize size;
+
+	if ((bytes = g_hash_table_lookup(row, name)) == NULL)
+	{
+		return FALSE;
+	}
+
+	data = g_bytes_get_data(bytes, &size);
+	*value = g_malloc(MAX(size, 1));
+	memcpy(*value, data, size);
+	*length = size;
+
+	return TRUE;
+}
+
+/**
+ * Returns whether file metadata should be prefetched on open.
+ * Prefetching is enabled by setting JULEA_HDF5_DB_PREFETCH to 1.
+ **/
+static gboolean
+H5VL_julea_db_prefetch_enabled(void)
+{
+	return (g_strcmp0(g_getenv("JULEA_HDF5_DB_PREFETCH"), "1") == 0);
+}
+
+static JHDF5Prefetch*
+H5VL_julea_db_prefetch_new(void)
+{
+	JHDF5Prefetch* prefetch;
+
+	prefetch = g_slice_new(JHDF5Prefetch);
+	prefetch->links = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_bytes_unref);
+	prefetch->datasets = g_hash_table_new_full(g_bytes_hash, g_bytes_equal, (GDestroyNotify)g_bytes_unref, (GDestroyNotify)g_hash_table_unref);
+	prefetch->attrs = g_hash_table_new_full(g_bytes_hash, g_bytes_equal, (GDestroyNotify)g_bytes_unref, (GDestroyNotify)g_hash_table_unref);
+	prefetch->spaces = g_hash_table_new_full(g_bytes_hash, g_bytes_equal, (GDestroyNotify)g_bytes_unref, (GDestroyNotify)H5VL_julea_db_object_unref);
+	prefetch->datatypes = g_hash_table_new_full(g_bytes_hash, g_bytes_equal, (GDestroyNotify)g_bytes_unref, (GDestroyNotify)H5VL_julea_db_object_unref);
+
+	return prefetch;
+}
+
+static void
+H5VL_julea_db_prefetch_free(JHDF5Prefetch* prefetch)
+{
+	if (prefetch == NULL)
+	{
+		return;
+	}
+
+	g_hash_table_unref(prefetch->links);
+	g_hash_table_unref(prefetch->datasets);
+	g_hash_table_unref(prefetch->attrs);
+	g_hash_table_unref(prefetch->spaces);
+	g_hash_table_unref(prefetch->datatypes);
+	g_slice_free(JHDF5Prefetch, prefetch);
+}
+
+/**
+ * Returns the key of a link in #JHDF5Prefetch.links.
+ **/
+static gchar*
+H5VL_julea_db_prefetch_link_key(gconstpointer parent_id, guint64 parent_id_len, JHDF5ObjectType parent_type, gchar const* name)
+{
+	g_autofree gchar* hex = NULL;
+
+	hex = H5VL_julea_db_buf_to_hex("", parent_id, parent_id_len);
+
+	return g_strdup_printf("%s:%u:%s", hex, (guint)parent_type, name);
+}
+
+/**
+ * Looks up a prefetched link.
+ *
+ * \return The child's ID, NULL if it has not been prefetched.
+ **/
+static GBytes*
+H5VL_julea_db_prefetch_get_link(JHDF5Object_t* file, JHDF5Object_t* parent, gchar const* name)
+{
+	g_autofree gchar* key = NULL;
+
+	if (file->file.prefetch == NULL)
+	{
+		return NULL;
+	}
+
+	key = H5VL_julea_db_prefetch_link_key(parent->backend_id, parent->backend_id_len, parent->type, name);
+
+	return g_hash_table_lookup(file->file.prefetch->links, key);
+}
+
+static gpointer
+H5VL_julea_db_prefetch_lookup(GHashTable* table, gconstpointer id, guint64 id_len)
+{
+	g_autoptr(GBytes) key = NULL;
+
+	key = g_bytes_new_static(id, id_len);
+
+	return g_hash_table_lookup(table, key);
+}
+
+/**
+ * Looks up a prefetched dataset row.
+ *
+ * \return The row, NULL if it has not been prefetched.
+ **/
+static GHashTable*
+H5VL_julea_db_prefetch_get_dataset(JHDF5Object_t* file, gconstpointer id, guint64 id_len)
+{
+	if (file->file.prefetch == NULL)
+	{
+		return NULL;
+	}
+
+	return H5VL_julea_db_prefetch_lookup(file->file.prefetch->datasets, id, id_len);
+}
+
+/**
+ * Looks up a prefetched attribute row.
+ *
+ * \return The row, NULL if it has not been prefetched.
+ **/
+static GHashTable*
+H5VL_julea_db_prefetch_get_attr(JHDF5Object_t* file, gconstpointer id, guint64 id_len)
+{
+	if (file->file.prefetch == NULL)
+	{
+		return NULL;
+	}
+
+	return H5VL_julea_db_prefetch_lookup(file->file.prefetch->attrs, id, id_len);
+}
+
+/**
+ * Returns a space, using the prefetched one if available.
+ **/
+static JHDF5Object_t*
+H5VL_julea_db_prefetch_get_space(JHDF5Object_t* file, void* id, guint64 id_len)
+{
+	JHDF5Object_t* space;
+
+	if (file->file.prefetch != NULL)
+	{
+		if ((space = H5VL_julea_db_prefetch_lookup(file->file.prefetch->spaces, id, id_len)) != NULL)
+		{
+			return H5VL_julea_db_object_ref(space);
+		}
+	}
+
+	return H5VL_julea_db_space_decode(id, id_len);
+}
+
+/**
+ * Returns a datatype, using the prefetched one if available.
+ **/
+static JHDF5Object_t*
+H5VL_julea_db_prefetch_get_datatype(JHDF5Object_t* file, void* id, guint64 id_len)
+{
+	JHDF5Object_t* datatype;
+
+	if (file->file.prefetch != NULL)
+	{
+		if ((datatype = H5VL_julea_db_prefetch_lookup(file->file.prefetch->datatypes, id, id_len)) != NULL)
+		{
+			return H5VL_julea_db_object_ref(datatype);
+		}
+	}
+
+	return H5VL_julea_db_datatype_decode(id, id_len);
+}
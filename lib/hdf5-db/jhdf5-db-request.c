@@ -0,0 +1,239 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2019 Benjamin Warnke
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <hdf5.h>
+#include <H5PLextern.h>
+
+#include <julea.h>
+
+#include "jhdf5-db.h"
+
+#if H5_VERSION_GE(1, 12, 1)
+typedef H5VL_request_status_t JHDF5RequestStatus;
+#define J_HDF5_DB_REQUEST_IN_PROGRESS H5VL_REQUEST_STATUS_IN_PROGRESS
+#define J_HDF5_DB_REQUEST_SUCCEED H5VL_REQUEST_STATUS_SUCCEED
+#define J_HDF5_DB_REQUEST_FAIL H5VL_REQUEST_STATUS_FAIL
+#else
+typedef H5ES_status_t JHDF5RequestStatus;
+#define J_HDF5_DB_REQUEST_IN_PROGRESS H5ES_STATUS_IN_PROGRESS
+#define J_HDF5_DB_REQUEST_SUCCEED H5ES_STATUS_SUCCEED
+#define J_HDF5_DB_REQUEST_FAIL H5ES_STATUS_FAIL
+#endif
+
+/**
+ * Creates a request if the operation has been issued asynchronously.
+ *
+ * \param req    The request token passed by HDF5.
+ * \param object The object the operation belongs to, it is kept alive until the request is freed.
+ *
+ * \return A new request, NULL if the operation is synchronous.
+ **/
+static JHDF5Request_t*
+H5VL_julea_db_request_new(void** req, JHDF5Object_t* object)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JHDF5Request_t* request;
+
+	if (req == NULL)
+	{
+		return NULL;
+	}
+
+	request = g_slice_new(JHDF5Request_t);
+	request->batch = NULL;
+	request->object = H5VL_julea_db_object_ref(object);
+	request->completed = 0;
+	request->ret = FALSE;
+	request->bytes = 0;
+	request->error = NULL;
+	request->data = NULL;
+	request->chunks = NULL;
+
+	return request;
+}
+
+static void
+H5VL_julea_db_request_callback(JBatch* batch, gboolean ret, gpointer data)
+{
+	JHDF5Request_t* request = data;
+
+	(void)batch;
+
+	request->ret = ret;
+	g_atomic_int_set(&request->completed, 1);
+}
+
+/**
+ * Applies the request's chunk index updates if its batch has succeeded.
+ * The batch has to be complete.
+ **/
+static void
+H5VL_julea_db_request_complete(JHDF5Request_t* request)
+{
+	if (request->chunks == NULL)
+	{
+		return;
+	}
+
+	if (request->ret && request->error == NULL)
+	{
+		H5VL_julea_db_dataset_chunks_commit(request->object, request->chunks);
+	}
+
+	g_clear_pointer(&request->chunks, g_array_unref);
+}
+
+/**
+ * Returns where the batch's operations should report their errors.
+ **/
+static GError**
+H5VL_julea_db_request_get_error(JHDF5Request_t* request, GError** error)
+{
+	return (request != NULL) ? &request->error : error;
+}
+
+/**
+ * Returns where the batch's operations should store the number of bytes transferred.
+ **/
+static guint64*
+H5VL_julea_db_request_get_bytes(JHDF5Request_t* request, guint64* bytes)
+{
+	return (request != NULL) ? &request->bytes : bytes;
+}
+
+/**
+ * Executes a batch, in the background if a request has been created for it.
+ *
+ * \param request The request, NULL to execute synchronously.
+ * \param batch   A batch.
+ * \param data    A buffer the batch's operations refer to, it is freed with g_free() once the batch has completed.
+ * \param object  The object the chunk index updates belong to.
+ * \param chunks  The #JHDF5ChunkUpdate entries to apply once the batch has succeeded, may be NULL.
+ * \param req     Returns the request token to HDF5.
+ *
+ * \return TRUE on success or if the batch has been started, FALSE otherwise.
+ **/
+static gboolean
+H5VL_julea_db_request_execute(JHDF5Request_t* request, JBatch* batch, gpointer data, JHDF5Object_t* object, GArray* chunks, void** req)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	if (request == NULL)
+	{
+		ret = j_batch_execute(batch);
+		g_free(data);
+
+		if (ret && chunks != NULL)
+		{
+			H5VL_julea_db_dataset_chunks_commit(object, chunks);
+		}
+
+		return ret;
+	}
+
+	g_assert(chunks == NULL || request->object == object);
+
+	request->batch = j_batch_ref(batch);
+	request->data = data;
+	request->chunks = (chunks != NULL) ? g_array_ref(chunks) : NULL;
+	j_batch_execute_async(batch, H5VL_julea_db_request_callback, request);
+	*req = request;
+
+	return TRUE;
+}
+
+/**
+ * Waits for a request, HDF5 passes the timeout in nanoseconds.
+ **/
+static herr_t
+H5VL_julea_db_request_wait(void* req, uint64_t timeout, JHDF5RequestStatus* status)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JHDF5Request_t* request = req;
+
+	if (timeout == G_MAXUINT64)
+	{
+		j_batch_wait(request->batch);
+	}
+	else
+	{
+		gint64 deadline = g_get_monotonic_time() + (gint64)MIN(timeout / 1000, (uint64_t)G_MAXINT32);
+
+		while (!g_atomic_int_get(&request->completed) && g_get_monotonic_time() < deadline)
+		{
+			g_usleep(10);
+		}
+	}
+
+	if (!g_atomic_int_get(&request->completed))
+	{
+		*status = J_HDF5_DB_REQUEST_IN_PROGRESS;
+
+		return 0;
+	}
+
+	j_batch_wait(request->batch);
+	H5VL_julea_db_request_complete(request);
+	*status = (request->ret && request->error == NULL) ? J_HDF5_DB_REQUEST_SUCCEED : J_HDF5_DB_REQUEST_FAIL;
+
+	return 0;
+}
+
+static herr_t
+H5VL_julea_db_request_free(void* req)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JHDF5Request_t* request = req;
+
+	if (request->batch != NULL)
+	{
+		j_batch_wait(request->batch);
+		H5VL_julea_db_request_complete(request);
+		j_batch_unref(request->batch);
+	}
+
+	if (request->chunks != NULL)
+	{
+		g_array_unref(request->chunks);
+	}
+
+	if (request->error != NULL)
+	{
+		H5VL_julea_db_error_handler(request->error);
+		g_error_free(request->error);
+	}
+
+	g_free(request->data);
+	H5VL_julea_db_object_unref(request->object);
+	g_slice_free(JHDF5Request_t, request);
+
+	return 0;
+}
@@ -120,6 +120,8 @@ H5VL_julea_db_object_unref(JHDF5Object_t* object)
 		{
 			case J_HDF5_OBJECT_TYPE_FILE:
 				g_free(object->file.name);
+				H5VL_julea_db_prefetch_free(object->file.prefetch);
+				H5VL_julea_db_collective_file_fini(object);
 				break;
 			case J_HDF5_OBJECT_TYPE_DATASET:
 				H5VL_julea_db_object_unref(object->dataset.file);
@@ -138,6 +140,25 @@ H5VL_julea_db_object_unref(JHDF5Object_t* object)
 					j_distributed_object_unref(object->dataset.object);
 				}
 
+				if (object->dataset.chunks.objects)
+				{
+					g_hash_table_unref(object->dataset.chunks.objects);
+				}
+
+				if (object->dataset.chunks.allocated)
+				{
+					g_hash_table_unref(object->dataset.chunks.allocated);
+				}
+
+				if (object->dataset.chunks.filters)
+				{
+					g_array_unref(object->dataset.chunks.filters);
+				}
+
+				g_free(object->dataset.chunks.dims);
+				g_free(object->dataset.chunks.grid);
+				g_free(object->dataset.chunks.prefix);
+
 				break;
 			case J_HDF5_OBJECT_TYPE_ATTR:
 				H5VL_julea_db_object_unref(object->attr.file);
@@ -213,15 +213,16 @@ _error:
 	return 1;
 }
 
+/**
+ * Creates a space from the current row of a space header iterator.
+ **/
 static JHDF5Object_t*
-H5VL_julea_db_space_decode(void* backend_id, guint64 backend_id_len)
+H5VL_julea_db_space_new_from_iterator(void const* backend_id, guint64 backend_id_len, JDBIterator* iterator)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	g_autofree guint32* tmp_uint32 = NULL;
-	g_autoptr(JDBIterator) iterator = NULL;
 	g_autoptr(GError) error = NULL;
-	g_autoptr(JDBSelector) selector = NULL;
 	JHDF5Object_t* object = NULL;
 	JDBType type;
 	guint64 length;
@@ -239,44 +240,61 @@ H5VL_julea_db_space_decode(void* backend_id, guint64 backend_id_len)
 	memcpy(object->backend_id, backend_id, backend_id_len);
 	object->backend_id_len = backend_id_len;
 
-	if (!(selector = j_db_selector_new(julea_db_schema_space_header, J_DB_SELECTOR_MODE_AND, &error)))
+	if (!j_db_iterator_get_field(iterator, "dim_cache", &type, &object->space.data, &object->space.data_size, &error))
 	{
 		j_goto_error();
 	}
 
-	if (!j_db_selector_add_field(selector, "_id", J_DB_SELECTOR_OPERATOR_EQ, object->backend_id, object->backend_id_len, &error))
+	if (!j_db_iterator_get_field(iterator, "dim_total_count", &type, (gpointer*)&tmp_uint32, &length, &error))
 	{
 		j_goto_error();
 	}
 
-	if (!(iterator = j_db_iterator_new(julea_db_schema_space_header, selector, &error)))
+	object->space.dim_total_count = *tmp_uint32;
+	object->space.hdf5_id = H5Sdecode(object->space.data);
+
+	return object;
+
+_error:
+	H5VL_julea_db_error_handler(error);
+	H5VL_julea_db_object_unref(object);
+
+	return NULL;
+}
+
+static JHDF5Object_t*
+H5VL_julea_db_space_decode(void* backend_id, guint64 backend_id_len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JDBIterator) iterator = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+
+	if (!(selector = j_db_selector_new(julea_db_schema_space_header, J_DB_SELECTOR_MODE_AND, &error)))
 	{
 		j_goto_error();
 	}
 
-	if (!j_db_iterator_next(iterator, NULL))
+	if (!j_db_selector_add_field(selector, "_id", J_DB_SELECTOR_OPERATOR_EQ, backend_id, backend_id_len, &error))
 	{
 		j_goto_error();
 	}
 
-	if (!j_db_iterator_get_field(iterator, "dim_cache", &type, &object->space.data, &object->space.data_size, &error))
+	if (!(iterator = j_db_iterator_new(julea_db_schema_space_header, selector, &error)))
 	{
 		j_goto_error();
 	}
 
-	if (!j_db_iterator_get_field(iterator, "dim_total_count", &type, (gpointer*)&tmp_uint32, &length, &error))
+	if (!j_db_iterator_next(iterator, NULL))
 	{
 		j_goto_error();
 	}
 
-	object->space.dim_total_count = *tmp_uint32;
-	object->space.hdf5_id = H5Sdecode(object->space.data);
-
-	return object;
+	return H5VL_julea_db_space_new_from_iterator(backend_id, backend_id_len, iterator);
 
 _error:
 	H5VL_julea_db_error_handler(error);
-	H5VL_julea_db_object_unref(object);
 
 	return NULL;
 }
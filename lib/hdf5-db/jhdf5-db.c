@@ -64,11 +64,15 @@ static herr_t H5VL_julea_db_link_term(void);
 
 // FIXME order is important
 #include "jhdf5-db-shared.c"
+#include "jhdf5-db-request.c"
+#include "jhdf5-db-prefetch.c"
 #include "jhdf5-db-link.c"
 #include "jhdf5-db-group.c"
 #include "jhdf5-db-datatype.c"
 #include "jhdf5-db-space.c"
 #include "jhdf5-db-attr.c"
+#include "jhdf5-db-filter.c"
+#include "jhdf5-db-collective.c"
 #include "jhdf5-db-dataset.c"
 #include "jhdf5-db-file.c"
 
@@ -309,12 +313,12 @@ static const H5VL_class_t H5VL_julea_db_g = {
 		.opt_query = H5VL_julea_db_introspect_opt_query,
 	},
 	.request_cls = {
-		.wait = NULL,
+		.wait = H5VL_julea_db_request_wait,
 		.notify = NULL,
 		.cancel = NULL,
 		.specific = NULL,
 		.optional = NULL,
-		.free = NULL,
+		.free = H5VL_julea_db_request_free,
 	},
 	.blob_cls = {
 		.put = NULL,
@@ -370,6 +374,254 @@ j_hdf5_set_semantics(JSemantics* semantics)
 	//FIXME implement this
 }
 
+/**
+ * Returns the connector object of an HDF5 identifier if it belongs to this connector.
+ **/
+static JHDF5Object_t*
+H5VL_julea_db_get_object(hid_t id)
+{
+	H5VL_class_value_t value;
+
+	if (H5VLget_value(id, &value) < 0 || value != JULEA_DB)
+	{
+		return NULL;
+	}
+
+	return H5VLobject(id);
+}
+
+gchar**
+j_hdf5_db_find_datasets(hid_t loc_id, gdouble min, gdouble max)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GHashTable) matches = NULL;
+	g_autoptr(GPtrArray) names = NULL;
+	g_autoptr(JDBIterator) iterator = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	g_autoptr(JDBSelector) range_selector = NULL;
+	JHDF5Object_t* object;
+	JHDF5Object_t* file;
+	JHDF5ObjectType child_type = J_HDF5_OBJECT_TYPE_DATASET;
+	gchar const* dataset_fields[] = { "_id", NULL };
+
+	if ((object = H5VL_julea_db_get_object(loc_id)) == NULL)
+	{
+		return NULL;
+	}
+
+	switch (object->type)
+	{
+		case J_HDF5_OBJECT_TYPE_FILE:
+			file = object;
+			break;
+		case J_HDF5_OBJECT_TYPE_GROUP:
+			file = object->group.file;
+			break;
+		case J_HDF5_OBJECT_TYPE_DATASET:
+		case J_HDF5_OBJECT_TYPE_ATTR:
+		case J_HDF5_OBJECT_TYPE_DATATYPE:
+		case J_HDF5_OBJECT_TYPE_SPACE:
+		case _J_HDF5_OBJECT_TYPE_COUNT:
+		default:
+			return NULL;
+	}
+
+	matches = g_hash_table_new_full(g_bytes_hash, g_bytes_equal, (GDestroyNotify)g_bytes_unref, NULL);
+
+	// Find the file's datasets whose statistics overlap the range
+	if (!(selector = j_db_selector_new(julea_db_schema_dataset, J_DB_SELECTOR_MODE_AND, &error)))
+	{
+		j_goto_error();
+	}
+
+	if (!j_db_selector_add_field(selector, "file", J_DB_SELECTOR_OPERATOR_EQ, file->backend_id, file->backend_id_len, &error))
+	{
+		j_goto_error();
+	}
+
+	if (!(range_selector = H5VL_julea_db_statistics_get_selector(julea_db_schema_dataset, min, max, &error)))
+	{
+		j_goto_error();
+	}
+
+	if (!j_db_selector_add_selector(selector, range_selector, &error))
+	{
+		j_goto_error();
+	}
+
+	if (!(iterator = j_db_iterator_new_for_fields(julea_db_schema_dataset, selector, dataset_fields, &error)))
+	{
+		j_goto_error();
+	}
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		JDBType type;
+		gpointer id = NULL;
+		guint64 id_len;
+
+		if (j_db_iterator_get_field(iterator, "_id", &type, &id, &id_len, NULL))
+		{
+			g_hash_table_add(matches, g_bytes_new_take(id, id_len));
+		}
+	}
+
+	g_clear_pointer(&iterator, j_db_iterator_unref);
+	g_clear_pointer(&selector, j_db_selector_unref);
+
+	// Resolve the names of the matching datasets linked from the location
+	if (!(selector = j_db_selector_new(julea_db_schema_link, J_DB_SELECTOR_MODE_AND, &error)))
+	{
+		j_goto_error();
+	}
+
+	if (!j_db_selector_add_field(selector, "parent", J_DB_SELECTOR_OPERATOR_EQ, object->backend_id, object->backend_id_len, &error))
+	{
+		j_goto_error();
+	}
+
+	if (!j_db_selector_add_field(selector, "parent_type", J_DB_SELECTOR_OPERATOR_EQ, &object->type, sizeof(object->type), &error))
+	{
+		j_goto_error();
+	}
+
+	if (!j_db_selector_add_field(selector, "child_type", J_DB_SELECTOR_OPERATOR_EQ, &child_type, sizeof(child_type), &error))
+	{
+		j_goto_error();
+	}
+
+	if (!(iterator = j_db_iterator_new(julea_db_schema_link, selector, &error)))
+	{
+		j_goto_error();
+	}
+
+	names = g_ptr_array_new_with_free_func(g_free);
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		g_autoptr(GBytes) child = NULL;
+		JDBType type;
+		gpointer id = NULL;
+		gpointer name = NULL;
+		guint64 len;
+
+		if (!j_db_iterator_get_field(iterator, "child", &type, &id, &len, NULL))
+		{
+			continue;
+		}
+
+		child = g_bytes_new_take(id, len);
+
+		if (g_hash_table_contains(matches, child) && j_db_iterator_get_field(iterator, "name", &type, &name, &len, NULL))
+		{
+			g_ptr_array_add(names, name);
+		}
+	}
+
+	g_ptr_array_add(names, NULL);
+
+	return (gchar**)g_ptr_array_free(g_steal_pointer(&names), FALSE);
+
+_error:
+	H5VL_julea_db_error_handler(error);
+
+	return NULL;
+}
+
+gint64
+j_hdf5_db_find_chunks(hid_t dataset_id, gdouble min, gdouble max, hsize_t** offsets)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GArray) result = NULL;
+	g_autoptr(JDBIterator) iterator = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	g_autoptr(JDBSelector) range_selector = NULL;
+	JHDF5Object_t* object;
+	gchar const* fields[] = { "chunk_index", NULL };
+	gint64 count = 0;
+
+	g_return_val_if_fail(offsets != NULL, -1);
+
+	*offsets = NULL;
+
+	if ((object = H5VL_julea_db_get_object(dataset_id)) == NULL || object->type != J_HDF5_OBJECT_TYPE_DATASET)
+	{
+		return -1;
+	}
+
+	if (object->dataset.chunks.rank == 0)
+	{
+		return -1;
+	}
+
+	if (!(selector = j_db_selector_new(julea_db_schema_chunk, J_DB_SELECTOR_MODE_AND, &error)))
+	{
+		j_goto_error();
+	}
+
+	if (!j_db_selector_add_field(selector, "dataset", J_DB_SELECTOR_OPERATOR_EQ, object->backend_id, object->backend_id_len, &error))
+	{
+		j_goto_error();
+	}
+
+	if (!(range_selector = H5VL_julea_db_statistics_get_selector(julea_db_schema_chunk, min, max, &error)))
+	{
+		j_goto_error();
+	}
+
+	if (!j_db_selector_add_selector(selector, range_selector, &error))
+	{
+		j_goto_error();
+	}
+
+	if (!(iterator = j_db_iterator_new_for_fields(julea_db_schema_chunk, selector, fields, &error)))
+	{
+		j_goto_error();
+	}
+
+	result = g_array_new(FALSE, FALSE, sizeof(hsize_t));
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		g_autofree guint64* chunk = NULL;
+		JDBType type;
+		guint64 len;
+		guint64 rest;
+		guint offset;
+
+		if (!j_db_iterator_get_field(iterator, "chunk_index", &type, (gpointer*)&chunk, &len, NULL))
+		{
+			continue;
+		}
+
+		// Chunk indices are row-major in the chunk grid
+		offset = result->len;
+		g_array_set_size(result, result->len + object->dataset.chunks.rank);
+		rest = *chunk;
+
+		for (guint i = object->dataset.chunks.rank; i > 0; i--)
+		{
+			g_array_index(result, hsize_t, offset + i - 1) = (rest % object->dataset.chunks.grid[i - 1]) * object->dataset.chunks.dims[i - 1];
+			rest /= object->dataset.chunks.grid[i - 1];
+		}
+
+		count++;
+	}
+
+	*offsets = (hsize_t*)(void*)g_array_free(g_steal_pointer(&result), FALSE);
+
+	return count;
+
+_error:
+	H5VL_julea_db_error_handler(error);
+
+	return -1;
+}
+
 
 #define JULEA_LOGFILE_ENDING "_JULEA_LOG.log"
 char* j_get_logname(const char *filename){
@@ -43,6 +43,71 @@ enum JHDF5ObjectType
 
 typedef enum JHDF5ObjectType JHDF5ObjectType;
 
+/**
+ * A filter of a dataset's filter pipeline.
+ **/
+typedef struct JHDF5Filter JHDF5Filter;
+struct JHDF5Filter
+{
+	guint32 id;
+	guint32 level;
+};
+
+/**
+ * The value statistics of a dataset or chunk.
+ * Integer and floating point values are tracked separately.
+ **/
+typedef struct JHDF5Statistics JHDF5Statistics;
+struct JHDF5Statistics
+{
+	gint64 min_value_i;
+	gdouble min_value_f;
+	gint64 max_value_i;
+	gdouble max_value_f;
+};
+
+/**
+ * The chunk index entry of an allocated chunk.
+ **/
+typedef struct JHDF5ChunkInfo JHDF5ChunkInfo;
+struct JHDF5ChunkInfo
+{
+	guint64 size;
+	JHDF5Statistics statistics;
+};
+
+/**
+ * A chunk index entry that is applied once the batch writing the chunk has succeeded.
+ **/
+typedef struct JHDF5ChunkUpdate JHDF5ChunkUpdate;
+struct JHDF5ChunkUpdate
+{
+	guint64 chunk;
+	JHDF5ChunkInfo info;
+};
+
+/**
+ * The metadata of a file fetched in bulk when it is opened.
+ **/
+typedef struct JHDF5Prefetch JHDF5Prefetch;
+struct JHDF5Prefetch
+{
+	/**
+	 * Maps link keys to the children's IDs.
+	 **/
+	GHashTable* links;
+	/**
+	 * Map dataset and attribute IDs to their rows.
+	 **/
+	GHashTable* datasets;
+	GHashTable* attrs;
+	/**
+	 * Map space and datatype IDs to decoded objects.
+	 **/
+	GHashTable* spaces;
+	GHashTable* datatypes;
+};
+
 typedef struct JHDF5Object_t JHDF5Object_t;
 struct JHDF5Object_t
 {
@@ -55,6 +120,16 @@ struct JHDF5Object_t
 		struct
 		{
 			char* name;
+			/**
+			 * The prefetched metadata, NULL if prefetching is disabled.
+			 **/
+			JHDF5Prefetch* prefetch;
+#ifdef H5_HAVE_PARALLEL
+			/**
+			 * The communicator for collective writes, NULL if the file has not been opened using the MPI-IO file driver.
+			 **/
+			MPI_Comm* comm;
+#endif
 		} file;
 		struct
 		{
@@ -64,13 +139,26 @@ struct JHDF5Object_t
 			JHDF5Object_t* space;
 			JDistribution* distribution;
 			JDistributedObject* object;
+			/**
+			 * The chunked layout, rank is 0 for contiguous datasets.
+			 **/
 			struct
 			{
-				gint64 min_value_i;
-				gdouble min_value_f;
-				gint64 max_value_i;
-				gdouble max_value_f;
-			} statistics;
+				guint rank;
+				guint64* dims;
+				guint64* grid;
+				char* prefix;
+				GHashTable* objects;
+				/**
+				 * Maps the indices of allocated chunks to #JHDF5ChunkInfo.
+				 **/
+				GHashTable* allocated;
+				/**
+				 * The filter pipeline, NULL if chunks are stored unfiltered.
+				 **/
+				GArray* filters;
+			} chunks;
+			JHDF5Statistics statistics;
 		} dataset;
 		struct
 		{
@@ -101,6 +189,37 @@ struct JHDF5Object_t
 	};
 };
 
+/**
+ * An asynchronous request, handed to HDF5 as the request token of an operation.
+ **/
+typedef struct JHDF5Request_t JHDF5Request_t;
+struct JHDF5Request_t
+{
+	JBatch* batch;
+	JHDF5Object_t* object;
+	/**
+	 * Set by the batch's completion callback.
+	 **/
+	gint completed;
+	gboolean ret;
+	/**
+	 * Receives the number of bytes transferred, it has to outlive the batch.
+	 **/
+	guint64 bytes;
+	/**
+	 * Receives the errors of DB operations, it has to outlive the batch.
+	 **/
+	GError* error;
+	/**
+	 * A buffer the batch's operations refer to.
+	 **/
+	gpointer data;
+	/**
+	 * The #JHDF5ChunkUpdate entries applied once the batch has succeeded.
+	 **/
+	GArray* chunks;
+};
+
 /*internal helper functions*/
 
 static void
@@ -115,6 +234,17 @@ H5VL_julea_db_object_ref(JHDF5Object_t* object);
 static void
 H5VL_julea_db_object_unref(JHDF5Object_t* object);
 
+static void
+H5VL_julea_db_prefetch_free(JHDF5Prefetch* prefetch);
+static void
+H5VL_julea_db_collective_file_fini(JHDF5Object_t* file);
+static JHDF5Object_t*
+H5VL_julea_db_space_decode(void* backend_id, guint64 backend_id_len);
+static JHDF5Object_t*
+H5VL_julea_db_datatype_decode(void* backend_id, guint64 backend_id_len);
+static void
+H5VL_julea_db_dataset_chunks_commit(JHDF5Object_t* object, GArray* chunks);
+
 #define j_goto_error() \
 	do \
 	{ \
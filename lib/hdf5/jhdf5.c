@@ -64,6 +64,12 @@ struct JHF_t
 {
 	char* name;
 	JKV* kv;
+	/**
+	 * Accumulates the metadata updates of the file and its objects, see j_hdf5_file_commit().
+	 **/
+	JBatch* metadata;
+	guint metadata_count;
+	gint ref_count;
 };
 
 typedef struct JHF_t JHF_t;
@@ -73,6 +79,7 @@ struct JHG_t
 {
 	char* location;
 	char* name;
+	JHF_t* file;
 	JKV* kv;
 };
 
@@ -84,6 +91,11 @@ struct JHD_t
 	char* location;
 	char* name;
 	size_t data_size;
+	/**
+	 * The dataset's dataspace, used for selections covering the whole dataset.
+	 **/
+	hid_t space_id;
+	JHF_t* file;
 	JDistribution* distribution;
 	JDistributedObject* object;
 	JKV* kv;
@@ -91,20 +103,273 @@ struct JHD_t
 
 typedef struct JHD_t JHD_t;
 
+/**
+ * A contiguous part of a selection, mapping a memory offset to a file offset.
+ **/
+struct JHDExtent_t
+{
+	hsize_t mem_offset;
+	hsize_t file_offset;
+	size_t length;
+};
+
+typedef struct JHDExtent_t JHDExtent_t;
+
+/**
+ * The maximum number of sequences fetched from a selection iterator at once.
+ **/
+#define J_HDF5_SEQUENCES_MAX 1024
+
 /* structure for attribute */
 struct JHA_t
 {
 	char* location;
 	char* name;
+	JHF_t* file;
 	size_t data_size;
 	JKV* kv;
-	JKV* ts;
+	/**
+	 * The attribute's type, space and data, see j_hdf5_serialize_attribute().
+	 * All of them are stored in one key-value pair, which is fetched once when opening the attribute.
+	 **/
+	bson_t* metadata;
 };
 
 typedef struct JHA_t JHA_t;
 
 static JSemantics* j_hdf5_semantics;
 
+/**
+ * The number of metadata updates after which a file's metadata batch is flushed.
+ **/
+#define J_HDF5_METADATA_BATCH_MAX 1024
+
+static JHF_t*
+j_hdf5_file_new(const char* name)
+{
+	JHF_t* file;
+
+	file = g_new(JHF_t, 1);
+	file->name = g_strdup(name);
+	file->kv = j_kv_new("hdf5", name);
+	file->metadata = j_batch_new(j_hdf5_semantics);
+	file->metadata_count = 0;
+	file->ref_count = 1;
+
+	return file;
+}
+
+/**
+ * Executes the metadata updates accumulated for a file.
+ *
+ * \return TRUE on success or if there was nothing to flush, FALSE otherwise.
+ **/
+static gboolean
+j_hdf5_file_flush(JHF_t* file)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (file->metadata_count == 0)
+	{
+		return TRUE;
+	}
+
+	file->metadata_count = 0;
+
+	return j_batch_execute(file->metadata);
+}
+
+/**
+ * Accounts for a metadata update queued in the file's metadata batch.
+ * With J_SEMANTICS_CONSISTENCY_IMMEDIATE, the update is executed right away.
+ * Otherwise, updates are accumulated until the file is flushed or closed or J_HDF5_METADATA_BATCH_MAX updates are pending.
+ **/
+static void
+j_hdf5_file_commit(JHF_t* file)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	file->metadata_count++;
+
+	if (j_semantics_get(j_batch_get_semantics(file->metadata), J_SEMANTICS_CONSISTENCY) == J_SEMANTICS_CONSISTENCY_IMMEDIATE
+	    || file->metadata_count >= J_HDF5_METADATA_BATCH_MAX)
+	{
+		if (!j_hdf5_file_flush(file))
+		{
+			// FIXME check return value properly
+		}
+	}
+}
+
+static JHF_t*
+j_hdf5_file_ref(JHF_t* file)
+{
+	g_atomic_int_inc(&file->ref_count);
+
+	return file;
+}
+
+/**
+ * Releases a reference to a file.
+ * Objects keep their file alive, so pending metadata updates can be flushed even if the file is closed first.
+ **/
+static void
+j_hdf5_file_unref(JHF_t* file)
+{
+	if (g_atomic_int_dec_and_test(&file->ref_count))
+	{
+		if (!j_hdf5_file_flush(file))
+		{
+			// FIXME check return value properly
+		}
+
+		j_batch_unref(file->metadata);
+		j_kv_unref(file->kv);
+		g_free(file->name);
+		g_free(file);
+	}
+}
+
+/**
+ * An asynchronous request, handed to HDF5 as the request token of an operation.
+ **/
+struct JHR_t
+{
+	JBatch* batch;
+	/**
+	 * Set by the batch's completion callback.
+	 **/
+	gint completed;
+	gboolean ret;
+	/**
+	 * Receives the number of bytes transferred, it has to outlive the batch.
+	 **/
+	guint64 bytes;
+};
+
+typedef struct JHR_t JHR_t;
+
+#if H5_VERSION_GE(1, 12, 1)
+typedef H5VL_request_status_t JHRStatus_t;
+#define J_HDF5_REQUEST_IN_PROGRESS H5VL_REQUEST_STATUS_IN_PROGRESS
+#define J_HDF5_REQUEST_SUCCEED H5VL_REQUEST_STATUS_SUCCEED
+#define J_HDF5_REQUEST_FAIL H5VL_REQUEST_STATUS_FAIL
+#else
+typedef H5ES_status_t JHRStatus_t;
+#define J_HDF5_REQUEST_IN_PROGRESS H5ES_STATUS_IN_PROGRESS
+#define J_HDF5_REQUEST_SUCCEED H5ES_STATUS_SUCCEED
+#define J_HDF5_REQUEST_FAIL H5ES_STATUS_FAIL
+#endif
+
+/**
+ * Creates a request if the operation has been issued asynchronously.
+ *
+ * \param req The request token passed by HDF5.
+ *
+ * \return A new request, NULL if the operation is synchronous.
+ **/
+static JHR_t*
+j_hdf5_request_new(void** req)
+{
+	JHR_t* request;
+
+	if (req == NULL)
+	{
+		return NULL;
+	}
+
+	request = g_slice_new(JHR_t);
+	request->batch = NULL;
+	request->completed = 0;
+	request->ret = FALSE;
+	request->bytes = 0;
+
+	return request;
+}
+
+static void
+j_hdf5_request_callback(JBatch* batch, gboolean ret, gpointer data)
+{
+	JHR_t* request = data;
+
+	(void)batch;
+
+	request->ret = ret;
+	g_atomic_int_set(&request->completed, 1);
+}
+
+/**
+ * Executes a batch, in the background if a request has been created for it.
+ * The request is handed to HDF5 via req and completed by the batch's callback.
+ *
+ * \return TRUE on success or if the batch has been started, FALSE otherwise.
+ **/
+static gboolean
+j_hdf5_request_execute(JHR_t* request, JBatch* batch, void** req)
+{
+	if (request == NULL)
+	{
+		return j_batch_execute(batch);
+	}
+
+	request->batch = j_batch_ref(batch);
+	j_batch_execute_async(batch, j_hdf5_request_callback, request);
+	*req = request;
+
+	return TRUE;
+}
+
+/**
+ * Waits for a request, HDF5 passes the timeout in nanoseconds.
+ **/
+static herr_t
+H5VL_julea_request_wait(void* req, uint64_t timeout, JHRStatus_t* status)
+{
+	JHR_t* request = req;
+
+	if (timeout == G_MAXUINT64)
+	{
+		j_batch_wait(request->batch);
+	}
+	else
+	{
+		gint64 deadline = g_get_monotonic_time() + (gint64)MIN(timeout / 1000, (uint64_t)G_MAXINT32);
+
+		while (!g_atomic_int_get(&request->completed) && g_get_monotonic_time() < deadline)
+		{
+			g_usleep(10);
+		}
+	}
+
+	if (!g_atomic_int_get(&request->completed))
+	{
+		*status = J_HDF5_REQUEST_IN_PROGRESS;
+
+		return 0;
+	}
+
+	j_batch_wait(request->batch);
+	*status = (request->ret) ? J_HDF5_REQUEST_SUCCEED : J_HDF5_REQUEST_FAIL;
+
+	return 0;
+}
+
+static herr_t
+H5VL_julea_request_free(void* req)
+{
+	JHR_t* request = req;
+
+	if (request->batch != NULL)
+	{
+		j_batch_wait(request->batch);
+		j_batch_unref(request->batch);
+	}
+
+	g_slice_free(JHR_t, request);
+
+	return 0;
+}
+
 /**
  * Initializes the plugin
  *
@@ -170,13 +435,14 @@ j_hdf5_encode_space(const char* property, hid_t* space_id, hid_t cpl_id, size_t*
 /**
  * Serializes attribute data
  *
+ * \param metadata The attribute's current metadata, may be NULL
  * \param data The data
  * \param size The size of the data
  *
- * \return b The serialized BSON
+ * \return b The serialized BSON, containing the metadata's type and space
  **/
 static bson_t*
-j_hdf5_serialize_attribute_data(const void* data, size_t data_size)
+j_hdf5_serialize_attribute_data(const bson_t* metadata, const void* data, size_t data_size)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -184,7 +450,15 @@ j_hdf5_serialize_attribute_data(const void* data, size_t data_size)
 
 	b = bson_new();
 
-	bson_append_int32(b, "type", -1, J_HDF5_TYPE_ATTRIBUTE);
+	if (metadata != NULL)
+	{
+		bson_copy_to_excluding_noinit(metadata, b, "data", "size", NULL);
+	}
+	else
+	{
+		bson_append_int32(b, "type", -1, J_HDF5_TYPE_ATTRIBUTE);
+	}
+
 	bson_append_binary(b, "data", -1, BSON_SUBTYPE_BINARY, data, data_size);
 	bson_append_int32(b, "size", -1, (int32_t)data_size);
 
@@ -198,11 +472,12 @@ j_hdf5_serialize_attribute_data(const void* data, size_t data_size)
  * \param type_size The size of the type data
  * \param space_data The space data
  * \param space_size The size of the space data
+ * \param data_size The data size of the attribute
  *
  * \return b The serialized BSON
  **/
 static bson_t*
-j_hdf5_serialize_attribute(const void* type_data, size_t type_size, const void* space_data, size_t space_size)
+j_hdf5_serialize_attribute(const void* type_data, size_t type_size, const void* space_data, size_t space_size, size_t data_size)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -215,6 +490,7 @@ j_hdf5_serialize_attribute(const void* type_data, size_t type_size, const void*
 	bson_append_int32(b, "ssize", -1, (int32_t)space_size);
 	bson_append_binary(b, "tdata", -1, BSON_SUBTYPE_BINARY, type_data, type_size);
 	bson_append_binary(b, "sdata", -1, BSON_SUBTYPE_BINARY, space_data, space_size);
+	bson_append_int32(b, "size", -1, (int32_t)data_size);
 
 	return b;
 }
@@ -269,7 +545,7 @@ j_hdf5_deserialize_attribute_data(const bson_t* b, void* data, size_t data_size)
 	J_TRACE_FUNCTION(NULL);
 
 	bson_iter_t iterator;
-	const void* buf;
+	const void* buf = NULL;
 	bson_subtype_t bs;
 
 	g_return_if_fail(b != NULL);
@@ -288,7 +564,12 @@ j_hdf5_deserialize_attribute_data(const bson_t* b, void* data, size_t data_size)
 			bson_iter_binary(&iterator, &bs, (uint32_t*)&data_size, (const uint8_t**)&buf);
 		}
 	}
-	memcpy(data, buf, data_size);
+
+	// The data is missing if the attribute has not been written yet
+	if (buf != NULL)
+	{
+		memcpy(data, buf, data_size);
+	}
 }
 
 /**
@@ -504,8 +785,6 @@ H5VL_julea_attr_create(void* obj, const H5VL_loc_params_t* loc_params, const cha
 	gsize data_size;
 
 	bson_t* tmp;
-	g_autoptr(JBatch) batch = NULL;
-	gchar* tsloc;
 
 	gpointer value;
 	guint32 len;
@@ -541,6 +820,7 @@ H5VL_julea_attr_create(void* obj, const H5VL_loc_params_t* loc_params, const cha
 			JHD_t* o = obj;
 
 			attribute->location = g_build_path("/", o->location, attr_name, NULL);
+			attribute->file = j_hdf5_file_ref(o->file);
 			attribute->kv = j_kv_new("hdf5", attribute->location);
 		}
 		break;
@@ -549,6 +829,7 @@ H5VL_julea_attr_create(void* obj, const H5VL_loc_params_t* loc_params, const cha
 			JHG_t* o = obj;
 
 			attribute->location = g_build_path("/", o->location, attr_name, NULL);
+			attribute->file = j_hdf5_file_ref(o->file);
 			attribute->kv = j_kv_new("hdf5", attribute->location);
 		}
 		break;
@@ -573,19 +854,12 @@ H5VL_julea_attr_create(void* obj, const H5VL_loc_params_t* loc_params, const cha
 			exit(1);
 	}
 
-	tsloc = g_strdup_printf("%s_ts", attribute->location);
-	attribute->ts = j_kv_new("hdf5", tsloc);
-	g_free(tsloc);
+	attribute->metadata = j_hdf5_serialize_attribute(type_buf, type_size, space_buf, space_size, data_size);
 
-	batch = j_batch_new(j_hdf5_semantics);
-	tmp = j_hdf5_serialize_attribute(type_buf, type_size, space_buf, space_size);
+	tmp = bson_copy(attribute->metadata);
 	value = bson_destroy_with_steal(tmp, TRUE, &len);
-	j_kv_put(attribute->ts, value, len, bson_free, batch);
-
-	if (!j_batch_execute(batch))
-	{
-		// FIXME check return value properly
-	}
+	j_kv_put(attribute->kv, value, len, bson_free, attribute->file->metadata);
+	j_hdf5_file_commit(attribute->file);
 
 	g_free(type_buf);
 	g_free(space_buf);
@@ -606,7 +880,6 @@ H5VL_julea_attr_open(void* obj, const H5VL_loc_params_t* loc_params, const char*
 	JHA_t* attribute;
 
 	g_autoptr(JBatch) batch = NULL;
-	gchar* tsloc;
 
 	gpointer value;
 	guint32 len;
@@ -617,6 +890,8 @@ H5VL_julea_attr_open(void* obj, const H5VL_loc_params_t* loc_params, const char*
 
 	attribute = g_new(JHA_t, 1);
 	attribute->name = g_strdup(attr_name);
+	attribute->data_size = 0;
+	attribute->metadata = NULL;
 
 	switch (loc_params->obj_type)
 	{
@@ -624,12 +899,14 @@ H5VL_julea_attr_open(void* obj, const H5VL_loc_params_t* loc_params, const char*
 		{
 			JHD_t* o = obj;
 			attribute->location = g_build_path("/", o->location, attr_name, NULL);
+			attribute->file = j_hdf5_file_ref(o->file);
 		}
 		break;
 		case H5I_GROUP:
 		{
 			JHG_t* o = obj;
 			attribute->location = g_build_path("/", o->location, attr_name, NULL);
+			attribute->file = j_hdf5_file_ref(o->file);
 		}
 		break;
 		case H5I_ATTR:
@@ -653,20 +930,18 @@ H5VL_julea_attr_open(void* obj, const H5VL_loc_params_t* loc_params, const char*
 			exit(1);
 	}
 
-	tsloc = g_strdup_printf("%s_ts", attribute->location);
-	attribute->ts = j_kv_new("hdf5", tsloc);
-	g_free(tsloc);
+	// Reads have to see the file's pending metadata updates
+	j_hdf5_file_flush(attribute->file);
 
 	batch = j_batch_new(j_hdf5_semantics);
 	attribute->kv = j_kv_new("hdf5", attribute->location);
 	j_kv_get(attribute->kv, &value, &len, batch);
 
+	// Type, space and data are all part of the same key-value pair, so later accesses do not need further round trips
 	if (j_batch_execute(batch))
 	{
-		bson_t data[1];
-
-		bson_init_static(data, value, len);
-		j_hdf5_deserialize_size(data, &(attribute->data_size));
+		attribute->metadata = bson_new_from_data(value, len);
+		j_hdf5_deserialize_size(attribute->metadata, &(attribute->data_size));
 		g_free(value);
 	}
 
@@ -683,25 +958,13 @@ H5VL_julea_attr_read(void* attr, hid_t dtype_id, void* buf, hid_t dxpl_id, void*
 
 	JHA_t* attribute = attr;
 
-	g_autoptr(JBatch) batch = NULL;
-
-	gpointer value;
-	guint32 len;
-
 	(void)dtype_id;
 	(void)dxpl_id;
 	(void)req;
 
-	batch = j_batch_new(j_hdf5_semantics);
-	j_kv_get(attribute->kv, &value, &len, batch);
-
-	if (j_batch_execute(batch))
+	if (attribute->metadata != NULL)
 	{
-		bson_t b[1];
-
-		bson_init_static(b, value, len);
-		j_hdf5_deserialize_attribute_data(b, buf, attribute->data_size);
-		g_free(value);
+		j_hdf5_deserialize_attribute_data(attribute->metadata, buf, attribute->data_size);
 	}
 
 	return 1;
@@ -726,14 +989,32 @@ H5VL_julea_attr_write(void* attr, hid_t dtype_id, const void* buf, hid_t dxpl_id
 
 	(void)dtype_id;
 	(void)dxpl_id;
-	(void)req;
 
-	batch = j_batch_new(j_hdf5_semantics);
-	tmp = j_hdf5_serialize_attribute_data(buf, attribute->data_size);
+	tmp = j_hdf5_serialize_attribute_data(attribute->metadata, buf, attribute->data_size);
+
+	if (attribute->metadata != NULL)
+	{
+		bson_destroy(attribute->metadata);
+	}
+
+	attribute->metadata = bson_copy(tmp);
 	value = bson_destroy_with_steal(tmp, TRUE, &len);
+
+	if (req == NULL)
+	{
+		j_kv_put(attribute->kv, value, len, bson_free, attribute->file->metadata);
+		j_hdf5_file_commit(attribute->file);
+
+		return 1;
+	}
+
+	// Asynchronous writes are tracked by their own request, so they must not overtake pending metadata updates
+	j_hdf5_file_flush(attribute->file);
+
+	batch = j_batch_new(j_hdf5_semantics);
 	j_kv_put(attribute->kv, value, len, bson_free, batch);
 
-	if (!j_batch_execute(batch))
+	if (!j_hdf5_request_execute(j_hdf5_request_new(req), batch, req))
 	{
 		// FIXME check return value properly
 	}
@@ -753,16 +1034,16 @@ H5VL_julea_attr_get(void* attr, H5VL_attr_get_t get_type, hid_t dxpl_id, void**
 
 	JHA_t* attribute = attr;
 
-	g_autoptr(JBatch) batch = NULL;
-
 	herr_t ret_value = 0;
 
-	gpointer value;
-	guint32 len;
-
 	(void)dxpl_id;
 	(void)req;
 
+	if (attribute->metadata == NULL)
+	{
+		return -1;
+	}
+
 	switch (get_type)
 	{
 		case H5VL_ATTR_GET_SPACE:
@@ -770,19 +1051,9 @@ H5VL_julea_attr_get(void* attr, H5VL_attr_get_t get_type, hid_t dxpl_id, void**
 			hid_t* ret_id = va_arg(arguments, hid_t*);
 			void* space;
 
-			batch = j_batch_new(j_hdf5_semantics);
-			j_kv_get(attribute->ts, &value, &len, batch);
-
-			if (j_batch_execute(batch))
-			{
-				bson_t b[1];
-
-				bson_init_static(b, value, len);
-				space = j_hdf5_deserialize_space(b);
-				*ret_id = H5Sdecode(space);
-				g_free(space);
-				g_free(value);
-			}
+			space = j_hdf5_deserialize_space(attribute->metadata);
+			*ret_id = H5Sdecode(space);
+			g_free(space);
 		}
 		break;
 		case H5VL_ATTR_GET_TYPE:
@@ -790,19 +1061,9 @@ H5VL_julea_attr_get(void* attr, H5VL_attr_get_t get_type, hid_t dxpl_id, void**
 			hid_t* ret_id = va_arg(arguments, hid_t*);
 			void* type;
 
-			batch = j_batch_new(j_hdf5_semantics);
-			j_kv_get(attribute->ts, &value, &len, batch);
-
-			if (j_batch_execute(batch))
-			{
-				bson_t b[1];
-
-				bson_init_static(b, value, len);
-				type = j_hdf5_deserialize_type(b);
-				*ret_id = H5Tdecode(type);
-				g_free(type);
-				g_free(value);
-			}
+			type = j_hdf5_deserialize_type(attribute->metadata);
+			*ret_id = H5Tdecode(type);
+			g_free(type);
 		}
 		break;
 		case H5VL_ATTR_GET_ACPL:
@@ -833,11 +1094,12 @@ H5VL_julea_attr_close(void* attr, hid_t dxpl_id, void** req)
 		j_kv_unref(attribute->kv);
 	}
 
-	if (attribute->ts != NULL)
+	if (attribute->metadata != NULL)
 	{
-		j_kv_unref(attribute->ts);
+		bson_destroy(attribute->metadata);
 	}
 
+	j_hdf5_file_unref(attribute->file);
 	g_free(attribute->name);
 	g_free(attribute->location);
 	g_free(attribute);
@@ -855,8 +1117,6 @@ H5VL_julea_file_create(const char* fname, unsigned flags, hid_t fcpl_id, hid_t f
 {
 	JHF_t* file;
 
-	g_autoptr(JBatch) batch = NULL;
-
 	bson_t tmp[1];
 
 	gpointer value;
@@ -868,23 +1128,15 @@ H5VL_julea_file_create(const char* fname, unsigned flags, hid_t fcpl_id, hid_t f
 	(void)dxpl_id;
 	(void)req;
 
-	batch = j_batch_new(j_hdf5_semantics);
-
-	file = g_new(JHF_t, 1);
-	file->name = g_strdup(fname);
-	file->kv = j_kv_new("hdf5", fname);
+	file = j_hdf5_file_new(fname);
 
 	bson_init(tmp);
 	bson_append_int32(tmp, "type", -1, J_HDF5_TYPE_FILE);
 	value = bson_destroy_with_steal(tmp, TRUE, &len);
 	bson_destroy(tmp);
 
-	j_kv_put(file->kv, value, len, bson_free, batch);
-
-	if (j_batch_execute(batch))
-	{
-		// FIXME check return value properly
-	}
+	j_kv_put(file->kv, value, len, bson_free, file->metadata);
+	j_hdf5_file_commit(file);
 
 	return file;
 }
@@ -911,9 +1163,7 @@ H5VL_julea_file_open(const char* fname, unsigned flags, hid_t fapl_id, hid_t dxp
 
 	batch = j_batch_new(j_hdf5_semantics);
 
-	file = g_new(JHF_t, 1);
-	file->name = g_strdup(fname);
-	file->kv = j_kv_new("hdf5", fname);
+	file = j_hdf5_file_new(fname);
 
 	j_kv_get(file->kv, &value, &len, batch);
 
@@ -931,14 +1181,51 @@ H5VL_julea_file_specific(void* obj, H5VL_file_specific_t specific_type, hid_t dx
 {
 	gint ret = -1;
 
-	(void)obj;
 	(void)dxpl_id;
 	(void)req;
-	(void)arguments;
 
 	switch (specific_type)
 	{
 		case H5VL_FILE_FLUSH:
+		{
+			H5I_type_t obj_type = va_arg(arguments, H5I_type_t);
+			JHF_t* file;
+
+			switch (obj_type)
+			{
+				case H5I_FILE:
+					file = obj;
+					break;
+				case H5I_GROUP:
+					file = ((JHG_t*)obj)->file;
+					break;
+				case H5I_DATASET:
+					file = ((JHD_t*)obj)->file;
+					break;
+				case H5I_ATTR:
+					file = ((JHA_t*)obj)->file;
+					break;
+				case H5I_BADID:
+				case H5I_DATASPACE:
+				case H5I_DATATYPE:
+				case H5I_ERROR_CLASS:
+				case H5I_ERROR_MSG:
+				case H5I_ERROR_STACK:
+				case H5I_GENPROP_CLS:
+				case H5I_GENPROP_LST:
+				case H5I_MAP:
+				case H5I_NTYPES:
+				case H5I_SPACE_SEL_ITER:
+				case H5I_UNINIT:
+				case H5I_VFL:
+				case H5I_VOL:
+				default:
+					return -1;
+			}
+
+			ret = (j_hdf5_file_flush(file)) ? 0 : -1;
+		}
+		break;
 		case H5VL_FILE_REOPEN:
 		case H5VL_FILE_MOUNT:
 		case H5VL_FILE_UNMOUNT:
@@ -963,9 +1250,12 @@ H5VL_julea_file_close(void* file, hid_t dxpl_id, void** req)
 	(void)dxpl_id;
 	(void)req;
 
-	j_kv_unref(f->kv);
-	g_free(f->name);
-	g_free(f);
+	if (!j_hdf5_file_flush(f))
+	{
+		// FIXME check return value properly
+	}
+
+	j_hdf5_file_unref(f);
 
 	return 1;
 }
@@ -980,8 +1270,6 @@ H5VL_julea_group_create(void* obj, const H5VL_loc_params_t* loc_params, const ch
 {
 	JHG_t* group;
 
-	g_autoptr(JBatch) batch = NULL;
-
 	bson_t tmp[1];
 
 	gpointer value;
@@ -993,8 +1281,6 @@ H5VL_julea_group_create(void* obj, const H5VL_loc_params_t* loc_params, const ch
 	(void)dxpl_id;
 	(void)req;
 
-	batch = j_batch_new(j_hdf5_semantics);
-
 	group = g_new(JHG_t, 1);
 
 	switch (loc_params->obj_type)
@@ -1004,6 +1290,7 @@ H5VL_julea_group_create(void* obj, const H5VL_loc_params_t* loc_params, const ch
 			JHF_t* o = obj;
 			group->location = g_build_path("/", o->name, name, NULL);
 			group->name = g_strdup(name);
+			group->file = j_hdf5_file_ref(o);
 		}
 		break;
 		case H5I_GROUP:
@@ -1011,6 +1298,7 @@ H5VL_julea_group_create(void* obj, const H5VL_loc_params_t* loc_params, const ch
 			JHG_t* o = obj;
 			group->location = g_build_path("/", o->location, name, NULL);
 			group->name = g_strdup(name);
+			group->file = j_hdf5_file_ref(o->file);
 		}
 		break;
 		case H5I_ATTR:
@@ -1041,12 +1329,8 @@ H5VL_julea_group_create(void* obj, const H5VL_loc_params_t* loc_params, const ch
 	value = bson_destroy_with_steal(tmp, TRUE, &len);
 	bson_destroy(tmp);
 
-	j_kv_put(group->kv, value, len, bson_free, batch);
-
-	if (j_batch_execute(batch))
-	{
-		// FIXME check return value properly
-	}
+	j_kv_put(group->kv, value, len, bson_free, group->file->metadata);
+	j_hdf5_file_commit(group->file);
 
 	return group;
 }
@@ -1081,12 +1365,14 @@ H5VL_julea_group_open(void* obj, const H5VL_loc_params_t* loc_params, const char
 		{
 			JHF_t* o = obj;
 			group->location = g_build_path("/", o->name, name, NULL);
+			group->file = j_hdf5_file_ref(o);
 		}
 		break;
 		case H5I_GROUP:
 		{
 			JHG_t* o = obj;
 			group->location = g_build_path("/", o->location, name, NULL);
+			group->file = j_hdf5_file_ref(o->file);
 		}
 		break;
 		case H5I_ATTR:
@@ -1112,6 +1398,7 @@ H5VL_julea_group_open(void* obj, const H5VL_loc_params_t* loc_params, const char
 
 	group->kv = j_kv_new("hdf5", group->location);
 
+	j_hdf5_file_flush(group->file);
 	j_kv_get(group->kv, &value, &len, batch);
 
 	if (j_batch_execute(batch))
@@ -1135,6 +1422,7 @@ H5VL_julea_group_close(void* grp, hid_t dxpl_id, void** req)
 	(void)req;
 
 	j_kv_unref(g->kv);
+	j_hdf5_file_unref(g->file);
 	g_free(g->name);
 	g_free(g->location);
 	g_free(g);
@@ -1165,7 +1453,7 @@ H5VL_julea_dataset_create(void* obj, const H5VL_loc_params_t* loc_params, const
 	gsize data_size;
 
 	bson_t* tmp;
-	g_autoptr(JBatch) batch = NULL;
+	JBatch* batch;
 	gchar* tsloc;
 
 	gpointer value;
@@ -1178,6 +1466,7 @@ H5VL_julea_dataset_create(void* obj, const H5VL_loc_params_t* loc_params, const
 
 	dset = g_new(JHD_t, 1);
 	dset->name = g_strdup(name);
+	dset->space_id = H5Scopy(space_id);
 	dset->distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
 
 	type_buf = j_hdf5_encode_type("dataset_type_id", &type_id, dcpl_id, &type_size);
@@ -1197,8 +1486,6 @@ H5VL_julea_dataset_create(void* obj, const H5VL_loc_params_t* loc_params, const
 
 	dset->data_size = data_size;
 
-	batch = j_batch_new(j_hdf5_semantics);
-
 	switch (loc_params->obj_type)
 	{
 		case H5I_FILE:
@@ -1206,8 +1493,7 @@ H5VL_julea_dataset_create(void* obj, const H5VL_loc_params_t* loc_params, const
 			JHF_t* o = obj;
 
 			dset->location = g_build_path("/", o->name, name, NULL);
-			dset->object = j_distributed_object_new("hdf5", dset->location, dset->distribution);
-			j_distributed_object_create(dset->object, batch);
+			dset->file = j_hdf5_file_ref(o);
 		}
 
 		break;
@@ -1216,8 +1502,7 @@ H5VL_julea_dataset_create(void* obj, const H5VL_loc_params_t* loc_params, const
 			JHG_t* o = obj;
 
 			dset->location = g_build_path("/", o->location, name, NULL);
-			dset->object = j_distributed_object_new("hdf5", dset->location, dset->distribution);
-			j_distributed_object_create(dset->object, batch);
+			dset->file = j_hdf5_file_ref(o->file);
 		}
 		break;
 		case H5I_ATTR:
@@ -1241,6 +1526,11 @@ H5VL_julea_dataset_create(void* obj, const H5VL_loc_params_t* loc_params, const
 			exit(1);
 	}
 
+	// The object creation is deferred with the metadata, data accesses flush it first
+	batch = dset->file->metadata;
+	dset->object = j_distributed_object_new("hdf5", dset->location, dset->distribution);
+	j_distributed_object_create(dset->object, batch);
+
 	tsloc = g_strdup_printf("%s_data", dset->location);
 	dset->kv = j_kv_new("hdf5", tsloc);
 	g_free(tsloc);
@@ -1248,11 +1538,7 @@ H5VL_julea_dataset_create(void* obj, const H5VL_loc_params_t* loc_params, const
 	tmp = j_hdf5_serialize_dataset(type_buf, type_size, space_buf, space_size, data_size, dset->distribution);
 	value = bson_destroy_with_steal(tmp, TRUE, &len);
 	j_kv_put(dset->kv, value, len, bson_free, batch);
-
-	if (!j_batch_execute(batch))
-	{
-		// FIXME check return value properly
-	}
+	j_hdf5_file_commit(dset->file);
 
 	g_free(type_buf);
 	g_free(space_buf);
@@ -1281,6 +1567,7 @@ H5VL_julea_dataset_open(void* obj, const H5VL_loc_params_t* loc_params, const ch
 
 	dset = g_new(JHD_t, 1);
 	dset->name = g_strdup(name);
+	dset->space_id = H5I_INVALID_HID;
 
 	switch (loc_params->obj_type)
 	{
@@ -1288,6 +1575,7 @@ H5VL_julea_dataset_open(void* obj, const H5VL_loc_params_t* loc_params, const ch
 		{
 			JHF_t* o = obj;
 			dset->location = g_build_path("/", o->name, name, NULL);
+			dset->file = j_hdf5_file_ref(o);
 		}
 
 		break;
@@ -1295,6 +1583,7 @@ H5VL_julea_dataset_open(void* obj, const H5VL_loc_params_t* loc_params, const ch
 		{
 			JHG_t* o = obj;
 			dset->location = g_build_path("/", o->location, name, NULL);
+			dset->file = j_hdf5_file_ref(o->file);
 		}
 		break;
 		case H5I_ATTR:
@@ -1322,15 +1611,23 @@ H5VL_julea_dataset_open(void* obj, const H5VL_loc_params_t* loc_params, const ch
 	dset->kv = j_kv_new("hdf5", tsloc);
 	g_free(tsloc);
 
+	j_hdf5_file_flush(dset->file);
+
 	batch = j_batch_new(j_hdf5_semantics);
 	j_kv_get(dset->kv, &value, &len, batch);
 
 	if (j_batch_execute(batch))
 	{
 		bson_t kvdata[1];
+		void* space;
 
 		bson_init_static(kvdata, value, len);
 		j_hdf5_deserialize_dataset(kvdata, dset, &(dset->data_size));
+
+		space = j_hdf5_deserialize_space(kvdata);
+		dset->space_id = H5Sdecode(space);
+		g_free(space);
+
 		g_free(value);
 	}
 
@@ -1339,31 +1636,226 @@ H5VL_julea_dataset_open(void* obj, const H5VL_loc_params_t* loc_params, const ch
 	return dset;
 }
 
+/**
+ * Fetches the next sequence of a selection iterator.
+ *
+ * \return TRUE if a sequence is available, FALSE if the selection is exhausted or an error occurred.
+ **/
+static gboolean
+j_hdf5_selection_next(hid_t iter_id, hsize_t* offsets, size_t* lengths, size_t* count, size_t* index)
+{
+	size_t nbytes;
+
+	if (*index < *count)
+	{
+		return TRUE;
+	}
+
+	*index = 0;
+
+	if (H5Ssel_iter_get_seq_list(iter_id, J_HDF5_SEQUENCES_MAX, SIZE_MAX, count, &nbytes, offsets, lengths) < 0)
+	{
+		*count = 0;
+	}
+
+	return (*count > 0);
+}
+
+/**
+ * Maps a dataset selection to contiguous extents.
+ * The memory and file selections are traversed in parallel, so each extent is contiguous in memory and in the file.
+ *
+ * \param d             The dataset.
+ * \param mem_space_id  The memory dataspace, H5S_ALL to use the file dataspace.
+ * \param file_space_id The file dataspace, H5S_ALL for the whole dataset.
+ *
+ * \return The extents, NULL if the selections do not match. Should be freed with g_array_unref().
+ **/
+static GArray*
+j_hdf5_dataset_get_extents(JHD_t* d, hid_t mem_space_id, hid_t file_space_id)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree hsize_t* file_offsets = NULL;
+	g_autofree hsize_t* mem_offsets = NULL;
+	g_autofree size_t* file_lengths = NULL;
+	g_autofree size_t* mem_lengths = NULL;
+	GArray* extents;
+	hid_t file_iter_id = H5I_INVALID_HID;
+	hid_t mem_iter_id = H5I_INVALID_HID;
+	hssize_t npoints;
+	size_t element_size;
+	size_t file_count = 0;
+	size_t file_index = 0;
+	size_t file_used = 0;
+	size_t mem_count = 0;
+	size_t mem_index = 0;
+	size_t mem_used = 0;
+	gboolean file_done;
+	gboolean mem_done;
+
+	extents = g_array_new(FALSE, FALSE, sizeof(JHDExtent_t));
+
+	if (file_space_id == H5S_ALL && mem_space_id == H5S_ALL)
+	{
+		JHDExtent_t extent;
+
+		extent.mem_offset = 0;
+		extent.file_offset = 0;
+		extent.length = d->data_size;
+		g_array_append_val(extents, extent);
+
+		return extents;
+	}
+
+	if (file_space_id == H5S_ALL)
+	{
+		file_space_id = d->space_id;
+	}
+
+	if (mem_space_id == H5S_ALL)
+	{
+		mem_space_id = file_space_id;
+	}
+
+	if ((npoints = H5Sget_simple_extent_npoints(d->space_id)) <= 0 || H5Sget_select_npoints(mem_space_id) != H5Sget_select_npoints(file_space_id))
+	{
+		g_array_unref(extents);
+		return NULL;
+	}
+
+	element_size = d->data_size / npoints;
+
+	file_offsets = g_new(hsize_t, J_HDF5_SEQUENCES_MAX);
+	file_lengths = g_new(size_t, J_HDF5_SEQUENCES_MAX);
+	mem_offsets = g_new(hsize_t, J_HDF5_SEQUENCES_MAX);
+	mem_lengths = g_new(size_t, J_HDF5_SEQUENCES_MAX);
+
+	file_iter_id = H5Ssel_iter_create(file_space_id, element_size, 0);
+	mem_iter_id = H5Ssel_iter_create(mem_space_id, element_size, 0);
+
+	if (file_iter_id < 0 || mem_iter_id < 0)
+	{
+		g_array_unref(extents);
+		extents = NULL;
+		goto end;
+	}
+
+	while (TRUE)
+	{
+		JHDExtent_t extent;
+
+		file_done = !j_hdf5_selection_next(file_iter_id, file_offsets, file_lengths, &file_count, &file_index);
+		mem_done = !j_hdf5_selection_next(mem_iter_id, mem_offsets, mem_lengths, &mem_count, &mem_index);
+
+		if (file_done || mem_done)
+		{
+			break;
+		}
+
+		extent.mem_offset = mem_offsets[mem_index] + mem_used;
+		extent.file_offset = file_offsets[file_index] + file_used;
+		extent.length = MIN(file_lengths[file_index] - file_used, mem_lengths[mem_index] - mem_used);
+
+		if (extents->len > 0)
+		{
+			JHDExtent_t* last = &g_array_index(extents, JHDExtent_t, extents->len - 1);
+
+			// Merge extents that are contiguous in memory and in the file
+			if (last->mem_offset + last->length == extent.mem_offset && last->file_offset + last->length == extent.file_offset)
+			{
+				last->length += extent.length;
+			}
+			else
+			{
+				g_array_append_val(extents, extent);
+			}
+		}
+		else
+		{
+			g_array_append_val(extents, extent);
+		}
+
+		file_used += extent.length;
+		mem_used += extent.length;
+
+		if (file_used == file_lengths[file_index])
+		{
+			file_index++;
+			file_used = 0;
+		}
+
+		if (mem_used == mem_lengths[mem_index])
+		{
+			mem_index++;
+			mem_used = 0;
+		}
+	}
+
+	if (file_done != mem_done)
+	{
+		g_array_unref(extents);
+		extents = NULL;
+	}
+
+end:
+	if (file_iter_id >= 0)
+	{
+		H5Ssel_iter_close(file_iter_id);
+	}
+
+	if (mem_iter_id >= 0)
+	{
+		H5Ssel_iter_close(mem_iter_id);
+	}
+
+	return extents;
+}
+
 /**
  * Reads the data from the dataset
+ * Only the selected parts are read, using one distributed object read per contiguous extent.
  **/
 static herr_t
-H5VL_julea_dataset_read(void* dset, hid_t mem_type_id __attribute__((unused)), hid_t mem_space_id __attribute__((unused)), hid_t file_space_id __attribute__((unused)), hid_t plist_id __attribute__((unused)), void* buf, void** req __attribute__((unused)))
+H5VL_julea_dataset_read(void* dset, hid_t mem_type_id __attribute__((unused)), hid_t mem_space_id, hid_t file_space_id, hid_t plist_id __attribute__((unused)), void* buf, void** req)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(GArray) extents = NULL;
 	JHD_t* d;
+	JHR_t* request;
 	guint64 bytes_read;
+	guint64* bytes;
 
 	d = (JHD_t*)dset;
 
+	g_assert(buf != NULL);
+
+	g_assert(d->object != NULL);
+
+	if ((extents = j_hdf5_dataset_get_extents(d, mem_space_id, file_space_id)) == NULL)
+	{
+		return -1;
+	}
+
+	// The dataset's object might not have been created yet
+	j_hdf5_file_flush(d->file);
+
 	batch = j_batch_new(j_hdf5_semantics);
+	request = j_hdf5_request_new(req);
 
 	bytes_read = 0;
+	bytes = (request != NULL) ? &request->bytes : &bytes_read;
 
-	g_assert(buf != NULL);
-
-	g_assert(d->object != NULL);
+	for (guint i = 0; i < extents->len; i++)
+	{
+		JHDExtent_t* extent = &g_array_index(extents, JHDExtent_t, i);
 
-	j_distributed_object_read(d->object, buf, d->data_size, 0, &bytes_read, batch);
+		j_distributed_object_read(d->object, (gchar*)buf + extent->mem_offset, extent->length, extent->file_offset, bytes, batch);
+	}
 
-	if (!j_batch_execute(batch))
+	if (!j_hdf5_request_execute(request, batch, req))
 	{
 		// FIXME check return value properly
 	}
@@ -1390,6 +1882,8 @@ H5VL_julea_dataset_get(void* dset, H5VL_dataset_get_t get_type, hid_t dxpl_id __
 
 	d = (JHD_t*)dset;
 
+	j_hdf5_file_flush(d->file);
+
 	switch (get_type)
 	{
 		case H5VL_DATASET_GET_DAPL:
@@ -1450,23 +1944,41 @@ H5VL_julea_dataset_get(void* dset, H5VL_dataset_get_t get_type, hid_t dxpl_id __
  * Writes the data to the dataset
  **/
 static herr_t
-H5VL_julea_dataset_write(void* dset, hid_t mem_type_id __attribute__((unused)), hid_t mem_space_id __attribute__((unused)), hid_t file_space_id __attribute__((unused)), hid_t plist_id __attribute__((unused)), const void* buf, void** req __attribute__((unused)))
+H5VL_julea_dataset_write(void* dset, hid_t mem_type_id __attribute__((unused)), hid_t mem_space_id, hid_t file_space_id, hid_t plist_id __attribute__((unused)), const void* buf, void** req)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(GArray) extents = NULL;
 	JHD_t* d;
+	JHR_t* request;
 	guint64 bytes_written;
+	guint64* bytes;
 
 	d = (JHD_t*)dset;
 
+	if ((extents = j_hdf5_dataset_get_extents(d, mem_space_id, file_space_id)) == NULL)
+	{
+		return -1;
+	}
+
+	// The dataset's object might not have been created yet
+	j_hdf5_file_flush(d->file);
+
 	batch = j_batch_new(j_hdf5_semantics);
+	request = j_hdf5_request_new(req);
 
 	bytes_written = 0;
+	bytes = (request != NULL) ? &request->bytes : &bytes_written;
 
-	j_distributed_object_write(d->object, buf, d->data_size, 0, &bytes_written, batch);
+	for (guint i = 0; i < extents->len; i++)
+	{
+		JHDExtent_t* extent = &g_array_index(extents, JHDExtent_t, i);
 
-	if (!j_batch_execute(batch))
+		j_distributed_object_write(d->object, (gchar const*)buf + extent->mem_offset, extent->length, extent->file_offset, bytes, batch);
+	}
+
+	if (!j_hdf5_request_execute(request, batch, req))
 	{
 		// FIXME check return value properly
 	}
@@ -1481,6 +1993,12 @@ static herr_t
 H5VL_julea_dataset_close(void* dset, hid_t dxpl_id __attribute__((unused)), void** req __attribute__((unused)))
 {
 	JHD_t* d = (JHD_t*)dset;
+
+	if (d->space_id >= 0)
+	{
+		H5Sclose(d->space_id);
+	}
+
 	if (d->distribution != NULL)
 	{
 		j_distribution_unref(d->distribution);
@@ -1496,6 +2014,7 @@ H5VL_julea_dataset_close(void* dset, hid_t dxpl_id __attribute__((unused)), void
 		j_distributed_object_unref(d->object);
 	}
 
+	j_hdf5_file_unref(d->file);
 	g_free(d->name);
 	free(d->location);
 	free(d);
@@ -1616,12 +2135,12 @@ static const H5VL_class_t H5VL_julea_g = {
 		.opt_query = H5VL_julea_introspect_opt_query,
 	},
 	.request_cls = {
-		.wait = NULL,
+		.wait = H5VL_julea_request_wait,
 		.notify = NULL,
 		.cancel = NULL,
 		.specific = NULL,
 		.optional = NULL,
-		.free = NULL,
+		.free = H5VL_julea_request_free,
 	},
 	.blob_cls = {
 		.put = NULL,
@@ -1704,3 +2223,28 @@ j_hdf5_set_semantics(JSemantics* semantics)
 
 	j_hdf5_semantics = j_semantics_ref(semantics);
 }
+
+gchar**
+j_hdf5_db_find_datasets(hid_t loc_id, gdouble min, gdouble max)
+{
+	(void)loc_id;
+	(void)min;
+	(void)max;
+
+	// This connector does not maintain statistics
+	return NULL;
+}
+
+gint64
+j_hdf5_db_find_chunks(hid_t dataset_id, gdouble min, gdouble max, hsize_t** offsets)
+{
+	(void)dataset_id;
+	(void)min;
+	(void)max;
+
+	g_return_val_if_fail(offsets != NULL, -1);
+
+	*offsets = NULL;
+
+	return -1;
+}
@@ -31,6 +31,7 @@
 
 #include <item/jitem.h>
 #include <item/jitem-internal.h>
+#include <item/jmetadata-cache-internal.h>
 
 #include <julea.h>
 #include <julea-kv.h>
@@ -68,6 +69,33 @@ struct JCollection
 	gint ref_count;
 };
 
+/**
+ * The maximum number of cached collections.
+ **/
+#define J_COLLECTION_CACHE_SIZE 1024
+
+/**
+ * Returns the cache of collections fetched by j_collection_get(), keyed by their names.
+ *
+ * \private
+ *
+ * \return The cache.
+ **/
+static JMetadataCache*
+j_collection_get_cache(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	static JMetadataCache* cache = NULL;
+
+	if (g_once_init_enter(&cache))
+	{
+		g_once_init_leave(&cache, j_metadata_cache_new(J_COLLECTION_CACHE_SIZE, (JMetadataCacheRefFunc)j_collection_ref, (GDestroyNotify)j_collection_unref));
+	}
+
+	return cache;
+}
+
 /**
  * Increases a collection's reference count.
  *
@@ -167,6 +195,9 @@ j_collection_create(gchar const* name, JBatch* batch)
 	tmp = j_collection_serialize(collection);
 	value = bson_destroy_with_steal(tmp, TRUE, &len);
 
+	// A collection of the same name is replaced.
+	j_metadata_cache_remove(j_collection_get_cache(), name);
+
 	j_kv_put(collection->kv, value, len, bson_free, batch);
 
 end:
@@ -181,6 +212,7 @@ j_collection_get_callback(gpointer value, guint32 len, gpointer data)
 
 	bson_init_static(tmp, value, len);
 	*collection = j_collection_new_from_bson(tmp);
+	j_metadata_cache_insert(j_collection_get_cache(), (*collection)->name, *collection);
 
 	g_free(value);
 }
@@ -203,6 +235,11 @@ j_collection_get(JCollection** collection, gchar const* name, JBatch* batch)
 	g_return_if_fail(collection != NULL);
 	g_return_if_fail(name != NULL);
 
+	if ((*collection = j_metadata_cache_lookup(j_collection_get_cache(), name, j_batch_get_semantics(batch))) != NULL)
+	{
+		return;
+	}
+
 	kv = j_kv_new("collections", name);
 	j_kv_get_callback(kv, j_collection_get_callback, collection, batch);
 }
@@ -222,6 +259,39 @@ j_collection_delete(JCollection* collection, JBatch* batch)
 	g_return_if_fail(collection != NULL);
 	g_return_if_fail(batch != NULL);
 
+	j_metadata_cache_remove(j_collection_get_cache(), collection->name);
+	j_item_invalidate_collection(collection);
+
+	j_kv_delete(collection->kv, batch);
+}
+
+/**
+ * Deletes a collection together with all of its items.
+ * Instead of iterating over the items, the servers delete the items' metadata and data by prefix.
+ *
+ * \code
+ * \endcode
+ *
+ * \param collection A collection.
+ * \param deleted    Returns the number of deleted items, can be NULL.
+ * \param batch      A batch.
+ **/
+void
+j_collection_delete_recursive(JCollection* collection, guint64* deleted, JBatch* batch)
+{
+	g_autofree gchar* prefix = NULL;
+
+	g_return_if_fail(collection != NULL);
+	g_return_if_fail(batch != NULL);
+
+	// Items are stored using their path, see j_item_new().
+	prefix = g_strconcat(collection->name, "/", NULL);
+
+	j_metadata_cache_remove(j_collection_get_cache(), collection->name);
+	j_item_invalidate_collection(collection);
+
+	j_kv_delete_prefix("items", prefix, deleted, batch);
+	j_distributed_object_delete_prefix("item", prefix, batch);
 	j_kv_delete(collection->kv, batch);
 }
 
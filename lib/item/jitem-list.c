@@ -0,0 +1,277 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <bson.h>
+
+#include <item/jitem-list.h>
+
+#include <item/jcollection.h>
+
+#include <julea.h>
+#include <julea-kv.h>
+
+/**
+ * \defgroup JItemList Item List
+ *
+ * Listing collections in pages.
+ *
+ * In contrast to JItemIterator, no JItem is constructed.
+ * Only the requested fields are extracted from each item's metadata and stored in memory that is reused for every page.
+ *
+ * @{
+ **/
+
+/**
+ * The maximum number of items per page.
+ **/
+#define J_ITEM_LIST_PAGE_SIZE 4096
+
+/**
+ * The size of the memory holding a page's names.
+ * Pages end early if it is exhausted.
+ **/
+#define J_ITEM_LIST_NAMES_SIZE (1024 * 1024)
+
+struct JItemList
+{
+	JKVIterator* iterator;
+
+	JItemListFields fields;
+
+	/**
+	 * The length of the prefix that is stripped from the keys.
+	 **/
+	gsize prefix_len;
+
+	/**
+	 * The current page's entries.
+	 **/
+	GArray* entries;
+
+	/**
+	 * The current page's names.
+	 **/
+	JMemoryChunk* names;
+
+	/**
+	 * Whether the iterator has an entry that did not fit into the previous page.
+	 **/
+	gboolean pending;
+
+	/**
+	 * Whether the iterator is exhausted.
+	 **/
+	gboolean done;
+};
+
+/**
+ * Creates a new listing of a collection's items.
+ *
+ * \code
+ * g_autoptr(JItemList) list = NULL;
+ * JItemListEntry const* entries;
+ * guint count;
+ *
+ * list = j_collection_list_items(collection, J_ITEM_LIST_NAME | J_ITEM_LIST_SIZE);
+ *
+ * while (j_item_list_next_page(list, &entries, &count))
+ * {
+ *   for (guint i = 0; i < count; i++)
+ *   {
+ *     g_print("%s %" G_GUINT64_FORMAT "\n", entries[i].name, entries[i].size);
+ *   }
+ * }
+ * \endcode
+ *
+ * \param collection A collection.
+ * \param fields     The fields to fill in.
+ *
+ * \return A new listing. Should be freed with j_item_list_free().
+ **/
+JItemList*
+j_collection_list_items(JCollection* collection, JItemListFields fields)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JItemList* list;
+	g_autofree gchar* prefix = NULL;
+
+	g_return_val_if_fail(collection != NULL, NULL);
+
+	prefix = g_strdup_printf("%s/", j_collection_get_name(collection));
+
+	list = g_slice_new(JItemList);
+	list->iterator = j_kv_iterator_new("items", prefix);
+	list->fields = fields;
+	list->prefix_len = strlen(prefix);
+	list->entries = g_array_sized_new(FALSE, FALSE, sizeof(JItemListEntry), J_ITEM_LIST_PAGE_SIZE);
+	list->names = j_memory_chunk_new(J_ITEM_LIST_NAMES_SIZE);
+	list->pending = FALSE;
+	list->done = FALSE;
+
+	return list;
+}
+
+/**
+ * Frees the memory allocated by a listing.
+ *
+ * \param list A listing.
+ **/
+void
+j_item_list_free(JItemList* list)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(list != NULL);
+
+	j_kv_iterator_free(list->iterator);
+	j_memory_chunk_free(list->names);
+	g_array_unref(list->entries);
+
+	g_slice_free(JItemList, list);
+}
+
+/**
+ * Extracts the requested status fields from an item's metadata.
+ *
+ * \private
+ *
+ * \param list  A listing.
+ * \param entry An entry.
+ * \param value The serialized item.
+ * \param len   The serialized item's length.
+ **/
+static void
+j_item_list_parse_status(JItemList* list, JItemListEntry* entry, gconstpointer value, guint32 len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_t b[1];
+	bson_iter_t iterator;
+	bson_iter_t child;
+
+	if (!bson_init_static(b, value, len))
+	{
+		return;
+	}
+
+	if (bson_iter_init_find(&iterator, b, "status") && BSON_ITER_HOLDS_DOCUMENT(&iterator) && bson_iter_recurse(&iterator, &child))
+	{
+		while (bson_iter_next(&child))
+		{
+			gchar const* key;
+
+			key = bson_iter_key(&child);
+
+			if ((list->fields & J_ITEM_LIST_SIZE) && g_strcmp0(key, "size") == 0)
+			{
+				entry->size = bson_iter_int64(&child);
+			}
+			else if ((list->fields & J_ITEM_LIST_MODIFICATION_TIME) && g_strcmp0(key, "modification_time") == 0)
+			{
+				entry->modification_time = bson_iter_int64(&child);
+			}
+		}
+	}
+
+	bson_destroy(b);
+}
+
+/**
+ * Fetches the next page of items.
+ * The returned entries are valid until the next call or until the listing is freed.
+ *
+ * \param list    A listing.
+ * \param entries Returns the page's entries.
+ * \param count   Returns the number of entries.
+ *
+ * \return TRUE if a non-empty page has been returned, FALSE if all items have been listed.
+ **/
+gboolean
+j_item_list_next_page(JItemList* list, JItemListEntry const** entries, guint* count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(list != NULL, FALSE);
+	g_return_val_if_fail(entries != NULL, FALSE);
+	g_return_val_if_fail(count != NULL, FALSE);
+
+	g_array_set_size(list->entries, 0);
+	j_memory_chunk_reset(list->names);
+
+	while (list->entries->len < J_ITEM_LIST_PAGE_SIZE && !list->done)
+	{
+		JItemListEntry entry = { NULL, 0, 0 };
+		gchar const* key;
+		gconstpointer value;
+		guint32 len;
+
+		if (!list->pending && !j_kv_iterator_next(list->iterator))
+		{
+			list->done = TRUE;
+			break;
+		}
+
+		key = j_kv_iterator_get(list->iterator, &value, &len);
+
+		if (list->fields & J_ITEM_LIST_NAME)
+		{
+			gchar const* name = key + list->prefix_len;
+			gsize name_len = strlen(name) + 1;
+			gchar* copy;
+
+			if ((copy = j_memory_chunk_get(list->names, name_len)) == NULL)
+			{
+				// The entry is returned with the next page.
+				list->pending = TRUE;
+				break;
+			}
+
+			memcpy(copy, name, name_len);
+			entry.name = copy;
+		}
+
+		list->pending = FALSE;
+
+		if (list->fields & (J_ITEM_LIST_SIZE | J_ITEM_LIST_MODIFICATION_TIME))
+		{
+			j_item_list_parse_status(list, &entry, value, len);
+		}
+
+		g_array_append_val(list->entries, entry);
+	}
+
+	*entries = (JItemListEntry const*)(gpointer)list->entries->data;
+	*count = list->entries->len;
+
+	return (list->entries->len > 0);
+}
+
+/**
+ * @}
+ **/
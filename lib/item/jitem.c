@@ -33,6 +33,7 @@
 
 #include <item/jcollection.h>
 #include <item/jcollection-internal.h>
+#include <item/jmetadata-cache-internal.h>
 
 #include <julea.h>
 #include <julea-kv.h>
@@ -93,6 +94,17 @@ struct JItem
 		 * Stored in microseconds since the Epoch.
 		 */
 		gint64 modification_time;
+
+		/**
+		 * The serialized item fetched by j_item_get_status(), NULL if there is none.
+		 * It is only available after the batch has been executed and is therefore deserialized on access.
+		 **/
+		gpointer fetched;
+
+		/**
+		 * The length of the serialized item.
+		 **/
+		guint32 fetched_len;
 	} status;
 
 	/**
@@ -106,6 +118,77 @@ struct JItem
 	gint ref_count;
 };
 
+static void j_item_deserialize_status(JItem*, bson_t const*);
+
+/**
+ * The maximum number of cached items.
+ **/
+#define J_ITEM_CACHE_SIZE 16384
+
+/**
+ * Returns the cache of items fetched by j_item_get(), keyed by their paths.
+ *
+ * \private
+ *
+ * \return The cache.
+ **/
+static JMetadataCache*
+j_item_get_cache(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	static JMetadataCache* cache = NULL;
+
+	if (g_once_init_enter(&cache))
+	{
+		g_once_init_leave(&cache, j_metadata_cache_new(J_ITEM_CACHE_SIZE, (JMetadataCacheRefFunc)j_item_ref, (GDestroyNotify)j_item_unref));
+	}
+
+	return cache;
+}
+
+/**
+ * Applies a status fetched by j_item_get_status().
+ *
+ * \private
+ *
+ * \param item An item.
+ **/
+static void
+j_item_apply_status(JItem* item)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_t b[1];
+	bson_iter_t iterator;
+
+	if (item->status.fetched == NULL)
+	{
+		return;
+	}
+
+	if (bson_init_static(b, item->status.fetched, item->status.fetched_len))
+	{
+		if (bson_iter_init_find(&iterator, b, "status") && BSON_ITER_HOLDS_DOCUMENT(&iterator))
+		{
+			guint8 const* data;
+			guint32 len;
+			bson_t b_status[1];
+
+			bson_iter_document(&iterator, &len, &data);
+			bson_init_static(b_status, data, len);
+			j_item_deserialize_status(item, b_status);
+			bson_destroy(b_status);
+		}
+
+		bson_destroy(b);
+	}
+
+	g_free(item->status.fetched);
+	item->status.fetched = NULL;
+	item->status.fetched_len = 0;
+}
+
 /**
  * Increases an item's reference count.
  *
@@ -167,6 +250,7 @@ j_item_unref(JItem* item)
 		j_credentials_unref(item->credentials);
 		j_distribution_unref(item->distribution);
 
+		g_free(item->status.fetched);
 		g_free(item->name);
 
 		g_slice_free(JItem, item);
@@ -213,6 +297,7 @@ j_item_create(JCollection* collection, gchar const* name, JDistribution* distrib
 
 	JItem* item;
 	bson_t* tmp;
+	g_autofree gchar* path = NULL;
 	gpointer value;
 	guint32 len;
 
@@ -227,21 +312,89 @@ j_item_create(JCollection* collection, gchar const* name, JDistribution* distrib
 	tmp = j_item_serialize(item, j_batch_get_semantics(batch));
 	value = bson_destroy_with_steal(tmp, TRUE, &len);
 
+	// An item of the same name is replaced.
+	path = g_build_path("/", j_collection_get_name(collection), name, NULL);
+	j_metadata_cache_remove(j_item_get_cache(), path);
+
 	j_distributed_object_create(item->object, batch);
 	j_kv_put(item->kv, value, len, bson_free, batch);
 
 	return item;
 }
 
+/**
+ * Clones an item, creating a point-in-time copy of it in a collection.
+ * The data is cloned using j_distributed_object_clone(), so that cloning only costs metadata if the object backend can share data.
+ * The clone gets the item's distribution and its current status, so j_item_get_status() should have been called before.
+ *
+ * \code
+ * \endcode
+ *
+ * \param item       An item.
+ * \param collection A collection.
+ * \param name       A name.
+ * \param batch      A batch.
+ *
+ * \return A new item. Should be freed with j_item_unref().
+ **/
+JItem*
+j_item_clone(JItem* item, JCollection* collection, gchar const* name, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JItem* clone;
+	JDistribution* distribution;
+	bson_t* tmp;
+	g_autofree gchar* path = NULL;
+	gpointer value;
+	guint32 len;
+
+	g_return_val_if_fail(item != NULL, NULL);
+	g_return_val_if_fail(collection != NULL, NULL);
+	g_return_val_if_fail(name != NULL, NULL);
+
+	j_item_apply_status(item);
+
+	// The clone's parts are laid out exactly like the item's
+	tmp = j_distribution_serialize(item->distribution);
+	distribution = j_distribution_new_from_bson(tmp);
+	bson_destroy(tmp);
+
+	if ((clone = j_item_new(collection, name, distribution)) == NULL)
+	{
+		j_distribution_unref(distribution);
+		return NULL;
+	}
+
+	clone->status.size = item->status.size;
+	clone->status.modification_time = item->status.modification_time;
+
+	tmp = j_item_serialize(clone, j_batch_get_semantics(batch));
+	value = bson_destroy_with_steal(tmp, TRUE, &len);
+
+	// An item of the same name is replaced.
+	path = g_build_path("/", j_collection_get_name(collection), name, NULL);
+	j_metadata_cache_remove(j_item_get_cache(), path);
+
+	j_distributed_object_clone(item->object, clone->object, batch);
+	j_kv_put(clone->kv, value, len, bson_free, batch);
+
+	return clone;
+}
+
 static void
 j_item_get_callback(gpointer value, guint32 len, gpointer data_)
 {
 	JItemGetData* data = data_;
 	bson_t tmp[1];
+	g_autofree gchar* path = NULL;
 
 	bson_init_static(tmp, value, len);
 	*(data->item) = j_item_new_from_bson(data->collection, tmp);
 
+	path = g_build_path("/", j_collection_get_name(data->collection), (*(data->item))->name, NULL);
+	j_metadata_cache_insert(j_item_get_cache(), path, *(data->item));
+
 	j_collection_unref(data->collection);
 	g_slice_free(JItemGetData, data);
 
@@ -272,11 +425,17 @@ j_item_get(JCollection* collection, JItem** item, gchar const* name, JBatch* bat
 	g_return_if_fail(item != NULL);
 	g_return_if_fail(name != NULL);
 
+	path = g_build_path("/", j_collection_get_name(collection), name, NULL);
+
+	if ((*item = j_metadata_cache_lookup(j_item_get_cache(), path, j_batch_get_semantics(batch))) != NULL)
+	{
+		return;
+	}
+
 	data = g_slice_new(JItemGetData);
 	data->collection = j_collection_ref(collection);
 	data->item = item;
 
-	path = g_build_path("/", j_collection_get_name(collection), name, NULL);
 	kv = j_kv_new("items", path);
 	j_kv_get_callback(kv, j_item_get_callback, data, batch);
 }
@@ -296,9 +455,14 @@ j_item_delete(JItem* item, JBatch* batch)
 {
 	J_TRACE_FUNCTION(NULL);
 
+	g_autofree gchar* path = NULL;
+
 	g_return_if_fail(item != NULL);
 	g_return_if_fail(batch != NULL);
 
+	path = g_build_path("/", j_collection_get_name(item->collection), item->name, NULL);
+	j_metadata_cache_remove(j_item_get_cache(), path);
+
 	j_kv_delete(item->kv, batch);
 	j_distributed_object_delete(item->object, batch);
 }
@@ -330,6 +494,8 @@ j_item_read(JItem* item, gpointer data, guint64 length, guint64 offset, guint64*
 
 /**
  * Writes an item.
+ * The item's size and modification time are updated in its metadata within the same batch,
+ * unless the batch uses J_SEMANTICS_CONSISTENCY_NONE.
  *
  * \note
  * j_item_write() modifies bytes_written even if j_batch_execute() is not called.
@@ -353,13 +519,36 @@ j_item_write(JItem* item, gconstpointer data, guint64 length, guint64 offset, gu
 	g_return_if_fail(data != NULL);
 	g_return_if_fail(bytes_written != NULL);
 
-	// FIXME see j_item_write_exec
 	j_distributed_object_write(item->object, data, length, offset, bytes_written, batch);
+
+	j_item_set_modification_time(item, g_get_real_time());
+
+	if (offset + length > item->status.size)
+	{
+		j_item_set_size(item, offset + length);
+	}
+
+	if (j_semantics_get(j_batch_get_semantics(batch), J_SEMANTICS_CONSISTENCY) != J_SEMANTICS_CONSISTENCY_NONE)
+	{
+		bson_t* tmp;
+		gpointer value;
+		guint32 len;
+
+		// Concurrent writers overwrite each other's status, J_SEMANTICS_CONSISTENCY_IMMEDIATE still returns the exact one.
+		tmp = j_item_serialize(item, j_batch_get_semantics(batch));
+		value = bson_destroy_with_steal(tmp, TRUE, &len);
+
+		j_kv_put(item->kv, value, len, bson_free, batch);
+	}
 }
 
 /**
  * Get the status of an item.
  *
+ * With J_SEMANTICS_CONSISTENCY_IMMEDIATE, the status is combined from all object servers holding parts of the item.
+ * Otherwise, it is read from the item's metadata using a single key-value get,
+ * which is skipped completely if the status is less than a second old.
+ *
  * \code
  * \endcode
  *
@@ -372,9 +561,22 @@ j_item_get_status(JItem* item, JBatch* batch)
 	J_TRACE_FUNCTION(NULL);
 
 	g_return_if_fail(item != NULL);
+	g_return_if_fail(batch != NULL);
+
+	if (j_semantics_get(j_batch_get_semantics(batch), J_SEMANTICS_CONSISTENCY) == J_SEMANTICS_CONSISTENCY_IMMEDIATE)
+	{
+		j_distributed_object_status(item->object, &(item->status.modification_time), &(item->status.size), batch);
+		return;
+	}
+
+	j_item_apply_status(item);
+
+	if (item->status.age >= (guint64)g_get_real_time() - G_USEC_PER_SEC)
+	{
+		return;
+	}
 
-	// FIXME check j_item_get_status_exec
-	j_distributed_object_status(item->object, &(item->status.modification_time), &(item->status.size), batch);
+	j_kv_get(item->kv, &(item->status.fetched), &(item->status.fetched_len), batch);
 }
 
 /**
@@ -394,6 +596,8 @@ j_item_get_size(JItem* item)
 
 	g_return_val_if_fail(item != NULL, 0);
 
+	j_item_apply_status(item);
+
 	return item->status.size;
 }
 
@@ -414,11 +618,33 @@ j_item_get_modification_time(JItem* item)
 
 	g_return_val_if_fail(item != NULL, 0);
 
+	j_item_apply_status(item);
+
 	return item->status.modification_time;
 }
 
 /* Internal */
 
+/**
+ * Removes all cached items of a collection.
+ *
+ * \private
+ *
+ * \param collection A collection.
+ **/
+void
+j_item_invalidate_collection(JCollection* collection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* prefix = NULL;
+
+	g_return_if_fail(collection != NULL);
+
+	prefix = g_strconcat(j_collection_get_name(collection), "/", NULL);
+	j_metadata_cache_remove_prefix(j_item_get_cache(), prefix);
+}
+
 /**
  * Creates a new item.
  *
@@ -463,6 +689,8 @@ j_item_new(JCollection* collection, gchar const* name, JDistribution* distributi
 	item->status.age = g_get_real_time();
 	item->status.size = 0;
 	item->status.modification_time = g_get_real_time();
+	item->status.fetched = NULL;
+	item->status.fetched_len = 0;
 	item->collection = j_collection_ref(collection);
 	item->ref_count = 1;
 
@@ -504,6 +732,8 @@ j_item_new_from_bson(JCollection* collection, bson_t const* b)
 	item->status.age = 0;
 	item->status.size = 0;
 	item->status.modification_time = 0;
+	item->status.fetched = NULL;
+	item->status.fetched_len = 0;
 	item->collection = j_collection_ref(collection);
 	item->ref_count = 1;
 
@@ -584,6 +814,8 @@ j_item_serialize(JItem* item, JSemantics* semantics)
 
 	g_return_val_if_fail(item != NULL, NULL);
 
+	(void)semantics;
+
 	b = bson_new();
 	b_cred = j_credentials_serialize(item->credentials);
 	b_distribution = j_distribution_serialize(item->distribution);
@@ -592,7 +824,7 @@ j_item_serialize(JItem* item, JSemantics* semantics)
 	bson_append_oid(b, "collection", -1, j_collection_get_id(item->collection));
 	bson_append_utf8(b, "name", -1, item->name, -1);
 
-	if (j_semantics_get(semantics, J_SEMANTICS_CONCURRENCY) == J_SEMANTICS_CONCURRENCY_NONE)
+	// The status is kept in the metadata, so that j_item_get_status() does not have to contact all object servers.
 	{
 		bson_t b_document[1];
 
@@ -789,109 +1021,6 @@ j_item_set_size(JItem* item, guint64 size)
 	item->status.size = size;
 }
 
-/*
-gboolean
-j_item_write_exec (JList* operations, JSemantics* semantics)
-{
-	if (j_semantics_get(semantics, J_SEMANTICS_CONCURRENCY) == J_SEMANTICS_CONCURRENCY_NONE && FALSE)
-	{
-		bson_t b_document[1];
-		bson_t cond[1];
-		bson_t op[1];
-		mongoc_client_t* mongo_connection;
-		mongoc_collection_t* mongo_collection;
-		mongoc_write_concern_t* write_concern;
-		gint ret;
-
-		j_helper_set_write_concern(write_concern, semantics);
-
-		bson_init(cond);
-		bson_append_oid(cond, "_id", -1, &(item->id));
-		bson_append_int32(cond, "Status.ModificationTime", -1, item->status.modification_time);
-		//bson_finish(cond);
-
-		j_item_set_modification_time(item, g_get_real_time());
-
-		bson_init(op);
-
-		bson_append_document_begin(op, "$set", -1, b_document);
-
-		if (max_offset > item->status.size)
-		{
-			j_item_set_size(item, max_offset);
-			bson_append_int64(b_document, "Status.Size", -1, item->status.size);
-		}
-
-		bson_append_int64(b_document, "Status.ModificationTime", -1, item->status.modification_time);
-		bson_append_document_end(op, b_document);
-
-		//bson_finish(op);
-
-		mongo_connection = j_connection_pool_pop_kv(0);
-		mongo_collection = mongoc_client_get_collection(mongo_connection, "JULEA", "Items");
-
-		ret = mongoc_collection_update(mongo_collection, MONGOC_UPDATE_NONE, cond, op, write_concern, NULL);
-
-		j_connection_pool_push_kv(0, mongo_connection);
-
-		if (!ret)
-		{
-
-		}
-
-		bson_destroy(cond);
-		bson_destroy(op);
-
-		mongoc_write_concern_destroy(write_concern);
-	}
-}
-*/
-
-/*
-gboolean
-j_item_get_status_exec (JList* operations, JSemantics* semantics)
-{
-	if (semantics_consistency != J_SEMANTICS_CONSISTENCY_IMMEDIATE)
-	{
-		if (item->status.age >= (guint64)g_get_real_time() - G_USEC_PER_SEC)
-		{
-			continue;
-		}
-	}
-
-	if (semantics_concurrency == J_SEMANTICS_CONCURRENCY_NONE)
-	{
-		bson_t result[1];
-		gchar* path;
-
-		bson_init(&opts);
-		bson_append_int32(&opts, "limit", -1, 1);
-		bson_append_document_begin(&opts, "projection", -1, &projection);
-
-		bson_append_bool(&projection, "Status.Size", -1, TRUE);
-		bson_append_bool(&projection, "Status.ModificationTime", -1, TRUE);
-
-		bson_append_document_end(&opts, &projection);
-
-		if (kv_backend != NULL)
-		{
-			path = g_build_path("/", j_collection_get_name(item->collection), item->name, NULL);
-			ret = j_backend_kv_get(kv_backend, "items", path, result) && ret;
-			g_free(path);
-		}
-
-		bson_init(&b);
-		bson_append_oid(&b, "_id", -1, &(item->id));
-
-		if (ret)
-		{
-			j_item_deserialize(item, result);
-			bson_destroy(result);
-		}
-	}
-}
-*/
-
 /**
  * @}
  **/
@@ -0,0 +1,351 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <item/jmetadata-cache-internal.h>
+
+#include <julea.h>
+
+/**
+ * \defgroup JMetadataCache Metadata Cache
+ *
+ * A bounded cache of deserialized collections and items.
+ * Entries are evicted in least recently used order.
+ *
+ * @{
+ **/
+
+/**
+ * The time in seconds an entry may be used with J_SEMANTICS_CONSISTENCY_EVENTUAL.
+ **/
+#define J_METADATA_CACHE_TTL 10
+
+/**
+ * A cache entry.
+ **/
+struct JMetadataCacheEntry
+{
+	/**
+	 * The key, owned by the entry.
+	 **/
+	gchar* key;
+
+	/**
+	 * The cached object, holding a reference.
+	 **/
+	gpointer value;
+
+	/**
+	 * The time the entry has been inserted.
+	 **/
+	gint64 time;
+
+	/**
+	 * The entry's link in the LRU list.
+	 **/
+	GList link[1];
+};
+
+typedef struct JMetadataCacheEntry JMetadataCacheEntry;
+
+/**
+ * A metadata cache.
+ **/
+struct JMetadataCache
+{
+	GMutex mutex[1];
+
+	/**
+	 * Maps keys to entries.
+	 **/
+	GHashTable* entries;
+
+	/**
+	 * The entries, most recently used first.
+	 **/
+	GQueue lru[1];
+
+	/**
+	 * The maximum number of entries.
+	 **/
+	guint capacity;
+
+	JMetadataCacheRefFunc ref_func;
+	GDestroyNotify unref_func;
+};
+
+static void
+j_metadata_cache_entry_free(JMetadataCache* cache, JMetadataCacheEntry* entry)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_queue_unlink(cache->lru, entry->link);
+	cache->unref_func(entry->value);
+	g_free(entry->key);
+
+	g_slice_free(JMetadataCacheEntry, entry);
+}
+
+/**
+ * Creates a new metadata cache.
+ *
+ * \private
+ *
+ * \param capacity   The maximum number of entries.
+ * \param ref_func   A function to reference cached objects.
+ * \param unref_func A function to release cached objects.
+ *
+ * \return A new cache. Should be freed with j_metadata_cache_free().
+ **/
+JMetadataCache*
+j_metadata_cache_new(guint capacity, JMetadataCacheRefFunc ref_func, GDestroyNotify unref_func)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMetadataCache* cache;
+
+	g_return_val_if_fail(capacity > 0, NULL);
+	g_return_val_if_fail(ref_func != NULL, NULL);
+	g_return_val_if_fail(unref_func != NULL, NULL);
+
+	cache = g_slice_new(JMetadataCache);
+	g_mutex_init(cache->mutex);
+	cache->entries = g_hash_table_new(g_str_hash, g_str_equal);
+	g_queue_init(cache->lru);
+	cache->capacity = capacity;
+	cache->ref_func = ref_func;
+	cache->unref_func = unref_func;
+
+	return cache;
+}
+
+/**
+ * Frees the memory allocated for a metadata cache, releasing all cached objects.
+ *
+ * \private
+ *
+ * \param cache A cache.
+ **/
+void
+j_metadata_cache_free(JMetadataCache* cache)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(cache != NULL);
+
+	while (cache->lru->head != NULL)
+	{
+		j_metadata_cache_entry_free(cache, cache->lru->head->data);
+	}
+
+	g_hash_table_unref(cache->entries);
+	g_mutex_clear(cache->mutex);
+
+	g_slice_free(JMetadataCache, cache);
+}
+
+/**
+ * Looks up an object.
+ * With J_SEMANTICS_CONSISTENCY_IMMEDIATE, the cache is bypassed.
+ * With J_SEMANTICS_CONSISTENCY_EVENTUAL, entries expire after J_METADATA_CACHE_TTL seconds.
+ *
+ * \private
+ *
+ * \param cache     A cache.
+ * \param key       A key.
+ * \param semantics The semantics of the lookup.
+ *
+ * \return A new reference to the cached object, NULL if there is none.
+ **/
+gpointer
+j_metadata_cache_lookup(JMetadataCache* cache, gchar const* key, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMetadataCacheEntry* entry;
+	JSemanticsConsistency consistency;
+	gpointer value = NULL;
+
+	g_return_val_if_fail(cache != NULL, NULL);
+	g_return_val_if_fail(key != NULL, NULL);
+	g_return_val_if_fail(semantics != NULL, NULL);
+
+	consistency = j_semantics_get(semantics, J_SEMANTICS_CONSISTENCY);
+
+	if (consistency == J_SEMANTICS_CONSISTENCY_IMMEDIATE)
+	{
+		return NULL;
+	}
+
+	g_mutex_lock(cache->mutex);
+
+	entry = g_hash_table_lookup(cache->entries, key);
+
+	if (entry != NULL)
+	{
+		if (consistency == J_SEMANTICS_CONSISTENCY_EVENTUAL && g_get_monotonic_time() - entry->time > J_METADATA_CACHE_TTL * G_USEC_PER_SEC)
+		{
+			g_hash_table_remove(cache->entries, entry->key);
+			j_metadata_cache_entry_free(cache, entry);
+		}
+		else
+		{
+			g_queue_unlink(cache->lru, entry->link);
+			g_queue_push_head_link(cache->lru, entry->link);
+
+			value = cache->ref_func(entry->value);
+		}
+	}
+
+	g_mutex_unlock(cache->mutex);
+
+	return value;
+}
+
+/**
+ * Inserts an object, replacing an existing entry for the same key.
+ * Evicts the least recently used entry if the cache is full.
+ *
+ * \private
+ *
+ * \param cache A cache.
+ * \param key   A key.
+ * \param value An object, the cache takes a new reference.
+ **/
+void
+j_metadata_cache_insert(JMetadataCache* cache, gchar const* key, gpointer value)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMetadataCacheEntry* entry;
+
+	g_return_if_fail(cache != NULL);
+	g_return_if_fail(key != NULL);
+	g_return_if_fail(value != NULL);
+
+	g_mutex_lock(cache->mutex);
+
+	entry = g_hash_table_lookup(cache->entries, key);
+
+	if (entry != NULL)
+	{
+		g_hash_table_remove(cache->entries, entry->key);
+		j_metadata_cache_entry_free(cache, entry);
+	}
+
+	while (g_hash_table_size(cache->entries) >= cache->capacity)
+	{
+		JMetadataCacheEntry* oldest = cache->lru->tail->data;
+
+		g_hash_table_remove(cache->entries, oldest->key);
+		j_metadata_cache_entry_free(cache, oldest);
+	}
+
+	entry = g_slice_new(JMetadataCacheEntry);
+	entry->key = g_strdup(key);
+	entry->value = cache->ref_func(value);
+	entry->time = g_get_monotonic_time();
+	entry->link->data = entry;
+	entry->link->prev = NULL;
+	entry->link->next = NULL;
+
+	g_hash_table_insert(cache->entries, entry->key, entry);
+	g_queue_push_head_link(cache->lru, entry->link);
+
+	g_mutex_unlock(cache->mutex);
+}
+
+/**
+ * Removes an entry.
+ *
+ * \private
+ *
+ * \param cache A cache.
+ * \param key   A key.
+ **/
+void
+j_metadata_cache_remove(JMetadataCache* cache, gchar const* key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMetadataCacheEntry* entry;
+
+	g_return_if_fail(cache != NULL);
+	g_return_if_fail(key != NULL);
+
+	g_mutex_lock(cache->mutex);
+
+	entry = g_hash_table_lookup(cache->entries, key);
+
+	if (entry != NULL)
+	{
+		g_hash_table_remove(cache->entries, entry->key);
+		j_metadata_cache_entry_free(cache, entry);
+	}
+
+	g_mutex_unlock(cache->mutex);
+}
+
+/**
+ * Removes all entries whose keys start with a prefix.
+ *
+ * \private
+ *
+ * \param cache  A cache.
+ * \param prefix A prefix.
+ **/
+void
+j_metadata_cache_remove_prefix(JMetadataCache* cache, gchar const* prefix)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GList* link;
+
+	g_return_if_fail(cache != NULL);
+	g_return_if_fail(prefix != NULL);
+
+	g_mutex_lock(cache->mutex);
+
+	link = cache->lru->head;
+
+	while (link != NULL)
+	{
+		JMetadataCacheEntry* entry = link->data;
+
+		link = link->next;
+
+		if (g_str_has_prefix(entry->key, prefix))
+		{
+			g_hash_table_remove(cache->entries, entry->key);
+			j_metadata_cache_entry_free(cache, entry);
+		}
+	}
+
+	g_mutex_unlock(cache->mutex);
+}
+
+/**
+ * @}
+ **/
@@ -0,0 +1,1232 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <bson.h>
+
+#include <item/jpacked-object.h>
+
+#include <julea.h>
+#include <julea-kv.h>
+#include <julea-object.h>
+
+/**
+ * \defgroup JPackedObject Packed Object
+ *
+ * Small objects that are appended into large container objects.
+ *
+ * Every small object would otherwise become a separate file on the servers, whose overhead dominates small accesses.
+ * Packed objects of a namespace are appended into a container object owned by the writing process instead.
+ * An index in the key-value store maps each packed object to its extent within a container.
+ * Overwriting or deleting a packed object leaves its old extent behind, which is reclaimed by compacting the container.
+ *
+ * @{
+ **/
+
+/**
+ * The object and key-value namespace holding the containers and the index.
+ **/
+#define J_PACKED_OBJECT_NAMESPACE "packed-objects"
+
+/**
+ * The key-value namespace holding the sizes of sealed containers.
+ **/
+#define J_PACKED_OBJECT_CONTAINERS "packed-containers"
+
+/**
+ * The size after which a container is sealed and a new one is started.
+ **/
+#define J_PACKED_OBJECT_CONTAINER_SIZE (64 * 1024 * 1024)
+
+/**
+ * Sealed containers with at most this percentage of live data are compacted.
+ **/
+#define J_PACKED_OBJECT_COMPACT_LIVE 50
+
+/**
+ * A container that packed objects are appended to.
+ **/
+struct JPackedObjectContainer
+{
+	gchar* namespace;
+
+	/**
+	 * The container's name, prefixed with its namespace.
+	 **/
+	gchar* name;
+
+	JObject* object;
+
+	/**
+	 * The number of bytes handed out so far.
+	 **/
+	guint64 size;
+
+	/**
+	 * The number of writes to the container that have not finished yet.
+	 **/
+	guint writers;
+
+	/**
+	 * Whether the container does not accept new writes anymore.
+	 * It is sealed as soon as all remaining writes have finished.
+	 **/
+	gboolean full;
+};
+
+typedef struct JPackedObjectContainer JPackedObjectContainer;
+
+/**
+ * A packed object entry found while compacting.
+ **/
+struct JPackedObjectCompactionEntry
+{
+	gchar* key;
+	gpointer value;
+	guint32 len;
+
+	guint64 offset;
+	guint64 length;
+};
+
+typedef struct JPackedObjectCompactionEntry JPackedObjectCompactionEntry;
+
+/**
+ * A sealed container considered for compaction.
+ **/
+struct JPackedObjectCompaction
+{
+	gchar* namespace;
+	gchar* container;
+
+	guint64 size;
+	guint64 live;
+
+	/**
+	 * Contains JPackedObjectCompactionEntry elements.
+	 **/
+	GPtrArray* entries;
+};
+
+typedef struct JPackedObjectCompaction JPackedObjectCompaction;
+
+struct JPackedObjectOperation
+{
+	union
+	{
+		struct
+		{
+			JPackedObject* object;
+			gconstpointer data;
+			guint64 length;
+			guint64* bytes_written;
+		} write;
+
+		struct
+		{
+			JPackedObject* object;
+			gpointer data;
+			guint64 length;
+			guint64 offset;
+			guint64* bytes_read;
+		} read;
+
+		struct
+		{
+			gchar* namespace;
+		} compact;
+	};
+};
+
+typedef struct JPackedObjectOperation JPackedObjectOperation;
+
+/**
+ * A JPackedObject.
+ **/
+struct JPackedObject
+{
+	/**
+	 * The namespace.
+	 **/
+	gchar* namespace;
+
+	/**
+	 * The name.
+	 **/
+	gchar* name;
+
+	/**
+	 * The object's index entry.
+	 **/
+	JKV* index;
+
+	/**
+	 * The reference count.
+	 **/
+	gint ref_count;
+};
+
+static struct
+{
+	GMutex mutex[1];
+
+	/**
+	 * Maps namespaces to the containers currently appended to.
+	 **/
+	GHashTable* current;
+
+	/**
+	 * Contains the namespaces currently being compacted in the background.
+	 **/
+	GHashTable* compacting;
+} j_packed_object_state;
+
+static bson_t*
+j_packed_object_serialize_extent(gchar const* container, guint64 offset, guint64 length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_t* b;
+
+	b = bson_new();
+
+	bson_append_utf8(b, "container", -1, container, -1);
+	bson_append_int64(b, "offset", -1, offset);
+	bson_append_int64(b, "length", -1, length);
+
+	return b;
+}
+
+static gboolean
+j_packed_object_deserialize_extent(gconstpointer value, guint32 len, gchar** container, guint64* offset, guint64* length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_t b[1];
+	bson_iter_t iterator;
+
+	if (!bson_init_static(b, value, len) || !bson_iter_init(&iterator, b))
+	{
+		return FALSE;
+	}
+
+	*container = NULL;
+	*offset = 0;
+	*length = 0;
+
+	while (bson_iter_next(&iterator))
+	{
+		gchar const* key;
+
+		key = bson_iter_key(&iterator);
+
+		if (g_strcmp0(key, "container") == 0)
+		{
+			g_free(*container);
+			*container = g_strdup(bson_iter_utf8(&iterator, NULL));
+		}
+		else if (g_strcmp0(key, "offset") == 0)
+		{
+			*offset = bson_iter_int64(&iterator);
+		}
+		else if (g_strcmp0(key, "length") == 0)
+		{
+			*length = bson_iter_int64(&iterator);
+		}
+	}
+
+	return (*container != NULL);
+}
+
+static void
+j_packed_object_container_free(JPackedObjectContainer* container)
+{
+	j_object_unref(container->object);
+	g_free(container->namespace);
+	g_free(container->name);
+
+	g_slice_free(JPackedObjectContainer, container);
+}
+
+static gboolean j_packed_object_compact_namespace(gchar const*, JSemantics*);
+
+static gpointer
+j_packed_object_compact_background(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* namespace = data;
+	g_autoptr(JSemantics) semantics = NULL;
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_packed_object_compact_namespace(namespace, semantics);
+
+	g_mutex_lock(j_packed_object_state.mutex);
+	g_hash_table_remove(j_packed_object_state.compacting, namespace);
+	g_mutex_unlock(j_packed_object_state.mutex);
+
+	return NULL;
+}
+
+/**
+ * Compacts a namespace in the background unless this is already being done.
+ *
+ * \private
+ *
+ * \param namespace A namespace.
+ **/
+static void
+j_packed_object_compact_start(gchar const* namespace)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean start = FALSE;
+
+	g_mutex_lock(j_packed_object_state.mutex);
+
+	if (j_packed_object_state.compacting == NULL)
+	{
+		j_packed_object_state.compacting = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	}
+
+	if (!g_hash_table_contains(j_packed_object_state.compacting, namespace))
+	{
+		g_hash_table_add(j_packed_object_state.compacting, g_strdup(namespace));
+		start = TRUE;
+	}
+
+	g_mutex_unlock(j_packed_object_state.mutex);
+
+	if (start)
+	{
+		j_background_operation_unref(j_background_operation_new(j_packed_object_compact_background, g_strdup(namespace)));
+	}
+}
+
+/**
+ * Seals a container, which makes it eligible for compaction, and frees it.
+ * All writes to the container have to be finished.
+ *
+ * \private
+ *
+ * \param container A container.
+ * \param semantics A semantics object.
+ **/
+static void
+j_packed_object_container_seal(JPackedObjectContainer* container, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JKV) kv = NULL;
+	bson_t* tmp;
+	gpointer value;
+	guint32 len;
+
+	tmp = bson_new();
+	bson_append_int64(tmp, "size", -1, container->size);
+	value = bson_destroy_with_steal(tmp, TRUE, &len);
+
+	batch = j_batch_new(semantics);
+	kv = j_kv_new(J_PACKED_OBJECT_CONTAINERS, container->name);
+	j_kv_put(kv, value, len, bson_free, batch);
+
+	if (j_batch_execute(batch))
+	{
+		j_packed_object_compact_start(container->namespace);
+	}
+
+	j_packed_object_container_free(container);
+}
+
+/**
+ * Reserves space within the current container of a namespace.
+ * A new container is started if the current one is too full.
+ *
+ * \private
+ *
+ * \param namespace A namespace.
+ * \param length    The number of bytes to reserve.
+ * \param semantics A semantics object.
+ * \param offset    Returns the reserved space's offset within the container.
+ *
+ * \return The container, NULL on error. Should be released with j_packed_object_container_release().
+ **/
+static JPackedObjectContainer*
+j_packed_object_container_reserve(gchar const* namespace, guint64 length, JSemantics* semantics, guint64* offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JPackedObjectContainer* container;
+	JPackedObjectContainer* sealed = NULL;
+
+	g_mutex_lock(j_packed_object_state.mutex);
+
+	if (j_packed_object_state.current == NULL)
+	{
+		j_packed_object_state.current = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	}
+
+	container = g_hash_table_lookup(j_packed_object_state.current, namespace);
+
+	if (container != NULL && container->size > 0 && container->size + length > J_PACKED_OBJECT_CONTAINER_SIZE)
+	{
+		g_hash_table_remove(j_packed_object_state.current, namespace);
+		container->full = TRUE;
+
+		if (container->writers == 0)
+		{
+			sealed = container;
+		}
+
+		container = NULL;
+	}
+
+	if (container == NULL)
+	{
+		g_autoptr(JBatch) batch = NULL;
+		g_autofree gchar* uuid = NULL;
+
+		uuid = g_uuid_string_random();
+
+		container = g_slice_new(JPackedObjectContainer);
+		container->namespace = g_strdup(namespace);
+		container->name = g_strconcat(namespace, "/", uuid, NULL);
+		container->object = j_object_new(J_PACKED_OBJECT_NAMESPACE, container->name);
+		container->size = 0;
+		container->writers = 0;
+		container->full = FALSE;
+
+		// The container is created before handing out space, so that writes of other threads can not overtake its creation.
+		batch = j_batch_new(semantics);
+		j_object_create(container->object, batch);
+
+		if (!j_batch_execute(batch))
+		{
+			j_packed_object_container_free(container);
+			container = NULL;
+			goto end;
+		}
+
+		g_hash_table_insert(j_packed_object_state.current, g_strdup(namespace), container);
+	}
+
+	*offset = container->size;
+	container->size += length;
+	container->writers++;
+
+end:
+	g_mutex_unlock(j_packed_object_state.mutex);
+
+	if (sealed != NULL)
+	{
+		j_packed_object_container_seal(sealed, semantics);
+	}
+
+	return container;
+}
+
+/**
+ * Releases a container after writing to the space reserved within it.
+ *
+ * \private
+ *
+ * \param container A container.
+ * \param semantics A semantics object.
+ **/
+static void
+j_packed_object_container_release(JPackedObjectContainer* container, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean seal;
+
+	g_mutex_lock(j_packed_object_state.mutex);
+	container->writers--;
+	seal = (container->full && container->writers == 0);
+	g_mutex_unlock(j_packed_object_state.mutex);
+
+	if (seal)
+	{
+		j_packed_object_container_seal(container, semantics);
+	}
+}
+
+static void
+j_packed_object_compaction_entry_free(JPackedObjectCompactionEntry* entry)
+{
+	g_free(entry->key);
+	g_free(entry->value);
+
+	g_slice_free(JPackedObjectCompactionEntry, entry);
+}
+
+static void
+j_packed_object_compaction_free(JPackedObjectCompaction* compaction)
+{
+	g_ptr_array_unref(compaction->entries);
+	g_free(compaction->namespace);
+	g_free(compaction->container);
+
+	g_slice_free(JPackedObjectCompaction, compaction);
+}
+
+/**
+ * Moves a sealed container's live packed objects into the current container and deletes it.
+ *
+ * \private
+ *
+ * \param compaction A compaction.
+ * \param semantics  A semantics object.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_packed_object_compact_container(JPackedObjectCompaction* compaction, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) object = NULL;
+	g_autoptr(JKV) kv = NULL;
+	g_autoptr(GPtrArray) reserved = NULL;
+	g_autofree gchar* buffer = NULL;
+	g_autofree guint64* bytes = NULL;
+	guint64 position;
+	gboolean ret = TRUE;
+
+	batch = j_batch_new(semantics);
+	object = j_object_new(J_PACKED_OBJECT_NAMESPACE, compaction->container);
+
+	if (compaction->entries->len > 0)
+	{
+		buffer = g_malloc(compaction->live);
+		bytes = g_new0(guint64, compaction->entries->len);
+		position = 0;
+
+		for (guint i = 0; i < compaction->entries->len; i++)
+		{
+			JPackedObjectCompactionEntry* entry = g_ptr_array_index(compaction->entries, i);
+
+			j_object_read(object, buffer + position, entry->length, entry->offset, &(bytes[i]), batch);
+			position += entry->length;
+		}
+
+		if (!j_batch_execute(batch))
+		{
+			return FALSE;
+		}
+
+		reserved = g_ptr_array_new();
+		position = 0;
+
+		for (guint i = 0; i < compaction->entries->len; i++)
+		{
+			JPackedObjectCompactionEntry* entry = g_ptr_array_index(compaction->entries, i);
+			JPackedObjectContainer* container;
+			g_autoptr(JKV) entry_kv = NULL;
+			bson_t* tmp;
+			gpointer value;
+			guint32 len;
+			guint64 offset;
+
+			if (bytes[i] != entry->length)
+			{
+				ret = FALSE;
+				break;
+			}
+
+			if ((container = j_packed_object_container_reserve(compaction->namespace, entry->length, semantics, &offset)) == NULL)
+			{
+				ret = FALSE;
+				break;
+			}
+
+			g_ptr_array_add(reserved, container);
+			j_object_write(container->object, buffer + position, entry->length, offset, &(bytes[i]), batch);
+			position += entry->length;
+
+			tmp = j_packed_object_serialize_extent(container->name, offset, entry->length);
+			value = bson_destroy_with_steal(tmp, TRUE, &len);
+
+			// Packed objects that have been overwritten or deleted in the meantime are left alone.
+			entry_kv = j_kv_new(J_PACKED_OBJECT_NAMESPACE, entry->key);
+			j_kv_compare_and_swap(entry_kv, entry->value, entry->len, value, len, bson_free, NULL, batch);
+		}
+
+		if (reserved->len > 0)
+		{
+			ret = j_batch_execute(batch) && ret;
+		}
+
+		for (guint i = 0; i < reserved->len; i++)
+		{
+			j_packed_object_container_release(g_ptr_array_index(reserved, i), semantics);
+		}
+
+		if (!ret)
+		{
+			return FALSE;
+		}
+	}
+
+	// Sealed containers are not written to anymore, so all data still referenced has been moved.
+	kv = j_kv_new(J_PACKED_OBJECT_CONTAINERS, compaction->container);
+	j_object_delete(object, batch);
+	j_kv_delete(kv, batch);
+
+	return j_batch_execute(batch);
+}
+
+/**
+ * Compacts all sealed containers of a namespace that contain mostly dead data.
+ *
+ * \private
+ *
+ * \param namespace A namespace.
+ * \param semantics A semantics object.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_packed_object_compact_namespace(gchar const* namespace, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GHashTable) compactions = NULL;
+	g_autofree gchar* prefix = NULL;
+	JKVIterator* iterator;
+	GHashTableIter hash_iterator;
+	gpointer value;
+	gboolean ret = TRUE;
+
+	prefix = g_strconcat(namespace, "/", NULL);
+	compactions = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)j_packed_object_compaction_free);
+
+	iterator = j_kv_iterator_new(J_PACKED_OBJECT_CONTAINERS, prefix);
+
+	while (j_kv_iterator_next(iterator))
+	{
+		JPackedObjectCompaction* compaction;
+		gchar const* key;
+		gconstpointer container_value;
+		guint32 len;
+		bson_t b[1];
+		bson_iter_t iter;
+
+		key = j_kv_iterator_get(iterator, &container_value, &len);
+
+		if (!bson_init_static(b, container_value, len) || !bson_iter_init_find(&iter, b, "size"))
+		{
+			continue;
+		}
+
+		compaction = g_slice_new(JPackedObjectCompaction);
+		compaction->namespace = g_strdup(namespace);
+		compaction->container = g_strdup(key);
+		compaction->size = bson_iter_int64(&iter);
+		compaction->live = 0;
+		compaction->entries = g_ptr_array_new_with_free_func((GDestroyNotify)j_packed_object_compaction_entry_free);
+
+		g_hash_table_insert(compactions, compaction->container, compaction);
+	}
+
+	j_kv_iterator_free(iterator);
+
+	if (g_hash_table_size(compactions) == 0)
+	{
+		return TRUE;
+	}
+
+	iterator = j_kv_iterator_new(J_PACKED_OBJECT_NAMESPACE, prefix);
+
+	while (j_kv_iterator_next(iterator))
+	{
+		JPackedObjectCompaction* compaction;
+		JPackedObjectCompactionEntry* entry;
+		g_autofree gchar* container = NULL;
+		gchar const* key;
+		gconstpointer entry_value;
+		guint32 len;
+		guint64 offset;
+		guint64 length;
+
+		key = j_kv_iterator_get(iterator, &entry_value, &len);
+
+		if (!j_packed_object_deserialize_extent(entry_value, len, &container, &offset, &length) || length == 0)
+		{
+			continue;
+		}
+
+		if ((compaction = g_hash_table_lookup(compactions, container)) == NULL)
+		{
+			continue;
+		}
+
+		entry = g_slice_new(JPackedObjectCompactionEntry);
+		entry->key = g_strdup(key);
+#if GLIB_CHECK_VERSION(2, 68, 0)
+		entry->value = g_memdup2(entry_value, len);
+#else
+		entry->value = g_memdup(entry_value, len);
+#endif
+		entry->len = len;
+		entry->offset = offset;
+		entry->length = length;
+
+		g_ptr_array_add(compaction->entries, entry);
+		compaction->live += length;
+	}
+
+	j_kv_iterator_free(iterator);
+
+	g_hash_table_iter_init(&hash_iterator, compactions);
+
+	while (g_hash_table_iter_next(&hash_iterator, NULL, &value))
+	{
+		JPackedObjectCompaction* compaction = value;
+
+		if (compaction->live * 100 > compaction->size * J_PACKED_OBJECT_COMPACT_LIVE)
+		{
+			continue;
+		}
+
+		ret = j_packed_object_compact_container(compaction, semantics) && ret;
+	}
+
+	return ret;
+}
+
+static gboolean
+j_packed_object_write_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autofree JPackedObjectContainer** containers = NULL;
+	g_autofree guint64* offsets = NULL;
+	g_autofree guint64* bytes = NULL;
+	JListIterator* it;
+	guint length;
+	gboolean written = FALSE;
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	batch = j_batch_new(semantics);
+	length = j_list_length(operations);
+	containers = g_new0(JPackedObjectContainer*, length);
+	offsets = g_new0(guint64, length);
+	bytes = g_new0(guint64, length);
+
+	it = j_list_iterator_new(operations);
+
+	for (guint i = 0; j_list_iterator_next(it); i++)
+	{
+		JPackedObjectOperation* operation = j_list_iterator_get(it);
+
+		if (operation->write.length == 0)
+		{
+			continue;
+		}
+
+		if ((containers[i] = j_packed_object_container_reserve(operation->write.object->namespace, operation->write.length, semantics, &(offsets[i]))) == NULL)
+		{
+			ret = FALSE;
+			continue;
+		}
+
+		j_object_write(containers[i]->object, operation->write.data, operation->write.length, offsets[i], &(bytes[i]), batch);
+		written = TRUE;
+	}
+
+	j_list_iterator_free(it);
+
+	if (written)
+	{
+		ret = j_batch_execute(batch) && ret;
+	}
+
+	// The index is only updated after the data has been written, so that readers never see incomplete packed objects.
+	it = j_list_iterator_new(operations);
+
+	for (guint i = 0; j_list_iterator_next(it); i++)
+	{
+		JPackedObjectOperation* operation = j_list_iterator_get(it);
+		bson_t* tmp;
+		gpointer value;
+		guint32 len;
+
+		if (operation->write.length > 0 && (containers[i] == NULL || bytes[i] != operation->write.length))
+		{
+			continue;
+		}
+
+		tmp = j_packed_object_serialize_extent((containers[i] != NULL) ? containers[i]->name : "", offsets[i], operation->write.length);
+		value = bson_destroy_with_steal(tmp, TRUE, &len);
+
+		j_kv_put(operation->write.object->index, value, len, bson_free, batch);
+		j_helper_atomic_add(operation->write.bytes_written, bytes[i]);
+	}
+
+	j_list_iterator_free(it);
+
+	ret = j_batch_execute(batch) && ret;
+
+	for (guint i = 0; i < length; i++)
+	{
+		if (containers[i] != NULL)
+		{
+			j_packed_object_container_release(containers[i], semantics);
+		}
+	}
+
+	return ret;
+}
+
+static void
+j_packed_object_write_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JPackedObjectOperation* operation = data;
+
+	j_packed_object_unref(operation->write.object);
+
+	g_slice_free(JPackedObjectOperation, operation);
+}
+
+static gboolean
+j_packed_object_read_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(GPtrArray) objects = NULL;
+	g_autofree gpointer* values = NULL;
+	g_autofree guint32* lens = NULL;
+	g_autofree guint64* bytes = NULL;
+	JListIterator* it;
+	guint length;
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	batch = j_batch_new(semantics);
+	objects = g_ptr_array_new_with_free_func((GDestroyNotify)j_object_unref);
+	length = j_list_length(operations);
+	values = g_new0(gpointer, length);
+	lens = g_new0(guint32, length);
+	bytes = g_new0(guint64, length);
+
+	it = j_list_iterator_new(operations);
+
+	for (guint i = 0; j_list_iterator_next(it); i++)
+	{
+		JPackedObjectOperation* operation = j_list_iterator_get(it);
+
+		j_kv_get(operation->read.object->index, &(values[i]), &(lens[i]), batch);
+	}
+
+	j_list_iterator_free(it);
+
+	// Missing packed objects are detected below using their values
+	j_batch_execute(batch);
+
+	it = j_list_iterator_new(operations);
+
+	for (guint i = 0; j_list_iterator_next(it); i++)
+	{
+		JPackedObjectOperation* operation = j_list_iterator_get(it);
+		JObject* object;
+		g_autofree gchar* container = NULL;
+		guint64 offset;
+		guint64 extent_length;
+
+		if (values[i] == NULL || !j_packed_object_deserialize_extent(values[i], lens[i], &container, &offset, &extent_length))
+		{
+			ret = FALSE;
+			continue;
+		}
+
+		if (operation->read.offset >= extent_length)
+		{
+			continue;
+		}
+
+		object = j_object_new(J_PACKED_OBJECT_NAMESPACE, container);
+		g_ptr_array_add(objects, object);
+
+		j_object_read(object, operation->read.data, MIN(operation->read.length, extent_length - operation->read.offset), offset + operation->read.offset, &(bytes[i]), batch);
+	}
+
+	j_list_iterator_free(it);
+
+	if (objects->len > 0)
+	{
+		ret = j_batch_execute(batch) && ret;
+	}
+
+	it = j_list_iterator_new(operations);
+
+	for (guint i = 0; j_list_iterator_next(it); i++)
+	{
+		JPackedObjectOperation* operation = j_list_iterator_get(it);
+
+		j_helper_atomic_add(operation->read.bytes_read, bytes[i]);
+		g_free(values[i]);
+	}
+
+	j_list_iterator_free(it);
+
+	return ret;
+}
+
+static void
+j_packed_object_read_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JPackedObjectOperation* operation = data;
+
+	j_packed_object_unref(operation->read.object);
+
+	g_slice_free(JPackedObjectOperation, operation);
+}
+
+static gboolean
+j_packed_object_compact_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JListIterator* it;
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	it = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(it))
+	{
+		JPackedObjectOperation* operation = j_list_iterator_get(it);
+
+		ret = j_packed_object_compact_namespace(operation->compact.namespace, semantics) && ret;
+	}
+
+	j_list_iterator_free(it);
+
+	return ret;
+}
+
+static void
+j_packed_object_compact_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JPackedObjectOperation* operation = data;
+
+	g_free(operation->compact.namespace);
+
+	g_slice_free(JPackedObjectOperation, operation);
+}
+
+/**
+ * Creates a new packed object.
+ *
+ * \code
+ * JPackedObject* object;
+ *
+ * object = j_packed_object_new("my-namespace", "my-object");
+ * \endcode
+ *
+ * \param namespace A namespace.
+ * \param name      A name.
+ *
+ * \return A new packed object. Should be freed with j_packed_object_unref().
+ **/
+JPackedObject*
+j_packed_object_new(gchar const* namespace, gchar const* name)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JPackedObject* object;
+	g_autofree gchar* key = NULL;
+
+	g_return_val_if_fail(namespace != NULL, NULL);
+	g_return_val_if_fail(name != NULL, NULL);
+
+	key = g_strconcat(namespace, "/", name, NULL);
+
+	object = g_slice_new(JPackedObject);
+	object->namespace = g_strdup(namespace);
+	object->name = g_strdup(name);
+	object->index = j_kv_new(J_PACKED_OBJECT_NAMESPACE, key);
+	object->ref_count = 1;
+
+	return object;
+}
+
+/**
+ * Increases a packed object's reference count.
+ *
+ * \param object A packed object.
+ *
+ * \return #object.
+ **/
+JPackedObject*
+j_packed_object_ref(JPackedObject* object)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(object != NULL, NULL);
+
+	g_atomic_int_inc(&(object->ref_count));
+
+	return object;
+}
+
+/**
+ * Decreases a packed object's reference count.
+ * When the reference count reaches zero, frees the memory allocated for the packed object.
+ *
+ * \param object A packed object.
+ **/
+void
+j_packed_object_unref(JPackedObject* object)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(object != NULL);
+
+	if (g_atomic_int_dec_and_test(&(object->ref_count)))
+	{
+		j_kv_unref(object->index);
+
+		g_free(object->namespace);
+		g_free(object->name);
+
+		g_slice_free(JPackedObject, object);
+	}
+}
+
+/**
+ * Returns a packed object's name.
+ *
+ * \param object A packed object.
+ *
+ * \return The name.
+ **/
+gchar const*
+j_packed_object_get_name(JPackedObject* object)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(object != NULL, NULL);
+
+	return object->name;
+}
+
+/**
+ * Writes a packed object.
+ * The packed object's previous content is replaced completely.
+ *
+ * \code
+ * \endcode
+ *
+ * \param object        A packed object.
+ * \param data          A buffer holding the data to write.
+ * \param length        Number of bytes to write.
+ * \param bytes_written Number of bytes written.
+ * \param batch         A batch.
+ **/
+void
+j_packed_object_write(JPackedObject* object, gconstpointer data, guint64 length, guint64* bytes_written, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JPackedObjectOperation* pop;
+	JOperation* operation;
+
+	g_return_if_fail(object != NULL);
+	g_return_if_fail(data != NULL || length == 0);
+	g_return_if_fail(length <= J_PACKED_OBJECT_CONTAINER_SIZE);
+	g_return_if_fail(bytes_written != NULL);
+
+	pop = g_slice_new(JPackedObjectOperation);
+	pop->write.object = j_packed_object_ref(object);
+	pop->write.data = data;
+	pop->write.length = length;
+	pop->write.bytes_written = bytes_written;
+
+	operation = j_operation_new();
+	operation->key = object;
+	operation->data = pop;
+	operation->exec_func = j_packed_object_write_exec;
+	operation->free_func = j_packed_object_write_free;
+
+	j_batch_add(batch, operation);
+
+	*bytes_written = 0;
+}
+
+/**
+ * Reads a packed object.
+ *
+ * \code
+ * \endcode
+ *
+ * \param object     A packed object.
+ * \param data       A buffer to hold the read data.
+ * \param length     Number of bytes to read.
+ * \param offset     An offset within #object.
+ * \param bytes_read Number of bytes read.
+ * \param batch      A batch.
+ **/
+void
+j_packed_object_read(JPackedObject* object, gpointer data, guint64 length, guint64 offset, guint64* bytes_read, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JPackedObjectOperation* pop;
+	JOperation* operation;
+
+	g_return_if_fail(object != NULL);
+	g_return_if_fail(data != NULL);
+	g_return_if_fail(length > 0);
+	g_return_if_fail(bytes_read != NULL);
+
+	pop = g_slice_new(JPackedObjectOperation);
+	pop->read.object = j_packed_object_ref(object);
+	pop->read.data = data;
+	pop->read.length = length;
+	pop->read.offset = offset;
+	pop->read.bytes_read = bytes_read;
+
+	operation = j_operation_new();
+	operation->key = object;
+	operation->data = pop;
+	operation->exec_func = j_packed_object_read_exec;
+	operation->free_func = j_packed_object_read_free;
+
+	j_batch_add(batch, operation);
+
+	*bytes_read = 0;
+}
+
+static void
+j_packed_object_status_callback(gpointer value, guint32 len, gpointer data)
+{
+	guint64* size = data;
+	g_autofree gchar* container = NULL;
+	guint64 offset;
+
+	j_packed_object_deserialize_extent(value, len, &container, &offset, size);
+
+	g_free(value);
+}
+
+/**
+ * Gets a packed object's size.
+ *
+ * \code
+ * \endcode
+ *
+ * \param object A packed object.
+ * \param size   Returns the size in bytes.
+ * \param batch  A batch.
+ **/
+void
+j_packed_object_status(JPackedObject* object, guint64* size, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(object != NULL);
+	g_return_if_fail(size != NULL);
+
+	j_kv_get_callback(object->index, j_packed_object_status_callback, size, batch);
+}
+
+/**
+ * Deletes a packed object.
+ * The space it occupies is reclaimed when its container is compacted.
+ *
+ * \code
+ * \endcode
+ *
+ * \param object A packed object.
+ * \param batch  A batch.
+ **/
+void
+j_packed_object_delete(JPackedObject* object, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(object != NULL);
+
+	j_kv_delete(object->index, batch);
+}
+
+/**
+ * Compacts a namespace's containers, reclaiming the space of overwritten and deleted packed objects.
+ * Only sealed containers with mostly dead data are compacted.
+ * Containers are also compacted in the background whenever one of this process's containers is sealed.
+ *
+ * \code
+ * j_packed_object_compact("my-namespace", batch);
+ * j_batch_execute_async(batch, NULL, NULL);
+ * \endcode
+ *
+ * \param namespace A namespace.
+ * \param batch     A batch.
+ **/
+void
+j_packed_object_compact(gchar const* namespace, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JPackedObjectOperation* pop;
+	JOperation* operation;
+
+	g_return_if_fail(namespace != NULL);
+
+	pop = g_slice_new(JPackedObjectOperation);
+	pop->compact.namespace = g_strdup(namespace);
+
+	operation = j_operation_new();
+	// The operation moves many packed objects and therefore acts as a barrier.
+	operation->key = NULL;
+	operation->data = pop;
+	operation->exec_func = j_packed_object_compact_exec;
+	operation->free_func = j_packed_object_compact_free;
+
+	j_batch_add(batch, operation);
+}
+
+/**
+ * @}
+ **/
@@ -39,10 +39,79 @@
  * @{
  **/
 
+/**
+ * The maximum number of key-value pairs a server sends at once.
+ * Iterating over large namespaces requires multiple round trips but bounded memory.
+ **/
+#define J_KV_ITERATOR_PAGE_SIZE 1024
+
+/**
+ * The state of one server's pages.
+ **/
+struct JKVIteratorServer
+{
+	/**
+	 * The server's index.
+	 **/
+	guint32 index;
+
+	/**
+	 * The current page, NULL if it has been consumed.
+	 **/
+	JMessage* reply;
+
+	/**
+	 * The pair read last from the current page.
+	 **/
+	gchar const* key;
+	gconstpointer value;
+	guint32 len;
+
+	/**
+	 * Whether the pair has not been returned yet, only used by sorted iterators.
+	 **/
+	gboolean pending;
+
+	/**
+	 * Whether the server has more pairs than it sent so far.
+	 **/
+	gboolean more;
+
+	/**
+	 * The last key of the consumed page, NULL before the first page.
+	 **/
+	gchar* last_key;
+};
+
+typedef struct JKVIteratorServer JKVIteratorServer;
+
 struct JKVIterator
 {
 	JBackend* kv_backend;
 
+	gchar* namespace;
+	gchar* prefix;
+
+	/**
+	 * Whether the iterator scans the range [start, end).
+	 * Empty bounds are open.
+	 **/
+	gboolean range;
+	gchar* start;
+	gchar* end;
+	gboolean reverse;
+
+	/**
+	 * The maximum number of pairs, 0 for no limit, and the number of pairs returned so far.
+	 **/
+	guint32 limit;
+	guint32 count;
+
+	/**
+	 * Whether pairs of different servers are merged in ascending key order.
+	 **/
+	gboolean sorted;
+
 	/**
 	 * The iterate cursor.
 	 **/
@@ -59,104 +128,341 @@ struct JKVIterator
 	gconstpointer value;
 	guint32 len;
 
-	JMessage** replies;
-	guint32 replies_n;
-	guint32 replies_cur;
+	/**
+	 * One page of pairs per server.
+	 **/
+	JKVIteratorServer* servers;
+	guint32 servers_n;
+
+	/**
+	 * The server whose page is read by unsorted iterators.
+	 **/
+	guint32 servers_cur;
 };
 
+/**
+ * Sends the request for a server's next page.
+ *
+ * \private
+ *
+ * \param iterator   An iterator.
+ * \param server     A server.
+ * \param connection Returns the connection the reply has to be received from.
+ *
+ * \return The request, NULL if the range's limit has been reached.
+ **/
 static JMessage*
-fetch_reply(guint32 index, gchar const* namespace, gchar const* prefix)
+request_page(JKVIterator* iterator, JKVIteratorServer* server, gpointer* connection)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	g_autoptr(JMessage) message = NULL;
-	JMessage* reply;
-	JMessageType message_type;
-	gpointer kv_connection;
+	JMessage* message;
 	gsize namespace_len;
-	gsize prefix_len;
+	guint32 limit = J_KV_ITERATOR_PAGE_SIZE;
 
-	namespace_len = strlen(namespace) + 1;
+	namespace_len = strlen(iterator->namespace) + 1;
 
-	if (prefix == NULL)
+	if (iterator->range)
 	{
-		message_type = J_MESSAGE_KV_GET_ALL;
-		prefix_len = 0;
+		gsize start_len;
+		gsize end_len;
+		gchar reverse = (iterator->reverse) ? 1 : 0;
+
+		if (iterator->limit > 0)
+		{
+			if (iterator->count >= iterator->limit)
+			{
+				return NULL;
+			}
+
+			limit = MIN(iterator->limit - iterator->count, J_KV_ITERATOR_PAGE_SIZE);
+		}
+
+		// Continue after the last key, which is excluded by the end bound in reverse and by its successor as the start bound otherwise
+		if (server->last_key != NULL && iterator->reverse)
+		{
+			g_free(iterator->end);
+			iterator->end = g_strdup(server->last_key);
+		}
+		else if (server->last_key != NULL)
+		{
+			g_free(iterator->start);
+			iterator->start = g_strdup_printf("%s\001", server->last_key);
+		}
+
+		start_len = strlen(iterator->start) + 1;
+		end_len = strlen(iterator->end) + 1;
+
+		message = j_message_new(J_MESSAGE_KV_GET_RANGE, namespace_len + start_len + end_len + 1 + 4);
+		j_message_append_n(message, iterator->namespace, namespace_len);
+		j_message_append_n(message, iterator->start, start_len);
+		j_message_append_n(message, iterator->end, end_len);
+		j_message_append_1(message, &reverse);
+		j_message_append_4(message, &limit);
 	}
 	else
 	{
-		message_type = J_MESSAGE_KV_GET_BY_PREFIX;
-		prefix_len = strlen(prefix) + 1;
+		gchar const* start;
+		gsize prefix_len = 0;
+		gsize start_len;
+
+		// The server continues after the last key of the previous page
+		start = (server->last_key != NULL) ? server->last_key : "";
+		start_len = strlen(start) + 1;
+
+		if (iterator->prefix != NULL)
+		{
+			prefix_len = strlen(iterator->prefix) + 1;
+		}
+
+		message = j_message_new((iterator->prefix == NULL) ? J_MESSAGE_KV_GET_ALL : J_MESSAGE_KV_GET_BY_PREFIX, namespace_len + prefix_len + start_len + 4);
+		j_message_append_n(message, iterator->namespace, namespace_len);
+
+		if (iterator->prefix != NULL)
+		{
+			j_message_append_n(message, iterator->prefix, prefix_len);
+		}
+
+		j_message_append_n(message, start, start_len);
+		j_message_append_4(message, &limit);
 	}
 
-	message = j_message_new(message_type, namespace_len + prefix_len);
-	j_message_append_n(message, namespace, namespace_len);
+	*connection = j_connection_pool_pop(J_BACKEND_TYPE_KV, server->index);
+	j_message_send(message, *connection);
+
+	return message;
+}
+
+/**
+ * Fetches the next page of all servers that have consumed their page but have more pairs.
+ * All requests are sent before the first reply is received, so the servers work in parallel.
+ *
+ * \private
+ *
+ * \param iterator An iterator.
+ *
+ * \return TRUE if at least one page has been fetched, FALSE otherwise.
+ **/
+static gboolean
+fetch_pages(JKVIterator* iterator)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree JMessage** messages = NULL;
+	g_autofree gpointer* connections = NULL;
+	gboolean ret = FALSE;
 
-	if (prefix != NULL)
+	messages = g_new0(JMessage*, iterator->servers_n);
+	connections = g_new0(gpointer, iterator->servers_n);
+
+	for (guint32 i = 0; i < iterator->servers_n; i++)
 	{
-		j_message_append_n(message, prefix, prefix_len);
+		JKVIteratorServer* server = &(iterator->servers[i]);
+
+		if (server->reply == NULL && server->more)
+		{
+			messages[i] = request_page(iterator, server, &(connections[i]));
+			server->more = FALSE;
+		}
 	}
 
-	kv_connection = j_connection_pool_pop(J_BACKEND_TYPE_KV, index);
-	j_message_send(message, kv_connection);
+	for (guint32 i = 0; i < iterator->servers_n; i++)
+	{
+		JKVIteratorServer* server = &(iterator->servers[i]);
 
-	reply = j_message_new_reply(message);
-	j_message_receive(reply, kv_connection);
+		if (messages[i] == NULL)
+		{
+			continue;
+		}
 
-	j_connection_pool_push(J_BACKEND_TYPE_KV, index, kv_connection);
+		server->reply = j_message_new_reply(messages[i]);
+
+		if (!j_message_receive(server->reply, connections[i]))
+		{
+			j_message_unref(server->reply);
+			server->reply = NULL;
+		}
+
+		j_connection_pool_push(J_BACKEND_TYPE_KV, server->index, connections[i]);
+		j_message_unref(messages[i]);
+
+		ret = TRUE;
+	}
 
-	return reply;
+	return ret;
 }
 
 /**
- * Creates a new JKVIterator.
+ * Reads the next pair from a server's page.
+ * Once the page has been consumed, it is freed and the server remembers where to continue.
  *
- * \param store A JStore.
+ * \private
  *
- * \return A new JKVIterator.
+ * \param server A server.
+ *
+ * \return TRUE if a pair has been read, FALSE if the page has been consumed.
  **/
-JKVIterator*
-j_kv_iterator_new(gchar const* namespace, gchar const* prefix)
+static gboolean
+read_pair(JKVIteratorServer* server)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JKVIterator* iterator;
+	if (server->reply == NULL)
+	{
+		return FALSE;
+	}
 
-	JConfiguration* configuration = j_configuration();
+	server->len = j_message_get_4(server->reply);
 
-	g_return_val_if_fail(namespace != NULL, NULL);
+	if (server->len > 0)
+	{
+		server->value = j_message_get_n(server->reply, server->len);
+		server->key = j_message_get_string(server->reply);
 
-	/* FIXME still necessary? */
-	//j_operation_cache_flush();
+		return TRUE;
+	}
+
+	server->more = (j_message_get_1(server->reply) != 0);
+
+	if (server->more)
+	{
+		g_free(server->last_key);
+		server->last_key = g_strdup(server->key);
+	}
+
+	server->key = NULL;
+	server->value = NULL;
+
+	j_message_unref(server->reply);
+	server->reply = NULL;
+
+	return FALSE;
+}
+
+/**
+ * Creates an iterator that reads pages of the given servers.
+ *
+ * \private
+ *
+ * \param namespace A namespace.
+ * \param first     The first server's index.
+ * \param count     The number of servers.
+ *
+ * \return A new JKVIterator.
+ **/
+static JKVIterator*
+iterator_new(gchar const* namespace, guint32 first, guint32 count)
+{
+	JKVIterator* iterator;
 
 	iterator = g_slice_new(JKVIterator);
-	iterator->kv_backend = j_kv_get_backend();
+	iterator->kv_backend = j_kv_get_backend(namespace);
+	iterator->namespace = g_strdup(namespace);
+	iterator->prefix = NULL;
+	iterator->range = FALSE;
+	iterator->start = NULL;
+	iterator->end = NULL;
+	iterator->reverse = FALSE;
+	iterator->limit = 0;
+	iterator->count = 0;
+	iterator->sorted = FALSE;
 	iterator->cursor = NULL;
 	iterator->key = NULL;
 	iterator->value = NULL;
 	iterator->len = 0;
-	iterator->replies_n = j_configuration_get_server_count(configuration, J_BACKEND_TYPE_KV);
-	iterator->replies = g_new0(JMessage*, iterator->replies_n);
-	iterator->replies_cur = 0;
+	iterator->servers_n = count;
+	iterator->servers = g_new0(JKVIteratorServer, count);
+	iterator->servers_cur = 0;
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		iterator->servers[i].index = first + i;
+		// Every server has to send its first page
+		iterator->servers[i].more = TRUE;
+	}
+
+	return iterator;
+}
+
+/**
+ * Starts an iterator over all pairs or those with a prefix.
+ *
+ * \private
+ *
+ * \param iterator An iterator.
+ * \param prefix   A prefix, NULL for all pairs.
+ **/
+static void
+iterator_start(JKVIterator* iterator, gchar const* prefix)
+{
+	iterator->prefix = g_strdup(prefix);
 
 	if (iterator->kv_backend == NULL)
 	{
-		for (guint32 i = 0; i < iterator->replies_n; i++)
-		{
-			iterator->replies[i] = fetch_reply(i, namespace, prefix);
-		}
+		fetch_pages(iterator);
+	}
+	else if (prefix == NULL)
+	{
+		j_backend_kv_get_all(iterator->kv_backend, iterator->namespace, &(iterator->cursor));
 	}
 	else
 	{
-		if (prefix == NULL)
-		{
-			j_backend_kv_get_all(iterator->kv_backend, namespace, &(iterator->cursor));
-		}
-		else
-		{
-			j_backend_kv_get_by_prefix(iterator->kv_backend, namespace, prefix, &(iterator->cursor));
-		}
+		j_backend_kv_get_by_prefix(iterator->kv_backend, iterator->namespace, prefix, &(iterator->cursor));
 	}
+}
+
+/**
+ * Creates a new JKVIterator.
+ * All servers are queried in parallel and their pairs are returned as they have been received.
+ *
+ * \param namespace A namespace.
+ * \param prefix    A prefix, NULL for all pairs.
+ *
+ * \return A new JKVIterator.
+ **/
+JKVIterator*
+j_kv_iterator_new(gchar const* namespace, gchar const* prefix)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVIterator* iterator;
+
+	JConfiguration* configuration = j_configuration();
+
+	g_return_val_if_fail(namespace != NULL, NULL);
+
+	/* FIXME still necessary? */
+	//j_operation_cache_flush();
+
+	iterator = iterator_new(namespace, 0, j_configuration_get_server_count(configuration, J_BACKEND_TYPE_KV));
+	iterator_start(iterator, prefix);
+
+	return iterator;
+}
+
+/**
+ * Creates a new JKVIterator that returns the pairs of all servers in ascending key order.
+ * Each server's pairs are merged as they arrive, which requires backends that iterate in ascending order.
+ *
+ * \param namespace A namespace.
+ * \param prefix    A prefix, NULL for all pairs.
+ *
+ * \return A new JKVIterator.
+ **/
+JKVIterator*
+j_kv_iterator_new_sorted(gchar const* namespace, gchar const* prefix)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVIterator* iterator;
+
+	JConfiguration* configuration = j_configuration();
+
+	g_return_val_if_fail(namespace != NULL, NULL);
+
+	iterator = iterator_new(namespace, 0, j_configuration_get_server_count(configuration, J_BACKEND_TYPE_KV));
+	iterator->sorted = TRUE;
+	iterator_start(iterator, prefix);
 
 	return iterator;
 }
@@ -176,30 +482,58 @@ j_kv_iterator_new_for_index(guint32 index, gchar const* namespace, gchar const*
 	/* FIXME still necessary? */
 	//j_operation_cache_flush();
 
-	iterator = g_slice_new(JKVIterator);
-	iterator->kv_backend = j_kv_get_backend();
-	iterator->cursor = NULL;
-	iterator->key = NULL;
-	iterator->value = NULL;
-	iterator->len = 0;
-	iterator->replies_n = 1;
-	iterator->replies = g_new0(JMessage*, 1);
-	iterator->replies_cur = 0;
+	iterator = iterator_new(namespace, index, 1);
+	iterator_start(iterator, prefix);
+
+	return iterator;
+}
+
+/**
+ * Creates a new JKVIterator for a range of keys on one server.
+ * Keys are compared byte-wise, so a key is in the range if start <= key < end.
+ *
+ * \code
+ * g_autoptr(JKVIterator) iterator = NULL;
+ *
+ * // The 100 newest entries of 2024, if keys are timestamps
+ * iterator = j_kv_iterator_new_for_range(0, "events", "2024", "2025", 100, TRUE);
+ * \endcode
+ *
+ * \param index     The server's index.
+ * \param namespace A namespace.
+ * \param start     The first key (inclusive), NULL to start at the namespace's first key.
+ * \param end       The last key (exclusive), NULL to end at the namespace's last key.
+ * \param limit     The maximum number of pairs, 0 for no limit.
+ * \param reverse   Whether to return keys in descending order.
+ *
+ * \return A new JKVIterator.
+ **/
+JKVIterator*
+j_kv_iterator_new_for_range(guint32 index, gchar const* namespace, gchar const* start, gchar const* end, guint32 limit, gboolean reverse)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVIterator* iterator;
+
+	JConfiguration* configuration = j_configuration();
+
+	g_return_val_if_fail(namespace != NULL, NULL);
+	g_return_val_if_fail(index < j_configuration_get_server_count(configuration, J_BACKEND_TYPE_KV), NULL);
+
+	iterator = iterator_new(namespace, index, 1);
+	iterator->range = TRUE;
+	iterator->start = g_strdup((start != NULL) ? start : "");
+	iterator->end = g_strdup((end != NULL) ? end : "");
+	iterator->reverse = reverse;
+	iterator->limit = limit;
 
 	if (iterator->kv_backend == NULL)
 	{
-		iterator->replies[0] = fetch_reply(index, namespace, prefix);
+		fetch_pages(iterator);
 	}
-	else
+	else if (!j_backend_kv_get_range(iterator->kv_backend, namespace, start, end, reverse, limit, &(iterator->cursor)))
 	{
-		if (prefix == NULL)
-		{
-			j_backend_kv_get_all(iterator->kv_backend, namespace, &(iterator->cursor));
-		}
-		else
-		{
-			j_backend_kv_get_by_prefix(iterator->kv_backend, namespace, prefix, &(iterator->cursor));
-		}
+		iterator->cursor = NULL;
 	}
 
 	return iterator;
@@ -217,19 +551,109 @@ j_kv_iterator_free(JKVIterator* iterator)
 
 	g_return_if_fail(iterator != NULL);
 
-	for (guint32 i = 0; i < iterator->replies_n; i++)
+	if (iterator->cursor != NULL)
 	{
-		if (iterator->replies[i] != NULL)
+		j_backend_kv_iterator_free(iterator->kv_backend, iterator->cursor);
+	}
+
+	for (guint32 i = 0; i < iterator->servers_n; i++)
+	{
+		if (iterator->servers[i].reply != NULL)
 		{
-			j_message_unref(iterator->replies[i]);
+			j_message_unref(iterator->servers[i].reply);
 		}
+
+		g_free(iterator->servers[i].last_key);
 	}
 
-	g_free(iterator->replies);
+	g_free(iterator->servers);
+	g_free(iterator->namespace);
+	g_free(iterator->prefix);
+	g_free(iterator->start);
+	g_free(iterator->end);
 
 	g_slice_free(JKVIterator, iterator);
 }
 
+/**
+ * Returns the next pair of a sorted iterator, which is the smallest pending pair of all servers.
+ *
+ * \private
+ *
+ * \param iterator A sorted iterator.
+ *
+ * \return The server the pair belongs to, NULL if all servers are exhausted.
+ **/
+static JKVIteratorServer*
+next_sorted(JKVIterator* iterator)
+{
+	JKVIteratorServer* next = NULL;
+
+	// Each server needs a pending pair, fetching the next pages of all exhausted servers at once
+	do
+	{
+		for (guint32 i = 0; i < iterator->servers_n; i++)
+		{
+			JKVIteratorServer* server = &(iterator->servers[i]);
+
+			if (!server->pending)
+			{
+				server->pending = read_pair(server);
+			}
+		}
+	} while (fetch_pages(iterator));
+
+	for (guint32 i = 0; i < iterator->servers_n; i++)
+	{
+		JKVIteratorServer* server = &(iterator->servers[i]);
+
+		if (server->pending && (next == NULL || g_strcmp0(server->key, next->key) < 0))
+		{
+			next = server;
+		}
+	}
+
+	if (next != NULL)
+	{
+		next->pending = FALSE;
+	}
+
+	return next;
+}
+
+/**
+ * Returns the next pair of an unsorted iterator.
+ * The servers' pages are read one after another, after which all servers are asked for their next page.
+ *
+ * \private
+ *
+ * \param iterator An unsorted iterator.
+ *
+ * \return The server the pair belongs to, NULL if all servers are exhausted.
+ **/
+static JKVIteratorServer*
+next_unsorted(JKVIterator* iterator)
+{
+	while (iterator->servers_cur < iterator->servers_n)
+	{
+		JKVIteratorServer* server = &(iterator->servers[iterator->servers_cur]);
+
+		if (read_pair(server))
+		{
+			return server;
+		}
+
+		iterator->servers_cur++;
+
+		if (iterator->servers_cur == iterator->servers_n && fetch_pages(iterator))
+		{
+			iterator->servers_cur = 0;
+		}
+	}
+
+	return NULL;
+}
+
 /**
  * Checks whether another collection is available.
  *
@@ -251,25 +675,33 @@ j_kv_iterator_next(JKVIterator* iterator)
 
 	if (iterator->kv_backend == NULL)
 	{
-	retry:
-		iterator->len = j_message_get_4(iterator->replies[iterator->replies_cur]);
+		JKVIteratorServer* server;
 
-		if (iterator->len > 0)
+		server = (iterator->sorted) ? next_sorted(iterator) : next_unsorted(iterator);
+
+		iterator->key = NULL;
+		iterator->value = NULL;
+		iterator->len = 0;
+
+		if (server != NULL)
 		{
-			iterator->value = j_message_get_n(iterator->replies[iterator->replies_cur], iterator->len);
-			iterator->key = j_message_get_string(iterator->replies[iterator->replies_cur]);
+			iterator->key = server->key;
+			iterator->value = server->value;
+			iterator->len = server->len;
+			iterator->count++;
 
 			ret = TRUE;
 		}
-		else if (iterator->replies_cur < iterator->replies_n - 1)
-		{
-			iterator->replies_cur++;
-			goto retry;
-		}
 	}
-	else
+	else if (iterator->cursor != NULL)
 	{
 		ret = j_backend_kv_iterate(iterator->kv_backend, iterator->cursor, &(iterator->key), &(iterator->value), &(iterator->len));
+
+		if (!ret)
+		{
+			// Exhausted iterators free themselves
+			iterator->cursor = NULL;
+		}
 	}
 
 	return ret;
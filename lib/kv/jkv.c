@@ -39,6 +39,23 @@
  * @{
  **/
 
+/**
+ * The maximum length of values copied into a put message.
+ * Larger values are sent by reference after the message, avoiding the copy.
+ **/
+#define J_KV_PUT_INLINE_LENGTH (64 * 1024)
+
+/**
+ * The number of seconds a copy of a server's Bloom filter is used before it is refreshed.
+ * Keys put by other clients might be reported as absent for this long.
+ **/
+#define J_KV_BLOOM_FILTER_REFRESH 1
+
+/**
+ * The number of seconds before asking a server without Bloom filters again.
+ **/
+#define J_KV_BLOOM_FILTER_RETRY 60
+
 struct JKVOperation
 {
 	union
@@ -58,12 +75,61 @@ struct JKVOperation
 			gpointer* value;
 			guint32 value_len;
 			GDestroyNotify value_destroy;
+			GTimeSpan ttl;
 		} put;
+
+		struct
+		{
+			JKV* kv;
+			gpointer expected;
+			guint32 expected_len;
+			gpointer value;
+			guint32 value_len;
+			GDestroyNotify value_destroy;
+			gboolean* swapped;
+		} compare_and_swap;
+
+		struct
+		{
+			JKV* kv;
+			gint64 delta;
+			gint64* result;
+		} add;
+
+		struct
+		{
+			gchar* namespace;
+			gchar* prefix;
+			guint64* deleted;
+		} delete_prefix;
 	};
 };
 
 typedef struct JKVOperation JKVOperation;
 
+/**
+ * A copy of a server's Bloom filter for one namespace.
+ **/
+struct JKVBloomFilter
+{
+	GMutex mutex[1];
+
+	/**
+	 * The filter, NULL if the server does not provide one.
+	 **/
+	JBloomFilter* filter;
+
+	/**
+	 * The server's epoch and version the copy corresponds to.
+	 **/
+	guint64 epoch;
+	guint64 version;
+
+	gint64 refresh_time;
+};
+
+typedef struct JKVBloomFilter JKVBloomFilter;
+
 /**
  * A JKV.
  **/
@@ -93,24 +159,31 @@ struct JKV
 static JBackend* j_kv_backend = NULL;
 static GModule* j_kv_module = NULL;
 
+// Backend for node-local namespaces, see j_configuration_is_local_namespace()
+static JBackend* j_kv_local_backend = NULL;
+static GModule* j_kv_local_module = NULL;
+
+// Maps "<index>:<namespace>" to JKVBloomFilter
+static GHashTable* j_kv_bloom_filters = NULL;
+static GMutex j_kv_bloom_filters_mutex;
+
 // FIXME copy and use GLib's G_DEFINE_CONSTRUCTOR/DESTRUCTOR
-static void __attribute__((constructor)) j_kv_init(void);
 static void __attribute__((destructor)) j_kv_fini(void);
 
 /**
  * Initializes the kv client.
+ * Called on first use by j_kv_get_backend(), so that processes not using the kv client do not load its backend.
  */
-static void
-j_kv_init(void)
+static gpointer
+j_kv_init(gpointer data)
 {
 	gchar const* kv_backend;
 	gchar const* kv_component;
 	gchar const* kv_path;
+	gchar const* kv_local_backend;
+	gchar const* kv_local_path;
 
-	if (j_kv_backend != NULL && j_kv_module != NULL)
-	{
-		return;
-	}
+	(void)data;
 
 	kv_backend = j_configuration_get_backend(j_configuration(), J_BACKEND_TYPE_KV);
 	kv_component = j_configuration_get_backend_component(j_configuration(), J_BACKEND_TYPE_KV);
@@ -123,6 +196,22 @@ j_kv_init(void)
 			g_critical("Could not initialize kv backend %s.\n", kv_backend);
 		}
 	}
+
+	kv_local_backend = j_configuration_get_local_backend(j_configuration(), J_BACKEND_TYPE_KV);
+	kv_local_path = j_configuration_get_local_backend_path(j_configuration(), J_BACKEND_TYPE_KV);
+
+	// If the kv backend runs on the client anyway, node-local namespaces do not need a backend of their own
+	if (j_kv_backend == NULL && kv_local_backend != NULL)
+	{
+		if (!j_backend_load_local(kv_local_backend, J_BACKEND_TYPE_KV, &j_kv_local_module, &j_kv_local_backend)
+		    || !j_backend_kv_init(j_kv_local_backend, (kv_local_path != NULL) ? kv_local_path : ""))
+		{
+			g_critical("Could not initialize local kv backend %s.\n", kv_local_backend);
+			j_kv_local_backend = NULL;
+		}
+	}
+
+	return NULL;
 }
 
 /**
@@ -131,6 +220,24 @@ j_kv_init(void)
 static void
 j_kv_fini(void)
 {
+	if (j_kv_bloom_filters != NULL)
+	{
+		g_hash_table_unref(j_kv_bloom_filters);
+		j_kv_bloom_filters = NULL;
+	}
+
+	if (j_kv_local_backend != NULL)
+	{
+		j_backend_kv_fini(j_kv_local_backend);
+		j_kv_local_backend = NULL;
+	}
+
+	if (j_kv_local_module != NULL)
+	{
+		g_module_close(j_kv_local_module);
+		j_kv_local_module = NULL;
+	}
+
 	if (j_kv_backend == NULL && j_kv_module == NULL)
 	{
 		return;
@@ -162,8 +269,6 @@ j_kv_put_free(gpointer data)
 	{
 		operation->put.value_destroy(operation->put.value);
 	}
-
-	g_slice_free(JKVOperation, operation);
 }
 
 static void
@@ -176,6 +281,77 @@ j_kv_delete_free(gpointer data)
 	j_kv_unref(kv);
 }
 
+static guint64
+j_kv_put_cache(gpointer data, gpointer buffer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVOperation* operation = data;
+
+	// The value is already owned by the operation.
+	if (operation->put.value_destroy != NULL)
+	{
+		return 0;
+	}
+
+	if (buffer != NULL)
+	{
+		memcpy(buffer, operation->put.value, operation->put.value_len);
+		operation->put.value = buffer;
+	}
+
+	return operation->put.value_len;
+}
+
+static guint64
+j_kv_delete_cache(gpointer data, gpointer buffer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	(void)data;
+	(void)buffer;
+
+	return 0;
+}
+
+/**
+ * Returns the identifier of the key-value pair an operation replaces.
+ *
+ * \private
+ *
+ * \param kv A KV.
+ *
+ * \return An identifier, should be freed with g_free().
+ **/
+static gchar*
+j_kv_get_identifier(JKV* kv)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	// The namespace's length keeps the identifier unambiguous.
+	return g_strdup_printf("%u:%zu:%s:%s", kv->index, strlen(kv->namespace), kv->namespace, kv->key);
+}
+
+static gchar*
+j_kv_put_coalesce(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVOperation* operation = data;
+
+	return j_kv_get_identifier(operation->put.kv);
+}
+
+static gchar*
+j_kv_delete_coalesce(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKV* kv = data;
+
+	return j_kv_get_identifier(kv);
+}
+
 static void
 j_kv_get_free(gpointer data)
 {
@@ -184,169 +360,541 @@ j_kv_get_free(gpointer data)
 	JKVOperation* operation = data;
 
 	j_kv_unref(operation->get.kv);
+}
+
+static void
+j_kv_compare_and_swap_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVOperation* operation = data;
+
+	j_kv_unref(operation->compare_and_swap.kv);
+	g_free(operation->compare_and_swap.expected);
 
-	g_slice_free(JKVOperation, operation);
+	if (operation->compare_and_swap.value_destroy != NULL)
+	{
+		operation->compare_and_swap.value_destroy(operation->compare_and_swap.value);
+	}
 }
 
-static gboolean
-j_kv_put_exec(JList* operations, JSemantics* semantics)
+static void
+j_kv_add_free(gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gboolean ret = TRUE;
+	JKVOperation* operation = data;
 
-	JBackend* kv_backend;
-	g_autoptr(JListIterator) it = NULL;
-	g_autoptr(JMessage) message = NULL;
-	JSemanticsSafety safety;
-	gchar const* namespace;
-	gpointer kv_batch = NULL;
-	gsize namespace_len;
-	guint32 index;
+	j_kv_unref(operation->add.kv);
+}
 
-	g_return_val_if_fail(operations != NULL, FALSE);
-	g_return_val_if_fail(semantics != NULL, FALSE);
+static void
+j_kv_delete_prefix_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	{
-		JKVOperation* kop;
+	JKVOperation* operation = data;
 
-		kop = j_list_get_first(operations);
-		g_assert(kop != NULL);
+	g_free(operation->delete_prefix.namespace);
+	g_free(operation->delete_prefix.prefix);
+}
 
-		namespace = kop->put.kv->namespace;
-		namespace_len = strlen(namespace) + 1;
-		index = kop->put.kv->index;
-	}
+/**
+ * Appends the transaction ID carried by messages of atomic batches.
+ *
+ * \private
+ *
+ * \param message   A message.
+ * \param semantics A semantics.
+ * \param index     The server's index.
+ *
+ * \return The current transaction, or NULL.
+ **/
+static JTransaction*
+j_kv_message_append_transaction(JMessage* message, JSemantics* semantics, guint32 index)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
-	it = j_list_iterator_new(operations);
-	kv_backend = j_kv_get_backend();
+	JTransaction* transaction;
+	guint64 id;
 
-	if (kv_backend == NULL)
-	{
-		/**
-		 * Force safe semantics to make the server send a reply.
-		 * Otherwise, nasty races can occur when using unsafe semantics:
-		 * - The client creates the item and sends its first write.
-		 * - The client sends another operation using another connection from the pool.
-		 * - The second operation is executed first and fails because the item does not exist.
-		 * This does not completely eliminate all races but fixes the common case of create, write, write, ...
-		 **/
-		message = j_message_new(J_MESSAGE_KV_PUT, namespace_len);
-		j_message_set_semantics(message, semantics);
-		j_message_append_n(message, namespace, namespace_len);
-	}
-	else
+	if (j_semantics_get(semantics, J_SEMANTICS_ATOMICITY) != J_SEMANTICS_ATOMICITY_BATCH)
 	{
-		ret = j_backend_kv_batch_start(kv_backend, namespace, semantics, &kv_batch);
+		return NULL;
 	}
 
-	while (j_list_iterator_next(it))
-	{
-		JKVOperation* kop = j_list_iterator_get(it);
+	// Batches without a transaction send 0, for example when executed by the operation cache.
+	transaction = j_transaction_get_current();
+	id = j_transaction_get_id(transaction);
+	j_message_append_8(message, &id);
 
-		if (kv_backend == NULL)
-		{
-			gsize key_len;
+	if (transaction != NULL)
+	{
+		j_transaction_add_participant(transaction, J_BACKEND_TYPE_KV, index);
+	}
 
-			key_len = strlen(kop->put.kv->key) + 1;
+	return transaction;
+}
 
-			j_message_add_operation(message, key_len + 4 + kop->put.value_len);
-			j_message_append_n(message, kop->put.kv->key, key_len);
-			j_message_append_4(message, &(kop->put.value_len));
-			j_message_append_n(message, kop->put.value, kop->put.value_len);
-		}
-		else
-		{
-			ret = j_backend_kv_put(kv_backend, kv_batch, kop->put.kv->key, kop->put.value, kop->put.value_len) && ret;
-		}
+static void
+j_kv_bloom_filter_free(JKVBloomFilter* bloom_filter)
+{
+	if (bloom_filter->filter != NULL)
+	{
+		j_bloom_filter_free(bloom_filter->filter);
 	}
 
-	if (kv_backend == NULL)
-	{
-		gpointer kv_connection;
+	g_mutex_clear(bloom_filter->mutex);
 
-		kv_connection = j_connection_pool_pop(J_BACKEND_TYPE_KV, index);
-		j_message_send(message, kv_connection);
+	g_slice_free(JKVBloomFilter, bloom_filter);
+}
 
-		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
-		{
-			g_autoptr(JMessage) reply = NULL;
+/**
+ * Returns the copy of a server's Bloom filter for a namespace.
+ *
+ * \private
+ *
+ * \param index     The server's index.
+ * \param namespace A namespace.
+ * \param create    Whether to create the copy if it does not exist yet.
+ *
+ * \return The copy, NULL if it does not exist.
+ **/
+static JKVBloomFilter*
+j_kv_bloom_filter_get(guint32 index, gchar const* namespace, gboolean create)
+{
+	J_TRACE_FUNCTION(NULL);
 
-			reply = j_message_new_reply(message);
-			j_message_receive(reply, kv_connection);
+	g_autofree gchar* name = NULL;
+	JKVBloomFilter* bloom_filter;
 
-			/* FIXME do something with reply */
-		}
+	name = g_strdup_printf("%u:%s", index, namespace);
 
-		j_connection_pool_push(J_BACKEND_TYPE_KV, index, kv_connection);
+	g_mutex_lock(&j_kv_bloom_filters_mutex);
+
+	if (j_kv_bloom_filters == NULL)
+	{
+		j_kv_bloom_filters = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)j_kv_bloom_filter_free);
 	}
-	else
+
+	if ((bloom_filter = g_hash_table_lookup(j_kv_bloom_filters, name)) == NULL && create)
 	{
-		ret = j_backend_kv_batch_execute(kv_backend, kv_batch) && ret;
+		bloom_filter = g_slice_new0(JKVBloomFilter);
+		g_mutex_init(bloom_filter->mutex);
+		g_hash_table_insert(j_kv_bloom_filters, g_steal_pointer(&name), bloom_filter);
 	}
 
-	return ret;
+	g_mutex_unlock(&j_kv_bloom_filters_mutex);
+
+	return bloom_filter;
 }
 
-static gboolean
-j_kv_delete_exec(JList* operations, JSemantics* semantics)
+/**
+ * Brings the copy of a server's Bloom filter up to date.
+ * Only the blocks that changed since the last refresh are transferred.
+ * The copy's lock has to be held.
+ *
+ * \private
+ *
+ * \param bloom_filter A copy.
+ * \param index        The server's index.
+ * \param namespace    A namespace.
+ **/
+static void
+j_kv_bloom_filter_refresh(JKVBloomFilter* bloom_filter, guint32 index, gchar const* namespace)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gboolean ret = TRUE;
-
-	JBackend* kv_backend;
-	g_autoptr(JListIterator) it = NULL;
 	g_autoptr(JMessage) message = NULL;
-	JSemanticsSafety safety;
-	gchar const* namespace;
-	gpointer kv_batch = NULL;
+	g_autoptr(JMessage) reply = NULL;
 	gsize namespace_len;
-	guint32 index;
+	guint64 epoch;
+	guint64 version;
+	guint64 bits;
+	guint32 hashes;
+	guint32 count;
+	gboolean merge;
 
-	g_return_val_if_fail(operations != NULL, FALSE);
-	g_return_val_if_fail(semantics != NULL, FALSE);
+	namespace_len = strlen(namespace) + 1;
 
-	{
-		JKV* object;
+	message = j_message_new(J_MESSAGE_KV_BLOOM_FILTER, namespace_len);
+	j_message_append_n(message, namespace, namespace_len);
+	j_message_add_operation(message, 8 + 8);
+	j_message_append_8(message, &(bloom_filter->epoch));
+	j_message_append_8(message, &(bloom_filter->version));
 
-		object = j_list_get_first(operations);
-		g_assert(object != NULL);
+	reply = j_message_new_reply(message);
 
-		namespace = object->namespace;
-		namespace_len = strlen(namespace) + 1;
-		index = object->index;
+	if (!j_connection_pool_exchange(J_BACKEND_TYPE_KV, index, message, reply))
+	{
+		// Keep using the current copy, it is not consulted after the server restarted anyway.
+		bloom_filter->refresh_time = g_get_monotonic_time() + J_KV_BLOOM_FILTER_REFRESH * G_TIME_SPAN_SECOND;
+		return;
 	}
 
-	safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
-	it = j_list_iterator_new(operations);
-	kv_backend = j_kv_get_backend();
+	epoch = j_message_get_8(reply);
+	version = j_message_get_8(reply);
+	bits = j_message_get_8(reply);
+	hashes = j_message_get_4(reply);
+	count = j_message_get_4(reply);
 
-	if (kv_backend == NULL)
+	if (bits == 0)
 	{
-		message = j_message_new(J_MESSAGE_KV_DELETE, namespace_len);
-		j_message_set_semantics(message, semantics);
-		j_message_append_n(message, namespace, namespace_len);
+		g_clear_pointer(&(bloom_filter->filter), j_bloom_filter_free);
+		bloom_filter->refresh_time = g_get_monotonic_time() + J_KV_BLOOM_FILTER_RETRY * G_TIME_SPAN_SECOND;
+		return;
 	}
-	else
+
+	// Within an epoch, the server only ever sets bits, so merging keeps the keys this client added itself.
+	merge = (bloom_filter->filter != NULL && bloom_filter->epoch == epoch && j_bloom_filter_get_bits(bloom_filter->filter) == bits && j_bloom_filter_get_hashes(bloom_filter->filter) == hashes);
+
+	if (!merge)
 	{
-		ret = j_backend_kv_batch_start(kv_backend, namespace, semantics, &kv_batch);
+		g_clear_pointer(&(bloom_filter->filter), j_bloom_filter_free);
+		bloom_filter->filter = j_bloom_filter_new(bits, hashes);
 	}
 
-	while (j_list_iterator_next(it))
+	for (guint32 i = 0; i < count; i++)
 	{
-		JKV* kv = j_list_iterator_get(it);
+		guint64 block;
+		guint64 words[J_BLOOM_FILTER_BLOCK_WORDS];
 
-		if (kv_backend == NULL)
+		block = j_message_get_8(reply);
+		memcpy(words, j_message_get_n(reply, sizeof(words)), sizeof(words));
+
+		if (block >= j_bloom_filter_get_blocks(bloom_filter->filter))
 		{
-			gsize key_len;
+			continue;
+		}
 
-			key_len = strlen(kv->key) + 1;
+		for (guint j = 0; j < J_BLOOM_FILTER_BLOCK_WORDS; j++)
+		{
+			words[j] = GUINT64_FROM_LE(words[j]);
 
-			j_message_add_operation(message, key_len);
-			j_message_append_n(message, kv->key, key_len);
-		}
+			if (merge)
+			{
+				words[j] |= j_bloom_filter_get_block(bloom_filter->filter, block)[j];
+			}
+		}
+
+		j_bloom_filter_set_block(bloom_filter->filter, block, words);
+	}
+
+	bloom_filter->epoch = epoch;
+	bloom_filter->version = version;
+	bloom_filter->refresh_time = g_get_monotonic_time() + J_KV_BLOOM_FILTER_REFRESH * G_TIME_SPAN_SECOND;
+}
+
+/**
+ * Checks whether none of the keys to get exist, using the servers' Bloom filters.
+ * This is only done for eventual consistency, because keys put by other clients might not be reflected yet.
+ *
+ * \private
+ *
+ * \param operations The get operations.
+ * \param semantics  A semantics.
+ *
+ * \return TRUE if all keys are definitely absent, FALSE if some might exist.
+ **/
+static gboolean
+j_kv_bloom_filter_absent(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JListIterator) it = NULL;
+	JKVBloomFilter* bloom_filter;
+	JKVOperation* kop;
+	JSemanticsConsistency consistency;
+	gboolean ret = TRUE;
+
+	consistency = j_semantics_get(semantics, J_SEMANTICS_CONSISTENCY);
+
+	// Transactions have to read through the server.
+	if ((consistency != J_SEMANTICS_CONSISTENCY_EVENTUAL && consistency != J_SEMANTICS_CONSISTENCY_NONE) || j_semantics_get(semantics, J_SEMANTICS_ATOMICITY) == J_SEMANTICS_ATOMICITY_BATCH)
+	{
+		return FALSE;
+	}
+
+	kop = j_list_get_first(operations);
+	bloom_filter = j_kv_bloom_filter_get(kop->get.kv->index, kop->get.kv->namespace, TRUE);
+
+	g_mutex_lock(bloom_filter->mutex);
+
+	if (g_get_monotonic_time() >= bloom_filter->refresh_time)
+	{
+		j_kv_bloom_filter_refresh(bloom_filter, kop->get.kv->index, kop->get.kv->namespace);
+	}
+
+	if (bloom_filter->filter == NULL)
+	{
+		ret = FALSE;
+	}
+	else
+	{
+		it = j_list_iterator_new(operations);
+
+		while (ret && j_list_iterator_next(it))
+		{
+			kop = j_list_iterator_get(it);
+			ret = !j_bloom_filter_contains(bloom_filter->filter, kop->get.kv->key);
+		}
+	}
+
+	g_mutex_unlock(bloom_filter->mutex);
+
+	return ret;
+}
+
+/**
+ * Adds a key this client has written to its copy of the server's Bloom filter.
+ * This way, the client's own writes are never reported as absent.
+ *
+ * \private
+ *
+ * \param kv A JKV.
+ **/
+static void
+j_kv_bloom_filter_add(JKV* kv)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVBloomFilter* bloom_filter;
+
+	if ((bloom_filter = j_kv_bloom_filter_get(kv->index, kv->namespace, FALSE)) == NULL)
+	{
+		return;
+	}
+
+	g_mutex_lock(bloom_filter->mutex);
+
+	if (bloom_filter->filter != NULL)
+	{
+		j_bloom_filter_add(bloom_filter->filter, kv->key);
+	}
+
+	g_mutex_unlock(bloom_filter->mutex);
+}
+
+static gboolean
+j_kv_put_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* kv_backend;
+	g_autoptr(JListIterator) it = NULL;
+	g_autoptr(JMessage) message = NULL;
+	JSemanticsSafety safety;
+	gchar const* namespace;
+	JTransaction* transaction = NULL;
+	gpointer kv_batch = NULL;
+	gsize namespace_len;
+	guint32 index;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JKVOperation* kop;
+
+		kop = j_list_get_first(operations);
+		g_assert(kop != NULL);
+
+		namespace = kop->put.kv->namespace;
+		namespace_len = strlen(namespace) + 1;
+		index = kop->put.kv->index;
+	}
+
+	safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
+	it = j_list_iterator_new(operations);
+	kv_backend = j_kv_get_backend(namespace);
+
+	if (kv_backend == NULL)
+	{
+		/**
+		 * Force safe semantics to make the server send a reply.
+		 * Otherwise, nasty races can occur when using unsafe semantics:
+		 * - The client creates the item and sends its first write.
+		 * - The client sends another operation using another connection from the pool.
+		 * - The second operation is executed first and fails because the item does not exist.
+		 * This does not completely eliminate all races but fixes the common case of create, write, write, ...
+		 **/
+		message = j_message_new(J_MESSAGE_KV_PUT, namespace_len + 8);
+		j_message_set_semantics(message, semantics);
+		j_message_append_n(message, namespace, namespace_len);
+		transaction = j_kv_message_append_transaction(message, semantics, index);
+	}
+	else
+	{
+		ret = j_backend_kv_batch_start(kv_backend, namespace, semantics, &kv_batch);
+	}
+
+	while (j_list_iterator_next(it))
+	{
+		JKVOperation* kop = j_list_iterator_get(it);
+
+		if (kv_backend == NULL)
+		{
+			gsize key_len;
+			gsize ttl_len;
+			guint32 value_len;
+
+			key_len = strlen(kop->put.kv->key) + 1;
+			ttl_len = (kop->put.ttl > 0) ? 8 : 0;
+			value_len = kop->put.value_len;
+
+			j_kv_bloom_filter_add(kop->put.kv);
+
+			if (kop->put.ttl > 0)
+			{
+				value_len |= J_MESSAGE_LENGTH_EXPIRY;
+			}
+
+			if (kop->put.value_len > J_KV_PUT_INLINE_LENGTH)
+			{
+				// The value is owned by the operation, so it stays alive until the message has been sent.
+				value_len |= J_MESSAGE_LENGTH_DEFERRED;
+
+				j_message_add_operation(message, key_len + 4 + ttl_len);
+				j_message_append_n(message, kop->put.kv->key, key_len);
+				j_message_append_4(message, &value_len);
+
+				if (kop->put.ttl > 0)
+				{
+					j_message_append_8(message, &(kop->put.ttl));
+				}
+
+				j_message_add_send(message, kop->put.value, kop->put.value_len);
+			}
+			else
+			{
+				j_message_add_operation(message, key_len + 4 + ttl_len + kop->put.value_len);
+				j_message_append_n(message, kop->put.kv->key, key_len);
+				j_message_append_4(message, &value_len);
+
+				if (kop->put.ttl > 0)
+				{
+					j_message_append_8(message, &(kop->put.ttl));
+				}
+
+				j_message_append_n(message, kop->put.value, kop->put.value_len);
+			}
+		}
+		else
+		{
+			ret = j_backend_kv_put(kv_backend, kv_batch, kop->put.kv->key, kop->put.value, kop->put.value_len) && ret;
+		}
+	}
+
+	if (kv_backend == NULL)
+	{
+		gpointer kv_connection;
+
+		kv_connection = j_connection_pool_pop(J_BACKEND_TYPE_KV, index);
+		j_message_send(message, kv_connection);
+
+		// The replies of staged operations are the servers' votes.
+		if (transaction != NULL || safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		{
+			g_autoptr(JMessage) reply = NULL;
+
+			reply = j_message_new_reply(message);
+
+			if (!j_message_receive(reply, kv_connection))
+			{
+				ret = FALSE;
+			}
+			else if (transaction != NULL)
+			{
+				guint32 count;
+
+				count = j_message_get_count(reply);
+				j_transaction_vote(transaction, count == j_list_length(operations));
+
+				for (guint32 i = 0; i < count; i++)
+				{
+					j_transaction_vote(transaction, j_message_get_4(reply) != 0);
+				}
+			}
+
+			/* FIXME do something with reply */
+		}
+
+		j_connection_pool_push(J_BACKEND_TYPE_KV, index, kv_connection);
+	}
+	else if (!ret && j_semantics_get(semantics, J_SEMANTICS_ATOMICITY) == J_SEMANTICS_ATOMICITY_BATCH)
+	{
+		j_backend_kv_batch_abort(kv_backend, kv_batch);
+	}
+	else
+	{
+		ret = j_backend_kv_batch_execute(kv_backend, kv_batch) && ret;
+	}
+
+	return ret;
+}
+
+static gboolean
+j_kv_delete_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* kv_backend;
+	g_autoptr(JListIterator) it = NULL;
+	g_autoptr(JMessage) message = NULL;
+	JSemanticsSafety safety;
+	gchar const* namespace;
+	JTransaction* transaction = NULL;
+	gpointer kv_batch = NULL;
+	gsize namespace_len;
+	guint32 index;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JKV* object;
+
+		object = j_list_get_first(operations);
+		g_assert(object != NULL);
+
+		namespace = object->namespace;
+		namespace_len = strlen(namespace) + 1;
+		index = object->index;
+	}
+
+	safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
+	it = j_list_iterator_new(operations);
+	kv_backend = j_kv_get_backend(namespace);
+
+	if (kv_backend == NULL)
+	{
+		message = j_message_new(J_MESSAGE_KV_DELETE, namespace_len + 8);
+		j_message_set_semantics(message, semantics);
+		j_message_append_n(message, namespace, namespace_len);
+		transaction = j_kv_message_append_transaction(message, semantics, index);
+	}
+	else
+	{
+		ret = j_backend_kv_batch_start(kv_backend, namespace, semantics, &kv_batch);
+	}
+
+	while (j_list_iterator_next(it))
+	{
+		JKV* kv = j_list_iterator_get(it);
+
+		if (kv_backend == NULL)
+		{
+			gsize key_len;
+
+			key_len = strlen(kv->key) + 1;
+
+			j_message_add_operation(message, key_len);
+			j_message_append_n(message, kv->key, key_len);
+		}
 		else
 		{
 			ret = j_backend_kv_delete(kv_backend, kv_batch, kv->key) && ret;
@@ -360,18 +908,457 @@ j_kv_delete_exec(JList* operations, JSemantics* semantics)
 		kv_connection = j_connection_pool_pop(J_BACKEND_TYPE_KV, index);
 		j_message_send(message, kv_connection);
 
-		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		// The replies of staged operations are the servers' votes.
+		if (transaction != NULL || safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		{
+			g_autoptr(JMessage) reply = NULL;
+
+			reply = j_message_new_reply(message);
+
+			if (!j_message_receive(reply, kv_connection))
+			{
+				ret = FALSE;
+			}
+			else if (transaction != NULL)
+			{
+				guint32 count;
+
+				count = j_message_get_count(reply);
+				j_transaction_vote(transaction, count == j_list_length(operations));
+
+				for (guint32 i = 0; i < count; i++)
+				{
+					j_transaction_vote(transaction, j_message_get_4(reply) != 0);
+				}
+			}
+
+			/* FIXME do something with reply */
+		}
+
+		j_connection_pool_push(J_BACKEND_TYPE_KV, index, kv_connection);
+	}
+	else if (!ret && j_semantics_get(semantics, J_SEMANTICS_ATOMICITY) == J_SEMANTICS_ATOMICITY_BATCH)
+	{
+		j_backend_kv_batch_abort(kv_backend, kv_batch);
+	}
+	else
+	{
+		ret = j_backend_kv_batch_execute(kv_backend, kv_batch) && ret;
+	}
+
+	return ret;
+}
+
+static gboolean
+j_kv_get_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* kv_backend;
+	g_autoptr(JListIterator) it = NULL;
+	g_autoptr(JMessage) message = NULL;
+	gchar const* namespace;
+	gpointer kv_batch = NULL;
+	gsize namespace_len;
+	guint32 index;
+	guint32 read_index;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JKVOperation* kop;
+
+		kop = j_list_get_first(operations);
+		g_assert(kop != NULL);
+
+		namespace = kop->get.kv->namespace;
+		namespace_len = strlen(namespace) + 1;
+		index = kop->get.kv->index;
+		read_index = index;
+	}
+
+	it = j_list_iterator_new(operations);
+	kv_backend = j_kv_get_backend(namespace);
+
+	// Misses do not need a round trip if the server's Bloom filter rules out all keys.
+	if (kv_backend == NULL && j_kv_bloom_filter_absent(operations, semantics))
+	{
+		return FALSE;
+	}
+
+	if (kv_backend == NULL)
+	{
+		/**
+		 * Force safe semantics to make the server send a reply.
+		 * Otherwise, nasty races can occur when using unsafe semantics:
+		 * - The client creates the item and sends its first write.
+		 * - The client sends another operation using another connection from the pool.
+		 * - The second operation is executed first and fails because the item does not exist.
+		 * This does not completely eliminate all races but fixes the common case of create, write, write, ...
+		 **/
+		message = j_message_new(J_MESSAGE_KV_GET, namespace_len + 8);
+		j_message_set_semantics(message, semantics);
+		j_message_append_n(message, namespace, namespace_len);
+
+		// Replicas might lag behind, so only reads that do not have to see the latest changes may use them.
+		// Transactions have to read through their participants.
+		if (j_kv_message_append_transaction(message, semantics, index) == NULL
+		    && j_semantics_get(semantics, J_SEMANTICS_ATOMICITY) != J_SEMANTICS_ATOMICITY_BATCH
+		    && (j_semantics_get(semantics, J_SEMANTICS_CONSISTENCY) == J_SEMANTICS_CONSISTENCY_EVENTUAL || j_semantics_get(semantics, J_SEMANTICS_CONSISTENCY) == J_SEMANTICS_CONSISTENCY_NONE))
+		{
+			read_index = j_connection_pool_get_read_index(J_BACKEND_TYPE_KV, index);
+		}
+	}
+	else
+	{
+		ret = j_backend_kv_batch_start(kv_backend, namespace, semantics, &kv_batch);
+	}
+
+	while (j_list_iterator_next(it))
+	{
+		JKVOperation* kop = j_list_iterator_get(it);
+
+		if (kv_backend == NULL)
+		{
+			gsize key_len;
+
+			key_len = strlen(kop->get.kv->key) + 1;
+
+			j_message_add_operation(message, key_len);
+			j_message_append_n(message, kop->get.kv->key, key_len);
+		}
+		else
+		{
+			if (kop->get.func != NULL)
+			{
+				gpointer value;
+				guint32 len;
+
+				ret = j_backend_kv_get(kv_backend, kv_batch, kop->get.kv->key, &value, &len) && ret;
+
+				if (ret)
+				{
+					// j_backend_kv_get returns a new copy, pass it along
+					kop->get.func(value, len, kop->get.data);
+				}
+			}
+			else
+			{
+				ret = j_backend_kv_get(kv_backend, kv_batch, kop->get.kv->key, kop->get.value, kop->get.value_len) && ret;
+			}
+		}
+	}
+
+	if (kv_backend == NULL)
+	{
+		g_autoptr(JListIterator) iter = NULL;
+		g_autoptr(JMessage) reply = NULL;
+
+		reply = j_message_new_reply(message);
+
+		// Gets are idempotent and can be retried after network errors, falling back to the server if its replica is unreachable
+		if (!j_connection_pool_exchange(J_BACKEND_TYPE_KV, read_index, message, reply)
+		    && (read_index == index || !j_connection_pool_exchange(J_BACKEND_TYPE_KV, index, message, reply)))
+		{
+			return FALSE;
+		}
+
+		iter = j_list_iterator_new(operations);
+
+		while (j_list_iterator_next(iter))
+		{
+			JKVOperation* kop = j_list_iterator_get(iter);
+			guint32 len;
+
+			len = j_message_get_4(reply);
+			ret = (len > 0) && ret;
+
+			if (len > 0)
+			{
+				gconstpointer data;
+
+				data = j_message_get_n(reply, len);
+
+				if (kop->get.func != NULL)
+				{
+					gpointer value;
+
+					// data belongs to the message, create a copy for the callback
+#if GLIB_CHECK_VERSION(2, 68, 0)
+					value = g_memdup2(data, len);
+#else
+					value = g_memdup(data, len);
+#endif
+					kop->get.func(value, len, kop->get.data);
+				}
+				else
+				{
+#if GLIB_CHECK_VERSION(2, 68, 0)
+					*(kop->get.value) = g_memdup2(data, len);
+#else
+					*(kop->get.value) = g_memdup(data, len);
+#endif
+					*(kop->get.value_len) = len;
+				}
+			}
+		}
+	}
+	else if (!ret && j_semantics_get(semantics, J_SEMANTICS_ATOMICITY) == J_SEMANTICS_ATOMICITY_BATCH)
+	{
+		j_backend_kv_batch_abort(kv_backend, kv_batch);
+	}
+	else
+	{
+		ret = j_backend_kv_batch_execute(kv_backend, kv_batch) && ret;
+	}
+
+	return ret;
+}
+
+static gboolean
+j_kv_compare_and_swap_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* kv_backend;
+	g_autoptr(JListIterator) it = NULL;
+	g_autoptr(JMessage) message = NULL;
+	gchar const* namespace;
+	gpointer kv_batch = NULL;
+	gsize namespace_len;
+	guint32 index;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JKVOperation* kop;
+
+		kop = j_list_get_first(operations);
+		g_assert(kop != NULL);
+
+		namespace = kop->compare_and_swap.kv->namespace;
+		namespace_len = strlen(namespace) + 1;
+		index = kop->compare_and_swap.kv->index;
+	}
+
+	it = j_list_iterator_new(operations);
+	kv_backend = j_kv_get_backend(namespace);
+
+	if (kv_backend == NULL)
+	{
+		// The server always replies, as the result is needed regardless of the safety semantics.
+		message = j_message_new(J_MESSAGE_KV_COMPARE_AND_SWAP, namespace_len);
+		j_message_set_semantics(message, semantics);
+		j_message_append_n(message, namespace, namespace_len);
+	}
+	else
+	{
+		ret = j_backend_kv_batch_start(kv_backend, namespace, semantics, &kv_batch);
+	}
+
+	while (j_list_iterator_next(it))
+	{
+		JKVOperation* kop = j_list_iterator_get(it);
+
+		if (kv_backend == NULL)
+		{
+			gsize key_len;
+			guint32 expected_len;
+
+			key_len = strlen(kop->compare_and_swap.kv->key) + 1;
+
+			// A length of G_MAXUINT32 signals that the key must not exist.
+			expected_len = (kop->compare_and_swap.expected != NULL) ? kop->compare_and_swap.expected_len : G_MAXUINT32;
+
+			j_message_add_operation(message, key_len + 4 + kop->compare_and_swap.expected_len + 4 + kop->compare_and_swap.value_len);
+			j_message_append_n(message, kop->compare_and_swap.kv->key, key_len);
+			j_message_append_4(message, &expected_len);
+
+			if (kop->compare_and_swap.expected != NULL)
+			{
+				j_message_append_n(message, kop->compare_and_swap.expected, kop->compare_and_swap.expected_len);
+			}
+
+			j_message_append_4(message, &(kop->compare_and_swap.value_len));
+			j_message_append_n(message, kop->compare_and_swap.value, kop->compare_and_swap.value_len);
+
+			j_kv_bloom_filter_add(kop->compare_and_swap.kv);
+		}
+		else
+		{
+			gboolean swapped = FALSE;
+
+			ret = j_backend_kv_compare_and_swap(kv_backend, kv_batch, kop->compare_and_swap.kv->key, kop->compare_and_swap.expected, kop->compare_and_swap.expected_len, kop->compare_and_swap.value, kop->compare_and_swap.value_len, &swapped) && ret;
+
+			if (kop->compare_and_swap.swapped != NULL)
+			{
+				*(kop->compare_and_swap.swapped) = swapped;
+			}
+		}
+	}
+
+	if (kv_backend == NULL)
+	{
+		g_autoptr(JListIterator) iter = NULL;
+		g_autoptr(JMessage) reply = NULL;
+		gpointer kv_connection;
+
+		kv_connection = j_connection_pool_pop(J_BACKEND_TYPE_KV, index);
+		j_message_send(message, kv_connection);
+
+		reply = j_message_new_reply(message);
+
+		if (!j_message_receive(reply, kv_connection))
+		{
+			ret = FALSE;
+		}
+		else
+		{
+			iter = j_list_iterator_new(operations);
+
+			while (j_list_iterator_next(iter))
+			{
+				JKVOperation* kop = j_list_iterator_get(iter);
+				gboolean swapped;
+
+				ret = (j_message_get_4(reply) != 0) && ret;
+				swapped = (j_message_get_4(reply) != 0);
+
+				if (kop->compare_and_swap.swapped != NULL)
+				{
+					*(kop->compare_and_swap.swapped) = swapped;
+				}
+			}
+		}
+
+		j_connection_pool_push(J_BACKEND_TYPE_KV, index, kv_connection);
+	}
+	else if (!ret && j_semantics_get(semantics, J_SEMANTICS_ATOMICITY) == J_SEMANTICS_ATOMICITY_BATCH)
+	{
+		j_backend_kv_batch_abort(kv_backend, kv_batch);
+	}
+	else
+	{
+		ret = j_backend_kv_batch_execute(kv_backend, kv_batch) && ret;
+	}
+
+	return ret;
+}
+
+static gboolean
+j_kv_add_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* kv_backend;
+	g_autoptr(JListIterator) it = NULL;
+	g_autoptr(JMessage) message = NULL;
+	gchar const* namespace;
+	gpointer kv_batch = NULL;
+	gsize namespace_len;
+	guint32 index;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JKVOperation* kop;
+
+		kop = j_list_get_first(operations);
+		g_assert(kop != NULL);
+
+		namespace = kop->add.kv->namespace;
+		namespace_len = strlen(namespace) + 1;
+		index = kop->add.kv->index;
+	}
+
+	it = j_list_iterator_new(operations);
+	kv_backend = j_kv_get_backend(namespace);
+
+	if (kv_backend == NULL)
+	{
+		// The server always replies, as the result is needed regardless of the safety semantics.
+		message = j_message_new(J_MESSAGE_KV_ADD, namespace_len);
+		j_message_set_semantics(message, semantics);
+		j_message_append_n(message, namespace, namespace_len);
+	}
+	else
+	{
+		ret = j_backend_kv_batch_start(kv_backend, namespace, semantics, &kv_batch);
+	}
+
+	while (j_list_iterator_next(it))
+	{
+		JKVOperation* kop = j_list_iterator_get(it);
+
+		if (kv_backend == NULL)
+		{
+			gsize key_len;
+
+			key_len = strlen(kop->add.kv->key) + 1;
+
+			j_message_add_operation(message, key_len + 8);
+			j_message_append_n(message, kop->add.kv->key, key_len);
+			j_message_append_8(message, &(kop->add.delta));
+
+			j_kv_bloom_filter_add(kop->add.kv);
+		}
+		else
+		{
+			ret = j_backend_kv_add(kv_backend, kv_batch, kop->add.kv->key, kop->add.delta, kop->add.result) && ret;
+		}
+	}
+
+	if (kv_backend == NULL)
+	{
+		g_autoptr(JListIterator) iter = NULL;
+		g_autoptr(JMessage) reply = NULL;
+		gpointer kv_connection;
+
+		kv_connection = j_connection_pool_pop(J_BACKEND_TYPE_KV, index);
+		j_message_send(message, kv_connection);
+
+		reply = j_message_new_reply(message);
+
+		if (!j_message_receive(reply, kv_connection))
 		{
-			g_autoptr(JMessage) reply = NULL;
+			ret = FALSE;
+		}
+		else
+		{
+			iter = j_list_iterator_new(operations);
 
-			reply = j_message_new_reply(message);
-			j_message_receive(reply, kv_connection);
+			while (j_list_iterator_next(iter))
+			{
+				JKVOperation* kop = j_list_iterator_get(iter);
+				gboolean op_ret;
+				gint64 result;
 
-			/* FIXME do something with reply */
+				op_ret = (j_message_get_4(reply) != 0);
+				result = j_message_get_8(reply);
+				ret = op_ret && ret;
+
+				if (op_ret && kop->add.result != NULL)
+				{
+					*(kop->add.result) = result;
+				}
+			}
 		}
 
 		j_connection_pool_push(J_BACKEND_TYPE_KV, index, kv_connection);
 	}
+	else if (!ret && j_semantics_get(semantics, J_SEMANTICS_ATOMICITY) == J_SEMANTICS_ATOMICITY_BATCH)
+	{
+		j_backend_kv_batch_abort(kv_backend, kv_batch);
+	}
 	else
 	{
 		ret = j_backend_kv_batch_execute(kv_backend, kv_batch) && ret;
@@ -380,149 +1367,144 @@ j_kv_delete_exec(JList* operations, JSemantics* semantics)
 	return ret;
 }
 
+/**
+ * Deletes all key-value pairs whose keys start with a prefix using a local backend.
+ *
+ * \private
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
 static gboolean
-j_kv_get_exec(JList* operations, JSemantics* semantics)
+j_kv_delete_prefix_local(JBackend* kv_backend, JSemantics* semantics, gchar const* namespace, gchar const* prefix, guint64* deleted)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	gboolean ret = TRUE;
 
-	JBackend* kv_backend;
-	g_autoptr(JListIterator) it = NULL;
-	g_autoptr(JMessage) message = NULL;
-	gchar const* namespace;
+	g_autoptr(GPtrArray) keys = NULL;
 	gpointer kv_batch = NULL;
-	gsize namespace_len;
-	guint32 index;
+	gpointer iterator;
+	gchar const* key;
+	gconstpointer value;
+	guint32 len;
 
-	g_return_val_if_fail(operations != NULL, FALSE);
-	g_return_val_if_fail(semantics != NULL, FALSE);
+	keys = g_ptr_array_new_with_free_func(g_free);
 
+	// The keys are collected first, since deleting them would invalidate the iterator.
+	if (j_backend_kv_get_by_prefix(kv_backend, namespace, prefix, &iterator))
 	{
-		JKVOperation* kop;
+		while (j_backend_kv_iterate(kv_backend, iterator, &key, &value, &len))
+		{
+			g_ptr_array_add(keys, g_strdup(key));
+		}
+	}
 
-		kop = j_list_get_first(operations);
-		g_assert(kop != NULL);
+	*deleted = 0;
 
-		namespace = kop->get.kv->namespace;
-		namespace_len = strlen(namespace) + 1;
-		index = kop->get.kv->index;
+	if (keys->len == 0)
+	{
+		return TRUE;
 	}
 
-	it = j_list_iterator_new(operations);
-	kv_backend = j_kv_get_backend();
-
-	if (kv_backend == NULL)
+	if (!j_backend_kv_batch_start(kv_backend, namespace, semantics, &kv_batch))
 	{
-		/**
-		 * Force safe semantics to make the server send a reply.
-		 * Otherwise, nasty races can occur when using unsafe semantics:
-		 * - The client creates the item and sends its first write.
-		 * - The client sends another operation using another connection from the pool.
-		 * - The second operation is executed first and fails because the item does not exist.
-		 * This does not completely eliminate all races but fixes the common case of create, write, write, ...
-		 **/
-		message = j_message_new(J_MESSAGE_KV_GET, namespace_len);
-		j_message_set_semantics(message, semantics);
-		j_message_append_n(message, namespace, namespace_len);
+		return FALSE;
 	}
-	else
+
+	for (guint i = 0; i < keys->len; i++)
 	{
-		ret = j_backend_kv_batch_start(kv_backend, namespace, semantics, &kv_batch);
+		ret = j_backend_kv_delete(kv_backend, kv_batch, g_ptr_array_index(keys, i)) && ret;
 	}
 
-	while (j_list_iterator_next(it))
+	ret = j_backend_kv_batch_execute(kv_backend, kv_batch) && ret;
+
+	if (ret)
 	{
-		JKVOperation* kop = j_list_iterator_get(it);
+		*deleted = keys->len;
+	}
 
-		if (kv_backend == NULL)
-		{
-			gsize key_len;
+	return ret;
+}
 
-			key_len = strlen(kop->get.kv->key) + 1;
+static gboolean
+j_kv_delete_prefix_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
 
-			j_message_add_operation(message, key_len);
-			j_message_append_n(message, kop->get.kv->key, key_len);
-		}
-		else
-		{
-			if (kop->get.func != NULL)
-			{
-				gpointer value;
-				guint32 len;
+	gboolean ret = TRUE;
 
-				ret = j_backend_kv_get(kv_backend, kv_batch, kop->get.kv->key, &value, &len) && ret;
+	g_autoptr(JListIterator) it = NULL;
+	guint32 server_count;
 
-				if (ret)
-				{
-					// j_backend_kv_get returns a new copy, pass it along
-					kop->get.func(value, len, kop->get.data);
-				}
-			}
-			else
-			{
-				ret = j_backend_kv_get(kv_backend, kv_batch, kop->get.kv->key, kop->get.value, kop->get.value_len) && ret;
-			}
-		}
-	}
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
 
-	if (kv_backend == NULL)
+	it = j_list_iterator_new(operations);
+	server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_KV);
+
+	while (j_list_iterator_next(it))
 	{
-		g_autoptr(JListIterator) iter = NULL;
-		g_autoptr(JMessage) reply = NULL;
-		gpointer kv_connection;
+		JKVOperation* kop = j_list_iterator_get(it);
+		JBackend* kv_backend;
+		gchar const* namespace = kop->delete_prefix.namespace;
+		gchar const* prefix = kop->delete_prefix.prefix;
+		guint64 count = 0;
 
-		kv_connection = j_connection_pool_pop(J_BACKEND_TYPE_KV, index);
-		j_message_send(message, kv_connection);
+		kv_backend = j_kv_get_backend(namespace);
 
-		reply = j_message_new_reply(message);
-		j_message_receive(reply, kv_connection);
+		if (kv_backend == NULL)
+		{
+			g_autofree JMessage** messages = NULL;
+			g_autofree gpointer* connections = NULL;
+			gsize namespace_len;
+			gsize prefix_len;
 
-		iter = j_list_iterator_new(operations);
+			namespace_len = strlen(namespace) + 1;
+			prefix_len = strlen(prefix) + 1;
 
-		while (j_list_iterator_next(iter))
-		{
-			JKVOperation* kop = j_list_iterator_get(iter);
-			guint32 len;
+			messages = g_new(JMessage*, server_count);
+			connections = g_new(gpointer, server_count);
 
-			len = j_message_get_4(reply);
-			ret = (len > 0) && ret;
+			// Keys are distributed over all servers, which delete their parts concurrently.
+			for (guint i = 0; i < server_count; i++)
+			{
+				messages[i] = j_message_new(J_MESSAGE_KV_DELETE_PREFIX, namespace_len + prefix_len);
+				j_message_set_semantics(messages[i], semantics);
+				j_message_append_n(messages[i], namespace, namespace_len);
+				j_message_append_n(messages[i], prefix, prefix_len);
 
-			if (len > 0)
+				connections[i] = j_connection_pool_pop(J_BACKEND_TYPE_KV, i);
+				j_message_send(messages[i], connections[i]);
+			}
+
+			for (guint i = 0; i < server_count; i++)
 			{
-				gconstpointer data;
+				g_autoptr(JMessage) reply = NULL;
 
-				data = j_message_get_n(reply, len);
+				reply = j_message_new_reply(messages[i]);
 
-				if (kop->get.func != NULL)
+				if (j_message_receive(reply, connections[i]))
 				{
-					gpointer value;
-
-					// data belongs to the message, create a copy for the callback
-#if GLIB_CHECK_VERSION(2, 68, 0)
-					value = g_memdup2(data, len);
-#else
-					value = g_memdup(data, len);
-#endif
-					kop->get.func(value, len, kop->get.data);
+					count += j_message_get_8(reply);
 				}
 				else
 				{
-#if GLIB_CHECK_VERSION(2, 68, 0)
-					*(kop->get.value) = g_memdup2(data, len);
-#else
-					*(kop->get.value) = g_memdup(data, len);
-#endif
-					*(kop->get.value_len) = len;
+					ret = FALSE;
 				}
+
+				j_connection_pool_push(J_BACKEND_TYPE_KV, i, connections[i]);
+				j_message_unref(messages[i]);
 			}
 		}
+		else
+		{
+			ret = j_kv_delete_prefix_local(kv_backend, semantics, namespace, prefix, &count) && ret;
+		}
 
-		j_connection_pool_push(J_BACKEND_TYPE_KV, index, kv_connection);
-	}
-	else
-	{
-		ret = j_backend_kv_batch_execute(kv_backend, kv_batch) && ret;
+		if (kop->delete_prefix.deleted != NULL)
+		{
+			*(kop->delete_prefix.deleted) = count;
+		}
 	}
 
 	return ret;
@@ -554,7 +1536,7 @@ j_kv_new(gchar const* namespace, gchar const* key)
 	g_return_val_if_fail(key != NULL, NULL);
 
 	kv = g_slice_new(JKV);
-	kv->index = j_helper_hash(key) % j_configuration_get_server_count(configuration, J_BACKEND_TYPE_KV);
+	kv->index = j_configuration_get_server_for_key(configuration, J_BACKEND_TYPE_KV, key);
 	kv->namespace = g_strdup(namespace);
 	kv->key = g_strdup(key);
 	kv->ref_count = 1;
@@ -597,6 +1579,39 @@ j_kv_new_for_index(guint32 index, gchar const* namespace, gchar const* key)
 	return kv;
 }
 
+/**
+ * Creates a new key-value pair on a server in the client's locality domain.
+ * This is useful for node-local scratch data that is mostly accessed by the same client.
+ * The key is hashed across the local servers only, so other clients have to use
+ * the same locality to find the pair.
+ *
+ * \code
+ * JKV* kv;
+ *
+ * kv = j_kv_new_local("JULEA", "scratch");
+ * \endcode
+ *
+ * \param namespace A namespace.
+ * \param key       A key.
+ *
+ * \return A new key-value pair. Should be freed with j_kv_unref().
+ **/
+JKV*
+j_kv_new_local(gchar const* namespace, gchar const* key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConfiguration* configuration = j_configuration();
+	guint32 local_count;
+
+	g_return_val_if_fail(namespace != NULL, NULL);
+	g_return_val_if_fail(key != NULL, NULL);
+
+	local_count = j_configuration_get_local_server_count(configuration, J_BACKEND_TYPE_KV);
+
+	return j_kv_new_for_index(j_configuration_get_local_server(configuration, J_BACKEND_TYPE_KV, j_helper_hash(key) % local_count), namespace, key);
+}
+
 /**
  * Increases a key-value pair's reference count.
  *
@@ -662,23 +1677,48 @@ j_kv_put(JKV* kv, gpointer value, guint32 value_len, GDestroyNotify value_destro
 {
 	J_TRACE_FUNCTION(NULL);
 
+	j_kv_put_expiring(kv, value, value_len, value_destroy, 0, batch);
+}
+
+/**
+ * Creates a key-value pair that expires after a given time.
+ * Expired keys are reclaimed by the server in the background, so they can remain visible for a few seconds after expiring.
+ * Putting the key again replaces its TTL, a plain j_kv_put() makes it persistent again.
+ * TTLs are ignored if the client uses the backend directly.
+ *
+ * \code
+ * \endcode
+ *
+ * \param kv    A KV.
+ * \param value A value.
+ * \param ttl   The time to live in microseconds, 0 if the key does not expire.
+ * \param batch A batch.
+ **/
+void
+j_kv_put_expiring(JKV* kv, gpointer value, guint32 value_len, GDestroyNotify value_destroy, GTimeSpan ttl, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
 	JKVOperation* kop;
 	JOperation* operation;
 
 	g_return_if_fail(kv != NULL);
+	g_return_if_fail(ttl >= 0);
 
-	kop = g_slice_new(JKVOperation);
+	operation = j_operation_new_with_data(sizeof(JKVOperation));
+	kop = operation->data;
 	kop->put.kv = j_kv_ref(kv);
 	kop->put.value = value;
 	kop->put.value_len = value_len;
 	kop->put.value_destroy = value_destroy;
+	kop->put.ttl = ttl;
 
-	operation = j_operation_new();
 	// FIXME key = index + namespace
 	operation->key = kv;
-	operation->data = kop;
 	operation->exec_func = j_kv_put_exec;
 	operation->free_func = j_kv_put_free;
+	operation->cache_func = j_kv_put_cache;
+	operation->coalesce_func = j_kv_put_coalesce;
 
 	j_batch_add(batch, operation);
 }
@@ -706,6 +1746,45 @@ j_kv_delete(JKV* kv, JBatch* batch)
 	operation->data = j_kv_ref(kv);
 	operation->exec_func = j_kv_delete_exec;
 	operation->free_func = j_kv_delete_free;
+	operation->cache_func = j_kv_delete_cache;
+	operation->coalesce_func = j_kv_delete_coalesce;
+
+	j_batch_add(batch, operation);
+}
+
+/**
+ * Deletes all key-value pairs of a namespace whose keys start with a prefix.
+ * Each server deletes its pairs within one backend batch, so that the keys do not have to be listed first.
+ *
+ * \code
+ * \endcode
+ *
+ * \param namespace A namespace.
+ * \param prefix    A prefix.
+ * \param deleted   Returns the number of deleted pairs, can be NULL.
+ * \param batch     A batch.
+ **/
+void
+j_kv_delete_prefix(gchar const* namespace, gchar const* prefix, guint64* deleted, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVOperation* kop;
+	JOperation* operation;
+
+	g_return_if_fail(namespace != NULL);
+	g_return_if_fail(prefix != NULL);
+
+	operation = j_operation_new_with_data(sizeof(JKVOperation));
+	kop = operation->data;
+	kop->delete_prefix.namespace = g_strdup(namespace);
+	kop->delete_prefix.prefix = g_strdup(prefix);
+	kop->delete_prefix.deleted = deleted;
+
+	// The operation affects many pairs and therefore acts as a barrier.
+	operation->key = NULL;
+	operation->exec_func = j_kv_delete_prefix_exec;
+	operation->free_func = j_kv_delete_prefix_free;
 
 	j_batch_add(batch, operation);
 }
@@ -729,16 +1808,15 @@ j_kv_get(JKV* kv, gpointer* value, guint32* value_len, JBatch* batch)
 
 	g_return_if_fail(kv != NULL);
 
-	kop = g_slice_new(JKVOperation);
+	operation = j_operation_new_with_data(sizeof(JKVOperation));
+	kop = operation->data;
 	kop->get.kv = j_kv_ref(kv);
 	kop->get.value = value;
 	kop->get.value_len = value_len;
 	kop->get.func = NULL;
 	kop->get.data = NULL;
 
-	operation = j_operation_new();
 	operation->key = kv;
-	operation->data = kop;
 	operation->exec_func = j_kv_get_exec;
 	operation->free_func = j_kv_get_free;
 
@@ -765,16 +1843,15 @@ j_kv_get_callback(JKV* kv, JKVGetFunc func, gpointer data, JBatch* batch)
 	g_return_if_fail(kv != NULL);
 	g_return_if_fail(func != NULL);
 
-	kop = g_slice_new(JKVOperation);
+	operation = j_operation_new_with_data(sizeof(JKVOperation));
+	kop = operation->data;
 	kop->get.kv = j_kv_ref(kv);
 	kop->get.value = NULL;
 	kop->get.value_len = NULL;
 	kop->get.func = func;
 	kop->get.data = data;
 
-	operation = j_operation_new();
 	operation->key = kv;
-	operation->data = kop;
 	operation->exec_func = j_kv_get_exec;
 	operation->free_func = j_kv_get_free;
 
@@ -782,13 +1859,117 @@ j_kv_get_callback(JKV* kv, JKVGetFunc func, gpointer data, JBatch* batch)
 }
 
 /**
- * Returns the kv backend.
+ * Replaces a key-value pair's value if it currently matches the expected value.
+ * The comparison and the update are performed by the server in a single round trip.
+ *
+ * \code
+ * gboolean swapped;
+ *
+ * j_kv_compare_and_swap(kv, old_value, old_len, new_value, new_len, g_free, &swapped, batch);
+ * j_batch_execute(batch);
+ * \endcode
+ *
+ * \param kv            A key-value pair.
+ * \param expected      The expected value, NULL if the key must not exist yet.
+ * \param expected_len  The expected value's length.
+ * \param value         The new value.
+ * \param value_len     The new value's length.
+ * \param value_destroy A function to free the new value, may be NULL.
+ * \param swapped       Returns whether the value has been replaced, may be NULL.
+ * \param batch         A batch.
+ **/
+void
+j_kv_compare_and_swap(JKV* kv, gconstpointer expected, guint32 expected_len, gpointer value, guint32 value_len, GDestroyNotify value_destroy, gboolean* swapped, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVOperation* kop;
+	JOperation* operation;
+
+	g_return_if_fail(kv != NULL);
+	g_return_if_fail(value != NULL);
+
+	operation = j_operation_new_with_data(sizeof(JKVOperation));
+	kop = operation->data;
+	kop->compare_and_swap.kv = j_kv_ref(kv);
+	// The expected value is copied, as the caller may reuse it before the batch is executed.
+#if GLIB_CHECK_VERSION(2, 68, 0)
+	kop->compare_and_swap.expected = (expected != NULL) ? g_memdup2(expected, expected_len) : NULL;
+#else
+	kop->compare_and_swap.expected = (expected != NULL) ? g_memdup(expected, expected_len) : NULL;
+#endif
+	kop->compare_and_swap.expected_len = (expected != NULL) ? expected_len : 0;
+	kop->compare_and_swap.value = value;
+	kop->compare_and_swap.value_len = value_len;
+	kop->compare_and_swap.value_destroy = value_destroy;
+	kop->compare_and_swap.swapped = swapped;
+
+	operation->key = kv;
+	operation->exec_func = j_kv_compare_and_swap_exec;
+	operation->free_func = j_kv_compare_and_swap_free;
+
+	j_batch_add(batch, operation);
+}
+
+/**
+ * Atomically adds to a counter stored in a key-value pair.
+ * The counter is stored as a 64-bit little-endian integer, a missing key counts as 0.
+ *
+ * \code
+ * gint64 result;
+ *
+ * j_kv_add(kv, 1, &result, batch);
+ * j_batch_execute(batch);
+ * \endcode
+ *
+ * \param kv     A key-value pair.
+ * \param delta  The value to add.
+ * \param result Returns the counter's new value, may be NULL.
+ * \param batch  A batch.
+ **/
+void
+j_kv_add(JKV* kv, gint64 delta, gint64* result, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVOperation* kop;
+	JOperation* operation;
+
+	g_return_if_fail(kv != NULL);
+
+	operation = j_operation_new_with_data(sizeof(JKVOperation));
+	kop = operation->data;
+	kop->add.kv = j_kv_ref(kv);
+	kop->add.delta = delta;
+	kop->add.result = result;
+
+	operation->key = kv;
+	operation->exec_func = j_kv_add_exec;
+	operation->free_func = j_kv_add_free;
+
+	j_batch_add(batch, operation);
+}
+
+/**
+ * Returns the kv backend responsible for a namespace.
+ * Node-local namespaces are handled by a backend within the client library, so operations on them do not involve a server.
  *
- * \return The kv backend.
+ * \param namespace A namespace.
+ *
+ * \return The kv backend, NULL if the namespace is handled by the servers.
  */
 JBackend*
-j_kv_get_backend(void)
+j_kv_get_backend(gchar const* namespace)
 {
+	static GOnce once = G_ONCE_INIT;
+
+	g_once(&once, j_kv_init, NULL);
+
+	if (j_kv_local_backend != NULL && namespace != NULL && j_configuration_is_local_namespace(j_configuration(), J_BACKEND_TYPE_KV, namespace))
+	{
+		return j_kv_local_backend;
+	}
+
 	return j_kv_backend;
 }
 
@@ -0,0 +1,669 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <object/jblock-cache-internal.h>
+
+#include <julea.h>
+
+/**
+ * \defgroup JBlockCache Block Cache
+ *
+ * A client-side cache for blocks of objects and distributed objects.
+ *
+ * Blocks have the configured stripe size and are evicted in least recently used order.
+ * Short blocks mark the end of an object.
+ *
+ * @{
+ **/
+
+/**
+ * The maximum number of blocks a read may span to be cached.
+ * Larger reads are passed through to avoid evicting the hot blocks the cache is meant for.
+ **/
+#define J_BLOCK_CACHE_MAX_READ_BLOCKS 16
+
+struct JBlockCacheKey
+{
+	guint32 index;
+	gchar const* namespace;
+	gchar const* name;
+	guint64 block;
+};
+
+typedef struct JBlockCacheKey JBlockCacheKey;
+
+struct JBlockCacheEntry
+{
+	JBlockCacheKey key;
+
+	/**
+	 * The key's strings.
+	 **/
+	gchar* namespace;
+	gchar* name;
+
+	guint8* data;
+	guint64 length;
+
+	/**
+	 * The entry's link in the LRU queue.
+	 **/
+	GList link;
+};
+
+typedef struct JBlockCacheEntry JBlockCacheEntry;
+
+struct JBlockCache
+{
+	GMutex mutex[1];
+
+	/**
+	 * Maps #JBlockCacheKey elements to #JBlockCacheEntry elements.
+	 **/
+	GHashTable* entries;
+
+	/**
+	 * The entries, most recently used first.
+	 **/
+	GQueue lru[1];
+
+	guint64 block_size;
+	guint max_entries;
+
+	/**
+	 * Incremented by invalidations, so that blocks fetched concurrently are not inserted.
+	 **/
+	guint64 generation;
+};
+
+/**
+ * A read that could not be served from the cache.
+ **/
+struct JBlockCacheMiss
+{
+	JBlockCacheRead* read;
+
+	/**
+	 * The block-aligned buffer, NULL if the read is passed through.
+	 **/
+	guint8* buffer;
+	guint64 offset;
+	guint64 nbytes;
+};
+
+typedef struct JBlockCacheMiss JBlockCacheMiss;
+
+static JBlockCache* j_block_cache = NULL;
+
+static guint
+j_block_cache_key_hash(gconstpointer data)
+{
+	JBlockCacheKey const* key = data;
+
+	return g_str_hash(key->name) ^ (g_str_hash(key->namespace) * 31) ^ g_int64_hash(&(key->block)) ^ key->index;
+}
+
+static gboolean
+j_block_cache_key_equal(gconstpointer a, gconstpointer b)
+{
+	JBlockCacheKey const* key_a = a;
+	JBlockCacheKey const* key_b = b;
+
+	return key_a->index == key_b->index
+	       && key_a->block == key_b->block
+	       && g_strcmp0(key_a->name, key_b->name) == 0
+	       && g_strcmp0(key_a->namespace, key_b->namespace) == 0;
+}
+
+static void
+j_block_cache_entry_free(gpointer data)
+{
+	JBlockCacheEntry* entry = data;
+
+	g_free(entry->namespace);
+	g_free(entry->name);
+	g_free(entry->data);
+
+	g_slice_free(JBlockCacheEntry, entry);
+}
+
+/**
+ * Removes an entry, the cache has to be locked.
+ **/
+static void
+j_block_cache_remove(JBlockCache* cache, JBlockCacheEntry* entry)
+{
+	g_queue_unlink(cache->lru, &(entry->link));
+	g_hash_table_remove(cache->entries, &(entry->key));
+}
+
+/**
+ * Inserts a block, the cache has to be locked.
+ **/
+static void
+j_block_cache_insert(JBlockCache* cache, guint32 index, gchar const* namespace, gchar const* name, guint64 block, guint8 const* data, guint64 length)
+{
+	JBlockCacheEntry* entry;
+	JBlockCacheKey key;
+
+	key.index = index;
+	key.namespace = namespace;
+	key.name = name;
+	key.block = block;
+
+	if ((entry = g_hash_table_lookup(cache->entries, &key)) != NULL)
+	{
+		g_queue_unlink(cache->lru, &(entry->link));
+	}
+	else
+	{
+		entry = g_slice_new(JBlockCacheEntry);
+		entry->namespace = g_strdup(namespace);
+		entry->name = g_strdup(name);
+		entry->key.index = index;
+		entry->key.namespace = entry->namespace;
+		entry->key.name = entry->name;
+		entry->key.block = block;
+		entry->data = g_malloc(cache->block_size);
+		entry->link.data = entry;
+		entry->link.prev = NULL;
+		entry->link.next = NULL;
+
+		g_hash_table_insert(cache->entries, &(entry->key), entry);
+	}
+
+	memcpy(entry->data, data, length);
+	entry->length = length;
+
+	g_queue_push_head_link(cache->lru, &(entry->link));
+
+	while (cache->lru->length > cache->max_entries)
+	{
+		j_block_cache_remove(cache, g_queue_peek_tail(cache->lru));
+	}
+}
+
+/**
+ * Serves a read from the cache.
+ *
+ * \return TRUE if all necessary blocks are cached, FALSE otherwise.
+ **/
+static gboolean
+j_block_cache_lookup(JBlockCache* cache, guint32 index, gchar const* namespace, gchar const* name, JBlockCacheRead* read, guint64* nbytes)
+{
+	JBlockCacheKey key;
+	guint64 end = read->offset + read->length;
+	guint64 position = read->offset;
+
+	key.index = index;
+	key.namespace = namespace;
+	key.name = name;
+
+	*nbytes = 0;
+
+	while (position < end)
+	{
+		JBlockCacheEntry* entry;
+		guint64 block_offset;
+		guint64 chunk;
+
+		key.block = position / cache->block_size;
+		block_offset = position % cache->block_size;
+
+		if ((entry = g_hash_table_lookup(cache->entries, &key)) == NULL)
+		{
+			return FALSE;
+		}
+
+		g_queue_unlink(cache->lru, &(entry->link));
+		g_queue_push_head_link(cache->lru, &(entry->link));
+
+		chunk = MIN(end, (key.block + 1) * cache->block_size) - position;
+
+		if (entry->length <= block_offset)
+		{
+			// The object ends before the read's position
+			break;
+		}
+
+		chunk = MIN(chunk, entry->length - block_offset);
+		memcpy((gchar*)read->data + (position - read->offset), entry->data + block_offset, chunk);
+
+		position += chunk;
+		*nbytes += chunk;
+
+		if (entry->length < cache->block_size)
+		{
+			break;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Returns the block cache.
+ *
+ * \private
+ *
+ * \param semantics A semantics object, can be NULL.
+ *
+ * \return The block cache, NULL if it is disabled or #semantics requires immediate consistency.
+ **/
+JBlockCache*
+j_block_cache_get(JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	static gsize initialized = 0;
+
+	if (g_once_init_enter(&initialized))
+	{
+		JConfiguration* configuration = j_configuration();
+		guint64 size;
+		guint64 block_size;
+
+		size = j_configuration_get_block_cache_size(configuration);
+		block_size = j_configuration_get_stripe_size(configuration);
+
+		if (block_size > 0 && size / block_size > 0)
+		{
+			j_block_cache = g_slice_new(JBlockCache);
+			g_mutex_init(j_block_cache->mutex);
+			j_block_cache->entries = g_hash_table_new_full(j_block_cache_key_hash, j_block_cache_key_equal, NULL, j_block_cache_entry_free);
+			g_queue_init(j_block_cache->lru);
+			j_block_cache->block_size = block_size;
+			j_block_cache->max_entries = MIN(size / block_size, G_MAXUINT);
+			j_block_cache->generation = 0;
+		}
+
+		g_once_init_leave(&initialized, 1);
+	}
+
+	if (j_block_cache == NULL)
+	{
+		return NULL;
+	}
+
+	if (semantics != NULL && j_semantics_get(semantics, J_SEMANTICS_CONSISTENCY) == J_SEMANTICS_CONSISTENCY_IMMEDIATE)
+	{
+		return NULL;
+	}
+
+	return j_block_cache;
+}
+
+/**
+ * Executes reads using the cache.
+ * Reads that cannot be served from the cache are extended to whole blocks, fetched and inserted into the cache.
+ *
+ * \private
+ *
+ * \param cache     A block cache.
+ * \param index     The server index or #J_BLOCK_CACHE_DISTRIBUTED.
+ * \param namespace The namespace.
+ * \param name      The name.
+ * \param reads     The reads.
+ * \param count     The number of reads.
+ * \param fetch     A function to execute reads that could not be served.
+ * \param user_data User data for #fetch.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+j_block_cache_read(JBlockCache* cache, guint32 index, gchar const* namespace, gchar const* name, JBlockCacheRead* reads, guint count, JBlockCacheFetchFunc fetch, gpointer user_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree JBlockCacheMiss* misses = NULL;
+	g_autofree JBlockCacheRead* fetches = NULL;
+	guint64 generation;
+	guint miss_count = 0;
+	guint max_blocks;
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(cache != NULL, FALSE);
+	g_return_val_if_fail(reads != NULL, FALSE);
+	g_return_val_if_fail(fetch != NULL, FALSE);
+
+	misses = g_new(JBlockCacheMiss, count);
+	max_blocks = MIN(J_BLOCK_CACHE_MAX_READ_BLOCKS, MAX(1, cache->max_entries / 4));
+
+	g_mutex_lock(cache->mutex);
+
+	generation = cache->generation;
+
+	for (guint i = 0; i < count; i++)
+	{
+		JBlockCacheRead* read = &(reads[i]);
+		JBlockCacheMiss* miss;
+		guint64 first;
+		guint64 last;
+		guint64 nbytes;
+
+		if (read->length == 0)
+		{
+			continue;
+		}
+
+		if (j_block_cache_lookup(cache, index, namespace, name, read, &nbytes))
+		{
+			j_helper_atomic_add(read->bytes_read, nbytes);
+			continue;
+		}
+
+		first = read->offset / cache->block_size;
+		last = (read->offset + read->length - 1) / cache->block_size;
+
+		miss = &(misses[miss_count]);
+		miss->read = read;
+		miss->buffer = NULL;
+		miss->offset = first * cache->block_size;
+		miss->nbytes = 0;
+
+		if (last - first < max_blocks)
+		{
+			miss->buffer = g_malloc((last - first + 1) * cache->block_size);
+		}
+
+		miss_count++;
+	}
+
+	g_mutex_unlock(cache->mutex);
+
+	if (miss_count == 0)
+	{
+		return TRUE;
+	}
+
+	fetches = g_new(JBlockCacheRead, miss_count);
+
+	for (guint i = 0; i < miss_count; i++)
+	{
+		JBlockCacheMiss* miss = &(misses[i]);
+
+		if (miss->buffer != NULL)
+		{
+			guint64 blocks = (miss->read->offset + miss->read->length - miss->offset + cache->block_size - 1) / cache->block_size;
+
+			fetches[i].data = miss->buffer;
+			fetches[i].length = blocks * cache->block_size;
+			fetches[i].offset = miss->offset;
+			fetches[i].bytes_read = &(miss->nbytes);
+		}
+		else
+		{
+			fetches[i] = *(miss->read);
+		}
+	}
+
+	ret = fetch(fetches, miss_count, user_data);
+
+	g_mutex_lock(cache->mutex);
+
+	for (guint i = 0; i < miss_count; i++)
+	{
+		JBlockCacheMiss* miss = &(misses[i]);
+		guint64 end;
+		guint64 nbytes = 0;
+
+		if (miss->buffer == NULL)
+		{
+			continue;
+		}
+
+		// Blocks are only inserted if no invalidation happened in the meantime
+		if (ret && generation == cache->generation)
+		{
+			for (guint64 position = 0; position < fetches[i].length; position += cache->block_size)
+			{
+				guint64 length;
+
+				length = (miss->nbytes > position) ? MIN(cache->block_size, miss->nbytes - position) : 0;
+				j_block_cache_insert(cache, index, namespace, name, (miss->offset + position) / cache->block_size, miss->buffer + position, length);
+
+				if (length < cache->block_size)
+				{
+					break;
+				}
+			}
+		}
+
+		end = miss->offset + miss->nbytes;
+
+		if (end > miss->read->offset)
+		{
+			nbytes = MIN(miss->read->length, end - miss->read->offset);
+			memcpy(miss->read->data, miss->buffer + (miss->read->offset - miss->offset), nbytes);
+		}
+
+		j_helper_atomic_add(miss->read->bytes_read, nbytes);
+
+		g_free(miss->buffer);
+	}
+
+	g_mutex_unlock(cache->mutex);
+
+	return ret;
+}
+
+/**
+ * Reads a range of an object into the cache.
+ * At most half of the cache is filled, so that prefetching does not evict all other blocks.
+ *
+ * \private
+ *
+ * \param cache     A block cache.
+ * \param index     The server index or #J_BLOCK_CACHE_DISTRIBUTED.
+ * \param namespace The namespace.
+ * \param name      The name.
+ * \param length    The length of the range, 0 to prefetch until the end of the object.
+ * \param offset    The offset of the range.
+ * \param fetch     A function to execute reads that could not be served.
+ * \param user_data User data for #fetch.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+j_block_cache_prefetch(JBlockCache* cache, guint32 index, gchar const* namespace, gchar const* name, guint64 length, guint64 offset, JBlockCacheFetchFunc fetch, gpointer user_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBlockCacheRead reads[J_BLOCK_CACHE_MAX_READ_BLOCKS];
+	guint64 bytes_read[J_BLOCK_CACHE_MAX_READ_BLOCKS];
+	g_autofree guint8* buffer = NULL;
+	guint64 first;
+	guint64 last;
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(cache != NULL, FALSE);
+	g_return_val_if_fail(fetch != NULL, FALSE);
+
+	first = offset / cache->block_size;
+	last = (length == 0 || length > G_MAXUINT64 - offset) ? G_MAXUINT64 : (offset + length - 1) / cache->block_size;
+	last = MIN(last, first + MAX(1, cache->max_entries / 2) - 1);
+
+	buffer = g_malloc(J_BLOCK_CACHE_MAX_READ_BLOCKS * cache->block_size);
+
+	for (guint64 block = first; ret && block <= last;)
+	{
+		guint count;
+		gboolean end = FALSE;
+
+		count = MIN(last - block + 1, J_BLOCK_CACHE_MAX_READ_BLOCKS);
+
+		// Single blocks are always small enough to be cached
+		for (guint i = 0; i < count; i++)
+		{
+			bytes_read[i] = 0;
+
+			reads[i].data = buffer + i * cache->block_size;
+			reads[i].length = cache->block_size;
+			reads[i].offset = (block + i) * cache->block_size;
+			reads[i].bytes_read = &(bytes_read[i]);
+		}
+
+		ret = j_block_cache_read(cache, index, namespace, name, reads, count, fetch, user_data);
+
+		// A short block marks the end of the object
+		for (guint i = 0; i < count; i++)
+		{
+			end = end || (bytes_read[i] < cache->block_size);
+		}
+
+		if (end)
+		{
+			break;
+		}
+
+		block += count;
+	}
+
+	return ret;
+}
+
+/**
+ * Invalidates cached blocks of an object.
+ *
+ * \private
+ *
+ * \param cache     A block cache, can be NULL.
+ * \param index     The server index or #J_BLOCK_CACHE_DISTRIBUTED.
+ * \param namespace The namespace.
+ * \param name      The name.
+ * \param length    The length of the modified range, G_MAXUINT64 for the whole object.
+ * \param offset    The offset of the modified range.
+ **/
+void
+j_block_cache_invalidate(JBlockCache* cache, guint32 index, gchar const* namespace, gchar const* name, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 first;
+	guint64 last;
+
+	if (cache == NULL)
+	{
+		return;
+	}
+
+	first = offset / cache->block_size;
+	last = (length > G_MAXUINT64 - offset) ? G_MAXUINT64 : (offset + MAX(length, 1) - 1) / cache->block_size;
+
+	g_mutex_lock(cache->mutex);
+
+	cache->generation++;
+
+	if (last - first >= cache->lru->length)
+	{
+		GList* link = cache->lru->head;
+
+		while (link != NULL)
+		{
+			JBlockCacheEntry* entry = link->data;
+
+			link = link->next;
+
+			if (entry->key.index == index
+			    && entry->key.block >= first
+			    && entry->key.block <= last
+			    && g_strcmp0(entry->key.name, name) == 0
+			    && g_strcmp0(entry->key.namespace, namespace) == 0)
+			{
+				j_block_cache_remove(cache, entry);
+			}
+		}
+	}
+	else
+	{
+		JBlockCacheKey key;
+
+		key.index = index;
+		key.namespace = namespace;
+		key.name = name;
+
+		for (key.block = first; key.block <= last; key.block++)
+		{
+			JBlockCacheEntry* entry;
+
+			if ((entry = g_hash_table_lookup(cache->entries, &key)) != NULL)
+			{
+				j_block_cache_remove(cache, entry);
+			}
+		}
+	}
+
+	g_mutex_unlock(cache->mutex);
+}
+
+/**
+ * Invalidates cached blocks of all objects whose names start with a prefix.
+ *
+ * \private
+ *
+ * \param cache     A block cache, can be NULL.
+ * \param namespace The namespace.
+ * \param prefix    The prefix.
+ **/
+void
+j_block_cache_invalidate_prefix(JBlockCache* cache, gchar const* namespace, gchar const* prefix)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GList* link;
+
+	if (cache == NULL)
+	{
+		return;
+	}
+
+	g_mutex_lock(cache->mutex);
+
+	cache->generation++;
+
+	link = cache->lru->head;
+
+	while (link != NULL)
+	{
+		JBlockCacheEntry* entry = link->data;
+
+		link = link->next;
+
+		if (g_str_has_prefix(entry->key.name, prefix)
+		    && g_strcmp0(entry->key.namespace, namespace) == 0)
+		{
+			j_block_cache_remove(cache, entry);
+		}
+	}
+
+	g_mutex_unlock(cache->mutex);
+}
+
+/**
+ * @}
+ **/
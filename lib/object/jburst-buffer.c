@@ -0,0 +1,902 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <gmodule.h>
+
+#include <unistd.h>
+
+#include <object/jburst-buffer-internal.h>
+#include <object/jobject-internal.h>
+
+#include <julea.h>
+
+/**
+ * \defgroup JBurstBuffer Burst Buffer
+ *
+ * A node-local tier for writes with eventual persistency.
+ *
+ * Writes are stored using a node-local object backend and drained to the object servers by a background thread.
+ * This spreads bursts of writes over time, optionally limited to a configured bandwidth.
+ *
+ * @{
+ **/
+
+/**
+ * The maximum number of bytes drained at once, further limited by the maximum operation size.
+ **/
+#define J_BURST_BUFFER_DRAIN_SIZE (4 * 1024 * 1024)
+
+/**
+ * The number of seconds the drain thread pauses after data could not be drained.
+ **/
+#define J_BURST_BUFFER_RETRY_PAUSE 1
+
+struct JBurstBufferExtent
+{
+	guint64 offset;
+	guint64 length;
+};
+
+typedef struct JBurstBufferExtent JBurstBufferExtent;
+
+struct JBurstBufferEntry
+{
+	gchar* key;
+
+	JBurstBufferType const* type;
+	gpointer object;
+
+	/**
+	 * The node-local object holding the staged data.
+	 **/
+	gpointer handle;
+
+	/**
+	 * The extents that have not been drained yet, sorted by offset and merged.
+	 **/
+	GArray* extents;
+
+	/**
+	 * The number of threads using the node-local object.
+	 **/
+	guint users;
+
+	/**
+	 * Whether a thread is draining the entry.
+	 **/
+	gboolean draining;
+
+	/**
+	 * The extent being drained.
+	 **/
+	guint64 drain_offset;
+	guint64 drain_length;
+
+	/**
+	 * Whether the extent being drained has been written again in the meantime.
+	 **/
+	gboolean modified;
+
+	/**
+	 * The entry's link in the drain queue.
+	 **/
+	GList link;
+	gboolean queued;
+};
+
+typedef struct JBurstBufferEntry JBurstBufferEntry;
+
+struct JBurstBuffer
+{
+	GModule* module;
+	JBackend* backend;
+
+	/**
+	 * The node-local namespace, so that processes sharing a path do not interfere.
+	 **/
+	gchar* namespace;
+
+	GMutex mutex[1];
+	GCond cond[1];
+
+	/**
+	 * Maps keys to #JBurstBufferEntry elements.
+	 **/
+	GHashTable* entries;
+
+	/**
+	 * The entries with staged data, in the order they are drained.
+	 **/
+	GQueue queue[1];
+
+	/**
+	 * The capacity and the number of staged bytes.
+	 **/
+	guint64 size;
+	guint64 used;
+
+	/**
+	 * The drain bandwidth in bytes per second, 0 for no limit.
+	 **/
+	guint64 bandwidth;
+
+	/**
+	 * The maximum number of bytes drained at once.
+	 **/
+	guint64 drain_size;
+
+	GThread* thread;
+	gboolean stop;
+};
+
+static JBurstBuffer* j_burst_buffer = NULL;
+
+// FIXME copy and use GLib's G_DEFINE_CONSTRUCTOR/DESTRUCTOR
+static void __attribute__((destructor)) j_burst_buffer_fini(void);
+
+/**
+ * Adds an extent.
+ *
+ * \return The number of bytes that were not covered before.
+ **/
+static guint64
+j_burst_buffer_extents_add(GArray* extents, guint64 offset, guint64 length)
+{
+	JBurstBufferExtent extent;
+	guint64 end = offset + length;
+	guint64 merged_offset = offset;
+	guint64 merged_end = end;
+	guint64 covered = 0;
+	guint first;
+	guint i;
+
+	for (first = 0; first < extents->len; first++)
+	{
+		JBurstBufferExtent* other = &g_array_index(extents, JBurstBufferExtent, first);
+
+		if (other->offset + other->length >= offset)
+		{
+			break;
+		}
+	}
+
+	// Merge all overlapping and adjacent extents
+	for (i = first; i < extents->len; i++)
+	{
+		JBurstBufferExtent* other = &g_array_index(extents, JBurstBufferExtent, i);
+		guint64 other_end = other->offset + other->length;
+
+		if (other->offset > end)
+		{
+			break;
+		}
+
+		if (MIN(end, other_end) > MAX(offset, other->offset))
+		{
+			covered += MIN(end, other_end) - MAX(offset, other->offset);
+		}
+
+		merged_offset = MIN(merged_offset, other->offset);
+		merged_end = MAX(merged_end, other_end);
+	}
+
+	extent.offset = merged_offset;
+	extent.length = merged_end - merged_offset;
+
+	g_array_remove_range(extents, first, i - first);
+	g_array_insert_val(extents, first, extent);
+
+	return length - covered;
+}
+
+/**
+ * Removes an extent.
+ *
+ * \return The number of bytes that were covered before.
+ **/
+static guint64
+j_burst_buffer_extents_remove(GArray* extents, guint64 offset, guint64 length)
+{
+	guint64 end = offset + length;
+	guint64 removed = 0;
+	guint i = 0;
+
+	while (i < extents->len)
+	{
+		JBurstBufferExtent* extent = &g_array_index(extents, JBurstBufferExtent, i);
+		guint64 extent_end = extent->offset + extent->length;
+
+		if (extent_end <= offset)
+		{
+			i++;
+			continue;
+		}
+
+		if (extent->offset >= end)
+		{
+			break;
+		}
+
+		removed += MIN(end, extent_end) - MAX(offset, extent->offset);
+
+		if (extent->offset < offset && extent_end > end)
+		{
+			JBurstBufferExtent tail;
+
+			tail.offset = end;
+			tail.length = extent_end - end;
+
+			extent->length = offset - extent->offset;
+			g_array_insert_val(extents, i + 1, tail);
+			break;
+		}
+		else if (extent->offset < offset)
+		{
+			extent->length = offset - extent->offset;
+			i++;
+		}
+		else if (extent_end > end)
+		{
+			extent->offset = end;
+			extent->length = extent_end - end;
+			break;
+		}
+		else
+		{
+			g_array_remove_index(extents, i);
+		}
+	}
+
+	return removed;
+}
+
+/**
+ * Returns the number of bytes of a range that are covered by the extents.
+ **/
+static guint64
+j_burst_buffer_extents_covered(GArray* extents, guint64 offset, guint64 length)
+{
+	guint64 end = offset + length;
+	guint64 covered = 0;
+
+	for (guint i = 0; i < extents->len; i++)
+	{
+		JBurstBufferExtent* extent = &g_array_index(extents, JBurstBufferExtent, i);
+		guint64 extent_end = extent->offset + extent->length;
+
+		if (extent->offset >= end)
+		{
+			break;
+		}
+
+		if (extent_end > offset)
+		{
+			covered += MIN(end, extent_end) - MAX(offset, extent->offset);
+		}
+	}
+
+	return covered;
+}
+
+static void
+j_burst_buffer_entry_free(gpointer data)
+{
+	JBurstBufferEntry* entry = data;
+
+	j_backend_object_delete(j_burst_buffer->backend, entry->handle);
+	entry->type->unref(entry->object);
+
+	g_array_unref(entry->extents);
+	g_free(entry->key);
+
+	g_slice_free(JBurstBufferEntry, entry);
+}
+
+/**
+ * Removes an entry if it is neither used nor holds staged data, the burst buffer has to be locked.
+ **/
+static void
+j_burst_buffer_entry_release(JBurstBuffer* burst_buffer, JBurstBufferEntry* entry)
+{
+	if (entry->users > 0 || entry->draining || entry->extents->len > 0)
+	{
+		return;
+	}
+
+	if (entry->queued)
+	{
+		g_queue_unlink(burst_buffer->queue, &(entry->link));
+		entry->queued = FALSE;
+	}
+
+	g_hash_table_remove(burst_buffer->entries, entry->key);
+}
+
+/**
+ * Drains the first extent of an entry, the burst buffer has to be locked and the entry has to be marked as draining.
+ * The lock is released while the data is written to the object servers.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_burst_buffer_drain_locked(JBurstBuffer* burst_buffer, JBurstBufferEntry* entry, guint64* nbytes)
+{
+	JBurstBufferExtent* extent;
+	g_autofree gpointer data = NULL;
+	guint64 bytes_read = 0;
+	guint64 length;
+	guint64 offset;
+	gboolean ret;
+
+	extent = &g_array_index(entry->extents, JBurstBufferExtent, 0);
+	offset = extent->offset;
+	length = MIN(extent->length, burst_buffer->drain_size);
+
+	entry->drain_offset = offset;
+	entry->drain_length = length;
+	entry->modified = FALSE;
+
+	g_mutex_unlock(burst_buffer->mutex);
+
+	data = g_malloc(length);
+	ret = j_backend_object_read(burst_buffer->backend, entry->handle, data, length, offset, &bytes_read) && bytes_read == length;
+	ret = ret && entry->type->drain(entry->object, data, length, offset);
+
+	g_mutex_lock(burst_buffer->mutex);
+
+	entry->drain_length = 0;
+
+	// Data that has been written again in the meantime stays staged and is drained again
+	if (ret && !entry->modified)
+	{
+		burst_buffer->used -= j_burst_buffer_extents_remove(entry->extents, offset, length);
+		g_cond_broadcast(burst_buffer->cond);
+	}
+
+	if (entry->extents->len == 0 && entry->queued)
+	{
+		g_queue_unlink(burst_buffer->queue, &(entry->link));
+		entry->queued = FALSE;
+	}
+
+	*nbytes = length;
+
+	return ret;
+}
+
+/**
+ * Drains all staged data of an entry, the burst buffer has to be locked.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_burst_buffer_flush_entry(JBurstBuffer* burst_buffer, JBurstBufferEntry* entry)
+{
+	gboolean ret = TRUE;
+
+	entry->users++;
+
+	while (entry->draining)
+	{
+		g_cond_wait(burst_buffer->cond, burst_buffer->mutex);
+	}
+
+	entry->draining = TRUE;
+
+	while (ret && entry->extents->len > 0)
+	{
+		guint64 nbytes;
+
+		ret = j_burst_buffer_drain_locked(burst_buffer, entry, &nbytes);
+	}
+
+	entry->draining = FALSE;
+	entry->users--;
+
+	g_cond_broadcast(burst_buffer->cond);
+	j_burst_buffer_entry_release(burst_buffer, entry);
+
+	return ret;
+}
+
+static gpointer
+j_burst_buffer_thread(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBurstBuffer* burst_buffer = data;
+	gint64 next_time = 0;
+
+	g_mutex_lock(burst_buffer->mutex);
+
+	while (TRUE)
+	{
+		JBurstBufferEntry* entry = NULL;
+		guint64 nbytes;
+		gboolean ret;
+
+		for (GList* link = burst_buffer->queue->head; link != NULL; link = link->next)
+		{
+			JBurstBufferEntry* candidate = link->data;
+
+			if (!candidate->draining)
+			{
+				entry = candidate;
+				break;
+			}
+		}
+
+		if (entry == NULL)
+		{
+			if (burst_buffer->stop && g_queue_is_empty(burst_buffer->queue))
+			{
+				break;
+			}
+
+			g_cond_wait(burst_buffer->cond, burst_buffer->mutex);
+			continue;
+		}
+
+		entry->draining = TRUE;
+		ret = j_burst_buffer_drain_locked(burst_buffer, entry, &nbytes);
+		entry->draining = FALSE;
+
+		// Entries take turns, so that a large object does not hold up the others
+		if (entry->queued)
+		{
+			g_queue_unlink(burst_buffer->queue, &(entry->link));
+			g_queue_push_tail_link(burst_buffer->queue, &(entry->link));
+		}
+
+		g_cond_broadcast(burst_buffer->cond);
+		j_burst_buffer_entry_release(burst_buffer, entry);
+
+		if (!ret)
+		{
+			gint64 end_time;
+
+			if (burst_buffer->stop)
+			{
+				g_warning("Could not drain burst buffer, staged data is lost.");
+				break;
+			}
+
+			end_time = g_get_monotonic_time() + J_BURST_BUFFER_RETRY_PAUSE * G_TIME_SPAN_SECOND;
+
+			while (!burst_buffer->stop && g_cond_wait_until(burst_buffer->cond, burst_buffer->mutex, end_time))
+			{
+			}
+		}
+		else if (burst_buffer->bandwidth > 0 && !burst_buffer->stop)
+		{
+			// Spread the drained data over time; remaining data is drained at full speed when stopping
+			next_time = MAX(next_time, g_get_monotonic_time()) + (gint64)(nbytes * G_TIME_SPAN_SECOND / burst_buffer->bandwidth);
+
+			while (!burst_buffer->stop && g_cond_wait_until(burst_buffer->cond, burst_buffer->mutex, next_time))
+			{
+			}
+		}
+	}
+
+	g_mutex_unlock(burst_buffer->mutex);
+
+	return NULL;
+}
+
+/**
+ * Shuts down the burst buffer, draining all staged data.
+ */
+static void
+j_burst_buffer_fini(void)
+{
+	JBurstBuffer* burst_buffer;
+
+	if ((burst_buffer = g_atomic_pointer_get(&j_burst_buffer)) == NULL)
+	{
+		return;
+	}
+
+	g_mutex_lock(burst_buffer->mutex);
+	burst_buffer->stop = TRUE;
+	g_cond_broadcast(burst_buffer->cond);
+	g_mutex_unlock(burst_buffer->mutex);
+
+	g_thread_join(burst_buffer->thread);
+
+	// Removing the entries deletes their node-local objects
+	g_hash_table_unref(burst_buffer->entries);
+
+	// Writes after shutting down are sent to the object servers directly
+	g_atomic_pointer_set(&j_burst_buffer, NULL);
+
+	j_backend_object_fini(burst_buffer->backend);
+	g_module_close(burst_buffer->module);
+
+	g_cond_clear(burst_buffer->cond);
+	g_mutex_clear(burst_buffer->mutex);
+	g_free(burst_buffer->namespace);
+
+	g_slice_free(JBurstBuffer, burst_buffer);
+}
+
+/**
+ * Returns the burst buffer.
+ *
+ * \private
+ *
+ * \param semantics A semantics object, can be NULL.
+ *
+ * \return The burst buffer, NULL if it is disabled or #semantics does not allow eventual persistency.
+ **/
+JBurstBuffer*
+j_burst_buffer_get(JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	static gsize initialized = 0;
+
+	JBurstBuffer* burst_buffer;
+
+	if (g_once_init_enter(&initialized))
+	{
+		JConfiguration* configuration = j_configuration();
+		gchar const* local_backend;
+		gchar const* local_path;
+
+		local_backend = j_configuration_get_local_backend(configuration, J_BACKEND_TYPE_OBJECT);
+		local_path = j_configuration_get_local_backend_path(configuration, J_BACKEND_TYPE_OBJECT);
+
+		// If the object backend runs on the client, there are no servers to stage data for
+		if (local_backend != NULL && j_object_get_backend() == NULL)
+		{
+			burst_buffer = g_slice_new(JBurstBuffer);
+			burst_buffer->module = NULL;
+			burst_buffer->backend = NULL;
+
+			if (j_backend_load_local(local_backend, J_BACKEND_TYPE_OBJECT, &(burst_buffer->module), &(burst_buffer->backend))
+			    && j_backend_object_init(burst_buffer->backend, (local_path != NULL) ? local_path : ""))
+			{
+				burst_buffer->namespace = g_strdup_printf("burst-buffer-%d", (gint)getpid());
+				g_mutex_init(burst_buffer->mutex);
+				g_cond_init(burst_buffer->cond);
+				burst_buffer->entries = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, j_burst_buffer_entry_free);
+				g_queue_init(burst_buffer->queue);
+				burst_buffer->size = j_configuration_get_burst_buffer_size(configuration);
+				burst_buffer->used = 0;
+				burst_buffer->bandwidth = j_configuration_get_burst_buffer_bandwidth(configuration);
+				burst_buffer->drain_size = MIN(J_BURST_BUFFER_DRAIN_SIZE, j_configuration_get_max_operation_size(configuration));
+				burst_buffer->stop = FALSE;
+				burst_buffer->thread = g_thread_new("JBurstBuffer", j_burst_buffer_thread, burst_buffer);
+
+				g_atomic_pointer_set(&j_burst_buffer, burst_buffer);
+			}
+			else
+			{
+				g_critical("Could not initialize burst buffer backend %s.\n", local_backend);
+
+				if (burst_buffer->module != NULL)
+				{
+					g_module_close(burst_buffer->module);
+				}
+
+				g_slice_free(JBurstBuffer, burst_buffer);
+			}
+		}
+
+		g_once_init_leave(&initialized, 1);
+	}
+
+	if ((burst_buffer = g_atomic_pointer_get(&j_burst_buffer)) == NULL)
+	{
+		return NULL;
+	}
+
+	if (semantics != NULL && j_semantics_get(semantics, J_SEMANTICS_PERSISTENCY) != J_SEMANTICS_PERSISTENCY_EVENTUAL)
+	{
+		return NULL;
+	}
+
+	return burst_buffer;
+}
+
+/**
+ * Stages a write.
+ * Waits for the drain thread if the burst buffer is full.
+ *
+ * \private
+ *
+ * \param burst_buffer A burst buffer.
+ * \param key          A key identifying the object.
+ * \param type         The object's type.
+ * \param object       The object, referenced while it has staged data.
+ * \param data         The data.
+ * \param length       The number of bytes.
+ * \param offset       The offset.
+ *
+ * \return TRUE if the write has been staged, FALSE if it has to be sent to the object servers directly.
+ *         The object's staged data has been drained in the latter case.
+ **/
+gboolean
+j_burst_buffer_write(JBurstBuffer* burst_buffer, gchar const* key, JBurstBufferType const* type, gpointer object, gconstpointer data, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBurstBufferEntry* entry;
+	guint64 nbytes = 0;
+	gboolean ret;
+
+	g_return_val_if_fail(burst_buffer != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(type != NULL, FALSE);
+	g_return_val_if_fail(object != NULL, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	g_mutex_lock(burst_buffer->mutex);
+
+	if (length > burst_buffer->size)
+	{
+		g_mutex_unlock(burst_buffer->mutex);
+		j_burst_buffer_flush(burst_buffer, key);
+
+		return FALSE;
+	}
+
+	while (burst_buffer->used + length > burst_buffer->size)
+	{
+		g_cond_wait(burst_buffer->cond, burst_buffer->mutex);
+	}
+
+	if ((entry = g_hash_table_lookup(burst_buffer->entries, key)) == NULL)
+	{
+		g_autofree gchar* path = NULL;
+		gpointer handle;
+
+		path = g_compute_checksum_for_string(G_CHECKSUM_SHA1, key, -1);
+
+		if (!j_backend_object_create(burst_buffer->backend, burst_buffer->namespace, path, &handle))
+		{
+			g_mutex_unlock(burst_buffer->mutex);
+
+			return FALSE;
+		}
+
+		entry = g_slice_new(JBurstBufferEntry);
+		entry->key = g_strdup(key);
+		entry->type = type;
+		entry->object = type->ref(object);
+		entry->handle = handle;
+		entry->extents = g_array_new(FALSE, FALSE, sizeof(JBurstBufferExtent));
+		entry->users = 0;
+		entry->draining = FALSE;
+		entry->drain_offset = 0;
+		entry->drain_length = 0;
+		entry->modified = FALSE;
+		entry->link.data = entry;
+		entry->link.prev = NULL;
+		entry->link.next = NULL;
+		entry->queued = FALSE;
+
+		g_hash_table_insert(burst_buffer->entries, entry->key, entry);
+	}
+
+	// Reserve the space while writing without holding the lock
+	burst_buffer->used += length;
+	entry->users++;
+
+	g_mutex_unlock(burst_buffer->mutex);
+
+	ret = j_backend_object_write(burst_buffer->backend, entry->handle, data, length, offset, &nbytes) && nbytes == length;
+
+	g_mutex_lock(burst_buffer->mutex);
+
+	entry->users--;
+	burst_buffer->used -= length;
+
+	if (ret)
+	{
+		burst_buffer->used += j_burst_buffer_extents_add(entry->extents, offset, length);
+
+		if (entry->drain_length > 0 && offset < entry->drain_offset + entry->drain_length && entry->drain_offset < offset + length)
+		{
+			entry->modified = TRUE;
+		}
+
+		if (!entry->queued)
+		{
+			g_queue_push_tail_link(burst_buffer->queue, &(entry->link));
+			entry->queued = TRUE;
+		}
+	}
+
+	g_cond_broadcast(burst_buffer->cond);
+	j_burst_buffer_entry_release(burst_buffer, entry);
+
+	g_mutex_unlock(burst_buffer->mutex);
+
+	if (!ret)
+	{
+		// The node-local backend might be full, older staged data must not overwrite the direct write later
+		j_burst_buffer_flush(burst_buffer, key);
+	}
+
+	return ret;
+}
+
+/**
+ * Serves a read from the burst buffer.
+ * Staged data overlapping the read is drained if the read cannot be served completely.
+ *
+ * \private
+ *
+ * \param burst_buffer A burst buffer.
+ * \param key          A key identifying the object.
+ * \param data         A buffer to hold the read data.
+ * \param length       The number of bytes.
+ * \param offset       The offset.
+ * \param bytes_read   Number of bytes read.
+ *
+ * \return TRUE if the read has been served, FALSE if it has to be sent to the object servers.
+ **/
+gboolean
+j_burst_buffer_read(JBurstBuffer* burst_buffer, gchar const* key, gpointer data, guint64 length, guint64 offset, guint64* bytes_read)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBurstBufferEntry* entry;
+	guint64 covered;
+	guint64 nbytes = 0;
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(burst_buffer != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(bytes_read != NULL, FALSE);
+
+	g_mutex_lock(burst_buffer->mutex);
+
+	if ((entry = g_hash_table_lookup(burst_buffer->entries, key)) == NULL)
+	{
+		g_mutex_unlock(burst_buffer->mutex);
+
+		return FALSE;
+	}
+
+	covered = j_burst_buffer_extents_covered(entry->extents, offset, length);
+
+	if (covered == length)
+	{
+		// Staged data is only removed from the node-local object once it has been drained
+		entry->users++;
+		g_mutex_unlock(burst_buffer->mutex);
+
+		ret = j_backend_object_read(burst_buffer->backend, entry->handle, data, length, offset, &nbytes) && nbytes == length;
+
+		g_mutex_lock(burst_buffer->mutex);
+		entry->users--;
+		j_burst_buffer_entry_release(burst_buffer, entry);
+	}
+
+	g_mutex_unlock(burst_buffer->mutex);
+
+	if (ret)
+	{
+		j_helper_atomic_add(bytes_read, nbytes);
+	}
+	else if (covered > 0)
+	{
+		j_burst_buffer_flush(burst_buffer, key);
+	}
+
+	return ret;
+}
+
+/**
+ * Drains the staged data of an object.
+ * Has to be called before operations that are not served by the burst buffer.
+ *
+ * \private
+ *
+ * \param burst_buffer A burst buffer.
+ * \param key          A key identifying the object.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+j_burst_buffer_flush(JBurstBuffer* burst_buffer, gchar const* key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBurstBufferEntry* entry;
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(burst_buffer != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+
+	g_mutex_lock(burst_buffer->mutex);
+
+	if ((entry = g_hash_table_lookup(burst_buffer->entries, key)) != NULL)
+	{
+		ret = j_burst_buffer_flush_entry(burst_buffer, entry);
+	}
+
+	g_mutex_unlock(burst_buffer->mutex);
+
+	return ret;
+}
+
+/**
+ * Drains the staged data of all objects.
+ *
+ * \private
+ *
+ * \param burst_buffer A burst buffer.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+j_burst_buffer_flush_all(JBurstBuffer* burst_buffer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GList* entries;
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(burst_buffer != NULL, FALSE);
+
+	g_mutex_lock(burst_buffer->mutex);
+
+	entries = g_hash_table_get_values(burst_buffer->entries);
+
+	// Keep the entries from being removed while others are drained
+	for (GList* link = entries; link != NULL; link = link->next)
+	{
+		JBurstBufferEntry* entry = link->data;
+
+		entry->users++;
+	}
+
+	for (GList* link = entries; link != NULL; link = link->next)
+	{
+		ret = j_burst_buffer_flush_entry(burst_buffer, link->data) && ret;
+	}
+
+	for (GList* link = entries; link != NULL; link = link->next)
+	{
+		JBurstBufferEntry* entry = link->data;
+
+		entry->users--;
+		j_burst_buffer_entry_release(burst_buffer, entry);
+	}
+
+	g_mutex_unlock(burst_buffer->mutex);
+
+	g_list_free(entries);
+
+	return ret;
+}
+
+/**
+ * @}
+ **/
@@ -27,8 +27,12 @@
 #include <string.h>
 
 #include <object/jdistributed-object.h>
+#include <object/jobject.h>
 
 #include <object/jobject-internal.h>
+#include <object/jblock-cache-internal.h>
+#include <object/jburst-buffer-internal.h>
+#include <object/jreed-solomon-internal.h>
 
 #include <julea.h>
 
@@ -75,6 +79,18 @@ struct JDistributedObjectBackgroundData
 		{
 			JList* bytes_written;
 		} write;
+
+		/**
+		 * The reduce part.
+		 */
+		struct
+		{
+			/**
+			 * The parts to merge the results into, one per message operation.
+			 * Contains #JDistributedObjectReducePart elements.
+			 */
+			JList* parts;
+		} reduce;
 	};
 };
 
@@ -84,14 +100,91 @@ struct JDistributedObjectReadBuffer
 {
 	gchar* data;
 	guint64* bytes_read;
+
+	/**
+	 * Whether the server sends a checksum of the data.
+	 */
+	gboolean checksum;
+
+	/**
+	 * The number of bytes received and their checksum, if any.
+	 */
+	guint64 length;
+	guint32 crc;
 };
 
 typedef struct JDistributedObjectReadBuffer JDistributedObjectReadBuffer;
 
+struct JDistributedObjectHedge;
+
+/**
+ * One request of a hedged read.
+ */
+struct JDistributedObjectHedgeAttempt
+{
+	struct JDistributedObjectHedge* hedge;
+
+	guint32 index;
+	JMessage* message;
+
+	/**
+	 * The buffers to receive into, pointing into #scratch.
+	 * Contains #JDistributedObjectReadBuffer elements.
+	 */
+	JList* buffers;
+	gchar* scratch;
+
+	gboolean started;
+	gboolean done;
+	gboolean success;
+};
+
+typedef struct JDistributedObjectHedgeAttempt JDistributedObjectHedgeAttempt;
+
+/**
+ * A read sent to one server and, if it is late, also to a server holding another copy of the same blocks.
+ * The attempts receive into private buffers, so that the slower one can finish after the read has returned.
+ */
+struct JDistributedObjectHedge
+{
+	gint ref_count;
+
+	GMutex mutex[1];
+	GCond cond[1];
+
+	/**
+	 * The buffers to fill, with their length set to the number of bytes requested.
+	 * Contains #JDistributedObjectReadBuffer elements.
+	 */
+	JList* targets;
+	guint64 length;
+
+	JDistributedObjectHedgeAttempt attempts[2];
+};
+
+typedef struct JDistributedObjectHedge JDistributedObjectHedge;
+
+/**
+ * The results of one server for one reduce operation.
+ */
+struct JDistributedObjectReducePart
+{
+	JReduce* reduce;
+	gboolean success;
+};
+
+typedef struct JDistributedObjectReducePart JDistributedObjectReducePart;
+
 struct JDistributedObjectOperation
 {
 	union
 	{
+		struct
+		{
+			JDistributedObject* object;
+			guint64 size;
+		} create;
+
 		struct
 		{
 			JDistributedObject* object;
@@ -120,12 +213,165 @@ struct JDistributedObjectOperation
 			guint64 length;
 			guint64 offset;
 			guint64* bytes_written;
+
+			/**
+			 * The buffer containing the data, see j_buffer_ref().
+			 * Cached operations reference it instead of copying the data.
+			 **/
+			gpointer buffer;
 		} write;
+
+		struct
+		{
+			JDistributedObject* object;
+			gconstpointer data;
+			guint64 length;
+			guint64* offset;
+			guint64* bytes_written;
+		} append;
+
+		struct
+		{
+			JDistributedObject* object;
+			JReduce* reduce;
+			guint64 length;
+			guint64 offset;
+			gboolean* success;
+		} reduce;
+
+		struct
+		{
+			JDistributedObject* object;
+			JDistributedObject* clone;
+		} clone;
+
+		struct
+		{
+			JDistributedObject* object;
+			JAdvice advice;
+			guint64 length;
+			guint64 offset;
+		} advise;
 	};
 };
 
 typedef struct JDistributedObjectOperation JDistributedObjectOperation;
 
+/**
+ * A list I/O operation.
+ * The extents are split into regular read or write operations that are executed together.
+ */
+struct JDistributedObjectVectorOperation
+{
+	JDistributedObject* object;
+
+	/**
+	 * The read or write operations, sorted by offset if they do not overlap.
+	 */
+	JDistributedObjectOperation* operations;
+	guint32 count;
+
+	/**
+	 * The number of bytes read or written.
+	 */
+	guint64* bytes;
+
+	/**
+	 * The buffers containing the writes' data, see j_buffer_ref().
+	 * NULL until the operation is cached.
+	 */
+	gpointer* buffers;
+};
+
+typedef struct JDistributedObjectVectorOperation JDistributedObjectVectorOperation;
+
+/**
+ * Adjacent or overlapping small writes that have been merged into one.
+ */
+struct JDistributedObjectWriteRun
+{
+	/**
+	 * The merged write.
+	 */
+	JDistributedObjectOperation operation;
+
+	/**
+	 * The merged data, owned by the run.
+	 */
+	gchar* buffer;
+	guint64 buffer_size;
+
+	/**
+	 * The number of bytes written for the merged write.
+	 */
+	guint64 bytes_written;
+
+	/**
+	 * The original writes.
+	 * Contains #JDistributedObjectOperation elements.
+	 */
+	GPtrArray* operations;
+};
+
+typedef struct JDistributedObjectWriteRun JDistributedObjectWriteRun;
+
+/**
+ * A copy of a written block that may already be stored on its server.
+ */
+struct JDistributedObjectDedupBlock
+{
+	/**
+	 * The block's digest, which identifies it on the server.
+	 */
+	guint8 hash[J_CHECKSUM_DIGEST_SIZE];
+
+	/**
+	 * The server and the offset of the copy.
+	 */
+	guint32 index;
+	guint64 offset;
+
+	/**
+	 * The number of bytes written by referencing the stored block, 0 if the block has to be sent.
+	 */
+	guint64 bytes_written;
+};
+
+typedef struct JDistributedObjectDedupBlock JDistributedObjectDedupBlock;
+
+/**
+ * A block whose digest has already been computed during a write.
+ */
+struct JDistributedObjectDedupDigest
+{
+	gchar const* data;
+	guint8 digest[J_CHECKSUM_DIGEST_SIZE];
+};
+
+typedef struct JDistributedObjectDedupDigest JDistributedObjectDedupDigest;
+
+/**
+ * The namespace holding the objects' distribution headers.
+ **/
+#define J_DISTRIBUTED_OBJECT_HEADER_NAMESPACE "distribution"
+
+/**
+ * The maximum size of a serialized distribution.
+ **/
+#define J_DISTRIBUTED_OBJECT_HEADER_SIZE 4096
+
+/**
+ * The offset of the append counter within the header, directly after the distribution.
+ * The object's size can not be determined by a single server, so appends reserve their space using the counter.
+ **/
+#define J_DISTRIBUTED_OBJECT_APPEND_COUNTER J_DISTRIBUTED_OBJECT_HEADER_SIZE
+
+/**
+ * The offset of an erasure-coded object's logical size within the header, directly after the append counter.
+ * Stripes are always written completely, so the parts' sizes include padding and parity.
+ **/
+#define J_DISTRIBUTED_OBJECT_ERASURE_SIZE (J_DISTRIBUTED_OBJECT_APPEND_COUNTER + sizeof(guint64))
+
 /**
  * A JDistributedObject.
  **/
@@ -141,258 +387,516 @@ struct JDistributedObject
 	 **/
 	gchar* name;
 
+	/**
+	 * The distribution, NULL if it has not been loaded from the header yet.
+	 **/
 	JDistribution* distribution;
 
 	/**
-	 * The reference count.
+	 * The header storing the distribution.
 	 **/
-	gint ref_count;
-};
-
-static void
-j_distributed_object_create_free(gpointer data)
-{
-	J_TRACE_FUNCTION(NULL);
-
-	JDistributedObject* object = data;
+	struct
+	{
+		GMutex mutex[1];
 
-	j_distributed_object_unref(object);
-}
+		/**
+		 * The serialized distribution, kept until the header has been written.
+		 **/
+		bson_t* data;
+		guint64 bytes_written;
 
-static void
-j_distributed_object_delete_free(gpointer data)
-{
-	J_TRACE_FUNCTION(NULL);
+		/**
+		 * Whether the header is written by the first write, which chooses the layout of autotuned distributions.
+		 **/
+		gint pending;
+	} header;
 
-	JDistributedObject* object = data;
+	/**
+	 * The read-ahead state.
+	 **/
+	struct
+	{
+		GMutex mutex[1];
 
-	j_distributed_object_unref(object);
-}
+		/**
+		 * The number of bytes to prefetch beyond a sequential read, 0 if disabled.
+		 **/
+		guint64 window;
 
-static void
-j_distributed_object_status_free(gpointer data)
-{
-	J_TRACE_FUNCTION(NULL);
+		/**
+		 * The offset a sequential read is expected at.
+		 **/
+		guint64 next_offset;
 
-	JDistributedObjectOperation* operation = data;
+		/**
+		 * The prefetched data.
+		 **/
+		gchar* buffer;
+		guint64 buffer_size;
 
-	j_distributed_object_unref(operation->status.object);
+		/**
+		 * The range of the object held in the buffer.
+		 **/
+		guint64 buffer_offset;
+		guint64 buffer_length;
+	} read_ahead;
 
-	g_slice_free(JDistributedObjectOperation, operation);
-}
+	/**
+	 * The reference count.
+	 **/
+	gint ref_count;
+};
 
-static void
-j_distributed_object_sync_free(gpointer data)
+static JObject*
+j_distributed_object_header_new(JDistributedObject* object)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JDistributedObjectOperation* operation = data;
+	g_autofree gchar* name = NULL;
 
-	j_distributed_object_unref(operation->sync.object);
+	name = g_strdup_printf("%s/%s", object->namespace, object->name);
 
-	g_slice_free(JDistributedObjectOperation, operation);
+	return j_object_new(J_DISTRIBUTED_OBJECT_HEADER_NAMESPACE, name);
 }
 
-static void
-j_distributed_object_read_free(gpointer data)
+/**
+ * Returns the key identifying an object in the burst buffer.
+ *
+ * \private
+ **/
+static gchar*
+j_distributed_object_burst_buffer_key(JDistributedObject* object)
 {
-	J_TRACE_FUNCTION(NULL);
-
-	JDistributedObjectOperation* operation = data;
-
-	j_distributed_object_unref(operation->read.object);
-
-	g_slice_free(JDistributedObjectOperation, operation);
+	return g_strdup_printf("distributed-object/%s/%s", object->namespace, object->name);
 }
 
+/**
+ * Drains an object's data from the burst buffer.
+ * Has to be called before operations that do not take staged data into account.
+ *
+ * \private
+ *
+ * \param object An object.
+ **/
 static void
-j_distributed_object_write_free(gpointer data)
+j_distributed_object_burst_buffer_flush(JDistributedObject* object)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JDistributedObjectOperation* operation = data;
+	JBurstBuffer* burst_buffer;
+	g_autofree gchar* key = NULL;
 
-	j_distributed_object_unref(operation->write.object);
+	if ((burst_buffer = j_burst_buffer_get(NULL)) == NULL)
+	{
+		return;
+	}
 
-	g_slice_free(JDistributedObjectOperation, operation);
+	key = j_distributed_object_burst_buffer_key(object);
+	j_burst_buffer_flush(burst_buffer, key);
 }
 
 /**
- * Executes create operations in a background operation.
+ * Loads an object's distribution from its header if necessary.
  *
  * \private
  *
- * \param data Background data.
+ * \param object    An object.
+ * \param semantics A semantics object.
  *
- * \return #data.
+ * \return TRUE if the distribution is available, FALSE otherwise.
  **/
-static gpointer
-j_distributed_object_create_background_operation(gpointer data)
+static gboolean
+j_distributed_object_load_distribution(JDistributedObject* object, JSemantics* semantics)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JDistributedObjectBackgroundData* background_data = data;
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) header = NULL;
+	g_autofree guint8* data = NULL;
+	guint64 bytes_read = 0;
+	guint32 len;
+	bson_t b[1];
 
-	JSemanticsSafety safety;
+	if (g_atomic_pointer_get(&(object->distribution)) != NULL)
+	{
+		return TRUE;
+	}
 
-	gpointer object_connection;
+	g_mutex_lock(object->header.mutex);
 
-	safety = j_semantics_get(background_data->semantics, J_SEMANTICS_SAFETY);
-	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
+	if (object->distribution != NULL)
+	{
+		goto end;
+	}
 
-	j_message_send(background_data->message, object_connection);
+	batch = j_batch_new(semantics);
+	header = j_distributed_object_header_new(object);
+	data = g_malloc(J_DISTRIBUTED_OBJECT_HEADER_SIZE);
 
-	if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+	j_object_read(header, data, J_DISTRIBUTED_OBJECT_HEADER_SIZE, 0, &bytes_read, batch);
+
+	if (!j_batch_execute(batch) || bytes_read < sizeof(len))
 	{
-		g_autoptr(JMessage) reply = NULL;
+		goto end;
+	}
 
-		reply = j_message_new_reply(background_data->message);
-		j_message_receive(reply, object_connection);
+	memcpy(&len, data, sizeof(len));
+	len = GUINT32_FROM_LE(len);
 
-		/* FIXME do something with reply */
+	if (len > bytes_read || !bson_init_static(b, data, len))
+	{
+		goto end;
 	}
 
-	j_message_unref(background_data->message);
-	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+	g_atomic_pointer_set(&(object->distribution), j_distribution_new_from_bson(b));
 
-	g_slice_free(JDistributedObjectBackgroundData, background_data);
+end:
+	g_mutex_unlock(object->header.mutex);
 
-	return NULL;
+	return (object->distribution != NULL);
 }
 
 /**
- * Executes create operations in a background operation.
+ * Returns the block size of an object's distribution.
  *
  * \private
  *
- * \param data Background data.
+ * \param object An object.
  *
- * \return #data.
+ * \return The block size, the configured stripe size if the distribution is not available.
  **/
-static gpointer
-j_distributed_object_delete_background_operation(gpointer data)
+static guint64
+j_distributed_object_get_block_size(JDistributedObject* object)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JDistributedObjectBackgroundData* background_data = data;
+	JDistribution* distribution;
+	guint64 block_size;
 
-	JSemanticsSafety safety;
+	distribution = g_atomic_pointer_get(&(object->distribution));
 
-	gpointer object_connection;
+	if (distribution == NULL || !j_distribution_get(distribution, "block-size", &block_size) || block_size == 0)
+	{
+		return j_configuration_get_stripe_size(j_configuration());
+	}
 
-	safety = j_semantics_get(background_data->semantics, J_SEMANTICS_SAFETY);
-	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
+	return block_size;
+}
 
-	j_message_send(background_data->message, object_connection);
+/**
+ * Chooses the layout of an autotuned distribution from the first writes and stores it in the header.
+ *
+ * \private
+ *
+ * \param object     An object.
+ * \param operations The write operations.
+ * \param semantics  A semantics object.
+ *
+ * \return TRUE if the layout is fixed, FALSE if the header could not be written.
+ **/
+static gboolean
+j_distributed_object_tune_distribution(JDistributedObject* object, JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+	gboolean ret = TRUE;
+
+	if (!g_atomic_int_get(&(object->header.pending)))
 	{
-		g_autoptr(JMessage) reply = NULL;
-		guint32 operation_count;
+		return TRUE;
+	}
 
-		reply = j_message_new_reply(background_data->message);
-		j_message_receive(reply, object_connection);
+	g_mutex_lock(object->header.mutex);
 
-		operation_count = j_message_get_count(reply);
+	if (object->header.pending)
+	{
+		g_autoptr(JBatch) batch = NULL;
+		g_autoptr(JObject) header = NULL;
+		g_autoptr(JListIterator) it = NULL;
+		guint64 size = 0;
 
-		for (guint i = 0; i < operation_count; i++)
+		it = j_list_iterator_new(operations);
+
+		while (j_list_iterator_next(it))
 		{
-			guint32 status;
+			JDistributedObjectOperation* operation = j_list_iterator_get(it);
 
-			status = j_message_get_4(reply);
-			background_data->ret = (status == 1) && background_data->ret;
+			size = MAX(size, operation->write.offset + operation->write.length);
 		}
+
+		j_distribution_tune(object->distribution, size);
+
+		g_clear_pointer(&(object->header.data), bson_destroy);
+		object->header.data = j_distribution_serialize(object->distribution);
+
+		batch = j_batch_new(semantics);
+		header = j_distributed_object_header_new(object);
+		j_object_write(header, bson_get_data(object->header.data), object->header.data->len, 0, &(object->header.bytes_written), batch);
+		ret = j_batch_execute(batch);
+
+		g_atomic_int_set(&(object->header.pending), !ret);
 	}
 
-	j_message_unref(background_data->message);
-	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+	g_mutex_unlock(object->header.mutex);
 
-	return data;
+	return ret;
 }
 
-/**
- * Executes write operations in a background operation.
- *
- * \private
- *
- * \param data Background data.
- *
- * \return #data.
- **/
-static gpointer
-j_distributed_object_read_background_operation(gpointer data)
+static void
+j_distributed_object_create_free(gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JDistributedObjectBackgroundData* background_data = data;
+	JDistributedObjectOperation* operation = data;
 
-	g_autoptr(JListIterator) it = NULL;
-	g_autoptr(JMessage) reply = NULL;
-	gpointer object_connection;
-	guint32 operations_done;
-	guint32 operation_count;
+	j_distributed_object_unref(operation->create.object);
 
-	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
-	j_message_send(background_data->message, object_connection);
+	g_slice_free(JDistributedObjectOperation, operation);
+}
 
-	reply = j_message_new_reply(background_data->message);
+static void
+j_distributed_object_delete_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	operations_done = 0;
-	operation_count = j_message_get_count(background_data->message);
+	JDistributedObject* object = data;
 
-	it = j_list_iterator_new(background_data->read.buffers);
+	j_distributed_object_unref(object);
+}
 
-	/**
-	 * This extra loop is necessary because the server might send multiple
-	 * replies per message. The same reply object can be used to receive
-	 * multiple times.
-	 */
-	while (operations_done < operation_count)
+static void
+j_distributed_object_status_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectOperation* operation = data;
+
+	j_distributed_object_unref(operation->status.object);
+
+	g_slice_free(JDistributedObjectOperation, operation);
+}
+
+static void
+j_distributed_object_sync_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectOperation* operation = data;
+
+	j_distributed_object_unref(operation->sync.object);
+
+	g_slice_free(JDistributedObjectOperation, operation);
+}
+
+static void
+j_distributed_object_advise_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectOperation* operation = data;
+
+	j_distributed_object_unref(operation->advise.object);
+
+	g_slice_free(JDistributedObjectOperation, operation);
+}
+
+static void
+j_distributed_object_read_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectOperation* operation = data;
+
+	j_distributed_object_unref(operation->read.object);
+
+	g_slice_free(JDistributedObjectOperation, operation);
+}
+
+static void
+j_distributed_object_write_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectOperation* operation = data;
+
+	j_distributed_object_unref(operation->write.object);
+
+	if (operation->write.buffer != NULL)
 	{
-		guint32 reply_operation_count;
+		j_buffer_free(operation->write.buffer);
+	}
 
-		j_message_receive(reply, object_connection);
+	g_slice_free(JDistributedObjectOperation, operation);
+}
 
-		reply_operation_count = j_message_get_count(reply);
+static void
+j_distributed_object_append_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
 
-		for (guint i = 0; i < reply_operation_count && j_list_iterator_next(it); i++)
+	JDistributedObjectOperation* operation = data;
+
+	j_distributed_object_unref(operation->append.object);
+
+	g_slice_free(JDistributedObjectOperation, operation);
+}
+
+static void
+j_distributed_object_clone_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectOperation* operation = data;
+
+	j_distributed_object_unref(operation->clone.object);
+	j_distributed_object_unref(operation->clone.clone);
+
+	g_slice_free(JDistributedObjectOperation, operation);
+}
+
+static void
+j_distributed_object_vector_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectVectorOperation* operation = data;
+
+	j_distributed_object_unref(operation->object);
+
+	for (guint32 i = 0; operation->buffers != NULL && i < operation->count; i++)
+	{
+		if (operation->buffers[i] != NULL)
 		{
-			JDistributedObjectReadBuffer* buffer = j_list_iterator_get(it);
-			gchar* read_data = buffer->data;
-			guint64* bytes_read = buffer->bytes_read;
+			j_buffer_free(operation->buffers[i]);
+		}
+	}
 
-			guint64 nbytes;
+	g_free(operation->buffers);
+	g_free(operation->operations);
+	g_slice_free(JDistributedObjectVectorOperation, operation);
+}
 
-			nbytes = j_message_get_8(reply);
-			j_helper_atomic_add(bytes_read, nbytes);
+static void
+j_distributed_object_reduce_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
 
-			if (nbytes > 0)
-			{
-				GInputStream* input;
+	JDistributedObjectOperation* operation = data;
 
-				input = g_io_stream_get_input_stream(G_IO_STREAM(object_connection));
-				g_input_stream_read_all(input, read_data, nbytes, NULL, NULL, NULL);
-			}
+	j_distributed_object_unref(operation->reduce.object);
+	j_reduce_unref(operation->reduce.reduce);
+
+	g_slice_free(JDistributedObjectOperation, operation);
+}
+
+static guint64
+j_distributed_object_metadata_cache(gpointer data, gpointer buffer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	(void)data;
+	(void)buffer;
+
+	// The operation does not reference any data owned by the caller.
+	return 0;
+}
+
+static guint64
+j_distributed_object_write_cache(gpointer data, gpointer buffer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectOperation* operation = data;
 
-			g_slice_free(JDistributedObjectReadBuffer, buffer);
+	// Data within a buffer does not have to be copied, the buffer is kept alive instead.
+	if (operation->write.buffer == NULL)
+	{
+		operation->write.buffer = j_buffer_ref(operation->write.data, operation->write.length);
+	}
+
+	if (buffer != NULL)
+	{
+		guint64* bytes_written = buffer;
+
+		if (operation->write.buffer == NULL)
+		{
+			gchar* write_data = (gchar*)(bytes_written + 1);
+
+			memcpy(write_data, operation->write.data, operation->write.length);
+			operation->write.data = write_data;
 		}
 
-		operations_done += reply_operation_count;
+		// The batch returns before the data is written, so the caller's counter is updated now.
+		*(operation->write.bytes_written) += operation->write.length;
+		*bytes_written = 0;
+
+		operation->write.bytes_written = bytes_written;
 	}
 
-	j_message_unref(background_data->message);
+	return sizeof(guint64) + ((operation->write.buffer != NULL) ? 0 : operation->write.length);
+}
 
-	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+static guint64
+j_distributed_object_writev_cache(gpointer data, gpointer buffer)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	j_list_unref(background_data->read.buffers);
+	JDistributedObjectVectorOperation* operation = data;
+	guint64 length = 0;
+	guint64 copy_length = 0;
 
-	g_slice_free(JDistributedObjectBackgroundData, background_data);
+	// Data within a buffer does not have to be copied, the buffer is kept alive instead.
+	if (operation->buffers == NULL)
+	{
+		operation->buffers = g_new(gpointer, operation->count);
 
-	return NULL;
+		for (guint32 i = 0; i < operation->count; i++)
+		{
+			operation->buffers[i] = j_buffer_ref(operation->operations[i].write.data, operation->operations[i].write.length);
+		}
+	}
+
+	for (guint32 i = 0; i < operation->count; i++)
+	{
+		length += operation->operations[i].write.length;
+
+		if (operation->buffers[i] == NULL)
+		{
+			copy_length += operation->operations[i].write.length;
+		}
+	}
+
+	if (buffer != NULL)
+	{
+		guint64* bytes_written = buffer;
+		gchar* write_data = (gchar*)(bytes_written + 1);
+
+		for (guint32 i = 0; i < operation->count; i++)
+		{
+			JDistributedObjectOperation* write = &(operation->operations[i]);
+
+			if (operation->buffers[i] == NULL)
+			{
+				memcpy(write_data, write->write.data, write->write.length);
+				write->write.data = write_data;
+				write_data += write->write.length;
+			}
+
+			write->write.bytes_written = bytes_written;
+		}
+
+		// The batch returns before the data is written, so the caller's counter is updated now.
+		*(operation->bytes) += length;
+		*bytes_written = 0;
+
+		operation->bytes = bytes_written;
+	}
+
+	return sizeof(guint64) + copy_length;
 }
 
 /**
- * Executes write operations in a background operation.
+ * Executes create operations in a background operation.
  *
  * \private
  *
@@ -401,7 +905,7 @@ j_distributed_object_read_background_operation(gpointer data)
  * \return #data.
  **/
 static gpointer
-j_distributed_object_write_background_operation(gpointer data)
+j_distributed_object_create_background_operation(gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -413,41 +917,29 @@ j_distributed_object_write_background_operation(gpointer data)
 
 	safety = j_semantics_get(background_data->semantics, J_SEMANTICS_SAFETY);
 	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
+
 	j_message_send(background_data->message, object_connection);
 
 	if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
 	{
-		g_autoptr(JListIterator) it = NULL;
 		g_autoptr(JMessage) reply = NULL;
-		guint64 nbytes;
 
 		reply = j_message_new_reply(background_data->message);
 		j_message_receive(reply, object_connection);
 
-		it = j_list_iterator_new(background_data->write.bytes_written);
-
-		while (j_list_iterator_next(it))
-		{
-			guint64* bytes_written = j_list_iterator_get(it);
-
-			nbytes = j_message_get_8(reply);
-			j_helper_atomic_add(bytes_written, nbytes);
-		}
+		/* FIXME do something with reply */
 	}
 
 	j_message_unref(background_data->message);
-
 	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
 
-	j_list_unref(background_data->write.bytes_written);
-
 	g_slice_free(JDistributedObjectBackgroundData, background_data);
 
 	return NULL;
 }
 
 /**
- * Executes status operations in a background operation.
+ * Executes create operations in a background operation.
  *
  * \private
  *
@@ -456,58 +948,48 @@ j_distributed_object_write_background_operation(gpointer data)
  * \return #data.
  **/
 static gpointer
-j_distributed_object_status_background_operation(gpointer data)
+j_distributed_object_delete_background_operation(gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JDistributedObjectBackgroundData* background_data = data;
 
-	g_autoptr(JListIterator) it = NULL;
-	g_autoptr(JMessage) reply = NULL;
+	JSemanticsSafety safety;
+
 	gpointer object_connection;
 
+	safety = j_semantics_get(background_data->semantics, J_SEMANTICS_SAFETY);
 	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
-	j_message_send(background_data->message, object_connection);
-
-	reply = j_message_new_reply(background_data->message);
-	j_message_receive(reply, object_connection);
 
-	it = j_list_iterator_new(background_data->operations);
+	j_message_send(background_data->message, object_connection);
 
-	while (j_list_iterator_next(it))
+	if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
 	{
-		JDistributedObjectOperation* operation = j_list_iterator_get(it);
-		gint64* modification_time = operation->status.modification_time;
-		guint64* size = operation->status.size;
-		gint64 modification_time_;
-		guint64 size_;
+		g_autoptr(JMessage) reply = NULL;
+		guint32 operation_count;
 
-		modification_time_ = j_message_get_8(reply);
-		size_ = j_message_get_8(reply);
+		reply = j_message_new_reply(background_data->message);
+		j_message_receive(reply, object_connection);
 
-		if (modification_time != NULL)
-		{
-			// FIXME max?
-			*modification_time = modification_time_;
-		}
+		operation_count = j_message_get_count(reply);
 
-		if (size != NULL)
+		for (guint i = 0; i < operation_count; i++)
 		{
-			j_helper_atomic_add(size, size_);
+			guint32 status;
+
+			status = j_message_get_4(reply);
+			background_data->ret = (status == 1) && background_data->ret;
 		}
 	}
 
 	j_message_unref(background_data->message);
-
 	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
 
-	g_slice_free(JDistributedObjectBackgroundData, background_data);
-
-	return NULL;
+	return data;
 }
 
 /**
- * Executes sync operations in a background operation.
+ * Executes clone operations in a background operation.
  *
  * \private
  *
@@ -516,248 +998,3625 @@ j_distributed_object_status_background_operation(gpointer data)
  * \return #data.
  **/
 static gpointer
-j_distributed_object_sync_background_operation(gpointer data)
+j_distributed_object_clone_background_operation(gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JDistributedObjectBackgroundData* background_data = data;
 
 	JSemanticsSafety safety;
+
 	gpointer object_connection;
 
 	safety = j_semantics_get(background_data->semantics, J_SEMANTICS_SAFETY);
 	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
+
 	j_message_send(background_data->message, object_connection);
 
 	if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
 	{
 		g_autoptr(JMessage) reply = NULL;
+		guint32 operation_count;
 
 		reply = j_message_new_reply(background_data->message);
 		j_message_receive(reply, object_connection);
 
-		// FIXME do something with reply
+		operation_count = j_message_get_count(reply);
+
+		for (guint i = 0; i < operation_count; i++)
+		{
+			guint32 status;
+
+			// Parts that have not been created yet do not have to be cloned
+			status = j_message_get_4(reply);
+			background_data->ret = (status != 0) && background_data->ret;
+		}
 	}
 
 	j_message_unref(background_data->message);
 	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
 
-	g_slice_free(JDistributedObjectBackgroundData, background_data);
+	return data;
+}
 
-	return NULL;
+/**
+ * Adds a read to a message.
+ *
+ * \private
+ *
+ * \param message A message.
+ * \param buffer  The buffer to read into.
+ * \param length  Number of bytes to read.
+ * \param offset  An offset within the server's part of the object.
+ **/
+static void
+j_distributed_object_read_add(JMessage* message, JDistributedObjectReadBuffer* buffer, guint64 length, guint64 offset)
+{
+	if (buffer->checksum)
+	{
+		length |= J_MESSAGE_LENGTH_CHECKSUM;
+	}
+
+	j_message_add_operation(message, sizeof(guint64) + sizeof(guint64));
+	j_message_append_8(message, &length);
+	j_message_append_8(message, &offset);
 }
 
+/**
+ * Receives the replies to a read message.
+ * The data is received into the buffers and each buffer's length is set to the number of valid bytes.
+ * Buffers whose checksum does not match are treated as empty.
+ *
+ * \private
+ *
+ * \param index      A server index.
+ * \param message    A read message.
+ * \param buffers    A list of #JDistributedObjectReadBuffer elements, one per operation in #message.
+ * \param connection A connection.
+ *
+ * \return TRUE on success, FALSE if a network error occurred.
+ **/
 static gboolean
-j_distributed_object_create_exec(JList* operations, JSemantics* semantics)
+j_distributed_object_read_receive(guint32 index, JMessage* message, JList* buffers, gpointer connection)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	// FIXME check return value for messages
-	gboolean ret = TRUE;
-
-	JBackend* object_backend;
 	g_autoptr(JListIterator) it = NULL;
-	g_autofree JMessage** messages = NULL;
-	gchar const* namespace = NULL;
-	gsize namespace_len = 0;
-	guint32 server_count = 0;
-
-	g_return_val_if_fail(operations != NULL, FALSE);
-	g_return_val_if_fail(semantics != NULL, FALSE);
-
-	{
-		JDistributedObject* object;
+	g_autoptr(JMessage) reply = NULL;
+	g_autoptr(GPtrArray) checked = NULL;
+	guint32 operations_done;
+	guint32 operation_count;
 
-		object = j_list_get_first(operations);
-		g_assert(object != NULL);
+	reply = j_message_new_reply(message);
+	checked = g_ptr_array_new();
 
-		namespace = object->namespace;
-		namespace_len = strlen(namespace) + 1;
-	}
+	operations_done = 0;
+	operation_count = j_message_get_count(message);
 
-	it = j_list_iterator_new(operations);
-	object_backend = j_object_get_backend();
+	it = j_list_iterator_new(buffers);
 
-	if (object_backend == NULL)
+	/**
+	 * This extra loop is necessary because the server might send multiple
+	 * replies per message. The same reply object can be used to receive
+	 * multiple times.
+	 */
+	while (operations_done < operation_count)
 	{
-		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
-		messages = g_new(JMessage*, server_count);
+		guint32 reply_operation_count;
 
-		// FIXME use actual distribution
-		for (guint i = 0; i < server_count; i++)
+		if (!j_message_receive(reply, connection))
 		{
-			/**
-			 * Force safe semantics to make the server send a reply.
-			 * Otherwise, nasty races can occur when using unsafe semantics:
-			 * - The client creates the object and sends its first write.
-			 * - The client sends another operation using another connection from the pool.
-			 * - The second operation is executed first and fails because the object does not exist.
-			 * This does not completely eliminate all races but fixes the common case of create, write, write, ...
-			 **/
-			messages[i] = j_message_new(J_MESSAGE_OBJECT_CREATE, namespace_len);
-			j_message_set_semantics(messages[i], semantics);
-			j_message_append_n(messages[i], namespace, namespace_len);
+			return FALSE;
 		}
-	}
 
-	while (j_list_iterator_next(it))
-	{
-		JDistributedObject* object = j_list_iterator_get(it);
+		reply_operation_count = j_message_get_count(reply);
 
-		if (object_backend == NULL)
+		for (guint i = 0; i < reply_operation_count && j_list_iterator_next(it); i++)
 		{
-			gsize name_len;
+			JDistributedObjectReadBuffer* buffer = j_list_iterator_get(it);
 
-			name_len = strlen(object->name) + 1;
+			buffer->length = j_message_get_8(reply);
 
-			// FIXME use actual distribution
-			for (guint i = 0; i < server_count; i++)
+			if (buffer->length > 0)
 			{
-				j_message_add_operation(messages[i], name_len);
-				j_message_append_n(messages[i], object->name, name_len);
+				j_message_add_receive(reply, buffer->data, buffer->length);
 			}
-		}
-		else
-		{
-			gpointer object_handle;
 
-			ret = j_backend_object_create(object_backend, object->namespace, object->name, &object_handle) && ret;
-			ret = j_backend_object_close(object_backend, object_handle) && ret;
+			if (buffer->checksum)
+			{
+				buffer->crc = j_message_get_4(reply);
+				g_ptr_array_add(checked, buffer);
+			}
 		}
-	}
-
-	if (object_backend == NULL)
-	{
-		g_autofree gpointer* background_data = NULL;
-
-		background_data = g_new(gpointer, server_count);
 
-		// FIXME use actual distribution
-		for (guint i = 0; i < server_count; i++)
+		if (!j_message_receive_data(reply, connection))
 		{
-			JDistributedObjectBackgroundData* data;
+			return FALSE;
+		}
 
-			data = g_slice_new(JDistributedObjectBackgroundData);
-			data->index = i;
-			data->message = messages[i];
-			data->operations = NULL;
-			data->semantics = semantics;
+		for (guint i = 0; i < checked->len; i++)
+		{
+			JDistributedObjectReadBuffer* buffer = g_ptr_array_index(checked, i);
 
-			background_data[i] = data;
+			// The data can only be counted once it has been verified
+			if (j_checksum_crc32c(0, buffer->data, buffer->length) != buffer->crc)
+			{
+				g_warning("Checksum mismatch while reading %" G_GUINT64_FORMAT " bytes from server %u.", buffer->length, index);
+				buffer->length = 0;
+			}
 		}
 
-		j_helper_execute_parallel(j_distributed_object_create_background_operation, background_data, server_count);
+		g_ptr_array_set_size(checked, 0);
+
+		operations_done += reply_operation_count;
 	}
 
-	return ret;
+	return TRUE;
 }
 
-static gboolean
-j_distributed_object_delete_exec(JList* operations, JSemantics* semantics)
+/**
+ * Executes read operations in a background operation.
+ * Failed reads are retried on a new connection, so the number of bytes read is only accounted once all replies have been received.
+ *
+ * \private
+ *
+ * \param data Background data.
+ *
+ * \return NULL.
+ **/
+static gpointer
+j_distributed_object_read_background_operation(gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gboolean ret = TRUE;
+	JDistributedObjectBackgroundData* background_data = data;
 
-	JBackend* object_backend;
 	g_autoptr(JListIterator) it = NULL;
-	g_autofree JMessage** messages = NULL;
-	gchar const* namespace = NULL;
-	gsize namespace_len = 0;
-	guint32 server_count = 0;
-
-	g_return_val_if_fail(operations != NULL, FALSE);
-	g_return_val_if_fail(semantics != NULL, FALSE);
+	gboolean ret = FALSE;
 
+	for (guint attempt = 0; !ret && (attempt == 0 || j_connection_pool_backoff(attempt)); attempt++)
 	{
-		JDistributedObject* object;
-
-		object = j_list_get_first(operations);
-		g_assert(object != NULL);
-
-		namespace = object->namespace;
-		namespace_len = strlen(namespace) + 1;
-	}
+		gpointer object_connection;
 
-	it = j_list_iterator_new(operations);
-	object_backend = j_object_get_backend();
+		if ((object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index)) == NULL)
+		{
+			continue;
+		}
 
-	if (object_backend == NULL)
-	{
-		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
-		messages = g_new(JMessage*, server_count);
+		ret = j_message_send(background_data->message, object_connection) && j_distributed_object_read_receive(background_data->index, background_data->message, background_data->read.buffers, object_connection);
 
-		// FIXME use actual distribution
-		for (guint i = 0; i < server_count; i++)
+		if (ret)
 		{
-			messages[i] = j_message_new(J_MESSAGE_OBJECT_DELETE, namespace_len);
-			j_message_set_semantics(messages[i], semantics);
-			j_message_append_n(messages[i], namespace, namespace_len);
+			j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+		}
+		else
+		{
+			j_connection_pool_discard(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
 		}
 	}
 
+	it = j_list_iterator_new(background_data->read.buffers);
+
 	while (j_list_iterator_next(it))
 	{
-		JDistributedObject* object = j_list_iterator_get(it);
+		JDistributedObjectReadBuffer* buffer = j_list_iterator_get(it);
 
-		if (object_backend == NULL)
+		if (ret)
 		{
-			gsize name_len;
-
-			name_len = strlen(object->name) + 1;
-
-			// FIXME use actual distribution
-			for (guint i = 0; i < server_count; i++)
-			{
-				j_message_add_operation(messages[i], name_len);
-				j_message_append_n(messages[i], object->name, name_len);
-			}
+			j_helper_atomic_add(buffer->bytes_read, buffer->length);
 		}
-		else
-		{
-			gboolean lret = FALSE;
-			gpointer object_handle;
 
-			if (j_backend_object_open(object_backend, object->namespace, object->name, &object_handle)
-			    && j_backend_object_delete(object_backend, object_handle))
-			{
-				lret = TRUE;
-			}
-
-			ret = lret && ret;
-		}
+		g_slice_free(JDistributedObjectReadBuffer, buffer);
 	}
 
-	if (object_backend == NULL)
-	{
-		g_autofree gpointer* background_data = NULL;
+	j_message_unref(background_data->message);
 
-		background_data = g_new(gpointer, server_count);
+	j_list_unref(background_data->read.buffers);
 
-		// FIXME use actual distribution
-		for (guint i = 0; i < server_count; i++)
-		{
-			JDistributedObjectBackgroundData* data;
+	g_slice_free(JDistributedObjectBackgroundData, background_data);
 
-			data = g_slice_new(JDistributedObjectBackgroundData);
-			data->index = i;
-			data->message = messages[i];
-			data->operations = NULL;
-			data->semantics = semantics;
+	return NULL;
+}
+
+/**
+ * Executes write operations in a background operation.
+ *
+ * \private
+ *
+ * \param data Background data.
+ *
+ * \return #data.
+ **/
+static gpointer
+j_distributed_object_write_background_operation(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectBackgroundData* background_data = data;
+
+	JSemanticsSafety safety;
+
+	gpointer object_connection;
+
+	safety = j_semantics_get(background_data->semantics, J_SEMANTICS_SAFETY);
+	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
+	j_message_send(background_data->message, object_connection);
+
+	if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+	{
+		g_autoptr(JListIterator) it = NULL;
+		g_autoptr(JMessage) reply = NULL;
+		guint64 nbytes;
+
+		reply = j_message_new_reply(background_data->message);
+		j_message_receive(reply, object_connection);
+
+		it = j_list_iterator_new(background_data->write.bytes_written);
+
+		while (j_list_iterator_next(it))
+		{
+			guint64* bytes_written = j_list_iterator_get(it);
+
+			nbytes = j_message_get_8(reply);
+			j_helper_atomic_add(bytes_written, nbytes);
+		}
+	}
+
+	j_message_unref(background_data->message);
+
+	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+
+	j_list_unref(background_data->write.bytes_written);
+
+	g_slice_free(JDistributedObjectBackgroundData, background_data);
+
+	return NULL;
+}
+
+/**
+ * Executes deduplication operations in a background operation.
+ * Unlike writes, these always wait for the reply, since it determines which blocks have to be sent.
+ *
+ * \private
+ *
+ * \param data Background data.
+ *
+ * \return #data.
+ **/
+static gpointer
+j_distributed_object_dedup_background_operation(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectBackgroundData* background_data = data;
+
+	g_autoptr(JListIterator) it = NULL;
+	g_autoptr(JMessage) reply = NULL;
+	gpointer object_connection;
+
+	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
+	j_message_send(background_data->message, object_connection);
+
+	reply = j_message_new_reply(background_data->message);
+	j_message_receive(reply, object_connection);
+
+	it = j_list_iterator_new(background_data->write.bytes_written);
+
+	while (j_list_iterator_next(it))
+	{
+		guint64* bytes_written = j_list_iterator_get(it);
+
+		*bytes_written = j_message_get_8(reply);
+	}
+
+	j_message_unref(background_data->message);
+
+	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+
+	j_list_unref(background_data->write.bytes_written);
+
+	g_slice_free(JDistributedObjectBackgroundData, background_data);
+
+	return NULL;
+}
+
+G_LOCK_DEFINE_STATIC(j_distributed_object_status);
+
+/**
+ * Executes status operations in a background operation.
+ *
+ * \private
+ *
+ * \param data Background data.
+ *
+ * \return #data.
+ **/
+static gpointer
+j_distributed_object_status_background_operation(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectBackgroundData* background_data = data;
+
+	g_autoptr(JListIterator) it = NULL;
+	g_autoptr(JMessage) reply = NULL;
+
+	reply = j_message_new_reply(background_data->message);
+
+	// Status requests are idempotent and can be retried after network errors
+	if (!j_connection_pool_exchange(J_BACKEND_TYPE_OBJECT, background_data->index, background_data->message, reply))
+	{
+		goto end;
+	}
+
+	it = j_list_iterator_new(background_data->operations);
+
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+		gint64* modification_time = operation->status.modification_time;
+		guint64* size = operation->status.size;
+		gint64 modification_time_;
+		guint64 size_;
+
+		modification_time_ = j_message_get_8(reply);
+		size_ = j_message_get_8(reply);
+
+		if (modification_time != NULL)
+		{
+			// FIXME max?
+			*modification_time = modification_time_;
+		}
+
+		if (size != NULL)
+		{
+			JDistribution* distribution = g_atomic_pointer_get(&(operation->status.object->distribution));
+
+			// Replicated and consistently hashed objects store all blocks at their logical offsets
+			if (distribution != NULL && (j_distribution_get_type(distribution) == J_DISTRIBUTION_REPLICATED || j_distribution_get_type(distribution) == J_DISTRIBUTION_CONSISTENT))
+			{
+				G_LOCK(j_distributed_object_status);
+				*size = MAX(*size, size_);
+				G_UNLOCK(j_distributed_object_status);
+			}
+			// Erasure-coded parts contain padding and parity, their logical size is read from the header afterwards
+			else if (distribution == NULL || j_distribution_get_type(distribution) != J_DISTRIBUTION_ERASURE)
+			{
+				j_helper_atomic_add(size, size_);
+			}
+		}
+	}
+
+end:
+	j_message_unref(background_data->message);
+
+	g_slice_free(JDistributedObjectBackgroundData, background_data);
+
+	return NULL;
+}
+
+/**
+ * Executes sync operations in a background operation.
+ *
+ * \private
+ *
+ * \param data Background data.
+ *
+ * \return #data.
+ **/
+static gpointer
+j_distributed_object_sync_background_operation(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectBackgroundData* background_data = data;
+
+	JSemanticsSafety safety;
+	gpointer object_connection;
+
+	safety = j_semantics_get(background_data->semantics, J_SEMANTICS_SAFETY);
+	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
+	j_message_send(background_data->message, object_connection);
+
+	if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+	{
+		g_autoptr(JMessage) reply = NULL;
+
+		reply = j_message_new_reply(background_data->message);
+		j_message_receive(reply, object_connection);
+
+		// FIXME do something with reply
+	}
+
+	j_message_unref(background_data->message);
+	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+
+	g_slice_free(JDistributedObjectBackgroundData, background_data);
+
+	return NULL;
+}
+
+/**
+ * Calculates how large each server's part of an object will be.
+ *
+ * \private
+ *
+ * \param object       An object.
+ * \param size         The object's expected size.
+ * \param sizes        Returns the size of each server's part.
+ * \param server_count The number of servers.
+ **/
+static void
+j_distributed_object_server_sizes(JDistributedObject* object, guint64 size, guint64* sizes, guint32 server_count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 block_id;
+	guint64 new_length;
+	guint64 new_offset;
+	guint index;
+
+	for (guint i = 0; i < server_count; i++)
+	{
+		sizes[i] = 0;
+	}
+
+	if (size == 0)
+	{
+		return;
+	}
+
+	j_distribution_reset(object->distribution, size, 0);
+
+	while (j_distribution_distribute(object->distribution, &index, &new_length, &new_offset, &block_id))
+	{
+		if (index < server_count)
+		{
+			sizes[index] = MAX(sizes[index], new_offset + new_length);
+		}
+	}
+}
+
+static gboolean
+j_distributed_object_create_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	// FIXME check return value for messages
+	gboolean ret = TRUE;
+
+	JBackend* object_backend;
+	g_autoptr(JListIterator) it = NULL;
+	g_autofree JMessage** messages = NULL;
+	g_autofree guint64* sizes = NULL;
+	gchar const* namespace = NULL;
+	gsize namespace_len = 0;
+	guint32 server_count = 0;
+	guint32 created = 0;
+	gboolean lazy_create;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JDistributedObjectOperation* operation = j_list_get_first(operations);
+		JDistributedObject* object = operation->create.object;
+
+		g_assert(operation != NULL);
+		g_assert(object != NULL);
+
+		namespace = object->namespace;
+		namespace_len = strlen(namespace) + 1;
+	}
+
+	it = j_list_iterator_new(operations);
+	object_backend = j_object_get_backend();
+	lazy_create = j_configuration_get_object_lazy_create(j_configuration());
+
+	if (object_backend == NULL)
+	{
+		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
+		messages = g_new(JMessage*, server_count);
+		sizes = g_new(guint64, server_count);
+
+		// FIXME use actual distribution
+		for (guint i = 0; i < server_count; i++)
+		{
+			/**
+			 * Force safe semantics to make the server send a reply.
+			 * Otherwise, nasty races can occur when using unsafe semantics:
+			 * - The client creates the object and sends its first write.
+			 * - The client sends another operation using another connection from the pool.
+			 * - The second operation is executed first and fails because the object does not exist.
+			 * This does not completely eliminate all races but fixes the common case of create, write, write, ...
+			 **/
+			messages[i] = j_message_new(J_MESSAGE_OBJECT_CREATE, namespace_len);
+			j_message_set_semantics(messages[i], semantics);
+			j_message_append_n(messages[i], namespace, namespace_len);
+		}
+	}
+
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+		JDistributedObject* object = operation->create.object;
+		guint64 size = operation->create.size;
+
+		if (object_backend == NULL)
+		{
+			gsize name_len;
+
+			name_len = strlen(object->name) + 1;
+			created++;
+
+			j_distributed_object_server_sizes(object, size, sizes, server_count);
+
+			// FIXME use actual distribution
+			for (guint i = 0; i < server_count; i++)
+			{
+				// The servers create their parts on the first write, only objects with a size hint have to be preallocated
+				// The first part is always created, so deleting an object that does not exist still fails
+				if (lazy_create && size == 0 && i > 0)
+				{
+					continue;
+				}
+
+				j_message_add_operation(messages[i], name_len + sizeof(guint64));
+				j_message_append_n(messages[i], object->name, name_len);
+				j_message_append_8(messages[i], &(sizes[i]));
+			}
+		}
+		else
+		{
+			gpointer object_handle;
+
+			ret = j_backend_object_create(object_backend, object->namespace, object->name, &object_handle) && ret;
+			ret = j_backend_object_preallocate(object_backend, object_handle, size) && ret;
+			ret = j_backend_object_close(object_backend, object_handle) && ret;
+		}
+	}
+
+	if (object_backend == NULL && created == 0)
+	{
+		for (guint i = 0; i < server_count; i++)
+		{
+			j_message_unref(messages[i]);
+		}
+	}
+	else if (object_backend == NULL)
+	{
+		g_autofree gpointer* background_data = NULL;
+		guint32 background_count = 0;
+
+		background_data = g_new(gpointer, server_count);
+
+		// FIXME use actual distribution
+		for (guint i = 0; i < server_count; i++)
+		{
+			JDistributedObjectBackgroundData* data;
+
+			// Servers without any parts to create are skipped
+			if (j_message_get_count(messages[i]) == 0)
+			{
+				j_message_unref(messages[i]);
+				continue;
+			}
+
+			data = g_slice_new(JDistributedObjectBackgroundData);
+			data->index = i;
+			data->message = messages[i];
+			data->operations = NULL;
+			data->semantics = semantics;
+
+			background_data[background_count] = data;
+			background_count++;
+		}
+
+		j_helper_execute_parallel(j_distributed_object_create_background_operation, background_data, background_count);
+	}
+
+	return ret;
+}
+
+static gboolean
+j_distributed_object_delete_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* object_backend;
+	JBlockCache* cache;
+	g_autoptr(JListIterator) it = NULL;
+	g_autofree JMessage** messages = NULL;
+	gchar const* namespace = NULL;
+	gsize namespace_len = 0;
+	guint32 server_count = 0;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JDistributedObject* object;
+
+		object = j_list_get_first(operations);
+		g_assert(object != NULL);
+
+		namespace = object->namespace;
+		namespace_len = strlen(namespace) + 1;
+	}
+
+	it = j_list_iterator_new(operations);
+	object_backend = j_object_get_backend();
+
+	if (object_backend == NULL)
+	{
+		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
+		messages = g_new(JMessage*, server_count);
+
+		// FIXME use actual distribution
+		for (guint i = 0; i < server_count; i++)
+		{
+			messages[i] = j_message_new(J_MESSAGE_OBJECT_DELETE, namespace_len);
+			j_message_set_semantics(messages[i], semantics);
+			j_message_append_n(messages[i], namespace, namespace_len);
+
+			// Only the first part is always created, the others might not have been written yet
+			j_message_set_lazy_create(messages[i], i > 0);
+		}
+	}
+
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObject* object = j_list_iterator_get(it);
+
+		// Staged data is drained first, so that it does not recreate the object later
+		j_distributed_object_burst_buffer_flush(object);
+
+		if (object_backend == NULL)
+		{
+			gsize name_len;
+
+			name_len = strlen(object->name) + 1;
+
+			// FIXME use actual distribution
+			for (guint i = 0; i < server_count; i++)
+			{
+				j_message_add_operation(messages[i], name_len);
+				j_message_append_n(messages[i], object->name, name_len);
+			}
+		}
+		else
+		{
+			gboolean lret = FALSE;
+			gpointer object_handle;
+
+			if (j_backend_object_open(object_backend, object->namespace, object->name, &object_handle)
+			    && j_backend_object_delete(object_backend, object_handle))
+			{
+				lret = TRUE;
+			}
+
+			ret = lret && ret;
+		}
+	}
+
+	if (object_backend == NULL)
+	{
+		g_autofree gpointer* background_data = NULL;
+
+		background_data = g_new(gpointer, server_count);
+
+		// FIXME use actual distribution
+		for (guint i = 0; i < server_count; i++)
+		{
+			JDistributedObjectBackgroundData* data;
+
+			data = g_slice_new(JDistributedObjectBackgroundData);
+			data->index = i;
+			data->message = messages[i];
+			data->operations = NULL;
+			data->semantics = semantics;
 			data->ret = TRUE;
 
-			background_data[i] = data;
-		}
+			background_data[i] = data;
+		}
+
+		j_helper_execute_parallel(j_distributed_object_delete_background_operation, background_data, server_count);
+
+		for (guint i = 0; i < server_count; i++)
+		{
+			JDistributedObjectBackgroundData* data = background_data[i];
+
+			ret = data->ret && ret;
+
+			g_slice_free(JDistributedObjectBackgroundData, data);
+		}
+	}
+
+	if ((cache = j_block_cache_get(NULL)) != NULL)
+	{
+		j_list_iterator_free(it);
+		it = j_list_iterator_new(operations);
+
+		while (j_list_iterator_next(it))
+		{
+			JDistributedObject* object = j_list_iterator_get(it);
+
+			j_block_cache_invalidate(cache, J_BLOCK_CACHE_DISTRIBUTED, object->namespace, object->name, G_MAXUINT64, 0);
+		}
+	}
+
+	return ret;
+}
+
+/**
+ * Returns the cost of sending a part to a server.
+ * A server's load is the number of its connections in use plus the number of parts already queued for it.
+ * The load is weighted by the server's round-trip latency, so slow servers are avoided.
+ *
+ * \private
+ *
+ * \param index  The server index.
+ * \param queued The number of queued parts per server, can be NULL.
+ *
+ * \return The cost.
+ **/
+static guint64
+j_distributed_object_get_cost(guint index, guint const* queued)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 load;
+	guint64 latency;
+
+	load = j_connection_pool_get_load(J_BACKEND_TYPE_OBJECT, index) + ((queued != NULL) ? queued[index] : 0);
+	// Servers without replies yet are treated as fast, so that their latency is measured.
+	latency = j_connection_pool_get_latency(J_BACKEND_TYPE_OBJECT, index);
+
+	return (load + 1) * MAX(latency, 1);
+}
+
+/**
+ * Chooses the cheapest copy of the block returned by the last call to j_distribution_distribute().
+ * See j_distributed_object_get_cost() for how the cost is determined.
+ *
+ * \private
+ *
+ * \param object     An object.
+ * \param index      The server index, returns the chosen server.
+ * \param new_offset The offset, returns the chosen copy's offset.
+ * \param queued     The number of queued parts per server, can be NULL.
+ **/
+static void
+j_distributed_object_choose_replica(JDistributedObject* object, guint* index, guint64* new_offset, guint* queued)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint replica_index;
+	guint64 replica_offset;
+	guint64 cost;
+
+	cost = j_distributed_object_get_cost(*index, queued);
+
+	for (guint r = 1; j_distribution_distribute_replica(object->distribution, r, &replica_index, &replica_offset); r++)
+	{
+		guint64 replica_cost;
+
+		replica_cost = j_distributed_object_get_cost(replica_index, queued);
+
+		if (replica_cost < cost)
+		{
+			*index = replica_index;
+			*new_offset = replica_offset;
+			cost = replica_cost;
+		}
+	}
+
+	if (queued != NULL)
+	{
+		queued[*index]++;
+	}
+}
+
+/**
+ * Reads a range of an object from all servers in parallel.
+ *
+ * \private
+ *
+ * \param object     An object.
+ * \param semantics  The semantics.
+ * \param data       A buffer to hold the read data.
+ * \param length     Number of bytes to read.
+ * \param offset     An offset within #object.
+ * \param bytes_read Number of bytes read.
+ **/
+static void
+j_distributed_object_fetch(JDistributedObject* object, JSemantics* semantics, gchar* data, guint64 length, guint64 offset, guint64* bytes_read)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree JList** br_lists = NULL;
+	g_autofree JMessage** messages = NULL;
+	g_autofree gpointer* background_data = NULL;
+	g_autofree guint* queued = NULL;
+	gsize name_len;
+	gsize namespace_len;
+	guint32 server_count;
+	guint32 index;
+	guint64 block_id;
+	guint64 new_length;
+	guint64 new_offset;
+	gboolean checksums;
+
+	server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
+	messages = g_new0(JMessage*, server_count);
+	br_lists = g_new0(JList*, server_count);
+	queued = g_new0(guint, server_count);
+	checksums = j_configuration_get_object_checksums(j_configuration());
+
+	namespace_len = strlen(object->namespace) + 1;
+	name_len = strlen(object->name) + 1;
+
+	j_distribution_reset(object->distribution, length, offset);
+
+	while (j_distribution_distribute(object->distribution, &index, &new_length, &new_offset, &block_id))
+	{
+		JDistributedObjectReadBuffer* buffer;
+
+		j_distributed_object_choose_replica(object, &index, &new_offset, queued);
+
+		if (messages[index] == NULL)
+		{
+			messages[index] = j_message_new(J_MESSAGE_OBJECT_READ, namespace_len + name_len);
+			j_message_set_semantics(messages[index], semantics);
+			j_message_append_n(messages[index], object->namespace, namespace_len);
+			j_message_append_n(messages[index], object->name, name_len);
+
+			br_lists[index] = j_list_new(NULL);
+		}
+
+		buffer = g_slice_new(JDistributedObjectReadBuffer);
+		buffer->data = data;
+		buffer->bytes_read = bytes_read;
+		buffer->checksum = checksums;
+
+		j_distributed_object_read_add(messages[index], buffer, new_length, new_offset);
+
+		j_list_append(br_lists[index], buffer);
+
+		data += new_length;
+	}
+
+	background_data = g_new(gpointer, server_count);
+
+	for (guint i = 0; i < server_count; i++)
+	{
+		JDistributedObjectBackgroundData* bdata;
+
+		if (messages[i] == NULL)
+		{
+			background_data[i] = NULL;
+			continue;
+		}
+
+		bdata = g_slice_new(JDistributedObjectBackgroundData);
+		bdata->index = i;
+		bdata->message = messages[i];
+		bdata->operations = NULL;
+		bdata->semantics = semantics;
+		bdata->read.buffers = br_lists[i];
+
+		background_data[i] = bdata;
+	}
+
+	j_helper_execute_parallel(j_distributed_object_read_background_operation, background_data, server_count);
+}
+
+/**
+ * Serves a read from the read-ahead buffer, refilling it for sequential reads.
+ *
+ * \private
+ *
+ * \param object    An object.
+ * \param semantics The semantics.
+ * \param operation A read operation.
+ *
+ * \return TRUE if the read has been served, FALSE if it should be sent to the servers directly.
+ **/
+static gboolean
+j_distributed_object_read_ahead(JDistributedObject* object, JSemantics* semantics, JDistributedObjectOperation* operation)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+	guint64 length = operation->read.length;
+	guint64 offset = operation->read.offset;
+	guint64 available;
+
+	g_mutex_lock(object->read_ahead.mutex);
+
+	if (offset >= object->read_ahead.buffer_offset && offset + length <= object->read_ahead.buffer_offset + object->read_ahead.buffer_length)
+	{
+		// Hit, the read has been prefetched completely.
+	}
+	else if (offset == object->read_ahead.next_offset)
+	{
+		guint64 fetch_length;
+		guint64 fetched = 0;
+
+		// Sequential access, fetch the requested range plus the window in one parallel round trip.
+		fetch_length = length + object->read_ahead.window;
+
+		if (object->read_ahead.buffer_size < fetch_length)
+		{
+			g_free(object->read_ahead.buffer);
+			object->read_ahead.buffer = g_malloc(fetch_length);
+			object->read_ahead.buffer_size = fetch_length;
+		}
+
+		j_distributed_object_fetch(object, semantics, object->read_ahead.buffer, fetch_length, offset, &fetched);
+
+		object->read_ahead.buffer_offset = offset;
+		object->read_ahead.buffer_length = fetched;
+	}
+	else
+	{
+		// Random access, do not pollute the buffer.
+		object->read_ahead.next_offset = offset + length;
+		goto end;
+	}
+
+	available = object->read_ahead.buffer_offset + object->read_ahead.buffer_length - offset;
+	available = MIN(available, length);
+
+	if (offset < object->read_ahead.buffer_offset + object->read_ahead.buffer_length && available > 0)
+	{
+		memcpy(operation->read.data, object->read_ahead.buffer + (offset - object->read_ahead.buffer_offset), available);
+		j_helper_atomic_add(operation->read.bytes_read, available);
+	}
+
+	object->read_ahead.next_offset = offset + length;
+	ret = TRUE;
+
+end:
+	g_mutex_unlock(object->read_ahead.mutex);
+
+	return ret;
+}
+
+/**
+ * Drops the read-ahead buffer, for example, because the object has been modified.
+ *
+ * \private
+ *
+ * \param object An object.
+ **/
+static void
+j_distributed_object_read_ahead_invalidate(JDistributedObject* object)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_mutex_lock(object->read_ahead.mutex);
+	object->read_ahead.buffer_offset = 0;
+	object->read_ahead.buffer_length = 0;
+	g_mutex_unlock(object->read_ahead.mutex);
+}
+
+/**
+ * The layout of an erasure-coded object.
+ **/
+struct JDistributedObjectErasure
+{
+	JDistributedObject* object;
+
+	guint data_count;
+	guint parity_count;
+	guint64 block_size;
+	guint start_index;
+	guint server_count;
+
+	/**
+	 * The object's parts on each server, created on demand.
+	 **/
+	JObject** parts;
+
+	/**
+	 * Maps stripe numbers to #JDistributedObjectStripe elements.
+	 **/
+	GHashTable* stripes;
+};
+
+typedef struct JDistributedObjectErasure JDistributedObjectErasure;
+
+/**
+ * A stripe of an erasure-coded object.
+ * Stripes are always written completely, so a stripe either exists on all of its servers or not at all.
+ **/
+struct JDistributedObjectStripe
+{
+	guint64 index;
+
+	/**
+	 * The data blocks followed by the parity blocks.
+	 **/
+	guint8* blocks;
+
+	/**
+	 * The number of bytes transferred for each block.
+	 **/
+	guint64* bytes;
+
+	/**
+	 * Whether each data block is needed.
+	 **/
+	gboolean* wanted;
+
+	/**
+	 * Whether the stripe has to be read before it can be written.
+	 **/
+	gboolean partial;
+
+	/**
+	 * Whether the stripe exists.
+	 **/
+	gboolean exists;
+};
+
+typedef struct JDistributedObjectStripe JDistributedObjectStripe;
+
+static void
+j_distributed_object_stripe_free(gpointer data)
+{
+	JDistributedObjectStripe* stripe = data;
+
+	g_free(stripe->blocks);
+	g_free(stripe->bytes);
+	g_free(stripe->wanted);
+
+	g_slice_free(JDistributedObjectStripe, stripe);
+}
+
+static void
+j_distributed_object_erasure_init(JDistributedObjectErasure* erasure, JDistributedObject* object)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 value;
+
+	erasure->object = object;
+
+	j_distribution_get(object->distribution, "data", &value);
+	erasure->data_count = value;
+	j_distribution_get(object->distribution, "parity", &value);
+	erasure->parity_count = value;
+	j_distribution_get(object->distribution, "block-size", &value);
+	erasure->block_size = value;
+	j_distribution_get(object->distribution, "start-index", &value);
+	erasure->start_index = value;
+	j_distribution_get(object->distribution, "server-count", &value);
+	erasure->server_count = value;
+
+	erasure->parts = g_new0(JObject*, erasure->server_count);
+	erasure->stripes = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, j_distributed_object_stripe_free);
+}
+
+static void
+j_distributed_object_erasure_fini(JDistributedObjectErasure* erasure)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	for (guint i = 0; i < erasure->server_count; i++)
+	{
+		if (erasure->parts[i] != NULL)
+		{
+			j_object_unref(erasure->parts[i]);
+		}
+	}
+
+	g_free(erasure->parts);
+	g_hash_table_unref(erasure->stripes);
+}
+
+/**
+ * Returns the part storing a block of a stripe.
+ * Stripe s is stored on the servers starting at (start_index + s), data blocks first.
+ **/
+static JObject*
+j_distributed_object_erasure_part(JDistributedObjectErasure* erasure, guint64 stripe, guint block)
+{
+	guint index;
+
+	index = (erasure->start_index + stripe + block) % erasure->server_count;
+
+	if (erasure->parts[index] == NULL)
+	{
+		erasure->parts[index] = j_object_new_for_index(index, erasure->object->namespace, erasure->object->name);
+	}
+
+	return erasure->parts[index];
+}
+
+static JDistributedObjectStripe*
+j_distributed_object_erasure_get_stripe(JDistributedObjectErasure* erasure, guint64 index)
+{
+	JDistributedObjectStripe* stripe;
+	guint blocks = erasure->data_count + erasure->parity_count;
+
+	if ((stripe = g_hash_table_lookup(erasure->stripes, &index)) == NULL)
+	{
+		stripe = g_slice_new(JDistributedObjectStripe);
+		stripe->index = index;
+		stripe->blocks = g_malloc0(blocks * erasure->block_size);
+		stripe->bytes = g_new0(guint64, blocks);
+		stripe->wanted = g_new0(gboolean, erasure->data_count);
+		stripe->partial = FALSE;
+		stripe->exists = FALSE;
+
+		g_hash_table_insert(erasure->stripes, &(stripe->index), stripe);
+	}
+
+	return stripe;
+}
+
+/**
+ * Reads an erasure-coded object's logical size from its header.
+ *
+ * \private
+ *
+ * \param object    An object.
+ * \param size      Returns the size, 0 if it has not been stored yet.
+ * \param semantics A semantics object.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_distributed_object_erasure_get_size(JDistributedObject* object, guint64* size, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) header = NULL;
+	guint64 value = 0;
+	guint64 bytes_read = 0;
+	gboolean ret;
+
+	batch = j_batch_new(semantics);
+	header = j_distributed_object_header_new(object);
+
+	j_object_read(header, &value, sizeof(value), J_DISTRIBUTED_OBJECT_ERASURE_SIZE, &bytes_read, batch);
+	ret = j_batch_execute(batch);
+
+	*size = (bytes_read == sizeof(value)) ? GUINT64_FROM_LE(value) : 0;
+
+	return ret;
+}
+
+/**
+ * Extends an erasure-coded object's logical size stored in its header.
+ * Like the read-modify-write of partial stripes, concurrent extensions are only serialized within a process.
+ *
+ * \private
+ *
+ * \param object    An object.
+ * \param size      The size the object has at least.
+ * \param semantics A semantics object.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_distributed_object_erasure_extend_size(JDistributedObject* object, guint64 size, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 current = 0;
+	gboolean ret;
+
+	g_mutex_lock(object->header.mutex);
+
+	ret = j_distributed_object_erasure_get_size(object, &current, semantics);
+
+	if (ret && size > current)
+	{
+		g_autoptr(JBatch) batch = NULL;
+		g_autoptr(JObject) header = NULL;
+		guint64 value;
+		guint64 bytes_written = 0;
+
+		batch = j_batch_new(semantics);
+		header = j_distributed_object_header_new(object);
+		value = GUINT64_TO_LE(size);
+
+		j_object_write(header, &value, sizeof(value), J_DISTRIBUTED_OBJECT_ERASURE_SIZE, &bytes_written, batch);
+		ret = j_batch_execute(batch) && bytes_written == sizeof(value);
+	}
+
+	g_mutex_unlock(object->header.mutex);
+
+	return ret;
+}
+
+/**
+ * Registers the part of a request that falls into the object's stripes.
+ **/
+static void
+j_distributed_object_erasure_add(JDistributedObjectErasure* erasure, guint64 length, guint64 offset, gboolean write)
+{
+	guint64 stripe_size = erasure->data_count * erasure->block_size;
+
+	for (guint64 s = offset / stripe_size; s * stripe_size < offset + length; s++)
+	{
+		JDistributedObjectStripe* stripe;
+		guint64 start;
+		guint64 end;
+
+		stripe = j_distributed_object_erasure_get_stripe(erasure, s);
+
+		start = MAX(offset, s * stripe_size) - (s * stripe_size);
+		end = MIN(offset + length, (s + 1) * stripe_size) - (s * stripe_size);
+
+		for (guint64 d = start / erasure->block_size; d * erasure->block_size < end; d++)
+		{
+			stripe->wanted[d] = TRUE;
+		}
+
+		if (write && (start > 0 || end < stripe_size))
+		{
+			stripe->partial = TRUE;
+		}
+	}
+}
+
+/**
+ * Reads the wanted data blocks of stripes.
+ * If a block is missing from an existing stripe, the other blocks are read and the missing ones are reconstructed.
+ *
+ * \return TRUE on success, FALSE if too many blocks are missing.
+ **/
+static gboolean
+j_distributed_object_erasure_load(JDistributedObjectErasure* erasure, gboolean partial_only, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JBatch) degraded_batch = NULL;
+	g_autoptr(GPtrArray) degraded = NULL;
+	GHashTableIter iter;
+	gpointer value;
+	guint blocks = erasure->data_count + erasure->parity_count;
+	gboolean ret = TRUE;
+
+	batch = j_batch_new(semantics);
+
+	g_hash_table_iter_init(&iter, erasure->stripes);
+
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+	{
+		JDistributedObjectStripe* stripe = value;
+
+		if (partial_only && !stripe->partial)
+		{
+			continue;
+		}
+
+		for (guint d = 0; d < erasure->data_count; d++)
+		{
+			// Partially written stripes are read completely to compute the parity
+			if (stripe->wanted[d] || partial_only)
+			{
+				j_object_read(j_distributed_object_erasure_part(erasure, stripe->index, d), stripe->blocks + d * erasure->block_size, erasure->block_size, stripe->index * erasure->block_size, &(stripe->bytes[d]), batch);
+			}
+		}
+	}
+
+	ret = j_batch_execute(batch) && ret;
+
+	degraded = g_ptr_array_new();
+	degraded_batch = j_batch_new(semantics);
+
+	g_hash_table_iter_init(&iter, erasure->stripes);
+
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+	{
+		JDistributedObjectStripe* stripe = value;
+		gboolean incomplete = FALSE;
+
+		if (partial_only && !stripe->partial)
+		{
+			continue;
+		}
+
+		for (guint d = 0; d < erasure->data_count; d++)
+		{
+			if (stripe->wanted[d] || partial_only)
+			{
+				stripe->exists = stripe->exists || (stripe->bytes[d] > 0);
+				incomplete = incomplete || (stripe->bytes[d] < erasure->block_size);
+			}
+		}
+
+		if (!incomplete || erasure->parity_count == 0)
+		{
+			continue;
+		}
+
+		// Either the stripe does not exist or blocks are missing, the parity tells which one it is
+		for (guint b = 0; b < blocks; b++)
+		{
+			if (b >= erasure->data_count || !(stripe->wanted[b] || partial_only))
+			{
+				j_object_read(j_distributed_object_erasure_part(erasure, stripe->index, b), stripe->blocks + b * erasure->block_size, erasure->block_size, stripe->index * erasure->block_size, &(stripe->bytes[b]), degraded_batch);
+			}
+		}
+
+		g_ptr_array_add(degraded, stripe);
+	}
+
+	if (degraded->len == 0)
+	{
+		return ret;
+	}
+
+	ret = j_batch_execute(degraded_batch) && ret;
+
+	for (guint i = 0; i < degraded->len; i++)
+	{
+		JDistributedObjectStripe* stripe = g_ptr_array_index(degraded, i);
+		g_autofree guint8** pointers = NULL;
+		g_autofree gboolean* present = NULL;
+		gboolean parity = FALSE;
+
+		pointers = g_new(guint8*, blocks);
+		present = g_new(gboolean, blocks);
+
+		for (guint b = 0; b < blocks; b++)
+		{
+			pointers[b] = stripe->blocks + b * erasure->block_size;
+			present[b] = (stripe->bytes[b] == erasure->block_size);
+
+			if (b >= erasure->data_count)
+			{
+				parity = parity || present[b];
+			}
+		}
+
+		if (!parity && !stripe->exists)
+		{
+			// The stripe has not been written yet
+			continue;
+		}
+
+		if (!j_reed_solomon_reconstruct(erasure->data_count, erasure->parity_count, pointers, present, erasure->block_size))
+		{
+			ret = FALSE;
+			continue;
+		}
+
+		stripe->exists = TRUE;
+	}
+
+	return ret;
+}
+
+/**
+ * Reads from an erasure-coded object.
+ * Only the data blocks covering the requests are read unless blocks have to be reconstructed.
+ **/
+static gboolean
+j_distributed_object_read_erasure(JDistributedObject* object, JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectErasure erasure;
+	g_autoptr(JListIterator) it = NULL;
+	guint64 stripe_size;
+	guint64 size = 0;
+	gboolean ret;
+
+	// Stripes are padded, only the logical size tells where the object ends
+	if (!j_distributed_object_erasure_get_size(object, &size, semantics))
+	{
+		return FALSE;
+	}
+
+	j_distributed_object_erasure_init(&erasure, object);
+	stripe_size = erasure.data_count * erasure.block_size;
+
+	it = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+		guint64 offset = operation->read.offset;
+		guint64 length;
+
+		length = (offset < size) ? MIN(operation->read.length, size - offset) : 0;
+
+		if (length > 0)
+		{
+			j_distributed_object_erasure_add(&erasure, length, offset, FALSE);
+		}
+	}
+
+	ret = j_distributed_object_erasure_load(&erasure, FALSE, semantics);
+
+	j_list_iterator_free(it);
+	it = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+		guint64 offset = operation->read.offset;
+		gchar* data = operation->read.data;
+		guint64 length;
+		guint64 nbytes = 0;
+
+		length = (offset < size) ? MIN(operation->read.length, size - offset) : 0;
+
+		while (length > 0)
+		{
+			JDistributedObjectStripe* stripe;
+			guint64 s = offset / stripe_size;
+			guint64 displacement = offset % stripe_size;
+			guint64 chunk;
+
+			stripe = g_hash_table_lookup(erasure.stripes, &s);
+
+			// Reads end at the first stripe that does not exist
+			if (stripe == NULL || !stripe->exists)
+			{
+				break;
+			}
+
+			chunk = MIN(length, stripe_size - displacement);
+			memcpy(data, stripe->blocks + displacement, chunk);
+
+			data += chunk;
+			length -= chunk;
+			offset += chunk;
+			nbytes += chunk;
+		}
+
+		j_helper_atomic_add(operation->read.bytes_read, nbytes);
+	}
+
+	j_distributed_object_erasure_fini(&erasure);
+
+	return ret;
+}
+
+/**
+ * Writes to an erasure-coded object.
+ * Stripes are always written completely, partially written stripes are read first.
+ **/
+static gboolean
+j_distributed_object_write_erasure(JDistributedObject* object, JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectErasure erasure;
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JListIterator) it = NULL;
+	g_autofree guint8** pointers = NULL;
+	GHashTableIter iter;
+	gpointer value;
+	guint blocks;
+	guint64 stripe_size;
+	guint64 size = 0;
+	gboolean ret;
+
+	j_distributed_object_erasure_init(&erasure, object);
+	blocks = erasure.data_count + erasure.parity_count;
+	stripe_size = erasure.data_count * erasure.block_size;
+
+	it = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+
+		j_distributed_object_erasure_add(&erasure, operation->write.length, operation->write.offset, TRUE);
+		size = MAX(size, operation->write.offset + operation->write.length);
+	}
+
+	ret = j_distributed_object_erasure_load(&erasure, TRUE, semantics);
+
+	if (!ret)
+	{
+		goto end;
+	}
+
+	j_list_iterator_free(it);
+	it = j_list_iterator_new(operations);
+
+	// Apply the writes in order
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+		guint64 length = operation->write.length;
+		guint64 offset = operation->write.offset;
+		gchar const* data = operation->write.data;
+
+		while (length > 0)
+		{
+			JDistributedObjectStripe* stripe;
+			guint64 s = offset / stripe_size;
+			guint64 displacement = offset % stripe_size;
+			guint64 chunk;
+
+			stripe = g_hash_table_lookup(erasure.stripes, &s);
+			chunk = MIN(length, stripe_size - displacement);
+			memcpy(stripe->blocks + displacement, data, chunk);
+
+			data += chunk;
+			length -= chunk;
+			offset += chunk;
+		}
+	}
+
+	batch = j_batch_new(semantics);
+	pointers = g_new(guint8*, blocks);
+
+	g_hash_table_iter_init(&iter, erasure.stripes);
+
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+	{
+		JDistributedObjectStripe* stripe = value;
+
+		for (guint b = 0; b < blocks; b++)
+		{
+			pointers[b] = stripe->blocks + b * erasure.block_size;
+		}
+
+		j_reed_solomon_encode(erasure.data_count, erasure.parity_count, pointers, pointers + erasure.data_count, erasure.block_size);
+
+		for (guint b = 0; b < blocks; b++)
+		{
+			j_object_write(j_distributed_object_erasure_part(&erasure, stripe->index, b), pointers[b], erasure.block_size, stripe->index * erasure.block_size, &(stripe->bytes[b]), batch);
+		}
+	}
+
+	ret = j_batch_execute(batch);
+
+	// The size is only extended once the data is in place, so that reads never see padding
+	ret = ret && j_distributed_object_erasure_extend_size(object, size, semantics);
+
+	if (ret)
+	{
+		j_list_iterator_free(it);
+		it = j_list_iterator_new(operations);
+
+		while (j_list_iterator_next(it))
+		{
+			JDistributedObjectOperation* operation = j_list_iterator_get(it);
+
+			j_helper_atomic_add(operation->write.bytes_written, operation->write.length);
+		}
+	}
+
+end:
+	j_distributed_object_erasure_fini(&erasure);
+
+	return ret;
+}
+
+static void
+j_distributed_object_hedge_unref(JDistributedObjectHedge* hedge)
+{
+	if (!g_atomic_int_dec_and_test(&(hedge->ref_count)))
+	{
+		return;
+	}
+
+	for (guint i = 0; i < G_N_ELEMENTS(hedge->attempts); i++)
+	{
+		JDistributedObjectHedgeAttempt* attempt = &(hedge->attempts[i]);
+
+		if (attempt->buffers != NULL)
+		{
+			g_autoptr(JListIterator) it = NULL;
+
+			it = j_list_iterator_new(attempt->buffers);
+
+			while (j_list_iterator_next(it))
+			{
+				g_slice_free(JDistributedObjectReadBuffer, j_list_iterator_get(it));
+			}
+
+			j_list_unref(attempt->buffers);
+		}
+
+		if (attempt->message != NULL)
+		{
+			j_message_unref(attempt->message);
+		}
+
+		g_free(attempt->scratch);
+	}
+
+	g_mutex_clear(hedge->mutex);
+	g_cond_clear(hedge->cond);
+
+	g_slice_free(JDistributedObjectHedge, hedge);
+}
+
+/**
+ * Creates a hedged read.
+ *
+ * \private
+ *
+ * \param object    An object.
+ * \param semantics The semantics.
+ * \param index     The server to read from first.
+ * \param alternate A server holding another copy, or the number of servers if there is none.
+ *
+ * \return A new hedged read.
+ **/
+static JDistributedObjectHedge*
+j_distributed_object_hedge_new(JDistributedObject* object, JSemantics* semantics, guint32 index, guint32 alternate)
+{
+	JDistributedObjectHedge* hedge;
+	gsize name_len;
+	gsize namespace_len;
+
+	namespace_len = strlen(object->namespace) + 1;
+	name_len = strlen(object->name) + 1;
+
+	hedge = g_slice_new0(JDistributedObjectHedge);
+	hedge->ref_count = 1;
+	g_mutex_init(hedge->mutex);
+	g_cond_init(hedge->cond);
+	hedge->targets = j_list_new(NULL);
+	hedge->length = 0;
+
+	hedge->attempts[0].index = index;
+	hedge->attempts[1].index = alternate;
+
+	for (guint i = 0; i < G_N_ELEMENTS(hedge->attempts); i++)
+	{
+		JDistributedObjectHedgeAttempt* attempt = &(hedge->attempts[i]);
+
+		attempt->hedge = hedge;
+
+		if (i > 0 && alternate >= j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT))
+		{
+			continue;
+		}
+
+		attempt->message = j_message_new(J_MESSAGE_OBJECT_READ, namespace_len + name_len);
+		j_message_set_semantics(attempt->message, semantics);
+		j_message_append_n(attempt->message, object->namespace, namespace_len);
+		j_message_append_n(attempt->message, object->name, name_len);
+	}
+
+	return hedge;
+}
+
+static void
+j_distributed_object_hedge_attempt(gpointer data, gpointer user_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectHedgeAttempt* attempt = data;
+	JDistributedObjectHedge* hedge = attempt->hedge;
+
+	gpointer object_connection;
+	gboolean success = FALSE;
+
+	(void)user_data;
+
+	if ((object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, attempt->index)) != NULL)
+	{
+		success = j_message_send(attempt->message, object_connection) && j_distributed_object_read_receive(attempt->index, attempt->message, attempt->buffers, object_connection);
+
+		if (success)
+		{
+			j_connection_pool_push(J_BACKEND_TYPE_OBJECT, attempt->index, object_connection);
+		}
+		else
+		{
+			j_connection_pool_discard(J_BACKEND_TYPE_OBJECT, attempt->index, object_connection);
+		}
+	}
+
+	g_mutex_lock(hedge->mutex);
+	attempt->done = TRUE;
+	attempt->success = success;
+	g_cond_signal(hedge->cond);
+	g_mutex_unlock(hedge->mutex);
+
+	j_distributed_object_hedge_unref(hedge);
+}
+
+/**
+ * Sends one request of a hedged read.
+ * The request runs in its own thread, so that the hedged read does not have to wait for it.
+ *
+ * \private
+ *
+ * \param hedge A hedged read.
+ * \param i     The attempt to start.
+ **/
+static void
+j_distributed_object_hedge_start(JDistributedObjectHedge* hedge, guint i)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	static GThreadPool* thread_pool = NULL;
+
+	JDistributedObjectHedgeAttempt* attempt = &(hedge->attempts[i]);
+
+	g_autoptr(JListIterator) it = NULL;
+	gchar* data;
+
+	if (g_once_init_enter(&thread_pool))
+	{
+		g_once_init_leave(&thread_pool, g_thread_pool_new(j_distributed_object_hedge_attempt, NULL, -1, FALSE, NULL));
+	}
+
+	attempt->scratch = g_malloc(hedge->length);
+	attempt->buffers = j_list_new(NULL);
+	data = attempt->scratch;
+
+	it = j_list_iterator_new(hedge->targets);
+
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectReadBuffer* target = j_list_iterator_get(it);
+		JDistributedObjectReadBuffer* buffer;
+
+		buffer = g_slice_new(JDistributedObjectReadBuffer);
+		buffer->data = data;
+		buffer->bytes_read = NULL;
+		buffer->checksum = target->checksum;
+		buffer->length = 0;
+		buffer->crc = 0;
+
+		j_list_append(attempt->buffers, buffer);
+
+		data += target->length;
+	}
+
+	attempt->started = TRUE;
+
+	g_atomic_int_inc(&(hedge->ref_count));
+	g_thread_pool_push(thread_pool, attempt, NULL);
+}
+
+/**
+ * Executes a hedged read in a background operation.
+ * The read is sent to a second server if the first one has not replied within its 95th percentile latency or has failed.
+ * The first successful reply is copied into the targets.
+ *
+ * \private
+ *
+ * \param data A hedged read.
+ *
+ * \return NULL.
+ **/
+static gpointer
+j_distributed_object_read_hedged_background_operation(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectHedge* hedge = data;
+	JDistributedObjectHedgeAttempt* winner = NULL;
+
+	g_autoptr(JListIterator) it = NULL;
+	g_autoptr(JListIterator) winner_it = NULL;
+	guint64 delay;
+
+	delay = j_connection_pool_get_latency_p95(J_BACKEND_TYPE_OBJECT, hedge->attempts[0].index);
+
+	j_distributed_object_hedge_start(hedge, 0);
+
+	g_mutex_lock(hedge->mutex);
+
+	if (delay > 0)
+	{
+		gint64 end_time;
+
+		end_time = g_get_monotonic_time() + (gint64)delay;
+
+		while (!hedge->attempts[0].done && g_cond_wait_until(hedge->cond, hedge->mutex, end_time))
+		{
+		}
+	}
+	else
+	{
+		// Without a latency estimate, the other copy is only used if the first server fails
+		while (!hedge->attempts[0].done)
+		{
+			g_cond_wait(hedge->cond, hedge->mutex);
+		}
+	}
+
+	if (!hedge->attempts[0].success && hedge->attempts[1].message != NULL)
+	{
+		g_mutex_unlock(hedge->mutex);
+		j_distributed_object_hedge_start(hedge, 1);
+		g_mutex_lock(hedge->mutex);
+	}
+
+	while (TRUE)
+	{
+		gboolean pending = FALSE;
+
+		for (guint i = 0; i < G_N_ELEMENTS(hedge->attempts) && winner == NULL; i++)
+		{
+			JDistributedObjectHedgeAttempt* attempt = &(hedge->attempts[i]);
+
+			if (attempt->success)
+			{
+				winner = attempt;
+			}
+
+			pending = pending || (attempt->started && !attempt->done);
+		}
+
+		if (winner != NULL || !pending)
+		{
+			break;
+		}
+
+		g_cond_wait(hedge->cond, hedge->mutex);
+	}
+
+	g_mutex_unlock(hedge->mutex);
+
+	it = j_list_iterator_new(hedge->targets);
+
+	if (winner != NULL)
+	{
+		winner_it = j_list_iterator_new(winner->buffers);
+	}
+
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectReadBuffer* target = j_list_iterator_get(it);
+
+		if (winner_it != NULL && j_list_iterator_next(winner_it))
+		{
+			JDistributedObjectReadBuffer* buffer = j_list_iterator_get(winner_it);
+
+			memcpy(target->data, buffer->data, buffer->length);
+			j_helper_atomic_add(target->bytes_read, buffer->length);
+		}
+
+		g_slice_free(JDistributedObjectReadBuffer, target);
+	}
+
+	j_list_unref(hedge->targets);
+	hedge->targets = NULL;
+
+	j_distributed_object_hedge_unref(hedge);
+
+	return NULL;
+}
+
+/**
+ * Reads from a replicated object using hedged reads.
+ * The blocks are grouped by the server they are read from and a server holding another copy.
+ *
+ * \private
+ *
+ * \param object     An object.
+ * \param operations A list of read operations.
+ * \param semantics  The semantics.
+ *
+ * \return TRUE.
+ **/
+static gboolean
+j_distributed_object_read_hedged(JDistributedObject* object, JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GHashTable) hedges = NULL;
+	g_autoptr(JListIterator) it = NULL;
+	g_autofree gpointer* background_data = NULL;
+	g_autofree guint* queued = NULL;
+	GHashTableIter iter;
+	gpointer value;
+	guint32 server_count;
+	gboolean checksums;
+	guint n = 0;
+
+	server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
+	checksums = j_configuration_get_object_checksums(j_configuration());
+	queued = g_new0(guint, server_count);
+	hedges = g_hash_table_new(NULL, NULL);
+
+	it = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+		gchar* new_data = operation->read.data;
+		guint64 length = operation->read.length;
+		guint64 offset = operation->read.offset;
+		guint32 index;
+		guint64 block_id;
+		guint64 new_length;
+		guint64 new_offset;
+
+		j_trace_file_begin(object->name, J_TRACE_FILE_READ);
+
+		if (object->read_ahead.window > 0 && j_distributed_object_read_ahead(object, semantics, operation))
+		{
+			j_trace_file_end(object->name, J_TRACE_FILE_READ, length, offset);
+			continue;
+		}
+
+		j_distribution_reset(object->distribution, length, offset);
+
+		while (j_distribution_distribute(object->distribution, &index, &new_length, &new_offset, &block_id))
+		{
+			JDistributedObjectHedge* hedge;
+			JDistributedObjectReadBuffer* buffer;
+			gpointer key;
+			guint32 first_index = index;
+			guint64 first_offset = new_offset;
+			guint32 alternate = server_count;
+			guint64 alternate_offset = 0;
+			guint32 replica_index;
+			guint64 replica_offset;
+
+			j_distributed_object_choose_replica(object, &index, &new_offset, queued);
+
+			if (first_index != index)
+			{
+				alternate = first_index;
+				alternate_offset = first_offset;
+			}
+
+			for (guint r = 1; alternate == server_count && j_distribution_distribute_replica(object->distribution, r, &replica_index, &replica_offset); r++)
+			{
+				if (replica_index != index)
+				{
+					alternate = replica_index;
+					alternate_offset = replica_offset;
+				}
+			}
+
+			key = GUINT_TO_POINTER(index * (server_count + 1) + alternate);
+
+			if ((hedge = g_hash_table_lookup(hedges, key)) == NULL)
+			{
+				hedge = j_distributed_object_hedge_new(object, semantics, index, alternate);
+				g_hash_table_insert(hedges, key, hedge);
+			}
+
+			// The requested length is kept to lay out the attempts' private buffers
+			buffer = g_slice_new(JDistributedObjectReadBuffer);
+			buffer->data = new_data;
+			buffer->bytes_read = operation->read.bytes_read;
+			buffer->checksum = checksums;
+			buffer->length = new_length;
+			buffer->crc = 0;
+
+			j_distributed_object_read_add(hedge->attempts[0].message, buffer, new_length, new_offset);
+
+			if (hedge->attempts[1].message != NULL)
+			{
+				j_distributed_object_read_add(hedge->attempts[1].message, buffer, new_length, alternate_offset);
+			}
+
+			j_list_append(hedge->targets, buffer);
+			hedge->length += new_length;
+
+			new_data += new_length;
+		}
+
+		j_trace_file_end(object->name, J_TRACE_FILE_READ, length, offset);
+	}
+
+	background_data = g_new(gpointer, g_hash_table_size(hedges));
+
+	g_hash_table_iter_init(&iter, hedges);
+
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+	{
+		background_data[n] = value;
+		n++;
+	}
+
+	j_helper_execute_parallel(j_distributed_object_read_hedged_background_operation, background_data, n);
+
+	return TRUE;
+}
+
+static gboolean
+j_distributed_object_read_exec_uncached(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	// FIXME check return value for messages
+	gboolean ret = TRUE;
+
+	JBackend* object_backend;
+	g_autofree JList** br_lists = NULL;
+	g_autoptr(JListIterator) it = NULL;
+	g_autofree JMessage** messages = NULL;
+	g_autofree guint* queued = NULL;
+	JDistributedObject* object = NULL;
+	gpointer object_handle;
+	gsize name_len = 0;
+	gsize namespace_len = 0;
+	guint32 server_count = 0;
+	gboolean checksums;
+
+	// FIXME
+	//JLock* lock = NULL;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	checksums = j_configuration_get_object_checksums(j_configuration());
+
+	{
+		JDistributedObjectOperation* operation = j_list_get_first(operations);
+		g_assert(operation != NULL);
+
+		object = operation->read.object;
+		g_assert(object != NULL);
+	}
+
+	it = j_list_iterator_new(operations);
+	object_backend = j_object_get_backend();
+
+	if (object_backend == NULL && !j_distributed_object_load_distribution(object, semantics))
+	{
+		return FALSE;
+	}
+
+	if (object_backend == NULL && j_distribution_get_type(object->distribution) == J_DISTRIBUTION_ERASURE)
+	{
+		return j_distributed_object_read_erasure(object, operations, semantics);
+	}
+
+	if (object_backend == NULL && j_configuration_get_hedged_reads(j_configuration()) && j_distribution_get_type(object->distribution) == J_DISTRIBUTION_REPLICATED)
+	{
+		return j_distributed_object_read_hedged(object, operations, semantics);
+	}
+
+	if (object_backend == NULL)
+	{
+		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
+		messages = g_new(JMessage*, server_count);
+		br_lists = g_new(JList*, server_count);
+		queued = g_new0(guint, server_count);
+
+		namespace_len = strlen(object->namespace) + 1;
+		name_len = strlen(object->name) + 1;
+
+		for (guint i = 0; i < server_count; i++)
+		{
+			messages[i] = NULL;
+			br_lists[i] = NULL;
+		}
+	}
+	else
+	{
+		ret = j_backend_object_open(object_backend, object->namespace, object->name, &object_handle) && ret;
+	}
+
+	/*
+	if (j_semantics_get(semantics, J_SEMANTICS_ATOMICITY) != J_SEMANTICS_ATOMICITY_NONE)
+	{
+		lock = j_lock_new("object", path);
+	}
+	*/
+
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+		gpointer data = operation->read.data;
+		guint64 length = operation->read.length;
+		guint64 offset = operation->read.offset;
+		guint64* bytes_read = operation->read.bytes_read;
+
+		j_trace_file_begin(object->name, J_TRACE_FILE_READ);
+
+		if (object_backend == NULL && object->read_ahead.window > 0 && j_distributed_object_read_ahead(object, semantics, operation))
+		{
+			// Served from the read-ahead buffer.
+		}
+		else if (object_backend == NULL)
+		{
+			gchar* new_data;
+			guint32 index;
+			guint64 block_id;
+			guint64 new_length;
+			guint64 new_offset;
+
+			j_distribution_reset(object->distribution, length, offset);
+			new_data = data;
+
+			while (j_distribution_distribute(object->distribution, &index, &new_length, &new_offset, &block_id))
+			{
+				JDistributedObjectReadBuffer* buffer;
+
+				// Spread reads of replicated blocks across their copies
+				j_distributed_object_choose_replica(object, &index, &new_offset, queued);
+
+				if (messages[index] == NULL && br_lists[index] == NULL)
+				{
+					messages[index] = j_message_new(J_MESSAGE_OBJECT_READ, namespace_len + name_len);
+					j_message_set_semantics(messages[index], semantics);
+					j_message_append_n(messages[index], object->namespace, namespace_len);
+					j_message_append_n(messages[index], object->name, name_len);
+
+					br_lists[index] = j_list_new(NULL);
+				}
+
+				buffer = g_slice_new(JDistributedObjectReadBuffer);
+				buffer->data = new_data;
+				buffer->bytes_read = bytes_read;
+				buffer->checksum = checksums;
+
+				j_distributed_object_read_add(messages[index], buffer, new_length, new_offset);
+
+				j_list_append(br_lists[index], buffer);
+
+				/*
+				if (lock != NULL)
+				{
+					j_lock_add(lock, block_id);
+				}
+				*/
+
+				new_data += new_length;
+			}
+		}
+		else
+		{
+			guint64 nbytes = 0;
+
+			ret = j_backend_object_read(object_backend, object_handle, data, length, offset, &nbytes) && ret;
+			j_helper_atomic_add(bytes_read, nbytes);
+		}
+
+		j_trace_file_end(object->name, J_TRACE_FILE_READ, length, offset);
+	}
+
+	if (object_backend == NULL)
+	{
+		g_autofree gpointer* background_data = NULL;
+
+		background_data = g_new(gpointer, server_count);
+
+		for (guint i = 0; i < server_count; i++)
+		{
+			JDistributedObjectBackgroundData* data;
+
+			if (messages[i] == NULL)
+			{
+				background_data[i] = NULL;
+				continue;
+			}
+
+			data = g_slice_new(JDistributedObjectBackgroundData);
+			data->index = i;
+			data->message = messages[i];
+			data->operations = NULL;
+			data->semantics = semantics;
+			data->read.buffers = br_lists[i];
+
+			background_data[i] = data;
+		}
+
+		j_helper_execute_parallel(j_distributed_object_read_background_operation, background_data, server_count);
+	}
+	else
+	{
+		ret = j_backend_object_close(object_backend, object_handle) && ret;
+	}
+
+	/*
+	if (lock != NULL)
+	{
+		// FIXME busy wait
+		while (!j_lock_acquire(lock));
+
+		j_lock_free(lock);
+	}
+	*/
+
+	return ret;
+}
+
+/**
+ * Executes reduce operations on one server in a background operation.
+ *
+ * \private
+ *
+ * \param data Background data.
+ *
+ * \return NULL.
+ **/
+static gpointer
+j_distributed_object_reduce_background_operation(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectBackgroundData* background_data = data;
+
+	g_autoptr(JListIterator) it = NULL;
+	g_autoptr(JMessage) reply = NULL;
+	gpointer object_connection;
+
+	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
+	j_message_send(background_data->message, object_connection);
+
+	reply = j_message_new_reply(background_data->message);
+	j_message_receive(reply, object_connection);
+
+	it = j_list_iterator_new(background_data->reduce.parts);
+
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectReducePart* part = j_list_iterator_get(it);
+
+		if (j_message_get_4(reply) != 0)
+		{
+			j_reduce_merge_from_message(part->reduce, reply);
+		}
+		else
+		{
+			part->success = FALSE;
+		}
+	}
+
+	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+
+	j_message_unref(background_data->message);
+	j_list_unref(background_data->reduce.parts);
+
+	g_slice_free(JDistributedObjectBackgroundData, background_data);
+
+	return NULL;
+}
+
+/**
+ * Reduces a range by reading it, used if the servers cannot reduce their parts themselves.
+ *
+ * \private
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_distributed_object_reduce_fetch(JDistributedObject* object, JSemantics* semantics, JReduce* reduce, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	g_autofree gchar* buffer = NULL;
+	guint64 buffer_size;
+
+	// The buffer has to consist of whole elements.
+	buffer_size = j_configuration_get_max_operation_size(j_configuration());
+	buffer_size = MIN(length, buffer_size - (buffer_size % sizeof(guint64)));
+	buffer = g_malloc(buffer_size);
+
+	while (ret && length > 0)
+	{
+		g_autoptr(JList) operations = NULL;
+		JDistributedObjectOperation read;
+		guint64 bytes_read = 0;
+
+		read.read.object = object;
+		read.read.data = buffer;
+		read.read.length = MIN(length, buffer_size);
+		read.read.offset = offset;
+		read.read.bytes_read = &bytes_read;
+
+		operations = j_list_new(NULL);
+		j_list_append(operations, &read);
+
+		ret = j_distributed_object_read_exec_uncached(operations, semantics);
+
+		j_reduce_process(reduce, buffer, bytes_read);
+
+		if (bytes_read < read.read.length)
+		{
+			break;
+		}
+
+		length -= read.read.length;
+		offset += read.read.length;
+	}
+
+	return ret;
+}
+
+static gboolean
+j_distributed_object_reduce_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	g_autoptr(JListIterator) it = NULL;
+	g_autofree JMessage** messages = NULL;
+	g_autofree JList** part_lists = NULL;
+	g_autofree JDistributedObjectReducePart* parts = NULL;
+	g_autofree gpointer* background_data = NULL;
+	g_autofree guint* queued = NULL;
+	JDistributedObject* object;
+	gsize name_len;
+	gsize namespace_len;
+	guint32 operation_count;
+	guint32 server_count;
+	guint32 op;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JDistributedObjectOperation* operation = j_list_get_first(operations);
+		g_assert(operation != NULL);
+
+		object = operation->reduce.object;
+		g_assert(object != NULL);
+	}
+
+	j_distributed_object_burst_buffer_flush(object);
+
+	it = j_list_iterator_new(operations);
+
+	if (j_object_get_backend() == NULL && !j_distributed_object_load_distribution(object, semantics))
+	{
+		return FALSE;
+	}
+
+	// Erasure-coded stripes and local backends are reduced on the client.
+	if (j_object_get_backend() != NULL || j_distribution_get_type(object->distribution) == J_DISTRIBUTION_ERASURE)
+	{
+		while (j_list_iterator_next(it))
+		{
+			JDistributedObjectOperation* operation = j_list_iterator_get(it);
+			gboolean success;
+
+			success = j_distributed_object_reduce_fetch(object, semantics, operation->reduce.reduce, operation->reduce.length, operation->reduce.offset);
+			ret = success && ret;
+
+			if (operation->reduce.success != NULL)
+			{
+				*(operation->reduce.success) = success;
+			}
+		}
+
+		return ret;
+	}
+
+	server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
+	operation_count = j_list_length(operations);
+
+	messages = g_new0(JMessage*, server_count);
+	part_lists = g_new0(JList*, server_count);
+	queued = g_new0(guint, server_count);
+
+	// Each server reduces its parts independently, the results are merged afterwards.
+	parts = g_new(JDistributedObjectReducePart, server_count * operation_count);
+
+	namespace_len = strlen(object->namespace) + 1;
+	name_len = strlen(object->name) + 1;
+
+	for (op = 0; j_list_iterator_next(it); op++)
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+		guint32 index;
+		guint64 block_id;
+		guint64 new_length;
+		guint64 new_offset;
+
+		for (guint i = 0; i < server_count; i++)
+		{
+			parts[i * operation_count + op].reduce = j_reduce_new_like(operation->reduce.reduce);
+			parts[i * operation_count + op].success = TRUE;
+		}
+
+		j_distribution_reset(object->distribution, operation->reduce.length, operation->reduce.offset);
+
+		while (j_distribution_distribute(object->distribution, &index, &new_length, &new_offset, &block_id))
+		{
+			j_distributed_object_choose_replica(object, &index, &new_offset, queued);
+
+			if (messages[index] == NULL)
+			{
+				messages[index] = j_message_new(J_MESSAGE_OBJECT_REDUCE, namespace_len + name_len);
+				j_message_set_semantics(messages[index], semantics);
+				j_message_set_lazy_create(messages[index], TRUE);
+				j_message_append_n(messages[index], object->namespace, namespace_len);
+				j_message_append_n(messages[index], object->name, name_len);
+
+				part_lists[index] = j_list_new(NULL);
+			}
+
+			j_message_add_operation(messages[index], j_reduce_get_spec_size() + sizeof(guint64) + sizeof(guint64));
+			j_reduce_append_spec(operation->reduce.reduce, messages[index]);
+			j_message_append_8(messages[index], &new_length);
+			j_message_append_8(messages[index], &new_offset);
+
+			j_list_append(part_lists[index], &(parts[index * operation_count + op]));
+		}
+	}
+
+	background_data = g_new(gpointer, server_count);
+
+	for (guint i = 0; i < server_count; i++)
+	{
+		JDistributedObjectBackgroundData* data;
+
+		if (messages[i] == NULL)
+		{
+			background_data[i] = NULL;
+			continue;
+		}
+
+		data = g_slice_new(JDistributedObjectBackgroundData);
+		data->index = i;
+		data->message = messages[i];
+		data->operations = NULL;
+		data->semantics = semantics;
+		data->reduce.parts = part_lists[i];
+
+		background_data[i] = data;
+	}
+
+	j_helper_execute_parallel(j_distributed_object_reduce_background_operation, background_data, server_count);
+
+	j_list_iterator_free(it);
+	it = j_list_iterator_new(operations);
+
+	for (op = 0; j_list_iterator_next(it); op++)
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+		gboolean success = TRUE;
+
+		for (guint i = 0; i < server_count; i++)
+		{
+			JDistributedObjectReducePart* part = &(parts[i * operation_count + op]);
+
+			j_reduce_merge(operation->reduce.reduce, part->reduce);
+			success = part->success && success;
+
+			j_reduce_unref(part->reduce);
+		}
+
+		ret = success && ret;
+
+		if (operation->reduce.success != NULL)
+		{
+			*(operation->reduce.success) = success;
+		}
+	}
+
+	return ret;
+}
+
+/**
+ * Starts a new run with a single write.
+ *
+ * \private
+ *
+ * \param operation A write operation.
+ *
+ * \return A new run.
+ **/
+static JDistributedObjectWriteRun*
+j_distributed_object_write_run_new(JDistributedObjectOperation* operation)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectWriteRun* run;
+
+	run = g_slice_new(JDistributedObjectWriteRun);
+	run->buffer_size = MAX(2 * operation->write.length, 64 * 1024);
+	run->buffer = g_malloc(run->buffer_size);
+	run->bytes_written = 0;
+	run->operations = g_ptr_array_new();
+
+	memcpy(run->buffer, operation->write.data, operation->write.length);
+	g_ptr_array_add(run->operations, operation);
+
+	run->operation.write.object = operation->write.object;
+	run->operation.write.data = run->buffer;
+	run->operation.write.length = operation->write.length;
+	run->operation.write.offset = operation->write.offset;
+	run->operation.write.bytes_written = &(run->bytes_written);
+
+	return run;
+}
+
+/**
+ * Finishes a run, reporting the bytes written to the original writes.
+ *
+ * \private
+ *
+ * \param run A run.
+ **/
+static void
+j_distributed_object_write_run_free(JDistributedObjectWriteRun* run)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 remaining = run->bytes_written;
+
+	for (guint i = 0; i < run->operations->len; i++)
+	{
+		JDistributedObjectOperation* operation = g_ptr_array_index(run->operations, i);
+		guint64 nbytes;
+
+		// Overlapping writes have all succeeded if the merged write has.
+		if (run->bytes_written == run->operation.write.length)
+		{
+			nbytes = operation->write.length;
+		}
+		else
+		{
+			nbytes = MIN(remaining, operation->write.length);
+			remaining -= nbytes;
+		}
+
+		j_helper_atomic_add(operation->write.bytes_written, nbytes);
+	}
+
+	g_ptr_array_unref(run->operations);
+	g_free(run->buffer);
+
+	g_slice_free(JDistributedObjectWriteRun, run);
+}
+
+/**
+ * Merges adjacent or overlapping small writes.
+ *
+ * Writes are merged in order, so later writes take precedence for overlapping ranges.
+ * Runs do not grow beyond #limit bytes and writes of at least #limit bytes are left alone.
+ *
+ * \private
+ *
+ * \param operations A list of write operations.
+ * \param limit      The maximum size of a merged write.
+ * \param runs       An array to store the runs in, has to be freed after the writes have been executed.
+ *
+ * \return A list of write operations.
+ **/
+static JList*
+j_distributed_object_write_coalesce(JList* operations, guint64 limit, GPtrArray* runs)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JListIterator) it = NULL;
+	JList* coalesced;
+	JDistributedObjectOperation* pending = NULL;
+	JDistributedObjectWriteRun* run = NULL;
+
+	coalesced = j_list_new(NULL);
+	it = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+		guint64 start;
+		guint64 end;
+
+		if (pending != NULL)
+		{
+			start = pending->write.offset;
+			end = pending->write.offset + pending->write.length;
+
+			if (operation->write.length < limit
+			    && operation->write.offset >= start
+			    && operation->write.offset <= end
+			    && MAX(end, operation->write.offset + operation->write.length) - start <= limit)
+			{
+				guint64 new_end;
+
+				if (run == NULL)
+				{
+					run = j_distributed_object_write_run_new(pending);
+					g_ptr_array_add(runs, run);
+					pending = &(run->operation);
+				}
+
+				new_end = MAX(end, operation->write.offset + operation->write.length);
+
+				if (new_end - start > run->buffer_size)
+				{
+					run->buffer_size = MIN(MAX(2 * run->buffer_size, new_end - start), limit);
+					run->buffer = g_realloc(run->buffer, run->buffer_size);
+					run->operation.write.data = run->buffer;
+				}
+
+				memcpy(run->buffer + (operation->write.offset - start), operation->write.data, operation->write.length);
+				g_ptr_array_add(run->operations, operation);
+				run->operation.write.length = new_end - start;
+
+				continue;
+			}
+
+			j_list_append(coalesced, pending);
+			pending = NULL;
+			run = NULL;
+		}
+
+		if (operation->write.length < limit)
+		{
+			pending = operation;
+		}
+		else
+		{
+			j_list_append(coalesced, operation);
+		}
+	}
+
+	if (pending != NULL)
+	{
+		j_list_append(coalesced, pending);
+	}
+
+	return coalesced;
+}
+
+struct JDistributedObjectCacheFetch
+{
+	JDistributedObject* object;
+	JSemantics* semantics;
+};
+
+typedef struct JDistributedObjectCacheFetch JDistributedObjectCacheFetch;
+
+static gboolean
+j_distributed_object_read_cache_fetch(JBlockCacheRead* reads, guint count, gpointer user_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectCacheFetch* fetch = user_data;
+
+	g_autoptr(JList) operations = NULL;
+	g_autofree JDistributedObjectOperation* fetch_operations = NULL;
+
+	operations = j_list_new(NULL);
+	fetch_operations = g_new(JDistributedObjectOperation, count);
+
+	for (guint i = 0; i < count; i++)
+	{
+		fetch_operations[i].read.object = fetch->object;
+		fetch_operations[i].read.data = reads[i].data;
+		fetch_operations[i].read.length = reads[i].length;
+		fetch_operations[i].read.offset = reads[i].offset;
+		fetch_operations[i].read.bytes_read = reads[i].bytes_read;
+
+		j_list_append(operations, &(fetch_operations[i]));
+	}
+
+	return j_distributed_object_read_exec_uncached(operations, fetch->semantics);
+}
+
+/**
+ * Executes read operations, serving repeated reads from the block cache if the semantics allow it.
+ *
+ * \private
+ **/
+static gboolean
+j_distributed_object_read_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBlockCache* cache;
+	JBurstBuffer* burst_buffer;
+	JDistributedObjectCacheFetch fetch;
+	g_autoptr(JListIterator) it = NULL;
+	g_autoptr(JList) unstaged = NULL;
+	g_autofree JBlockCacheRead* reads = NULL;
+	guint count = 0;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	// Staged data is newer than the servers' data, regardless of the semantics
+	if ((burst_buffer = j_burst_buffer_get(NULL)) != NULL)
+	{
+		g_autofree gchar* key = NULL;
+
+		unstaged = j_list_new(NULL);
+		it = j_list_iterator_new(operations);
+
+		while (j_list_iterator_next(it))
+		{
+			JDistributedObjectOperation* operation = j_list_iterator_get(it);
+
+			if (key == NULL)
+			{
+				key = j_distributed_object_burst_buffer_key(operation->read.object);
+			}
+
+			if (!j_burst_buffer_read(burst_buffer, key, operation->read.data, operation->read.length, operation->read.offset, operation->read.bytes_read))
+			{
+				j_list_append(unstaged, operation);
+			}
+		}
+
+		g_clear_pointer(&it, j_list_iterator_free);
+
+		if (j_list_length(unstaged) == 0)
+		{
+			return TRUE;
+		}
+
+		operations = unstaged;
+	}
+
+	if (j_object_get_backend() != NULL || (cache = j_block_cache_get(semantics)) == NULL)
+	{
+		return j_distributed_object_read_exec_uncached(operations, semantics);
+	}
+
+	{
+		JDistributedObjectOperation* operation = j_list_get_first(operations);
+		g_assert(operation != NULL);
+
+		fetch.object = operation->read.object;
+		fetch.semantics = semantics;
+	}
+
+	reads = g_new(JBlockCacheRead, j_list_length(operations));
+	it = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+
+		reads[count].data = operation->read.data;
+		reads[count].length = operation->read.length;
+		reads[count].offset = operation->read.offset;
+		reads[count].bytes_read = operation->read.bytes_read;
+		count++;
+	}
+
+	return j_block_cache_read(cache, J_BLOCK_CACHE_DISTRIBUTED, fetch.object->namespace, fetch.object->name, reads, count, j_distributed_object_read_cache_fetch, &fetch);
+}
+
+/**
+ * A range to be read into the block cache in the background.
+ **/
+struct JDistributedObjectPrefetch
+{
+	JDistributedObject* object;
+	JSemantics* semantics;
+	guint64 length;
+	guint64 offset;
+};
+
+typedef struct JDistributedObjectPrefetch JDistributedObjectPrefetch;
+
+static gpointer
+j_distributed_object_prefetch_background(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectPrefetch* prefetch = data;
+	JBlockCache* cache;
+	JDistributedObjectCacheFetch fetch;
+
+	fetch.object = prefetch->object;
+	fetch.semantics = prefetch->semantics;
+
+	if ((cache = j_block_cache_get(prefetch->semantics)) != NULL)
+	{
+		j_block_cache_prefetch(cache, J_BLOCK_CACHE_DISTRIBUTED, prefetch->object->namespace, prefetch->object->name, prefetch->length, prefetch->offset, j_distributed_object_read_cache_fetch, &fetch);
+	}
+
+	j_distributed_object_unref(prefetch->object);
+	j_semantics_unref(prefetch->semantics);
+	g_slice_free(JDistributedObjectPrefetch, prefetch);
+
+	return NULL;
+}
+
+/**
+ * Adds advice for a range of a server's part of an object to the server's message.
+ *
+ * \private
+ **/
+static void
+j_distributed_object_advise_add(JDistributedObject* object, JSemantics* semantics, JMessage** messages, guint32 index, guint32 advice, guint64 length, guint64 offset)
+{
+	if (messages[index] == NULL)
+	{
+		gsize name_len;
+		gsize namespace_len;
+
+		namespace_len = strlen(object->namespace) + 1;
+		name_len = strlen(object->name) + 1;
+
+		messages[index] = j_message_new(J_MESSAGE_OBJECT_ADVISE, namespace_len + name_len);
+		j_message_set_semantics(messages[index], semantics);
+		j_message_append_n(messages[index], object->namespace, namespace_len);
+		j_message_append_n(messages[index], object->name, name_len);
+	}
+
+	j_message_add_operation(messages[index], sizeof(guint32) + sizeof(guint64) + sizeof(guint64));
+	j_message_append_4(messages[index], &advice);
+	j_message_append_8(messages[index], &length);
+	j_message_append_8(messages[index], &offset);
+}
+
+static gboolean
+j_distributed_object_advise_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* object_backend;
+	JBlockCache* cache = NULL;
+	g_autoptr(JListIterator) it = NULL;
+	g_autofree JMessage** messages = NULL;
+	g_autofree guint64* starts = NULL;
+	g_autofree guint64* ends = NULL;
+	JDistributedObject* object;
+	gpointer object_handle = NULL;
+	guint32 server_count = 0;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JDistributedObjectOperation* operation = j_list_get_first(operations);
+		g_assert(operation != NULL);
+
+		object = operation->advise.object;
+		g_assert(object != NULL);
+	}
+
+	it = j_list_iterator_new(operations);
+	object_backend = j_object_get_backend();
+
+	if (object_backend == NULL)
+	{
+		if (!j_distributed_object_load_distribution(object, semantics))
+		{
+			return FALSE;
+		}
+
+		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
+		messages = g_new0(JMessage*, server_count);
+		starts = g_new(guint64, server_count);
+		ends = g_new(guint64, server_count);
+
+		cache = j_block_cache_get(semantics);
+	}
+	else
+	{
+		ret = j_backend_object_open(object_backend, object->namespace, object->name, &object_handle) && ret;
+	}
+
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+		guint32 advice = operation->advise.advice;
+		guint64 length = operation->advise.length;
+		guint64 offset = operation->advise.offset;
+
+		if (object_backend != NULL)
+		{
+			if (object_handle != NULL)
+			{
+				ret = j_backend_object_advise(object_backend, object_handle, advice, length, offset) && ret;
+			}
+		}
+		else if (advice == J_ADVICE_WILL_NEED && cache != NULL)
+		{
+			JDistributedObjectPrefetch* prefetch;
+
+			// With a block cache, the data is fetched into it instead of the servers' caches
+			prefetch = g_slice_new(JDistributedObjectPrefetch);
+			prefetch->object = j_distributed_object_ref(object);
+			prefetch->semantics = j_semantics_ref(semantics);
+			prefetch->length = length;
+			prefetch->offset = offset;
+
+			j_background_operation_unref(j_background_operation_new(j_distributed_object_prefetch_background, prefetch));
+		}
+		else if (length == 0 || j_distribution_get_type(object->distribution) == J_DISTRIBUTION_ERASURE)
+		{
+			// Erasure-coded parts are not laid out like the object, so the advice covers the servers' whole parts
+			for (guint i = 0; i < server_count; i++)
+			{
+				j_distributed_object_advise_add(object, semantics, messages, i, advice, 0, 0);
+			}
+		}
+		else
+		{
+			guint32 index;
+			guint64 block_id;
+			guint64 new_length;
+			guint64 new_offset;
+
+			for (guint i = 0; i < server_count; i++)
+			{
+				starts[i] = G_MAXUINT64;
+				ends[i] = 0;
+			}
+
+			// Each server gets a single range covering its blocks
+			j_distribution_reset(object->distribution, length, offset);
+
+			while (j_distribution_distribute(object->distribution, &index, &new_length, &new_offset, &block_id))
+			{
+				starts[index] = MIN(starts[index], new_offset);
+				ends[index] = MAX(ends[index], new_offset + new_length);
+			}
+
+			for (guint i = 0; i < server_count; i++)
+			{
+				if (starts[i] < ends[i])
+				{
+					j_distributed_object_advise_add(object, semantics, messages, i, advice, ends[i] - starts[i], starts[i]);
+				}
+			}
+		}
+	}
+
+	if (object_backend == NULL)
+	{
+		g_autofree gpointer* background_data = NULL;
+		guint32 count = 0;
+
+		background_data = g_new(gpointer, server_count);
+
+		for (guint i = 0; i < server_count; i++)
+		{
+			JDistributedObjectBackgroundData* data;
+
+			if (messages[i] == NULL)
+			{
+				continue;
+			}
+
+			data = g_slice_new(JDistributedObjectBackgroundData);
+			data->index = i;
+			data->message = messages[i];
+			data->operations = operations;
+			data->semantics = semantics;
+
+			background_data[count] = data;
+			count++;
+		}
+
+		// Sending advice works like syncing, the replies only contain status values
+		if (count > 0)
+		{
+			j_helper_execute_parallel(j_distributed_object_sync_background_operation, background_data, count);
+		}
+	}
+	else if (object_handle != NULL)
+	{
+		ret = j_backend_object_close(object_backend, object_handle) && ret;
+	}
+
+	return ret;
+}
+
+static gint
+j_distributed_object_write_compare(gconstpointer a, gconstpointer b)
+{
+	JDistributedObjectOperation const* operation_a = *(JDistributedObjectOperation* const*)a;
+	JDistributedObjectOperation const* operation_b = *(JDistributedObjectOperation* const*)b;
+
+	if (operation_a->write.offset < operation_b->write.offset)
+	{
+		return -1;
+	}
+
+	return (operation_a->write.offset > operation_b->write.offset) ? 1 : 0;
+}
+
+/**
+ * Checks whether write operations do not overlap, so that they can be executed in any order.
+ *
+ * \private
+ *
+ * \param operations A list of write operations.
+ *
+ * \return TRUE if the operations do not overlap, FALSE otherwise.
+ **/
+static gboolean
+j_distributed_object_write_disjoint(JList* operations)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GPtrArray) sorted = NULL;
+	g_autoptr(JListIterator) it = NULL;
+
+	sorted = g_ptr_array_new();
+	it = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(it))
+	{
+		g_ptr_array_add(sorted, j_list_iterator_get(it));
+	}
+
+	g_ptr_array_sort(sorted, j_distributed_object_write_compare);
+
+	for (guint i = 1; i < sorted->len; i++)
+	{
+		JDistributedObjectOperation* previous = g_ptr_array_index(sorted, i - 1);
+		JDistributedObjectOperation* operation = g_ptr_array_index(sorted, i);
+
+		if (previous->write.offset + previous->write.length > operation->write.offset)
+		{
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Returns the offset of the first deduplication block contained in a part of a write.
+ *
+ * \private
+ **/
+static guint64
+j_distributed_object_dedup_first(guint64 offset)
+{
+	return (offset + J_MESSAGE_DEDUP_BLOCK_SIZE - 1) / J_MESSAGE_DEDUP_BLOCK_SIZE * J_MESSAGE_DEDUP_BLOCK_SIZE;
+}
+
+/**
+ * Computes the digest of a deduplication block.
+ * Writes often contain the same block repeatedly, so the blocks are first compared using their fast hash.
+ * Only blocks whose content differs from all earlier ones have their digest computed.
+ *
+ * \private
+ *
+ * \param digests The digests computed so far, indexed by the blocks' hashes.
+ * \param data    The block's data.
+ * \param digest  A buffer of #J_CHECKSUM_DIGEST_SIZE bytes to store the digest in.
+ **/
+static void
+j_distributed_object_dedup_digest(GHashTable* digests, gchar const* data, guint8* digest)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectDedupDigest* known;
+	GBytes* key;
+	guint8 hash[J_CHECKSUM_HASH_SIZE];
+
+	j_checksum_hash(data, J_MESSAGE_DEDUP_BLOCK_SIZE, hash);
+	key = g_bytes_new(hash, sizeof(hash));
+
+	// The hash is not cryptographic, so equal hashes only identify a block together with its content
+	if ((known = g_hash_table_lookup(digests, key)) != NULL && memcmp(known->data, data, J_MESSAGE_DEDUP_BLOCK_SIZE) == 0)
+	{
+		memcpy(digest, known->digest, J_CHECKSUM_DIGEST_SIZE);
+		g_bytes_unref(key);
+
+		return;
+	}
+
+	j_checksum_digest(data, J_MESSAGE_DEDUP_BLOCK_SIZE, digest);
+
+	if (known == NULL)
+	{
+		known = g_new(JDistributedObjectDedupDigest, 1);
+		known->data = data;
+		memcpy(known->digest, digest, J_CHECKSUM_DIGEST_SIZE);
+
+		g_hash_table_insert(digests, key, known);
+	}
+	else
+	{
+		g_bytes_unref(key);
+	}
+}
+
+/**
+ * Asks the servers to reference the stored copies of all blocks contained in write operations.
+ * The operations are distributed exactly like j_distributed_object_write_exec_uncached() does,
+ * so that it can consume the blocks in order.
+ *
+ * \private
+ *
+ * \param object       A distributed object.
+ * \param operations   A list of write operations.
+ * \param semantics    A semantics object.
+ * \param server_count The number of object servers.
+ *
+ * \return An array of #JDistributedObjectDedupBlock elements.
+ **/
+static GArray*
+j_distributed_object_write_dedup(JDistributedObject* object, JList* operations, JSemantics* semantics, guint32 server_count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JListIterator) it = NULL;
+	g_autofree JMessage** messages = NULL;
+	g_autofree JList** lists = NULL;
+	g_autofree gpointer* background_data = NULL;
+	g_autoptr(GHashTable) digests = NULL;
+	GArray* blocks;
+	gsize namespace_len;
+	gsize name_len;
+
+	blocks = g_array_new(FALSE, FALSE, sizeof(JDistributedObjectDedupBlock));
+	digests = g_hash_table_new_full(g_bytes_hash, g_bytes_equal, (GDestroyNotify)g_bytes_unref, g_free);
+	it = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+		gchar const* new_data;
+		guint32 index;
+		guint64 block_id;
+		guint64 new_length;
+		guint64 new_offset;
+
+		j_distribution_reset(object->distribution, operation->write.length, operation->write.offset);
+		new_data = operation->write.data;
+
+		while (j_distribution_distribute(object->distribution, &index, &new_length, &new_offset, &block_id))
+		{
+			guint64 first;
+			guint64 count;
+			guint64 replica_offset;
+			guint32 replica_index;
+			guint start;
+
+			first = j_distributed_object_dedup_first(new_offset) - new_offset;
+			count = (first < new_length) ? (new_length - first) / J_MESSAGE_DEDUP_BLOCK_SIZE : 0;
+			start = blocks->len;
+
+			for (guint64 i = 0; i < count; i++)
+			{
+				JDistributedObjectDedupBlock block;
+
+				j_distributed_object_dedup_digest(digests, new_data + first + i * J_MESSAGE_DEDUP_BLOCK_SIZE, block.hash);
+				block.index = index;
+				block.offset = new_offset + first + i * J_MESSAGE_DEDUP_BLOCK_SIZE;
+				block.bytes_written = 0;
+
+				g_array_append_val(blocks, block);
+			}
+
+			// Copies contain the same data, so their blocks share the hashes
+			for (guint replica = 1; count > 0 && j_distribution_distribute_replica(object->distribution, replica, &replica_index, &replica_offset); replica++)
+			{
+				for (guint64 i = 0; i < count; i++)
+				{
+					JDistributedObjectDedupBlock block;
+
+					block = g_array_index(blocks, JDistributedObjectDedupBlock, start + i);
+					block.index = replica_index;
+					block.offset = replica_offset + first + i * J_MESSAGE_DEDUP_BLOCK_SIZE;
+
+					g_array_append_val(blocks, block);
+				}
+			}
+
+			new_data += new_length;
+		}
+	}
+
+	if (blocks->len == 0)
+	{
+		return blocks;
+	}
+
+	messages = g_new0(JMessage*, server_count);
+	lists = g_new0(JList*, server_count);
+	background_data = g_new0(gpointer, server_count);
+
+	namespace_len = strlen(object->namespace) + 1;
+	name_len = strlen(object->name) + 1;
+
+	// The array does not grow anymore, so pointers to its elements stay valid
+	for (guint i = 0; i < blocks->len; i++)
+	{
+		JDistributedObjectDedupBlock* block = &g_array_index(blocks, JDistributedObjectDedupBlock, i);
+
+		if (messages[block->index] == NULL)
+		{
+			messages[block->index] = j_message_new(J_MESSAGE_OBJECT_DEDUP, namespace_len + name_len);
+			j_message_set_semantics(messages[block->index], semantics);
+			j_message_set_lazy_create(messages[block->index], TRUE);
+			j_message_append_n(messages[block->index], object->namespace, namespace_len);
+			j_message_append_n(messages[block->index], object->name, name_len);
+
+			lists[block->index] = j_list_new(NULL);
+		}
+
+		j_message_add_operation(messages[block->index], J_CHECKSUM_DIGEST_SIZE + sizeof(guint64));
+		j_message_append_n(messages[block->index], block->hash, J_CHECKSUM_DIGEST_SIZE);
+		j_message_append_8(messages[block->index], &(block->offset));
+
+		j_list_append(lists[block->index], &(block->bytes_written));
+	}
+
+	for (guint i = 0; i < server_count; i++)
+	{
+		JDistributedObjectBackgroundData* data;
+
+		if (messages[i] == NULL)
+		{
+			continue;
+		}
+
+		data = g_slice_new(JDistributedObjectBackgroundData);
+		data->index = i;
+		data->message = messages[i];
+		data->operations = NULL;
+		data->semantics = semantics;
+		data->write.bytes_written = lists[i];
+
+		background_data[i] = data;
+	}
+
+	j_helper_execute_parallel(j_distributed_object_dedup_background_operation, background_data, server_count);
+
+	return blocks;
+}
+
+/**
+ * Adds a write to a server's message, creating the message if necessary.
+ *
+ * \private
+ *
+ * \param messages      The servers' messages.
+ * \param bw_lists      The servers' lists of bytes_written counters.
+ * \param index         The server's index.
+ * \param object        A distributed object.
+ * \param semantics     A semantics object.
+ * \param data          The data.
+ * \param length        The data's length.
+ * \param offset        The offset on the server.
+ * \param checksum      Whether the data is protected by a checksum.
+ * \param crc           The data's checksum, if any.
+ * \param hash          The data's digest if it is a block that should be stored for deduplication, NULL otherwise.
+ * \param bytes_written The counter for the bytes written.
+ **/
+static void
+j_distributed_object_write_add(JMessage** messages, JList** bw_lists, guint32 index, JDistributedObject* object, JSemantics* semantics, gconstpointer data, guint64 length, guint64 offset, gboolean checksum, guint32 crc, guint8 const* hash, guint64* bytes_written)
+{
+	guint64 message_length = length;
+
+	if (messages[index] == NULL && bw_lists[index] == NULL)
+	{
+		gsize namespace_len = strlen(object->namespace) + 1;
+		gsize name_len = strlen(object->name) + 1;
+
+		messages[index] = j_message_new(J_MESSAGE_OBJECT_WRITE, namespace_len + name_len);
+		j_message_set_semantics(messages[index], semantics);
+		j_message_set_lazy_create(messages[index], TRUE);
+		j_message_append_n(messages[index], object->namespace, namespace_len);
+		j_message_append_n(messages[index], object->name, name_len);
+
+		bw_lists[index] = j_list_new(NULL);
+	}
+
+	if (checksum)
+	{
+		message_length |= J_MESSAGE_LENGTH_CHECKSUM;
+	}
+
+	if (hash != NULL)
+	{
+		message_length |= J_MESSAGE_LENGTH_DEDUP;
+	}
+
+	j_message_add_operation(messages[index], sizeof(guint64) + sizeof(guint64) + ((checksum) ? sizeof(guint32) : 0) + ((hash != NULL) ? J_CHECKSUM_DIGEST_SIZE : 0));
+	j_message_append_8(messages[index], &message_length);
+	j_message_append_8(messages[index], &offset);
+
+	if (checksum)
+	{
+		j_message_append_4(messages[index], &crc);
+	}
+
+	if (hash != NULL)
+	{
+		j_message_append_n(messages[index], hash, J_CHECKSUM_DIGEST_SIZE);
+	}
+
+	j_message_add_send(messages[index], data, length);
+
+	j_list_append(bw_lists[index], bytes_written);
+}
+
+static gboolean
+j_distributed_object_write_exec_uncached(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	// FIXME check return value for messages
+	gboolean ret = TRUE;
+
+	JBackend* object_backend;
+	g_autofree JList** bw_lists = NULL;
+	g_autoptr(GPtrArray) runs = NULL;
+	g_autoptr(JList) coalesced = NULL;
+	g_autoptr(JListIterator) it = NULL;
+	g_autofree JMessage** messages = NULL;
+	g_autoptr(GArray) dedup_blocks = NULL;
+	JDistributedObject* object = NULL;
+	gpointer object_handle;
+	guint32 server_count = 0;
+	// Collects the bytes written to further copies of replicated blocks.
+	guint64 replica_bytes_written = 0;
+	guint dedup_block = 0;
+	gboolean checksums;
+
+	// FIXME
+	//JLock* lock = NULL;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	checksums = j_configuration_get_object_checksums(j_configuration());
+
+	{
+		JDistributedObjectOperation* operation = j_list_get_first(operations);
+		g_assert(operation != NULL);
+
+		object = operation->write.object;
+		g_assert(object != NULL);
+	}
+
+	object_backend = j_object_get_backend();
+
+	if (object_backend == NULL && !j_distributed_object_tune_distribution(object, operations, semantics))
+	{
+		return FALSE;
+	}
+
+	if (object_backend == NULL && !j_distributed_object_load_distribution(object, semantics))
+	{
+		return FALSE;
+	}
+
+	// Merge small writes to reduce the number of operations and message fragments.
+	// Runs are limited to the object's block size, so that merged writes do not span more servers than necessary.
+	runs = g_ptr_array_new_with_free_func((GDestroyNotify)j_distributed_object_write_run_free);
+	coalesced = j_distributed_object_write_coalesce(operations, j_distributed_object_get_block_size(object), runs);
+
+	it = j_list_iterator_new(coalesced);
+
+	if (object->read_ahead.window > 0)
+	{
+		j_distributed_object_read_ahead_invalidate(object);
+	}
+
+	if (object_backend == NULL && j_distribution_get_type(object->distribution) == J_DISTRIBUTION_ERASURE)
+	{
+		return j_distributed_object_write_erasure(object, coalesced, semantics);
+	}
+
+	if (object_backend == NULL)
+	{
+		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
+		messages = g_new(JMessage*, server_count);
+		bw_lists = g_new(JList*, server_count);
+
+		for (guint i = 0; i < server_count; i++)
+		{
+			messages[i] = NULL;
+			bw_lists[i] = NULL;
+		}
+
+		// Stored blocks are referenced before the remaining data is sent, which is only correct if the order of the writes does not matter
+		if (j_configuration_get_object_dedup(j_configuration()) && j_distributed_object_write_disjoint(coalesced))
+		{
+			dedup_blocks = j_distributed_object_write_dedup(object, coalesced, semantics, server_count);
+		}
+	}
+	else
+	{
+		ret = j_backend_object_open(object_backend, object->namespace, object->name, &object_handle) && ret;
+	}
+
+	/*
+	if (j_semantics_get(semantics, J_SEMANTICS_ATOMICITY) != J_SEMANTICS_ATOMICITY_NONE)
+	{
+		lock = j_lock_new("object", path);
+	}
+	*/
+
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+		gconstpointer data = operation->write.data;
+		guint64 length = operation->write.length;
+		guint64 offset = operation->write.offset;
+		guint64* bytes_written = operation->write.bytes_written;
+
+		j_trace_file_begin(object->name, J_TRACE_FILE_WRITE);
+
+		if (object_backend == NULL)
+		{
+			gchar const* new_data;
+			guint32 index;
+			guint64 block_id;
+			guint64 new_length;
+			guint64 new_offset;
+
+			j_distribution_reset(object->distribution, length, offset);
+			new_data = data;
+
+			while (j_distribution_distribute(object->distribution, &index, &new_length, &new_offset, &block_id))
+			{
+				guint replica = 0;
+				// The deduplicated blocks, relative to the part's offset
+				guint64 blocks_start = new_length;
+				guint64 blocks_end = new_length;
+				guint32 crc = 0;
+
+				if (dedup_blocks != NULL)
+				{
+					blocks_start = MIN(j_distributed_object_dedup_first(new_offset) - new_offset, new_length);
+					blocks_end = blocks_start + (new_length - blocks_start) / J_MESSAGE_DEDUP_BLOCK_SIZE * J_MESSAGE_DEDUP_BLOCK_SIZE;
+				}
+
+				// The data is sent without copying it, so computing the checksum is its only additional pass
+				if (checksums && blocks_start == blocks_end)
+				{
+					crc = j_checksum_crc32c(0, new_data, new_length);
+				}
+
+				// Replicated blocks are sent to all of their copies, only the first one counts towards bytes_written
+				do
+				{
+					guint64* counter = (replica == 0) ? bytes_written : &replica_bytes_written;
+
+					if (blocks_start == blocks_end)
+					{
+						j_distributed_object_write_add(messages, bw_lists, index, object, semantics, new_data, new_length, new_offset, checksums, crc, NULL, counter);
+					}
+					else
+					{
+						// The parts before and after the blocks are written as usual, stored blocks have been referenced already
+						if (blocks_start > 0)
+						{
+							crc = (checksums) ? j_checksum_crc32c(0, new_data, blocks_start) : 0;
+							j_distributed_object_write_add(messages, bw_lists, index, object, semantics, new_data, blocks_start, new_offset, checksums, crc, NULL, counter);
+						}
+
+						for (guint64 position = blocks_start; position < blocks_end; position += J_MESSAGE_DEDUP_BLOCK_SIZE)
+						{
+							JDistributedObjectDedupBlock* block = &g_array_index(dedup_blocks, JDistributedObjectDedupBlock, dedup_block);
+							gchar const* block_data = new_data + position;
+
+							dedup_block++;
+
+							if (block->bytes_written == J_MESSAGE_DEDUP_BLOCK_SIZE)
+							{
+								// Unsafe writes already count all data as written
+								if (j_semantics_get(semantics, J_SEMANTICS_SAFETY) != J_SEMANTICS_SAFETY_NONE)
+								{
+									j_helper_atomic_add(counter, block->bytes_written);
+								}
+
+								continue;
+							}
+
+							crc = (checksums) ? j_checksum_crc32c(0, block_data, J_MESSAGE_DEDUP_BLOCK_SIZE) : 0;
+							j_distributed_object_write_add(messages, bw_lists, index, object, semantics, block_data, J_MESSAGE_DEDUP_BLOCK_SIZE, new_offset + position, checksums, crc, block->hash, counter);
+						}
+
+						if (blocks_end < new_length)
+						{
+							crc = (checksums) ? j_checksum_crc32c(0, new_data + blocks_end, new_length - blocks_end) : 0;
+							j_distributed_object_write_add(messages, bw_lists, index, object, semantics, new_data + blocks_end, new_length - blocks_end, new_offset + blocks_end, checksums, crc, NULL, counter);
+						}
+					}
+
+					replica++;
+				} while (j_distribution_distribute_replica(object->distribution, replica, &index, &new_offset));
+
+				/*
+				if (lock != NULL)
+				{
+					j_lock_add(lock, block_id);
+				}
+				*/
+
+				new_data += new_length;
+
+				// Fake bytes_written here instead of doing another loop further down
+				if (j_semantics_get(semantics, J_SEMANTICS_SAFETY) == J_SEMANTICS_SAFETY_NONE)
+				{
+					j_helper_atomic_add(bytes_written, new_length);
+				}
+			}
+		}
+		else
+		{
+			guint64 nbytes = 0;
+
+			ret = j_backend_object_write(object_backend, object_handle, data, length, offset, &nbytes) && ret;
+			j_helper_atomic_add(bytes_written, nbytes);
+		}
+
+		j_trace_file_end(object->name, J_TRACE_FILE_WRITE, length, offset);
+	}
+
+	if (object_backend == NULL)
+	{
+		g_autofree gpointer* background_data = NULL;
+
+		background_data = g_new(gpointer, server_count);
+
+		for (guint i = 0; i < server_count; i++)
+		{
+			JDistributedObjectBackgroundData* data;
+
+			if (messages[i] == NULL)
+			{
+				background_data[i] = NULL;
+				continue;
+			}
+
+			data = g_slice_new(JDistributedObjectBackgroundData);
+			data->index = i;
+			data->message = messages[i];
+			data->operations = NULL;
+			data->semantics = semantics;
+			data->write.bytes_written = bw_lists[i];
+
+			background_data[i] = data;
+		}
+
+		j_helper_execute_parallel(j_distributed_object_write_background_operation, background_data, server_count);
+	}
+	else
+	{
+		ret = j_backend_object_close(object_backend, object_handle) && ret;
+	}
+
+	/*
+	if (lock != NULL)
+	{
+		// FIXME busy wait
+		while (!j_lock_acquire(lock));
+
+		j_lock_free(lock);
+	}
+	*/
+
+	return ret;
+}
+
+/**
+ * Executes write operations and invalidates the written blocks in the block cache.
+ * Blocks are invalidated after writing, so that blocks fetched concurrently are not inserted.
+ *
+ * \private
+ **/
+static gboolean
+j_distributed_object_write_exec_direct(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
 
-		j_helper_execute_parallel(j_distributed_object_delete_background_operation, background_data, server_count);
+	JBlockCache* cache;
+	gboolean ret;
 
-		for (guint i = 0; i < server_count; i++)
-		{
-			JDistributedObjectBackgroundData* data = background_data[i];
+	ret = j_distributed_object_write_exec_uncached(operations, semantics);
 
-			ret = data->ret && ret;
+	if ((cache = j_block_cache_get(NULL)) != NULL)
+	{
+		g_autoptr(JListIterator) it = NULL;
 
-			g_slice_free(JDistributedObjectBackgroundData, data);
+		it = j_list_iterator_new(operations);
+
+		while (j_list_iterator_next(it))
+		{
+			JDistributedObjectOperation* operation = j_list_iterator_get(it);
+			JDistributedObject* object = operation->write.object;
+
+			j_block_cache_invalidate(cache, J_BLOCK_CACHE_DISTRIBUTED, object->namespace, object->name, operation->write.length, operation->write.offset);
 		}
 	}
 
@@ -765,25 +4624,51 @@ j_distributed_object_delete_exec(JList* operations, JSemantics* semantics)
 }
 
 static gboolean
-j_distributed_object_read_exec(JList* operations, JSemantics* semantics)
+j_distributed_object_burst_buffer_drain(gpointer data, gconstpointer buffer, guint64 length, guint64 offset)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	// FIXME check return value for messages
-	gboolean ret = TRUE;
+	JDistributedObjectOperation operation;
+	g_autoptr(JList) operations = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	guint64 bytes_written = 0;
+	gboolean ret;
 
-	JBackend* object_backend;
-	g_autofree JList** br_lists = NULL;
-	g_autoptr(JListIterator) it = NULL;
-	g_autofree JMessage** messages = NULL;
-	JDistributedObject* object = NULL;
-	gpointer object_handle;
-	gsize name_len = 0;
-	gsize namespace_len = 0;
-	guint32 server_count = 0;
+	operation.write.object = data;
+	operation.write.data = buffer;
+	operation.write.length = length;
+	operation.write.offset = offset;
+	operation.write.bytes_written = &bytes_written;
 
-	// FIXME
-	//JLock* lock = NULL;
+	operations = j_list_new(NULL);
+	j_list_append(operations, &operation);
+
+	// The exec function is called directly, since batches could wait for the burst buffer
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	ret = j_distributed_object_write_exec_direct(operations, semantics);
+
+	return ret && bytes_written == length;
+}
+
+static JBurstBufferType const j_distributed_object_burst_buffer_type = {
+	(gpointer(*)(gpointer))j_distributed_object_ref,
+	(GDestroyNotify)j_distributed_object_unref,
+	j_distributed_object_burst_buffer_drain
+};
+
+/**
+ * Executes write operations, staging them in the burst buffer if the semantics allow it.
+ *
+ * \private
+ **/
+static gboolean
+j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBurstBuffer* burst_buffer;
+	JDistributedObject* object;
+	g_autoptr(JList) unstaged = NULL;
 
 	g_return_val_if_fail(operations != NULL, FALSE);
 	g_return_val_if_fail(semantics != NULL, FALSE);
@@ -792,154 +4677,317 @@ j_distributed_object_read_exec(JList* operations, JSemantics* semantics)
 		JDistributedObjectOperation* operation = j_list_get_first(operations);
 		g_assert(operation != NULL);
 
-		object = operation->read.object;
+		object = operation->write.object;
 		g_assert(object != NULL);
 	}
 
-	it = j_list_iterator_new(operations);
-	object_backend = j_object_get_backend();
+	if ((burst_buffer = j_burst_buffer_get(semantics)) == NULL)
+	{
+		return j_distributed_object_write_exec_direct(operations, semantics);
+	}
 
-	if (object_backend == NULL)
+	// The layout is fixed now, so that draining does not have to access the header
+	if (!j_distributed_object_tune_distribution(object, operations, semantics) || !j_distributed_object_load_distribution(object, semantics))
 	{
-		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
-		messages = g_new(JMessage*, server_count);
-		br_lists = g_new(JList*, server_count);
+		return FALSE;
+	}
 
-		namespace_len = strlen(object->namespace) + 1;
-		name_len = strlen(object->name) + 1;
+	// Erasure-coded stripes have to be read and written as a whole
+	if (j_distribution_get_type(object->distribution) == J_DISTRIBUTION_ERASURE)
+	{
+		j_distributed_object_burst_buffer_flush(object);
 
-		for (guint i = 0; i < server_count; i++)
+		return j_distributed_object_write_exec_direct(operations, semantics);
+	}
+
+	{
+		g_autoptr(JListIterator) it = NULL;
+		g_autofree gchar* key = NULL;
+
+		unstaged = j_list_new(NULL);
+		key = j_distributed_object_burst_buffer_key(object);
+		it = j_list_iterator_new(operations);
+
+		while (j_list_iterator_next(it))
 		{
-			messages[i] = NULL;
-			br_lists[i] = NULL;
+			JDistributedObjectOperation* operation = j_list_iterator_get(it);
+
+			// Once a write has not been staged, the following ones are written directly to keep their order
+			if (j_list_length(unstaged) == 0
+			    && j_burst_buffer_write(burst_buffer, key, &j_distributed_object_burst_buffer_type, object, operation->write.data, operation->write.length, operation->write.offset))
+			{
+				j_helper_atomic_add(operation->write.bytes_written, operation->write.length);
+				continue;
+			}
+
+			j_list_append(unstaged, operation);
 		}
 	}
-	else
+
+	if (j_list_length(unstaged) == 0)
 	{
-		ret = j_backend_object_open(object_backend, object->namespace, object->name, &object_handle) && ret;
+		return TRUE;
 	}
 
-	/*
-	if (j_semantics_get(semantics, J_SEMANTICS_ATOMICITY) != J_SEMANTICS_ATOMICITY_NONE)
+	return j_distributed_object_write_exec_direct(unstaged, semantics);
+}
+
+/**
+ * Executes list I/O operations by passing their extents to the regular read or write execution.
+ * Each server thus receives a single message containing all of its parts.
+ *
+ * \private
+ **/
+static gboolean
+j_distributed_object_append_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) header = NULL;
+	g_autofree guint64* reserved = NULL;
+	g_autofree guint64* bytes_written = NULL;
+	JDistributedObject* object;
+	JListIterator* it;
+	guint length;
+	gboolean written = FALSE;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
 	{
-		lock = j_lock_new("object", path);
+		JDistributedObjectOperation* operation = j_list_get_first(operations);
+
+		g_assert(operation != NULL);
+
+		object = operation->append.object;
 	}
-	*/
 
-	while (j_list_iterator_next(it))
+	batch = j_batch_new(semantics);
+	header = j_distributed_object_header_new(object);
+	length = j_list_length(operations);
+	reserved = g_new0(guint64, length);
+	bytes_written = g_new0(guint64, length);
+
+	// All appends are reserved with a single message to the header's server
+	it = j_list_iterator_new(operations);
+
+	for (guint i = 0; j_list_iterator_next(it); i++)
 	{
 		JDistributedObjectOperation* operation = j_list_iterator_get(it);
-		gpointer data = operation->read.data;
-		guint64 length = operation->read.length;
-		guint64 offset = operation->read.offset;
-		guint64* bytes_read = operation->read.bytes_read;
 
-		j_trace_file_begin(object->name, J_TRACE_FILE_READ);
+		j_object_reserve(header, J_DISTRIBUTED_OBJECT_APPEND_COUNTER, operation->append.length, operation->append.offset, &(reserved[i]), batch);
+	}
 
-		if (object_backend == NULL)
+	j_list_iterator_free(it);
+
+	ret = j_batch_execute(batch) && ret;
+
+	// The reserved space is written like any other data, which stripes it across the servers
+	it = j_list_iterator_new(operations);
+
+	for (guint i = 0; j_list_iterator_next(it); i++)
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+
+		if (reserved[i] != operation->append.length)
 		{
-			gchar* new_data;
-			guint32 index;
-			guint64 block_id;
-			guint64 new_length;
-			guint64 new_offset;
+			continue;
+		}
 
-			j_distribution_reset(object->distribution, length, offset);
-			new_data = data;
+		j_distributed_object_write(object, operation->append.data, operation->append.length, *(operation->append.offset), &(bytes_written[i]), batch);
+		written = TRUE;
+	}
 
-			while (j_distribution_distribute(object->distribution, &index, &new_length, &new_offset, &block_id))
-			{
-				JDistributedObjectReadBuffer* buffer;
+	j_list_iterator_free(it);
 
-				if (messages[index] == NULL && br_lists[index] == NULL)
-				{
-					messages[index] = j_message_new(J_MESSAGE_OBJECT_READ, namespace_len + name_len);
-					j_message_set_semantics(messages[index], semantics);
-					j_message_append_n(messages[index], object->namespace, namespace_len);
-					j_message_append_n(messages[index], object->name, name_len);
+	if (written)
+	{
+		ret = j_batch_execute(batch) && ret;
+	}
 
-					br_lists[index] = j_list_new(NULL);
-				}
+	it = j_list_iterator_new(operations);
 
-				j_message_add_operation(messages[index], sizeof(guint64) + sizeof(guint64));
-				j_message_append_8(messages[index], &new_length);
-				j_message_append_8(messages[index], &new_offset);
+	for (guint i = 0; j_list_iterator_next(it); i++)
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
 
-				buffer = g_slice_new(JDistributedObjectReadBuffer);
-				buffer->data = new_data;
-				buffer->bytes_read = bytes_read;
+		j_helper_atomic_add(operation->append.bytes_written, bytes_written[i]);
+	}
 
-				j_list_append(br_lists[index], buffer);
+	j_list_iterator_free(it);
 
-				/*
-				if (lock != NULL)
-				{
-					j_lock_add(lock, block_id);
-				}
-				*/
+	return ret;
+}
 
-				new_data += new_length;
-			}
-		}
-		else
-		{
-			guint64 nbytes = 0;
+static gboolean
+j_distributed_object_vector_exec(JList* operations, JSemantics* semantics, gboolean write)
+{
+	J_TRACE_FUNCTION(NULL);
 
-			ret = j_backend_object_read(object_backend, object_handle, data, length, offset, &nbytes) && ret;
-			j_helper_atomic_add(bytes_read, nbytes);
+	g_autoptr(JList) extents = NULL;
+	g_autoptr(JListIterator) it = NULL;
+
+	extents = j_list_new(NULL);
+	it = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectVectorOperation* operation = j_list_iterator_get(it);
+
+		for (guint32 i = 0; i < operation->count; i++)
+		{
+			j_list_append(extents, &(operation->operations[i]));
 		}
+	}
 
-		j_trace_file_end(object->name, J_TRACE_FILE_READ, length, offset);
+	return (write) ? j_distributed_object_write_exec(extents, semantics) : j_distributed_object_read_exec(extents, semantics);
+}
+
+static gboolean
+j_distributed_object_readv_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return j_distributed_object_vector_exec(operations, semantics, FALSE);
+}
+
+static gboolean
+j_distributed_object_writev_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return j_distributed_object_vector_exec(operations, semantics, TRUE);
+}
+
+static gint
+j_distributed_object_vector_compare(gconstpointer a, gconstpointer b, gpointer data)
+{
+	JDistributedObjectOperation const* operation_a = a;
+	JDistributedObjectOperation const* operation_b = b;
+
+	(void)data;
+
+	// read and write share the layout of their first members
+	if (operation_a->read.offset < operation_b->read.offset)
+	{
+		return -1;
+	}
+	else if (operation_a->read.offset > operation_b->read.offset)
+	{
+		return 1;
 	}
 
-	if (object_backend == NULL)
+	return 0;
+}
+
+/**
+ * Creates a list I/O operation.
+ * Extents are split at the maximum operation size and sorted by offset,
+ * so that the parts sent to each server are ordered and adjacent extents can be merged.
+ * Overlapping extents keep their order to preserve the semantics of overlapping writes.
+ *
+ * \private
+ **/
+static JDistributedObjectVectorOperation*
+j_distributed_object_vector_new(JDistributedObject* object, JDistributedObjectExtent const* extents, guint32 count, guint64* bytes, gboolean write)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectVectorOperation* operation;
+	guint64 max_operation_size;
+	guint32 n = 0;
+	gboolean overlap = FALSE;
+
+	max_operation_size = j_configuration_get_max_operation_size(j_configuration());
+
+	for (guint32 i = 0; i < count; i++)
 	{
-		g_autofree gpointer* background_data = NULL;
+		n += (extents[i].length + max_operation_size - 1) / max_operation_size;
+	}
 
-		background_data = g_new(gpointer, server_count);
+	operation = g_slice_new(JDistributedObjectVectorOperation);
+	operation->object = j_distributed_object_ref(object);
+	operation->operations = g_new(JDistributedObjectOperation, n);
+	operation->count = 0;
+	operation->bytes = bytes;
+	operation->buffers = NULL;
 
-		for (guint i = 0; i < server_count; i++)
+	for (guint32 i = 0; i < count; i++)
+	{
+		gchar* data = extents[i].data;
+		guint64 length = extents[i].length;
+		guint64 offset = extents[i].offset;
+
+		// Chunk operation if necessary
+		while (length > 0)
 		{
-			JDistributedObjectBackgroundData* data;
+			JDistributedObjectOperation* iop = &(operation->operations[operation->count]);
+			guint64 chunk_size;
 
-			if (messages[i] == NULL)
+			chunk_size = MIN(length, max_operation_size);
+
+			if (write)
 			{
-				background_data[i] = NULL;
-				continue;
+				iop->write.object = object;
+				iop->write.data = data;
+				iop->write.length = chunk_size;
+				iop->write.offset = offset;
+				iop->write.bytes_written = bytes;
+				iop->write.buffer = NULL;
+			}
+			else
+			{
+				iop->read.object = object;
+				iop->read.data = data;
+				iop->read.length = chunk_size;
+				iop->read.offset = offset;
+				iop->read.bytes_read = bytes;
 			}
 
-			data = g_slice_new(JDistributedObjectBackgroundData);
-			data->index = i;
-			data->message = messages[i];
-			data->operations = NULL;
-			data->semantics = semantics;
-			data->read.buffers = br_lists[i];
+			operation->count++;
 
-			background_data[i] = data;
+			data += chunk_size;
+			length -= chunk_size;
+			offset += chunk_size;
 		}
-
-		j_helper_execute_parallel(j_distributed_object_read_background_operation, background_data, server_count);
 	}
-	else
+
+	if (write)
 	{
-		ret = j_backend_object_close(object_backend, object_handle) && ret;
-	}
+		g_autofree JDistributedObjectOperation* sorted = NULL;
 
-	/*
-	if (lock != NULL)
+		sorted = g_new(JDistributedObjectOperation, operation->count);
+		memcpy(sorted, operation->operations, operation->count * sizeof(JDistributedObjectOperation));
+		g_qsort_with_data(sorted, operation->count, sizeof(JDistributedObjectOperation), j_distributed_object_vector_compare, NULL);
+
+		for (guint32 i = 1; i < operation->count; i++)
+		{
+			if (sorted[i].write.offset < sorted[i - 1].write.offset + sorted[i - 1].write.length)
+			{
+				overlap = TRUE;
+				break;
+			}
+		}
+
+		if (!overlap)
+		{
+			memcpy(operation->operations, sorted, operation->count * sizeof(JDistributedObjectOperation));
+		}
+	}
+	else
 	{
-		// FIXME busy wait
-		while (!j_lock_acquire(lock));
-
-		j_lock_free(lock);
+		// Overlapping reads do not influence each other
+		g_qsort_with_data(operation->operations, operation->count, sizeof(JDistributedObjectOperation), j_distributed_object_vector_compare, NULL);
 	}
-	*/
 
-	return ret;
+	return operation;
 }
 
 static gboolean
-j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
+j_distributed_object_status_exec(JList* operations, JSemantics* semantics)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -947,27 +4995,24 @@ j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
 	gboolean ret = TRUE;
 
 	JBackend* object_backend;
-	g_autofree JList** bw_lists = NULL;
 	g_autoptr(JListIterator) it = NULL;
 	g_autofree JMessage** messages = NULL;
-	JDistributedObject* object = NULL;
-	gpointer object_handle;
-	gsize name_len = 0;
+	gchar const* namespace = NULL;
 	gsize namespace_len = 0;
 	guint32 server_count = 0;
 
-	// FIXME
-	//JLock* lock = NULL;
-
 	g_return_val_if_fail(operations != NULL, FALSE);
 	g_return_val_if_fail(semantics != NULL, FALSE);
 
 	{
 		JDistributedObjectOperation* operation = j_list_get_first(operations);
-		g_assert(operation != NULL);
+		JDistributedObject* object = operation->status.object;
 
-		object = operation->write.object;
+		g_assert(operation != NULL);
 		g_assert(object != NULL);
+
+		namespace = object->namespace;
+		namespace_len = strlen(namespace) + 1;
 	}
 
 	it = j_list_iterator_new(operations);
@@ -977,94 +5022,59 @@ j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
 	{
 		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
 		messages = g_new(JMessage*, server_count);
-		bw_lists = g_new(JList*, server_count);
-
-		namespace_len = strlen(object->namespace) + 1;
-		name_len = strlen(object->name) + 1;
 
+		// FIXME use actual distribution
 		for (guint i = 0; i < server_count; i++)
 		{
-			messages[i] = NULL;
-			bw_lists[i] = NULL;
+			messages[i] = j_message_new(J_MESSAGE_OBJECT_STATUS, namespace_len);
+			j_message_set_semantics(messages[i], semantics);
+			j_message_append_n(messages[i], namespace, namespace_len);
 		}
 	}
-	else
-	{
-		ret = j_backend_object_open(object_backend, object->namespace, object->name, &object_handle) && ret;
-	}
-
-	/*
-	if (j_semantics_get(semantics, J_SEMANTICS_ATOMICITY) != J_SEMANTICS_ATOMICITY_NONE)
-	{
-		lock = j_lock_new("object", path);
-	}
-	*/
 
 	while (j_list_iterator_next(it))
 	{
 		JDistributedObjectOperation* operation = j_list_iterator_get(it);
-		gconstpointer data = operation->write.data;
-		guint64 length = operation->write.length;
-		guint64 offset = operation->write.offset;
-		guint64* bytes_written = operation->write.bytes_written;
+		JDistributedObject* object = operation->status.object;
+		gint64* modification_time = operation->status.modification_time;
+		guint64* size = operation->status.size;
 
-		j_trace_file_begin(object->name, J_TRACE_FILE_WRITE);
+		j_distributed_object_burst_buffer_flush(object);
 
-		if (object_backend == NULL)
+		if (modification_time != NULL)
 		{
-			gchar const* new_data;
-			guint32 index;
-			guint64 block_id;
-			guint64 new_length;
-			guint64 new_offset;
-
-			j_distribution_reset(object->distribution, length, offset);
-			new_data = data;
-
-			while (j_distribution_distribute(object->distribution, &index, &new_length, &new_offset, &block_id))
-			{
-				if (messages[index] == NULL && bw_lists[index] == NULL)
-				{
-					messages[index] = j_message_new(J_MESSAGE_OBJECT_WRITE, namespace_len + name_len);
-					j_message_set_semantics(messages[index], semantics);
-					j_message_append_n(messages[index], object->namespace, namespace_len);
-					j_message_append_n(messages[index], object->name, name_len);
-
-					bw_lists[index] = j_list_new(NULL);
-				}
+			*modification_time = 0;
+		}
 
-				j_message_add_operation(messages[index], sizeof(guint64) + sizeof(guint64));
-				j_message_append_8(messages[index], &new_length);
-				j_message_append_8(messages[index], &new_offset);
-				j_message_add_send(messages[index], new_data, new_length);
+		if (size != NULL)
+		{
+			*size = 0;
+		}
 
-				j_list_append(bw_lists[index], bytes_written);
+		if (object_backend == NULL)
+		{
+			gsize name_len;
 
-				/*
-				if (lock != NULL)
-				{
-					j_lock_add(lock, block_id);
-				}
-				*/
+			name_len = strlen(object->name) + 1;
 
-				new_data += new_length;
+			// The distribution determines how the parts' sizes are combined, objects without a header use the sum
+			j_distributed_object_load_distribution(object, semantics);
 
-				// Fake bytes_written here instead of doing another loop further down
-				if (j_semantics_get(semantics, J_SEMANTICS_SAFETY) == J_SEMANTICS_SAFETY_NONE)
-				{
-					j_helper_atomic_add(bytes_written, new_length);
-				}
+			// FIXME use actual distribution
+			for (guint i = 0; i < server_count; i++)
+			{
+				j_message_add_operation(messages[i], name_len);
+				j_message_append_n(messages[i], object->name, name_len);
 			}
 		}
 		else
 		{
-			guint64 nbytes = 0;
+			gpointer object_handle;
 
-			ret = j_backend_object_write(object_backend, object_handle, data, length, offset, &nbytes) && ret;
-			j_helper_atomic_add(bytes_written, nbytes);
+			ret = j_backend_object_open(object_backend, object->namespace, object->name, &object_handle) && ret;
+			ret = j_backend_object_status(object_backend, object_handle, modification_time, size) && ret;
+			ret = j_backend_object_close(object_backend, object_handle) && ret;
 		}
-
-		j_trace_file_end(object->name, J_TRACE_FILE_WRITE, length, offset);
 	}
 
 	if (object_backend == NULL)
@@ -1073,59 +5083,55 @@ j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
 
 		background_data = g_new(gpointer, server_count);
 
+		// FIXME use actual distribution
 		for (guint i = 0; i < server_count; i++)
 		{
 			JDistributedObjectBackgroundData* data;
 
-			if (messages[i] == NULL)
-			{
-				background_data[i] = NULL;
-				continue;
-			}
-
 			data = g_slice_new(JDistributedObjectBackgroundData);
 			data->index = i;
 			data->message = messages[i];
-			data->operations = NULL;
+			data->operations = operations;
 			data->semantics = semantics;
-			data->write.bytes_written = bw_lists[i];
 
 			background_data[i] = data;
 		}
 
-		j_helper_execute_parallel(j_distributed_object_write_background_operation, background_data, server_count);
-	}
-	else
-	{
-		ret = j_backend_object_close(object_backend, object_handle) && ret;
-	}
+		j_helper_execute_parallel(j_distributed_object_status_background_operation, background_data, server_count);
 
-	/*
-	if (lock != NULL)
-	{
-		// FIXME busy wait
-		while (!j_lock_acquire(lock));
+		j_list_iterator_free(it);
+		it = j_list_iterator_new(operations);
 
-		j_lock_free(lock);
+		while (j_list_iterator_next(it))
+		{
+			JDistributedObjectOperation* operation = j_list_iterator_get(it);
+			JDistributedObject* object = operation->status.object;
+			guint64* size = operation->status.size;
+
+			if (size != NULL && object->distribution != NULL && j_distribution_get_type(object->distribution) == J_DISTRIBUTION_ERASURE)
+			{
+				ret = j_distributed_object_erasure_get_size(object, size, semantics) && ret;
+			}
+		}
 	}
-	*/
 
 	return ret;
 }
 
 static gboolean
-j_distributed_object_status_exec(JList* operations, JSemantics* semantics)
+j_distributed_object_clone_exec(JList* operations, JSemantics* semantics)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	// FIXME check return value for messages
 	gboolean ret = TRUE;
 
 	JBackend* object_backend;
+	JBlockCache* cache;
 	g_autoptr(JListIterator) it = NULL;
+	g_autoptr(JBatch) batch = NULL;
 	g_autofree JMessage** messages = NULL;
-	gchar const* namespace = NULL;
-	gsize namespace_len = 0;
+	JDistributedObject* object;
+	gpointer object_handle = NULL;
 	guint32 server_count = 0;
 
 	g_return_val_if_fail(operations != NULL, FALSE);
@@ -1133,69 +5139,82 @@ j_distributed_object_status_exec(JList* operations, JSemantics* semantics)
 
 	{
 		JDistributedObjectOperation* operation = j_list_get_first(operations);
-		JDistributedObject* object = operation->status.object;
 
 		g_assert(operation != NULL);
-		g_assert(object != NULL);
 
-		namespace = object->namespace;
-		namespace_len = strlen(namespace) + 1;
+		object = operation->clone.object;
 	}
 
+	j_distributed_object_burst_buffer_flush(object);
+
 	it = j_list_iterator_new(operations);
 	object_backend = j_object_get_backend();
 
 	if (object_backend == NULL)
 	{
+		gsize name_len;
+		gsize namespace_len;
+
+		namespace_len = strlen(object->namespace) + 1;
+		name_len = strlen(object->name) + 1;
+
 		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
 		messages = g_new(JMessage*, server_count);
 
-		// FIXME use actual distribution
+		// All servers store a part with the object's name, so every server clones its part locally
 		for (guint i = 0; i < server_count; i++)
 		{
-			messages[i] = j_message_new(J_MESSAGE_OBJECT_STATUS, namespace_len);
+			messages[i] = j_message_new(J_MESSAGE_OBJECT_CLONE, namespace_len + name_len);
 			j_message_set_semantics(messages[i], semantics);
-			j_message_append_n(messages[i], namespace, namespace_len);
+			j_message_append_n(messages[i], object->namespace, namespace_len);
+			j_message_append_n(messages[i], object->name, name_len);
 		}
 	}
+	else
+	{
+		ret = j_backend_object_open(object_backend, object->namespace, object->name, &object_handle) && ret;
+	}
 
 	while (j_list_iterator_next(it))
 	{
 		JDistributedObjectOperation* operation = j_list_iterator_get(it);
-		JDistributedObject* object = operation->status.object;
-		gint64* modification_time = operation->status.modification_time;
-		guint64* size = operation->status.size;
-
-		if (modification_time != NULL)
-		{
-			*modification_time = 0;
-		}
+		JDistributedObject* clone = operation->clone.clone;
 
-		if (size != NULL)
-		{
-			*size = 0;
-		}
+		// Staged data of the clone would overwrite the cloned data later
+		j_distributed_object_burst_buffer_flush(clone);
 
 		if (object_backend == NULL)
 		{
-			gsize name_len;
+			gsize clone_name_len;
+			gsize clone_namespace_len;
 
-			name_len = strlen(object->name) + 1;
+			clone_namespace_len = strlen(clone->namespace) + 1;
+			clone_name_len = strlen(clone->name) + 1;
 
-			// FIXME use actual distribution
 			for (guint i = 0; i < server_count; i++)
 			{
-				j_message_add_operation(messages[i], name_len);
-				j_message_append_n(messages[i], object->name, name_len);
+				j_message_add_operation(messages[i], clone_namespace_len + clone_name_len);
+				j_message_append_n(messages[i], clone->namespace, clone_namespace_len);
+				j_message_append_n(messages[i], clone->name, clone_name_len);
 			}
 		}
-		else
+		else if (object_handle != NULL)
 		{
-			gpointer object_handle;
+			gpointer clone_handle;
+			gboolean lret = FALSE;
 
-			ret = j_backend_object_open(object_backend, object->namespace, object->name, &object_handle) && ret;
-			ret = j_backend_object_status(object_backend, object_handle, modification_time, size) && ret;
-			ret = j_backend_object_close(object_backend, object_handle) && ret;
+			if (j_backend_object_open(object_backend, clone->namespace, clone->name, &clone_handle))
+			{
+				j_backend_object_delete(object_backend, clone_handle);
+			}
+
+			if (j_backend_object_create(object_backend, clone->namespace, clone->name, &clone_handle))
+			{
+				lret = j_backend_object_clone(object_backend, object_handle, clone_handle);
+				lret = j_backend_object_close(object_backend, clone_handle) && lret;
+			}
+
+			ret = lret && ret;
 		}
 	}
 
@@ -1205,7 +5224,6 @@ j_distributed_object_status_exec(JList* operations, JSemantics* semantics)
 
 		background_data = g_new(gpointer, server_count);
 
-		// FIXME use actual distribution
 		for (guint i = 0; i < server_count; i++)
 		{
 			JDistributedObjectBackgroundData* data;
@@ -1213,13 +5231,61 @@ j_distributed_object_status_exec(JList* operations, JSemantics* semantics)
 			data = g_slice_new(JDistributedObjectBackgroundData);
 			data->index = i;
 			data->message = messages[i];
-			data->operations = operations;
+			data->operations = NULL;
 			data->semantics = semantics;
+			data->ret = TRUE;
 
 			background_data[i] = data;
 		}
 
-		j_helper_execute_parallel(j_distributed_object_status_background_operation, background_data, server_count);
+		j_helper_execute_parallel(j_distributed_object_clone_background_operation, background_data, server_count);
+
+		for (guint i = 0; i < server_count; i++)
+		{
+			JDistributedObjectBackgroundData* data = background_data[i];
+
+			ret = data->ret && ret;
+
+			g_slice_free(JDistributedObjectBackgroundData, data);
+		}
+	}
+	else if (object_handle != NULL)
+	{
+		ret = j_backend_object_close(object_backend, object_handle) && ret;
+	}
+
+	// The header is cloned last, so that clones only become readable once their parts exist
+	batch = j_batch_new(semantics);
+
+	j_list_iterator_free(it);
+	it = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+		g_autoptr(JObject) header = NULL;
+		g_autoptr(JObject) clone_header = NULL;
+
+		header = j_distributed_object_header_new(object);
+		clone_header = j_distributed_object_header_new(operation->clone.clone);
+
+		j_object_clone(header, clone_header, batch);
+	}
+
+	ret = j_batch_execute(batch) && ret;
+
+	cache = j_block_cache_get(NULL);
+
+	j_list_iterator_free(it);
+	it = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+		JDistributedObject* clone = operation->clone.clone;
+
+		j_distributed_object_read_ahead_invalidate(clone);
+		j_block_cache_invalidate(cache, J_BLOCK_CACHE_DISTRIBUTED, clone->namespace, clone->name, G_MAXUINT64, 0);
 	}
 
 	return ret;
@@ -1276,6 +5342,8 @@ j_distributed_object_sync_exec(JList* operations, JSemantics* semantics)
 		JDistributedObjectOperation* operation = j_list_iterator_get(it);
 		JDistributedObject* object = operation->sync.object;
 
+		j_distributed_object_burst_buffer_flush(object);
+
 		if (object_backend == NULL)
 		{
 			gsize name_len;
@@ -1335,9 +5403,13 @@ j_distributed_object_sync_exec(JList* operations, JSemantics* semantics)
  * i = j_distributed_object_new("JULEA", "JULEA", d);
  * \endcode
  *
+ * j_distributed_object_create() stores the distribution in a header next to the object.
+ * Existing objects can therefore be opened without knowing their distribution,
+ * in which case it is loaded from the header on first access.
+ *
  * \param namespace    A namespace.
  * \param name         An object name.
- * \param distribution A distribution.
+ * \param distribution A distribution or NULL to use the one stored with the object.
  *
  * \return A new object. Should be freed with j_distributed_object_unref().
  **/
@@ -1350,12 +5422,22 @@ j_distributed_object_new(gchar const* namespace, gchar const* name, JDistributio
 
 	g_return_val_if_fail(namespace != NULL, NULL);
 	g_return_val_if_fail(name != NULL, NULL);
-	g_return_val_if_fail(distribution != NULL, NULL);
 
 	object = g_slice_new(JDistributedObject);
 	object->namespace = g_strdup(namespace);
 	object->name = g_strdup(name);
-	object->distribution = j_distribution_ref(distribution);
+	object->distribution = (distribution != NULL) ? j_distribution_ref(distribution) : NULL;
+	g_mutex_init(object->header.mutex);
+	object->header.data = NULL;
+	object->header.bytes_written = 0;
+	object->header.pending = FALSE;
+	g_mutex_init(object->read_ahead.mutex);
+	object->read_ahead.window = 0;
+	object->read_ahead.next_offset = 0;
+	object->read_ahead.buffer = NULL;
+	object->read_ahead.buffer_size = 0;
+	object->read_ahead.buffer_offset = 0;
+	object->read_ahead.buffer_length = 0;
 	object->ref_count = 1;
 
 	return object;
@@ -1379,38 +5461,85 @@ j_distributed_object_ref(JDistributedObject* object)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	g_return_val_if_fail(object != NULL, NULL);
+	g_return_val_if_fail(object != NULL, NULL);
+
+	g_atomic_int_inc(&(object->ref_count));
+
+	return object;
+}
+
+/**
+ * Decreases an object's reference count.
+ * When the reference count reaches zero, frees the memory allocated for the object.
+ *
+ * \code
+ * \endcode
+ *
+ * \param object An object.
+ **/
+void
+j_distributed_object_unref(JDistributedObject* object)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(object != NULL);
+
+	if (g_atomic_int_dec_and_test(&(object->ref_count)))
+	{
+		g_free(object->name);
+		g_free(object->namespace);
+
+		if (object->distribution != NULL)
+		{
+			j_distribution_unref(object->distribution);
+		}
 
-	g_atomic_int_inc(&(object->ref_count));
+		if (object->header.data != NULL)
+		{
+			bson_destroy(object->header.data);
+		}
 
-	return object;
+		g_mutex_clear(object->header.mutex);
+		g_mutex_clear(object->read_ahead.mutex);
+		g_free(object->read_ahead.buffer);
+
+		g_slice_free(JDistributedObject, object);
+	}
 }
 
 /**
- * Decreases an object's reference count.
- * When the reference count reaches zero, frees the memory allocated for the object.
+ * Enables read-ahead for sequential reads.
+ *
+ * When a read continues where the previous one ended, the following stripes are fetched from all servers in parallel and kept in a client-side buffer.
+ * The buffer is only invalidated by writes using the same object handle, that is, modifications by other clients might not be visible.
  *
  * \code
+ * j_distributed_object_set_read_ahead(object, 8);
  * \endcode
  *
- * \param object An object.
+ * \param object  An object.
+ * \param stripes The number of stripes to prefetch, 0 to disable read-ahead.
  **/
 void
-j_distributed_object_unref(JDistributedObject* object)
+j_distributed_object_set_read_ahead(JDistributedObject* object, guint32 stripes)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	g_return_if_fail(object != NULL);
 
-	if (g_atomic_int_dec_and_test(&(object->ref_count)))
-	{
-		g_free(object->name);
-		g_free(object->namespace);
+	g_mutex_lock(object->read_ahead.mutex);
 
-		j_distribution_unref(object->distribution);
+	object->read_ahead.window = stripes * j_configuration_get_stripe_size(j_configuration());
+	object->read_ahead.buffer_offset = 0;
+	object->read_ahead.buffer_length = 0;
 
-		g_slice_free(JDistributedObject, object);
+	if (stripes == 0)
+	{
+		g_clear_pointer(&(object->read_ahead.buffer), g_free);
+		object->read_ahead.buffer_size = 0;
 	}
+
+	g_mutex_unlock(object->read_ahead.mutex);
 }
 
 /**
@@ -1430,18 +5559,79 @@ j_distributed_object_create(JDistributedObject* object, JBatch* batch)
 {
 	J_TRACE_FUNCTION(NULL);
 
+	j_distributed_object_create_with_size(object, 0, batch);
+}
+
+/**
+ * Creates an object and reserves space for it on all servers.
+ * The size is only a hint and does not change the object's size.
+ * Creating large objects this way reduces fragmentation when they are written by many clients in parallel.
+ *
+ * \code
+ * \endcode
+ *
+ * \param object An object.
+ * \param size   The expected size in bytes, 0 for none.
+ * \param batch  A batch.
+ **/
+void
+j_distributed_object_create_with_size(JDistributedObject* object, guint64 size, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectOperation* iop;
 	JOperation* operation;
+	g_autoptr(JObject) header = NULL;
+	gboolean pending;
 
 	g_return_if_fail(object != NULL);
 
+	g_mutex_lock(object->header.mutex);
+
+	if (object->distribution == NULL)
+	{
+		g_atomic_pointer_set(&(object->distribution), j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN));
+	}
+
+	if (size > 0)
+	{
+		j_distribution_tune(object->distribution, size);
+	}
+
+	// Without a size hint, autotuned distributions are tuned by the first write
+	pending = j_distribution_get_autotune(object->distribution);
+	g_atomic_int_set(&(object->header.pending), pending);
+
+	if (!pending)
+	{
+		g_clear_pointer(&(object->header.data), bson_destroy);
+		object->header.data = j_distribution_serialize(object->distribution);
+	}
+
+	g_mutex_unlock(object->header.mutex);
+
+	iop = g_slice_new(JDistributedObjectOperation);
+	iop->create.object = j_distributed_object_ref(object);
+	iop->create.size = size;
+
 	operation = j_operation_new();
 	// FIXME key = index + namespace
 	operation->key = object;
-	operation->data = j_distributed_object_ref(object);
+	operation->data = iop;
 	operation->exec_func = j_distributed_object_create_exec;
 	operation->free_func = j_distributed_object_create_free;
+	operation->cache_func = j_distributed_object_metadata_cache;
 
 	j_batch_add(batch, operation);
+
+	// The header lives as long as the object, which is referenced by the create operation.
+	header = j_distributed_object_header_new(object);
+	j_object_create(header, batch);
+
+	if (!pending)
+	{
+		j_object_write(header, bson_get_data(object->header.data), object->header.data->len, 0, &(object->header.bytes_written), batch);
+	}
 }
 
 /**
@@ -1459,6 +5649,7 @@ j_distributed_object_delete(JDistributedObject* object, JBatch* batch)
 	J_TRACE_FUNCTION(NULL);
 
 	JOperation* operation;
+	g_autoptr(JObject) header = NULL;
 
 	g_return_if_fail(object != NULL);
 
@@ -1467,8 +5658,39 @@ j_distributed_object_delete(JDistributedObject* object, JBatch* batch)
 	operation->data = j_distributed_object_ref(object);
 	operation->exec_func = j_distributed_object_delete_exec;
 	operation->free_func = j_distributed_object_delete_free;
+	operation->cache_func = j_distributed_object_metadata_cache;
 
 	j_batch_add(batch, operation);
+
+	header = j_distributed_object_header_new(object);
+	j_object_delete(header, batch);
+}
+
+/**
+ * Deletes all objects of a namespace whose names start with a prefix, including their headers.
+ * The servers delete the objects' parts on their own, see j_object_delete_prefix().
+ *
+ * \code
+ * \endcode
+ *
+ * \param namespace A namespace.
+ * \param prefix    A prefix.
+ * \param batch     A batch.
+ **/
+void
+j_distributed_object_delete_prefix(gchar const* namespace, gchar const* prefix, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* header_prefix = NULL;
+
+	g_return_if_fail(namespace != NULL);
+	g_return_if_fail(prefix != NULL);
+
+	header_prefix = g_strdup_printf("%s/%s", namespace, prefix);
+
+	j_object_delete_prefix(namespace, prefix, NULL, batch);
+	j_object_delete_prefix(J_DISTRIBUTED_OBJECT_HEADER_NAMESPACE, header_prefix, NULL, batch);
 }
 
 /**
@@ -1575,12 +5797,14 @@ j_distributed_object_write(JDistributedObject* object, gconstpointer data, guint
 		iop->write.length = chunk_size;
 		iop->write.offset = offset;
 		iop->write.bytes_written = bytes_written;
+		iop->write.buffer = NULL;
 
 		operation = j_operation_new();
 		operation->key = object;
 		operation->data = iop;
 		operation->exec_func = j_distributed_object_write_exec;
 		operation->free_func = j_distributed_object_write_free;
+		operation->cache_func = j_distributed_object_write_cache;
 
 		j_batch_add(batch, operation);
 
@@ -1592,6 +5816,157 @@ j_distributed_object_write(JDistributedObject* object, gconstpointer data, guint
 	*bytes_written = 0;
 }
 
+/**
+ * Reads multiple regions of an object.
+ * All regions are distributed in one pass and each server receives a single message,
+ * which is considerably cheaper than calling j_distributed_object_read() for each region.
+ *
+ * \code
+ * JDistributedObjectExtent extents[2] = {
+ *   { buffer, 1024, 0 },
+ *   { buffer + 1024, 1024, 4096 }
+ * };
+ *
+ * j_distributed_object_readv(object, extents, 2, &bytes_read, batch);
+ * \endcode
+ *
+ * \param object     An object.
+ * \param extents    The regions to read.
+ * \param count      The number of regions.
+ * \param bytes_read Number of bytes read in total.
+ * \param batch      A batch.
+ **/
+void
+j_distributed_object_readv(JDistributedObject* object, JDistributedObjectExtent const* extents, guint32 count, guint64* bytes_read, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectVectorOperation* iop;
+	JOperation* operation;
+
+	g_return_if_fail(object != NULL);
+	g_return_if_fail(extents != NULL || count == 0);
+	g_return_if_fail(bytes_read != NULL);
+
+	*bytes_read = 0;
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	iop = j_distributed_object_vector_new(object, extents, count, bytes_read, FALSE);
+
+	operation = j_operation_new();
+	operation->key = object;
+	operation->data = iop;
+	operation->exec_func = j_distributed_object_readv_exec;
+	operation->free_func = j_distributed_object_vector_free;
+
+	j_batch_add(batch, operation);
+}
+
+/**
+ * Writes multiple regions of an object.
+ * All regions are distributed in one pass and each server receives a single message,
+ * which is considerably cheaper than calling j_distributed_object_write() for each region.
+ *
+ * \note
+ * j_distributed_object_writev() modifies bytes_written even if j_batch_execute() is not called.
+ *
+ * \code
+ * \endcode
+ *
+ * \param object        An object.
+ * \param extents       The regions to write.
+ * \param count         The number of regions.
+ * \param bytes_written Number of bytes written in total.
+ * \param batch         A batch.
+ **/
+void
+j_distributed_object_writev(JDistributedObject* object, JDistributedObjectExtent const* extents, guint32 count, guint64* bytes_written, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectVectorOperation* iop;
+	JOperation* operation;
+
+	g_return_if_fail(object != NULL);
+	g_return_if_fail(extents != NULL || count == 0);
+	g_return_if_fail(bytes_written != NULL);
+
+	*bytes_written = 0;
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	iop = j_distributed_object_vector_new(object, extents, count, bytes_written, TRUE);
+
+	operation = j_operation_new();
+	operation->key = object;
+	operation->data = iop;
+	operation->exec_func = j_distributed_object_writev_exec;
+	operation->free_func = j_distributed_object_vector_free;
+	operation->cache_func = j_distributed_object_writev_cache;
+
+	j_batch_add(batch, operation);
+}
+
+/**
+ * Appends data to the end of an object.
+ * The space is reserved atomically by the server holding the object's header, so that many clients can append to the same object without coordination.
+ * The end of the object is tracked separately from its size, that is, data written beyond it using j_distributed_object_write() may be overwritten by later appends.
+ *
+ * \code
+ * guint64 offset;
+ * guint64 bytes_written;
+ *
+ * j_distributed_object_append(object, record, record_len, &offset, &bytes_written, batch);
+ * j_batch_execute(batch);
+ * \endcode
+ *
+ * \param object        An object.
+ * \param data          A buffer holding the data to append.
+ * \param length        Number of bytes to append.
+ * \param offset        Returns the offset the data has been appended at.
+ * \param bytes_written Number of bytes written.
+ * \param batch         A batch.
+ **/
+void
+j_distributed_object_append(JDistributedObject* object, gconstpointer data, guint64 length, guint64* offset, guint64* bytes_written, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectOperation* iop;
+	JOperation* operation;
+
+	g_return_if_fail(object != NULL);
+	g_return_if_fail(data != NULL);
+	g_return_if_fail(length > 0);
+	g_return_if_fail(offset != NULL);
+	g_return_if_fail(bytes_written != NULL);
+
+	iop = g_slice_new(JDistributedObjectOperation);
+	iop->append.object = j_distributed_object_ref(object);
+	iop->append.data = data;
+	iop->append.length = length;
+	iop->append.offset = offset;
+	iop->append.bytes_written = bytes_written;
+
+	operation = j_operation_new();
+	operation->key = object;
+	operation->data = iop;
+	operation->exec_func = j_distributed_object_append_exec;
+	operation->free_func = j_distributed_object_append_free;
+
+	j_batch_add(batch, operation);
+
+	*offset = 0;
+	*bytes_written = 0;
+}
+
 /**
  * Get the status of an object.
  *
@@ -1656,6 +6031,151 @@ j_distributed_object_sync(JDistributedObject* object, JBatch* batch)
 	j_batch_add(batch, operation);
 }
 
+/**
+ * Tells the servers how a range of an object is going to be accessed.
+ * Each server receives advice for its part of the range, see j_object_advise().
+ * If the client's block cache is enabled, ranges that will be needed are fetched into it in the background instead.
+ *
+ * \code
+ * j_distributed_object_advise(object, J_ADVICE_RANDOM, 0, 0, batch);
+ * \endcode
+ *
+ * \param object An object.
+ * \param advice The expected access pattern.
+ * \param length The length of the range, 0 for the rest of the object.
+ * \param offset An offset within the object.
+ * \param batch  A batch.
+ **/
+void
+j_distributed_object_advise(JDistributedObject* object, JAdvice advice, guint64 length, guint64 offset, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectOperation* iop;
+	JOperation* operation;
+
+	g_return_if_fail(object != NULL);
+
+	iop = g_slice_new(JDistributedObjectOperation);
+	iop->advise.object = j_distributed_object_ref(object);
+	iop->advise.advice = advice;
+	iop->advise.length = length;
+	iop->advise.offset = offset;
+
+	operation = j_operation_new();
+	operation->key = object;
+	operation->data = iop;
+	operation->exec_func = j_distributed_object_advise_exec;
+	operation->free_func = j_distributed_object_advise_free;
+
+	j_batch_add(batch, operation);
+}
+
+/**
+ * Starts reading a range of an object that is going to be read soon.
+ * This is a shortcut for j_distributed_object_advise() with #J_ADVICE_WILL_NEED.
+ *
+ * \code
+ * j_distributed_object_prefetch(object, 64 * 1024 * 1024, 0, batch);
+ * j_batch_execute(batch);
+ * \endcode
+ *
+ * \param object An object.
+ * \param length The length of the range, 0 for the rest of the object.
+ * \param offset An offset within the object.
+ * \param batch  A batch.
+ **/
+void
+j_distributed_object_prefetch(JDistributedObject* object, guint64 length, guint64 offset, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	j_distributed_object_advise(object, J_ADVICE_WILL_NEED, length, offset, batch);
+}
+
+/**
+ * Clones an object, replacing the clone's data with a point-in-time copy of the object's data.
+ * Every server clones its part locally, so that cloning only costs metadata if the backend can share data, see j_object_clone().
+ * The distribution is copied along with the data.
+ *
+ * \code
+ * g_autoptr(JDistributedObject) snapshot = NULL;
+ *
+ * snapshot = j_distributed_object_new("snapshots", "checkpoint-1", NULL);
+ * j_distributed_object_clone(object, snapshot, batch);
+ * j_batch_execute(batch);
+ * \endcode
+ *
+ * \param object An object, which must have been written to at least once.
+ * \param clone  The clone, which should have been created without a distribution or with the object's one.
+ * \param batch  A batch.
+ **/
+void
+j_distributed_object_clone(JDistributedObject* object, JDistributedObject* clone, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectOperation* iop;
+	JOperation* operation;
+
+	g_return_if_fail(object != NULL);
+	g_return_if_fail(clone != NULL);
+
+	iop = g_slice_new(JDistributedObjectOperation);
+	iop->clone.object = j_distributed_object_ref(object);
+	iop->clone.clone = j_distributed_object_ref(clone);
+
+	operation = j_operation_new();
+	operation->key = object;
+	operation->data = iop;
+	operation->exec_func = j_distributed_object_clone_exec;
+	operation->free_func = j_distributed_object_clone_free;
+
+	j_batch_add(batch, operation);
+}
+
+/**
+ * Reduces a range of an object where it is stored, only transferring the results.
+ * Each server reduces its stripes in parallel, see j_object_reduce().
+ * The distribution's block size should be a multiple of the element size.
+ *
+ * \code
+ * \endcode
+ *
+ * \param object  An object.
+ * \param reduce  A reduction.
+ * \param length  Number of bytes to reduce.
+ * \param offset  An offset within #object, should be a multiple of the element size.
+ * \param success Returns whether the range could be reduced, can be NULL.
+ * \param batch   A batch.
+ **/
+void
+j_distributed_object_reduce(JDistributedObject* object, JReduce* reduce, guint64 length, guint64 offset, gboolean* success, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectOperation* iop;
+	JOperation* operation;
+
+	g_return_if_fail(object != NULL);
+	g_return_if_fail(reduce != NULL);
+
+	iop = g_slice_new(JDistributedObjectOperation);
+	iop->reduce.object = j_distributed_object_ref(object);
+	iop->reduce.reduce = j_reduce_ref(reduce);
+	iop->reduce.length = length;
+	iop->reduce.offset = offset;
+	iop->reduce.success = success;
+
+	operation = j_operation_new();
+	operation->key = object;
+	operation->data = iop;
+	operation->exec_func = j_distributed_object_reduce_exec;
+	operation->free_func = j_distributed_object_reduce_free;
+
+	j_batch_add(batch, operation);
+}
+
 /**
  * @}
  **/
@@ -55,6 +55,19 @@ struct JObjectIterator
 	JMessage** replies;
 	guint32 replies_n;
 	guint32 replies_cur;
+
+	/**
+	 * The requests and their connections when listing objects with their status, NULL otherwise.
+	 * Each server streams its listing in several replies, so the connection is only returned once the last reply has been received.
+	 **/
+	JMessage** messages;
+	gpointer* connections;
+
+	/**
+	 * The current modification time and size.
+	 **/
+	gint64 modification_time;
+	guint64 size;
 };
 
 static JMessage*
@@ -101,6 +114,86 @@ fetch_reply(guint32 index, gchar const* namespace, gchar const* prefix)
 	return reply;
 }
 
+/**
+ * Sends a list request to a server and receives the first reply.
+ *
+ * \private
+ *
+ * \param iterator  An iterator.
+ * \param index     The server's index.
+ * \param namespace A namespace.
+ * \param prefix    A prefix, an empty string to list all objects.
+ **/
+static void
+list_fetch_first(JObjectIterator* iterator, guint32 index, gchar const* namespace, gchar const* prefix)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessage* message;
+	JMessage* reply;
+	gpointer object_connection;
+	gsize namespace_len;
+	gsize prefix_len;
+
+	namespace_len = strlen(namespace) + 1;
+	prefix_len = strlen(prefix) + 1;
+
+	message = j_message_new(J_MESSAGE_OBJECT_LIST, namespace_len + prefix_len);
+	j_message_append_n(message, namespace, namespace_len);
+	j_message_append_n(message, prefix, prefix_len);
+
+	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, index);
+	reply = j_message_new_reply(message);
+
+	if (!j_message_send(message, object_connection) || !j_message_receive(reply, object_connection))
+	{
+		j_connection_pool_discard(J_BACKEND_TYPE_OBJECT, index, object_connection);
+		j_message_unref(reply);
+		reply = NULL;
+		object_connection = NULL;
+	}
+
+	iterator->messages[index] = message;
+	iterator->replies[index] = reply;
+	iterator->connections[index] = object_connection;
+}
+
+/**
+ * Receives the next reply of a list request.
+ *
+ * \private
+ *
+ * \param iterator An iterator.
+ * \param index    The server's index.
+ *
+ * \return TRUE on success, FALSE if the reply could not be received.
+ **/
+static gboolean
+list_fetch_next(JObjectIterator* iterator, guint32 index)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessage* reply;
+
+	reply = j_message_new_reply(iterator->messages[index]);
+
+	j_message_unref(iterator->replies[index]);
+	iterator->replies[index] = NULL;
+
+	if (!j_message_receive(reply, iterator->connections[index]))
+	{
+		j_connection_pool_discard(J_BACKEND_TYPE_OBJECT, index, iterator->connections[index]);
+		iterator->connections[index] = NULL;
+		j_message_unref(reply);
+
+		return FALSE;
+	}
+
+	iterator->replies[index] = reply;
+
+	return TRUE;
+}
+
 /**
  * Creates a new JObjectIterator.
  *
@@ -129,6 +222,10 @@ j_object_iterator_new(gchar const* namespace, gchar const* prefix)
 	iterator->replies_n = j_configuration_get_server_count(configuration, J_BACKEND_TYPE_OBJECT);
 	iterator->replies = g_new0(JMessage*, iterator->replies_n);
 	iterator->replies_cur = 0;
+	iterator->messages = NULL;
+	iterator->connections = NULL;
+	iterator->modification_time = 0;
+	iterator->size = 0;
 
 	if (iterator->object_backend == NULL)
 	{
@@ -174,6 +271,10 @@ j_object_iterator_new_for_index(guint32 index, gchar const* namespace, gchar con
 	iterator->replies_n = 1;
 	iterator->replies = g_new0(JMessage*, 1);
 	iterator->replies_cur = 0;
+	iterator->messages = NULL;
+	iterator->connections = NULL;
+	iterator->modification_time = 0;
+	iterator->size = 0;
 
 	if (iterator->object_backend == NULL)
 	{
@@ -194,6 +295,67 @@ j_object_iterator_new_for_index(guint32 index, gchar const* namespace, gchar con
 	return iterator;
 }
 
+/**
+ * Creates a new JObjectIterator that also returns the objects' modification times and sizes.
+ * Servers return the status while listing, so no additional status request is necessary per object.
+ *
+ * \code
+ * g_autoptr(JObjectIterator) iterator = NULL;
+ * gint64 modification_time;
+ * guint64 size;
+ *
+ * iterator = j_object_iterator_new_with_status("namespace", NULL);
+ *
+ * while (j_object_iterator_next(iterator))
+ * {
+ * 	j_object_iterator_get_status(iterator, &modification_time, &size);
+ * 	g_print("%s %" G_GUINT64_FORMAT "\n", j_object_iterator_get(iterator), size);
+ * }
+ * \endcode
+ *
+ * \param namespace A namespace.
+ * \param prefix    A prefix, NULL to list all objects.
+ *
+ * \return A new JObjectIterator.
+ **/
+JObjectIterator*
+j_object_iterator_new_with_status(gchar const* namespace, gchar const* prefix)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectIterator* iterator;
+
+	JConfiguration* configuration = j_configuration();
+
+	g_return_val_if_fail(namespace != NULL, NULL);
+
+	iterator = g_slice_new(JObjectIterator);
+	iterator->object_backend = j_object_get_backend();
+	iterator->cursor = NULL;
+	iterator->name = NULL;
+	iterator->replies_n = j_configuration_get_server_count(configuration, J_BACKEND_TYPE_OBJECT);
+	iterator->replies = g_new0(JMessage*, iterator->replies_n);
+	iterator->replies_cur = 0;
+	iterator->messages = g_new0(JMessage*, iterator->replies_n);
+	iterator->connections = g_new0(gpointer, iterator->replies_n);
+	iterator->modification_time = 0;
+	iterator->size = 0;
+
+	if (iterator->object_backend == NULL)
+	{
+		for (guint32 i = 0; i < iterator->replies_n; i++)
+		{
+			list_fetch_first(iterator, i, namespace, (prefix != NULL) ? prefix : "");
+		}
+	}
+	else
+	{
+		// FIXME j_backend_object_get_all(iterator->object_backend, namespace, &(iterator->cursor));
+	}
+
+	return iterator;
+}
+
 /**
  * Frees the memory allocated by the JObjectIterator.
  *
@@ -216,6 +378,26 @@ j_object_iterator_free(JObjectIterator* iterator)
 
 	g_free(iterator->replies);
 
+	if (iterator->messages != NULL)
+	{
+		for (guint32 i = 0; i < iterator->replies_n; i++)
+		{
+			// Connections with unread replies can not be reused
+			if (iterator->connections[i] != NULL)
+			{
+				j_connection_pool_discard(J_BACKEND_TYPE_OBJECT, i, iterator->connections[i]);
+			}
+
+			if (iterator->messages[i] != NULL)
+			{
+				j_message_unref(iterator->messages[i]);
+			}
+		}
+
+		g_free(iterator->messages);
+		g_free(iterator->connections);
+	}
+
 	g_slice_free(JObjectIterator, iterator);
 }
 
@@ -238,7 +420,41 @@ j_object_iterator_next(JObjectIterator* iterator)
 
 	g_return_val_if_fail(iterator != NULL, FALSE);
 
-	if (iterator->object_backend == NULL)
+	if (iterator->object_backend == NULL && iterator->messages != NULL)
+	{
+		while (iterator->replies_cur < iterator->replies_n)
+		{
+			JMessage* reply = iterator->replies[iterator->replies_cur];
+
+			if (reply != NULL)
+			{
+				iterator->name = j_message_get_string(reply);
+
+				if (iterator->name[0] != '\0')
+				{
+					iterator->modification_time = j_message_get_8(reply);
+					iterator->size = j_message_get_8(reply);
+
+					ret = TRUE;
+					break;
+				}
+
+				if (j_message_get_1(reply) != 0 && list_fetch_next(iterator, iterator->replies_cur))
+				{
+					continue;
+				}
+
+				if (iterator->connections[iterator->replies_cur] != NULL)
+				{
+					j_connection_pool_push(J_BACKEND_TYPE_OBJECT, iterator->replies_cur, iterator->connections[iterator->replies_cur]);
+					iterator->connections[iterator->replies_cur] = NULL;
+				}
+			}
+
+			iterator->replies_cur++;
+		}
+	}
+	else if (iterator->object_backend == NULL)
 	{
 	retry:
 		iterator->name = j_message_get_string(iterator->replies[iterator->replies_cur]);
@@ -281,6 +497,36 @@ j_object_iterator_get(JObjectIterator* iterator)
 	return iterator->name;
 }
 
+/**
+ * Returns the current object's modification time and size.
+ * Only available for iterators created with j_object_iterator_new_with_status().
+ *
+ * \code
+ * \endcode
+ *
+ * \param iterator          An iterator.
+ * \param modification_time Returns the modification time, can be NULL.
+ * \param size              Returns the size, can be NULL.
+ **/
+void
+j_object_iterator_get_status(JObjectIterator* iterator, gint64* modification_time, guint64* size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(iterator != NULL);
+	g_return_if_fail(iterator->messages != NULL);
+
+	if (modification_time != NULL)
+	{
+		*modification_time = iterator->modification_time;
+	}
+
+	if (size != NULL)
+	{
+		*size = iterator->size;
+	}
+}
+
 /**
  * @}
  **/
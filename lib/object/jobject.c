@@ -28,6 +28,8 @@
 
 #include <object/jobject.h>
 #include <object/jobject-internal.h>
+#include <object/jblock-cache-internal.h>
+#include <object/jburst-buffer-internal.h>
 
 #include <julea.h>
 
@@ -43,6 +45,12 @@ struct JObjectOperation
 {
 	union
 	{
+		struct
+		{
+			JObject* object;
+			guint64 size;
+		} create;
+
 		struct
 		{
 			JObject* object;
@@ -71,7 +79,65 @@ struct JObjectOperation
 			guint64 length;
 			guint64 offset;
 			guint64* bytes_written;
+
+			/**
+			 * The buffer containing the data, see j_buffer_ref().
+			 * Cached operations reference it instead of copying the data.
+			 **/
+			gpointer buffer;
 		} write;
+
+		struct
+		{
+			JObject* object;
+			gconstpointer data;
+			guint64 length;
+
+			/**
+			 * The offset of the counter to advance, #J_MESSAGE_APPEND_END to append data.
+			 **/
+			guint64 counter;
+
+			guint64* offset;
+			guint64* bytes_written;
+		} append;
+
+		struct
+		{
+			JObject* object;
+			guint64 length;
+			guint64 offset;
+		} discard;
+
+		struct
+		{
+			JObject* object;
+			JAdvice advice;
+			guint64 length;
+			guint64 offset;
+		} advise;
+
+		struct
+		{
+			JObject* object;
+			JObject* clone;
+		} clone;
+
+		struct
+		{
+			JObject* object;
+			JReduce* reduce;
+			guint64 length;
+			guint64 offset;
+			gboolean* success;
+		} reduce;
+
+		struct
+		{
+			gchar* namespace;
+			gchar* prefix;
+			guint64* deleted;
+		} delete_prefix;
 	};
 };
 
@@ -103,27 +169,34 @@ struct JObject
 	gint ref_count;
 };
 
+/**
+ * The number of bytes copied at once when cloning an object to another server.
+ **/
+#define J_OBJECT_CLONE_COPY_SIZE (4 * 1024 * 1024)
+
 static JBackend* j_object_backend = NULL;
 static GModule* j_object_module = NULL;
 
+/**
+ * Serializes appends if the object backend runs on the client.
+ **/
+static GMutex j_object_append_mutex[1];
+
 // FIXME copy and use GLib's G_DEFINE_CONSTRUCTOR/DESTRUCTOR
-static void __attribute__((constructor)) j_object_init(void);
 static void __attribute__((destructor)) j_object_fini(void);
 
 /**
  * Initializes the object client.
+ * Called on first use by j_object_get_backend(), so that processes not using the object client do not load its backend.
  */
-static void
-j_object_init(void)
+static gpointer
+j_object_init(gpointer data)
 {
 	gchar const* object_backend;
 	gchar const* object_component;
 	gchar const* object_path;
 
-	if (j_object_backend != NULL && j_object_module != NULL)
-	{
-		return;
-	}
+	(void)data;
 
 	object_backend = j_configuration_get_backend(j_configuration(), J_BACKEND_TYPE_OBJECT);
 	object_component = j_configuration_get_backend_component(j_configuration(), J_BACKEND_TYPE_OBJECT);
@@ -136,6 +209,8 @@ j_object_init(void)
 			g_critical("Could not initialize object backend %s.\n", object_backend);
 		}
 	}
+
+	return NULL;
 }
 
 /**
@@ -162,14 +237,52 @@ j_object_fini(void)
 	}
 }
 
+/**
+ * Returns the key identifying an object in the burst buffer.
+ *
+ * \private
+ **/
+static gchar*
+j_object_burst_buffer_key(JObject* object)
+{
+	return g_strdup_printf("object/%u/%s/%s", object->index, object->namespace, object->name);
+}
+
+/**
+ * Drains an object's data from the burst buffer.
+ * Has to be called before operations that do not take staged data into account.
+ *
+ * \private
+ *
+ * \param object An object.
+ **/
+static void
+j_object_burst_buffer_flush(JObject* object)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBurstBuffer* burst_buffer;
+	g_autofree gchar* key = NULL;
+
+	if ((burst_buffer = j_burst_buffer_get(NULL)) == NULL)
+	{
+		return;
+	}
+
+	key = j_object_burst_buffer_key(object);
+	j_burst_buffer_flush(burst_buffer, key);
+}
+
 static void
 j_object_create_free(gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JObject* object = data;
+	JObjectOperation* operation = data;
 
-	j_object_unref(object);
+	j_object_unref(operation->create.object);
+
+	g_slice_free(JObjectOperation, operation);
 }
 
 static void
@@ -227,6 +340,133 @@ j_object_write_free(gpointer data)
 
 	j_object_unref(operation->write.object);
 
+	if (operation->write.buffer != NULL)
+	{
+		j_buffer_free(operation->write.buffer);
+	}
+
+	g_slice_free(JObjectOperation, operation);
+}
+
+static void
+j_object_append_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* operation = data;
+
+	j_object_unref(operation->append.object);
+
+	g_slice_free(JObjectOperation, operation);
+}
+
+static guint64
+j_object_metadata_cache(gpointer data, gpointer buffer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	(void)data;
+	(void)buffer;
+
+	// The operation does not reference any data owned by the caller.
+	return 0;
+}
+
+static guint64
+j_object_write_cache(gpointer data, gpointer buffer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* operation = data;
+
+	// Data within a buffer does not have to be copied, the buffer is kept alive instead.
+	if (operation->write.buffer == NULL)
+	{
+		operation->write.buffer = j_buffer_ref(operation->write.data, operation->write.length);
+	}
+
+	if (buffer != NULL)
+	{
+		guint64* bytes_written = buffer;
+
+		if (operation->write.buffer == NULL)
+		{
+			gchar* write_data = (gchar*)(bytes_written + 1);
+
+			memcpy(write_data, operation->write.data, operation->write.length);
+			operation->write.data = write_data;
+		}
+
+		// The batch returns before the data is written, so the caller's counter is updated now.
+		*(operation->write.bytes_written) += operation->write.length;
+		*bytes_written = 0;
+
+		operation->write.bytes_written = bytes_written;
+	}
+
+	return sizeof(guint64) + ((operation->write.buffer != NULL) ? 0 : operation->write.length);
+}
+
+static void
+j_object_discard_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* operation = data;
+
+	j_object_unref(operation->discard.object);
+
+	g_slice_free(JObjectOperation, operation);
+}
+
+static void
+j_object_advise_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* operation = data;
+
+	j_object_unref(operation->advise.object);
+
+	g_slice_free(JObjectOperation, operation);
+}
+
+static void
+j_object_clone_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* operation = data;
+
+	j_object_unref(operation->clone.object);
+	j_object_unref(operation->clone.clone);
+
+	g_slice_free(JObjectOperation, operation);
+}
+
+static void
+j_object_reduce_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* operation = data;
+
+	j_object_unref(operation->reduce.object);
+	j_reduce_unref(operation->reduce.reduce);
+
+	g_slice_free(JObjectOperation, operation);
+}
+
+static void
+j_object_delete_prefix_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* operation = data;
+
+	g_free(operation->delete_prefix.namespace);
+	g_free(operation->delete_prefix.prefix);
+
 	g_slice_free(JObjectOperation, operation);
 }
 
@@ -249,9 +489,10 @@ j_object_create_exec(JList* operations, JSemantics* semantics)
 	g_return_val_if_fail(semantics != NULL, FALSE);
 
 	{
-		JObject* object;
+		JObjectOperation* operation = j_list_get_first(operations);
+		JObject* object = operation->create.object;
 
-		object = j_list_get_first(operations);
+		g_assert(operation != NULL);
 		g_assert(object != NULL);
 
 		namespace = object->namespace;
@@ -279,7 +520,9 @@ j_object_create_exec(JList* operations, JSemantics* semantics)
 
 	while (j_list_iterator_next(it))
 	{
-		JObject* object = j_list_iterator_get(it);
+		JObjectOperation* operation = j_list_iterator_get(it);
+		JObject* object = operation->create.object;
+		guint64 size = operation->create.size;
 
 		if (object_backend == NULL)
 		{
@@ -287,14 +530,16 @@ j_object_create_exec(JList* operations, JSemantics* semantics)
 
 			name_len = strlen(object->name) + 1;
 
-			j_message_add_operation(message, name_len);
+			j_message_add_operation(message, name_len + sizeof(guint64));
 			j_message_append_n(message, object->name, name_len);
+			j_message_append_8(message, &size);
 		}
 		else
 		{
 			gpointer object_handle;
 
 			ret = j_backend_object_create(object_backend, object->namespace, object->name, &object_handle) && ret;
+			ret = j_backend_object_preallocate(object_backend, object_handle, size) && ret;
 			ret = j_backend_object_close(object_backend, object_handle) && ret;
 		}
 	}
@@ -333,6 +578,7 @@ j_object_delete_exec(JList* operations, JSemantics* semantics)
 	gboolean ret = TRUE;
 
 	JBackend* object_backend;
+	JBlockCache* cache;
 	g_autoptr(JListIterator) it = NULL;
 	g_autoptr(JMessage) message = NULL;
 	gchar const* namespace;
@@ -367,6 +613,9 @@ j_object_delete_exec(JList* operations, JSemantics* semantics)
 	{
 		JObject* object = j_list_iterator_get(it);
 
+		// Staged data is drained first, so that it does not recreate the object later
+		j_object_burst_buffer_flush(object);
+
 		if (object_backend == NULL)
 		{
 			gsize name_len;
@@ -423,91 +672,242 @@ j_object_delete_exec(JList* operations, JSemantics* semantics)
 		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, index, object_connection);
 	}
 
+	if ((cache = j_block_cache_get(NULL)) != NULL)
+	{
+		j_list_iterator_free(it);
+		it = j_list_iterator_new(operations);
+
+		while (j_list_iterator_next(it))
+		{
+			JObject* object = j_list_iterator_get(it);
+
+			j_block_cache_invalidate(cache, object->index, object->namespace, object->name, G_MAXUINT64, 0);
+		}
+	}
+
 	return ret;
 }
 
-static gboolean
-j_object_read_exec(JList* operations, JSemantics* semantics)
+/**
+ * Deletes all objects whose names start with a prefix using a local backend.
+ *
+ * \private
+ *
+ * \return The number of deleted objects.
+ **/
+static guint64
+j_object_delete_prefix_local(JBackend* object_backend, gchar const* namespace, gchar const* prefix)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	// FIXME check return value for messages
-	gboolean ret = TRUE;
-
-	JBackend* object_backend;
-	JListIterator* it;
-	g_autoptr(JMessage) message = NULL;
-	JObject* object;
-	gpointer object_handle;
-
-	// FIXME
-	//JLock* lock = NULL;
+	g_autoptr(GPtrArray) names = NULL;
+	gchar const* name;
+	gpointer iterator;
+	guint64 count = 0;
 
-	g_return_val_if_fail(operations != NULL, FALSE);
-	g_return_val_if_fail(semantics != NULL, FALSE);
+	names = g_ptr_array_new_with_free_func(g_free);
 
+	// The names are collected first, since deleting objects would invalidate the iterator.
+	if (j_backend_object_get_by_prefix(object_backend, namespace, prefix, &iterator))
 	{
-		JObjectOperation* operation = j_list_get_first(operations);
+		while (j_backend_object_iterate(object_backend, iterator, &name))
+		{
+			g_ptr_array_add(names, g_strdup(name));
+		}
+	}
 
-		object = operation->read.object;
+	for (guint i = 0; i < names->len; i++)
+	{
+		gpointer object_handle;
 
-		g_assert(operation != NULL);
-		g_assert(object != NULL);
+		if (j_backend_object_open(object_backend, namespace, g_ptr_array_index(names, i), &object_handle)
+		    && j_backend_object_delete(object_backend, object_handle))
+		{
+			count++;
+		}
 	}
 
-	it = j_list_iterator_new(operations);
-	object_backend = j_object_get_backend();
+	return count;
+}
 
-	if (object_backend == NULL)
-	{
-		gsize name_len;
-		gsize namespace_len;
+static gboolean
+j_object_delete_prefix_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
 
-		namespace_len = strlen(object->namespace) + 1;
-		name_len = strlen(object->name) + 1;
+	gboolean ret = TRUE;
 
-		message = j_message_new(J_MESSAGE_OBJECT_READ, namespace_len + name_len);
-		j_message_set_semantics(message, semantics);
-		j_message_append_n(message, object->namespace, namespace_len);
-		j_message_append_n(message, object->name, name_len);
-	}
-	else
-	{
-		ret = j_backend_object_open(object_backend, object->namespace, object->name, &object_handle) && ret;
-	}
+	JBackend* object_backend;
+	JBurstBuffer* burst_buffer;
+	g_autoptr(JListIterator) it = NULL;
+	guint32 server_count;
 
-	/*
-	if (j_semantics_get(semantics, J_SEMANTICS_ATOMICITY) != J_SEMANTICS_ATOMICITY_NONE)
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	it = j_list_iterator_new(operations);
+	object_backend = j_object_get_backend();
+	server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
+
+	if ((burst_buffer = j_burst_buffer_get(NULL)) != NULL)
 	{
-		lock = j_lock_new("item", path);
+		j_burst_buffer_flush_all(burst_buffer);
 	}
-	*/
 
 	while (j_list_iterator_next(it))
 	{
 		JObjectOperation* operation = j_list_iterator_get(it);
-		gpointer data = operation->read.data;
-		guint64 length = operation->read.length;
-		guint64 offset = operation->read.offset;
-		guint64* bytes_read = operation->read.bytes_read;
-
-		j_trace_file_begin(object->name, J_TRACE_FILE_READ);
+		gchar const* namespace = operation->delete_prefix.namespace;
+		gchar const* prefix = operation->delete_prefix.prefix;
+		guint64 count = 0;
 
 		if (object_backend == NULL)
 		{
-			j_message_add_operation(message, sizeof(guint64) + sizeof(guint64));
-			j_message_append_8(message, &length);
-			j_message_append_8(message, &offset);
-		}
-		else
+			g_autofree JMessage** messages = NULL;
+			g_autofree gpointer* connections = NULL;
+			gsize namespace_len;
+			gsize prefix_len;
+
+			namespace_len = strlen(namespace) + 1;
+			prefix_len = strlen(prefix) + 1;
+
+			messages = g_new(JMessage*, server_count);
+			connections = g_new(gpointer, server_count);
+
+			// All servers delete their objects concurrently.
+			for (guint i = 0; i < server_count; i++)
+			{
+				messages[i] = j_message_new(J_MESSAGE_OBJECT_DELETE_PREFIX, namespace_len + prefix_len);
+				j_message_set_semantics(messages[i], semantics);
+				j_message_append_n(messages[i], namespace, namespace_len);
+				j_message_append_n(messages[i], prefix, prefix_len);
+
+				connections[i] = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, i);
+				j_message_send(messages[i], connections[i]);
+			}
+
+			for (guint i = 0; i < server_count; i++)
+			{
+				g_autoptr(JMessage) reply = NULL;
+
+				reply = j_message_new_reply(messages[i]);
+
+				if (j_message_receive(reply, connections[i]))
+				{
+					count += j_message_get_8(reply);
+				}
+				else
+				{
+					ret = FALSE;
+				}
+
+				j_connection_pool_push(J_BACKEND_TYPE_OBJECT, i, connections[i]);
+				j_message_unref(messages[i]);
+			}
+		}
+		else
+		{
+			count = j_object_delete_prefix_local(object_backend, namespace, prefix);
+		}
+
+		j_block_cache_invalidate_prefix(j_block_cache_get(NULL), namespace, prefix);
+
+		if (operation->delete_prefix.deleted != NULL)
+		{
+			*(operation->delete_prefix.deleted) = count;
+		}
+	}
+
+	return ret;
+}
+
+static gboolean
+j_object_read_exec_uncached(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	// FIXME check return value for messages
+	gboolean ret = TRUE;
+
+	JBackend* object_backend;
+	JListIterator* it;
+	g_autoptr(JMessage) message = NULL;
+	g_autoptr(GArray) extents = NULL;
+	JObject* object;
+	gpointer object_handle;
+
+	// FIXME
+	//JLock* lock = NULL;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JObjectOperation* operation = j_list_get_first(operations);
+
+		object = operation->read.object;
+
+		g_assert(operation != NULL);
+		g_assert(object != NULL);
+	}
+
+	it = j_list_iterator_new(operations);
+	object_backend = j_object_get_backend();
+
+	if (object_backend == NULL)
+	{
+		gsize name_len;
+		gsize namespace_len;
+
+		namespace_len = strlen(object->namespace) + 1;
+		name_len = strlen(object->name) + 1;
+
+		message = j_message_new(J_MESSAGE_OBJECT_READ, namespace_len + name_len);
+		j_message_set_semantics(message, semantics);
+		j_message_append_n(message, object->namespace, namespace_len);
+		j_message_append_n(message, object->name, name_len);
+	}
+	else
+	{
+		ret = j_backend_object_open(object_backend, object->namespace, object->name, &object_handle) && ret;
+		extents = g_array_new(FALSE, FALSE, sizeof(JBackendObjectExtent));
+	}
+
+	/*
+	if (j_semantics_get(semantics, J_SEMANTICS_ATOMICITY) != J_SEMANTICS_ATOMICITY_NONE)
+	{
+		lock = j_lock_new("item", path);
+	}
+	*/
+
+	while (j_list_iterator_next(it))
+	{
+		JObjectOperation* operation = j_list_iterator_get(it);
+		gpointer data = operation->read.data;
+		guint64 length = operation->read.length;
+		guint64 offset = operation->read.offset;
+
+		if (object_backend == NULL)
 		{
-			guint64 nbytes = 0;
+			j_trace_file_begin(object->name, J_TRACE_FILE_READ);
+
+			j_message_add_operation(message, sizeof(guint64) + sizeof(guint64));
+			j_message_append_8(message, &length);
+			j_message_append_8(message, &offset);
 
-			ret = j_backend_object_read(object_backend, object_handle, data, length, offset, &nbytes) && ret;
-			j_helper_atomic_add(bytes_read, nbytes);
+			j_trace_file_end(object->name, J_TRACE_FILE_READ, length, offset);
 		}
+		else
+		{
+			JBackendObjectExtent extent;
+
+			extent.data = data;
+			extent.length = length;
+			extent.offset = offset;
+			extent.bytes = 0;
 
-		j_trace_file_end(object->name, J_TRACE_FILE_READ, length, offset);
+			g_array_append_val(extents, extent);
+		}
 	}
 
 	j_list_iterator_free(it);
@@ -555,13 +955,12 @@ j_object_read_exec(JList* operations, JSemantics* semantics)
 
 				if (nbytes > 0)
 				{
-					GInputStream* input;
-
-					input = g_io_stream_get_input_stream(G_IO_STREAM(object_connection));
-					g_input_stream_read_all(input, data, nbytes, NULL, NULL, NULL);
+					j_message_add_receive(reply, data, nbytes);
 				}
 			}
 
+			j_message_receive_data(reply, object_connection);
+
 			operations_done += reply_operation_count;
 		}
 
@@ -571,6 +970,29 @@ j_object_read_exec(JList* operations, JSemantics* semantics)
 	}
 	else
 	{
+		guint64 length = 0;
+		guint i = 0;
+
+		// Hand all extents to the backend at once so that it can issue them concurrently.
+		// They are in flight together, so they are traced as one operation starting at the first extent.
+		j_trace_file_begin(object->name, J_TRACE_FILE_READ);
+		ret = j_backend_object_readv(object_backend, object_handle, (JBackendObjectExtent*)(gpointer)extents->data, extents->len) && ret;
+
+		it = j_list_iterator_new(operations);
+
+		while (j_list_iterator_next(it))
+		{
+			JObjectOperation* operation = j_list_iterator_get(it);
+
+			length += g_array_index(extents, JBackendObjectExtent, i).length;
+			j_helper_atomic_add(operation->read.bytes_read, g_array_index(extents, JBackendObjectExtent, i).bytes);
+			i++;
+		}
+
+		j_trace_file_end(object->name, J_TRACE_FILE_READ, length, (extents->len > 0) ? g_array_index(extents, JBackendObjectExtent, 0).offset : 0);
+
+		j_list_iterator_free(it);
+
 		ret = j_backend_object_close(object_backend, object_handle) && ret;
 	}
 
@@ -587,8 +1009,160 @@ j_object_read_exec(JList* operations, JSemantics* semantics)
 	return ret;
 }
 
+struct JObjectCacheFetch
+{
+	JObject* object;
+	JSemantics* semantics;
+};
+
+typedef struct JObjectCacheFetch JObjectCacheFetch;
+
 static gboolean
-j_object_write_exec(JList* operations, JSemantics* semantics)
+j_object_read_cache_fetch(JBlockCacheRead* reads, guint count, gpointer user_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectCacheFetch* fetch = user_data;
+
+	g_autoptr(JList) operations = NULL;
+	g_autofree JObjectOperation* fetch_operations = NULL;
+
+	operations = j_list_new(NULL);
+	fetch_operations = g_new(JObjectOperation, count);
+
+	for (guint i = 0; i < count; i++)
+	{
+		fetch_operations[i].read.object = fetch->object;
+		fetch_operations[i].read.data = reads[i].data;
+		fetch_operations[i].read.length = reads[i].length;
+		fetch_operations[i].read.offset = reads[i].offset;
+		fetch_operations[i].read.bytes_read = reads[i].bytes_read;
+
+		j_list_append(operations, &(fetch_operations[i]));
+	}
+
+	return j_object_read_exec_uncached(operations, fetch->semantics);
+}
+
+static gboolean
+j_object_read_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBlockCache* cache;
+	JBurstBuffer* burst_buffer;
+	JObjectCacheFetch fetch;
+	g_autoptr(JListIterator) it = NULL;
+	g_autoptr(JList) unstaged = NULL;
+	g_autofree JBlockCacheRead* reads = NULL;
+	guint count = 0;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	// Staged data is newer than the servers' data, regardless of the semantics
+	if ((burst_buffer = j_burst_buffer_get(NULL)) != NULL)
+	{
+		g_autofree gchar* key = NULL;
+
+		unstaged = j_list_new(NULL);
+		it = j_list_iterator_new(operations);
+
+		while (j_list_iterator_next(it))
+		{
+			JObjectOperation* operation = j_list_iterator_get(it);
+
+			if (key == NULL)
+			{
+				key = j_object_burst_buffer_key(operation->read.object);
+			}
+
+			if (!j_burst_buffer_read(burst_buffer, key, operation->read.data, operation->read.length, operation->read.offset, operation->read.bytes_read))
+			{
+				j_list_append(unstaged, operation);
+			}
+		}
+
+		g_clear_pointer(&it, j_list_iterator_free);
+
+		if (j_list_length(unstaged) == 0)
+		{
+			return TRUE;
+		}
+
+		operations = unstaged;
+	}
+
+	// The cache is only used for remote objects
+	if (j_object_get_backend() != NULL || (cache = j_block_cache_get(semantics)) == NULL)
+	{
+		return j_object_read_exec_uncached(operations, semantics);
+	}
+
+	{
+		JObjectOperation* operation = j_list_get_first(operations);
+		g_assert(operation != NULL);
+
+		fetch.object = operation->read.object;
+		fetch.semantics = semantics;
+	}
+
+	reads = g_new(JBlockCacheRead, j_list_length(operations));
+	it = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(it))
+	{
+		JObjectOperation* operation = j_list_iterator_get(it);
+
+		reads[count].data = operation->read.data;
+		reads[count].length = operation->read.length;
+		reads[count].offset = operation->read.offset;
+		reads[count].bytes_read = operation->read.bytes_read;
+		count++;
+	}
+
+	return j_block_cache_read(cache, fetch.object->index, fetch.object->namespace, fetch.object->name, reads, count, j_object_read_cache_fetch, &fetch);
+}
+
+/**
+ * A range to be read into the block cache in the background.
+ **/
+struct JObjectPrefetch
+{
+	JObject* object;
+	JSemantics* semantics;
+	guint64 length;
+	guint64 offset;
+};
+
+typedef struct JObjectPrefetch JObjectPrefetch;
+
+static gpointer
+j_object_prefetch_background(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectPrefetch* prefetch = data;
+	JBlockCache* cache;
+	JObjectCacheFetch fetch;
+
+	fetch.object = prefetch->object;
+	fetch.semantics = prefetch->semantics;
+
+	if ((cache = j_block_cache_get(prefetch->semantics)) != NULL)
+	{
+		j_block_cache_prefetch(cache, prefetch->object->index, prefetch->object->namespace, prefetch->object->name, prefetch->length, prefetch->offset, j_object_read_cache_fetch, &fetch);
+	}
+
+	j_object_unref(prefetch->object);
+	j_semantics_unref(prefetch->semantics);
+	g_slice_free(JObjectPrefetch, prefetch);
+
+	return NULL;
+}
+
+static gboolean
+j_object_write_exec_direct(JList* operations, JSemantics* semantics)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -596,8 +1170,10 @@ j_object_write_exec(JList* operations, JSemantics* semantics)
 	gboolean ret = TRUE;
 
 	JBackend* object_backend;
+	JBlockCache* cache;
 	JListIterator* it;
 	g_autoptr(JMessage) message = NULL;
+	g_autoptr(GArray) extents = NULL;
 	JObject* object;
 	gpointer object_handle;
 
@@ -635,6 +1211,7 @@ j_object_write_exec(JList* operations, JSemantics* semantics)
 	else
 	{
 		ret = j_backend_object_open(object_backend, object->namespace, object->name, &object_handle) && ret;
+		extents = g_array_new(FALSE, FALSE, sizeof(JBackendObjectExtent));
 	}
 
 	/*
@@ -652,8 +1229,6 @@ j_object_write_exec(JList* operations, JSemantics* semantics)
 		guint64 offset = operation->write.offset;
 		guint64* bytes_written = operation->write.bytes_written;
 
-		j_trace_file_begin(object->name, J_TRACE_FILE_WRITE);
-
 		/*
 		if (lock != NULL)
 		{
@@ -663,6 +1238,8 @@ j_object_write_exec(JList* operations, JSemantics* semantics)
 
 		if (object_backend == NULL)
 		{
+			j_trace_file_begin(object->name, J_TRACE_FILE_WRITE);
+
 			j_message_add_operation(message, sizeof(guint64) + sizeof(guint64));
 			j_message_append_8(message, &length);
 			j_message_append_8(message, &offset);
@@ -673,16 +1250,20 @@ j_object_write_exec(JList* operations, JSemantics* semantics)
 			{
 				j_helper_atomic_add(bytes_written, length);
 			}
+
+			j_trace_file_end(object->name, J_TRACE_FILE_WRITE, length, offset);
 		}
 		else
 		{
-			guint64 nbytes = 0;
+			JBackendObjectExtent extent;
 
-			ret = j_backend_object_write(object_backend, object_handle, data, length, offset, &nbytes) && ret;
-			j_helper_atomic_add(bytes_written, nbytes);
-		}
+			extent.data = (gpointer)data;
+			extent.length = length;
+			extent.offset = offset;
+			extent.bytes = 0;
 
-		j_trace_file_end(object->name, J_TRACE_FILE_WRITE, length, offset);
+			g_array_append_val(extents, extent);
+		}
 	}
 
 	j_list_iterator_free(it);
@@ -723,6 +1304,27 @@ j_object_write_exec(JList* operations, JSemantics* semantics)
 	}
 	else
 	{
+		guint64 length = 0;
+		guint i = 0;
+
+		j_trace_file_begin(object->name, J_TRACE_FILE_WRITE);
+		ret = j_backend_object_writev(object_backend, object_handle, (JBackendObjectExtent*)(gpointer)extents->data, extents->len) && ret;
+
+		it = j_list_iterator_new(operations);
+
+		while (j_list_iterator_next(it))
+		{
+			JObjectOperation* operation = j_list_iterator_get(it);
+
+			length += g_array_index(extents, JBackendObjectExtent, i).length;
+			j_helper_atomic_add(operation->write.bytes_written, g_array_index(extents, JBackendObjectExtent, i).bytes);
+			i++;
+		}
+
+		j_trace_file_end(object->name, J_TRACE_FILE_WRITE, length, (extents->len > 0) ? g_array_index(extents, JBackendObjectExtent, 0).offset : 0);
+
+		j_list_iterator_free(it);
+
 		ret = j_backend_object_close(object_backend, object_handle) && ret;
 	}
 
@@ -736,37 +1338,333 @@ j_object_write_exec(JList* operations, JSemantics* semantics)
 	}
 	*/
 
+	if ((cache = j_block_cache_get(NULL)) != NULL)
+	{
+		it = j_list_iterator_new(operations);
+
+		// Invalidate after writing, so that blocks fetched concurrently are not inserted
+		while (j_list_iterator_next(it))
+		{
+			JObjectOperation* operation = j_list_iterator_get(it);
+
+			j_block_cache_invalidate(cache, object->index, object->namespace, object->name, operation->write.length, operation->write.offset);
+		}
+
+		j_list_iterator_free(it);
+	}
+
 	return ret;
 }
 
 static gboolean
-j_object_status_exec(JList* operations, JSemantics* semantics)
+j_object_burst_buffer_drain(gpointer data, gconstpointer buffer, guint64 length, guint64 offset)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	// FIXME check return value for messages
-	gboolean ret = TRUE;
+	JObjectOperation operation;
+	g_autoptr(JList) operations = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	guint64 bytes_written = 0;
+	gboolean ret;
 
-	JBackend* object_backend;
-	JListIterator* it;
-	g_autoptr(JMessage) message = NULL;
-	gchar const* namespace;
-	gsize namespace_len;
-	guint32 index;
+	operation.write.object = data;
+	operation.write.data = buffer;
+	operation.write.length = length;
+	operation.write.offset = offset;
+	operation.write.bytes_written = &bytes_written;
 
-	g_return_val_if_fail(operations != NULL, FALSE);
-	g_return_val_if_fail(semantics != NULL, FALSE);
+	operations = j_list_new(NULL);
+	j_list_append(operations, &operation);
 
-	{
-		JObjectOperation* operation = j_list_get_first(operations);
-		JObject* object = operation->status.object;
+	// The exec function is called directly, since batches could wait for the burst buffer
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	ret = j_object_write_exec_direct(operations, semantics);
 
-		g_assert(operation != NULL);
-		g_assert(object != NULL);
+	return ret && bytes_written == length;
+}
 
-		namespace = object->namespace;
-		namespace_len = strlen(namespace) + 1;
-		index = object->index;
+static JBurstBufferType const j_object_burst_buffer_type = {
+	(gpointer(*)(gpointer))j_object_ref,
+	(GDestroyNotify)j_object_unref,
+	j_object_burst_buffer_drain
+};
+
+/**
+ * Executes write operations, staging them in the burst buffer if the semantics allow it.
+ *
+ * \private
+ **/
+static gboolean
+j_object_write_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBurstBuffer* burst_buffer;
+	g_autoptr(JList) unstaged = NULL;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	if ((burst_buffer = j_burst_buffer_get(semantics)) != NULL)
+	{
+		g_autoptr(JListIterator) it = NULL;
+		g_autofree gchar* key = NULL;
+
+		unstaged = j_list_new(NULL);
+		it = j_list_iterator_new(operations);
+
+		while (j_list_iterator_next(it))
+		{
+			JObjectOperation* operation = j_list_iterator_get(it);
+
+			if (key == NULL)
+			{
+				key = j_object_burst_buffer_key(operation->write.object);
+			}
+
+			// Once a write has not been staged, the following ones are written directly to keep their order
+			if (j_list_length(unstaged) == 0
+			    && j_burst_buffer_write(burst_buffer, key, &j_object_burst_buffer_type, operation->write.object, operation->write.data, operation->write.length, operation->write.offset))
+			{
+				j_helper_atomic_add(operation->write.bytes_written, operation->write.length);
+				continue;
+			}
+
+			j_list_append(unstaged, operation);
+		}
+
+		if (j_list_length(unstaged) == 0)
+		{
+			return TRUE;
+		}
+
+		operations = unstaged;
+	}
+
+	return j_object_write_exec_direct(operations, semantics);
+}
+
+/**
+ * Appends data to the end of an object, or advances a counter stored within it.
+ * Both are performed by a single server call while holding a lock, so that concurrent appends never get the same offset.
+ *
+ * \private
+ *
+ * \param backend   The object backend.
+ * \param object    The backend object.
+ * \param data      The data to append.
+ * \param length    The number of bytes.
+ * \param counter   The offset of the counter, #J_MESSAGE_APPEND_END to append data.
+ * \param offset    Returns the offset the data has been appended at or the counter's previous value.
+ *
+ * \return The number of bytes appended or reserved.
+ **/
+static guint64
+j_object_append_local(JBackend* backend, gpointer object, gconstpointer data, guint64 length, guint64 counter, guint64* offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 bytes_written = 0;
+
+	*offset = 0;
+
+	g_mutex_lock(j_object_append_mutex);
+
+	if (counter == J_MESSAGE_APPEND_END)
+	{
+		gint64 modification_time;
+
+		if (j_backend_object_status(backend, object, &modification_time, offset))
+		{
+			j_backend_object_write(backend, object, data, length, *offset, &bytes_written);
+		}
+	}
+	else
+	{
+		guint64 value = 0;
+		guint64 bytes = 0;
+
+		if (j_backend_object_read(backend, object, &value, sizeof(value), counter, &bytes))
+		{
+			*offset = (bytes == sizeof(value)) ? GUINT64_FROM_LE(value) : 0;
+			value = GUINT64_TO_LE(*offset + length);
+
+			if (j_backend_object_write(backend, object, &value, sizeof(value), counter, &bytes) && bytes == sizeof(value))
+			{
+				bytes_written = length;
+			}
+		}
+	}
+
+	g_mutex_unlock(j_object_append_mutex);
+
+	return bytes_written;
+}
+
+static gboolean
+j_object_append_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* object_backend;
+	JBlockCache* cache;
+	JListIterator* it;
+	g_autoptr(JMessage) message = NULL;
+	JObject* object;
+	gpointer object_handle = NULL;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JObjectOperation* operation = j_list_get_first(operations);
+
+		g_assert(operation != NULL);
+
+		object = operation->append.object;
+	}
+
+	j_object_burst_buffer_flush(object);
+
+	it = j_list_iterator_new(operations);
+	object_backend = j_object_get_backend();
+
+	if (object_backend == NULL)
+	{
+		gsize name_len;
+		gsize namespace_len;
+
+		namespace_len = strlen(object->namespace) + 1;
+		name_len = strlen(object->name) + 1;
+
+		message = j_message_new(J_MESSAGE_OBJECT_APPEND, namespace_len + name_len);
+		j_message_set_semantics(message, semantics);
+		j_message_append_n(message, object->namespace, namespace_len);
+		j_message_append_n(message, object->name, name_len);
+	}
+	else
+	{
+		ret = j_backend_object_open(object_backend, object->namespace, object->name, &object_handle) && ret;
+	}
+
+	while (j_list_iterator_next(it))
+	{
+		JObjectOperation* operation = j_list_iterator_get(it);
+		guint64 length = operation->append.length;
+		guint64 counter = operation->append.counter;
+
+		j_trace_file_begin(object->name, J_TRACE_FILE_WRITE);
+
+		if (object_backend == NULL)
+		{
+			j_message_add_operation(message, sizeof(guint64) + sizeof(guint64));
+			j_message_append_8(message, &length);
+			j_message_append_8(message, &counter);
+
+			if (counter == J_MESSAGE_APPEND_END)
+			{
+				j_message_add_send(message, operation->append.data, length);
+			}
+		}
+		else if (object_handle != NULL)
+		{
+			guint64 bytes_written;
+
+			bytes_written = j_object_append_local(object_backend, object_handle, operation->append.data, length, counter, operation->append.offset);
+			j_helper_atomic_add(operation->append.bytes_written, bytes_written);
+			ret = (bytes_written == length) && ret;
+		}
+
+		j_trace_file_end(object->name, J_TRACE_FILE_WRITE, length, 0);
+	}
+
+	j_list_iterator_free(it);
+
+	if (object_backend == NULL)
+	{
+		g_autoptr(JMessage) reply = NULL;
+		gpointer object_connection;
+
+		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, object->index);
+		j_message_send(message, object_connection);
+
+		// The server always replies, since the offsets are only known afterwards
+		reply = j_message_new_reply(message);
+		j_message_receive(reply, object_connection);
+
+		it = j_list_iterator_new(operations);
+
+		while (j_list_iterator_next(it))
+		{
+			JObjectOperation* operation = j_list_iterator_get(it);
+			guint64 nbytes;
+
+			*(operation->append.offset) = j_message_get_8(reply);
+			nbytes = j_message_get_8(reply);
+
+			j_helper_atomic_add(operation->append.bytes_written, nbytes);
+			ret = (nbytes == operation->append.length) && ret;
+		}
+
+		j_list_iterator_free(it);
+
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, object->index, object_connection);
+	}
+	else if (object_handle != NULL)
+	{
+		ret = j_backend_object_close(object_backend, object_handle) && ret;
+	}
+
+	if ((cache = j_block_cache_get(NULL)) != NULL)
+	{
+		it = j_list_iterator_new(operations);
+
+		while (j_list_iterator_next(it))
+		{
+			JObjectOperation* operation = j_list_iterator_get(it);
+
+			if (operation->append.counter == J_MESSAGE_APPEND_END)
+			{
+				j_block_cache_invalidate(cache, object->index, object->namespace, object->name, operation->append.length, *(operation->append.offset));
+			}
+		}
+
+		j_list_iterator_free(it);
+	}
+
+	return ret;
+}
+
+static gboolean
+j_object_status_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	// FIXME check return value for messages
+	gboolean ret = TRUE;
+
+	JBackend* object_backend;
+	JListIterator* it;
+	g_autoptr(JMessage) message = NULL;
+	gchar const* namespace;
+	gsize namespace_len;
+	guint32 index;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JObjectOperation* operation = j_list_get_first(operations);
+		JObject* object = operation->status.object;
+
+		g_assert(operation != NULL);
+		g_assert(object != NULL);
+
+		namespace = object->namespace;
+		namespace_len = strlen(namespace) + 1;
+		index = object->index;
 	}
 
 	it = j_list_iterator_new(operations);
@@ -786,6 +1684,8 @@ j_object_status_exec(JList* operations, JSemantics* semantics)
 		gint64* modification_time = operation->status.modification_time;
 		guint64* size = operation->status.size;
 
+		j_object_burst_buffer_flush(object);
+
 		if (object_backend == NULL)
 		{
 			gsize name_len;
@@ -810,13 +1710,14 @@ j_object_status_exec(JList* operations, JSemantics* semantics)
 	if (object_backend == NULL)
 	{
 		g_autoptr(JMessage) reply = NULL;
-		gpointer object_connection;
-
-		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, index);
-		j_message_send(message, object_connection);
 
 		reply = j_message_new_reply(message);
-		j_message_receive(reply, object_connection);
+
+		// Status requests are idempotent and can be retried after network errors
+		if (!j_connection_pool_exchange(J_BACKEND_TYPE_OBJECT, index, message, reply))
+		{
+			return FALSE;
+		}
 
 		it = j_list_iterator_new(operations);
 
@@ -843,8 +1744,6 @@ j_object_status_exec(JList* operations, JSemantics* semantics)
 		}
 
 		j_list_iterator_free(it);
-
-		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, index, object_connection);
 	}
 
 	return ret;
@@ -895,6 +1794,8 @@ j_object_sync_exec(JList* operations, JSemantics* semantics)
 		JObjectOperation* operation = j_list_iterator_get(it);
 		JObject* object = operation->sync.object;
 
+		j_object_burst_buffer_flush(object);
+
 		if (object_backend == NULL)
 		{
 			gsize name_len;
@@ -906,11 +1807,614 @@ j_object_sync_exec(JList* operations, JSemantics* semantics)
 		}
 		else
 		{
-			gpointer object_handle;
+			gpointer object_handle;
+
+			ret = j_backend_object_open(object_backend, object->namespace, object->name, &object_handle) && ret;
+			ret = j_backend_object_sync(object_backend, object_handle) && ret;
+			ret = j_backend_object_close(object_backend, object_handle) && ret;
+		}
+	}
+
+	j_list_iterator_free(it);
+
+	if (object_backend == NULL)
+	{
+		JSemanticsSafety safety;
+		gpointer object_connection;
+
+		safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
+		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, index);
+		j_message_send(message, object_connection);
+
+		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		{
+			g_autoptr(JMessage) reply = NULL;
+
+			reply = j_message_new_reply(message);
+			j_message_receive(reply, object_connection);
+
+			// FIXME do something with reply
+		}
+
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, index, object_connection);
+	}
+
+	return ret;
+}
+
+static gboolean
+j_object_discard_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* object_backend;
+	JBlockCache* cache;
+	JListIterator* it;
+	g_autoptr(JMessage) message = NULL;
+	JObject* object;
+	gpointer object_handle = NULL;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JObjectOperation* operation = j_list_get_first(operations);
+
+		g_assert(operation != NULL);
+
+		object = operation->discard.object;
+	}
+
+	j_object_burst_buffer_flush(object);
+
+	it = j_list_iterator_new(operations);
+	object_backend = j_object_get_backend();
+
+	if (object_backend == NULL)
+	{
+		gsize name_len;
+		gsize namespace_len;
+
+		namespace_len = strlen(object->namespace) + 1;
+		name_len = strlen(object->name) + 1;
+
+		message = j_message_new(J_MESSAGE_OBJECT_DISCARD, namespace_len + name_len);
+		j_message_set_semantics(message, semantics);
+		j_message_append_n(message, object->namespace, namespace_len);
+		j_message_append_n(message, object->name, name_len);
+	}
+	else
+	{
+		ret = j_backend_object_open(object_backend, object->namespace, object->name, &object_handle) && ret;
+	}
+
+	while (j_list_iterator_next(it))
+	{
+		JObjectOperation* operation = j_list_iterator_get(it);
+		guint64 length = operation->discard.length;
+		guint64 offset = operation->discard.offset;
+
+		if (object_backend == NULL)
+		{
+			j_message_add_operation(message, sizeof(guint64) + sizeof(guint64));
+			j_message_append_8(message, &length);
+			j_message_append_8(message, &offset);
+		}
+		else if (object_handle != NULL)
+		{
+			ret = j_backend_object_discard(object_backend, object_handle, length, offset) && ret;
+		}
+	}
+
+	j_list_iterator_free(it);
+
+	if (object_backend == NULL)
+	{
+		JSemanticsSafety safety;
+		gpointer object_connection;
+
+		safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
+		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, object->index);
+		j_message_send(message, object_connection);
+
+		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		{
+			g_autoptr(JMessage) reply = NULL;
+			guint32 reply_operation_count;
+
+			reply = j_message_new_reply(message);
+			j_message_receive(reply, object_connection);
+
+			reply_operation_count = j_message_get_count(reply);
+
+			for (guint i = 0; i < reply_operation_count; i++)
+			{
+				ret = (j_message_get_4(reply) != 0) && ret;
+			}
+		}
+
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, object->index, object_connection);
+	}
+	else if (object_handle != NULL)
+	{
+		ret = j_backend_object_close(object_backend, object_handle) && ret;
+	}
+
+	if ((cache = j_block_cache_get(NULL)) != NULL)
+	{
+		it = j_list_iterator_new(operations);
+
+		while (j_list_iterator_next(it))
+		{
+			JObjectOperation* operation = j_list_iterator_get(it);
+
+			j_block_cache_invalidate(cache, object->index, object->namespace, object->name, operation->discard.length, operation->discard.offset);
+		}
+
+		j_list_iterator_free(it);
+	}
+
+	return ret;
+}
+
+static gboolean
+j_object_advise_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* object_backend;
+	JBlockCache* cache = NULL;
+	JListIterator* it;
+	g_autoptr(JMessage) message = NULL;
+	JObject* object;
+	gpointer object_handle = NULL;
+	guint32 count = 0;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JObjectOperation* operation = j_list_get_first(operations);
+
+		g_assert(operation != NULL);
+
+		object = operation->advise.object;
+	}
+
+	it = j_list_iterator_new(operations);
+	object_backend = j_object_get_backend();
+
+	if (object_backend == NULL)
+	{
+		gsize name_len;
+		gsize namespace_len;
+
+		namespace_len = strlen(object->namespace) + 1;
+		name_len = strlen(object->name) + 1;
+
+		message = j_message_new(J_MESSAGE_OBJECT_ADVISE, namespace_len + name_len);
+		j_message_set_semantics(message, semantics);
+		j_message_append_n(message, object->namespace, namespace_len);
+		j_message_append_n(message, object->name, name_len);
+
+		cache = j_block_cache_get(semantics);
+	}
+	else
+	{
+		ret = j_backend_object_open(object_backend, object->namespace, object->name, &object_handle) && ret;
+	}
+
+	while (j_list_iterator_next(it))
+	{
+		JObjectOperation* operation = j_list_iterator_get(it);
+		guint32 advice = operation->advise.advice;
+		guint64 length = operation->advise.length;
+		guint64 offset = operation->advise.offset;
+
+		if (object_backend == NULL)
+		{
+			// With a block cache, the data is fetched into it instead of the server's cache
+			if (advice == J_ADVICE_WILL_NEED && cache != NULL)
+			{
+				JObjectPrefetch* prefetch;
+
+				prefetch = g_slice_new(JObjectPrefetch);
+				prefetch->object = j_object_ref(object);
+				prefetch->semantics = j_semantics_ref(semantics);
+				prefetch->length = length;
+				prefetch->offset = offset;
+
+				j_background_operation_unref(j_background_operation_new(j_object_prefetch_background, prefetch));
+
+				continue;
+			}
+
+			j_message_add_operation(message, sizeof(guint32) + sizeof(guint64) + sizeof(guint64));
+			j_message_append_4(message, &advice);
+			j_message_append_8(message, &length);
+			j_message_append_8(message, &offset);
+			count++;
+		}
+		else if (object_handle != NULL)
+		{
+			ret = j_backend_object_advise(object_backend, object_handle, advice, length, offset) && ret;
+		}
+	}
+
+	j_list_iterator_free(it);
+
+	if (object_backend == NULL && count > 0)
+	{
+		JSemanticsSafety safety;
+		gpointer object_connection;
+
+		safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
+		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, object->index);
+		j_message_send(message, object_connection);
+
+		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		{
+			g_autoptr(JMessage) reply = NULL;
+			guint32 reply_operation_count;
+
+			reply = j_message_new_reply(message);
+			j_message_receive(reply, object_connection);
+
+			reply_operation_count = j_message_get_count(reply);
+
+			for (guint i = 0; i < reply_operation_count; i++)
+			{
+				ret = (j_message_get_4(reply) != 0) && ret;
+			}
+		}
+
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, object->index, object_connection);
+	}
+	else if (object_handle != NULL)
+	{
+		ret = j_backend_object_close(object_backend, object_handle) && ret;
+	}
+
+	return ret;
+}
+
+/**
+ * Clones an object using a local backend.
+ *
+ * \private
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_object_clone_local(JBackend* object_backend, gpointer object_handle, JObject* clone)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gpointer clone_handle;
+	gboolean ret = FALSE;
+
+	// Remove the old data, so that the clone does not keep any of it
+	if (j_backend_object_open(object_backend, clone->namespace, clone->name, &clone_handle))
+	{
+		j_backend_object_delete(object_backend, clone_handle);
+	}
+
+	if (j_backend_object_create(object_backend, clone->namespace, clone->name, &clone_handle))
+	{
+		ret = j_backend_object_clone(object_backend, object_handle, clone_handle);
+		ret = j_backend_object_close(object_backend, clone_handle) && ret;
+	}
+
+	return ret;
+}
+
+/**
+ * Clones an object stored on another server by copying its data.
+ *
+ * \private
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_object_clone_copy(JObject* object, JObject* clone, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autofree gchar* buffer = NULL;
+	guint64 size = 0;
+	gboolean ret;
+
+	batch = j_batch_new(semantics);
+
+	j_object_status(object, NULL, &size, batch);
+
+	if (!j_batch_execute(batch))
+	{
+		return FALSE;
+	}
+
+	// The clone might not exist, which is not an error
+	j_object_delete(clone, batch);
+	j_batch_execute(batch);
+
+	j_object_create(clone, batch);
+	ret = j_batch_execute(batch);
+
+	buffer = g_malloc(J_OBJECT_CLONE_COPY_SIZE);
+
+	for (guint64 offset = 0; offset < size && ret; offset += J_OBJECT_CLONE_COPY_SIZE)
+	{
+		guint64 length = MIN(size - offset, J_OBJECT_CLONE_COPY_SIZE);
+		guint64 bytes_read = 0;
+		guint64 bytes_written = 0;
+
+		j_object_read(object, buffer, length, offset, &bytes_read, batch);
+		ret = j_batch_execute(batch) && bytes_read == length;
+
+		if (ret)
+		{
+			j_object_write(clone, buffer, length, offset, &bytes_written, batch);
+			ret = j_batch_execute(batch) && bytes_written == length;
+		}
+	}
+
+	return ret;
+}
+
+static gboolean
+j_object_clone_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* object_backend;
+	JBlockCache* cache;
+	g_autoptr(JListIterator) it = NULL;
+	g_autoptr(JMessage) message = NULL;
+	JObject* object;
+	gpointer object_handle = NULL;
+	guint32 cloned = 0;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JObjectOperation* operation = j_list_get_first(operations);
+
+		g_assert(operation != NULL);
+
+		object = operation->clone.object;
+	}
+
+	j_object_burst_buffer_flush(object);
+
+	it = j_list_iterator_new(operations);
+	object_backend = j_object_get_backend();
+
+	if (object_backend == NULL)
+	{
+		gsize name_len;
+		gsize namespace_len;
+
+		namespace_len = strlen(object->namespace) + 1;
+		name_len = strlen(object->name) + 1;
+
+		message = j_message_new(J_MESSAGE_OBJECT_CLONE, namespace_len + name_len);
+		j_message_set_semantics(message, semantics);
+		j_message_append_n(message, object->namespace, namespace_len);
+		j_message_append_n(message, object->name, name_len);
+	}
+	else
+	{
+		ret = j_backend_object_open(object_backend, object->namespace, object->name, &object_handle) && ret;
+	}
+
+	while (j_list_iterator_next(it))
+	{
+		JObjectOperation* operation = j_list_iterator_get(it);
+		JObject* clone = operation->clone.clone;
+
+		// Staged data of the clone would overwrite the cloned data later
+		j_object_burst_buffer_flush(clone);
+
+		if (object_backend == NULL)
+		{
+			gsize clone_name_len;
+			gsize clone_namespace_len;
+
+			// Data can only be shared if both objects are stored on the same server
+			if (clone->index != object->index)
+			{
+				ret = j_object_clone_copy(object, clone, semantics) && ret;
+				continue;
+			}
+
+			clone_namespace_len = strlen(clone->namespace) + 1;
+			clone_name_len = strlen(clone->name) + 1;
+			cloned++;
+
+			j_message_add_operation(message, clone_namespace_len + clone_name_len);
+			j_message_append_n(message, clone->namespace, clone_namespace_len);
+			j_message_append_n(message, clone->name, clone_name_len);
+		}
+		else if (object_handle != NULL)
+		{
+			ret = j_object_clone_local(object_backend, object_handle, clone) && ret;
+		}
+	}
+
+	if (object_backend == NULL && cloned > 0)
+	{
+		JSemanticsSafety safety;
+		gpointer object_connection;
+
+		safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
+		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, object->index);
+		j_message_send(message, object_connection);
+
+		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		{
+			g_autoptr(JMessage) reply = NULL;
+			guint32 reply_operation_count;
+
+			reply = j_message_new_reply(message);
+			j_message_receive(reply, object_connection);
+
+			reply_operation_count = j_message_get_count(reply);
+
+			for (guint i = 0; i < reply_operation_count; i++)
+			{
+				ret = (j_message_get_4(reply) == 1) && ret;
+			}
+		}
+
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, object->index, object_connection);
+	}
+	else if (object_handle != NULL)
+	{
+		ret = j_backend_object_close(object_backend, object_handle) && ret;
+	}
+
+	if ((cache = j_block_cache_get(NULL)) != NULL)
+	{
+		j_list_iterator_free(it);
+		it = j_list_iterator_new(operations);
+
+		while (j_list_iterator_next(it))
+		{
+			JObjectOperation* operation = j_list_iterator_get(it);
+			JObject* clone = operation->clone.clone;
+
+			j_block_cache_invalidate(cache, clone->index, clone->namespace, clone->name, G_MAXUINT64, 0);
+		}
+	}
+
+	return ret;
+}
+
+/**
+ * Reduces a range of an object using a local backend.
+ *
+ * \private
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_object_reduce_local(JBackend* object_backend, gpointer object_handle, JReduce* reduce, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* buffer = NULL;
+	guint64 buffer_size;
+
+	// The buffer has to consist of whole elements.
+	buffer_size = j_configuration_get_max_operation_size(j_configuration());
+	buffer_size = MIN(length, buffer_size - (buffer_size % sizeof(guint64)));
+	buffer = g_malloc(buffer_size);
+
+	while (length > 0)
+	{
+		guint64 bytes_read = 0;
+		guint64 chunk_length;
+
+		chunk_length = MIN(length, buffer_size);
+
+		if (!j_backend_object_read(object_backend, object_handle, buffer, chunk_length, offset, &bytes_read))
+		{
+			return FALSE;
+		}
+
+		j_reduce_process(reduce, buffer, bytes_read);
+
+		if (bytes_read < chunk_length)
+		{
+			break;
+		}
+
+		length -= chunk_length;
+		offset += chunk_length;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+j_object_reduce_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* object_backend;
+	JListIterator* it;
+	g_autoptr(JMessage) message = NULL;
+	JObject* object;
+	gpointer object_handle = NULL;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JObjectOperation* operation = j_list_get_first(operations);
+
+		g_assert(operation != NULL);
+
+		object = operation->reduce.object;
+	}
+
+	j_object_burst_buffer_flush(object);
+
+	it = j_list_iterator_new(operations);
+	object_backend = j_object_get_backend();
+
+	if (object_backend == NULL)
+	{
+		gsize name_len;
+		gsize namespace_len;
+
+		namespace_len = strlen(object->namespace) + 1;
+		name_len = strlen(object->name) + 1;
+
+		message = j_message_new(J_MESSAGE_OBJECT_REDUCE, namespace_len + name_len);
+		j_message_set_semantics(message, semantics);
+		j_message_append_n(message, object->namespace, namespace_len);
+		j_message_append_n(message, object->name, name_len);
+	}
+	else
+	{
+		ret = j_backend_object_open(object_backend, object->namespace, object->name, &object_handle) && ret;
+	}
+
+	while (j_list_iterator_next(it))
+	{
+		JObjectOperation* operation = j_list_iterator_get(it);
+		guint64 length = operation->reduce.length;
+		guint64 offset = operation->reduce.offset;
+
+		if (object_backend == NULL)
+		{
+			j_message_add_operation(message, j_reduce_get_spec_size() + sizeof(guint64) + sizeof(guint64));
+			j_reduce_append_spec(operation->reduce.reduce, message);
+			j_message_append_8(message, &length);
+			j_message_append_8(message, &offset);
+		}
+		else
+		{
+			gboolean success;
 
-			ret = j_backend_object_open(object_backend, object->namespace, object->name, &object_handle) && ret;
-			ret = j_backend_object_sync(object_backend, object_handle) && ret;
-			ret = j_backend_object_close(object_backend, object_handle) && ret;
+			success = (object_handle != NULL && j_object_reduce_local(object_backend, object_handle, operation->reduce.reduce, length, offset));
+			ret = success && ret;
+
+			if (operation->reduce.success != NULL)
+			{
+				*(operation->reduce.success) = success;
+			}
 		}
 	}
 
@@ -918,24 +2422,44 @@ j_object_sync_exec(JList* operations, JSemantics* semantics)
 
 	if (object_backend == NULL)
 	{
-		JSemanticsSafety safety;
+		g_autoptr(JMessage) reply = NULL;
 		gpointer object_connection;
 
-		safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
-		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, index);
+		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, object->index);
 		j_message_send(message, object_connection);
 
-		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		reply = j_message_new_reply(message);
+		j_message_receive(reply, object_connection);
+
+		it = j_list_iterator_new(operations);
+
+		while (j_list_iterator_next(it))
 		{
-			g_autoptr(JMessage) reply = NULL;
+			JObjectOperation* operation = j_list_iterator_get(it);
+			gboolean success;
 
-			reply = j_message_new_reply(message);
-			j_message_receive(reply, object_connection);
+			success = (j_message_get_4(reply) != 0);
 
-			// FIXME do something with reply
+			if (success)
+			{
+				j_reduce_merge_from_message(operation->reduce.reduce, reply);
+			}
+
+			ret = success && ret;
+
+			if (operation->reduce.success != NULL)
+			{
+				*(operation->reduce.success) = success;
+			}
 		}
 
-		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, index, object_connection);
+		j_list_iterator_free(it);
+
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, object->index, object_connection);
+	}
+	else if (object_handle != NULL)
+	{
+		ret = j_backend_object_close(object_backend, object_handle) && ret;
 	}
 
 	return ret;
@@ -967,7 +2491,7 @@ j_object_new(gchar const* namespace, gchar const* name)
 	g_return_val_if_fail(name != NULL, NULL);
 
 	object = g_slice_new(JObject);
-	object->index = j_helper_hash(name) % j_configuration_get_server_count(configuration, J_BACKEND_TYPE_OBJECT);
+	object->index = j_configuration_get_server_for_key(configuration, J_BACKEND_TYPE_OBJECT, name);
 	object->namespace = g_strdup(namespace);
 	object->name = g_strdup(name);
 	object->ref_count = 1;
@@ -1078,16 +2602,41 @@ j_object_create(JObject* object, JBatch* batch)
 {
 	J_TRACE_FUNCTION(NULL);
 
+	j_object_create_with_size(object, 0, batch);
+}
+
+/**
+ * Creates an object and reserves space for it.
+ * The size is only a hint and does not change the object's size.
+ *
+ * \code
+ * \endcode
+ *
+ * \param object An object.
+ * \param size   The expected size in bytes, 0 for none.
+ * \param batch  A batch.
+ **/
+void
+j_object_create_with_size(JObject* object, guint64 size, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* iop;
 	JOperation* operation;
 
 	g_return_if_fail(object != NULL);
 
+	iop = g_slice_new(JObjectOperation);
+	iop->create.object = j_object_ref(object);
+	iop->create.size = size;
+
 	operation = j_operation_new();
 	// FIXME key = index + namespace
 	operation->key = object;
-	operation->data = j_object_ref(object);
+	operation->data = iop;
 	operation->exec_func = j_object_create_exec;
 	operation->free_func = j_object_create_free;
+	operation->cache_func = j_object_metadata_cache;
 
 	j_batch_add(batch, operation);
 }
@@ -1115,6 +2664,45 @@ j_object_delete(JObject* object, JBatch* batch)
 	operation->data = j_object_ref(object);
 	operation->exec_func = j_object_delete_exec;
 	operation->free_func = j_object_delete_free;
+	operation->cache_func = j_object_metadata_cache;
+
+	j_batch_add(batch, operation);
+}
+
+/**
+ * Deletes all objects of a namespace whose names start with a prefix.
+ * Each server deletes its objects on its own, so that the objects do not have to be listed first.
+ *
+ * \code
+ * \endcode
+ *
+ * \param namespace A namespace.
+ * \param prefix    A prefix.
+ * \param deleted   Returns the number of deleted objects, can be NULL.
+ * \param batch     A batch.
+ **/
+void
+j_object_delete_prefix(gchar const* namespace, gchar const* prefix, guint64* deleted, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* iop;
+	JOperation* operation;
+
+	g_return_if_fail(namespace != NULL);
+	g_return_if_fail(prefix != NULL);
+
+	iop = g_slice_new(JObjectOperation);
+	iop->delete_prefix.namespace = g_strdup(namespace);
+	iop->delete_prefix.prefix = g_strdup(prefix);
+	iop->delete_prefix.deleted = deleted;
+
+	operation = j_operation_new();
+	// The operation affects many objects and therefore acts as a barrier.
+	operation->key = NULL;
+	operation->data = iop;
+	operation->exec_func = j_object_delete_prefix_exec;
+	operation->free_func = j_object_delete_prefix_free;
 
 	j_batch_add(batch, operation);
 }
@@ -1223,12 +2811,14 @@ j_object_write(JObject* object, gconstpointer data, guint64 length, guint64 offs
 		iop->write.length = chunk_size;
 		iop->write.offset = offset;
 		iop->write.bytes_written = bytes_written;
+		iop->write.buffer = NULL;
 
 		operation = j_operation_new();
 		operation->key = object;
 		operation->data = iop;
 		operation->exec_func = j_object_write_exec;
 		operation->free_func = j_object_write_free;
+		operation->cache_func = j_object_write_cache;
 
 		j_batch_add(batch, operation);
 
@@ -1240,6 +2830,106 @@ j_object_write(JObject* object, gconstpointer data, guint64 length, guint64 offs
 	*bytes_written = 0;
 }
 
+/**
+ * Appends data to the end of an object.
+ * The offset is determined by the server, so that many clients can append to the same object without coordination.
+ * Concurrent appends never overlap, but the data is not split into several messages and should therefore not exceed the maximum operation size.
+ *
+ * \code
+ * guint64 offset;
+ * guint64 bytes_written;
+ *
+ * j_object_append(object, record, record_len, &offset, &bytes_written, batch);
+ * j_batch_execute(batch);
+ * \endcode
+ *
+ * \param object        An object.
+ * \param data          A buffer holding the data to append.
+ * \param length        Number of bytes to append.
+ * \param offset        Returns the offset the data has been appended at.
+ * \param bytes_written Number of bytes written.
+ * \param batch         A batch.
+ **/
+void
+j_object_append(JObject* object, gconstpointer data, guint64 length, guint64* offset, guint64* bytes_written, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* iop;
+	JOperation* operation;
+
+	g_return_if_fail(object != NULL);
+	g_return_if_fail(data != NULL);
+	g_return_if_fail(length > 0);
+	g_return_if_fail(offset != NULL);
+	g_return_if_fail(bytes_written != NULL);
+
+	iop = g_slice_new(JObjectOperation);
+	iop->append.object = j_object_ref(object);
+	iop->append.data = data;
+	iop->append.length = length;
+	iop->append.counter = J_MESSAGE_APPEND_END;
+	iop->append.offset = offset;
+	iop->append.bytes_written = bytes_written;
+
+	operation = j_operation_new();
+	operation->key = object;
+	operation->data = iop;
+	operation->exec_func = j_object_append_exec;
+	operation->free_func = j_object_append_free;
+
+	j_batch_add(batch, operation);
+
+	*offset = 0;
+	*bytes_written = 0;
+}
+
+/**
+ * Atomically advances a counter stored within an object.
+ * This allows reserving space in other objects, whose size does not tell where to append.
+ *
+ * \private
+ *
+ * \param object   An object.
+ * \param counter  The offset of the 8-byte counter within #object.
+ * \param length   The number of bytes to reserve.
+ * \param offset   Returns the counter's previous value, that is, the offset of the reserved space.
+ * \param reserved Number of bytes reserved.
+ * \param batch    A batch.
+ **/
+void
+j_object_reserve(JObject* object, guint64 counter, guint64 length, guint64* offset, guint64* reserved, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* iop;
+	JOperation* operation;
+
+	g_return_if_fail(object != NULL);
+	g_return_if_fail(counter != J_MESSAGE_APPEND_END);
+	g_return_if_fail(offset != NULL);
+	g_return_if_fail(reserved != NULL);
+
+	iop = g_slice_new(JObjectOperation);
+	iop->append.object = j_object_ref(object);
+	iop->append.data = NULL;
+	iop->append.length = length;
+	iop->append.counter = counter;
+	iop->append.offset = offset;
+	iop->append.bytes_written = reserved;
+
+	operation = j_operation_new();
+	operation->key = object;
+	operation->data = iop;
+	operation->exec_func = j_object_append_exec;
+	operation->free_func = j_object_append_free;
+
+	j_batch_add(batch, operation);
+
+	*offset = 0;
+	*reserved = 0;
+}
+
 /**
  * Get the status of an object.
  *
@@ -1304,6 +2994,198 @@ j_object_sync(JObject* object, JBatch* batch)
 	j_batch_add(batch, operation);
 }
 
+/**
+ * Discards a range of an object.
+ * The range's storage is deallocated if the backend supports it and reads as zeros afterwards.
+ * The object's size does not change.
+ *
+ * \code
+ * \endcode
+ *
+ * \param object An object.
+ * \param length Number of bytes to discard.
+ * \param offset An offset within the object.
+ * \param batch  A batch.
+ **/
+void
+j_object_discard(JObject* object, guint64 length, guint64 offset, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* iop;
+	JOperation* operation;
+
+	g_return_if_fail(object != NULL);
+	g_return_if_fail(length > 0);
+
+	iop = g_slice_new(JObjectOperation);
+	iop->discard.object = j_object_ref(object);
+	iop->discard.length = length;
+	iop->discard.offset = offset;
+
+	operation = j_operation_new();
+	operation->key = object;
+	operation->data = iop;
+	operation->exec_func = j_object_discard_exec;
+	operation->free_func = j_object_discard_free;
+
+	j_batch_add(batch, operation);
+}
+
+/**
+ * Tells the server how a range of an object is going to be accessed.
+ * Advice is only a hint and does not change the object's data.
+ * The posix backend passes it on to the kernel, for example, to read ahead sequentially or to start reading ranges that will be needed soon.
+ * If the client's block cache is enabled, ranges that will be needed are fetched into it in the background instead.
+ *
+ * \code
+ * j_object_advise(object, J_ADVICE_SEQUENTIAL, 0, 0, batch);
+ * \endcode
+ *
+ * \param object An object.
+ * \param advice The expected access pattern.
+ * \param length The length of the range, 0 for the rest of the object.
+ * \param offset An offset within the object.
+ * \param batch  A batch.
+ **/
+void
+j_object_advise(JObject* object, JAdvice advice, guint64 length, guint64 offset, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* iop;
+	JOperation* operation;
+
+	g_return_if_fail(object != NULL);
+
+	iop = g_slice_new(JObjectOperation);
+	iop->advise.object = j_object_ref(object);
+	iop->advise.advice = advice;
+	iop->advise.length = length;
+	iop->advise.offset = offset;
+
+	operation = j_operation_new();
+	operation->key = object;
+	operation->data = iop;
+	operation->exec_func = j_object_advise_exec;
+	operation->free_func = j_object_advise_free;
+
+	j_batch_add(batch, operation);
+}
+
+/**
+ * Starts reading a range of an object that is going to be read soon, so that the actual read does not have to wait for storage.
+ * This is a shortcut for j_object_advise() with #J_ADVICE_WILL_NEED.
+ *
+ * \code
+ * j_object_prefetch(object, 4 * 1024 * 1024, 0, batch);
+ * j_batch_execute(batch);
+ * \endcode
+ *
+ * \param object An object.
+ * \param length The length of the range, 0 for the rest of the object.
+ * \param offset An offset within the object.
+ * \param batch  A batch.
+ **/
+void
+j_object_prefetch(JObject* object, guint64 length, guint64 offset, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	j_object_advise(object, J_ADVICE_WILL_NEED, length, offset, batch);
+}
+
+/**
+ * Clones an object, replacing the clone's data with a point-in-time copy of the object's data.
+ * Both objects can be modified independently afterwards.
+ * If both objects are stored on the same server, the backend shares their data until either is modified where possible, so that cloning only costs metadata.
+ * Otherwise, the data is copied.
+ *
+ * \code
+ * g_autoptr(JObject) snapshot = NULL;
+ *
+ * snapshot = j_object_new_for_index(index, "snapshots", "checkpoint-1");
+ * j_object_clone(object, snapshot, batch);
+ * j_batch_execute(batch);
+ * \endcode
+ *
+ * \param object An object.
+ * \param clone  The clone, which is created if it does not exist.
+ * \param batch  A batch.
+ **/
+void
+j_object_clone(JObject* object, JObject* clone, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* iop;
+	JOperation* operation;
+
+	g_return_if_fail(object != NULL);
+	g_return_if_fail(clone != NULL);
+
+	iop = g_slice_new(JObjectOperation);
+	iop->clone.object = j_object_ref(object);
+	iop->clone.clone = j_object_ref(clone);
+
+	operation = j_operation_new();
+	operation->key = object;
+	operation->data = iop;
+	operation->exec_func = j_object_clone_exec;
+	operation->free_func = j_object_clone_free;
+
+	j_batch_add(batch, operation);
+}
+
+/**
+ * Reduces a range of an object where it is stored, only transferring the results.
+ * The object is interpreted as an array of the reduction's element type.
+ * The results are merged into the reduction, so it can be used for several ranges or objects.
+ *
+ * \code
+ * g_autoptr(JReduce) reduce = NULL;
+ *
+ * reduce = j_reduce_new(J_REDUCE_TYPE_FLOAT64);
+ * j_object_reduce(object, reduce, size, 0, NULL, batch);
+ * j_batch_execute(batch);
+ *
+ * g_print("%f\n", j_reduce_get_sum(reduce) / j_reduce_get_count(reduce));
+ * \endcode
+ *
+ * \param object  An object.
+ * \param reduce  A reduction.
+ * \param length  Number of bytes to reduce.
+ * \param offset  An offset within the object, should be a multiple of the element size.
+ * \param success Returns whether the range could be reduced, can be NULL.
+ * \param batch   A batch.
+ **/
+void
+j_object_reduce(JObject* object, JReduce* reduce, guint64 length, guint64 offset, gboolean* success, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* iop;
+	JOperation* operation;
+
+	g_return_if_fail(object != NULL);
+	g_return_if_fail(reduce != NULL);
+
+	iop = g_slice_new(JObjectOperation);
+	iop->reduce.object = j_object_ref(object);
+	iop->reduce.reduce = j_reduce_ref(reduce);
+	iop->reduce.length = length;
+	iop->reduce.offset = offset;
+	iop->reduce.success = success;
+
+	operation = j_operation_new();
+	operation->key = object;
+	operation->data = iop;
+	operation->exec_func = j_object_reduce_exec;
+	operation->free_func = j_object_reduce_free;
+
+	j_batch_add(batch, operation);
+}
+
 /**
  * Returns the object backend.
  *
@@ -1312,6 +3194,10 @@ j_object_sync(JObject* object, JBatch* batch)
 JBackend*
 j_object_get_backend(void)
 {
+	static GOnce once = G_ONCE_INIT;
+
+	g_once(&once, j_object_init, NULL);
+
 	return j_object_backend;
 }
 
@@ -0,0 +1,388 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+
+#define J_REED_SOLOMON_SSSE3
+#endif
+
+#include <object/jreed-solomon-internal.h>
+
+#include <julea.h>
+
+/**
+ * \defgroup JReedSolomon Reed-Solomon Codes
+ *
+ * Systematic Reed-Solomon codes over GF(2^8) for erasure-coded distributed objects.
+ *
+ * The parity blocks are computed using a Cauchy matrix,
+ * so any data_count of the data_count + parity_count blocks are sufficient to reconstruct the data.
+ *
+ * @{
+ **/
+
+/**
+ * The field's generator polynomial x^8 + x^4 + x^3 + x^2 + 1.
+ **/
+#define J_REED_SOLOMON_POLYNOMIAL 0x11d
+
+static struct
+{
+	guint8 exp[512];
+	guint8 log[256];
+
+	/**
+	 * Whether the CPU supports SSSE3.
+	 **/
+	gboolean ssse3;
+} j_reed_solomon_tables;
+
+static void
+j_reed_solomon_init(void)
+{
+	static gsize initialized = 0;
+
+	if (g_once_init_enter(&initialized))
+	{
+		guint x = 1;
+
+		for (guint i = 0; i < 255; i++)
+		{
+			j_reed_solomon_tables.exp[i] = x;
+			j_reed_solomon_tables.log[x] = i;
+
+			x <<= 1;
+
+			if (x & 0x100)
+			{
+				x ^= J_REED_SOLOMON_POLYNOMIAL;
+			}
+		}
+
+		// Avoid the modulo when multiplying
+		for (guint i = 255; i < G_N_ELEMENTS(j_reed_solomon_tables.exp); i++)
+		{
+			j_reed_solomon_tables.exp[i] = j_reed_solomon_tables.exp[i - 255];
+		}
+
+#ifdef J_REED_SOLOMON_SSSE3
+		j_reed_solomon_tables.ssse3 = __builtin_cpu_supports("ssse3");
+#else
+		j_reed_solomon_tables.ssse3 = FALSE;
+#endif
+
+		g_once_init_leave(&initialized, 1);
+	}
+}
+
+static guint8
+j_reed_solomon_mul(guint8 a, guint8 b)
+{
+	if (a == 0 || b == 0)
+	{
+		return 0;
+	}
+
+	return j_reed_solomon_tables.exp[j_reed_solomon_tables.log[a] + j_reed_solomon_tables.log[b]];
+}
+
+static guint8
+j_reed_solomon_inv(guint8 a)
+{
+	g_return_val_if_fail(a != 0, 0);
+
+	return j_reed_solomon_tables.exp[255 - j_reed_solomon_tables.log[a]];
+}
+
+/**
+ * Returns the coefficient of a data block for a parity block.
+ * The Cauchy matrix uses x = data_count + parity and y = data.
+ **/
+static guint8
+j_reed_solomon_coefficient(guint data_count, guint parity, guint data)
+{
+	return j_reed_solomon_inv((data_count + parity) ^ data);
+}
+
+#ifdef J_REED_SOLOMON_SSSE3
+/**
+ * Processes 16 bytes at a time by looking up the products of the low and high nibbles with a byte shuffle.
+ *
+ * \return The number of bytes processed.
+ **/
+__attribute__((target("ssse3"))) static gsize
+j_reed_solomon_mul_add_ssse3(guint8* dst, guint8 const* src, guint8 const* low, guint8 const* high, gsize length)
+{
+	__m128i const mask = _mm_set1_epi8(0x0f);
+	__m128i const table_low = _mm_loadu_si128((__m128i const*)(gconstpointer)low);
+	__m128i const table_high = _mm_loadu_si128((__m128i const*)(gconstpointer)high);
+	gsize i;
+
+	for (i = 0; i + 16 <= length; i += 16)
+	{
+		__m128i s;
+		__m128i d;
+		__m128i product;
+
+		s = _mm_loadu_si128((__m128i const*)(gconstpointer)(src + i));
+		d = _mm_loadu_si128((__m128i const*)(gpointer)(dst + i));
+
+		product = _mm_xor_si128(_mm_shuffle_epi8(table_low, _mm_and_si128(s, mask)), _mm_shuffle_epi8(table_high, _mm_and_si128(_mm_srli_epi64(s, 4), mask)));
+		_mm_storeu_si128((__m128i*)(gpointer)(dst + i), _mm_xor_si128(d, product));
+	}
+
+	return i;
+}
+#endif
+
+/**
+ * Computes dst += c * src.
+ **/
+static void
+j_reed_solomon_mul_add(guint8* dst, guint8 const* src, guint8 c, gsize length)
+{
+	guint8 low[16];
+	guint8 high[16];
+	gsize i = 0;
+
+	if (c == 0)
+	{
+		return;
+	}
+
+	if (c == 1)
+	{
+		for (; i < length; i++)
+		{
+			dst[i] ^= src[i];
+		}
+
+		return;
+	}
+
+	for (guint j = 0; j < 16; j++)
+	{
+		low[j] = j_reed_solomon_mul(c, j);
+		high[j] = j_reed_solomon_mul(c, j << 4);
+	}
+
+#ifdef J_REED_SOLOMON_SSSE3
+	if (j_reed_solomon_tables.ssse3)
+	{
+		i = j_reed_solomon_mul_add_ssse3(dst, src, low, high, length);
+	}
+#endif
+
+	for (; i < length; i++)
+	{
+		dst[i] ^= low[src[i] & 0x0f] ^ high[src[i] >> 4];
+	}
+}
+
+/**
+ * Computes the parity blocks of a stripe.
+ *
+ * \private
+ *
+ * \param data_count   The number of data blocks.
+ * \param parity_count The number of parity blocks.
+ * \param data         The data blocks.
+ * \param parity       Returns the parity blocks.
+ * \param length       The length of each block.
+ **/
+void
+j_reed_solomon_encode(guint data_count, guint parity_count, guint8* const* data, guint8* const* parity, gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(data_count + parity_count <= 256);
+
+	j_reed_solomon_init();
+
+	for (guint p = 0; p < parity_count; p++)
+	{
+		memset(parity[p], 0, length);
+
+		for (guint d = 0; d < data_count; d++)
+		{
+			j_reed_solomon_mul_add(parity[p], data[d], j_reed_solomon_coefficient(data_count, p, d), length);
+		}
+	}
+}
+
+/**
+ * Reconstructs missing data blocks of a stripe.
+ * Missing parity blocks are not reconstructed.
+ *
+ * \private
+ *
+ * \param data_count   The number of data blocks.
+ * \param parity_count The number of parity blocks.
+ * \param blocks       The data blocks followed by the parity blocks.
+ * \param present      Whether each block is available.
+ * \param length       The length of each block.
+ *
+ * \return TRUE if all data blocks are available, FALSE if too many blocks are missing.
+ **/
+gboolean
+j_reed_solomon_reconstruct(guint data_count, guint parity_count, guint8* const* blocks, gboolean const* present, gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree guint8* matrix = NULL;
+	g_autofree guint8* inverse = NULL;
+	g_autofree guint* rows = NULL;
+	guint count = 0;
+	gboolean missing = FALSE;
+
+	g_return_val_if_fail(data_count + parity_count <= 256, FALSE);
+
+	j_reed_solomon_init();
+
+	for (guint d = 0; d < data_count; d++)
+	{
+		missing = missing || !present[d];
+	}
+
+	if (!missing)
+	{
+		return TRUE;
+	}
+
+	rows = g_new(guint, data_count);
+
+	for (guint i = 0; i < data_count + parity_count && count < data_count; i++)
+	{
+		if (present[i])
+		{
+			rows[count] = i;
+			count++;
+		}
+	}
+
+	if (count < data_count)
+	{
+		return FALSE;
+	}
+
+	// The rows of the generator matrix belonging to the available blocks
+	matrix = g_new0(guint8, data_count * data_count);
+	inverse = g_new0(guint8, data_count * data_count);
+
+	for (guint r = 0; r < data_count; r++)
+	{
+		for (guint c = 0; c < data_count; c++)
+		{
+			if (rows[r] < data_count)
+			{
+				matrix[r * data_count + c] = (rows[r] == c) ? 1 : 0;
+			}
+			else
+			{
+				matrix[r * data_count + c] = j_reed_solomon_coefficient(data_count, rows[r] - data_count, c);
+			}
+		}
+
+		inverse[r * data_count + r] = 1;
+	}
+
+	// Gauss-Jordan elimination, the matrix is always invertible
+	for (guint c = 0; c < data_count; c++)
+	{
+		guint pivot = c;
+		guint8 factor;
+
+		while (matrix[pivot * data_count + c] == 0)
+		{
+			pivot++;
+			g_assert(pivot < data_count);
+		}
+
+		if (pivot != c)
+		{
+			for (guint i = 0; i < data_count; i++)
+			{
+				guint8 tmp;
+
+				tmp = matrix[c * data_count + i];
+				matrix[c * data_count + i] = matrix[pivot * data_count + i];
+				matrix[pivot * data_count + i] = tmp;
+
+				tmp = inverse[c * data_count + i];
+				inverse[c * data_count + i] = inverse[pivot * data_count + i];
+				inverse[pivot * data_count + i] = tmp;
+			}
+		}
+
+		factor = j_reed_solomon_inv(matrix[c * data_count + c]);
+
+		for (guint i = 0; i < data_count; i++)
+		{
+			matrix[c * data_count + i] = j_reed_solomon_mul(matrix[c * data_count + i], factor);
+			inverse[c * data_count + i] = j_reed_solomon_mul(inverse[c * data_count + i], factor);
+		}
+
+		for (guint r = 0; r < data_count; r++)
+		{
+			guint8 f;
+
+			if (r == c || (f = matrix[r * data_count + c]) == 0)
+			{
+				continue;
+			}
+
+			for (guint i = 0; i < data_count; i++)
+			{
+				matrix[r * data_count + i] ^= j_reed_solomon_mul(f, matrix[c * data_count + i]);
+				inverse[r * data_count + i] ^= j_reed_solomon_mul(f, inverse[c * data_count + i]);
+			}
+		}
+	}
+
+	for (guint d = 0; d < data_count; d++)
+	{
+		if (present[d])
+		{
+			continue;
+		}
+
+		memset(blocks[d], 0, length);
+
+		for (guint i = 0; i < data_count; i++)
+		{
+			j_reed_solomon_mul_add(blocks[d], blocks[rows[i]], inverse[d * data_count + i], length);
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * @}
+ **/
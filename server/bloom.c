@@ -0,0 +1,383 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <julea.h>
+
+#include "server.h"
+
+/**
+ * The number of hash functions used by the filters.
+ * Together with roughly ten bits per key, this results in a false positive rate of about one percent.
+ **/
+#define JD_KV_BLOOM_HASHES 7
+
+/**
+ * The number of seconds after which a filter is rebuilt from the backend.
+ * Deleted keys are only removed from a filter when it is rebuilt.
+ **/
+#define JD_KV_BLOOM_REBUILD 60
+
+struct JdKVBloom
+{
+	gchar* namespace;
+
+	/**
+	 * The keys that are being put.
+	 **/
+	GPtrArray* keys;
+};
+
+/**
+ * A namespace's filter.
+ **/
+struct JdKVBloomEntry
+{
+	GMutex mutex[1];
+
+	/**
+	 * The filter, NULL until it has been requested for the first time.
+	 **/
+	JBloomFilter* filter;
+
+	/**
+	 * Changes whenever the filter is rebuilt, forcing clients to fetch it completely.
+	 **/
+	guint64 epoch;
+
+	gint64 built;
+};
+
+typedef struct JdKVBloomEntry JdKVBloomEntry;
+
+static struct
+{
+	GMutex mutex[1];
+
+	/**
+	 * Maps namespaces to their JdKVBloomEntry.
+	 * Filters are only maintained for namespaces that clients have asked for.
+	 **/
+	GHashTable* entries;
+
+	guint64 bits;
+	guint64 epoch;
+
+	gint enabled;
+} jd_kv_bloom;
+
+static void
+jd_kv_bloom_entry_free(JdKVBloomEntry* entry)
+{
+	if (entry->filter != NULL)
+	{
+		j_bloom_filter_free(entry->filter);
+	}
+
+	g_mutex_clear(entry->mutex);
+
+	g_slice_free(JdKVBloomEntry, entry);
+}
+
+/**
+ * Rebuilds a namespace's filter from the backend.
+ * The entry's lock has to be held, so no keys that are put concurrently are lost.
+ *
+ * \private
+ *
+ * \param entry     An entry.
+ * \param namespace The entry's namespace.
+ **/
+static void
+jd_kv_bloom_rebuild(JdKVBloomEntry* entry, gchar const* namespace)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gpointer iterator = NULL;
+	gchar const* key;
+	gconstpointer value;
+	guint32 len;
+
+	if (entry->filter == NULL)
+	{
+		entry->filter = j_bloom_filter_new(jd_kv_bloom.bits, JD_KV_BLOOM_HASHES);
+	}
+	else
+	{
+		j_bloom_filter_clear(entry->filter);
+	}
+
+	g_mutex_lock(jd_kv_bloom.mutex);
+	entry->epoch = ++jd_kv_bloom.epoch;
+	g_mutex_unlock(jd_kv_bloom.mutex);
+
+	entry->built = g_get_monotonic_time();
+
+	if (j_backend_kv_get_all(jd_kv_backend, namespace, &iterator))
+	{
+		while (j_backend_kv_iterate(jd_kv_backend, iterator, &key, &value, &len))
+		{
+			j_bloom_filter_add(entry->filter, key);
+		}
+	}
+}
+
+/**
+ * Starts maintaining Bloom filters for key-value namespaces.
+ *
+ * \private
+ *
+ * \param bits The number of bits per filter.
+ **/
+void
+jd_kv_bloom_start(guint64 bits)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(jd_kv_backend != NULL);
+	g_return_if_fail(bits > 0);
+	g_return_if_fail(jd_kv_bloom.entries == NULL);
+
+	jd_kv_bloom.entries = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)jd_kv_bloom_entry_free);
+	jd_kv_bloom.bits = bits;
+	// Epochs have to differ across restarts, otherwise clients would keep their outdated filters.
+	jd_kv_bloom.epoch = g_get_real_time();
+
+	g_atomic_int_set(&(jd_kv_bloom.enabled), 1);
+}
+
+/**
+ * Stops maintaining Bloom filters.
+ *
+ * \private
+ **/
+void
+jd_kv_bloom_stop(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (jd_kv_bloom.entries == NULL)
+	{
+		return;
+	}
+
+	g_atomic_int_set(&(jd_kv_bloom.enabled), 0);
+
+	g_hash_table_unref(jd_kv_bloom.entries);
+	jd_kv_bloom.entries = NULL;
+}
+
+/**
+ * Starts collecting the keys that are put into a namespace.
+ *
+ * \private
+ *
+ * \param namespace A namespace.
+ *
+ * \return A new collector, NULL if Bloom filters are disabled.
+ **/
+JdKVBloom*
+jd_kv_bloom_begin(gchar const* namespace)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdKVBloom* bloom;
+
+	if (!g_atomic_int_get(&(jd_kv_bloom.enabled)))
+	{
+		return NULL;
+	}
+
+	bloom = g_slice_new(JdKVBloom);
+	bloom->namespace = g_strdup(namespace);
+	bloom->keys = g_ptr_array_new_with_free_func(g_free);
+
+	return bloom;
+}
+
+/**
+ * Collects a key that is put.
+ *
+ * \private
+ *
+ * \param bloom A collector, might be NULL.
+ * \param key   A key.
+ **/
+void
+jd_kv_bloom_add(JdKVBloom* bloom, gchar const* key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (bloom == NULL)
+	{
+		return;
+	}
+
+	g_ptr_array_add(bloom->keys, g_strdup(key));
+}
+
+/**
+ * Adds the collected keys to their namespace's filter and frees the collector.
+ * Has to be called after the keys have been put, so that a rebuild cannot miss them.
+ * Keys are added even if putting them failed, which only results in false positives.
+ *
+ * \private
+ *
+ * \param bloom A collector, might be NULL.
+ **/
+void
+jd_kv_bloom_end(JdKVBloom* bloom)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdKVBloomEntry* entry;
+
+	if (bloom == NULL)
+	{
+		return;
+	}
+
+	g_mutex_lock(jd_kv_bloom.mutex);
+	entry = g_hash_table_lookup(jd_kv_bloom.entries, bloom->namespace);
+	g_mutex_unlock(jd_kv_bloom.mutex);
+
+	// Entries are never removed while the server is running.
+	if (entry != NULL)
+	{
+		g_mutex_lock(entry->mutex);
+
+		if (entry->filter != NULL)
+		{
+			for (guint i = 0; i < bloom->keys->len; i++)
+			{
+				j_bloom_filter_add(entry->filter, g_ptr_array_index(bloom->keys, i));
+			}
+		}
+
+		g_mutex_unlock(entry->mutex);
+	}
+
+	g_ptr_array_unref(bloom->keys);
+	g_free(bloom->namespace);
+
+	g_slice_free(JdKVBloom, bloom);
+}
+
+/**
+ * Appends a namespace's filter to a reply.
+ * Only the blocks that changed since the client's version are included.
+ *
+ * \private
+ *
+ * \param namespace A namespace.
+ * \param epoch     The epoch of the client's filter.
+ * \param version   The version of the client's filter.
+ * \param reply     A reply.
+ **/
+void
+jd_kv_bloom_fetch(gchar const* namespace, guint64 epoch, guint64 version, JMessage* reply)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdKVBloomEntry* entry;
+	guint64 bits = 0;
+	guint64 current_version = 0;
+	guint64 blocks;
+	guint32 hashes = 0;
+	guint32 count = 0;
+
+	if (!g_atomic_int_get(&(jd_kv_bloom.enabled)))
+	{
+		// A filter without any bits tells the client that filters are disabled.
+		j_message_add_operation(reply, 8 + 8 + 8 + 4 + 4);
+		j_message_append_8(reply, &epoch);
+		j_message_append_8(reply, &current_version);
+		j_message_append_8(reply, &bits);
+		j_message_append_4(reply, &hashes);
+		j_message_append_4(reply, &count);
+		return;
+	}
+
+	g_mutex_lock(jd_kv_bloom.mutex);
+
+	if ((entry = g_hash_table_lookup(jd_kv_bloom.entries, namespace)) == NULL)
+	{
+		entry = g_slice_new0(JdKVBloomEntry);
+		g_mutex_init(entry->mutex);
+		g_hash_table_insert(jd_kv_bloom.entries, g_strdup(namespace), entry);
+	}
+
+	g_mutex_unlock(jd_kv_bloom.mutex);
+
+	g_mutex_lock(entry->mutex);
+
+	// The entry has been registered before building, so all keys put from now on are added to the filter.
+	if (entry->filter == NULL || g_get_monotonic_time() - entry->built > JD_KV_BLOOM_REBUILD * G_TIME_SPAN_SECOND)
+	{
+		jd_kv_bloom_rebuild(entry, namespace);
+	}
+
+	if (epoch != entry->epoch)
+	{
+		version = 0;
+	}
+
+	bits = j_bloom_filter_get_bits(entry->filter);
+	hashes = j_bloom_filter_get_hashes(entry->filter);
+	blocks = j_bloom_filter_get_blocks(entry->filter);
+	current_version = j_bloom_filter_get_version(entry->filter);
+
+	for (guint64 i = 0; i < blocks; i++)
+	{
+		if (version == 0 || j_bloom_filter_get_block_version(entry->filter, i) > version)
+		{
+			count++;
+		}
+	}
+
+	j_message_add_operation(reply, 8 + 8 + 8 + 4 + 4 + count * (8 + J_BLOOM_FILTER_BLOCK_WORDS * sizeof(guint64)));
+	j_message_append_8(reply, &(entry->epoch));
+	j_message_append_8(reply, &current_version);
+	j_message_append_8(reply, &bits);
+	j_message_append_4(reply, &hashes);
+	j_message_append_4(reply, &count);
+
+	for (guint64 i = 0; i < blocks; i++)
+	{
+		if (version == 0 || j_bloom_filter_get_block_version(entry->filter, i) > version)
+		{
+			guint64 const* block;
+			guint64 words[J_BLOOM_FILTER_BLOCK_WORDS];
+
+			block = j_bloom_filter_get_block(entry->filter, i);
+
+			for (guint j = 0; j < J_BLOOM_FILTER_BLOCK_WORDS; j++)
+			{
+				words[j] = GUINT64_TO_LE(block[j]);
+			}
+
+			j_message_append_8(reply, &i);
+			j_message_append_n(reply, words, sizeof(words));
+		}
+	}
+
+	g_mutex_unlock(entry->mutex);
+}
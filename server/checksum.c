@@ -0,0 +1,335 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <julea.h>
+
+#include "server.h"
+
+
+/**
+ * The amount of object data covered by one stored checksum.
+ **/
+#define JD_OBJECT_CHECKSUM_CHUNK (64 * 1024)
+
+/**
+ * The number of locks objects with checksums are distributed over.
+ **/
+#define JD_OBJECT_CHECKSUM_LOCKS 64
+
+/**
+ * The suffix of the namespaces the checksums are stored in.
+ **/
+#define JD_OBJECT_CHECKSUM_SUFFIX ".crc32c"
+
+/**
+ * A stored checksum.
+ * Both values are stored in little endian byte order.
+ **/
+struct JdObjectChecksum
+{
+	guint32 crc;
+
+	/**
+	 * The number of bytes covered, 0 if the chunk does not have a checksum.
+	 **/
+	guint32 length;
+};
+
+typedef struct JdObjectChecksum JdObjectChecksum;
+
+static GRWLock jd_object_checksum_lock[JD_OBJECT_CHECKSUM_LOCKS];
+
+/**
+ * Computes the checksum of a chunk as it is currently stored.
+ *
+ * \private
+ **/
+static void
+jd_object_checksums_read_chunk(gpointer object, gchar* buffer, guint64 length, guint64 offset, JdObjectChecksum* checksum)
+{
+	guint64 bytes_read = 0;
+
+	if (!j_backend_object_read(jd_object_backend, object, buffer, length, offset, &bytes_read))
+	{
+		bytes_read = 0;
+	}
+
+	checksum->crc = j_checksum_crc32c(0, buffer, bytes_read);
+	checksum->length = bytes_read;
+}
+
+/**
+ * Returns the namespace an object's checksums are stored in.
+ *
+ * \private
+ *
+ * \param namespace The object's namespace.
+ *
+ * \return The namespace, to be freed with g_free().
+ **/
+gchar*
+jd_object_checksums_namespace(gchar const* namespace)
+{
+	return g_strconcat(namespace, JD_OBJECT_CHECKSUM_SUFFIX, NULL);
+}
+
+/**
+ * Returns the lock that protects an object and its checksums.
+ * Modifications hold it for writing, reads that are verified hold it for reading.
+ *
+ * \private
+ *
+ * \param namespace A namespace.
+ * \param path      A path.
+ *
+ * \return The lock.
+ **/
+GRWLock*
+jd_object_checksums_lock(gchar const* namespace, gchar const* path)
+{
+	return &(jd_object_checksum_lock[(g_str_hash(namespace) ^ g_str_hash(path)) % JD_OBJECT_CHECKSUM_LOCKS]);
+}
+
+/**
+ * Updates the checksums of a range that has been modified.
+ * Chunks that are written completely are checksummed from the written data, all others are read back.
+ * Has to be called with the object's lock held for writing.
+ *
+ * \private
+ *
+ * \param checksums The object's checksums.
+ * \param object    The object.
+ * \param data      The written data, NULL if it is not available.
+ * \param length    The length of the range.
+ * \param offset    The offset of the range.
+ **/
+void
+jd_object_checksums_update(JdObjectChecksums const* checksums, gpointer object, gconstpointer data, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree JdObjectChecksum* entries = NULL;
+	g_autofree gchar* buffer = NULL;
+	guint64 bytes_written = 0;
+	guint64 count;
+	guint64 first;
+
+	if (length == 0)
+	{
+		return;
+	}
+
+	first = offset / JD_OBJECT_CHECKSUM_CHUNK;
+	count = (offset + length - 1) / JD_OBJECT_CHECKSUM_CHUNK - first + 1;
+	entries = g_new(JdObjectChecksum, count);
+
+	for (guint64 i = 0; i < count; i++)
+	{
+		JdObjectChecksum checksum;
+		guint64 chunk_offset;
+
+		chunk_offset = (first + i) * JD_OBJECT_CHECKSUM_CHUNK;
+
+		if (data != NULL && chunk_offset >= offset && chunk_offset + JD_OBJECT_CHECKSUM_CHUNK <= offset + length)
+		{
+			checksum.crc = j_checksum_crc32c(0, (gchar const*)data + (chunk_offset - offset), JD_OBJECT_CHECKSUM_CHUNK);
+			checksum.length = JD_OBJECT_CHECKSUM_CHUNK;
+		}
+		else
+		{
+			if (buffer == NULL)
+			{
+				buffer = g_malloc(JD_OBJECT_CHECKSUM_CHUNK);
+			}
+
+			jd_object_checksums_read_chunk(object, buffer, JD_OBJECT_CHECKSUM_CHUNK, chunk_offset, &checksum);
+		}
+
+		entries[i].crc = GUINT32_TO_LE(checksum.crc);
+		entries[i].length = GUINT32_TO_LE(checksum.length);
+	}
+
+	if (!j_backend_object_write(jd_object_backend, checksums->object, entries, count * sizeof(JdObjectChecksum), first * sizeof(JdObjectChecksum), &bytes_written)
+	    || bytes_written != count * sizeof(JdObjectChecksum))
+	{
+		g_warning("Could not store checksums.");
+	}
+}
+
+/**
+ * Verifies data read from an object against the stored checksums.
+ * Chunks that have been read completely are verified using the read data, all others are read again.
+ *
+ * \private
+ *
+ * \param checksums The object's checksums.
+ * \param object    The object.
+ * \param data      The read data.
+ * \param length    The number of bytes read.
+ * \param offset    The offset the data has been read from.
+ *
+ * \return TRUE if the data is intact or there are no checksums for it, FALSE otherwise.
+ **/
+gboolean
+jd_object_checksums_verify(JdObjectChecksums const* checksums, gpointer object, gconstpointer data, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree JdObjectChecksum* entries = NULL;
+	g_autofree gchar* buffer = NULL;
+	guint64 bytes_read = 0;
+	guint64 count;
+	guint64 first;
+
+	if (length == 0)
+	{
+		return TRUE;
+	}
+
+	first = offset / JD_OBJECT_CHECKSUM_CHUNK;
+	count = (offset + length - 1) / JD_OBJECT_CHECKSUM_CHUNK - first + 1;
+	entries = g_new(JdObjectChecksum, count);
+
+	if (!j_backend_object_read(jd_object_backend, checksums->object, entries, count * sizeof(JdObjectChecksum), first * sizeof(JdObjectChecksum), &bytes_read))
+	{
+		return TRUE;
+	}
+
+	// Chunks beyond the end of the stored checksums have not been written with checksums enabled
+	count = bytes_read / sizeof(JdObjectChecksum);
+
+	for (guint64 i = 0; i < count; i++)
+	{
+		JdObjectChecksum checksum;
+		guint64 chunk_offset;
+		guint32 expected_crc;
+		guint32 expected_length;
+
+		chunk_offset = (first + i) * JD_OBJECT_CHECKSUM_CHUNK;
+		expected_crc = GUINT32_FROM_LE(entries[i].crc);
+		expected_length = GUINT32_FROM_LE(entries[i].length);
+
+		if (expected_length == 0)
+		{
+			continue;
+		}
+
+		if (chunk_offset >= offset && chunk_offset + expected_length <= offset + length)
+		{
+			checksum.crc = j_checksum_crc32c(0, (gchar const*)data + (chunk_offset - offset), expected_length);
+			checksum.length = expected_length;
+		}
+		else
+		{
+			if (buffer == NULL)
+			{
+				buffer = g_malloc(JD_OBJECT_CHECKSUM_CHUNK);
+			}
+
+			jd_object_checksums_read_chunk(object, buffer, expected_length, chunk_offset, &checksum);
+		}
+
+		if (checksum.crc != expected_crc || checksum.length != expected_length)
+		{
+			g_warning("Checksum mismatch in chunk at offset %" G_GUINT64_FORMAT ".", chunk_offset);
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Deletes an object's checksums.
+ * If objects are deleted in the background, the checksums are deleted in the background, too.
+ *
+ * \private
+ *
+ * \param namespace The object's namespace.
+ * \param path      The object's path.
+ **/
+void
+jd_object_checksums_delete(gchar const* namespace, gchar const* path)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* checksums_namespace = NULL;
+	gpointer object;
+
+	checksums_namespace = jd_object_checksums_namespace(namespace);
+
+	if (jd_object_reclaim_enabled())
+	{
+		jd_object_reclaim_defer(checksums_namespace, path);
+	}
+	else if (j_backend_object_open(jd_object_backend, checksums_namespace, path, &object))
+	{
+		j_backend_object_delete(jd_object_backend, object);
+	}
+}
+
+/**
+ * Clones an object's checksums after the object has been cloned.
+ * The clone's old checksums have to be deleted before.
+ *
+ * \private
+ *
+ * \param namespace       The object's namespace.
+ * \param path            The object's path.
+ * \param clone_namespace The clone's namespace.
+ * \param clone_path      The clone's path.
+ **/
+void
+jd_object_checksums_clone(gchar const* namespace, gchar const* path, gchar const* clone_namespace, gchar const* clone_path)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* checksums_namespace = NULL;
+	g_autofree gchar* clone_checksums_namespace = NULL;
+	gpointer object;
+	gpointer clone;
+
+	checksums_namespace = jd_object_checksums_namespace(namespace);
+	clone_checksums_namespace = jd_object_checksums_namespace(clone_namespace);
+
+	if (!j_backend_object_open(jd_object_backend, checksums_namespace, path, &object))
+	{
+		return;
+	}
+
+	jd_object_reclaim_now(clone_checksums_namespace, clone_path);
+
+	if (j_backend_object_create(jd_object_backend, clone_checksums_namespace, clone_path, &clone))
+	{
+		// Without its checksums, the clone's data is simply not verified
+		if (!j_backend_object_clone(jd_object_backend, object, clone))
+		{
+			j_backend_object_delete(jd_object_backend, clone);
+		}
+		else
+		{
+			j_backend_object_close(jd_object_backend, clone);
+		}
+	}
+
+	j_backend_object_close(jd_object_backend, object);
+}
@@ -0,0 +1,418 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <julea.h>
+
+#include "server.h"
+
+/**
+ * The number of locks objects and blocks are distributed over.
+ **/
+#define JD_OBJECT_DEDUP_LOCKS 64
+
+/**
+ * The suffix of the namespaces the blocks referenced by objects are recorded in.
+ * Each object has a map containing one hash per block, unreferenced blocks are zeroed.
+ **/
+#define JD_OBJECT_DEDUP_MAP_SUFFIX ".dedup"
+
+/**
+ * The namespace the blocks are stored in, named after their hashes.
+ **/
+#define JD_OBJECT_DEDUP_BLOCKS ".dedup-blocks"
+
+/**
+ * The namespace the blocks' reference counts are stored in.
+ * Each count is stored in little endian byte order.
+ **/
+#define JD_OBJECT_DEDUP_REFERENCES ".dedup-references"
+
+static GMutex jd_object_dedup_object_lock[JD_OBJECT_DEDUP_LOCKS];
+static GMutex jd_object_dedup_block_lock[JD_OBJECT_DEDUP_LOCKS];
+
+static guint8 const jd_object_dedup_none[J_CHECKSUM_DIGEST_SIZE] = { 0 };
+
+static GMutex*
+jd_object_dedup_object_lock_get(gchar const* namespace, gchar const* path)
+{
+	return &(jd_object_dedup_object_lock[(g_str_hash(namespace) ^ g_str_hash(path)) % JD_OBJECT_DEDUP_LOCKS]);
+}
+
+static GMutex*
+jd_object_dedup_block_lock_get(guint8 const* hash)
+{
+	return &(jd_object_dedup_block_lock[hash[0] % JD_OBJECT_DEDUP_LOCKS]);
+}
+
+static void
+jd_object_dedup_name(guint8 const* hash, gchar* name)
+{
+	for (guint i = 0; i < J_CHECKSUM_DIGEST_SIZE; i++)
+	{
+		g_snprintf(name + 2 * i, 3, "%02x", hash[i]);
+	}
+}
+
+/**
+ * Changes a block's reference count and deletes the block if it is not referenced anymore.
+ * Has to be called with the block's lock held.
+ *
+ * \private
+ *
+ * \param hash  The block's hash.
+ * \param delta The change.
+ **/
+static void
+jd_object_dedup_references_add(guint8 const* hash, gint64 delta)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gchar name[2 * J_CHECKSUM_DIGEST_SIZE + 1];
+	gpointer object;
+	guint64 references = 0;
+	guint64 bytes_read = 0;
+	guint64 bytes_written = 0;
+
+	jd_object_dedup_name(hash, name);
+
+	if (!j_backend_object_open(jd_object_backend, JD_OBJECT_DEDUP_REFERENCES, name, &object))
+	{
+		if (delta <= 0 || !j_backend_object_create(jd_object_backend, JD_OBJECT_DEDUP_REFERENCES, name, &object))
+		{
+			return;
+		}
+	}
+
+	if (j_backend_object_read(jd_object_backend, object, &references, sizeof(references), 0, &bytes_read) && bytes_read == sizeof(references))
+	{
+		references = GUINT64_FROM_LE(references);
+	}
+	else
+	{
+		references = 0;
+	}
+
+	if (delta < 0 && references <= (guint64)-delta)
+	{
+		gpointer block;
+
+		j_backend_object_delete(jd_object_backend, object);
+
+		if (j_backend_object_open(jd_object_backend, JD_OBJECT_DEDUP_BLOCKS, name, &block))
+		{
+			j_backend_object_delete(jd_object_backend, block);
+		}
+
+		return;
+	}
+
+	references = GUINT64_TO_LE(references + delta);
+
+	if (!j_backend_object_write(jd_object_backend, object, &references, sizeof(references), 0, &bytes_written) || bytes_written != sizeof(references))
+	{
+		g_warning("Could not store reference count of block %s.", name);
+	}
+
+	j_backend_object_close(jd_object_backend, object);
+}
+
+/**
+ * Drops a reference to a block.
+ *
+ * \private
+ **/
+static void
+jd_object_dedup_unref(guint8 const* hash)
+{
+	GMutex* lock;
+
+	if (memcmp(hash, jd_object_dedup_none, J_CHECKSUM_DIGEST_SIZE) == 0)
+	{
+		return;
+	}
+
+	lock = jd_object_dedup_block_lock_get(hash);
+
+	g_mutex_lock(lock);
+	jd_object_dedup_references_add(hash, -1);
+	g_mutex_unlock(lock);
+}
+
+/**
+ * Opens an object's map.
+ *
+ * \private
+ *
+ * \param namespace The object's namespace.
+ * \param path      The object's path.
+ * \param create    Whether to create the map if it does not exist.
+ * \param map       Returns the map.
+ *
+ * \return TRUE if the map has been opened, FALSE otherwise.
+ **/
+static gboolean
+jd_object_dedup_map_open(gchar const* namespace, gchar const* path, gboolean create, gpointer* map)
+{
+	g_autofree gchar* map_namespace = NULL;
+
+	map_namespace = g_strconcat(namespace, JD_OBJECT_DEDUP_MAP_SUFFIX, NULL);
+
+	if (j_backend_object_open(jd_object_backend, map_namespace, path, map))
+	{
+		return TRUE;
+	}
+
+	return create && j_backend_object_create(jd_object_backend, map_namespace, path, map);
+}
+
+/**
+ * Drops the references of all blocks overlapping a range that has been modified.
+ * Blocks that are modified partially are not deduplicated anymore.
+ *
+ * \private
+ *
+ * \param namespace The object's namespace.
+ * \param path      The object's path.
+ * \param length    The length of the range.
+ * \param offset    The offset of the range.
+ **/
+void
+jd_object_dedup_release(gchar const* namespace, gchar const* path, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree guint8* entries = NULL;
+	GMutex* lock;
+	gpointer map;
+	guint64 bytes_read = 0;
+	guint64 bytes_written = 0;
+	guint64 count;
+	guint64 first;
+
+	if (length == 0)
+	{
+		return;
+	}
+
+	first = offset / J_MESSAGE_DEDUP_BLOCK_SIZE;
+	count = (offset + length - 1) / J_MESSAGE_DEDUP_BLOCK_SIZE - first + 1;
+
+	lock = jd_object_dedup_object_lock_get(namespace, path);
+	g_mutex_lock(lock);
+
+	if (!jd_object_dedup_map_open(namespace, path, FALSE, &map))
+	{
+		goto end;
+	}
+
+	entries = g_malloc(count * J_CHECKSUM_DIGEST_SIZE);
+
+	if (j_backend_object_read(jd_object_backend, map, entries, count * J_CHECKSUM_DIGEST_SIZE, first * J_CHECKSUM_DIGEST_SIZE, &bytes_read))
+	{
+		gboolean referenced = FALSE;
+
+		// Blocks beyond the end of the map have never been deduplicated
+		count = bytes_read / J_CHECKSUM_DIGEST_SIZE;
+
+		for (guint64 i = 0; i < count; i++)
+		{
+			if (memcmp(entries + i * J_CHECKSUM_DIGEST_SIZE, jd_object_dedup_none, J_CHECKSUM_DIGEST_SIZE) != 0)
+			{
+				jd_object_dedup_unref(entries + i * J_CHECKSUM_DIGEST_SIZE);
+				referenced = TRUE;
+			}
+		}
+
+		if (referenced)
+		{
+			memset(entries, 0, count * J_CHECKSUM_DIGEST_SIZE);
+			j_backend_object_write(jd_object_backend, map, entries, count * J_CHECKSUM_DIGEST_SIZE, first * J_CHECKSUM_DIGEST_SIZE, &bytes_written);
+		}
+	}
+
+	j_backend_object_close(jd_object_backend, map);
+
+end:
+	g_mutex_unlock(lock);
+}
+
+/**
+ * Makes a block of an object reference a stored block.
+ * If data is given, it is stored unless a block with the same hash exists already; the object's data has to be written separately.
+ * Otherwise, the stored block is copied to the object, sharing storage if the backend supports it.
+ *
+ * \private
+ *
+ * \param namespace The object's namespace.
+ * \param path      The object's path.
+ * \param object    The object.
+ * \param hash      The block's hash.
+ * \param data      The block's data or NULL.
+ * \param offset    The block's offset, a multiple of #J_MESSAGE_DEDUP_BLOCK_SIZE.
+ *
+ * \return TRUE if the block is referenced, FALSE if the data is not stored.
+ **/
+gboolean
+jd_object_dedup_reference(gchar const* namespace, gchar const* path, gpointer object, guint8 const* hash, gconstpointer data, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gchar name[2 * J_CHECKSUM_DIGEST_SIZE + 1];
+	guint8 old_hash[J_CHECKSUM_DIGEST_SIZE];
+	GMutex* lock;
+	GMutex* block_lock;
+	gpointer block;
+	gpointer map;
+	guint64 bytes_read = 0;
+	guint64 bytes_written = 0;
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(offset % J_MESSAGE_DEDUP_BLOCK_SIZE == 0, FALSE);
+
+	// The hash of unreferenced blocks cannot be stored
+	if (memcmp(hash, jd_object_dedup_none, J_CHECKSUM_DIGEST_SIZE) == 0)
+	{
+		return FALSE;
+	}
+
+	jd_object_dedup_name(hash, name);
+
+	lock = jd_object_dedup_object_lock_get(namespace, path);
+	block_lock = jd_object_dedup_block_lock_get(hash);
+
+	g_mutex_lock(lock);
+	g_mutex_lock(block_lock);
+
+	if (j_backend_object_open(jd_object_backend, JD_OBJECT_DEDUP_BLOCKS, name, &block))
+	{
+		ret = (data != NULL) || j_backend_object_copy_range(jd_object_backend, block, object, J_MESSAGE_DEDUP_BLOCK_SIZE, 0, offset);
+		j_backend_object_close(jd_object_backend, block);
+	}
+	else if (data != NULL && j_backend_object_create(jd_object_backend, JD_OBJECT_DEDUP_BLOCKS, name, &block))
+	{
+		ret = j_backend_object_write(jd_object_backend, block, data, J_MESSAGE_DEDUP_BLOCK_SIZE, 0, &bytes_written) && bytes_written == J_MESSAGE_DEDUP_BLOCK_SIZE;
+
+		if (ret)
+		{
+			j_backend_object_close(jd_object_backend, block);
+		}
+		else
+		{
+			j_backend_object_delete(jd_object_backend, block);
+		}
+	}
+
+	if (ret)
+	{
+		jd_object_dedup_references_add(hash, 1);
+	}
+
+	g_mutex_unlock(block_lock);
+
+	if (!ret)
+	{
+		goto end;
+	}
+
+	if (!jd_object_dedup_map_open(namespace, path, TRUE, &map))
+	{
+		// Without the map entry, the reference could never be dropped
+		jd_object_dedup_unref(hash);
+		goto end;
+	}
+
+	if (!j_backend_object_read(jd_object_backend, map, old_hash, sizeof(old_hash), (offset / J_MESSAGE_DEDUP_BLOCK_SIZE) * J_CHECKSUM_DIGEST_SIZE, &bytes_read) || bytes_read != sizeof(old_hash))
+	{
+		memset(old_hash, 0, sizeof(old_hash));
+	}
+
+	if (j_backend_object_write(jd_object_backend, map, hash, J_CHECKSUM_DIGEST_SIZE, (offset / J_MESSAGE_DEDUP_BLOCK_SIZE) * J_CHECKSUM_DIGEST_SIZE, &bytes_written) && bytes_written == J_CHECKSUM_DIGEST_SIZE)
+	{
+		jd_object_dedup_unref(old_hash);
+	}
+	else
+	{
+		jd_object_dedup_unref(hash);
+	}
+
+	j_backend_object_close(jd_object_backend, map);
+
+end:
+	g_mutex_unlock(lock);
+
+	return ret;
+}
+
+/**
+ * Drops the references of all blocks of an object and deletes its map.
+ *
+ * \private
+ *
+ * \param namespace The object's namespace.
+ * \param path      The object's path.
+ **/
+void
+jd_object_dedup_delete(gchar const* namespace, gchar const* path)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree guint8* entries = NULL;
+	GMutex* lock;
+	gpointer map;
+	guint64 size = 0;
+	guint64 const entries_size = 4096 * J_CHECKSUM_DIGEST_SIZE;
+
+	lock = jd_object_dedup_object_lock_get(namespace, path);
+	g_mutex_lock(lock);
+
+	if (!jd_object_dedup_map_open(namespace, path, FALSE, &map))
+	{
+		goto end;
+	}
+
+	entries = g_malloc(entries_size);
+
+	if (j_backend_object_status(jd_object_backend, map, NULL, &size))
+	{
+		for (guint64 position = 0; position < size; position += entries_size)
+		{
+			guint64 bytes_read = 0;
+
+			if (!j_backend_object_read(jd_object_backend, map, entries, entries_size, position, &bytes_read))
+			{
+				break;
+			}
+
+			for (guint64 i = 0; i + J_CHECKSUM_DIGEST_SIZE <= bytes_read; i += J_CHECKSUM_DIGEST_SIZE)
+			{
+				jd_object_dedup_unref(entries + i);
+			}
+		}
+	}
+
+	j_backend_object_delete(jd_object_backend, map);
+
+end:
+	g_mutex_unlock(lock);
+}
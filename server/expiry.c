@@ -0,0 +1,424 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <julea.h>
+
+#include "server.h"
+
+/**
+ * The namespace holding the expiry records.
+ * Index entries "t:<expiry>:<record>" are sorted by their expiry time and point to their record.
+ * Records "k:<namespace length>:<namespace>:<key>" hold a key's current expiry time.
+ **/
+#define JD_KV_EXPIRY_NAMESPACE "julea-expiry"
+
+/**
+ * The number of seconds between two sweeps.
+ **/
+#define JD_KV_EXPIRY_INTERVAL 5
+
+/**
+ * The maximum number of expired keys reclaimed within one backend batch.
+ **/
+#define JD_KV_EXPIRY_BATCH 1024
+
+struct JdKVExpiry
+{
+	gchar* namespace;
+	JSemantics* semantics;
+
+	/**
+	 * The keys whose expiry changes, with their TTL.
+	 **/
+	GPtrArray* keys;
+	GArray* ttls;
+};
+
+static struct
+{
+	GThread* thread;
+
+	GMutex mutex[1];
+	GCond cond[1];
+	gboolean stop;
+
+	/**
+	 * Puts hold the lock for reading, the sweeper for writing.
+	 * This keeps the sweeper from deleting a key that is being put again without a TTL.
+	 **/
+	GRWLock lock[1];
+
+	/**
+	 * Whether any key has ever been given a TTL.
+	 * Until then, plain puts do not have to clear expiry records.
+	 **/
+	gint used;
+} jd_kv_expiry;
+
+static gchar*
+jd_kv_expiry_record_key(gchar const* namespace, gchar const* key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return g_strdup_printf("k:%zu:%s:%s", strlen(namespace), namespace, key);
+}
+
+/**
+ * Splits a record key into its namespace and key.
+ *
+ * \private
+ *
+ * \param record    A record key.
+ * \param namespace Returns the namespace, should be freed with g_free().
+ * \param key       Returns the key.
+ *
+ * \return TRUE on success, FALSE if the record key is malformed.
+ **/
+static gboolean
+jd_kv_expiry_record_parse(gchar const* record, gchar** namespace, gchar const** key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gchar* end = NULL;
+	guint64 namespace_len;
+
+	if (!g_str_has_prefix(record, "k:"))
+	{
+		return FALSE;
+	}
+
+	namespace_len = g_ascii_strtoull(record + 2, &end, 10);
+
+	if (end == NULL || *end != ':' || strlen(end + 1) < namespace_len + 1 || end[1 + namespace_len] != ':')
+	{
+		return FALSE;
+	}
+
+	*namespace = g_strndup(end + 1, namespace_len);
+	*key = end + 1 + namespace_len + 1;
+
+	return TRUE;
+}
+
+/**
+ * Reclaims one batch of expired keys.
+ *
+ * \private
+ *
+ * \param semantics The semantics to delete the keys with.
+ *
+ * \return TRUE if there might be more expired keys, FALSE otherwise.
+ **/
+static gboolean
+jd_kv_expiry_sweep(JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GPtrArray) index_keys = NULL;
+	g_autoptr(GPtrArray) records = NULL;
+	g_autofree gchar* end = NULL;
+	gpointer iterator = NULL;
+	gpointer batch = NULL;
+	gchar const* key;
+	gconstpointer value;
+	guint32 len;
+
+	index_keys = g_ptr_array_new_with_free_func(g_free);
+	records = g_ptr_array_new_with_free_func(g_free);
+	end = g_strdup_printf("t:%020" G_GINT64_FORMAT, g_get_real_time());
+
+	if (!j_backend_kv_get_range(jd_kv_backend, JD_KV_EXPIRY_NAMESPACE, "t:", end, FALSE, JD_KV_EXPIRY_BATCH, &iterator) || iterator == NULL)
+	{
+		return FALSE;
+	}
+
+	while (j_backend_kv_iterate(jd_kv_backend, iterator, &key, &value, &len))
+	{
+		g_ptr_array_add(index_keys, g_strdup(key));
+		g_ptr_array_add(records, g_strndup(value, len));
+	}
+
+	if (index_keys->len == 0)
+	{
+		return FALSE;
+	}
+
+	g_rw_lock_writer_lock(jd_kv_expiry.lock);
+
+	if (j_backend_kv_batch_start(jd_kv_backend, JD_KV_EXPIRY_NAMESPACE, semantics, &batch))
+	{
+		for (guint i = 0; i < index_keys->len; i++)
+		{
+			gchar const* index_key = g_ptr_array_index(index_keys, i);
+			gchar const* record = g_ptr_array_index(records, i);
+			g_autofree gpointer current = NULL;
+			g_autofree gchar* namespace = NULL;
+			gchar const* target;
+			guint32 current_len;
+			gint64 expiry;
+
+			expiry = g_ascii_strtoll(index_key + 2, NULL, 10);
+
+			// Only the latest expiry counts, the key might have been put again in the meantime.
+			if (j_backend_kv_get(jd_kv_backend, batch, record, &current, &current_len) && current_len == sizeof(gint64) && GINT64_FROM_LE(*(gint64*)current) == expiry && jd_kv_expiry_record_parse(record, &namespace, &target))
+			{
+				gpointer target_batch;
+
+				if (j_backend_kv_batch_start(jd_kv_backend, namespace, semantics, &target_batch))
+				{
+					j_backend_kv_delete(jd_kv_backend, target_batch, target);
+					j_backend_kv_batch_execute(jd_kv_backend, target_batch);
+				}
+
+				j_backend_kv_delete(jd_kv_backend, batch, record);
+			}
+
+			j_backend_kv_delete(jd_kv_backend, batch, index_key);
+		}
+
+		j_backend_kv_batch_execute(jd_kv_backend, batch);
+	}
+
+	g_rw_lock_writer_unlock(jd_kv_expiry.lock);
+
+	return (index_keys->len == JD_KV_EXPIRY_BATCH);
+}
+
+static gpointer
+jd_kv_expiry_thread(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JSemantics) semantics = NULL;
+
+	(void)data;
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	g_mutex_lock(jd_kv_expiry.mutex);
+
+	while (!jd_kv_expiry.stop)
+	{
+		gint64 end_time;
+
+		if (g_atomic_int_get(&(jd_kv_expiry.used)))
+		{
+			gboolean more;
+
+			do
+			{
+				g_mutex_unlock(jd_kv_expiry.mutex);
+				more = jd_kv_expiry_sweep(semantics);
+				g_mutex_lock(jd_kv_expiry.mutex);
+			} while (more && !jd_kv_expiry.stop);
+		}
+
+		end_time = g_get_monotonic_time() + JD_KV_EXPIRY_INTERVAL * G_TIME_SPAN_SECOND;
+
+		while (!jd_kv_expiry.stop && g_cond_wait_until(jd_kv_expiry.cond, jd_kv_expiry.mutex, end_time))
+		{
+		}
+	}
+
+	g_mutex_unlock(jd_kv_expiry.mutex);
+
+	return NULL;
+}
+
+/**
+ * Starts reclaiming expired keys in the background.
+ *
+ * \private
+ **/
+void
+jd_kv_expiry_start(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gpointer iterator = NULL;
+	gchar const* key;
+	gconstpointer value;
+	guint32 len;
+
+	g_return_if_fail(jd_kv_backend != NULL);
+	g_return_if_fail(jd_kv_expiry.thread == NULL);
+
+	// Records left over from earlier runs have to be honored.
+	if (j_backend_kv_get_range(jd_kv_backend, JD_KV_EXPIRY_NAMESPACE, NULL, NULL, FALSE, 1, &iterator) && iterator != NULL)
+	{
+		while (j_backend_kv_iterate(jd_kv_backend, iterator, &key, &value, &len))
+		{
+			g_atomic_int_set(&(jd_kv_expiry.used), 1);
+		}
+	}
+
+	jd_kv_expiry.stop = FALSE;
+	jd_kv_expiry.thread = g_thread_new("julea-expiry", jd_kv_expiry_thread, NULL);
+}
+
+/**
+ * Stops reclaiming expired keys.
+ *
+ * \private
+ **/
+void
+jd_kv_expiry_stop(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (jd_kv_expiry.thread == NULL)
+	{
+		return;
+	}
+
+	g_mutex_lock(jd_kv_expiry.mutex);
+	jd_kv_expiry.stop = TRUE;
+	g_cond_signal(jd_kv_expiry.cond);
+	g_mutex_unlock(jd_kv_expiry.mutex);
+
+	g_thread_join(jd_kv_expiry.thread);
+	jd_kv_expiry.thread = NULL;
+}
+
+/**
+ * Begins tracking the expiry of puts into a namespace.
+ * Has to be called before the puts' backend batch is executed.
+ *
+ * \private
+ *
+ * \param namespace A namespace.
+ * \param semantics The semantics to update the expiry records with.
+ *
+ * \return A new expiry context, should be finished with jd_kv_expiry_end().
+ **/
+JdKVExpiry*
+jd_kv_expiry_begin(gchar const* namespace, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdKVExpiry* expiry;
+
+	expiry = g_slice_new(JdKVExpiry);
+	expiry->namespace = g_strdup(namespace);
+	expiry->semantics = j_semantics_ref(semantics);
+	expiry->keys = g_ptr_array_new_with_free_func(g_free);
+	expiry->ttls = g_array_new(FALSE, FALSE, sizeof(GTimeSpan));
+
+	g_rw_lock_reader_lock(jd_kv_expiry.lock);
+
+	return expiry;
+}
+
+/**
+ * Records the TTL of a put.
+ *
+ * \private
+ *
+ * \param expiry An expiry context.
+ * \param key    A key.
+ * \param ttl    The key's TTL in microseconds, 0 if it does not expire.
+ **/
+void
+jd_kv_expiry_set(JdKVExpiry* expiry, gchar const* key, GTimeSpan ttl)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(expiry != NULL);
+	g_return_if_fail(key != NULL);
+
+	if (ttl > 0)
+	{
+		g_atomic_int_set(&(jd_kv_expiry.used), 1);
+	}
+	else if (!g_atomic_int_get(&(jd_kv_expiry.used)))
+	{
+		return;
+	}
+
+	g_ptr_array_add(expiry->keys, g_strdup(key));
+	g_array_append_val(expiry->ttls, ttl);
+}
+
+/**
+ * Finishes tracking the expiry of puts.
+ *
+ * \private
+ *
+ * \param expiry An expiry context.
+ * \param commit Whether the puts have been applied.
+ **/
+void
+jd_kv_expiry_end(JdKVExpiry* expiry, gboolean commit)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gpointer batch = NULL;
+	gint64 now;
+
+	g_return_if_fail(expiry != NULL);
+
+	now = g_get_real_time();
+
+	if (commit && expiry->keys->len > 0 && j_backend_kv_batch_start(jd_kv_backend, JD_KV_EXPIRY_NAMESPACE, expiry->semantics, &batch))
+	{
+		for (guint i = 0; i < expiry->keys->len; i++)
+		{
+			g_autofree gchar* record = NULL;
+			GTimeSpan ttl;
+
+			record = jd_kv_expiry_record_key(expiry->namespace, g_ptr_array_index(expiry->keys, i));
+			ttl = g_array_index(expiry->ttls, GTimeSpan, i);
+
+			if (ttl > 0)
+			{
+				g_autofree gchar* index_key = NULL;
+				gint64 expires;
+				gint64 expires_le;
+
+				expires = now + ttl;
+				expires_le = GINT64_TO_LE(expires);
+				index_key = g_strdup_printf("t:%020" G_GINT64_FORMAT ":%s", expires, record);
+
+				// Superseded index entries are discarded by the sweeper, since they do not match the record anymore.
+				j_backend_kv_put(jd_kv_backend, batch, record, &expires_le, sizeof(expires_le));
+				j_backend_kv_put(jd_kv_backend, batch, index_key, record, strlen(record));
+			}
+			else
+			{
+				j_backend_kv_delete(jd_kv_backend, batch, record);
+			}
+		}
+
+		j_backend_kv_batch_execute(jd_kv_backend, batch);
+	}
+
+	g_rw_lock_reader_unlock(jd_kv_expiry.lock);
+
+	g_array_unref(expiry->ttls);
+	g_ptr_array_unref(expiry->keys);
+	j_semantics_unref(expiry->semantics);
+	g_free(expiry->namespace);
+
+	g_slice_free(JdKVExpiry, expiry);
+}
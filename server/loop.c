@@ -22,36 +22,2622 @@
 #include <glib.h>
 #include <gio/gio.h>
 
+#include <string.h>
+
 #include <julea.h>
 
-#include "server.h"
+#include "server.h"
+
+static guint jd_thread_num = 0;
+
+/**
+ * The maximum number of objects a connection keeps open.
+ **/
+#define JD_OBJECT_HANDLES_MAX 16
+
+/**
+ * The minimum length of a read or write to be transferred directly between the socket and the backend's file descriptor.
+ * Smaller accesses are cheaper to copy than to transfer with separate system calls.
+ **/
+#define JD_OBJECT_ZERO_COPY_MIN (64 * 1024)
+
+/**
+ * The number of locks serializing appends.
+ * Appends to the same object always use the same lock, so that they can not determine the same offset.
+ **/
+#define JD_OBJECT_APPEND_LOCKS 64
+
+static GMutex jd_object_append_mutex[JD_OBJECT_APPEND_LOCKS];
+
+/**
+ * The number of objects sent per reply when listing objects with their status.
+ * Listings are streamed in several replies, so that neither side has to buffer all of them.
+ **/
+#define JD_OBJECT_LIST_BATCH 1024
+
+/**
+ * Incremented whenever an object is deleted.
+ * Connections drop their open objects when it changes, so writes never end up in a deleted object.
+ **/
+static gint jd_object_generation = 0;
+
+/**
+ * An object kept open by a connection.
+ **/
+struct JdObjectHandle
+{
+	/**
+	 * The namespace and path, separated by a slash.
+	 **/
+	gchar* key;
+
+	/**
+	 * The backend object.
+	 **/
+	gpointer object;
+};
+
+typedef struct JdObjectHandle JdObjectHandle;
+
+/**
+ * The objects a connection keeps open across messages.
+ * Many clients writing to one shared object send a message per write,
+ * which would otherwise have to open and close the object every time.
+ * If more than #JD_OBJECT_HANDLES_MAX objects are accessed, the least recently used one is closed.
+ **/
+struct JdObjectHandles
+{
+	/**
+	 * Maps namespace and path to the object's link in #lru.
+	 **/
+	GHashTable* objects;
+
+	/**
+	 * Contains JdObjectHandle elements, the most recently used one first.
+	 **/
+	GQueue lru[1];
+
+	/**
+	 * The value of jd_object_generation the objects were opened at.
+	 **/
+	gint generation;
+};
+
+static void
+jd_object_handle_free(JdObjectHandle* handle)
+{
+	j_backend_object_close(jd_object_backend, handle->object);
+
+	g_free(handle->key);
+	g_slice_free(JdObjectHandle, handle);
+}
+
+/**
+ * Closes all objects of a connection.
+ *
+ * \private
+ **/
+static void
+jd_object_handles_clear(JdObjectHandles* handles)
+{
+	JdObjectHandle* handle;
+
+	g_hash_table_remove_all(handles->objects);
+
+	while ((handle = g_queue_pop_head(handles->lru)) != NULL)
+	{
+		jd_object_handle_free(handle);
+	}
+}
+
+JdObjectHandles*
+jd_object_handles_new(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdObjectHandles* handles;
+
+	handles = g_slice_new(JdObjectHandles);
+	handles->objects = g_hash_table_new(g_str_hash, g_str_equal);
+	g_queue_init(handles->lru);
+	handles->generation = g_atomic_int_get(&jd_object_generation);
+
+	return handles;
+}
+
+void
+jd_object_handles_free(JdObjectHandles* handles)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(handles != NULL);
+
+	jd_object_handles_clear(handles);
+	g_hash_table_unref(handles->objects);
+
+	g_slice_free(JdObjectHandles, handles);
+}
+
+/**
+ * Returns an open object, opening it if necessary.
+ * The object is owned by the connection and must not be closed.
+ *
+ * \private
+ *
+ * \return The object, NULL if it could not be opened.
+ **/
+static gpointer
+jd_object_handles_open(JdObjectHandles* handles, gchar const* namespace, gchar const* path)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* key = NULL;
+	JdObjectHandle* handle;
+	GList* link;
+	gpointer object;
+	gint generation;
+
+	generation = g_atomic_int_get(&jd_object_generation);
+
+	if (handles->generation != generation)
+	{
+		jd_object_handles_clear(handles);
+		handles->generation = generation;
+	}
+
+	key = g_strconcat(namespace, "/", path, NULL);
+
+	if ((link = g_hash_table_lookup(handles->objects, key)) != NULL)
+	{
+		g_queue_unlink(handles->lru, link);
+		g_queue_push_head_link(handles->lru, link);
+
+		handle = link->data;
+
+		return handle->object;
+	}
+
+	if (jd_object_reclaim_pending(namespace, path) || !j_backend_object_open(jd_object_backend, namespace, path, &object))
+	{
+		return NULL;
+	}
+
+	if (g_queue_get_length(handles->lru) >= JD_OBJECT_HANDLES_MAX)
+	{
+		handle = g_queue_pop_tail(handles->lru);
+
+		g_hash_table_remove(handles->objects, handle->key);
+		jd_object_handle_free(handle);
+	}
+
+	handle = g_slice_new(JdObjectHandle);
+	handle->key = g_steal_pointer(&key);
+	handle->object = object;
+
+	g_queue_push_head(handles->lru, handle);
+	g_hash_table_insert(handles->objects, handle->key, handles->lru->head);
+
+	return object;
+}
+
+/**
+ * Opens the checksums stored alongside an object.
+ * The checksums' object is owned by the connection and must not be closed.
+ *
+ * \private
+ *
+ * \param checksums Returns the checksums.
+ * \param create    Whether the checksums should be created if they do not exist yet.
+ *
+ * \return #checksums, NULL if checksums are disabled or do not exist.
+ **/
+static JdObjectChecksums*
+jd_object_checksums_open(JdObjectHandles* handles, JdObjectChecksums* checksums, gchar const* namespace, gchar const* path, gboolean create)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* checksums_namespace = NULL;
+
+	if (!jd_object_checksums_enabled)
+	{
+		return NULL;
+	}
+
+	checksums_namespace = jd_object_checksums_namespace(namespace);
+	checksums->object = jd_object_handles_open(handles, checksums_namespace, path);
+
+	if (checksums->object == NULL && create)
+	{
+		gpointer new_object;
+
+		jd_object_reclaim_now(checksums_namespace, path);
+
+		if (j_backend_object_create(jd_object_backend, checksums_namespace, path, &new_object))
+		{
+			j_backend_object_close(jd_object_backend, new_object);
+		}
+
+		checksums->object = jd_object_handles_open(handles, checksums_namespace, path);
+	}
+
+	if (checksums->object == NULL)
+	{
+		return NULL;
+	}
+
+	checksums->lock = jd_object_checksums_lock(namespace, path);
+
+	return checksums;
+}
+
+/**
+ * Returns whether a request may create missing objects.
+ * Only the parts of distributed objects are created lazily, other objects have to be created explicitly.
+ *
+ * \private
+ *
+ * \param message A message.
+ *
+ * \return TRUE if missing objects may be created, FALSE otherwise.
+ **/
+static gboolean
+jd_object_lazy_create_allowed(JMessage* message)
+{
+	return jd_object_lazy_create && j_message_get_lazy_create(message);
+}
+
+/**
+ * Concurrent syncs are merged into groups.
+ * While one thread (the leader) syncs a group, syncs arriving on other threads are collected into the next group.
+ * As soon as the leader is done, one of the waiting threads syncs the whole next group with a single backend call.
+ * This adds no latency for a single client but shares the cost of a sync among concurrent ones.
+ **/
+static struct
+{
+	GMutex mutex[1];
+	GCond cond[1];
+
+	/**
+	 * The objects of the group that is currently being collected.
+	 **/
+	GPtrArray* pending;
+
+	/**
+	 * The number of the group that is currently being collected.
+	 **/
+	guint64 collecting;
+
+	/**
+	 * The number of the last group that has been synced.
+	 **/
+	guint64 completed;
+
+	/**
+	 * Whether a leader is currently syncing a group.
+	 **/
+	gboolean leader;
+} jd_sync_group = { .collecting = 1 };
+
+/**
+ * Syncs an object, possibly together with objects of concurrent connections.
+ * Returns after the object has been synced.
+ *
+ * \private
+ *
+ * \param object An object.
+ **/
+static void
+jd_sync_object(gpointer object)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 group;
+
+	g_mutex_lock(jd_sync_group.mutex);
+
+	if (jd_sync_group.pending == NULL)
+	{
+		jd_sync_group.pending = g_ptr_array_new();
+	}
+
+	group = jd_sync_group.collecting;
+
+	// Different connections can share the same object
+	if (!g_ptr_array_find(jd_sync_group.pending, object, NULL))
+	{
+		g_ptr_array_add(jd_sync_group.pending, object);
+	}
+
+	while (jd_sync_group.completed < group)
+	{
+		if (!jd_sync_group.leader)
+		{
+			g_autoptr(GPtrArray) objects = NULL;
+			guint64 current;
+
+			jd_sync_group.leader = TRUE;
+
+			objects = jd_sync_group.pending;
+			current = jd_sync_group.collecting;
+
+			jd_sync_group.pending = g_ptr_array_new();
+			jd_sync_group.collecting++;
+
+			g_mutex_unlock(jd_sync_group.mutex);
+
+			j_backend_object_syncv(jd_object_backend, objects->pdata, objects->len);
+
+			g_mutex_lock(jd_sync_group.mutex);
+
+			jd_sync_group.completed = current;
+			jd_sync_group.leader = FALSE;
+
+			g_cond_broadcast(jd_sync_group.cond);
+		}
+		else
+		{
+			g_cond_wait(jd_sync_group.cond, jd_sync_group.mutex);
+		}
+	}
+
+	g_mutex_unlock(jd_sync_group.mutex);
+}
+
+/**
+ * Reads all pending extents with a single backend call and appends them to the reply.
+ * Extents without a buffer are sent directly from the object's file descriptor.
+ * If the object has checksums, the read data is verified before it is sent.
+ *
+ * \private
+ *
+ * \param checked Whether the client requested a checksum, one element per extent.
+ **/
+static void
+jd_object_read_flush(gpointer object, GArray* extents, GArray* checked, gint fd, JdObjectChecksums const* checksums, JMessage* reply, JStatistics* statistics, JdSchedulerClient* client)
+{
+	g_autoptr(GArray) memory = NULL;
+	JBackendObjectExtent* extent;
+	guint64 size = 0;
+	guint j = 0;
+
+	if (extents->len == 0)
+	{
+		return;
+	}
+
+	memory = g_array_sized_new(FALSE, FALSE, sizeof(JBackendObjectExtent), extents->len);
+
+	for (guint i = 0; i < extents->len; i++)
+	{
+		extent = &g_array_index(extents, JBackendObjectExtent, i);
+
+		if (extent->data != NULL)
+		{
+			g_array_append_val(memory, *extent);
+		}
+	}
+
+	// Keep writes from modifying the data between reading and verifying it
+	if (checksums != NULL)
+	{
+		g_rw_lock_reader_lock(checksums->lock);
+	}
+
+	// Objects that have not been created yet are read as holes
+	if (memory->len > 0 && object != NULL)
+	{
+		guint64 cost = 0;
+
+		for (guint i = 0; i < memory->len; i++)
+		{
+			cost += g_array_index(memory, JBackendObjectExtent, i).length;
+		}
+
+		jd_scheduler_enter(client, JD_SCHEDULER_OBJECT, cost);
+		j_backend_object_readv(jd_object_backend, object, (JBackendObjectExtent*)(gpointer)memory->data, memory->len);
+		jd_scheduler_leave(client, JD_SCHEDULER_OBJECT, cost);
+	}
+
+	if (memory->len < extents->len)
+	{
+		gint64 modification_time;
+
+		// The data is not read here, so the reply's lengths are derived from the object's size
+		if (!j_backend_object_status(jd_object_backend, object, &modification_time, &size))
+		{
+			size = 0;
+		}
+	}
+
+	for (guint i = 0; i < extents->len; i++)
+	{
+		extent = &g_array_index(extents, JBackendObjectExtent, i);
+
+		if (extent->data != NULL)
+		{
+			extent = &g_array_index(memory, JBackendObjectExtent, j);
+			j++;
+		}
+		else
+		{
+			extent->bytes = (extent->offset < size) ? MIN(extent->length, size - extent->offset) : 0;
+		}
+
+		j_statistics_add(statistics, J_STATISTICS_BYTES_READ, extent->bytes);
+
+		// Corrupted data is not sent, the client sees a short read
+		if (checksums != NULL && extent->data != NULL && !jd_object_checksums_verify(checksums, object, extent->data, extent->bytes, extent->offset))
+		{
+			extent->bytes = 0;
+		}
+
+		if (g_array_index(checked, gboolean, i))
+		{
+			guint32 crc;
+
+			crc = (extent->data != NULL) ? j_checksum_crc32c(0, extent->data, extent->bytes) : 0;
+
+			j_message_add_operation(reply, sizeof(guint64) + sizeof(guint32));
+			j_message_append_8(reply, &(extent->bytes));
+			j_message_append_4(reply, &crc);
+		}
+		else
+		{
+			j_message_add_operation(reply, sizeof(guint64));
+			j_message_append_8(reply, &(extent->bytes));
+		}
+
+		if (extent->bytes > 0)
+		{
+			if (extent->data != NULL)
+			{
+				j_message_add_send(reply, extent->data, extent->bytes);
+			}
+			else
+			{
+				j_message_add_send_file(reply, fd, extent->offset, extent->bytes);
+			}
+		}
+
+		j_statistics_add(statistics, J_STATISTICS_BYTES_SENT, extent->bytes);
+	}
+
+	if (checksums != NULL)
+	{
+		g_rw_lock_reader_unlock(checksums->lock);
+	}
+
+	g_array_set_size(extents, 0);
+	g_array_set_size(checked, 0);
+}
+
+/**
+ * Compares two extent indices by the offsets of their extents.
+ *
+ * \private
+ **/
+static gint
+jd_object_extent_compare(gconstpointer a, gconstpointer b, gpointer data)
+{
+	GArray* extents = data;
+	JBackendObjectExtent const* extent_a = &g_array_index(extents, JBackendObjectExtent, *(guint const*)a);
+	JBackendObjectExtent const* extent_b = &g_array_index(extents, JBackendObjectExtent, *(guint const*)b);
+
+	if (extent_a->offset < extent_b->offset)
+	{
+		return -1;
+	}
+	else if (extent_a->offset > extent_b->offset)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Writes all pending extents with a single backend call and appends the results to the reply.
+ *
+ * The extents are sorted by offset and contiguous ones are coalesced if they do not overlap.
+ * Overlapping extents are written in arrival order to preserve their semantics.
+ * If the client guarantees non-overlapping access, the extents are not checked for overlaps.
+ * Replies are always appended in arrival order.
+ * If the object has checksums, they are updated together with the data.
+ *
+ * \private
+ **/
+static void
+jd_object_write_flush(gpointer object, GArray* extents, gboolean disjoint, JdObjectChecksums const* checksums, JMessage* reply, JStatistics* statistics, JdSchedulerClient* client)
+{
+	g_autoptr(GArray) order = NULL;
+	g_autoptr(GArray) merged = NULL;
+	g_autoptr(GArray) owners = NULL;
+	JBackendObjectExtent* extent;
+	JBackendObjectExtent* last = NULL;
+	gboolean overlap = FALSE;
+	guint64 cost = 0;
+
+	if (extents->len == 0)
+	{
+		return;
+	}
+
+	order = g_array_sized_new(FALSE, FALSE, sizeof(guint), extents->len);
+
+	for (guint i = 0; i < extents->len; i++)
+	{
+		g_array_append_val(order, i);
+	}
+
+	// g_array_sort_with_data() is stable, so extents with equal offsets keep their order
+	g_array_sort_with_data(order, jd_object_extent_compare, extents);
+
+	for (guint i = 1; i < order->len && !disjoint; i++)
+	{
+		JBackendObjectExtent const* prev = &g_array_index(extents, JBackendObjectExtent, g_array_index(order, guint, i - 1));
+
+		extent = &g_array_index(extents, JBackendObjectExtent, g_array_index(order, guint, i));
+
+		if (extent->offset < prev->offset + prev->length)
+		{
+			overlap = TRUE;
+			break;
+		}
+	}
+
+	if (overlap)
+	{
+		for (guint i = 0; i < order->len; i++)
+		{
+			g_array_index(order, guint, i) = i;
+		}
+	}
+
+	merged = g_array_sized_new(FALSE, FALSE, sizeof(JBackendObjectExtent), extents->len);
+	owners = g_array_sized_new(FALSE, FALSE, sizeof(guint), extents->len);
+
+	for (guint i = 0; i < order->len; i++)
+	{
+		guint owner;
+
+		extent = &g_array_index(extents, JBackendObjectExtent, g_array_index(order, guint, i));
+
+		// Extents from consecutive memory chunk segments can be merged without copying
+		if (last != NULL && last->offset + last->length == extent->offset && (gchar*)last->data + last->length == extent->data)
+		{
+			last->length += extent->length;
+		}
+		else
+		{
+			g_array_append_val(merged, *extent);
+			last = &g_array_index(merged, JBackendObjectExtent, merged->len - 1);
+			last->bytes = 0;
+		}
+
+		owner = merged->len - 1;
+		g_array_append_val(owners, owner);
+	}
+
+	for (guint i = 0; i < merged->len; i++)
+	{
+		cost += g_array_index(merged, JBackendObjectExtent, i).length;
+	}
+
+	if (checksums != NULL)
+	{
+		g_rw_lock_writer_lock(checksums->lock);
+	}
+
+	jd_scheduler_enter(client, JD_SCHEDULER_OBJECT, cost);
+	j_backend_object_writev(jd_object_backend, object, (JBackendObjectExtent*)(gpointer)merged->data, merged->len);
+	jd_scheduler_leave(client, JD_SCHEDULER_OBJECT, cost);
+
+	// Distribute the bytes written over the original extents
+	for (guint i = 0; i < order->len; i++)
+	{
+		JBackendObjectExtent* owner;
+
+		extent = &g_array_index(extents, JBackendObjectExtent, g_array_index(order, guint, i));
+		owner = &g_array_index(merged, JBackendObjectExtent, g_array_index(owners, guint, i));
+
+		extent->bytes = MIN(owner->bytes, extent->length);
+		owner->bytes -= extent->bytes;
+	}
+
+	if (checksums != NULL)
+	{
+		// Updating in arrival order makes the checksums of overlapping extents match the data written last
+		for (guint i = 0; i < extents->len; i++)
+		{
+			extent = &g_array_index(extents, JBackendObjectExtent, i);
+			jd_object_checksums_update(checksums, object, (extent->bytes == extent->length) ? extent->data : NULL, extent->length, extent->offset);
+		}
+
+		g_rw_lock_writer_unlock(checksums->lock);
+	}
+
+	for (guint i = 0; i < extents->len; i++)
+	{
+		extent = &g_array_index(extents, JBackendObjectExtent, i);
+
+		j_statistics_add(statistics, J_STATISTICS_BYTES_WRITTEN, extent->bytes);
+
+		if (reply != NULL)
+		{
+			j_message_add_operation(reply, sizeof(guint64));
+			j_message_append_8(reply, &(extent->bytes));
+		}
+	}
+
+	g_array_set_size(extents, 0);
+}
+
+/**
+ * Appends at most one page of key-value pairs to a reply.
+ * The page is terminated by a zero length, followed by a flag that tells the client whether more pairs are available.
+ * The client can continue the iteration by sending the last key it received as the start key.
+ *
+ * \private
+ *
+ * \param reply    A reply.
+ * \param iterator An iterator, NULL if the iteration could not be started.
+ * \param start    The key to continue after, empty to start at the beginning.
+ * \param limit    The maximum number of pairs, 0 for no limit.
+ **/
+static void
+jd_kv_iterate_page(JMessage* reply, gpointer iterator, gchar const* start, guint32 limit)
+{
+	gchar const* key;
+	gconstpointer value;
+	guint32 len;
+	guint32 count = 0;
+	guint32 zero = 0;
+	gchar more = 0;
+
+	// Continuing an iteration requires the backend to iterate in order
+	if (jd_kv_backend->kv.backend_seek == NULL)
+	{
+		limit = 0;
+	}
+
+	if (iterator == NULL)
+	{
+		goto end;
+	}
+
+	if (start[0] != '\0' && !j_backend_kv_seek(jd_kv_backend, iterator, start))
+	{
+		start = "";
+	}
+
+	while (j_backend_kv_iterate(jd_kv_backend, iterator, &key, &value, &len))
+	{
+		gsize key_len;
+
+		// The start key itself has already been sent as part of the previous page
+		if (start[0] != '\0' && g_strcmp0(key, start) == 0)
+		{
+			continue;
+		}
+
+		if (limit > 0 && count == limit)
+		{
+			more = 1;
+			j_backend_kv_iterator_free(jd_kv_backend, iterator);
+			break;
+		}
+
+		key_len = strlen(key) + 1;
+
+		j_message_add_operation(reply, 4 + len + key_len);
+		j_message_append_4(reply, &len);
+		j_message_append_n(reply, value, len);
+		j_message_append_string(reply, key);
+
+		count++;
+	}
+
+end:
+	j_message_add_operation(reply, 4 + 1);
+	j_message_append_4(reply, &zero);
+	j_message_append_1(reply, &more);
+}
+
+/**
+ * The number of seconds after which staged operations of unfinished transactions are discarded.
+ * This cleans up after clients that failed between staging and committing.
+ **/
+#define JD_TRANSACTION_TIMEOUT 600
+
+/**
+ * A key-value operation staged for a transaction.
+ **/
+struct JdTransactionOperation
+{
+	/**
+	 * J_MESSAGE_KV_PUT or J_MESSAGE_KV_DELETE.
+	 **/
+	JMessageType type;
+
+	gchar* namespace;
+	gchar* key;
+
+	/**
+	 * The value, NULL for deletes.
+	 **/
+	GBytes* value;
+
+	/**
+	 * The put's TTL in microseconds, 0 if the key does not expire.
+	 **/
+	GTimeSpan ttl;
+};
+
+typedef struct JdTransactionOperation JdTransactionOperation;
+
+/**
+ * A transaction's staged operations.
+ **/
+struct JdTransaction
+{
+	guint64 id;
+
+	/**
+	 * The staged operations in their original order.
+	 **/
+	GPtrArray* operations;
+
+	/**
+	 * The time of the last staged operation, used to expire abandoned transactions.
+	 **/
+	gint64 last_used;
+};
+
+typedef struct JdTransaction JdTransaction;
+
+/**
+ * The transactions with staged operations.
+ * Messages of one transaction can arrive on different connections, so the table is shared.
+ **/
+static struct
+{
+	GMutex mutex[1];
+
+	/**
+	 * Maps IDs to JdTransaction.
+	 **/
+	GHashTable* table;
+} jd_transactions;
+
+static void
+jd_transaction_operation_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdTransactionOperation* operation = data;
+
+	g_free(operation->namespace);
+	g_free(operation->key);
+
+	if (operation->value != NULL)
+	{
+		g_bytes_unref(operation->value);
+	}
+
+	g_slice_free(JdTransactionOperation, operation);
+}
+
+static void
+jd_transaction_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdTransaction* transaction = data;
+
+	g_ptr_array_unref(transaction->operations);
+
+	g_slice_free(JdTransaction, transaction);
+}
+
+/**
+ * Returns a transaction, creating it if necessary.
+ * Has to be called with the table's mutex held.
+ *
+ * \private
+ *
+ * \param id A transaction ID.
+ *
+ * \return The transaction.
+ **/
+static JdTransaction*
+jd_transaction_get(guint64 id)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdTransaction* transaction;
+	gint64 now;
+
+	now = g_get_monotonic_time();
+
+	if (G_UNLIKELY(jd_transactions.table == NULL))
+	{
+		jd_transactions.table = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, jd_transaction_free);
+	}
+
+	transaction = g_hash_table_lookup(jd_transactions.table, &id);
+
+	if (transaction == NULL)
+	{
+		GHashTableIter iter;
+		gpointer value;
+
+		// New transactions are rare compared to staged operations, so this is a good time to expire old ones.
+		g_hash_table_iter_init(&iter, jd_transactions.table);
+
+		while (g_hash_table_iter_next(&iter, NULL, &value))
+		{
+			JdTransaction* old = value;
+
+			if (now - old->last_used > JD_TRANSACTION_TIMEOUT * G_USEC_PER_SEC)
+			{
+				g_hash_table_iter_remove(&iter);
+			}
+		}
+
+		transaction = g_slice_new(JdTransaction);
+		transaction->id = id;
+		transaction->operations = g_ptr_array_new_with_free_func(jd_transaction_operation_free);
+
+		// The key points into the value, which lives as long as the entry.
+		g_hash_table_insert(jd_transactions.table, &(transaction->id), transaction);
+	}
+
+	transaction->last_used = now;
+
+	return transaction;
+}
+
+/**
+ * Stages a key-value operation for a transaction.
+ *
+ * \private
+ *
+ * \param id        A transaction ID.
+ * \param type      J_MESSAGE_KV_PUT or J_MESSAGE_KV_DELETE.
+ * \param namespace A namespace.
+ * \param key       A key.
+ * \param value     A value, NULL for deletes.
+ * \param len       The value's length.
+ * \param ttl       The put's TTL, 0 if the key does not expire.
+ **/
+static void
+jd_transaction_stage(guint64 id, JMessageType type, gchar const* namespace, gchar const* key, gconstpointer value, guint32 len, GTimeSpan ttl)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdTransaction* transaction;
+	JdTransactionOperation* operation;
+
+	operation = g_slice_new(JdTransactionOperation);
+	operation->type = type;
+	operation->namespace = g_strdup(namespace);
+	operation->key = g_strdup(key);
+	operation->value = (value != NULL) ? g_bytes_new(value, len) : NULL;
+	operation->ttl = ttl;
+
+	g_mutex_lock(jd_transactions.mutex);
+	transaction = jd_transaction_get(id);
+	g_ptr_array_add(transaction->operations, operation);
+	g_mutex_unlock(jd_transactions.mutex);
+}
+
+/**
+ * Looks up a key's staged value, so that a transaction reads its own modifications.
+ *
+ * \private
+ *
+ * \param id        A transaction ID.
+ * \param namespace A namespace.
+ * \param key       A key.
+ * \param value     Returns the staged value, NULL if the key has been deleted.
+ *
+ * \return TRUE if the transaction has staged an operation for the key, FALSE otherwise.
+ **/
+static gboolean
+jd_transaction_lookup(guint64 id, gchar const* namespace, gchar const* key, GBytes** value)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdTransaction* transaction = NULL;
+	gboolean ret = FALSE;
+
+	g_mutex_lock(jd_transactions.mutex);
+
+	if (jd_transactions.table != NULL)
+	{
+		transaction = g_hash_table_lookup(jd_transactions.table, &id);
+	}
+
+	// The latest operation wins.
+	for (guint i = (transaction != NULL) ? transaction->operations->len : 0; i > 0; i--)
+	{
+		JdTransactionOperation* operation = g_ptr_array_index(transaction->operations, i - 1);
+
+		if (g_strcmp0(operation->key, key) == 0 && g_strcmp0(operation->namespace, namespace) == 0)
+		{
+			*value = (operation->value != NULL) ? g_bytes_ref(operation->value) : NULL;
+			ret = TRUE;
+			break;
+		}
+	}
+
+	g_mutex_unlock(jd_transactions.mutex);
+
+	return ret;
+}
+
+/**
+ * Commits or aborts a transaction's staged operations.
+ * Consecutive operations of the same namespace are applied within one backend batch, which is aborted if any of them fails.
+ *
+ * \private
+ *
+ * \param id        A transaction ID.
+ * \param semantics The semantics to apply the operations with.
+ * \param commit    Whether to commit.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+jd_transaction_finish(guint64 id, JSemantics* semantics, gboolean commit)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdTransaction* transaction = NULL;
+	gboolean ret = TRUE;
+
+	g_mutex_lock(jd_transactions.mutex);
+
+	if (jd_transactions.table != NULL)
+	{
+		transaction = g_hash_table_lookup(jd_transactions.table, &id);
+
+		if (transaction != NULL)
+		{
+			g_hash_table_steal(jd_transactions.table, &id);
+		}
+	}
+
+	g_mutex_unlock(jd_transactions.mutex);
+
+	if (transaction == NULL)
+	{
+		// Expired transactions can not be committed anymore.
+		return !commit;
+	}
+
+	for (guint i = 0; commit && i < transaction->operations->len;)
+	{
+		JdTransactionOperation* first = g_ptr_array_index(transaction->operations, i);
+		JdKVExpiry* expiry;
+		JdKVBloom* bloom;
+		gpointer batch;
+		gboolean batch_ret = TRUE;
+
+		if (!j_backend_kv_batch_start(jd_kv_backend, first->namespace, semantics, &batch))
+		{
+			ret = FALSE;
+			break;
+		}
+
+		expiry = jd_kv_expiry_begin(first->namespace, semantics);
+		bloom = jd_kv_bloom_begin(first->namespace);
+
+		for (; i < transaction->operations->len; i++)
+		{
+			JdTransactionOperation* operation = g_ptr_array_index(transaction->operations, i);
+
+			if (g_strcmp0(operation->namespace, first->namespace) != 0)
+			{
+				break;
+			}
+
+			if (operation->type == J_MESSAGE_KV_PUT)
+			{
+				gconstpointer data;
+				gsize len;
+
+				data = g_bytes_get_data(operation->value, &len);
+				batch_ret = j_backend_kv_put(jd_kv_backend, batch, operation->key, data, len) && batch_ret;
+				jd_kv_expiry_set(expiry, operation->key, operation->ttl);
+				jd_kv_bloom_add(bloom, operation->key);
+			}
+			else
+			{
+				// Deleting a key that does not exist is not an error within a transaction.
+				j_backend_kv_delete(jd_kv_backend, batch, operation->key);
+			}
+		}
+
+		if (batch_ret)
+		{
+			batch_ret = j_backend_kv_batch_execute(jd_kv_backend, batch);
+		}
+		else
+		{
+			j_backend_kv_batch_abort(jd_kv_backend, batch);
+		}
+
+		jd_kv_expiry_end(expiry, batch_ret);
+		jd_kv_bloom_end(bloom);
+
+		ret = batch_ret && ret;
+	}
+
+	jd_transaction_free(transaction);
+
+	return ret;
+}
+
+/**
+ * Returns the duration between two points in time, clamped to the range of a JMessageTiming field.
+ *
+ * \private
+ *
+ * \param start The start (in microseconds).
+ * \param end   The end (in microseconds).
+ *
+ * \return The duration (in microseconds).
+ **/
+static guint32
+jd_duration(gint64 start, gint64 end)
+{
+	return CLAMP(end - start, 0, G_MAXUINT32);
+}
+
+/**
+ * Sends a reply and records when it was ready and when it had been sent.
+ * If the client asked for them, the server-side timings are echoed back in the reply.
+ *
+ * \private
+ *
+ * \param reply      A reply.
+ * \param connection A connection.
+ * \param times      The request's times.
+ **/
+static void
+jd_send_reply(JMessage* reply, GSocketConnection* connection, JdMessageTimes* times)
+{
+	JMessageTiming timing;
+
+	times->completed = g_get_monotonic_time();
+
+	timing.queue_time = jd_duration(times->ready, times->receive);
+	timing.receive_time = jd_duration(times->receive, times->received);
+	timing.service_time = jd_duration(times->dispatched, times->completed);
+	timing.reserved = 0;
+
+	j_message_set_timing(reply, &timing);
+	j_message_send(reply, connection);
+
+	times->sent = g_get_monotonic_time();
+}
+
+/**
+ * Handles an insert message with batch atomicity.
+ * Consecutive entries of the same schema are inserted at once, which allows backends to use multi-row statements.
+ *
+ * \private
+ *
+ * \param message         A message.
+ * \param connection      A connection.
+ * \param semantics       The message's semantics.
+ * \param operation_count The number of operations.
+ * \param times           The message's times.
+ **/
+static void
+jd_db_insert_multi(JMessage* message, GSocketConnection* connection, JSemantics* semantics, guint32 operation_count, JdMessageTimes* times)
+{
+	g_autoptr(JMessage) reply = NULL;
+	g_autofree gchar const** names = NULL;
+	g_autofree bson_t* metadata = NULL;
+	g_autofree bson_t const** metadata_ptrs = NULL;
+	g_autofree bson_t* ids = NULL;
+	g_autofree gboolean* inserted = NULL;
+	JBackendOperation backend_operation;
+	gchar const* namespace = NULL;
+	gpointer batch = NULL;
+	GError* error = NULL;
+
+	reply = j_message_new_reply(message);
+
+	names = g_new(gchar const*, operation_count);
+	metadata = g_new(bson_t, operation_count);
+	metadata_ptrs = g_new(bson_t const*, operation_count);
+	ids = g_new(bson_t, operation_count);
+	inserted = g_new0(gboolean, operation_count);
+
+	memcpy(&backend_operation, &j_backend_operation_db_insert, sizeof(JBackendOperation));
+
+	// The parameters point into the message, which stays valid until the reply has been sent
+	for (guint32 i = 0; i < operation_count; i++)
+	{
+		bson_t const* bson;
+
+		j_backend_operation_from_message_static(message, backend_operation.in_param, backend_operation.in_param_count);
+
+		if (i == 0)
+		{
+			namespace = backend_operation.in_param[0].ptr;
+		}
+
+		names[i] = backend_operation.in_param[1].ptr;
+		bson = backend_operation.in_param[2].ptr;
+
+		if (bson != NULL)
+		{
+			bson_init_static(&metadata[i], bson_get_data(bson), bson->len);
+		}
+		else
+		{
+			bson_init(&metadata[i]);
+		}
+
+		metadata_ptrs[i] = &metadata[i];
+		bson_init(&ids[i]);
+	}
+
+	j_backend_db_batch_start(jd_db_backend, namespace, semantics, &batch, &error);
+
+	for (guint32 i = 0; i < operation_count && error == NULL;)
+	{
+		guint32 count = 1;
+
+		while (i + count < operation_count && g_strcmp0(names[i], names[i + count]) == 0)
+		{
+			count++;
+		}
+
+		if (j_backend_db_insert_multi(jd_db_backend, batch, names[i], metadata_ptrs + i, count, ids + i, &error))
+		{
+			for (guint32 j = 0; j < count; j++)
+			{
+				inserted[i + j] = TRUE;
+			}
+		}
+
+		i += count;
+	}
+
+	for (guint32 i = 0; i < operation_count; i++)
+	{
+		backend_operation.out_param[0].ptr = &ids[i];
+		backend_operation.out_param[0].bson_initialized = inserted[i];
+		backend_operation.out_param[1].ptr = &backend_operation.out_param[1].error_ptr;
+		backend_operation.out_param[1].error_ptr = NULL;
+
+		// As with single inserts, all entries following a failed one report its error
+		if (!inserted[i] && error != NULL)
+		{
+			backend_operation.out_param[1].error_ptr = g_error_copy(error);
+		}
+
+		j_backend_operation_to_message(reply, backend_operation.out_param, backend_operation.out_param_count);
+
+		bson_destroy(&ids[i]);
+		bson_destroy(&metadata[i]);
+	}
+
+	j_backend_db_batch_execute(jd_db_backend, batch, NULL);
+
+	if (error != NULL)
+	{
+		g_error_free(error);
+	}
+
+	jd_send_reply(reply, connection, times);
+}
+
+/**
+ * Determines the free and total space of the file system containing the object backend's data.
+ * Both values are 0 if there is no object backend or its path does not refer to a file system.
+ *
+ * \private
+ *
+ * \param space_free  Returns the free space in bytes.
+ * \param space_total Returns the total space in bytes.
+ **/
+static void
+jd_object_storage_space(guint64* space_free, guint64* space_total)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_auto(GStrv) paths = NULL;
+
+	*space_free = 0;
+	*space_total = 0;
+
+	if (jd_object_backend == NULL || jd_object_path == NULL || jd_object_path[0] == '\0')
+	{
+		return;
+	}
+
+	// Striped backends have several paths separated by semicolons
+	paths = g_strsplit(jd_object_path, ";", 0);
+
+	for (guint i = 0; paths[i] != NULL; i++)
+	{
+		g_autoptr(GFile) file = NULL;
+		g_autoptr(GFileInfo) info = NULL;
+		g_auto(GStrv) split = NULL;
+
+		// Backend options are appended to the path, separated by colons
+		split = g_strsplit(paths[i], ":", 2);
+		file = g_file_new_for_path(split[0]);
+
+		if ((info = g_file_query_filesystem_info(file, G_FILE_ATTRIBUTE_FILESYSTEM_FREE "," G_FILE_ATTRIBUTE_FILESYSTEM_SIZE, NULL, NULL)) != NULL)
+		{
+			*space_free += g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE);
+			*space_total += g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
+		}
+	}
+}
+
+gboolean
+jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk* memory_chunk, guint64 memory_chunk_size, JStatistics* statistics, JdObjectHandles* handles, JdSchedulerClient* client, JdMessageTimes* times)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gchar const* key;
+	gchar const* namespace;
+	gchar const* path;
+	guint32 operation_count;
+	JBackendOperation backend_operation;
+	g_autoptr(JSemantics) semantics = NULL;
+	JSemanticsSafety safety;
+	gboolean message_matched = FALSE;
+	guint i;
+	JMessageType message_type;
+	JdSchedulerClass scheduler_class = JD_SCHEDULER_CLASSES;
+	gint64 start_time;
+	guint64 start_bytes;
+
+	operation_count = j_message_get_count(message);
+	semantics = j_message_get_semantics(message);
+	safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
+
+	message_type = j_message_get_type(message);
+	start_time = g_get_monotonic_time();
+	start_bytes = j_statistics_get(statistics, J_STATISTICS_BYTES_READ) + j_statistics_get(statistics, J_STATISTICS_BYTES_WRITTEN);
+
+	// Object data is scheduled per backend call, since only then its size is known.
+	if (message_type >= J_MESSAGE_KV_PUT && message_type <= J_MESSAGE_KV_GET_BY_PREFIX)
+	{
+		scheduler_class = JD_SCHEDULER_KV;
+	}
+	else if (message_type >= J_MESSAGE_DB_SCHEMA_CREATE && message_type <= J_MESSAGE_DB_AGGREGATE)
+	{
+		scheduler_class = JD_SCHEDULER_DB;
+	}
+	else if (message_type == J_MESSAGE_KV_COMPARE_AND_SWAP || message_type == J_MESSAGE_KV_ADD || message_type == J_MESSAGE_KV_GET_RANGE || message_type == J_MESSAGE_KV_DELETE_PREFIX || message_type == J_MESSAGE_KV_BLOOM_FILTER || message_type == J_MESSAGE_KV_REPLICATE)
+	{
+		scheduler_class = JD_SCHEDULER_KV;
+	}
+	else if (message_type == J_MESSAGE_DB_ADVISE_INDEXES || message_type == J_MESSAGE_DB_REPLICATE)
+	{
+		scheduler_class = JD_SCHEDULER_DB;
+	}
+
+	if (scheduler_class != JD_SCHEDULER_CLASSES)
+	{
+		jd_scheduler_enter(client, scheduler_class, operation_count);
+	}
+
+	times->dispatched = g_get_monotonic_time();
+	times->completed = 0;
+	times->sent = 0;
+
+	switch (j_message_get_type(message))
+	{
+		case J_MESSAGE_NONE:
+			break;
+		case J_MESSAGE_OBJECT_CREATE:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			gpointer object;
+
+			if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+			{
+				reply = j_message_new_reply(message);
+			}
+
+			namespace = j_message_get_string(message);
+
+			for (i = 0; i < operation_count; i++)
+			{
+				guint64 size;
+
+				path = j_message_get_string(message);
+				size = j_message_get_8(message);
+
+				jd_object_reclaim_now(namespace, path);
+
+				if (j_backend_object_create(jd_object_backend, namespace, path, &object))
+				{
+					j_statistics_add(statistics, J_STATISTICS_FILES_CREATED, 1);
+
+					if (size > 0)
+					{
+						j_backend_object_preallocate(jd_object_backend, object, size);
+					}
+
+					if (safety == J_SEMANTICS_SAFETY_STORAGE)
+					{
+						jd_sync_object(object);
+						j_statistics_add(statistics, J_STATISTICS_SYNC, 1);
+					}
+
+					j_backend_object_close(jd_object_backend, object);
+				}
+
+				if (reply != NULL)
+				{
+					j_message_add_operation(reply, 0);
+				}
+			}
+
+			if (reply != NULL)
+			{
+				jd_send_reply(reply, connection, times);
+			}
+		}
+		break;
+		case J_MESSAGE_OBJECT_DELETE:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			gpointer object;
+
+			if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+			{
+				reply = j_message_new_reply(message);
+			}
+
+			namespace = j_message_get_string(message);
+
+			for (i = 0; i < operation_count; i++)
+			{
+				guint32 status = 0;
+
+				path = j_message_get_string(message);
+
+				// Logged writes must not bring the object back during replay, so the deletion has to be durable before the object is touched
+				if (jd_object_wal_enabled())
+				{
+					JdObjectWal* wal;
+					gboolean logged;
+
+					wal = jd_object_wal_begin();
+					logged = jd_object_wal_delete(wal, namespace, path);
+					logged = jd_object_wal_end(wal) && logged;
+
+					if (!logged)
+					{
+						if (reply != NULL)
+						{
+							j_message_add_operation(reply, sizeof(status));
+							j_message_append_4(reply, &status);
+						}
+
+						continue;
+					}
+				}
+
+				if (jd_object_checksums_enabled)
+				{
+					jd_object_checksums_delete(namespace, path);
+				}
+
+				if (jd_object_dedup_enabled)
+				{
+					jd_object_dedup_delete(namespace, path);
+				}
+
+				if (jd_object_reclaim_enabled())
+				{
+					// The object is hidden before the connections drop it, so it cannot be opened again in between
+					if (jd_object_reclaim_defer(namespace, path))
+					{
+						status = 1;
+						j_statistics_add(statistics, J_STATISTICS_FILES_DELETED, 1);
+					}
+					else if (jd_object_lazy_create_allowed(message))
+					{
+						// Parts that have never been written do not exist
+						status = 1;
+					}
+
+					g_atomic_int_inc(&jd_object_generation);
+				}
+				else
+				{
+					// Make all connections drop the object
+					g_atomic_int_inc(&jd_object_generation);
+
+					if (j_backend_object_open(jd_object_backend, namespace, path, &object))
+					{
+						if (j_backend_object_delete(jd_object_backend, object))
+						{
+							status = 1;
+							j_statistics_add(statistics, J_STATISTICS_FILES_DELETED, 1);
+						}
+					}
+					else if (jd_object_lazy_create_allowed(message))
+					{
+						// Parts that have never been written do not exist
+						status = 1;
+					}
+				}
+
+				if (reply != NULL)
+				{
+					j_message_add_operation(reply, sizeof(status));
+					j_message_append_4(reply, &status);
+				}
+			}
+
+			if (reply != NULL)
+			{
+				jd_send_reply(reply, connection, times);
+			}
+		}
+		break;
+		case J_MESSAGE_OBJECT_DELETE_PREFIX:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			g_autoptr(GPtrArray) names = NULL;
+			gchar const* prefix;
+			gpointer iterator;
+			guint64 count = 0;
+
+			reply = j_message_new_reply(message);
+			namespace = j_message_get_string(message);
+			prefix = j_message_get_string(message);
+
+			names = g_ptr_array_new_with_free_func(g_free);
+
+			// The names are collected first, since deleting objects would invalidate the iterator.
+			if (j_backend_object_get_by_prefix(jd_object_backend, namespace, prefix, &iterator))
+			{
+				while (j_backend_object_iterate(jd_object_backend, iterator, &key))
+				{
+					g_ptr_array_add(names, g_strdup(key));
+				}
+			}
+
+			// Logged writes must not bring the objects back during replay, so the deletions have to be durable before the objects are touched
+			if (names->len > 0 && jd_object_wal_enabled())
+			{
+				JdObjectWal* wal;
+				gboolean logged = TRUE;
+
+				wal = jd_object_wal_begin();
+
+				for (i = 0; i < names->len && logged; i++)
+				{
+					logged = jd_object_wal_delete(wal, namespace, g_ptr_array_index(names, i));
+				}
+
+				logged = jd_object_wal_end(wal) && logged;
+
+				if (!logged)
+				{
+					g_ptr_array_set_size(names, 0);
+				}
+			}
+
+			for (i = 0; i < names->len && jd_object_checksums_enabled; i++)
+			{
+				jd_object_checksums_delete(namespace, g_ptr_array_index(names, i));
+			}
+
+			for (i = 0; i < names->len && jd_object_dedup_enabled; i++)
+			{
+				jd_object_dedup_delete(namespace, g_ptr_array_index(names, i));
+			}
+
+			if (jd_object_reclaim_enabled())
+			{
+				for (i = 0; i < names->len; i++)
+				{
+					if (jd_object_reclaim_defer(namespace, g_ptr_array_index(names, i)))
+					{
+						count++;
+					}
+				}
+			}
+
+			// Make all connections drop the objects
+			g_atomic_int_inc(&jd_object_generation);
+
+			for (i = 0; i < names->len && !jd_object_reclaim_enabled(); i++)
+			{
+				gpointer object;
+
+				if (j_backend_object_open(jd_object_backend, namespace, g_ptr_array_index(names, i), &object)
+				    && j_backend_object_delete(jd_object_backend, object))
+				{
+					count++;
+				}
+			}
+
+			j_statistics_add(statistics, J_STATISTICS_FILES_DELETED, count);
+
+			j_message_add_operation(reply, sizeof(count));
+			j_message_append_8(reply, &count);
+
+			jd_send_reply(reply, connection, times);
+		}
+		break;
+		case J_MESSAGE_OBJECT_DISCARD:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			JdObjectChecksums checksums_buffer;
+			JdObjectChecksums* checksums = NULL;
+			gpointer object;
+			gboolean opened;
+
+			if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+			{
+				reply = j_message_new_reply(message);
+			}
+
+			namespace = j_message_get_string(message);
+			path = j_message_get_string(message);
+
+			opened = !jd_object_reclaim_pending(namespace, path) && j_backend_object_open(jd_object_backend, namespace, path, &object);
+
+			if (opened)
+			{
+				checksums = jd_object_checksums_open(handles, &checksums_buffer, namespace, path, FALSE);
+			}
+
+			for (i = 0; i < operation_count; i++)
+			{
+				guint32 status = 0;
+				guint64 length;
+				guint64 offset;
+
+				length = j_message_get_8(message);
+				offset = j_message_get_8(message);
+
+				// Logged writes must not bring discarded data back during replay, so the discard has to be durable before the object is touched
+				if (opened && jd_object_wal_enabled())
+				{
+					JdObjectWal* wal;
+					gboolean logged;
+
+					wal = jd_object_wal_begin();
+					logged = jd_object_wal_discard(wal, namespace, path, length, offset);
+					logged = jd_object_wal_end(wal) && logged;
+
+					if (!logged)
+					{
+						if (reply != NULL)
+						{
+							j_message_add_operation(reply, sizeof(status));
+							j_message_append_4(reply, &status);
+						}
+
+						continue;
+					}
+				}
+
+				if (checksums != NULL)
+				{
+					g_rw_lock_writer_lock(checksums->lock);
+				}
+
+				if (opened && j_backend_object_discard(jd_object_backend, object, length, offset))
+				{
+					status = 1;
+				}
+
+				if (checksums != NULL)
+				{
+					jd_object_checksums_update(checksums, object, NULL, length, offset);
+					g_rw_lock_writer_unlock(checksums->lock);
+				}
+
+				if (opened && jd_object_dedup_enabled)
+				{
+					jd_object_dedup_release(namespace, path, length, offset);
+				}
+
+				if (reply != NULL)
+				{
+					j_message_add_operation(reply, sizeof(status));
+					j_message_append_4(reply, &status);
+				}
+			}
+
+			if (opened)
+			{
+				if (safety == J_SEMANTICS_SAFETY_STORAGE)
+				{
+					jd_sync_object(object);
+					j_statistics_add(statistics, J_STATISTICS_SYNC, 1);
+				}
+
+				j_backend_object_close(jd_object_backend, object);
+			}
+
+			if (reply != NULL)
+			{
+				jd_send_reply(reply, connection, times);
+			}
+		}
+		break;
+		case J_MESSAGE_OBJECT_ADVISE:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			gpointer object;
+
+			if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+			{
+				reply = j_message_new_reply(message);
+			}
+
+			namespace = j_message_get_string(message);
+			path = j_message_get_string(message);
+
+			// Advice about the access pattern has to apply to the handle used for reading
+			object = jd_object_handles_open(handles, namespace, path);
+
+			for (i = 0; i < operation_count; i++)
+			{
+				guint32 status = 0;
+				guint32 advice;
+				guint64 length;
+				guint64 offset;
+
+				advice = j_message_get_4(message);
+				length = j_message_get_8(message);
+				offset = j_message_get_8(message);
+
+				if (object != NULL && j_backend_object_advise(jd_object_backend, object, advice, length, offset))
+				{
+					status = 1;
+				}
+
+				if (reply != NULL)
+				{
+					j_message_add_operation(reply, sizeof(status));
+					j_message_append_4(reply, &status);
+				}
+			}
+
+			if (reply != NULL)
+			{
+				jd_send_reply(reply, connection, times);
+			}
+		}
+		break;
+		case J_MESSAGE_OBJECT_CLONE:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			gpointer object;
+			gboolean opened;
+
+			if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+			{
+				reply = j_message_new_reply(message);
+			}
+
+			namespace = j_message_get_string(message);
+			path = j_message_get_string(message);
+
+			opened = !jd_object_reclaim_pending(namespace, path) && j_backend_object_open(jd_object_backend, namespace, path, &object);
+
+			for (i = 0; i < operation_count; i++)
+			{
+				gchar const* clone_namespace;
+				gchar const* clone_path;
+				gpointer clone;
+				/**
+				 * 0 if cloning failed, 1 if the object has been cloned
+				 * and 2 if the object does not exist, in which case the clone has been removed.
+				 * The latter is not an error for distributed objects, whose parts are created lazily.
+				 **/
+				guint32 status = 0;
+
+				clone_namespace = j_message_get_string(message);
+				clone_path = j_message_get_string(message);
+
+				jd_object_reclaim_now(clone_namespace, clone_path);
+
+				// The clone replaces existing data, so all connections have to drop it
+				g_atomic_int_inc(&jd_object_generation);
+
+				if (j_backend_object_open(jd_object_backend, clone_namespace, clone_path, &clone))
+				{
+					j_backend_object_delete(jd_object_backend, clone);
+				}
+
+				if (jd_object_checksums_enabled)
+				{
+					jd_object_checksums_delete(clone_namespace, clone_path);
+				}
+
+				// The clone does not reference the object's deduplicated blocks, its data is shared by cloning
+				if (jd_object_dedup_enabled)
+				{
+					jd_object_dedup_delete(clone_namespace, clone_path);
+				}
+
+				if (!opened)
+				{
+					status = 2;
+				}
+				else if (j_backend_object_create(jd_object_backend, clone_namespace, clone_path, &clone))
+				{
+					j_statistics_add(statistics, J_STATISTICS_FILES_CREATED, 1);
+
+					if (j_backend_object_clone(jd_object_backend, object, clone))
+					{
+						status = 1;
+					}
+
+					if (jd_object_checksums_enabled)
+					{
+						jd_object_checksums_clone(namespace, path, clone_namespace, clone_path);
+					}
+
+					if (safety == J_SEMANTICS_SAFETY_STORAGE)
+					{
+						jd_sync_object(clone);
+						j_statistics_add(statistics, J_STATISTICS_SYNC, 1);
+					}
+
+					j_backend_object_close(jd_object_backend, clone);
+				}
+
+				if (reply != NULL)
+				{
+					j_message_add_operation(reply, sizeof(status));
+					j_message_append_4(reply, &status);
+				}
+			}
+
+			if (opened)
+			{
+				j_backend_object_close(jd_object_backend, object);
+			}
+
+			if (reply != NULL)
+			{
+				jd_send_reply(reply, connection, times);
+			}
+		}
+		break;
+		case J_MESSAGE_OBJECT_GET_ALL:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			gpointer iterator;
+			gchar const* empty = "";
+
+			reply = j_message_new_reply(message);
+			namespace = j_message_get_string(message);
+
+			if (j_backend_object_get_all(jd_object_backend, namespace, &iterator))
+			{
+				while (j_backend_object_iterate(jd_object_backend, iterator, &key))
+				{
+					gsize key_len;
+
+					// Deleted objects are hidden until they have been reclaimed
+					if (jd_object_reclaim_pending(namespace, key))
+					{
+						continue;
+					}
+
+					key_len = strlen(key) + 1;
+
+					j_message_add_operation(reply, key_len);
+					j_message_append_string(reply, key);
+				}
+			}
+
+			j_message_add_operation(reply, 1);
+			j_message_append_string(reply, empty);
+
+			jd_send_reply(reply, connection, times);
+		}
+		break;
+		case J_MESSAGE_OBJECT_LIST:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			gchar const* prefix;
+			gpointer iterator;
+			gboolean ret;
+			gchar const* empty = "";
+			guint8 more;
+			guint count = 0;
+
+			reply = j_message_new_reply(message);
+			namespace = j_message_get_string(message);
+			prefix = j_message_get_string(message);
+
+			if (prefix[0] == '\0')
+			{
+				ret = j_backend_object_get_all(jd_object_backend, namespace, &iterator);
+			}
+			else
+			{
+				ret = j_backend_object_get_by_prefix(jd_object_backend, namespace, prefix, &iterator);
+			}
+
+			if (ret)
+			{
+				gint64 modification_time;
+				guint64 size;
+
+				while (j_backend_object_iterate_status(jd_object_backend, namespace, iterator, &key, &modification_time, &size))
+				{
+					gsize key_len;
+
+					// Deleted objects are hidden until they have been reclaimed
+					if (jd_object_reclaim_pending(namespace, key))
+					{
+						continue;
+					}
+
+					if (count == JD_OBJECT_LIST_BATCH)
+					{
+						more = 1;
+
+						j_message_add_operation(reply, 1 + 1);
+						j_message_append_string(reply, empty);
+						j_message_append_1(reply, &more);
+
+						jd_send_reply(reply, connection, times);
+						j_message_unref(reply);
+
+						reply = j_message_new_reply(message);
+						count = 0;
+					}
+
+					key_len = strlen(key) + 1;
+
+					j_message_add_operation(reply, key_len + 8 + 8);
+					j_message_append_string(reply, key);
+					j_message_append_8(reply, &modification_time);
+					j_message_append_8(reply, &size);
+
+					count++;
+				}
+			}
+
+			more = 0;
+
+			j_message_add_operation(reply, 1 + 1);
+			j_message_append_string(reply, empty);
+			j_message_append_1(reply, &more);
+
+			jd_send_reply(reply, connection, times);
+		}
+		break;
+		case J_MESSAGE_OBJECT_GET_BY_PREFIX:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			gchar const* prefix;
+			gpointer iterator;
+			gchar const* empty = "";
+
+			reply = j_message_new_reply(message);
+			namespace = j_message_get_string(message);
+			prefix = j_message_get_string(message);
+
+			if (j_backend_object_get_by_prefix(jd_object_backend, namespace, prefix, &iterator))
+			{
+				while (j_backend_object_iterate(jd_object_backend, iterator, &key))
+				{
+					gsize key_len;
+
+					// Deleted objects are hidden until they have been reclaimed
+					if (jd_object_reclaim_pending(namespace, key))
+					{
+						continue;
+					}
+
+					key_len = strlen(key) + 1;
+
+					j_message_add_operation(reply, key_len);
+					j_message_append_string(reply, key);
+				}
+			}
+
+			j_message_add_operation(reply, 1);
+			j_message_append_string(reply, empty);
+
+			jd_send_reply(reply, connection, times);
+		}
+		break;
+		case J_MESSAGE_OBJECT_READ:
+		{
+			JMessage* reply;
+			g_autoptr(GArray) extents = NULL;
+			g_autoptr(GArray) checked = NULL;
+			JdObjectChecksums checksums_buffer;
+			JdObjectChecksums* checksums = NULL;
+			gpointer object;
+			gint fd = -1;
+
+			namespace = j_message_get_string(message);
+			path = j_message_get_string(message);
+
+			reply = j_message_new_reply(message);
+			extents = g_array_sized_new(FALSE, FALSE, sizeof(JBackendObjectExtent), operation_count);
+			checked = g_array_sized_new(FALSE, FALSE, sizeof(gboolean), operation_count);
+
+			// FIXME return value
+			object = jd_object_handles_open(handles, namespace, path);
+
+			if (object != NULL)
+			{
+				checksums = jd_object_checksums_open(handles, &checksums_buffer, namespace, path, FALSE);
+			}
+
+			// Data sent directly from the file cannot be verified
+			if (object == NULL || checksums != NULL || !j_backend_object_get_fd(jd_object_backend, object, &fd))
+			{
+				fd = -1;
+			}
+
+			for (i = 0; i < operation_count; i++)
+			{
+				JBackendObjectExtent extent;
+				gboolean checksum;
+				guint64 length;
+				guint64 offset;
+
+				length = j_message_get_8(message);
+				offset = j_message_get_8(message);
+
+				checksum = ((length & J_MESSAGE_LENGTH_CHECKSUM) != 0);
+				length &= ~J_MESSAGE_LENGTH_CHECKSUM;
+
+				// Large reads are sent from the page cache without copying them into the memory chunk
+				if (fd != -1 && !checksum && length >= JD_OBJECT_ZERO_COPY_MIN)
+				{
+					extent.data = NULL;
+					extent.length = length;
+					extent.offset = offset;
+					extent.bytes = 0;
+
+					g_array_append_val(extents, extent);
+					g_array_append_val(checked, checksum);
+					continue;
+				}
+
+				if (length > memory_chunk_size)
+				{
+					guint64 bytes_read = 0;
+					guint32 crc = 0;
+
+					// Keep the replies in order
+					jd_object_read_flush(object, extents, checked, fd, checksums, reply, statistics, client);
+
+					// FIXME return proper error
+					j_message_add_operation(reply, sizeof(guint64) + ((checksum) ? sizeof(guint32) : 0));
+					j_message_append_8(reply, &bytes_read);
+
+					if (checksum)
+					{
+						j_message_append_4(reply, &crc);
+					}
+
+					continue;
+				}
+
+				extent.data = j_memory_chunk_get(memory_chunk, length);
+
+				if (extent.data == NULL)
+				{
+					jd_object_read_flush(object, extents, checked, fd, checksums, reply, statistics, client);
+
+					// FIXME ugly
+					jd_send_reply(reply, connection, times);
+					j_message_unref(reply);
+
+					reply = j_message_new_reply(message);
+
+					j_memory_chunk_reset(memory_chunk);
+					extent.data = j_memory_chunk_get(memory_chunk, length);
+				}
+
+				extent.length = length;
+				extent.offset = offset;
+				extent.bytes = 0;
+
+				g_array_append_val(extents, extent);
+				g_array_append_val(checked, checksum);
+			}
+
+			jd_object_read_flush(object, extents, checked, fd, checksums, reply, statistics, client);
+
+			jd_send_reply(reply, connection, times);
+			j_message_unref(reply);
+
+			j_memory_chunk_reset(memory_chunk);
+		}
+		break;
+		case J_MESSAGE_OBJECT_REDUCE:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			gpointer object;
+			gchar* buffer;
+			guint64 buffer_size;
+
+			namespace = j_message_get_string(message);
+			path = j_message_get_string(message);
+
+			reply = j_message_new_reply(message);
+
+			// The data is only read into the memory chunk, a buffer consisting of whole elements is reused for all chunks
+			buffer_size = memory_chunk_size - (memory_chunk_size % sizeof(guint64));
+			buffer = j_memory_chunk_get(memory_chunk, buffer_size);
+
+			object = jd_object_handles_open(handles, namespace, path);
+
+			for (i = 0; i < operation_count; i++)
+			{
+				g_autoptr(JReduce) reduce = NULL;
+				guint32 status;
+				guint64 length;
+				guint64 offset;
+
+				reduce = j_reduce_new_from_message(message);
+				length = j_message_get_8(message);
+				offset = j_message_get_8(message);
+
+				// With lazy creation, parts that have not been written yet are empty
+				status = ((object != NULL || jd_object_lazy_create_allowed(message)) && reduce != NULL && buffer != NULL);
+
+				while (status && object != NULL && length > 0)
+				{
+					guint64 bytes_read = 0;
+					guint64 chunk_length;
+
+					chunk_length = MIN(length, buffer_size);
+
+					jd_scheduler_enter(client, JD_SCHEDULER_OBJECT, chunk_length);
+					status = j_backend_object_read(jd_object_backend, object, buffer, chunk_length, offset, &bytes_read);
+					jd_scheduler_leave(client, JD_SCHEDULER_OBJECT, chunk_length);
+
+					j_statistics_add(statistics, J_STATISTICS_BYTES_READ, bytes_read);
+					j_reduce_process(reduce, buffer, bytes_read);
+
+					// The end of the object has been reached
+					if (bytes_read < chunk_length)
+					{
+						break;
+					}
+
+					length -= chunk_length;
+					offset += chunk_length;
+				}
+
+				j_message_add_operation(reply, sizeof(status) + ((status) ? j_reduce_get_result_size(reduce) : 0));
+				j_message_append_4(reply, &status);
+
+				if (status)
+				{
+					j_reduce_append_result(reduce, reply);
+				}
+			}
+
+			jd_send_reply(reply, connection, times);
+
+			j_memory_chunk_reset(memory_chunk);
+		}
+		break;
+		case J_MESSAGE_OBJECT_WRITE:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			g_autoptr(GArray) extents = NULL;
+			JdObjectChecksums checksums_buffer;
+			JdObjectChecksums* checksums = NULL;
+			JdObjectWal* wal = NULL;
+			gpointer object;
+			gboolean disjoint;
+			gint fd = -1;
+
+			if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+			{
+				reply = j_message_new_reply(message);
+			}
+
+			namespace = j_message_get_string(message);
+			path = j_message_get_string(message);
+
+			extents = g_array_sized_new(FALSE, FALSE, sizeof(JBackendObjectExtent), operation_count);
+			disjoint = (j_semantics_get(semantics, J_SEMANTICS_CONCURRENCY) == J_SEMANTICS_CONCURRENCY_NON_OVERLAPPING);
+
+			// FIXME return value
+			object = jd_object_handles_open(handles, namespace, path);
+
+			if (object == NULL && jd_object_lazy_create_allowed(message))
+			{
+				gpointer new_object;
+
+				// Another connection might create the object concurrently, so it is opened again in any case
+				jd_object_reclaim_now(namespace, path);
+
+				if (j_backend_object_create(jd_object_backend, namespace, path, &new_object))
+				{
+					j_statistics_add(statistics, J_STATISTICS_FILES_CREATED, 1);
+					j_backend_object_close(jd_object_backend, new_object);
+				}
+
+				object = jd_object_handles_open(handles, namespace, path);
+			}
+
+			if (object != NULL)
+			{
+				checksums = jd_object_checksums_open(handles, &checksums_buffer, namespace, path, TRUE);
+			}
+
+			// Durable writes are logged and acknowledged as soon as the log has been synced
+			if (object != NULL && safety == J_SEMANTICS_SAFETY_STORAGE && jd_object_wal_enabled())
+			{
+				wal = jd_object_wal_begin();
+			}
+
+			// Data moved directly to the file cannot be verified, checksummed or logged
+			if (object == NULL || checksums != NULL || wal != NULL || !j_backend_object_get_fd(jd_object_backend, object, &fd))
+			{
+				fd = -1;
+			}
+
+			for (i = 0; i < operation_count; i++)
+			{
+				JBackendObjectExtent extent;
+				gboolean checksum;
+				gboolean dedup;
+				guint8 hash[J_CHECKSUM_DIGEST_SIZE];
+				guint32 crc = 0;
+				guint64 length;
+				guint64 offset;
+
+				length = j_message_get_8(message);
+				offset = j_message_get_8(message);
+
+				checksum = ((length & J_MESSAGE_LENGTH_CHECKSUM) != 0);
+				dedup = ((length & J_MESSAGE_LENGTH_DEDUP) != 0);
+				length &= ~(J_MESSAGE_LENGTH_CHECKSUM | J_MESSAGE_LENGTH_DEDUP);
+
+				if (checksum)
+				{
+					crc = j_message_get_4(message);
+				}
+
+				if (dedup)
+				{
+					memcpy(hash, j_message_get_n(message, sizeof(hash)), sizeof(hash));
+				}
+
+				// Large writes are moved from the socket to the file without copying them into the memory chunk
+				if (fd != -1 && !checksum && !dedup && length >= JD_OBJECT_ZERO_COPY_MIN)
+				{
+					guint64 bytes_written = 0;
+
+					// Keep the writes and replies in order
+					jd_object_write_flush(object, extents, disjoint, checksums, reply, statistics, client);
+					j_memory_chunk_reset(memory_chunk);
+
+					// FIXME return value
+					jd_scheduler_enter(client, JD_SCHEDULER_OBJECT, length);
+					j_message_receive_file(message, connection, fd, offset, length, &bytes_written);
+					jd_scheduler_leave(client, JD_SCHEDULER_OBJECT, length);
+					j_statistics_add(statistics, J_STATISTICS_BYTES_RECEIVED, length);
+					j_statistics_add(statistics, J_STATISTICS_BYTES_WRITTEN, bytes_written);
+					j_backend_object_written(jd_object_backend, object, bytes_written, offset);
+
+					if (jd_object_dedup_enabled)
+					{
+						jd_object_dedup_release(namespace, path, length, offset);
+					}
+
+					if (reply != NULL)
+					{
+						j_message_add_operation(reply, sizeof(guint64));
+						j_message_append_8(reply, &bytes_written);
+					}
+
+					continue;
+				}
+
+				if (length > memory_chunk_size)
+				{
+					guint64 bytes_written = 0;
+
+					// Keep the replies in order
+					jd_object_write_flush(object, extents, disjoint, checksums, reply, statistics, client);
+
+					// FIXME return proper error
+					j_message_add_operation(reply, sizeof(guint64));
+					j_message_append_8(reply, &bytes_written);
+					continue;
+				}
+
+				extent.data = j_memory_chunk_get(memory_chunk, length);
+
+				if (extent.data == NULL)
+				{
+					// Write the extents received so far to make room for this one
+					jd_object_write_flush(object, extents, disjoint, checksums, reply, statistics, client);
+
+					j_memory_chunk_reset(memory_chunk);
+					extent.data = j_memory_chunk_get(memory_chunk, length);
+				}
+
+				g_assert(extent.data != NULL);
+
+				// Also handles data that was part of a compressed message
+				j_message_add_receive(message, extent.data, length);
+				j_message_receive_data(message, connection);
+				j_statistics_add(statistics, J_STATISTICS_BYTES_RECEIVED, length);
+
+				// Data corrupted in transit is not written
+				if (checksum && j_checksum_crc32c(0, extent.data, length) != crc)
+				{
+					guint64 bytes_written = 0;
+
+					g_warning("Checksum mismatch while writing %" G_GUINT64_FORMAT " bytes.", length);
+
+					jd_object_write_flush(object, extents, disjoint, checksums, reply, statistics, client);
+
+					if (reply != NULL)
+					{
+						j_message_add_operation(reply, sizeof(guint64));
+						j_message_append_8(reply, &bytes_written);
+					}
+
+					continue;
+				}
+
+				if (object != NULL && jd_object_dedup_enabled)
+				{
+					gboolean referenced = FALSE;
+
+					// New blocks are stored for later writes, the extent is written as usual
+					if (dedup && length == J_MESSAGE_DEDUP_BLOCK_SIZE && offset % J_MESSAGE_DEDUP_BLOCK_SIZE == 0)
+					{
+						guint8 data_hash[J_CHECKSUM_DIGEST_SIZE];
+
+						j_checksum_digest(extent.data, length, data_hash);
+
+						if (memcmp(data_hash, hash, sizeof(hash)) == 0)
+						{
+							referenced = jd_object_dedup_reference(namespace, path, object, hash, extent.data, offset);
+						}
+						else
+						{
+							g_warning("Hash mismatch while writing deduplicated block at offset %" G_GUINT64_FORMAT ".", offset);
+						}
+					}
+
+					if (!referenced)
+					{
+						jd_object_dedup_release(namespace, path, length, offset);
+					}
+				}
 
-static guint jd_thread_num = 0;
+				// The backend is synced instead if the log cannot be written
+				if (wal != NULL && !jd_object_wal_append(wal, namespace, path, extent.data, length, offset))
+				{
+					jd_object_wal_end(wal);
+					wal = NULL;
+				}
 
-gboolean
-jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk* memory_chunk, guint64 memory_chunk_size, JStatistics* statistics)
-{
-	J_TRACE_FUNCTION(NULL);
+				extent.length = length;
+				extent.offset = offset;
+				extent.bytes = 0;
 
-	gchar const* key;
-	gchar const* namespace;
-	gchar const* path;
-	guint32 operation_count;
-	JBackendOperation backend_operation;
-	g_autoptr(JSemantics) semantics = NULL;
-	JSemanticsSafety safety;
-	gboolean message_matched = FALSE;
-	guint i;
+				g_array_append_val(extents, extent);
+			}
 
-	operation_count = j_message_get_count(message);
-	semantics = j_message_get_semantics(message);
-	safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
+			jd_object_write_flush(object, extents, disjoint, checksums, reply, statistics, client);
 
-	switch (j_message_get_type(message))
-	{
-		case J_MESSAGE_NONE:
-			break;
-		case J_MESSAGE_OBJECT_CREATE:
+			if (safety == J_SEMANTICS_SAFETY_STORAGE)
+			{
+				if (wal == NULL || !jd_object_wal_end(wal))
+				{
+					jd_sync_object(object);
+				}
+
+				j_statistics_add(statistics, J_STATISTICS_SYNC, 1);
+			}
+
+			if (reply != NULL)
+			{
+				jd_send_reply(reply, connection, times);
+			}
+
+			j_memory_chunk_reset(memory_chunk);
+		}
+		break;
+		case J_MESSAGE_OBJECT_APPEND:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			JdObjectChecksums checksums_buffer;
+			JdObjectChecksums* checksums = NULL;
+			GMutex* mutex;
+			gpointer object;
+
+			// Appends always reply, since only the server knows where the data ended up
+			reply = j_message_new_reply(message);
+
+			namespace = j_message_get_string(message);
+			path = j_message_get_string(message);
+
+			mutex = &(jd_object_append_mutex[(g_str_hash(namespace) ^ g_str_hash(path)) % JD_OBJECT_APPEND_LOCKS]);
+			object = jd_object_handles_open(handles, namespace, path);
+
+			if (object == NULL && jd_object_lazy_create_allowed(message))
+			{
+				gpointer new_object;
+
+				jd_object_reclaim_now(namespace, path);
+
+				if (j_backend_object_create(jd_object_backend, namespace, path, &new_object))
+				{
+					j_statistics_add(statistics, J_STATISTICS_FILES_CREATED, 1);
+					j_backend_object_close(jd_object_backend, new_object);
+				}
+
+				object = jd_object_handles_open(handles, namespace, path);
+			}
+
+			if (object != NULL)
+			{
+				checksums = jd_object_checksums_open(handles, &checksums_buffer, namespace, path, TRUE);
+			}
+
+			for (i = 0; i < operation_count; i++)
+			{
+				g_autofree gpointer buffer = NULL;
+				gpointer data = NULL;
+				guint64 length;
+				guint64 counter;
+				guint64 offset = 0;
+				guint64 bytes_written = 0;
+
+				length = j_message_get_8(message);
+				counter = j_message_get_8(message);
+
+				if (counter == J_MESSAGE_APPEND_END)
+				{
+					// The data has to be received even if the object does not exist
+					if (length > memory_chunk_size)
+					{
+						data = buffer = g_malloc(length);
+					}
+					else
+					{
+						j_memory_chunk_reset(memory_chunk);
+						data = j_memory_chunk_get(memory_chunk, length);
+					}
+
+					j_message_add_receive(message, data, length);
+					j_message_receive_data(message, connection);
+					j_statistics_add(statistics, J_STATISTICS_BYTES_RECEIVED, length);
+				}
+
+				if (object != NULL)
+				{
+					jd_scheduler_enter(client, JD_SCHEDULER_OBJECT, length);
+					g_mutex_lock(mutex);
+
+					if (checksums != NULL)
+					{
+						g_rw_lock_writer_lock(checksums->lock);
+					}
+
+					if (counter == J_MESSAGE_APPEND_END)
+					{
+						gint64 modification_time;
+
+						if (j_backend_object_status(jd_object_backend, object, &modification_time, &offset))
+						{
+							j_backend_object_write(jd_object_backend, object, data, length, offset, &bytes_written);
+						}
+					}
+					else
+					{
+						guint64 value = 0;
+						guint64 bytes = 0;
+
+						// Counters that have never been advanced start at zero
+						if (j_backend_object_read(jd_object_backend, object, &value, sizeof(value), counter, &bytes))
+						{
+							offset = (bytes == sizeof(value)) ? GUINT64_FROM_LE(value) : 0;
+							value = GUINT64_TO_LE(offset + length);
+
+							if (j_backend_object_write(jd_object_backend, object, &value, sizeof(value), counter, &bytes) && bytes == sizeof(value))
+							{
+								bytes_written = length;
+							}
+						}
+					}
+
+					if (checksums != NULL)
+					{
+						if (counter == J_MESSAGE_APPEND_END)
+						{
+							jd_object_checksums_update(checksums, object, (bytes_written == length) ? data : NULL, bytes_written, offset);
+						}
+						else
+						{
+							jd_object_checksums_update(checksums, object, NULL, sizeof(guint64), counter);
+						}
+
+						g_rw_lock_writer_unlock(checksums->lock);
+					}
+
+					if (jd_object_dedup_enabled)
+					{
+						if (counter == J_MESSAGE_APPEND_END)
+						{
+							jd_object_dedup_release(namespace, path, bytes_written, offset);
+						}
+						else
+						{
+							jd_object_dedup_release(namespace, path, sizeof(guint64), counter);
+						}
+					}
+
+					g_mutex_unlock(mutex);
+					jd_scheduler_leave(client, JD_SCHEDULER_OBJECT, length);
+
+					if (counter == J_MESSAGE_APPEND_END)
+					{
+						j_statistics_add(statistics, J_STATISTICS_BYTES_WRITTEN, bytes_written);
+					}
+				}
+
+				j_message_add_operation(reply, sizeof(guint64) + sizeof(guint64));
+				j_message_append_8(reply, &offset);
+				j_message_append_8(reply, &bytes_written);
+			}
+
+			if (object != NULL && safety == J_SEMANTICS_SAFETY_STORAGE)
+			{
+				jd_sync_object(object);
+				j_statistics_add(statistics, J_STATISTICS_SYNC, 1);
+			}
+
+			jd_send_reply(reply, connection, times);
+
+			j_memory_chunk_reset(memory_chunk);
+		}
+		break;
+		case J_MESSAGE_OBJECT_DEDUP:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			JdObjectChecksums checksums_buffer;
+			JdObjectChecksums* checksums = NULL;
+			gpointer object;
+
+			// Deduplication always replies, since the client has to send the blocks that are not stored
+			reply = j_message_new_reply(message);
+
+			namespace = j_message_get_string(message);
+			path = j_message_get_string(message);
+
+			object = jd_object_handles_open(handles, namespace, path);
+
+			if (object == NULL && jd_object_lazy_create_allowed(message))
+			{
+				gpointer new_object;
+
+				jd_object_reclaim_now(namespace, path);
+
+				if (j_backend_object_create(jd_object_backend, namespace, path, &new_object))
+				{
+					j_statistics_add(statistics, J_STATISTICS_FILES_CREATED, 1);
+					j_backend_object_close(jd_object_backend, new_object);
+				}
+
+				object = jd_object_handles_open(handles, namespace, path);
+			}
+
+			if (object != NULL)
+			{
+				checksums = jd_object_checksums_open(handles, &checksums_buffer, namespace, path, TRUE);
+			}
+
+			for (i = 0; i < operation_count; i++)
+			{
+				guint8 const* hash;
+				guint64 offset;
+				guint64 bytes_written = 0;
+
+				hash = j_message_get_n(message, J_CHECKSUM_DIGEST_SIZE);
+				offset = j_message_get_8(message);
+
+				if (object != NULL && jd_object_dedup_enabled && offset % J_MESSAGE_DEDUP_BLOCK_SIZE == 0)
+				{
+					jd_scheduler_enter(client, JD_SCHEDULER_OBJECT, J_MESSAGE_DEDUP_BLOCK_SIZE);
+
+					if (checksums != NULL)
+					{
+						g_rw_lock_writer_lock(checksums->lock);
+					}
+
+					if (jd_object_dedup_reference(namespace, path, object, hash, NULL, offset))
+					{
+						bytes_written = J_MESSAGE_DEDUP_BLOCK_SIZE;
+					}
+
+					if (checksums != NULL)
+					{
+						if (bytes_written > 0)
+						{
+							jd_object_checksums_update(checksums, object, NULL, bytes_written, offset);
+						}
+
+						g_rw_lock_writer_unlock(checksums->lock);
+					}
+
+					jd_scheduler_leave(client, JD_SCHEDULER_OBJECT, J_MESSAGE_DEDUP_BLOCK_SIZE);
+					j_statistics_add(statistics, J_STATISTICS_BYTES_WRITTEN, bytes_written);
+				}
+
+				j_message_add_operation(reply, sizeof(guint64));
+				j_message_append_8(reply, &bytes_written);
+			}
+
+			if (object != NULL && safety == J_SEMANTICS_SAFETY_STORAGE)
+			{
+				jd_sync_object(object);
+				j_statistics_add(statistics, J_STATISTICS_SYNC, 1);
+			}
+
+			jd_send_reply(reply, connection, times);
+		}
+		break;
+		case J_MESSAGE_OBJECT_STATUS:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			gpointer object;
+
+			reply = j_message_new_reply(message);
+
+			namespace = j_message_get_string(message);
+
+			for (i = 0; i < operation_count; i++)
+			{
+				gint64 modification_time = 0;
+				guint64 size = 0;
+
+				path = j_message_get_string(message);
+				object = jd_object_handles_open(handles, namespace, path);
+
+				if (object != NULL && j_backend_object_status(jd_object_backend, object, &modification_time, &size))
+				{
+					j_statistics_add(statistics, J_STATISTICS_FILES_STATED, 1);
+				}
+
+				j_message_add_operation(reply, sizeof(gint64) + sizeof(guint64));
+				j_message_append_8(reply, &modification_time);
+				j_message_append_8(reply, &size);
+			}
+
+			jd_send_reply(reply, connection, times);
+		}
+		break;
+		case J_MESSAGE_OBJECT_SYNC:
 		{
 			g_autoptr(JMessage) reply = NULL;
 			gpointer object;
@@ -67,593 +2653,816 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			{
 				path = j_message_get_string(message);
 
-				if (j_backend_object_create(jd_object_backend, namespace, path, &object))
-				{
-					j_statistics_add(statistics, J_STATISTICS_FILES_CREATED, 1);
+				if ((object = jd_object_handles_open(handles, namespace, path)) != NULL)
+				{
+					jd_sync_object(object);
+					j_statistics_add(statistics, J_STATISTICS_SYNC, 1);
+				}
+
+				if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+				{
+					j_message_add_operation(reply, 0);
+				}
+			}
+
+			if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+			{
+				jd_send_reply(reply, connection, times);
+			}
+		}
+		break;
+		case J_MESSAGE_STATISTICS:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			JStatistics* r_statistics;
+			gchar get_all;
+			guint64 value;
+
+			get_all = j_message_get_1(message);
+			r_statistics = (get_all == 0) ? statistics : jd_statistics_get_all();
+
+			reply = j_message_new_reply(message);
+			j_message_add_operation(reply, (11 + 7 * J_STATISTICS_MESSAGE_TYPES) * sizeof(guint64));
+
+			value = j_statistics_get(r_statistics, J_STATISTICS_FILES_CREATED);
+			j_message_append_8(reply, &value);
+			value = j_statistics_get(r_statistics, J_STATISTICS_FILES_DELETED);
+			j_message_append_8(reply, &value);
+			value = j_statistics_get(r_statistics, J_STATISTICS_FILES_STATED);
+			j_message_append_8(reply, &value);
+			value = j_statistics_get(r_statistics, J_STATISTICS_SYNC);
+			j_message_append_8(reply, &value);
+			value = j_statistics_get(r_statistics, J_STATISTICS_BYTES_READ);
+			j_message_append_8(reply, &value);
+			value = j_statistics_get(r_statistics, J_STATISTICS_BYTES_WRITTEN);
+			j_message_append_8(reply, &value);
+			value = j_statistics_get(r_statistics, J_STATISTICS_BYTES_RECEIVED);
+			j_message_append_8(reply, &value);
+			value = j_statistics_get(r_statistics, J_STATISTICS_BYTES_SENT);
+			j_message_append_8(reply, &value);
+
+			// Appended after the original counters, so older clients can still parse the reply.
+			value = j_statistics_get(r_statistics, J_STATISTICS_CONNECTIONS);
+			j_message_append_8(reply, &value);
+
+			for (guint t = 0; t < J_STATISTICS_MESSAGE_TYPES; t++)
+			{
+				value = j_statistics_get_message(r_statistics, t, J_STATISTICS_MESSAGE_REQUESTS);
+				j_message_append_8(reply, &value);
+				value = j_statistics_get_message(r_statistics, t, J_STATISTICS_MESSAGE_BYTES);
+				j_message_append_8(reply, &value);
+				value = j_statistics_get_message(r_statistics, t, J_STATISTICS_MESSAGE_TIME);
+				j_message_append_8(reply, &value);
+			}
 
-					if (safety == J_SEMANTICS_SAFETY_STORAGE)
-					{
-						j_backend_object_sync(jd_object_backend, object);
-						j_statistics_add(statistics, J_STATISTICS_SYNC, 1);
-					}
+			// The phases of the request time, appended after the original counters.
+			for (guint t = 0; t < J_STATISTICS_MESSAGE_TYPES; t++)
+			{
+				value = j_statistics_get_message(r_statistics, t, J_STATISTICS_MESSAGE_QUEUE_TIME);
+				j_message_append_8(reply, &value);
+				value = j_statistics_get_message(r_statistics, t, J_STATISTICS_MESSAGE_RECEIVE_TIME);
+				j_message_append_8(reply, &value);
+				value = j_statistics_get_message(r_statistics, t, J_STATISTICS_MESSAGE_SERVICE_TIME);
+				j_message_append_8(reply, &value);
+				value = j_statistics_get_message(r_statistics, t, J_STATISTICS_MESSAGE_REPLY_TIME);
+				j_message_append_8(reply, &value);
+			}
 
-					j_backend_object_close(jd_object_backend, object);
-				}
+			// The object storage's free and total space, used by J_DISTRIBUTION_ADAPTIVE.
+			{
+				guint64 space_free = 0;
+				guint64 space_total = 0;
 
-				if (reply != NULL)
-				{
-					j_message_add_operation(reply, 0);
-				}
+				jd_object_storage_space(&space_free, &space_total);
+				j_message_append_8(reply, &space_free);
+				j_message_append_8(reply, &space_total);
 			}
 
-			if (reply != NULL)
+			if (get_all != 0)
 			{
-				j_message_send(reply, connection);
+				j_statistics_free(r_statistics);
 			}
+
+			jd_send_reply(reply, connection, times);
 		}
 		break;
-		case J_MESSAGE_OBJECT_DELETE:
+		case J_MESSAGE_PING:
 		{
 			g_autoptr(JMessage) reply = NULL;
-			gpointer object;
+			g_autofree gchar* compression = NULL;
+			gboolean compact = FALSE;
+			guint num;
 
-			if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
-			{
-				reply = j_message_new_reply(message);
-			}
+			num = g_atomic_int_add(&jd_thread_num, 1);
 
-			namespace = j_message_get_string(message);
+			(void)num;
+			//g_message("HELLO %d", num);
 
 			for (i = 0; i < operation_count; i++)
 			{
-				guint32 status = 0;
+				gchar const* request;
 
-				path = j_message_get_string(message);
+				request = j_message_get_string(message);
 
-				if (j_backend_object_open(jd_object_backend, namespace, path, &object)
-				    && j_backend_object_delete(jd_object_backend, object))
+				if (g_str_has_prefix(request, "compression:") && j_message_compression_supported(request + strlen("compression:")))
 				{
-					status = 1;
-					j_statistics_add(statistics, J_STATISTICS_FILES_DELETED, 1);
+					g_free(compression);
+					compression = g_strdup(request);
 				}
-
-				if (reply != NULL)
+				else if (g_strcmp0(request, "compact") == 0)
 				{
-					j_message_add_operation(reply, sizeof(status));
-					j_message_append_4(reply, &status);
+					compact = TRUE;
 				}
 			}
 
-			if (reply != NULL)
+			reply = j_message_new_reply(message);
+
+			if (jd_object_backend != NULL)
 			{
-				j_message_send(reply, connection);
+				j_message_add_operation(reply, 7);
+				j_message_append_string(reply, "object");
 			}
-		}
-		break;
-		case J_MESSAGE_OBJECT_GET_ALL:
-		{
-			g_autoptr(JMessage) reply = NULL;
-			gpointer iterator;
-			gchar const* empty = "";
 
-			reply = j_message_new_reply(message);
-			namespace = j_message_get_string(message);
+			if (jd_kv_backend != NULL)
+			{
+				j_message_add_operation(reply, 3);
+				j_message_append_string(reply, "kv");
+			}
 
-			if (j_backend_object_get_all(jd_object_backend, namespace, &iterator))
+			if (jd_db_backend != NULL)
 			{
-				while (j_backend_object_iterate(jd_object_backend, iterator, &key))
-				{
-					gsize key_len;
+				j_message_add_operation(reply, 3);
+				j_message_append_string(reply, "db");
+			}
 
-					key_len = strlen(key) + 1;
+			if (compression != NULL)
+			{
+				j_message_add_operation(reply, strlen(compression) + 1);
+				j_message_append_string(reply, compression);
+			}
 
-					j_message_add_operation(reply, key_len);
-					j_message_append_string(reply, key);
-				}
+			// Compactly encoded requests are always decoded, so they only have to be confirmed
+			if (compact)
+			{
+				j_message_add_operation(reply, 8);
+				j_message_append_string(reply, "compact");
 			}
 
-			j_message_add_operation(reply, 1);
-			j_message_append_string(reply, empty);
+			jd_send_reply(reply, connection, times);
 
-			j_message_send(reply, connection);
+			// Only enable compression after the reply, the client does the same.
+			if (compression != NULL)
+			{
+				j_message_set_compression(connection, compression + strlen("compression:"));
+			}
 		}
 		break;
-		case J_MESSAGE_OBJECT_GET_BY_PREFIX:
+		case J_MESSAGE_KV_PUT:
 		{
 			g_autoptr(JMessage) reply = NULL;
-			gchar const* prefix;
-			gpointer iterator;
-			gchar const* empty = "";
-
-			reply = j_message_new_reply(message);
+			g_autoptr(GPtrArray) buffers = NULL;
+			JdKVExpiry* expiry = NULL;
+			JdKVBloom* bloom = NULL;
+			gpointer batch = NULL;
+			guint64 transaction_id = 0;
+			gboolean atomic;
+			gboolean batch_ret = TRUE;
+
+			atomic = (j_semantics_get(semantics, J_SEMANTICS_ATOMICITY) == J_SEMANTICS_ATOMICITY_BATCH);
 			namespace = j_message_get_string(message);
-			prefix = j_message_get_string(message);
 
-			if (j_backend_object_get_by_prefix(jd_object_backend, namespace, prefix, &iterator))
+			if (atomic)
 			{
-				while (j_backend_object_iterate(jd_object_backend, iterator, &key))
-				{
-					gsize key_len;
-
-					key_len = strlen(key) + 1;
-
-					j_message_add_operation(reply, key_len);
-					j_message_append_string(reply, key);
-				}
+				transaction_id = j_message_get_8(message);
 			}
 
-			j_message_add_operation(reply, 1);
-			j_message_append_string(reply, empty);
-
-			j_message_send(reply, connection);
-		}
-		break;
-		case J_MESSAGE_OBJECT_READ:
-		{
-			JMessage* reply;
-			gpointer object;
-
-			namespace = j_message_get_string(message);
-			path = j_message_get_string(message);
-
-			reply = j_message_new_reply(message);
+			// The replies to staged operations are the votes of a transaction.
+			if (transaction_id != 0 || safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+			{
+				reply = j_message_new_reply(message);
+			}
 
-			// FIXME return value
-			j_backend_object_open(jd_object_backend, namespace, path, &object);
+			if (transaction_id == 0)
+			{
+				j_backend_kv_batch_start(jd_kv_backend, namespace, semantics, &batch);
+				expiry = jd_kv_expiry_begin(namespace, semantics);
+				bloom = jd_kv_bloom_begin(namespace);
+			}
 
 			for (i = 0; i < operation_count; i++)
 			{
-				gchar* buf;
-				guint64 length;
-				guint64 offset;
-				guint64 bytes_read = 0;
+				gconstpointer data;
+				GTimeSpan ttl = 0;
+				guint32 len;
+				gboolean ret = TRUE;
 
-				length = j_message_get_8(message);
-				offset = j_message_get_8(message);
+				key = j_message_get_string(message);
+				len = j_message_get_4(message);
 
-				if (length > memory_chunk_size)
+				if (len & J_MESSAGE_LENGTH_EXPIRY)
 				{
-					// FIXME return proper error
-					j_message_add_operation(reply, sizeof(guint64));
-					j_message_append_8(reply, &bytes_read);
-					continue;
+					len &= ~J_MESSAGE_LENGTH_EXPIRY;
+					ttl = j_message_get_8(message);
 				}
 
-				buf = j_memory_chunk_get(memory_chunk, length);
-
-				if (buf == NULL)
+				if (len & J_MESSAGE_LENGTH_DEFERRED)
 				{
-					// FIXME ugly
-					j_message_send(reply, connection);
-					j_message_unref(reply);
+					gpointer buffer;
 
-					reply = j_message_new_reply(message);
+					// Large values follow the message, receive them directly into their final buffer.
+					len &= ~J_MESSAGE_LENGTH_DEFERRED;
 
-					j_memory_chunk_reset(memory_chunk);
-					buf = j_memory_chunk_get(memory_chunk, length);
-				}
+					if ((buffer = j_memory_chunk_get(memory_chunk, len)) == NULL)
+					{
+						if (buffers == NULL)
+						{
+							buffers = g_ptr_array_new_with_free_func(g_free);
+						}
 
-				j_backend_object_read(jd_object_backend, object, buf, length, offset, &bytes_read);
-				j_statistics_add(statistics, J_STATISTICS_BYTES_READ, bytes_read);
+						buffer = g_malloc(len);
+						g_ptr_array_add(buffers, buffer);
+					}
 
-				j_message_add_operation(reply, sizeof(guint64));
-				j_message_append_8(reply, &bytes_read);
+					j_message_add_receive(message, buffer, len);
+					ret = j_message_receive_data(message, connection);
+					data = buffer;
+				}
+				else
+				{
+					data = j_message_get_n(message, len);
+				}
 
-				if (bytes_read > 0)
+				if (!ret)
+				{
+					batch_ret = FALSE;
+				}
+				else if (transaction_id != 0)
+				{
+					jd_transaction_stage(transaction_id, J_MESSAGE_KV_PUT, namespace, key, data, len, ttl);
+				}
+				else
 				{
-					j_message_add_send(reply, buf, bytes_read);
+					ret = j_backend_kv_put(jd_kv_backend, batch, key, data, len);
+					batch_ret = ret && batch_ret;
+					jd_kv_expiry_set(expiry, key, ttl);
+					jd_kv_bloom_add(bloom, key);
 				}
 
-				j_statistics_add(statistics, J_STATISTICS_BYTES_SENT, bytes_read);
+				if (reply != NULL)
+				{
+					guint32 dummy;
+
+					dummy = (ret) ? 1 : 0;
+					j_message_add_operation(reply, 4);
+					j_message_append_4(reply, &dummy);
+				}
 			}
 
-			j_backend_object_close(jd_object_backend, object);
+			if (transaction_id == 0)
+			{
+				// Batch atomicity discards all of the message's operations if one of them fails.
+				if (atomic && !batch_ret)
+				{
+					j_backend_kv_batch_abort(jd_kv_backend, batch);
+					jd_kv_expiry_end(expiry, FALSE);
+				}
+				else
+				{
+					jd_kv_expiry_end(expiry, j_backend_kv_batch_execute(jd_kv_backend, batch));
+				}
 
-			j_message_send(reply, connection);
-			j_message_unref(reply);
+				jd_kv_bloom_end(bloom);
+			}
 
+			// The backend is done with the values now.
 			j_memory_chunk_reset(memory_chunk);
+
+			if (reply != NULL)
+			{
+				jd_send_reply(reply, connection, times);
+			}
 		}
 		break;
-		case J_MESSAGE_OBJECT_WRITE:
+		case J_MESSAGE_KV_DELETE:
 		{
 			g_autoptr(JMessage) reply = NULL;
-			gpointer object;
+			gpointer batch = NULL;
+			guint64 transaction_id = 0;
+			gboolean atomic;
+			gboolean batch_ret = TRUE;
 
-			if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+			atomic = (j_semantics_get(semantics, J_SEMANTICS_ATOMICITY) == J_SEMANTICS_ATOMICITY_BATCH);
+			namespace = j_message_get_string(message);
+
+			if (atomic)
 			{
-				reply = j_message_new_reply(message);
+				transaction_id = j_message_get_8(message);
 			}
 
-			namespace = j_message_get_string(message);
-			path = j_message_get_string(message);
+			if (transaction_id != 0 || safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+			{
+				reply = j_message_new_reply(message);
+			}
 
-			// FIXME return value
-			j_backend_object_open(jd_object_backend, namespace, path, &object);
+			if (transaction_id == 0)
+			{
+				j_backend_kv_batch_start(jd_kv_backend, namespace, semantics, &batch);
+			}
 
 			for (i = 0; i < operation_count; i++)
 			{
-				GInputStream* input;
-				gchar* buf;
-				guint64 length;
-				guint64 offset;
-				guint64 bytes_written = 0;
+				gboolean ret = TRUE;
 
-				length = j_message_get_8(message);
-				offset = j_message_get_8(message);
+				key = j_message_get_string(message);
 
-				if (length > memory_chunk_size)
+				if (transaction_id != 0)
 				{
-					// FIXME return proper error
-					j_message_add_operation(reply, sizeof(guint64));
-					j_message_append_8(reply, &bytes_written);
-					continue;
+					jd_transaction_stage(transaction_id, J_MESSAGE_KV_DELETE, namespace, key, NULL, 0, 0);
+				}
+				else
+				{
+					ret = j_backend_kv_delete(jd_kv_backend, batch, key);
+					batch_ret = ret && batch_ret;
 				}
-
-				// Guaranteed to work because memory_chunk is reset below
-				buf = j_memory_chunk_get(memory_chunk, length);
-				g_assert(buf != NULL);
-
-				input = g_io_stream_get_input_stream(G_IO_STREAM(connection));
-				g_input_stream_read_all(input, buf, length, NULL, NULL, NULL);
-				j_statistics_add(statistics, J_STATISTICS_BYTES_RECEIVED, length);
-
-				j_backend_object_write(jd_object_backend, object, buf, length, offset, &bytes_written);
-				j_statistics_add(statistics, J_STATISTICS_BYTES_WRITTEN, bytes_written);
 
 				if (reply != NULL)
 				{
-					j_message_add_operation(reply, sizeof(guint64));
-					j_message_append_8(reply, &bytes_written);
-				}
+					guint32 dummy;
 
-				j_memory_chunk_reset(memory_chunk);
+					dummy = (ret) ? 1 : 0;
+					j_message_add_operation(reply, 4);
+					j_message_append_4(reply, &dummy);
+				}
 			}
 
-			if (safety == J_SEMANTICS_SAFETY_STORAGE)
+			if (transaction_id == 0)
 			{
-				j_backend_object_sync(jd_object_backend, object);
-				j_statistics_add(statistics, J_STATISTICS_SYNC, 1);
+				// Batch atomicity discards all of the message's operations if one of them fails.
+				if (atomic && !batch_ret)
+				{
+					j_backend_kv_batch_abort(jd_kv_backend, batch);
+				}
+				else
+				{
+					j_backend_kv_batch_execute(jd_kv_backend, batch);
+				}
 			}
 
-			j_backend_object_close(jd_object_backend, object);
-
 			if (reply != NULL)
 			{
-				j_message_send(reply, connection);
+				jd_send_reply(reply, connection, times);
 			}
-
-			j_memory_chunk_reset(memory_chunk);
 		}
 		break;
-		case J_MESSAGE_OBJECT_STATUS:
+		case J_MESSAGE_KV_DELETE_PREFIX:
 		{
 			g_autoptr(JMessage) reply = NULL;
-			gpointer object;
+			g_autoptr(GPtrArray) keys = NULL;
+			gchar const* prefix;
+			gpointer batch = NULL;
+			gpointer iterator;
+			guint64 count = 0;
 
 			reply = j_message_new_reply(message);
-
 			namespace = j_message_get_string(message);
+			prefix = j_message_get_string(message);
 
-			for (i = 0; i < operation_count; i++)
-			{
-				gint64 modification_time = 0;
-				guint64 size = 0;
-
-				path = j_message_get_string(message);
+			keys = g_ptr_array_new_with_free_func(g_free);
 
-				// FIXME return value
-				j_backend_object_open(jd_object_backend, namespace, path, &object);
+			// The keys are collected first, since deleting them would invalidate the iterator.
+			if (j_backend_kv_get_by_prefix(jd_kv_backend, namespace, prefix, &iterator))
+			{
+				gconstpointer value;
+				guint32 len;
 
-				if (j_backend_object_status(jd_object_backend, object, &modification_time, &size))
+				while (j_backend_kv_iterate(jd_kv_backend, iterator, &key, &value, &len))
 				{
-					j_statistics_add(statistics, J_STATISTICS_FILES_STATED, 1);
+					g_ptr_array_add(keys, g_strdup(key));
 				}
+			}
 
-				j_message_add_operation(reply, sizeof(gint64) + sizeof(guint64));
-				j_message_append_8(reply, &modification_time);
-				j_message_append_8(reply, &size);
+			// All keys are deleted within one backend batch.
+			if (keys->len > 0 && j_backend_kv_batch_start(jd_kv_backend, namespace, semantics, &batch))
+			{
+				for (i = 0; i < keys->len; i++)
+				{
+					if (j_backend_kv_delete(jd_kv_backend, batch, g_ptr_array_index(keys, i)))
+					{
+						count++;
+					}
+				}
 
-				j_backend_object_close(jd_object_backend, object);
+				if (!j_backend_kv_batch_execute(jd_kv_backend, batch))
+				{
+					count = 0;
+				}
 			}
 
-			j_message_send(reply, connection);
+			j_message_add_operation(reply, sizeof(count));
+			j_message_append_8(reply, &count);
+
+			jd_send_reply(reply, connection, times);
 		}
 		break;
-		case J_MESSAGE_OBJECT_SYNC:
+		case J_MESSAGE_KV_GET:
 		{
 			g_autoptr(JMessage) reply = NULL;
-			gpointer object;
+			g_autofree gchar const** keys = NULL;
+			g_autofree gpointer* values = NULL;
+			g_autofree guint32* lens = NULL;
+			gpointer batch;
 
-			if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+			guint64 transaction_id = 0;
+
+			reply = j_message_new_reply(message);
+			namespace = j_message_get_string(message);
+
+			if (j_semantics_get(semantics, J_SEMANTICS_ATOMICITY) == J_SEMANTICS_ATOMICITY_BATCH)
 			{
-				reply = j_message_new_reply(message);
+				transaction_id = j_message_get_8(message);
 			}
 
-			namespace = j_message_get_string(message);
+			j_backend_kv_batch_start(jd_kv_backend, namespace, semantics, &batch);
+
+			keys = g_new(gchar const*, operation_count);
+			values = g_new0(gpointer, operation_count);
+			lens = g_new0(guint32, operation_count);
 
 			for (i = 0; i < operation_count; i++)
 			{
-				path = j_message_get_string(message);
+				keys[i] = j_message_get_string(message);
+			}
 
-				if (j_backend_object_open(jd_object_backend, namespace, path, &object))
+			// Resolve all keys at once so backends can use a single lookup
+			if (!j_backend_kv_get_multi(jd_kv_backend, batch, keys, operation_count, values, lens))
+			{
+				// Partial results are not trustworthy, report all keys as not found
+				for (i = 0; i < operation_count; i++)
 				{
-					j_backend_object_sync(jd_object_backend, object);
-					j_statistics_add(statistics, J_STATISTICS_SYNC, 1);
-					j_backend_object_close(jd_object_backend, object);
+					g_clear_pointer(&values[i], g_free);
+					lens[i] = 0;
 				}
 
-				if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+				transaction_id = 0;
+			}
+
+			// A transaction reads its own staged modifications.
+			for (i = 0; transaction_id != 0 && i < operation_count; i++)
+			{
+				GBytes* staged = NULL;
+
+				if (jd_transaction_lookup(transaction_id, namespace, keys[i], &staged))
 				{
-					j_message_add_operation(reply, 0);
+					g_free(values[i]);
+					values[i] = NULL;
+					lens[i] = 0;
+
+					if (staged != NULL)
+					{
+						gsize len;
+
+						values[i] = g_bytes_unref_to_data(staged, &len);
+						lens[i] = len;
+					}
 				}
 			}
 
-			if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+			for (i = 0; i < operation_count; i++)
 			{
-				j_message_send(reply, connection);
+				if (values[i] != NULL)
+				{
+					j_message_add_operation(reply, 4 + lens[i]);
+					j_message_append_4(reply, &lens[i]);
+					j_message_append_n(reply, values[i], lens[i]);
+
+					g_free(values[i]);
+				}
+				else
+				{
+					guint32 zero = 0;
+
+					j_message_add_operation(reply, 4);
+					j_message_append_4(reply, &zero);
+				}
 			}
+
+			j_backend_kv_batch_execute(jd_kv_backend, batch);
+
+			jd_send_reply(reply, connection, times);
 		}
 		break;
-		case J_MESSAGE_STATISTICS:
+		case J_MESSAGE_TRANSACTION_COMMIT:
+		case J_MESSAGE_TRANSACTION_ABORT:
 		{
 			g_autoptr(JMessage) reply = NULL;
-			JStatistics* r_statistics;
-			gchar get_all;
-			guint64 value;
+			guint64 transaction_id;
+			guint32 ret;
 
-			get_all = j_message_get_1(message);
-			r_statistics = (get_all == 0) ? statistics : jd_statistics;
+			reply = j_message_new_reply(message);
+			transaction_id = j_message_get_8(message);
 
-			if (get_all != 0)
-			{
-				g_mutex_lock(jd_statistics_mutex);
-				/* FIXME add statistics of all threads */
-			}
+			ret = (jd_transaction_finish(transaction_id, semantics, j_message_get_type(message) == J_MESSAGE_TRANSACTION_COMMIT)) ? 1 : 0;
 
-			reply = j_message_new_reply(message);
-			j_message_add_operation(reply, 8 * sizeof(guint64));
+			j_message_add_operation(reply, 4);
+			j_message_append_4(reply, &ret);
+			jd_send_reply(reply, connection, times);
+		}
+		break;
+		case J_MESSAGE_KV_GET_ALL:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			gchar const* start;
+			gpointer iterator = NULL;
+			guint32 limit;
 
-			value = j_statistics_get(r_statistics, J_STATISTICS_FILES_CREATED);
-			j_message_append_8(reply, &value);
-			value = j_statistics_get(r_statistics, J_STATISTICS_FILES_DELETED);
-			j_message_append_8(reply, &value);
-			value = j_statistics_get(r_statistics, J_STATISTICS_FILES_STATED);
-			j_message_append_8(reply, &value);
-			value = j_statistics_get(r_statistics, J_STATISTICS_SYNC);
-			j_message_append_8(reply, &value);
-			value = j_statistics_get(r_statistics, J_STATISTICS_BYTES_READ);
-			j_message_append_8(reply, &value);
-			value = j_statistics_get(r_statistics, J_STATISTICS_BYTES_WRITTEN);
-			j_message_append_8(reply, &value);
-			value = j_statistics_get(r_statistics, J_STATISTICS_BYTES_RECEIVED);
-			j_message_append_8(reply, &value);
-			value = j_statistics_get(r_statistics, J_STATISTICS_BYTES_SENT);
-			j_message_append_8(reply, &value);
+			reply = j_message_new_reply(message);
+			namespace = j_message_get_string(message);
+			start = j_message_get_string(message);
+			limit = j_message_get_4(message);
 
-			if (get_all != 0)
+			if (!j_backend_kv_get_all(jd_kv_backend, namespace, &iterator))
 			{
-				g_mutex_unlock(jd_statistics_mutex);
+				iterator = NULL;
 			}
 
-			j_message_send(reply, connection);
+			jd_kv_iterate_page(reply, iterator, start, limit);
+
+			jd_send_reply(reply, connection, times);
 		}
 		break;
-		case J_MESSAGE_PING:
+		case J_MESSAGE_KV_GET_BY_PREFIX:
 		{
 			g_autoptr(JMessage) reply = NULL;
-			guint num;
-
-			num = g_atomic_int_add(&jd_thread_num, 1);
-
-			(void)num;
-			//g_message("HELLO %d", num);
+			gchar const* prefix;
+			gchar const* start;
+			gpointer iterator = NULL;
+			guint32 limit;
 
 			reply = j_message_new_reply(message);
+			namespace = j_message_get_string(message);
+			prefix = j_message_get_string(message);
+			start = j_message_get_string(message);
+			limit = j_message_get_4(message);
 
-			if (jd_object_backend != NULL)
-			{
-				j_message_add_operation(reply, 7);
-				j_message_append_string(reply, "object");
-			}
-
-			if (jd_kv_backend != NULL)
+			if (!j_backend_kv_get_by_prefix(jd_kv_backend, namespace, prefix, &iterator))
 			{
-				j_message_add_operation(reply, 3);
-				j_message_append_string(reply, "kv");
+				iterator = NULL;
 			}
 
-			if (jd_db_backend != NULL)
-			{
-				j_message_add_operation(reply, 3);
-				j_message_append_string(reply, "db");
-			}
+			jd_kv_iterate_page(reply, iterator, start, limit);
 
-			j_message_send(reply, connection);
+			jd_send_reply(reply, connection, times);
 		}
 		break;
-		case J_MESSAGE_KV_PUT:
+		case J_MESSAGE_KV_GET_RANGE:
 		{
 			g_autoptr(JMessage) reply = NULL;
-			gpointer batch;
-
-			if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
-			{
-				reply = j_message_new_reply(message);
-			}
+			gchar const* start;
+			gchar const* end;
+			gpointer iterator = NULL;
+			gconstpointer value;
+			guint32 len;
+			guint32 limit;
+			guint32 count = 0;
+			guint32 zero = 0;
+			gchar reverse;
+			gchar more = 0;
 
+			reply = j_message_new_reply(message);
 			namespace = j_message_get_string(message);
-			j_backend_kv_batch_start(jd_kv_backend, namespace, semantics, &batch);
+			start = j_message_get_string(message);
+			end = j_message_get_string(message);
+			reverse = j_message_get_1(message);
+			limit = j_message_get_4(message);
 
-			for (i = 0; i < operation_count; i++)
+			// Empty bounds are open, one more pair tells whether the client has to fetch another page
+			if (j_backend_kv_get_range(jd_kv_backend, namespace, (start[0] != '\0') ? start : NULL, (end[0] != '\0') ? end : NULL, reverse != 0, (limit > 0) ? limit + 1 : 0, &iterator) && iterator != NULL)
 			{
-				gconstpointer data;
-				guint32 len;
-				gboolean ret;
+				while (j_backend_kv_iterate(jd_kv_backend, iterator, &key, &value, &len))
+				{
+					gsize key_len;
 
-				key = j_message_get_string(message);
-				len = j_message_get_4(message);
-				data = j_message_get_n(message, len);
+					if (limit > 0 && count == limit)
+					{
+						more = 1;
+						j_backend_kv_iterator_free(jd_kv_backend, iterator);
+						break;
+					}
 
-				ret = j_backend_kv_put(jd_kv_backend, batch, key, data, len);
+					key_len = strlen(key) + 1;
 
-				if (reply != NULL)
-				{
-					guint32 dummy;
+					j_message_add_operation(reply, 4 + len + key_len);
+					j_message_append_4(reply, &len);
+					j_message_append_n(reply, value, len);
+					j_message_append_string(reply, key);
 
-					dummy = (ret) ? 1 : 0;
-					j_message_add_operation(reply, 4);
-					j_message_append_4(reply, &dummy);
+					count++;
 				}
 			}
 
-			j_backend_kv_batch_execute(jd_kv_backend, batch);
+			j_message_add_operation(reply, 4 + 1);
+			j_message_append_4(reply, &zero);
+			j_message_append_1(reply, &more);
 
-			if (reply != NULL)
-			{
-				j_message_send(reply, connection);
-			}
+			jd_send_reply(reply, connection, times);
 		}
 		break;
-		case J_MESSAGE_KV_DELETE:
+		case J_MESSAGE_KV_COMPARE_AND_SWAP:
 		{
 			g_autoptr(JMessage) reply = NULL;
-			gpointer batch;
+			g_autofree gchar const** keys = NULL;
+			g_autofree guint32* rets = NULL;
+			g_autofree guint32* swapped = NULL;
+			JdKVBloom* bloom;
+			gpointer batch = NULL;
+			gboolean atomic;
+			gboolean batch_ret = TRUE;
+
+			// The result is needed regardless of the safety semantics, so there always is a reply.
+			reply = j_message_new_reply(message);
+			atomic = (j_semantics_get(semantics, J_SEMANTICS_ATOMICITY) == J_SEMANTICS_ATOMICITY_BATCH);
+			namespace = j_message_get_string(message);
 
-			if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
-			{
-				reply = j_message_new_reply(message);
-			}
+			keys = g_new(gchar const*, operation_count);
+			rets = g_new(guint32, operation_count);
+			swapped = g_new(guint32, operation_count);
 
-			namespace = j_message_get_string(message);
 			j_backend_kv_batch_start(jd_kv_backend, namespace, semantics, &batch);
 
 			for (i = 0; i < operation_count; i++)
 			{
-				gboolean ret;
+				gconstpointer expected = NULL;
+				gconstpointer value;
+				guint32 expected_len;
+				guint32 len;
+				gboolean swapped_ret = FALSE;
 
 				key = j_message_get_string(message);
 
-				ret = j_backend_kv_delete(jd_kv_backend, batch, key);
+				// A length of G_MAXUINT32 signals that the key must not exist.
+				expected_len = j_message_get_4(message);
 
-				if (reply != NULL)
+				if (expected_len != G_MAXUINT32)
 				{
-					guint32 dummy;
-
-					dummy = (ret) ? 1 : 0;
-					j_message_add_operation(reply, 4);
-					j_message_append_4(reply, &dummy);
+					expected = j_message_get_n(message, expected_len);
+				}
+				else
+				{
+					expected_len = 0;
 				}
+
+				len = j_message_get_4(message);
+				value = j_message_get_n(message, len);
+
+				keys[i] = key;
+				rets[i] = (j_backend_kv_compare_and_swap(jd_kv_backend, batch, key, expected, expected_len, value, len, &swapped_ret)) ? 1 : 0;
+				swapped[i] = (swapped_ret) ? 1 : 0;
+				batch_ret = (rets[i] != 0) && batch_ret;
 			}
 
-			j_backend_kv_batch_execute(jd_kv_backend, batch);
+			// Batch atomicity discards all of the message's operations if one of them fails.
+			if (atomic && !batch_ret)
+			{
+				j_backend_kv_batch_abort(jd_kv_backend, batch);
+				batch_ret = FALSE;
+			}
+			else
+			{
+				// Conflicting commits have to reach the client, the swaps did not happen then.
+				batch_ret = j_backend_kv_batch_execute(jd_kv_backend, batch);
+			}
 
-			if (reply != NULL)
+			bloom = jd_kv_bloom_begin(namespace);
+
+			for (i = 0; i < operation_count; i++)
 			{
-				j_message_send(reply, connection);
+				if (!batch_ret)
+				{
+					rets[i] = 0;
+					swapped[i] = 0;
+				}
+
+				if (swapped[i] != 0)
+				{
+					jd_kv_bloom_add(bloom, keys[i]);
+				}
+
+				j_message_add_operation(reply, 8);
+				j_message_append_4(reply, &(rets[i]));
+				j_message_append_4(reply, &(swapped[i]));
 			}
+
+			jd_kv_bloom_end(bloom);
+
+			jd_send_reply(reply, connection, times);
 		}
 		break;
-		case J_MESSAGE_KV_GET:
+		case J_MESSAGE_KV_ADD:
 		{
 			g_autoptr(JMessage) reply = NULL;
-			gpointer batch;
+			g_autofree gchar const** keys = NULL;
+			g_autofree guint32* rets = NULL;
+			g_autofree gint64* results = NULL;
+			JdKVBloom* bloom;
+			gpointer batch = NULL;
+			gboolean atomic;
+			gboolean batch_ret = TRUE;
 
 			reply = j_message_new_reply(message);
+			atomic = (j_semantics_get(semantics, J_SEMANTICS_ATOMICITY) == J_SEMANTICS_ATOMICITY_BATCH);
 			namespace = j_message_get_string(message);
+
+			keys = g_new(gchar const*, operation_count);
+			rets = g_new(guint32, operation_count);
+			results = g_new0(gint64, operation_count);
+
 			j_backend_kv_batch_start(jd_kv_backend, namespace, semantics, &batch);
 
 			for (i = 0; i < operation_count; i++)
 			{
-				gpointer value;
-				guint32 len;
+				gint64 delta;
 
 				key = j_message_get_string(message);
+				delta = j_message_get_8(message);
 
-				if (j_backend_kv_get(jd_kv_backend, batch, key, &value, &len))
-				{
-					j_message_add_operation(reply, 4 + len);
-					j_message_append_4(reply, &len);
-					j_message_append_n(reply, value, len);
+				keys[i] = key;
+				rets[i] = (j_backend_kv_add(jd_kv_backend, batch, key, delta, &(results[i]))) ? 1 : 0;
+				batch_ret = (rets[i] != 0) && batch_ret;
+			}
 
-					g_free(value);
-				}
-				else
+			if (atomic && !batch_ret)
+			{
+				j_backend_kv_batch_abort(jd_kv_backend, batch);
+				batch_ret = FALSE;
+			}
+			else
+			{
+				batch_ret = j_backend_kv_batch_execute(jd_kv_backend, batch);
+			}
+
+			bloom = jd_kv_bloom_begin(namespace);
+
+			// The results are only valid once the batch has been committed.
+			for (i = 0; i < operation_count; i++)
+			{
+				if (!batch_ret)
 				{
-					guint32 zero = 0;
+					rets[i] = 0;
+					results[i] = 0;
+				}
 
-					j_message_add_operation(reply, 4);
-					j_message_append_4(reply, &zero);
+				if (rets[i] != 0)
+				{
+					jd_kv_bloom_add(bloom, keys[i]);
 				}
+
+				j_message_add_operation(reply, 4 + 8);
+				j_message_append_4(reply, &(rets[i]));
+				j_message_append_8(reply, &(results[i]));
 			}
 
-			j_backend_kv_batch_execute(jd_kv_backend, batch);
+			jd_kv_bloom_end(bloom);
 
-			j_message_send(reply, connection);
+			jd_send_reply(reply, connection, times);
 		}
 		break;
-		case J_MESSAGE_KV_GET_ALL:
+		case J_MESSAGE_KV_BLOOM_FILTER:
 		{
 			g_autoptr(JMessage) reply = NULL;
-			gpointer iterator;
-			gconstpointer value;
-			guint32 len;
-			guint32 zero = 0;
+			guint64 epoch;
+			guint64 version;
 
 			reply = j_message_new_reply(message);
 			namespace = j_message_get_string(message);
+			epoch = j_message_get_8(message);
+			version = j_message_get_8(message);
 
-			j_backend_kv_get_all(jd_kv_backend, namespace, &iterator);
-
-			while (j_backend_kv_iterate(jd_kv_backend, iterator, &key, &value, &len))
-			{
-				gsize key_len;
-
-				key_len = strlen(key) + 1;
-
-				j_message_add_operation(reply, 4 + len + key_len);
-				j_message_append_4(reply, &len);
-				j_message_append_n(reply, value, len);
-				j_message_append_string(reply, key);
-			}
+			jd_kv_bloom_fetch(namespace, epoch, version, reply);
 
-			j_message_add_operation(reply, 4);
-			j_message_append_4(reply, &zero);
-
-			j_message_send(reply, connection);
+			jd_send_reply(reply, connection, times);
 		}
 		break;
-		case J_MESSAGE_KV_GET_BY_PREFIX:
+		case J_MESSAGE_KV_REPLICATE:
+		case J_MESSAGE_DB_REPLICATE:
 		{
 			g_autoptr(JMessage) reply = NULL;
-			gchar const* prefix;
-			gpointer iterator;
-			gconstpointer value;
-			guint32 len;
-			guint32 zero = 0;
+			guint32 ret;
 
+			// Primaries wait for the reply before shipping their next batch.
 			reply = j_message_new_reply(message);
-			namespace = j_message_get_string(message);
-			prefix = j_message_get_string(message);
-
-			j_backend_kv_get_by_prefix(jd_kv_backend, namespace, prefix, &iterator);
 
-			while (j_backend_kv_iterate(jd_kv_backend, iterator, &key, &value, &len))
+			if (j_message_get_type(message) == J_MESSAGE_KV_REPLICATE)
 			{
-				gsize key_len;
-
-				key_len = strlen(key) + 1;
-
-				j_message_add_operation(reply, 4 + len + key_len);
-				j_message_append_4(reply, &len);
-				j_message_append_n(reply, value, len);
-				j_message_append_string(reply, key);
+				ret = (jd_kv_backend != NULL && jd_replication_apply_kv(message, semantics)) ? 1 : 0;
+			}
+			else
+			{
+				ret = (jd_db_backend != NULL && jd_replication_apply_db(message, semantics)) ? 1 : 0;
 			}
 
 			j_message_add_operation(reply, 4);
-			j_message_append_4(reply, &zero);
-
-			j_message_send(reply, connection);
+			j_message_append_4(reply, &ret);
+			jd_send_reply(reply, connection, times);
 		}
 		break;
 		case J_MESSAGE_DB_SCHEMA_CREATE:
@@ -678,6 +3487,13 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			}
 			// fallthrough
 		case J_MESSAGE_DB_INSERT:
+			if (!message_matched && operation_count > 1 && j_semantics_get(semantics, J_SEMANTICS_ATOMICITY) == J_SEMANTICS_ATOMICITY_BATCH)
+			{
+				jd_db_insert_multi(message, connection, semantics, operation_count, times);
+				message_matched = TRUE;
+				break;
+			}
+
 			if (!message_matched)
 			{
 				memcpy(&backend_operation, &j_backend_operation_db_insert, sizeof(JBackendOperation));
@@ -704,6 +3520,20 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 				memcpy(&backend_operation, &j_backend_operation_db_query, sizeof(JBackendOperation));
 				message_matched = TRUE;
 			}
+			// fallthrough
+		case J_MESSAGE_DB_AGGREGATE:
+			if (!message_matched)
+			{
+				memcpy(&backend_operation, &j_backend_operation_db_aggregate, sizeof(JBackendOperation));
+				message_matched = TRUE;
+			}
+			// fallthrough
+		case J_MESSAGE_DB_ADVISE_INDEXES:
+			if (!message_matched)
+			{
+				memcpy(&backend_operation, &j_backend_operation_db_advise_indexes, sizeof(JBackendOperation));
+				message_matched = TRUE;
+			}
 			{
 				g_autoptr(JMessage) reply = NULL;
 				GError* error = NULL;
@@ -840,7 +3670,7 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 						g_warn_if_reached();
 				}
 
-				j_message_send(reply, connection);
+				jd_send_reply(reply, connection, times);
 			}
 			break;
 		default:
@@ -848,5 +3678,36 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			break;
 	}
 
+	if (scheduler_class != JD_SCHEDULER_CLASSES)
+	{
+		jd_scheduler_leave(client, scheduler_class, operation_count);
+	}
+
+	if ((guint)message_type < J_STATISTICS_MESSAGE_TYPES)
+	{
+		guint64 duration;
+		gint64 end_time;
+
+		end_time = g_get_monotonic_time();
+		duration = end_time - start_time;
+
+		// Requests without a reply are complete once they have been handled.
+		if (times->completed == 0)
+		{
+			times->completed = end_time;
+			times->sent = end_time;
+		}
+
+		j_statistics_add_message(statistics, message_type, J_STATISTICS_MESSAGE_REQUESTS, 1);
+		j_statistics_add_message(statistics, message_type, J_STATISTICS_MESSAGE_BYTES, j_statistics_get(statistics, J_STATISTICS_BYTES_READ) + j_statistics_get(statistics, J_STATISTICS_BYTES_WRITTEN) - start_bytes);
+		j_statistics_add_message(statistics, message_type, J_STATISTICS_MESSAGE_TIME, duration);
+		j_statistics_add_latency(statistics, message_type, duration);
+
+		j_statistics_add_message(statistics, message_type, J_STATISTICS_MESSAGE_QUEUE_TIME, jd_duration(times->ready, times->receive));
+		j_statistics_add_message(statistics, message_type, J_STATISTICS_MESSAGE_RECEIVE_TIME, jd_duration(times->receive, times->received));
+		j_statistics_add_message(statistics, message_type, J_STATISTICS_MESSAGE_SERVICE_TIME, jd_duration(times->dispatched, times->completed));
+		j_statistics_add_message(statistics, message_type, J_STATISTICS_MESSAGE_REPLY_TIME, jd_duration(times->completed, times->sent));
+	}
+
 	return message_matched;
 }
@@ -0,0 +1,346 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <string.h>
+
+#include <julea.h>
+
+#include "server.h"
+
+/**
+ * The maximum size of an HTTP request header.
+ * Everything beyond it is ignored, since all requests are answered the same way.
+ **/
+#define JD_METRICS_REQUEST_SIZE 4096
+
+/**
+ * The number of threads answering metrics requests.
+ **/
+#define JD_METRICS_THREADS 2
+
+struct JdMetricsCounter
+{
+	JStatisticsType type;
+	gchar const* name;
+	gchar const* help;
+};
+
+typedef struct JdMetricsCounter JdMetricsCounter;
+
+static JdMetricsCounter const jd_metrics_counters[] = {
+	{ J_STATISTICS_FILES_CREATED, "julea_files_created_total", "Number of created objects." },
+	{ J_STATISTICS_FILES_DELETED, "julea_files_deleted_total", "Number of deleted objects." },
+	{ J_STATISTICS_FILES_STATED, "julea_files_stated_total", "Number of stat'ed objects." },
+	{ J_STATISTICS_SYNC, "julea_syncs_total", "Number of sync operations." },
+	{ J_STATISTICS_BYTES_READ, "julea_read_bytes_total", "Number of bytes read from the backends." },
+	{ J_STATISTICS_BYTES_WRITTEN, "julea_written_bytes_total", "Number of bytes written to the backends." },
+	{ J_STATISTICS_BYTES_RECEIVED, "julea_received_bytes_total", "Number of bulk data bytes received from clients." },
+	{ J_STATISTICS_BYTES_SENT, "julea_sent_bytes_total", "Number of bulk data bytes sent to clients." },
+};
+
+/**
+ * Formats a backend's call statistics in the Prometheus text format.
+ * Each metric is appended to its own string, since the samples of a metric have to be contiguous.
+ *
+ * \param calls_metrics    A string to append the number of calls to.
+ * \param bytes_metrics    A string to append the number of bytes to.
+ * \param duration_metrics A string to append the latency histograms to.
+ * \param backend          A backend, may be NULL.
+ * \param type             The backend's type.
+ **/
+static void
+jd_metrics_format_backend(GString* calls_metrics, GString* bytes_metrics, GString* duration_metrics, JBackend* backend, gchar const* type)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBackendStatistics* statistics;
+	gchar const* name;
+
+	if (backend == NULL || (statistics = j_backend_get_statistics(backend)) == NULL)
+	{
+		return;
+	}
+
+	name = j_backend_statistics_get_name(statistics);
+
+	for (guint c = 0; c < J_BACKEND_CALLS; c++)
+	{
+		gchar const* call = j_backend_call_get_name(c);
+		guint64 calls;
+		guint64 count = 0;
+
+		// Skip unused calls to keep the output small, there are many buckets per call.
+		if ((calls = j_backend_statistics_get(statistics, c, J_BACKEND_STATISTICS_CALLS)) == 0)
+		{
+			continue;
+		}
+
+		g_string_append_printf(calls_metrics, "julea_backend_calls_total{backend=\"%s\",type=\"%s\",call=\"%s\"} %" G_GUINT64_FORMAT "\n", name, type, call, calls);
+		g_string_append_printf(bytes_metrics, "julea_backend_bytes_total{backend=\"%s\",type=\"%s\",call=\"%s\"} %" G_GUINT64_FORMAT "\n", name, type, call, j_backend_statistics_get(statistics, c, J_BACKEND_STATISTICS_BYTES));
+
+		for (guint b = 0; b < J_STATISTICS_LATENCY_BUCKETS - 1; b++)
+		{
+			count += j_backend_statistics_get_latency(statistics, c, b);
+			g_string_append_printf(duration_metrics, "julea_backend_call_duration_seconds_bucket{backend=\"%s\",type=\"%s\",call=\"%s\",le=\"%g\"} %" G_GUINT64_FORMAT "\n", name, type, call, (gdouble)(G_GUINT64_CONSTANT(1) << b) / (gdouble)G_USEC_PER_SEC, count);
+		}
+
+		count += j_backend_statistics_get_latency(statistics, c, J_STATISTICS_LATENCY_BUCKETS - 1);
+		g_string_append_printf(duration_metrics, "julea_backend_call_duration_seconds_bucket{backend=\"%s\",type=\"%s\",call=\"%s\",le=\"+Inf\"} %" G_GUINT64_FORMAT "\n", name, type, call, count);
+		g_string_append_printf(duration_metrics, "julea_backend_call_duration_seconds_sum{backend=\"%s\",type=\"%s\",call=\"%s\"} %f\n", name, type, call, (gdouble)j_backend_statistics_get(statistics, c, J_BACKEND_STATISTICS_TIME) / (gdouble)G_USEC_PER_SEC);
+		g_string_append_printf(duration_metrics, "julea_backend_call_duration_seconds_count{backend=\"%s\",type=\"%s\",call=\"%s\"} %" G_GUINT64_FORMAT "\n", name, type, call, count);
+	}
+}
+
+/**
+ * Formats the current metrics in the Prometheus text format.
+ *
+ * \return The metrics. Should be freed with g_string_free().
+ **/
+static GString*
+jd_metrics_format(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GArray) usage = NULL;
+	JStatistics* statistics;
+	GString* metrics;
+	GString* calls_metrics;
+	GString* bytes_metrics;
+	GString* duration_metrics;
+
+	statistics = jd_statistics_get_all();
+	usage = jd_memory_chunk_get_usage();
+	metrics = g_string_new(NULL);
+
+	for (guint i = 0; i < G_N_ELEMENTS(jd_metrics_counters); i++)
+	{
+		g_string_append_printf(metrics, "# HELP %s %s\n", jd_metrics_counters[i].name, jd_metrics_counters[i].help);
+		g_string_append_printf(metrics, "# TYPE %s counter\n", jd_metrics_counters[i].name);
+		g_string_append_printf(metrics, "%s %" G_GUINT64_FORMAT "\n", jd_metrics_counters[i].name, j_statistics_get(statistics, jd_metrics_counters[i].type));
+	}
+
+	g_string_append(metrics, "# HELP julea_connections Number of established connections.\n");
+	g_string_append(metrics, "# TYPE julea_connections gauge\n");
+	g_string_append_printf(metrics, "julea_connections %" G_GUINT64_FORMAT "\n", j_statistics_get(statistics, J_STATISTICS_CONNECTIONS));
+
+	g_string_append(metrics, "# HELP julea_requests_total Number of handled requests.\n");
+	g_string_append(metrics, "# TYPE julea_requests_total counter\n");
+
+	for (guint t = 0; t < J_STATISTICS_MESSAGE_TYPES; t++)
+	{
+		g_string_append_printf(metrics, "julea_requests_total{type=\"%s\"} %" G_GUINT64_FORMAT "\n", j_message_type_get_name(t), j_statistics_get_message(statistics, t, J_STATISTICS_MESSAGE_REQUESTS));
+	}
+
+	g_string_append(metrics, "# HELP julea_request_bytes_total Number of bytes read or written while handling requests.\n");
+	g_string_append(metrics, "# TYPE julea_request_bytes_total counter\n");
+
+	for (guint t = 0; t < J_STATISTICS_MESSAGE_TYPES; t++)
+	{
+		g_string_append_printf(metrics, "julea_request_bytes_total{type=\"%s\"} %" G_GUINT64_FORMAT "\n", j_message_type_get_name(t), j_statistics_get_message(statistics, t, J_STATISTICS_MESSAGE_BYTES));
+	}
+
+	g_string_append(metrics, "# HELP julea_request_duration_seconds Time spent handling requests, including the backends.\n");
+	g_string_append(metrics, "# TYPE julea_request_duration_seconds histogram\n");
+
+	for (guint t = 0; t < J_STATISTICS_MESSAGE_TYPES; t++)
+	{
+		gchar const* name = j_message_type_get_name(t);
+		guint64 count = 0;
+
+		// Skip idle message types to keep the output small, there are many buckets per type.
+		if (j_statistics_get_message(statistics, t, J_STATISTICS_MESSAGE_REQUESTS) == 0)
+		{
+			continue;
+		}
+
+		for (guint b = 0; b < J_STATISTICS_LATENCY_BUCKETS - 1; b++)
+		{
+			count += j_statistics_get_latency(statistics, t, b);
+			g_string_append_printf(metrics, "julea_request_duration_seconds_bucket{type=\"%s\",le=\"%g\"} %" G_GUINT64_FORMAT "\n", name, (gdouble)(G_GUINT64_CONSTANT(1) << b) / (gdouble)G_USEC_PER_SEC, count);
+		}
+
+		count += j_statistics_get_latency(statistics, t, J_STATISTICS_LATENCY_BUCKETS - 1);
+		g_string_append_printf(metrics, "julea_request_duration_seconds_bucket{type=\"%s\",le=\"+Inf\"} %" G_GUINT64_FORMAT "\n", name, count);
+		g_string_append_printf(metrics, "julea_request_duration_seconds_sum{type=\"%s\"} %f\n", name, (gdouble)j_statistics_get_message(statistics, t, J_STATISTICS_MESSAGE_TIME) / (gdouble)G_USEC_PER_SEC);
+		g_string_append_printf(metrics, "julea_request_duration_seconds_count{type=\"%s\"} %" G_GUINT64_FORMAT "\n", name, count);
+	}
+
+	g_string_append(metrics, "# HELP julea_request_phase_seconds_total Time requests spent in each phase on the server.\n");
+	g_string_append(metrics, "# TYPE julea_request_phase_seconds_total counter\n");
+
+	for (guint t = 0; t < J_STATISTICS_MESSAGE_TYPES; t++)
+	{
+		gchar const* name = j_message_type_get_name(t);
+
+		if (j_statistics_get_message(statistics, t, J_STATISTICS_MESSAGE_REQUESTS) == 0)
+		{
+			continue;
+		}
+
+		g_string_append_printf(metrics, "julea_request_phase_seconds_total{type=\"%s\",phase=\"queue\"} %f\n", name, (gdouble)j_statistics_get_message(statistics, t, J_STATISTICS_MESSAGE_QUEUE_TIME) / (gdouble)G_USEC_PER_SEC);
+		g_string_append_printf(metrics, "julea_request_phase_seconds_total{type=\"%s\",phase=\"receive\"} %f\n", name, (gdouble)j_statistics_get_message(statistics, t, J_STATISTICS_MESSAGE_RECEIVE_TIME) / (gdouble)G_USEC_PER_SEC);
+		g_string_append_printf(metrics, "julea_request_phase_seconds_total{type=\"%s\",phase=\"service\"} %f\n", name, (gdouble)j_statistics_get_message(statistics, t, J_STATISTICS_MESSAGE_SERVICE_TIME) / (gdouble)G_USEC_PER_SEC);
+		g_string_append_printf(metrics, "julea_request_phase_seconds_total{type=\"%s\",phase=\"reply\"} %f\n", name, (gdouble)j_statistics_get_message(statistics, t, J_STATISTICS_MESSAGE_REPLY_TIME) / (gdouble)G_USEC_PER_SEC);
+	}
+
+	calls_metrics = g_string_new("# HELP julea_backend_calls_total Number of backend calls.\n# TYPE julea_backend_calls_total counter\n");
+	bytes_metrics = g_string_new("# HELP julea_backend_bytes_total Number of bytes read or written by backend calls.\n# TYPE julea_backend_bytes_total counter\n");
+	duration_metrics = g_string_new("# HELP julea_backend_call_duration_seconds Time spent in backend calls.\n# TYPE julea_backend_call_duration_seconds histogram\n");
+
+	jd_metrics_format_backend(calls_metrics, bytes_metrics, duration_metrics, jd_object_backend, "object");
+	jd_metrics_format_backend(calls_metrics, bytes_metrics, duration_metrics, jd_kv_backend, "kv");
+	jd_metrics_format_backend(calls_metrics, bytes_metrics, duration_metrics, jd_db_backend, "db");
+
+	g_string_append_len(metrics, calls_metrics->str, calls_metrics->len);
+	g_string_append_len(metrics, bytes_metrics->str, bytes_metrics->len);
+	g_string_append_len(metrics, duration_metrics->str, duration_metrics->len);
+
+	g_string_free(calls_metrics, TRUE);
+	g_string_free(bytes_metrics, TRUE);
+	g_string_free(duration_metrics, TRUE);
+
+	g_string_append(metrics, "# HELP julea_memory_chunk_size_bytes Size of a connection's memory chunk.\n");
+	g_string_append(metrics, "# TYPE julea_memory_chunk_size_bytes gauge\n");
+
+	for (guint i = 0; i < usage->len; i++)
+	{
+		g_string_append_printf(metrics, "julea_memory_chunk_size_bytes{connection=\"%u\"} %" G_GUINT64_FORMAT "\n", i, g_array_index(usage, JdMemoryChunkUsage, i).size);
+	}
+
+	g_string_append(metrics, "# HELP julea_memory_chunk_peak_bytes Largest amount of a connection's memory chunk used at once.\n");
+	g_string_append(metrics, "# TYPE julea_memory_chunk_peak_bytes gauge\n");
+
+	for (guint i = 0; i < usage->len; i++)
+	{
+		g_string_append_printf(metrics, "julea_memory_chunk_peak_bytes{connection=\"%u\"} %" G_GUINT64_FORMAT "\n", i, g_array_index(usage, JdMemoryChunkUsage, i).peak);
+	}
+
+	j_statistics_free(statistics);
+
+	return metrics;
+}
+
+static gboolean
+jd_metrics_on_run(GThreadedSocketService* service, GSocketConnection* connection, GObject* source_object, gpointer user_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* header = NULL;
+	GInputStream* input;
+	GOutputStream* output;
+	GString* metrics;
+	gchar request[JD_METRICS_REQUEST_SIZE];
+	gsize request_length = 0;
+
+	(void)service;
+	(void)source_object;
+	(void)user_data;
+
+	input = g_io_stream_get_input_stream(G_IO_STREAM(connection));
+	output = g_io_stream_get_output_stream(G_IO_STREAM(connection));
+
+	// Read the request header, its contents do not matter since there is only one resource.
+	while (request_length < sizeof(request) - 1)
+	{
+		gssize nbytes;
+
+		nbytes = g_input_stream_read(input, request + request_length, sizeof(request) - 1 - request_length, NULL, NULL);
+
+		if (nbytes <= 0)
+		{
+			break;
+		}
+
+		request_length += nbytes;
+		request[request_length] = '\0';
+
+		if (strstr(request, "\r\n\r\n") != NULL)
+		{
+			break;
+		}
+	}
+
+	metrics = jd_metrics_format();
+	header = g_strdup_printf("HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: %" G_GSIZE_FORMAT "\r\nConnection: close\r\n\r\n", metrics->len);
+
+	if (g_output_stream_write_all(output, header, strlen(header), NULL, NULL, NULL))
+	{
+		g_output_stream_write_all(output, metrics->str, metrics->len, NULL, NULL, NULL);
+	}
+
+	g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+	g_string_free(metrics, TRUE);
+
+	return TRUE;
+}
+
+/**
+ * Starts serving metrics via HTTP.
+ *
+ * \param port A port.
+ *
+ * \return A socket service, NULL if the port could not be used.
+ **/
+GSocketService*
+jd_metrics_start(gint port)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GError* error = NULL;
+	GSocketService* service;
+
+	g_return_val_if_fail(port > 0 && port <= G_MAXUINT16, NULL);
+
+	service = g_threaded_socket_service_new(JD_METRICS_THREADS);
+
+	if (!g_socket_listener_add_inet_port(G_SOCKET_LISTENER(service), port, NULL, &error))
+	{
+		g_warning("Cannot serve metrics on port %d: %s", port, error->message);
+		g_error_free(error);
+		g_object_unref(service);
+
+		return NULL;
+	}
+
+	g_signal_connect(service, "run", G_CALLBACK(jd_metrics_on_run), NULL);
+	g_socket_service_start(service);
+
+	return service;
+}
+
+/**
+ * Stops serving metrics.
+ *
+ * \param service A socket service returned by jd_metrics_start().
+ **/
+void
+jd_metrics_stop(GSocketService* service)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(service != NULL);
+
+	g_socket_service_stop(service);
+	g_socket_listener_close(G_SOCKET_LISTENER(service));
+	g_object_unref(service);
+}
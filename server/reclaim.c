@@ -0,0 +1,359 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <julea.h>
+
+#include "server.h"
+
+/**
+ * The maximum number of objects deleted before the reclaimer pauses.
+ **/
+#define JD_OBJECT_RECLAIM_BATCH 64
+
+/**
+ * The number of milliseconds the reclaimer pauses between two batches, leaving the backend to foreground requests.
+ **/
+#define JD_OBJECT_RECLAIM_PAUSE 10
+
+/**
+ * An object waiting to be deleted.
+ **/
+struct JdObjectReclaimEntry
+{
+	gchar* namespace;
+	gchar* path;
+	gchar* key;
+};
+
+typedef struct JdObjectReclaimEntry JdObjectReclaimEntry;
+
+static struct
+{
+	GThread* thread;
+
+	GMutex mutex[1];
+	GCond cond[1];
+	gboolean stop;
+
+	/**
+	 * Contains JdObjectReclaimEntry elements in deletion order.
+	 **/
+	GQueue queue[1];
+
+	/**
+	 * Maps the keys of all objects that have been deleted but not reclaimed yet to their entries.
+	 * An entry is only removed after its object has been deleted physically.
+	 **/
+	GHashTable* pending;
+
+	/**
+	 * Held while an object is deleted physically.
+	 * This keeps an object from being created again while its old version is still being deleted.
+	 **/
+	GMutex delete_mutex[1];
+
+	gint enabled;
+} jd_object_reclaim;
+
+static void
+jd_object_reclaim_entry_free(JdObjectReclaimEntry* entry)
+{
+	g_free(entry->namespace);
+	g_free(entry->path);
+	g_free(entry->key);
+
+	g_slice_free(JdObjectReclaimEntry, entry);
+}
+
+/**
+ * Deletes an object physically if it is still pending and forgets about it.
+ *
+ * \private
+ *
+ * \param key The object's key.
+ **/
+static void
+jd_object_reclaim_delete(gchar const* key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdObjectReclaimEntry* entry;
+
+	g_mutex_lock(jd_object_reclaim.delete_mutex);
+
+	g_mutex_lock(jd_object_reclaim.mutex);
+	entry = g_hash_table_lookup(jd_object_reclaim.pending, key);
+	g_mutex_unlock(jd_object_reclaim.mutex);
+
+	if (entry != NULL)
+	{
+		gpointer object;
+
+		if (j_backend_object_open(jd_object_backend, entry->namespace, entry->path, &object))
+		{
+			j_backend_object_delete(jd_object_backend, object);
+		}
+
+		g_mutex_lock(jd_object_reclaim.mutex);
+		g_queue_remove(jd_object_reclaim.queue, entry);
+		g_hash_table_remove(jd_object_reclaim.pending, key);
+		g_mutex_unlock(jd_object_reclaim.mutex);
+	}
+
+	g_mutex_unlock(jd_object_reclaim.delete_mutex);
+}
+
+static gpointer
+jd_object_reclaim_thread(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	(void)data;
+
+	g_mutex_lock(jd_object_reclaim.mutex);
+
+	while (TRUE)
+	{
+		g_autoptr(GPtrArray) keys = NULL;
+
+		while (!jd_object_reclaim.stop && g_queue_is_empty(jd_object_reclaim.queue))
+		{
+			g_cond_wait(jd_object_reclaim.cond, jd_object_reclaim.mutex);
+		}
+
+		if (g_queue_is_empty(jd_object_reclaim.queue))
+		{
+			break;
+		}
+
+		keys = g_ptr_array_new_with_free_func(g_free);
+
+		for (GList* link = jd_object_reclaim.queue->head; link != NULL && keys->len < JD_OBJECT_RECLAIM_BATCH; link = link->next)
+		{
+			JdObjectReclaimEntry* entry = link->data;
+
+			g_ptr_array_add(keys, g_strdup(entry->key));
+		}
+
+		g_mutex_unlock(jd_object_reclaim.mutex);
+
+		for (guint i = 0; i < keys->len; i++)
+		{
+			jd_object_reclaim_delete(g_ptr_array_index(keys, i));
+		}
+
+		g_mutex_lock(jd_object_reclaim.mutex);
+
+		// Remaining deletions are finished right away when stopping
+		if (!jd_object_reclaim.stop && !g_queue_is_empty(jd_object_reclaim.queue))
+		{
+			gint64 end_time;
+
+			end_time = g_get_monotonic_time() + JD_OBJECT_RECLAIM_PAUSE * G_TIME_SPAN_MILLISECOND;
+
+			while (!jd_object_reclaim.stop && g_cond_wait_until(jd_object_reclaim.cond, jd_object_reclaim.mutex, end_time))
+			{
+			}
+		}
+	}
+
+	g_mutex_unlock(jd_object_reclaim.mutex);
+
+	return NULL;
+}
+
+/**
+ * Starts deleting objects in the background.
+ *
+ * \private
+ **/
+void
+jd_object_reclaim_start(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(jd_object_backend != NULL);
+	g_return_if_fail(jd_object_reclaim.thread == NULL);
+
+	g_queue_init(jd_object_reclaim.queue);
+	jd_object_reclaim.pending = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)jd_object_reclaim_entry_free);
+	jd_object_reclaim.stop = FALSE;
+	jd_object_reclaim.thread = g_thread_new("julea-reclaim", jd_object_reclaim_thread, NULL);
+
+	g_atomic_int_set(&(jd_object_reclaim.enabled), 1);
+}
+
+/**
+ * Stops deleting objects in the background.
+ * All pending deletions are finished before returning.
+ *
+ * \private
+ **/
+void
+jd_object_reclaim_stop(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (jd_object_reclaim.thread == NULL)
+	{
+		return;
+	}
+
+	g_mutex_lock(jd_object_reclaim.mutex);
+	jd_object_reclaim.stop = TRUE;
+	g_cond_signal(jd_object_reclaim.cond);
+	g_mutex_unlock(jd_object_reclaim.mutex);
+
+	g_thread_join(jd_object_reclaim.thread);
+	jd_object_reclaim.thread = NULL;
+
+	g_atomic_int_set(&(jd_object_reclaim.enabled), 0);
+
+	g_hash_table_unref(jd_object_reclaim.pending);
+	jd_object_reclaim.pending = NULL;
+}
+
+/**
+ * Returns whether objects are deleted in the background.
+ *
+ * \private
+ **/
+gboolean
+jd_object_reclaim_enabled(void)
+{
+	return g_atomic_int_get(&(jd_object_reclaim.enabled));
+}
+
+/**
+ * Marks an object as deleted and queues its physical deletion.
+ * The object is hidden immediately.
+ *
+ * \private
+ *
+ * \param namespace A namespace.
+ * \param path      A path.
+ *
+ * \return TRUE if the object existed, FALSE otherwise.
+ **/
+gboolean
+jd_object_reclaim_defer(gchar const* namespace, gchar const* path)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* key = NULL;
+	JdObjectReclaimEntry* entry;
+	gpointer object;
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(jd_object_reclaim_enabled(), FALSE);
+
+	key = g_strconcat(namespace, "/", path, NULL);
+
+	g_mutex_lock(jd_object_reclaim.mutex);
+
+	if (g_hash_table_contains(jd_object_reclaim.pending, key))
+	{
+		goto end;
+	}
+
+	// Opening is cheap compared to deleting and tells whether the object exists
+	if (!j_backend_object_open(jd_object_backend, namespace, path, &object))
+	{
+		goto end;
+	}
+
+	j_backend_object_close(jd_object_backend, object);
+
+	entry = g_slice_new(JdObjectReclaimEntry);
+	entry->namespace = g_strdup(namespace);
+	entry->path = g_strdup(path);
+	entry->key = g_steal_pointer(&key);
+
+	g_queue_push_tail(jd_object_reclaim.queue, entry);
+	g_hash_table_insert(jd_object_reclaim.pending, entry->key, entry);
+	g_cond_signal(jd_object_reclaim.cond);
+
+	ret = TRUE;
+
+end:
+	g_mutex_unlock(jd_object_reclaim.mutex);
+
+	return ret;
+}
+
+/**
+ * Returns whether an object has been deleted but not reclaimed yet.
+ * Such objects have to be treated as if they did not exist.
+ *
+ * \private
+ *
+ * \param namespace A namespace.
+ * \param path      A path.
+ *
+ * \return TRUE if the object is pending deletion, FALSE otherwise.
+ **/
+gboolean
+jd_object_reclaim_pending(gchar const* namespace, gchar const* path)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* key = NULL;
+	gboolean ret;
+
+	if (!jd_object_reclaim_enabled())
+	{
+		return FALSE;
+	}
+
+	key = g_strconcat(namespace, "/", path, NULL);
+
+	g_mutex_lock(jd_object_reclaim.mutex);
+	ret = g_hash_table_contains(jd_object_reclaim.pending, key);
+	g_mutex_unlock(jd_object_reclaim.mutex);
+
+	return ret;
+}
+
+/**
+ * Deletes an object pending deletion right away.
+ * Has to be called before creating an object, so that the new object is not deleted by the reclaimer.
+ *
+ * \private
+ *
+ * \param namespace A namespace.
+ * \param path      A path.
+ **/
+void
+jd_object_reclaim_now(gchar const* namespace, gchar const* path)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* key = NULL;
+
+	if (!jd_object_reclaim_pending(namespace, path))
+	{
+		return;
+	}
+
+	key = g_strconcat(namespace, "/", path, NULL);
+	jd_object_reclaim_delete(key);
+}
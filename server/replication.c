@@ -0,0 +1,1086 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <string.h>
+
+#include <julea.h>
+
+#include "server.h"
+
+/**
+ * The maximum number of batches waiting to be shipped.
+ * Further batches are dropped, so that an unreachable replica does not block the primary.
+ **/
+#define JD_REPLICATION_BACKLOG 65536
+
+/**
+ * The number of milliseconds to wait before reconnecting to an unreachable replica.
+ **/
+#define JD_REPLICATION_RETRY 1000
+
+/**
+ * The kinds of changes shipped to replicas.
+ **/
+enum JdReplicationChange
+{
+	JD_REPLICATION_KV_PUT = 'p',
+	JD_REPLICATION_KV_DELETE = 'd',
+	JD_REPLICATION_DB_SCHEMA_CREATE = 'c',
+	JD_REPLICATION_DB_SCHEMA_DELETE = 'r',
+	JD_REPLICATION_DB_INSERT = 'i',
+	JD_REPLICATION_DB_UPDATE = 'u',
+	JD_REPLICATION_DB_DELETE = 'x'
+};
+
+typedef enum JdReplicationChange JdReplicationChange;
+
+/**
+ * A batch of a replicated backend.
+ **/
+struct JdReplicationBatch
+{
+	/**
+	 * The original backend's batch.
+	 **/
+	gpointer batch;
+
+	gchar* namespace;
+	JSemantics* semantics;
+
+	/**
+	 * The batch's changes, NULL if it has not changed anything.
+	 **/
+	JMessage* message;
+};
+
+typedef struct JdReplicationBatch JdReplicationBatch;
+
+/**
+ * A replicated backend.
+ **/
+struct JdReplication
+{
+	/**
+	 * The backend whose functions have been replaced, NULL if replication is disabled.
+	 **/
+	JBackend* backend;
+
+	/**
+	 * The backend's original functions, used to apply changes without shipping them.
+	 **/
+	JBackend original;
+
+	JMessageType message_type;
+
+	/**
+	 * The replicas' addresses and connections, NULL if not connected.
+	 **/
+	gchar** replicas;
+	gpointer* connections;
+
+	/**
+	 * Makes batches enter the queue in the order they were executed.
+	 **/
+	GMutex order_mutex[1];
+
+	GThread* thread;
+	GMutex mutex[1];
+	GCond cond[1];
+	gboolean stop;
+
+	/**
+	 * Contains the JMessage elements to ship.
+	 **/
+	GQueue queue[1];
+
+	guint64 dropped;
+};
+
+typedef struct JdReplication JdReplication;
+
+static JdReplication jd_replication_kv;
+static JdReplication jd_replication_db;
+
+static JdReplication*
+jd_replication_get(JBackendType type)
+{
+	switch (type)
+	{
+		case J_BACKEND_TYPE_KV:
+			return &jd_replication_kv;
+		case J_BACKEND_TYPE_DB:
+			return &jd_replication_db;
+		case J_BACKEND_TYPE_OBJECT:
+		default:
+			g_assert_not_reached();
+	}
+
+	return NULL;
+}
+
+static JdReplicationBatch*
+jd_replication_batch_new(gpointer batch, gchar const* namespace, JSemantics* semantics)
+{
+	JdReplicationBatch* replication_batch;
+
+	replication_batch = g_slice_new(JdReplicationBatch);
+	replication_batch->batch = batch;
+	replication_batch->namespace = g_strdup(namespace);
+	replication_batch->semantics = j_semantics_ref(semantics);
+	replication_batch->message = NULL;
+
+	return replication_batch;
+}
+
+static void
+jd_replication_batch_free(JdReplicationBatch* replication_batch)
+{
+	if (replication_batch->message != NULL)
+	{
+		j_message_unref(replication_batch->message);
+	}
+
+	j_semantics_unref(replication_batch->semantics);
+	g_free(replication_batch->namespace);
+
+	g_slice_free(JdReplicationBatch, replication_batch);
+}
+
+/**
+ * Records a change of a batch.
+ *
+ * \private
+ *
+ * \param replication       A replicated backend.
+ * \param replication_batch A batch.
+ * \param change            The kind of change.
+ * \param name              The key or schema name.
+ * \param length            The length of the data appended by the caller.
+ **/
+static void
+jd_replication_batch_record(JdReplication* replication, JdReplicationBatch* replication_batch, JdReplicationChange change, gchar const* name, gsize length)
+{
+	guint8 change_byte = change;
+	gsize name_len;
+
+	if (replication_batch->message == NULL)
+	{
+		gsize namespace_len;
+
+		namespace_len = strlen(replication_batch->namespace) + 1;
+
+		replication_batch->message = j_message_new(replication->message_type, namespace_len);
+		j_message_set_semantics(replication_batch->message, replication_batch->semantics);
+		j_message_append_n(replication_batch->message, replication_batch->namespace, namespace_len);
+	}
+
+	name_len = strlen(name) + 1;
+
+	j_message_add_operation(replication_batch->message, 1 + name_len + length);
+	j_message_append_1(replication_batch->message, &change_byte);
+	j_message_append_n(replication_batch->message, name, name_len);
+}
+
+static gsize
+jd_replication_bson_length(bson_t const* bson)
+{
+	return 4 + ((bson != NULL) ? bson->len : 0);
+}
+
+static void
+jd_replication_append_bson(JMessage* message, bson_t const* bson)
+{
+	guint32 len;
+
+	len = (bson != NULL) ? bson->len : 0;
+	j_message_append_4(message, &len);
+
+	if (len > 0)
+	{
+		j_message_append_n(message, bson_get_data(bson), len);
+	}
+}
+
+/**
+ * Reads a BSON document appended by jd_replication_append_bson().
+ *
+ * \private
+ *
+ * \param message A message.
+ * \param bson    An uninitialized BSON document, which points into the message.
+ *
+ * \return The document, NULL if none has been appended.
+ **/
+static bson_t*
+jd_replication_get_bson(JMessage* message, bson_t* bson)
+{
+	gconstpointer data;
+	guint32 len;
+
+	len = j_message_get_4(message);
+
+	if (len == 0)
+	{
+		return NULL;
+	}
+
+	data = j_message_get_n(message, len);
+
+	if (!bson_init_static(bson, data, len))
+	{
+		return NULL;
+	}
+
+	return bson;
+}
+
+/**
+ * Queues a batch's changes to be shipped to all replicas.
+ *
+ * \private
+ *
+ * \param replication A replicated backend.
+ * \param message     The changes.
+ **/
+static void
+jd_replication_ship(JdReplication* replication, JMessage* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_mutex_lock(replication->mutex);
+
+	if (replication->queue->length < JD_REPLICATION_BACKLOG)
+	{
+		g_queue_push_tail(replication->queue, message);
+		g_cond_signal(replication->cond);
+	}
+	else
+	{
+		if (replication->dropped == 0)
+		{
+			g_warning("Replication backlog is full, replicas will miss changes.");
+		}
+
+		replication->dropped++;
+		j_message_unref(message);
+	}
+
+	g_mutex_unlock(replication->mutex);
+}
+
+/**
+ * Executes a batch and ships its changes if it succeeded.
+ *
+ * \private
+ *
+ * \param replication       A replicated backend.
+ * \param replication_batch A batch, which is freed.
+ * \param execute           Executes the original batch.
+ * \param error             A GError, only used by db backends.
+ **/
+static gboolean
+jd_replication_batch_execute(JdReplication* replication, JdReplicationBatch* replication_batch, gboolean (*execute)(JdReplication*, gpointer, GError**), GError** error)
+{
+	gboolean ret;
+
+	if (replication_batch->message == NULL)
+	{
+		ret = execute(replication, replication_batch->batch, error);
+	}
+	else
+	{
+		// Batches changing the same keys have to reach the replicas in the order they were executed.
+		g_mutex_lock(replication->order_mutex);
+
+		ret = execute(replication, replication_batch->batch, error);
+
+		if (ret)
+		{
+			jd_replication_ship(replication, g_steal_pointer(&(replication_batch->message)));
+		}
+
+		g_mutex_unlock(replication->order_mutex);
+	}
+
+	jd_replication_batch_free(replication_batch);
+
+	return ret;
+}
+
+static gboolean
+jd_replication_kv_execute(JdReplication* replication, gpointer batch, GError** error)
+{
+	(void)error;
+
+	return replication->original.kv.backend_batch_execute(replication->original.data, batch);
+}
+
+static gboolean
+jd_replication_kv_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* batch)
+{
+	gpointer original_batch = NULL;
+
+	if (!jd_replication_kv.original.kv.backend_batch_start(backend_data, namespace, semantics, &original_batch))
+	{
+		return FALSE;
+	}
+
+	*batch = jd_replication_batch_new(original_batch, namespace, semantics);
+
+	return TRUE;
+}
+
+static gboolean
+jd_replication_kv_batch_execute(gpointer backend_data, gpointer batch)
+{
+	(void)backend_data;
+
+	return jd_replication_batch_execute(&jd_replication_kv, batch, jd_replication_kv_execute, NULL);
+}
+
+static gboolean
+jd_replication_kv_batch_abort(gpointer backend_data, gpointer batch)
+{
+	JdReplicationBatch* replication_batch = batch;
+	gboolean ret;
+
+	ret = jd_replication_kv.original.kv.backend_batch_abort(backend_data, replication_batch->batch);
+	jd_replication_batch_free(replication_batch);
+
+	return ret;
+}
+
+static void
+jd_replication_kv_record_put(JdReplicationBatch* replication_batch, gchar const* key, gconstpointer value, guint32 value_len)
+{
+	jd_replication_batch_record(&jd_replication_kv, replication_batch, JD_REPLICATION_KV_PUT, key, 4 + value_len);
+	j_message_append_4(replication_batch->message, &value_len);
+	j_message_append_n(replication_batch->message, value, value_len);
+}
+
+static gboolean
+jd_replication_kv_put(gpointer backend_data, gpointer batch, gchar const* key, gconstpointer value, guint32 value_len)
+{
+	JdReplicationBatch* replication_batch = batch;
+	gboolean ret;
+
+	ret = jd_replication_kv.original.kv.backend_put(backend_data, replication_batch->batch, key, value, value_len);
+
+	if (ret)
+	{
+		jd_replication_kv_record_put(replication_batch, key, value, value_len);
+	}
+
+	return ret;
+}
+
+static gboolean
+jd_replication_kv_delete(gpointer backend_data, gpointer batch, gchar const* key)
+{
+	JdReplicationBatch* replication_batch = batch;
+	gboolean ret;
+
+	ret = jd_replication_kv.original.kv.backend_delete(backend_data, replication_batch->batch, key);
+
+	if (ret)
+	{
+		jd_replication_batch_record(&jd_replication_kv, replication_batch, JD_REPLICATION_KV_DELETE, key, 0);
+	}
+
+	return ret;
+}
+
+static gboolean
+jd_replication_kv_get(gpointer backend_data, gpointer batch, gchar const* key, gpointer* value, guint32* value_len)
+{
+	JdReplicationBatch* replication_batch = batch;
+
+	return jd_replication_kv.original.kv.backend_get(backend_data, replication_batch->batch, key, value, value_len);
+}
+
+static gboolean
+jd_replication_kv_get_multi(gpointer backend_data, gpointer batch, gchar const** keys, guint32 count, gpointer* values, guint32* value_lens)
+{
+	JdReplicationBatch* replication_batch = batch;
+
+	return jd_replication_kv.original.kv.backend_get_multi(backend_data, replication_batch->batch, keys, count, values, value_lens);
+}
+
+static gboolean
+jd_replication_kv_compare_and_swap(gpointer backend_data, gpointer batch, gchar const* key, gconstpointer expected, guint32 expected_len, gconstpointer value, guint32 value_len, gboolean* swapped)
+{
+	JdReplicationBatch* replication_batch = batch;
+	gboolean ret;
+
+	ret = jd_replication_kv.original.kv.backend_compare_and_swap(backend_data, replication_batch->batch, key, expected, expected_len, value, value_len, swapped);
+
+	// Replicas only need the outcome, so the swap is shipped as a put.
+	if (ret && *swapped)
+	{
+		jd_replication_kv_record_put(replication_batch, key, value, value_len);
+	}
+
+	return ret;
+}
+
+static gboolean
+jd_replication_kv_add(gpointer backend_data, gpointer batch, gchar const* key, gint64 delta, gint64* result)
+{
+	JdReplicationBatch* replication_batch = batch;
+	gboolean ret;
+
+	ret = jd_replication_kv.original.kv.backend_add(backend_data, replication_batch->batch, key, delta, result);
+
+	// Replicas only need the outcome, so the addition is shipped as a put of the counter's new value.
+	if (ret)
+	{
+		gint64 sum;
+
+		sum = GINT64_TO_LE(*result);
+		jd_replication_kv_record_put(replication_batch, key, &sum, sizeof(sum));
+	}
+
+	return ret;
+}
+
+static gboolean
+jd_replication_db_execute(JdReplication* replication, gpointer batch, GError** error)
+{
+	return replication->original.db.backend_batch_execute(replication->original.data, batch, error);
+}
+
+static gboolean
+jd_replication_db_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* batch, GError** error)
+{
+	gpointer original_batch = NULL;
+
+	if (!jd_replication_db.original.db.backend_batch_start(backend_data, namespace, semantics, &original_batch, error))
+	{
+		return FALSE;
+	}
+
+	*batch = jd_replication_batch_new(original_batch, namespace, semantics);
+
+	return TRUE;
+}
+
+static gboolean
+jd_replication_db_batch_execute(gpointer backend_data, gpointer batch, GError** error)
+{
+	(void)backend_data;
+
+	return jd_replication_batch_execute(&jd_replication_db, batch, jd_replication_db_execute, error);
+}
+
+static gboolean
+jd_replication_db_batch_abort(gpointer backend_data, gpointer batch, GError** error)
+{
+	JdReplicationBatch* replication_batch = batch;
+	gboolean ret;
+
+	ret = jd_replication_db.original.db.backend_batch_abort(backend_data, replication_batch->batch, error);
+	jd_replication_batch_free(replication_batch);
+
+	return ret;
+}
+
+static gboolean
+jd_replication_db_schema_create(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* schema, GError** error)
+{
+	JdReplicationBatch* replication_batch = batch;
+	gboolean ret;
+
+	ret = jd_replication_db.original.db.backend_schema_create(backend_data, replication_batch->batch, name, schema, error);
+
+	if (ret)
+	{
+		jd_replication_batch_record(&jd_replication_db, replication_batch, JD_REPLICATION_DB_SCHEMA_CREATE, name, jd_replication_bson_length(schema));
+		jd_replication_append_bson(replication_batch->message, schema);
+	}
+
+	return ret;
+}
+
+static gboolean
+jd_replication_db_schema_get(gpointer backend_data, gpointer batch, gchar const* name, bson_t* schema, GError** error)
+{
+	JdReplicationBatch* replication_batch = batch;
+
+	return jd_replication_db.original.db.backend_schema_get(backend_data, replication_batch->batch, name, schema, error);
+}
+
+static gboolean
+jd_replication_db_schema_delete(gpointer backend_data, gpointer batch, gchar const* name, GError** error)
+{
+	JdReplicationBatch* replication_batch = batch;
+	gboolean ret;
+
+	ret = jd_replication_db.original.db.backend_schema_delete(backend_data, replication_batch->batch, name, error);
+
+	if (ret)
+	{
+		jd_replication_batch_record(&jd_replication_db, replication_batch, JD_REPLICATION_DB_SCHEMA_DELETE, name, 0);
+	}
+
+	return ret;
+}
+
+static void
+jd_replication_db_record_insert(JdReplicationBatch* replication_batch, gchar const* name, bson_t const* metadata)
+{
+	jd_replication_batch_record(&jd_replication_db, replication_batch, JD_REPLICATION_DB_INSERT, name, jd_replication_bson_length(metadata));
+	jd_replication_append_bson(replication_batch->message, metadata);
+}
+
+static gboolean
+jd_replication_db_insert(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* metadata, bson_t* id, GError** error)
+{
+	JdReplicationBatch* replication_batch = batch;
+	gboolean ret;
+
+	ret = jd_replication_db.original.db.backend_insert(backend_data, replication_batch->batch, name, metadata, id, error);
+
+	if (ret)
+	{
+		jd_replication_db_record_insert(replication_batch, name, metadata);
+	}
+
+	return ret;
+}
+
+static gboolean
+jd_replication_db_insert_multi(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* const* metadata, guint count, bson_t* ids, GError** error)
+{
+	JdReplicationBatch* replication_batch = batch;
+	gboolean ret;
+
+	ret = jd_replication_db.original.db.backend_insert_multi(backend_data, replication_batch->batch, name, metadata, count, ids, error);
+
+	// Replicas insert the entries one by one in the same order, so that they are assigned the same IDs.
+	if (ret)
+	{
+		for (guint i = 0; i < count; i++)
+		{
+			jd_replication_db_record_insert(replication_batch, name, metadata[i]);
+		}
+	}
+
+	return ret;
+}
+
+static gboolean
+jd_replication_db_update(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* selector, bson_t const* metadata, GError** error)
+{
+	JdReplicationBatch* replication_batch = batch;
+	gboolean ret;
+
+	ret = jd_replication_db.original.db.backend_update(backend_data, replication_batch->batch, name, selector, metadata, error);
+
+	if (ret)
+	{
+		jd_replication_batch_record(&jd_replication_db, replication_batch, JD_REPLICATION_DB_UPDATE, name, jd_replication_bson_length(selector) + jd_replication_bson_length(metadata));
+		jd_replication_append_bson(replication_batch->message, selector);
+		jd_replication_append_bson(replication_batch->message, metadata);
+	}
+
+	return ret;
+}
+
+static gboolean
+jd_replication_db_delete(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* selector, GError** error)
+{
+	JdReplicationBatch* replication_batch = batch;
+	gboolean ret;
+
+	ret = jd_replication_db.original.db.backend_delete(backend_data, replication_batch->batch, name, selector, error);
+
+	if (ret)
+	{
+		jd_replication_batch_record(&jd_replication_db, replication_batch, JD_REPLICATION_DB_DELETE, name, jd_replication_bson_length(selector));
+		jd_replication_append_bson(replication_batch->message, selector);
+	}
+
+	return ret;
+}
+
+static gboolean
+jd_replication_db_query(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* selector, gpointer* iterator, GError** error)
+{
+	JdReplicationBatch* replication_batch = batch;
+
+	return jd_replication_db.original.db.backend_query(backend_data, replication_batch->batch, name, selector, iterator, error);
+}
+
+static gboolean
+jd_replication_db_query_fields(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* selector, bson_t const* fields, gpointer* iterator, GError** error)
+{
+	JdReplicationBatch* replication_batch = batch;
+
+	return jd_replication_db.original.db.backend_query_fields(backend_data, replication_batch->batch, name, selector, fields, iterator, error);
+}
+
+static gboolean
+jd_replication_db_aggregate(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* selector, bson_t const* aggregation, gpointer* iterator, GError** error)
+{
+	JdReplicationBatch* replication_batch = batch;
+
+	return jd_replication_db.original.db.backend_aggregate(backend_data, replication_batch->batch, name, selector, aggregation, iterator, error);
+}
+
+static gboolean
+jd_replication_db_advise_indexes(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* options, bson_t* advice, GError** error)
+{
+	JdReplicationBatch* replication_batch = batch;
+
+	// Indexes only affect performance, so replicas decide on their own.
+	return jd_replication_db.original.db.backend_advise_indexes(backend_data, replication_batch->batch, name, options, advice, error);
+}
+
+/**
+ * Ships a batch's changes to a replica and waits for them to be applied.
+ *
+ * \private
+ *
+ * \param replication A replicated backend.
+ * \param i           The replica's index.
+ * \param message     The changes.
+ *
+ * \return TRUE on success, FALSE if the replica is unreachable.
+ **/
+static gboolean
+jd_replication_send(JdReplication* replication, guint i, JMessage* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JMessage) reply = NULL;
+
+	if (replication->connections[i] == NULL)
+	{
+		g_autoptr(GError) error = NULL;
+
+		if ((replication->connections[i] = j_transport_connect(replication->replicas[i], &error)) == NULL)
+		{
+			return FALSE;
+		}
+	}
+
+	reply = j_message_new_reply(message);
+
+	if (!j_message_send(message, replication->connections[i]) || !j_message_receive(reply, replication->connections[i]))
+	{
+		g_io_stream_close(G_IO_STREAM(replication->connections[i]), NULL, NULL);
+		g_clear_object(&(replication->connections[i]));
+
+		return FALSE;
+	}
+
+	if (j_message_get_count(reply) == 0 || j_message_get_4(reply) == 0)
+	{
+		g_warning("Replica %s could not apply changes.", replication->replicas[i]);
+	}
+
+	return TRUE;
+}
+
+static gpointer
+jd_replication_thread(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdReplication* replication = data;
+	g_autofree gboolean* shipped = NULL;
+
+	shipped = g_new0(gboolean, g_strv_length(replication->replicas));
+
+	g_mutex_lock(replication->mutex);
+
+	while (TRUE)
+	{
+		JMessage* message;
+		gboolean done = TRUE;
+
+		while (!replication->stop && g_queue_is_empty(replication->queue))
+		{
+			g_cond_wait(replication->cond, replication->mutex);
+		}
+
+		if (g_queue_is_empty(replication->queue))
+		{
+			break;
+		}
+
+		// Messages stay queued until all replicas have them, so that the backlog limit covers them, too.
+		message = g_queue_peek_head(replication->queue);
+
+		g_mutex_unlock(replication->mutex);
+
+		for (guint i = 0; replication->replicas[i] != NULL; i++)
+		{
+			if (!shipped[i])
+			{
+				shipped[i] = jd_replication_send(replication, i, message);
+				done = done && shipped[i];
+			}
+		}
+
+		g_mutex_lock(replication->mutex);
+
+		// Remaining changes are dropped when stopping, the replicas have to be brought up to date manually.
+		if (done || replication->stop)
+		{
+			g_queue_pop_head(replication->queue);
+			j_message_unref(message);
+
+			for (guint i = 0; replication->replicas[i] != NULL; i++)
+			{
+				shipped[i] = FALSE;
+			}
+		}
+		else
+		{
+			gint64 end_time;
+
+			end_time = g_get_monotonic_time() + JD_REPLICATION_RETRY * G_TIME_SPAN_MILLISECOND;
+
+			while (!replication->stop && g_cond_wait_until(replication->cond, replication->mutex, end_time))
+			{
+			}
+		}
+	}
+
+	g_mutex_unlock(replication->mutex);
+
+	return NULL;
+}
+
+/**
+ * Starts shipping a backend's changes to its replicas.
+ * The backend's functions are replaced, so that the changes of successful batches are recorded.
+ *
+ * \private
+ *
+ * \param backend  A kv or db backend.
+ * \param replicas The replicas' addresses.
+ **/
+void
+jd_replication_start(JBackend* backend, gchar const* const* replicas)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdReplication* replication;
+
+	g_return_if_fail(backend != NULL);
+	g_return_if_fail(replicas != NULL && replicas[0] != NULL);
+
+	replication = jd_replication_get(backend->type);
+
+	g_return_if_fail(replication->backend == NULL);
+
+	replication->backend = backend;
+	replication->original = *backend;
+	replication->replicas = g_strdupv((gchar**)replicas);
+	replication->connections = g_new0(gpointer, g_strv_length(replication->replicas));
+	replication->stop = FALSE;
+	replication->dropped = 0;
+
+	g_mutex_init(replication->order_mutex);
+	g_mutex_init(replication->mutex);
+	g_cond_init(replication->cond);
+	g_queue_init(replication->queue);
+
+	if (backend->type == J_BACKEND_TYPE_KV)
+	{
+		replication->message_type = J_MESSAGE_KV_REPLICATE;
+
+		backend->kv.backend_batch_start = jd_replication_kv_batch_start;
+		backend->kv.backend_batch_execute = jd_replication_kv_batch_execute;
+		backend->kv.backend_batch_abort = (backend->kv.backend_batch_abort != NULL) ? jd_replication_kv_batch_abort : NULL;
+		backend->kv.backend_put = jd_replication_kv_put;
+		backend->kv.backend_delete = jd_replication_kv_delete;
+		backend->kv.backend_get = jd_replication_kv_get;
+		backend->kv.backend_get_multi = (backend->kv.backend_get_multi != NULL) ? jd_replication_kv_get_multi : NULL;
+		backend->kv.backend_compare_and_swap = (backend->kv.backend_compare_and_swap != NULL) ? jd_replication_kv_compare_and_swap : NULL;
+		backend->kv.backend_add = (backend->kv.backend_add != NULL) ? jd_replication_kv_add : NULL;
+	}
+	else
+	{
+		replication->message_type = J_MESSAGE_DB_REPLICATE;
+
+		backend->db.backend_batch_start = jd_replication_db_batch_start;
+		backend->db.backend_batch_execute = jd_replication_db_batch_execute;
+		backend->db.backend_batch_abort = (backend->db.backend_batch_abort != NULL) ? jd_replication_db_batch_abort : NULL;
+		backend->db.backend_schema_create = jd_replication_db_schema_create;
+		backend->db.backend_schema_get = jd_replication_db_schema_get;
+		backend->db.backend_schema_delete = jd_replication_db_schema_delete;
+		backend->db.backend_insert = jd_replication_db_insert;
+		backend->db.backend_insert_multi = (backend->db.backend_insert_multi != NULL) ? jd_replication_db_insert_multi : NULL;
+		backend->db.backend_update = jd_replication_db_update;
+		backend->db.backend_delete = jd_replication_db_delete;
+		backend->db.backend_query = jd_replication_db_query;
+		backend->db.backend_query_fields = (backend->db.backend_query_fields != NULL) ? jd_replication_db_query_fields : NULL;
+		backend->db.backend_aggregate = (backend->db.backend_aggregate != NULL) ? jd_replication_db_aggregate : NULL;
+		backend->db.backend_advise_indexes = (backend->db.backend_advise_indexes != NULL) ? jd_replication_db_advise_indexes : NULL;
+	}
+
+	replication->thread = g_thread_new("julea-replication", jd_replication_thread, replication);
+}
+
+/**
+ * Stops shipping a backend's changes.
+ * Changes that cannot be shipped right away are dropped.
+ *
+ * \private
+ *
+ * \param backend A kv or db backend.
+ **/
+void
+jd_replication_stop(JBackend* backend)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdReplication* replication;
+
+	g_return_if_fail(backend != NULL);
+
+	replication = jd_replication_get(backend->type);
+
+	if (replication->backend != backend)
+	{
+		return;
+	}
+
+	g_mutex_lock(replication->mutex);
+	replication->stop = TRUE;
+	g_cond_signal(replication->cond);
+	g_mutex_unlock(replication->mutex);
+
+	g_thread_join(replication->thread);
+	replication->thread = NULL;
+
+	*backend = replication->original;
+	replication->backend = NULL;
+
+	for (guint i = 0; replication->replicas[i] != NULL; i++)
+	{
+		if (replication->connections[i] != NULL)
+		{
+			g_io_stream_close(G_IO_STREAM(replication->connections[i]), NULL, NULL);
+			g_object_unref(replication->connections[i]);
+		}
+	}
+
+	if (replication->dropped > 0)
+	{
+		g_warning("Replicas missed %" G_GUINT64_FORMAT " batches.", replication->dropped);
+	}
+
+	g_clear_pointer(&(replication->connections), g_free);
+	g_clear_pointer(&(replication->replicas), g_strfreev);
+
+	g_mutex_clear(replication->order_mutex);
+	g_mutex_clear(replication->mutex);
+	g_cond_clear(replication->cond);
+}
+
+/**
+ * Returns the backend used to apply changes received from a primary.
+ * If the server replicates the backend itself, the changes are not shipped again.
+ *
+ * \private
+ *
+ * \param backend A kv or db backend.
+ *
+ * \return The backend with its original functions.
+ **/
+static JBackend*
+jd_replication_local(JBackend* backend)
+{
+	JdReplication* replication;
+
+	replication = jd_replication_get(backend->type);
+
+	if (replication->backend == backend)
+	{
+		return &(replication->original);
+	}
+
+	return backend;
+}
+
+/**
+ * Applies changes shipped by a primary kv server.
+ *
+ * \private
+ *
+ * \param message   A J_MESSAGE_KV_REPLICATE message.
+ * \param semantics The semantics of the primary's batch.
+ *
+ * \return TRUE if all changes have been applied, FALSE otherwise.
+ **/
+gboolean
+jd_replication_apply_kv(JMessage* message, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBackend* backend;
+	JdKVBloom* bloom;
+	gchar const* namespace;
+	gpointer batch = NULL;
+	guint32 operation_count;
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(jd_kv_backend != NULL, FALSE);
+
+	backend = jd_replication_local(jd_kv_backend);
+	operation_count = j_message_get_count(message);
+	namespace = j_message_get_string(message);
+
+	if (!j_backend_kv_batch_start(backend, namespace, semantics, &batch))
+	{
+		return FALSE;
+	}
+
+	bloom = jd_kv_bloom_begin(namespace);
+
+	for (guint32 i = 0; i < operation_count; i++)
+	{
+		gchar const* key;
+		guint8 change;
+
+		change = (guint8)j_message_get_1(message);
+		key = j_message_get_string(message);
+
+		if (change == JD_REPLICATION_KV_PUT)
+		{
+			gconstpointer value;
+			guint32 len;
+
+			len = j_message_get_4(message);
+			value = j_message_get_n(message, len);
+
+			ret = j_backend_kv_put(backend, batch, key, value, len) && ret;
+			jd_kv_bloom_add(bloom, key);
+		}
+		else
+		{
+			// Keys might already be gone if an earlier batch has been applied twice.
+			j_backend_kv_delete(backend, batch, key);
+		}
+	}
+
+	ret = j_backend_kv_batch_execute(backend, batch) && ret;
+
+	jd_kv_bloom_end(bloom);
+
+	return ret;
+}
+
+/**
+ * Applies changes shipped by a primary db server.
+ *
+ * \private
+ *
+ * \param message   A J_MESSAGE_DB_REPLICATE message.
+ * \param semantics The semantics of the primary's batch.
+ *
+ * \return TRUE if all changes have been applied, FALSE otherwise.
+ **/
+gboolean
+jd_replication_apply_db(JMessage* message, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBackend* backend;
+	gchar const* namespace;
+	gpointer batch = NULL;
+	guint32 operation_count;
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(jd_db_backend != NULL, FALSE);
+
+	backend = jd_replication_local(jd_db_backend);
+	operation_count = j_message_get_count(message);
+	namespace = j_message_get_string(message);
+
+	if (!j_backend_db_batch_start(backend, namespace, semantics, &batch, NULL))
+	{
+		return FALSE;
+	}
+
+	for (guint32 i = 0; i < operation_count; i++)
+	{
+		g_autoptr(GError) error = NULL;
+		gchar const* name;
+		guint8 change;
+		bson_t selector[1];
+		bson_t metadata[1];
+		bson_t id[1];
+
+		change = (guint8)j_message_get_1(message);
+		name = j_message_get_string(message);
+
+		switch (change)
+		{
+			case JD_REPLICATION_DB_SCHEMA_CREATE:
+				ret = j_backend_db_schema_create(backend, batch, name, jd_replication_get_bson(message, metadata), &error) && ret;
+				break;
+			case JD_REPLICATION_DB_SCHEMA_DELETE:
+				ret = j_backend_db_schema_delete(backend, batch, name, &error) && ret;
+				break;
+			case JD_REPLICATION_DB_INSERT:
+				if (j_backend_db_insert(backend, batch, name, jd_replication_get_bson(message, metadata), id, &error))
+				{
+					bson_destroy(id);
+				}
+				else
+				{
+					ret = FALSE;
+				}
+
+				break;
+			case JD_REPLICATION_DB_UPDATE:
+			{
+				bson_t const* update_selector;
+
+				update_selector = jd_replication_get_bson(message, selector);
+				ret = j_backend_db_update(backend, batch, name, update_selector, jd_replication_get_bson(message, metadata), &error) && ret;
+			}
+			break;
+			case JD_REPLICATION_DB_DELETE:
+				ret = j_backend_db_delete(backend, batch, name, jd_replication_get_bson(message, selector), &error) && ret;
+				break;
+			default:
+				g_warn_if_reached();
+				ret = FALSE;
+		}
+
+		if (error != NULL)
+		{
+			g_debug("Could not apply replicated change to %s: %s", name, error->message);
+		}
+	}
+
+	ret = j_backend_db_batch_execute(backend, batch, NULL) && ret;
+
+	return ret;
+}
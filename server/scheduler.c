@@ -0,0 +1,364 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <julea.h>
+
+#include "server.h"
+
+/**
+ * Object data operations smaller than this many bytes are not queued.
+ * They are dominated by latency and would otherwise wait behind bulk transfers.
+ **/
+#define JD_SCHEDULER_SMALL_COST (64 * 1024)
+
+/**
+ * The cost a client may use up per round before the next client is served.
+ * Object data is accounted in bytes, key-value and database messages in operations.
+ **/
+static guint64 const jd_scheduler_quantum[JD_SCHEDULER_CLASSES] = {
+	1024 * 1024,
+	64,
+	64
+};
+
+/**
+ * A request waiting to be admitted.
+ **/
+struct JdSchedulerTicket
+{
+	guint64 cost;
+	gboolean admitted;
+};
+
+typedef struct JdSchedulerTicket JdSchedulerTicket;
+
+/**
+ * The state of a client within a class.
+ **/
+struct JdSchedulerQueue
+{
+	/**
+	 * Contains JdSchedulerTicket elements in arrival order.
+	 **/
+	GQueue tickets[1];
+
+	/**
+	 * The cost the client may still use in the current round.
+	 **/
+	guint64 deficit;
+
+	/**
+	 * Whether the client is part of its class's round.
+	 **/
+	gboolean active;
+};
+
+typedef struct JdSchedulerQueue JdSchedulerQueue;
+
+/**
+ * All connections from the same host share one client, so that opening more connections does not result in a larger share.
+ **/
+struct JdSchedulerClient
+{
+	gchar* host;
+	guint ref_count;
+
+	JdSchedulerQueue queues[JD_SCHEDULER_CLASSES];
+};
+
+/**
+ * Requests of the same class share a concurrency limit.
+ * Waiting requests are admitted using deficit round robin over all clients.
+ **/
+struct JdSchedulerClassState
+{
+	GMutex mutex[1];
+	GCond cond[1];
+
+	/**
+	 * The maximum number of concurrent requests, 0 for no limit.
+	 **/
+	guint limit;
+
+	/**
+	 * The number of currently admitted requests.
+	 **/
+	guint admitted;
+
+	/**
+	 * The clients with waiting requests, in round robin order.
+	 * Contains JdSchedulerClient elements.
+	 **/
+	GQueue round[1];
+};
+
+typedef struct JdSchedulerClassState JdSchedulerClassState;
+
+static struct
+{
+	JdSchedulerClassState classes[JD_SCHEDULER_CLASSES];
+
+	/**
+	 * Maps host names to clients.
+	 * Protected by mutex.
+	 **/
+	GHashTable* clients;
+	GMutex mutex[1];
+} jd_scheduler;
+
+/**
+ * Admits waiting requests as long as the class's limit allows.
+ * The class's mutex has to be held.
+ *
+ * \private
+ **/
+static void
+jd_scheduler_dispatch(JdSchedulerClass class)
+{
+	JdSchedulerClassState* state = &(jd_scheduler.classes[class]);
+	gboolean admitted = FALSE;
+
+	while (state->admitted < state->limit && !g_queue_is_empty(state->round))
+	{
+		JdSchedulerClient* client = g_queue_peek_head(state->round);
+		JdSchedulerQueue* queue = &(client->queues[class]);
+		JdSchedulerTicket* ticket = g_queue_peek_head(queue->tickets);
+
+		if (queue->deficit < ticket->cost)
+		{
+			// The client has used up its share of this round, the next client is served.
+			queue->deficit += jd_scheduler_quantum[class];
+			g_queue_push_tail(state->round, g_queue_pop_head(state->round));
+			continue;
+		}
+
+		g_queue_pop_head(queue->tickets);
+		queue->deficit -= ticket->cost;
+		ticket->admitted = TRUE;
+		state->admitted++;
+		admitted = TRUE;
+
+		if (g_queue_is_empty(queue->tickets))
+		{
+			// Idle clients do not keep their share.
+			g_queue_pop_head(state->round);
+			queue->deficit = 0;
+			queue->active = FALSE;
+		}
+	}
+
+	if (admitted)
+	{
+		g_cond_broadcast(state->cond);
+	}
+}
+
+/**
+ * Sets the concurrency limits.
+ *
+ * \param limits The maximum number of concurrent requests per class, 0 or less for no limit.
+ **/
+void
+jd_scheduler_init(gint const* limits)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	for (guint i = 0; i < JD_SCHEDULER_CLASSES; i++)
+	{
+		JdSchedulerClassState* state = &(jd_scheduler.classes[i]);
+
+		g_mutex_init(state->mutex);
+		g_cond_init(state->cond);
+		g_queue_init(state->round);
+		state->limit = MAX(0, limits[i]);
+		state->admitted = 0;
+	}
+
+	g_mutex_init(jd_scheduler.mutex);
+	jd_scheduler.clients = g_hash_table_new(g_str_hash, g_str_equal);
+}
+
+/**
+ * Admits all waiting requests, so that connections still being handled do not block shutdown.
+ * The scheduler's state is kept, since these connections still use it.
+ **/
+void
+jd_scheduler_fini(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	for (guint i = 0; i < JD_SCHEDULER_CLASSES; i++)
+	{
+		JdSchedulerClassState* state = &(jd_scheduler.classes[i]);
+
+		g_mutex_lock(state->mutex);
+
+		if (state->limit > 0)
+		{
+			state->limit = G_MAXUINT;
+			jd_scheduler_dispatch(i);
+		}
+
+		g_mutex_unlock(state->mutex);
+	}
+}
+
+/**
+ * Returns the client a connection belongs to.
+ *
+ * \param connection A connection.
+ *
+ * \return The client. Should be released with jd_scheduler_client_unref().
+ **/
+JdSchedulerClient*
+jd_scheduler_client_ref(GSocketConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GSocketAddress) address = NULL;
+	g_autofree gchar* host = NULL;
+	JdSchedulerClient* client;
+
+	address = g_socket_connection_get_remote_address(connection, NULL);
+
+	if (address != NULL && G_IS_INET_SOCKET_ADDRESS(address))
+	{
+		host = g_inet_address_to_string(g_inet_socket_address_get_address(G_INET_SOCKET_ADDRESS(address)));
+	}
+	else
+	{
+		// Local connections (for example, via Unix sockets) all belong to one client.
+		host = g_strdup("local");
+	}
+
+	g_mutex_lock(jd_scheduler.mutex);
+
+	if ((client = g_hash_table_lookup(jd_scheduler.clients, host)) == NULL)
+	{
+		client = g_slice_new0(JdSchedulerClient);
+		client->host = g_steal_pointer(&host);
+		client->ref_count = 0;
+
+		for (guint i = 0; i < JD_SCHEDULER_CLASSES; i++)
+		{
+			g_queue_init(client->queues[i].tickets);
+		}
+
+		g_hash_table_insert(jd_scheduler.clients, client->host, client);
+	}
+
+	client->ref_count++;
+
+	g_mutex_unlock(jd_scheduler.mutex);
+
+	return client;
+}
+
+void
+jd_scheduler_client_unref(JdSchedulerClient* client)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(client != NULL);
+
+	g_mutex_lock(jd_scheduler.mutex);
+
+	client->ref_count--;
+
+	if (client->ref_count == 0)
+	{
+		g_hash_table_remove(jd_scheduler.clients, client->host);
+
+		g_free(client->host);
+		g_slice_free(JdSchedulerClient, client);
+	}
+
+	g_mutex_unlock(jd_scheduler.mutex);
+}
+
+/**
+ * Waits until a request may access its backend.
+ * Has to be followed by jd_scheduler_leave() with the same arguments.
+ *
+ * \param client A client.
+ * \param class  The request's class.
+ * \param cost   The request's cost, in bytes for object data and in operations otherwise.
+ **/
+void
+jd_scheduler_enter(JdSchedulerClient* client, JdSchedulerClass class, guint64 cost)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdSchedulerClassState* state = &(jd_scheduler.classes[class]);
+	JdSchedulerQueue* queue = &(client->queues[class]);
+	JdSchedulerTicket ticket;
+
+	if (state->limit == 0 || (class == JD_SCHEDULER_OBJECT && cost < JD_SCHEDULER_SMALL_COST))
+	{
+		return;
+	}
+
+	ticket.cost = cost;
+	ticket.admitted = FALSE;
+
+	g_mutex_lock(state->mutex);
+
+	g_queue_push_tail(queue->tickets, &ticket);
+
+	if (!queue->active)
+	{
+		queue->active = TRUE;
+		g_queue_push_tail(state->round, client);
+	}
+
+	jd_scheduler_dispatch(class);
+
+	while (!ticket.admitted)
+	{
+		g_cond_wait(state->cond, state->mutex);
+	}
+
+	g_mutex_unlock(state->mutex);
+}
+
+void
+jd_scheduler_leave(JdSchedulerClient* client, JdSchedulerClass class, guint64 cost)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdSchedulerClassState* state = &(jd_scheduler.classes[class]);
+
+	(void)client;
+
+	if (state->limit == 0 || (class == JD_SCHEDULER_OBJECT && cost < JD_SCHEDULER_SMALL_COST))
+	{
+		return;
+	}
+
+	g_mutex_lock(state->mutex);
+
+	state->admitted--;
+	jd_scheduler_dispatch(class);
+
+	g_mutex_unlock(state->mutex);
+}
@@ -16,185 +16,1338 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+// Required for pthread_setaffinity_np().
+#define _GNU_SOURCE
+
 #include <julea-config.h>
 
-#include <glib.h>
-#include <glib/gstdio.h>
-#include <glib-unix.h>
-#include <glib-object.h>
-#include <gio/gio.h>
-#include <gmodule.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <glib-unix.h>
+#include <glib-object.h>
+#include <gio/gio.h>
+#include <gmodule.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <locale.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <julea.h>
+
+#include "server.h"
+
+JBackend* jd_object_backend = NULL;
+JBackend* jd_kv_backend = NULL;
+JBackend* jd_db_backend = NULL;
+
+gchar* jd_object_path = NULL;
+gboolean jd_object_lazy_create = FALSE;
+gboolean jd_object_checksums_enabled = FALSE;
+gboolean jd_object_dedup_enabled = FALSE;
+
+/**
+ * The current configuration, replaced when it is reloaded.
+ **/
+static JConfiguration* jd_configuration = NULL;
+
+/**
+ * Configurations replaced by a reload.
+ * Connections might still use them, so they are kept until the server exits.
+ **/
+static GSList* jd_configurations_old = NULL;
+
+/**
+ * The time in microseconds after which an idle connection releases its additional receive memory.
+ **/
+#define JD_CONNECTION_IDLE_TIMEOUT G_TIME_SPAN_SECOND
+
+/**
+ * The environment variables used to hand the listening sockets to a new server process.
+ * The first one contains the sockets' file descriptors separated by commas.
+ * The second one contains one end of a socket pair used to coordinate both processes.
+ **/
+#define JD_RESTART_LISTEN_FDS "JULEA_SERVER_LISTEN_FDS"
+#define JD_RESTART_HANDOFF_FD "JULEA_SERVER_HANDOFF_FD"
+
+/**
+ * The time in microseconds a restarting server waits for its connections to be closed.
+ **/
+#define JD_RESTART_DRAIN_TIMEOUT (30 * G_TIME_SPAN_SECOND)
+
+/**
+ * The executable followed by the arguments the server was started with, used to start the new process on restart.
+ **/
+static gchar** jd_arguments = NULL;
+
+/**
+ * A socket service accepting connections.
+ * The first listener uses the main loop, additional ones have their own thread.
+ **/
+struct JdListener
+{
+	GSocketService* service;
+
+	/**
+	 * The context accepting connections, NULL for the main loop's.
+	 **/
+	GMainContext* context;
+	GMainLoop* main_loop;
+	GThread* thread;
+};
+
+typedef struct JdListener JdListener;
+
+/**
+ * The listeners, all listening on the same port.
+ * Contains JdListener elements.
+ **/
+static GPtrArray* jd_listeners = NULL;
+
+/**
+ * The sockets the server listens on.
+ * Contains GSocket elements.
+ **/
+static GPtrArray* jd_listen_sockets = NULL;
+
+/**
+ * The server's end of the socket pair shared with a new server process, -1 if no restart is in progress.
+ * It is closed implicitly when the server exits, which tells the new process to initialize its backends.
+ **/
+static gint jd_restart_fd = -1;
+
+/**
+ * When the server stops waiting for its connections to be closed.
+ **/
+static gint64 jd_drain_deadline = 0;
+
+static gboolean
+jd_signal(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GMainLoop* main_loop = data;
+
+	if (g_main_loop_is_running(main_loop))
+	{
+		g_main_loop_quit(main_loop);
+	}
+
+	return FALSE;
+}
+
+/**
+ * The state of a client connection.
+ **/
+struct JdConnection
+{
+	GSocketConnection* connection;
+	JMessage* message;
+
+	/**
+	 * Created by the first thread handling a message, so that it is allocated on that thread's NUMA node.
+	 **/
+	JMemoryChunk* memory_chunk;
+
+	guint64 memory_chunk_size;
+	JdObjectHandles* object_handles;
+	JdSchedulerClient* scheduler_client;
+
+	/**
+	 * The NUMA node whose threads handle the connection.
+	 **/
+	guint numa_node;
+
+	/**
+	 * When the connection became readable, only used in event-driven mode.
+	 **/
+	gint64 ready_time;
+
+	/**
+	 * The source waiting for the next message, only used in event-driven mode.
+	 * NULL while a worker handles the connection.
+	 * Protected by jd_connections_mutex.
+	 **/
+	GSource* watch;
+};
+
+typedef struct JdConnection JdConnection;
+
+/**
+ * The worker threads used in event-driven mode, one pool per NUMA node, NULL otherwise.
+ * Contains GThreadPool elements.
+ **/
+static GPtrArray* jd_workers = NULL;
+
+/**
+ * The CPUs of each NUMA node, NULL if the server is not NUMA-aware.
+ * Contains GArray elements of guint.
+ **/
+static GPtrArray* jd_numa_nodes = NULL;
+
+/**
+ * The number of connections assigned to NUMA nodes so far.
+ **/
+static gint jd_numa_assigned = 0;
+
+/**
+ * The NUMA node (plus one) the current thread is bound to.
+ **/
+static GPrivate jd_numa_current;
+
+/**
+ * The currently established connections.
+ * Protected by jd_connections_mutex.
+ **/
+static GPtrArray* jd_connections = NULL;
+static GMutex jd_connections_mutex[1] = { 0 };
+
+/**
+ * Whether the server is about to exit and closes connections once they are idle.
+ * Protected by jd_connections_mutex.
+ **/
+static gboolean jd_draining = FALSE;
+
+/**
+ * The statistics of a thread handling messages.
+ **/
+struct JdThreadStatistics
+{
+	/**
+	 * The statistics, only modified by the owning thread.
+	 **/
+	JStatistics* statistics;
+
+	/**
+	 * The next thread's statistics.
+	 **/
+	struct JdThreadStatistics* next;
+
+	/**
+	 * Whether a thread currently owns the statistics.
+	 * Statistics of exited threads are kept for their totals and reused by new threads.
+	 **/
+	gint in_use;
+};
+
+typedef struct JdThreadStatistics JdThreadStatistics;
+
+static void jd_thread_statistics_release(gpointer);
+
+/**
+ * All threads' statistics, kept until the server exits.
+ * Threads only ever prepend to this list, so it can be read without locking.
+ **/
+static JdThreadStatistics* jd_thread_statistics = NULL;
+
+static GPrivate jd_thread_statistics_current = G_PRIVATE_INIT(jd_thread_statistics_release);
+
+/**
+ * The number of established connections.
+ **/
+static gint jd_connection_count = 0;
+
+static void
+jd_thread_statistics_release(gpointer data)
+{
+	JdThreadStatistics* thread_statistics = data;
+
+	g_atomic_int_set(&(thread_statistics->in_use), 0);
+}
+
+/**
+ * Returns the statistics of the current thread.
+ *
+ * \return The statistics.
+ **/
+static JStatistics*
+jd_thread_statistics_get(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdThreadStatistics* thread_statistics;
+
+	if (G_LIKELY((thread_statistics = g_private_get(&jd_thread_statistics_current)) != NULL))
+	{
+		return thread_statistics->statistics;
+	}
+
+	// Reuse the statistics of an exited thread, if any.
+	for (thread_statistics = g_atomic_pointer_get(&jd_thread_statistics); thread_statistics != NULL; thread_statistics = thread_statistics->next)
+	{
+		if (g_atomic_int_compare_and_exchange(&(thread_statistics->in_use), 0, 1))
+		{
+			break;
+		}
+	}
+
+	if (thread_statistics == NULL)
+	{
+		thread_statistics = g_slice_new(JdThreadStatistics);
+		thread_statistics->statistics = j_statistics_new(TRUE);
+		thread_statistics->in_use = 1;
+
+		do
+		{
+			thread_statistics->next = g_atomic_pointer_get(&jd_thread_statistics);
+		} while (!g_atomic_pointer_compare_and_exchange(&jd_thread_statistics, thread_statistics->next, thread_statistics));
+	}
+
+	g_private_set(&jd_thread_statistics_current, thread_statistics);
+
+	return thread_statistics->statistics;
+}
+
+/**
+ * Parses a CPU list as found in sysfs, for example, \c 0-3,8-11.
+ *
+ * \return A new array of CPUs. Should be freed with g_array_unref().
+ **/
+static GArray*
+jd_numa_parse_cpulist(gchar const* cpulist)
+{
+	g_auto(GStrv) ranges = NULL;
+	GArray* cpus;
+
+	cpus = g_array_new(FALSE, FALSE, sizeof(guint));
+	ranges = g_strsplit(g_strstrip((gchar*)cpulist), ",", 0);
+
+	for (guint i = 0; ranges[i] != NULL; i++)
+	{
+		guint first;
+		guint last;
+		gint matched;
+
+		matched = sscanf(ranges[i], "%u-%u", &first, &last);
+
+		if (matched < 1)
+		{
+			continue;
+		}
+
+		if (matched == 1)
+		{
+			last = first;
+		}
+
+		for (guint cpu = first; cpu <= last; cpu++)
+		{
+			g_array_append_val(cpus, cpu);
+		}
+	}
+
+	return cpus;
+}
+
+/**
+ * Reads the NUMA topology from sysfs.
+ * Nodes without CPUs (for example, memory-only ones) are ignored.
+ *
+ * \return TRUE if at least one node was found, FALSE otherwise.
+ **/
+static gboolean
+jd_numa_init(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GDir) dir = NULL;
+	gchar const* name;
+
+	if ((dir = g_dir_open("/sys/devices/system/node", 0, NULL)) == NULL)
+	{
+		return FALSE;
+	}
+
+	jd_numa_nodes = g_ptr_array_new_with_free_func((GDestroyNotify)g_array_unref);
+
+	while ((name = g_dir_read_name(dir)) != NULL)
+	{
+		g_autofree gchar* path = NULL;
+		g_autofree gchar* cpulist = NULL;
+		GArray* cpus;
+
+		if (!g_str_has_prefix(name, "node") || !g_ascii_isdigit(name[4]))
+		{
+			continue;
+		}
+
+		path = g_build_filename("/sys/devices/system/node", name, "cpulist", NULL);
+
+		if (!g_file_get_contents(path, &cpulist, NULL, NULL))
+		{
+			continue;
+		}
+
+		cpus = jd_numa_parse_cpulist(cpulist);
+
+		if (cpus->len == 0)
+		{
+			g_array_unref(cpus);
+			continue;
+		}
+
+		g_ptr_array_add(jd_numa_nodes, cpus);
+	}
+
+	if (jd_numa_nodes->len == 0)
+	{
+		g_ptr_array_unref(jd_numa_nodes);
+		jd_numa_nodes = NULL;
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Returns the NUMA node the next connection should be handled on.
+ * Connections are distributed round-robin over all nodes.
+ **/
+static guint
+jd_numa_assign(void)
+{
+	if (jd_numa_nodes == NULL)
+	{
+		return 0;
+	}
+
+	return (guint)g_atomic_int_add(&jd_numa_assigned, 1) % jd_numa_nodes->len;
+}
+
+/**
+ * Binds the current thread to the CPUs of a NUMA node.
+ * Memory the thread touches first is then allocated on that node by the kernel.
+ **/
+static void
+jd_numa_bind(guint node)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (jd_numa_nodes == NULL || GPOINTER_TO_UINT(g_private_get(&jd_numa_current)) == node + 1)
+	{
+		return;
+	}
+
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+	{
+		GArray* cpus = g_ptr_array_index(jd_numa_nodes, node);
+		cpu_set_t cpu_set;
+
+		CPU_ZERO(&cpu_set);
+
+		for (guint i = 0; i < cpus->len; i++)
+		{
+			if (g_array_index(cpus, guint, i) < CPU_SETSIZE)
+			{
+				CPU_SET(g_array_index(cpus, guint, i), &cpu_set);
+			}
+		}
+
+		if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0)
+		{
+			g_warning("Could not bind thread to NUMA node %u.", node);
+		}
+	}
+#endif
+
+	g_private_set(&jd_numa_current, GUINT_TO_POINTER(node + 1));
+}
+
+static JdConnection*
+jd_connection_new(GSocketConnection* connection, guint numa_node)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdConnection* jd_connection;
+
+	j_helper_set_nodelay(connection, TRUE);
+
+	jd_connection = g_slice_new(JdConnection);
+	jd_connection->connection = g_object_ref(connection);
+	jd_connection->message = j_message_new(J_MESSAGE_NONE, 0);
+	jd_connection->memory_chunk_size = j_configuration_get_max_operation_size(g_atomic_pointer_get(&jd_configuration));
+	jd_connection->memory_chunk = NULL;
+	jd_connection->object_handles = jd_object_handles_new();
+	jd_connection->scheduler_client = jd_scheduler_client_ref(connection);
+	jd_connection->numa_node = numa_node;
+	jd_connection->ready_time = 0;
+	jd_connection->watch = NULL;
+
+	g_atomic_int_inc(&jd_connection_count);
+
+	g_mutex_lock(jd_connections_mutex);
+	g_ptr_array_add(jd_connections, jd_connection);
+	g_mutex_unlock(jd_connections_mutex);
+
+	return jd_connection;
+}
+
+static void
+jd_connection_free(JdConnection* jd_connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_mutex_lock(jd_connections_mutex);
+	g_ptr_array_remove_fast(jd_connections, jd_connection);
+	g_mutex_unlock(jd_connections_mutex);
+
+	g_atomic_int_add(&jd_connection_count, -1);
+
+	jd_object_handles_free(jd_connection->object_handles);
+	jd_scheduler_client_unref(jd_connection->scheduler_client);
+
+	if (jd_connection->memory_chunk != NULL)
+	{
+		j_memory_chunk_free(jd_connection->memory_chunk);
+	}
+
+	j_message_unref(jd_connection->message);
+	g_object_unref(jd_connection->connection);
+
+	g_slice_free(JdConnection, jd_connection);
+}
+
+/**
+ * Returns the statistics of all threads.
+ * The threads' statistics are summed without locking, so the totals are accurate at any time.
+ *
+ * \return A new statistics. Should be freed with j_statistics_free().
+ **/
+JStatistics*
+jd_statistics_get_all(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JStatistics* statistics;
+
+	statistics = j_statistics_new(FALSE);
+
+	for (JdThreadStatistics* thread_statistics = g_atomic_pointer_get(&jd_thread_statistics); thread_statistics != NULL; thread_statistics = thread_statistics->next)
+	{
+		j_statistics_merge(statistics, thread_statistics->statistics);
+	}
+
+	j_statistics_add(statistics, J_STATISTICS_CONNECTIONS, g_atomic_int_get(&jd_connection_count));
+
+	return statistics;
+}
+
+
+/**
+ * Returns the memory chunk usage of all established connections.
+ *
+ * \return A new array of JdMemoryChunkUsage. Should be freed with g_array_unref().
+ **/
+GArray*
+jd_memory_chunk_get_usage(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GArray* usage;
+
+	usage = g_array_new(FALSE, FALSE, sizeof(JdMemoryChunkUsage));
+
+	g_mutex_lock(jd_connections_mutex);
+
+	for (guint i = 0; i < jd_connections->len; i++)
+	{
+		JdConnection* jd_connection = g_ptr_array_index(jd_connections, i);
+		JdMemoryChunkUsage chunk_usage;
+
+		if (jd_connection->memory_chunk == NULL)
+		{
+			continue;
+		}
+
+		chunk_usage.size = j_memory_chunk_get_size(jd_connection->memory_chunk);
+		chunk_usage.peak = j_memory_chunk_get_peak(jd_connection->memory_chunk);
+
+		g_array_append_val(usage, chunk_usage);
+	}
+
+	g_mutex_unlock(jd_connections_mutex);
+
+	return usage;
+}
+
+/**
+ * Handles the message received on a connection.
+ * If the client sent a trace context, the server's spans continue the client's trace.
+ *
+ * This function is not traced itself, since its span would not be part of the client's trace.
+ **/
+static void
+jd_connection_handle_message(JdConnection* jd_connection, JdMessageTimes* times)
+{
+	JTraceContext trace_context;
+	gboolean traced;
+
+	traced = j_message_get_trace_context(jd_connection->message, &trace_context);
+
+	if (jd_connection->memory_chunk == NULL)
+	{
+		JConfiguration* configuration = g_atomic_pointer_get(&jd_configuration);
+
+		// The chunk starts at one operation and grows for large batches.
+		jd_connection->memory_chunk = j_memory_chunk_new_growable(jd_connection->memory_chunk_size, j_configuration_get_max_receive_size(configuration), j_configuration_get_receive_hugepages(configuration));
+	}
+
+	if (traced)
+	{
+		j_trace_context_set(&trace_context);
+	}
+
+	jd_handle_message(jd_connection->message, jd_connection->connection, jd_connection->memory_chunk, jd_connection->memory_chunk_size, jd_thread_statistics_get(), jd_connection->object_handles, jd_connection->scheduler_client, times);
+
+	if (traced)
+	{
+		j_trace_context_set(NULL);
+	}
+}
+
+static gboolean
+jd_on_run(GThreadedSocketService* service, GSocketConnection* connection, GObject* source_object, gpointer user_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdConnection* jd_connection;
+	GSocket* socket_;
+	guint numa_node;
+
+	(void)service;
+	(void)source_object;
+	(void)user_data;
+
+	numa_node = jd_numa_assign();
+	jd_numa_bind(numa_node);
+
+	jd_connection = jd_connection_new(connection, numa_node);
+	socket_ = g_socket_connection_get_socket(connection);
+
+	// Wait for the connection to become readable first, so that idle time is not accounted as receive time.
+	while (TRUE)
+	{
+		g_autoptr(GError) error = NULL;
+		JdMessageTimes times;
+
+		if (!g_socket_condition_timed_wait(socket_, G_IO_IN, JD_CONNECTION_IDLE_TIMEOUT, NULL, &error))
+		{
+			if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT))
+			{
+				gboolean draining;
+
+				g_mutex_lock(jd_connections_mutex);
+				draining = jd_draining;
+				g_mutex_unlock(jd_connections_mutex);
+
+				// Idle connections are closed when the server exits, clients reconnect to the new server process.
+				if (draining)
+				{
+					break;
+				}
+
+				if (jd_connection->memory_chunk != NULL)
+				{
+					j_memory_chunk_shrink(jd_connection->memory_chunk);
+				}
+
+				continue;
+			}
+
+			break;
+		}
+
+		// The connection's own thread starts receiving immediately.
+		times.ready = g_get_monotonic_time();
+		times.receive = times.ready;
+
+		if (!j_message_receive(jd_connection->message, connection))
+		{
+			break;
+		}
+
+		times.received = g_get_monotonic_time();
+		jd_connection_handle_message(jd_connection, &times);
+	}
+
+	jd_connection_free(jd_connection);
+
+	return TRUE;
+}
+
+static void jd_connection_watch(JdConnection*);
+
+static gboolean
+jd_on_readable(GSocket* socket, GIOCondition condition, gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdConnection* jd_connection = data;
+
+	(void)socket;
+	(void)condition;
+
+	g_mutex_lock(jd_connections_mutex);
+	jd_connection->watch = NULL;
+	g_mutex_unlock(jd_connections_mutex);
+
+	jd_connection->ready_time = g_get_monotonic_time();
+	g_thread_pool_push(g_ptr_array_index(jd_workers, jd_connection->numa_node), jd_connection, NULL);
+
+	// The worker watches the connection again after handling the message.
+	return G_SOURCE_REMOVE;
+}
+
+/**
+ * Waits for the next message on a connection without blocking a thread.
+ * If the server is about to exit, the connection is closed instead.
+ **/
+static void
+jd_connection_watch(JdConnection* jd_connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GSource) source = NULL;
+	gboolean draining;
+
+	g_mutex_lock(jd_connections_mutex);
+
+	if (!(draining = jd_draining))
+	{
+		source = g_socket_create_source(g_socket_connection_get_socket(jd_connection->connection), G_IO_IN | G_IO_HUP | G_IO_ERR, NULL);
+		g_source_set_callback(source, (GSourceFunc)jd_on_readable, jd_connection, NULL);
+		g_source_attach(source, NULL);
+
+		jd_connection->watch = source;
+	}
+
+	g_mutex_unlock(jd_connections_mutex);
+
+	if (draining)
+	{
+		jd_connection_free(jd_connection);
+	}
+}
+
+static void
+jd_on_work(gpointer data, gpointer user_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdConnection* jd_connection = data;
+	JdMessageTimes times;
+
+	// Idle threads are shared between pools, so they might have been bound to another node.
+	jd_numa_bind(GPOINTER_TO_UINT(user_data));
+
+	// The time between the connection becoming readable and a worker picking it up is the queue time.
+	times.ready = jd_connection->ready_time;
+	times.receive = g_get_monotonic_time();
+
+	if (j_message_receive(jd_connection->message, jd_connection->connection))
+	{
+		times.received = g_get_monotonic_time();
+		jd_connection_handle_message(jd_connection, &times);
+
+		// Release additional receive memory if no further message is pending.
+		if (!(g_socket_condition_check(g_socket_connection_get_socket(jd_connection->connection), G_IO_IN) & G_IO_IN))
+		{
+			j_memory_chunk_shrink(jd_connection->memory_chunk);
+		}
+
+		jd_connection_watch(jd_connection);
+	}
+	else
+	{
+		jd_connection_free(jd_connection);
+	}
+}
+
+static gboolean
+jd_on_incoming(GSocketService* service, GSocketConnection* connection, GObject* source_object, gpointer user_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	(void)service;
+	(void)source_object;
+	(void)user_data;
+
+	jd_connection_watch(jd_connection_new(connection, jd_numa_assign()));
+
+	return TRUE;
+}
+
+static gboolean
+jd_daemon(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gint fd;
+	pid_t pid;
+
+	pid = fork();
+
+	if (pid > 0)
+	{
+		g_message("Daemon started as process %d.", pid);
+		g_message("Log messages will be redirected to journald if possible. To view them, use journalctl GLIB_DOMAIN=%s.", G_LOG_DOMAIN);
+		_exit(0);
+	}
+	else if (pid == -1)
+	{
+		return FALSE;
+	}
+
+	if (setsid() == -1)
+	{
+		return FALSE;
+	}
+
+	if (g_chdir("/") == -1)
+	{
+		return FALSE;
+	}
+
+	fd = open("/dev/null", O_RDWR);
+
+	if (fd == -1)
+	{
+		return FALSE;
+	}
+
+	if (dup2(fd, STDIN_FILENO) == -1 || dup2(fd, STDOUT_FILENO) == -1 || dup2(fd, STDERR_FILENO) == -1)
+	{
+		return FALSE;
+	}
+
+	if (fd > 2)
+	{
+		close(fd);
+	}
+
+	// Try to redirect GLib log messages to journald.
+	// They can be shown with: journalctl GLIB_DOMAIN=JULEA
+	g_log_set_writer_func(g_log_writer_journald, NULL, NULL);
+
+	return TRUE;
+}
+
+/**
+ * Returns the index of the server or replica listening on the given host and port.
+ *
+ * \param host         A host name.
+ * \param port         A port.
+ * \param backend_type A backend type.
+ *
+ * \return The index, -1 if the server is not configured for the backend type.
+ **/
+static gint
+jd_get_server_index(gchar const* host, gint port, JBackendType backend_type)
+{
+	guint count;
+
+	// Replicas follow the primaries.
+	count = j_configuration_get_server_count(jd_configuration, backend_type) + j_configuration_get_replica_count(jd_configuration, backend_type);
+
+	for (guint i = 0; i < count; i++)
+	{
+		g_autoptr(GNetworkAddress) address = NULL;
+		gchar const* addr_server;
+		gchar const* server;
+		guint16 addr_port;
+
+		server = j_configuration_get_server(jd_configuration, backend_type, i);
+		address = G_NETWORK_ADDRESS(g_network_address_parse(server, 4711, NULL));
+
+		addr_server = g_network_address_get_hostname(address);
+		addr_port = g_network_address_get_port(address);
+
+		if (g_strcmp0(host, addr_server) == 0 && port == addr_port)
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+static gboolean
+jd_is_server_for_backend(gchar const* host, gint port, JBackendType backend_type)
+{
+	return (jd_get_server_index(host, port, backend_type) >= 0);
+}
+
+/**
+ * Returns the addresses of the replicas that receive the changes of the server listening on the given host and port.
+ *
+ * \param host         A host name.
+ * \param port         A port.
+ * \param backend_type A backend type.
+ *
+ * \return The addresses, NULL if the server has no replicas.
+ **/
+static gchar**
+jd_get_replicas(gchar const* host, gint port, JBackendType backend_type)
+{
+	GPtrArray* replicas;
+	guint servers;
+	guint count;
+	gint index;
+
+	index = jd_get_server_index(host, port, backend_type);
+	servers = j_configuration_get_server_count(jd_configuration, backend_type);
+	count = j_configuration_get_replica_count(jd_configuration, backend_type);
+
+	if (index < 0 || (guint)index >= servers)
+	{
+		return NULL;
+	}
+
+	replicas = g_ptr_array_new();
+
+	// Replica r replicates the server with index r modulo servers.
+	for (guint r = index; r < count; r += servers)
+	{
+		g_ptr_array_add(replicas, g_strdup(j_configuration_get_server(jd_configuration, backend_type, servers + r)));
+	}
+
+	if (replicas->len == 0)
+	{
+		g_ptr_array_free(replicas, TRUE);
+		return NULL;
+	}
+
+	g_ptr_array_add(replicas, NULL);
+
+	return (gchar**)g_ptr_array_free(replicas, FALSE);
+}
+
+static void
+jd_on_listener_event(GSocketListener* listener, GSocketListenerEvent event, GSocket* socket, gpointer data)
+{
+	(void)listener;
+	(void)data;
+
+	if (event == G_SOCKET_LISTENER_LISTENED)
+	{
+		g_ptr_array_add(jd_listen_sockets, g_object_ref(socket));
+	}
+}
+
+static gpointer
+jd_listener_thread(gpointer data)
+{
+	JdListener* listener = data;
+
+	g_main_context_push_thread_default(listener->context);
+	g_main_loop_run(listener->main_loop);
+	g_main_context_pop_thread_default(listener->context);
+
+	return NULL;
+}
+
+/**
+ * Creates a listener.
+ *
+ * \param threaded   Whether each connection is handled by its own thread.
+ * \param own_thread Whether the listener accepts connections on its own thread instead of the main loop.
+ *
+ * \return A new listener. Should be freed with jd_listener_free().
+ **/
+static JdListener*
+jd_listener_new(gboolean threaded, gboolean own_thread)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdListener* listener;
+
+	listener = g_slice_new(JdListener);
+	listener->context = (own_thread) ? g_main_context_new() : NULL;
+	listener->main_loop = NULL;
+	listener->thread = NULL;
+
+	// Services accept connections on the context that is the thread-default one when they are set up.
+	g_main_context_push_thread_default(listener->context);
+	listener->service = (threaded) ? g_threaded_socket_service_new(-1) : g_socket_service_new();
+	g_main_context_pop_thread_default(listener->context);
+
+	g_socket_listener_set_backlog(G_SOCKET_LISTENER(listener->service), 128);
+	g_signal_connect(listener->service, "event", G_CALLBACK(jd_on_listener_event), NULL);
+
+	return listener;
+}
+
+/**
+ * Makes a listener accept connections.
+ *
+ * \param shared Whether the listener shares the port with a listener set up before.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+jd_listener_listen(JdListener* listener, gchar const* host, guint16 port, gboolean shared, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean listening;
+
+	g_main_context_push_thread_default(listener->context);
+
+	if (shared)
+	{
+		listening = j_transport_listen_shared(listener->service, host, port, error);
+	}
+	else
+	{
+		listening = j_transport_listen(listener->service, host, port, error);
+	}
+
+	g_main_context_pop_thread_default(listener->context);
+
+	return listening;
+}
+
+static void
+jd_listener_start(JdListener* listener)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_main_context_push_thread_default(listener->context);
+	g_socket_service_start(listener->service);
+	g_main_context_pop_thread_default(listener->context);
+
+	if (listener->context != NULL)
+	{
+		listener->main_loop = g_main_loop_new(listener->context, FALSE);
+		listener->thread = g_thread_new("julea-listener", jd_listener_thread, listener);
+	}
+}
+
+static void
+jd_listener_free(JdListener* listener)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_socket_service_stop(listener->service);
+
+	if (listener->thread != NULL)
+	{
+		g_main_loop_quit(listener->main_loop);
+		g_thread_join(listener->thread);
+		g_main_loop_unref(listener->main_loop);
+	}
+
+	g_object_unref(listener->service);
+
+	if (listener->context != NULL)
+	{
+		g_main_context_unref(listener->context);
+	}
+
+	g_slice_free(JdListener, listener);
+}
+
+/**
+ * Listens on the sockets handed over by a previous server process.
+ *
+ * \param fds The sockets' file descriptors, separated by commas.
+ *
+ * 
+eturn TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+jd_listen_adopt(gchar const* fds, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_auto(GStrv) fd_strs = NULL;
+
+	fd_strs = g_strsplit(fds, ",", 0);
+
+	for (guint i = 0; fd_strs[i] != NULL; i++)
+	{
+		g_autoptr(GSocket) socket_ = NULL;
+		JdListener* listener;
+		gboolean added;
+		guint64 fd;
+
+		if (!g_ascii_string_to_unsigned(fd_strs[i], 10, 0, G_MAXINT, &fd, error))
+		{
+			return FALSE;
+		}
 
-#include <locale.h>
-#include <string.h>
-#include <unistd.h>
+		// The socket has to be closed if the server itself is restarted later.
+		fcntl((gint)fd, F_SETFD, FD_CLOEXEC);
 
-#include <julea.h>
+		if ((socket_ = g_socket_new_from_fd((gint)fd, error)) == NULL)
+		{
+			return FALSE;
+		}
 
-#include "server.h"
+		// The sockets are distributed over the listeners, the kernel keeps distributing connections among the shared ones.
+		listener = g_ptr_array_index(jd_listeners, i % jd_listeners->len);
 
-JStatistics* jd_statistics = NULL;
-GMutex jd_statistics_mutex[1] = { 0 };
+		g_main_context_push_thread_default(listener->context);
+		added = g_socket_listener_add_socket(G_SOCKET_LISTENER(listener->service), socket_, NULL, error);
+		g_main_context_pop_thread_default(listener->context);
 
-JBackend* jd_object_backend = NULL;
-JBackend* jd_kv_backend = NULL;
-JBackend* jd_db_backend = NULL;
+		if (!added)
+		{
+			return FALSE;
+		}
 
-static JConfiguration* jd_configuration = NULL;
+		g_ptr_array_add(jd_listen_sockets, g_steal_pointer(&socket_));
+	}
 
-static gboolean
-jd_signal(gpointer data)
+	return TRUE;
+}
+
+/**
+ * Tells the previous server process that the listening sockets have been taken over and waits for it to exit.
+ * Backends are only initialized afterwards, since they might hold exclusive locks.
+ * New connections wait in the sockets' backlog in the meantime.
+ **/
+static void
+jd_restart_wait(gint fd)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	GMainLoop* main_loop = data;
+	gchar buffer = 1;
 
-	if (g_main_loop_is_running(main_loop))
+	// The previous process closes its end when exiting, which ends the wait.
+	if (write(fd, &buffer, 1) == 1)
 	{
-		g_main_loop_quit(main_loop);
+		g_message("Took over listening sockets, waiting for the previous server process to exit.");
+
+		gssize nbytes;
+
+		do
+		{
+			nbytes = read(fd, &buffer, 1);
+		} while (nbytes > 0 || (nbytes == -1 && errno == EINTR));
 	}
 
-	return FALSE;
+	close(fd);
 }
 
+/**
+ * Reloads the configuration.
+ * New connections use the new receive buffer settings, existing ones keep theirs.
+ * Backends and servers are only set up at startup, changing them requires a restart.
+ **/
 static gboolean
-jd_on_run(GThreadedSocketService* service, GSocketConnection* connection, GObject* source_object, gpointer user_data)
+jd_on_reload(gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JMemoryChunk* memory_chunk;
-	g_autoptr(JMessage) message = NULL;
-	JStatistics* statistics;
-	guint64 memory_chunk_size;
-
-	(void)service;
-	(void)source_object;
-	(void)user_data;
+	JConfiguration* configuration;
+	JConfiguration* configuration_old;
 
-	j_helper_set_nodelay(connection, TRUE);
+	(void)data;
 
-	statistics = j_statistics_new(TRUE);
-	memory_chunk_size = j_configuration_get_max_operation_size(jd_configuration);
-	memory_chunk = j_memory_chunk_new(memory_chunk_size);
+	if ((configuration = j_configuration_new()) == NULL)
+	{
+		g_warning("Could not reload configuration, keeping the current one.");
+		return G_SOURCE_CONTINUE;
+	}
 
-	message = j_message_new(J_MESSAGE_NONE, 0);
+	configuration_old = jd_configuration;
 
-	while (j_message_receive(message, connection))
+	for (JBackendType i = J_BACKEND_TYPE_OBJECT; i <= J_BACKEND_TYPE_DB; i++)
 	{
-		jd_handle_message(message, connection, memory_chunk, memory_chunk_size, statistics);
+		if (g_strcmp0(j_configuration_get_backend(configuration, i), j_configuration_get_backend(configuration_old, i)) != 0
+		    || g_strcmp0(j_configuration_get_backend_component(configuration, i), j_configuration_get_backend_component(configuration_old, i)) != 0
+		    || g_strcmp0(j_configuration_get_backend_path(configuration, i), j_configuration_get_backend_path(configuration_old, i)) != 0
+		    || j_configuration_get_server_count(configuration, i) != j_configuration_get_server_count(configuration_old, i))
+		{
+			g_warning("Backend or server changes only take effect after a restart.");
+			break;
+		}
 	}
 
-	{
-		guint64 value;
+	jd_configurations_old = g_slist_prepend(jd_configurations_old, configuration_old);
+	g_atomic_pointer_set(&jd_configuration, configuration);
 
-		g_mutex_lock(jd_statistics_mutex);
+	g_message("Reloaded configuration.");
 
-		value = j_statistics_get(statistics, J_STATISTICS_FILES_CREATED);
-		j_statistics_add(jd_statistics, J_STATISTICS_FILES_CREATED, value);
-		value = j_statistics_get(statistics, J_STATISTICS_FILES_DELETED);
-		j_statistics_add(jd_statistics, J_STATISTICS_FILES_DELETED, value);
-		value = j_statistics_get(statistics, J_STATISTICS_SYNC);
-		j_statistics_add(jd_statistics, J_STATISTICS_SYNC, value);
-		value = j_statistics_get(statistics, J_STATISTICS_BYTES_READ);
-		j_statistics_add(jd_statistics, J_STATISTICS_BYTES_READ, value);
-		value = j_statistics_get(statistics, J_STATISTICS_BYTES_WRITTEN);
-		j_statistics_add(jd_statistics, J_STATISTICS_BYTES_WRITTEN, value);
-		value = j_statistics_get(statistics, J_STATISTICS_BYTES_RECEIVED);
-		j_statistics_add(jd_statistics, J_STATISTICS_BYTES_RECEIVED, value);
-		value = j_statistics_get(statistics, J_STATISTICS_BYTES_SENT);
-		j_statistics_add(jd_statistics, J_STATISTICS_BYTES_SENT, value);
+	return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+jd_on_drain_check(gpointer data)
+{
+	GMainLoop* main_loop = data;
 
-		g_mutex_unlock(jd_statistics_mutex);
+	if (g_atomic_int_get(&jd_connection_count) > 0 && g_get_monotonic_time() < jd_drain_deadline)
+	{
+		return G_SOURCE_CONTINUE;
 	}
 
-	j_memory_chunk_free(memory_chunk);
-	j_statistics_free(statistics);
+	if (g_main_loop_is_running(main_loop))
+	{
+		g_main_loop_quit(main_loop);
+	}
 
-	return TRUE;
+	return G_SOURCE_REMOVE;
 }
 
-static gboolean
-jd_daemon(void)
+/**
+ * Stops accepting connections and exits once all established connections have been closed.
+ * Connections are closed as soon as they are idle, so that clients reconnect to the new server process.
+ **/
+static void
+jd_drain(GMainLoop* main_loop)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gint fd;
-	pid_t pid;
-
-	pid = fork();
+	g_autoptr(GPtrArray) idle = NULL;
 
-	if (pid > 0)
+	for (guint i = 0; i < jd_listeners->len; i++)
 	{
-		g_message("Daemon started as process %d.", pid);
-		g_message("Log messages will be redirected to journald if possible. To view them, use journalctl GLIB_DOMAIN=%s.", G_LOG_DOMAIN);
-		_exit(0);
+		JdListener* listener = g_ptr_array_index(jd_listeners, i);
+
+		g_socket_service_stop(listener->service);
+		// The new server process keeps its own copies of the sockets.
+		g_socket_listener_close(G_SOCKET_LISTENER(listener->service));
 	}
-	else if (pid == -1)
+
+	idle = g_ptr_array_new();
+
+	g_mutex_lock(jd_connections_mutex);
+
+	jd_draining = TRUE;
+
+	for (guint i = 0; i < jd_connections->len; i++)
 	{
-		return FALSE;
+		JdConnection* jd_connection = g_ptr_array_index(jd_connections, i);
+
+		if (jd_connection->watch != NULL)
+		{
+			g_ptr_array_add(idle, jd_connection);
+		}
 	}
 
-	if (setsid() == -1)
+	g_mutex_unlock(jd_connections_mutex);
+
+	// Watches are dispatched by the main loop, so they cannot fire concurrently.
+	for (guint i = 0; i < idle->len; i++)
 	{
-		return FALSE;
+		JdConnection* jd_connection = g_ptr_array_index(idle, i);
+
+		g_source_destroy(jd_connection->watch);
+		jd_connection_free(jd_connection);
 	}
 
-	if (g_chdir("/") == -1)
+	jd_drain_deadline = g_get_monotonic_time() + JD_RESTART_DRAIN_TIMEOUT;
+	g_timeout_add(100, jd_on_drain_check, main_loop);
+}
+
+static gboolean
+jd_on_handoff(gint fd, GIOCondition condition, gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GMainLoop* main_loop = data;
+	gchar buffer;
+
+	(void)condition;
+
+	if (read(fd, &buffer, 1) == 1)
 	{
-		return FALSE;
+		g_message("New server process took over listening sockets, closing connections.");
+
+		// The socket pair is kept open until the server exits.
+		jd_drain(main_loop);
+	}
+	else
+	{
+		g_warning("New server process did not start, continuing.");
+
+		close(fd);
+		jd_restart_fd = -1;
 	}
 
-	fd = open("/dev/null", O_RDWR);
+	return G_SOURCE_REMOVE;
+}
 
-	if (fd == -1)
+/**
+ * Starts a new server process that takes over the listening sockets.
+ * Connections are not refused at any time; the server exits once the new process is running.
+ **/
+static gboolean
+jd_on_restart(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GString) fds = NULL;
+	g_auto(GStrv) envp = NULL;
+	g_autofree gchar* handoff_fd = NULL;
+	gint handoff[2];
+	gboolean spawned;
+
+	if (jd_restart_fd != -1)
 	{
-		return FALSE;
+		g_warning("Restart already in progress.");
+		return G_SOURCE_CONTINUE;
 	}
 
-	if (dup2(fd, STDIN_FILENO) == -1 || dup2(fd, STDOUT_FILENO) == -1 || dup2(fd, STDERR_FILENO) == -1)
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, handoff) != 0)
 	{
-		return FALSE;
+		g_warning("Could not restart: %s", g_strerror(errno));
+		return G_SOURCE_CONTINUE;
 	}
 
-	if (fd > 2)
+	fds = g_string_new(NULL);
+
+	// Only the listening sockets and the new process's end of the socket pair are inherited.
+	for (guint i = 0; i < jd_listen_sockets->len; i++)
 	{
-		close(fd);
-	}
+		gint fd = g_socket_get_fd(g_ptr_array_index(jd_listen_sockets, i));
 
-	// Try to redirect GLib log messages to journald.
-	// They can be shown with: journalctl GLIB_DOMAIN=JULEA
-	g_log_set_writer_func(g_log_writer_journald, NULL, NULL);
+		fcntl(fd, F_SETFD, 0);
+		g_string_append_printf(fds, "%s%d", (i > 0) ? "," : "", fd);
+	}
 
-	return TRUE;
-}
+	fcntl(handoff[1], F_SETFD, 0);
+	handoff_fd = g_strdup_printf("%d", handoff[1]);
 
-static gboolean
-jd_is_server_for_backend(gchar const* host, gint port, JBackendType backend_type)
-{
-	guint count;
+	envp = g_get_environ();
+	envp = g_environ_setenv(envp, JD_RESTART_LISTEN_FDS, fds->str, TRUE);
+	envp = g_environ_setenv(envp, JD_RESTART_HANDOFF_FD, handoff_fd, TRUE);
 
-	count = j_configuration_get_server_count(jd_configuration, backend_type);
+	spawned = g_spawn_async(NULL, jd_arguments, envp, G_SPAWN_LEAVE_DESCRIPTORS_OPEN | G_SPAWN_FILE_AND_ARGV_ZERO, NULL, NULL, NULL, &error);
 
-	for (guint i = 0; i < count; i++)
+	for (guint i = 0; i < jd_listen_sockets->len; i++)
 	{
-		g_autoptr(GNetworkAddress) address = NULL;
-		gchar const* addr_server;
-		gchar const* server;
-		guint16 addr_port;
+		fcntl(g_socket_get_fd(g_ptr_array_index(jd_listen_sockets, i)), F_SETFD, FD_CLOEXEC);
+	}
 
-		server = j_configuration_get_server(jd_configuration, backend_type, i);
-		address = G_NETWORK_ADDRESS(g_network_address_parse(server, 4711, NULL));
+	close(handoff[1]);
 
-		addr_server = g_network_address_get_hostname(address);
-		addr_port = g_network_address_get_port(address);
+	if (!spawned)
+	{
+		g_warning("Could not restart: %s", error->message);
+		close(handoff[0]);
 
-		if (g_strcmp0(host, addr_server) == 0 && port == addr_port)
-		{
-			return TRUE;
-		}
+		return G_SOURCE_CONTINUE;
 	}
 
-	return FALSE;
+	g_message("Restarting, waiting for the new server process to take over.");
+
+	jd_restart_fd = handoff[0];
+	g_unix_fd_add(jd_restart_fd, G_IO_IN | G_IO_HUP | G_IO_ERR, jd_on_handoff, data);
+
+	return G_SOURCE_CONTINUE;
 }
 
 int
@@ -205,37 +1358,77 @@ main(int argc, char** argv)
 	gboolean opt_daemon = FALSE;
 	g_autofree gchar* opt_host = NULL;
 	gint opt_port = 4711;
+	gint opt_workers = 0;
+	gint opt_metrics_port = 0;
+	gint opt_listeners = 1;
+	gboolean opt_numa = FALSE;
+	gboolean opt_deferred_delete = FALSE;
+	gint opt_kv_bloom_filter = 0;
+	gint opt_concurrency[JD_SCHEDULER_CLASSES] = { 0 };
 
 	JTrace* trace;
 	GError* error = NULL;
 	g_autoptr(GMainLoop) main_loop = NULL;
 	GModule* object_module = NULL;
+	GModule* object_cold_module = NULL;
 	GModule* kv_module = NULL;
 	GModule* db_module = NULL;
 	g_autoptr(GOptionContext) context = NULL;
-	g_autoptr(GSocketService) socket_service = NULL;
+	GSocketService* metrics_service = NULL;
 	gchar const* object_backend;
 	gchar const* object_component;
 	g_autofree gchar* object_path = NULL;
+	gchar const* object_cold_backend;
+	g_autofree gchar* object_cold_path = NULL;
+	g_autofree gchar* object_wal_path = NULL;
 	gchar const* kv_backend;
 	gchar const* kv_component;
 	g_autofree gchar* kv_path = NULL;
 	gchar const* db_backend;
 	gchar const* db_component;
 	g_autofree gchar* db_path = NULL;
+	g_auto(GStrv) kv_replicas = NULL;
+	g_auto(GStrv) db_replicas = NULL;
 	g_autofree gchar* port_str = NULL;
+	gchar const* listen_fds;
+	gchar const* handoff_fd;
 	guint listen_retries = 0;
 
 	GOptionEntry entries[] = {
 		{ "daemon", 0, 0, G_OPTION_ARG_NONE, &opt_daemon, "Run as daemon", NULL },
 		{ "host", 0, 0, G_OPTION_ARG_STRING, &opt_host, "Override host name", "hostname" },
 		{ "port", 0, 0, G_OPTION_ARG_INT, &opt_port, "Port to use", "4711" },
+		{ "workers", 0, 0, G_OPTION_ARG_INT, &opt_workers, "Number of worker threads handling messages (0 uses one thread per connection, -1 one per core)", "0" },
+		{ "metrics-port", 0, 0, G_OPTION_ARG_INT, &opt_metrics_port, "Port to serve Prometheus metrics on via HTTP (0 disables it)", "0" },
+		{ "listeners", 0, 0, G_OPTION_ARG_INT, &opt_listeners, "Number of listeners sharing the port, each accepting connections on its own thread", "1" },
+		{ "numa", 0, 0, G_OPTION_ARG_NONE, &opt_numa, "Bind threads handling a connection to one NUMA node", NULL },
+		{ "deferred-delete", 0, 0, G_OPTION_ARG_NONE, &opt_deferred_delete, "Reply to object deletions immediately and delete the objects in the background", NULL },
+		{ "kv-bloom-filter", 0, 0, G_OPTION_ARG_INT, &opt_kv_bloom_filter, "Size in KiB of the Bloom filters clients can fetch per key-value namespace (0 disables them)", "0" },
+		{ "object-concurrency", 0, 0, G_OPTION_ARG_INT, &opt_concurrency[JD_SCHEDULER_OBJECT], "Maximum number of concurrent large object reads and writes (0 for no limit)", "0" },
+		{ "kv-concurrency", 0, 0, G_OPTION_ARG_INT, &opt_concurrency[JD_SCHEDULER_KV], "Maximum number of concurrent key-value requests (0 for no limit)", "0" },
+		{ "db-concurrency", 0, 0, G_OPTION_ARG_INT, &opt_concurrency[JD_SCHEDULER_DB], "Maximum number of concurrent database requests (0 for no limit)", "0" },
 		{ NULL, 0, 0, 0, NULL, NULL, NULL }
 	};
 
 	// Explicitly enable UTF-8 since functions such as g_format_size might return UTF-8 characters.
 	setlocale(LC_ALL, "C.UTF-8");
 
+	// The executable is looked up before the working directory changes, parsing the options modifies the arguments.
+	jd_arguments = g_new(gchar*, argc + 2);
+	jd_arguments[0] = g_find_program_in_path(argv[0]);
+
+	if (jd_arguments[0] == NULL)
+	{
+		jd_arguments[0] = g_strdup(argv[0]);
+	}
+
+	for (gint i = 0; i < argc; i++)
+	{
+		jd_arguments[i + 1] = g_strdup(argv[i]);
+	}
+
+	jd_arguments[argc + 1] = NULL;
+
 	context = g_option_context_new(NULL);
 	g_option_context_add_main_entries(context, entries, NULL);
 
@@ -263,13 +1456,55 @@ main(int argc, char** argv)
 		opt_host = g_strdup(hostname);
 	}
 
-	socket_service = g_threaded_socket_service_new(-1);
-	g_socket_listener_set_backlog(G_SOCKET_LISTENER(socket_service), 128);
+	if (opt_workers < 0)
+	{
+		opt_workers = g_get_num_processors();
+	}
 
-	while (TRUE)
+	jd_listen_sockets = g_ptr_array_new_with_free_func(g_object_unref);
+	jd_listeners = g_ptr_array_new_with_free_func((GDestroyNotify)jd_listener_free);
+
+	for (gint i = 0; i < MAX(1, opt_listeners); i++)
+	{
+		// The first listener uses the main loop.
+		g_ptr_array_add(jd_listeners, jd_listener_new(opt_workers == 0, i > 0));
+	}
+
+	listen_fds = g_getenv(JD_RESTART_LISTEN_FDS);
+	handoff_fd = g_getenv(JD_RESTART_HANDOFF_FD);
+
+	if (listen_fds != NULL)
+	{
+		// A previous server process is restarting and hands over its sockets.
+		if (!jd_listen_adopt(listen_fds, &error))
+		{
+			g_critical("Cannot take over listening sockets: %s", error->message);
+			return 1;
+		}
+	}
+
+	while (listen_fds == NULL)
 	{
-		if (!g_socket_listener_add_inet_port(G_SOCKET_LISTENER(socket_service), opt_port, NULL, &error))
+		gboolean listening = TRUE;
+
+		// Additional listeners share the first one's port, the kernel distributes connections among them.
+		for (guint i = 0; i < jd_listeners->len && listening; i++)
 		{
+			listening = jd_listener_listen(g_ptr_array_index(jd_listeners, i), opt_host, opt_port, i > 0, &error);
+		}
+
+		if (!listening)
+		{
+			// Drop the listeners set up so far, allowing to retry.
+			for (guint i = 0; i < jd_listeners->len; i++)
+			{
+				JdListener* listener = g_ptr_array_index(jd_listeners, i);
+
+				g_socket_listener_close(G_SOCKET_LISTENER(listener->service));
+			}
+
+			g_ptr_array_set_size(jd_listen_sockets, 0);
+
 			if (error != NULL)
 			{
 				g_warning("%s", error->message);
@@ -293,6 +1528,20 @@ main(int argc, char** argv)
 		break;
 	}
 
+	if (handoff_fd != NULL)
+	{
+		guint64 fd;
+
+		if (g_ascii_string_to_unsigned(handoff_fd, 10, 0, G_MAXINT, &fd, NULL))
+		{
+			jd_restart_wait((gint)fd);
+		}
+	}
+
+	// Processes started by a later restart must not see these.
+	g_unsetenv(JD_RESTART_LISTEN_FDS);
+	g_unsetenv(JD_RESTART_HANDOFF_FD);
+
 	j_trace_init("julea-server");
 
 	trace = j_trace_enter(G_STRFUNC, NULL);
@@ -314,6 +1563,7 @@ main(int argc, char** argv)
 	object_backend = j_configuration_get_backend(jd_configuration, J_BACKEND_TYPE_OBJECT);
 	object_component = j_configuration_get_backend_component(jd_configuration, J_BACKEND_TYPE_OBJECT);
 	object_path = j_helper_str_replace(j_configuration_get_backend_path(jd_configuration, J_BACKEND_TYPE_OBJECT), "{PORT}", port_str);
+	object_cold_backend = j_configuration_get_object_cold_backend(jd_configuration);
 
 	kv_backend = j_configuration_get_backend(jd_configuration, J_BACKEND_TYPE_KV);
 	kv_component = j_configuration_get_backend_component(jd_configuration, J_BACKEND_TYPE_KV);
@@ -323,16 +1573,64 @@ main(int argc, char** argv)
 	db_component = j_configuration_get_backend_component(jd_configuration, J_BACKEND_TYPE_DB);
 	db_path = j_helper_str_replace(j_configuration_get_backend_path(jd_configuration, J_BACKEND_TYPE_DB), "{PORT}", port_str);
 
+	if (opt_metrics_port > 0)
+	{
+		// Backend statistics are only kept if they can be queried.
+		j_backend_statistics_enable(TRUE);
+	}
+
 	if (jd_is_server_for_backend(opt_host, opt_port, J_BACKEND_TYPE_OBJECT)
 	    && j_backend_load_server(object_backend, object_component, J_BACKEND_TYPE_OBJECT, &object_module, &jd_object_backend))
 	{
-		if (jd_object_backend == NULL || !j_backend_object_init(jd_object_backend, object_path))
+		if (object_cold_backend != NULL)
 		{
-			g_warning("Could not initialize object backend %s.", object_backend);
-			return 1;
+			JBackend* cold_backend = NULL;
+
+			object_cold_path = j_helper_str_replace(j_configuration_get_object_cold_path(jd_configuration), "{PORT}", port_str);
+
+			// The cold tier is only accessed by the server, so client backends like rados can be used, too.
+			if (jd_object_backend == NULL
+			    || !j_backend_load_local(object_cold_backend, J_BACKEND_TYPE_OBJECT, &object_cold_module, &cold_backend)
+			    || !j_backend_object_init_tiered(jd_object_backend, object_path, cold_backend, object_cold_path, j_configuration_get_object_cold_after(jd_configuration)))
+			{
+				g_warning("Could not initialize object backends %s and %s.", object_backend, object_cold_backend);
+				return 1;
+			}
+
+			g_debug("Initialized object backend %s with cold tier %s.", object_backend, object_cold_backend);
+		}
+		else
+		{
+			if (jd_object_backend == NULL || !j_backend_object_init(jd_object_backend, object_path))
+			{
+				g_warning("Could not initialize object backend %s.", object_backend);
+				return 1;
+			}
+
+			g_debug("Initialized object backend %s.", object_backend);
+		}
+
+		jd_object_path = g_strdup(object_path);
+		jd_object_lazy_create = j_configuration_get_object_lazy_create(jd_configuration);
+		jd_object_checksums_enabled = j_configuration_get_object_checksums(jd_configuration);
+		jd_object_dedup_enabled = j_configuration_get_object_dedup(jd_configuration);
+
+		// Writes left in the log by a crash have to be replayed before serving requests
+		if (j_configuration_get_object_wal_path(jd_configuration) != NULL)
+		{
+			object_wal_path = j_helper_str_replace(j_configuration_get_object_wal_path(jd_configuration), "{PORT}", port_str);
+
+			if (!jd_object_wal_start(object_wal_path))
+			{
+				g_warning("Could not initialize write-ahead log %s.", object_wal_path);
+				return 1;
+			}
 		}
 
-		g_debug("Initialized object backend %s.", object_backend);
+		if (opt_deferred_delete)
+		{
+			jd_object_reclaim_start();
+		}
 	}
 
 	if (jd_is_server_for_backend(opt_host, opt_port, J_BACKEND_TYPE_KV)
@@ -345,6 +1643,19 @@ main(int argc, char** argv)
 		}
 
 		g_debug("Initialized kv backend %s.", kv_backend);
+
+		jd_kv_expiry_start();
+
+		if (opt_kv_bloom_filter > 0)
+		{
+			jd_kv_bloom_start((guint64)opt_kv_bloom_filter * 1024 * 8);
+		}
+
+		if ((kv_replicas = jd_get_replicas(opt_host, opt_port, J_BACKEND_TYPE_KV)) != NULL)
+		{
+			jd_replication_start(jd_kv_backend, (gchar const* const*)kv_replicas);
+			g_debug("Replicating kv backend to %u replicas.", g_strv_length(kv_replicas));
+		}
 	}
 
 	if (jd_is_server_for_backend(opt_host, opt_port, J_BACKEND_TYPE_DB)
@@ -357,39 +1668,114 @@ main(int argc, char** argv)
 		}
 
 		g_debug("Initialized db backend %s.", db_backend);
+
+		if ((db_replicas = jd_get_replicas(opt_host, opt_port, J_BACKEND_TYPE_DB)) != NULL)
+		{
+			jd_replication_start(jd_db_backend, (gchar const* const*)db_replicas);
+			g_debug("Replicating db backend to %u replicas.", g_strv_length(db_replicas));
+		}
+	}
+
+	jd_connections = g_ptr_array_new();
+	g_mutex_init(jd_connections_mutex);
+
+	jd_scheduler_init(opt_concurrency);
+
+	if (opt_metrics_port > 0 && (metrics_service = jd_metrics_start(opt_metrics_port)) == NULL)
+	{
+		return 1;
+	}
+
+	if (opt_numa && !jd_numa_init())
+	{
+		g_warning("Could not read NUMA topology, threads will not be bound.");
 	}
 
-	jd_statistics = j_statistics_new(FALSE);
-	g_mutex_init(jd_statistics_mutex);
+	if (opt_workers > 0)
+	{
+		guint pools;
+
+		pools = (jd_numa_nodes != NULL) ? jd_numa_nodes->len : 1;
+		jd_workers = g_ptr_array_new();
+
+		// Each node gets its own workers, so that a connection is always handled on the same node.
+		for (guint i = 0; i < pools; i++)
+		{
+			g_ptr_array_add(jd_workers, g_thread_pool_new(jd_on_work, GUINT_TO_POINTER(i), MAX(1, opt_workers / (gint)pools), TRUE, NULL));
+		}
+	}
+
+	for (guint i = 0; i < jd_listeners->len; i++)
+	{
+		JdListener* listener = g_ptr_array_index(jd_listeners, i);
 
-	g_socket_service_start(socket_service);
-	g_signal_connect(socket_service, "run", G_CALLBACK(jd_on_run), NULL);
+		if (opt_workers > 0)
+		{
+			g_signal_connect(listener->service, "incoming", G_CALLBACK(jd_on_incoming), NULL);
+		}
+		else
+		{
+			g_signal_connect(listener->service, "run", G_CALLBACK(jd_on_run), NULL);
+		}
+
+		jd_listener_start(listener);
+	}
 
 	main_loop = g_main_loop_new(NULL, FALSE);
 
-	g_unix_signal_add(SIGHUP, jd_signal, main_loop);
+	g_unix_signal_add(SIGHUP, jd_on_reload, NULL);
+	g_unix_signal_add(SIGUSR2, jd_on_restart, main_loop);
 	g_unix_signal_add(SIGINT, jd_signal, main_loop);
 	g_unix_signal_add(SIGTERM, jd_signal, main_loop);
 
 	g_main_loop_run(main_loop);
 
-	g_socket_service_stop(socket_service);
+	g_ptr_array_unref(jd_listeners);
+
+	if (jd_workers != NULL)
+	{
+		for (guint i = 0; i < jd_workers->len; i++)
+		{
+			g_thread_pool_free(g_ptr_array_index(jd_workers, i), FALSE, TRUE);
+		}
+
+		g_ptr_array_unref(jd_workers);
+	}
+
+	if (jd_numa_nodes != NULL)
+	{
+		g_ptr_array_unref(jd_numa_nodes);
+	}
+
+	if (metrics_service != NULL)
+	{
+		jd_metrics_stop(metrics_service);
+	}
 
-	g_mutex_clear(jd_statistics_mutex);
-	j_statistics_free(jd_statistics);
+	g_mutex_clear(jd_connections_mutex);
+	g_ptr_array_unref(jd_connections);
+
+	jd_scheduler_fini();
 
 	if (jd_db_backend != NULL)
 	{
+		jd_replication_stop(jd_db_backend);
 		j_backend_db_fini(jd_db_backend);
 	}
 
 	if (jd_kv_backend != NULL)
 	{
+		jd_kv_bloom_stop();
+		// Keys deleted by the expiry thread are still shipped to the replicas.
+		jd_kv_expiry_stop();
+		jd_replication_stop(jd_kv_backend);
 		j_backend_kv_fini(jd_kv_backend);
 	}
 
 	if (jd_object_backend != NULL)
 	{
+		jd_object_wal_stop();
+		jd_object_reclaim_stop();
 		j_backend_object_fini(jd_object_backend);
 	}
 
@@ -403,11 +1789,22 @@ main(int argc, char** argv)
 		g_module_close(kv_module);
 	}
 
+	if (object_cold_module != NULL)
+	{
+		g_module_close(object_cold_module);
+	}
+
 	if (object_module)
 	{
 		g_module_close(object_module);
 	}
 
+	g_free(jd_object_path);
+
+	g_ptr_array_unref(jd_listen_sockets);
+	g_strfreev(jd_arguments);
+
+	g_slist_free_full(jd_configurations_old, (GDestroyNotify)j_configuration_unref);
 	j_configuration_unref(jd_configuration);
 
 	j_trace_leave(trace);
@@ -27,13 +27,192 @@
 #include <jmessage.h>
 #include <jstatistics.h>
 
-G_GNUC_INTERNAL extern JStatistics* jd_statistics;
-G_GNUC_INTERNAL extern GMutex jd_statistics_mutex[1];
+/**
+ * The memory chunk usage of a connection.
+ **/
+struct JdMemoryChunkUsage
+{
+	guint64 size;
+	guint64 peak;
+};
+
+typedef struct JdMemoryChunkUsage JdMemoryChunkUsage;
+
+/**
+ * The points in time a request passes on the server.
+ * All times are monotonic and given in microseconds.
+ **/
+struct JdMessageTimes
+{
+	/**
+	 * When the connection became readable.
+	 **/
+	gint64 ready;
+
+	/**
+	 * When a thread started receiving the request.
+	 **/
+	gint64 receive;
+
+	/**
+	 * When the full request was available.
+	 **/
+	gint64 received;
+
+	/**
+	 * When the request was dispatched to its handler.
+	 **/
+	gint64 dispatched;
+
+	/**
+	 * When the reply was ready to be sent, 0 if none has been sent yet.
+	 **/
+	gint64 completed;
+
+	/**
+	 * When the reply had been sent.
+	 **/
+	gint64 sent;
+};
+
+typedef struct JdMessageTimes JdMessageTimes;
+
+G_GNUC_INTERNAL JStatistics* jd_statistics_get_all(void);
+G_GNUC_INTERNAL GArray* jd_memory_chunk_get_usage(void);
+
+G_GNUC_INTERNAL GSocketService* jd_metrics_start(gint);
+G_GNUC_INTERNAL void jd_metrics_stop(GSocketService*);
+
+struct JdKVExpiry;
+
+typedef struct JdKVExpiry JdKVExpiry;
+
+G_GNUC_INTERNAL void jd_kv_expiry_start(void);
+G_GNUC_INTERNAL void jd_kv_expiry_stop(void);
+G_GNUC_INTERNAL JdKVExpiry* jd_kv_expiry_begin(gchar const*, JSemantics*);
+G_GNUC_INTERNAL void jd_kv_expiry_set(JdKVExpiry*, gchar const*, GTimeSpan);
+G_GNUC_INTERNAL void jd_kv_expiry_end(JdKVExpiry*, gboolean);
+
+struct JdKVBloom;
+
+typedef struct JdKVBloom JdKVBloom;
+
+G_GNUC_INTERNAL void jd_kv_bloom_start(guint64);
+G_GNUC_INTERNAL void jd_kv_bloom_stop(void);
+G_GNUC_INTERNAL JdKVBloom* jd_kv_bloom_begin(gchar const*);
+G_GNUC_INTERNAL void jd_kv_bloom_add(JdKVBloom*, gchar const*);
+G_GNUC_INTERNAL void jd_kv_bloom_end(JdKVBloom*);
+G_GNUC_INTERNAL void jd_kv_bloom_fetch(gchar const*, guint64, guint64, JMessage*);
+
+G_GNUC_INTERNAL void jd_object_reclaim_start(void);
+G_GNUC_INTERNAL void jd_object_reclaim_stop(void);
+G_GNUC_INTERNAL gboolean jd_object_reclaim_enabled(void);
+G_GNUC_INTERNAL gboolean jd_object_reclaim_defer(gchar const*, gchar const*);
+G_GNUC_INTERNAL gboolean jd_object_reclaim_pending(gchar const*, gchar const*);
+G_GNUC_INTERNAL void jd_object_reclaim_now(gchar const*, gchar const*);
+
+G_GNUC_INTERNAL void jd_replication_start(JBackend*, gchar const* const*);
+G_GNUC_INTERNAL void jd_replication_stop(JBackend*);
+G_GNUC_INTERNAL gboolean jd_replication_apply_kv(JMessage*, JSemantics*);
+G_GNUC_INTERNAL gboolean jd_replication_apply_db(JMessage*, JSemantics*);
+
+struct JdObjectWal;
+
+typedef struct JdObjectWal JdObjectWal;
+
+G_GNUC_INTERNAL gboolean jd_object_wal_start(gchar const*);
+G_GNUC_INTERNAL void jd_object_wal_stop(void);
+G_GNUC_INTERNAL gboolean jd_object_wal_enabled(void);
+G_GNUC_INTERNAL JdObjectWal* jd_object_wal_begin(void);
+G_GNUC_INTERNAL gboolean jd_object_wal_append(JdObjectWal*, gchar const*, gchar const*, gconstpointer, guint64, guint64);
+G_GNUC_INTERNAL gboolean jd_object_wal_end(JdObjectWal*);
+G_GNUC_INTERNAL gboolean jd_object_wal_delete(JdObjectWal*, gchar const*, gchar const*);
+G_GNUC_INTERNAL gboolean jd_object_wal_discard(JdObjectWal*, gchar const*, gchar const*, guint64, guint64);
+
+/**
+ * The checksums stored alongside an object.
+ **/
+struct JdObjectChecksums
+{
+	/**
+	 * The object the checksums are stored in.
+	 **/
+	gpointer object;
+
+	/**
+	 * Keeps readers from seeing data whose checksums have not been updated yet.
+	 **/
+	GRWLock* lock;
+};
+
+typedef struct JdObjectChecksums JdObjectChecksums;
+
+G_GNUC_INTERNAL gchar* jd_object_checksums_namespace(gchar const*);
+G_GNUC_INTERNAL GRWLock* jd_object_checksums_lock(gchar const*, gchar const*);
+G_GNUC_INTERNAL void jd_object_checksums_update(JdObjectChecksums const*, gpointer, gconstpointer, guint64, guint64);
+G_GNUC_INTERNAL gboolean jd_object_checksums_verify(JdObjectChecksums const*, gpointer, gconstpointer, guint64, guint64);
+G_GNUC_INTERNAL void jd_object_checksums_delete(gchar const*, gchar const*);
+G_GNUC_INTERNAL void jd_object_checksums_clone(gchar const*, gchar const*, gchar const*, gchar const*);
+
+G_GNUC_INTERNAL void jd_object_dedup_release(gchar const*, gchar const*, guint64, guint64);
+G_GNUC_INTERNAL gboolean jd_object_dedup_reference(gchar const*, gchar const*, gpointer, guint8 const*, gconstpointer, guint64);
+G_GNUC_INTERNAL void jd_object_dedup_delete(gchar const*, gchar const*);
+
+/**
+ * The classes of requests the scheduler controls access to backends for.
+ **/
+enum JdSchedulerClass
+{
+	JD_SCHEDULER_OBJECT,
+	JD_SCHEDULER_KV,
+	JD_SCHEDULER_DB,
+	JD_SCHEDULER_CLASSES
+};
+
+typedef enum JdSchedulerClass JdSchedulerClass;
+
+struct JdSchedulerClient;
+
+typedef struct JdSchedulerClient JdSchedulerClient;
+
+G_GNUC_INTERNAL void jd_scheduler_init(gint const*);
+G_GNUC_INTERNAL void jd_scheduler_fini(void);
+G_GNUC_INTERNAL JdSchedulerClient* jd_scheduler_client_ref(GSocketConnection*);
+G_GNUC_INTERNAL void jd_scheduler_client_unref(JdSchedulerClient*);
+G_GNUC_INTERNAL void jd_scheduler_enter(JdSchedulerClient*, JdSchedulerClass, guint64);
+G_GNUC_INTERNAL void jd_scheduler_leave(JdSchedulerClient*, JdSchedulerClass, guint64);
 
 G_GNUC_INTERNAL extern JBackend* jd_object_backend;
 G_GNUC_INTERNAL extern JBackend* jd_kv_backend;
 G_GNUC_INTERNAL extern JBackend* jd_db_backend;
 
-G_GNUC_INTERNAL gboolean jd_handle_message(JMessage*, GSocketConnection*, JMemoryChunk*, guint64, JStatistics*);
+/**
+ * The object backend's path, used to report the available storage space.
+ **/
+G_GNUC_INTERNAL extern gchar* jd_object_path;
+
+/**
+ * Whether the parts of distributed objects are created by their first write, see j_configuration_get_object_lazy_create().
+ **/
+G_GNUC_INTERNAL extern gboolean jd_object_lazy_create;
+
+/**
+ * Whether object data is protected by checksums, see j_configuration_get_object_checksums().
+ **/
+G_GNUC_INTERNAL extern gboolean jd_object_checksums_enabled;
+
+/**
+ * Whether identical blocks of objects are deduplicated, see j_configuration_get_object_dedup().
+ **/
+G_GNUC_INTERNAL extern gboolean jd_object_dedup_enabled;
+
+struct JdObjectHandles;
+
+typedef struct JdObjectHandles JdObjectHandles;
+
+G_GNUC_INTERNAL JdObjectHandles* jd_object_handles_new(void);
+G_GNUC_INTERNAL void jd_object_handles_free(JdObjectHandles*);
+
+G_GNUC_INTERNAL gboolean jd_handle_message(JMessage*, GSocketConnection*, JMemoryChunk*, guint64, JStatistics*, JdObjectHandles*, JdSchedulerClient*, JdMessageTimes*);
 
 #endif
@@ -0,0 +1,1001 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <julea.h>
+
+#include "server.h"
+
+/**
+ * The number of milliseconds after which logged writes are applied to the backend.
+ **/
+#define JD_OBJECT_WAL_CHECKPOINT_INTERVAL 1000
+
+/**
+ * The size in bytes after which a log is checkpointed early.
+ **/
+#define JD_OBJECT_WAL_CHECKPOINT_SIZE (64 * 1024 * 1024)
+
+/**
+ * The prefix of the log files, followed by their generation.
+ **/
+#define JD_OBJECT_WAL_PREFIX "wal-"
+
+/**
+ * Marks the beginning of each record.
+ **/
+#define JD_OBJECT_WAL_MAGIC 0x4a57414c
+
+enum JdObjectWalType
+{
+	JD_OBJECT_WAL_WRITE,
+	JD_OBJECT_WAL_DELETE,
+	JD_OBJECT_WAL_DISCARD
+};
+
+/**
+ * The header of a record in the log, followed by the namespace, the path and the data.
+ * The checksum covers the header (with the checksum set to zero), the names and the data, so records torn by a crash are detected.
+ **/
+struct JdObjectWalRecord
+{
+	guint32 magic;
+	guint32 type;
+	guint32 namespace_length;
+	guint32 path_length;
+	guint64 length;
+	guint64 offset;
+	guint32 crc;
+	guint32 padding;
+};
+
+typedef struct JdObjectWalRecord JdObjectWalRecord;
+
+/**
+ * An object that has been written to since the last checkpoint.
+ **/
+struct JdObjectWalEntry
+{
+	gchar* namespace;
+	gchar* path;
+};
+
+typedef struct JdObjectWalEntry JdObjectWalEntry;
+
+/**
+ * One generation of the log.
+ * New records are always appended to the current generation, older ones are only kept until their objects have been synced.
+ **/
+struct JdObjectWal
+{
+	guint64 generation;
+	gchar* path;
+	gint fd;
+
+	/**
+	 * The number of bytes appended and synced.
+	 **/
+	guint64 written;
+	guint64 synced;
+
+	/**
+	 * Whether a thread is currently syncing the log.
+	 **/
+	gboolean syncing;
+
+	/**
+	 * Whether appending to or syncing the log has failed.
+	 * Writes then have to be synced to the backend directly.
+	 **/
+	gboolean failed;
+
+	/**
+	 * The number of writes that have been logged but might not have reached the backend yet.
+	 **/
+	guint writers;
+
+	/**
+	 * Contains the JdObjectWalEntry elements of all objects written to or discarded from.
+	 **/
+	GHashTable* objects;
+};
+
+static struct
+{
+	GThread* thread;
+
+	/**
+	 * Protects all logs.
+	 **/
+	GMutex mutex[1];
+
+	/**
+	 * Signaled when a log has been synced or has no writers left.
+	 **/
+	GCond cond[1];
+
+	/**
+	 * Signaled when the checkpoint thread should wake up.
+	 **/
+	GCond checkpoint_cond[1];
+
+	gboolean stop;
+
+	gchar* path;
+	JdObjectWal* current;
+
+	gint enabled;
+} jd_object_wal;
+
+static guint
+jd_object_wal_entry_hash(gconstpointer data)
+{
+	JdObjectWalEntry const* entry = data;
+
+	return g_str_hash(entry->namespace) * 31 + g_str_hash(entry->path);
+}
+
+static gboolean
+jd_object_wal_entry_equal(gconstpointer a, gconstpointer b)
+{
+	JdObjectWalEntry const* entry_a = a;
+	JdObjectWalEntry const* entry_b = b;
+
+	return (g_strcmp0(entry_a->namespace, entry_b->namespace) == 0 && g_strcmp0(entry_a->path, entry_b->path) == 0);
+}
+
+static JdObjectWalEntry*
+jd_object_wal_entry_new(gchar const* namespace, gchar const* path)
+{
+	JdObjectWalEntry* entry;
+
+	entry = g_slice_new(JdObjectWalEntry);
+	entry->namespace = g_strdup(namespace);
+	entry->path = g_strdup(path);
+
+	return entry;
+}
+
+static void
+jd_object_wal_entry_free(JdObjectWalEntry* entry)
+{
+	g_free(entry->namespace);
+	g_free(entry->path);
+
+	g_slice_free(JdObjectWalEntry, entry);
+}
+
+static GHashTable*
+jd_object_wal_entry_table_new(GDestroyNotify value_free)
+{
+	return g_hash_table_new_full(jd_object_wal_entry_hash, jd_object_wal_entry_equal, (GDestroyNotify)jd_object_wal_entry_free, value_free);
+}
+
+/**
+ * Makes the creation or deletion of files in the log directory durable.
+ *
+ * \private
+ **/
+static void
+jd_object_wal_sync_directory(void)
+{
+	gint fd;
+
+	if ((fd = open(jd_object_wal.path, O_RDONLY | O_DIRECTORY)) != -1)
+	{
+		fsync(fd);
+		close(fd);
+	}
+}
+
+/**
+ * Creates a new generation of the log.
+ *
+ * \private
+ *
+ * \param generation The generation.
+ *
+ * \return The log, NULL on failure.
+ **/
+static JdObjectWal*
+jd_object_wal_new(guint64 generation)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdObjectWal* log;
+	g_autofree gchar* name = NULL;
+	gint fd;
+
+	name = g_strdup_printf(JD_OBJECT_WAL_PREFIX "%016" G_GINT64_MODIFIER "x", generation);
+
+	log = g_slice_new(JdObjectWal);
+	log->generation = generation;
+	log->path = g_build_filename(jd_object_wal.path, name, NULL);
+	log->fd = -1;
+	log->written = 0;
+	log->synced = 0;
+	log->syncing = FALSE;
+	log->failed = FALSE;
+	log->writers = 0;
+	log->objects = jd_object_wal_entry_table_new(NULL);
+
+	if ((fd = open(log->path, O_WRONLY | O_CREAT | O_TRUNC, 0600)) == -1)
+	{
+		g_warning("Could not create write-ahead log %s: %s", log->path, g_strerror(errno));
+
+		g_hash_table_unref(log->objects);
+		g_free(log->path);
+		g_slice_free(JdObjectWal, log);
+
+		return NULL;
+	}
+
+	log->fd = fd;
+
+	// Syncing the log later only makes its data durable, not the file itself
+	jd_object_wal_sync_directory();
+
+	return log;
+}
+
+/**
+ * Deletes a generation of the log.
+ *
+ * \private
+ *
+ * \param log A log.
+ **/
+static void
+jd_object_wal_free(JdObjectWal* log)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	close(log->fd);
+	g_unlink(log->path);
+
+	g_hash_table_unref(log->objects);
+	g_free(log->path);
+	g_slice_free(JdObjectWal, log);
+}
+
+/**
+ * Syncs all objects written to in a generation of the log and deletes it afterwards.
+ * The generation must not be current anymore.
+ *
+ * \private
+ *
+ * \param log A log.
+ **/
+static void
+jd_object_wal_checkpoint(JdObjectWal* log)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GHashTableIter iter;
+	JdObjectWalEntry* entry;
+
+	g_mutex_lock(jd_object_wal.mutex);
+
+	// Logged writes might not have reached the backend yet
+	while (log->writers > 0)
+	{
+		g_cond_wait(jd_object_wal.cond, jd_object_wal.mutex);
+	}
+
+	g_mutex_unlock(jd_object_wal.mutex);
+
+	g_hash_table_iter_init(&iter, log->objects);
+
+	while (g_hash_table_iter_next(&iter, (gpointer*)&entry, NULL))
+	{
+		gpointer object;
+
+		// Deleted objects do not need to be synced
+		if (j_backend_object_open(jd_object_backend, entry->namespace, entry->path, &object))
+		{
+			j_backend_object_sync(jd_object_backend, object);
+			j_backend_object_close(jd_object_backend, object);
+		}
+	}
+
+	jd_object_wal_free(log);
+}
+
+static gpointer
+jd_object_wal_thread(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	(void)data;
+
+	g_mutex_lock(jd_object_wal.mutex);
+
+	while (!jd_object_wal.stop)
+	{
+		JdObjectWal* log;
+		JdObjectWal* next;
+		gint64 end_time;
+
+		end_time = g_get_monotonic_time() + JD_OBJECT_WAL_CHECKPOINT_INTERVAL * G_TIME_SPAN_MILLISECOND;
+
+		while (!jd_object_wal.stop && jd_object_wal.current->written < JD_OBJECT_WAL_CHECKPOINT_SIZE && g_cond_wait_until(jd_object_wal.checkpoint_cond, jd_object_wal.mutex, end_time))
+		{
+		}
+
+		log = jd_object_wal.current;
+
+		// The final checkpoint is done when stopping
+		if (jd_object_wal.stop || (log->written == 0 && !log->failed))
+		{
+			continue;
+		}
+
+		// New writes go to the next generation while the old one is being checkpointed
+		if ((next = jd_object_wal_new(log->generation + 1)) == NULL)
+		{
+			end_time = g_get_monotonic_time() + JD_OBJECT_WAL_CHECKPOINT_INTERVAL * G_TIME_SPAN_MILLISECOND;
+
+			while (!jd_object_wal.stop && g_cond_wait_until(jd_object_wal.checkpoint_cond, jd_object_wal.mutex, end_time))
+			{
+			}
+
+			continue;
+		}
+
+		jd_object_wal.current = next;
+
+		g_mutex_unlock(jd_object_wal.mutex);
+		jd_object_wal_checkpoint(log);
+		g_mutex_lock(jd_object_wal.mutex);
+	}
+
+	g_mutex_unlock(jd_object_wal.mutex);
+
+	return NULL;
+}
+
+/**
+ * Reads the next record from a log.
+ *
+ * \private
+ *
+ * \param fd        The log's file descriptor.
+ * \param record    A record header.
+ * \param namespace Returns the namespace.
+ * \param path      Returns the path.
+ * \param data      Returns the data.
+ *
+ * \return TRUE if a complete record has been read, FALSE otherwise.
+ **/
+static gboolean
+jd_object_wal_read(gint fd, JdObjectWalRecord* record, gchar** namespace, gchar** path, gpointer* data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* record_namespace = NULL;
+	g_autofree gchar* record_path = NULL;
+	g_autofree gpointer record_data = NULL;
+	struct stat buf;
+	guint64 data_length;
+	guint64 remaining;
+	off_t position;
+	guint32 crc;
+
+	if (read(fd, record, sizeof(*record)) != sizeof(*record) || record->magic != JD_OBJECT_WAL_MAGIC)
+	{
+		return FALSE;
+	}
+
+	if (fstat(fd, &buf) != 0 || (position = lseek(fd, 0, SEEK_CUR)) < 0 || buf.st_size < position)
+	{
+		return FALSE;
+	}
+
+	remaining = buf.st_size - position;
+
+	// Discards only record the range, they do not carry any data
+	data_length = (record->type == JD_OBJECT_WAL_DISCARD) ? 0 : record->length;
+
+	// Lengths of torn records are garbage, a record cannot extend past the end of the log
+	if (record->namespace_length > 4096 || record->path_length > 4096 || record->namespace_length + record->path_length > remaining || data_length > remaining - record->namespace_length - record->path_length)
+	{
+		return FALSE;
+	}
+
+	record_namespace = g_malloc0(record->namespace_length + 1);
+	record_path = g_malloc0(record->path_length + 1);
+	record_data = g_malloc(MAX(data_length, 1));
+
+	if (read(fd, record_namespace, record->namespace_length) != (gssize)record->namespace_length
+	    || read(fd, record_path, record->path_length) != (gssize)record->path_length
+	    || read(fd, record_data, data_length) != (gssize)data_length)
+	{
+		return FALSE;
+	}
+
+	crc = record->crc;
+	record->crc = 0;
+	record->crc = j_checksum_crc32c(0, record, sizeof(*record));
+	record->crc = j_checksum_crc32c(record->crc, record_namespace, record->namespace_length);
+	record->crc = j_checksum_crc32c(record->crc, record_path, record->path_length);
+	record->crc = j_checksum_crc32c(record->crc, record_data, data_length);
+
+	if (record->crc != crc)
+	{
+		return FALSE;
+	}
+
+	*namespace = g_steal_pointer(&record_namespace);
+	*path = g_steal_pointer(&record_path);
+	*data = g_steal_pointer(&record_data);
+
+	return TRUE;
+}
+
+/**
+ * Writes a logged record to the backend.
+ *
+ * \private
+ *
+ * \param namespace A namespace.
+ * \param path      A path.
+ * \param data      The data, NULL to discard the range.
+ * \param length    The data's length.
+ * \param offset    The offset to write to.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+jd_object_wal_apply(gchar const* namespace, gchar const* path, gconstpointer data, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gpointer object;
+	guint64 bytes_written = 0;
+	gboolean ret;
+
+	if (data == NULL)
+	{
+		// There is nothing to discard from objects that do not exist
+		if (!j_backend_object_open(jd_object_backend, namespace, path, &object))
+		{
+			return TRUE;
+		}
+
+		ret = j_backend_object_discard(jd_object_backend, object, length, offset);
+	}
+	// Lazily created objects might not have survived
+	else if (!j_backend_object_open(jd_object_backend, namespace, path, &object)
+		 && !j_backend_object_create(jd_object_backend, namespace, path, &object))
+	{
+		return FALSE;
+	}
+	else
+	{
+		ret = j_backend_object_write(jd_object_backend, object, data, length, offset, &bytes_written) && bytes_written == length;
+	}
+
+	if (jd_object_checksums_enabled)
+	{
+		g_autofree gchar* checksums_namespace = NULL;
+		JdObjectChecksums checksums;
+
+		checksums_namespace = jd_object_checksums_namespace(namespace);
+
+		if (j_backend_object_open(jd_object_backend, checksums_namespace, path, &(checksums.object))
+		    || j_backend_object_create(jd_object_backend, checksums_namespace, path, &(checksums.object)))
+		{
+			checksums.lock = jd_object_checksums_lock(namespace, path);
+
+			g_rw_lock_writer_lock(checksums.lock);
+			jd_object_checksums_update(&checksums, object, (ret) ? data : NULL, length, offset);
+			g_rw_lock_writer_unlock(checksums.lock);
+
+			j_backend_object_sync(jd_object_backend, checksums.object);
+			j_backend_object_close(jd_object_backend, checksums.object);
+		}
+	}
+
+	if (jd_object_dedup_enabled)
+	{
+		jd_object_dedup_release(namespace, path, length, offset);
+	}
+
+	ret = j_backend_object_sync(jd_object_backend, object) && ret;
+	j_backend_object_close(jd_object_backend, object);
+
+	return ret;
+}
+
+/**
+ * Applies all logs left over from a previous run and deletes them.
+ * Writes and discards are applied in order, those to objects that have been deleted later are skipped.
+ *
+ * \private
+ *
+ * \param generation Returns the last generation found.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+jd_object_wal_replay(guint64* generation)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GDir) dir = NULL;
+	g_autoptr(GPtrArray) files = NULL;
+	g_autoptr(GHashTable) deletes = NULL;
+	gchar const* name;
+	guint64 count = 0;
+	gboolean ret = TRUE;
+
+	*generation = 0;
+
+	if ((dir = g_dir_open(jd_object_wal.path, 0, NULL)) == NULL)
+	{
+		return FALSE;
+	}
+
+	files = g_ptr_array_new_with_free_func(g_free);
+	deletes = jd_object_wal_entry_table_new(g_free);
+
+	while ((name = g_dir_read_name(dir)) != NULL)
+	{
+		if (g_str_has_prefix(name, JD_OBJECT_WAL_PREFIX))
+		{
+			g_ptr_array_add(files, g_build_filename(jd_object_wal.path, name, NULL));
+			*generation = MAX(*generation, g_ascii_strtoull(name + strlen(JD_OBJECT_WAL_PREFIX), NULL, 16));
+		}
+	}
+
+	// The generations are zero-padded, so they sort by name
+	g_ptr_array_sort(files, (GCompareFunc)g_strcmp0);
+
+	// The first pass finds the last deletion of each object, the second one applies the writes following it
+	for (guint pass = 0; pass < 2; pass++)
+	{
+		guint64 sequence = 0;
+
+		for (guint i = 0; i < files->len; i++)
+		{
+			JdObjectWalRecord record;
+			gchar* namespace;
+			gchar* path;
+			gpointer data;
+			gint fd;
+
+			if ((fd = open(g_ptr_array_index(files, i), O_RDONLY)) == -1)
+			{
+				g_warning("Could not open write-ahead log %s: %s", (gchar const*)g_ptr_array_index(files, i), g_strerror(errno));
+				return FALSE;
+			}
+
+			// A torn record marks the end of a log
+			while (jd_object_wal_read(fd, &record, &namespace, &path, &data))
+			{
+				JdObjectWalEntry key = { namespace, path };
+
+				sequence++;
+
+				if (pass == 0 && record.type == JD_OBJECT_WAL_DELETE)
+				{
+					guint64* last;
+
+					last = g_new(guint64, 1);
+					*last = sequence;
+					g_hash_table_replace(deletes, jd_object_wal_entry_new(namespace, path), last);
+				}
+				else if (pass == 1 && (record.type == JD_OBJECT_WAL_WRITE || record.type == JD_OBJECT_WAL_DISCARD))
+				{
+					guint64 const* last;
+
+					last = g_hash_table_lookup(deletes, &key);
+
+					if (last == NULL || *last < sequence)
+					{
+						if (jd_object_wal_apply(namespace, path, (record.type == JD_OBJECT_WAL_WRITE) ? data : NULL, record.length, record.offset))
+						{
+							count++;
+						}
+						else
+						{
+							g_warning("Could not replay %s of %" G_GUINT64_FORMAT " bytes to %s/%s.", (record.type == JD_OBJECT_WAL_WRITE) ? "write" : "discard", record.length, namespace, path);
+							ret = FALSE;
+						}
+					}
+				}
+
+				g_free(namespace);
+				g_free(path);
+				g_free(data);
+			}
+
+			close(fd);
+		}
+	}
+
+	// Logs are kept if anything went wrong, so the next start can try again
+	for (guint i = 0; i < files->len && ret; i++)
+	{
+		g_unlink(g_ptr_array_index(files, i));
+	}
+
+	if (count > 0)
+	{
+		g_message("Replayed %" G_GUINT64_FORMAT " writes from the write-ahead log.", count);
+	}
+
+	return ret;
+}
+
+/**
+ * Starts logging durable writes.
+ * Logs left over from a previous run are applied first.
+ *
+ * \private
+ *
+ * \param path The directory to store the log in.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+jd_object_wal_start(gchar const* path)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 generation;
+
+	g_return_val_if_fail(jd_object_backend != NULL, FALSE);
+	g_return_val_if_fail(path != NULL, FALSE);
+	g_return_val_if_fail(jd_object_wal.thread == NULL, FALSE);
+
+	if (g_mkdir_with_parents(path, 0700) != 0)
+	{
+		g_warning("Could not create write-ahead log directory %s: %s", path, g_strerror(errno));
+		return FALSE;
+	}
+
+	jd_object_wal.path = g_strdup(path);
+
+	if (!jd_object_wal_replay(&generation)
+	    || (jd_object_wal.current = jd_object_wal_new(generation + 1)) == NULL)
+	{
+		g_free(jd_object_wal.path);
+		jd_object_wal.path = NULL;
+
+		return FALSE;
+	}
+
+	jd_object_wal.stop = FALSE;
+	jd_object_wal.thread = g_thread_new("julea-wal", jd_object_wal_thread, NULL);
+
+	g_atomic_int_set(&(jd_object_wal.enabled), 1);
+
+	return TRUE;
+}
+
+/**
+ * Stops logging durable writes.
+ * All logged writes are synced to the backend before returning.
+ *
+ * \private
+ **/
+void
+jd_object_wal_stop(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (jd_object_wal.thread == NULL)
+	{
+		return;
+	}
+
+	g_mutex_lock(jd_object_wal.mutex);
+	jd_object_wal.stop = TRUE;
+	g_cond_signal(jd_object_wal.checkpoint_cond);
+	g_mutex_unlock(jd_object_wal.mutex);
+
+	g_thread_join(jd_object_wal.thread);
+	jd_object_wal.thread = NULL;
+
+	g_atomic_int_set(&(jd_object_wal.enabled), 0);
+
+	jd_object_wal_checkpoint(jd_object_wal.current);
+	jd_object_wal.current = NULL;
+
+	jd_object_wal_sync_directory();
+
+	g_free(jd_object_wal.path);
+	jd_object_wal.path = NULL;
+}
+
+/**
+ * Returns whether durable writes are logged.
+ *
+ * \private
+ **/
+gboolean
+jd_object_wal_enabled(void)
+{
+	return g_atomic_int_get(&(jd_object_wal.enabled));
+}
+
+/**
+ * Appends a record to a log.
+ *
+ * \private
+ *
+ * \param log       A log.
+ * \param type      The record's type.
+ * \param namespace A namespace.
+ * \param path      A path.
+ * \param data      The data, NULL if the record does not carry any.
+ * \param length    The data's length.
+ * \param offset    The data's offset.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+jd_object_wal_append_record(JdObjectWal* log, guint32 type, gchar const* namespace, gchar const* path, gconstpointer data, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdObjectWalRecord record;
+	struct iovec iov[4];
+	guint64 data_length;
+	gsize size;
+	gboolean ret = FALSE;
+
+	data_length = (data != NULL) ? length : 0;
+
+	record.magic = JD_OBJECT_WAL_MAGIC;
+	record.type = type;
+	record.namespace_length = strlen(namespace);
+	record.path_length = strlen(path);
+	record.length = length;
+	record.offset = offset;
+	record.crc = 0;
+	record.padding = 0;
+
+	record.crc = j_checksum_crc32c(0, &record, sizeof(record));
+	record.crc = j_checksum_crc32c(record.crc, namespace, record.namespace_length);
+	record.crc = j_checksum_crc32c(record.crc, path, record.path_length);
+	record.crc = j_checksum_crc32c(record.crc, data, data_length);
+
+	iov[0].iov_base = &record;
+	iov[0].iov_len = sizeof(record);
+	iov[1].iov_base = (gpointer)(gintptr)namespace;
+	iov[1].iov_len = record.namespace_length;
+	iov[2].iov_base = (gpointer)(gintptr)path;
+	iov[2].iov_len = record.path_length;
+	iov[3].iov_base = (gpointer)(gintptr)data;
+	iov[3].iov_len = data_length;
+
+	size = sizeof(record) + record.namespace_length + record.path_length + data_length;
+
+	g_mutex_lock(jd_object_wal.mutex);
+
+	// A partially appended record would hide all following ones during replay
+	if (!log->failed)
+	{
+		if (pwritev(log->fd, iov, 4, log->written) == (gssize)size)
+		{
+			JdObjectWalEntry key = { (gchar*)(gintptr)namespace, (gchar*)(gintptr)path };
+
+			log->written += size;
+			ret = TRUE;
+
+			if (type != JD_OBJECT_WAL_DELETE && !g_hash_table_contains(log->objects, &key))
+			{
+				g_hash_table_add(log->objects, jd_object_wal_entry_new(namespace, path));
+			}
+
+			if (log->written >= JD_OBJECT_WAL_CHECKPOINT_SIZE)
+			{
+				g_cond_signal(jd_object_wal.checkpoint_cond);
+			}
+		}
+		else
+		{
+			g_warning("Could not append to write-ahead log %s.", log->path);
+			log->failed = TRUE;
+		}
+	}
+
+	g_mutex_unlock(jd_object_wal.mutex);
+
+	return ret;
+}
+
+/**
+ * Begins logging writes, deletions or discards.
+ * The changes have to be appended with jd_object_wal_append(), jd_object_wal_delete() or jd_object_wal_discard() before they are applied to the backend.
+ *
+ * \private
+ *
+ * \return The log to append to.
+ **/
+JdObjectWal*
+jd_object_wal_begin(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdObjectWal* log;
+
+	g_return_val_if_fail(jd_object_wal_enabled(), NULL);
+
+	g_mutex_lock(jd_object_wal.mutex);
+	log = jd_object_wal.current;
+	log->writers++;
+	g_mutex_unlock(jd_object_wal.mutex);
+
+	return log;
+}
+
+/**
+ * Appends a write to the log.
+ *
+ * \private
+ *
+ * \param log       A log.
+ * \param namespace A namespace.
+ * \param path      A path.
+ * \param data      The data.
+ * \param length    The data's length.
+ * \param offset    The data's offset.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+jd_object_wal_append(JdObjectWal* log, gchar const* namespace, gchar const* path, gconstpointer data, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(log != NULL, FALSE);
+
+	return jd_object_wal_append_record(log, JD_OBJECT_WAL_WRITE, namespace, path, data, length, offset);
+}
+
+/**
+ * Ends logging writes.
+ * Has to be called after the writes have been written to the backend.
+ * Concurrent calls share a single sync of the log.
+ *
+ * \private
+ *
+ * \param log A log.
+ *
+ * \return TRUE if all writes are durable, FALSE if they still have to be synced to the backend.
+ **/
+gboolean
+jd_object_wal_end(JdObjectWal* log)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 target;
+	gboolean ret;
+
+	g_return_val_if_fail(log != NULL, FALSE);
+
+	g_mutex_lock(jd_object_wal.mutex);
+
+	target = log->written;
+
+	while (!log->failed && log->synced < target)
+	{
+		if (!log->syncing)
+		{
+			guint64 written;
+			gboolean synced;
+
+			log->syncing = TRUE;
+			written = log->written;
+
+			g_mutex_unlock(jd_object_wal.mutex);
+			synced = (fdatasync(log->fd) == 0);
+			g_mutex_lock(jd_object_wal.mutex);
+
+			log->syncing = FALSE;
+
+			if (synced)
+			{
+				log->synced = written;
+			}
+			else
+			{
+				g_warning("Could not sync write-ahead log %s.", log->path);
+				log->failed = TRUE;
+			}
+
+			g_cond_broadcast(jd_object_wal.cond);
+		}
+		else
+		{
+			g_cond_wait(jd_object_wal.cond, jd_object_wal.mutex);
+		}
+	}
+
+	ret = !log->failed;
+
+	if (--log->writers == 0)
+	{
+		g_cond_broadcast(jd_object_wal.cond);
+	}
+
+	g_mutex_unlock(jd_object_wal.mutex);
+
+	return ret;
+}
+
+/**
+ * Records the deletion of an object, so earlier writes to it are not replayed.
+ * The deletion must only be applied to the backend once jd_object_wal_end() has succeeded.
+ *
+ * \private
+ *
+ * \param log       A log.
+ * \param namespace A namespace.
+ * \param path      A path.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+jd_object_wal_delete(JdObjectWal* log, gchar const* namespace, gchar const* path)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(log != NULL, FALSE);
+
+	return jd_object_wal_append_record(log, JD_OBJECT_WAL_DELETE, namespace, path, NULL, 0, 0);
+}
+
+/**
+ * Records a discarded range, so earlier writes to it are not replayed over it.
+ * The discard must only be applied to the backend once jd_object_wal_end() has succeeded.
+ *
+ * \private
+ *
+ * \param log       A log.
+ * \param namespace A namespace.
+ * \param path      A path.
+ * \param length    The range's length.
+ * \param offset    The range's offset.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+jd_object_wal_discard(JdObjectWal* log, gchar const* namespace, gchar const* path, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(log != NULL, FALSE);
+
+	return jd_object_wal_append_record(log, JD_OBJECT_WAL_DISCARD, namespace, path, NULL, length, offset);
+}
@@ -0,0 +1,102 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <julea.h>
+
+#include "test.h"
+
+static void
+test_backend_latency_new_free(void)
+{
+	JBackendLatency* latency;
+
+	latency = j_backend_latency_new(NULL);
+	g_assert_nonnull(latency);
+	j_backend_latency_free(latency);
+
+	// The path itself is ignored
+	latency = j_backend_latency_new("/tmp/julea/null");
+	g_assert_nonnull(latency);
+	j_backend_latency_free(latency);
+
+	latency = j_backend_latency_new("/tmp/julea/null:latency=10:read=~20:write=5-15:bandwidth=100:sync-bandwidth=1");
+	g_assert_null(latency);
+
+	latency = j_backend_latency_new("/tmp/julea/null:read=15-5");
+	g_assert_null(latency);
+
+	latency = j_backend_latency_new("/tmp/julea/null:unknown=10");
+	g_assert_null(latency);
+}
+
+static void
+test_backend_latency_get(void)
+{
+	JBackendLatency* latency;
+
+	latency = j_backend_latency_new("/tmp/julea/null:read=100:latency=10:write=50-150:sync=~1000:write-bandwidth=1");
+	g_assert_nonnull(latency);
+
+	// Explicit latencies take precedence over the default one
+	g_assert_cmpuint(j_backend_latency_get(latency, J_BACKEND_LATENCY_READ, 1024 * 1024), ==, 100);
+	g_assert_cmpuint(j_backend_latency_get(latency, J_BACKEND_LATENCY_METADATA, 0), ==, 10);
+
+	for (guint i = 0; i < 100; i++)
+	{
+		guint64 write;
+
+		write = j_backend_latency_get(latency, J_BACKEND_LATENCY_WRITE, 0);
+		g_assert_cmpuint(write, >=, 50);
+		g_assert_cmpuint(write, <=, 150);
+
+		// One MiB takes one second at 1 MiB/s
+		write = j_backend_latency_get(latency, J_BACKEND_LATENCY_WRITE, 1024 * 1024);
+		g_assert_cmpuint(write, >=, G_USEC_PER_SEC + 50);
+		g_assert_cmpuint(write, <=, G_USEC_PER_SEC + 150);
+	}
+
+	j_backend_latency_free(latency);
+}
+
+static void
+test_backend_latency_inject(void)
+{
+	JBackendLatency* latency;
+	gint64 start;
+
+	latency = j_backend_latency_new("/tmp/julea/null:latency=2000");
+	g_assert_nonnull(latency);
+
+	start = g_get_monotonic_time();
+	j_backend_latency_inject(latency, J_BACKEND_LATENCY_SYNC, 0);
+	g_assert_cmpint(g_get_monotonic_time() - start, >=, 2000);
+
+	j_backend_latency_free(latency);
+}
+
+void
+test_core_backend_latency(void)
+{
+	g_test_add_func("/core/backend-latency/new_free", test_backend_latency_new_free);
+	g_test_add_func("/core/backend-latency/get", test_backend_latency_get);
+	g_test_add_func("/core/backend-latency/inject", test_backend_latency_inject);
+}
@@ -56,9 +56,45 @@ test_background_operation_wait(void)
 	j_background_operation_unref(background_operation);
 }
 
+static gpointer
+on_background_operation_increment(gpointer data)
+{
+	return GUINT_TO_POINTER(GPOINTER_TO_UINT(data) + 1);
+}
+
+static void
+test_background_operation_execute_parallel(void)
+{
+	gpointer data[64];
+
+	for (guint i = 0; i < G_N_ELEMENTS(data); i++)
+	{
+		// Leave gaps, just like servers without operations.
+		data[i] = (i % 3 == 0) ? NULL : GUINT_TO_POINTER(i);
+	}
+
+	for (guint j = 0; j < 100; j++)
+	{
+		j_helper_execute_parallel(on_background_operation_increment, data, G_N_ELEMENTS(data));
+	}
+
+	for (guint i = 0; i < G_N_ELEMENTS(data); i++)
+	{
+		if (i % 3 == 0)
+		{
+			g_assert_null(data[i]);
+		}
+		else
+		{
+			g_assert_cmpuint(GPOINTER_TO_UINT(data[i]), ==, i + 100);
+		}
+	}
+}
+
 void
 test_core_background_operation(void)
 {
 	g_test_add_func("/core/background_operation/new_ref_unref", test_background_operation_new_ref_unref);
 	g_test_add_func("/core/background_operation/wait", test_background_operation_wait);
+	g_test_add_func("/core/background_operation/execute_parallel", test_background_operation_execute_parallel);
 }
@@ -22,6 +22,7 @@
 
 #include <julea.h>
 #include <julea-item.h>
+#include <julea-kv.h>
 
 #include "test.h"
 
@@ -128,6 +129,238 @@ test_batch_execute_async(void)
 	_test_batch_execute(TRUE);
 }
 
+static void
+test_batch_queue(void)
+{
+	guint const n = 20;
+
+	g_autoptr(JBatchQueue) queue = NULL;
+	g_autoptr(JBatch) delete_batch = NULL;
+	JKV* kvs[20];
+	gboolean seen[20] = { FALSE };
+	guint count;
+	gboolean ret;
+
+	queue = j_batch_queue_new();
+	delete_batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JBatch) batch = NULL;
+		g_autofree gchar* name = g_strdup_printf("queue-%u", i);
+
+		batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+		kvs[i] = j_kv_new("test-batch", name);
+
+		j_kv_put(kvs[i], g_strdup("value"), 6, g_free, batch);
+		j_batch_queue_submit(queue, batch, GUINT_TO_POINTER(i + 1));
+	}
+
+	count = j_batch_queue_wait(queue, n);
+	g_assert_cmpuint(count, ==, n);
+
+	for (guint i = 0; i < n; i++)
+	{
+		JBatch* batch;
+		gpointer user_data;
+		gboolean batch_ret = FALSE;
+
+		ret = j_batch_queue_poll(queue, &batch, &batch_ret, &user_data);
+		g_assert_true(ret);
+		g_assert_true(batch_ret);
+		g_assert_cmpuint(GPOINTER_TO_UINT(user_data), >=, 1);
+		g_assert_cmpuint(GPOINTER_TO_UINT(user_data), <=, n);
+		g_assert_false(seen[GPOINTER_TO_UINT(user_data) - 1]);
+
+		seen[GPOINTER_TO_UINT(user_data) - 1] = TRUE;
+
+		j_batch_unref(batch);
+	}
+
+	{
+		JBatch* batch = NULL;
+
+		ret = j_batch_queue_poll(queue, &batch, NULL, NULL);
+		g_assert_false(ret);
+		g_assert_null(batch);
+	}
+
+	for (guint i = 0; i < n; i++)
+	{
+		j_kv_delete(kvs[i], delete_batch);
+		j_kv_unref(kvs[i]);
+	}
+
+	ret = j_batch_execute(delete_batch);
+	g_assert_true(ret);
+}
+
+static gpointer
+test_batch_auto_thread(gpointer data)
+{
+	JBatch* batch = data;
+
+	for (guint i = 0; i < 10; i++)
+	{
+		g_autoptr(JKV) kv = NULL;
+		g_autofree gchar* name = g_strdup_printf("auto-%p-%u", (gpointer)g_thread_self(), i);
+		gboolean ret;
+
+		kv = j_kv_new("test-batch", name);
+		j_kv_put(kv, g_strdup("value"), 6, g_free, batch);
+
+		// Only queues the operation
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+
+		j_kv_delete(kv, batch);
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+	}
+
+	return NULL;
+}
+
+static void
+test_batch_auto(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JBatch) get_batch = NULL;
+	g_autoptr(JBatchFuture) future = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autoptr(JKV) kv = NULL;
+	GThread* threads[4];
+	gpointer value = NULL;
+	guint32 length = 0;
+	gboolean ret;
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	batch = j_batch_new_auto(semantics, 8, 0, 1000);
+	get_batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	for (guint i = 0; i < G_N_ELEMENTS(threads); i++)
+	{
+		threads[i] = g_thread_new("test-batch-auto", test_batch_auto_thread, batch);
+	}
+
+	for (guint i = 0; i < G_N_ELEMENTS(threads); i++)
+	{
+		g_thread_join(threads[i]);
+	}
+
+	j_batch_wait(batch);
+
+	// A single operation is executed once the delay has passed
+	kv = j_kv_new("test-batch", "auto");
+	j_kv_put(kv, g_strdup("auto"), 5, g_free, batch);
+	future = j_batch_execute_future(batch);
+
+	ret = j_batch_future_wait(future);
+	g_assert_true(ret);
+	g_assert_true(j_batch_future_poll(future, &ret));
+	g_assert_true(ret);
+
+	j_kv_get(kv, &value, &length, get_batch);
+	ret = j_batch_execute(get_batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(length, ==, 5);
+	g_assert_cmpstr(value, ==, "auto");
+	g_free(value);
+
+	j_kv_delete(kv, batch);
+	j_batch_wait(batch);
+
+	g_assert_cmpuint(j_statistics_get(j_batch_get_statistics(batch), J_STATISTICS_BATCHES), >=, 2);
+}
+
+static void
+test_batch_statistics(void)
+{
+	g_autoptr(JCollection) collection = NULL;
+	g_autoptr(JBatch) batch = NULL;
+	JStatistics* statistics;
+	guint64 global_batches;
+	guint64 replies = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	statistics = j_batch_get_statistics(batch);
+	g_assert_nonnull(statistics);
+	g_assert_cmpuint(j_statistics_get(statistics, J_STATISTICS_BATCHES), ==, 0);
+
+	global_batches = j_statistics_get(j_batch_get_global_statistics(), J_STATISTICS_BATCHES);
+
+	collection = j_collection_create("test-batch-statistics", batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_collection_delete(collection, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	g_assert_cmpuint(j_statistics_get(statistics, J_STATISTICS_BATCHES), ==, 2);
+	g_assert_cmpuint(j_statistics_get(j_batch_get_global_statistics(), J_STATISTICS_BATCHES), >=, global_batches + 2);
+	g_assert_cmpuint(j_statistics_get(statistics, J_STATISTICS_BATCH_NETWORK_TIME), <=, j_statistics_get(statistics, J_STATISTICS_BATCH_EXECUTION_TIME));
+
+	// Collections are stored in the kv servers, at least one of them must have replied.
+	for (guint i = 0; i < j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_KV); i++)
+	{
+		JConnectionPoolServerStatistics server_statistics;
+
+		g_assert_true(j_connection_pool_get_server_statistics(J_BACKEND_TYPE_KV, i, &server_statistics));
+		g_assert_cmpuint(server_statistics.latency_max, >=, server_statistics.latency);
+		replies += server_statistics.replies;
+	}
+
+	g_assert_cmpuint(replies, >=, 2);
+}
+
+static void
+test_batch_execute_relaxed(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	JKV* kvs[10];
+	gpointer values[10];
+	guint32 lengths[10];
+	gboolean ret;
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(semantics, J_SEMANTICS_ORDERING, J_SEMANTICS_ORDERING_RELAXED);
+	batch = j_batch_new(semantics);
+
+	/* Interleave operations on different keys, the operations on each key have to stay in order. */
+	for (guint i = 0; i < 10; i++)
+	{
+		g_autofree gchar* name = g_strdup_printf("relaxed-%u", i);
+
+		kvs[i] = j_kv_new("test-batch", name);
+		j_kv_put(kvs[i], g_strdup("first"), 6, g_free, batch);
+	}
+
+	for (guint i = 0; i < 10; i++)
+	{
+		j_kv_put(kvs[i], g_strdup("second"), 7, g_free, batch);
+		j_kv_get(kvs[i], &values[i], &lengths[i], batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint i = 0; i < 10; i++)
+	{
+		g_assert_cmpuint(lengths[i], ==, 7);
+		g_assert_cmpstr(values[i], ==, "second");
+		g_free(values[i]);
+
+		j_kv_delete(kvs[i], batch);
+		j_kv_unref(kvs[i]);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
 void
 test_core_batch(void)
 {
@@ -136,4 +369,8 @@ test_core_batch(void)
 	g_test_add_func("/core/batch/execute_empty", test_batch_execute_empty);
 	g_test_add_func("/core/batch/execute", test_batch_execute);
 	g_test_add_func("/core/batch/execute_async", test_batch_execute_async);
+	g_test_add_func("/core/batch/execute_relaxed", test_batch_execute_relaxed);
+	g_test_add_func("/core/batch/statistics", test_batch_statistics);
+	g_test_add_func("/core/batch/queue", test_batch_queue);
+	g_test_add_func("/core/batch/auto", test_batch_auto);
 }
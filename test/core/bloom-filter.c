@@ -0,0 +1,115 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <julea.h>
+
+#include "test.h"
+
+static void
+test_bloom_filter_new_free(void)
+{
+	g_autoptr(JBloomFilter) filter = NULL;
+
+	filter = j_bloom_filter_new(1000, 7);
+	g_assert_nonnull(filter);
+
+	// The size is rounded up to whole blocks
+	g_assert_cmpuint(j_bloom_filter_get_bits(filter), ==, J_BLOOM_FILTER_BLOCK_WORDS * 64);
+	g_assert_cmpuint(j_bloom_filter_get_blocks(filter), ==, 1);
+	g_assert_cmpuint(j_bloom_filter_get_hashes(filter), ==, 7);
+	g_assert_cmpuint(j_bloom_filter_get_version(filter), ==, 0);
+}
+
+static void
+test_bloom_filter_contains(void)
+{
+	guint const n = 1000;
+
+	g_autoptr(JBloomFilter) filter = NULL;
+	guint false_positives = 0;
+
+	filter = j_bloom_filter_new(n * 10, 7);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autofree gchar* key = g_strdup_printf("key-%u", i);
+
+		j_bloom_filter_add(filter, key);
+	}
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autofree gchar* key = g_strdup_printf("key-%u", i);
+		g_autofree gchar* other = g_strdup_printf("other-%u", i);
+
+		g_assert_true(j_bloom_filter_contains(filter, key));
+
+		if (j_bloom_filter_contains(filter, other))
+		{
+			false_positives++;
+		}
+	}
+
+	// About one percent is expected with ten bits per key
+	g_assert_cmpuint(false_positives, <, n / 20);
+
+	j_bloom_filter_clear(filter);
+	g_assert_false(j_bloom_filter_contains(filter, "key-0"));
+}
+
+static void
+test_bloom_filter_blocks(void)
+{
+	g_autoptr(JBloomFilter) filter = NULL;
+	g_autoptr(JBloomFilter) copy = NULL;
+	guint64 version;
+
+	filter = j_bloom_filter_new(J_BLOOM_FILTER_BLOCK_WORDS * 64 * 4, 3);
+	copy = j_bloom_filter_new(J_BLOOM_FILTER_BLOCK_WORDS * 64 * 4, 3);
+
+	g_assert_true(j_bloom_filter_add(filter, "first"));
+	g_assert_false(j_bloom_filter_add(filter, "first"));
+	version = j_bloom_filter_get_version(filter);
+	g_assert_cmpuint(version, ==, 1);
+
+	g_assert_true(j_bloom_filter_add(filter, "second"));
+
+	// Only the blocks modified after the first key have to be transferred to a copy that knows it already
+	for (guint64 i = 0; i < j_bloom_filter_get_blocks(filter); i++)
+	{
+		if (j_bloom_filter_get_block_version(filter, i) > 0)
+		{
+			j_bloom_filter_set_block(copy, i, j_bloom_filter_get_block(filter, i));
+		}
+	}
+
+	g_assert_true(j_bloom_filter_contains(copy, "first"));
+	g_assert_true(j_bloom_filter_contains(copy, "second"));
+}
+
+void
+test_core_bloom_filter(void)
+{
+	g_test_add_func("/core/bloom-filter/new_free", test_bloom_filter_new_free);
+	g_test_add_func("/core/bloom-filter/contains", test_bloom_filter_contains);
+	g_test_add_func("/core/bloom-filter/blocks", test_bloom_filter_blocks);
+}
@@ -0,0 +1,83 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <julea.h>
+
+#include "test.h"
+
+static void
+test_buffer_new_free(void)
+{
+	gpointer buffer;
+
+	buffer = j_buffer_new(1000, FALSE);
+	g_assert_nonnull(buffer);
+	g_assert_cmpuint((guintptr)buffer % J_BUFFER_ALIGNMENT, ==, 0);
+
+	// Sizes are rounded up to their size class
+	g_assert_cmpuint(j_buffer_get_size(buffer), ==, J_BUFFER_ALIGNMENT);
+
+	memset(buffer, 42, 1000);
+
+	j_buffer_free(buffer);
+
+	buffer = j_buffer_new(4 * 1024 * 1024, TRUE);
+	g_assert_nonnull(buffer);
+	g_assert_cmpuint(j_buffer_get_size(buffer), ==, 4 * 1024 * 1024);
+
+	j_buffer_free(buffer);
+}
+
+static void
+test_buffer_ref(void)
+{
+	gpointer buffer;
+	gpointer ref;
+	gchar data[16];
+
+	buffer = j_buffer_new(8192, FALSE);
+
+	// Regions within the buffer reference it
+	ref = j_buffer_ref((gchar*)buffer + 100, 1000);
+	g_assert_true(ref == buffer);
+
+	// Regions exceeding the buffer do not
+	g_assert_null(j_buffer_ref((gchar*)buffer + 8000, 1000));
+	g_assert_null(j_buffer_ref(data, sizeof(data)));
+	g_assert_cmpuint(j_buffer_get_size(data), ==, 0);
+
+	// The buffer stays alive until the last reference has been released
+	j_buffer_free(buffer);
+	g_assert_cmpuint(j_buffer_get_size(buffer), ==, 8192);
+
+	j_buffer_free(ref);
+	g_assert_cmpuint(j_buffer_get_size(buffer), ==, 0);
+}
+
+void
+test_core_buffer(void)
+{
+	g_test_add_func("/core/buffer/new_free", test_buffer_new_free);
+	g_test_add_func("/core/buffer/ref", test_buffer_ref);
+}
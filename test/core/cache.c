@@ -71,7 +71,7 @@ test_cache_release(void)
 	ret2 = j_cache_get(cache, 1);
 	g_assert_true(ret2 == NULL);
 
-	j_cache_release(cache, ret1);
+	j_cache_release(cache, ret1, 1);
 
 	ret1 = j_cache_get(cache, 1);
 	g_assert_true(ret1 != NULL);
@@ -81,10 +81,44 @@ test_cache_release(void)
 	j_cache_free(cache);
 }
 
+static void
+test_cache_wrap(void)
+{
+	JCache* cache;
+	gpointer ret1;
+	gpointer ret2;
+	gpointer ret3;
+
+	cache = j_cache_new(10);
+
+	ret1 = j_cache_get(cache, 4);
+	g_assert_true(ret1 != NULL);
+	ret2 = j_cache_get(cache, 4);
+	g_assert_true(ret2 != NULL);
+	g_assert_cmpuint(j_cache_get_used(cache), ==, 8);
+
+	// Does not fit at the end and the beginning is still in use.
+	ret3 = j_cache_get(cache, 4);
+	g_assert_true(ret3 == NULL);
+
+	j_cache_release(cache, ret1, 4);
+
+	ret3 = j_cache_get(cache, 4);
+	g_assert_true(ret3 == ret1);
+
+	j_cache_release(cache, ret2, 4);
+	j_cache_release(cache, ret3, 4);
+	g_assert_cmpuint(j_cache_get_used(cache), ==, 0);
+	g_assert_cmpuint(j_cache_get_high_water_mark(cache), ==, 10);
+
+	j_cache_free(cache);
+}
+
 void
 test_core_cache(void)
 {
 	g_test_add_func("/core/cache/new_free", test_cache_new_free);
 	g_test_add_func("/core/cache/get", test_cache_get);
 	g_test_add_func("/core/cache/release", test_cache_release);
+	g_test_add_func("/core/cache/wrap", test_cache_wrap);
 }
@@ -0,0 +1,122 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <julea.h>
+
+#include "test.h"
+
+static void
+test_checksum_crc32c(void)
+{
+	g_assert_cmpuint(j_checksum_crc32c(0, NULL, 0), ==, 0);
+	g_assert_cmpuint(j_checksum_crc32c(0, "123456789", 9), ==, 0xe3069283);
+}
+
+static void
+test_checksum_crc32c_incremental(void)
+{
+	guint const n = 1000;
+
+	g_autofree guint8* data = NULL;
+	guint32 crc;
+
+	data = g_malloc(n);
+
+	for (guint i = 0; i < n; i++)
+	{
+		data[i] = g_test_rand_int_range(0, 256);
+	}
+
+	crc = j_checksum_crc32c(0, data, n);
+
+	// Unaligned pieces have to result in the same checksum
+	for (guint i = 1; i < n; i += 37)
+	{
+		g_assert_cmpuint(j_checksum_crc32c(j_checksum_crc32c(0, data, i), data + i, n - i), ==, crc);
+	}
+
+	data[n / 2] ^= 1;
+	g_assert_cmpuint(j_checksum_crc32c(0, data, n), !=, crc);
+}
+
+static void
+test_checksum_hash(void)
+{
+	guint const n = 1000;
+
+	g_autofree guint8* data = NULL;
+	g_autoptr(GHashTable) hashes = NULL;
+	guint8 hash[J_CHECKSUM_HASH_SIZE];
+	guint8 other_hash[J_CHECKSUM_HASH_SIZE];
+
+	data = g_malloc(n);
+	hashes = g_hash_table_new_full(g_bytes_hash, g_bytes_equal, (GDestroyNotify)g_bytes_unref, NULL);
+
+	for (guint i = 0; i < n; i++)
+	{
+		data[i] = g_test_rand_int_range(0, 256);
+	}
+
+	// Copies at different alignments have to result in the same hash
+	j_checksum_hash(data + 1, n - 1, hash);
+	memmove(data, data + 1, n - 1);
+	j_checksum_hash(data, n - 1, other_hash);
+	g_assert_cmpmem(hash, sizeof(hash), other_hash, sizeof(other_hash));
+
+	// All prefixes are distinct, which covers the lanes as well as the remaining bytes
+	for (guint i = 0; i <= 200; i++)
+	{
+		j_checksum_hash(data, i, hash);
+		g_assert_true(g_hash_table_add(hashes, g_bytes_new(hash, sizeof(hash))));
+	}
+
+	j_checksum_hash(data, n, hash);
+	data[n / 2] ^= 1;
+	j_checksum_hash(data, n, other_hash);
+	g_assert_true(memcmp(hash, other_hash, sizeof(hash)) != 0);
+}
+
+static void
+test_checksum_digest(void)
+{
+	// SHA-256 of "abc", see FIPS 180-2
+	static guint8 const expected[J_CHECKSUM_DIGEST_SIZE] = {
+		0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+		0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+	};
+
+	guint8 digest[J_CHECKSUM_DIGEST_SIZE];
+
+	j_checksum_digest("abc", 3, digest);
+	g_assert_cmpmem(digest, sizeof(digest), expected, sizeof(expected));
+}
+
+void
+test_core_checksum(void)
+{
+	g_test_add_func("/core/checksum/crc32c", test_checksum_crc32c);
+	g_test_add_func("/core/checksum/crc32c_incremental", test_checksum_crc32c_incremental);
+	g_test_add_func("/core/checksum/hash", test_checksum_hash);
+	g_test_add_func("/core/checksum/digest", test_checksum_digest);
+}
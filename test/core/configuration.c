@@ -74,11 +74,13 @@ test_configuration_get(void)
 	gchar const* object_servers[] = { "localhost", "local.host", NULL };
 	gchar const* kv_servers[] = { "localhost", NULL };
 	gchar const* db_servers[] = { "localhost", "host.local", NULL };
+	gchar const* db_replicas[] = { "replica.local", NULL };
 
 	key_file = g_key_file_new();
 	g_key_file_set_string_list(key_file, "servers", "object", object_servers, 2);
 	g_key_file_set_string_list(key_file, "servers", "kv", kv_servers, 1);
 	g_key_file_set_string_list(key_file, "servers", "db", db_servers, 2);
+	g_key_file_set_string_list(key_file, "servers", "db-replicas", db_replicas, 1);
 	g_key_file_set_string(key_file, "object", "backend", "null");
 	g_key_file_set_string(key_file, "object", "component", "server");
 	g_key_file_set_string(key_file, "object", "path", "NULL");
@@ -88,6 +90,19 @@ test_configuration_get(void)
 	g_key_file_set_string(key_file, "db", "backend", "null3");
 	g_key_file_set_string(key_file, "db", "component", "client");
 	g_key_file_set_string(key_file, "db", "path", "NULL3");
+	g_key_file_set_uint64(key_file, "clients", "block-cache-size", 1024 * 1024);
+	g_key_file_set_integer(key_file, "clients", "retries", 3);
+	g_key_file_set_boolean(key_file, "clients", "hedged-reads", TRUE);
+	g_key_file_set_boolean(key_file, "clients", "compact-messages", TRUE);
+	g_key_file_set_string(key_file, "object", "local-backend", "memory");
+	g_key_file_set_string(key_file, "object", "local-path", "/tmp/julea/burst-buffer");
+	g_key_file_set_uint64(key_file, "object", "burst-buffer-bandwidth", 100 * 1024 * 1024);
+	g_key_file_set_string(key_file, "object", "cold-backend", "rados");
+	g_key_file_set_string(key_file, "object", "cold-path", "/etc/ceph/ceph.conf:data");
+	g_key_file_set_boolean(key_file, "object", "checksums", TRUE);
+	g_key_file_set_boolean(key_file, "object", "dedup", TRUE);
+	g_key_file_set_string(key_file, "object", "wal-path", "/mnt/nvme/julea-wal");
+	g_key_file_set_string(key_file, "addresses", "local.host", "192.0.2.1");
 
 	configuration = j_configuration_new_for_data(key_file);
 	g_assert_true(configuration != NULL);
@@ -103,6 +118,11 @@ test_configuration_get(void)
 	g_assert_cmpstr(j_configuration_get_server(configuration, J_BACKEND_TYPE_DB, 1), ==, "host.local");
 	g_assert_cmpuint(j_configuration_get_server_count(configuration, J_BACKEND_TYPE_DB), ==, 2);
 
+	// Replicas follow the servers.
+	g_assert_cmpuint(j_configuration_get_replica_count(configuration, J_BACKEND_TYPE_KV), ==, 0);
+	g_assert_cmpuint(j_configuration_get_replica_count(configuration, J_BACKEND_TYPE_DB), ==, 1);
+	g_assert_cmpstr(j_configuration_get_server(configuration, J_BACKEND_TYPE_DB, 2), ==, "replica.local");
+
 	g_assert_cmpstr(j_configuration_get_backend(configuration, J_BACKEND_TYPE_OBJECT), ==, "null");
 	g_assert_cmpstr(j_configuration_get_backend_component(configuration, J_BACKEND_TYPE_OBJECT), ==, "server");
 	g_assert_cmpstr(j_configuration_get_backend_path(configuration, J_BACKEND_TYPE_OBJECT), ==, "NULL");
@@ -115,15 +135,129 @@ test_configuration_get(void)
 	g_assert_cmpstr(j_configuration_get_backend_component(configuration, J_BACKEND_TYPE_DB), ==, "client");
 	g_assert_cmpstr(j_configuration_get_backend_path(configuration, J_BACKEND_TYPE_DB), ==, "NULL3");
 
+	g_assert_cmpuint(j_configuration_get_block_cache_size(configuration), ==, 1024 * 1024);
+	g_assert_cmpuint(j_configuration_get_retries(configuration), ==, 3);
+	g_assert_cmpuint(j_configuration_get_retry_delay(configuration), ==, 10);
+	g_assert_true(j_configuration_get_hedged_reads(configuration));
+	g_assert_true(j_configuration_get_compact_messages(configuration));
+
+	g_assert_cmpstr(j_configuration_get_local_backend(configuration, J_BACKEND_TYPE_OBJECT), ==, "memory");
+	g_assert_cmpstr(j_configuration_get_local_backend_path(configuration, J_BACKEND_TYPE_OBJECT), ==, "/tmp/julea/burst-buffer");
+	g_assert_cmpuint(j_configuration_get_burst_buffer_size(configuration), ==, G_GUINT64_CONSTANT(1024) * 1024 * 1024);
+	g_assert_cmpuint(j_configuration_get_burst_buffer_bandwidth(configuration), ==, 100 * 1024 * 1024);
+
+	g_assert_cmpstr(j_configuration_get_object_cold_backend(configuration), ==, "rados");
+	g_assert_cmpstr(j_configuration_get_object_cold_path(configuration), ==, "/etc/ceph/ceph.conf:data");
+	g_assert_cmpuint(j_configuration_get_object_cold_after(configuration), ==, 60 * 60);
+	g_assert_true(j_configuration_get_object_checksums(configuration));
+	g_assert_true(j_configuration_get_object_dedup(configuration));
+	g_assert_cmpstr(j_configuration_get_object_wal_path(configuration), ==, "/mnt/nvme/julea-wal");
+
+	g_assert_cmpstr(j_configuration_get_server_address(configuration, "local.host"), ==, "192.0.2.1");
+	g_assert_null(j_configuration_get_server_address(configuration, "host.local"));
+
 	j_configuration_unref(configuration);
 
 	g_key_file_free(key_file);
 }
 
+static void
+test_configuration_local_namespace(void)
+{
+	JConfiguration* configuration;
+	GKeyFile* key_file;
+	gchar const* servers[] = { "localhost", NULL };
+	gchar const* local_namespaces[] = { "scratch", "tmp-*", NULL };
+
+	key_file = g_key_file_new();
+	g_key_file_set_string_list(key_file, "servers", "object", servers, 1);
+	g_key_file_set_string_list(key_file, "servers", "kv", servers, 1);
+	g_key_file_set_string_list(key_file, "servers", "db", servers, 1);
+	g_key_file_set_string(key_file, "object", "backend", "null");
+	g_key_file_set_string(key_file, "object", "component", "server");
+	g_key_file_set_string(key_file, "object", "path", "");
+	g_key_file_set_string(key_file, "kv", "backend", "null");
+	g_key_file_set_string(key_file, "kv", "component", "server");
+	g_key_file_set_string(key_file, "kv", "path", "");
+	g_key_file_set_string(key_file, "db", "backend", "null");
+	g_key_file_set_string(key_file, "db", "component", "server");
+	g_key_file_set_string(key_file, "db", "path", "");
+
+	configuration = j_configuration_new_for_data(key_file);
+	g_assert_nonnull(configuration);
+	g_assert_null(j_configuration_get_local_backend(configuration, J_BACKEND_TYPE_KV));
+	g_assert_false(j_configuration_is_local_namespace(configuration, J_BACKEND_TYPE_KV, "scratch"));
+	j_configuration_unref(configuration);
+
+	g_key_file_set_string(key_file, "kv", "local-backend", "memory");
+	g_key_file_set_string(key_file, "kv", "local-path", "local");
+	g_key_file_set_string_list(key_file, "kv", "local-namespaces", local_namespaces, 2);
+
+	configuration = j_configuration_new_for_data(key_file);
+	g_assert_nonnull(configuration);
+	g_assert_cmpstr(j_configuration_get_local_backend(configuration, J_BACKEND_TYPE_KV), ==, "memory");
+	g_assert_cmpstr(j_configuration_get_local_backend_path(configuration, J_BACKEND_TYPE_KV), ==, "local");
+	g_assert_null(j_configuration_get_local_backend(configuration, J_BACKEND_TYPE_OBJECT));
+	g_assert_true(j_configuration_is_local_namespace(configuration, J_BACKEND_TYPE_KV, "scratch"));
+	g_assert_true(j_configuration_is_local_namespace(configuration, J_BACKEND_TYPE_KV, "tmp-42"));
+	g_assert_false(j_configuration_is_local_namespace(configuration, J_BACKEND_TYPE_KV, "scratch2"));
+	g_assert_false(j_configuration_is_local_namespace(configuration, J_BACKEND_TYPE_OBJECT, "scratch"));
+	j_configuration_unref(configuration);
+
+	g_key_file_free(key_file);
+}
+
+static void
+test_configuration_new_from_environment(void)
+{
+	JConfiguration* configuration;
+	g_autoptr(GKeyFile) key_file = NULL;
+	g_autofree gchar* data = NULL;
+	g_autofree gchar* encoded = NULL;
+	g_autofree gchar* value = NULL;
+	gchar const* servers[] = { "localhost", NULL };
+	gsize data_len;
+
+	key_file = g_key_file_new();
+	g_key_file_set_string_list(key_file, "servers", "object", servers, 1);
+	g_key_file_set_string_list(key_file, "servers", "kv", servers, 1);
+	g_key_file_set_string_list(key_file, "servers", "db", servers, 1);
+	g_key_file_set_string(key_file, "object", "backend", "null");
+	g_key_file_set_string(key_file, "object", "component", "server");
+	g_key_file_set_string(key_file, "object", "path", "environment");
+	g_key_file_set_string(key_file, "kv", "backend", "null");
+	g_key_file_set_string(key_file, "kv", "component", "server");
+	g_key_file_set_string(key_file, "kv", "path", "");
+	g_key_file_set_string(key_file, "db", "backend", "null");
+	g_key_file_set_string(key_file, "db", "component", "server");
+	g_key_file_set_string(key_file, "db", "path", "");
+
+	data = g_key_file_to_data(key_file, &data_len, NULL);
+
+	g_setenv("JULEA_CONFIG_DATA", data, TRUE);
+	configuration = j_configuration_new();
+	g_assert_nonnull(configuration);
+	g_assert_cmpstr(j_configuration_get_backend_path(configuration, J_BACKEND_TYPE_OBJECT), ==, "environment");
+	j_configuration_unref(configuration);
+
+	encoded = g_base64_encode((guchar const*)data, data_len);
+	value = g_strconcat("base64:", encoded, NULL);
+
+	g_setenv("JULEA_CONFIG_DATA", value, TRUE);
+	configuration = j_configuration_new();
+	g_assert_nonnull(configuration);
+	g_assert_cmpstr(j_configuration_get_backend_path(configuration, J_BACKEND_TYPE_OBJECT), ==, "environment");
+	j_configuration_unref(configuration);
+
+	g_unsetenv("JULEA_CONFIG_DATA");
+}
+
 void
 test_core_configuration(void)
 {
 	g_test_add_func("/core/configuration/new_ref_unref", test_configuration_new_ref_unref);
 	g_test_add_func("/core/configuration/new_for_data", test_configuration_new_for_data);
 	g_test_add_func("/core/configuration/get", test_configuration_get);
+	g_test_add_func("/core/configuration/local_namespace", test_configuration_local_namespace);
+	g_test_add_func("/core/configuration/new_from_environment", test_configuration_new_from_environment);
 }
@@ -0,0 +1,119 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <julea.h>
+
+#include "test.h"
+
+/**
+ * Returns a configuration whose servers do not exist.
+ * Nothing listens on port 1, so connections are refused right away.
+ **/
+static gchar*
+test_connection_pool_dead_configuration(void)
+{
+	g_autoptr(GKeyFile) key_file = NULL;
+	gchar const* servers[] = { "localhost:1", NULL };
+
+	key_file = g_key_file_new();
+	g_key_file_set_string_list(key_file, "servers", "object", servers, 1);
+	g_key_file_set_string_list(key_file, "servers", "kv", servers, 1);
+	g_key_file_set_string_list(key_file, "servers", "db", servers, 1);
+	g_key_file_set_string(key_file, "object", "backend", "null");
+	g_key_file_set_string(key_file, "object", "component", "server");
+	g_key_file_set_string(key_file, "object", "path", "");
+	g_key_file_set_string(key_file, "kv", "backend", "null");
+	g_key_file_set_string(key_file, "kv", "component", "server");
+	g_key_file_set_string(key_file, "kv", "path", "");
+	g_key_file_set_string(key_file, "db", "backend", "null");
+	g_key_file_set_string(key_file, "db", "component", "server");
+	g_key_file_set_string(key_file, "db", "path", "");
+	g_key_file_set_integer(key_file, "clients", "retries", 2);
+	g_key_file_set_integer(key_file, "clients", "retry-delay", 1);
+
+	return g_key_file_to_data(key_file, NULL, NULL);
+}
+
+static void
+test_connection_pool_dead_server_subprocess(void)
+{
+	g_autoptr(JMessage) message = NULL;
+	g_autoptr(JMessage) reply = NULL;
+	JConnectionPoolServerStatistics statistics;
+	gboolean ret;
+
+	if (!g_test_subprocess())
+	{
+		return;
+	}
+
+	// Failed connections are reported as warnings, which must not abort the test
+	g_log_set_always_fatal(G_LOG_FATAL_MASK);
+
+	g_assert_null(j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, 0));
+	g_assert_null(j_connection_pool_pop(J_BACKEND_TYPE_KV, 0));
+
+	// The failed attempts must not use up the pool's connections, otherwise this would block
+	g_assert_null(j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, 0));
+
+	message = j_message_new(J_MESSAGE_PING, 0);
+	reply = j_message_new_reply(message);
+
+	ret = j_connection_pool_exchange(J_BACKEND_TYPE_OBJECT, 0, message, reply);
+	g_assert_false(ret);
+
+	ret = j_connection_pool_get_server_statistics(J_BACKEND_TYPE_OBJECT, 0, &statistics);
+	g_assert_true(ret);
+	g_assert_cmpuint(statistics.errors, >=, 3);
+}
+
+static void
+test_connection_pool_dead_server(void)
+{
+	g_autofree gchar* data = NULL;
+	g_autofree gchar* old_data = NULL;
+
+	data = test_connection_pool_dead_configuration();
+	old_data = g_strdup(g_getenv("JULEA_CONFIG_DATA"));
+
+	// The subprocess initializes JULEA with the configuration from the environment, a timeout catches pops that block
+	g_setenv("JULEA_CONFIG_DATA", data, TRUE);
+	g_test_trap_subprocess("/core/connection-pool/dead_server/subprocess", 60 * G_USEC_PER_SEC, 0);
+
+	if (old_data != NULL)
+	{
+		g_setenv("JULEA_CONFIG_DATA", old_data, TRUE);
+	}
+	else
+	{
+		g_unsetenv("JULEA_CONFIG_DATA");
+	}
+
+	g_test_trap_assert_passed();
+}
+
+void
+test_core_connection_pool(void)
+{
+	g_test_add_func("/core/connection-pool/dead_server", test_connection_pool_dead_server);
+	g_test_add_func("/core/connection-pool/dead_server/subprocess", test_connection_pool_dead_server_subprocess);
+}
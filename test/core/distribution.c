@@ -65,6 +65,7 @@ test_distribution_distribute(JDistributionType type, JConfiguration** configurat
 	g_autoptr(JDistribution) distribution = NULL;
 	gboolean ret;
 	guint64 block_size;
+	guint64 value;
 	guint64 length;
 	guint64 offset;
 	guint64 block_id;
@@ -79,6 +80,10 @@ test_distribution_distribute(JDistributionType type, JConfiguration** configurat
 
 	j_distribution_set_block_size(distribution, block_size);
 
+	ret = j_distribution_get(distribution, "block-size", &value);
+	g_assert_true(ret);
+	g_assert_cmpuint(value, ==, block_size);
+
 	switch (type)
 	{
 		case J_DISTRIBUTION_ROUND_ROBIN:
@@ -213,10 +218,271 @@ test_distribution_weighted(JConfiguration** configuration, gconstpointer data)
 	test_distribution_distribute(J_DISTRIBUTION_WEIGHTED, configuration, data);
 }
 
+static void
+test_distribution_consistent(JConfiguration** configuration, gconstpointer data)
+{
+	JDistribution* distribution;
+	gboolean ret;
+	guint64 block_size;
+	guint64 length;
+	guint64 offset;
+	guint64 block_id;
+	guint index;
+	guint moved;
+
+	(void)data;
+
+	block_size = j_configuration_get_stripe_size(*configuration);
+
+	distribution = j_distribution_new_for_configuration(J_DISTRIBUTION_CONSISTENT, *configuration);
+	j_distribution_reset(distribution, 2 * block_size, 42);
+
+	ret = j_distribution_distribute(distribution, &index, &length, &offset, &block_id);
+	g_assert_true(ret);
+	g_assert_cmpuint(index, <, 2);
+	g_assert_cmpuint(length, ==, block_size - 42);
+	g_assert_cmpuint(offset, ==, 42);
+	g_assert_cmpuint(block_id, ==, 0);
+
+	ret = j_distribution_distribute(distribution, &index, &length, &offset, &block_id);
+	g_assert_true(ret);
+	g_assert_cmpuint(index, <, 2);
+	g_assert_cmpuint(length, ==, block_size);
+	g_assert_cmpuint(offset, ==, block_size);
+	g_assert_cmpuint(block_id, ==, 1);
+
+	ret = j_distribution_distribute(distribution, &index, &length, &offset, &block_id);
+	g_assert_true(ret);
+	g_assert_cmpuint(index, <, 2);
+	g_assert_cmpuint(length, ==, 42);
+	g_assert_cmpuint(offset, ==, 2 * block_size);
+	g_assert_cmpuint(block_id, ==, 2);
+
+	ret = j_distribution_distribute(distribution, &index, &length, &offset, &block_id);
+	g_assert_true(!ret);
+
+	j_distribution_unref(distribution);
+
+	// Growing from 4 to 5 buckets should only move keys to the new bucket.
+	moved = 0;
+
+	for (guint64 i = 0; i < 1000; i++)
+	{
+		guint32 old_bucket;
+		guint32 new_bucket;
+
+		old_bucket = j_helper_jump_hash(i, 4);
+		new_bucket = j_helper_jump_hash(i, 5);
+
+		if (old_bucket != new_bucket)
+		{
+			g_assert_cmpuint(new_bucket, ==, 4);
+			moved++;
+		}
+	}
+
+	g_assert_cmpuint(moved, >, 100);
+	g_assert_cmpuint(moved, <, 300);
+}
+
+static void
+test_distribution_local(void)
+{
+	g_autoptr(JConfiguration) configuration = NULL;
+	g_autoptr(JDistribution) distribution = NULL;
+	g_autoptr(GKeyFile) key_file = NULL;
+	gchar const* servers[] = { "host1", "host2", "host3", NULL };
+	gchar const* locality[] = { "pod1/rack1", "pod2/rack1", "pod1/rack1", NULL };
+	gboolean ret;
+	guint64 block_size;
+	guint64 length;
+	guint64 offset;
+	guint64 block_id;
+	guint index;
+
+	key_file = g_key_file_new();
+	g_key_file_set_string_list(key_file, "servers", "object", servers, 3);
+	g_key_file_set_string_list(key_file, "servers", "kv", servers, 3);
+	g_key_file_set_string_list(key_file, "servers", "db", servers, 3);
+	g_key_file_set_string_list(key_file, "servers", "object-locality", locality, 3);
+	g_key_file_set_string(key_file, "clients", "locality", "pod1/rack1");
+	g_key_file_set_string(key_file, "object", "backend", "null");
+	g_key_file_set_string(key_file, "object", "component", "server");
+	g_key_file_set_string(key_file, "object", "path", "");
+	g_key_file_set_string(key_file, "kv", "backend", "null");
+	g_key_file_set_string(key_file, "kv", "component", "server");
+	g_key_file_set_string(key_file, "kv", "path", "");
+	g_key_file_set_string(key_file, "db", "backend", "null");
+	g_key_file_set_string(key_file, "db", "component", "server");
+	g_key_file_set_string(key_file, "db", "path", "");
+
+	g_unsetenv("JULEA_LOCALITY");
+	configuration = j_configuration_new_for_data(key_file);
+
+	g_assert_cmpuint(j_configuration_get_local_server_count(configuration, J_BACKEND_TYPE_OBJECT), ==, 2);
+	g_assert_cmpuint(j_configuration_get_local_server(configuration, J_BACKEND_TYPE_OBJECT, 0), ==, 0);
+	g_assert_cmpuint(j_configuration_get_local_server(configuration, J_BACKEND_TYPE_OBJECT, 1), ==, 2);
+	// No labels for key-value servers, so all are local.
+	g_assert_cmpuint(j_configuration_get_local_server_count(configuration, J_BACKEND_TYPE_KV), ==, 3);
+
+	block_size = j_configuration_get_stripe_size(configuration);
+
+	distribution = j_distribution_new_for_configuration(J_DISTRIBUTION_LOCAL, configuration);
+	j_distribution_set(distribution, "start-index", 0);
+	j_distribution_reset(distribution, 3 * block_size, 0);
+
+	ret = j_distribution_distribute(distribution, &index, &length, &offset, &block_id);
+	g_assert_true(ret);
+	g_assert_cmpuint(index, ==, 0);
+	g_assert_cmpuint(offset, ==, 0);
+
+	ret = j_distribution_distribute(distribution, &index, &length, &offset, &block_id);
+	g_assert_true(ret);
+	g_assert_cmpuint(index, ==, 2);
+	g_assert_cmpuint(offset, ==, 0);
+
+	ret = j_distribution_distribute(distribution, &index, &length, &offset, &block_id);
+	g_assert_true(ret);
+	g_assert_cmpuint(index, ==, 0);
+	g_assert_cmpuint(offset, ==, block_size);
+
+	ret = j_distribution_distribute(distribution, &index, &length, &offset, &block_id);
+	g_assert_true(!ret);
+}
+
+static void
+test_distribution_tune(JConfiguration** configuration, gconstpointer data)
+{
+	g_autoptr(JDistribution) small = NULL;
+	g_autoptr(JDistribution) large = NULL;
+	g_autoptr(JDistribution) fixed = NULL;
+	gboolean ret;
+	guint64 stripe_size;
+	guint64 length;
+	guint64 offset;
+	guint64 block_id;
+	guint index;
+	guint first_index;
+
+	(void)data;
+
+	stripe_size = j_configuration_get_stripe_size(*configuration);
+
+	// Small objects are stored on a single server
+	small = j_distribution_new_for_configuration(J_DISTRIBUTION_ROUND_ROBIN, *configuration);
+	j_distribution_set_autotune(small, TRUE);
+	g_assert_true(j_distribution_get_autotune(small));
+	ret = j_distribution_tune(small, stripe_size / 2);
+	g_assert_true(ret);
+	g_assert_false(j_distribution_get_autotune(small));
+
+	j_distribution_reset(small, 4 * stripe_size, 0);
+
+	ret = j_distribution_distribute(small, &first_index, &length, &offset, &block_id);
+	g_assert_true(ret);
+
+	while (j_distribution_distribute(small, &index, &length, &offset, &block_id))
+	{
+		g_assert_cmpuint(index, ==, first_index);
+	}
+
+	// Large objects use all servers with larger blocks
+	large = j_distribution_new_for_configuration(J_DISTRIBUTION_ROUND_ROBIN, *configuration);
+	j_distribution_set_autotune(large, TRUE);
+	ret = j_distribution_tune(large, 1024 * stripe_size);
+	g_assert_true(ret);
+
+	j_distribution_reset(large, 2 * 1024 * stripe_size, 0);
+
+	ret = j_distribution_distribute(large, &first_index, &length, &offset, &block_id);
+	g_assert_true(ret);
+	g_assert_cmpuint(length, >, stripe_size);
+
+	ret = j_distribution_distribute(large, &index, &length, &offset, &block_id);
+	g_assert_true(ret);
+	g_assert_cmpuint(index, !=, first_index);
+
+	// Distributions without autotune are not changed
+	fixed = j_distribution_new_for_configuration(J_DISTRIBUTION_ROUND_ROBIN, *configuration);
+	ret = j_distribution_tune(fixed, stripe_size / 2);
+	g_assert_false(ret);
+}
+
+static void
+test_distribution_replicated(JConfiguration** configuration, gconstpointer data)
+{
+	g_autoptr(JDistribution) distribution = NULL;
+	gboolean ret;
+	guint64 block_size;
+	guint64 length;
+	guint64 offset;
+	guint64 block_id;
+	guint64 replicas;
+	guint index;
+	guint replica_index;
+	guint64 replica_offset;
+
+	(void)data;
+
+	block_size = j_configuration_get_stripe_size(*configuration);
+
+	distribution = j_distribution_new_for_configuration(J_DISTRIBUTION_REPLICATED, *configuration);
+	j_distribution_set(distribution, "start-index", 1);
+	j_distribution_set(distribution, "replicas", 2);
+
+	ret = j_distribution_get(distribution, "replicas", &replicas);
+	g_assert_true(ret);
+	g_assert_cmpuint(replicas, ==, 2);
+
+	j_distribution_reset(distribution, 2 * block_size, 42);
+
+	ret = j_distribution_distribute(distribution, &index, &length, &offset, &block_id);
+	g_assert_true(ret);
+	g_assert_cmpuint(index, ==, 1);
+	g_assert_cmpuint(length, ==, block_size - 42);
+	g_assert_cmpuint(offset, ==, 42);
+
+	// The first copy is the one returned by j_distribution_distribute()
+	ret = j_distribution_distribute_replica(distribution, 0, &replica_index, &replica_offset);
+	g_assert_true(ret);
+	g_assert_cmpuint(replica_index, ==, 1);
+	g_assert_cmpuint(replica_offset, ==, 42);
+
+	ret = j_distribution_distribute_replica(distribution, 1, &replica_index, &replica_offset);
+	g_assert_true(ret);
+	g_assert_cmpuint(replica_index, ==, 0);
+	g_assert_cmpuint(replica_offset, ==, 42);
+
+	ret = j_distribution_distribute_replica(distribution, 2, &replica_index, &replica_offset);
+	g_assert_false(ret);
+
+	ret = j_distribution_distribute(distribution, &index, &length, &offset, &block_id);
+	g_assert_true(ret);
+	g_assert_cmpuint(index, ==, 0);
+	g_assert_cmpuint(length, ==, block_size);
+	g_assert_cmpuint(offset, ==, block_size);
+
+	ret = j_distribution_distribute_replica(distribution, 1, &replica_index, &replica_offset);
+	g_assert_true(ret);
+	g_assert_cmpuint(replica_index, ==, 1);
+	g_assert_cmpuint(replica_offset, ==, block_size);
+
+	ret = j_distribution_distribute(distribution, &index, &length, &offset, &block_id);
+	g_assert_true(ret);
+	g_assert_cmpuint(length, ==, 42);
+
+	ret = j_distribution_distribute(distribution, &index, &length, &offset, &block_id);
+	g_assert_false(ret);
+}
+
 void
 test_core_distribution(void)
 {
 	g_test_add("/core/distribution/round_robin", JConfiguration*, NULL, test_distribution_fixture_setup, test_distribution_round_robin, test_distribution_fixture_teardown);
 	g_test_add("/core/distribution/single_server", JConfiguration*, NULL, test_distribution_fixture_setup, test_distribution_single_server, test_distribution_fixture_teardown);
 	g_test_add("/core/distribution/weighted", JConfiguration*, NULL, test_distribution_fixture_setup, test_distribution_weighted, test_distribution_fixture_teardown);
+	g_test_add("/core/distribution/consistent", JConfiguration*, NULL, test_distribution_fixture_setup, test_distribution_consistent, test_distribution_fixture_teardown);
+	g_test_add("/core/distribution/replicated", JConfiguration*, NULL, test_distribution_fixture_setup, test_distribution_replicated, test_distribution_fixture_teardown);
+	g_test_add("/core/distribution/tune", JConfiguration*, NULL, test_distribution_fixture_setup, test_distribution_tune, test_distribution_fixture_teardown);
+	g_test_add_func("/core/distribution/local", test_distribution_local);
 }
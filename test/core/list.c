@@ -115,6 +115,105 @@ test_list_get(JList** list, gconstpointer data)
 	g_assert_cmpstr(s, ==, "-1");
 }
 
+static void
+test_list_remove(JList** list, gconstpointer data)
+{
+	gchar* first;
+	gchar* middle;
+	gchar* last;
+	gchar const* s;
+
+	(void)data;
+
+	first = g_strdup("0");
+	middle = g_strdup("1");
+	last = g_strdup("2");
+
+	j_list_append(*list, first);
+	j_list_append(*list, middle);
+	j_list_append(*list, last);
+
+	g_assert_true(j_list_remove(*list, middle));
+	g_assert_cmpuint(j_list_length(*list), ==, 2);
+
+	g_assert_true(j_list_remove(*list, last));
+	s = j_list_get_last(*list);
+	g_assert_cmpstr(s, ==, "0");
+
+	g_assert_false(j_list_remove(*list, (gpointer)"missing"));
+
+	g_assert_true(j_list_remove(*list, first));
+	g_assert_cmpuint(j_list_length(*list), ==, 0);
+	g_assert_null(j_list_get_first(*list));
+	g_assert_null(j_list_get_last(*list));
+
+	j_list_append(*list, g_strdup("3"));
+	s = j_list_get_first(*list);
+	g_assert_cmpstr(s, ==, "3");
+}
+
+static void
+test_list_reuse(JList** list, gconstpointer data)
+{
+	gchar const* s;
+
+	(void)data;
+
+	// Emptied lists keep their array, the list must not see stale elements.
+	for (guint i = 0; i < 3; i++)
+	{
+		for (guint j = 0; j < 5000; j++)
+		{
+			j_list_append(*list, g_strdup_printf("%u", j));
+		}
+
+		g_assert_cmpuint(j_list_length(*list), ==, 5000);
+		s = j_list_get_first(*list);
+		g_assert_cmpstr(s, ==, "0");
+		s = j_list_get_last(*list);
+		g_assert_cmpstr(s, ==, "4999");
+
+		j_list_delete_all(*list);
+		g_assert_cmpuint(j_list_length(*list), ==, 0);
+	}
+
+	j_list_prepend(*list, g_strdup("1"));
+	j_list_prepend(*list, g_strdup("0"));
+	s = j_list_get_last(*list);
+	g_assert_cmpstr(s, ==, "1");
+}
+
+static void
+test_list_mixed(JList** list, gconstpointer data)
+{
+	g_autoptr(JListIterator) iterator = NULL;
+	gint expected = -1000;
+
+	(void)data;
+
+	// Prepends and appends both have to grow the array.
+	for (gint i = 0; i < 1000; i++)
+	{
+		j_list_append(*list, g_strdup_printf("%d", i));
+		j_list_prepend(*list, g_strdup_printf("%d", -i - 1));
+	}
+
+	g_assert_cmpuint(j_list_length(*list), ==, 2000);
+
+	iterator = j_list_iterator_new(*list);
+
+	while (j_list_iterator_next(iterator))
+	{
+		g_autofree gchar* s = NULL;
+
+		s = g_strdup_printf("%d", expected);
+		g_assert_cmpstr(j_list_iterator_get(iterator), ==, s);
+		expected++;
+	}
+
+	g_assert_cmpint(expected, ==, 1000);
+}
+
 void
 test_core_list(void)
 {
@@ -123,4 +222,7 @@ test_core_list(void)
 	g_test_add("/core/list/append", JList*, NULL, test_list_fixture_setup, test_list_append, test_list_fixture_teardown);
 	g_test_add("/core/list/prepend", JList*, NULL, test_list_fixture_setup, test_list_prepend, test_list_fixture_teardown);
 	g_test_add("/core/list/get", JList*, NULL, test_list_fixture_setup, test_list_get, test_list_fixture_teardown);
+	g_test_add("/core/list/remove", JList*, NULL, test_list_fixture_setup, test_list_remove, test_list_fixture_teardown);
+	g_test_add("/core/list/reuse", JList*, NULL, test_list_fixture_setup, test_list_reuse, test_list_fixture_teardown);
+	g_test_add("/core/list/mixed", JList*, NULL, test_list_fixture_setup, test_list_mixed, test_list_fixture_teardown);
 }
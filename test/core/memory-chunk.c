@@ -80,10 +80,85 @@ test_memory_chunk_reset(void)
 	j_memory_chunk_free(memory_chunk);
 }
 
+static void
+test_memory_chunk_peak(void)
+{
+	JMemoryChunk* memory_chunk;
+	gpointer ret;
+
+	memory_chunk = j_memory_chunk_new(3);
+	g_assert_cmpuint(j_memory_chunk_get_peak(memory_chunk), ==, 0);
+
+	ret = j_memory_chunk_get(memory_chunk, 2);
+	g_assert_true(ret != NULL);
+	g_assert_cmpuint(j_memory_chunk_get_peak(memory_chunk), ==, 2);
+
+	j_memory_chunk_reset(memory_chunk);
+
+	ret = j_memory_chunk_get(memory_chunk, 1);
+	g_assert_true(ret != NULL);
+	g_assert_cmpuint(j_memory_chunk_get_peak(memory_chunk), ==, 2);
+
+	ret = j_memory_chunk_get(memory_chunk, 2);
+	g_assert_true(ret != NULL);
+	g_assert_cmpuint(j_memory_chunk_get_peak(memory_chunk), ==, 3);
+
+	j_memory_chunk_free(memory_chunk);
+}
+
+static void
+test_memory_chunk_growable(void)
+{
+	JMemoryChunk* memory_chunk;
+	gpointer ret;
+
+	memory_chunk = j_memory_chunk_new_growable(2, 6, FALSE);
+	g_assert_cmpuint(j_memory_chunk_get_size(memory_chunk), ==, 2);
+
+	ret = j_memory_chunk_get(memory_chunk, 2);
+	g_assert_true(ret != NULL);
+	ret = j_memory_chunk_get(memory_chunk, 1);
+	g_assert_true(ret != NULL);
+	g_assert_cmpuint(j_memory_chunk_get_size(memory_chunk), ==, 4);
+
+	// Larger requests get their own segment
+	ret = j_memory_chunk_get(memory_chunk, 3);
+	g_assert_true(ret == NULL);
+	ret = j_memory_chunk_get(memory_chunk, 2);
+	g_assert_true(ret != NULL);
+	g_assert_cmpuint(j_memory_chunk_get_size(memory_chunk), ==, 6);
+	g_assert_cmpuint(j_memory_chunk_get_peak(memory_chunk), ==, 5);
+
+	ret = j_memory_chunk_get(memory_chunk, 1);
+	g_assert_true(ret == NULL);
+
+	// Existing segments are reused after a reset
+	j_memory_chunk_reset(memory_chunk);
+
+	for (guint i = 0; i < 3; i++)
+	{
+		ret = j_memory_chunk_get(memory_chunk, 2);
+		g_assert_true(ret != NULL);
+	}
+
+	g_assert_cmpuint(j_memory_chunk_get_size(memory_chunk), ==, 6);
+
+	j_memory_chunk_shrink(memory_chunk);
+	g_assert_cmpuint(j_memory_chunk_get_size(memory_chunk), ==, 2);
+
+	ret = j_memory_chunk_get(memory_chunk, 4);
+	g_assert_true(ret != NULL);
+	g_assert_cmpuint(j_memory_chunk_get_size(memory_chunk), ==, 6);
+
+	j_memory_chunk_free(memory_chunk);
+}
+
 void
 test_core_memory_chunk(void)
 {
 	g_test_add_func("/core/memory-chunk/new_free", test_memory_chunk_new_free);
 	g_test_add_func("/core/memory-chunk/get", test_memory_chunk_get);
 	g_test_add_func("/core/memory-chunk/reset", test_memory_chunk_reset);
+	g_test_add_func("/core/memory-chunk/peak", test_memory_chunk_peak);
+	g_test_add_func("/core/memory-chunk/growable", test_memory_chunk_growable);
 }
@@ -22,6 +22,7 @@
 #include <gio/gio.h>
 
 #include <string.h>
+#include <sys/socket.h>
 
 #include <julea.h>
 
@@ -165,6 +166,79 @@ test_message_write_read(void)
 	g_assert_cmpstr(dummy_str, ==, "42");
 }
 
+static void
+test_message_compact(void)
+{
+	g_autoptr(GSocketConnection) connection_send = NULL;
+	g_autoptr(GSocketConnection) connection_recv = NULL;
+	g_autoptr(GSocket) socket_send = NULL;
+	g_autoptr(GSocket) socket_recv = NULL;
+	guint64 const lengths[] = { 4096, 4096 | J_MESSAGE_LENGTH_CHECKSUM, 100 };
+	guint64 const offsets[] = { 8192, 12288, 0 };
+	gint fds[2];
+	gboolean ret;
+
+	ret = (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+	g_assert_true(ret);
+
+	socket_send = g_socket_new_from_fd(fds[0], NULL);
+	g_assert_nonnull(socket_send);
+	socket_recv = g_socket_new_from_fd(fds[1], NULL);
+	g_assert_nonnull(socket_recv);
+
+	connection_send = g_socket_connection_factory_create_connection(socket_send);
+	connection_recv = g_socket_connection_factory_create_connection(socket_recv);
+
+	j_message_set_compact(connection_send, TRUE);
+
+	// The second message refers to the first one's namespace and name
+	for (guint i = 0; i < 2; i++)
+	{
+		g_autoptr(JMessage) message_send = NULL;
+		g_autoptr(JMessage) message_recv = NULL;
+		guint32 crc = 2342;
+
+		message_send = j_message_new(J_MESSAGE_OBJECT_WRITE, strlen("test-ns") + 1 + strlen("test-object") + 1);
+		j_message_append_string(message_send, "test-ns");
+		j_message_append_string(message_send, "test-object");
+
+		for (guint j = 0; j < G_N_ELEMENTS(lengths); j++)
+		{
+			j_message_add_operation(message_send, sizeof(guint64) + sizeof(guint64) + (((lengths[j] & J_MESSAGE_LENGTH_CHECKSUM) != 0) ? sizeof(guint32) : 0));
+			j_message_append_8(message_send, &(lengths[j]));
+			j_message_append_8(message_send, &(offsets[j]));
+
+			if ((lengths[j] & J_MESSAGE_LENGTH_CHECKSUM) != 0)
+			{
+				j_message_append_4(message_send, &crc);
+			}
+		}
+
+		ret = j_message_send(message_send, connection_send);
+		g_assert_true(ret);
+
+		message_recv = j_message_new(J_MESSAGE_NONE, 0);
+		ret = j_message_receive(message_recv, connection_recv);
+		g_assert_true(ret);
+
+		g_assert_cmpint(j_message_get_type(message_recv), ==, J_MESSAGE_OBJECT_WRITE);
+		g_assert_cmpuint(j_message_get_count(message_recv), ==, G_N_ELEMENTS(lengths));
+		g_assert_cmpstr(j_message_get_string(message_recv), ==, "test-ns");
+		g_assert_cmpstr(j_message_get_string(message_recv), ==, "test-object");
+
+		for (guint j = 0; j < G_N_ELEMENTS(lengths); j++)
+		{
+			g_assert_cmpuint(j_message_get_8(message_recv), ==, lengths[j]);
+			g_assert_cmpuint(j_message_get_8(message_recv), ==, offsets[j]);
+
+			if ((lengths[j] & J_MESSAGE_LENGTH_CHECKSUM) != 0)
+			{
+				g_assert_cmpuint(j_message_get_4(message_recv), ==, crc);
+			}
+		}
+	}
+}
+
 static void
 test_message_semantics(void)
 {
@@ -198,5 +272,6 @@ test_core_message(void)
 	g_test_add_func("/core/message/header", test_message_header);
 	g_test_add_func("/core/message/append", test_message_append);
 	g_test_add_func("/core/message/write_read", test_message_write_read);
+	g_test_add_func("/core/message/compact", test_message_compact);
 	g_test_add_func("/core/message/semantics", test_message_semantics);
 }
@@ -0,0 +1,155 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <julea.h>
+
+#include "test.h"
+
+/**
+ * Sends a message through memory streams, so that it can be read from.
+ **/
+static JMessage*
+test_reduce_transfer(JMessage* message)
+{
+	g_autoptr(GOutputStream) output = NULL;
+	g_autoptr(GInputStream) input = NULL;
+	JMessage* received;
+	gboolean ret;
+
+	output = g_memory_output_stream_new(NULL, 0, g_realloc, g_free);
+	input = g_memory_input_stream_new();
+
+	ret = j_message_write(message, output);
+	g_assert_true(ret);
+
+	g_memory_input_stream_add_data(
+		G_MEMORY_INPUT_STREAM(input),
+		g_memory_output_stream_get_data(G_MEMORY_OUTPUT_STREAM(output)),
+		g_memory_output_stream_get_data_size(G_MEMORY_OUTPUT_STREAM(output)),
+		NULL);
+
+	received = j_message_new(J_MESSAGE_NONE, 0);
+	ret = j_message_read(received, input);
+	g_assert_true(ret);
+
+	return received;
+}
+
+static void
+test_reduce_process(void)
+{
+	g_autoptr(JReduce) reduce = NULL;
+	gint32 data[] = { 3, -1, 4, 1, 5 };
+
+	reduce = j_reduce_new(J_REDUCE_TYPE_INT32);
+
+	g_assert_cmpuint(j_reduce_get_count(reduce), ==, 0);
+
+	// The trailing partial element is ignored.
+	j_reduce_process(reduce, data, sizeof(data) + 2);
+
+	g_assert_cmpuint(j_reduce_get_count(reduce), ==, 5);
+	g_assert_cmpfloat(j_reduce_get_sum(reduce), ==, 12.0);
+	g_assert_cmpfloat(j_reduce_get_min(reduce), ==, -1.0);
+	g_assert_cmpfloat(j_reduce_get_max(reduce), ==, 5.0);
+}
+
+static void
+test_reduce_filter_histogram(void)
+{
+	g_autoptr(JReduce) reduce = NULL;
+	gdouble data[] = { 0.5, 1.5, 2.5, 3.5, 10.0, -4.0 };
+	guint64 const* histogram;
+	guint32 bins;
+
+	reduce = j_reduce_new(J_REDUCE_TYPE_FLOAT64);
+	j_reduce_set_filter(reduce, 0.0, 4.0);
+	j_reduce_set_histogram(reduce, 0.0, 4.0, 2);
+
+	j_reduce_process(reduce, data, sizeof(data));
+
+	g_assert_cmpuint(j_reduce_get_count(reduce), ==, 4);
+	g_assert_cmpfloat(j_reduce_get_sum(reduce), ==, 8.0);
+	g_assert_cmpfloat(j_reduce_get_min(reduce), ==, 0.5);
+	g_assert_cmpfloat(j_reduce_get_max(reduce), ==, 3.5);
+
+	histogram = j_reduce_get_histogram(reduce, &bins);
+
+	g_assert_cmpuint(bins, ==, 2);
+	g_assert_cmpuint(histogram[0], ==, 2);
+	g_assert_cmpuint(histogram[1], ==, 2);
+}
+
+static void
+test_reduce_message(void)
+{
+	g_autoptr(JMessage) message = NULL;
+	g_autoptr(JMessage) message_recv = NULL;
+	g_autoptr(JMessage) reply = NULL;
+	g_autoptr(JMessage) reply_recv = NULL;
+	g_autoptr(JReduce) reduce = NULL;
+	g_autoptr(JReduce) remote = NULL;
+	guint64 data[] = { 1, 2, 3, 4 };
+	guint64 const* histogram;
+	guint32 bins;
+
+	reduce = j_reduce_new(J_REDUCE_TYPE_UINT64);
+	j_reduce_set_histogram(reduce, 0.0, 4.0, 4);
+	j_reduce_process(reduce, data, sizeof(guint64));
+
+	message = j_message_new(J_MESSAGE_OBJECT_REDUCE, j_reduce_get_spec_size());
+	j_reduce_append_spec(reduce, message);
+
+	// Simulate the server, which only knows the settings.
+	message_recv = test_reduce_transfer(message);
+	remote = j_reduce_new_from_message(message_recv);
+	g_assert_nonnull(remote);
+	j_reduce_process(remote, data + 1, 3 * sizeof(guint64));
+
+	reply = j_message_new(J_MESSAGE_NONE, j_reduce_get_result_size(remote));
+	j_reduce_append_result(remote, reply);
+
+	reply_recv = test_reduce_transfer(reply);
+	j_reduce_merge_from_message(reduce, reply_recv);
+
+	g_assert_cmpuint(j_reduce_get_count(reduce), ==, 4);
+	g_assert_cmpfloat(j_reduce_get_sum(reduce), ==, 10.0);
+	g_assert_cmpfloat(j_reduce_get_min(reduce), ==, 1.0);
+	g_assert_cmpfloat(j_reduce_get_max(reduce), ==, 4.0);
+
+	histogram = j_reduce_get_histogram(reduce, &bins);
+
+	g_assert_cmpuint(bins, ==, 4);
+	g_assert_cmpuint(histogram[0], ==, 0);
+	g_assert_cmpuint(histogram[1], ==, 1);
+	g_assert_cmpuint(histogram[2], ==, 1);
+	g_assert_cmpuint(histogram[3], ==, 2);
+}
+
+void
+test_core_reduce(void)
+{
+	g_test_add_func("/core/reduce/process", test_reduce_process);
+	g_test_add_func("/core/reduce/filter_histogram", test_reduce_filter_histogram);
+	g_test_add_func("/core/reduce/message", test_reduce_message);
+}
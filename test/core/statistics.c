@@ -0,0 +1,132 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <julea.h>
+
+#include <jstatistics.h>
+
+#include "test.h"
+
+static void
+test_statistics_new_free(void)
+{
+	JStatistics* statistics;
+
+	statistics = j_statistics_new(FALSE);
+	g_assert_true(statistics != NULL);
+
+	g_assert_cmpuint(j_statistics_get(statistics, J_STATISTICS_BYTES_READ), ==, 0);
+	g_assert_cmpuint(j_statistics_get_message(statistics, J_MESSAGE_OBJECT_READ, J_STATISTICS_MESSAGE_REQUESTS), ==, 0);
+	g_assert_cmpuint(j_statistics_get_latency(statistics, J_MESSAGE_OBJECT_READ, 0), ==, 0);
+
+	j_statistics_free(statistics);
+}
+
+static void
+test_statistics_add(void)
+{
+	JStatistics* statistics;
+
+	statistics = j_statistics_new(FALSE);
+
+	j_statistics_add(statistics, J_STATISTICS_BYTES_READ, 42);
+	j_statistics_add(statistics, J_STATISTICS_BYTES_READ, 23);
+	g_assert_cmpuint(j_statistics_get(statistics, J_STATISTICS_BYTES_READ), ==, 65);
+	g_assert_cmpuint(j_statistics_get(statistics, J_STATISTICS_BYTES_WRITTEN), ==, 0);
+
+	j_statistics_add_message(statistics, J_MESSAGE_KV_PUT, J_STATISTICS_MESSAGE_REQUESTS, 2);
+	j_statistics_add_message(statistics, J_MESSAGE_KV_PUT, J_STATISTICS_MESSAGE_BYTES, 1024);
+	j_statistics_add_message(statistics, J_MESSAGE_KV_PUT, J_STATISTICS_MESSAGE_TIME, 100);
+	g_assert_cmpuint(j_statistics_get_message(statistics, J_MESSAGE_KV_PUT, J_STATISTICS_MESSAGE_REQUESTS), ==, 2);
+	g_assert_cmpuint(j_statistics_get_message(statistics, J_MESSAGE_KV_PUT, J_STATISTICS_MESSAGE_BYTES), ==, 1024);
+	g_assert_cmpuint(j_statistics_get_message(statistics, J_MESSAGE_KV_PUT, J_STATISTICS_MESSAGE_TIME), ==, 100);
+	g_assert_cmpuint(j_statistics_get_message(statistics, J_MESSAGE_KV_GET, J_STATISTICS_MESSAGE_REQUESTS), ==, 0);
+
+	j_statistics_add_message(statistics, J_MESSAGE_KV_PUT, J_STATISTICS_MESSAGE_QUEUE_TIME, 10);
+	j_statistics_add_message(statistics, J_MESSAGE_KV_PUT, J_STATISTICS_MESSAGE_RECEIVE_TIME, 20);
+	j_statistics_add_message(statistics, J_MESSAGE_KV_PUT, J_STATISTICS_MESSAGE_SERVICE_TIME, 60);
+	j_statistics_add_message(statistics, J_MESSAGE_KV_PUT, J_STATISTICS_MESSAGE_REPLY_TIME, 10);
+	g_assert_cmpuint(j_statistics_get_message(statistics, J_MESSAGE_KV_PUT, J_STATISTICS_MESSAGE_QUEUE_TIME), ==, 10);
+	g_assert_cmpuint(j_statistics_get_message(statistics, J_MESSAGE_KV_PUT, J_STATISTICS_MESSAGE_RECEIVE_TIME), ==, 20);
+	g_assert_cmpuint(j_statistics_get_message(statistics, J_MESSAGE_KV_PUT, J_STATISTICS_MESSAGE_SERVICE_TIME), ==, 60);
+	g_assert_cmpuint(j_statistics_get_message(statistics, J_MESSAGE_KV_PUT, J_STATISTICS_MESSAGE_REPLY_TIME), ==, 10);
+
+	j_statistics_free(statistics);
+}
+
+static void
+test_statistics_latency(void)
+{
+	JStatistics* statistics;
+
+	statistics = j_statistics_new(FALSE);
+
+	j_statistics_add_latency(statistics, J_MESSAGE_PING, 0);
+	j_statistics_add_latency(statistics, J_MESSAGE_PING, 1);
+	j_statistics_add_latency(statistics, J_MESSAGE_PING, 2);
+	j_statistics_add_latency(statistics, J_MESSAGE_PING, 3);
+	j_statistics_add_latency(statistics, J_MESSAGE_PING, 4);
+	j_statistics_add_latency(statistics, J_MESSAGE_PING, G_MAXUINT64);
+
+	g_assert_cmpuint(j_statistics_get_latency(statistics, J_MESSAGE_PING, 0), ==, 1);
+	g_assert_cmpuint(j_statistics_get_latency(statistics, J_MESSAGE_PING, 1), ==, 1);
+	g_assert_cmpuint(j_statistics_get_latency(statistics, J_MESSAGE_PING, 2), ==, 2);
+	g_assert_cmpuint(j_statistics_get_latency(statistics, J_MESSAGE_PING, 3), ==, 1);
+	g_assert_cmpuint(j_statistics_get_latency(statistics, J_MESSAGE_PING, J_STATISTICS_LATENCY_BUCKETS - 1), ==, 1);
+
+	j_statistics_free(statistics);
+}
+
+static void
+test_statistics_merge(void)
+{
+	JStatistics* statistics;
+	JStatistics* other;
+
+	statistics = j_statistics_new(FALSE);
+	other = j_statistics_new(FALSE);
+
+	j_statistics_add(statistics, J_STATISTICS_FILES_CREATED, 1);
+	j_statistics_add(other, J_STATISTICS_FILES_CREATED, 2);
+	j_statistics_add(other, J_STATISTICS_FILES_STATED, 3);
+	j_statistics_add_message(other, J_MESSAGE_OBJECT_WRITE, J_STATISTICS_MESSAGE_REQUESTS, 1);
+	j_statistics_add_latency(other, J_MESSAGE_OBJECT_WRITE, 1);
+
+	j_statistics_merge(statistics, other);
+
+	g_assert_cmpuint(j_statistics_get(statistics, J_STATISTICS_FILES_CREATED), ==, 3);
+	g_assert_cmpuint(j_statistics_get(statistics, J_STATISTICS_FILES_STATED), ==, 3);
+	g_assert_cmpuint(j_statistics_get_message(statistics, J_MESSAGE_OBJECT_WRITE, J_STATISTICS_MESSAGE_REQUESTS), ==, 1);
+	g_assert_cmpuint(j_statistics_get_latency(statistics, J_MESSAGE_OBJECT_WRITE, 1), ==, 1);
+
+	j_statistics_free(other);
+	j_statistics_free(statistics);
+}
+
+void
+test_core_statistics(void)
+{
+	g_test_add_func("/core/statistics/new_free", test_statistics_new_free);
+	g_test_add_func("/core/statistics/add", test_statistics_add);
+	g_test_add_func("/core/statistics/latency", test_statistics_latency);
+	g_test_add_func("/core/statistics/merge", test_statistics_merge);
+}
@@ -21,6 +21,8 @@
 
 #include <glib.h>
 
+#include <string.h>
+
 #include <julea.h>
 #include <julea-db.h>
 
@@ -74,85 +76,853 @@ test_db_schema_create_delete(void)
 		ret = j_db_schema_add_field(schema, "uint-0", J_DB_TYPE_UINT64, &error);
 		g_assert_true(ret);
 		g_assert_no_error(error);
-		ret = j_db_schema_add_field(schema, "uint-1", J_DB_TYPE_UINT64, &error);
+		ret = j_db_schema_add_field(schema, "uint-1", J_DB_TYPE_UINT64, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		ret = j_db_schema_add_field(schema, "float-0", J_DB_TYPE_FLOAT64, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		ret = j_db_schema_add_field(schema, "float-1", J_DB_TYPE_FLOAT64, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_schema_add_index(schema, idx_string, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		ret = j_db_schema_add_index(schema, idx_uint, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		ret = j_db_schema_add_index(schema, idx_float, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_schema_create(schema, batch, NULL);
+		g_assert_true(ret);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_schema_delete(schema, batch, NULL);
+		g_assert_true(ret);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_db_schema_get_cached(void)
+{
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JDBSchema) schema = NULL;
+	JDBType type;
+	gboolean ret;
+
+	schema = j_db_schema_new("test-ns", "test-schema-cached", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "uint-0", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	// Fetching the schema repeatedly is served by the cache after the first time
+	for (guint i = 0; i < 2; i++)
+	{
+		g_autoptr(JDBSchema) other = NULL;
+
+		other = j_db_schema_new("test-ns", "test-schema-cached", &error);
+		g_assert_nonnull(other);
+
+		ret = j_db_schema_get(other, batch, &error);
+		g_assert_true(ret);
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_schema_get_field(other, "uint-0", &type, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(type, ==, J_DB_TYPE_UINT64);
+	}
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	{
+		g_autoptr(JDBSchema) other = NULL;
+
+		other = j_db_schema_new("test-ns", "test-schema-cached", &error);
+		g_assert_nonnull(other);
+
+		ret = j_db_schema_get(other, batch, &error);
+		g_assert_true(ret);
+		ret = j_batch_execute(batch);
+		g_assert_false(ret);
+	}
+}
+
+static void
+test_db_entry_new_free(void)
+{
+	guint const n = 100000;
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(GError) error = NULL;
+		g_autoptr(JDBEntry) entry = NULL;
+		g_autoptr(JDBSchema) schema = NULL;
+
+		schema = j_db_schema_new("test-ns", "test-schema", &error);
+		g_assert_nonnull(schema);
+		g_assert_no_error(error);
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+	}
+}
+
+static void
+test_db_entry_insert_update_delete(void)
+{
+	guint const n = 1000;
+
+	gchar const* file = "demo.bp";
+	guint64 dim = 4;
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	g_autoptr(JDBEntry) delete_entry = NULL;
+	g_autoptr(JDBEntry) update_entry = NULL;
+	g_autoptr(JDBSchema) schema = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	gboolean ret;
+
+	schema = j_db_schema_new("test-ns", "test-schema", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "string-0", J_DB_TYPE_STRING, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "uint-0", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "string-0", file, strlen(file), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "uint-0", &dim, sizeof(dim), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_entry_insert(entry, batch, NULL);
+		g_assert_true(ret);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+	g_assert_nonnull(selector);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_add_field(selector, "string-0", J_DB_SELECTOR_OPERATOR_EQ, file, strlen(file), &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	update_entry = j_db_entry_new(schema, &error);
+	g_assert_nonnull(update_entry);
+	g_assert_no_error(error);
+
+	dim = 3;
+	ret = j_db_entry_set_field(update_entry, "uint-0", &dim, sizeof(dim), &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_entry_update(update_entry, selector, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	delete_entry = j_db_entry_new(schema, &error);
+	g_assert_nonnull(delete_entry);
+	g_assert_no_error(error);
+
+	ret = j_db_entry_delete(delete_entry, selector, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_db_entry_insert_batch(void)
+{
+	guint const n = 1500;
+
+	gchar const* file = "demo.bp";
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GHashTable) ids = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDBSchema) schema = NULL;
+	g_autoptr(GPtrArray) entries = NULL;
+	g_autoptr(JDBIterator) iterator = NULL;
+	guint entries_read = 0;
+	gboolean ret;
+
+	// Batch atomicity allows the server to insert the entries with multi-row statements
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(semantics, J_SEMANTICS_ATOMICITY, J_SEMANTICS_ATOMICITY_BATCH);
+	batch = j_batch_new(semantics);
+
+	schema = j_db_schema_new("test-ns", "test-schema-batch", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "string-0", J_DB_TYPE_STRING, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "uint-0", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	entries = g_ptr_array_new_with_free_func((GDestroyNotify)j_db_entry_unref);
+
+	for (guint64 i = 0; i < n; i++)
+	{
+		JDBEntry* entry;
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "string-0", file, strlen(file), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "uint-0", &i, sizeof(i), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_entry_insert(entry, batch, NULL);
+		g_assert_true(ret);
+
+		g_ptr_array_add(entries, entry);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	ids = g_hash_table_new_full(g_bytes_hash, g_bytes_equal, (GDestroyNotify)g_bytes_unref, NULL);
+
+	for (guint i = 0; i < n; i++)
+	{
+		gpointer id;
+		guint64 length;
+
+		ret = j_db_entry_get_id(g_ptr_array_index(entries, i), &id, &length, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// Every entry has to receive its own id
+		ret = g_hash_table_add(ids, g_bytes_new_take(id, length));
+		g_assert_true(ret);
+	}
+
+	// The result spans multiple pages
+	iterator = j_db_iterator_new(schema, NULL, &error);
+	g_assert_nonnull(iterator);
+	g_assert_no_error(error);
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		g_autofree guint64* value = NULL;
+		JDBType type;
+		guint64 length;
+
+		ret = j_db_iterator_get_field(iterator, "uint-0", &type, (gpointer*)&value, &length, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(*value, ==, entries_read);
+
+		entries_read++;
+	}
+
+	g_assert_cmpuint(entries_read, ==, n);
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+}
+
+static void
+test_db_entry_query_range(void)
+{
+	guint64 const n = 100;
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDBSchema) schema = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	g_autoptr(JDBSelector) sub_selector = NULL;
+	g_autoptr(JDBIterator) iterator = NULL;
+	gboolean ret;
+	guint64 value;
+	guint entries = 0;
+
+	gchar const* idx_uint[] = {
+		"uint-0", NULL
+	};
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	schema = j_db_schema_new("test-ns", "test-schema-range", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "uint-0", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_index(schema, idx_uint, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint64 i = 0; i < n; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "uint-0", &i, sizeof(i), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_insert(entry, batch, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+	}
+
+	// (uint-0 >= 10 AND uint-0 < 20) OR uint-0 == 50
+	selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_OR, &error);
+	g_assert_nonnull(selector);
+	g_assert_no_error(error);
+
+	sub_selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+	g_assert_nonnull(sub_selector);
+	g_assert_no_error(error);
+
+	value = 10;
+	ret = j_db_selector_add_field(sub_selector, "uint-0", J_DB_SELECTOR_OPERATOR_GE, &value, sizeof(value), &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	value = 20;
+	ret = j_db_selector_add_field(sub_selector, "uint-0", J_DB_SELECTOR_OPERATOR_LT, &value, sizeof(value), &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_add_selector(selector, sub_selector, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	value = 50;
+	ret = j_db_selector_add_field(selector, "uint-0", J_DB_SELECTOR_OPERATOR_EQ, &value, sizeof(value), &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	iterator = j_db_iterator_new(schema, selector, &error);
+	g_assert_nonnull(iterator);
+	g_assert_no_error(error);
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		g_autofree guint64* field = NULL;
+		JDBType type;
+		guint64 length;
+
+		ret = j_db_iterator_get_field(iterator, "uint-0", &type, (gpointer*)&field, &length, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_true((*field >= 10 && *field < 20) || *field == 50);
+
+		entries++;
+	}
+
+	g_assert_cmpuint(entries, ==, 11);
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_db_selector_prepared(void)
+{
+	guint64 const n = 20;
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDBSchema) schema = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	g_autoptr(JDBSelector) sub_selector = NULL;
+	gboolean ret;
+	guint64 value;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	schema = j_db_schema_new("test-ns", "test-schema-prepared", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "uint-0", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "string-0", J_DB_TYPE_STRING, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint64 i = 0; i < n; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+		g_autofree gchar* string = NULL;
+
+		string = g_strdup_printf("string-%" G_GUINT64_FORMAT, i % 2);
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "uint-0", &i, sizeof(i), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "string-0", string, strlen(string), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_insert(entry, batch, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// uint-0 >= ? AND (string-0 = ? AND uint-0 < 10)
+	selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+	g_assert_nonnull(selector);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_add_parameter(selector, "uint-0", J_DB_SELECTOR_OPERATOR_GE, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	sub_selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+	g_assert_nonnull(sub_selector);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_add_parameter(sub_selector, "string-0", J_DB_SELECTOR_OPERATOR_EQ, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	value = 10;
+	ret = j_db_selector_add_field(sub_selector, "uint-0", J_DB_SELECTOR_OPERATOR_LT, &value, sizeof(value), &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_add_selector(selector, sub_selector, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_prepare(selector, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	for (guint64 i = 0; i < 4; i++)
+	{
+		g_autoptr(JDBIterator) iterator = NULL;
+		g_autofree gchar* string = NULL;
+		guint entries = 0;
+
+		string = g_strdup_printf("string-%" G_GUINT64_FORMAT, i % 2);
+
+		ret = j_db_selector_bind(selector, 0, &i, sizeof(i), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_bind(selector, 1, string, strlen(string), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		iterator = j_db_iterator_new(schema, selector, &error);
+		g_assert_nonnull(iterator);
+		g_assert_no_error(error);
+
+		while (j_db_iterator_next(iterator, NULL))
+		{
+			g_autofree guint64* field = NULL;
+			JDBType type;
+			guint64 length;
+
+			ret = j_db_iterator_get_field(iterator, "uint-0", &type, (gpointer*)&field, &length, &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+			g_assert_cmpuint(*field, >=, i);
+			g_assert_cmpuint(*field, <, 10);
+			g_assert_cmpuint(*field % 2, ==, i % 2);
+
+			entries++;
+		}
+
+		// Entries i, i + 2, ..., 8 + i % 2
+		g_assert_cmpuint(entries, ==, 5 - i / 2);
+	}
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_db_schema_advise_indexes(void)
+{
+	guint64 const n = 32;
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDBSchema) schema = NULL;
+	g_autoptr(GPtrArray) indexes = NULL;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	indexes = g_ptr_array_new_with_free_func((GDestroyNotify)g_strfreev);
+
+	schema = j_db_schema_new("test-ns", "test-schema-advise", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "uint-0", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "uint-1", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint64 i = 0; i < n; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "uint-0", &i, sizeof(i), &error);
 		g_assert_true(ret);
 		g_assert_no_error(error);
-		ret = j_db_schema_add_field(schema, "float-0", J_DB_TYPE_FLOAT64, &error);
+
+		ret = j_db_entry_set_field(entry, "uint-1", &i, sizeof(i), &error);
 		g_assert_true(ret);
 		g_assert_no_error(error);
-		ret = j_db_schema_add_field(schema, "float-1", J_DB_TYPE_FLOAT64, &error);
+
+		ret = j_db_entry_insert(entry, batch, &error);
 		g_assert_true(ret);
 		g_assert_no_error(error);
+	}
 
-		ret = j_db_schema_add_index(schema, idx_string, &error);
-		g_assert_true(ret);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Only uint-0 is queried often enough to be suggested
+	for (guint64 i = 0; i < n; i++)
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+		g_autoptr(JDBIterator) iterator = NULL;
+
+		selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
 		g_assert_no_error(error);
-		ret = j_db_schema_add_index(schema, idx_uint, &error);
+
+		ret = j_db_selector_add_field(selector, "uint-0", J_DB_SELECTOR_OPERATOR_EQ, &i, sizeof(i), &error);
 		g_assert_true(ret);
 		g_assert_no_error(error);
-		ret = j_db_schema_add_index(schema, idx_float, &error);
-		g_assert_true(ret);
+
+		iterator = j_db_iterator_new(schema, selector, &error);
+		g_assert_nonnull(iterator);
 		g_assert_no_error(error);
 
-		// FIXME Do not pass error, will not exist anymore when batch is executed
-		ret = j_db_schema_create(schema, batch, NULL);
+		while (j_db_iterator_next(iterator, NULL))
+		{
+		}
+	}
+
+	ret = j_db_schema_advise_indexes(schema, TRUE, indexes, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	// Not all backends support index advice
+	if (j_batch_execute(batch))
+	{
+		gchar** fields;
+
+		g_assert_cmpuint(indexes->len, ==, 1);
+
+		fields = g_ptr_array_index(indexes, 0);
+		g_assert_cmpuint(g_strv_length(fields), ==, 1);
+		g_assert_cmpstr(fields[0], ==, "uint-0");
+
+		// The created index covers the workload, so nothing is suggested anymore
+		g_ptr_array_set_size(indexes, 0);
+
+		ret = j_db_schema_advise_indexes(schema, FALSE, indexes, batch, &error);
 		g_assert_true(ret);
+		g_assert_no_error(error);
 
-		// FIXME Do not pass error, will not exist anymore when batch is executed
-		ret = j_db_schema_delete(schema, batch, NULL);
+		ret = j_batch_execute(batch);
 		g_assert_true(ret);
+		g_assert_cmpuint(indexes->len, ==, 0);
 	}
 
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
 	ret = j_batch_execute(batch);
 	g_assert_true(ret);
 }
 
 static void
-test_db_entry_new_free(void)
+test_db_entry_array(void)
 {
-	guint const n = 100000;
+	guint64 const n = 10;
 
-	for (guint i = 0; i < n; i++)
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDBSchema) schema = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	g_autoptr(JDBIterator) iterator = NULL;
+	g_autofree gchar* element = NULL;
+	gboolean ret;
+	JDBType type;
+	guint32 length;
+	gdouble value;
+	guint entries = 0;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	schema = j_db_schema_new("test-ns", "test-schema-array", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_array_field(schema, "coords", J_DB_TYPE_STRING, 3, &error);
+	g_assert_false(ret);
+	g_assert_error(error, J_DB_ERROR, J_DB_ERROR_TYPE_INVALID);
+	g_clear_error(&error);
+
+	ret = j_db_schema_add_array_field(schema, "coords", J_DB_TYPE_FLOAT64, 3, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_get_array_field(schema, "coords", &type, &length, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+	g_assert_cmpint(type, ==, J_DB_TYPE_FLOAT64);
+	g_assert_cmpuint(length, ==, 3);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint64 i = 0; i < n; i++)
 	{
-		g_autoptr(GError) error = NULL;
 		g_autoptr(JDBEntry) entry = NULL;
-		g_autoptr(JDBSchema) schema = NULL;
-
-		schema = j_db_schema_new("test-ns", "test-schema", &error);
-		g_assert_nonnull(schema);
-		g_assert_no_error(error);
+		gdouble coords[3] = { i, i * 2, i * 3 };
 
 		entry = j_db_entry_new(schema, &error);
 		g_assert_nonnull(entry);
 		g_assert_no_error(error);
+
+		ret = j_db_entry_set_array_field(entry, "coords", coords, 2, &error);
+		g_assert_false(ret);
+		g_assert_error(error, J_DB_ERROR, J_DB_ERROR_TYPE_INVALID);
+		g_clear_error(&error);
+
+		ret = j_db_entry_set_array_field(entry, "coords", coords, 3, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_insert(entry, batch, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// coords[1] >= 10
+	selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+	g_assert_nonnull(selector);
+	g_assert_no_error(error);
+
+	element = j_db_array_element_name("coords", 1);
+	value = 10;
+	ret = j_db_selector_add_field(selector, element, J_DB_SELECTOR_OPERATOR_GE, &value, sizeof(value), &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	iterator = j_db_iterator_new(schema, selector, &error);
+	g_assert_nonnull(iterator);
+	g_assert_no_error(error);
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		g_autofree gdouble* coords = NULL;
+
+		ret = j_db_iterator_get_array_field(iterator, "coords", &type, (gpointer*)&coords, &length, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpint(type, ==, J_DB_TYPE_FLOAT64);
+		g_assert_cmpuint(length, ==, 3);
+		g_assert_cmpfloat(coords[1], >=, 10);
+		g_assert_cmpfloat(coords[1], ==, coords[0] * 2);
+		g_assert_cmpfloat(coords[2], ==, coords[0] * 3);
+
+		entries++;
 	}
+
+	g_assert_cmpuint(entries, ==, 5);
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
 }
 
 static void
-test_db_entry_insert_update_delete(void)
+test_db_entry_aggregate(void)
 {
-	guint const n = 1000;
-
-	gchar const* file = "demo.bp";
-	guint64 dim = 4;
+	guint32 const n = 100;
 
 	g_autoptr(GError) error = NULL;
-	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
-	g_autoptr(JDBEntry) delete_entry = NULL;
-	g_autoptr(JDBEntry) update_entry = NULL;
+	g_autoptr(JBatch) batch = NULL;
 	g_autoptr(JDBSchema) schema = NULL;
 	g_autoptr(JDBSelector) selector = NULL;
+	g_autoptr(JDBAggregate) aggregate = NULL;
+	g_autoptr(JDBAggregate) aggregate_total = NULL;
+	g_autofree guint64* count = NULL;
+	g_autofree guint64* sum = NULL;
 	gboolean ret;
+	guint64 value;
+	guint32 groups = 0;
 
-	schema = j_db_schema_new("test-ns", "test-schema", &error);
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	schema = j_db_schema_new("test-ns", "test-schema-aggregate", &error);
 	g_assert_nonnull(schema);
 	g_assert_no_error(error);
 
-	ret = j_db_schema_add_field(schema, "string-0", J_DB_TYPE_STRING, &error);
+	ret = j_db_schema_add_field(schema, "bucket", J_DB_TYPE_UINT32, &error);
 	g_assert_true(ret);
 	g_assert_no_error(error);
 
-	ret = j_db_schema_add_field(schema, "uint-0", J_DB_TYPE_UINT64, &error);
+	ret = j_db_schema_add_field(schema, "value", J_DB_TYPE_UINT64, &error);
 	g_assert_true(ret);
 	g_assert_no_error(error);
 
@@ -162,69 +932,177 @@ test_db_entry_insert_update_delete(void)
 
 	ret = j_batch_execute(batch);
 	g_assert_true(ret);
-	g_assert_no_error(error);
 
-	for (guint i = 0; i < n; i++)
+	for (guint32 i = 0; i < n; i++)
 	{
 		g_autoptr(JDBEntry) entry = NULL;
+		guint32 group = i % 4;
+
+		value = i;
 
 		entry = j_db_entry_new(schema, &error);
 		g_assert_nonnull(entry);
 		g_assert_no_error(error);
 
-		ret = j_db_entry_set_field(entry, "string-0", file, strlen(file), &error);
+		ret = j_db_entry_set_field(entry, "bucket", &group, sizeof(group), &error);
 		g_assert_true(ret);
 		g_assert_no_error(error);
 
-		ret = j_db_entry_set_field(entry, "uint-0", &dim, sizeof(dim), &error);
+		ret = j_db_entry_set_field(entry, "value", &value, sizeof(value), &error);
 		g_assert_true(ret);
 		g_assert_no_error(error);
 
-		// FIXME Do not pass error, will not exist anymore when batch is executed
-		ret = j_db_entry_insert(entry, batch, NULL);
+		ret = j_db_entry_insert(entry, batch, &error);
 		g_assert_true(ret);
+		g_assert_no_error(error);
 	}
 
 	ret = j_batch_execute(batch);
 	g_assert_true(ret);
 
-	selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
-	g_assert_nonnull(selector);
+	aggregate = j_db_aggregate_new(schema, NULL, &error);
+	g_assert_nonnull(aggregate);
 	g_assert_no_error(error);
 
-	ret = j_db_selector_add_field(selector, "string-0", J_DB_SELECTOR_OPERATOR_EQ, file, strlen(file), &error);
+	ret = j_db_aggregate_group_by(aggregate, "bucket", &error);
 	g_assert_true(ret);
 	g_assert_no_error(error);
 
-	update_entry = j_db_entry_new(schema, &error);
-	g_assert_nonnull(update_entry);
+	ret = j_db_aggregate_add(aggregate, "count", J_DB_AGGREGATE_FUNCTION_COUNT, NULL, &error);
+	g_assert_true(ret);
 	g_assert_no_error(error);
 
-	dim = 3;
-	ret = j_db_entry_set_field(update_entry, "uint-0", &dim, sizeof(dim), &error);
+	ret = j_db_aggregate_add(aggregate, "sum", J_DB_AGGREGATE_FUNCTION_SUM, "value", &error);
 	g_assert_true(ret);
 	g_assert_no_error(error);
 
-	ret = j_db_entry_update(update_entry, selector, batch, &error);
+	ret = j_db_aggregate_add(aggregate, "min", J_DB_AGGREGATE_FUNCTION_MIN, "value", &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_aggregate_add(aggregate, "max", J_DB_AGGREGATE_FUNCTION_MAX, "value", &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_aggregate_add(aggregate, "avg", J_DB_AGGREGATE_FUNCTION_AVG, "value", &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	// Names must be unique
+	ret = j_db_aggregate_add(aggregate, "bucket", J_DB_AGGREGATE_FUNCTION_COUNT, NULL, &error);
+	g_assert_false(ret);
+	g_assert_nonnull(error);
+	g_clear_error(&error);
+
+	ret = j_db_aggregate_execute(aggregate, batch, &error);
 	g_assert_true(ret);
 	g_assert_no_error(error);
 
 	ret = j_batch_execute(batch);
 	g_assert_true(ret);
+
+	// Groups are returned in ascending order
+	while (j_db_aggregate_next(aggregate, NULL))
+	{
+		g_autofree guint32* group = NULL;
+		g_autofree guint64* group_count = NULL;
+		g_autofree guint64* group_sum = NULL;
+		g_autofree guint64* group_min = NULL;
+		g_autofree guint64* group_max = NULL;
+		g_autofree gdouble* group_avg = NULL;
+		JDBType type;
+		guint64 length;
+
+		ret = j_db_aggregate_get_field(aggregate, "bucket", &type, (gpointer*)&group, &length, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(type, ==, J_DB_TYPE_UINT32);
+		g_assert_cmpuint(*group, ==, groups);
+
+		ret = j_db_aggregate_get_field(aggregate, "count", &type, (gpointer*)&group_count, &length, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(type, ==, J_DB_TYPE_UINT64);
+		g_assert_cmpuint(*group_count, ==, n / 4);
+
+		ret = j_db_aggregate_get_field(aggregate, "sum", &type, (gpointer*)&group_sum, &length, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(type, ==, J_DB_TYPE_UINT64);
+		g_assert_cmpuint(*group_sum, ==, 1200 + 25 * *group);
+
+		ret = j_db_aggregate_get_field(aggregate, "min", &type, (gpointer*)&group_min, &length, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(*group_min, ==, *group);
+
+		ret = j_db_aggregate_get_field(aggregate, "max", &type, (gpointer*)&group_max, &length, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(*group_max, ==, 96 + *group);
+
+		ret = j_db_aggregate_get_field(aggregate, "avg", &type, (gpointer*)&group_avg, &length, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(type, ==, J_DB_TYPE_FLOAT64);
+		g_assert_cmpfloat(*group_avg, ==, 48 + *group);
+
+		groups++;
+	}
+
+	g_assert_cmpuint(groups, ==, 4);
+
+	// Without group-by fields, exactly one result is returned
+	selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+	g_assert_nonnull(selector);
+	g_assert_no_error(error);
+
+	value = 10;
+	ret = j_db_selector_add_field(selector, "value", J_DB_SELECTOR_OPERATOR_LT, &value, sizeof(value), &error);
+	g_assert_true(ret);
 	g_assert_no_error(error);
 
-	delete_entry = j_db_entry_new(schema, &error);
-	g_assert_nonnull(delete_entry);
+	aggregate_total = j_db_aggregate_new(schema, selector, &error);
+	g_assert_nonnull(aggregate_total);
 	g_assert_no_error(error);
 
-	ret = j_db_entry_delete(delete_entry, selector, batch, &error);
+	ret = j_db_aggregate_add(aggregate_total, "count", J_DB_AGGREGATE_FUNCTION_COUNT, NULL, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_aggregate_add(aggregate_total, "sum", J_DB_AGGREGATE_FUNCTION_SUM, "value", &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_aggregate_execute(aggregate_total, batch, &error);
 	g_assert_true(ret);
 	g_assert_no_error(error);
 
 	ret = j_batch_execute(batch);
 	g_assert_true(ret);
+
+	ret = j_db_aggregate_next(aggregate_total, &error);
+	g_assert_true(ret);
 	g_assert_no_error(error);
 
+	{
+		JDBType type;
+		guint64 length;
+
+		ret = j_db_aggregate_get_field(aggregate_total, "count", &type, (gpointer*)&count, &length, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(*count, ==, 10);
+
+		ret = j_db_aggregate_get_field(aggregate_total, "sum", &type, (gpointer*)&sum, &length, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(*sum, ==, 45);
+	}
+
+	ret = j_db_aggregate_next(aggregate_total, NULL);
+	g_assert_false(ret);
+
 	ret = j_db_schema_delete(schema, batch, &error);
 	g_assert_true(ret);
 	g_assert_no_error(error);
@@ -406,6 +1284,67 @@ iterator_get(void)
 	g_assert_cmpuint(entries, ==, 1);
 }
 
+static void
+iterator_get_fields(void)
+{
+	g_autoptr(GError) error = NULL;
+
+	gboolean success = TRUE;
+	g_autoptr(JDBSchema) schema = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	g_autoptr(JDBIterator) iterator = NULL;
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	gchar const* file = "demo.bp";
+	gchar const* fields[] = {
+		"name", NULL
+	};
+	JDBType type;
+	guint64 len;
+
+	guint entries = 0;
+
+	schema = j_db_schema_new("adios2", "variables", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+	success = j_db_schema_get(schema, batch, &error);
+	g_assert_true(success);
+	g_assert_no_error(error);
+	success = j_batch_execute(batch);
+	g_assert_true(success);
+
+	selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+	g_assert_nonnull(selector);
+	g_assert_no_error(error);
+	success = j_db_selector_add_field(selector, "file", J_DB_SELECTOR_OPERATOR_EQ, file, strlen(file), &error);
+	g_assert_true(success);
+	g_assert_no_error(error);
+
+	iterator = j_db_iterator_new_for_fields(schema, selector, fields, &error);
+	g_assert_nonnull(iterator);
+	g_assert_no_error(error);
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		g_autofree gchar* name = NULL;
+		g_autofree gdouble* min = NULL;
+
+		success = j_db_iterator_get_field(iterator, "name", &type, (gpointer*)&name, &len, &error);
+		g_assert_true(success);
+		g_assert_no_error(error);
+
+		// Fields outside of the projection are not retrieved
+		success = j_db_iterator_get_field(iterator, "min", &type, (gpointer*)&min, &len, &error);
+		g_assert_false(success);
+		g_assert_nonnull(error);
+		g_clear_error(&error);
+
+		entries++;
+	}
+
+	g_assert_cmpuint(entries, ==, 1);
+}
+
 static void
 entry_update(void)
 {
@@ -527,6 +1466,7 @@ test_db_all(void)
 	schema_create();
 	entry_insert();
 	iterator_get();
+	iterator_get_fields();
 	entry_update();
 	entry_delete();
 	schema_delete();
@@ -538,7 +1478,14 @@ test_db_db(void)
 	// FIXME add more tests
 	g_test_add_func("/db/schema/new_free", test_db_schema_new_free);
 	g_test_add_func("/db/schema/create_delete", test_db_schema_create_delete);
+	g_test_add_func("/db/schema/get_cached", test_db_schema_get_cached);
+	g_test_add_func("/db/schema/advise_indexes", test_db_schema_advise_indexes);
+	g_test_add_func("/db/selector/prepared", test_db_selector_prepared);
 	g_test_add_func("/db/entry/new_free", test_db_entry_new_free);
 	g_test_add_func("/db/entry/insert_update_delete", test_db_entry_insert_update_delete);
+	g_test_add_func("/db/entry/insert_batch", test_db_entry_insert_batch);
+	g_test_add_func("/db/entry/query_range", test_db_entry_query_range);
+	g_test_add_func("/db/entry/array", test_db_entry_array);
+	g_test_add_func("/db/entry/aggregate", test_db_entry_aggregate);
 	g_test_add_func("/db/all", test_db_all);
 }
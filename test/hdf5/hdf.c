@@ -145,6 +145,368 @@ test_hdf_read_write(void)
 	H5Fclose(file);
 }
 
+static void
+test_hdf_selection(void)
+{
+	hid_t file;
+	hid_t dataset;
+	hid_t dataspace_ds;
+	hid_t dataspace_mem;
+
+	hsize_t dims_ds[2];
+	hsize_t dims_mem[1];
+	hsize_t start[2];
+	hsize_t count[2];
+	hsize_t points[4][2] = { { 0, 0 }, { 1, 3 }, { 1, 2 }, { 5, 6 } };
+
+	int data_ds[6][7];
+	int data_slab[2][3];
+	int data_points[4];
+
+	file = H5Fcreate("JULEA.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+
+	dims_ds[0] = 6;
+	dims_ds[1] = 7;
+	dataspace_ds = H5Screate_simple(2, dims_ds, NULL);
+	dataset = H5Dcreate2(file, "TestDataset", H5T_NATIVE_INT, dataspace_ds, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+
+	for (guint i = 0; i < 6; i++)
+	{
+		for (guint j = 0; j < 7; j++)
+		{
+			data_ds[i][j] = 0;
+		}
+	}
+
+	H5Dwrite(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data_ds);
+
+	for (guint i = 0; i < 2; i++)
+	{
+		for (guint j = 0; j < 3; j++)
+		{
+			data_slab[i][j] = 10 * (i + 1) + j;
+		}
+	}
+
+	// Write a 2x3 hyperslab starting at (1, 2)
+	start[0] = 1;
+	start[1] = 2;
+	count[0] = 2;
+	count[1] = 3;
+	H5Sselect_hyperslab(dataspace_ds, H5S_SELECT_SET, start, NULL, count, NULL);
+	dataspace_mem = H5Screate_simple(2, count, NULL);
+
+	H5Dwrite(dataset, H5T_NATIVE_INT, dataspace_mem, dataspace_ds, H5P_DEFAULT, data_slab);
+
+	H5Sclose(dataspace_mem);
+
+	H5Dread(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data_ds);
+
+	for (guint i = 0; i < 6; i++)
+	{
+		for (guint j = 0; j < 7; j++)
+		{
+			if (i >= 1 && i < 3 && j >= 2 && j < 5)
+			{
+				g_assert_cmpint(data_ds[i][j], ==, data_slab[i - 1][j - 2]);
+			}
+			else
+			{
+				g_assert_cmpint(data_ds[i][j], ==, 0);
+			}
+		}
+	}
+
+	// Read unsorted points, including two that are adjacent in the file
+	H5Sselect_elements(dataspace_ds, H5S_SELECT_SET, 4, (const hsize_t*)points);
+	dims_mem[0] = 4;
+	dataspace_mem = H5Screate_simple(1, dims_mem, NULL);
+
+	H5Dread(dataset, H5T_NATIVE_INT, dataspace_mem, dataspace_ds, H5P_DEFAULT, data_points);
+
+	g_assert_cmpint(data_points[0], ==, 0);
+	g_assert_cmpint(data_points[1], ==, 11);
+	g_assert_cmpint(data_points[2], ==, 10);
+	g_assert_cmpint(data_points[3], ==, 0);
+
+	H5Sclose(dataspace_mem);
+	H5Sclose(dataspace_ds);
+	H5Dclose(dataset);
+
+	H5Fclose(file);
+}
+
+static void
+test_hdf_chunked(void)
+{
+	hid_t file;
+	hid_t dataset;
+	hid_t dataspace_ds;
+	hid_t dataspace_mem;
+	hid_t dcpl;
+
+	hsize_t dims_ds[2] = { 10, 10 };
+	hsize_t dims_chunk[2] = { 4, 4 };
+	hsize_t start[2] = { 3, 3 };
+	hsize_t count[2] = { 5, 5 };
+
+	int data_ds[10][10];
+	int data_slab[5][5];
+
+	file = H5Fcreate("JULEA.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+
+	dcpl = H5Pcreate(H5P_DATASET_CREATE);
+	H5Pset_chunk(dcpl, 2, dims_chunk);
+
+	dataspace_ds = H5Screate_simple(2, dims_ds, NULL);
+	dataset = H5Dcreate2(file, "TestDataset", H5T_NATIVE_INT, dataspace_ds, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+
+	for (guint i = 0; i < 5; i++)
+	{
+		for (guint j = 0; j < 5; j++)
+		{
+			data_slab[i][j] = 100 * (i + 1) + j;
+		}
+	}
+
+	// The hyperslab touches four of the nine chunks
+	H5Sselect_hyperslab(dataspace_ds, H5S_SELECT_SET, start, NULL, count, NULL);
+	dataspace_mem = H5Screate_simple(2, count, NULL);
+
+	H5Dwrite(dataset, H5T_NATIVE_INT, dataspace_mem, dataspace_ds, H5P_DEFAULT, data_slab);
+
+	H5Sclose(dataspace_mem);
+	H5Dclose(dataset);
+
+	dataset = H5Dopen2(file, "TestDataset", H5P_DEFAULT);
+
+	H5Dread(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data_ds);
+
+	for (guint i = 0; i < 10; i++)
+	{
+		for (guint j = 0; j < 10; j++)
+		{
+			if (i >= 3 && i < 8 && j >= 3 && j < 8)
+			{
+				g_assert_cmpint(data_ds[i][j], ==, data_slab[i - 3][j - 3]);
+			}
+			else
+			{
+				g_assert_cmpint(data_ds[i][j], ==, 0);
+			}
+		}
+	}
+
+	H5Sclose(dataspace_ds);
+	H5Pclose(dcpl);
+	H5Dclose(dataset);
+
+	H5Fclose(file);
+}
+
+static void
+test_hdf_filtered(void)
+{
+	hid_t file;
+	hid_t dataset;
+	hid_t dataspace_ds;
+	hid_t dataspace_mem;
+	hid_t dcpl;
+
+	hsize_t dims_ds[2] = { 10, 10 };
+	hsize_t dims_chunk[2] = { 4, 4 };
+	hsize_t start[2] = { 2, 5 };
+	hsize_t count[2] = { 3, 3 };
+	guint deflate_level = 6;
+
+	int data_ds[10][10];
+	int data_slab[3][3];
+
+	file = H5Fcreate("JULEA.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+
+	dcpl = H5Pcreate(H5P_DATASET_CREATE);
+	H5Pset_chunk(dcpl, 2, dims_chunk);
+	H5Pset_shuffle(dcpl);
+	H5Pset_filter(dcpl, H5Z_FILTER_DEFLATE, H5Z_FLAG_OPTIONAL, 1, &deflate_level);
+
+	dataspace_ds = H5Screate_simple(2, dims_ds, NULL);
+	dataset = H5Dcreate2(file, "TestDataset", H5T_NATIVE_INT, dataspace_ds, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+
+	for (guint i = 0; i < 10; i++)
+	{
+		for (guint j = 0; j < 10; j++)
+		{
+			data_ds[i][j] = i * 10 + j;
+		}
+	}
+
+	H5Dwrite(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data_ds);
+
+	for (guint i = 0; i < 3; i++)
+	{
+		for (guint j = 0; j < 3; j++)
+		{
+			data_slab[i][j] = -1;
+		}
+	}
+
+	// Partially overwrite filtered chunks
+	H5Sselect_hyperslab(dataspace_ds, H5S_SELECT_SET, start, NULL, count, NULL);
+	dataspace_mem = H5Screate_simple(2, count, NULL);
+
+	H5Dwrite(dataset, H5T_NATIVE_INT, dataspace_mem, dataspace_ds, H5P_DEFAULT, data_slab);
+
+	H5Sclose(dataspace_mem);
+	H5Dclose(dataset);
+
+	dataset = H5Dopen2(file, "TestDataset", H5P_DEFAULT);
+
+	H5Dread(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data_ds);
+
+	for (guint i = 0; i < 10; i++)
+	{
+		for (guint j = 0; j < 10; j++)
+		{
+			if (i >= 2 && i < 5 && j >= 5 && j < 8)
+			{
+				g_assert_cmpint(data_ds[i][j], ==, -1);
+			}
+			else
+			{
+				g_assert_cmpint(data_ds[i][j], ==, i * 10 + j);
+			}
+		}
+	}
+
+	H5Sclose(dataspace_ds);
+	H5Pclose(dcpl);
+	H5Dclose(dataset);
+
+	H5Fclose(file);
+}
+
+static void
+test_hdf_metadata(void)
+{
+	hid_t file;
+	hid_t dataset;
+	hid_t dataspace_attr;
+	hid_t dataspace_ds;
+
+	hsize_t dims_attr[1] = { 1 };
+	hsize_t dims_ds[1] = { 1 };
+
+	dataspace_attr = H5Screate_simple(1, dims_attr, NULL);
+	dataspace_ds = H5Screate_simple(1, dims_ds, NULL);
+
+	file = H5Fcreate("JULEA.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+	dataset = H5Dcreate2(file, "TestDataset", H5T_NATIVE_INT, dataspace_ds, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+
+	// Enough attributes to exceed the metadata batch size
+	for (gint i = 0; i < 1500; i++)
+	{
+		g_autofree gchar* name = NULL;
+		hid_t attribute;
+
+		name = g_strdup_printf("TestAttribute%d", i);
+		attribute = H5Acreate2(dataset, name, H5T_NATIVE_INT, dataspace_attr, H5P_DEFAULT, H5P_DEFAULT);
+		H5Awrite(attribute, H5T_NATIVE_INT, &i);
+		H5Aclose(attribute);
+	}
+
+	H5Dclose(dataset);
+	H5Fclose(file);
+
+	file = H5Fopen("JULEA.h5", H5F_ACC_RDONLY, H5P_DEFAULT);
+	dataset = H5Dopen2(file, "TestDataset", H5P_DEFAULT);
+
+	for (gint i = 0; i < 1500; i += 100)
+	{
+		g_autofree gchar* name = NULL;
+		hid_t attribute;
+		gint value = -1;
+
+		name = g_strdup_printf("TestAttribute%d", i);
+		attribute = H5Aopen(dataset, name, H5P_DEFAULT);
+		H5Aread(attribute, H5T_NATIVE_INT, &value);
+		H5Aclose(attribute);
+
+		g_assert_cmpint(value, ==, i);
+	}
+
+	H5Dclose(dataset);
+	H5Fclose(file);
+
+	H5Sclose(dataspace_ds);
+	H5Sclose(dataspace_attr);
+}
+
+static void
+test_hdf_statistics(void)
+{
+	hid_t file;
+	hid_t dataset;
+	hid_t dataspace_ds;
+	hid_t dcpl;
+
+	hsize_t dims_ds[2] = { 8, 8 };
+	hsize_t dims_chunk[2] = { 4, 4 };
+	g_autofree hsize_t* offsets = NULL;
+	g_auto(GStrv) names = NULL;
+	gint64 chunks;
+
+	int data_ds[8][8];
+
+	file = H5Fcreate("JULEA.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+
+	dcpl = H5Pcreate(H5P_DATASET_CREATE);
+	H5Pset_chunk(dcpl, 2, dims_chunk);
+
+	dataspace_ds = H5Screate_simple(2, dims_ds, NULL);
+	dataset = H5Dcreate2(file, "TestDataset", H5T_NATIVE_INT, dataspace_ds, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+
+	for (guint i = 0; i < 8; i++)
+	{
+		for (guint j = 0; j < 8; j++)
+		{
+			data_ds[i][j] = i * 8 + j;
+		}
+	}
+
+	H5Dwrite(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data_ds);
+
+	// Row 7, columns 4 to 7 only lie within the last chunk
+	chunks = j_hdf5_db_find_chunks(dataset, 60.0, 63.0, &offsets);
+
+	H5Dclose(dataset);
+
+	if (chunks < 0)
+	{
+		g_test_skip("Searching is not supported by this connector");
+	}
+	else
+	{
+		g_assert_cmpint(chunks, ==, 1);
+		g_assert_cmpuint(offsets[0], ==, 4);
+		g_assert_cmpuint(offsets[1], ==, 4);
+
+		names = j_hdf5_db_find_datasets(file, 10.5, 11.5);
+		g_assert_nonnull(names);
+		g_assert_cmpuint(g_strv_length(names), ==, 1);
+		g_assert_cmpstr(names[0], ==, "TestDataset");
+		g_clear_pointer(&names, g_strfreev);
+
+		names = j_hdf5_db_find_datasets(file, 64.5, 100.0);
+		g_assert_nonnull(names);
+		g_assert_cmpuint(g_strv_length(names), ==, 0);
+	}
+
+	H5Sclose(dataspace_ds);
+	H5Pclose(dcpl);
+
+	H5Fclose(file);
+}
+
 #endif
 
 void
@@ -158,5 +520,10 @@ test_hdf_hdf(void)
 	}
 
 	g_test_add_func("/hdf5/read_write", test_hdf_read_write);
+	g_test_add_func("/hdf5/selection", test_hdf_selection);
+	g_test_add_func("/hdf5/chunked", test_hdf_chunked);
+	g_test_add_func("/hdf5/filtered", test_hdf_filtered);
+	g_test_add_func("/hdf5/statistics", test_hdf_statistics);
+	g_test_add_func("/hdf5/metadata", test_hdf_metadata);
 #endif
 }
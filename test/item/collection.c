@@ -69,9 +69,49 @@ test_collection_name(JCollection** collection, gconstpointer data)
 	g_assert_cmpstr(j_collection_get_name(*collection), ==, "test-collection");
 }
 
+static void
+test_collection_delete_recursive(void)
+{
+	guint const n = 100;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JCollection) collection = NULL;
+	JItem* item = NULL;
+	guint64 deleted = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	collection = j_collection_create("test-collection-recursive", batch);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JItem) new_item = NULL;
+		g_autofree gchar* name = NULL;
+		guint64 bytes_written = 0;
+
+		name = g_strdup_printf("test-item-%u", i);
+		new_item = j_item_create(collection, name, NULL, batch);
+		j_item_write(new_item, "data", 4, 0, &bytes_written, batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_collection_delete_recursive(collection, &deleted, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(deleted, ==, n);
+
+	j_item_get(collection, &item, "test-item-0", batch);
+	ret = j_batch_execute(batch);
+	g_assert_false(ret);
+	g_assert_null(item);
+}
+
 void
 test_item_collection(void)
 {
 	g_test_add_func("/item/collection/new_free", test_collection_new_free);
 	g_test_add("/item/collection/name", JCollection*, NULL, test_collection_fixture_setup, test_collection_name, test_collection_fixture_teardown);
+	g_test_add_func("/item/collection/delete_recursive", test_collection_delete_recursive);
 }
@@ -92,9 +92,73 @@ test_item_iterator_next_get(void)
 	g_assert_cmpuint(items, ==, n);
 }
 
+static void
+test_item_iterator_list_items(void)
+{
+	guint const n = 10000;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JBatch) delete_batch = NULL;
+	g_autoptr(JCollection) collection = NULL;
+	g_autoptr(JItemList) item_list = NULL;
+	JItemListEntry const* entries;
+	guint count;
+	gboolean ret;
+
+	guint items = 0;
+	guint pages = 0;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	delete_batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	collection = j_collection_create("test-collection", batch);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JItem) item = NULL;
+
+		g_autofree gchar* name = NULL;
+
+		name = g_strdup_printf("test-item-%d", i);
+		item = j_item_create(collection, name, NULL, batch);
+		j_item_delete(item, delete_batch);
+
+		g_assert_true(item != NULL);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	item_list = j_collection_list_items(collection, J_ITEM_LIST_NAME | J_ITEM_LIST_SIZE);
+
+	while (j_item_list_next_page(item_list, &entries, &count))
+	{
+		g_assert_cmpuint(count, >, 0);
+
+		for (guint i = 0; i < count; i++)
+		{
+			g_assert_true(g_str_has_prefix(entries[i].name, "test-item-"));
+			g_assert_cmpuint(entries[i].size, ==, 0);
+			g_assert_cmpint(entries[i].modification_time, ==, 0);
+		}
+
+		items += count;
+		pages++;
+	}
+
+	g_assert_false(j_item_list_next_page(item_list, &entries, &count));
+	g_assert_cmpuint(count, ==, 0);
+
+	ret = j_batch_execute(delete_batch);
+	g_assert_true(ret);
+
+	g_assert_cmpuint(items, ==, n);
+	g_assert_cmpuint(pages, >, 1);
+}
+
 void
 test_item_item_iterator(void)
 {
 	g_test_add_func("/item/item-iterator/new_free", test_item_iterator_new_free);
 	g_test_add_func("/item/item-iterator/next_get", test_item_iterator_next_get);
+	g_test_add_func("/item/item-iterator/list_items", test_item_iterator_list_items);
 }
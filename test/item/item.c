@@ -101,6 +101,136 @@ test_item_modification_time(JItem** item, gconstpointer data)
 	g_assert_cmpuint(j_item_get_modification_time(*item), >, 0);
 }
 
+static void
+test_item_status(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JBatch) immediate_batch = NULL;
+	g_autoptr(JCollection) collection = NULL;
+	g_autoptr(JItem) item = NULL;
+	g_autoptr(JItem) other_item = NULL;
+	gchar data[4] = "abc";
+	guint64 bytes_written = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	immediate_batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_POSIX);
+
+	collection = j_collection_create("test-collection-status", batch);
+	item = j_item_create(collection, "test-item-status", NULL, batch);
+	j_item_write(item, data, sizeof(data), 10, &bytes_written, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	g_assert_cmpuint(j_item_get_size(item), ==, 14);
+
+	// The status is part of the metadata written together with the data.
+	j_item_get(collection, &other_item, "test-item-status", batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_nonnull(other_item);
+
+	j_item_get_status(other_item, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(j_item_get_size(other_item), ==, 14);
+
+	j_item_get_status(other_item, immediate_batch);
+	ret = j_batch_execute(immediate_batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(j_item_get_size(other_item), ==, 14);
+
+	j_item_delete(item, batch);
+	j_collection_delete(collection, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_item_get_cached(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JBatch) immediate_batch = NULL;
+	g_autoptr(JCollection) collection = NULL;
+	g_autoptr(JItem) item = NULL;
+	g_autoptr(JItem) first = NULL;
+	g_autoptr(JItem) second = NULL;
+	g_autoptr(JItem) third = NULL;
+	JItem* deleted = NULL;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	immediate_batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_POSIX);
+
+	collection = j_collection_create("test-collection-cached", batch);
+	item = j_item_create(collection, "test-item-cached", NULL, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_item_get(collection, &first, "test-item-cached", batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_nonnull(first);
+
+	// Repeated lookups are answered from the cache.
+	j_item_get(collection, &second, "test-item-cached", batch);
+	g_assert_true(second == first);
+
+	// Immediate consistency always fetches the metadata.
+	j_item_get(collection, &third, "test-item-cached", immediate_batch);
+	ret = j_batch_execute(immediate_batch);
+	g_assert_true(ret);
+	g_assert_nonnull(third);
+	g_assert_true(third != first);
+
+	j_item_delete(item, batch);
+	j_item_get(collection, &deleted, "test-item-cached", batch);
+	g_assert_null(deleted);
+
+	j_collection_delete(collection, batch);
+	j_batch_execute(batch);
+	g_assert_null(deleted);
+}
+
+static void
+test_item_clone(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JCollection) collection = NULL;
+	g_autoptr(JItem) item = NULL;
+	g_autoptr(JItem) clone = NULL;
+	gchar data[4] = "abc";
+	gchar buffer[4];
+	guint64 nbytes = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	collection = j_collection_create("test-collection-clone", batch);
+	item = j_item_create(collection, "test-item", NULL, batch);
+	j_item_write(item, data, sizeof(data), 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	clone = j_item_clone(item, collection, "test-item-clone", batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_nonnull(clone);
+	g_assert_cmpuint(j_item_get_size(clone), ==, sizeof(data));
+
+	j_item_write(item, "xyz", 4, 0, &nbytes, batch);
+	j_item_read(clone, buffer, sizeof(buffer), 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpmem(buffer, nbytes, data, sizeof(data));
+
+	j_item_delete(item, batch);
+	j_item_delete(clone, batch);
+	j_collection_delete(collection, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
 void
 test_item_item(void)
 {
@@ -109,4 +239,7 @@ test_item_item(void)
 	g_test_add("/item/item/name", JItem*, NULL, test_item_fixture_setup, test_item_name, test_item_fixture_teardown);
 	g_test_add("/item/item/size", JItem*, NULL, test_item_fixture_setup, test_item_size, test_item_fixture_teardown);
 	g_test_add("/item/item/modification_time", JItem*, NULL, test_item_fixture_setup, test_item_modification_time, test_item_fixture_teardown);
+	g_test_add_func("/item/item/status", test_item_status);
+	g_test_add_func("/item/item/get_cached", test_item_get_cached);
+	g_test_add_func("/item/item/clone", test_item_clone);
 }
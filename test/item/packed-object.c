@@ -0,0 +1,187 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <julea.h>
+#include <julea-item.h>
+
+#include "test.h"
+
+static void
+test_packed_object_new_free(void)
+{
+	guint const n = 100000;
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JPackedObject) object = NULL;
+
+		object = j_packed_object_new("test-packed", "test-packed-object");
+		g_assert_nonnull(object);
+	}
+}
+
+static void
+test_packed_object_write_read(void)
+{
+	guint const n = 100;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(GPtrArray) objects = NULL;
+	gchar buffer[32];
+	guint64 bytes_written[100];
+	guint64 bytes_read[100];
+	gchar data[100][32];
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	objects = g_ptr_array_new_with_free_func((GDestroyNotify)j_packed_object_unref);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autofree gchar* name = NULL;
+		JPackedObject* object;
+
+		name = g_strdup_printf("test-packed-object-%u", i);
+		object = j_packed_object_new("test-packed", name);
+		g_ptr_array_add(objects, object);
+
+		g_snprintf(data[i], sizeof(data[i]), "packed-%u", i);
+		j_packed_object_write(object, data[i], strlen(data[i]), &(bytes_written[i]), batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_assert_cmpuint(bytes_written[i], ==, strlen(data[i]));
+	}
+
+	for (guint i = 0; i < n; i++)
+	{
+		j_packed_object_read(g_ptr_array_index(objects, i), data[i], sizeof(data[i]), 0, &(bytes_read[i]), batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autofree gchar* expected = NULL;
+
+		expected = g_strdup_printf("packed-%u", i);
+		g_assert_cmpuint(bytes_read[i], ==, strlen(expected));
+		g_assert_cmpmem(data[i], bytes_read[i], expected, strlen(expected));
+	}
+
+	// Reads at an offset only return the packed object's own data.
+	j_packed_object_read(g_ptr_array_index(objects, 12), buffer, sizeof(buffer), 7, &(bytes_read[0]), batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(bytes_read[0], ==, 2);
+	g_assert_cmpmem(buffer, bytes_read[0], "12", 2);
+
+	for (guint i = 0; i < n; i++)
+	{
+		j_packed_object_delete(g_ptr_array_index(objects, i), batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_packed_object_overwrite(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JPackedObject) object = NULL;
+	gchar buffer[16];
+	guint64 bytes_written;
+	guint64 bytes_read;
+	guint64 size = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	object = j_packed_object_new("test-packed", "test-packed-overwrite");
+
+	j_packed_object_write(object, "first-version", 13, &bytes_written, batch);
+	j_packed_object_write(object, "second", 6, &bytes_written, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_packed_object_status(object, &size, batch);
+	j_packed_object_read(object, buffer, sizeof(buffer), 0, &bytes_read, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(size, ==, 6);
+	g_assert_cmpuint(bytes_read, ==, 6);
+	g_assert_cmpmem(buffer, bytes_read, "second", 6);
+
+	j_packed_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_packed_object_read(object, buffer, sizeof(buffer), 0, &bytes_read, batch);
+	ret = j_batch_execute(batch);
+	g_assert_false(ret);
+}
+
+static void
+test_packed_object_compact(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JPackedObject) object = NULL;
+	gchar buffer[16];
+	guint64 bytes_written;
+	guint64 bytes_read;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	object = j_packed_object_new("test-packed-compact", "test-packed-object");
+
+	j_packed_object_write(object, "compact", 7, &bytes_written, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Compaction must not touch containers that are still being appended to.
+	j_packed_object_compact("test-packed-compact", batch);
+	j_packed_object_read(object, buffer, sizeof(buffer), 0, &bytes_read, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(bytes_read, ==, 7);
+	g_assert_cmpmem(buffer, bytes_read, "compact", 7);
+
+	j_packed_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+void
+test_item_packed_object(void)
+{
+	g_test_add_func("/item/packed-object/new_free", test_packed_object_new_free);
+	g_test_add_func("/item/packed-object/write_read", test_packed_object_write_read);
+	g_test_add_func("/item/packed-object/overwrite", test_packed_object_overwrite);
+	g_test_add_func("/item/packed-object/compact", test_packed_object_compact);
+}
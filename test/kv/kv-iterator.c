@@ -180,9 +180,196 @@ test_kv_iterator_next_get(void)
 	g_assert_true(ret);
 }
 
+static void
+test_kv_iterator_pages(void)
+{
+	// Spans multiple pages on every server
+	guint const n = 5000;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JBatch) delete_batch = NULL;
+	g_autoptr(JKVIterator) kv_iterator = NULL;
+	g_autoptr(JKVIterator) kv_iterator_prefix = NULL;
+	g_autoptr(JKVIterator) kv_iterator_sorted = NULL;
+	g_autoptr(GHashTable) keys = NULL;
+	g_autofree gchar* last_key = NULL;
+	guint count;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	delete_batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	keys = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JKV) kv = NULL;
+
+		g_autofree gchar* key = NULL;
+		gchar* value = NULL;
+
+		key = g_strdup_printf("test-key-pages-%d", i);
+		value = g_strdup_printf("test-value-%d", i);
+		kv = j_kv_new("test-ns-pages", key);
+		j_kv_put(kv, value, strlen(value) + 1, g_free, batch);
+		j_kv_delete(kv, delete_batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	kv_iterator = j_kv_iterator_new("test-ns-pages", NULL);
+
+	while (j_kv_iterator_next(kv_iterator))
+	{
+		gchar const* key;
+		gconstpointer value;
+		guint32 len;
+
+		key = j_kv_iterator_get(kv_iterator, &value, &len);
+		g_assert_true(g_str_has_prefix(key, "test-key-pages-"));
+
+		// Every key must be returned exactly once
+		g_assert_true(g_hash_table_add(keys, g_strdup(key)));
+	}
+
+	g_assert_cmpuint(g_hash_table_size(keys), ==, n);
+
+	// Merging the servers' pages returns all keys in ascending order
+	kv_iterator_sorted = j_kv_iterator_new_sorted("test-ns-pages", NULL);
+	count = 0;
+
+	while (j_kv_iterator_next(kv_iterator_sorted))
+	{
+		gchar const* key;
+		gconstpointer value;
+		guint32 len;
+
+		key = j_kv_iterator_get(kv_iterator_sorted, &value, &len);
+		g_assert_true(g_hash_table_contains(keys, key));
+
+		if (last_key != NULL)
+		{
+			g_assert_cmpint(g_strcmp0(last_key, key), <, 0);
+		}
+
+		g_free(last_key);
+		last_key = g_strdup(key);
+		count++;
+	}
+
+	g_assert_cmpuint(count, ==, n);
+
+	// Freeing an iterator that has not been exhausted must not leak
+	kv_iterator_prefix = j_kv_iterator_new("test-ns-pages", "test-key-pages-");
+	g_assert_true(j_kv_iterator_next(kv_iterator_prefix));
+
+	ret = j_batch_execute(delete_batch);
+	g_assert_true(ret);
+}
+
+static void
+test_kv_iterator_range(void)
+{
+	// Spans multiple pages
+	guint const n = 3000;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JBatch) delete_batch = NULL;
+	g_autoptr(JKVIterator) kv_iterator = NULL;
+	g_autoptr(JKVIterator) kv_iterator_reverse = NULL;
+	g_autoptr(JKVIterator) kv_iterator_limit = NULL;
+	guint count;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	delete_batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JKV) kv = NULL;
+
+		g_autofree gchar* key = NULL;
+		gchar* value = NULL;
+
+		key = g_strdup_printf("test-key-range-%05u", i);
+		value = g_strdup_printf("test-value-%u", i);
+		kv = j_kv_new_for_index(0, "test-ns-range", key);
+		j_kv_put(kv, value, strlen(value) + 1, g_free, batch);
+		j_kv_delete(kv, delete_batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Ascending order, the end is excluded
+	kv_iterator = j_kv_iterator_new_for_range(0, "test-ns-range", "test-key-range-01000", "test-key-range-02500", 0, FALSE);
+	count = 0;
+
+	while (j_kv_iterator_next(kv_iterator))
+	{
+		g_autofree gchar* expected = NULL;
+		gchar const* key;
+		gconstpointer value;
+		guint32 len;
+
+		key = j_kv_iterator_get(kv_iterator, &value, &len);
+		expected = g_strdup_printf("test-key-range-%05u", 1000 + count);
+		g_assert_cmpstr(key, ==, expected);
+
+		count++;
+	}
+
+	g_assert_cmpuint(count, ==, 1500);
+
+	// Descending order with a limit, newest first
+	kv_iterator_reverse = j_kv_iterator_new_for_range(0, "test-ns-range", "test-key-range-01000", "test-key-range-02500", 100, TRUE);
+	count = 0;
+
+	while (j_kv_iterator_next(kv_iterator_reverse))
+	{
+		g_autofree gchar* expected = NULL;
+		gchar const* key;
+		gconstpointer value;
+		guint32 len;
+
+		key = j_kv_iterator_get(kv_iterator_reverse, &value, &len);
+		expected = g_strdup_printf("test-key-range-%05u", 2499 - count);
+		g_assert_cmpstr(key, ==, expected);
+
+		count++;
+	}
+
+	g_assert_cmpuint(count, ==, 100);
+
+	// Open bounds in reverse, with a limit that spans more than one page
+	kv_iterator_limit = j_kv_iterator_new_for_range(0, "test-ns-range", NULL, NULL, 1100, TRUE);
+	count = 0;
+
+	while (j_kv_iterator_next(kv_iterator_limit))
+	{
+		g_autofree gchar* expected = NULL;
+		gchar const* key;
+		gconstpointer value;
+		guint32 len;
+
+		key = j_kv_iterator_get(kv_iterator_limit, &value, &len);
+		expected = g_strdup_printf("test-key-range-%05u", n - 1 - count);
+		g_assert_cmpstr(key, ==, expected);
+
+		count++;
+	}
+
+	g_assert_cmpuint(count, ==, 1100);
+
+	ret = j_batch_execute(delete_batch);
+	g_assert_true(ret);
+}
+
 void
 test_kv_kv_iterator(void)
 {
 	g_test_add_func("/kv/kv-iterator/new_free", test_kv_iterator_new_free);
 	g_test_add_func("/kv/kv-iterator/next_get", test_kv_iterator_next_get);
+	g_test_add_func("/kv/kv-iterator/pages", test_kv_iterator_pages);
+	g_test_add_func("/kv/kv-iterator/range", test_kv_iterator_range);
 }
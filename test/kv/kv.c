@@ -20,6 +20,8 @@
 
 #include <glib.h>
 
+#include <string.h>
+
 #include <julea.h>
 #include <julea-kv.h>
 
@@ -166,6 +168,253 @@ test_kv_get(void)
 	g_assert_true(ret);
 }
 
+static void
+test_kv_put_large(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JKV) kv = NULL;
+	g_autoptr(JKV) kv_small = NULL;
+	g_autofree gchar* get_value = NULL;
+	g_autofree gchar* get_value_small = NULL;
+	g_autofree gchar* value = NULL;
+	gchar value_small[] = "kv-value";
+	guint32 const len = 4 * 1024 * 1024;
+	guint32 get_len = 0;
+	guint32 get_len_small = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	value = g_malloc(len);
+
+	for (guint32 i = 0; i < len; i++)
+	{
+		value[i] = i % 251;
+	}
+
+	kv = j_kv_new("test", "test-kv-put-large");
+	kv_small = j_kv_new("test", "test-kv-put-large-small");
+
+	// Large values are sent after the message, mix them with inline ones.
+	j_kv_put(kv, value, len, NULL, batch);
+	j_kv_put(kv_small, value_small, sizeof(value_small), NULL, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_kv_get(kv, (gpointer)&get_value, &get_len, batch);
+	j_kv_get(kv_small, (gpointer)&get_value_small, &get_len_small, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	g_assert_cmpuint(get_len, ==, len);
+	g_assert_true(memcmp(get_value, value, len) == 0);
+	g_assert_cmpuint(get_len_small, ==, sizeof(value_small));
+	g_assert_cmpstr(get_value_small, ==, value_small);
+
+	j_kv_delete(kv, batch);
+	j_kv_delete(kv_small, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_kv_compare_and_swap(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JKV) kv = NULL;
+	g_autofree gchar* get_value = NULL;
+	gchar value_old[] = "kv-old";
+	gchar value_new[] = "kv-new";
+	guint32 get_len = 0;
+	gboolean swapped = FALSE;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	kv = j_kv_new("test", "test-kv-compare-and-swap");
+
+	// The key does not exist yet, so only the first creation succeeds.
+	j_kv_compare_and_swap(kv, NULL, 0, value_old, sizeof(value_old), NULL, &swapped, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_true(swapped);
+
+	j_kv_compare_and_swap(kv, NULL, 0, value_new, sizeof(value_new), NULL, &swapped, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_false(swapped);
+
+	j_kv_compare_and_swap(kv, value_new, sizeof(value_new), value_new, sizeof(value_new), NULL, &swapped, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_false(swapped);
+
+	j_kv_compare_and_swap(kv, value_old, sizeof(value_old), value_new, sizeof(value_new), NULL, &swapped, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_true(swapped);
+
+	j_kv_get(kv, (gpointer)&get_value, &get_len, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(get_len, ==, sizeof(value_new));
+	g_assert_cmpstr(get_value, ==, value_new);
+
+	j_kv_delete(kv, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_kv_add(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JKV) kv = NULL;
+	gint64 result_1 = 0;
+	gint64 result_2 = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	kv = j_kv_new("test", "test-kv-add");
+
+	// Missing counters start at 0.
+	j_kv_add(kv, 5, &result_1, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpint(result_1, ==, 5);
+
+	j_kv_add(kv, -2, &result_1, batch);
+	j_kv_add(kv, 10, &result_2, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpint(result_1, ==, 3);
+	g_assert_cmpint(result_2, ==, 13);
+
+	j_kv_delete(kv, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_kv_put_expiring(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JKV) kv = NULL;
+	g_autofree gchar* get_value = NULL;
+	gchar value[] = "kv-value";
+	guint32 get_len = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	kv = j_kv_new("test", "test-kv-put-expiring");
+
+	// Keys remain readable until they expire.
+	j_kv_put_expiring(kv, value, sizeof(value), NULL, G_TIME_SPAN_HOUR, batch);
+	j_kv_get(kv, (gpointer*)&get_value, &get_len, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(get_len, ==, sizeof(value));
+	g_assert_cmpstr(get_value, ==, value);
+
+	// Plain puts make the key persistent again.
+	j_kv_put(kv, value, sizeof(value), NULL, batch);
+	j_kv_delete(kv, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_kv_put_eventual(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JBatch) eventual_batch = NULL;
+	g_autoptr(JKV) kv = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autofree gchar* get_value = NULL;
+	gchar value[] = "kv-value";
+	guint32 get_len = 0;
+	gboolean ret;
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(semantics, J_SEMANTICS_PERSISTENCY, J_SEMANTICS_PERSISTENCY_EVENTUAL);
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	eventual_batch = j_batch_new(semantics);
+
+	kv = j_kv_new("test", "test-kv-put-eventual");
+	g_assert_nonnull(kv);
+
+	// Queued puts are superseded by later ones.
+	for (guint i = 0; i < 10; i++)
+	{
+		j_kv_put(kv, g_strdup_printf("kv-value-%u", i), strlen("kv-value-0") + 1, g_free, eventual_batch);
+		ret = j_batch_execute(eventual_batch);
+		g_assert_true(ret);
+	}
+
+	j_kv_put(kv, value, sizeof(value), NULL, eventual_batch);
+	ret = j_batch_execute(eventual_batch);
+	g_assert_true(ret);
+
+	// The value has to have been copied when the batch returned.
+	memset(value, 0, sizeof(value));
+
+	j_kv_get(kv, (gpointer)&get_value, &get_len, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	g_assert_cmpstr(get_value, ==, "kv-value");
+	g_assert_cmpuint(get_len, ==, sizeof(value));
+
+	j_kv_delete(kv, eventual_batch);
+	ret = j_batch_execute(eventual_batch);
+	g_assert_true(ret);
+}
+
+static void
+test_kv_put_atomic(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JBatch) atomic_batch = NULL;
+	g_autoptr(JKV) kv1 = NULL;
+	g_autoptr(JKV) kv2 = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autofree gchar* get_value1 = NULL;
+	g_autofree gchar* get_value2 = NULL;
+	guint32 get_len1 = 0;
+	guint32 get_len2 = 0;
+	gboolean ret;
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(semantics, J_SEMANTICS_ATOMICITY, J_SEMANTICS_ATOMICITY_BATCH);
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	atomic_batch = j_batch_new(semantics);
+
+	kv1 = j_kv_new("test", "test-kv-put-atomic-1");
+	kv2 = j_kv_new("test", "test-kv-put-atomic-2");
+
+	// Operations of the same batch see each other's modifications.
+	j_kv_put(kv1, g_strdup("kv-value-1"), strlen("kv-value-1") + 1, g_free, atomic_batch);
+	j_kv_put(kv2, g_strdup("kv-value-2"), strlen("kv-value-2") + 1, g_free, atomic_batch);
+	j_kv_get(kv1, (gpointer)&get_value1, &get_len1, atomic_batch);
+	ret = j_batch_execute(atomic_batch);
+	g_assert_true(ret);
+
+	g_assert_cmpstr(get_value1, ==, "kv-value-1");
+	g_assert_cmpuint(get_len1, ==, strlen("kv-value-1") + 1);
+
+	j_kv_get(kv2, (gpointer)&get_value2, &get_len2, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	g_assert_cmpstr(get_value2, ==, "kv-value-2");
+	g_assert_cmpuint(get_len2, ==, strlen("kv-value-2") + 1);
+
+	j_kv_delete(kv1, atomic_batch);
+	j_kv_delete(kv2, atomic_batch);
+	ret = j_batch_execute(atomic_batch);
+	g_assert_true(ret);
+}
+
 static guint num_callbacks = 0;
 
 static void
@@ -221,5 +470,11 @@ test_kv_kv(void)
 	g_test_add_func("/kv/kv/put_delete", test_kv_put_delete);
 	g_test_add_func("/kv/kv/put_update", test_kv_put_update);
 	g_test_add_func("/kv/kv/get", test_kv_get);
+	g_test_add_func("/kv/kv/put_large", test_kv_put_large);
+	g_test_add_func("/kv/kv/compare_and_swap", test_kv_compare_and_swap);
+	g_test_add_func("/kv/kv/add", test_kv_add);
+	g_test_add_func("/kv/kv/put_expiring", test_kv_put_expiring);
+	g_test_add_func("/kv/kv/put_eventual", test_kv_put_eventual);
+	g_test_add_func("/kv/kv/put_atomic", test_kv_put_atomic);
 	g_test_add_func("/kv/kv/get_callback", test_kv_get_callback);
 }
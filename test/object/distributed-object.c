@@ -78,6 +78,43 @@ test_object_create_delete(void)
 	g_assert_false(ret);
 }
 
+static void
+test_object_create_delete_unwritten(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDistribution) distribution = NULL;
+	g_autoptr(JDistributedObject) object = NULL;
+	g_autoptr(JDistributedObject) object_short = NULL;
+	guint64 nbytes = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
+	j_distribution_set_block_size(distribution, 4096);
+
+	// Objects that have never been written only have their first part when created lazily
+	object = j_distributed_object_new("test", "test-distributed-object-unwritten", distribution);
+	j_distributed_object_create(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_distributed_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Short objects only have a part on a single server
+	object_short = j_distributed_object_new("test", "test-distributed-object-short", distribution);
+	j_distributed_object_create(object_short, batch);
+	j_distributed_object_write(object_short, "short", 5, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 5);
+
+	j_distributed_object_delete(object_short, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
 static void
 test_object_read_write(void)
 {
@@ -168,6 +205,161 @@ test_object_read_write(void)
 	g_assert_true(ret);
 }
 
+static void
+test_object_write_coalesce(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDistribution) distribution = NULL;
+	g_autoptr(JDistributedObject) object = NULL;
+	g_autofree gchar* buffer = NULL;
+	g_autofree gchar* buffer2 = NULL;
+	guint64 nbytes = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer = g_malloc0(64 * 1024);
+	buffer2 = g_malloc0(64 * 1024);
+
+	for (guint i = 0; i < 64 * 1024; i++)
+	{
+		buffer[i] = i % 251;
+	}
+
+	distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
+	j_distribution_set_block_size(distribution, 16 * 1024);
+	object = j_distributed_object_new("test", "test-distributed-object-write-coalesce", distribution);
+
+	j_distributed_object_create(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Adjacent small writes.
+	for (guint i = 0; i < 16; i++)
+	{
+		j_distributed_object_write(object, buffer + (i * 4096), 4096, i * 4096, &nbytes, batch);
+	}
+
+	// An overlapping write that has to take precedence.
+	memset(buffer + 1000, 'j', 100);
+	j_distributed_object_write(object, buffer + 1000, 100, 1000, &nbytes, batch);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 64 * 1024 + 100);
+
+	j_distributed_object_read(object, buffer2, 64 * 1024, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 64 * 1024);
+	g_assert_cmpmem(buffer2, 64 * 1024, buffer, 64 * 1024);
+
+	j_distributed_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_object_read_ahead(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDistribution) distribution = NULL;
+	g_autoptr(JDistributedObject) object = NULL;
+	g_autofree gchar* buffer = NULL;
+	g_autofree gchar* buffer2 = NULL;
+	guint64 nbytes = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer = g_malloc0(4096);
+	buffer2 = g_malloc0(1024);
+
+	for (guint i = 0; i < 4096; i++)
+	{
+		buffer[i] = i % 251;
+	}
+
+	distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
+	j_distribution_set_block_size(distribution, 512);
+	object = j_distributed_object_new("test", "test-distributed-object-read-ahead", distribution);
+	j_distributed_object_set_read_ahead(object, 4);
+
+	j_distributed_object_create(object, batch);
+	j_distributed_object_write(object, buffer, 4096, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 4096);
+
+	// Sequential reads, including one past the end of the object.
+	for (guint64 offset = 0; offset < 4096; offset += 1024)
+	{
+		j_distributed_object_read(object, buffer2, 1024, offset, &nbytes, batch);
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+		g_assert_cmpuint(nbytes, ==, 1024);
+		g_assert_cmpmem(buffer2, 1024, buffer + offset, 1024);
+	}
+
+	j_distributed_object_read(object, buffer2, 1024, 4096, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 0);
+
+	// A write has to invalidate prefetched data.
+	memset(buffer, 'j', 1024);
+
+	j_distributed_object_read(object, buffer2, 1024, 0, &nbytes, batch);
+	j_distributed_object_read(object, buffer2, 1024, 1024, &nbytes, batch);
+	j_distributed_object_write(object, buffer, 1024, 2048, &nbytes, batch);
+	j_distributed_object_read(object, buffer2, 1024, 2048, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpmem(buffer2, 1024, buffer, 1024);
+
+	j_distributed_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_object_create_with_size(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDistribution) distribution = NULL;
+	g_autoptr(JDistributedObject) object = NULL;
+	g_autofree gchar* buffer = NULL;
+	guint64 nbytes = 0;
+	guint64 size = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer = g_malloc0(42);
+
+	distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
+	object = j_distributed_object_new("test", "test-distributed-object-create-with-size", distribution);
+	g_assert_true(object != NULL);
+
+	j_distributed_object_create_with_size(object, 16 * 1024 * 1024, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Preallocation must not change the size
+	j_distributed_object_status(object, NULL, &size, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(size, ==, 0);
+
+	j_distributed_object_write(object, buffer, 42, 0, &nbytes, batch);
+	j_distributed_object_status(object, NULL, &size, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 42);
+	g_assert_cmpuint(size, ==, 42);
+
+	j_distributed_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
 static void
 test_object_status(void)
 {
@@ -242,12 +434,577 @@ test_object_sync(void)
 	g_assert_true(ret);
 }
 
+static void
+test_object_append(void)
+{
+	guint const n = 100;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDistribution) distribution = NULL;
+	g_autoptr(JDistributedObject) object = NULL;
+	g_autofree gchar* buffer = NULL;
+	g_autofree gchar* data = NULL;
+	g_autofree guint64* offsets = NULL;
+	g_autofree guint64* nbytes = NULL;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer = g_malloc(n * 1024);
+	data = g_malloc(n * 1024);
+	offsets = g_new(guint64, n);
+	nbytes = g_new(guint64, n);
+
+	distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
+	j_distribution_set_block_size(distribution, 4096);
+	object = j_distributed_object_new("test", "test-distributed-object-append", distribution);
+	g_assert_true(object != NULL);
+
+	j_distributed_object_create(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint i = 0; i < n; i++)
+	{
+		memset(data + i * 1024, 'a' + (i % 26), 1024);
+		j_distributed_object_append(object, data + i * 1024, 1024, &(offsets[i]), &(nbytes[i]), batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Every append got its own range, even though the data is striped across all servers
+	for (guint i = 0; i < n; i++)
+	{
+		guint64 bytes_read = 0;
+
+		g_assert_cmpuint(nbytes[i], ==, 1024);
+		g_assert_cmpuint(offsets[i] % 1024, ==, 0);
+		g_assert_cmpuint(offsets[i], <, n * 1024);
+
+		j_distributed_object_read(object, buffer, 1024, offsets[i], &bytes_read, batch);
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+		g_assert_cmpuint(bytes_read, ==, 1024);
+		g_assert_cmpmem(buffer, 1024, data + i * 1024, 1024);
+	}
+
+	j_distributed_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_object_clone(void)
+{
+	guint const n = 64 * 1024;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDistribution) distribution = NULL;
+	g_autoptr(JDistributedObject) object = NULL;
+	g_autoptr(JDistributedObject) clone = NULL;
+	g_autofree gchar* buffer = NULL;
+	g_autofree gchar* data = NULL;
+	guint64 nbytes = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer = g_malloc(n);
+	data = g_malloc(n);
+
+	distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
+	j_distribution_set_block_size(distribution, 4096);
+	object = j_distributed_object_new("test", "test-distributed-object-clone", distribution);
+	clone = j_distributed_object_new("test-snapshot", "test-distributed-object-clone", NULL);
+
+	for (guint i = 0; i < n; i++)
+	{
+		data[i] = 'a' + (i % 26);
+	}
+
+	j_distributed_object_create(object, batch);
+	j_distributed_object_write(object, data, n, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_distributed_object_clone(object, clone, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	memset(buffer, 'z', n);
+	j_distributed_object_write(object, buffer, n, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// The clone's distribution is loaded from its own header
+	j_distributed_object_read(clone, buffer, n, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, n);
+	g_assert_cmpmem(buffer, n, data, n);
+
+	j_distributed_object_delete(object, batch);
+	j_distributed_object_delete(clone, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_object_repeated_blocks(void)
+{
+	guint const n = 4 * 1024 * 1024 + 1000;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDistribution) distribution = NULL;
+	g_autoptr(JDistributedObject) object = NULL;
+	g_autoptr(JDistributedObject) copy = NULL;
+	g_autofree gchar* buffer = NULL;
+	g_autofree gchar* data = NULL;
+	guint64 nbytes = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer = g_malloc(n);
+	data = g_malloc(n);
+
+	distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
+	j_distribution_set_block_size(distribution, 2 * 1024 * 1024);
+	object = j_distributed_object_new("test", "test-distributed-object-repeated", distribution);
+	copy = j_distributed_object_new("test", "test-distributed-object-repeated-copy", distribution);
+
+	for (guint i = 0; i < n; i++)
+	{
+		data[i] = 'a' + (i % 23);
+	}
+
+	// With deduplication enabled, the second write only references the blocks stored by the first one
+	j_distributed_object_create(object, batch);
+	j_distributed_object_write(object, data, n, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, n);
+
+	j_distributed_object_create(copy, batch);
+	j_distributed_object_write(copy, data, n, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, n);
+
+	// Modifying one object must not affect the other
+	memset(buffer, 'z', n);
+	j_distributed_object_write(object, buffer, 1024 * 1024, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_distributed_object_read(copy, buffer, n, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, n);
+	g_assert_cmpmem(buffer, n, data, n);
+
+	j_distributed_object_read(object, buffer, n, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, n);
+	g_assert_cmpint(buffer[0], ==, 'z');
+	g_assert_cmpmem(buffer + 1024 * 1024, n - 1024 * 1024, data + 1024 * 1024, n - 1024 * 1024);
+
+	j_distributed_object_delete(object, batch);
+	j_distributed_object_delete(copy, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_object_advise(void)
+{
+	guint const n = 64 * 1024;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDistribution) distribution = NULL;
+	g_autoptr(JDistributedObject) object = NULL;
+	g_autofree gchar* buffer = NULL;
+	g_autofree gchar* data = NULL;
+	guint64 nbytes = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer = g_malloc(n);
+	data = g_malloc(n);
+
+	distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
+	j_distribution_set_block_size(distribution, 4096);
+	object = j_distributed_object_new("test", "test-distributed-object-advise", distribution);
+
+	for (guint i = 0; i < n; i++)
+	{
+		data[i] = 'a' + (i % 26);
+	}
+
+	j_distributed_object_create(object, batch);
+	j_distributed_object_write(object, data, n, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Each server only receives advice for its own blocks
+	j_distributed_object_advise(object, J_ADVICE_RANDOM, n / 2, 1000, batch);
+	j_distributed_object_prefetch(object, 0, 0, batch);
+	j_distributed_object_read(object, buffer, n, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, n);
+	g_assert_cmpmem(buffer, n, data, n);
+
+	j_distributed_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_object_distribution_header(void)
+{
+	guint const n = 64 * 1024;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDistribution) distribution = NULL;
+	g_autoptr(JDistributedObject) object = NULL;
+	g_autoptr(JDistributedObject) object2 = NULL;
+	g_autofree gchar* buffer = NULL;
+	g_autofree gchar* buffer2 = NULL;
+	guint64 nbytes = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer = g_malloc(n);
+	buffer2 = g_malloc0(n);
+
+	for (guint i = 0; i < n; i++)
+	{
+		buffer[i] = i % 251;
+	}
+
+	distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
+	j_distribution_set_block_size(distribution, 4096);
+	object = j_distributed_object_new("test", "test-distributed-object-header", distribution);
+	g_assert_true(object != NULL);
+
+	j_distributed_object_create(object, batch);
+	j_distributed_object_write(object, buffer, n, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, n);
+
+	// The distribution (including the random start index) is loaded from the header
+	object2 = j_distributed_object_new("test", "test-distributed-object-header", NULL);
+	g_assert_true(object2 != NULL);
+
+	j_distributed_object_read(object2, buffer2, n, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, n);
+	g_assert_cmpmem(buffer, n, buffer2, n);
+
+	j_distributed_object_delete(object2, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_object_readv_writev(void)
+{
+	guint const n = 1000;
+	guint const size = 16;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDistribution) distribution = NULL;
+	g_autoptr(JDistributedObject) object = NULL;
+	g_autofree JDistributedObjectExtent* extents = NULL;
+	g_autofree gchar* buffer = NULL;
+	g_autofree gchar* buffer2 = NULL;
+	guint64 nbytes = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	extents = g_new(JDistributedObjectExtent, n);
+	buffer = g_malloc(n * size);
+	buffer2 = g_malloc0(n * size);
+
+	for (guint i = 0; i < n * size; i++)
+	{
+		buffer[i] = i % 251;
+	}
+
+	distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
+	j_distribution_set_block_size(distribution, 4096);
+	object = j_distributed_object_new("test", "test-distributed-object-vector", distribution);
+	g_assert_true(object != NULL);
+
+	j_distributed_object_create(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Strided regions in reverse order
+	for (guint i = 0; i < n; i++)
+	{
+		extents[i].data = buffer + (n - i - 1) * size;
+		extents[i].length = size;
+		extents[i].offset = (n - i - 1) * 3 * size;
+	}
+
+	j_distributed_object_writev(object, extents, n, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, n * size);
+
+	for (guint i = 0; i < n; i++)
+	{
+		extents[i].data = buffer2 + i * size;
+		extents[i].length = size;
+		extents[i].offset = i * 3 * size;
+	}
+
+	j_distributed_object_readv(object, extents, n, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, n * size);
+	g_assert_cmpmem(buffer, n * size, buffer2, n * size);
+
+	j_distributed_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+/**
+ * Deletes the part storing an erasure-coded object's first block and checks that the data is reconstructed.
+ **/
+static void
+test_object_erasure_missing_part(JDistribution* distribution, JDistributedObject* object, gchar const* name, gchar const* buffer, guint n)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) part = NULL;
+	g_autofree gchar* buffer2 = NULL;
+	guint64 parity = 0;
+	guint64 block_id;
+	guint64 length;
+	guint64 offset;
+	guint64 nbytes = 0;
+	guint index;
+	gboolean ret;
+
+	// Without parity, there is nothing to reconstruct from
+	if (!j_distribution_get(distribution, "parity", &parity) || parity == 0)
+	{
+		return;
+	}
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer2 = g_malloc0(n);
+
+	j_distribution_reset(distribution, 1, 0);
+	g_assert_true(j_distribution_distribute(distribution, &index, &length, &offset, &block_id));
+
+	part = j_object_new_for_index(index, "test", name);
+	j_object_delete(part, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_distributed_object_read(object, buffer2, n, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, n);
+	g_assert_cmpmem(buffer, n, buffer2, n);
+
+	// An empty part allows deleting the object as usual
+	j_object_create(part, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+/**
+ * Deletes the part storing a replicated object's first block and checks that the other copies are still complete.
+ **/
+static void
+test_object_replicated_failed_replica(JDistribution* distribution, gchar const* name, gchar const* buffer)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) failed = NULL;
+	g_autoptr(GArray) copies = NULL;
+	g_autofree gchar* buffer2 = NULL;
+	guint64 replicas = 0;
+	guint64 block_id;
+	guint64 length;
+	guint64 offset;
+	guint64 replica_offset;
+	guint index;
+	guint replica_index;
+	gboolean ret;
+
+	if (!j_distribution_get(distribution, "replicas", &replicas) || replicas < 2)
+	{
+		return;
+	}
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	copies = g_array_new(FALSE, FALSE, sizeof(guint64));
+
+	j_distribution_reset(distribution, 1, 0);
+	g_assert_true(j_distribution_distribute(distribution, &index, &length, &offset, &block_id));
+
+	// The copies have to be determined before the distribution is used again
+	for (guint r = 1; j_distribution_distribute_replica(distribution, r, &replica_index, &replica_offset); r++)
+	{
+		guint64 copy = replica_index;
+
+		g_array_append_val(copies, copy);
+		g_array_append_val(copies, replica_offset);
+	}
+
+	g_assert_cmpuint(copies->len, ==, 2 * (replicas - 1));
+
+	failed = j_object_new_for_index(index, "test", name);
+	j_object_delete(failed, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	buffer2 = g_malloc0(length);
+
+	for (guint i = 0; i < copies->len; i += 2)
+	{
+		g_autoptr(JObject) copy = NULL;
+		guint64 nbytes = 0;
+
+		copy = j_object_new_for_index(g_array_index(copies, guint64, i), "test", name);
+		j_object_read(copy, buffer2, length, g_array_index(copies, guint64, i + 1), &nbytes, batch);
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+		g_assert_cmpuint(nbytes, ==, length);
+		g_assert_cmpmem(buffer, length, buffer2, length);
+	}
+
+	// An empty part allows deleting the object as usual
+	j_object_create(failed, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+/**
+ * Writes, partially overwrites, reads and deletes an object using a distribution.
+ **/
+static void
+test_object_distribution(JDistributionType type, gchar const* name)
+{
+	guint const n = 100 * 1000;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDistribution) distribution = NULL;
+	g_autoptr(JDistributedObject) object = NULL;
+	g_autofree gchar* buffer = NULL;
+	g_autofree gchar* buffer2 = NULL;
+	gint64 modification_time = 0;
+	guint64 size = 0;
+	guint64 nbytes = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer = g_malloc(n);
+	buffer2 = g_malloc0(n + 4096);
+
+	for (guint i = 0; i < n; i++)
+	{
+		buffer[i] = i % 251;
+	}
+
+	distribution = j_distribution_new(type);
+	j_distribution_set_block_size(distribution, 4096);
+	object = j_distributed_object_new("test", name, distribution);
+	g_assert_true(object != NULL);
+
+	j_distributed_object_create(object, batch);
+	j_distributed_object_write(object, buffer, n, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, n);
+
+	// Partially overwrite a block, which affects its stripe or all of its copies
+	memset(buffer + 5000, 42, 100);
+	j_distributed_object_write(object, buffer + 5000, 100, 5000, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 100);
+
+	j_distributed_object_read(object, buffer2, n, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, n);
+	g_assert_cmpmem(buffer, n, buffer2, n);
+
+	// Padding, parity and copies are not counted towards the size
+	j_distributed_object_status(object, &modification_time, &size, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(size, ==, n);
+
+	if (type == J_DISTRIBUTION_ERASURE)
+	{
+		// n is not a multiple of the stripe size, reads must not return the padding
+		j_distributed_object_read(object, buffer2, n + 4096, 0, &nbytes, batch);
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+		g_assert_cmpuint(nbytes, ==, n);
+
+		j_distributed_object_read(object, buffer2, 4096, n, &nbytes, batch);
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+		g_assert_cmpuint(nbytes, ==, 0);
+
+		test_object_erasure_missing_part(distribution, object, name, buffer, n);
+	}
+	else if (type == J_DISTRIBUTION_REPLICATED)
+	{
+		test_object_replicated_failed_replica(distribution, name, buffer);
+	}
+
+	j_distributed_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_object_erasure(void)
+{
+	test_object_distribution(J_DISTRIBUTION_ERASURE, "test-distributed-object-erasure");
+}
+
+static void
+test_object_replicated(void)
+{
+	test_object_distribution(J_DISTRIBUTION_REPLICATED, "test-distributed-object-replicated");
+}
+
+static void
+test_object_consistent(void)
+{
+	test_object_distribution(J_DISTRIBUTION_CONSISTENT, "test-distributed-object-consistent");
+}
+
 void
 test_object_distributed_object(void)
 {
 	g_test_add_func("/object/distributed-object/new_free", test_object_new_free);
 	g_test_add_func("/object/distributed-object/create_delete", test_object_create_delete);
+	g_test_add_func("/object/distributed-object/create_delete_unwritten", test_object_create_delete_unwritten);
+	g_test_add_func("/object/distributed-object/create_with_size", test_object_create_with_size);
 	g_test_add_func("/object/distributed-object/read_write", test_object_read_write);
+	g_test_add_func("/object/distributed-object/write_coalesce", test_object_write_coalesce);
+	g_test_add_func("/object/distributed-object/read_ahead", test_object_read_ahead);
 	g_test_add_func("/object/distributed-object/status", test_object_status);
 	g_test_add_func("/object/distributed-object/sync", test_object_sync);
+	g_test_add_func("/object/distributed-object/append", test_object_append);
+	g_test_add_func("/object/distributed-object/clone", test_object_clone);
+	g_test_add_func("/object/distributed-object/advise", test_object_advise);
+	g_test_add_func("/object/distributed-object/repeated_blocks", test_object_repeated_blocks);
+	g_test_add_func("/object/distributed-object/distribution_header", test_object_distribution_header);
+	g_test_add_func("/object/distributed-object/readv_writev", test_object_readv_writev);
+	g_test_add_func("/object/distributed-object/erasure", test_object_erasure);
+	g_test_add_func("/object/distributed-object/replicated", test_object_replicated);
+	g_test_add_func("/object/distributed-object/consistent", test_object_consistent);
 }
@@ -20,6 +20,8 @@
 
 #include <glib.h>
 
+#include <string.h>
+
 #include <julea.h>
 #include <julea-object.h>
 
@@ -166,9 +168,76 @@ test_object_iterator_next_get(void)
 	g_assert_true(ret);
 }
 
+static void
+test_object_iterator_status(void)
+{
+	// More objects than a server sends per reply, so that listings are streamed in several replies
+	guint const n = 2500;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JBatch) delete_batch = NULL;
+	g_autoptr(JObjectIterator) object_iterator = NULL;
+	g_autoptr(JObjectIterator) object_iterator_early = NULL;
+	gchar const data[] = "0123456789";
+	guint64 bytes_written;
+	gboolean ret;
+
+	guint objects = 0;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	delete_batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JObject) object = NULL;
+
+		g_autofree gchar* key = NULL;
+
+		key = g_strdup_printf("test-key-status-%d", i);
+		object = j_object_new("test-ns", key);
+		j_object_create(object, batch);
+		j_object_write(object, data, i % 10, 0, &bytes_written, batch);
+		j_object_delete(object, delete_batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	object_iterator = j_object_iterator_new_with_status("test-ns", "test-key-status-");
+
+	while (j_object_iterator_next(object_iterator))
+	{
+		gchar const* key;
+		gint64 modification_time;
+		guint64 size;
+		guint i;
+
+		key = j_object_iterator_get(object_iterator);
+		g_assert_true(g_str_has_prefix(key, "test-key-status-"));
+
+		i = g_ascii_strtoull(key + strlen("test-key-status-"), NULL, 10);
+		j_object_iterator_get_status(object_iterator, &modification_time, &size);
+		g_assert_cmpint(modification_time, >, 0);
+		g_assert_cmpuint(size, ==, i % 10);
+
+		objects++;
+	}
+
+	g_assert_cmpuint(objects, ==, n);
+
+	// Iterators can be freed before all replies have been received
+	object_iterator_early = j_object_iterator_new_with_status("test-ns", NULL);
+	g_assert_true(j_object_iterator_next(object_iterator_early));
+	g_clear_pointer(&object_iterator_early, j_object_iterator_free);
+
+	ret = j_batch_execute(delete_batch);
+	g_assert_true(ret);
+}
+
 void
 test_object_object_iterator(void)
 {
 	g_test_add_func("/object/object-iterator/new_free", test_object_iterator_new_free);
 	g_test_add_func("/object/object-iterator/next_get", test_object_iterator_next_get);
+	g_test_add_func("/object/object-iterator/status", test_object_iterator_status);
 }
@@ -231,6 +231,247 @@ test_object_sync(void)
 	g_assert_true(ret);
 }
 
+static void
+test_object_discard(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) object = NULL;
+	g_autofree gchar* buffer = NULL;
+	g_autofree gchar* zeros = NULL;
+	guint64 nbytes = 0;
+	guint64 size = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer = g_malloc(8192);
+	zeros = g_malloc0(4096);
+
+	object = j_object_new("test", "test-object-discard");
+	g_assert_true(object != NULL);
+
+	j_object_create(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	memset(buffer, 'j', 8192);
+
+	j_object_write(object, buffer, 8192, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 8192);
+
+	j_object_discard(object, 4096, 0, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_object_read(object, buffer, 8192, 0, &nbytes, batch);
+	j_object_status(object, NULL, &size, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 8192);
+	g_assert_cmpuint(size, ==, 8192);
+	g_assert_cmpmem(buffer, 4096, zeros, 4096);
+	g_assert_cmpint(buffer[4096], ==, 'j');
+	g_assert_cmpint(buffer[8191], ==, 'j');
+
+	j_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_object_append(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) object = NULL;
+	gchar buffer[16];
+	guint64 offsets[3];
+	guint64 nbytes[3];
+	guint64 size = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	object = j_object_new("test", "test-object-append");
+	g_assert_true(object != NULL);
+
+	j_object_create(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_object_write(object, "head", 4, 0, &(nbytes[0]), batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Appends start at the current end of the object and never overlap
+	j_object_append(object, "abc", 3, &(offsets[0]), &(nbytes[0]), batch);
+	j_object_append(object, "defg", 4, &(offsets[1]), &(nbytes[1]), batch);
+	j_object_append(object, "h", 1, &(offsets[2]), &(nbytes[2]), batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(offsets[0], ==, 4);
+	g_assert_cmpuint(offsets[1], ==, 7);
+	g_assert_cmpuint(offsets[2], ==, 11);
+	g_assert_cmpuint(nbytes[0], ==, 3);
+	g_assert_cmpuint(nbytes[1], ==, 4);
+	g_assert_cmpuint(nbytes[2], ==, 1);
+
+	j_object_read(object, buffer, 12, 0, &(nbytes[0]), batch);
+	j_object_status(object, NULL, &size, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes[0], ==, 12);
+	g_assert_cmpuint(size, ==, 12);
+	g_assert_cmpmem(buffer, 12, "headabcdefgh", 12);
+
+	j_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_object_clone(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) object = NULL;
+	g_autoptr(JObject) clone = NULL;
+	g_autoptr(JObject) copy = NULL;
+	gchar buffer[16];
+	guint64 nbytes = 0;
+	guint64 size = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	object = j_object_new("test", "test-object-clone");
+	clone = j_object_new_for_index(0, "test-snapshot", "test-object-clone");
+	copy = j_object_new_for_index(j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT) - 1, "test-snapshot", "test-object-copy");
+
+	j_object_create(object, batch);
+	j_object_write(object, "original", 8, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Objects on other servers are copied
+	j_object_clone(object, clone, batch);
+	j_object_clone(object, copy, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// The clones do not see later modifications
+	j_object_write(object, "modified", 8, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_object_read(clone, buffer, sizeof(buffer), 0, &nbytes, batch);
+	j_object_status(clone, NULL, &size, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(size, ==, 8);
+	g_assert_cmpmem(buffer, nbytes, "original", 8);
+
+	j_object_read(copy, buffer, sizeof(buffer), 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpmem(buffer, nbytes, "original", 8);
+
+	j_object_write(clone, "clone", 5, 0, &nbytes, batch);
+	j_object_read(object, buffer, sizeof(buffer), 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpmem(buffer, nbytes, "modified", 8);
+
+	j_object_delete(object, batch);
+	j_object_delete(clone, batch);
+	j_object_delete(copy, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_object_advise(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) object = NULL;
+	gchar buffer[16];
+	guint64 nbytes = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	object = j_object_new("test", "test-object-advise");
+
+	j_object_create(object, batch);
+	j_object_write(object, "advise", 6, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Advice does not change the data
+	j_object_advise(object, J_ADVICE_SEQUENTIAL, 0, 0, batch);
+	j_object_prefetch(object, 6, 0, batch);
+	j_object_read(object, buffer, sizeof(buffer), 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpmem(buffer, nbytes, "advise", 6);
+
+	j_object_advise(object, J_ADVICE_NO_REUSE, 0, 0, batch);
+	j_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_object_eventual(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JBatch) eventual_batch = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autoptr(JObject) object = NULL;
+	gchar buffer[16];
+	guint64 nbytes = 0;
+	guint64 size = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(semantics, J_SEMANTICS_PERSISTENCY, J_SEMANTICS_PERSISTENCY_EVENTUAL);
+	eventual_batch = j_batch_new(semantics);
+
+	object = j_object_new("test", "test-object-eventual");
+	j_object_create(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Writes with eventual persistency might be staged in the burst buffer
+	j_object_write(object, "eventual", 8, 0, &nbytes, eventual_batch);
+	j_object_write(object, "ly", 2, 8, &nbytes, eventual_batch);
+	ret = j_batch_execute(eventual_batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 10);
+
+	j_object_read(object, buffer, 10, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 10);
+	g_assert_cmpmem(buffer, nbytes, "eventually", 10);
+
+	// Reads that are not fully staged see the drained data
+	j_object_write(object, "E", 1, 0, &nbytes, eventual_batch);
+	ret = j_batch_execute(eventual_batch);
+	g_assert_true(ret);
+
+	j_object_read(object, buffer, sizeof(buffer), 0, &nbytes, batch);
+	j_object_status(object, NULL, &size, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 10);
+	g_assert_cmpmem(buffer, nbytes, "Eventually", 10);
+	g_assert_cmpuint(size, ==, 10);
+
+	j_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
 void
 test_object_object(void)
 {
@@ -239,4 +480,9 @@ test_object_object(void)
 	g_test_add_func("/object/object/read_write", test_object_read_write);
 	g_test_add_func("/object/object/status", test_object_status);
 	g_test_add_func("/object/object/sync", test_object_sync);
+	g_test_add_func("/object/object/discard", test_object_discard);
+	g_test_add_func("/object/object/append", test_object_append);
+	g_test_add_func("/object/object/clone", test_object_clone);
+	g_test_add_func("/object/object/advise", test_object_advise);
+	g_test_add_func("/object/object/eventual", test_object_eventual);
 }
@@ -0,0 +1,150 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+// The codes are internal to the object client, so they are compiled into the test, which also allows choosing the implementation
+#define JULEA_OBJECT_COMPILATION
+#include "../../lib/object/jreed-solomon.c"
+
+#include "test.h"
+
+/**
+ * Erases all combinations of up to parity_count blocks and checks that the data can be reconstructed.
+ **/
+static void
+test_reed_solomon_stripe(guint data_count, guint parity_count, gsize length)
+{
+	guint const count = data_count + parity_count;
+
+	g_autofree guint8** original = NULL;
+	g_autofree guint8** blocks = NULL;
+	g_autofree gboolean* present = NULL;
+
+	original = g_new(guint8*, count);
+	blocks = g_new(guint8*, count);
+	present = g_new(gboolean, count);
+
+	for (guint i = 0; i < count; i++)
+	{
+		original[i] = g_malloc(length);
+		blocks[i] = g_malloc(length);
+	}
+
+	for (guint i = 0; i < data_count; i++)
+	{
+		for (gsize j = 0; j < length; j++)
+		{
+			original[i][j] = g_test_rand_int_range(0, 256);
+		}
+	}
+
+	j_reed_solomon_encode(data_count, parity_count, original, original + data_count, length);
+
+	for (guint erased = 0; erased < (1U << count); erased++)
+	{
+		guint erased_count = 0;
+		gboolean ret;
+
+		for (guint i = 0; i < count; i++)
+		{
+			present[i] = ((erased & (1U << i)) == 0);
+			erased_count += (present[i]) ? 0 : 1;
+
+			memcpy(blocks[i], original[i], length);
+
+			// Erased blocks must not be read
+			if (!present[i])
+			{
+				memset(blocks[i], 0xaa, length);
+			}
+		}
+
+		ret = j_reed_solomon_reconstruct(data_count, parity_count, blocks, present, length);
+
+		if (erased_count > parity_count)
+		{
+			g_assert_false(ret);
+			continue;
+		}
+
+		g_assert_true(ret);
+
+		for (guint i = 0; i < data_count; i++)
+		{
+			g_assert_cmpmem(blocks[i], length, original[i], length);
+		}
+	}
+
+	for (guint i = 0; i < count; i++)
+	{
+		g_free(original[i]);
+		g_free(blocks[i]);
+	}
+}
+
+static void
+test_reed_solomon_codes(void)
+{
+	// Lengths that are not a multiple of 16 also exercise the scalar tail of the SSSE3 implementation
+	test_reed_solomon_stripe(1, 1, 64);
+	test_reed_solomon_stripe(2, 1, 100);
+	test_reed_solomon_stripe(4, 2, 1000);
+	test_reed_solomon_stripe(6, 3, 4099);
+	test_reed_solomon_stripe(8, 4, 17);
+}
+
+static void
+test_reed_solomon_scalar(void)
+{
+	gboolean ssse3;
+
+	j_reed_solomon_init();
+
+	ssse3 = j_reed_solomon_tables.ssse3;
+	j_reed_solomon_tables.ssse3 = FALSE;
+
+	test_reed_solomon_codes();
+
+	j_reed_solomon_tables.ssse3 = ssse3;
+}
+
+static void
+test_reed_solomon_ssse3(void)
+{
+	j_reed_solomon_init();
+
+	if (!j_reed_solomon_tables.ssse3)
+	{
+		g_test_skip("SSSE3 is not supported");
+		return;
+	}
+
+	test_reed_solomon_codes();
+}
+
+void
+test_object_reed_solomon(void)
+{
+	g_test_add_func("/object/reed-solomon/scalar", test_reed_solomon_scalar);
+	g_test_add_func("/object/reed-solomon/ssse3", test_reed_solomon_ssse3);
+}
@@ -37,10 +37,15 @@ main(int argc, char** argv)
 	g_test_init(&argc, &argv, NULL);
 
 	// Core
+	test_core_backend_latency();
 	test_core_background_operation();
+	test_core_bloom_filter();
+	test_core_buffer();
 	test_core_batch();
 	test_core_cache();
+	test_core_checksum();
 	test_core_configuration();
+	test_core_connection_pool();
 	test_core_credentials();
 	test_core_dir_iterator();
 	test_core_distribution();
@@ -48,12 +53,15 @@ main(int argc, char** argv)
 	test_core_list_iterator();
 	test_core_memory_chunk();
 	test_core_message();
+	test_core_reduce();
 	test_core_semantics();
+	test_core_statistics();
 
 	// Object client
 	test_object_distributed_object();
 	test_object_object();
 	test_object_object_iterator();
+	test_object_reed_solomon();
 
 	// KV client
 	test_kv_kv();
@@ -67,6 +75,7 @@ main(int argc, char** argv)
 	test_item_collection_iterator();
 	test_item_item();
 	test_item_item_iterator();
+	test_item_packed_object();
 	test_item_uri();
 
 	// HDF5 client
@@ -19,10 +19,15 @@
 #ifndef JULEA_TEST_T
 #define JULEA_TEST_T
 
+void test_core_backend_latency(void);
 void test_core_background_operation(void);
+void test_core_bloom_filter(void);
+void test_core_buffer(void);
 void test_core_batch(void);
 void test_core_cache(void);
+void test_core_checksum(void);
 void test_core_configuration(void);
+void test_core_connection_pool(void);
 void test_core_credentials(void);
 void test_core_dir_iterator(void);
 void test_core_distribution(void);
@@ -30,11 +35,14 @@ void test_core_list(void);
 void test_core_list_iterator(void);
 void test_core_memory_chunk(void);
 void test_core_message(void);
+void test_core_reduce(void);
 void test_core_semantics(void);
+void test_core_statistics(void);
 
 void test_object_distributed_object(void);
 void test_object_object(void);
 void test_object_object_iterator(void);
+void test_object_reed_solomon(void);
 
 void test_kv_kv(void);
 void test_kv_kv_iterator(void);
@@ -45,6 +53,7 @@ void test_item_collection(void);
 void test_item_collection_iterator(void);
 void test_item_item(void);
 void test_item_item_iterator(void);
+void test_item_packed_object(void);
 void test_item_uri(void);
 
 void test_hdf_hdf(void);
@@ -0,0 +1,473 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2017-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <locale.h>
+#include <math.h>
+#include <string.h>
+
+#include <bson.h>
+
+static gdouble opt_threshold = 5.0;
+static gboolean opt_all = FALSE;
+
+/**
+ * The result of a single benchmark as written by julea-benchmark --json.
+ **/
+struct CompareResult
+{
+	gchar* name;
+
+	gdouble operations_per_second;
+	gdouble bytes_per_second;
+
+	/**
+	 * Statistics of the per-iteration (or per-operation) latencies in seconds.
+	 **/
+	gint64 count;
+	gdouble mean;
+	gdouble stddev;
+};
+
+typedef struct CompareResult CompareResult;
+
+/**
+ * A benchmark run as written by julea-benchmark --json.
+ **/
+struct CompareRun
+{
+	bson_t* document;
+
+	/**
+	 * The results in the order they have been written.
+	 **/
+	GPtrArray* results;
+	GHashTable* results_by_name;
+};
+
+typedef struct CompareRun CompareRun;
+
+/**
+ * Two-sided critical values of Student's t-distribution for a confidence of 95%, indexed by the degrees of freedom minus one.
+ **/
+static gdouble const compare_t_critical[] = {
+	12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+	2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+	2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+static gdouble
+compare_get_t_critical(gdouble degrees_of_freedom)
+{
+	guint index;
+
+	if (degrees_of_freedom < 1.0)
+	{
+		return compare_t_critical[0];
+	}
+
+	index = (guint)degrees_of_freedom - 1;
+
+	if (index < G_N_ELEMENTS(compare_t_critical))
+	{
+		return compare_t_critical[index];
+	}
+
+	if (degrees_of_freedom <= 60.0)
+	{
+		return 2.000;
+	}
+
+	if (degrees_of_freedom <= 120.0)
+	{
+		return 1.980;
+	}
+
+	return 1.960;
+}
+
+static void
+compare_result_free(gpointer data)
+{
+	CompareResult* result = data;
+
+	g_free(result->name);
+	g_free(result);
+}
+
+static void
+compare_run_free(CompareRun* run)
+{
+	if (run == NULL)
+	{
+		return;
+	}
+
+	g_hash_table_unref(run->results_by_name);
+	g_ptr_array_unref(run->results);
+	bson_destroy(run->document);
+	g_free(run);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(CompareRun, compare_run_free)
+
+/**
+ * Returns a numeric field, JSON does not distinguish between integers and floating-point numbers.
+ **/
+static gdouble
+compare_get_number(bson_t const* document, gchar const* path)
+{
+	bson_iter_t iter;
+	bson_iter_t field;
+
+	if (!bson_iter_init(&iter, document) || !bson_iter_find_descendant(&iter, path, &field))
+	{
+		return 0.0;
+	}
+
+	if (BSON_ITER_HOLDS_DOUBLE(&field))
+	{
+		return bson_iter_double(&field);
+	}
+	else if (BSON_ITER_HOLDS_INT32(&field))
+	{
+		return bson_iter_int32(&field);
+	}
+	else if (BSON_ITER_HOLDS_INT64(&field))
+	{
+		return bson_iter_int64(&field);
+	}
+
+	return 0.0;
+}
+
+static gchar const*
+compare_get_string(bson_t const* document, gchar const* path)
+{
+	bson_iter_t iter;
+	bson_iter_t field;
+
+	if (!bson_iter_init(&iter, document) || !bson_iter_find_descendant(&iter, path, &field) || !BSON_ITER_HOLDS_UTF8(&field))
+	{
+		return "unknown";
+	}
+
+	return bson_iter_utf8(&field, NULL);
+}
+
+/**
+ * Loads a benchmark run.
+ *
+ * \param path The path of a file written by julea-benchmark --json.
+ *
+ * \return The run or NULL on failure.
+ **/
+static CompareRun*
+compare_run_load(gchar const* path)
+{
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar* json = NULL;
+	CompareRun* run;
+	bson_error_t bson_error;
+	bson_iter_t iter;
+	bson_iter_t results;
+	gsize length;
+
+	if (!g_file_get_contents(path, &json, &length, &error))
+	{
+		g_printerr("Error: %s\n", error->message);
+
+		return NULL;
+	}
+
+	run = g_new(CompareRun, 1);
+	run->results = g_ptr_array_new_with_free_func(compare_result_free);
+	run->results_by_name = g_hash_table_new(g_str_hash, g_str_equal);
+	run->document = bson_new_from_json((uint8_t const*)json, length, &bson_error);
+
+	if (run->document == NULL)
+	{
+		g_printerr("Error: Could not parse %s: %s\n", path, bson_error.message);
+		run->document = bson_new();
+		compare_run_free(run);
+
+		return NULL;
+	}
+
+	if (compare_get_number(run->document, "format") < 1.0 || compare_get_number(run->document, "format") > 1.0)
+	{
+		g_printerr("Error: %s has an unsupported format\n", path);
+		compare_run_free(run);
+
+		return NULL;
+	}
+
+	if (!bson_iter_init_find(&iter, run->document, "results") || !BSON_ITER_HOLDS_ARRAY(&iter) || !bson_iter_recurse(&iter, &results))
+	{
+		g_printerr("Error: %s does not contain results\n", path);
+		compare_run_free(run);
+
+		return NULL;
+	}
+
+	while (bson_iter_next(&results))
+	{
+		CompareResult* result;
+		bson_t entry;
+		uint8_t const* data;
+		uint32_t data_length;
+
+		if (!BSON_ITER_HOLDS_DOCUMENT(&results))
+		{
+			continue;
+		}
+
+		bson_iter_document(&results, &data_length, &data);
+
+		if (!bson_init_static(&entry, data, data_length))
+		{
+			continue;
+		}
+
+		result = g_new(CompareResult, 1);
+		result->name = g_strdup(compare_get_string(&entry, "name"));
+		result->operations_per_second = compare_get_number(&entry, "operations_per_second");
+		result->bytes_per_second = compare_get_number(&entry, "bytes_per_second");
+		result->count = compare_get_number(&entry, "latency.count");
+		result->mean = compare_get_number(&entry, "latency.mean");
+		result->stddev = compare_get_number(&entry, "latency.stddev");
+
+		g_ptr_array_add(run->results, result);
+		g_hash_table_insert(run->results_by_name, result->name, result);
+	}
+
+	return run;
+}
+
+static void
+compare_print_rate(CompareResult const* result)
+{
+	if (result->operations_per_second > 0.0)
+	{
+		g_print("%12.0f/s", result->operations_per_second);
+	}
+	else if (result->bytes_per_second > 0.0)
+	{
+		g_autofree gchar* size = NULL;
+
+		size = g_format_size((guint64)result->bytes_per_second);
+		g_print("%10s/s", size);
+	}
+	else
+	{
+		g_print("%14s", "-");
+	}
+}
+
+/**
+ * Compares a result against its baseline.
+ * Latencies are compared using Welch's t-test if both results contain enough samples, rates are compared otherwise.
+ *
+ * \param baseline    The baseline result.
+ * \param current     The current result.
+ * \param change      Returns the change in percent, positive values mean that the current result is slower.
+ * \param significant Returns whether the change is statistically significant.
+ * \param tested      Returns whether a significance test could be performed.
+ **/
+static void
+compare_result(CompareResult const* baseline, CompareResult const* current, gdouble* change, gboolean* significant, gboolean* tested)
+{
+	*change = 0.0;
+	*significant = FALSE;
+	*tested = FALSE;
+
+	if (baseline->count >= 2 && current->count >= 2 && baseline->mean > 0.0)
+	{
+		gdouble variance_baseline;
+		gdouble variance_current;
+		gdouble standard_error;
+
+		*change = (current->mean - baseline->mean) / baseline->mean * 100.0;
+		*tested = TRUE;
+
+		variance_baseline = baseline->stddev * baseline->stddev / baseline->count;
+		variance_current = current->stddev * current->stddev / current->count;
+		standard_error = sqrt(variance_baseline + variance_current);
+
+		if (standard_error > 0.0)
+		{
+			gdouble t;
+			gdouble degrees_of_freedom;
+
+			t = (current->mean - baseline->mean) / standard_error;
+			degrees_of_freedom = pow(variance_baseline + variance_current, 2.0) / ((variance_baseline * variance_baseline / (baseline->count - 1)) + (variance_current * variance_current / (current->count - 1)));
+
+			*significant = (fabs(t) > compare_get_t_critical(degrees_of_freedom));
+		}
+		else
+		{
+			// Without any variance, every difference is significant.
+			*significant = TRUE;
+		}
+	}
+	else if (baseline->operations_per_second > 0.0)
+	{
+		*change = (baseline->operations_per_second - current->operations_per_second) / baseline->operations_per_second * 100.0;
+		*significant = TRUE;
+	}
+	else if (baseline->bytes_per_second > 0.0)
+	{
+		*change = (baseline->bytes_per_second - current->bytes_per_second) / baseline->bytes_per_second * 100.0;
+		*significant = TRUE;
+	}
+}
+
+static void
+compare_print_info(CompareRun const* baseline, CompareRun const* current, gchar const* path)
+{
+	gchar const* value_baseline;
+	gchar const* value_current;
+
+	value_baseline = compare_get_string(baseline->document, path);
+	value_current = compare_get_string(current->document, path);
+
+	g_print("%-20s %s", path, value_baseline);
+
+	if (g_strcmp0(value_baseline, value_current) != 0)
+	{
+		g_print(" -> %s (differs)", value_current);
+	}
+
+	g_print("\n");
+}
+
+int
+main(int argc, char** argv)
+{
+	GError* error = NULL;
+	g_autoptr(GOptionContext) context = NULL;
+	g_autoptr(CompareRun) baseline = NULL;
+	g_autoptr(CompareRun) current = NULL;
+	guint regressions = 0;
+	guint improvements = 0;
+	guint missing = 0;
+	gsize name_max = 4;
+
+	GOptionEntry entries[] = {
+		{ "threshold", 't', 0, G_OPTION_ARG_DOUBLE, &opt_threshold, "Minimum change in percent to report", "5" },
+		{ "all", 'a', 0, G_OPTION_ARG_NONE, &opt_all, "Also print unchanged results", NULL },
+		{ NULL, 0, 0, 0, NULL, NULL, NULL }
+	};
+
+	// Explicitly enable UTF-8 since functions such as g_format_size might return UTF-8 characters.
+	setlocale(LC_ALL, "C.UTF-8");
+
+	context = g_option_context_new("BASELINE CURRENT");
+	g_option_context_set_summary(context, "Compares two result files written by julea-benchmark --json.\nLatency changes are only reported if they are statistically significant with a confidence of 95%, rates are compared if there are too few samples.\nExits with status 2 if there are regressions.");
+	g_option_context_add_main_entries(context, entries, NULL);
+
+	if (!g_option_context_parse(context, &argc, &argv, &error))
+	{
+		if (error)
+		{
+			g_printerr("%s\n", error->message);
+			g_error_free(error);
+		}
+
+		return 1;
+	}
+
+	if (argc != 3 || opt_threshold < 0.0)
+	{
+		g_autofree gchar* help = NULL;
+
+		help = g_option_context_get_help(context, TRUE, NULL);
+
+		g_print("%s", help);
+
+		return 1;
+	}
+
+	if ((baseline = compare_run_load(argv[1])) == NULL || (current = compare_run_load(argv[2])) == NULL)
+	{
+		return 1;
+	}
+
+	compare_print_info(baseline, current, "time");
+	compare_print_info(baseline, current, "build.version");
+	compare_print_info(baseline, current, "build.buildtype");
+	compare_print_info(baseline, current, "build.compiler");
+	compare_print_info(baseline, current, "host.name");
+	compare_print_info(baseline, current, "host.release");
+	g_print("\n");
+
+	for (guint i = 0; i < current->results->len; i++)
+	{
+		CompareResult const* result = g_ptr_array_index(current->results, i);
+
+		name_max = MAX(name_max, strlen(result->name));
+	}
+
+	g_print("%-*s %14s %14s %9s\n", (gint)name_max, "Name", "Baseline", "Current", "Change");
+
+	for (guint i = 0; i < current->results->len; i++)
+	{
+		CompareResult const* result = g_ptr_array_index(current->results, i);
+		CompareResult const* result_baseline;
+		gchar const* verdict = "unchanged";
+		gdouble change;
+		gboolean significant;
+		gboolean tested;
+
+		if ((result_baseline = g_hash_table_lookup(baseline->results_by_name, result->name)) == NULL)
+		{
+			missing++;
+			continue;
+		}
+
+		compare_result(result_baseline, result, &change, &significant, &tested);
+
+		if (significant && change > opt_threshold)
+		{
+			verdict = "regression";
+			regressions++;
+		}
+		else if (significant && change < -opt_threshold)
+		{
+			verdict = "improvement";
+			improvements++;
+		}
+		else if (!opt_all)
+		{
+			continue;
+		}
+
+		g_print("%-*s ", (gint)name_max, result->name);
+		compare_print_rate(result_baseline);
+		g_print(" ");
+		compare_print_rate(result);
+		g_print(" %+8.1f%% %s%s\n", change, verdict, (tested) ? "" : " (untested)");
+	}
+
+	g_print("\n%u regression(s), %u improvement(s), %u result(s) without baseline\n", regressions, improvements, missing);
+
+	return (regressions > 0) ? 2 : 0;
+}
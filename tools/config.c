@@ -32,18 +32,54 @@ static gchar const* opt_name = "julea";
 static gchar const* opt_servers_object = NULL;
 static gchar const* opt_servers_kv = NULL;
 static gchar const* opt_servers_db = NULL;
+static gchar const* opt_servers_object_locality = NULL;
+static gchar const* opt_servers_kv_locality = NULL;
+static gchar const* opt_servers_db_locality = NULL;
+static gchar const* opt_servers_kv_replicas = NULL;
+static gchar const* opt_servers_db_replicas = NULL;
+static gchar const* opt_locality = NULL;
 static gchar const* opt_object_backend = NULL;
 static gchar const* opt_object_component = NULL;
 static gchar const* opt_object_path = NULL;
+static gchar const* opt_object_local_backend = NULL;
+static gchar const* opt_object_local_path = NULL;
+static gint64 opt_burst_buffer_size = 0;
+static gint64 opt_burst_buffer_bandwidth = 0;
+static gchar const* opt_object_cold_backend = NULL;
+static gchar const* opt_object_cold_path = NULL;
+static gint opt_object_cold_after = 0;
+static gchar const* opt_object_wal_path = NULL;
 static gchar const* opt_kv_backend = NULL;
 static gchar const* opt_kv_component = NULL;
 static gchar const* opt_kv_path = NULL;
+static gchar const* opt_kv_local_backend = NULL;
+static gchar const* opt_kv_local_path = NULL;
+static gchar const* opt_kv_local_namespaces = NULL;
 static gchar const* opt_db_backend = NULL;
 static gchar const* opt_db_component = NULL;
 static gchar const* opt_db_path = NULL;
 static gint64 opt_max_operation_size = 0;
+static gint64 opt_max_receive_size = 0;
+static gboolean opt_receive_hugepages = FALSE;
 static gint opt_max_connections = 0;
 static gint64 opt_stripe_size = 0;
+static gchar const* opt_compression = NULL;
+static gint opt_max_connections_object = 0;
+static gint opt_max_connections_kv = 0;
+static gint opt_max_connections_db = 0;
+static gboolean opt_adaptive_connections = FALSE;
+static gboolean opt_consistent_hashing = FALSE;
+static gboolean opt_object_lazy_create = FALSE;
+static gboolean opt_object_checksums = FALSE;
+static gboolean opt_object_dedup = FALSE;
+static gint opt_warm_up_connections = 0;
+static gint opt_health_check_interval = 0;
+static gint opt_retries = 0;
+static gint opt_retry_delay = 0;
+static gboolean opt_hedged_reads = FALSE;
+static gboolean opt_compact_messages = FALSE;
+static gint64 opt_block_cache_size = 0;
+static gboolean opt_resolve = FALSE;
 
 static gchar**
 string_split(gchar const* string)
@@ -63,6 +99,53 @@ string_split(gchar const* string)
 	return arr;
 }
 
+/**
+ * Stores the servers' addresses, so that clients do not have to resolve their host names.
+ **/
+static gboolean
+resolve_servers(GKeyFile* key_file, gchar** servers)
+{
+	GResolver* resolver;
+
+	resolver = g_resolver_get_default();
+
+	for (guint i = 0; servers[i] != NULL; i++)
+	{
+		g_autoptr(GSocketConnectable) address = NULL;
+		g_autoptr(GError) error = NULL;
+		g_autofree gchar* address_string = NULL;
+		GList* addresses;
+		gchar const* hostname;
+
+		if ((address = g_network_address_parse(servers[i], 4711, NULL)) == NULL)
+		{
+			continue;
+		}
+
+		hostname = g_network_address_get_hostname(G_NETWORK_ADDRESS(address));
+
+		if (g_key_file_has_key(key_file, "addresses", hostname, NULL))
+		{
+			continue;
+		}
+
+		if ((addresses = g_resolver_lookup_by_name(resolver, hostname, NULL, &error)) == NULL)
+		{
+			g_printerr("Can not resolve %s: %s\n", hostname, error->message);
+			g_object_unref(resolver);
+			return FALSE;
+		}
+
+		address_string = g_inet_address_to_string(addresses->data);
+		g_key_file_set_string(key_file, "addresses", hostname, address_string);
+		g_resolver_free_addresses(addresses);
+	}
+
+	g_object_unref(resolver);
+
+	return TRUE;
+}
+
 static gboolean
 read_config(gchar* path)
 {
@@ -98,27 +181,142 @@ write_config(gchar* path)
 	g_auto(GStrv) servers_object = NULL;
 	g_auto(GStrv) servers_kv = NULL;
 	g_auto(GStrv) servers_db = NULL;
+	g_auto(GStrv) servers_kv_replicas = NULL;
+	g_auto(GStrv) servers_db_replicas = NULL;
 
 	servers_object = string_split(opt_servers_object);
 	servers_kv = string_split(opt_servers_kv);
 	servers_db = string_split(opt_servers_db);
+	servers_kv_replicas = string_split((opt_servers_kv_replicas != NULL) ? opt_servers_kv_replicas : "");
+	servers_db_replicas = string_split((opt_servers_db_replicas != NULL) ? opt_servers_db_replicas : "");
 
 	key_file = g_key_file_new();
 	g_key_file_set_int64(key_file, "core", "max-operation-size", opt_stripe_size);
+	g_key_file_set_int64(key_file, "core", "max-receive-size", opt_max_receive_size);
+	g_key_file_set_boolean(key_file, "core", "receive-hugepages", opt_receive_hugepages);
 	g_key_file_set_integer(key_file, "clients", "max-connections", opt_max_connections);
 	g_key_file_set_int64(key_file, "clients", "stripe-size", opt_stripe_size);
+	g_key_file_set_integer(key_file, "clients", "max-connections-object", opt_max_connections_object);
+	g_key_file_set_integer(key_file, "clients", "max-connections-kv", opt_max_connections_kv);
+	g_key_file_set_integer(key_file, "clients", "max-connections-db", opt_max_connections_db);
+	g_key_file_set_boolean(key_file, "clients", "adaptive-connections", opt_adaptive_connections);
+	g_key_file_set_boolean(key_file, "clients", "consistent-hashing", opt_consistent_hashing);
+	g_key_file_set_integer(key_file, "clients", "warm-up-connections", opt_warm_up_connections);
+	g_key_file_set_integer(key_file, "clients", "health-check-interval", opt_health_check_interval);
+	g_key_file_set_integer(key_file, "clients", "retries", opt_retries);
+	g_key_file_set_integer(key_file, "clients", "retry-delay", opt_retry_delay);
+	g_key_file_set_boolean(key_file, "clients", "hedged-reads", opt_hedged_reads);
+	g_key_file_set_boolean(key_file, "clients", "compact-messages", opt_compact_messages);
+	g_key_file_set_int64(key_file, "clients", "block-cache-size", opt_block_cache_size);
+
+	if (opt_locality != NULL)
+	{
+		g_key_file_set_string(key_file, "clients", "locality", opt_locality);
+	}
+
+	if (opt_compression != NULL)
+	{
+		g_key_file_set_string(key_file, "clients", "compression", opt_compression);
+	}
+
 	g_key_file_set_string_list(key_file, "servers", "object", (gchar const* const*)servers_object, g_strv_length(servers_object));
 	g_key_file_set_string_list(key_file, "servers", "kv", (gchar const* const*)servers_kv, g_strv_length(servers_kv));
 	g_key_file_set_string_list(key_file, "servers", "db", (gchar const* const*)servers_db, g_strv_length(servers_db));
+
+	if (opt_servers_object_locality != NULL)
+	{
+		g_auto(GStrv) servers_object_locality = string_split(opt_servers_object_locality);
+		g_key_file_set_string_list(key_file, "servers", "object-locality", (gchar const* const*)servers_object_locality, g_strv_length(servers_object_locality));
+	}
+
+	if (opt_servers_kv_locality != NULL)
+	{
+		g_auto(GStrv) servers_kv_locality = string_split(opt_servers_kv_locality);
+		g_key_file_set_string_list(key_file, "servers", "kv-locality", (gchar const* const*)servers_kv_locality, g_strv_length(servers_kv_locality));
+	}
+
+	if (opt_servers_db_locality != NULL)
+	{
+		g_auto(GStrv) servers_db_locality = string_split(opt_servers_db_locality);
+		g_key_file_set_string_list(key_file, "servers", "db-locality", (gchar const* const*)servers_db_locality, g_strv_length(servers_db_locality));
+	}
+
+	if (opt_servers_kv_replicas != NULL)
+	{
+		g_key_file_set_string_list(key_file, "servers", "kv-replicas", (gchar const* const*)servers_kv_replicas, g_strv_length(servers_kv_replicas));
+	}
+
+	if (opt_servers_db_replicas != NULL)
+	{
+		g_key_file_set_string_list(key_file, "servers", "db-replicas", (gchar const* const*)servers_db_replicas, g_strv_length(servers_db_replicas));
+	}
+
 	g_key_file_set_string(key_file, "object", "backend", opt_object_backend);
 	g_key_file_set_string(key_file, "object", "component", opt_object_component);
 	g_key_file_set_string(key_file, "object", "path", opt_object_path);
+	g_key_file_set_boolean(key_file, "object", "lazy-create", opt_object_lazy_create);
+	g_key_file_set_boolean(key_file, "object", "checksums", opt_object_checksums);
+	g_key_file_set_boolean(key_file, "object", "dedup", opt_object_dedup);
+
+	if (opt_object_local_backend != NULL)
+	{
+		g_key_file_set_string(key_file, "object", "local-backend", opt_object_local_backend);
+	}
+
+	if (opt_object_local_path != NULL)
+	{
+		g_key_file_set_string(key_file, "object", "local-path", opt_object_local_path);
+	}
+
+	g_key_file_set_int64(key_file, "object", "burst-buffer-size", opt_burst_buffer_size);
+	g_key_file_set_int64(key_file, "object", "burst-buffer-bandwidth", opt_burst_buffer_bandwidth);
+
+	if (opt_object_cold_backend != NULL)
+	{
+		g_key_file_set_string(key_file, "object", "cold-backend", opt_object_cold_backend);
+	}
+
+	if (opt_object_cold_path != NULL)
+	{
+		g_key_file_set_string(key_file, "object", "cold-path", opt_object_cold_path);
+	}
+
+	g_key_file_set_integer(key_file, "object", "cold-after", opt_object_cold_after);
+
+	if (opt_object_wal_path != NULL)
+	{
+		g_key_file_set_string(key_file, "object", "wal-path", opt_object_wal_path);
+	}
+
 	g_key_file_set_string(key_file, "kv", "backend", opt_kv_backend);
 	g_key_file_set_string(key_file, "kv", "component", opt_kv_component);
 	g_key_file_set_string(key_file, "kv", "path", opt_kv_path);
+
+	if (opt_kv_local_backend != NULL)
+	{
+		g_key_file_set_string(key_file, "kv", "local-backend", opt_kv_local_backend);
+	}
+
+	if (opt_kv_local_path != NULL)
+	{
+		g_key_file_set_string(key_file, "kv", "local-path", opt_kv_local_path);
+	}
+
+	if (opt_kv_local_namespaces != NULL)
+	{
+		g_auto(GStrv) kv_local_namespaces = string_split(opt_kv_local_namespaces);
+		g_key_file_set_string_list(key_file, "kv", "local-namespaces", (gchar const* const*)kv_local_namespaces, g_strv_length(kv_local_namespaces));
+	}
+
 	g_key_file_set_string(key_file, "db", "backend", opt_db_backend);
 	g_key_file_set_string(key_file, "db", "component", opt_db_component);
 	g_key_file_set_string(key_file, "db", "path", opt_db_path);
+
+	if (opt_resolve && !(resolve_servers(key_file, servers_object) && resolve_servers(key_file, servers_kv) && resolve_servers(key_file, servers_db) && resolve_servers(key_file, servers_kv_replicas) && resolve_servers(key_file, servers_db_replicas)))
+	{
+		return FALSE;
+	}
+
 	key_file_data = g_key_file_to_data(key_file, &key_file_data_len, NULL);
 
 	if (path != NULL)
@@ -155,18 +353,54 @@ main(gint argc, gchar** argv)
 		{ "object-servers", 0, 0, G_OPTION_ARG_STRING, &opt_servers_object, "Object servers to use", "host1,host2:port" },
 		{ "kv-servers", 0, 0, G_OPTION_ARG_STRING, &opt_servers_kv, "Key-value servers to use", "host1,host2:port" },
 		{ "db-servers", 0, 0, G_OPTION_ARG_STRING, &opt_servers_db, "Database servers to use", "host1,host2:port" },
+		{ "object-servers-locality", 0, 0, G_OPTION_ARG_STRING, &opt_servers_object_locality, "Locality labels of the object servers", "pod1/rack1,pod1/rack2" },
+		{ "kv-servers-locality", 0, 0, G_OPTION_ARG_STRING, &opt_servers_kv_locality, "Locality labels of the key-value servers", "pod1/rack1,pod1/rack2" },
+		{ "db-servers-locality", 0, 0, G_OPTION_ARG_STRING, &opt_servers_db_locality, "Locality labels of the database servers", "pod1/rack1,pod1/rack2" },
+		{ "kv-replicas", 0, 0, G_OPTION_ARG_STRING, &opt_servers_kv_replicas, "Key-value servers replicating the key-value servers", "host3,host4:port" },
+		{ "db-replicas", 0, 0, G_OPTION_ARG_STRING, &opt_servers_db_replicas, "Database servers replicating the database servers", "host3,host4:port" },
+		{ "locality", 0, 0, G_OPTION_ARG_STRING, &opt_locality, "Locality label of the clients", "pod1/rack1" },
 		{ "object-backend", 0, 0, G_OPTION_ARG_STRING, &opt_object_backend, "Object backend to use", "posix|null|gio|…" },
 		{ "object-component", 0, 0, G_OPTION_ARG_STRING, &opt_object_component, "Object component to use", "client|server" },
 		{ "object-path", 0, 0, G_OPTION_ARG_STRING, &opt_object_path, "Object path to use", "/path/to/storage" },
+		{ "object-lazy-create", 0, 0, G_OPTION_ARG_NONE, &opt_object_lazy_create, "Create the parts of distributed objects on their first write", NULL },
+		{ "object-checksums", 0, 0, G_OPTION_ARG_NONE, &opt_object_checksums, "Protect object data with CRC32C checksums", NULL },
+		{ "object-dedup", 0, 0, G_OPTION_ARG_NONE, &opt_object_dedup, "Deduplicate identical blocks of objects", NULL },
+		{ "object-local-backend", 0, 0, G_OPTION_ARG_STRING, &opt_object_local_backend, "Object backend to use for the node-local burst buffer", "memory|posix|…" },
+		{ "object-local-path", 0, 0, G_OPTION_ARG_STRING, &opt_object_local_path, "Object path to use for the node-local burst buffer", "/path/to/storage" },
+		{ "burst-buffer-size", 0, 0, G_OPTION_ARG_INT64, &opt_burst_buffer_size, "Capacity of the node-local burst buffer", "0" },
+		{ "burst-buffer-bandwidth", 0, 0, G_OPTION_ARG_INT64, &opt_burst_buffer_bandwidth, "Bandwidth for draining the burst buffer in bytes per second", "0" },
+		{ "object-cold-backend", 0, 0, G_OPTION_ARG_STRING, &opt_object_cold_backend, "Object backend to use as the servers' cold tier", "posix|rados|…" },
+		{ "object-cold-path", 0, 0, G_OPTION_ARG_STRING, &opt_object_cold_path, "Object path to use for the servers' cold tier", "/path/to/storage" },
+		{ "object-cold-after", 0, 0, G_OPTION_ARG_INT, &opt_object_cold_after, "Seconds after which unused objects are moved to the cold tier (0 for one hour)", "0" },
+		{ "object-wal-path", 0, 0, G_OPTION_ARG_STRING, &opt_object_wal_path, "Directory for the servers' write-ahead log, ideally on a fast device", "/path/to/log" },
 		{ "kv-backend", 0, 0, G_OPTION_ARG_STRING, &opt_kv_backend, "Key-value backend to use", "posix|null|gio|…" },
 		{ "kv-component", 0, 0, G_OPTION_ARG_STRING, &opt_kv_component, "Key-value component to use", "client|server" },
 		{ "kv-path", 0, 0, G_OPTION_ARG_STRING, &opt_kv_path, "Key-value path to use", "/path/to/storage" },
+		{ "kv-local-backend", 0, 0, G_OPTION_ARG_STRING, &opt_kv_local_backend, "Key-value backend to use for node-local namespaces", "memory|lmdb|…" },
+		{ "kv-local-path", 0, 0, G_OPTION_ARG_STRING, &opt_kv_local_path, "Key-value path to use for node-local namespaces", "/path/to/storage" },
+		{ "kv-local-namespaces", 0, 0, G_OPTION_ARG_STRING, &opt_kv_local_namespaces, "Key-value namespaces that are node-local", "scratch,tmp-*" },
 		{ "db-backend", 0, 0, G_OPTION_ARG_STRING, &opt_db_backend, "Database backend to use", "sqlite|null|…" },
 		{ "db-component", 0, 0, G_OPTION_ARG_STRING, &opt_db_component, "Database component to use", "client|server" },
 		{ "db-path", 0, 0, G_OPTION_ARG_STRING, &opt_db_path, "Database path to use", "/path/to/storage" },
 		{ "max-operation-size", 0, 0, G_OPTION_ARG_INT64, &opt_max_operation_size, "Maximum size of an operation", "0" },
+		{ "max-receive-size", 0, 0, G_OPTION_ARG_INT64, &opt_max_receive_size, "Maximum memory per server connection for receiving a message", "0" },
+		{ "receive-hugepages", 0, 0, G_OPTION_ARG_NONE, &opt_receive_hugepages, "Back the servers' receive buffers with huge pages", NULL },
 		{ "max-connections", 0, 0, G_OPTION_ARG_INT, &opt_max_connections, "Maximum number of connections", "0" },
 		{ "stripe-size", 0, 0, G_OPTION_ARG_INT64, &opt_stripe_size, "Default stripe size", "0" },
+		{ "max-connections-object", 0, 0, G_OPTION_ARG_INT, &opt_max_connections_object, "Maximum number of connections per object server", "0" },
+		{ "max-connections-kv", 0, 0, G_OPTION_ARG_INT, &opt_max_connections_kv, "Maximum number of connections per key-value server", "0" },
+		{ "max-connections-db", 0, 0, G_OPTION_ARG_INT, &opt_max_connections_db, "Maximum number of connections per database server", "0" },
+		{ "adaptive-connections", 0, 0, G_OPTION_ARG_NONE, &opt_adaptive_connections, "Adapt the number of object connections to the servers' service times", NULL },
+		{ "consistent-hashing", 0, 0, G_OPTION_ARG_NONE, &opt_consistent_hashing, "Place key-value pairs using consistent hashing", NULL },
+		{ "warm-up-connections", 0, 0, G_OPTION_ARG_INT, &opt_warm_up_connections, "Number of connections per server to establish at startup", "0" },
+		{ "health-check-interval", 0, 0, G_OPTION_ARG_INT, &opt_health_check_interval, "Interval for checking idle connections in seconds", "0" },
+		{ "retries", 0, 0, G_OPTION_ARG_INT, &opt_retries, "Number of retries for idempotent requests after network errors", "0" },
+		{ "retry-delay", 0, 0, G_OPTION_ARG_INT, &opt_retry_delay, "Delay before the first retry in milliseconds", "0" },
+		{ "hedged-reads", 0, 0, G_OPTION_ARG_NONE, &opt_hedged_reads, "Send reads of replicated blocks to a second copy if the first one is slow", NULL },
+		{ "block-cache-size", 0, 0, G_OPTION_ARG_INT64, &opt_block_cache_size, "Size of the client-side block cache", "0" },
+		{ "resolve", 0, 0, G_OPTION_ARG_NONE, &opt_resolve, "Store the servers' resolved addresses", NULL },
+		{ "compression", 0, 0, G_OPTION_ARG_STRING, &opt_compression, "Message compression to request", "lz4|zstd" },
+		{ "compact-messages", 0, 0, G_OPTION_ARG_NONE, &opt_compact_messages, "Encode object reads and writes compactly", NULL },
 		{ NULL, 0, 0, 0, NULL, NULL, NULL }
 	};
 
@@ -192,7 +426,20 @@ main(gint argc, gchar** argv)
 	    || (opt_read && !opt_user && !opt_system)
 	    || (!opt_read && (opt_servers_object == NULL || opt_servers_kv == NULL || opt_servers_db == NULL || opt_object_backend == NULL || opt_object_component == NULL || opt_object_path == NULL || opt_kv_backend == NULL || opt_kv_component == NULL || opt_kv_path == NULL || opt_db_backend == NULL || opt_db_component == NULL || opt_db_path == NULL))
 	    || opt_max_operation_size < 0
+	    || opt_max_receive_size < 0
 	    || opt_max_connections < 0
+	    || opt_max_connections_object < 0
+	    || opt_max_connections_kv < 0
+	    || opt_max_connections_db < 0
+	    || opt_warm_up_connections < 0
+	    || opt_health_check_interval < 0
+	    || opt_retries < 0
+	    || opt_retry_delay < 0
+	    || opt_block_cache_size < 0
+	    || opt_burst_buffer_size < 0
+	    || opt_burst_buffer_bandwidth < 0
+	    || opt_object_cold_after < 0
+	    || ((opt_object_cold_backend == NULL) != (opt_object_cold_path == NULL))
 	    || opt_stripe_size < 0)
 	{
 		g_autofree gchar* help = NULL;
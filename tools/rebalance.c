@@ -0,0 +1,377 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <locale.h>
+#include <string.h>
+
+#include <julea.h>
+#include <julea-kv.h>
+#include <julea-object.h>
+
+/**
+ * A single object or key-value pair that has to be moved.
+ **/
+struct RebalanceTask
+{
+	JBackendType type;
+	gchar* namespace;
+	gchar* name;
+	guint32 from;
+	guint32 to;
+};
+
+typedef struct RebalanceTask RebalanceTask;
+
+static gchar** opt_namespaces = NULL;
+static gboolean opt_object = FALSE;
+static gboolean opt_kv = FALSE;
+static gint opt_threads = 4;
+static gint opt_bandwidth = 0;
+static gint64 opt_chunk_size = 4 * 1024 * 1024;
+static gboolean opt_dry_run = FALSE;
+
+static GMutex rebalance_mutex;
+static gint64 rebalance_start = 0;
+static guint64 rebalance_bytes = 0;
+static guint rebalance_moved = 0;
+static guint rebalance_failed = 0;
+
+static void
+rebalance_task_free(RebalanceTask* task)
+{
+	g_free(task->namespace);
+	g_free(task->name);
+
+	g_slice_free(RebalanceTask, task);
+}
+
+/**
+ * Accounts for transferred bytes and sleeps if the configured bandwidth has been exceeded.
+ *
+ * \param bytes The number of bytes that are about to be transferred.
+ **/
+static void
+rebalance_throttle(guint64 bytes)
+{
+	gint64 elapsed;
+	gint64 expected;
+
+	if (opt_bandwidth == 0)
+	{
+		return;
+	}
+
+	g_mutex_lock(&rebalance_mutex);
+
+	rebalance_bytes += bytes;
+	elapsed = g_get_monotonic_time() - rebalance_start;
+	// The time in microseconds it should have taken to transfer all bytes at the configured bandwidth.
+	expected = (gdouble)rebalance_bytes / (opt_bandwidth * 1024.0 * 1024.0) * G_USEC_PER_SEC;
+
+	g_mutex_unlock(&rebalance_mutex);
+
+	if (expected > elapsed)
+	{
+		g_usleep(expected - elapsed);
+	}
+}
+
+static gboolean
+rebalance_object(RebalanceTask* task)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) source = NULL;
+	g_autoptr(JObject) destination = NULL;
+	g_autofree gchar* buffer = NULL;
+	gint64 modification_time;
+	guint64 size;
+	guint64 offset;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	source = j_object_new_for_index(task->from, task->namespace, task->name);
+	destination = j_object_new_for_index(task->to, task->namespace, task->name);
+
+	j_object_status(source, &modification_time, &size, batch);
+	j_object_create(destination, batch);
+
+	if (!j_batch_execute(batch))
+	{
+		return FALSE;
+	}
+
+	buffer = g_malloc(opt_chunk_size);
+
+	// Stream the object in chunks so that large objects do not have to be held in memory.
+	for (offset = 0; offset < size; offset += opt_chunk_size)
+	{
+		guint64 length;
+		guint64 bytes_read = 0;
+		guint64 bytes_written = 0;
+
+		length = MIN((guint64)opt_chunk_size, size - offset);
+
+		rebalance_throttle(length);
+
+		j_object_read(source, buffer, length, offset, &bytes_read, batch);
+
+		if (!j_batch_execute(batch) || bytes_read != length)
+		{
+			return FALSE;
+		}
+
+		j_object_write(destination, buffer, length, offset, &bytes_written, batch);
+
+		if (!j_batch_execute(batch) || bytes_written != length)
+		{
+			return FALSE;
+		}
+	}
+
+	j_object_sync(destination, batch);
+	j_object_delete(source, batch);
+
+	return j_batch_execute(batch);
+}
+
+static gboolean
+rebalance_kv(RebalanceTask* task)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JKV) source = NULL;
+	g_autoptr(JKV) destination = NULL;
+	gpointer value = NULL;
+	guint32 length = 0;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	source = j_kv_new_for_index(task->from, task->namespace, task->name);
+	destination = j_kv_new_for_index(task->to, task->namespace, task->name);
+
+	j_kv_get(source, &value, &length, batch);
+
+	if (!j_batch_execute(batch))
+	{
+		return FALSE;
+	}
+
+	rebalance_throttle(length);
+
+	// The batch takes ownership of value.
+	j_kv_put(destination, value, length, g_free, batch);
+	j_kv_delete(source, batch);
+
+	return j_batch_execute(batch);
+}
+
+static void
+rebalance_worker(gpointer data, gpointer user_data)
+{
+	RebalanceTask* task = data;
+	gboolean ret;
+
+	(void)user_data;
+
+	if (task->type == J_BACKEND_TYPE_OBJECT)
+	{
+		ret = rebalance_object(task);
+	}
+	else
+	{
+		ret = rebalance_kv(task);
+	}
+
+	g_mutex_lock(&rebalance_mutex);
+
+	if (ret)
+	{
+		rebalance_moved++;
+	}
+	else
+	{
+		rebalance_failed++;
+		g_printerr("Failed to move %s %s/%s from server %u to server %u\n", (task->type == J_BACKEND_TYPE_OBJECT) ? "object" : "key", task->namespace, task->name, task->from, task->to);
+	}
+
+	g_mutex_unlock(&rebalance_mutex);
+
+	rebalance_task_free(task);
+}
+
+/**
+ * Collects the objects or key-value pairs of a namespace that are stored on the wrong server.
+ *
+ * All names are collected before any data is moved, as moving data modifies the servers being iterated.
+ **/
+static void
+rebalance_collect(GPtrArray* tasks, JBackendType type, gchar const* namespace)
+{
+	JConfiguration* configuration = j_configuration();
+
+	for (guint32 i = 0; i < j_configuration_get_server_count(configuration, type); i++)
+	{
+		g_autoptr(JObjectIterator) object_iterator = NULL;
+		g_autoptr(JKVIterator) kv_iterator = NULL;
+
+		if (type == J_BACKEND_TYPE_OBJECT)
+		{
+			object_iterator = j_object_iterator_new_for_index(i, namespace, NULL);
+		}
+		else
+		{
+			kv_iterator = j_kv_iterator_new_for_index(i, namespace, NULL);
+		}
+
+		while ((object_iterator != NULL) ? j_object_iterator_next(object_iterator) : j_kv_iterator_next(kv_iterator))
+		{
+			RebalanceTask* task;
+			gchar const* name;
+			guint32 to;
+
+			if (object_iterator != NULL)
+			{
+				name = j_object_iterator_get(object_iterator);
+			}
+			else
+			{
+				gconstpointer value;
+				guint32 length;
+
+				name = j_kv_iterator_get(kv_iterator, &value, &length);
+			}
+
+			to = j_configuration_get_server_for_key(configuration, type, name);
+
+			if (to == i)
+			{
+				continue;
+			}
+
+			task = g_slice_new(RebalanceTask);
+			task->type = type;
+			task->namespace = g_strdup(namespace);
+			task->name = g_strdup(name);
+			task->from = i;
+			task->to = to;
+
+			g_ptr_array_add(tasks, task);
+		}
+	}
+}
+
+gint
+main(gint argc, gchar** argv)
+{
+	GError* error = NULL;
+	g_autoptr(GOptionContext) context = NULL;
+	g_autoptr(GPtrArray) tasks = NULL;
+	GThreadPool* pool;
+
+	GOptionEntry entries[] = {
+		{ "namespace", 'n', 0, G_OPTION_ARG_STRING_ARRAY, &opt_namespaces, "Namespace to rebalance (can be given multiple times)", "namespace" },
+		{ "object", 0, 0, G_OPTION_ARG_NONE, &opt_object, "Rebalance objects", NULL },
+		{ "kv", 0, 0, G_OPTION_ARG_NONE, &opt_kv, "Rebalance key-value pairs", NULL },
+		{ "threads", 't', 0, G_OPTION_ARG_INT, &opt_threads, "Number of parallel transfers", "4" },
+		{ "bandwidth", 'b', 0, G_OPTION_ARG_INT, &opt_bandwidth, "Maximum bandwidth in MiB/s (0 for unlimited)", "0" },
+		{ "chunk-size", 0, 0, G_OPTION_ARG_INT64, &opt_chunk_size, "Size of the chunks used for streaming objects", "4194304" },
+		{ "dry-run", 0, 0, G_OPTION_ARG_NONE, &opt_dry_run, "Only print what would be moved", NULL },
+		{ NULL, 0, 0, 0, NULL, NULL, NULL }
+	};
+
+	// Explicitly enable UTF-8 since functions such as g_format_size might return UTF-8 characters.
+	setlocale(LC_ALL, "C.UTF-8");
+
+	context = g_option_context_new(NULL);
+	g_option_context_set_summary(context, "Moves objects and key-value pairs to the servers they belong on according to the current configuration.");
+	g_option_context_add_main_entries(context, entries, NULL);
+
+	if (!g_option_context_parse(context, &argc, &argv, &error))
+	{
+		if (error)
+		{
+			g_printerr("%s\n", error->message);
+			g_error_free(error);
+		}
+
+		return 1;
+	}
+
+	if (opt_namespaces == NULL
+	    || (!opt_object && !opt_kv)
+	    || opt_threads <= 0
+	    || opt_bandwidth < 0
+	    || opt_chunk_size <= 0)
+	{
+		g_autofree gchar* help = NULL;
+
+		help = g_option_context_get_help(context, TRUE, NULL);
+
+		g_print("%s", help);
+
+		return 1;
+	}
+
+	tasks = g_ptr_array_new();
+
+	for (guint i = 0; opt_namespaces[i] != NULL; i++)
+	{
+		if (opt_object)
+		{
+			rebalance_collect(tasks, J_BACKEND_TYPE_OBJECT, opt_namespaces[i]);
+		}
+
+		if (opt_kv)
+		{
+			rebalance_collect(tasks, J_BACKEND_TYPE_KV, opt_namespaces[i]);
+		}
+	}
+
+	if (opt_dry_run)
+	{
+		for (guint i = 0; i < tasks->len; i++)
+		{
+			RebalanceTask* task = g_ptr_array_index(tasks, i);
+
+			g_print("%s %s/%s: %u -> %u\n", (task->type == J_BACKEND_TYPE_OBJECT) ? "object" : "kv", task->namespace, task->name, task->from, task->to);
+			rebalance_task_free(task);
+		}
+
+		g_strfreev(opt_namespaces);
+
+		return 0;
+	}
+
+	rebalance_start = g_get_monotonic_time();
+	pool = g_thread_pool_new(rebalance_worker, NULL, opt_threads, TRUE, NULL);
+
+	for (guint i = 0; i < tasks->len; i++)
+	{
+		g_thread_pool_push(pool, g_ptr_array_index(tasks, i), NULL);
+	}
+
+	// Waits for all queued transfers to finish.
+	g_thread_pool_free(pool, FALSE, TRUE);
+
+	g_print("%u moved, %u failed\n", rebalance_moved, rebalance_failed);
+
+	g_strfreev(opt_namespaces);
+
+	return (rebalance_failed == 0) ? 0 : 1;
+}
@@ -28,6 +28,68 @@
 #include <jmessage.h>
 #include <jstatistics.h>
 
+static gint opt_interval = 0;
+static gint opt_count = 0;
+
+static JStatisticsType const statistics_types[] = {
+	J_STATISTICS_FILES_CREATED,
+	J_STATISTICS_FILES_DELETED,
+	J_STATISTICS_FILES_STATED,
+	J_STATISTICS_SYNC,
+	J_STATISTICS_BYTES_READ,
+	J_STATISTICS_BYTES_WRITTEN,
+	J_STATISTICS_BYTES_RECEIVED,
+	J_STATISTICS_BYTES_SENT,
+	J_STATISTICS_CONNECTIONS
+};
+
+/**
+ * Fetches the statistics of an object server and adds them to statistics.
+ **/
+static void
+fetch_statistics(guint index, JStatistics* statistics)
+{
+	g_autoptr(JMessage) message = NULL;
+	g_autoptr(JMessage) reply = NULL;
+	gpointer connection;
+	gchar get_all;
+
+	get_all = 1;
+
+	message = j_message_new(J_MESSAGE_STATISTICS, sizeof(gchar));
+	j_message_add_operation(message, 0);
+	j_message_append_1(message, &get_all);
+
+	connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, index);
+
+	j_message_send(message, connection);
+
+	reply = j_message_new_reply(message);
+	j_message_receive(reply, connection);
+
+	for (guint i = 0; i < G_N_ELEMENTS(statistics_types); i++)
+	{
+		j_statistics_add(statistics, statistics_types[i], j_message_get_8(reply));
+	}
+
+	for (guint t = 0; t < J_STATISTICS_MESSAGE_TYPES; t++)
+	{
+		j_statistics_add_message(statistics, t, J_STATISTICS_MESSAGE_REQUESTS, j_message_get_8(reply));
+		j_statistics_add_message(statistics, t, J_STATISTICS_MESSAGE_BYTES, j_message_get_8(reply));
+		j_statistics_add_message(statistics, t, J_STATISTICS_MESSAGE_TIME, j_message_get_8(reply));
+	}
+
+	for (guint t = 0; t < J_STATISTICS_MESSAGE_TYPES; t++)
+	{
+		j_statistics_add_message(statistics, t, J_STATISTICS_MESSAGE_QUEUE_TIME, j_message_get_8(reply));
+		j_statistics_add_message(statistics, t, J_STATISTICS_MESSAGE_RECEIVE_TIME, j_message_get_8(reply));
+		j_statistics_add_message(statistics, t, J_STATISTICS_MESSAGE_SERVICE_TIME, j_message_get_8(reply));
+		j_statistics_add_message(statistics, t, J_STATISTICS_MESSAGE_REPLY_TIME, j_message_get_8(reply));
+	}
+
+	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, index, connection);
+}
+
 static void
 print_statistics(JStatistics* statistics)
 {
@@ -49,6 +111,23 @@ print_statistics(JStatistics* statistics)
 	g_print("  %s written\n", size_written);
 	g_print("  %s received\n", size_received);
 	g_print("  %s sent\n", size_sent);
+	g_print("  %" G_GUINT64_FORMAT " connections\n", j_statistics_get(statistics, J_STATISTICS_CONNECTIONS));
+
+	for (guint t = 0; t < J_STATISTICS_MESSAGE_TYPES; t++)
+	{
+		guint64 requests;
+		guint64 request_time;
+
+		if ((requests = j_statistics_get_message(statistics, t, J_STATISTICS_MESSAGE_REQUESTS)) == 0)
+		{
+			continue;
+		}
+
+		request_time = j_statistics_get_message(statistics, t, J_STATISTICS_MESSAGE_TIME);
+
+		g_print("  %" G_GUINT64_FORMAT " %s requests (%.1f µs on average)\n", requests, j_message_type_get_name(t), (gdouble)request_time / (gdouble)requests);
+		g_print("    %.1f µs queued, %.1f µs receiving, %.1f µs servicing, %.1f µs replying\n", (gdouble)j_statistics_get_message(statistics, t, J_STATISTICS_MESSAGE_QUEUE_TIME) / (gdouble)requests, (gdouble)j_statistics_get_message(statistics, t, J_STATISTICS_MESSAGE_RECEIVE_TIME) / (gdouble)requests, (gdouble)j_statistics_get_message(statistics, t, J_STATISTICS_MESSAGE_SERVICE_TIME) / (gdouble)requests, (gdouble)j_statistics_get_message(statistics, t, J_STATISTICS_MESSAGE_REPLY_TIME) / (gdouble)requests);
+	}
 
 	g_free(size_read);
 	g_free(size_written);
@@ -56,74 +135,144 @@ print_statistics(JStatistics* statistics)
 	g_free(size_sent);
 }
 
+/**
+ * Prints the rates between two snapshots of the total statistics.
+ **/
+static void
+print_rates(JStatistics* previous, JStatistics* current, gdouble elapsed)
+{
+	g_autofree gchar* rate_read = NULL;
+	g_autofree gchar* rate_written = NULL;
+	g_autoptr(GDateTime) now = NULL;
+	g_autofree gchar* timestamp = NULL;
+
+	now = g_date_time_new_now_local();
+	timestamp = g_date_time_format(now, "%H:%M:%S");
+
+	rate_read = g_format_size((guint64)((gdouble)(j_statistics_get(current, J_STATISTICS_BYTES_READ) - j_statistics_get(previous, J_STATISTICS_BYTES_READ)) / elapsed));
+	rate_written = g_format_size((guint64)((gdouble)(j_statistics_get(current, J_STATISTICS_BYTES_WRITTEN) - j_statistics_get(previous, J_STATISTICS_BYTES_WRITTEN)) / elapsed));
+
+	g_print("%s  %s/s read, %s/s written, %" G_GUINT64_FORMAT " connections", timestamp, rate_read, rate_written, j_statistics_get(current, J_STATISTICS_CONNECTIONS));
+
+	for (guint t = 0; t < J_STATISTICS_MESSAGE_TYPES; t++)
+	{
+		guint64 requests;
+		guint64 request_time;
+
+		requests = j_statistics_get_message(current, t, J_STATISTICS_MESSAGE_REQUESTS) - j_statistics_get_message(previous, t, J_STATISTICS_MESSAGE_REQUESTS);
+
+		// The statistics requests themselves are not interesting.
+		if (requests == 0 || t == J_MESSAGE_STATISTICS)
+		{
+			continue;
+		}
+
+		request_time = j_statistics_get_message(current, t, J_STATISTICS_MESSAGE_TIME) - j_statistics_get_message(previous, t, J_STATISTICS_MESSAGE_TIME);
+
+		g_print(", %s %.1f/s (%.1f µs)", j_message_type_get_name(t), (gdouble)requests / elapsed, (gdouble)request_time / (gdouble)requests);
+	}
+
+	g_print("\n");
+}
+
+static JStatistics*
+fetch_total(JConfiguration* configuration)
+{
+	JStatistics* statistics_total;
+
+	statistics_total = j_statistics_new(FALSE);
+
+	for (guint i = 0; i < j_configuration_get_server_count(configuration, J_BACKEND_TYPE_OBJECT); i++)
+	{
+		fetch_statistics(i, statistics_total);
+	}
+
+	return statistics_total;
+}
+
 int
 main(int argc, char** argv)
 {
+	GError* error = NULL;
+	g_autoptr(GOptionContext) context = NULL;
 	JConfiguration* configuration;
-	g_autoptr(JMessage) message = NULL;
 	JStatistics* statistics_total;
-	gchar get_all;
 
-	(void)argc;
-	(void)argv;
+	GOptionEntry entries[] = {
+		{ "interval", 'i', 0, G_OPTION_ARG_INT, &opt_interval, "Print rates every given number of seconds (0 prints the totals once)", "0" },
+		{ "count", 'c', 0, G_OPTION_ARG_INT, &opt_count, "Number of rates to print (0 for unlimited)", "0" },
+		{ NULL, 0, 0, 0, NULL, NULL, NULL }
+	};
 
 	// Explicitly enable UTF-8 since functions such as g_format_size might return UTF-8 characters.
 	setlocale(LC_ALL, "C.UTF-8");
 
-	get_all = 1;
-	configuration = j_configuration();
-	statistics_total = j_statistics_new(FALSE);
+	context = g_option_context_new(NULL);
+	g_option_context_set_summary(context, "Shows the statistics of all object servers.");
+	g_option_context_add_main_entries(context, entries, NULL);
 
-	message = j_message_new(J_MESSAGE_STATISTICS, sizeof(gchar));
-	j_message_add_operation(message, 0);
-	j_message_append_1(message, &get_all);
+	if (!g_option_context_parse(context, &argc, &argv, &error))
+	{
+		if (error)
+		{
+			g_printerr("%s\n", error->message);
+			g_error_free(error);
+		}
 
-	for (guint i = 0; i < j_configuration_get_server_count(configuration, J_BACKEND_TYPE_OBJECT); i++)
+		return 1;
+	}
+
+	if (opt_interval < 0 || opt_count < 0)
 	{
-		g_autoptr(JMessage) reply = NULL;
-		JStatistics* statistics;
-		gpointer connection;
-		guint64 value;
+		g_autofree gchar* help = NULL;
 
-		connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, i);
-		statistics = j_statistics_new(FALSE);
+		help = g_option_context_get_help(context, TRUE, NULL);
 
-		j_message_send(message, connection);
+		g_print("%s", help);
 
-		reply = j_message_new_reply(message);
-		j_message_receive(reply, connection);
+		return 1;
+	}
 
-		value = j_message_get_8(reply);
-		j_statistics_add(statistics, J_STATISTICS_FILES_CREATED, value);
-		j_statistics_add(statistics_total, J_STATISTICS_FILES_CREATED, value);
+	configuration = j_configuration();
 
-		value = j_message_get_8(reply);
-		j_statistics_add(statistics, J_STATISTICS_FILES_DELETED, value);
-		j_statistics_add(statistics_total, J_STATISTICS_FILES_DELETED, value);
+	if (opt_interval > 0)
+	{
+		gint64 previous_time;
 
-		value = j_message_get_8(reply);
-		j_statistics_add(statistics, J_STATISTICS_FILES_STATED, value);
-		j_statistics_add(statistics_total, J_STATISTICS_FILES_STATED, value);
+		statistics_total = fetch_total(configuration);
+		previous_time = g_get_monotonic_time();
 
-		value = j_message_get_8(reply);
-		j_statistics_add(statistics, J_STATISTICS_SYNC, value);
-		j_statistics_add(statistics_total, J_STATISTICS_SYNC, value);
+		for (gint i = 0; opt_count == 0 || i < opt_count; i++)
+		{
+			JStatistics* statistics_current;
+			gint64 current_time;
 
-		value = j_message_get_8(reply);
-		j_statistics_add(statistics, J_STATISTICS_BYTES_READ, value);
-		j_statistics_add(statistics_total, J_STATISTICS_BYTES_READ, value);
+			g_usleep(opt_interval * G_USEC_PER_SEC);
 
-		value = j_message_get_8(reply);
-		j_statistics_add(statistics, J_STATISTICS_BYTES_WRITTEN, value);
-		j_statistics_add(statistics_total, J_STATISTICS_BYTES_WRITTEN, value);
+			statistics_current = fetch_total(configuration);
+			current_time = g_get_monotonic_time();
 
-		value = j_message_get_8(reply);
-		j_statistics_add(statistics, J_STATISTICS_BYTES_RECEIVED, value);
-		j_statistics_add(statistics_total, J_STATISTICS_BYTES_RECEIVED, value);
+			print_rates(statistics_total, statistics_current, (gdouble)(current_time - previous_time) / (gdouble)G_USEC_PER_SEC);
 
-		value = j_message_get_8(reply);
-		j_statistics_add(statistics, J_STATISTICS_BYTES_SENT, value);
-		j_statistics_add(statistics_total, J_STATISTICS_BYTES_SENT, value);
+			j_statistics_free(statistics_total);
+			statistics_total = statistics_current;
+			previous_time = current_time;
+		}
+
+		j_statistics_free(statistics_total);
+
+		return 0;
+	}
+
+	statistics_total = j_statistics_new(FALSE);
+
+	for (guint i = 0; i < j_configuration_get_server_count(configuration, J_BACKEND_TYPE_OBJECT); i++)
+	{
+		JStatistics* statistics;
+
+		statistics = j_statistics_new(FALSE);
+		fetch_statistics(i, statistics);
+		j_statistics_merge(statistics_total, statistics);
 
 		g_print("Data server %d\n", i);
 		print_statistics(statistics);
@@ -134,7 +283,6 @@ main(int argc, char** argv)
 		}
 
 		j_statistics_free(statistics);
-		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, i, connection);
 	}
 
 	if (j_configuration_get_server_count(configuration, J_BACKEND_TYPE_OBJECT) > 1)